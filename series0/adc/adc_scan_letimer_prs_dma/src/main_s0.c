@@ -37,6 +37,7 @@
 #include "em_device.h"
 #include "em_chip.h"
 #include "em_cmu.h"
+#include "em_core.h"
 #include "em_emu.h"
 #include "em_adc.h"
 #include "em_prs.h"
@@ -57,10 +58,54 @@
 #define DMA_CHANNEL     0
 #define PRS_CHANNEL     0
 
+/*
+ * Capture modes:
+ * CAPTURE_LETIMER   - the LETIMER starts one scan per period over PRS and
+ *                     a looped basic DMA transfer keeps the latest results
+ *                     in adcBuffer
+ * CAPTURE_PING_PONG - the ADC repeats the scan back to back at the full
+ *                     conversion rate and DMA ping-pong fills the two
+ *                     halves of pingPongBuffer in turn, without a gap
+ */
+#define CAPTURE_LETIMER     0
+#define CAPTURE_PING_PONG   1
+
+#ifndef CAPTURE_MODE
+#define CAPTURE_MODE        CAPTURE_LETIMER
+#endif
+
+// Number of inputs in the scan, must agree with initScan.input
+#define SCAN_CHANNELS       2
+
+// Results per ping-pong half, a multiple of SCAN_CHANNELS and at most
+// 1024, the longest PL230 transfer
+#define PP_BUFFER_SIZE      512
+
+#if (PP_BUFFER_SIZE % SCAN_CHANNELS) || (PP_BUFFER_SIZE > 1024)
+#error "PP_BUFFER_SIZE must be a multiple of SCAN_CHANNELS up to 1024"
+#endif
+
 // Buffer for ADC single and scan conversion
 uint32_t adcBuffer[ADC_BUFFER_SIZE];
 uint32_t topValue;
 
+// Ping-pong halves, the primary descriptor fills [0], the alternate [1]
+uint16_t pingPongBuffer[2][PP_BUFFER_SIZE];
+
+// Half filled last, and set until the main loop has processed it
+volatile uint32_t readyHalf;
+volatile bool halfReady;
+
+// Halves completed, and halves the main loop did not get to in time
+volatile uint32_t halvesCaptured;
+volatile uint32_t halvesDropped;
+
+// Scan FIFO overflows, the DMA did not keep up with the ADC
+volatile uint32_t scanOverflows;
+
+// Average of each scan input over the last processed half
+uint32_t channelAverage[SCAN_CHANNELS];
+
 DMA_CB_TypeDef dmacb;
 
 /**************************************************************************//**
@@ -68,7 +113,57 @@ DMA_CB_TypeDef dmacb;
  *****************************************************************************/
 void dmaCallback(unsigned int channel, bool primary, void *user)
 {
+#if (CAPTURE_MODE == CAPTURE_PING_PONG)
+  uint32_t half = primary ? 0 : 1;
+
+  // Re-arm the descriptor that just finished. The DMA is already filling
+  // the other half, so this only has to happen within one half period.
+  DMA_RefreshPingPong(channel,
+      primary,
+      false,                        // don't use burst
+      pingPongBuffer[half],         // destination
+      (void *)&(ADC0->SCANDATA),    // source
+      PP_BUFFER_SIZE - 1,           // transfer size
+      false);                       // Do not stop ping-pong
+
+  if (ADC0->IF & ADC_IF_SCANOF) {
+    ADC_IntClear(ADC0, ADC_IFC_SCANOF);
+    scanOverflows++;
+  }
+
+  // The main loop still had the previous half, which is now overwritten
+  if (halfReady) {
+    halvesDropped++;
+  }
+
+  readyHalf = half;
+  halfReady = true;
+  halvesCaptured++;
+#else
   // Insert transfer complete functionality here
+#endif
+}
+
+/**************************************************************************//**
+ * @brief Average each scan input over one ping-pong half
+ *
+ * @note
+ *   Stands in for the application processing. It must finish within the
+ *   time the DMA takes to fill the other half, or halves are dropped.
+ *****************************************************************************/
+void processHalf(const uint16_t *block)
+{
+  uint32_t sum[SCAN_CHANNELS] = {0};
+  uint32_t i;
+
+  // Scan results arrive in input order, lowest input first
+  for (i = 0; i < PP_BUFFER_SIZE; i++) {
+    sum[i % SCAN_CHANNELS] += block[i];
+  }
+
+  for (i = 0; i < SCAN_CHANNELS; i++) {
+    channelAverage[i] = sum[i] / (PP_BUFFER_SIZE / SCAN_CHANNELS);
+  }
 }
 
 /**************************************************************************//**
@@ -142,6 +237,26 @@ void initDma(void)
   chnlCfg.cb        = &dmacb;
   DMA_CfgChannel(DMA_CHANNEL, &chnlCfg);
 
+#if (CAPTURE_MODE == CAPTURE_PING_PONG)
+  // Move the 12-bit results as halfwords, one per ADC request
+  descrCfg.dstInc  = dmaDataInc2;
+  descrCfg.srcInc  = dmaDataIncNone;
+  descrCfg.size    = dmaDataSize2;
+  descrCfg.arbRate = dmaArbitrate1;
+  descrCfg.hprot   = 0;
+  DMA_CfgDescr(DMA_CHANNEL, true, &descrCfg);   // configure as primary
+  DMA_CfgDescr(DMA_CHANNEL, false, &descrCfg);  // configure as alternate
+
+  // Start DMA, the alternate takes over as soon as the primary is done
+  DMA_ActivatePingPong(DMA_CHANNEL,
+      false,                        // don't use burst
+      pingPongBuffer[0],            // primary destination
+      (void *)&(ADC0->SCANDATA),    // primary source
+      PP_BUFFER_SIZE - 1,           // primary transfer size
+      pingPongBuffer[1],            // alternate destination
+      (void *)&(ADC0->SCANDATA),    // alternate source
+      PP_BUFFER_SIZE - 1);          // alternate transfer size
+#else
   descrCfg.dstInc  = dmaDataInc4;
   descrCfg.srcInc  = dmaDataIncNone;
   descrCfg.size    = dmaDataSize4;
@@ -162,6 +277,7 @@ void initDma(void)
       adcBuffer,                  // destination
       (void *)&(ADC0->SCANDATA),  // source
       ADC_BUFFER_SIZE - 1);       // transfer size
+#endif
 }
 
 /**************************************************************************//**
@@ -189,9 +305,16 @@ void initAdc(void)
   initScan.reference  = adcRef2V5;    // 2.5V reference
   initScan.resolution = adcRes12Bit;  // 12-bit resolution
 
+#if (CAPTURE_MODE == CAPTURE_PING_PONG)
+  // Shortest acquisition time and restart the scan as soon as it is
+  // done, 14 ADC clocks per result or about 928 ksps in total
+  initScan.acqTime = adcAcqTime1;
+  initScan.rep     = true;
+#else
   // Enable PRS trigger and select channel 0
   initScan.prsEnable = true;
   initScan.prsSel = (ADC_PRSSEL_TypeDef) PRS_CHANNEL;
+#endif
 
   // Initialize ADC
   ADC_Init(ADC0, &init);
@@ -205,6 +328,36 @@ int main(void)
 {
   CHIP_Init();
 
+#if (CAPTURE_MODE == CAPTURE_PING_PONG)
+  CORE_DECLARE_IRQ_STATE;
+  uint32_t half;
+
+  // Setup ADC to convert continuously
+  initAdc();
+  // Setup DMA to fill the ping-pong halves in turn
+  initDma();
+  // Start the first scan, the ADC repeats it from here on
+  ADC_Start(ADC0, adcStartScan);
+
+  // Infinite loop
+  while(1)
+  {
+    // Enter EM1 until the next half is filled
+    CORE_ENTER_CRITICAL();
+    if (!halfReady) {
+      EMU_EnterEM1();
+    }
+    CORE_EXIT_CRITICAL();
+
+    if (halfReady) {
+      half = readyHalf;
+      processHalf(pingPongBuffer[half]);
+
+      // Done with it, the DMA may overwrite it from now on
+      halfReady = false;
+    }
+  }
+#else
   // Setup ADC to perform conversions via PRS
   initAdc();
   // Setup DMA to move ADC results to user memory
@@ -218,4 +371,5 @@ int main(void)
     // Enter EM1 until next ADC interrupt
     EMU_EnterEM1();
   }
+#endif
 }
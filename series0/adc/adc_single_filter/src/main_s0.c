@@ -0,0 +1,228 @@
+/***************************************************************************//**
+ * @file main_s0.c
+ * @brief Filter polled ADC conversions with fixed-point median and average
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2020 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ *******************************************************************************
+ * # Evaluation Quality
+ * This code has been minimally tested to ensure that it builds and is suitable 
+ * as a demonstration for evaluation purposes only. This code will be maintained
+ * at the sole discretion of Silicon Labs.
+ ******************************************************************************/
+
+
+#include <stdint.h>
+#include <string.h>
+#include "em_device.h"
+#include "em_chip.h"
+#include "em_cmu.h"
+#include "em_adc.h"
+#include "benchmark.h"
+#include "fixmath.h"
+
+#define adcFreq   13000000
+
+// Filter lengths: the median removes spikes, the average the noise
+#define MEDIAN_LENGTH     5
+#define AVERAGE_LENGTH    16
+
+// Kernel benchmark sizes
+#define DOT_TAPS          64
+#define KERNEL_RUNS       8
+
+volatile uint32_t sample;
+volatile uint32_t median;
+volatile uint32_t average;
+volatile uint32_t millivolts;
+
+// Average cycles of each kernel, for one call, on this core:
+// dot product of DOT_TAPS taps, Q31 multiply, atan2, square root,
+// median and average of one sample
+volatile uint32_t cyclesDotQ15;
+volatile uint32_t cyclesMulQ31;
+volatile uint32_t cyclesAtan2;
+volatile uint32_t cyclesSqrt32;
+volatile uint32_t cyclesMedian;
+volatile uint32_t cyclesAverage;
+
+// Results of the kernels, kept so the calls are not optimized away
+volatile int64_t dotResult;
+volatile int32_t kernelResult;
+
+static int32_t medianRing[MEDIAN_LENGTH];
+static int32_t medianSorted[MEDIAN_LENGTH];
+static int32_t averageRing[AVERAGE_LENGTH];
+static FIXMATH_Median_t medianFilter;
+static FIXMATH_Average_t averageFilter;
+
+static int16_t taps[DOT_TAPS];
+static int16_t history[DOT_TAPS];
+
+/**************************************************************************//**
+ * @brief  Initialize ADC function
+ *****************************************************************************/
+void initADC (void)
+{
+  // Enable ADC0 clock
+  CMU_ClockEnable(cmuClock_ADC0, true);
+
+  // Declare init structs
+  ADC_Init_TypeDef init = ADC_INIT_DEFAULT;
+  ADC_InitSingle_TypeDef initSingle = ADC_INITSINGLE_DEFAULT;
+
+  // Modify init structs and initialize
+  init.prescale = ADC_PrescaleCalc(adcFreq, 0); // Init to max ADC clock for Series 0
+
+  initSingle.diff       = false;        // single ended
+  initSingle.reference  = adcRef2V5;    // internal 2.5V reference
+  initSingle.resolution = adcRes12Bit;  // 12-bit resolution
+
+  // Select ADC input. See README for corresponding EXP header pin.
+  initSingle.input = adcSingleInputCh7;
+  init.timebase = ADC_TimebaseCalc(0);
+
+  ADC_Init(ADC0, &init);
+  ADC_InitSingle(ADC0, &initSingle);
+}
+
+/**************************************************************************//**
+ * @brief  Average cycles of a benchmark section, 0 if it was not run
+ *****************************************************************************/
+static uint32_t averageCycles(const char *name)
+{
+  const BENCHMARK_Entry_t *entry;
+
+  for (unsigned int i = 0; i < BENCHMARK_Count(); i++) {
+    entry = BENCHMARK_Get(i);
+    if ((strcmp(entry->name, name) == 0) && (entry->runs > 0)) {
+      return (uint32_t)(entry->total / entry->runs);
+    }
+  }
+  return 0;
+}
+
+/**************************************************************************//**
+ * @brief  Time each fixed-point kernel on this core
+ *****************************************************************************/
+static void benchmarkKernels(void)
+{
+  FIXMATH_Median_t med;
+  FIXMATH_Average_t avg;
+  int32_t medRing[MEDIAN_LENGTH];
+  int32_t medSorted[MEDIAN_LENGTH];
+  int32_t avgRing[AVERAGE_LENGTH];
+  uint32_t state = 12345;
+  uint32_t start;
+  int32_t x, y;
+
+  // Pseudo random operands, the same on every run
+  for (int i = 0; i < DOT_TAPS; i++) {
+    state = state * 1103515245UL + 12345UL;
+    taps[i] = (int16_t)(state >> 16);
+    state = state * 1103515245UL + 12345UL;
+    history[i] = (int16_t)(state >> 16);
+  }
+
+  FIXMATH_MedianInit(&med, medRing, medSorted, MEDIAN_LENGTH);
+  FIXMATH_AverageInit(&avg, avgRing, AVERAGE_LENGTH);
+
+  BENCHMARK_Reset();
+
+  for (int run = 0; run < KERNEL_RUNS; run++) {
+    state = state * 1103515245UL + 12345UL;
+    x = (int32_t)state;
+    state = state * 1103515245UL + 12345UL;
+    y = (int32_t)state;
+
+    BENCHMARK_START(start);
+    dotResult = FIXMATH_DotQ15(taps, history, DOT_TAPS);
+    BENCHMARK_STOP("dotq15", start, DOT_TAPS);
+
+    BENCHMARK_START(start);
+    kernelResult = FIXMATH_MulQ31(x, y);
+    BENCHMARK_STOP("mulq31", start, 1);
+
+    BENCHMARK_START(start);
+    kernelResult = FIXMATH_Atan2(y, x);
+    BENCHMARK_STOP("atan2", start, 1);
+
+    BENCHMARK_START(start);
+    kernelResult = FIXMATH_Sqrt32((uint32_t)x);
+    BENCHMARK_STOP("sqrt32", start, 1);
+
+    BENCHMARK_START(start);
+    kernelResult = FIXMATH_MedianAdd(&med, y & 0xFFF);
+    BENCHMARK_STOP("median", start, 1);
+
+    BENCHMARK_START(start);
+    kernelResult = FIXMATH_AverageAdd(&avg, x & 0xFFF);
+    BENCHMARK_STOP("average", start, 1);
+  }
+
+  cyclesDotQ15  = averageCycles("dotq15");
+  cyclesMulQ31  = averageCycles("mulq31");
+  cyclesAtan2   = averageCycles("atan2");
+  cyclesSqrt32  = averageCycles("sqrt32");
+  cyclesMedian  = averageCycles("median");
+  cyclesAverage = averageCycles("average");
+}
+
+/**************************************************************************//**
+ * @brief  Main function
+ *****************************************************************************/
+int main(void)
+{
+  CHIP_Init();
+
+  // Cycle counter for the kernel timings
+  BENCHMARK_Init();
+  benchmarkKernels();
+
+  FIXMATH_MedianInit(&medianFilter, medianRing, medianSorted, MEDIAN_LENGTH);
+  FIXMATH_AverageInit(&averageFilter, averageRing, AVERAGE_LENGTH);
+
+  initADC();
+
+  // Infinite loop
+  while(1)
+  {
+    // Start ADC conversion
+    ADC_Start(ADC0, adcStartSingle);
+
+    // Wait for conversion to be complete
+    while(!(ADC0->STATUS & _ADC_STATUS_SINGLEDV_MASK));
+
+    // Get ADC result
+    sample = ADC_DataSingleGet(ADC0);
+
+    // Median of the last 5 samples, then average of the last 16 medians
+    median = (uint32_t)FIXMATH_MedianAdd(&medianFilter, (int32_t)sample);
+    average = (uint32_t)FIXMATH_AverageAdd(&averageFilter, (int32_t)median);
+
+    // Calculate input voltage in mV
+    millivolts = (average * 2500) / 4096;
+  }
+}
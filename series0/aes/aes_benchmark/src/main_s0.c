@@ -0,0 +1,443 @@
+/***************************************************************************//**
+ * @file main_s0.c
+ * @brief This project measures AES throughput for all modes and key sizes
+ * and compares polled, interrupt and DMA feeding of the AES module.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2022 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ *******************************************************************************
+ * # Evaluation Quality
+ * This code has been minimally tested to ensure that it builds and is suitable
+ * as a demonstration for evaluation purposes only. This code will be maintained
+ * at the sole discretion of Silicon Labs.
+ ******************************************************************************/
+
+#include <stdio.h>
+#include <string.h>
+#include "em_device.h"
+#include "em_cmu.h"
+#include "em_chip.h"
+#include "em_emu.h"
+#include "em_aes.h"
+#include "em_dma.h"
+#include "dmactrl.h"
+#include "retargetserial.h"
+#include "benchmark.h"
+
+#if !defined(AES_CTRL_BYTEORDER)
+#error "Interrupt and DMA feeding need the AES BYTEORDER control bit"
+#endif
+
+// Note: change these to change the buffer sizes that are measured
+//       (each must be a multiple of 16 and at most MAX_DATA_SIZE)
+static const uint32_t dataSizes[] = { 16, 64, 256, 1024, 4096 };
+
+#define SIZE_COUNT      (sizeof(dataSizes) / sizeof(dataSizes[0]))
+
+// Largest buffer, 1024 words is also the longest single DMA transfer
+#define MAX_DATA_SIZE   4096
+#define MAX_DATA_WORDS  (MAX_DATA_SIZE / 4)
+
+// Number of times each case is run, the table shows min/avg/max
+#define BENCHMARK_RUNS  4
+
+#define BLOCK_SIZE      16
+
+// DMA channels used, the read channel has high priority so a finished block
+// is always drained before the next one is written
+#define DMA_CHANNEL_WRITE   0
+#define DMA_CHANNEL_READ    1
+
+// Buffers are word arrays so the DMA and the AES library get aligned data
+static uint32_t originalData[MAX_DATA_WORDS];
+static uint32_t encryptedData[MAX_DATA_WORDS];
+static uint32_t referenceData[MAX_DATA_WORDS];
+
+// Note: the first 16 bytes are used as the 128 bit key
+static const uint32_t key[8] = {
+  0x16157E2B, 0xA6D2AE28, 0x8815F7AB, 0x3C4FCF09,
+  0x10EB3D60, 0xBE71CA15, 0xF0AE732B, 0x81777D85
+};
+
+static const uint32_t initVector[4] = {
+  0x03020100, 0x07060504, 0x0B0A0908, 0x0F0E0D0C
+};
+
+// Counter for CTR mode, reloaded from initVector before each run
+static uint32_t counter[4];
+
+// Generated decryption keys
+static uint32_t decryptKey128[4];
+static uint32_t decryptKey256[8];
+
+// Interrupt/DMA feeding state
+static uint32_t *feedOut;
+static const uint32_t *feedIn;
+static volatile uint32_t *feedTarget;
+static volatile uint32_t blocksLeft;
+static volatile bool feedBusy;
+
+static DMA_CB_TypeDef readCallback;
+
+// A flag indicating whether the interrupt and DMA results matched the
+// library. Note: This is only volatile to ensure that it doesn't get
+// optimized out by the compiler before the user checks its value.
+static volatile bool isError;
+
+/***************************************************************************//**
+ * Library (register polled) cases
+ ******************************************************************************/
+
+typedef void (*AesRun_t)(uint32_t len);
+
+#define IN      ((const uint8_t *)originalData)
+#define OUT     ((uint8_t *)encryptedData)
+#define KEY     ((const uint8_t *)key)
+#define IV      ((const uint8_t *)initVector)
+
+static void runEcb128(uint32_t len) { AES_ECB128(OUT, IN, len, KEY, true); }
+static void runEcb256(uint32_t len) { AES_ECB256(OUT, IN, len, KEY, true); }
+static void runCbc128(uint32_t len) { AES_CBC128(OUT, IN, len, KEY, IV, true); }
+static void runCbc256(uint32_t len) { AES_CBC256(OUT, IN, len, KEY, IV, true); }
+static void runCfb128(uint32_t len) { AES_CFB128(OUT, IN, len, KEY, IV, true); }
+static void runCfb256(uint32_t len) { AES_CFB256(OUT, IN, len, KEY, IV, true); }
+static void runOfb128(uint32_t len) { AES_OFB128(OUT, IN, len, KEY, IV); }
+static void runOfb256(uint32_t len) { AES_OFB256(OUT, IN, len, KEY, IV); }
+
+static void runCtr128(uint32_t len)
+{
+  memcpy(counter, initVector, sizeof(counter));
+  AES_CTR128(OUT, IN, len, KEY, (uint8_t *)counter, AES_CTRUpdate32Bit);
+}
+
+static void runCtr256(uint32_t len)
+{
+  memcpy(counter, initVector, sizeof(counter));
+  AES_CTR256(OUT, IN, len, KEY, (uint8_t *)counter, AES_CTRUpdate32Bit);
+}
+
+static const struct {
+  const char *name;
+  AesRun_t   run;
+} libraryCases[] = {
+  { "ecb128 polled", runEcb128 },
+  { "ecb256 polled", runEcb256 },
+  { "cbc128 polled", runCbc128 },
+  { "cbc256 polled", runCbc256 },
+  { "cfb128 polled", runCfb128 },
+  { "cfb256 polled", runCfb256 },
+  { "ofb128 polled", runOfb128 },
+  { "ofb256 polled", runOfb256 },
+  { "ctr128 polled", runCtr128 },
+  { "ctr256 polled", runCtr256 },
+};
+
+#define LIBRARY_CASE_COUNT (sizeof(libraryCases) / sizeof(libraryCases[0]))
+
+/**************************************************************************//**
+ * @brief
+ *    Load the 128 bit key and, for CBC, the IV. BYTEORDER is set so the key
+ *    and data registers take words in memory order, as the DMA copies them.
+ *****************************************************************************/
+static void startAes(bool cbc)
+{
+  if (cbc) {
+    AES->CTRL = AES_CTRL_BYTEORDER | AES_CTRL_KEYBUFEN | AES_CTRL_XORSTART;
+  } else {
+    AES->CTRL = AES_CTRL_BYTEORDER | AES_CTRL_KEYBUFEN | AES_CTRL_DATASTART;
+  }
+
+  for (uint32_t i = 0; i < 4; i++) {
+    AES->KEYHA = key[i];
+  }
+
+  // CBC starts with the IV in DATA, each plaintext block written to XORDATA
+  // is XOR'ed with the previous ciphertext and encrypted
+  if (cbc) {
+    for (uint32_t i = 0; i < 4; i++) {
+      AES->DATA = initVector[i];
+    }
+  }
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Write the next plaintext block, the last word starts the encryption
+ *****************************************************************************/
+static void writeBlock(void)
+{
+  for (uint32_t i = 0; i < 4; i++) {
+    *feedTarget = *feedIn++;
+  }
+}
+
+/**************************************************************************//**
+ * @brief
+ *    AES interrupt handler, drains a finished block and feeds the next one
+ *****************************************************************************/
+void AES_IRQHandler(void)
+{
+  AES_IntClear(AES_IFC_DONE);
+
+  for (uint32_t i = 0; i < 4; i++) {
+    *feedOut++ = AES->DATA;
+  }
+
+  if (--blocksLeft > 0) {
+    writeBlock();
+  } else {
+    feedBusy = false;
+  }
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Encrypt a buffer 128 bit ECB or CBC, fed block by block from the AES
+ *    interrupt
+ *****************************************************************************/
+static void runInterrupt(bool cbc, uint32_t len)
+{
+  startAes(cbc);
+
+  feedTarget = cbc ? &AES->XORDATA : &AES->DATA;
+  feedIn     = originalData;
+  feedOut    = encryptedData;
+  blocksLeft = len / BLOCK_SIZE;
+  feedBusy   = true;
+
+  AES_IntClear(AES_IFC_DONE);
+  AES_IntEnable(AES_IEN_DONE);
+  writeBlock();
+
+  // The core is free here, spin instead of sleeping so the cycle counter
+  // keeps running and the table shows the time to finish
+  while (feedBusy) ;
+
+  AES_IntDisable(AES_IEN_DONE);
+}
+
+/**************************************************************************//**
+ * @brief
+ *    DMA callback, called when the read channel has drained the buffer
+ *****************************************************************************/
+static void dmaReadDone(unsigned int channel, bool primary, void *user)
+{
+  (void)channel;
+  (void)primary;
+  (void)user;
+
+  feedBusy = false;
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Initialize the DMA controller and the two AES channels
+ *****************************************************************************/
+static void initDma(void)
+{
+  DMA_Init_TypeDef dmaInit;
+  DMA_CfgDescr_TypeDef descrCfg;
+  DMA_CfgChannel_TypeDef chnlCfg;
+
+  CMU_ClockEnable(cmuClock_DMA, true);
+
+  dmaInit.hprot        = 0;
+  dmaInit.controlBlock = dmaControlBlock;
+  DMA_Init(&dmaInit);
+
+  readCallback.cbFunc  = dmaReadDone;
+  readCallback.userPtr = NULL;
+
+  // Read channel: AES->DATA to memory, 4 words per request
+  chnlCfg.highPri   = true;
+  chnlCfg.enableInt = true;
+  chnlCfg.select    = DMAREQ_AES_DATARD;
+  chnlCfg.cb        = &readCallback;
+  DMA_CfgChannel(DMA_CHANNEL_READ, &chnlCfg);
+
+  descrCfg.dstInc  = dmaDataInc4;
+  descrCfg.srcInc  = dmaDataIncNone;
+  descrCfg.size    = dmaDataSize4;
+  descrCfg.arbRate = dmaArbitrate4;
+  descrCfg.hprot   = 0;
+  DMA_CfgDescr(DMA_CHANNEL_READ, true, &descrCfg);
+
+  // Write channel: memory to AES->DATA or AES->XORDATA, 4 words per request
+  descrCfg.dstInc  = dmaDataIncNone;
+  descrCfg.srcInc  = dmaDataInc4;
+  DMA_CfgDescr(DMA_CHANNEL_WRITE, true, &descrCfg);
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Encrypt a buffer 128 bit ECB or CBC with the DMA feeding the AES module
+ *****************************************************************************/
+static void runDma(bool cbc, uint32_t len)
+{
+  DMA_CfgChannel_TypeDef chnlCfg;
+
+  startAes(cbc);
+
+  chnlCfg.highPri   = false;
+  chnlCfg.enableInt = false;
+  chnlCfg.select    = cbc ? DMAREQ_AES_XORDATAWR : DMAREQ_AES_DATAWR;
+  chnlCfg.cb        = NULL;
+  DMA_CfgChannel(DMA_CHANNEL_WRITE, &chnlCfg);
+
+  feedBusy = true;
+
+  // Arm the read side first so it is ready when the first block finishes
+  DMA_ActivateBasic(DMA_CHANNEL_READ, true, false,
+                    encryptedData, (void *)&AES->DATA, (len / 4) - 1);
+  DMA_ActivateBasic(DMA_CHANNEL_WRITE, true, false,
+                    cbc ? (void *)&AES->XORDATA : (void *)&AES->DATA,
+                    originalData, (len / 4) - 1);
+
+  // The core is free here, spin instead of sleeping so the cycle counter
+  // keeps running and the table shows the time to finish
+  while (feedBusy) ;
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Compare the last result with the library result for the same mode
+ *****************************************************************************/
+static void checkResult(AesRun_t reference, uint32_t len)
+{
+  // Keep the result, the library case writes to encryptedData
+  memcpy(referenceData, encryptedData, len);
+  reference(len);
+  if (memcmp(referenceData, encryptedData, len) != 0) {
+    isError = true;
+  }
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Time the decryption key generation, which is needed once per key for
+ *    ECB and CBC decryption and is not part of the per byte cost
+ *****************************************************************************/
+static void benchmarkKeySchedule(void)
+{
+  uint32_t start;
+
+  BENCHMARK_Reset();
+
+  for (uint32_t run = 0; run < BENCHMARK_RUNS; run++) {
+    BENCHMARK_START(start);
+    AES_DecryptKey128((uint8_t *)decryptKey128, KEY);
+    BENCHMARK_STOP("aes128 decrypt key", start, 0);
+
+    BENCHMARK_START(start);
+    AES_DecryptKey256((uint8_t *)decryptKey256, KEY);
+    BENCHMARK_STOP("aes256 decrypt key", start, 0);
+  }
+
+  printf("\nKey schedule\n");
+  BENCHMARK_Print();
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Time all modes and feeding methods for one buffer size
+ *****************************************************************************/
+static void benchmarkSize(uint32_t len)
+{
+  uint32_t start;
+
+  BENCHMARK_Reset();
+
+  for (uint32_t run = 0; run < BENCHMARK_RUNS; run++) {
+    for (uint32_t i = 0; i < LIBRARY_CASE_COUNT; i++) {
+      BENCHMARK_START(start);
+      libraryCases[i].run(len);
+      BENCHMARK_STOP(libraryCases[i].name, start, len);
+    }
+
+    BENCHMARK_START(start);
+    runInterrupt(false, len);
+    BENCHMARK_STOP("ecb128 interrupt", start, len);
+    checkResult(runEcb128, len);
+
+    BENCHMARK_START(start);
+    runDma(false, len);
+    BENCHMARK_STOP("ecb128 dma", start, len);
+    checkResult(runEcb128, len);
+
+    BENCHMARK_START(start);
+    runInterrupt(true, len);
+    BENCHMARK_STOP("cbc128 interrupt", start, len);
+    checkResult(runCbc128, len);
+
+    BENCHMARK_START(start);
+    runDma(true, len);
+    BENCHMARK_STOP("cbc128 dma", start, len);
+    checkResult(runCbc128, len);
+  }
+
+  printf("\n%lu bytes\n", (unsigned long)len);
+  BENCHMARK_Print();
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Main function
+ *****************************************************************************/
+int main(void)
+{
+  // Chip errata
+  CHIP_Init();
+
+  // Cycle counter and serial port for the benchmark results
+  BENCHMARK_Init();
+  RETARGET_SerialInit();
+  RETARGET_SerialCrLf(1);
+
+  // Enable AES clock
+  CMU_ClockEnable(cmuClock_AES, true);
+  NVIC_ClearPendingIRQ(AES_IRQn);
+  NVIC_EnableIRQ(AES_IRQn);
+
+  initDma();
+
+  // Fill the plaintext with a counting pattern
+  for (uint32_t i = 0; i < MAX_DATA_WORDS; i++) {
+    originalData[i] = 0x03020100 + (i * 0x04040404);
+  }
+
+  printf("\naes_benchmark, core clock %lu Hz\n",
+         (unsigned long)SystemCoreClockGet());
+
+  isError = false;
+  benchmarkKeySchedule();
+  for (uint32_t i = 0; i < SIZE_COUNT; i++) {
+    benchmarkSize(dataSizes[i]);
+  }
+
+  // Pause the debugger here to check if the isError variable is true/false
+  while (1) {
+    EMU_EnterEM1();
+  }
+}
@@ -0,0 +1,78 @@
+/***************************************************************************//**
+ * @file aes_ccm.h
+ * @brief AES CCM authenticated encryption on the AES module, single pass.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2022 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ******************************************************************************/
+
+#ifndef AES_CCM_H
+#define AES_CCM_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/// AES block size in bytes
+#define AESCCM_BLOCK_SIZE   16
+
+/// Nonce length limits in bytes, the rest of the counter block holds the
+/// message length, so a 13 byte nonce allows messages up to 64 kB
+#define AESCCM_NONCE_MIN    7
+#define AESCCM_NONCE_MAX    13
+
+/// Tag length limits in bytes, the length must be even
+#define AESCCM_TAG_MIN      4
+#define AESCCM_TAG_MAX      16
+
+bool AESCCM_Encrypt(const uint8_t *key,
+                    const uint8_t *nonce,
+                    uint32_t nonceLen,
+                    const uint8_t *aad,
+                    uint32_t aadLen,
+                    uint8_t *out,
+                    const uint8_t *in,
+                    uint32_t len,
+                    uint8_t *tag,
+                    uint32_t tagLen);
+bool AESCCM_Decrypt(const uint8_t *key,
+                    const uint8_t *nonce,
+                    uint32_t nonceLen,
+                    const uint8_t *aad,
+                    uint32_t aadLen,
+                    uint8_t *out,
+                    const uint8_t *in,
+                    uint32_t len,
+                    const uint8_t *tag,
+                    uint32_t tagLen);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // AES_CCM_H
@@ -0,0 +1,66 @@
+/***************************************************************************//**
+ * @file ccm_soft.h
+ * @brief Software AES-128 CCM, the reference for the throughput comparison.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2022 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ******************************************************************************/
+
+#ifndef CCM_SOFT_H
+#define CCM_SOFT_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+bool SOFTCCM_Encrypt(const uint8_t *key,
+                     const uint8_t *nonce,
+                     uint32_t nonceLen,
+                     const uint8_t *aad,
+                     uint32_t aadLen,
+                     uint8_t *out,
+                     const uint8_t *in,
+                     uint32_t len,
+                     uint8_t *tag,
+                     uint32_t tagLen);
+bool SOFTCCM_Decrypt(const uint8_t *key,
+                     const uint8_t *nonce,
+                     uint32_t nonceLen,
+                     const uint8_t *aad,
+                     uint32_t aadLen,
+                     uint8_t *out,
+                     const uint8_t *in,
+                     uint32_t len,
+                     const uint8_t *tag,
+                     uint32_t tagLen);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // CCM_SOFT_H
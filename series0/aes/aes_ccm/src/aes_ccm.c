@@ -0,0 +1,426 @@
+/***************************************************************************//**
+ * @file aes_ccm.c
+ * @brief AES CCM authenticated encryption on the AES module, single pass.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2022 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ******************************************************************************/
+
+#include <stdint.h>
+#include <string.h>
+#include "em_device.h"
+#include "aes_ccm.h"
+
+/**************************************************************************//**
+ * @brief
+ *    Load a 128 bit key into the AES key buffer.
+ *
+ * @details
+ *    With the key buffer enabled the key is reloaded before every block, so
+ *    both passes of CCM share one key load per call.
+ *****************************************************************************/
+static void loadKey(const uint8_t *key)
+{
+  uint32_t k[4];
+  int i;
+
+  memcpy(k, key, sizeof(k));
+
+  AES->CTRL = AES_CTRL_KEYBUFEN | AES_CTRL_DATASTART;
+  for (i = 3; i >= 0; i--) {
+    AES->KEYHA = __REV(k[i]);
+  }
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Write a block to AES->DATA, the last word starts the encryption.
+ *****************************************************************************/
+static void startBlock(const uint32_t *block)
+{
+  int i;
+
+  for (i = 3; i >= 0; i--) {
+    AES->DATA = __REV(block[i]);
+  }
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Wait for the encryption started by startBlock() and read the result.
+ *****************************************************************************/
+static void finishBlock(uint32_t *block)
+{
+  int i;
+
+  while (AES->STATUS & AES_STATUS_RUNNING) ;
+
+  for (i = 3; i >= 0; i--) {
+    block[i] = __REV(AES->DATA);
+  }
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Increment the big endian counter in the last q bytes of a counter
+ *    block.
+ *****************************************************************************/
+static void nextCounter(uint32_t *counter, uint32_t q)
+{
+  uint8_t *c = (uint8_t *)counter;
+  uint32_t i;
+
+  for (i = AESCCM_BLOCK_SIZE - 1; i >= AESCCM_BLOCK_SIZE - q; i--) {
+    if (++c[i] != 0) {
+      break;
+    }
+  }
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Check the lengths and start the MAC and the keystream.
+ *
+ * @details
+ *    Formats the first MAC block B0 and the counter block A0, encrypts A0
+ *    for the tag mask S0 and leaves the counter at A1, then runs the
+ *    CBC-MAC over B0 and the associated data. The associated data is XOR'ed
+ *    into the MAC state a byte at a time, which pads the last block with
+ *    zeros for free.
+ *
+ * @return
+ *    false if a length is not allowed.
+ *****************************************************************************/
+static bool start(const uint8_t *key,
+                  const uint8_t *nonce,
+                  uint32_t nonceLen,
+                  const uint8_t *aad,
+                  uint32_t aadLen,
+                  uint32_t len,
+                  uint32_t tagLen,
+                  uint32_t *mac,
+                  uint32_t *counter,
+                  uint32_t *mask)
+{
+  uint8_t *m = (uint8_t *)mac;
+  uint8_t *c = (uint8_t *)counter;
+  uint32_t q = (AESCCM_BLOCK_SIZE - 1) - nonceLen;
+  uint32_t pos, i;
+
+  if ((nonceLen < AESCCM_NONCE_MIN) || (nonceLen > AESCCM_NONCE_MAX)
+      || (tagLen < AESCCM_TAG_MIN) || (tagLen > AESCCM_TAG_MAX)
+      || ((tagLen & 1) != 0)
+      || ((q < 4) && ((len >> (8 * q)) != 0))) {
+    return false;
+  }
+
+  loadKey(key);
+
+  // A0: flags, nonce, counter 0
+  memset(counter, 0, AESCCM_BLOCK_SIZE);
+  c[0] = (uint8_t)(q - 1);
+  memcpy(&c[1], nonce, nonceLen);
+  startBlock(counter);
+
+  // B0 while S0 is encrypted: flags, nonce, message length
+  memset(mac, 0, AESCCM_BLOCK_SIZE);
+  m[0] = (uint8_t)(((aadLen > 0) ? 0x40 : 0) | (((tagLen - 2) / 2) << 3)
+                   | (q - 1));
+  memcpy(&m[1], nonce, nonceLen);
+  for (i = 0; (i < q) && (i < 4); i++) {
+    m[AESCCM_BLOCK_SIZE - 1 - i] = (uint8_t)(len >> (8 * i));
+  }
+
+  finishBlock(mask);
+  nextCounter(counter, q);
+
+  startBlock(mac);
+  finishBlock(mac);
+
+  if (aadLen == 0) {
+    return true;
+  }
+
+  // Associated data length, 2 bytes or 0xFFFE and 4 bytes
+  if (aadLen < 0xFF00) {
+    m[0] ^= (uint8_t)(aadLen >> 8);
+    m[1] ^= (uint8_t)aadLen;
+    pos = 2;
+  } else {
+    m[0] ^= 0xFF;
+    m[1] ^= 0xFE;
+    m[2] ^= (uint8_t)(aadLen >> 24);
+    m[3] ^= (uint8_t)(aadLen >> 16);
+    m[4] ^= (uint8_t)(aadLen >> 8);
+    m[5] ^= (uint8_t)aadLen;
+    pos = 6;
+  }
+
+  for (i = 0; i < aadLen; i++) {
+    m[pos++] ^= aad[i];
+    if (pos == AESCCM_BLOCK_SIZE) {
+      startBlock(mac);
+      finishBlock(mac);
+      pos = 0;
+    }
+  }
+  if (pos > 0) {
+    startBlock(mac);
+    finishBlock(mac);
+  }
+
+  return true;
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Encrypt or decrypt the payload and run the CBC-MAC over the plaintext
+ *    in one pass.
+ *
+ * @details
+ *    Each block is read from the input once and written to the output once.
+ *    The AES module does the keystream block and then the MAC block; the
+ *    core loads, XORs and stores the data while the AES module is running.
+ *    Encryption starts the MAC block before the ciphertext is stored, since
+ *    the plaintext is known first. Decryption needs the plaintext for the
+ *    MAC, so the MAC block runs while the plaintext is stored.
+ *
+ *    The last partial block is padded with zeros for the MAC, so on
+ *    decryption the keystream bytes past the end are cleared first.
+ *****************************************************************************/
+static void crypt(uint32_t *mac,
+                  uint32_t *counter,
+                  uint32_t q,
+                  uint8_t *out,
+                  const uint8_t *in,
+                  uint32_t len,
+                  bool decrypt)
+{
+  uint32_t data[4];
+  uint32_t keystream[4];
+  uint32_t n;
+  int i;
+
+  while (len > 0) {
+    n = (len < AESCCM_BLOCK_SIZE) ? len : AESCCM_BLOCK_SIZE;
+
+    startBlock(counter);
+
+    if (n < AESCCM_BLOCK_SIZE) {
+      memset(data, 0, sizeof(data));
+    }
+    memcpy(data, in, n);
+    nextCounter(counter, q);
+
+    if (!decrypt) {
+      for (i = 0; i < 4; i++) {
+        mac[i] ^= data[i];
+      }
+    }
+
+    finishBlock(keystream);
+    for (i = 0; i < 4; i++) {
+      data[i] ^= keystream[i];
+    }
+
+    if (decrypt) {
+      if (n < AESCCM_BLOCK_SIZE) {
+        memset((uint8_t *)data + n, 0, AESCCM_BLOCK_SIZE - n);
+      }
+      for (i = 0; i < 4; i++) {
+        mac[i] ^= data[i];
+      }
+    }
+
+    startBlock(mac);
+    memcpy(out, data, n);
+    finishBlock(mac);
+
+    in  += n;
+    out += n;
+    len -= n;
+  }
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Encrypt and authenticate a message with AES-128 CCM (NIST SP 800-38C,
+ *    RFC 3610).
+ *
+ * @details
+ *    The CBC-MAC and the CTR encryption are interleaved block by block, so
+ *    the message is read once, with no staging copy, and the key is loaded
+ *    once. Buffers need no alignment. The AES module is used in polled mode
+ *    and must not be used by interrupts during the call.
+ *
+ * @param[in] key
+ *    128 bit key.
+ *
+ * @param[in] nonce
+ *    Nonce, AESCCM_NONCE_MIN to AESCCM_NONCE_MAX bytes. A nonce must never
+ *    be used twice with the same key.
+ *
+ * @param[in] nonceLen
+ *    Nonce length in bytes.
+ *
+ * @param[in] aad
+ *    Associated data, authenticated but not encrypted. May be NULL if
+ *    aadLen is 0.
+ *
+ * @param[in] aadLen
+ *    Associated data length in bytes.
+ *
+ * @param[out] out
+ *    Ciphertext, len bytes, may be the same as in.
+ *
+ * @param[in] in
+ *    Plaintext.
+ *
+ * @param[in] len
+ *    Message length in bytes, any length that fits the length field.
+ *
+ * @param[out] tag
+ *    Authentication tag, tagLen bytes.
+ *
+ * @param[in] tagLen
+ *    Tag length in bytes, even, AESCCM_TAG_MIN to AESCCM_TAG_MAX.
+ *
+ * @return
+ *    false if a length is not allowed, nothing is written then.
+ *****************************************************************************/
+bool AESCCM_Encrypt(const uint8_t *key,
+                    const uint8_t *nonce,
+                    uint32_t nonceLen,
+                    const uint8_t *aad,
+                    uint32_t aadLen,
+                    uint8_t *out,
+                    const uint8_t *in,
+                    uint32_t len,
+                    uint8_t *tag,
+                    uint32_t tagLen)
+{
+  uint32_t mac[4];
+  uint32_t counter[4];
+  uint32_t mask[4];
+  int i;
+
+  if (!start(key, nonce, nonceLen, aad, aadLen, len, tagLen,
+             mac, counter, mask)) {
+    return false;
+  }
+
+  crypt(mac, counter, (AESCCM_BLOCK_SIZE - 1) - nonceLen,
+        out, in, len, false);
+
+  for (i = 0; i < 4; i++) {
+    mac[i] ^= mask[i];
+  }
+  memcpy(tag, mac, tagLen);
+
+  return true;
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Decrypt a message with AES-128 CCM and check its tag.
+ *
+ * @details
+ *    Same single pass as AESCCM_Encrypt(). The tag is compared in constant
+ *    time. The plaintext is only known to be authentic once the call
+ *    returns true; on a tag mismatch the output is cleared.
+ *
+ * @param[in] key
+ *    128 bit key.
+ *
+ * @param[in] nonce
+ *    Nonce used for the encryption.
+ *
+ * @param[in] nonceLen
+ *    Nonce length in bytes.
+ *
+ * @param[in] aad
+ *    Associated data. May be NULL if aadLen is 0.
+ *
+ * @param[in] aadLen
+ *    Associated data length in bytes.
+ *
+ * @param[out] out
+ *    Plaintext, len bytes, may be the same as in.
+ *
+ * @param[in] in
+ *    Ciphertext.
+ *
+ * @param[in] len
+ *    Message length in bytes.
+ *
+ * @param[in] tag
+ *    Received authentication tag.
+ *
+ * @param[in] tagLen
+ *    Tag length in bytes.
+ *
+ * @return
+ *    true if the tag matches, false if it does not or a length is not
+ *    allowed.
+ *****************************************************************************/
+bool AESCCM_Decrypt(const uint8_t *key,
+                    const uint8_t *nonce,
+                    uint32_t nonceLen,
+                    const uint8_t *aad,
+                    uint32_t aadLen,
+                    uint8_t *out,
+                    const uint8_t *in,
+                    uint32_t len,
+                    const uint8_t *tag,
+                    uint32_t tagLen)
+{
+  uint32_t mac[4];
+  uint32_t counter[4];
+  uint32_t mask[4];
+  const uint8_t *m = (const uint8_t *)mac;
+  uint8_t diff = 0;
+  uint32_t i;
+
+  if (!start(key, nonce, nonceLen, aad, aadLen, len, tagLen,
+             mac, counter, mask)) {
+    return false;
+  }
+
+  crypt(mac, counter, (AESCCM_BLOCK_SIZE - 1) - nonceLen,
+        out, in, len, true);
+
+  for (i = 0; i < 4; i++) {
+    mac[i] ^= mask[i];
+  }
+  for (i = 0; i < tagLen; i++) {
+    diff |= m[i] ^ tag[i];
+  }
+
+  if (diff != 0) {
+    memset(out, 0, len);
+    return false;
+  }
+  return true;
+}
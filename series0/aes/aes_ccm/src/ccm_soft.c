@@ -0,0 +1,366 @@
+/***************************************************************************//**
+ * @file ccm_soft.c
+ * @brief Software AES-128 CCM, the reference for the throughput comparison.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2022 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ******************************************************************************/
+
+#include <stdint.h>
+#include <string.h>
+#include "aes_ccm.h"
+#include "ccm_soft.h"
+
+// Expanded key, 11 round keys
+#define ROUND_KEYS_SIZE   176
+
+static const uint8_t sbox[256] = {
+  0x63, 0x7C, 0x77, 0x7B, 0xF2, 0x6B, 0x6F, 0xC5,
+  0x30, 0x01, 0x67, 0x2B, 0xFE, 0xD7, 0xAB, 0x76,
+  0xCA, 0x82, 0xC9, 0x7D, 0xFA, 0x59, 0x47, 0xF0,
+  0xAD, 0xD4, 0xA2, 0xAF, 0x9C, 0xA4, 0x72, 0xC0,
+  0xB7, 0xFD, 0x93, 0x26, 0x36, 0x3F, 0xF7, 0xCC,
+  0x34, 0xA5, 0xE5, 0xF1, 0x71, 0xD8, 0x31, 0x15,
+  0x04, 0xC7, 0x23, 0xC3, 0x18, 0x96, 0x05, 0x9A,
+  0x07, 0x12, 0x80, 0xE2, 0xEB, 0x27, 0xB2, 0x75,
+  0x09, 0x83, 0x2C, 0x1A, 0x1B, 0x6E, 0x5A, 0xA0,
+  0x52, 0x3B, 0xD6, 0xB3, 0x29, 0xE3, 0x2F, 0x84,
+  0x53, 0xD1, 0x00, 0xED, 0x20, 0xFC, 0xB1, 0x5B,
+  0x6A, 0xCB, 0xBE, 0x39, 0x4A, 0x4C, 0x58, 0xCF,
+  0xD0, 0xEF, 0xAA, 0xFB, 0x43, 0x4D, 0x33, 0x85,
+  0x45, 0xF9, 0x02, 0x7F, 0x50, 0x3C, 0x9F, 0xA8,
+  0x51, 0xA3, 0x40, 0x8F, 0x92, 0x9D, 0x38, 0xF5,
+  0xBC, 0xB6, 0xDA, 0x21, 0x10, 0xFF, 0xF3, 0xD2,
+  0xCD, 0x0C, 0x13, 0xEC, 0x5F, 0x97, 0x44, 0x17,
+  0xC4, 0xA7, 0x7E, 0x3D, 0x64, 0x5D, 0x19, 0x73,
+  0x60, 0x81, 0x4F, 0xDC, 0x22, 0x2A, 0x90, 0x88,
+  0x46, 0xEE, 0xB8, 0x14, 0xDE, 0x5E, 0x0B, 0xDB,
+  0xE0, 0x32, 0x3A, 0x0A, 0x49, 0x06, 0x24, 0x5C,
+  0xC2, 0xD3, 0xAC, 0x62, 0x91, 0x95, 0xE4, 0x79,
+  0xE7, 0xC8, 0x37, 0x6D, 0x8D, 0xD5, 0x4E, 0xA9,
+  0x6C, 0x56, 0xF4, 0xEA, 0x65, 0x7A, 0xAE, 0x08,
+  0xBA, 0x78, 0x25, 0x2E, 0x1C, 0xA6, 0xB4, 0xC6,
+  0xE8, 0xDD, 0x74, 0x1F, 0x4B, 0xBD, 0x8B, 0x8A,
+  0x70, 0x3E, 0xB5, 0x66, 0x48, 0x03, 0xF6, 0x0E,
+  0x61, 0x35, 0x57, 0xB9, 0x86, 0xC1, 0x1D, 0x9E,
+  0xE1, 0xF8, 0x98, 0x11, 0x69, 0xD9, 0x8E, 0x94,
+  0x9B, 0x1E, 0x87, 0xE9, 0xCE, 0x55, 0x28, 0xDF,
+  0x8C, 0xA1, 0x89, 0x0D, 0xBF, 0xE6, 0x42, 0x68,
+  0x41, 0x99, 0x2D, 0x0F, 0xB0, 0x54, 0xBB, 0x16
+};
+
+/**************************************************************************//**
+ * @brief
+ *    Multiply by x in GF(2^8).
+ *****************************************************************************/
+static uint8_t xtime(uint8_t b)
+{
+  return (uint8_t)((b << 1) ^ ((b & 0x80) ? 0x1B : 0));
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Expand a 128 bit key into the 11 round keys.
+ *****************************************************************************/
+static void expandKey(uint8_t *roundKeys, const uint8_t *key)
+{
+  uint8_t rcon = 1;
+  uint8_t t[4];
+  uint32_t i;
+
+  memcpy(roundKeys, key, 16);
+
+  for (i = 16; i < ROUND_KEYS_SIZE; i += 4) {
+    memcpy(t, &roundKeys[i - 4], 4);
+    if ((i % 16) == 0) {
+      uint8_t first = t[0];
+
+      t[0] = sbox[t[1]] ^ rcon;
+      t[1] = sbox[t[2]];
+      t[2] = sbox[t[3]];
+      t[3] = sbox[first];
+      rcon = xtime(rcon);
+    }
+    roundKeys[i]     = roundKeys[i - 16] ^ t[0];
+    roundKeys[i + 1] = roundKeys[i - 15] ^ t[1];
+    roundKeys[i + 2] = roundKeys[i - 14] ^ t[2];
+    roundKeys[i + 3] = roundKeys[i - 13] ^ t[3];
+  }
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Encrypt one block in place, byte oriented with no tables but the
+ *    S-box, as small software implementations do.
+ *****************************************************************************/
+static void encryptBlock(const uint8_t *roundKeys, uint8_t *s)
+{
+  uint8_t t[16];
+  uint32_t round, c, i;
+
+  for (i = 0; i < 16; i++) {
+    s[i] ^= roundKeys[i];
+  }
+
+  for (round = 1; round <= 10; round++) {
+    // SubBytes and ShiftRows, column major state
+    for (i = 0; i < 16; i++) {
+      t[i] = sbox[s[(i + 4 * (i % 4)) % 16]];
+    }
+
+    // MixColumns, skipped in the last round
+    for (c = 0; c < 16; c += 4) {
+      if (round < 10) {
+        uint8_t a = t[c] ^ t[c + 1] ^ t[c + 2] ^ t[c + 3];
+        uint8_t first = t[c];
+
+        s[c]     = t[c] ^ a ^ xtime(t[c] ^ t[c + 1]);
+        s[c + 1] = t[c + 1] ^ a ^ xtime(t[c + 1] ^ t[c + 2]);
+        s[c + 2] = t[c + 2] ^ a ^ xtime(t[c + 2] ^ t[c + 3]);
+        s[c + 3] = t[c + 3] ^ a ^ xtime(t[c + 3] ^ first);
+      } else {
+        memcpy(&s[c], &t[c], 4);
+      }
+    }
+
+    for (i = 0; i < 16; i++) {
+      s[i] ^= roundKeys[16 * round + i];
+    }
+  }
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Check the lengths, set up the counter block A1 and the tag mask S0 and
+ *    run the CBC-MAC over B0 and the associated data.
+ *****************************************************************************/
+static bool start(const uint8_t *roundKeys,
+                  const uint8_t *nonce,
+                  uint32_t nonceLen,
+                  const uint8_t *aad,
+                  uint32_t aadLen,
+                  uint32_t len,
+                  uint32_t tagLen,
+                  uint8_t *mac,
+                  uint8_t *counter,
+                  uint8_t *mask)
+{
+  uint32_t q = (AESCCM_BLOCK_SIZE - 1) - nonceLen;
+  uint32_t pos, i;
+
+  if ((nonceLen < AESCCM_NONCE_MIN) || (nonceLen > AESCCM_NONCE_MAX)
+      || (tagLen < AESCCM_TAG_MIN) || (tagLen > AESCCM_TAG_MAX)
+      || ((tagLen & 1) != 0)
+      || ((q < 4) && ((len >> (8 * q)) != 0))) {
+    return false;
+  }
+
+  memset(counter, 0, AESCCM_BLOCK_SIZE);
+  counter[0] = (uint8_t)(q - 1);
+  memcpy(&counter[1], nonce, nonceLen);
+  memcpy(mask, counter, AESCCM_BLOCK_SIZE);
+  encryptBlock(roundKeys, mask);
+  counter[AESCCM_BLOCK_SIZE - 1] = 1;
+
+  memset(mac, 0, AESCCM_BLOCK_SIZE);
+  mac[0] = (uint8_t)(((aadLen > 0) ? 0x40 : 0) | (((tagLen - 2) / 2) << 3)
+                     | (q - 1));
+  memcpy(&mac[1], nonce, nonceLen);
+  for (i = 0; (i < q) && (i < 4); i++) {
+    mac[AESCCM_BLOCK_SIZE - 1 - i] = (uint8_t)(len >> (8 * i));
+  }
+  encryptBlock(roundKeys, mac);
+
+  if (aadLen == 0) {
+    return true;
+  }
+
+  if (aadLen < 0xFF00) {
+    mac[0] ^= (uint8_t)(aadLen >> 8);
+    mac[1] ^= (uint8_t)aadLen;
+    pos = 2;
+  } else {
+    mac[0] ^= 0xFF;
+    mac[1] ^= 0xFE;
+    mac[2] ^= (uint8_t)(aadLen >> 24);
+    mac[3] ^= (uint8_t)(aadLen >> 16);
+    mac[4] ^= (uint8_t)(aadLen >> 8);
+    mac[5] ^= (uint8_t)aadLen;
+    pos = 6;
+  }
+
+  for (i = 0; i < aadLen; i++) {
+    mac[pos++] ^= aad[i];
+    if (pos == AESCCM_BLOCK_SIZE) {
+      encryptBlock(roundKeys, mac);
+      pos = 0;
+    }
+  }
+  if (pos > 0) {
+    encryptBlock(roundKeys, mac);
+  }
+
+  return true;
+}
+
+/**************************************************************************//**
+ * @brief
+ *    CBC-MAC pass over the plaintext.
+ *****************************************************************************/
+static void macPass(const uint8_t *roundKeys,
+                    uint8_t *mac,
+                    const uint8_t *data,
+                    uint32_t len)
+{
+  uint32_t i;
+
+  while (len > 0) {
+    for (i = 0; (i < AESCCM_BLOCK_SIZE) && (i < len); i++) {
+      mac[i] ^= data[i];
+    }
+    encryptBlock(roundKeys, mac);
+    data += i;
+    len  -= i;
+  }
+}
+
+/**************************************************************************//**
+ * @brief
+ *    CTR pass, the counter is the last q bytes of the counter block.
+ *****************************************************************************/
+static void ctrPass(const uint8_t *roundKeys,
+                    uint8_t *counter,
+                    uint32_t q,
+                    uint8_t *out,
+                    const uint8_t *in,
+                    uint32_t len)
+{
+  uint8_t keystream[AESCCM_BLOCK_SIZE];
+  uint32_t i;
+
+  while (len > 0) {
+    memcpy(keystream, counter, AESCCM_BLOCK_SIZE);
+    encryptBlock(roundKeys, keystream);
+    for (i = AESCCM_BLOCK_SIZE - 1; i >= AESCCM_BLOCK_SIZE - q; i--) {
+      if (++counter[i] != 0) {
+        break;
+      }
+    }
+    for (i = 0; (i < AESCCM_BLOCK_SIZE) && (i < len); i++) {
+      out[i] = in[i] ^ keystream[i];
+    }
+    in  += i;
+    out += i;
+    len -= i;
+  }
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Encrypt and authenticate a message, same arguments and result as
+ *    AESCCM_Encrypt().
+ *
+ * @details
+ *    Done the textbook way: the key is expanded, the CBC-MAC runs over the
+ *    plaintext and then a separate CTR pass encrypts it, so the message is
+ *    read twice. out must not overlap in.
+ *****************************************************************************/
+bool SOFTCCM_Encrypt(const uint8_t *key,
+                     const uint8_t *nonce,
+                     uint32_t nonceLen,
+                     const uint8_t *aad,
+                     uint32_t aadLen,
+                     uint8_t *out,
+                     const uint8_t *in,
+                     uint32_t len,
+                     uint8_t *tag,
+                     uint32_t tagLen)
+{
+  uint8_t roundKeys[ROUND_KEYS_SIZE];
+  uint8_t mac[AESCCM_BLOCK_SIZE];
+  uint8_t counter[AESCCM_BLOCK_SIZE];
+  uint8_t mask[AESCCM_BLOCK_SIZE];
+  uint32_t i;
+
+  expandKey(roundKeys, key);
+  if (!start(roundKeys, nonce, nonceLen, aad, aadLen, len, tagLen,
+             mac, counter, mask)) {
+    return false;
+  }
+
+  macPass(roundKeys, mac, in, len);
+  ctrPass(roundKeys, counter, (AESCCM_BLOCK_SIZE - 1) - nonceLen,
+          out, in, len);
+
+  for (i = 0; i < tagLen; i++) {
+    tag[i] = mac[i] ^ mask[i];
+  }
+  return true;
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Decrypt a message and check its tag, same arguments and result as
+ *    AESCCM_Decrypt(). The CTR pass runs first, then the CBC-MAC over the
+ *    plaintext in out.
+ *****************************************************************************/
+bool SOFTCCM_Decrypt(const uint8_t *key,
+                     const uint8_t *nonce,
+                     uint32_t nonceLen,
+                     const uint8_t *aad,
+                     uint32_t aadLen,
+                     uint8_t *out,
+                     const uint8_t *in,
+                     uint32_t len,
+                     const uint8_t *tag,
+                     uint32_t tagLen)
+{
+  uint8_t roundKeys[ROUND_KEYS_SIZE];
+  uint8_t mac[AESCCM_BLOCK_SIZE];
+  uint8_t counter[AESCCM_BLOCK_SIZE];
+  uint8_t mask[AESCCM_BLOCK_SIZE];
+  uint8_t diff = 0;
+  uint32_t i;
+
+  expandKey(roundKeys, key);
+  if (!start(roundKeys, nonce, nonceLen, aad, aadLen, len, tagLen,
+             mac, counter, mask)) {
+    return false;
+  }
+
+  ctrPass(roundKeys, counter, (AESCCM_BLOCK_SIZE - 1) - nonceLen,
+          out, in, len);
+  macPass(roundKeys, mac, out, len);
+
+  for (i = 0; i < tagLen; i++) {
+    diff |= mac[i] ^ mask[i] ^ tag[i];
+  }
+
+  if (diff != 0) {
+    memset(out, 0, len);
+    return false;
+  }
+  return true;
+}
@@ -0,0 +1,332 @@
+/***************************************************************************//**
+ * @file main_s0.c
+ * @brief This project checks AES-128 CCM on the AES module against the NIST
+ * test vectors and measures its throughput against a two pass version built
+ * from the emlib modes and a software implementation.
+ * and compares polled, interrupt and DMA feeding of the AES module.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2022 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ *******************************************************************************
+ * # Evaluation Quality
+ * This code has been minimally tested to ensure that it builds and is suitable
+ * as a demonstration for evaluation purposes only. This code will be maintained
+ * at the sole discretion of Silicon Labs.
+ ******************************************************************************/
+
+#include <stdio.h>
+#include <string.h>
+#include "em_device.h"
+#include "em_cmu.h"
+#include "em_chip.h"
+#include "em_emu.h"
+#include "em_aes.h"
+#include "retargetserial.h"
+#include "benchmark.h"
+#include "aes_ccm.h"
+#include "ccm_soft.h"
+
+// Note: change these to change the message sizes that are measured
+//       (each must be a multiple of 16 and at most MAX_DATA_SIZE, the two
+//       pass case uses AES_CBC128 and AES_CTR128 on whole blocks)
+static const uint32_t dataSizes[] = { 16, 64, 256, 1024 };
+
+#define SIZE_COUNT      (sizeof(dataSizes) / sizeof(dataSizes[0]))
+
+#define MAX_DATA_SIZE   1024
+#define MAX_DATA_WORDS  (MAX_DATA_SIZE / 4)
+
+// Number of times each case is run, the table shows min/avg/max
+#define BENCHMARK_RUNS  4
+
+// Nonce and tag sizes of the measured messages, as used by 802.15.4
+#define NONCE_SIZE      13
+#define TAG_SIZE        8
+
+// Buffers are word arrays so the emlib AES functions get aligned data
+static uint32_t plainData[MAX_DATA_WORDS];
+static uint32_t cipherData[MAX_DATA_WORDS];
+static uint32_t referenceData[MAX_DATA_WORDS];
+static uint32_t decryptedData[MAX_DATA_WORDS];
+
+// CBC output of the two pass case, only its last block is the MAC
+static uint32_t macScratch[MAX_DATA_WORDS];
+
+static uint8_t tag[TAG_SIZE];
+static uint8_t referenceTag[TAG_SIZE];
+
+// Key and nonce of the NIST SP 800-38C examples
+static const uint32_t key[4] = {
+  0x43424140, 0x47464544, 0x4B4A4948, 0x4F4E4D4C
+};
+
+static const uint8_t nonce[NONCE_SIZE] = {
+  0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16,
+  0x17, 0x18, 0x19, 0x1A, 0x1B, 0x1C
+};
+
+#define KEY     ((const uint8_t *)key)
+
+// NIST SP 800-38C appendix C examples 1 to 3: nonce, associated data and
+// plaintext are counting patterns starting at 0x10, 0x00 and 0x20
+static const struct {
+  uint32_t nonceLen;
+  uint32_t aadLen;
+  uint32_t len;
+  uint32_t tagLen;
+  uint8_t  expected[32];
+} vectors[] = {
+  { 7, 8, 4, 4,
+    { 0x71, 0x62, 0x01, 0x5B, 0x4D, 0xAC, 0x25, 0x5D } },
+  { 8, 16, 16, 6,
+    { 0xD2, 0xA1, 0xF0, 0xE0, 0x51, 0xEA, 0x5F, 0x62,
+      0x08, 0x1A, 0x77, 0x92, 0x07, 0x3D, 0x59, 0x3D,
+      0x1F, 0xC6, 0x4F, 0xBF, 0xAC, 0xCD } },
+  { 12, 20, 24, 8,
+    { 0xE3, 0xB2, 0x01, 0xA9, 0xF5, 0xB7, 0x1A, 0x7A,
+      0x9B, 0x1C, 0xEA, 0xEC, 0xCD, 0x97, 0xE7, 0x0B,
+      0x61, 0x76, 0xAA, 0xD9, 0xA4, 0x42, 0x8A, 0xA5,
+      0x48, 0x43, 0x92, 0xFB, 0xC1, 0xB0, 0x99, 0x51 } },
+};
+
+#define VECTOR_COUNT (sizeof(vectors) / sizeof(vectors[0]))
+
+// A flag indicating whether any check failed: a test vector, a tampered
+// tag that was accepted, or a measured case that did not match the single
+// pass result. Note: This is only volatile to ensure that it doesn't get
+// optimized out by the compiler before the user checks its value.
+static volatile bool isError;
+
+/**************************************************************************//**
+ * @brief
+ *    Encrypt, decrypt and tamper with one test vector, with the AES module
+ *    or with the software implementation
+ *****************************************************************************/
+static void checkVector(uint32_t v, bool software)
+{
+  uint8_t vectorNonce[AESCCM_NONCE_MAX];
+  uint8_t aad[32];
+  uint8_t plain[32];
+  uint8_t cipher[32];
+  uint8_t decrypted[32];
+  uint8_t vectorTag[AESCCM_TAG_MAX];
+  uint32_t len = vectors[v].len;
+  uint32_t tagLen = vectors[v].tagLen;
+  bool ok;
+
+  for (uint32_t i = 0; i < sizeof(plain); i++) {
+    aad[i] = (uint8_t)i;
+    plain[i] = (uint8_t)(0x20 + i);
+  }
+  memcpy(vectorNonce, nonce, sizeof(vectorNonce));
+
+  if (software) {
+    ok = SOFTCCM_Encrypt(KEY, vectorNonce, vectors[v].nonceLen,
+                         aad, vectors[v].aadLen, cipher, plain, len,
+                         vectorTag, tagLen);
+  } else {
+    ok = AESCCM_Encrypt(KEY, vectorNonce, vectors[v].nonceLen,
+                        aad, vectors[v].aadLen, cipher, plain, len,
+                        vectorTag, tagLen);
+  }
+  if (!ok
+      || (memcmp(cipher, vectors[v].expected, len) != 0)
+      || (memcmp(vectorTag, &vectors[v].expected[len], tagLen) != 0)) {
+    isError = true;
+  }
+
+  // Decrypt, then flip a tag bit, which must be rejected
+  for (uint32_t pass = 0; pass < 2; pass++) {
+    if (software) {
+      ok = SOFTCCM_Decrypt(KEY, vectorNonce, vectors[v].nonceLen,
+                           aad, vectors[v].aadLen, decrypted, cipher, len,
+                           vectorTag, tagLen);
+    } else {
+      ok = AESCCM_Decrypt(KEY, vectorNonce, vectors[v].nonceLen,
+                          aad, vectors[v].aadLen, decrypted, cipher, len,
+                          vectorTag, tagLen);
+    }
+    if ((pass == 0) && (!ok || (memcmp(decrypted, plain, len) != 0))) {
+      isError = true;
+    }
+    if ((pass == 1) && ok) {
+      isError = true;
+    }
+    vectorTag[0] ^= 0x01;
+  }
+}
+
+/**************************************************************************//**
+ * @brief
+ *    CCM from the emlib modes: a CBC pass for the MAC, then a CTR pass
+ *
+ * @details
+ *    The CBC-MAC is AES_CBC128 over the message with E(B0) as the IV, its
+ *    last ciphertext block is the MAC, so the message is read twice and the
+ *    CBC output needs a scratch buffer of the message size. No associated
+ *    data, whole blocks only.
+ *****************************************************************************/
+static void twoPassEncrypt(uint32_t len)
+{
+  uint32_t block[4];
+  uint32_t mask[4];
+  uint8_t *b = (uint8_t *)block;
+  const uint8_t *mac = (const uint8_t *)&macScratch[(len - 16) / 4];
+
+  // B0: flags, nonce, message length
+  b[0] = (uint8_t)((((TAG_SIZE - 2) / 2) << 3) | (14 - NONCE_SIZE));
+  memcpy(&b[1], nonce, NONCE_SIZE);
+  b[14] = (uint8_t)(len >> 8);
+  b[15] = (uint8_t)len;
+  AES_ECB128(b, b, 16, KEY, true);
+  AES_CBC128((uint8_t *)macScratch, (const uint8_t *)plainData, len,
+             KEY, b, true);
+
+  // A0 for the tag mask, then A1 onwards for the message
+  memset(block, 0, sizeof(block));
+  b[0] = (uint8_t)(14 - NONCE_SIZE);
+  memcpy(&b[1], nonce, NONCE_SIZE);
+  AES_ECB128((uint8_t *)mask, b, 16, KEY, true);
+  b[15] = 1;
+  AES_CTR128((uint8_t *)cipherData, (const uint8_t *)plainData, len,
+             KEY, b, AES_CTRUpdate32Bit);
+
+  for (uint32_t i = 0; i < TAG_SIZE; i++) {
+    tag[i] = mac[i] ^ ((const uint8_t *)mask)[i];
+  }
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Compare the last result with the single pass result
+ *****************************************************************************/
+static void checkResult(uint32_t len)
+{
+  if ((memcmp(cipherData, referenceData, len) != 0)
+      || (memcmp(tag, referenceTag, TAG_SIZE) != 0)) {
+    isError = true;
+  }
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Time all cases for one message size
+ *****************************************************************************/
+static void benchmarkSize(uint32_t len)
+{
+  const uint8_t *plain = (const uint8_t *)plainData;
+  uint8_t *cipher = (uint8_t *)cipherData;
+  uint8_t *decrypted = (uint8_t *)decryptedData;
+  uint32_t start;
+
+  BENCHMARK_Reset();
+
+  for (uint32_t run = 0; run < BENCHMARK_RUNS; run++) {
+    BENCHMARK_START(start);
+    AESCCM_Encrypt(KEY, nonce, NONCE_SIZE, NULL, 0,
+                   cipher, plain, len, tag, TAG_SIZE);
+    BENCHMARK_STOP("ccm aes single pass enc", start, len);
+    memcpy(referenceData, cipherData, len);
+    memcpy(referenceTag, tag, TAG_SIZE);
+
+    BENCHMARK_START(start);
+    if (!AESCCM_Decrypt(KEY, nonce, NONCE_SIZE, NULL, 0,
+                        decrypted, cipher, len, tag, TAG_SIZE)) {
+      isError = true;
+    }
+    BENCHMARK_STOP("ccm aes single pass dec", start, len);
+    if (memcmp(decryptedData, plainData, len) != 0) {
+      isError = true;
+    }
+
+    BENCHMARK_START(start);
+    twoPassEncrypt(len);
+    BENCHMARK_STOP("ccm aes emlib two pass", start, len);
+    checkResult(len);
+
+    BENCHMARK_START(start);
+    SOFTCCM_Encrypt(KEY, nonce, NONCE_SIZE, NULL, 0,
+                    cipher, plain, len, tag, TAG_SIZE);
+    BENCHMARK_STOP("ccm software enc", start, len);
+    checkResult(len);
+
+    BENCHMARK_START(start);
+    if (!SOFTCCM_Decrypt(KEY, nonce, NONCE_SIZE, NULL, 0,
+                         decrypted, cipher, len, tag, TAG_SIZE)) {
+      isError = true;
+    }
+    BENCHMARK_STOP("ccm software dec", start, len);
+    if (memcmp(decryptedData, plainData, len) != 0) {
+      isError = true;
+    }
+  }
+
+  printf("\n%lu bytes\n", (unsigned long)len);
+  BENCHMARK_Print();
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Main function
+ *****************************************************************************/
+int main(void)
+{
+  uint8_t *plain = (uint8_t *)plainData;
+
+  // Chip errata
+  CHIP_Init();
+
+  // Cycle counter and serial port for the benchmark results
+  BENCHMARK_Init();
+  RETARGET_SerialInit();
+  RETARGET_SerialCrLf(1);
+
+  // Enable AES clock
+  CMU_ClockEnable(cmuClock_AES, true);
+
+  isError = false;
+
+  for (uint32_t v = 0; v < VECTOR_COUNT; v++) {
+    checkVector(v, false);
+    checkVector(v, true);
+  }
+  printf("\nNIST SP 800-38C vectors %s\n", isError ? "FAILED" : "passed");
+
+  // Fill the message with a counting pattern
+  for (uint32_t i = 0; i < MAX_DATA_SIZE; i++) {
+    plain[i] = (uint8_t)i;
+  }
+
+  for (uint32_t i = 0; i < SIZE_COUNT; i++) {
+    benchmarkSize(dataSizes[i]);
+  }
+
+  printf("\nDone, isError = %d\n", isError ? 1 : 0);
+
+  // Pause the debugger here to check if the isError variable is true/false
+  while (1) {
+    EMU_EnterEM1();
+  }
+}
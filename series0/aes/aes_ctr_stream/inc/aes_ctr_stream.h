@@ -0,0 +1,70 @@
+/***************************************************************************//**
+ * @file aes_ctr_stream.h
+ * @brief Incremental AES CTR mode encryption for data arriving in fragments.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2022 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ******************************************************************************/
+
+#ifndef AES_CTR_STREAM_H
+#define AES_CTR_STREAM_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "em_aes.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/// AES block size in bytes
+#define AESCTR_BLOCK_SIZE   16
+
+/// CTR stream context. The fields are private, use the functions below.
+typedef struct {
+  uint32_t key[8];                  ///< Key, 4 or 8 words
+  uint32_t counter[4];              ///< Counter for the next keystream block
+  uint32_t keystream[4];            ///< Current keystream block
+  uint32_t offset;                  ///< Keystream bytes already used
+  bool aes256;                      ///< 256 bit key
+  AES_CtrFuncPtr_TypeDef ctrFunc;   ///< Counter update function
+} AESCTR_Context_t;
+
+void AESCTR_Init(AESCTR_Context_t *ctx,
+                 const uint8_t *key,
+                 bool aes256,
+                 const uint8_t *counter,
+                 AES_CtrFuncPtr_TypeDef ctrFunc);
+void AESCTR_Update(AESCTR_Context_t *ctx,
+                   uint8_t *out,
+                   const uint8_t *in,
+                   uint32_t len);
+void AESCTR_GetCounter(const AESCTR_Context_t *ctx, uint8_t *counter);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // AES_CTR_STREAM_H
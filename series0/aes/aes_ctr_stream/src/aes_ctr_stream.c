@@ -0,0 +1,198 @@
+/***************************************************************************//**
+ * @file main_s0.c
+ * @file aes_ctr_stream.c
+ * @brief Incremental AES CTR mode encryption for data arriving in fragments.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2022 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ******************************************************************************/
+
+#include <stdint.h>
+#include <string.h>
+#include "em_device.h"
+#include "em_aes.h"
+#include "aes_ctr_stream.h"
+
+/**************************************************************************//**
+ * @brief
+ *    Load the context key into the AES key buffer.
+ *
+ * @details
+ *    The key buffer reloads the key before every block, so this is done once
+ *    per update call instead of once per block. Reloading per call keeps the
+ *    context correct if other code uses the AES module in between.
+ *****************************************************************************/
+static void loadKey(const AESCTR_Context_t *ctx)
+{
+  int i;
+
+  if (ctx->aes256) {
+    AES->CTRL = AES_CTRL_AES256 | AES_CTRL_KEYBUFEN | AES_CTRL_DATASTART;
+    for (i = 3; i >= 0; i--) {
+      AES->KEYLA = __REV(ctx->key[i + 4]);
+      AES->KEYHA = __REV(ctx->key[i]);
+    }
+  } else {
+    AES->CTRL = AES_CTRL_KEYBUFEN | AES_CTRL_DATASTART;
+    for (i = 3; i >= 0; i--) {
+      AES->KEYHA = __REV(ctx->key[i]);
+    }
+  }
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Encrypt the counter into the keystream buffer and advance the counter.
+ *****************************************************************************/
+static void nextKeystream(AESCTR_Context_t *ctx)
+{
+  int i;
+
+  // Writing the last word starts the encryption
+  for (i = 3; i >= 0; i--) {
+    AES->DATA = __REV(ctx->counter[i]);
+  }
+
+  // Update the counter while the block is being encrypted
+  ctx->ctrFunc((uint8_t *)ctx->counter);
+
+  while (AES->STATUS & AES_STATUS_RUNNING) ;
+
+  for (i = 3; i >= 0; i--) {
+    ctx->keystream[i] = __REV(AES->DATA);
+  }
+  ctx->offset = 0;
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Initialize a CTR stream context.
+ *
+ * @param[out] ctx
+ *    Context to initialize.
+ *
+ * @param[in] key
+ *    128 or 256 bit key. Copied into the context, no alignment needed.
+ *
+ * @param[in] aes256
+ *    True for a 256 bit key, false for a 128 bit key.
+ *
+ * @param[in] counter
+ *    128 bit initial counter. Copied into the context.
+ *
+ * @param[in] ctrFunc
+ *    Function used to update the counter after each block, for example
+ *    AES_CTRUpdate32Bit.
+ *****************************************************************************/
+void AESCTR_Init(AESCTR_Context_t *ctx,
+                 const uint8_t *key,
+                 bool aes256,
+                 const uint8_t *counter,
+                 AES_CtrFuncPtr_TypeDef ctrFunc)
+{
+  memset(ctx, 0, sizeof(*ctx));
+  memcpy(ctx->key, key, aes256 ? 32 : 16);
+  memcpy(ctx->counter, counter, AESCTR_BLOCK_SIZE);
+  ctx->aes256  = aes256;
+  ctx->ctrFunc = ctrFunc;
+
+  // No keystream available yet
+  ctx->offset = AESCTR_BLOCK_SIZE;
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Encrypt or decrypt the next fragment of the stream.
+ *
+ * @details
+ *    Keystream bytes left over from a previous call are used first, so a
+ *    stream can be split at any byte boundary and give the same result as
+ *    one AES_CTR128()/AES_CTR256() call over the whole buffer. Encryption
+ *    and decryption are the same operation in CTR mode.
+ *
+ * @param[in] ctx
+ *    Context set up by AESCTR_Init().
+ *
+ * @param[out] out
+ *    Output buffer, may be the same as in for in place operation.
+ *
+ * @param[in] in
+ *    Input buffer, no alignment needed.
+ *
+ * @param[in] len
+ *    Number of bytes, any length.
+ *****************************************************************************/
+void AESCTR_Update(AESCTR_Context_t *ctx,
+                   uint8_t *out,
+                   const uint8_t *in,
+                   uint32_t len)
+{
+  const uint8_t *keystream = (const uint8_t *)ctx->keystream;
+  bool keyLoaded = false;
+
+  while (len > 0) {
+    if (ctx->offset == AESCTR_BLOCK_SIZE) {
+      if (!keyLoaded) {
+        loadKey(ctx);
+        keyLoaded = true;
+      }
+      nextKeystream(ctx);
+
+      // Whole aligned blocks are XOR'ed a word at a time
+      if ((len >= AESCTR_BLOCK_SIZE)
+          && ((((uintptr_t)in | (uintptr_t)out) & 3) == 0)) {
+        const uint32_t *in32 = (const uint32_t *)in;
+        uint32_t *out32 = (uint32_t *)out;
+
+        for (int i = 0; i < 4; i++) {
+          out32[i] = in32[i] ^ ctx->keystream[i];
+        }
+        in  += AESCTR_BLOCK_SIZE;
+        out += AESCTR_BLOCK_SIZE;
+        len -= AESCTR_BLOCK_SIZE;
+        ctx->offset = AESCTR_BLOCK_SIZE;
+        continue;
+      }
+    }
+
+    *out++ = *in++ ^ keystream[ctx->offset++];
+    len--;
+  }
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Read the counter value that will be used for the next keystream block.
+ *
+ * @param[in] ctx
+ *    Context set up by AESCTR_Init().
+ *
+ * @param[out] counter
+ *    16 byte buffer for the counter.
+ *****************************************************************************/
+void AESCTR_GetCounter(const AESCTR_Context_t *ctx, uint8_t *counter)
+{
+  memcpy(counter, ctx->counter, AESCTR_BLOCK_SIZE);
+}
@@ -0,0 +1,179 @@
+/***************************************************************************//**
+ * @file main_s0.c
+ * @brief This project encrypts a buffer in place as a stream of fragments with
+ * an incremental AES CTR context and checks it against AES_CTR128().
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2020 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ *******************************************************************************
+ * # Evaluation Quality
+ * This code has been minimally tested to ensure that it builds and is suitable 
+ * as a demonstration for evaluation purposes only. This code will be maintained
+ * at the sole discretion of Silicon Labs.
+ ******************************************************************************/
+
+#include "em_device.h"
+#include "em_cmu.h"
+#include "em_chip.h"
+#include "em_emu.h"
+#include "em_aes.h"
+#include "aes_ctr_stream.h"
+
+// Note: change this to change the number of bytes to encrypt
+//       (any length works for the stream, AES_CTR128 needs a multiple of 16)
+#define DATA_SIZE 256
+
+// Fragment sizes used to feed the stream, as if the data arrived in pieces
+// from a UART. The list is repeated until all data is consumed.
+static const uint8_t fragmentSizes[] = { 1, 7, 16, 3, 32, 13, 2, 48, 5, 19 };
+
+#define FRAGMENT_COUNT (sizeof(fragmentSizes) / sizeof(fragmentSizes[0]))
+
+// Buffer that is encrypted and then decrypted in place
+static uint8_t streamData[DATA_SIZE];
+
+// Original data and the reference result from AES_CTR128
+static uint32_t originalData[DATA_SIZE / 4];
+static uint32_t referenceData[DATA_SIZE / 4];
+
+// Number of bytes to make up a 128 bit key (16 * 8 = 128)
+#define KEY_SIZE 16
+
+// Note: change this to change the key
+// Note: must be 128 bits
+// Note: the same key is used for encryption and decryption in CTR mode
+const static uint8_t key[KEY_SIZE] = {
+  0x2B, 0x7E, 0x15, 0x16, 0x28, 0xAE, 0xD2, 0xA6,
+  0xAB, 0xF7, 0x15, 0x88, 0x09, 0xCF, 0x4F, 0x3C
+};
+
+// Number of bytes to make up a 128 bit counter (16 * 8 = 128)
+#define COUNTER_SIZE 16
+
+// Note: change this to change the initial counter
+// Note: must be 128 bits
+const uint8_t initialCounter[COUNTER_SIZE] = {
+  0xF0, 0xF1, 0xF2, 0xF3, 0xF4, 0xF5, 0xF6, 0xF7,
+  0xF8, 0xF9, 0xFA, 0xFB, 0xFC, 0xFD, 0xFE, 0xFF
+};
+
+// A buffer to hold the counter for the AES_CTR128 reference
+uint32_t counterBuffer[COUNTER_SIZE / 4];
+
+// Stream context
+static AESCTR_Context_t ctrContext;
+
+// Flags indicating whether the stream matched the reference and whether the
+// decrypted data matched the original data
+// Note: These are only volatile to ensure that they don't get optimized out
+// by the compiler before the user checks their value.
+static volatile bool isErrorEncrypt;
+static volatile bool isErrorDecrypt;
+
+/**************************************************************************//**
+ * @brief
+ *    Run the whole buffer through the stream context in place, one fragment
+ *    at a time
+ *
+ * @param[in] first
+ *    Index of the first fragment size to use, so encryption and decryption
+ *    split the data differently
+ *****************************************************************************/
+static void streamBuffer(uint32_t first)
+{
+  uint32_t pos = 0;
+  uint32_t n = first;
+
+  AESCTR_Init(&ctrContext, key, false, initialCounter, AES_CTRUpdate32Bit);
+
+  while (pos < DATA_SIZE) {
+    uint32_t len = fragmentSizes[n++ % FRAGMENT_COUNT];
+
+    if (len > DATA_SIZE - pos) {
+      len = DATA_SIZE - pos;
+    }
+    AESCTR_Update(&ctrContext, &streamData[pos], &streamData[pos], len);
+    pos += len;
+  }
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Main function
+ *****************************************************************************/
+int main(void)
+{
+  uint8_t *original = (uint8_t *)originalData;
+  uint8_t *reference = (uint8_t *)referenceData;
+
+  // Chip errata
+  CHIP_Init();
+
+  // Enable AES clock
+  CMU_ClockEnable(cmuClock_AES, true);
+
+  // Fill the data with a counting pattern
+  for (uint32_t i = 0; i < DATA_SIZE; i++) {
+    original[i] = (uint8_t)i;
+    streamData[i] = original[i];
+  }
+
+  // Encrypt the whole buffer in one call for reference
+  for (uint32_t i = 0; i < COUNTER_SIZE; i++) {
+    ((uint8_t *)counterBuffer)[i] = initialCounter[i];
+  }
+  AES_CTR128(reference,
+             original,
+             DATA_SIZE,
+             key,
+             (uint8_t *)counterBuffer,
+             AES_CTRUpdate32Bit);
+
+  // Encrypt in place as a stream of fragments
+  streamBuffer(0);
+
+  isErrorEncrypt = false;
+  for (uint32_t i = 0; i < DATA_SIZE; i++) {
+    if (streamData[i] != reference[i]) {
+      isErrorEncrypt = true;
+    }
+  }
+
+  // Decrypt in place, splitting the stream at different positions
+  streamBuffer(FRAGMENT_COUNT / 2);
+
+  isErrorDecrypt = false;
+  for (uint32_t i = 0; i < DATA_SIZE; i++) {
+    if (streamData[i] != original[i]) {
+      isErrorDecrypt = true;
+    }
+  }
+
+  // Pause the debugger here to check if the isErrorEncrypt and
+  // isErrorDecrypt variables are true/false
+  while (1) {
+    EMU_EnterEM1();
+  }
+}
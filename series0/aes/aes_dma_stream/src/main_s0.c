@@ -0,0 +1,353 @@
+/***************************************************************************//**
+ * @file main_s0.c
+ * @brief This project streams a multi-kilobyte buffer through the AES module
+ * using the DMA in ECB and CBC mode while the core sleeps in EM1.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2022 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ *******************************************************************************
+ * # Evaluation Quality
+ * This code has been minimally tested to ensure that it builds and is suitable
+ * as a demonstration for evaluation purposes only. This code will be maintained
+ * at the sole discretion of Silicon Labs.
+ ******************************************************************************/
+
+#include "em_device.h"
+#include "em_cmu.h"
+#include "em_chip.h"
+#include "em_core.h"
+#include "em_emu.h"
+#include "em_aes.h"
+#include "em_dma.h"
+
+#include "dmactrl.h"
+
+#if !defined(AES_CTRL_BYTEORDER)
+#error "DMA streaming needs the AES BYTEORDER control bit"
+#endif
+
+// DMA channels used, the read channel has high priority so a finished block
+// is always drained before the next one is written
+#define DMA_CHANNEL_WRITE   0
+#define DMA_CHANNEL_READ    1
+
+// Note: change this to change the number of bytes to encrypt
+//       (must be a multiple of CHUNK_SIZE)
+#define DATA_SIZE           4096
+
+// Number of bytes moved per pair of DMA descriptors. Each chunk must be a
+// multiple of the 16 byte AES block and at most 1024 words (DMA limit).
+#define CHUNK_SIZE          1024
+
+#define BLOCK_SIZE          16
+#define DATA_WORDS          (DATA_SIZE / 4)
+#define CHUNK_WORDS         (CHUNK_SIZE / 4)
+
+#if (CHUNK_SIZE % BLOCK_SIZE) || (DATA_SIZE % CHUNK_SIZE) || (CHUNK_WORDS > 1024)
+#error "CHUNK_SIZE must be a multiple of 16, at most 4096 and divide DATA_SIZE"
+#endif
+
+// Buffers are word arrays so the DMA and the AES library get aligned data
+static uint32_t originalData[DATA_WORDS];
+static uint32_t encryptedData[DATA_WORDS];
+static uint32_t referenceData[DATA_WORDS];
+
+// Number of bytes to make up a 128 bit key (16 * 8 = 128)
+#define KEY_SIZE 16
+
+// Note: change this to change the key
+// Note: must be 128 bits
+SL_ALIGN(4) const static uint8_t key[KEY_SIZE] SL_ATTRIBUTE_ALIGN(4) = {
+  0x2B, 0x7E, 0x15, 0x16, 0x28, 0xAE, 0xD2, 0xA6,
+  0xAB, 0xF7, 0x15, 0x88, 0x09, 0xCF, 0x4F, 0x3C
+};
+
+// Note: change this to change the initialization vector used in CBC mode
+SL_ALIGN(4) const static uint8_t initVector[BLOCK_SIZE] SL_ATTRIBUTE_ALIGN(4) = {
+  0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07,
+  0x08, 0x09, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E, 0x0F
+};
+
+// Cipher modes that can be fed by the DMA. ECB writes plaintext to DATA,
+// CBC writes it to XORDATA where it is XOR'ed with the previous ciphertext
+// still held in DATA.
+typedef enum {
+  streamModeEcb,
+  streamModeCbc
+} StreamMode_t;
+
+// Stream state, updated from the DMA callback
+static uint32_t *streamDst;
+static const uint32_t *streamSrc;
+static volatile void *streamTarget;
+static volatile uint32_t chunksLeft;
+static volatile uint32_t chunksDone;
+static volatile bool streamBusy;
+
+static DMA_CB_TypeDef readCallback;
+
+// Flags indicating whether the DMA result matched the AES library result
+// Note: These are only volatile to ensure that they don't get optimized out
+// by the compiler before the user checks their value.
+static volatile bool isErrorEcb;
+static volatile bool isErrorCbc;
+
+/**************************************************************************//**
+ * @brief
+ *    Arm both DMA channels for the next chunk of the stream
+ *****************************************************************************/
+static void armChunk(void)
+{
+  uint32_t *dst = streamDst;
+  const uint32_t *src = streamSrc;
+
+  // Arm the read side first so it is ready when the first block finishes
+  DMA_ActivateBasic(DMA_CHANNEL_READ,
+                    true,
+                    false,
+                    dst,
+                    (void *)&AES->DATA,
+                    CHUNK_WORDS - 1);
+
+  DMA_ActivateBasic(DMA_CHANNEL_WRITE,
+                    true,
+                    false,
+                    (void *)streamTarget,
+                    (void *)src,
+                    CHUNK_WORDS - 1);
+
+  streamDst = dst + CHUNK_WORDS;
+  streamSrc = src + CHUNK_WORDS;
+}
+
+/**************************************************************************//**
+ * @brief
+ *    DMA callback, called when the read channel has drained a whole chunk
+ *****************************************************************************/
+static void dmaReadDone(unsigned int channel, bool primary, void *user)
+{
+  (void)channel;
+  (void)primary;
+  (void)user;
+
+  chunksDone++;
+
+  if (--chunksLeft > 0) {
+    armChunk();
+  } else {
+    streamBusy = false;
+  }
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Initialize the DMA controller and the two AES channels
+ *****************************************************************************/
+static void initDma(void)
+{
+  DMA_Init_TypeDef dmaInit;
+  DMA_CfgDescr_TypeDef descrCfg;
+  DMA_CfgChannel_TypeDef chnlCfg;
+
+  CMU_ClockEnable(cmuClock_DMA, true);
+
+  dmaInit.hprot        = 0;
+  dmaInit.controlBlock = dmaControlBlock;
+  DMA_Init(&dmaInit);
+
+  readCallback.cbFunc  = dmaReadDone;
+  readCallback.userPtr = NULL;
+
+  // Read channel: AES->DATA to memory, 4 words per request
+  chnlCfg.highPri   = true;
+  chnlCfg.enableInt = true;
+  chnlCfg.select    = DMAREQ_AES_DATARD;
+  chnlCfg.cb        = &readCallback;
+  DMA_CfgChannel(DMA_CHANNEL_READ, &chnlCfg);
+
+  descrCfg.dstInc  = dmaDataInc4;
+  descrCfg.srcInc  = dmaDataIncNone;
+  descrCfg.size    = dmaDataSize4;
+  descrCfg.arbRate = dmaArbitrate4;
+  descrCfg.hprot   = 0;
+  DMA_CfgDescr(DMA_CHANNEL_READ, true, &descrCfg);
+
+  // Write channel: memory to AES->DATA or AES->XORDATA, 4 words per request
+  descrCfg.dstInc  = dmaDataIncNone;
+  descrCfg.srcInc  = dmaDataInc4;
+  DMA_CfgDescr(DMA_CHANNEL_WRITE, true, &descrCfg);
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Start encrypting a buffer with the DMA feeding the AES module.
+ *
+ * @param[in] mode
+ *    Cipher mode, ECB or CBC.
+ *
+ * @param[out] out
+ *    Buffer for the encrypted data, may be the same as in.
+ *
+ * @param[in] in
+ *    Plaintext, word aligned.
+ *
+ * @param[in] len
+ *    Number of bytes, a multiple of CHUNK_SIZE.
+ *
+ * @param[in] keyIn
+ *    128 bit encryption key, word aligned.
+ *
+ * @param[in] iv
+ *    128 bit initialization vector, word aligned, only used in CBC mode.
+ *****************************************************************************/
+static void startStream(StreamMode_t mode, uint32_t *out, const uint32_t *in,
+                        uint32_t len, const uint8_t *keyIn, const uint8_t *iv)
+{
+  DMA_CfgChannel_TypeDef chnlCfg;
+  const uint32_t *key32 = (const uint32_t *)keyIn;
+  const uint32_t *iv32 = (const uint32_t *)iv;
+
+  // With BYTEORDER set the key and data registers take the words in memory
+  // order, so the DMA can copy buffers without any swapping. The key buffer
+  // reloads the key before every block.
+  if (mode == streamModeEcb) {
+    AES->CTRL = AES_CTRL_BYTEORDER | AES_CTRL_KEYBUFEN | AES_CTRL_DATASTART;
+  } else {
+    AES->CTRL = AES_CTRL_BYTEORDER | AES_CTRL_KEYBUFEN | AES_CTRL_XORSTART;
+  }
+
+  for (uint32_t i = 0; i < 4; i++) {
+    AES->KEYHA = key32[i];
+  }
+
+  // CBC starts with the IV in DATA, each plaintext block written to XORDATA
+  // is XOR'ed with it and encrypted, leaving the ciphertext for the next one
+  if (mode == streamModeCbc) {
+    for (uint32_t i = 0; i < 4; i++) {
+      AES->DATA = iv32[i];
+    }
+  }
+
+  // The write channel request depends on which register starts the block
+  chnlCfg.highPri   = false;
+  chnlCfg.enableInt = false;
+  chnlCfg.select    = (mode == streamModeEcb) ? DMAREQ_AES_DATAWR
+                                              : DMAREQ_AES_XORDATAWR;
+  chnlCfg.cb        = NULL;
+  DMA_CfgChannel(DMA_CHANNEL_WRITE, &chnlCfg);
+
+  streamTarget = (mode == streamModeEcb) ? &AES->DATA : &AES->XORDATA;
+  streamDst  = out;
+  streamSrc  = in;
+  chunksLeft = len / CHUNK_SIZE;
+  chunksDone = 0;
+  streamBusy = true;
+
+  armChunk();
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Sleep in EM1 until the current stream has finished
+ *****************************************************************************/
+static void waitStream(void)
+{
+  CORE_DECLARE_IRQ_STATE;
+
+  while (streamBusy) {
+    // The callback may finish the stream between the check and the sleep,
+    // so check again with interrupts masked. A pending interrupt still
+    // wakes the core from EM1.
+    CORE_ENTER_CRITICAL();
+    if (streamBusy) {
+      EMU_EnterEM1();
+    }
+    CORE_EXIT_CRITICAL();
+  }
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Compare the DMA result with the AES library result
+ *****************************************************************************/
+static bool compare(const uint32_t *a, const uint32_t *b)
+{
+  for (uint32_t i = 0; i < DATA_WORDS; i++) {
+    if (a[i] != b[i]) {
+      return true;
+    }
+  }
+  return false;
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Main function
+ *****************************************************************************/
+int main(void)
+{
+  // Chip errata
+  CHIP_Init();
+
+  // Enable AES clock
+  CMU_ClockEnable(cmuClock_AES, true);
+
+  initDma();
+
+  // Fill the plaintext with a counting pattern
+  for (uint32_t i = 0; i < DATA_WORDS; i++) {
+    originalData[i] = 0x03020100 + (i * 0x04040404);
+  }
+
+  // Encrypt data using AES-128 ECB, fed by the DMA
+  startStream(streamModeEcb, encryptedData, originalData, DATA_SIZE, key, NULL);
+  waitStream();
+
+  // Encrypt the same data with the AES library for reference
+  AES_ECB128((uint8_t *)referenceData,
+             (const uint8_t *)originalData,
+             DATA_SIZE,
+             key,
+             true);
+  isErrorEcb = compare(encryptedData, referenceData);
+
+  // Encrypt data using AES-128 CBC, fed by the DMA
+  startStream(streamModeCbc, encryptedData, originalData, DATA_SIZE, key, initVector);
+  waitStream();
+
+  AES_CBC128((uint8_t *)referenceData,
+             (const uint8_t *)originalData,
+             DATA_SIZE,
+             key,
+             initVector,
+             true);
+  isErrorCbc = compare(encryptedData, referenceData);
+
+  // Pause the debugger here to check if the isErrorEcb and isErrorCbc
+  // variables are true/false
+  while (1) {
+    EMU_EnterEM1();
+  }
+}
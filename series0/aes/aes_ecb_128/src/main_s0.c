@@ -39,6 +39,9 @@
 #include "em_chip.h"
 #include "em_emu.h"
 #include "em_aes.h"
+#include <stdio.h>
+#include "retargetserial.h"
+#include "benchmark.h"
 
 // Note: change this to change the number of bytes to encrypt
 //       (must be a multiple of 16)
@@ -85,28 +88,41 @@ static volatile bool isError;
  *****************************************************************************/
 int main(void)
 {
+  uint32_t start;
+
   // Chip errata
   CHIP_Init();
 
+  // Cycle counter and serial port for the benchmark results
+  BENCHMARK_Init();
+  RETARGET_SerialInit();
+  RETARGET_SerialCrLf(1);
+
   // Enable AES clock
   CMU_ClockEnable(cmuClock_AES, true);
 
   // Calculate decryption key from original key. Only needs to be done once for each key
+  BENCHMARK_START(start);
   AES_DecryptKey128(decryptionKey, encryptionKey);
+  BENCHMARK_STOP("aes128 decrypt key", start, 0);
 
   // Encrypt data using AES-128 ECB
+  BENCHMARK_START(start);
   AES_ECB128(encryptedData, // Pointer to buffer where encrypted/decrypted data will be put
              originalData,  // Pointer to buffer holding data to encrypt/decrypt
              DATA_SIZE,     // Number of bytes to encrypt (must be a multiple of 16)
              encryptionKey, // A 128 bit encryption/decryption key
              true);         // Use encryption mode
+  BENCHMARK_STOP("aes128 ecb encrypt", start, DATA_SIZE);
 
   // Decrypt data using AES-128 ECB
+  BENCHMARK_START(start);
   AES_ECB128(decryptedData, // Pointer to buffer where encrypted/decrypted data will be put
              encryptedData, // Pointer to buffer holding data to encrypt/decrypt
              DATA_SIZE,     // Number of bytes to encrypt (must be a multiple of 16)
              decryptionKey, // A 128 bit encryption/decryption key
              false);        // Use decryption mode
+  BENCHMARK_STOP("aes128 ecb decrypt", start, DATA_SIZE);
 
   // Check whether decrypted result is identical to the original data
   isError = false;
@@ -116,6 +132,9 @@ int main(void)
     }
   }
 
+  printf("\naes_ecb_128, %d bytes\n", DATA_SIZE);
+  BENCHMARK_Print();
+
   // Pause the debugger here to check if the isError variable is true/false
   while (1) {
     EMU_EnterEM1();
@@ -0,0 +1,63 @@
+/***************************************************************************//**
+ * @file aes_key_cache.h
+ * @brief Decryption key cache for ECB and CBC decryption with many keys.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2022 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ******************************************************************************/
+
+#ifndef AES_KEY_CACHE_H
+#define AES_KEY_CACHE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/// Number of key slots, 68 bytes of RAM each
+#ifndef AESKEY_SLOTS
+#define AESKEY_SLOTS        8
+#endif
+
+/// Cache counters
+typedef struct {
+  uint32_t hits;      ///< Lookups served from the cache
+  uint32_t misses;    ///< Lookups that generated the decryption key
+} AESKEY_Stats_t;
+
+void AESKEY_Init(void);
+const uint8_t *AESKEY_DecryptKey(uint32_t slot,
+                                 const uint8_t *key,
+                                 bool aes256);
+void AESKEY_Invalidate(uint32_t slot);
+void AESKEY_GetStats(AESKEY_Stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // AES_KEY_CACHE_H
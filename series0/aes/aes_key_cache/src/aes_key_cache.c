@@ -0,0 +1,158 @@
+/***************************************************************************//**
+ * @file aes_key_cache.c
+ * @brief Decryption key cache for ECB and CBC decryption with many keys.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2022 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ******************************************************************************/
+
+#include <stdint.h>
+#include <string.h>
+#include "em_device.h"
+#include "em_aes.h"
+#include "aes_key_cache.h"
+
+// One cached key. Word arrays, the emlib AES functions need aligned keys.
+typedef struct {
+  uint32_t key[8];          // Encryption key, 4 or 8 words
+  uint32_t decryptKey[8];   // Decryption key generated from it
+  bool aes256;
+  bool valid;
+} Slot_t;
+
+static Slot_t slots[AESKEY_SLOTS];
+static AESKEY_Stats_t stats;
+
+/**************************************************************************//**
+ * @brief
+ *    Compare a key with the key of a slot.
+ *
+ * @details
+ *    Every word is compared, so the time does not depend on where the keys
+ *    differ.
+ *****************************************************************************/
+static bool sameKey(const Slot_t *s, const uint8_t *key, uint32_t words)
+{
+  uint32_t k[8];
+  uint32_t diff = 0;
+  uint32_t i;
+
+  memcpy(k, key, words * 4);
+  for (i = 0; i < words; i++) {
+    diff |= k[i] ^ s->key[i];
+  }
+  return diff == 0;
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Clear all slots and the counters.
+ *****************************************************************************/
+void AESKEY_Init(void)
+{
+  memset(slots, 0, sizeof(slots));
+  stats.hits   = 0;
+  stats.misses = 0;
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Get the decryption key for a key, generating it only if the slot does
+ *    not hold it yet.
+ *
+ * @details
+ *    AES_DecryptKey128() and AES_DecryptKey256() run the key schedule on
+ *    the AES module, which is the same work for every packet decrypted
+ *    with the same key. Here it is done once per key and slot: the key is
+ *    compared with the one stored in the slot, and a different key
+ *    replaces it, so a slot can be given a new key at any time.
+ *
+ *    The AES clock must be enabled. The function uses the AES module on a
+ *    miss and must not be called while an AES operation is in progress.
+ *
+ * @param[in] slot
+ *    Slot number, 0 to AESKEY_SLOTS - 1, such as one per peer.
+ *
+ * @param[in] key
+ *    128 or 256 bit encryption key, no alignment needed.
+ *
+ * @param[in] aes256
+ *    True for a 256 bit key, false for a 128 bit key.
+ *
+ * @return
+ *    The word aligned decryption key to pass to AES_ECB128/256() or
+ *    AES_CBC128/256() for decryption, valid until the slot gets another
+ *    key. NULL if the slot number is out of range.
+ *****************************************************************************/
+const uint8_t *AESKEY_DecryptKey(uint32_t slot,
+                                 const uint8_t *key,
+                                 bool aes256)
+{
+  uint32_t words = aes256 ? 8 : 4;
+  Slot_t *s;
+
+  if (slot >= AESKEY_SLOTS) {
+    return NULL;
+  }
+  s = &slots[slot];
+
+  if (s->valid && (s->aes256 == aes256) && sameKey(s, key, words)) {
+    stats.hits++;
+    return (const uint8_t *)s->decryptKey;
+  }
+
+  memcpy(s->key, key, words * 4);
+  if (aes256) {
+    AES_DecryptKey256((uint8_t *)s->decryptKey, (const uint8_t *)s->key);
+  } else {
+    AES_DecryptKey128((uint8_t *)s->decryptKey, (const uint8_t *)s->key);
+  }
+  s->aes256 = aes256;
+  s->valid  = true;
+  stats.misses++;
+
+  return (const uint8_t *)s->decryptKey;
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Forget the key of a slot and clear it from RAM, such as when a peer
+ *    leaves.
+ *****************************************************************************/
+void AESKEY_Invalidate(uint32_t slot)
+{
+  if (slot < AESKEY_SLOTS) {
+    memset(&slots[slot], 0, sizeof(slots[slot]));
+  }
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Copy the counters.
+ *****************************************************************************/
+void AESKEY_GetStats(AESKEY_Stats_t *copy)
+{
+  *copy = stats;
+}
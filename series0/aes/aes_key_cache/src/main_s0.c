@@ -0,0 +1,286 @@
+/***************************************************************************//**
+ * @file main_s0.c
+ * @brief This project decrypts many small CBC packets from several peers and
+ * measures the cycles saved per packet by caching the decryption keys.
+ * and compares polled, interrupt and DMA feeding of the AES module.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2022 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ *******************************************************************************
+ * # Evaluation Quality
+ * This code has been minimally tested to ensure that it builds and is suitable
+ * as a demonstration for evaluation purposes only. This code will be maintained
+ * at the sole discretion of Silicon Labs.
+ ******************************************************************************/
+
+#include <stdio.h>
+#include <string.h>
+#include "em_device.h"
+#include "em_cmu.h"
+#include "em_chip.h"
+#include "em_emu.h"
+#include "em_aes.h"
+#include "retargetserial.h"
+#include "benchmark.h"
+#include "aes_key_cache.h"
+
+// Note: change these to change the workload
+//       (PACKET_SIZE must be a multiple of 16)
+#define PEER_COUNT      6
+#define PEERS_AES256    2
+#define PACKET_SIZE     32
+#define PACKET_COUNT    2000
+
+#if PEER_COUNT > AESKEY_SLOTS
+#error "One key slot per peer is needed"
+#endif
+
+// Peer 0 gets a new key halfway through, which the cache must pick up
+#define REKEY_PACKET    (PACKET_COUNT / 2)
+
+// Keys of the peers, the last PEERS_AES256 peers use 256 bit keys
+static uint32_t peerKey[PEER_COUNT][8];
+
+// One packet per peer, encrypted with the peer's key
+static uint32_t plainPacket[PEER_COUNT][PACKET_SIZE / 4];
+static uint32_t cipherPacket[PEER_COUNT][PACKET_SIZE / 4];
+static uint32_t decryptedPacket[PACKET_SIZE / 4];
+
+// Decryption key generated for every packet when not caching
+static uint32_t decryptKey[8];
+
+static const uint32_t initVector[4] = {
+  0x03020100, 0x07060504, 0x0B0A0908, 0x0F0E0D0C
+};
+
+// Cycles saved per packet by the cache, for 128 and 256 bit keys.
+// Note: These are only volatile so they can be viewed in the debugger.
+static volatile uint32_t cyclesSaved128;
+static volatile uint32_t cyclesSaved256;
+
+// A flag indicating whether a packet did not decrypt to its plaintext or
+// the cache did not miss exactly once per key. Note: This is only volatile
+// to ensure that it doesn't get optimized out by the compiler before the
+// user checks its value.
+static volatile bool isError;
+
+#define IV      ((const uint8_t *)initVector)
+
+/**************************************************************************//**
+ * @brief
+ *    Whether a peer uses a 256 bit key
+ *****************************************************************************/
+static bool isAes256(uint32_t peer)
+{
+  return peer >= (PEER_COUNT - PEERS_AES256);
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Give a peer a key derived from a seed and encrypt its packet with it
+ *****************************************************************************/
+static void setKey(uint32_t peer, uint32_t seed)
+{
+  uint8_t *key = (uint8_t *)peerKey[peer];
+  uint8_t *plain = (uint8_t *)plainPacket[peer];
+
+  for (uint32_t i = 0; i < sizeof(peerKey[peer]); i++) {
+    key[i] = (uint8_t)(seed * 29 + i * 7);
+  }
+  for (uint32_t i = 0; i < PACKET_SIZE; i++) {
+    plain[i] = (uint8_t)(seed + i);
+  }
+
+  if (isAes256(peer)) {
+    AES_CBC256((uint8_t *)cipherPacket[peer], plain, PACKET_SIZE,
+               key, IV, true);
+  } else {
+    AES_CBC128((uint8_t *)cipherPacket[peer], plain, PACKET_SIZE,
+               key, IV, true);
+  }
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Peer of the next packet, from a fixed pseudo random sequence
+ *****************************************************************************/
+static uint32_t nextPeer(uint32_t *state)
+{
+  *state = (*state * 1103515245UL) + 12345UL;
+  return (*state >> 16) % PEER_COUNT;
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Decrypt the packet stream, generating the decryption key for every
+ *    packet or taking it from the cache
+ *****************************************************************************/
+static void runPackets(bool cached)
+{
+  const uint8_t *key;
+  const uint8_t *dk;
+  uint32_t state = 1;
+  uint32_t start;
+  uint32_t peer;
+  bool aes256;
+
+  for (peer = 0; peer < PEER_COUNT; peer++) {
+    setKey(peer, peer);
+  }
+
+  for (uint32_t n = 0; n < PACKET_COUNT; n++) {
+    if (n == REKEY_PACKET) {
+      setKey(0, PEER_COUNT);
+    }
+
+    peer = nextPeer(&state);
+    key = (const uint8_t *)peerKey[peer];
+    aes256 = isAes256(peer);
+
+    BENCHMARK_START(start);
+    if (cached) {
+      dk = AESKEY_DecryptKey(peer, key, aes256);
+    } else {
+      dk = (const uint8_t *)decryptKey;
+      if (aes256) {
+        AES_DecryptKey256((uint8_t *)decryptKey, key);
+      } else {
+        AES_DecryptKey128((uint8_t *)decryptKey, key);
+      }
+    }
+    if (aes256) {
+      AES_CBC256((uint8_t *)decryptedPacket,
+                 (const uint8_t *)cipherPacket[peer], PACKET_SIZE,
+                 dk, IV, false);
+    } else {
+      AES_CBC128((uint8_t *)decryptedPacket,
+                 (const uint8_t *)cipherPacket[peer], PACKET_SIZE,
+                 dk, IV, false);
+    }
+    if (cached) {
+      BENCHMARK_STOP(aes256 ? "cbc256 cached key" : "cbc128 cached key",
+                     start, PACKET_SIZE);
+    } else {
+      BENCHMARK_STOP(aes256 ? "cbc256 key per packet" : "cbc128 key per packet",
+                     start, PACKET_SIZE);
+    }
+
+    if (memcmp(decryptedPacket, plainPacket[peer], PACKET_SIZE) != 0) {
+      isError = true;
+    }
+  }
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Average cycles of a benchmark section, 0 if it was not run
+ *****************************************************************************/
+static uint32_t averageCycles(const char *name)
+{
+  const BENCHMARK_Entry_t *entry;
+
+  for (unsigned int i = 0; i < BENCHMARK_Count(); i++) {
+    entry = BENCHMARK_Get(i);
+    if ((strcmp(entry->name, name) == 0) && (entry->runs > 0)) {
+      return (uint32_t)(entry->total / entry->runs);
+    }
+  }
+  return 0;
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Cycles saved per packet, and print them with the share of the packet
+ *    time
+ *****************************************************************************/
+static uint32_t printSaved(const char *label,
+                           const char *uncached,
+                           const char *cached)
+{
+  uint32_t before = averageCycles(uncached);
+  uint32_t after = averageCycles(cached);
+  uint32_t saved = (before > after) ? before - after : 0;
+
+  printf("%s: %lu -> %lu cycles per packet, %lu saved (%lu%%)\n",
+         label,
+         (unsigned long)before,
+         (unsigned long)after,
+         (unsigned long)saved,
+         (unsigned long)(before ? (saved * 100) / before : 0));
+
+  return saved;
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Main function
+ *****************************************************************************/
+int main(void)
+{
+  AESKEY_Stats_t stats;
+
+  // Chip errata
+  CHIP_Init();
+
+  // Cycle counter and serial port for the benchmark results
+  BENCHMARK_Init();
+  RETARGET_SerialInit();
+  RETARGET_SerialCrLf(1);
+
+  // Enable AES clock
+  CMU_ClockEnable(cmuClock_AES, true);
+
+  isError = false;
+  BENCHMARK_Reset();
+  AESKEY_Init();
+
+  // The same packet stream, without and then with the cache
+  runPackets(false);
+  runPackets(true);
+
+  // One miss per peer key, plus one for the new key of peer 0
+  AESKEY_GetStats(&stats);
+  if ((stats.misses != PEER_COUNT + 1)
+      || (stats.hits != PACKET_COUNT - stats.misses)) {
+    isError = true;
+  }
+
+  printf("\n%d packets of %d bytes from %d peers\n",
+         PACKET_COUNT, PACKET_SIZE, PEER_COUNT);
+  BENCHMARK_Print();
+  printf("\n");
+  cyclesSaved128 = printSaved("cbc128", "cbc128 key per packet",
+                              "cbc128 cached key");
+  cyclesSaved256 = printSaved("cbc256", "cbc256 key per packet",
+                              "cbc256 cached key");
+  printf("Cache hits %lu, misses %lu\n",
+         (unsigned long)stats.hits, (unsigned long)stats.misses);
+  printf("isError = %d\n", isError ? 1 : 0);
+
+  // Pause the debugger here to check if the isError variable is true/false
+  while (1) {
+    EMU_EnterEM1();
+  }
+}
@@ -0,0 +1,441 @@
+/***************************************************************************//**
+ * @file awg.c
+ *
+ * @brief Arbitrary waveform generator streaming DAC tables with the DMA.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2022 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ *******************************************************************************
+ * # Evaluation Quality
+ * This code has been minimally tested to ensure that it builds and is suitable 
+ * as a demonstration for evaluation purposes only. This code will be maintained
+ * at the sole discretion of Silicon Labs.
+ ******************************************************************************/
+
+#include "em_device.h"
+#include "em_cmu.h"
+#include "em_core.h"
+#include "em_dma.h"
+#include "em_prs.h"
+#include "em_timer.h"
+#include "dmactrl.h"
+
+#include "awg.h"
+
+#define MAX_CHANNELS        2
+
+// Half table completions per second a channel can be refreshed at
+#define MAX_HALF_RATE       20000
+
+/*
+ * Both DAC channels convert on the TIMER0 overflow, brought to them by
+ * PRS channel AWG_PRS_CHANNEL. Each conversion empties the channel data
+ * register, which requests the next sample from the DMA, so both outputs
+ * step together once per period and the DMA keeps one sample ahead.
+ */
+static const uint32_t dmaChannel[MAX_CHANNELS] = {
+  AWG_DMA_CHANNEL0, AWG_DMA_CHANNEL1
+};
+static const uint32_t dmaRequest[MAX_CHANNELS] = {
+  DMAREQ_DAC0_CH0, DMAREQ_DAC0_CH1
+};
+
+/*
+ * Each channel plays its table in ping-pong mode, the primary descriptor
+ * moving the first half and the alternate descriptor the second half. As
+ * one half completes the DMA goes on with the other, and the callback
+ * refreshes the completed descriptor for the next pass.
+ *
+ * Two programs are kept so the next one can be set up while the other
+ * plays. A queued program is switched to at a table boundary: the primary
+ * descriptor is refreshed with the first half of the new table while the
+ * second half of the old table plays, and the alternate with the second
+ * half of the new table once the first half plays. The top buffer of
+ * TIMER0 is written as the new table starts and is loaded at the next
+ * overflow, so the first sample or two of the new table still last an old
+ * period.
+ */
+static uint32_t programTop[2];
+static uint32_t programFrequency[2];
+static uint32_t programTable[2][MAX_CHANNELS];
+
+// Program of the first half in the primary descriptor of each channel
+static uint32_t primaryProgram[MAX_CHANNELS];
+
+// Program of the pass each channel plays
+static volatile uint32_t started[MAX_CHANNELS];
+
+// Passes started by each channel and the program the last pass takes
+static uint32_t passes[MAX_CHANNELS];
+static uint32_t decidedPass;
+static uint32_t passProgram;
+
+static uint16_t tables[AWG_TABLES][AWG_MAX_SAMPLES];
+static uint32_t tableLength[AWG_TABLES];
+
+static DMA_CB_TypeDef callback[MAX_CHANNELS];
+
+static uint32_t channels;
+static uint32_t timerFreq;
+static volatile uint32_t activeProgram;
+static volatile bool playing;
+static volatile bool queued;
+
+/**************************************************************************//**
+ * @brief
+ *   Data register of a DAC channel
+ *****************************************************************************/
+static void *dataRegister(uint32_t c)
+{
+  return (c == 0) ? (void *)&DAC0->CH0DATA : (void *)&DAC0->CH1DATA;
+}
+
+/**************************************************************************//**
+ * @brief
+ *   True if the active or the queued program plays a table
+ *****************************************************************************/
+static bool tableInUse(uint32_t table)
+{
+  for (uint32_t c = 0; c < channels; c++) {
+    if (programTable[activeProgram][c] == table) {
+      return true;
+    }
+    if (queued && (programTable[activeProgram ^ 1][c] == table)) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Refresh the half of the table that has just been played
+ *
+ * @param[in] channelNum
+ *   DMA channel whose half completed.
+ *
+ * @param[in] isPrimaryDescriptor
+ *   true if the first half completed, false if the second half did.
+ *
+ * @param[in] userPtr
+ *   Generator channel, 0 or 1.
+ *****************************************************************************/
+static void refreshTransfer(unsigned int channelNum,
+                            bool isPrimaryDescriptor,
+                            void *userPtr)
+{
+  uint32_t c = (uint32_t)userPtr;
+  uint32_t table, length, first, prog;
+
+  if (isPrimaryDescriptor) {
+    /*
+     * The second half plays, pick the program of the next pass. The first
+     * channel to get here on a pass decides for both, so they switch on
+     * the same pass even when AWG_Play() runs between their callbacks.
+     */
+    passes[c]++;
+    if (passes[c] != decidedPass) {
+      decidedPass = passes[c];
+      passProgram = queued ? (activeProgram ^ 1) : activeProgram;
+    }
+    prog = passProgram;
+    primaryProgram[c] = prog;
+
+    table = programTable[prog][c];
+    first = tableLength[table] / 2;
+    DMA_RefreshPingPong(channelNum, true, false, NULL,
+                        tables[table], first - 1, false);
+  } else {
+    // The first half of the next pass plays, finish its table
+    prog = primaryProgram[c];
+    if ((c == 0) && (prog != started[0])) {
+      TIMER_TopBufSet(TIMER0, programTop[prog] - 1);
+    }
+    started[c] = prog;
+
+    table = programTable[prog][c];
+    length = tableLength[table];
+    first = length / 2;
+    DMA_RefreshPingPong(channelNum, false, false, NULL,
+                        &tables[table][first], length - first - 1, false);
+
+    // The switch is done once every channel has started the new program
+    if (queued) {
+      for (c = 0; c < channels; c++) {
+        if (started[c] == activeProgram) {
+          return;
+        }
+      }
+      activeProgram ^= 1;
+      queued = false;
+    }
+  }
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Set up TIMER0, the PRS and the DMA for the generator
+ *
+ * @note
+ *   DAC0 must be set up by the caller, with the channels used enabled and
+ *   triggered by PRS channel AWG_PRS_CHANNEL, so each sample is converted
+ *   on the TIMER0 overflow.
+ *
+ * @param[in] count
+ *   Channels to drive, 1 for CH0 only or 2 for CH0 and CH1.
+ *
+ * @return
+ *   false if count is out of range.
+ *****************************************************************************/
+bool AWG_Init(uint32_t count)
+{
+  DMA_Init_TypeDef        dmaInit;
+  DMA_CfgChannel_TypeDef  chnlCfg;
+  DMA_CfgDescr_TypeDef    descrCfg;
+  TIMER_Init_TypeDef      timerInit = TIMER_INIT_DEFAULT;
+
+  if ((count < 1) || (count > MAX_CHANNELS)) {
+    return false;
+  }
+
+  channels = count;
+  activeProgram = 0;
+  playing = false;
+  queued = false;
+  for (uint32_t t = 0; t < AWG_TABLES; t++) {
+    tableLength[t] = 0;
+  }
+
+  CMU_ClockEnable(cmuClock_HFPER, true);
+  CMU_ClockEnable(cmuClock_TIMER0, true);
+  CMU_ClockEnable(cmuClock_PRS, true);
+  CMU_ClockEnable(cmuClock_DMA, true);
+
+  // Started by the first AWG_Play()
+  timerInit.enable = false;
+  TIMER_Init(TIMER0, &timerInit);
+
+  timerFreq = CMU_ClockFreqGet(cmuClock_TIMER0);
+
+  // Pass the overflow pulse of TIMER0 on as it is
+  PRS_SourceSignalSet(AWG_PRS_CHANNEL,
+                      PRS_CH_CTRL_SOURCESEL_TIMER0,
+                      PRS_CH_CTRL_SIGSEL_TIMER0OF,
+                      prsEdgeOff);
+
+  dmaInit.hprot = 0;
+  dmaInit.controlBlock = dmaControlBlock;
+  DMA_Init(&dmaInit);
+
+  // Half words from the table to the data register, which stays put
+  descrCfg.dstInc  = dmaDataIncNone;
+  descrCfg.srcInc  = dmaDataInc2;
+  descrCfg.size    = dmaDataSize2;
+  descrCfg.arbRate = dmaArbitrate1;
+  descrCfg.hprot   = 0;
+
+  for (uint32_t c = 0; c < channels; c++) {
+    callback[c].cbFunc  = (DMA_FuncPtr_TypeDef)refreshTransfer;
+    callback[c].userPtr = (void *)c;
+
+    chnlCfg.highPri   = true;
+    chnlCfg.enableInt = true;
+    chnlCfg.select    = dmaRequest[c];
+    chnlCfg.cb        = &callback[c];
+    DMA_CfgChannel(dmaChannel[c], &chnlCfg);
+
+    DMA_CfgDescr(dmaChannel[c], true, &descrCfg);
+    DMA_CfgDescr(dmaChannel[c], false, &descrCfg);
+  }
+
+  return true;
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Copy a waveform into a table
+ *
+ * @param[in] table
+ *   Table to write, below AWG_TABLES. It must not be playing or queued.
+ *
+ * @param[in] samples
+ *   12 bit DAC samples, one period of the waveform.
+ *
+ * @param[in] count
+ *   Number of samples, 2 to AWG_MAX_SAMPLES, one half for each descriptor.
+ *
+ * @return
+ *   false if the table is out of range or in use, or count is.
+ *****************************************************************************/
+bool AWG_Upload(uint32_t table, const uint16_t *samples, uint32_t count)
+{
+  if ((table >= AWG_TABLES) || (samples == NULL)
+      || (count < 2) || (count > AWG_MAX_SAMPLES)) {
+    return false;
+  }
+
+  CORE_DECLARE_IRQ_STATE;
+  CORE_ENTER_CRITICAL();
+  if (playing && tableInUse(table)) {
+    CORE_EXIT_CRITICAL();
+    return false;
+  }
+  // Keep an upload from being started on until it is complete
+  tableLength[table] = 0;
+  CORE_EXIT_CRITICAL();
+
+  for (uint32_t i = 0; i < count; i++) {
+    tables[table][i] = samples[i] & 0x0FFF;
+  }
+  tableLength[table] = count;
+
+  return true;
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Play tables at a waveform frequency
+ *
+ * @details
+ *   The sample rate is frequency times the table length, rounded to a
+ *   whole number of TIMER0 clocks per sample; AWG_GetFrequency() gives
+ *   the frequency it comes to. If nothing is playing the tables start
+ *   right away. Otherwise they are queued and take over at the next table
+ *   boundary, or the one after if the second half of the tables playing
+ *   now has already started, together with the new sample rate. Only one
+ *   program can be queued at a time.
+ *
+ * @param[in] table0
+ *   Table for DAC0 CH0.
+ *
+ * @param[in] table1
+ *   Table for DAC0 CH1, the same length as table0 so both stay in step.
+ *   Ignored when only one channel is driven.
+ *
+ * @param[in] frequency
+ *   Waveform frequency in Hz.
+ *
+ * @return
+ *   false if a program is already queued, a table is empty, the lengths
+ *   differ, the sample rate is above AWG_MAX_SAMPLE_RATE, or the halves of
+ *   the table go by too fast for the callback to refresh them.
+ *****************************************************************************/
+bool AWG_Play(uint32_t table0, uint32_t table1, uint32_t frequency)
+{
+  uint32_t length, first, rate, top, next, c, t;
+
+  if ((table0 >= AWG_TABLES) || (tableLength[table0] == 0)
+      || (frequency == 0) || (frequency > AWG_MAX_SAMPLE_RATE)) {
+    return false;
+  }
+  length = tableLength[table0];
+  if ((channels > 1)
+      && ((table1 >= AWG_TABLES) || (tableLength[table1] != length))) {
+    return false;
+  }
+
+  rate = frequency * length;
+  if ((rate > AWG_MAX_SAMPLE_RATE) || ((frequency * 2) > MAX_HALF_RATE)) {
+    return false;
+  }
+  top = (timerFreq + (rate / 2)) / rate;
+
+  CORE_DECLARE_IRQ_STATE;
+  CORE_ENTER_CRITICAL();
+
+  if (queued) {
+    CORE_EXIT_CRITICAL();
+    return false;
+  }
+
+  next = playing ? (activeProgram ^ 1) : activeProgram;
+  programTable[next][0] = table0;
+  programTable[next][1] = table1;
+  programTop[next] = top;
+  programFrequency[next] = timerFreq / (top * length);
+
+  if (!playing) {
+    first = length / 2;
+    for (c = 0; c < channels; c++) {
+      t = programTable[next][c];
+      primaryProgram[c] = next;
+      started[c] = next;
+      passes[c] = 0;
+      DMA_ActivatePingPong(dmaChannel[c], false,
+                           dataRegister(c), tables[t], first - 1,
+                           dataRegister(c), &tables[t][first],
+                           length - first - 1);
+    }
+    decidedPass = 0;
+    TIMER_TopSet(TIMER0, top - 1);
+    TIMER_CounterSet(TIMER0, 0);
+    playing = true;
+    TIMER_Enable(TIMER0, true);
+  } else {
+    // Taken by the callbacks at the next half table completion
+    queued = true;
+  }
+
+  CORE_EXIT_CRITICAL();
+  return true;
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Stop the generator, the outputs keep the last sample converted
+ *****************************************************************************/
+void AWG_Stop(void)
+{
+  CORE_DECLARE_IRQ_STATE;
+  CORE_ENTER_CRITICAL();
+
+  TIMER_Enable(TIMER0, false);
+  for (uint32_t c = 0; c < channels; c++) {
+    DMA_ChannelEnable(dmaChannel[c], false);
+  }
+  playing = false;
+  queued = false;
+
+  CORE_EXIT_CRITICAL();
+}
+
+/**************************************************************************//**
+ * @brief
+ *   True while a program waits for a table boundary to take over
+ *****************************************************************************/
+bool AWG_IsPending(void)
+{
+  return queued;
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Waveform frequency in Hz of the program playing, after rounding
+ *****************************************************************************/
+uint32_t AWG_GetFrequency(void)
+{
+  return playing ? programFrequency[activeProgram] : 0;
+}
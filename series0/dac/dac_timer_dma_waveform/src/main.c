@@ -0,0 +1,228 @@
+/***************************************************************************//**
+ * @file main.c
+ * @brief This project uses the DAC, TIMER0, the PRS and the DMA as an
+ * arbitrary waveform generator. Waveform tables are uploaded at run time and
+ * played on both DAC channels in step, switching table and frequency at a
+ * table boundary without a glitch. This project operates in EM1.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2022 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ *******************************************************************************
+ * # Evaluation Quality
+ * This code has been minimally tested to ensure that it builds and is suitable 
+ * as a demonstration for evaluation purposes only. This code will be maintained
+ * at the sole discretion of Silicon Labs.
+ ******************************************************************************/
+
+#include <math.h>
+
+#include "em_device.h"
+#include "em_chip.h"
+#include "em_cmu.h"
+#include "em_emu.h"
+#include "em_dac.h"
+
+#include "awg.h"
+
+// Samples per waveform period
+#define WAVE_SAMPLES    64
+
+// Full scale of the 12 bit DAC
+#define DAC_MAX         4095
+
+// Tables uploaded to the generator
+#define TABLE_SINE      0
+#define TABLE_COSINE    1
+#define TABLE_TRIANGLE  2
+#define TABLE_SAWTOOTH  3
+
+// Set the DAC to max frequency of 1 MHz
+#define CLK_DAC_FREQ    1000000
+
+// Time each step of the demo plays for
+#define STEP_MS         2000
+
+// Tables and waveform frequency of each step, CH0 and CH1 play in step
+typedef struct {
+  uint32_t table0;
+  uint32_t table1;
+  uint32_t frequency;
+} Step_t;
+
+static const Step_t steps[] = {
+  { TABLE_SINE,     TABLE_COSINE,   1000 },
+  { TABLE_SINE,     TABLE_COSINE,   5000 },
+  { TABLE_TRIANGLE, TABLE_SAWTOOTH, 2000 },
+  { TABLE_SAWTOOTH, TABLE_SINE,     500 },
+};
+
+#define STEPS           (sizeof(steps) / sizeof(steps[0]))
+
+// Waveform being built before it is uploaded
+static uint16_t wave[WAVE_SAMPLES];
+
+static volatile uint32_t msTicks;
+
+/**************************************************************************//**
+ * @brief SysTick_Handler
+ * Interrupt Service Routine for system tick counter
+ *****************************************************************************/
+void SysTick_Handler(void)
+{
+  msTicks++;       // increment counter necessary in Delay()
+}
+
+/**************************************************************************//**
+ * @brief Delays number of msTick Systicks (typically 1 ms)
+ * @param dlyTicks Number of ticks to delay
+ *****************************************************************************/
+void Delay(uint32_t dlyTicks)
+{
+  uint32_t curTicks;
+
+  curTicks = msTicks;
+  while ((msTicks - curTicks) < dlyTicks) {
+    EMU_EnterEM1();
+  }
+}
+
+/**************************************************************************//**
+ * @brief
+ *    DAC initialization
+ *****************************************************************************/
+void initDac(void)
+{
+  // Use default settings
+  DAC_Init_TypeDef        init        = DAC_INIT_DEFAULT;
+  DAC_InitChannel_TypeDef initChannel = DAC_INITCHANNEL_DEFAULT;
+
+  // Enable the DAC clock
+  CMU_ClockEnable(cmuClock_DAC0, true);
+
+  // Calculate the DAC clock prescale value resulting in a 1 MHz DAC clock
+  init.prescale = DAC_PrescaleCalc(CLK_DAC_FREQ, 0);
+
+  // Set reference to internal 1.25V reference
+  init.reference = dacRef1V25;
+
+  // Convert each value on the TIMER0 overflow, on PRS channel AWG_PRS_CHANNEL
+  initChannel.prsEnable = true;
+  initChannel.prsSel = dacPRSSELCh0;
+
+  // Initialize the DAC and both DAC channels
+  DAC_Init(DAC0, &init);
+  DAC_InitChannel(DAC0, &initChannel, 0);
+  DAC_InitChannel(DAC0, &initChannel, 1);
+
+  // Enable the DAC channels. See readme.txt for the output pins.
+  DAC_Enable(DAC0, 0, true);
+  DAC_Enable(DAC0, 1, true);
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Build the fixed waveforms and upload them to the generator
+ *****************************************************************************/
+void uploadWaves(void)
+{
+  const float pi = 3.14159265f;
+  uint32_t i;
+
+  for (i = 0; i < WAVE_SAMPLES; i++) {
+    wave[i] = (uint16_t)((DAC_MAX / 2)
+                         + ((DAC_MAX / 2) * sinf((2 * pi * i) / WAVE_SAMPLES)));
+  }
+  AWG_Upload(TABLE_SINE, wave, WAVE_SAMPLES);
+
+  for (i = 0; i < WAVE_SAMPLES; i++) {
+    wave[i] = (uint16_t)((DAC_MAX / 2)
+                         + ((DAC_MAX / 2) * cosf((2 * pi * i) / WAVE_SAMPLES)));
+  }
+  AWG_Upload(TABLE_COSINE, wave, WAVE_SAMPLES);
+
+  for (i = 0; i < WAVE_SAMPLES; i++) {
+    wave[i] = (uint16_t)((DAC_MAX * i) / (WAVE_SAMPLES - 1));
+  }
+  AWG_Upload(TABLE_SAWTOOTH, wave, WAVE_SAMPLES);
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Build a triangle of the given peak and upload it
+ *
+ * @return
+ *    false if the triangle is playing or queued and was left as it is.
+ *****************************************************************************/
+bool uploadTriangle(uint32_t peak)
+{
+  uint32_t half = WAVE_SAMPLES / 2;
+
+  for (uint32_t i = 0; i < half; i++) {
+    wave[i] = (uint16_t)((peak * i) / half);
+    wave[WAVE_SAMPLES - 1 - i] = (uint16_t)((peak * (i + 1)) / half);
+  }
+
+  return AWG_Upload(TABLE_TRIANGLE, wave, WAVE_SAMPLES);
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Play the steps in turn on both DAC channels
+ *****************************************************************************/
+int main(void)
+{
+  uint32_t step = 0;
+  uint32_t peak = DAC_MAX;
+
+  // Chip errata
+  CHIP_Init();
+
+  // Setup SysTick Timer for 1 msec interrupts
+  if (SysTick_Config(CMU_ClockFreqGet(cmuClock_CORE) / 1000)) while (1) ;
+
+  // Initialize the DAC and the generator for both channels
+  initDac();
+  AWG_Init(2);
+
+  uploadWaves();
+  uploadTriangle(peak);
+
+  while (1) {
+    // Queued while the previous step plays, taken at a table boundary
+    while (!AWG_Play(steps[step].table0,
+                     steps[step].table1,
+                     steps[step].frequency)) {
+      EMU_EnterEM1();
+    }
+    Delay(STEP_MS);
+
+    // Lower the triangle a little each time round, while it does not play
+    step = (step + 1) % STEPS;
+    if (step == 0) {
+      peak = (peak > (DAC_MAX / 4)) ? (peak - (DAC_MAX / 8)) : DAC_MAX;
+      uploadTriangle(peak);
+    }
+  }
+}
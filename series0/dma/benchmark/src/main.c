@@ -0,0 +1,771 @@
+/***************************************************************************//**
+ * @file main.c
+ * @brief Measures DMA throughput for memory to memory, looped, scatter-gather,
+ * 2D and peripheral to memory transfers and for several active channels. See
+ * readme.txt for details.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2020 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ *******************************************************************************
+ * # Evaluation Quality
+ * This code has been minimally tested to ensure that it builds and is suitable 
+ * as a demonstration for evaluation purposes only. This code will be maintained
+ * at the sole discretion of Silicon Labs.
+ ******************************************************************************/
+
+
+#include <string.h>
+#include "em_device.h"
+#include "em_chip.h"
+#include "em_adc.h"
+#include "em_cmu.h"
+#include "em_dma.h"
+#include "em_usart.h"
+
+#include "dmactrl.h"
+
+/*******************************************************************************
+ *******************************   DEFINES   ***********************************
+ ******************************************************************************/
+
+// Transfers timed per result, the fastest is kept
+#define RUNS                      4
+
+// Buffer size, words
+#define BUFFER_WORDS              1024
+
+// A DMA cycle moves at most 1024 units
+#define MAX_UNITS                 1024
+
+// Memory to memory block sizes, bytes
+#define NUM_M2M_SIZES             4
+#define NUM_M2M_UNITS             3
+
+// Bytes moved by the looped, scatter-gather and 2D transfers
+#define CHAIN_BYTES               1024
+#define NUM_LOOPED                4
+#define NUM_LINKED                6
+#define MAX_LINKED                64
+
+// 2D copy of a 16 x 16 word window out of a 32 x 32 word image
+#define IMAGE_WIDTH               32
+#define IMAGE_HEIGHT              32
+#define WINDOW_WIDTH              16
+#define WINDOW_HEIGHT             16
+#define WINDOW_ROW                8
+#define WINDOW_COL                8
+
+// Peripheral to memory transfers
+#define P2M_SPI                   0
+#define P2M_UART                  1
+#define P2M_ADC                   2
+#define NUM_P2M                   3
+#define P2M_BYTES                 1024
+#define ADC_SAMPLES               1024
+
+// SPI bit rate, emlib sets the closest, at most half the HFPERCLK
+#define SPI_BITRATE               20000000
+#define UART_BAUDRATE             1000000
+
+// Init to max ADC clock for Series 0, and conversion time at 12 bits
+#define ADC_FREQ                  13000000
+#define ADC_CYCLES_PER_SAMPLE     (1 + 13)
+
+// Arbitration between memory to memory channels
+#define ARB_CHANNELS              4
+#define ARB_WORDS                 (BUFFER_WORDS / ARB_CHANNELS)
+#define NUM_ARB_CONFIGS           4
+
+// DMA channels, the 2D copy must use channel 0
+#define M2M_CHANNEL               0
+#define RX_CHANNEL                0
+#define TX_CHANNEL                1
+
+/*******************************************************************************
+ ***************************   GLOBAL VARIABLES   *******************************
+ ******************************************************************************/
+
+// One memory to memory transfer
+typedef struct {
+  uint32_t unitBytes;         // Bytes per unit, 1, 2 or 4
+  uint32_t bytes;             // Bytes moved
+  uint32_t cycles;            // From the request to the channel done
+  uint32_t kBps;              // Throughput, kB/s
+  bool ok;                    // The copy matches the source
+} M2mResult_t;
+
+// A transfer of CHAIN_BYTES as loops, scatter-gather tasks or 2D rows
+typedef struct {
+  uint32_t count;             // Loops, tasks or rows
+  uint32_t bytes;             // Bytes moved
+  uint32_t cycles;            // From the request to the channel done
+  uint32_t kBps;              // Throughput, kB/s
+  int32_t overheadCycles;     // Cost of each loop, task or row after the
+                              // first, against one cycle or one task
+  bool ok;                    // The copy matches the source
+} ChainResult_t;
+
+// A transfer from a peripheral
+typedef struct {
+  uint32_t units;             // Bytes or samples moved
+  uint32_t cycles;            // From the start to the channel done
+  uint32_t ratePerSec;        // Units per second
+  uint32_t nominalPerSec;     // Units per second the peripheral is set for
+  uint32_t efficiency;        // ratePerSec in % of nominalPerSec
+  bool ok;                    // Data right and no overflow
+} P2mResult_t;
+
+// ARB_CHANNELS copies of ARB_WORDS started together
+typedef struct {
+  uint32_t arbUnits;          // Units moved per arbitration
+  bool ch0HighPri;            // Channel 0 has high priority
+  uint32_t doneCycles[ARB_CHANNELS];
+  uint32_t totalCycles;       // Until the last channel is done
+  uint32_t kBps;              // Throughput of all channels, kB/s
+} ArbResult_t;
+
+typedef struct {
+  DMA_ArbiterConfig_TypeDef arbRate;
+  uint32_t arbUnits;
+  bool ch0HighPri;
+} ArbConfig_t;
+
+static const uint32_t m2mSizes[NUM_M2M_SIZES] = { 16, 64, 256, 1024 };
+
+static const DMA_DataSize_TypeDef m2mUnits[NUM_M2M_UNITS] = {
+  dmaDataSize1, dmaDataSize2, dmaDataSize4
+};
+
+static const uint32_t loopCounts[NUM_LOOPED] = { 4, 16, 64, 256 };
+
+static const uint32_t linkCounts[NUM_LINKED] = { 2, 4, 8, 16, 32, 64 };
+
+static const ArbConfig_t arbConfigs[NUM_ARB_CONFIGS] = {
+  // Round robin, one unit per turn
+  { dmaArbitrate1, 1, false },
+  // Round robin, 8 units per turn
+  { dmaArbitrate8, 8, false },
+  // Round robin, each channel moves all its units before the next one
+  { dmaArbitrate1024, 1024, false },
+  // Channel 0 first, one unit per turn
+  { dmaArbitrate1, 1, true },
+};
+
+static volatile M2mResult_t m2m[NUM_M2M_UNITS * NUM_M2M_SIZES];
+static volatile ChainResult_t looped[NUM_LOOPED];
+static volatile ChainResult_t linked[NUM_LINKED];
+static volatile ChainResult_t copy2d;
+static volatile P2mResult_t p2m[NUM_P2M];
+static volatile ArbResult_t arbitration[NUM_ARB_CONFIGS];
+
+// Passes completed over all measurements
+static volatile uint32_t passes;
+
+static uint32_t coreHz;
+
+// Cycles of one auto cycle moving CHAIN_BYTES in words
+static uint32_t chainBaseCycles;
+
+static uint32_t srcBuffer[BUFFER_WORDS];
+static uint32_t dstBuffer[BUFFER_WORDS];
+
+// Alternate descriptors of the scatter-gather tasks
+static DMA_DESCRIPTOR_TypeDef altDescrs[MAX_LINKED];
+
+/**************************************************************************//**
+ * @brief
+ *    Throughput of a transfer, kB/s at the core clock
+ *****************************************************************************/
+static uint32_t kBps(uint32_t bytes, uint32_t cycles)
+{
+  return (uint32_t)(((uint64_t)bytes * coreHz) / ((uint64_t)cycles * 1000));
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Configure a channel without its done interrupt
+ *
+ * @param[in] select
+ *    Peripheral request, 0 for software requests only
+ *****************************************************************************/
+static void cfgChannel(unsigned int channel, uint32_t select, bool highPri)
+{
+  DMA_CfgChannel_TypeDef chnlCfg;
+
+  chnlCfg.highPri   = highPri;
+  chnlCfg.enableInt = false;
+  chnlCfg.select    = select;
+  chnlCfg.cb        = NULL;
+  DMA_CfgChannel(channel, &chnlCfg);
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Configure the primary descriptor of a channel
+ *****************************************************************************/
+static void cfgDescr(unsigned int channel,
+                     DMA_DataSize_TypeDef size,
+                     DMA_DataInc_TypeDef srcInc,
+                     DMA_DataInc_TypeDef dstInc,
+                     DMA_ArbiterConfig_TypeDef arbRate)
+{
+  DMA_CfgDescr_TypeDef descrCfg;
+
+  descrCfg.dstInc  = dstInc;
+  descrCfg.srcInc  = srcInc;
+  descrCfg.size    = size;
+  descrCfg.arbRate = arbRate;
+  descrCfg.hprot   = 0;
+  DMA_CfgDescr(channel, true, &descrCfg);
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Activate an auto cycle on the primary descriptor, as DMA_ActivateAuto()
+ *    does, but without its software request
+ *
+ * @details
+ *    So that the time does not include setting up the channel, and several
+ *    channels can be started by the same request. DMA_ActivateBasic() sets
+ *    up the descriptor and enables the channel, then the cycle is changed
+ *    from basic to auto, which moves all units on one request.
+ *****************************************************************************/
+static void activateAuto(unsigned int channel, void *dst, void *src,
+                         unsigned int nMinus1)
+{
+  DMA_DESCRIPTOR_TypeDef *descr =
+    ((DMA_DESCRIPTOR_TypeDef *)(DMA->CTRLBASE)) + channel;
+
+  DMA_ActivateBasic(channel, true, false, dst, src, nMinus1);
+  descr->CTRL = (descr->CTRL & ~_DMA_CTRL_CYCLE_CTRL_MASK)
+                | DMA_CTRL_CYCLE_CTRL_AUTO;
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Wait for channels to be done
+ *
+ * @details
+ *    The done flags in DMA->IF are polled, so each time is late by up to
+ *    one turn of the loop, a few tens of cycles.
+ *
+ * @param[in] mask
+ *    Channels to wait for
+ *
+ * @param[in] start
+ *    DWT cycle count the channels were started at
+ *
+ * @param[out] doneCycles
+ *    Cycles to each channel done, indexed by channel, may be NULL
+ *
+ * @return
+ *    Cycles to the last channel done
+ *****************************************************************************/
+static uint32_t waitDone(uint32_t mask, uint32_t start, uint32_t *doneCycles)
+{
+  uint32_t pending = mask;
+  uint32_t cycles = 0;
+  uint32_t done, ch;
+
+  while (pending) {
+    done = DMA->IF & pending;
+    if (done) {
+      cycles = DWT->CYCCNT - start;
+      for (ch = 0; doneCycles && (ch < ARB_CHANNELS); ch++) {
+        if (done & (1 << ch)) {
+          doneCycles[ch] = cycles;
+        }
+      }
+      pending &= ~done;
+    }
+  }
+
+  return cycles;
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Start activated memory to memory channels with one software request
+ *****************************************************************************/
+static uint32_t runChannels(uint32_t mask, uint32_t *doneCycles)
+{
+  uint32_t start;
+
+  DMA->IFC = mask;
+  start = DWT->CYCCNT;
+  DMA->CHSWREQ = mask;
+
+  return waitDone(mask, start, doneCycles);
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Time an auto cycle copy on M2M_CHANNEL, the fastest of RUNS
+ *****************************************************************************/
+static uint32_t timeAuto(void *dst, void *src, unsigned int nMinus1)
+{
+  uint32_t cycles, i;
+  uint32_t min = 0xFFFFFFFF;
+
+  for (i = 0; i < RUNS; i++) {
+    activateAuto(M2M_CHANNEL, dst, src, nMinus1);
+    cycles = runChannels(1 << M2M_CHANNEL, NULL);
+    if (cycles < min) {
+      min = cycles;
+    }
+  }
+
+  return min;
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Single auto cycle copies of bytes, half words and words
+ *****************************************************************************/
+static void measureM2m(void)
+{
+  volatile M2mResult_t *r;
+  uint32_t u, s;
+
+  cfgChannel(M2M_CHANNEL, 0, false);
+
+  for (u = 0; u < NUM_M2M_UNITS; u++) {
+    cfgDescr(M2M_CHANNEL, m2mUnits[u], (DMA_DataInc_TypeDef)m2mUnits[u],
+             (DMA_DataInc_TypeDef)m2mUnits[u], dmaArbitrate1024);
+
+    for (s = 0; s < NUM_M2M_SIZES; s++) {
+      r = &m2m[(u * NUM_M2M_SIZES) + s];
+
+      memset(dstBuffer, 0, m2mSizes[s]);
+      r->unitBytes = 1 << m2mUnits[u];
+      r->bytes = m2mSizes[s];
+      r->cycles = timeAuto(dstBuffer, srcBuffer,
+                           (m2mSizes[s] >> m2mUnits[u]) - 1);
+      r->kBps = kBps(m2mSizes[s], r->cycles);
+      r->ok = (memcmp(dstBuffer, srcBuffer, m2mSizes[s]) == 0);
+
+      if ((m2mUnits[u] == dmaDataSize4) && (m2mSizes[s] == CHAIN_BYTES)) {
+        chainBaseCycles = r->cycles;
+      }
+    }
+  }
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Fill in a looped, scatter-gather or 2D result
+ *
+ * @param[in] base
+ *    Cycles of the same transfer in one cycle or one task
+ *****************************************************************************/
+static void setChainResult(volatile ChainResult_t *r, uint32_t count,
+                           uint32_t cycles, uint32_t base, bool ok)
+{
+  r->count = count;
+  r->bytes = CHAIN_BYTES;
+  r->cycles = cycles;
+  r->kBps = kBps(CHAIN_BYTES, cycles);
+  r->overheadCycles = ((int32_t)cycles - (int32_t)base)
+                      / (int32_t)(count - 1);
+  r->ok = ok;
+}
+
+/**************************************************************************//**
+ * @brief
+ *    One auto cycle run again for each loop
+ *
+ * @details
+ *    The DMA has no loop counter: the hardware loop of channels 0 and 1
+ *    reloads the count until software stops it, as em_dma does from the
+ *    done interrupt. Here the CPU activates and requests the cycle again
+ *    each time it is done, so the time includes this cost. Each loop moves
+ *    the same CHAIN_BYTES / loops bytes again, so the channel moves
+ *    CHAIN_BYTES in all.
+ *****************************************************************************/
+static void measureLooped(void)
+{
+  uint32_t mask = 1 << M2M_CHANNEL;
+  uint32_t i, l, nMinus1, start, cycles;
+
+  cfgChannel(M2M_CHANNEL, 0, false);
+  cfgDescr(M2M_CHANNEL, dmaDataSize4, dmaDataInc4, dmaDataInc4,
+           dmaArbitrate1024);
+
+  for (i = 0; i < NUM_LOOPED; i++) {
+    nMinus1 = (CHAIN_BYTES / loopCounts[i] / 4) - 1;
+
+    memset(dstBuffer, 0, CHAIN_BYTES);
+    activateAuto(M2M_CHANNEL, dstBuffer, srcBuffer, nMinus1);
+
+    DMA->IFC = mask;
+    start = DWT->CYCCNT;
+    DMA->CHSWREQ = mask;
+    for (l = 1; l < loopCounts[i]; l++) {
+      while (!(DMA->IF & mask)) {
+      }
+      DMA->IFC = mask;
+      activateAuto(M2M_CHANNEL, dstBuffer, srcBuffer, nMinus1);
+      DMA->CHSWREQ = mask;
+    }
+    cycles = waitDone(mask, start, NULL);
+
+    setChainResult(&looped[i], loopCounts[i], cycles, chainBaseCycles,
+                   memcmp(dstBuffer, srcBuffer, (nMinus1 + 1) * 4) == 0);
+  }
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Time a memory scatter-gather list of count tasks, the fastest of RUNS
+ *
+ * @details
+ *    DMA_ActivateScatterGather() makes the software request itself, so the
+ *    time includes the call.
+ *****************************************************************************/
+static uint32_t timeScatterGather(uint32_t count)
+{
+  DMA_CfgDescrSGAlt_TypeDef altDesc;
+  uint32_t chunk = CHAIN_BYTES / count;
+  uint32_t cycles, start, i, d;
+  uint32_t min = 0xFFFFFFFF;
+
+  altDesc.dstInc     = dmaDataInc4;
+  altDesc.srcInc     = dmaDataInc4;
+  altDesc.size       = dmaDataSize4;
+  altDesc.arbRate    = dmaArbitrate1024;
+  altDesc.hprot      = 0;
+  altDesc.nMinus1    = (chunk / 4) - 1;
+  altDesc.peripheral = false;
+
+  for (d = 0; d < count; d++) {
+    altDesc.src = (uint8_t *)srcBuffer + (d * chunk);
+    altDesc.dst = (uint8_t *)dstBuffer + (d * chunk);
+    DMA_CfgDescrScatterGather(altDescrs, d, &altDesc);
+  }
+
+  for (i = 0; i < RUNS; i++) {
+    DMA->IFC = 1 << M2M_CHANNEL;
+    start = DWT->CYCCNT;
+    DMA_ActivateScatterGather(M2M_CHANNEL, false, altDescrs, count);
+    cycles = waitDone(1 << M2M_CHANNEL, start, NULL);
+    if (cycles < min) {
+      min = cycles;
+    }
+  }
+
+  return min;
+}
+
+/**************************************************************************//**
+ * @brief
+ *    CHAIN_BYTES split over scatter-gather tasks, as in scatter_gather
+ *
+ * @details
+ *    The primary descriptor copies each alternate descriptor in turn before
+ *    the alternate moves its task. The overhead is against one task, which
+ *    includes the call that starts the list.
+ *****************************************************************************/
+static void measureLinked(void)
+{
+  uint32_t i, base, cycles;
+
+  cfgChannel(M2M_CHANNEL, 0, false);
+  base = timeScatterGather(1);
+
+  for (i = 0; i < NUM_LINKED; i++) {
+    memset(dstBuffer, 0, CHAIN_BYTES);
+    cycles = timeScatterGather(linkCounts[i]);
+    setChainResult(&linked[i], linkCounts[i], cycles, base,
+                   memcmp(dstBuffer, srcBuffer, CHAIN_BYTES) == 0);
+  }
+}
+
+/**************************************************************************//**
+ * @brief
+ *    2D copy of a window out of an image, as in 2d_copy
+ *
+ * @details
+ *    The loop register of channel 0 holds the row width and the rectangle
+ *    register the height and the strides, so a single basic cycle moves all
+ *    rows on one request.
+ *****************************************************************************/
+static void measure2d(void)
+{
+  DMA_CfgLoop_TypeDef loopCfg;
+  DMA_CfgRect_TypeDef rectCfg;
+  uint32_t offset = (WINDOW_ROW * IMAGE_WIDTH) + WINDOW_COL;
+  uint32_t cycles, i, row;
+  uint32_t min = 0xFFFFFFFF;
+  bool ok = true;
+
+  cfgChannel(M2M_CHANNEL, 0, false);
+  cfgDescr(M2M_CHANNEL, dmaDataSize4, dmaDataInc4, dmaDataInc4,
+           dmaArbitrate1024);
+
+  loopCfg.enable  = true;
+  loopCfg.nMinus1 = WINDOW_WIDTH - 1;
+  DMA_CfgLoop(M2M_CHANNEL, &loopCfg);
+
+  rectCfg.height    = WINDOW_HEIGHT - 1;
+  rectCfg.dstStride = IMAGE_WIDTH * 4;
+  rectCfg.srcStride = IMAGE_WIDTH * 4;
+  DMA_CfgRect(M2M_CHANNEL, &rectCfg);
+
+  memset(dstBuffer, 0, sizeof(dstBuffer));
+  for (i = 0; i < RUNS; i++) {
+    DMA_ActivateBasic(M2M_CHANNEL, true, false, &dstBuffer[offset],
+                      &srcBuffer[offset], WINDOW_WIDTH - 1);
+    cycles = runChannels(1 << M2M_CHANNEL, NULL);
+    if (cycles < min) {
+      min = cycles;
+    }
+  }
+
+  DMA_ResetLoop(M2M_CHANNEL);
+  DMA_ResetRect(M2M_CHANNEL);
+
+  for (row = 0; row < WINDOW_HEIGHT; row++) {
+    if (memcmp(&dstBuffer[offset + (row * IMAGE_WIDTH)],
+               &srcBuffer[offset + (row * IMAGE_WIDTH)],
+               WINDOW_WIDTH * 4) != 0) {
+      ok = false;
+    }
+  }
+
+  setChainResult(&copy2d, WINDOW_HEIGHT, min, chainBaseCycles, ok);
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Fill in a peripheral to memory result
+ *****************************************************************************/
+static void setP2mResult(volatile P2mResult_t *r, uint32_t units,
+                         uint32_t cycles, uint32_t nominal, bool ok)
+{
+  r->units = units;
+  r->cycles = cycles;
+  r->ratePerSec = (uint32_t)(((uint64_t)units * coreHz) / cycles);
+  r->nominalPerSec = nominal;
+  r->efficiency = (uint32_t)(((uint64_t)r->ratePerSec * 100) / nominal);
+  r->ok = ok;
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Receive P2M_BYTES in internal loopback; USART1 must be initialized
+ *
+ * @details
+ *    One channel feeds TXDATA on TXBL and the other empties RXDATA on
+ *    RXDATAV, so the time is that of the receive channel.
+ *
+ * @param[in] bitsPerByte
+ *    Bit times each byte takes on the line
+ *****************************************************************************/
+static void measureUsart(volatile P2mResult_t *r, uint32_t bitsPerByte)
+{
+  uint8_t *rx = (uint8_t *)dstBuffer;
+  uint8_t *tx = (uint8_t *)srcBuffer;
+  uint32_t start, cycles;
+  bool ok;
+
+  // Internal loopback, no pins are used
+  USART1->CTRL |= USART_CTRL_LOOPBK;
+  USART1->CMD = USART_CMD_CLEARRX | USART_CMD_CLEARTX;
+  USART_IntClear(USART1, _USART_IF_MASK);
+
+  cfgChannel(RX_CHANNEL, DMAREQ_USART1_RXDATAV, false);
+  cfgDescr(RX_CHANNEL, dmaDataSize1, dmaDataIncNone, dmaDataInc1,
+           dmaArbitrate1);
+  cfgChannel(TX_CHANNEL, DMAREQ_USART1_TXBL, false);
+  cfgDescr(TX_CHANNEL, dmaDataSize1, dmaDataInc1, dmaDataIncNone,
+           dmaArbitrate1);
+
+  memset(rx, 0, P2M_BYTES);
+  DMA->IFC = 1 << RX_CHANNEL;
+  DMA_ActivateBasic(RX_CHANNEL, true, false, rx, (void *)&USART1->RXDATA,
+                    P2M_BYTES - 1);
+
+  start = DWT->CYCCNT;
+  DMA_ActivateBasic(TX_CHANNEL, true, false, (void *)&USART1->TXDATA, tx,
+                    P2M_BYTES - 1);
+  cycles = waitDone(1 << RX_CHANNEL, start, NULL);
+
+  ok = (memcmp(rx, tx, P2M_BYTES) == 0)
+       && !(USART_IntGet(USART1) & USART_IF_RXOF);
+
+  setP2mResult(r, P2M_BYTES, cycles,
+               USART_BaudrateGet(USART1) / bitsPerByte, ok);
+
+  USART_Reset(USART1);
+}
+
+/**************************************************************************//**
+ * @brief
+ *    USART1 as an SPI master and as a UART, in internal loopback
+ *****************************************************************************/
+static void measureSerial(void)
+{
+  USART_InitSync_TypeDef spiInit = USART_INITSYNC_DEFAULT;
+  USART_InitAsync_TypeDef uartInit = USART_INITASYNC_DEFAULT;
+
+  CMU_ClockEnable(cmuClock_HFPER, true);
+  CMU_ClockEnable(cmuClock_USART1, true);
+
+  spiInit.baudrate = SPI_BITRATE;
+  USART_InitSync(USART1, &spiInit);
+  measureUsart(&p2m[P2M_SPI], 8);
+
+  // Start bit, 8 data bits and a stop bit
+  uartInit.baudrate = UART_BAUDRATE;
+  USART_InitAsync(USART1, &uartInit);
+  measureUsart(&p2m[P2M_UART], 10);
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Repeated ADC conversions of VSS, read from SINGLEDATA
+ *****************************************************************************/
+static void measureAdc(void)
+{
+  ADC_Init_TypeDef init = ADC_INIT_DEFAULT;
+  ADC_InitSingle_TypeDef initSingle = ADC_INITSINGLE_DEFAULT;
+  uint32_t start, cycles, adcHz;
+  bool ok;
+
+  CMU_ClockEnable(cmuClock_HFPER, true);
+  CMU_ClockEnable(cmuClock_ADC0, true);
+
+  init.timebase = ADC_TimebaseCalc(0);
+  init.prescale = ADC_PrescaleCalc(ADC_FREQ, 0);
+  adcHz = CMU_ClockFreqGet(cmuClock_HFPER) / (init.prescale + 1);
+
+  // Convert back to back, request the DMA for each result
+  initSingle.input = adcSingleInpVSS;
+  initSingle.reference = adcRef2V5;
+  initSingle.resolution = adcRes12Bit;
+  initSingle.acqTime = adcAcqTime1;
+  initSingle.rep = true;
+
+  ADC_Init(ADC0, &init);
+  ADC_InitSingle(ADC0, &initSingle);
+  ADC_IntClear(ADC0, _ADC_IF_MASK);
+
+  cfgChannel(RX_CHANNEL, DMAREQ_ADC0_SINGLE, false);
+  cfgDescr(RX_CHANNEL, dmaDataSize4, dmaDataIncNone, dmaDataInc4,
+           dmaArbitrate1);
+
+  DMA->IFC = 1 << RX_CHANNEL;
+  DMA_ActivateBasic(RX_CHANNEL, true, false, dstBuffer,
+                    (void *)&ADC0->SINGLEDATA, ADC_SAMPLES - 1);
+
+  start = DWT->CYCCNT;
+  ADC_Start(ADC0, adcStartSingle);
+  cycles = waitDone(1 << RX_CHANNEL, start, NULL);
+  ADC0->CMD = ADC_CMD_SINGLESTOP;
+
+  ok = !(ADC_IntGet(ADC0) & ADC_IF_SINGLEOF);
+
+  setP2mResult(&p2m[P2M_ADC], ADC_SAMPLES, cycles,
+               adcHz / ADC_CYCLES_PER_SAMPLE, ok);
+
+  ADC_Reset(ADC0);
+}
+
+/**************************************************************************//**
+ * @brief
+ *    ARB_CHANNELS auto cycle copies started by the same request, for each
+ *    arbitration setting
+ *****************************************************************************/
+static void measureArbitration(void)
+{
+  const ArbConfig_t *config;
+  volatile ArbResult_t *r;
+  uint32_t doneCycles[ARB_CHANNELS];
+  uint32_t i, ch;
+
+  for (i = 0; i < NUM_ARB_CONFIGS; i++) {
+    config = &arbConfigs[i];
+    r = &arbitration[i];
+
+    for (ch = 0; ch < ARB_CHANNELS; ch++) {
+      cfgChannel(ch, 0, (ch == 0) && config->ch0HighPri);
+      cfgDescr(ch, dmaDataSize4, dmaDataInc4, dmaDataInc4, config->arbRate);
+      activateAuto(ch, &dstBuffer[ch * ARB_WORDS], &srcBuffer[ch * ARB_WORDS],
+                   ARB_WORDS - 1);
+    }
+
+    r->arbUnits = config->arbUnits;
+    r->ch0HighPri = config->ch0HighPri;
+    r->totalCycles = runChannels((1 << ARB_CHANNELS) - 1, doneCycles);
+    r->kBps = kBps(ARB_CHANNELS * ARB_WORDS * 4, r->totalCycles);
+    for (ch = 0; ch < ARB_CHANNELS; ch++) {
+      r->doneCycles[ch] = doneCycles[ch];
+    }
+  }
+
+  cfgChannel(0, 0, false);
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Main function
+ *****************************************************************************/
+int main(void)
+{
+  DMA_Init_TypeDef dmaInit;
+  uint32_t i;
+
+  CHIP_Init();
+
+  // Run from the 48 MHz crystal
+  CMU_ClockSelectSet(cmuClock_HF, cmuSelect_HFXO);
+  coreHz = SystemCoreClockGet();
+
+  // Start the cycle counter
+  CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+  DWT->CYCCNT = 0;
+  DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+  CMU_ClockEnable(cmuClock_DMA, true);
+  dmaInit.hprot        = 0;
+  dmaInit.controlBlock = dmaControlBlock;
+  DMA_Init(&dmaInit);
+
+  for (i = 0; i < sizeof(srcBuffer); i++) {
+    ((uint8_t *)srcBuffer)[i] = (uint8_t)((i * 7) + 3);
+  }
+
+  // Measure everything, over and over
+  while (1) {
+    measureM2m();
+    measureLooped();
+    measureLinked();
+    measure2d();
+    measureSerial();
+    measureAdc();
+    measureArbitration();
+    passes++;
+  }
+}
@@ -0,0 +1,236 @@
+/***************************************************************************//**
+ * @file main.c
+ * @brief ADC streaming into a ring of four buffers with the dmastream driver
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2021 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ *******************************************************************************
+ * # Evaluation Quality
+ * This code has been minimally tested to ensure that it builds and is suitable 
+ * as a demonstration for evaluation purposes only. This code will be maintained
+ * at the sole discretion of Silicon Labs.
+ ******************************************************************************/
+
+
+#include "em_chip.h"
+#include "em_device.h"
+#include "em_cmu.h"
+#include "em_emu.h"
+#include "em_adc.h"
+#include "em_prs.h"
+#include "em_dma.h"
+#include "em_letimer.h"
+
+#include "dmactrl.h"
+#include "dmastream.h"
+
+// DMA and PRS channels used
+#define DMA_CHANNEL         0
+#define PRS_CHANNEL         0
+
+// Conversions per second, LFRCO / LETIMER top
+#define SAMPLE_RATE         1024
+
+// Ring of four buffers of 64 results, 62.5 ms each
+#define NUM_BUFFERS         4
+#define BUFFER_SIZE         64
+
+// Init to max ADC clock for Series 0
+#define ADC_FREQ            13000000
+
+// ADC reference and the divider of the VDD/3 input, in mV
+#define ADC_REF_MV          2500
+#define VDD_DIVIDER         3
+
+// Buffers of the ring
+uint32_t adcBuffer[NUM_BUFFERS][BUFFER_SIZE];
+
+static DMASTREAM_Stream_t stream;
+
+// Buffers handled by the main loop, and buffers the DMA dropped
+volatile uint32_t buffersDone;
+volatile uint32_t overruns;
+
+// Mean, smallest and largest VDD of the last buffer, in mV
+volatile uint32_t vddMean;
+volatile uint32_t vddMin;
+volatile uint32_t vddMax;
+
+/**************************************************************************//**
+ * @brief LETIMER initialization, one PRS pulse per conversion
+ *****************************************************************************/
+void initLetimer(void)
+{
+  LETIMER_Init_TypeDef letimerInit = LETIMER_INIT_DEFAULT;
+
+  // Start LFRCO and wait until it is stable
+  CMU_OscillatorEnable(cmuOsc_LFRCO, true, true);
+
+  // Enable clock to the interface of the low energy modules
+  CMU_ClockEnable(cmuClock_HFLE, true);
+
+  // Route the LFRCO clock to LFA (LETIMER0)
+  CMU_ClockSelectSet(cmuClock_LFA, cmuSelect_LFRCO);
+  CMU_ClockEnable(cmuClock_LETIMER0, true);
+
+  // Reload COMP0 on underflow, pulse output, and run in repeat mode
+  letimerInit.comp0Top  = true;
+  letimerInit.ufoa0     = letimerUFOAPulse;
+  letimerInit.repMode   = letimerRepeatFree;
+  letimerInit.enable    = false;
+  LETIMER_Init(LETIMER0, &letimerInit);
+
+  // Need REP0 != 0 to pulse on underflow
+  LETIMER_RepeatSet(LETIMER0, 0, 1);
+  LETIMER_CompareSet(LETIMER0, 0,
+                     CMU_ClockFreqGet(cmuClock_LETIMER0) / SAMPLE_RATE);
+
+  // Use LETIMER0 as async PRS to trigger the ADC
+  CMU_ClockEnable(cmuClock_PRS, true);
+  PRS_SourceAsyncSignalSet(PRS_CHANNEL, PRS_CH_CTRL_SOURCESEL_LETIMER0,
+      PRS_CH_CTRL_SIGSEL_LETIMER0CH0);
+}
+
+/**************************************************************************//**
+ * @brief ADC initialization, single conversions of VDD/3 on each PRS pulse
+ *****************************************************************************/
+void initAdc(void)
+{
+  ADC_Init_TypeDef init = ADC_INIT_DEFAULT;
+  ADC_InitSingle_TypeDef initSingle = ADC_INITSINGLE_DEFAULT;
+
+  CMU_ClockEnable(cmuClock_HFPER, true);
+  CMU_ClockEnable(cmuClock_ADC0, true);
+
+  init.timebase = ADC_TimebaseCalc(0);
+  init.prescale = ADC_PrescaleCalc(ADC_FREQ, 0);
+
+  initSingle.input      = adcSingleInpVDDDiv3;
+  initSingle.reference  = adcRef2V5;
+  initSingle.resolution = adcRes12Bit;
+
+  // Enable PRS trigger and select the channel
+  initSingle.prsEnable = true;
+  initSingle.prsSel    = (ADC_PRSSEL_TypeDef) PRS_CHANNEL;
+
+  ADC_Init(ADC0, &init);
+  ADC_InitSingle(ADC0, &initSingle);
+}
+
+/**************************************************************************//**
+ * @brief DMA initialization, the ring of ADC0 result buffers
+ *****************************************************************************/
+bool initDma(void)
+{
+  DMA_Init_TypeDef dmaInit;
+  void * const buffers[NUM_BUFFERS] = {
+    adcBuffer[0], adcBuffer[1], adcBuffer[2], adcBuffer[3]
+  };
+  const DMASTREAM_Init_t streamInit = {
+    .channel   = DMA_CHANNEL,
+    .select    = DMAREQ_ADC0_SINGLE,
+    .direction = dmaStreamPeriToMem,
+    .periAddr  = &ADC0->SINGLEDATA,
+    .size      = dmaDataSize4,
+    .buffers   = buffers,
+    .count     = NUM_BUFFERS,
+    .length    = BUFFER_SIZE,
+    .callback  = NULL,
+  };
+
+  CMU_ClockEnable(cmuClock_DMA, true);
+
+  dmaInit.hprot        = 0;
+  dmaInit.controlBlock = dmaControlBlock;
+  DMA_Init(&dmaInit);
+
+  return DMASTREAM_Init(&stream, &streamInit);
+}
+
+/**************************************************************************//**
+ * @brief Sleep in EM1 until the DMA completes a buffer
+ *****************************************************************************/
+uint32_t *waitForBuffer(void)
+{
+  uint32_t *buffer;
+
+  // A pending interrupt still wakes the core with interrupts masked
+  __disable_irq();
+  while ((buffer = DMASTREAM_Acquire(&stream)) == NULL) {
+    EMU_EnterEM1();
+    __enable_irq();
+    __disable_irq();
+  }
+  __enable_irq();
+
+  return buffer;
+}
+
+/**************************************************************************//**
+ * @brief  Main function
+ *****************************************************************************/
+int main(void)
+{
+  uint32_t *buffer;
+  uint32_t sum, min, max, i;
+
+  CHIP_Init();
+
+  initAdc();
+  initLetimer();
+  if (!initDma()) {
+    while (1) {
+    }
+  }
+
+  DMASTREAM_Start(&stream);
+  LETIMER_Enable(LETIMER0, true);
+
+  while (1) {
+    buffer = waitForBuffer();
+
+    sum = 0;
+    min = UINT32_MAX;
+    max = 0;
+    for (i = 0; i < BUFFER_SIZE; i++) {
+      sum += buffer[i];
+      if (buffer[i] < min) {
+        min = buffer[i];
+      }
+      if (buffer[i] > max) {
+        max = buffer[i];
+      }
+    }
+
+    // The DMA fills the other three buffers meanwhile
+    DMASTREAM_Release(&stream, buffer);
+
+    vddMean = (sum / BUFFER_SIZE) * ADC_REF_MV * VDD_DIVIDER / 4096;
+    vddMin  = min * ADC_REF_MV * VDD_DIVIDER / 4096;
+    vddMax  = max * ADC_REF_MV * VDD_DIVIDER / 4096;
+    overruns = DMASTREAM_Overruns(&stream);
+    buffersDone++;
+  }
+}
@@ -0,0 +1,513 @@
+/***************************************************************************//**
+ * @file i2cqueue.c
+ *
+ * @brief Queue of interrupt-driven I2C master transactions on I2C0.
+ *
+ * A transaction goes through these states, one I2C interrupt each except
+ * where the DMA takes over:
+ *
+ *   START + address/W, ACK -> data bytes, ACK each (or DMA, then TXC)
+ *   repeated START + address/R, ACK -> data bytes (or DMA for all but
+ *   the last), NACK + STOP on the last byte, MSTOP -> callback
+ *
+ * The DMA read runs with AUTOACK set so the slave is acknowledged without
+ * the core. The DMA done callback clears AUTOACK again before the last
+ * byte, which the interrupt handler NACKs.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2022 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ *******************************************************************************
+ * # Evaluation Quality
+ * This code has been minimally tested to ensure that it builds and is suitable 
+ * as a demonstration for evaluation purposes only. This code will be maintained
+ * at the sole discretion of Silicon Labs.
+ ******************************************************************************/
+
+#include <stddef.h>
+
+#include "em_device.h"
+#include "em_cmu.h"
+#include "em_core.h"
+#include "em_dma.h"
+#include "em_gpio.h"
+#include "em_i2c.h"
+#include "dmactrl.h"
+
+#include "i2cqueue.h"
+
+// I2C pins, PD6 (SDA) and PD7 (SCL) at location 1
+#define I2CQ_SDA_PORT   gpioPortD
+#define I2CQ_SDA_PIN    6
+#define I2CQ_SCL_PORT   gpioPortD
+#define I2CQ_SCL_PIN    7
+#define I2CQ_LOCATION   I2C_ROUTE_LOCATION_LOC1
+
+// Interrupts that end a transaction in any state
+#define I2CQ_IF_ERRORS  (I2C_IF_ARBLOST | I2C_IF_BUSERR)
+
+// Transaction states
+typedef enum {
+  stateAddrWrite,       // Address with write bit sent, waiting for ACK
+  stateWrite,           // Data byte sent, waiting for ACK
+  stateWriteDma,        // DMA filling TXDATA, waiting for TXC
+  stateAddrRead,        // Address with read bit sent, waiting for ACK
+  stateRead,            // Waiting for the next data byte
+  stateReadDma,         // DMA reading all but the last byte
+  stateReadLast,        // Waiting for the last data byte
+  stateStop             // STOP sent, waiting for MSTOP
+} State_t;
+
+// Ends the read payload, the write payload needs no callback
+static DMA_CB_TypeDef readCallback;
+
+// Transactions waiting for the bus
+static I2CQ_Transfer_t *pendingHead;
+static I2CQ_Transfer_t *pendingTail;
+
+// Running transaction
+static I2CQ_Transfer_t *current;
+static State_t state;
+static I2CQ_Status_t result;
+static uint32_t txCount;
+static uint32_t rxCount;
+static uint32_t slaveCtrl;
+static volatile bool busy;
+
+static void readByte(void);
+
+/**************************************************************************//**
+ * @brief
+ *    Set the I2C interrupts the next state waits for, errors are always on
+ *****************************************************************************/
+static void waitFor(uint32_t flags)
+{
+  I2C0->IEN = I2CQ_IF_ERRORS | flags;
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Send a STOP condition, the transaction ends with status once it is out
+ *****************************************************************************/
+static void sendStop(I2CQ_Status_t status)
+{
+  result = status;
+  state = stateStop;
+  I2C0->CMD = I2C_CMD_STOP;
+  waitFor(I2C_IF_MSTOP);
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Send a START (or repeated START) and the slave address
+ *****************************************************************************/
+static void sendAddress(bool read)
+{
+  I2C0->CMD = I2C_CMD_START;
+
+  // The address is not transmitted until the START has been sent
+  I2C0->TXDATA = (current->address & 0xFE) | (read ? 1 : 0);
+
+  state = read ? stateAddrRead : stateAddrWrite;
+  waitFor(I2C_IF_ACK | I2C_IF_NACK);
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Write phase done, read back or stop
+ *****************************************************************************/
+static void endWrite(void)
+{
+  if (current->rxLength > 0) {
+    sendAddress(true);
+  } else {
+    sendStop(i2cqStatusDone);
+  }
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Send the next byte of the write phase, the whole remaining payload if
+ *    it is long enough for the DMA
+ *****************************************************************************/
+static void writeNext(void)
+{
+  uint32_t left = current->txLength - txCount;
+
+  if (left == 0) {
+    endWrite();
+  } else if (left > I2CQ_DMA_THRESHOLD) {
+    // TXC may still be set from the address byte
+    I2C_IntClear(I2C0, I2C_IFC_TXC);
+    state = stateWriteDma;
+    waitFor(I2C_IF_TXC | I2C_IF_NACK);
+    DMA_ActivateBasic(I2CQ_DMA_CHANNEL_TX, true, false,
+                      (void *)&I2C0->TXDATA,
+                      (void *)&current->tx[txCount],
+                      left - 1);
+    txCount += left;
+  } else {
+    I2C0->TXDATA = current->tx[txCount++];
+    state = stateWrite;
+    waitFor(I2C_IF_ACK | I2C_IF_NACK);
+  }
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Address acknowledged for reading, start receiving
+ *****************************************************************************/
+static void startRead(void)
+{
+  uint32_t count = current->rxLength - 1;
+
+  if (current->rxLength > I2CQ_DMA_THRESHOLD) {
+    rxCount = count;
+
+    // Acknowledge bytes as they arrive, the DMA only needs to read them
+    I2C0->CTRL |= I2C_CTRL_AUTOACK;
+    state = stateReadDma;
+    waitFor(0);
+    DMA_ActivateBasic(I2CQ_DMA_CHANNEL_RX, true, false,
+                      current->rx,
+                      (void *)&I2C0->RXDATA,
+                      count - 1);
+  } else {
+    state = (current->rxLength == 1) ? stateReadLast : stateRead;
+    waitFor(I2C_IF_RXDATAV);
+  }
+}
+
+/**************************************************************************//**
+ * @brief
+ *    All but the last byte of a read are in. Called from the DMA interrupt.
+ *
+ * @details
+ *    The PL230 cannot write I2C0->CTRL after the payload the way a linked
+ *    LDMA descriptor can, so AUTOACK is turned off here. The last byte is
+ *    on the bus by now and has to be NACKed, so this has to run within the
+ *    time of a byte, 22 us at 400 kHz, of the DMA reading the byte before.
+ *****************************************************************************/
+static void readDone(unsigned int channel, bool primary, void *user)
+{
+  (void)channel;
+  (void)primary;
+  (void)user;
+
+  if (state != stateReadDma) {
+    return;
+  }
+
+  I2C0->CTRL &= ~I2C_CTRL_AUTOACK;
+  state = stateReadLast;
+  if (I2C0->STATUS & I2C_STATUS_RXDATAV) {
+    readByte();
+  } else {
+    waitFor(I2C_IF_RXDATAV);
+  }
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Take a received byte, ACK it to get the next one or NACK and stop
+ *    after the last
+ *****************************************************************************/
+static void readByte(void)
+{
+  current->rx[rxCount++] = I2C0->RXDATA;
+
+  if (rxCount < current->rxLength) {
+    if (rxCount == (uint32_t)current->rxLength - 1) {
+      state = stateReadLast;
+    }
+    I2C0->CMD = I2C_CMD_ACK;
+  } else {
+    I2C0->CMD = I2C_CMD_NACK;
+    sendStop(i2cqStatusDone);
+  }
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Start the next queued transaction, if any
+ *****************************************************************************/
+static void startNext(void)
+{
+  current = pendingHead;
+  if (current == NULL) {
+    busy = false;
+    return;
+  }
+
+  pendingHead = current->next;
+  if (pendingHead == NULL) {
+    pendingTail = NULL;
+  }
+
+  busy = true;
+  txCount = 0;
+  rxCount = 0;
+
+  // Abort whatever an earlier error left behind and flush the buffers
+  if (I2C0->STATE & I2C_STATE_BUSY) {
+    I2C0->CMD = I2C_CMD_ABORT;
+  }
+  I2C0->CMD = I2C_CMD_CLEARPC | I2C_CMD_CLEARTX;
+
+  // A slave setup may use AUTOACK and AUTOSN, finish() gives them back
+  slaveCtrl = I2C0->CTRL & (I2C_CTRL_AUTOACK | I2C_CTRL_AUTOSN);
+  I2C0->CTRL &= ~(I2C_CTRL_AUTOACK | I2C_CTRL_AUTOSN);
+  I2C_IntClear(I2C0, _I2C_IFC_MASK);
+
+  sendAddress(current->txLength == 0);
+}
+
+/**************************************************************************//**
+ * @brief
+ *    End the running transaction and move on to the next one
+ *****************************************************************************/
+static void finish(I2CQ_Status_t status)
+{
+  I2CQ_Transfer_t *transfer = current;
+
+  waitFor(0);
+  DMA_ChannelEnable(I2CQ_DMA_CHANNEL_TX, false);
+  DMA_ChannelEnable(I2CQ_DMA_CHANNEL_RX, false);
+  I2C0->CTRL = (I2C0->CTRL & ~(I2C_CTRL_AUTOACK | I2C_CTRL_AUTOSN))
+               | slaveCtrl;
+
+  // Unlink before the callback, which may submit the transaction again
+  current = NULL;
+  transfer->status = status;
+  if (transfer->callback) {
+    transfer->callback(transfer);
+  }
+
+  startNext();
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Initialize I2C0 as master, its pins, the DMA and the queue
+ *
+ * @details
+ *    The DMA is initialized with the control block of dmactrl.c. An
+ *    application using other DMA channels initializes the DMA once, before
+ *    or here, with the same control block.
+ *
+ * @param[in] frequency
+ *    Bus clock in Hz, up to I2C_FREQ_FAST_MAX.
+ *****************************************************************************/
+void I2CQ_Init(uint32_t frequency)
+{
+  I2C_Init_TypeDef       i2cInit = I2C_INIT_DEFAULT;
+  DMA_Init_TypeDef       dmaInit;
+  DMA_CfgChannel_TypeDef chnlCfg;
+  DMA_CfgDescr_TypeDef   descrCfg;
+
+  CMU_ClockEnable(cmuClock_HFPER, true);
+  CMU_ClockEnable(cmuClock_GPIO, true);
+  CMU_ClockEnable(cmuClock_I2C0, true);
+  CMU_ClockEnable(cmuClock_DMA, true);
+
+  GPIO_PinModeSet(I2CQ_SDA_PORT, I2CQ_SDA_PIN, gpioModeWiredAndPullUpFilter, 1);
+  GPIO_PinModeSet(I2CQ_SCL_PORT, I2CQ_SCL_PIN, gpioModeWiredAndPullUpFilter, 1);
+
+  // Enable pins at the location as specified in datasheet
+  I2C0->ROUTE = I2C_ROUTE_SDAPEN | I2C_ROUTE_SCLPEN | I2CQ_LOCATION;
+
+  // Above 100 kHz the clock needs the asymmetric low/high ratio
+  i2cInit.freq = frequency;
+  if (frequency > I2C_FREQ_STANDARD_MAX) {
+    i2cInit.clhr = i2cClockHLRAsymetric;
+  }
+  I2C_Init(I2C0, &i2cInit);
+
+  // ACK, NACK and STOP are all sent by the state machine
+  I2C0->CTRL &= ~(I2C_CTRL_AUTOACK | I2C_CTRL_AUTOSN);
+
+  dmaInit.hprot = 0;
+  dmaInit.controlBlock = dmaControlBlock;
+  DMA_Init(&dmaInit);
+
+  // Transfer a byte whenever the transmit buffer has room, no interrupt
+  chnlCfg.highPri   = false;
+  chnlCfg.enableInt = false;
+  chnlCfg.select    = DMAREQ_I2C0_TXBL;
+  chnlCfg.cb        = NULL;
+  DMA_CfgChannel(I2CQ_DMA_CHANNEL_TX, &chnlCfg);
+
+  descrCfg.dstInc  = dmaDataIncNone;
+  descrCfg.srcInc  = dmaDataInc1;
+  descrCfg.size    = dmaDataSize1;
+  descrCfg.arbRate = dmaArbitrate1;
+  descrCfg.hprot   = 0;
+  DMA_CfgDescr(I2CQ_DMA_CHANNEL_TX, true, &descrCfg);
+
+  // Transfer a byte whenever one has been received, then call readDone()
+  readCallback.cbFunc  = (DMA_FuncPtr_TypeDef)readDone;
+  readCallback.userPtr = NULL;
+
+  chnlCfg.enableInt = true;
+  chnlCfg.select    = DMAREQ_I2C0_RXDATAV;
+  chnlCfg.cb        = &readCallback;
+  DMA_CfgChannel(I2CQ_DMA_CHANNEL_RX, &chnlCfg);
+
+  descrCfg.dstInc  = dmaDataInc1;
+  descrCfg.srcInc  = dmaDataIncNone;
+  DMA_CfgDescr(I2CQ_DMA_CHANNEL_RX, true, &descrCfg);
+
+  pendingHead = NULL;
+  pendingTail = NULL;
+  current = NULL;
+  slaveCtrl = 0;
+  busy = false;
+
+  I2C0->IEN = 0;
+  NVIC_ClearPendingIRQ(I2C0_IRQn);
+  NVIC_EnableIRQ(I2C0_IRQn);
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Queue a transaction. It starts right away if the bus is idle.
+ *
+ * @param[in] transfer
+ *    Transaction, must stay valid until its callback has been called.
+ *
+ * @return
+ *    False if the transaction is empty or a phase is longer than
+ *    I2CQ_MAX_LENGTH.
+ *****************************************************************************/
+bool I2CQ_Submit(I2CQ_Transfer_t *transfer)
+{
+  CORE_DECLARE_IRQ_STATE;
+
+  if (((transfer->txLength == 0) && (transfer->rxLength == 0))
+      || (transfer->txLength > I2CQ_MAX_LENGTH)
+      || (transfer->rxLength > I2CQ_MAX_LENGTH)) {
+    return false;
+  }
+
+  transfer->status = i2cqStatusPending;
+  transfer->next = NULL;
+
+  CORE_ENTER_CRITICAL();
+  if (pendingTail) {
+    pendingTail->next = transfer;
+  } else {
+    pendingHead = transfer;
+  }
+  pendingTail = transfer;
+
+  if (!busy) {
+    startNext();
+  }
+  CORE_EXIT_CRITICAL();
+
+  return true;
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Check whether all queued transactions have completed
+ *****************************************************************************/
+bool I2CQ_IsIdle(void)
+{
+  return !busy;
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Run the state machine, called from I2C0_IRQHandler()
+ *
+ * @details
+ *    The application owns I2C0_IRQHandler() so that I2C0 can also be a
+ *    slave between transactions. The handler calls this while the queue
+ *    is not idle and handles the slave events otherwise.
+ *****************************************************************************/
+void I2CQ_IRQHandler(void)
+{
+  uint32_t flags = I2C_IntGetEnabled(I2C0);
+
+  I2C_IntClear(I2C0, flags);
+
+  if (current == NULL) {
+    return;
+  }
+
+  // The bus is lost, there is no STOP to wait for
+  if (flags & I2CQ_IF_ERRORS) {
+    I2C0->CMD = I2C_CMD_ABORT;
+    finish((flags & I2C_IF_ARBLOST) ? i2cqStatusArbLost : i2cqStatusBusError);
+    return;
+  }
+
+  switch (state) {
+    case stateAddrWrite:
+    case stateWrite:
+    case stateAddrRead:
+      if (flags & I2C_IF_NACK) {
+        I2C0->CMD = I2C_CMD_CLEARTX;
+        sendStop(i2cqStatusNack);
+      } else if (flags & I2C_IF_ACK) {
+        if (state == stateAddrRead) {
+          startRead();
+        } else {
+          writeNext();
+        }
+      }
+      break;
+
+    case stateWriteDma:
+      if (flags & I2C_IF_NACK) {
+        DMA_ChannelEnable(I2CQ_DMA_CHANNEL_TX, false);
+        I2C0->CMD = I2C_CMD_CLEARTX;
+        sendStop(i2cqStatusNack);
+      } else if ((flags & I2C_IF_TXC)
+                 && !DMA_ChannelEnabled(I2CQ_DMA_CHANNEL_TX)
+                 && (I2C0->STATUS & I2C_STATUS_TXBL)) {
+        // TXC is also set if the DMA falls behind the bus for a moment,
+        // only the one after the last byte ends the write
+        endWrite();
+      }
+      break;
+
+    case stateRead:
+    case stateReadLast:
+      if (I2C0->STATUS & I2C_STATUS_RXDATAV) {
+        readByte();
+      }
+      break;
+
+    case stateStop:
+      if (flags & I2C_IF_MSTOP) {
+        finish(result);
+      }
+      break;
+
+    default:
+      break;
+  }
+}
@@ -44,6 +44,7 @@
 #include "em_emu.h"
 #include "em_gpio.h"
 #include "bsp.h"
+#include "i2cqueue.h"
 
 // Defines
 #define CORE_FREQUENCY              14000000
@@ -61,6 +62,9 @@ uint8_t i2c_rxBufferIndex;
 volatile bool i2c_rxInProgress;
 volatile bool i2c_startTx;
 
+// Queued master transaction
+I2CQ_Transfer_t i2c_transfer;
+
 /**************************************************************************//**
  * @brief  Starting oscillators and enabling clocks
  *****************************************************************************/
@@ -105,11 +109,10 @@ void enableI2cSlaveInterrupts(void)
 }
 
 /**************************************************************************//**
- * @brief  disables I2C interrupts
+ * @brief  disables I2C slave interrupts, the queue sets its own
  *****************************************************************************/
 void disableI2cInterrupts(void)
 {
-  NVIC_DisableIRQ(I2C0_IRQn);
   I2C_IntDisable(I2C0, I2C_IEN_ADDR | I2C_IEN_RXDATAV | I2C_IEN_SSTOP);
   I2C_IntClear(I2C0, I2C_IFC_ADDR | I2C_IF_RXDATAV | I2C_IFC_SSTOP);
 }
@@ -119,21 +122,8 @@ void disableI2cInterrupts(void)
  *****************************************************************************/
 void initI2C(void)
 {
-  // Using default settings
-  I2C_Init_TypeDef i2cInit = I2C_INIT_DEFAULT;
-  // Use ~400khz SCK
-  i2cInit.freq = I2C_FREQ_FAST_MAX;
-
-  // Using PD6 (SDA) and PD7 (SCL)
-  GPIO_PinModeSet(gpioPortD, 6, gpioModeWiredAndPullUpFilter, 1);
-  GPIO_PinModeSet(gpioPortD, 7, gpioModeWiredAndPullUpFilter, 1);
-
-  // Enable pins at location 1 as specified in datasheet
-  I2C0->ROUTE = I2C_ROUTE_SDAPEN | I2C_ROUTE_SCLPEN;
-  I2C0->ROUTE = (I2C0->ROUTE & (~_I2C_ROUTE_LOCATION_MASK)) | I2C_ROUTE_LOCATION_LOC1;
-
-  // Initializing the I2C
-  I2C_Init(I2C0, &i2cInit);
+  // Using PD6 (SDA) and PD7 (SCL) at location 1 with ~400khz SCK
+  I2CQ_Init(I2C_FREQ_FAST_MAX);
 
   // Setting the status flags and index
   i2c_rxInProgress = false;
@@ -147,35 +137,38 @@ void initI2C(void)
 }
 
 /**************************************************************************//**
- * @brief  Transmitting I2C data. Will busy-wait until the transfer is complete.
+ * @brief  Called from the I2C interrupt once the transfer has completed
  *****************************************************************************/
-void performI2CTransfer(void)
+void i2cTransferDone(I2CQ_Transfer_t *transfer)
 {
-  // Transfer structure
-  I2C_TransferSeq_TypeDef i2cTransfer;
-  I2C_TransferReturn_TypeDef result;
+  (void)transfer;
 
+  // Clearing pin to indicate end of transfer
+  GPIO_PinOutClear(BSP_GPIO_LED1_PORT, BSP_GPIO_LED1_PIN);
+  enableI2cSlaveInterrupts();
+}
+
+/**************************************************************************//**
+ * @brief  Transmitting I2C data. Returns at once, the transfer is queued and
+ *         completes in the I2C and DMA interrupts.
+ *****************************************************************************/
+void performI2CTransfer(void)
+{
   // Setting LED to indicate transfer
   GPIO_PinOutSet(BSP_GPIO_LED1_PORT, BSP_GPIO_LED1_PIN);
 
-  // Initializing I2C transfer
-  i2cTransfer.addr          = I2C_ADDRESS;
-  i2cTransfer.flags         = I2C_FLAG_WRITE;
-  i2cTransfer.buf[0].data   = i2c_txBuffer;
-  i2cTransfer.buf[0].len    = i2c_txBufferSize;
-  i2cTransfer.buf[1].data   = i2c_rxBuffer;
-  i2cTransfer.buf[1].len    = I2C_RXBUFFER_SIZE;
-  result = I2C_TransferInit(I2C0, &i2cTransfer);
-
-  // Sending data
-  while (result == i2cTransferInProgress)
-  {
-    result = I2C_Transfer(I2C0);
+  // Longer than I2CQ_DMA_THRESHOLD, so the DMA moves the data bytes
+  i2c_transfer.address  = I2C_ADDRESS;
+  i2c_transfer.tx       = i2c_txBuffer;
+  i2c_transfer.txLength = i2c_txBufferSize;
+  i2c_transfer.rx       = NULL;
+  i2c_transfer.rxLength = 0;
+  i2c_transfer.callback = i2cTransferDone;
+  i2c_transfer.user     = NULL;
+
+  if (!I2CQ_Submit(&i2c_transfer)) {
+    i2cTransferDone(&i2c_transfer);
   }
-
-  // Clearing pin to indicate end of transfer
-  GPIO_PinOutClear(BSP_GPIO_LED1_PORT, BSP_GPIO_LED1_PIN);
-  enableI2cSlaveInterrupts();
 }
 
 /**************************************************************************//**
@@ -198,6 +191,13 @@ void I2C0_IRQHandler(void)
 {
   int status;
 
+  // Master transfers are run by the queue
+  if (!I2CQ_IsIdle())
+  {
+    I2CQ_IRQHandler();
+    return;
+  }
+
   status = I2C0->IF;
 
   if (status & I2C_IF_ADDR)
@@ -287,13 +287,20 @@ int main(void)
        receiveI2CData();
     }else if (i2c_startTx)
     {
-       // Transmitting data
+       // Queueing data for transmission
        performI2CTransfer();
-       // Transmission complete
        i2c_startTx = false;
     }
 
-    // Forever enter EM2. The RTC or I2C will wake up the EFM32
-    EMU_EnterEM2(false);
+    if (!I2CQ_IsIdle())
+    {
+      // The master transfer and the DMA need the HF clocks
+      EMU_EnterEM1();
+    }
+    else
+    {
+      // Forever enter EM2. The RTC or I2C will wake up the EFM32
+      EMU_EnterEM2(false);
+    }
   }
 }
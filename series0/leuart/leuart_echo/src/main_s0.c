@@ -40,12 +40,22 @@
 #include "em_gpio.h"
 #include "em_leuart.h"
 #include "em_chip.h"
+#include "em_dma.h"
+#include "dmactrl.h"
 
 #define RX_BUFFER_SIZE 80             // Software receive buffer size
 
+// Set to 0 to receive every byte with an interrupt instead of framed messages
+#define FRAMED_RX      1
+
+#define NODE_ADDRESS   '@'            // Start frame, first byte of our messages
+#define END_OF_MESSAGE '\n'           // Signal frame, last byte of a message
+#define RX_DMA_CHANNEL 0              // DMA channel moving received bytes
+
 static uint32_t rxDataReady = 0;      // Flag indicating receiver does not have data
 static volatile char rxBuffer[RX_BUFFER_SIZE]; // Software receive buffer
 static char txBuffer[RX_BUFFER_SIZE]; // Software transmit buffer
+static uint32_t rxMessages = 0;       // Messages received, one wake each
 
 /**************************************************************************//**
  * @brief
@@ -82,11 +92,99 @@ void initLeuart(void)
   // Enable LEUART0 RX/TX pins on PD[5:4] (see readme.txt for details)
   LEUART0->ROUTE = LEUART_ROUTE_LOCATION_LOC0 | LEUART_ROUTE_RXPEN | LEUART_ROUTE_TXPEN;
 
+#if FRAMED_RX
+  // Drop everything until our start frame, which unblocks the receiver
+  LEUART0->STARTFRAME = NODE_ADDRESS;
+  LEUART0->SIGFRAME   = END_OF_MESSAGE;
+  LEUART0->CTRL      |= LEUART_CTRL_SFUBRX;
+  LEUART0->CMD        = LEUART_CMD_RXBLOCKEN;
+
+  // Auto wake up DMA when data is received
+  LEUART_RxDmaInEM2Enable(LEUART0, true);
+
+  // Enable LEUART0 end of message/TX interrupts
+  LEUART_IntEnable(LEUART0, LEUART_IEN_SIGF | LEUART_IEN_TXC);
+#else
   // Enable LEUART0 RX/TX interrupts
   LEUART_IntEnable(LEUART0, LEUART_IEN_RXDATAV | LEUART_IEN_TXC);
+#endif
   NVIC_EnableIRQ(LEUART0_IRQn);
 }
 
+#if FRAMED_RX
+/**************************************************************************//**
+ * @brief
+ *    Start the DMA moving the next message into rxBuffer
+ *
+ * @details
+ *    There is no transfer done interrupt; the end of message interrupt of
+ *    the LEUART is the only wake for a message. A message longer than the
+ *    buffer is cut at RX_BUFFER_SIZE - 1 bytes.
+ *****************************************************************************/
+void startRxDma(void)
+{
+  bool isUseBurst = false;
+  DMA_ActivateBasic(RX_DMA_CHANNEL,
+                    true,                      // Primary descriptor
+                    isUseBurst,
+                    (void *) rxBuffer,         // Destination address to transfer to
+                    (void *) &LEUART0->RXDATA, // Source address to transfer from
+                    RX_BUFFER_SIZE - 2);       // Number of DMA transfers minus 1
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Get the number of bytes the DMA has still to move into rxBuffer
+ *****************************************************************************/
+uint32_t rxDmaRemaining(void)
+{
+  DMA_DESCRIPTOR_TypeDef *descr = ((DMA_DESCRIPTOR_TypeDef *) DMA->CTRLBASE)
+                                  + RX_DMA_CHANNEL;
+
+  if (!DMA_ChannelEnabled(RX_DMA_CHANNEL)) {
+    return 0;
+  }
+  return ((descr->CTRL & _DMA_CTRL_N_MINUS_1_MASK) >> _DMA_CTRL_N_MINUS_1_SHIFT) + 1;
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Initialize the DMA module
+ *
+ * @details
+ *    Always use dmaControlBlock to make sure that the control block is
+ *    properly aligned. Tell the DMA module to trigger when there is data in
+ *    the LEUART RX buffer.
+ *****************************************************************************/
+void initDma(void)
+{
+  // Initializing the DMA
+  DMA_Init_TypeDef init;
+  init.hprot = 0; // Access level/protection not an issue
+  init.controlBlock = dmaControlBlock; // Make sure control block is properly aligned
+  DMA_Init(&init);
+
+  // Channel configuration
+  DMA_CfgChannel_TypeDef channelConfig;
+  channelConfig.highPri   = false; // Set high priority for the channel
+  channelConfig.enableInt = false; // The LEUART end of message interrupt is used
+  channelConfig.select    = DMAREQ_LEUART0_RXDATAV; // Select DMA trigger
+  channelConfig.cb        = NULL;                   // No callback because no interrupt
+  DMA_CfgChannel(RX_DMA_CHANNEL, &channelConfig);
+
+  // Channel descriptor configuration
+  DMA_CfgDescr_TypeDef descriptorConfig;
+  descriptorConfig.dstInc  = dmaDataInc1;    // Destination moves along rxBuffer
+  descriptorConfig.srcInc  = dmaDataIncNone; // Source doesn't move
+  descriptorConfig.size    = dmaDataSize1;   // Transfer 8 bits each time
+  descriptorConfig.arbRate = dmaArbitrate1;  // Arbitrate after every DMA transfer
+  descriptorConfig.hprot   = 0;              // Access level/protection not an issue
+  DMA_CfgDescr(RX_DMA_CHANNEL, true, &descriptorConfig);
+
+  startRxDma();
+}
+#endif
+
 /**************************************************************************//**
  * @brief
  *    LEUART0 interrupt service routine
@@ -100,13 +198,28 @@ void LEUART0_IRQHandler(void)
 {
   // Note: These are static because the handler will exit/enter
   //       multiple times to fully transmit a message.
+#if !FRAMED_RX
   static uint32_t rxIndex = 0;
+#endif
   static uint32_t txIndex = 0;
 
   // Acknowledge the interrupt
   uint32_t flags = LEUART_IntGet(LEUART0);
   LEUART_IntClear(LEUART0, flags);
 
+#if FRAMED_RX
+  // End of message: the DMA has moved all of it once the RX buffer is empty
+  if (flags & LEUART_IF_SIGF) {
+    LEUART0->CMD = LEUART_CMD_RXBLOCKEN; // Wait for the next start frame
+    while ((LEUART0->STATUS & LEUART_STATUS_RXDATAV)
+           && (rxDmaRemaining() != 0)) ;
+    uint32_t rxLength = RX_BUFFER_SIZE - 1 - rxDmaRemaining();
+    DMA_ChannelEnable(RX_DMA_CHANNEL, false);
+    rxBuffer[rxLength] = '\0';
+    rxDataReady = 1;
+    rxMessages++;
+  }
+#else
   // RX portion of the interrupt handler
   if (flags & LEUART_IF_RXDATAV) {
     while (LEUART0->STATUS & LEUART_STATUS_RXDATAV) { // While there is still incoming data
@@ -122,6 +235,7 @@ void LEUART0_IRQHandler(void)
       }
     }
   }
+#endif
 
   // TX portion of the interrupt handler
   if (flags & LEUART_IF_TXC) {
@@ -155,6 +269,9 @@ int main(void)
   // Initialization
   initGpio();
   initLeuart();
+#if FRAMED_RX
+  initDma();
+#endif
 
   // Print the welcome message
   char welcomeString[] = "LEUART echo code example\r\n";
@@ -168,6 +285,15 @@ int main(void)
 
     // When notified by the RX handler, start processing the received data
     if (rxDataReady) {
+#if FRAMED_RX
+      // Echo the message without our address
+      for (i = 0; rxBuffer[i + 1] != 0; i++) {
+        txBuffer[i] = rxBuffer[i + 1]; // Copy rxBuffer into txBuffer
+      }
+      txBuffer[i] = '\0';
+      rxDataReady = 0; // Indicate that we need new data
+      startRxDma();
+#else
       LEUART_IntDisable(LEUART0, LEUART_IEN_RXDATAV | LEUART_IEN_TXC); // Disable interrupts
       for (i = 0; rxBuffer[i] != 0; i++) {
         txBuffer[i] = rxBuffer[i]; // Copy rxBuffer into txBuffer
@@ -175,6 +301,7 @@ int main(void)
       txBuffer[i] = '\0';
       rxDataReady = 0; // Indicate that we need new data
       LEUART_IntEnable(LEUART0, LEUART_IEN_RXDATAV | LEUART_IEN_TXC); // Re-enable interrupts
+#endif
       LEUART_IntSet(LEUART0, LEUART_IFS_TXC);
     }
 
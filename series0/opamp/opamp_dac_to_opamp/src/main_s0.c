@@ -6,6 +6,11 @@
  * R2 = R1. This results in Vout = Vin * 2. This project also configures the
  * DAC to output on Channel 0. The user should use a wire to connect the
  * output of the DAC to the positive input node of the opamp.
+ *
+ * The DAC streams a 64 point waveform from RAM: TIMER0 paces the DMA, which
+ * writes one point per overflow to the DAC channel, so the opamp drives a
+ * 1 kHz waveform. Push button PB0 switches between a sine, a triangle, a
+ * sawtooth and a square wave.
  *******************************************************************************
  * # License
  * <b>Copyright 2020 Silicon Laboratories Inc. www.silabs.com</b>
@@ -43,7 +48,12 @@
 #include "em_cmu.h"
 #include "em_emu.h"
 #include "em_opamp.h"
-#include "em_adc.h"
+#include "em_dac.h"
+#include "em_gpio.h"
+#include "em_timer.h"
+#include "em_dma.h"
+#include "dmactrl.h"
+#include "bsp.h"
 
 // Note: change this to one of the OPAMP_ResSel_TypeDef type defines to select
 //       the R2/R1 resistor ladder ratio. By default this is R2 = R1. This
@@ -54,6 +64,51 @@
 // be either a zero or one
 #define CHANNEL_NUM 0
 
+// Note: change this to set the frequency of the waveform
+#define WAVEFORM_FREQ 1000
+
+// Points per waveform period; TIMER0 overflows once per point
+#define WAVE_POINTS   64
+#define TIMER0_FREQ   (WAVEFORM_FREQ * WAVE_POINTS)
+
+// DMA channel that writes the DAC
+#define DMA_CHANNEL   0
+
+// Waveform shapes, in the order PB0 steps through them
+#define SHAPE_SINE      0
+#define SHAPE_TRIANGLE  1
+#define SHAPE_SAWTOOTH  2
+#define SHAPE_SQUARE    3
+#define NUM_SHAPES      4
+
+// One period of a sine wave, 12-bit DAC codes
+static const uint16_t sineTable[WAVE_POINTS] = {
+  2048, 2248, 2447, 2642, 2831, 3013, 3185, 3346,
+  3495, 3630, 3750, 3853, 3939, 4007, 4056, 4085,
+  4095, 4085, 4056, 4007, 3939, 3853, 3750, 3630,
+  3495, 3346, 3185, 3013, 2831, 2642, 2447, 2248,
+  2048, 1847, 1648, 1453, 1264, 1082,  910,  749,
+   600,  465,  345,  242,  156,   88,   39,   10,
+     0,   10,   39,   88,  156,  242,  345,  465,
+   600,  749,  910, 1082, 1264, 1453, 1648, 1847,
+};
+
+// The waveform streamed and the next one
+static uint16_t waveform[2][WAVE_POINTS];
+
+// DAC channel data register the DMA writes
+#define DAC_DATA ((CHANNEL_NUM == 0) ? &DAC0->CH0DATA : &DAC0->CH1DATA)
+
+// Buffer of the waveform streamed, and its shape
+static volatile uint32_t active;
+static volatile uint32_t shape;
+
+// Buffer each descriptor sends next, primary and alternate
+static volatile uint32_t descriptorBuffer[2];
+
+// Set by the PB0 interrupt
+static volatile bool buttonPressed;
+
 /**************************************************************************//**
  * @brief
  *    DAC initialization
@@ -83,24 +138,230 @@ void initDac(void)
 
 /**************************************************************************//**
  * @brief
- *    Calculate the digital value that maps to the desired output voltage
+ *    Fill one buffer with one period of a waveform
  *
- * @note
- *    The vRef parameter must match the reference voltage selected during
- *    initialization
+ * @param [out] buf
+ *    WAVE_POINTS 12-bit DAC codes
  *
- * @param [in] vOut
- *    Desired output voltage
+ * @param [in] waveShape
+ *    One of the SHAPE_ defines
+ *****************************************************************************/
+void fillWaveform(uint16_t *buf, uint32_t waveShape)
+{
+  uint32_t i;
+
+  for (i = 0; i < WAVE_POINTS; i++) {
+    switch (waveShape) {
+      case SHAPE_TRIANGLE:
+        if (i < WAVE_POINTS / 2) {
+          buf[i] = (uint16_t)((i * 4095) / (WAVE_POINTS / 2));
+        } else {
+          buf[i] = (uint16_t)(((WAVE_POINTS - i) * 4095) / (WAVE_POINTS / 2));
+        }
+        break;
+      case SHAPE_SAWTOOTH:
+        buf[i] = (uint16_t)((i * 4095) / (WAVE_POINTS - 1));
+        break;
+      case SHAPE_SQUARE:
+        buf[i] = (i < WAVE_POINTS / 2) ? 4095 : 0;
+        break;
+      default:
+        buf[i] = sineTable[i];
+        break;
+    }
+  }
+}
+
+/***************************************************************************//**
+* @brief
+*   DMA callback function
+*
+* @details
+*   This function gets called after the primary or the alternate descriptor
+*   has sent one period. It refreshes that descriptor with the buffer of the
+*   waveform streamed, while the other descriptor sends the next period. A
+*   new waveform therefore starts at the end of a period, without a glitch.
+*
+* @notes
+*   The userPtr parameter is not used because we don't need a user defined
+*   pointer. However, the function definition needs to have all three of
+*   these parameters because the default handler provided in em_dma.c calls
+*   the user's callback function this way.
+******************************************************************************/
+void refreshTransfer(uint32_t channelNum,
+                     bool isPrimaryDescriptor,
+                     void *userPtr)
+{
+  uint32_t buf = active;
+
+  (void)userPtr;
+
+  DMA_RefreshPingPong(channelNum,
+                      isPrimaryDescriptor,
+                      false,                   // Don't use the burst feature
+                      (void *) DAC_DATA,       // Destination address to transfer to
+                      (void *) waveform[buf],  // Source address to transfer from
+                      WAVE_POINTS - 1,         // Number of DMA transfers minus 1
+                      false);                  // Don't stop after using this descriptor
+
+  descriptorBuffer[isPrimaryDescriptor ? 0 : 1] = buf;
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Timer initialization
+ *****************************************************************************/
+void initTimer(void)
+{
+  // Enable clock for TIMER0 module
+  CMU_ClockEnable(cmuClock_TIMER0, true);
+
+  // Initialize TIMER0
+  TIMER_Init_TypeDef init = TIMER_INIT_DEFAULT;
+  init.enable = false;
+  TIMER_Init(TIMER0, &init);
+
+  // Set top (reload) value for the timer
+  // Note: the timer runs off of the HFPER clock
+  uint32_t topValue = CMU_ClockFreqGet(cmuClock_HFPER) / TIMER0_FREQ;
+  TIMER_TopBufSet(TIMER0, topValue);
+
+  // Automatically clear the DMA request
+  TIMER0->CTRL |= TIMER_CTRL_DMACLRACT;
+
+  // Enable TIMER0
+  TIMER_Enable(TIMER0, true);
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Initialize the DMA module
  *
- * @param [in] vRef
- *    Reference voltage used by the DAC
+ * @details
+ *    Always use dmaControlBlock to make sure that the control block is properly
+ *    aligned. The DMA is triggered by the TIMER0 overflow, one point per
+ *    overflow. A ping pong cycle is used on all devices, also on those that
+ *    have loop mode, because the refresh at the end of each period is what
+ *    changes the waveform without a glitch.
  *
- * @return
- *    The digital value that maps to the desired output voltage
+ * @note
+ *    The descriptor configuration and callback need to at least have static
+ *    scope persistence so that the reference to the object is valid beyond its
+ *    first use in initialization.
+ ******************************************************************************/
+void initDma(void)
+{
+  // Start with the sine wave
+  active = 0;
+  shape = SHAPE_SINE;
+  fillWaveform(waveform[active], shape);
+  descriptorBuffer[0] = active;
+  descriptorBuffer[1] = active;
+
+  // Initializing the DMA
+  DMA_Init_TypeDef init;
+  init.hprot = 0; // Access level/protection not an issue
+  init.controlBlock = dmaControlBlock; // Make sure control block is properly aligned
+  DMA_Init(&init);
+
+  // Callback configuration
+  static DMA_CB_TypeDef callback;
+  callback.cbFunc = (DMA_FuncPtr_TypeDef) refreshTransfer;
+  callback.userPtr = NULL; // Unused
+
+  // Channel configuration
+  DMA_CfgChannel_TypeDef channelConfig;
+  channelConfig.highPri   = false; // Don't set high priority for the channel
+  channelConfig.enableInt = true;  // Interrupt needed to refresh the descriptors
+  channelConfig.select    = DMAREQ_TIMER0_UFOF; // Select DMA trigger
+  channelConfig.cb        = &callback;          // Need callback to refresh DMA transfer
+  DMA_CfgChannel(DMA_CHANNEL, &channelConfig);
+
+  // Channel configuration for ping pong mode
+  static DMA_CfgDescr_TypeDef descriptorConfig;
+  descriptorConfig.dstInc  = dmaDataIncNone; // Destination doesn't move
+  descriptorConfig.srcInc  = dmaDataInc2;    // Source moves 2 bytes each transfer
+  descriptorConfig.size    = dmaDataSize2;   // Transfer 2 bytes each time
+  descriptorConfig.arbRate = dmaArbitrate1;  // Arbitrate after every DMA transfer
+  descriptorConfig.hprot   = 0;              // Access level/protection not an issue
+  DMA_CfgDescr(DMA_CHANNEL, true, &descriptorConfig);  // Primary descriptor
+  DMA_CfgDescr(DMA_CHANNEL, false, &descriptorConfig); // Alternate descriptor
+
+  // Activate ping pong DMA cycle (used for memory-peripheral transfers)
+  bool isUseBurst = false;
+  DMA_ActivatePingPong(DMA_CHANNEL,
+                       isUseBurst,
+                       (void *) DAC_DATA,          // Primary destination address to transfer to
+                       (void *) waveform[active],  // Primary source address to transfer from
+                       WAVE_POINTS - 1,            // Primary number of DMA transfers minus 1
+                       (void *) DAC_DATA,          // Alternate destination address to transfer to
+                       (void *) waveform[active],  // Alternate source address to transfer from
+                       WAVE_POINTS - 1);           // Alternate number of DMA transfers minus 1
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Switch the stream to another waveform at the end of a period
+ *
+ * @details
+ *    The new waveform is written to the buffer not streamed. Once it is
+ *    the buffer streamed, the DMA callback hands it to each descriptor in
+ *    turn, so the switch happens within two periods.
+ *
+ * @param [in] waveShape
+ *    One of the SHAPE_ defines
  *****************************************************************************/
-uint32_t getDacValue(float vOut, float vRef)
+void streamWaveform(uint32_t waveShape)
 {
-  return (uint32_t)((vOut * 4095) / vRef);
+  uint32_t next = active ^ 1;
+
+  // Wait until neither descriptor sends the buffer about to be written
+  while ((descriptorBuffer[0] == next) || (descriptorBuffer[1] == next)) {
+    EMU_EnterEM1();
+  }
+
+  fillWaveform(waveform[next], waveShape);
+
+  active = next;
+  shape = waveShape;
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Push button PB0 initialization, a falling edge interrupt
+ *****************************************************************************/
+void initButton(void)
+{
+  CMU_ClockEnable(cmuClock_GPIO, true);
+
+  GPIO_PinModeSet(BSP_GPIO_PB0_PORT, BSP_GPIO_PB0_PIN, gpioModeInputPullFilter, 1);
+  GPIO_ExtIntConfig(BSP_GPIO_PB0_PORT, BSP_GPIO_PB0_PIN, BSP_GPIO_PB0_PIN,
+                    false, true, true);
+
+  NVIC_ClearPendingIRQ(GPIO_EVEN_IRQn);
+  NVIC_EnableIRQ(GPIO_EVEN_IRQn);
+  NVIC_ClearPendingIRQ(GPIO_ODD_IRQn);
+  NVIC_EnableIRQ(GPIO_ODD_IRQn);
+}
+
+/**************************************************************************//**
+ * @brief
+ *    GPIO Even IRQ for pushbuttons on even-numbered pins
+ *****************************************************************************/
+void GPIO_EVEN_IRQHandler(void)
+{
+  GPIO_IntClear(GPIO_IntGet() & 0x5555);
+  buttonPressed = true;
+}
+
+/**************************************************************************//**
+ * @brief
+ *    GPIO Odd IRQ for pushbuttons on odd-numbered pins
+ *****************************************************************************/
+void GPIO_ODD_IRQHandler(void)
+{
+  GPIO_IntClear(GPIO_IntGet() & 0xAAAA);
+  buttonPressed = true;
 }
 
 /**************************************************************************//**
@@ -114,6 +375,8 @@ void initOpamp(void)
   init.resInMux = opaResInMuxVss;          // Set the input to the resistor ladder to VSS
   init.resSel   = RESISTOR_SELECT;         // Choose the resistor ladder ratio
   init.outPen   = DAC_OPA2MUX_OUTPEN_OUT0; // Choose main output location #0 (PD5)
+  init.bias     = 15;                      // Highest bias current for the most bandwidth
+  init.halfBias = false;                   // Don't halve the bias current
 
   // Enable OPA2
   OPAMP_Enable(DAC0, OPA2, &init);
@@ -144,16 +407,21 @@ int main(void)
   // Enable the DAC clock for accessing the opamp registers
   CMU_ClockEnable(cmuClock_DAC0, true);
 
-  // Initialize the ADC and OPAMP
+  // Initialize the DAC and OPAMP, then start streaming
   initDac();
   initOpamp();
-
-  // Output the 12-bit output value for 1.1 V
-  uint32_t dacValue = getDacValue(1.1, 1.25);
-  DAC_ChannelOutputSet(DAC0, CHANNEL_NUM, dacValue);
+  initDma();
+  initTimer();
+  initButton();
 
   while (1) {
-    EMU_EnterEM3(false);
+    // The DMA streams the waveform, sleep until PB0 is pressed
+    EMU_EnterEM1();
+
+    if (buttonPressed) {
+      buttonPressed = false;
+      streamWaveform((shape + 1) % NUM_SHAPES);
+    }
   }
 }
 
@@ -0,0 +1,93 @@
+/***************************************************************************//**
+ * @file swtimer.h
+ * @brief Tickless software timers on the two RTC compare registers.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2020 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ******************************************************************************/
+
+#ifndef SWTIMER_H
+#define SWTIMER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Longest timeout or period, RTC ticks. The 24-bit RTC counter is extended
+// to 32 bits with its overflows and deadlines are compared as signed
+// differences of the extended count.
+#define SWTIMER_MAX_TICKS     0x7FFFFFFFUL
+
+struct SWTIMER_Timer;
+
+// Called from the RTC interrupt when a timer expires
+typedef void (*SWTIMER_Callback_t)(struct SWTIMER_Timer *timer, void *data);
+
+// Timer state, owned by the caller and zeroed before first use, as for
+// any static timer. The fields are private, use the functions below.
+typedef struct SWTIMER_Timer {
+  struct SWTIMER_Timer *next;     // Next timer by deadline
+  uint32_t deadline;              // Extended RTC count to expire at
+  uint32_t period;                // Ticks to restart with, 0 for one shot
+  uint32_t periodFrac;            // Fraction of a tick to add to period
+  uint32_t frac;                  // Fraction of a tick carried, 16 bits
+  uint32_t periodMs;              // Period in ms, 0 if set in ticks
+  uint32_t slack;                 // Ticks the timer may run late by
+  SWTIMER_Callback_t callback;
+  void *data;
+  bool running;
+} SWTIMER_Timer_t;
+
+void SWTIMER_Init(void);
+bool SWTIMER_Start(SWTIMER_Timer_t *timer,
+                   uint32_t timeout,
+                   uint32_t period,
+                   uint32_t slack,
+                   SWTIMER_Callback_t callback,
+                   void *data);
+bool SWTIMER_StartMs(SWTIMER_Timer_t *timer,
+                     uint32_t timeoutMs,
+                     uint32_t periodMs,
+                     uint32_t slackMs,
+                     SWTIMER_Callback_t callback,
+                     void *data);
+void SWTIMER_Stop(SWTIMER_Timer_t *timer);
+bool SWTIMER_IsRunning(const SWTIMER_Timer_t *timer);
+void SWTIMER_DelayMs(uint32_t ms);
+uint32_t SWTIMER_MsToTicks(uint32_t ms);
+uint32_t SWTIMER_GetTicks(void);
+uint32_t SWTIMER_GetWakeupCount(void);
+uint32_t SWTIMER_GetExpiryCount(void);
+bool SWTIMER_Calibrate(uint32_t ms);
+int32_t SWTIMER_GetErrorPpm(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SWTIMER_H
@@ -0,0 +1,225 @@
+/***************************************************************************//**
+ * @file main.c
+ * @brief This project runs several low rate software timers on the RTC with
+ * no periodic tick, with both compare registers as a queue of wakeups and the
+ * RTC clock measured against the HFXO.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2020 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ *******************************************************************************
+ * # Evaluation Quality
+ * This code has been minimally tested to ensure that it builds and is suitable 
+ * as a demonstration for evaluation purposes only. This code will be maintained
+ * at the sole discretion of Silicon Labs.
+ ******************************************************************************/
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "em_device.h"
+#include "em_chip.h"
+#include "em_cmu.h"
+#include "em_core.h"
+#include "em_emu.h"
+#include "em_gpio.h"
+
+#include "bsp.h"
+#include "swtimer.h"
+
+// Clock of the RTC, cmuSelect_LFXO or cmuSelect_ULFRCO. The EFM32G cannot
+// clock the RTC from the ULFRCO.
+#define RTC_CLOCK             cmuSelect_LFXO
+
+// Timer periods and the slack the sensor and report timers share a
+// wakeup with
+#define HEARTBEAT_MS          500
+#define SENSOR_MS             1000
+#define REPORT_MS             1100
+#define SHARED_SLACK_MS       100
+
+// Interval and window of the RTC clock measurement
+#define CALIBRATE_MS          60000
+#define CALIBRATE_WINDOW_MS   100
+
+static SWTIMER_Timer_t heartbeatTimer;
+static SWTIMER_Timer_t sensorTimer;
+static SWTIMER_Timer_t reportTimer;
+static SWTIMER_Timer_t calibrateTimer;
+
+static volatile bool calibrateDue;
+
+// Results, inspect them in the debugger
+volatile uint32_t heartbeats;
+volatile uint32_t sensorReads;
+volatile uint32_t reports;
+volatile uint32_t wakeups;
+volatile uint32_t expiries;
+volatile uint32_t calibrations;
+volatile int32_t errorPpm;
+
+/**************************************************************************//**
+ * @brief Toggle LED0 twice a second
+ *****************************************************************************/
+static void heartbeat(SWTIMER_Timer_t *timer, void *data)
+{
+  (void)timer;
+  (void)data;
+
+  GPIO_PinOutToggle(BSP_GPIO_LED0_PORT, BSP_GPIO_LED0_PIN);
+  heartbeats++;
+}
+
+/**************************************************************************//**
+ * @brief Stand-in for reading a sensor
+ *****************************************************************************/
+static void readSensor(SWTIMER_Timer_t *timer, void *data)
+{
+  (void)timer;
+  (void)data;
+
+  sensorReads++;
+}
+
+/**************************************************************************//**
+ * @brief Stand-in for reporting the readings
+ *****************************************************************************/
+static void report(SWTIMER_Timer_t *timer, void *data)
+{
+  (void)timer;
+  (void)data;
+
+  reports++;
+  wakeups = SWTIMER_GetWakeupCount();
+  expiries = SWTIMER_GetExpiryCount();
+}
+
+/**************************************************************************//**
+ * @brief Ask the main loop to measure the RTC clock again
+ *****************************************************************************/
+static void calibrate(SWTIMER_Timer_t *timer, void *data)
+{
+  (void)timer;
+  (void)data;
+
+  calibrateDue = true;
+}
+
+/**************************************************************************//**
+ * @brief Measure the RTC clock against the HFXO
+ *
+ * @details The core runs from the HFXO for the measurement only, and from
+ * the HFRCO otherwise.
+ *****************************************************************************/
+static void calibrateRtcClock(void)
+{
+  CMU_ClockSelectSet(cmuClock_HF, cmuSelect_HFXO);
+
+  if (SWTIMER_Calibrate(CALIBRATE_WINDOW_MS)) {
+    calibrations++;
+    errorPpm = SWTIMER_GetErrorPpm();
+  }
+
+  CMU_ClockSelectSet(cmuClock_HF, cmuSelect_HFRCO);
+  CMU_OscillatorEnable(cmuOsc_HFXO, false, false);
+}
+
+/**************************************************************************//**
+ * @brief GPIO initialization
+ *****************************************************************************/
+void initGPIO(void)
+{
+  //Turn on the clock for the GPIO
+  CMU_ClockEnable(cmuClock_GPIO, true);
+
+  //Enable LED0
+  GPIO_PinModeSet(BSP_GPIO_LED0_PORT, BSP_GPIO_LED0_PIN, gpioModePushPull, 0);
+}
+
+/**************************************************************************//**
+ * @brief RTC initialization
+ *****************************************************************************/
+void rtcSetup(void)
+{
+  // Enable the oscillator for the RTC
+  if (RTC_CLOCK == cmuSelect_ULFRCO) {
+    CMU_OscillatorEnable(cmuOsc_ULFRCO, true, true);
+  } else {
+    CMU_OscillatorEnable(cmuOsc_LFXO, true, true);
+  }
+
+  // Turn on the clock for Low Energy clocks
+  CMU_ClockEnable(cmuClock_HFLE, true);
+  CMU_ClockSelectSet(cmuClock_LFA, RTC_CLOCK);
+
+  // Start the RTC and take over its compare registers
+  SWTIMER_Init();
+}
+
+/**************************************************************************//**
+ * @brief  Main function
+ *****************************************************************************/
+int main(void)
+{
+  CORE_DECLARE_IRQ_STATE;
+
+  // Chip errata
+  CHIP_Init();
+
+  // Initializations
+  initGPIO();
+
+  rtcSetup();
+
+  // Measure the RTC clock before any timer is converted from ms
+  calibrateRtcClock();
+
+  SWTIMER_StartMs(&heartbeatTimer, HEARTBEAT_MS, HEARTBEAT_MS, 0,
+                  heartbeat, NULL);
+  SWTIMER_StartMs(&sensorTimer, SENSOR_MS, SENSOR_MS, SHARED_SLACK_MS,
+                  readSensor, NULL);
+  SWTIMER_StartMs(&reportTimer, REPORT_MS, REPORT_MS, SHARED_SLACK_MS,
+                  report, NULL);
+  SWTIMER_StartMs(&calibrateTimer, CALIBRATE_MS, CALIBRATE_MS,
+                  CALIBRATE_MS / 10, calibrate, NULL);
+
+  // Infinite loop
+  while(1)
+  {
+    if (calibrateDue) {
+      calibrateDue = false;
+      calibrateRtcClock();
+    }
+
+    // Check and sleep with interrupts off so the request cannot be missed
+    CORE_ENTER_CRITICAL();
+    if (!calibrateDue) {
+      if (RTC_CLOCK == cmuSelect_ULFRCO) {
+        EMU_EnterEM3(true);
+      } else {
+        EMU_EnterEM2(true);
+      }
+    }
+    CORE_EXIT_CRITICAL();
+  }
+}
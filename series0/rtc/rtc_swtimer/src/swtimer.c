@@ -0,0 +1,785 @@
+/***************************************************************************//**
+ * @file swtimer.c
+ * @brief Tickless software timers on the two RTC compare registers.
+ *
+ * @details
+ *   The RTC counts freely and any number of caller owned timers wait on
+ *   it in a list sorted by deadline. The device sleeps from one deadline
+ *   to the next with no periodic tick. The 24-bit counter is extended to
+ *   32 bits by counting its overflows.
+ *
+ *   A timer may run up to its slack late. A wakeup is moved from the first
+ *   deadline of the list to the latest later deadline that every timer
+ *   before it can still wait for, and all timers due by then expire in
+ *   the same interrupt.
+ *
+ *   COMP0 and COMP1 hold the next two wakeups as a queue. A compare whose
+ *   value is still wanted is left alone, so a wakeup usually only writes
+ *   the compare that just matched, with the one after already armed in the
+ *   other. Each write to a compare register is synchronized to the low
+ *   frequency clock, which takes up to three of its cycles, 3 ms with the
+ *   ULFRCO; writing only one of them keeps the interrupt short.
+ *
+ *   Timers started in milliseconds are converted with the measured rate
+ *   of the RTC clock, see SWTIMER_Calibrate(), and keep the fraction of a
+ *   tick of their period so that a periodic timer does not drift.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2020 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ******************************************************************************/
+
+#include <stddef.h>
+#include "em_device.h"
+#include "em_cmu.h"
+#include "em_core.h"
+#include "em_emu.h"
+#include "em_rtc.h"
+#include "em_timer.h"
+#include "swtimer.h"
+
+// Compare registers of the RTC, COMP0 and COMP1
+#define COMPARES          2
+
+// Soonest a compare can be set ahead of the counter and still match,
+// allowing for the synchronization of the write
+#define MIN_LEAD_TICKS    5
+
+// Furthest a compare can be set ahead, half the 24-bit counter range.
+// Later deadlines take an empty wakeup on the way.
+#define MAX_LEAD_TICKS    (1UL << 23)
+
+#define OVERFLOW_TICKS    (_RTC_CNT_MASK + 1UL)
+
+// Reference counts a calibration aims for, leaving room for an RTC clock
+// that runs at half its nominal rate
+#define CAL_MAX_COUNTS    0x8000UL
+
+// Largest prescaler of TIMER0, 2^10
+#define CAL_MAX_PRESC     10
+
+#define COMPARE_IF(c)     (RTC_IF_COMP0 << (c))
+
+static SWTIMER_Timer_t *head;
+
+// Wakeup held in each compare, in extended ticks, while it is armed
+static uint32_t compareAt[COMPARES];
+static bool armed[COMPARES];
+
+// Upper 8 bits of the extended count
+static uint32_t overflows;
+
+// Nominal and measured rate of the RTC clock, ticks per second, Q16
+static uint32_t nominalHz;
+static uint32_t rateQ16;
+
+static volatile uint32_t wakeupCount;
+static volatile uint32_t expiryCount;
+
+/***************************************************************************//**
+ * @brief
+ *   Compare two counter values across the 32-bit wrap.
+ *
+ * @return
+ *   true if a is before b.
+ ******************************************************************************/
+static bool before(uint32_t a, uint32_t b)
+{
+  return (int32_t)(a - b) < 0;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Get the extended count, the overflows added to the RTC counter.
+ *
+ * @details
+ *   An overflow that is still pending is taken into account; the counter
+ *   is read again as it may have wrapped after the first read.
+ ******************************************************************************/
+static uint32_t getTicks(void)
+{
+  uint32_t ticks;
+  CORE_DECLARE_IRQ_STATE;
+
+  CORE_ENTER_CRITICAL();
+
+  ticks = overflows + RTC_CounterGet();
+  if (RTC_IntGet() & RTC_IF_OF) {
+    ticks = overflows + OVERFLOW_TICKS + RTC_CounterGet();
+  }
+
+  CORE_EXIT_CRITICAL();
+
+  return ticks;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Convert milliseconds to RTC ticks at the measured rate, Q16.
+ ******************************************************************************/
+static uint64_t msToTicksQ16(uint32_t ms)
+{
+  return ((uint64_t)ms * rateQ16) / 1000;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Set the period of a timer from its period in milliseconds.
+ ******************************************************************************/
+static void setPeriodMs(SWTIMER_Timer_t *timer)
+{
+  uint64_t period = msToTicksQ16(timer->periodMs);
+
+  timer->period = (uint32_t)(period >> 16);
+  timer->periodFrac = (uint32_t)period & 0xFFFF;
+
+  // A period shorter than a tick would make the timer a one shot
+  if (timer->period == 0) {
+    timer->period = 1;
+    timer->periodFrac = 0;
+  }
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Insert a timer into the list, after any timers with the same deadline.
+ ******************************************************************************/
+static void insert(SWTIMER_Timer_t *timer)
+{
+  SWTIMER_Timer_t **link = &head;
+
+  while ((*link != NULL) && !before(timer->deadline, (*link)->deadline)) {
+    link = &(*link)->next;
+  }
+
+  timer->next = *link;
+  *link = timer;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Remove a timer from the list if it is in it.
+ ******************************************************************************/
+static void unlink(SWTIMER_Timer_t *timer)
+{
+  SWTIMER_Timer_t **link;
+
+  for (link = &head; *link != NULL; link = &(*link)->next) {
+    if (*link == timer) {
+      *link = timer->next;
+      break;
+    }
+  }
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Find the wakeup of the timers from first on.
+ *
+ * @details
+ *   The wakeup starts at the first deadline and moves on to each later
+ *   deadline that is no later than the earliest deadline + slack of the
+ *   timers taken in so far.
+ *
+ * @return
+ *   The first timer that expires after the wakeup, or NULL.
+ ******************************************************************************/
+static SWTIMER_Timer_t *findWake(SWTIMER_Timer_t *first, uint32_t *wake)
+{
+  SWTIMER_Timer_t *timer;
+  uint32_t limit;
+
+  *wake = first->deadline;
+  limit = first->deadline + first->slack;
+
+  for (timer = first->next;
+       (timer != NULL) && !before(limit, timer->deadline);
+       timer = timer->next) {
+    *wake = timer->deadline;
+    if (before(timer->deadline + timer->slack, limit)) {
+      limit = timer->deadline + timer->slack;
+    }
+  }
+
+  return timer;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Arm a compare register for a wakeup.
+ ******************************************************************************/
+static void arm(unsigned int compare, uint32_t wake)
+{
+  RTC_CompareSet(compare, wake & _RTC_CNT_MASK);
+  RTC_IntClear(COMPARE_IF(compare));
+  RTC_IntEnable(COMPARE_IF(compare));
+
+  compareAt[compare] = wake;
+  armed[compare] = true;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Program the compare registers for the next two wakeups.
+ *
+ * @details
+ *   An armed compare that already holds one of the wakeups is kept, the
+ *   other wakeups are written to the compares that are free, and compares
+ *   that are not needed are disarmed. Called with interrupts disabled.
+ ******************************************************************************/
+static void program(void)
+{
+  SWTIMER_Timer_t *rest;
+  uint32_t wake[COMPARES];
+  bool covered[COMPARES] = { false, false };
+  bool keep[COMPARES] = { false, false };
+  unsigned int wakes = 0;
+  unsigned int i, c;
+  uint32_t now;
+
+  now = getTicks();
+
+  if (head != NULL) {
+    rest = findWake(head, &wake[0]);
+    wakes = 1;
+
+    if (before(wake[0], now + MIN_LEAD_TICKS)) {
+      wake[0] = now + MIN_LEAD_TICKS;
+    }
+
+    if (before(now + MAX_LEAD_TICKS, wake[0])) {
+      wake[0] = now + MAX_LEAD_TICKS;
+    } else if (rest != NULL) {
+      findWake(rest, &wake[1]);
+      if (before(wake[0], wake[1])
+          && !before(now + MAX_LEAD_TICKS, wake[1])) {
+        wakes = 2;
+      }
+    }
+  }
+
+  for (i = 0; i < wakes; i++) {
+    for (c = 0; c < COMPARES; c++) {
+      if (armed[c] && !keep[c] && (compareAt[c] == wake[i])) {
+        keep[c] = true;
+        covered[i] = true;
+        break;
+      }
+    }
+  }
+
+  for (i = 0; i < wakes; i++) {
+    for (c = 0; !covered[i] && (c < COMPARES); c++) {
+      if (!keep[c]) {
+        arm(c, wake[i]);
+        keep[c] = true;
+        covered[i] = true;
+      }
+    }
+  }
+
+  for (c = 0; c < COMPARES; c++) {
+    if (armed[c] && !keep[c]) {
+      RTC_IntDisable(COMPARE_IF(c));
+      RTC_IntClear(COMPARE_IF(c));
+      armed[c] = false;
+    }
+  }
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Sleep until the next interrupt, in EM3 if the RTC runs from the
+ *   ULFRCO and in EM2 otherwise.
+ ******************************************************************************/
+static void enterSleep(void)
+{
+  if (CMU_ClockSelectGet(cmuClock_LFA) == cmuSelect_ULFRCO) {
+    EMU_EnterEM3(true);
+  } else {
+    EMU_EnterEM2(true);
+  }
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Timer callback of SWTIMER_DelayMs().
+ ******************************************************************************/
+static void delayExpired(SWTIMER_Timer_t *timer, void *data)
+{
+  (void)timer;
+
+  *(volatile bool *)data = true;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Start a timer, with interrupts disabled.
+ ******************************************************************************/
+static void start(SWTIMER_Timer_t *timer,
+                  uint32_t timeout,
+                  uint32_t slack,
+                  SWTIMER_Callback_t callback,
+                  void *data)
+{
+  unlink(timer);
+
+  timer->deadline = getTicks() + timeout;
+  timer->frac = 0;
+  timer->slack = slack;
+  timer->callback = callback;
+  timer->data = data;
+  timer->running = true;
+
+  insert(timer);
+  program();
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Wait for the next RTC tick.
+ *
+ * @return
+ *   The RTC counter after the tick.
+ ******************************************************************************/
+static uint32_t waitTick(void)
+{
+  uint32_t first = RTC_CounterGet();
+  uint32_t count;
+
+  do {
+    count = RTC_CounterGet();
+  } while (count == first);
+
+  return count;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   RTC interrupt, counts the overflows and expires every timer that is
+ *   due.
+ *
+ * @details
+ *   Periodic timers are put back before their callback runs, so a
+ *   callback can stop or restart its own timer. A periodic timer that has
+ *   fallen a whole period behind restarts from now rather than expiring
+ *   several times in a row.
+ ******************************************************************************/
+void RTC_IRQHandler(void)
+{
+  SWTIMER_Timer_t *timer;
+  uint32_t flags;
+  uint32_t now;
+  unsigned int c;
+
+  flags = RTC_IntGet() & RTC->IEN;
+  RTC_IntClear(flags);
+
+  if (flags & RTC_IF_OF) {
+    overflows += OVERFLOW_TICKS;
+  }
+
+  if (!(flags & (RTC_IF_COMP0 | RTC_IF_COMP1))) {
+    return;
+  }
+
+  for (c = 0; c < COMPARES; c++) {
+    if (flags & COMPARE_IF(c)) {
+      RTC_IntDisable(COMPARE_IF(c));
+      armed[c] = false;
+    }
+  }
+
+  wakeupCount++;
+
+  now = getTicks();
+
+  while ((head != NULL) && !before(now, head->deadline)) {
+    timer = head;
+    head = timer->next;
+
+    if (timer->period != 0) {
+      timer->frac += timer->periodFrac;
+      timer->deadline += timer->period + (timer->frac >> 16);
+      timer->frac &= 0xFFFF;
+      if (!before(now, timer->deadline)) {
+        timer->deadline = now + timer->period;
+      }
+      insert(timer);
+    } else {
+      timer->running = false;
+    }
+
+    expiryCount++;
+
+    if (timer->callback != NULL) {
+      timer->callback(timer, timer->data);
+    }
+  }
+
+  program();
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Start the RTC counting freely and take over both compare registers.
+ *
+ * @details
+ *   The LFA clock must already be selected and the HFLE clock enabled.
+ *   Until SWTIMER_Calibrate() is called, milliseconds are converted at the
+ *   nominal rate of the RTC clock.
+ ******************************************************************************/
+void SWTIMER_Init(void)
+{
+  RTC_Init_TypeDef rtcInit = RTC_INIT_DEFAULT;
+  unsigned int c;
+
+  CMU_ClockEnable(cmuClock_RTC, true);
+  nominalHz = CMU_ClockFreqGet(cmuClock_RTC);
+  rateQ16 = nominalHz << 16;
+
+  head = NULL;
+  overflows = 0;
+  wakeupCount = 0;
+  expiryCount = 0;
+
+  for (c = 0; c < COMPARES; c++) {
+    armed[c] = false;
+  }
+
+  RTC_IntDisable(_RTC_IEN_MASK);
+  RTC_IntClear(_RTC_IFC_MASK);
+
+  // Count through the whole 24-bit range rather than up to COMP0
+  rtcInit.comp0Top = false;
+  RTC_Init(&rtcInit);
+
+  RTC_IntEnable(RTC_IEN_OF);
+  NVIC_ClearPendingIRQ(RTC_IRQn);
+  NVIC_EnableIRQ(RTC_IRQn);
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Start or restart a timer.
+ *
+ * @param[in] timer
+ *   Timer to start, owned by the caller until it expires or is stopped.
+ *
+ * @param[in] timeout
+ *   RTC ticks to the first expiry.
+ *
+ * @param[in] period
+ *   RTC ticks between later expiries, 0 for a one shot timer.
+ *
+ * @param[in] slack
+ *   RTC ticks the timer may run late by to share a wakeup.
+ *
+ * @param[in] callback
+ *   Called from the RTC interrupt on each expiry, may be NULL.
+ *
+ * @param[in] data
+ *   Passed to the callback.
+ *
+ * @return
+ *   false if a time is longer than SWTIMER_MAX_TICKS.
+ ******************************************************************************/
+bool SWTIMER_Start(SWTIMER_Timer_t *timer,
+                   uint32_t timeout,
+                   uint32_t period,
+                   uint32_t slack,
+                   SWTIMER_Callback_t callback,
+                   void *data)
+{
+  CORE_DECLARE_IRQ_STATE;
+
+  if ((timer == NULL)
+      || (timeout > SWTIMER_MAX_TICKS)
+      || (period > SWTIMER_MAX_TICKS)
+      || (slack > SWTIMER_MAX_TICKS)) {
+    return false;
+  }
+
+  CORE_ENTER_CRITICAL();
+
+  timer->period = period;
+  timer->periodFrac = 0;
+  timer->periodMs = 0;
+  start(timer, timeout, slack, callback, data);
+
+  CORE_EXIT_CRITICAL();
+
+  return true;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Start or restart a timer with its times in milliseconds.
+ *
+ * @details
+ *   The times are converted at the measured rate of the RTC clock. The
+ *   period keeps its fraction of a tick, and is converted again by each
+ *   SWTIMER_Calibrate().
+ *
+ * @return
+ *   false if a time is longer than SWTIMER_MAX_TICKS.
+ ******************************************************************************/
+bool SWTIMER_StartMs(SWTIMER_Timer_t *timer,
+                     uint32_t timeoutMs,
+                     uint32_t periodMs,
+                     uint32_t slackMs,
+                     SWTIMER_Callback_t callback,
+                     void *data)
+{
+  CORE_DECLARE_IRQ_STATE;
+
+  if ((timer == NULL)
+      || ((msToTicksQ16(timeoutMs) >> 16) >= SWTIMER_MAX_TICKS)
+      || ((msToTicksQ16(periodMs) >> 16) >= SWTIMER_MAX_TICKS)
+      || ((msToTicksQ16(slackMs) >> 16) > SWTIMER_MAX_TICKS)) {
+    return false;
+  }
+
+  CORE_ENTER_CRITICAL();
+
+  timer->periodMs = periodMs;
+  if (periodMs != 0) {
+    setPeriodMs(timer);
+  } else {
+    timer->period = 0;
+    timer->periodFrac = 0;
+  }
+  start(timer, SWTIMER_MsToTicks(timeoutMs),
+        (uint32_t)(msToTicksQ16(slackMs) >> 16), callback, data);
+
+  CORE_EXIT_CRITICAL();
+
+  return true;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Stop a timer, nothing happens if it is not running.
+ ******************************************************************************/
+void SWTIMER_Stop(SWTIMER_Timer_t *timer)
+{
+  CORE_DECLARE_IRQ_STATE;
+
+  CORE_ENTER_CRITICAL();
+
+  unlink(timer);
+  timer->running = false;
+  program();
+
+  CORE_EXIT_CRITICAL();
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Check whether a timer is waiting to expire.
+ ******************************************************************************/
+bool SWTIMER_IsRunning(const SWTIMER_Timer_t *timer)
+{
+  return timer->running;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Sleep for a number of milliseconds, other timers keep running.
+ *
+ * @details
+ *   Replaces a SysTick based delay; the device sleeps in EM2 or EM3 until
+ *   the delay is over and wakes up only for other timers. Must not be
+ *   called from a timer callback.
+ ******************************************************************************/
+void SWTIMER_DelayMs(uint32_t ms)
+{
+  SWTIMER_Timer_t timer;
+  volatile bool done = false;
+  CORE_DECLARE_IRQ_STATE;
+
+  timer.running = false;
+  if (!SWTIMER_StartMs(&timer, ms, 0, 0, delayExpired, (void *)&done)) {
+    return;
+  }
+
+  while (!done) {
+    // Check and sleep with interrupts off so the wakeup cannot be missed
+    CORE_ENTER_CRITICAL();
+    if (!done) {
+      enterSleep();
+    }
+    CORE_EXIT_CRITICAL();
+  }
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Convert milliseconds to RTC ticks at the measured rate, rounded up.
+ ******************************************************************************/
+uint32_t SWTIMER_MsToTicks(uint32_t ms)
+{
+  uint64_t ticks = (msToTicksQ16(ms) + 0xFFFF) >> 16;
+
+  return (ticks > SWTIMER_MAX_TICKS) ? SWTIMER_MAX_TICKS : (uint32_t)ticks;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Get the extended RTC count the timers run on.
+ ******************************************************************************/
+uint32_t SWTIMER_GetTicks(void)
+{
+  return getTicks();
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Get the number of RTC compare wakeups since SWTIMER_Init().
+ ******************************************************************************/
+uint32_t SWTIMER_GetWakeupCount(void)
+{
+  return wakeupCount;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Get the number of timer expiries since SWTIMER_Init(). More expiries
+ *   than wakeups means deadlines were coalesced.
+ ******************************************************************************/
+uint32_t SWTIMER_GetExpiryCount(void)
+{
+  return expiryCount;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Measure the rate of the RTC clock against the HFPERCLK.
+ *
+ * @details
+ *   TIMER0 counts the HFPERCLK over a window of whole RTC ticks, from one
+ *   tick to another, so the result is only as good as the HFPERCLK; run it
+ *   from the HFXO for the measurement. The ULFRCO is only specified to
+ *   within tens of percent and the LFXO to the tolerance of its crystal,
+ *   and both drift with temperature, so the measurement is best repeated
+ *   from time to time.
+ *
+ *   Timers keep running; the CPU waits in EM0 over the window, with
+ *   interrupts disabled only around its two edges. The periods of the
+ *   running millisecond timers are converted again at the new rate.
+ *
+ * @param[in] ms
+ *   Length of the window. Longer windows average the jitter of the ULFRCO.
+ *
+ * @return
+ *   false if the window was too short or too long, was stretched by an
+ *   interrupt, or the rate was more than 50 % off the nominal rate.
+ ******************************************************************************/
+bool SWTIMER_Calibrate(uint32_t ms)
+{
+  TIMER_Init_TypeDef timerInit = TIMER_INIT_DEFAULT;
+  SWTIMER_Timer_t *timer;
+  uint32_t ticks, refHz, counts, begin, end;
+  uint32_t nominalQ16;
+  uint64_t expected, rate;
+  unsigned int presc;
+  bool overflow;
+  CORE_DECLARE_IRQ_STATE;
+
+  ticks = (uint32_t)(((uint64_t)nominalHz * ms) / 1000);
+  if ((ticks < 2) || (ticks > MAX_LEAD_TICKS)) {
+    return false;
+  }
+
+  // Smallest prescaler that keeps the window within the 16-bit counter
+  refHz = CMU_ClockFreqGet(cmuClock_HFPER);
+  expected = ((uint64_t)refHz * ms) / 1000;
+  for (presc = 0;
+       ((expected >> presc) >= CAL_MAX_COUNTS) && (presc < CAL_MAX_PRESC);
+       presc++) {
+  }
+  if ((expected >> presc) >= CAL_MAX_COUNTS) {
+    return false;
+  }
+
+  CMU_ClockEnable(cmuClock_HFPER, true);
+  CMU_ClockEnable(cmuClock_TIMER0, true);
+  timerInit.prescale = (TIMER_Prescale_TypeDef)presc;
+  TIMER_TopSet(TIMER0, 0xFFFF);
+  TIMER_Init(TIMER0, &timerInit);
+
+  CORE_ENTER_CRITICAL();
+  begin = waitTick();
+  TIMER_CounterSet(TIMER0, 0);
+  TIMER_IntClear(TIMER0, TIMER_IF_OF);
+  CORE_EXIT_CRITICAL();
+
+  while (((RTC_CounterGet() - begin) & _RTC_CNT_MASK) < (ticks - 1)) {
+  }
+
+  CORE_ENTER_CRITICAL();
+  end = waitTick();
+  counts = TIMER_CounterGet(TIMER0);
+  overflow = (TIMER_IntGet(TIMER0) & TIMER_IF_OF) != 0;
+  CORE_EXIT_CRITICAL();
+
+  TIMER_Enable(TIMER0, false);
+  CMU_ClockEnable(cmuClock_TIMER0, false);
+
+  if ((((end - begin) & _RTC_CNT_MASK) != ticks) || overflow || (counts == 0)) {
+    return false;
+  }
+
+  rate = (((uint64_t)ticks * refHz) << 16) / ((uint64_t)counts << presc);
+
+  nominalQ16 = nominalHz << 16;
+  if ((rate < (nominalQ16 / 2)) || (rate > (nominalQ16 + (nominalQ16 / 2)))) {
+    return false;
+  }
+
+  CORE_ENTER_CRITICAL();
+
+  rateQ16 = (uint32_t)rate;
+  for (timer = head; timer != NULL; timer = timer->next) {
+    if (timer->periodMs != 0) {
+      setPeriodMs(timer);
+    }
+  }
+
+  CORE_EXIT_CRITICAL();
+
+  return true;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Get the error of the RTC clock found by the last SWTIMER_Calibrate(),
+ *   in parts per million, positive if it runs fast.
+ ******************************************************************************/
+int32_t SWTIMER_GetErrorPpm(void)
+{
+  int64_t error = (int64_t)rateQ16 - ((int64_t)nominalHz << 16);
+
+  return (int32_t)((error * 1000000) / ((int64_t)nominalHz << 16));
+}
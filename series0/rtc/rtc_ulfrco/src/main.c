@@ -2,7 +2,8 @@
  * @file main.c
  * @brief This project demonstrates the use of the RTC. The timer is set to
  * interrupt after 5 seconds. The device then goes into EM3. Upon interrupt the
- * device wakes up and toggles LED's 0 and 1.
+ * device wakes up and toggles LED's 0 and 1. The period is kept at 5 seconds
+ * with the ULFRCO error measured against the HFXO.
  *******************************************************************************
  * # License
  * <b>Copyright 2020 Silicon Laboratories Inc. www.silabs.com</b>
@@ -44,24 +45,72 @@
 #include "em_gpio.h"
 
 #include "bsp.h"
+#include "lfcal.h"
 
-#define DELAY_SECONDS 5.0
+#define PERIOD_MS     5000
 #define ULFRCOFREQ    1000
-#define COMPARE_TOP   (DELAY_SECONDS * ULFRCOFREQ - 1)
+
+// The ULFRCO is measured over 1 s at startup and then every 12 periods,
+// once a minute, to follow its drift with the temperature
+#define MEASURE_TICKS 1000
+#define MEASURE_EVERY 12
+
+// Fraction of a tick carried from one period to the next
+static uint32_t periodFrac;
+
+static volatile uint32_t periods;
+static volatile bool measureDue;
+
+// Measurements of the ULFRCO and its error at the last one, ppm
+volatile uint32_t measurements;
+volatile int32_t errorPpm;
+
+/**************************************************************************//**
+ * @brief Compare value of the next period at the measured ULFRCO rate
+ *****************************************************************************/
+static uint32_t nextCompare(void)
+{
+  return LFCAL_PeriodTicks(PERIOD_MS, &periodFrac) - 1;
+}
 
 /**************************************************************************//**
  * @brief RTCC interrupt service routine
  *****************************************************************************/
 void RTC_IRQHandler(void)
 {
-  //Reset counter
-  RTC_CounterReset();
+  // COMP0 is the top value, the counter has wrapped at the match; set the
+  // length of the next period, rather than reset the counter late
+  RTC_CompareSet(0, nextCompare());
 
   //Clear interrupt flag
   RTC_IntClear(RTC_IFC_COMP0);
 
   // Toggle LED 0
   GPIO_PinOutToggle(BSP_GPIO_LED0_PORT, BSP_GPIO_LED0_PIN);
+
+  if ((++periods % MEASURE_EVERY) == 0) {
+    measureDue = true;
+  }
+}
+
+/**************************************************************************//**
+ * @brief Measure the ULFRCO against the HFXO
+ *
+ * @details The core runs from the HFXO for the measurement only, and from
+ * the HFRCO otherwise. The measurement starts right after a wakeup, so the
+ * counter does not wrap at the next one over the window.
+ *****************************************************************************/
+static void measureUlfrco(void)
+{
+  CMU_ClockSelectSet(cmuClock_HF, cmuSelect_HFXO);
+
+  if (LFCAL_Measure(RTC_CounterGet, _RTC_CNT_MASK, MEASURE_TICKS)) {
+    measurements = LFCAL_GetMeasureCount();
+    errorPpm = LFCAL_GetErrorPpm();
+  }
+
+  CMU_ClockSelectSet(cmuClock_HF, cmuSelect_HFRCO);
+  CMU_OscillatorEnable(cmuOsc_HFXO, false, false);
 }
 
 /**************************************************************************//**
@@ -90,8 +139,10 @@ void rtcSetup(void)
 
   CMU_ClockEnable(cmuClock_RTC, true);
 
-  // Set RTC compare value for RTC 0
-  RTC_CompareSet(0, COMPARE_TOP);
+  // Set RTC compare value for RTC 0, the first period is at the nominal
+  // ULFRCO rate
+  LFCAL_Init(ULFRCOFREQ);
+  RTC_CompareSet(0, nextCompare());
 
   // Allow channel 0 to cause an interrupt
   RTC_IntEnable(RTC_IEN_COMP0);
@@ -102,7 +153,7 @@ void rtcSetup(void)
   // Configure the RTC settings
   RTC_Init_TypeDef rtc = RTC_INIT_DEFAULT;
 
-  // Initialise RTC with pre-defined settings
+  // Initialise RTC with pre-defined settings, COMP0 as the top value
   RTC_Init(&rtc);
 }
 
@@ -119,9 +170,17 @@ int main(void)
 
   rtcSetup();
 
+  // Measure the ULFRCO over the first period, the next ones are compensated
+  measureUlfrco();
+
   // Infinite loop
   while(1)
   {
     EMU_EnterEM3(true);
+
+    if (measureDue) {
+      measureDue = false;
+      measureUlfrco();
+    }
   }
 }
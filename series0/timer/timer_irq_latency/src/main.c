@@ -0,0 +1,354 @@
+/***************************************************************************//**
+ * @file main.c
+ * @brief Measures the interrupt latency and its jitter from a TIMER compare
+ * match to the first store of the handler, with the vector table and the
+ * handler in flash and in RAM and at several core clocks. See readme.txt for details.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2020 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ *******************************************************************************
+ * # Evaluation Quality
+ * This code has been minimally tested to ensure that it builds and is suitable 
+ * as a demonstration for evaluation purposes only. This code will be maintained
+ * at the sole discretion of Silicon Labs.
+ ******************************************************************************/
+
+#include "em_device.h"
+#include "em_chip.h"
+#include "em_cmu.h"
+#include "em_gpio.h"
+#include "em_prs.h"
+#include "em_ramfunc.h"
+#include "em_timer.h"
+#include "bsp.h"
+
+/*******************************************************************************
+ *******************************   DEFINES   ***********************************
+ ******************************************************************************/
+
+// Compare matches measured per configuration
+#define RUN_SAMPLES               1000
+
+// TIMER1 counts ahead of the compare match when it is set
+#define COMPARE_LEAD              200
+
+/*
+ * The compare output of TIMER1 CC0 toggles PD6 (location 4) at the match,
+ * the handler toggles LED0, and the PRS takes LED0 to the input capture of
+ * CC1.
+ */
+#define COMPARE_PORT              gpioPortD
+#define COMPARE_PIN               6
+#define COMPARE_LOCATION          TIMER_ROUTE_LOCATION_LOC4
+#define ISR_PORT                  BSP_GPIO_LED0_PORT
+#define ISR_PIN                   BSP_GPIO_LED0_PIN
+#define ISR_PRS_CHANNEL           0
+
+// Exception and interrupt entries in the vector table
+#define VECTOR_COUNT              (16 + EXT_IRQ_COUNT)
+
+// VTOR needs the table aligned to its size rounded up to a power of two
+#define VECTOR_ALIGNMENT          256
+
+#if (VECTOR_COUNT * 4) > VECTOR_ALIGNMENT
+#error "Vector table larger than VECTOR_ALIGNMENT"
+#endif
+
+#define NUM_CLOCKS                3
+#define NUM_PLACEMENTS            3
+#define NUM_RUNS                  (NUM_CLOCKS * NUM_PLACEMENTS)
+
+/*******************************************************************************
+ ***************************   GLOBAL VARIABLES   *******************************
+ ******************************************************************************/
+
+// Latency of one configuration
+typedef struct {
+  uint32_t coreHz;          // Core and TIMER1 clock
+  bool ramVectors;          // Vector table in RAM, else in flash
+  bool ramHandler;          // Handler in RAM, else in flash
+  uint32_t samples;         // Compare matches in the statistics
+  uint32_t cyclesMin;       // Compare match to the handler toggling LED0
+  uint32_t cyclesMax;
+  float cyclesMean;
+  uint32_t jitter;          // cyclesMax - cyclesMin
+  float latencyMin;         // The same in ns
+  float latencyMean;
+  float latencyMax;
+} LatencyResult_t;
+
+typedef struct {
+  bool ramVectors;
+  bool ramHandler;
+} Placement_t;
+
+static const CMU_HFRCOBand_TypeDef clocks[NUM_CLOCKS] = {
+  cmuHFRCOBand_7MHz, cmuHFRCOBand_14MHz, cmuHFRCOBand_21MHz
+};
+
+static const Placement_t placements[NUM_PLACEMENTS] = {
+  { false, false }, { true, false }, { true, true }
+};
+
+static volatile LatencyResult_t results[NUM_RUNS];
+
+// Passes completed over all configurations
+static volatile uint32_t passes;
+
+// Set by the handler
+static volatile bool handled;
+
+// RAM copy of the vector table, filled in by setPlacement()
+#if defined(__ICCARM__)
+#pragma data_alignment=VECTOR_ALIGNMENT
+static __no_init uint32_t ramTable[VECTOR_COUNT];
+#else
+static uint32_t ramTable[VECTOR_COUNT]
+__attribute__((aligned(VECTOR_ALIGNMENT)));
+#endif
+
+// Vector table of the startup code
+static uint32_t flashVtor;
+
+/**************************************************************************//**
+ * @brief
+ *    TIMER1 handler in flash, in the vector table of the startup code
+ *
+ * @details
+ *    LED0 is toggled first, its edge is the end of the latency. Registers
+ *    are written directly, as in the RAM handler below, which must not call
+ *    functions in flash.
+ *****************************************************************************/
+void TIMER1_IRQHandler(void)
+{
+  GPIO->P[ISR_PORT].DOUTTGL = 1 << ISR_PIN;
+  TIMER1->IFC = TIMER_IFC_CC0;
+  handled = true;
+}
+
+/**************************************************************************//**
+ * @brief
+ *    TIMER1 handler in RAM, installed in the RAM vector table
+ *****************************************************************************/
+SL_RAMFUNC_DEFINITION_BEGIN
+static void ramTimerHandler(void)
+{
+  GPIO->P[ISR_PORT].DOUTTGL = 1 << ISR_PIN;
+  TIMER1->IFC = TIMER_IFC_CC0;
+  handled = true;
+}
+SL_RAMFUNC_DEFINITION_END
+
+/**************************************************************************//**
+ * @brief
+ *    Set up the pins and the PRS from LED0 to TIMER1
+ *
+ * @details
+ *    The LED0 pin is configured as an external interrupt with no edge
+ *    enabled, which selects its port for the PRS signal. The PRS source
+ *    splits the lower (0-7) and higher (8-15) GPIO pins.
+ *****************************************************************************/
+static void initGpioPrs(void)
+{
+  CMU_ClockEnable(cmuClock_GPIO, true);
+  CMU_ClockEnable(cmuClock_PRS, true);
+
+  GPIO_PinModeSet(COMPARE_PORT, COMPARE_PIN, gpioModePushPull, 0);
+  GPIO_PinModeSet(ISR_PORT, ISR_PIN, gpioModePushPull, 0);
+  GPIO_ExtIntConfig(ISR_PORT, ISR_PIN, ISR_PIN, false, false, false);
+
+  if (ISR_PIN < 8) {
+    PRS_SourceSignalSet(ISR_PRS_CHANNEL, PRS_CH_CTRL_SOURCESEL_GPIOL,
+                        ISR_PIN, prsEdgeOff);
+  } else {
+    PRS_SourceSignalSet(ISR_PRS_CHANNEL, PRS_CH_CTRL_SOURCESEL_GPIOH,
+                        ISR_PIN - 8, prsEdgeOff);
+  }
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Start TIMER1 counting the core clock
+ *
+ * @details
+ *    CC0 compares and toggles its output at the match, CC1 captures both
+ *    edges of LED0.
+ *****************************************************************************/
+static void initTimer(void)
+{
+  TIMER_Init_TypeDef timerInit = TIMER_INIT_DEFAULT;
+  TIMER_InitCC_TypeDef compareInit = TIMER_INITCC_DEFAULT;
+  TIMER_InitCC_TypeDef captureInit = TIMER_INITCC_DEFAULT;
+
+  CMU_ClockEnable(cmuClock_HFPER, true);
+  CMU_ClockEnable(cmuClock_TIMER1, true);
+
+  timerInit.enable = false;
+  TIMER_Init(TIMER1, &timerInit);
+
+  compareInit.mode = timerCCModeCompare;
+  compareInit.cmoa = timerOutputActionToggle;
+  TIMER_InitCC(TIMER1, 0, &compareInit);
+
+  captureInit.mode = timerCCModeCapture;
+  captureInit.edge = timerEdgeBoth;
+  captureInit.prsInput = true;
+  captureInit.prsSel = (TIMER_PRSSEL_TypeDef)ISR_PRS_CHANNEL;
+  TIMER_InitCC(TIMER1, 1, &captureInit);
+
+  TIMER1->ROUTE = TIMER_ROUTE_CC0PEN | COMPARE_LOCATION;
+
+  TIMER_TopSet(TIMER1, TIMER_MaxCount(TIMER1));
+  TIMER_IntClear(TIMER1, _TIMER_IF_MASK);
+  TIMER_IntEnable(TIMER1, TIMER_IEN_CC0);
+  NVIC_ClearPendingIRQ(TIMER1_IRQn);
+  NVIC_EnableIRQ(TIMER1_IRQn);
+
+  TIMER_Enable(TIMER1, true);
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Place the vector table and the handler
+ *
+ * @details
+ *    The RAM table is a copy of the table of the startup code with the
+ *    TIMER1 entry set to the handler to measure. TIMER1 only interrupts
+ *    while measure() waits for it, so no vector is fetched from a table
+ *    half written.
+ *****************************************************************************/
+static void setPlacement(bool ramVectors, bool ramHandler)
+{
+  const uint32_t *table = (const uint32_t *)flashVtor;
+  uint32_t i;
+
+  if (ramVectors) {
+    for (i = 0; i < VECTOR_COUNT; i++) {
+      ramTable[i] = table[i];
+    }
+    ramTable[16 + TIMER1_IRQn] = ramHandler ? (uint32_t)ramTimerHandler
+                                            : (uint32_t)TIMER1_IRQHandler;
+
+    // Complete the copy before the next exception fetches a vector from it
+    __DSB();
+    SCB->VTOR = (uint32_t)ramTable;
+  } else {
+    SCB->VTOR = flashVtor;
+  }
+  __DSB();
+  __ISB();
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Measure one configuration
+ *
+ * @details
+ *    Each compare match is set COMPARE_LEAD counts ahead and the CPU waits
+ *    for the handler in a loop, as a control loop waiting for its next
+ *    period would. The latency is the LED0 edge captured by CC1 less the
+ *    compare value, in TIMER1 counts, which are core cycles.
+ *
+ * @param[in] r
+ *    Configuration, its statistics are filled in
+ *****************************************************************************/
+static void measure(volatile LatencyResult_t *r)
+{
+  uint32_t mask = TIMER_MaxCount(TIMER1);
+  uint32_t compare, cycles, i;
+  uint32_t min = 0xFFFFFFFF, max = 0;
+  uint64_t sum = 0;
+
+  setPlacement(r->ramVectors, r->ramHandler);
+
+  for (i = 0; i < RUN_SAMPLES; i++) {
+    // Empty the capture buffer
+    while (TIMER1->STATUS & TIMER_STATUS_ICV1) {
+      TIMER_CaptureGet(TIMER1, 1);
+    }
+
+    handled = false;
+    compare = (TIMER_CounterGet(TIMER1) + COMPARE_LEAD) & mask;
+    TIMER_CompareSet(TIMER1, 0, compare);
+
+    while (!handled) {
+    }
+    while (!(TIMER1->STATUS & TIMER_STATUS_ICV1)) {
+    }
+
+    cycles = (TIMER_CaptureGet(TIMER1, 1) - compare) & mask;
+    sum += cycles;
+    if (cycles < min) {
+      min = cycles;
+    }
+    if (cycles > max) {
+      max = cycles;
+    }
+  }
+
+  r->samples = RUN_SAMPLES;
+  r->cyclesMin = min;
+  r->cyclesMax = max;
+  r->cyclesMean = (float)sum / RUN_SAMPLES;
+  r->jitter = max - min;
+  r->latencyMin = min * 1e9f / r->coreHz;
+  r->latencyMean = r->cyclesMean * 1e9f / r->coreHz;
+  r->latencyMax = max * 1e9f / r->coreHz;
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Main function
+ *****************************************************************************/
+int main(void)
+{
+  volatile LatencyResult_t *r;
+  int c, p;
+
+  CHIP_Init();
+
+  flashVtor = SCB->VTOR;
+
+  initGpioPrs();
+  initTimer();
+
+  // Measure all configurations, over and over
+  while (1) {
+    r = results;
+    for (c = 0; c < NUM_CLOCKS; c++) {
+      // Emlib sets the flash wait states with the clock
+      CMU_HFRCOBandSet(clocks[c]);
+
+      for (p = 0; p < NUM_PLACEMENTS; p++) {
+        r->coreHz = SystemCoreClockGet();
+        r->ramVectors = placements[p].ramVectors;
+        r->ramHandler = placements[p].ramHandler;
+        measure(r);
+        r++;
+      }
+    }
+    passes++;
+  }
+}
@@ -51,6 +51,9 @@ extern "C" {
 // (clocked by 32 kHz clock) whenever the USB enters suspend mode. If ONVBUSOFF is set, the
 // USB controller will automatically enter low power mode whenever power is lost
 // on VBUS. This requires that the USB regulator is used and that VREGI is connected to VBUS.
+// In low power mode the USB clocks are gated and USBD_SafeToEnterEM2() returns true, the
+// main loop then enters EM2. The USB core keeps its endpoint state, so on resume the stack
+// restores the 48 MHz clock and the transfers set up before the suspend carry on.
 // Needed for emusb/em_usbd.c and emusb/em_usbdint.c
 #define USB_PWRSAVE_MODE (USB_PWRSAVE_MODE_ONSUSPEND | USB_PWRSAVE_MODE_ONVBUSOFF)
 
@@ -60,17 +63,30 @@ extern "C" {
 #define NUM_EP_USED      3
 
 // Specify the number of application timers needed
-// This must at least be 1 for the UartRxTimeout() functionality provided in the Drivers/cdc.c code
+// This must at least be 2, one for the UartRxTimeout() functionality and one for the
+// throughput statistics provided in the src/cdc_s0.c code
 // Needed for emusb/em_usbtimer.c
-#define NUM_APP_TIMERS   1
+#define NUM_APP_TIMERS   2
 
 // Specify which timer to use for the CDC UartRxTimeout() timer
 // This #define chooses Timer0 by default
-// Needed for Drivers/cdc.c
+// Needed for src/cdc_s0.c
 #define CDC_TIMER_ID     0
 
+// Specify which timer to use for sampling the throughput once per second
+// Needed for src/cdc_s0.c
+#define CDC_STATS_TIMER_ID  1
+
+// Ring buffer configuration, the number and size of the buffers in each direction
+// USB OUT buffers must be a multiple of the 64 byte endpoint size
+// Needed for src/cdc_s0.c
+#define CDC_USB_RX_BUF_CNT  4     // USB OUT to UART TX buffers
+#define CDC_USB_RX_BUF_SIZ  256   // Bytes per USB read
+#define CDC_USB_TX_BUF_CNT  4     // UART RX to USB IN buffers
+#define CDC_USB_TX_BUF_SIZ  255   // Bytes per USB write
+
 // Define the interface numbers
-// Needed for Drivers/cdc.c
+// Needed for src/cdc_s0.c
 #define CDC_CTRL_INTERFACE_NO   0
 #define CDC_DATA_INTERFACE_NO   1
 
@@ -79,20 +95,20 @@ extern "C" {
 #define NUM_INTERFACES   2
 
 // Define USB endpoint addresses for the interfaces
-// Needed for src/descriptors.c and Drivers/cdc.c
+// Needed for src/descriptors.c and src/cdc_s0.c
 #define CDC_EP_DATA_OUT  0x01  // Endpoint for CDC data transmission (host sends to device)
 #define CDC_EP_DATA_IN   0x81  // Endpoint for CDC data reception (host receives from device)
 #define CDC_EP_NOTIFY    0x82  // Notification endpoint (not used)
 
 // DMA configuration options
-// Needed for Drivers/cdc.c
+// Needed for src/cdc_s0.c
 #define CDC_UART_TX_DMA_CHANNEL     0
 #define CDC_UART_RX_DMA_CHANNEL     1
 #define CDC_TX_DMA_SIGNAL           DMAREQ_USART1_TXBL
 #define CDC_RX_DMA_SIGNAL           DMAREQ_USART1_RXDATAV
 
 // USART configuration options
-// Needed for Drivers/cdc.c
+// Needed for src/cdc_s0.c
 #define CDC_UART                    USART1
 #define CDC_UART_CLOCK              cmuClock_USART1
 #define CDC_UART_ROUTE              (USART_ROUTE_RXPEN | USART_ROUTE_TXPEN | USART_ROUTE_LOCATION_LOC1)
@@ -101,7 +117,18 @@ extern "C" {
 #define CDC_UART_RX_PORT            gpioPortD
 #define CDC_UART_RX_PIN             1
 
-// This define is used in Drivers/cdc.c, but it is left as an empty define since
+// Receive flow control options
+// RTS is a GPIO deasserted when the UART RX ring reaches its high water mark,
+// the USART has no CTS input so UART TX is not held back by the far end
+// Set CDC_FLOW_CONTROL to 1 when RTS is connected
+// Needed for src/cdc_s0.c
+#define CDC_FLOW_CONTROL            0
+#define CDC_UART_RTS_PORT           gpioPortD
+#define CDC_UART_RTS_PIN            2
+#define CDC_RX_HIGH_WATER           (CDC_USB_TX_BUF_CNT - 1)  // Buffers waiting for USB to deassert RTS
+#define CDC_RX_LOW_WATER            (CDC_USB_TX_BUF_CNT - 2)  // Buffers waiting for USB to assert RTS
+
+// This define is used in src/cdc_s0.c, but it is left as an empty define since
 // we are using the STK (starter kit) instead of the DK (development kit)
 #define CDC_ENABLE_DK_UART_SWITCH()
 
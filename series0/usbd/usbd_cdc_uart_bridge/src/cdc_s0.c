@@ -0,0 +1,1200 @@
+/***************************************************************************//**
+ * @file cdc_s0.c
+ * @brief USB Communication Device Class (CDC) driver.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2021 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ *******************************************************************************
+ * # Evaluation Quality
+ * This code has been minimally tested to ensure that it builds and is suitable 
+ * as a demonstration for evaluation purposes only. This code will be maintained
+ * at the sole discretion of Silicon Labs.
+ ******************************************************************************/
+
+#include <string.h>
+#include "em_device.h"
+#include "em_common.h"
+#include "em_cmu.h"
+#include "em_core.h"
+#include "em_dma.h"
+#include "em_gpio.h"
+#include "em_usart.h"
+#include "em_usb.h"
+#include "dmactrl.h"
+#include "cdc.h"
+
+/* *INDENT-OFF* */
+/**************************************************************************//**
+ * @addtogroup Cdc
+ * @{ Implements USB Communication Device Class (CDC).
+
+   @section cdc_intro CDC implementation.
+
+   The source code of the CDC implementation resides in
+   kits/common/drivers/cdc.c and cdc.h. This driver implements a basic
+   USB to RS232 bridge.
+
+   @section cdc_config CDC device configuration options.
+
+   This section contains a description of the configuration options for
+   the driver. The options are @htmlonly #define's @endhtmlonly which are
+   expected to be found in the application "usbconfig.h" header file.
+   The values shown below are from the Giant Gecko DK3750 CDC example.
+
+   @verbatim
+ // USB interface numbers. Interfaces are numbered from zero to one less than
+ // the number of concurrent interfaces supported by the configuration. A CDC
+ // device is by itself a composite device and has two interfaces.
+ // The interface numbers must be 0 and 1 for a standalone CDC device, for a
+ // composite device which includes a CDC interface it must not be in conflict
+ // with other device interfaces.
+ #define CDC_CTRL_INTERFACE_NO ( 0 )
+ #define CDC_DATA_INTERFACE_NO ( 1 )
+
+ // Endpoint address for CDC data reception.
+ #define CDC_EP_DATA_OUT ( 0x01 )
+
+ // Endpoint address for CDC data transmission.
+ #define CDC_EP_DATA_IN ( 0x81 )
+
+ // Endpoint address for the notification endpoint (not used).
+ #define CDC_EP_NOTIFY ( 0x82 )
+
+ // Timer id, see USBTIMER in the USB device stack documentation.
+ // The CDC driver has a Rx timeout functionality which require a timer.
+ #define CDC_TIMER_ID ( 0 )
+
+ // DMA related macros, select DMA channels and DMA request signals.
+ #define CDC_UART_TX_DMA_CHANNEL   ( 0 )
+ #define CDC_UART_RX_DMA_CHANNEL   ( 1 )
+ #define CDC_TX_DMA_SIGNAL         DMAREQ_UART1_TXBL
+ #define CDC_RX_DMA_SIGNAL         DMAREQ_UART1_RXDATAV
+
+ // UART/USART selection macros.
+ #define CDC_UART                  UART1
+ #define CDC_UART_CLOCK            cmuClock_UART1
+ #define CDC_UART_ROUTE            ( UART_ROUTE_RXPEN | UART_ROUTE_TXPEN | \
+                                    UART_ROUTE_LOCATION_LOC2 )
+ #define CDC_UART_TX_PORT          gpioPortB
+ #define CDC_UART_TX_PIN           9
+ #define CDC_UART_RX_PORT          gpioPortB
+ #define CDC_UART_RX_PIN           10
+
+ // Activate the RS232 switch on DK's.
+ #define CDC_ENABLE_DK_UART_SWITCH() BSP_PeripheralAccess(BSP_RS232_UART, true)
+
+ // No RS232 switch on STK's. Leave the definition "empty".
+ #define CDC_ENABLE_DK_UART_SWITCH()
+
+   @endverbatim
+ ** @} ***********************************************************************/
+/* *INDENT-ON* */
+
+/** @cond DO_NOT_INCLUDE_WITH_DOXYGEN */
+
+/*** Typedef's and defines. ***/
+
+#define CDC_BULK_EP_SIZE  (USB_FS_BULK_EP_MAXSIZE) // This is the max. ep size.
+
+// Host to device (USB OUT to UART TX) ring. Each buffer takes one USB read of
+// up to CDC_USB_RX_BUF_SIZ bytes and is sent to the UART straight from the
+// ring by the TX DMA channel.
+#ifndef CDC_USB_RX_BUF_CNT
+#define CDC_USB_RX_BUF_CNT  4
+#endif
+#ifndef CDC_USB_RX_BUF_SIZ
+#define CDC_USB_RX_BUF_SIZ  (4 * CDC_BULK_EP_SIZE) // Must be a multiple of the ep size.
+#endif
+
+// Device to host (UART RX to USB IN) ring. The RX DMA channel runs in
+// ping-pong mode, the primary and alternate descriptors take turns on the
+// buffers of the ring, and each filled buffer is passed to USBD_Write() as
+// it is. Keep the size one short of a multiple of the ep size so a full
+// buffer always ends with a short packet.
+#ifndef CDC_USB_TX_BUF_CNT
+#define CDC_USB_TX_BUF_CNT  4
+#endif
+#ifndef CDC_USB_TX_BUF_SIZ
+#define CDC_USB_TX_BUF_SIZ  255    // Packet size when transmitting on USB.
+#endif
+
+// USB buffers must be word aligned
+#define CDC_USB_TX_BUF_STRIDE  ((CDC_USB_TX_BUF_SIZ + 3) & ~3)
+
+#if (CDC_USB_RX_BUF_SIZ % CDC_BULK_EP_SIZE) || (CDC_USB_RX_BUF_SIZ > 2048) \
+  || (CDC_USB_TX_BUF_SIZ > 2048) || (CDC_USB_RX_BUF_CNT < 2) || (CDC_USB_TX_BUF_CNT < 2)
+#error "CDC ring buffers must be 2 or more buffers of at most 2048 bytes"
+#endif
+
+// A DMA cycle moves at most 1024 bytes, one buffer is one cycle
+#if (CDC_USB_RX_BUF_SIZ > 1024) || (CDC_USB_TX_BUF_SIZ > 1024)
+#error "CDC ring buffers must be at most 1024 bytes on the DMA"
+#endif
+
+// The UART RX ring is checked every CDC_RX_TICK ms. A partial buffer is sent
+// on USB once the line has been idle for an adaptive time between
+// CDC_RX_IDLE_MIN and CDC_RX_TIMEOUT, see UartRxIdleLimit().
+#define CDC_RX_TICK       1
+
+// Shortest idle time in ms, 2 char times on current baudrate.
+#define CDC_RX_IDLE_MIN   SL_MAX(CDC_RX_TICK, 20000 / (cdcLineCoding.dwDTERate))
+
+// Longest idle time in ms, 5 char times on current baudrate. Minimum timeout
+// is set to 10 ms.
+#define CDC_RX_TIMEOUT    SL_MAX(10U, 50000 / (cdcLineCoding.dwDTERate))
+
+// Weight of a new sample in the fill level and gap averages, 1 / 2^n
+#define CDC_RX_AVG_SHIFT  2
+
+// Receive flow control. RTS is a GPIO driven from the fill level of the UART
+// RX ring: it is deasserted (high) when CDC_RX_HIGH_WATER buffers wait for
+// USB and asserted again at CDC_RX_LOW_WATER. The series 0 USART has no CTS
+// input, so UART TX is not held back by the far end.
+#ifndef CDC_FLOW_CONTROL
+#define CDC_FLOW_CONTROL  0
+#endif
+#ifndef CDC_RX_HIGH_WATER
+#define CDC_RX_HIGH_WATER (CDC_USB_TX_BUF_CNT - 1)
+#endif
+#ifndef CDC_RX_LOW_WATER
+#define CDC_RX_LOW_WATER  (CDC_USB_TX_BUF_CNT - 2)
+#endif
+
+#if CDC_FLOW_CONTROL && ((CDC_RX_HIGH_WATER >= CDC_USB_TX_BUF_CNT) \
+  || (CDC_RX_LOW_WATER >= CDC_RX_HIGH_WATER))
+#error "CDC_RX_LOW_WATER < CDC_RX_HIGH_WATER < CDC_USB_TX_BUF_CNT required"
+#endif
+
+// Throughput is sampled once per CDC_STATS_PERIOD ms
+#define CDC_STATS_PERIOD  1000
+
+// The serial port LINE CODING data structure, used to carry information
+// about serial port baudrate, parity etc. between host and device.
+SL_PACK_START(1)
+typedef struct {
+  uint32_t dwDTERate;               /** Baudrate                            */
+  uint8_t  bCharFormat;             /** Stop bits, 0=1 1=1.5 2=2            */
+  uint8_t  bParityType;             /** 0=None 1=Odd 2=Even 3=Mark 4=Space  */
+  uint8_t  bDataBits;               /** 5, 6, 7, 8 or 16                    */
+  uint8_t  dummy;                   /** To ensure size is a multiple of 4 bytes */
+} SL_ATTRIBUTE_PACKED cdcLineCoding_TypeDef;
+SL_PACK_END()
+
+/*** Function prototypes. ***/
+
+static int  UsbDataReceived(USB_Status_TypeDef status, uint32_t xferred,
+                            uint32_t remaining);
+static int  UsbDataTransmitted(USB_Status_TypeDef status, uint32_t xferred,
+                               uint32_t remaining);
+static void DmaSetup(void);
+static int  LineCodingReceived(USB_Status_TypeDef status,
+                               uint32_t xferred,
+                               uint32_t remaining);
+static void SerialPortInit(void);
+static void UartRxTimeout(void);
+static void StatsTimeout(void);
+static void UsbRxArm(void);
+static void UartRxRun(void);
+static void UartRtsHold(void);
+static void UartRtsUpdate(void);
+static void CdcSuspend(void);
+static void CdcResume(void);
+
+static void DmaTxComplete(unsigned int channel, bool primary, void *user);
+static void DmaRxComplete(unsigned int channel, bool primary, void *user);
+
+static DMA_CB_TypeDef dmaCallbackTx;
+static DMA_CB_TypeDef dmaCallbackRx;
+
+/*** Variables ***/
+
+/*
+ * The LineCoding variable must be 4-byte aligned as it is used as USB
+ * transmit and receive buffer.
+ */
+SL_ALIGN(4)
+SL_PACK_START(1)
+static cdcLineCoding_TypeDef SL_ATTRIBUTE_ALIGN(4) cdcLineCoding =
+{
+  115200, 0, 0, 8, 0
+};
+SL_PACK_END()
+
+// USB receive buffers, sent to the UART in place
+STATIC_UBUF(usbRxBuffer, CDC_USB_RX_BUF_CNT * CDC_USB_RX_BUF_SIZ);
+// UART receive buffers, sent over USB in place
+STATIC_UBUF(uartRxBuffer, CDC_USB_TX_BUF_CNT * CDC_USB_TX_BUF_STRIDE);
+
+#define USB_RX_BUF(i)     (&usbRxBuffer[(i) * CDC_USB_RX_BUF_SIZ])
+#define UART_RX_BUF(i)    (&uartRxBuffer[(i) * CDC_USB_TX_BUF_STRIDE])
+
+// USB OUT to UART TX ring state
+static int            usbRxHead;       // Buffer the next USB read goes to
+static int            uartTxTail;      // Oldest buffer not yet sent to the UART
+static int            usbRxPending;    // Buffers received but not yet sent
+static uint32_t       usbRxLen[CDC_USB_RX_BUF_CNT];
+
+// UART RX to USB IN ring state
+static int            uartRxHead;      // Buffer the RX DMA is filling
+static bool           uartRxPrimary;   // Descriptor filling the head buffer
+static bool           uartRxNextArmed; // Other descriptor set up for the next buffer
+static int            usbTxTail;       // Oldest buffer not yet sent over USB
+static int            uartRxPending;   // Buffers filled but not yet sent
+static uint32_t       uartRxLen[CDC_USB_TX_BUF_CNT];
+static uint32_t       uartRxLastCount; // Bytes in the head buffer at the last timeout
+static uint32_t       uartRxIdle;      // ms without new chars in the head buffer
+static int32_t        uartRxFillAvg;   // Average fill of sent buffers, 0 to 256
+static int32_t        uartRxGapAvg;    // Average gap between chars in a burst, ms * 16
+static uint32_t       lastUsbTxCnt;
+
+static bool           usbRxActive, dmaTxActive;
+static bool           usbTxActive, dmaRxActive;
+static bool           usbTxZlp;
+static bool           uartRtsHeld;     // RTS deasserted, far end told to wait
+static bool           usbSuspended;    // Bus suspended while configured, rings kept
+
+// Throughput statistics
+static CDC_Throughput_TypeDef cdcThroughput[CDC_THROUGHPUT_RATES];
+static int            cdcThroughputCount;
+static uint32_t       uartToUsbTotal, usbToUartTotal;
+static uint32_t       uartToUsbLast, usbToUartLast;
+static uint32_t       rxStallTotal, rxStallLast;
+static uint32_t       usbTxWriteTotal, usbTxWriteLast;
+static uint32_t       rtsHoldTotal, rtsHoldLast;
+
+/** @endcond */
+
+/**************************************************************************//**
+ * @brief CDC device initialization.
+ *****************************************************************************/
+void CDC_Init(void)
+{
+  SerialPortInit();
+  DmaSetup();
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Handle USB setup commands. Implements CDC class specific commands.
+ *
+ * @param[in] setup Pointer to the setup packet received.
+ *
+ * @return USB_STATUS_OK if command accepted.
+ *         USB_STATUS_REQ_UNHANDLED when command is unknown, the USB device
+ *         stack will handle the request.
+ *****************************************************************************/
+int CDC_SetupCmd(const USB_Setup_TypeDef *setup)
+{
+  int retVal = USB_STATUS_REQ_UNHANDLED;
+
+  if ( (setup->Type         == USB_SETUP_TYPE_CLASS)
+       && (setup->Recipient == USB_SETUP_RECIPIENT_INTERFACE)    ) {
+    switch (setup->bRequest) {
+      case USB_CDC_GETLINECODING:
+        /********************/
+        if ( (setup->wValue       == 0)
+             && (setup->wIndex    == CDC_CTRL_INTERFACE_NO) // Interface no.
+             && (setup->wLength   == 7)                     // Length of cdcLineCoding.
+             && (setup->Direction == USB_SETUP_DIR_IN)    ) {
+          // Send current settings to USB host.
+          USBD_Write(0, (void*) &cdcLineCoding, 7, NULL);
+          retVal = USB_STATUS_OK;
+        }
+        break;
+
+      case USB_CDC_SETLINECODING:
+        /********************/
+        if ( (setup->wValue       == 0)
+             && (setup->wIndex    == CDC_CTRL_INTERFACE_NO) // Interface no.
+             && (setup->wLength   == 7)                     // Length of cdcLineCoding.
+             && (setup->Direction != USB_SETUP_DIR_IN)    ) {
+          // Get new settings from USB host.
+          USBD_Read(0, (void*) &cdcLineCoding, 7, LineCodingReceived);
+          retVal = USB_STATUS_OK;
+        }
+        break;
+
+      case USB_CDC_SETCTRLLINESTATE:
+        /********************/
+        if ( (setup->wIndex     == CDC_CTRL_INTERFACE_NO)      // Interface no.
+             && (setup->wLength == 0)    ) {                // No data.
+          // Do nothing ( Non compliant behaviour !! )
+          retVal = USB_STATUS_OK;
+        }
+        break;
+    }
+  }
+
+  return retVal;
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Callback function called each time the USB device state is changed.
+ *   Starts CDC operation when device has been configured by USB host.
+ *
+ * @note
+ *   The DMA RX channel is activated/started here but not the TX channel
+ *   because, upon plugging in the device, the USB host will start sending
+ *   packets over USB to the device in order to enumerate it. Since the device
+ *   tries to send any data it receives over USB out to UART, it will output
+ *   what essentially looks like junk onto the serial terminal emulator. To
+ *   avoid this, the TX channel is not immediately activated but rather started
+ *   up later in the UsbDataReceived() function.
+ *
+ * @param[in] oldState The device state the device has just left.
+ * @param[in] newState The new device state.
+ *****************************************************************************/
+void CDC_StateChangeEvent(USBD_State_TypeDef oldState,
+                          USBD_State_TypeDef newState)
+{
+  if (newState == USBD_STATE_CONFIGURED) {
+    // We have been configured, start CDC functionality !
+
+    if ((oldState == USBD_STATE_SUSPENDED) && usbSuspended) {
+      // Resume, the endpoint transfers set up before the suspend are still
+      // in place, carry on where the rings were left.
+      CdcResume();
+      return;
+    }
+
+    // Start receiving data from USB host.
+    usbRxHead    = 0;
+    uartTxTail   = 0;
+    usbRxPending = 0;
+    usbRxActive  = false;
+    dmaTxActive  = false;
+    UsbRxArm();
+
+    // Start receiving data on UART.
+    uartRxHead      = 0;
+    usbTxTail       = 0;
+    uartRxPending   = 0;
+    uartRxLastCount = 0;
+    uartRxIdle      = 0;
+    uartRxFillAvg   = 0;
+    uartRxGapAvg    = 0;
+    lastUsbTxCnt    = 0;
+    usbTxActive     = false;
+    usbTxZlp        = false;
+    dmaRxActive     = false;
+    usbSuspended    = false;
+    uartRtsHeld     = true;
+    UartRxRun();
+    UartRtsUpdate();
+
+    USBTIMER_Start(CDC_TIMER_ID, CDC_RX_TICK, UartRxTimeout);
+    USBTIMER_Start(CDC_STATS_TIMER_ID, CDC_STATS_PERIOD, StatsTimeout);
+  } else if (((oldState == USBD_STATE_CONFIGURED) || usbSuspended)
+             && (newState != USBD_STATE_SUSPENDED)) {
+    // We have been de-configured, or reset while suspended, stop CDC
+    // functionality.
+    USBTIMER_Stop(CDC_TIMER_ID);
+    USBTIMER_Stop(CDC_STATS_TIMER_ID);
+    // Stop DMA channels and tell the far end to stop sending.
+    DMA_ChannelEnable(CDC_UART_RX_DMA_CHANNEL, false);
+    DMA_ChannelEnable(CDC_UART_TX_DMA_CHANNEL, false);
+    dmaTxActive  = false;
+    usbSuspended = false;
+    UartRtsHold();
+  } else if ((oldState == USBD_STATE_CONFIGURED)
+             && (newState == USBD_STATE_SUSPENDED)) {
+    // We have been suspended, pause CDC functionality. The main loop
+    // enters EM2 once CDC_SafeToEnterEM2() returns true.
+    CdcSuspend();
+  }
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Get the throughput measured for each baud rate used so far.
+ *
+ * @param[out] count Number of entries in the returned table.
+ *
+ * @return Table of throughput entries, one per baud rate.
+ *****************************************************************************/
+const CDC_Throughput_TypeDef *CDC_GetThroughput(int *count)
+{
+  *count = cdcThroughputCount;
+  return cdcThroughput;
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Check whether the device may enter EM2.
+ *
+ * @details
+ *   True while the USB stack has put the USB in low power mode, on a
+ *   suspend or with VBUS off, and no UART transmit DMA is running.
+ *   Call with interrupts masked, just before entering the energy mode.
+ *
+ * @return true if EM2 may be entered, false if only EM1.
+ *****************************************************************************/
+bool CDC_SafeToEnterEM2(void)
+{
+  return !dmaTxActive && USBD_SafeToEnterEM2();
+}
+
+/** @cond DO_NOT_INCLUDE_WITH_DOXYGEN */
+
+/**************************************************************************//**
+ * @brief Arm a USB read into the next free buffer of the USB OUT ring.
+ *
+ * @note
+ *   When the ring is full no read is armed and the USB device NAKs the
+ *   host until the UART has drained a buffer. Nothing is armed while the
+ *   bus is suspended. Must be called with interrupts masked.
+ *****************************************************************************/
+static void UsbRxArm(void)
+{
+  if (!usbSuspended && !usbRxActive && (usbRxPending < CDC_USB_RX_BUF_CNT)) {
+    usbRxActive = true;
+    USBD_Read(CDC_EP_DATA_OUT, (void*) USB_RX_BUF(usbRxHead),
+              CDC_USB_RX_BUF_SIZ, UsbDataReceived);
+  }
+}
+
+/**************************************************************************//**
+ * @brief Start a UART transmit DMA from the oldest received USB buffer.
+ *
+ * @note Must be called with interrupts masked.
+ *****************************************************************************/
+static void UartTxNext(void)
+{
+  if (!usbSuspended && !dmaTxActive && (usbRxPending > 0)) {
+    dmaTxActive = true;
+    DMA_ActivateBasic(CDC_UART_TX_DMA_CHANNEL,
+                      true,
+                      false,
+                      (void *) &(CDC_UART->TXDATA),
+                      (void *) USB_RX_BUF(uartTxTail),
+                      usbRxLen[uartTxTail] - 1);
+  }
+}
+
+/**************************************************************************//**
+ * @brief Callback function called whenever a new packet with data is received
+ *        on USB.
+ *
+ * @param[in] status    Transfer status code.
+ * @param[in] xferred   Number of bytes transferred.
+ * @param[in] remaining Number of bytes not transferred.
+ *
+ * @return USB_STATUS_OK.
+ *****************************************************************************/
+static int UsbDataReceived(USB_Status_TypeDef status,
+                           uint32_t xferred,
+                           uint32_t remaining)
+{
+  CORE_DECLARE_IRQ_STATE;
+  (void) remaining;            // Unused parameter.
+
+  if (status != USB_STATUS_OK) {
+    return USB_STATUS_OK;
+  }
+
+  CORE_ENTER_ATOMIC();
+
+  usbRxActive = false;
+  if (xferred > 0) {
+    // Queue the buffer for the UART, no copy is made.
+    usbRxLen[usbRxHead] = xferred;
+    usbRxHead = (usbRxHead + 1) % CDC_USB_RX_BUF_CNT;
+    usbRxPending++;
+    usbToUartTotal += xferred;
+    UartTxNext();
+  }
+
+  // Read the next packet while the UART is busy, if there is room.
+  UsbRxArm();
+
+  CORE_EXIT_ATOMIC();
+  return USB_STATUS_OK;
+}
+
+/**************************************************************************//**
+ * @brief Callback function called whenever a UART transmit DMA has completed.
+ *
+ * @param[in] channel The DMA channel that finished.
+ * @param[in] primary Primary or alternate DMA descriptor.
+ * @param[in] user    User defined pointer (not used).
+ *****************************************************************************/
+static void DmaTxComplete(unsigned int channel, bool primary, void *user)
+{
+  CORE_DECLARE_IRQ_STATE;
+  (void) channel;              // Unused parameter.
+  (void) primary;              // Unused parameter.
+  (void) user;                 // Unused parameter.
+
+  /*
+   * As nested interrupts may occur and we rely on variables usbRxActive
+   * and dmaTxActive etc, we must handle this function as a critical region.
+   */
+  CORE_ENTER_ATOMIC();
+
+  // The buffer has been sent, give it back to the USB OUT ring.
+  uartTxTail = (uartTxTail + 1) % CDC_USB_RX_BUF_CNT;
+  usbRxPending--;
+  dmaTxActive = false;
+
+  UartTxNext();
+  UsbRxArm();
+
+  CORE_EXIT_ATOMIC();
+}
+
+/**************************************************************************//**
+ * @brief Send the oldest filled UART buffer over USB.
+ *
+ * @note
+ *   A transfer that is a multiple of the ep size is followed by a zero
+ *   length packet when nothing else is waiting, so the host sees the end
+ *   of the data. Must be called with interrupts masked.
+ *****************************************************************************/
+static void UsbTxNext(void)
+{
+  if (usbSuspended || usbTxActive) {
+    return;
+  }
+
+  if (uartRxPending > 0) {
+    usbTxActive = true;
+    usbTxZlp = false;
+    lastUsbTxCnt = uartRxLen[usbTxTail];
+    usbTxWriteTotal++;
+    USBD_Write(CDC_EP_DATA_IN, (void*) UART_RX_BUF(usbTxTail),
+               lastUsbTxCnt, UsbDataTransmitted);
+  } else if ((lastUsbTxCnt > 0) && ((lastUsbTxCnt % CDC_BULK_EP_SIZE) == 0)) {
+    usbTxActive = true;
+    usbTxZlp = true;
+    lastUsbTxCnt = 0;
+    USBD_Write(CDC_EP_DATA_IN, NULL, 0, UsbDataTransmitted);
+  }
+}
+
+/**************************************************************************//**
+ * @brief Get a descriptor of the UART RX DMA channel.
+ *
+ * @param[in] primary Primary or alternate descriptor.
+ *
+ * @return Pointer to the descriptor in the DMA control block.
+ *****************************************************************************/
+static DMA_DESCRIPTOR_TypeDef *UartRxDescriptor(bool primary)
+{
+  DMA_DESCRIPTOR_TypeDef *base;
+
+  base = (DMA_DESCRIPTOR_TypeDef *) (primary ? DMA->CTRLBASE : DMA->ALTCTRLBASE);
+  return &base[CDC_UART_RX_DMA_CHANNEL];
+}
+
+/**************************************************************************//**
+ * @brief Get the number of chars the UART RX DMA has put in the head buffer.
+ *
+ * @details
+ *   The DMA writes the remaining count back to the descriptor after each
+ *   char and marks the descriptor invalid once the buffer is full.
+ *
+ * @return Number of bytes in the head buffer.
+ *****************************************************************************/
+static uint32_t UartRxCount(void)
+{
+  uint32_t ctrl = UartRxDescriptor(uartRxPrimary)->CTRL;
+
+  if ((ctrl & _DMA_CTRL_CYCLE_CTRL_MASK) == DMA_CTRL_CYCLE_CTRL_INVALID) {
+    return CDC_USB_TX_BUF_SIZ;
+  }
+  return CDC_USB_TX_BUF_SIZ - 1
+         - ((ctrl & _DMA_CTRL_N_MINUS_1_MASK) >> _DMA_CTRL_N_MINUS_1_SHIFT);
+}
+
+/**************************************************************************//**
+ * @brief Keep the UART RX DMA running into the UART RX ring.
+ *
+ * @details
+ *   In ping-pong mode the DMA switches to the other descriptor by itself
+ *   when the head buffer is full, so it moves from one buffer to the next
+ *   without waiting for the CPU. The other descriptor is only set up while
+ *   the next buffer is free. Otherwise it is left invalid and the DMA stops
+ *   at the end of the head buffer instead of running into a buffer still
+ *   waiting for USB; the descriptor is set up when USB has sent a buffer.
+ *
+ * @note Must be called with interrupts masked.
+ *****************************************************************************/
+static void UartRxRun(void)
+{
+  int next = (uartRxHead + 1) % CDC_USB_TX_BUF_CNT;
+
+  if (usbSuspended) {
+    return;
+  }
+
+  if (!dmaRxActive && (uartRxPending < CDC_USB_TX_BUF_CNT)) {
+    dmaRxActive = true;
+    uartRxLastCount = 0;
+    uartRxPrimary = true;
+    uartRxNextArmed = (uartRxPending < CDC_USB_TX_BUF_CNT - 1);
+    DMA_ActivatePingPong(CDC_UART_RX_DMA_CHANNEL,
+                         false,
+                         (void *) UART_RX_BUF(uartRxHead),
+                         (void *) &(CDC_UART->RXDATA),
+                         CDC_USB_TX_BUF_SIZ - 1,
+                         (void *) UART_RX_BUF(next),
+                         (void *) &(CDC_UART->RXDATA),
+                         CDC_USB_TX_BUF_SIZ - 1);
+    if (!uartRxNextArmed) {
+      // Only one free buffer, the DMA reads the alternate descriptor when
+      // the primary one is done and stops there
+      UartRxDescriptor(false)->CTRL &= ~_DMA_CTRL_CYCLE_CTRL_MASK;
+    }
+  } else if (dmaRxActive && !uartRxNextArmed
+             && (uartRxPending < CDC_USB_TX_BUF_CNT - 1)) {
+    // The next buffer is free now, let the DMA carry on into it
+    uartRxNextArmed = true;
+    DMA_RefreshPingPong(CDC_UART_RX_DMA_CHANNEL,
+                        !uartRxPrimary,
+                        false,
+                        (void *) UART_RX_BUF(next),
+                        (void *) &(CDC_UART->RXDATA),
+                        CDC_USB_TX_BUF_SIZ - 1,
+                        false);
+  }
+}
+
+/**************************************************************************//**
+ * @brief Deassert RTS so the far end stops sending.
+ *****************************************************************************/
+static void UartRtsHold(void)
+{
+#if CDC_FLOW_CONTROL
+  GPIO_PinOutSet(CDC_UART_RTS_PORT, CDC_UART_RTS_PIN);
+#endif
+  uartRtsHeld = true;
+}
+
+/**************************************************************************//**
+ * @brief Drive RTS from the number of UART RX buffers waiting for USB.
+ *
+ * @details
+ *   RTS is deasserted at the high water mark while there is still at least
+ *   one free buffer, so chars the far end sends before it reacts are not
+ *   lost. It is asserted again once USB has drained the ring down to the
+ *   low water mark. Without flow control this only records the state.
+ *
+ * @note Must be called with interrupts masked.
+ *****************************************************************************/
+static void UartRtsUpdate(void)
+{
+  if (!uartRtsHeld && (uartRxPending >= CDC_RX_HIGH_WATER)) {
+    UartRtsHold();
+    rtsHoldTotal++;
+  } else if (uartRtsHeld && (uartRxPending <= CDC_RX_LOW_WATER)) {
+#if CDC_FLOW_CONTROL
+    GPIO_PinOutClear(CDC_UART_RTS_PORT, CDC_UART_RTS_PIN);
+#endif
+    uartRtsHeld = false;
+  }
+}
+
+/**************************************************************************//**
+ * @brief Hand the head buffer of the UART RX ring over to USB.
+ *
+ * @param[in] count Number of bytes in the buffer.
+ *
+ * @note Must be called with interrupts masked.
+ *****************************************************************************/
+static void UartRxBufferDone(uint32_t count)
+{
+  uartRxLen[uartRxHead] = count;
+  uartRxHead = (uartRxHead + 1) % CDC_USB_TX_BUF_CNT;
+  uartRxPending++;
+  uartRxLastCount = 0;
+  uartRxIdle = 0;
+  uartToUsbTotal += count;
+
+  UartRtsUpdate();
+
+  // Full buffers mean bulk traffic, small ones interactive traffic
+  uartRxFillAvg += ((int32_t)(count * 256 / CDC_USB_TX_BUF_SIZ) - uartRxFillAvg)
+                   >> CDC_RX_AVG_SHIFT;
+}
+
+/**************************************************************************//**
+ * @brief Callback function called whenever a packet with data has been
+ *        transmitted on USB
+ *
+ * @param[in] status    Transfer status code.
+ * @param[in] xferred   Number of bytes transferred.
+ * @param[in] remaining Number of bytes not transferred.
+ *
+ * @return USB_STATUS_OK.
+ *****************************************************************************/
+static int UsbDataTransmitted(USB_Status_TypeDef status,
+                              uint32_t xferred,
+                              uint32_t remaining)
+{
+  CORE_DECLARE_IRQ_STATE;
+  (void) xferred;              // Unused parameter.
+  (void) remaining;            // Unused parameter.
+
+  if (status != USB_STATUS_OK) {
+    return USB_STATUS_OK;
+  }
+
+  CORE_ENTER_ATOMIC();
+
+  usbTxActive = false;
+  if (!usbTxZlp) {
+    // The buffer has been sent, give it back to the UART RX ring.
+    usbTxTail = (usbTxTail + 1) % CDC_USB_TX_BUF_CNT;
+    uartRxPending--;
+    UartRtsUpdate();
+  }
+
+  UartRxRun();
+  UsbTxNext();
+
+  CORE_EXIT_ATOMIC();
+  return USB_STATUS_OK;
+}
+
+/**************************************************************************//**
+ * @brief Callback function called whenever a UART receive DMA has filled a
+ *        buffer.
+ *
+ * @param[in] channel The DMA channel that finished.
+ * @param[in] primary Primary or alternate DMA descriptor.
+ * @param[in] user    User defined pointer (not used).
+ *****************************************************************************/
+static void DmaRxComplete(unsigned int channel, bool primary, void *user)
+{
+  CORE_DECLARE_IRQ_STATE;
+  (void) user;                 // Unused parameter.
+
+  /*
+   * As nested interrupts may occur and we rely on variables usbTxActive
+   * and dmaRxActive etc, we must handle this function as a critical region.
+   */
+  CORE_ENTER_ATOMIC();
+
+  UartRxBufferDone(CDC_USB_TX_BUF_SIZ);
+
+  // The DMA is still running if the other descriptor was set up in time.
+  if (uartRxNextArmed && DMA_ChannelEnabled(channel)) {
+    uartRxPrimary = !primary;
+    uartRxNextArmed = false;
+  } else {
+    dmaRxActive = false;
+    if (uartRxPending == CDC_USB_TX_BUF_CNT) {
+      // Ring full, the UART is not read until USB catches up.
+      rxStallTotal++;
+    }
+  }
+
+  UartRxRun();
+  UsbTxNext();
+
+  CORE_EXIT_ATOMIC();
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Get how long the line must be idle before a partial buffer is sent.
+ *
+ * @details
+ *   Sparse traffic, such as a person typing, leaves the buffers nearly empty
+ *   and gets flushed after CDC_RX_IDLE_MIN to keep the latency low. Bulk
+ *   traffic fills whole buffers and moves the limit towards CDC_RX_TIMEOUT,
+ *   so short pauses in a burst do not split it into small USB packets. The
+ *   limit is also kept above twice the average gap seen inside bursts.
+ *
+ * @return Idle time in ms.
+ *****************************************************************************/
+static uint32_t UartRxIdleLimit(void)
+{
+  uint32_t idleMin = CDC_RX_IDLE_MIN;
+  uint32_t idleMax = CDC_RX_TIMEOUT;
+  uint32_t limit;
+
+  limit = idleMin + ((idleMax - idleMin) * (uint32_t)uartRxFillAvg) / 256;
+  limit = SL_MAX(limit, (uint32_t)uartRxGapAvg * 2 / 16);
+
+  return SL_MIN(limit, idleMax);
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Stop the UART RX DMA and send the chars received so far on USB.
+ *
+ * @note Must be called with interrupts masked.
+ *****************************************************************************/
+static void UartRxFlush(void)
+{
+  uint32_t numReceived = 0;
+  bool     running = true;
+
+  DMA_ChannelEnable(CDC_UART_RX_DMA_CHANNEL, false);
+  dmaRxActive = false;
+
+  if (DMA->IF & (1 << CDC_UART_RX_DMA_CHANNEL)) {
+    // The buffer filled up just before the DMA was stopped, any chars
+    // after that went to the following buffer.
+    DMA->IFC = 1 << CDC_UART_RX_DMA_CHANNEL;
+    UartRxBufferDone(CDC_USB_TX_BUF_SIZ);
+    running = uartRxNextArmed;
+    uartRxPrimary = !uartRxPrimary;
+  }
+  if (running) {
+    numReceived = UartRxCount();
+  }
+  if (numReceived > 0) {
+    UartRxBufferDone(numReceived);
+  }
+
+  UartRxRun();
+  UsbTxNext();
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Called each CDC_RX_TICK ms.
+ *   Implements UART Rx rate monitoring, i.e. we must behave differently when
+ *   UART Rx rate is slow e.g. when a person is typing characters, and when UART
+ *   Rx rate is maximum.
+ *****************************************************************************/
+static void UartRxTimeout(void)
+{
+  CORE_DECLARE_IRQ_STATE;
+  uint32_t numReceived;
+
+  CORE_ENTER_ATOMIC();
+
+  if (dmaRxActive) {
+    numReceived = UartRxCount();
+
+    if (numReceived != uartRxLastCount) {
+      // New chars, a gap inside the current burst has ended
+      if (uartRxIdle > 0) {
+        uartRxGapAvg += ((int32_t)(uartRxIdle * 16) - uartRxGapAvg)
+                        >> CDC_RX_AVG_SHIFT;
+      }
+      uartRxIdle = 0;
+      uartRxLastCount = numReceived;
+    } else if (numReceived > 0) {
+      uartRxIdle += CDC_RX_TICK;
+      if (uartRxIdle >= UartRxIdleLimit()) {
+        /*
+         * There is curently no activity on UART Rx but some chars have been
+         * received. Stop DMA and transmit the chars we have got so far on USB.
+         */
+        UartRxFlush();
+      }
+    }
+  }
+
+  CORE_EXIT_ATOMIC();
+
+  // Restart timer to continue monitoring.
+  USBTIMER_Start(CDC_TIMER_ID, CDC_RX_TICK, UartRxTimeout);
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Called once per CDC_STATS_PERIOD. Records the bytes moved in each
+ *   direction during the last period against the current baud rate.
+ *****************************************************************************/
+static void StatsTimeout(void)
+{
+  CDC_Throughput_TypeDef *entry = NULL;
+  uint32_t toUsb, toUart, stalls, writes, holds;
+  int i;
+
+  toUsb  = uartToUsbTotal - uartToUsbLast;
+  toUart = usbToUartTotal - usbToUartLast;
+  stalls = rxStallTotal - rxStallLast;
+  uartToUsbLast = uartToUsbTotal;
+  usbToUartLast = usbToUartTotal;
+  rxStallLast   = rxStallTotal;
+  writes = usbTxWriteTotal - usbTxWriteLast;
+  usbTxWriteLast = usbTxWriteTotal;
+  holds = rtsHoldTotal - rtsHoldLast;
+  rtsHoldLast = rtsHoldTotal;
+
+  if ((toUsb > 0) || (toUart > 0)) {
+    // One entry per baud rate, the last entry is reused when the table is full
+    for (i = 0; i < cdcThroughputCount; i++) {
+      if (cdcThroughput[i].baudRate == cdcLineCoding.dwDTERate) {
+        entry = &cdcThroughput[i];
+        break;
+      }
+    }
+    if (entry == NULL) {
+      if (cdcThroughputCount < CDC_THROUGHPUT_RATES) {
+        cdcThroughputCount++;
+      }
+      entry = &cdcThroughput[cdcThroughputCount - 1];
+      memset(entry, 0, sizeof(*entry));
+      entry->baudRate = cdcLineCoding.dwDTERate;
+    }
+
+    entry->seconds++;
+    entry->uartToUsbBytes += toUsb;
+    entry->usbToUartBytes += toUart;
+    entry->rxStalls       += stalls;
+    entry->uartToUsbWrites += writes;
+    entry->rtsHolds       += holds;
+    entry->uartToUsbPeak   = SL_MAX(entry->uartToUsbPeak, toUsb * 1000 / CDC_STATS_PERIOD);
+    entry->usbToUartPeak   = SL_MAX(entry->usbToUartPeak, toUart * 1000 / CDC_STATS_PERIOD);
+
+    // Count UART receive overflows, bytes lost while the RX ring was full
+    if (CDC_UART->IF & USART_IF_RXOF) {
+      USART_IntClear(CDC_UART, USART_IF_RXOF);
+      entry->rxOverflows++;
+    }
+  }
+
+  USBTIMER_Start(CDC_STATS_TIMER_ID, CDC_STATS_PERIOD, StatsTimeout);
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Pause the bridge when the bus is suspended.
+ *
+ * @details
+ *   The far end is told to stop sending and the chars already received are
+ *   kept in the UART RX ring, to be sent after the resume. A UART transmit
+ *   in progress is left to finish, no new one is started. The rings and
+ *   the endpoint transfers are left as they are.
+ *****************************************************************************/
+static void CdcSuspend(void)
+{
+  CORE_DECLARE_IRQ_STATE;
+
+  USBTIMER_Stop(CDC_TIMER_ID);
+  USBTIMER_Stop(CDC_STATS_TIMER_ID);
+
+  CORE_ENTER_ATOMIC();
+
+  usbSuspended = true;
+  UartRtsHold();
+  if (dmaRxActive) {
+    UartRxFlush();
+  }
+
+  CORE_EXIT_ATOMIC();
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Restart the bridge from where it was paused by CdcSuspend().
+ *****************************************************************************/
+static void CdcResume(void)
+{
+  CORE_DECLARE_IRQ_STATE;
+
+  CORE_ENTER_ATOMIC();
+
+  usbSuspended = false;
+  UartRxRun();
+  UartRtsUpdate();
+  UartTxNext();
+  UsbRxArm();
+  UsbTxNext();
+
+  CORE_EXIT_ATOMIC();
+
+  USBTIMER_Start(CDC_TIMER_ID, CDC_RX_TICK, UartRxTimeout);
+  USBTIMER_Start(CDC_STATS_TIMER_ID, CDC_STATS_PERIOD, StatsTimeout);
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Callback function called when the data stage of a CDC_SET_LINECODING
+ *   setup command has completed.
+ *
+ * @param[in] status    Transfer status code.
+ * @param[in] xferred   Number of bytes transferred.
+ * @param[in] remaining Number of bytes not transferred.
+ *
+ * @return USB_STATUS_OK if data accepted.
+ *         USB_STATUS_REQ_ERR if data calls for modes we can not support.
+ *****************************************************************************/
+static int LineCodingReceived(USB_Status_TypeDef status,
+                              uint32_t xferred,
+                              uint32_t remaining)
+{
+  uint32_t frame = 0;
+  (void) remaining;
+
+  // We have received new serial port communication settings from USB host.
+  if ((status == USB_STATUS_OK) && (xferred == 7)) {
+    // Check bDataBits, valid values are: 5, 6, 7, 8 or 16 bits.
+    if (cdcLineCoding.bDataBits == 5) {
+      frame |= USART_FRAME_DATABITS_FIVE;
+    } else if (cdcLineCoding.bDataBits == 6) {
+      frame |= USART_FRAME_DATABITS_SIX;
+    } else if (cdcLineCoding.bDataBits == 7) {
+      frame |= USART_FRAME_DATABITS_SEVEN;
+    } else if (cdcLineCoding.bDataBits == 8) {
+      frame |= USART_FRAME_DATABITS_EIGHT;
+    } else if (cdcLineCoding.bDataBits == 16) {
+      frame |= USART_FRAME_DATABITS_SIXTEEN;
+    } else {
+      return USB_STATUS_REQ_ERR;
+    }
+
+    // Check bParityType, valid values are: 0=None 1=Odd 2=Even 3=Mark 4=Space
+    if (cdcLineCoding.bParityType == 0) {
+      frame |= USART_FRAME_PARITY_NONE;
+    } else if (cdcLineCoding.bParityType == 1) {
+      frame |= USART_FRAME_PARITY_ODD;
+    } else if (cdcLineCoding.bParityType == 2) {
+      frame |= USART_FRAME_PARITY_EVEN;
+    } else if (cdcLineCoding.bParityType == 3) {
+      return USB_STATUS_REQ_ERR;
+    } else if (cdcLineCoding.bParityType == 4) {
+      return USB_STATUS_REQ_ERR;
+    } else {
+      return USB_STATUS_REQ_ERR;
+    }
+
+    // Check bCharFormat, valid values are: 0=1 1=1.5 2=2 stop bits
+    if (cdcLineCoding.bCharFormat == 0) {
+      frame |= USART_FRAME_STOPBITS_ONE;
+    } else if (cdcLineCoding.bCharFormat == 1) {
+      frame |= USART_FRAME_STOPBITS_ONEANDAHALF;
+    } else if (cdcLineCoding.bCharFormat == 2) {
+      frame |= USART_FRAME_STOPBITS_TWO;
+    } else {
+      return USB_STATUS_REQ_ERR;
+    }
+
+    // Program new UART baudrate etc.
+    CDC_UART->FRAME = frame;
+    USART_BaudrateAsyncSet(CDC_UART, 0, cdcLineCoding.dwDTERate, usartOVS16);
+
+    return USB_STATUS_OK;
+  }
+  return USB_STATUS_REQ_ERR;
+}
+
+/**************************************************************************//**
+ * @brief Initialize the DMA peripheral.
+ *****************************************************************************/
+static void DmaSetup(void)
+{
+  DMA_Init_TypeDef       dmaInit;
+  DMA_CfgChannel_TypeDef chnlCfg;
+  DMA_CfgDescr_TypeDef   descrCfg;
+
+  // DMA initialization
+  dmaInit.hprot        = 0;
+  dmaInit.controlBlock = dmaControlBlock; // Make sure control block is properly aligned
+  DMA_Init(&dmaInit);
+
+  /*---------- Configure DMA channel for UART Tx. ----------*/
+
+  // Setup the interrupt callback routine
+  dmaCallbackTx.cbFunc  = DmaTxComplete;
+  dmaCallbackTx.userPtr = NULL;
+
+  // Channel configuration and trigger selection
+  chnlCfg.highPri   = false;
+  chnlCfg.enableInt = true;
+  chnlCfg.select    = CDC_TX_DMA_SIGNAL;
+  chnlCfg.cb        = &dmaCallbackTx;
+  DMA_CfgChannel(CDC_UART_TX_DMA_CHANNEL, &chnlCfg);
+
+  // Channel descriptor configuration, the source and count are set for
+  // each buffer of the USB OUT ring
+  descrCfg.dstInc  = dmaDataIncNone;
+  descrCfg.srcInc  = dmaDataInc1;
+  descrCfg.size    = dmaDataSize1;
+  descrCfg.arbRate = dmaArbitrate1;
+  descrCfg.hprot   = 0;
+  DMA_CfgDescr(CDC_UART_TX_DMA_CHANNEL, true, &descrCfg);
+
+  /*---------- Configure DMA channel for UART Rx. ----------*/
+
+  // Setup the interrupt callback routine
+  dmaCallbackRx.cbFunc  = DmaRxComplete;
+  dmaCallbackRx.userPtr = NULL;
+
+  // Channel configuration and trigger selection, high priority so a long
+  // UART TX transfer never delays a received char
+  chnlCfg.highPri   = true;
+  chnlCfg.enableInt = true;
+  chnlCfg.select    = CDC_RX_DMA_SIGNAL;
+  chnlCfg.cb        = &dmaCallbackRx;
+  DMA_CfgChannel(CDC_UART_RX_DMA_CHANNEL, &chnlCfg);
+
+  // Both descriptors take one char per request and take turns on the
+  // buffers of the UART RX ring
+  descrCfg.dstInc  = dmaDataInc1;
+  descrCfg.srcInc  = dmaDataIncNone;
+  descrCfg.size    = dmaDataSize1;
+  descrCfg.arbRate = dmaArbitrate1;
+  descrCfg.hprot   = 0;
+  DMA_CfgDescr(CDC_UART_RX_DMA_CHANNEL, true, &descrCfg);
+  DMA_CfgDescr(CDC_UART_RX_DMA_CHANNEL, false, &descrCfg);
+}
+
+/**************************************************************************//**
+ * @brief Initialize the UART peripheral.
+ *****************************************************************************/
+static void SerialPortInit(void)
+{
+  USART_InitAsync_TypeDef init  = USART_INITASYNC_DEFAULT;
+
+  // Enable GPIO clock.
+  CMU_ClockEnable(cmuClock_GPIO, true);
+  
+  // To avoid false start, configure output as high.
+  GPIO_PinModeSet(CDC_UART_TX_PORT, CDC_UART_TX_PIN, gpioModePushPull, 1);
+  GPIO_PinModeSet(CDC_UART_RX_PORT, CDC_UART_RX_PIN, gpioModeInput, 0);
+
+#if CDC_FLOW_CONTROL
+  // RTS starts deasserted until the device is configured.
+  GPIO_PinModeSet(CDC_UART_RTS_PORT, CDC_UART_RTS_PIN, gpioModePushPull, 1);
+#endif
+
+  // Enable DK mainboard RS232/UART switch.
+  CDC_ENABLE_DK_UART_SWITCH();
+
+  // Enable peripheral clocks.
+  CMU_ClockEnable(cmuClock_HFPER, true);
+  CMU_ClockEnable(CDC_UART_CLOCK, true);
+
+  // Configure UART for basic async operation.
+  init.enable = usartDisable;
+  USART_InitAsync(CDC_UART, &init);
+
+  // Enable Tx/Rx pins and set correct UART location.
+  CDC_UART->ROUTE = CDC_UART_ROUTE;
+
+  // Finally enable it
+  USART_Enable(CDC_UART, usartEnable);
+}
+
+/** @endcond */
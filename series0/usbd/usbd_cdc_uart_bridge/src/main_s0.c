@@ -43,6 +43,7 @@
 #include "em_gpio.h"
 #include "em_chip.h"
 #include "em_emu.h"
+#include "em_core.h"
 
 // USB specific includes
 #include "em_usb.h"
@@ -62,7 +63,7 @@ int main(void)
   // (Setup the DMA and USART pins)
   CDC_Init();
 
-  // Set the callback functions (see Drivers/cdc.c)
+  // Set the callback functions (see src/cdc_s0.c)
   const USBD_Callbacks_TypeDef callbacks = {
     .usbReset        = NULL,
     .usbStateChange  = CDC_StateChangeEvent, // Called when the device changes state
@@ -91,9 +92,18 @@ int main(void)
   // USBTIMER_DelayMs( 1000 );
   // USBD_Connect();
 
-  // Enter EM1 to save energy
+  // Enter EM2 while the USB is in low power mode (suspended or VBUS off),
+  // EM1 otherwise. Interrupts are masked from the check until the core
+  // sleeps, so a resume in between wakes it at once.
   while (1) {
-    EMU_EnterEM1();
+    CORE_DECLARE_IRQ_STATE;
+    CORE_ENTER_CRITICAL();
+    if (CDC_SafeToEnterEM2()) {
+      EMU_EnterEM2(true);
+    } else {
+      EMU_EnterEM1();
+    }
+    CORE_EXIT_CRITICAL();
   }
 }
 
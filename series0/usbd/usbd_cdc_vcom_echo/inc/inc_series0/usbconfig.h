@@ -51,6 +51,9 @@ extern "C" {
 // (clocked by 32 kHz clock) whenever the USB enters suspend mode. If ONVBUSOFF is set, the
 // USB controller will automatically enter low power mode whenever power is lost
 // on VBUS. This requires that the USB regulator is used and that VREGI is connected to VBUS.
+// In low power mode the USB clocks are gated and USBD_SafeToEnterEM2() returns true, the
+// main loop then enters EM2. The USB core keeps its endpoint state, so on resume the stack
+// restores the 48 MHz clock and the transfers set up before the suspend carry on.
 // Needed for emusb/em_usbd.c and emusb/em_usbdint.c
 #define USB_PWRSAVE_MODE (USB_PWRSAVE_MODE_ONSUSPEND | USB_PWRSAVE_MODE_ONVBUSOFF)
 
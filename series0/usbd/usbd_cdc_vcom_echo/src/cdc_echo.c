@@ -236,8 +236,12 @@ void cdcStateChangeEvent(USBD_State_TypeDef oldState, USBD_State_TypeDef newStat
   // If the USB device was configured
   if (newState == USBD_STATE_CONFIGURED) {
 
-    // If we transitioned from the suspended state to the configured state due to bus activity
-    if (oldState == USBD_STATE_SUSPENDED) {} // Currently does nothing
+    // If we transitioned from the suspended state to the configured state due
+    // to bus activity, the transfers set up before the suspend are still in
+    // place and the echo carries on where it was left
+    if (oldState == USBD_STATE_SUSPENDED) {
+      return;
+    }
 
     // Initially, we are waiting to receive data from the USB host over USB
     usbTxActive = false;
@@ -250,9 +254,10 @@ void cdcStateChangeEvent(USBD_State_TypeDef oldState, USBD_State_TypeDef newStat
   else if ((oldState == USBD_STATE_CONFIGURED) && (newState != USBD_STATE_SUSPENDED)) {
     // Currently nothing is done here
   }
-  // Else if we have been suspended
+  // Else if we have been suspended, the USB stack gates the USB clocks and
+  // the main loop enters EM2 (see USB_PWRSAVE_MODE in usbconfig.h)
   else if (newState == USBD_STATE_SUSPENDED) {
-    // Currently nothing is done here
+    // Nothing to pause, the echo only runs on USB
   }
 }
 
@@ -0,0 +1,89 @@
+/***************************************************************************//**
+ * @file adcscanring.h
+ *
+ * @brief Continuous ADC scan into a looped LDMA ring, unpacked by scan ID
+ * into one FIFO per channel.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2020 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ******************************************************************************/
+
+#ifndef ADCSCANRING_H
+#define ADCSCANRING_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "em_device.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// LDMA channel that empties the scan FIFO
+#define ADCSR_LDMA_CHANNEL    0
+
+// Largest ring, two descriptors of at most 2048 words each
+#define ADCSR_MAX_RING        4096
+
+// Most channels unpacked, one per scan input
+#define ADCSR_MAX_CHANNELS    8
+
+// Results held per channel until ADCSR_Read(), a power of 2
+#ifndef ADCSR_CHANNEL_SIZE
+#define ADCSR_CHANNEL_SIZE    64
+#endif
+
+#if (ADCSR_CHANNEL_SIZE & (ADCSR_CHANNEL_SIZE - 1)) != 0
+#error "ADCSR_CHANNEL_SIZE must be a power of 2"
+#endif
+
+// SCANDATAX word: the scan input ID above the conversion result
+#define ADCSR_ID(word)        (((word) & _ADC_SCANDATAX_SCANINPUTID_MASK) \
+                               >> _ADC_SCANDATAX_SCANINPUTID_SHIFT)
+#define ADCSR_DATA(word)      ((word) & _ADC_SCANDATAX_DATA_MASK)
+
+// Results lost, all counters only ever count up
+typedef struct {
+  uint32_t halvesDropped;     // Ring halves overwritten before unpacking
+  uint32_t fifoOverflows;     // ADC scan FIFO overflows (SCANOF)
+  uint32_t unknownIds;        // Results with an ID not given to ADCSR_Init()
+  uint32_t channelOverruns[ADCSR_MAX_CHANNELS]; // Results lost to a full
+                                                // channel FIFO
+} ADCSR_Counters_t;
+
+bool ADCSR_Init(uint32_t *ring,
+                uint32_t size,
+                const uint32_t *scanIds,
+                uint32_t channels);
+void ADCSR_Stop(void);
+uint32_t ADCSR_Available(uint32_t channel);
+uint32_t ADCSR_Read(uint32_t channel, uint16_t *out, uint32_t max);
+void ADCSR_GetCounters(ADCSR_Counters_t *counters);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // ADCSCANRING_H
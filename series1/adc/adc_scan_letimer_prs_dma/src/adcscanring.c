@@ -0,0 +1,301 @@
+/***************************************************************************//**
+ * @file adcscanring.c
+ *
+ * @brief Continuous ADC scan into a looped LDMA ring, unpacked by scan ID
+ * into one FIFO per channel.
+ *
+ * Two linked LDMA descriptors move SCANDATAX words into the two halves of a
+ * ring and loop forever. The LDMA interrupt at the end of each half unpacks
+ * it: the scan input ID of every word selects the channel FIFO the result
+ * goes into. The CPU is only involved once per half ring, not per
+ * conversion.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2020 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ *******************************************************************************
+ * # Evaluation Quality
+ * This code has been minimally tested to ensure that it builds and is suitable 
+ * as a demonstration for evaluation purposes only. This code will be maintained
+ * at the sole discretion of Silicon Labs.
+ ******************************************************************************/
+
+#include <string.h>
+#include "em_device.h"
+#include "em_adc.h"
+#include "em_cmu.h"
+#include "em_ldma.h"
+
+#include "adcscanring.h"
+
+// Scan input IDs are 5 bits wide
+#define NUM_SCAN_IDS    32
+
+// idToChannel entry of an ID that is not unpacked
+#define NO_CHANNEL      0xFF
+
+static LDMA_Descriptor_t descriptors[2];
+
+static uint32_t *ringBuffer;
+static uint32_t halfSize;
+static uint32_t lastHalf;
+
+static uint8_t idToChannel[NUM_SCAN_IDS];
+static uint32_t numChannels;
+
+// One FIFO per channel; head is written in the LDMA interrupt only, tail
+// in ADCSR_Read() only. Both run freely and wrap at 2^32.
+static uint16_t fifo[ADCSR_MAX_CHANNELS][ADCSR_CHANNEL_SIZE];
+static volatile uint32_t head[ADCSR_MAX_CHANNELS];
+static volatile uint32_t tail[ADCSR_MAX_CHANNELS];
+
+static volatile ADCSR_Counters_t counters;
+
+/**************************************************************************//**
+ * @brief
+ *   Put each result of one half ring into the FIFO of its channel
+ *****************************************************************************/
+static void unpack(const uint32_t *block, uint32_t count)
+{
+  uint32_t i, ch, h;
+
+  for (i = 0; i < count; i++) {
+    ch = idToChannel[ADCSR_ID(block[i])];
+    if (ch == NO_CHANNEL) {
+      counters.unknownIds++;
+      continue;
+    }
+
+    h = head[ch];
+    if (h - tail[ch] == ADCSR_CHANNEL_SIZE) {
+      // Keep the older results, the reader is behind
+      counters.channelOverruns[ch]++;
+      continue;
+    }
+    fifo[ch][h & (ADCSR_CHANNEL_SIZE - 1)] = (uint16_t)ADCSR_DATA(block[i]);
+    head[ch] = h + 1;
+  }
+}
+
+/**************************************************************************//**
+ * @brief LDMA Handler
+ *****************************************************************************/
+void LDMA_IRQHandler(void)
+{
+  uint32_t pending = LDMA_IntGetEnabled();
+  uint32_t half;
+
+  if (pending & LDMA_IF_ERROR) {
+    __BKPT(0);
+  }
+
+  if (pending & ((1 << ADCSR_LDMA_CHANNEL) << _LDMA_IFC_DONE_SHIFT)) {
+    // Clear interrupt flag
+    LDMA_IntClear((1 << ADCSR_LDMA_CHANNEL) << _LDMA_IFC_DONE_SHIFT);
+
+    // The half the LDMA is not writing is the one just completed
+    if (LDMA->CH[ADCSR_LDMA_CHANNEL].DST < (uint32_t)(ringBuffer + halfSize)) {
+      half = 1;
+    } else {
+      half = 0;
+    }
+
+    // Both halves completed since the last interrupt, one was overwritten
+    if (half == lastHalf) {
+      counters.halvesDropped++;
+    }
+    lastHalf = half;
+
+    unpack(ringBuffer + (half * halfSize), halfSize);
+  }
+
+  if (ADC_IntGet(ADC0) & ADC_IF_SCANOF) {
+    ADC_IntClear(ADC0, ADC_IF_SCANOF);
+    counters.fifoOverflows++;
+  }
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Start emptying the ADC scan FIFO into a looped ring
+ *
+ * @details
+ *   The ADC scan must be set up, with its inputs added and the scan FIFO
+ *   data valid level (DVL) set, before calling this. The LDMA moves DVL
+ *   results per request.
+ *
+ * @param[in] ring
+ *   Ring buffer, written by the LDMA.
+ *
+ * @param[in] size
+ *   Ring size in words, even and at most ADCSR_MAX_RING; each half must be
+ *   a multiple of the DVL.
+ *
+ * @param[in] scanIds
+ *   Scan input ID of each channel, as returned by
+ *   ADC_ScanSingleEndedInputAdd().
+ *
+ * @param[in] channels
+ *   Number of channels, at most ADCSR_MAX_CHANNELS.
+ *
+ * @return
+ *   false if the arguments or the DVL do not fit.
+ *****************************************************************************/
+bool ADCSR_Init(uint32_t *ring,
+                uint32_t size,
+                const uint32_t *scanIds,
+                uint32_t channels)
+{
+  LDMA_Init_t ldmaInit = LDMA_INIT_DEFAULT;
+  LDMA_TransferCfg_t transferCfg =
+    LDMA_TRANSFER_CFG_PERIPHERAL(ldmaPeripheralSignal_ADC0_SCAN);
+  uint32_t dvl = ((ADC0->SCANCTRLX & _ADC_SCANCTRLX_DVL_MASK)
+                  >> _ADC_SCANCTRLX_DVL_SHIFT) + 1;
+  uint32_t i;
+
+  // LDMA block sizes of 1 to 4 units are encoded as the size - 1
+  if ((size == 0) || (size > ADCSR_MAX_RING) || (size % 2)
+      || (dvl > 4) || ((size / 2) % dvl)
+      || (channels == 0) || (channels > ADCSR_MAX_CHANNELS)) {
+    return false;
+  }
+
+  memset(idToChannel, NO_CHANNEL, sizeof(idToChannel));
+  for (i = 0; i < channels; i++) {
+    if (scanIds[i] >= NUM_SCAN_IDS) {
+      return false;
+    }
+    idToChannel[scanIds[i]] = (uint8_t)i;
+    head[i] = 0;
+    tail[i] = 0;
+    counters.channelOverruns[i] = 0;
+  }
+  numChannels = channels;
+
+  ringBuffer = ring;
+  halfSize = size / 2;
+  lastHalf = 1;
+  counters.halvesDropped = 0;
+  counters.fifoOverflows = 0;
+  counters.unknownIds = 0;
+
+  // Each half links to the other, interrupt when either is full
+  descriptors[0] = (LDMA_Descriptor_t)
+    LDMA_DESCRIPTOR_LINKREL_P2M_WORD(&(ADC0->SCANDATAX), ring, halfSize, 1);
+  descriptors[1] = (LDMA_Descriptor_t)
+    LDMA_DESCRIPTOR_LINKREL_P2M_WORD(&(ADC0->SCANDATAX), ring + halfSize,
+                                     halfSize, -1);
+
+  for (i = 0; i < 2; i++) {
+    descriptors[i].xfer.blockSize = dvl - 1;  // DVL results per request
+    descriptors[i].xfer.ignoreSrec = true;    // only act on DVL requests
+    descriptors[i].xfer.doneIfs = 1;
+  }
+
+  // Enable LDMA clock
+  CMU_ClockEnable(cmuClock_LDMA, true);
+
+  LDMA_Init(&ldmaInit);
+
+  // Start from an empty scan FIFO, stale results would be out of order
+  ADC0->SCANFIFOCLEAR = ADC_SCANFIFOCLEAR_SCANFIFOCLEAR;
+  ADC_IntClear(ADC0, ADC_IF_SCANOF);
+
+  LDMA_StartTransfer(ADCSR_LDMA_CHANNEL, &transferCfg, &descriptors[0]);
+
+  return true;
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Stop the LDMA transfer; results still in the channel FIFOs can be read
+ *****************************************************************************/
+void ADCSR_Stop(void)
+{
+  LDMA_StopTransfer(ADCSR_LDMA_CHANNEL);
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Number of results waiting in the FIFO of a channel
+ *****************************************************************************/
+uint32_t ADCSR_Available(uint32_t channel)
+{
+  if (channel >= numChannels) {
+    return 0;
+  }
+  return head[channel] - tail[channel];
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Take results out of the FIFO of a channel, oldest first
+ *
+ * @param[in] channel
+ *   Channel, the index into the scanIds given to ADCSR_Init().
+ *
+ * @param[out] out
+ *   Results.
+ *
+ * @param[in] max
+ *   Results that fit in out.
+ *
+ * @return
+ *   Number of results read.
+ *****************************************************************************/
+uint32_t ADCSR_Read(uint32_t channel, uint16_t *out, uint32_t max)
+{
+  uint32_t t, count, i;
+
+  count = ADCSR_Available(channel);
+  if (count > max) {
+    count = max;
+  }
+
+  t = tail[channel];
+  for (i = 0; i < count; i++) {
+    out[i] = fifo[channel][(t + i) & (ADCSR_CHANNEL_SIZE - 1)];
+  }
+
+  // Free the entries only after copying them out
+  tail[channel] = t + count;
+
+  return count;
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Copy the lost result counters
+ *****************************************************************************/
+void ADCSR_GetCounters(ADCSR_Counters_t *copy)
+{
+  uint32_t i;
+
+  copy->halvesDropped = counters.halvesDropped;
+  copy->fifoOverflows = counters.fifoOverflows;
+  copy->unknownIds = counters.unknownIds;
+  for (i = 0; i < ADCSR_MAX_CHANNELS; i++) {
+    copy->channelOverruns[i] = counters.channelOverruns[i];
+  }
+}
@@ -42,36 +42,47 @@
 #include "em_prs.h"
 #include "em_ldma.h"
 #include "em_letimer.h"
-
-// Change this to set number of samples per interrupt
-#define ADC_BUFFER_SIZE 8
+#include "adcscanring.h"
 
 // Change this to set how many samples get sent at once
 #define ADC_DVL         2
 
+// LDMA ring in words, the LDMA interrupts every RING_SIZE / 2 results
+#define RING_SIZE       256
+
 // Init to max ADC clock for Series 1 with AUXHFRCO
 #define ADC_FREQ        4000000
 
 // Desired letimer interrupt frequency (in Hz)
 #define letimerDesired  1000
 
-#define LDMA_CHANNEL    0
 #define PRS_CHANNEL     0
 
-// Buffer for ADC single and scan conversion
-uint32_t adcBuffer[ADC_BUFFER_SIZE];
+// Scan inputs and the input group each one is added to
+typedef struct {
+  ADC_ScanInputGroup_TypeDef group;
+  ADC_PosSel_TypeDef input;
+} ScanInput_t;
 
-LDMA_TransferCfg_t trans;
-LDMA_Descriptor_t descr;
+#define NUM_INPUTS      2
 
-/**************************************************************************//**
- * @brief LDMA Handler
- *****************************************************************************/
-void LDMA_IRQHandler(void)
-{
-  // Clear interrupt flag
-  LDMA_IntClear((1 << LDMA_CHANNEL) << _LDMA_IFC_DONE_SHIFT);
-}
+static const ScanInput_t scanInputs[NUM_INPUTS] = {
+  { adcScanInputGroup0, adcPosSelAPORT4YCH10 },
+  { adcScanInputGroup1, adcPosSelAPORT4XCH11 },
+};
+
+// Scan input ID of each input, the ADC tags its results with it
+static uint32_t scanIds[NUM_INPUTS];
+
+// Scan results, written continuously by the LDMA
+static uint32_t scanRing[RING_SIZE];
+
+// Latest result and number of results read of each input
+static volatile uint16_t latest[NUM_INPUTS];
+static volatile uint32_t resultCount[NUM_INPUTS];
+
+// Results lost, see adcscanring.h
+static volatile ADCSR_Counters_t lostResults;
 
 /**************************************************************************//**
  * @brief LETIMER initialization
@@ -114,39 +125,6 @@ void initLetimer(void)
       PRS_CH_CTRL_SIGSEL_LETIMER0CH0);
 }
 
-/**************************************************************************//**
- * @brief LDMA initialization
- *****************************************************************************/
-void initLdma(void)
-{
-  // Enable LDMA clock
-  CMU_ClockEnable(cmuClock_LDMA, true);
-
-  // Basic LDMA configuration
-  LDMA_Init_t ldmaInit = LDMA_INIT_DEFAULT;
-
-  LDMA_Init(&ldmaInit);
-
-  // Transfer triggers on ADC Scan conversion complete
-  trans = (LDMA_TransferCfg_t)LDMA_TRANSFER_CFG_PERIPHERAL(ldmaPeripheralSignal_ADC0_SCAN);
-
-  descr = (LDMA_Descriptor_t)LDMA_DESCRIPTOR_LINKREL_P2M_WORD(
-      &(ADC0->SCANDATA),  // source
-      adcBuffer,          // destination
-      ADC_BUFFER_SIZE,    // data transfer size
-      0);                 // link relative offset (links to self)
-
-  descr.xfer.blockSize =ADC_DVL-1;    // transfers ADC_DVL number of units per arbitration cycle
-  descr.xfer.ignoreSrec = true; // ignores single requests to reduce energy usage
-
-  // Initialize LDMA transfer
-  LDMA_StartTransfer(LDMA_CHANNEL, &trans, &descr);
-
-  // Clear pending and enable interrupts for channel
-  NVIC_ClearPendingIRQ(LDMA_IRQn);
-  NVIC_EnableIRQ(LDMA_IRQn);
-}
-
 /**************************************************************************//**
  * @brief ADC initialization
  *****************************************************************************/
@@ -155,6 +133,7 @@ void initAdc(void)
   // Declare init structs
   ADC_Init_TypeDef init = ADC_INIT_DEFAULT;
   ADC_InitScan_TypeDef initScan = ADC_INITSCAN_DEFAULT;
+  uint32_t i;
 
   // Enable ADC clock
   CMU_ClockEnable(cmuClock_ADC0, true);
@@ -171,10 +150,12 @@ void initAdc(void)
   // Let the ADC enable its clock on demand in EM2
   init.em2ClockConfig = adcEm2ClockOnDemand;
 
-  // Add external ADC input to scan. See README for corresponding EXP header pin.
+  // Add external ADC inputs to scan. See README for corresponding EXP header pin.
   // *Note that internal channels are unavailable in ADC scan mode
-  ADC_ScanSingleEndedInputAdd(&initScan, adcScanInputGroup0, adcPosSelAPORT4YCH10);
-  ADC_ScanSingleEndedInputAdd(&initScan, adcScanInputGroup1, adcPosSelAPORT4XCH11);
+  for (i = 0; i < NUM_INPUTS; i++) {
+    scanIds[i] = ADC_ScanSingleEndedInputAdd(&initScan, scanInputs[i].group,
+                                             scanInputs[i].input);
+  }
 
   // Basic ADC scan configuration
   initScan.diff       = false;        // single-ended
@@ -205,19 +186,37 @@ void initAdc(void)
  *****************************************************************************/
 int main(void)
 {
+  uint16_t block[ADCSR_CHANNEL_SIZE];
+  ADCSR_Counters_t counters;
+  uint32_t i, n;
+
   CHIP_Init();
 
   // Setup ADC to perform conversions via PRS
   initAdc();
-  // Setup DMA to move ADC results to user memory
-  initLdma();
+  // Setup the LDMA ring and unpack results by scan input ID
+  if (!ADCSR_Init(scanRing, RING_SIZE, scanIds, NUM_INPUTS)) {
+    __BKPT(0);
+  }
   // Set up LETIMER to trigger ADC via PRS in periodic intervals
   initLetimer();
 
   // Infinite loop
   while(1)
   {
-    // Enter EM2 until next ADC interrupt
+    // Enter EM2 until the next half of the ring is unpacked
     EMU_EnterEM2(false);
+
+    // Take the new results of each input
+    for (i = 0; i < NUM_INPUTS; i++) {
+      n = ADCSR_Read(i, block, ADCSR_CHANNEL_SIZE);
+      if (n > 0) {
+        latest[i] = block[n - 1];
+        resultCount[i] += n;
+      }
+    }
+
+    ADCSR_GetCounters(&counters);
+    lostResults = counters;
   }
 }
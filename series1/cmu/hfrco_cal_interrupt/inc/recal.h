@@ -0,0 +1,68 @@
+/***************************************************************************//**
+ * @file recal.h
+ * @brief Background recalibration of the HFRCO against the LFXO.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2021 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ******************************************************************************/
+
+#ifndef RECAL_H
+#define RECAL_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Recalibration settings
+typedef struct {
+  uint32_t frequency;   // HFRCO frequency to hold, Hz
+  uint32_t period;      // Seconds between runs while the temperature holds
+  float tempDelta;      // Temperature change since the last run that starts
+                        // a new one, degrees C
+  uint32_t deadband;    // Error left alone, ppm
+} RECAL_Config_t;
+
+#define RECAL_CONFIG_DEFAULT                                            \
+  {                                                                     \
+    19000000,             /* 19 MHz */                                  \
+    60,                   /* Run at least once a minute */              \
+    2.0f,                 /* or on a 2 degree C change */               \
+    0                     /* Hold the closest tuning */                 \
+  }
+
+bool RECAL_Start(const RECAL_Config_t *config);
+void RECAL_Stop(void);
+int32_t RECAL_GetErrorPpm(void);
+uint32_t RECAL_GetRunCount(void);
+uint32_t RECAL_GetStepCount(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // RECAL_H
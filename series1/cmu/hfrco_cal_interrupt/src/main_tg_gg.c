@@ -36,9 +36,9 @@
 
 #include "em_chip.h"
 #include "em_cmu.h"
-#include "em_cryotimer.h"
 #include "em_emu.h"
 #include "em_gpio.h"
+#include "recal.h"
 
 /*
  * Top value for the calibration down counter.  Maximum allowed is
@@ -85,44 +85,6 @@
  */
 #define DOWNCOUNT   0xFFFFF
 
-/*
- * Setup the CRYOTIMER to generate interrupts at 16-second intervals.
- * This assumes that the LFXO is already running.
- */
-void startCryo(void)
-{
-  CRYOTIMER_Init_TypeDef cryoInit = CRYOTIMER_INIT_DEFAULT;
-
-  CMU_ClockEnable(cmuClock_CRYOTIMER, true);
-
-  // Set CRYOTIMER parameters
-  cryoInit.osc = cryotimerOscLFXO;
-  cryoInit.presc = cryotimerPresc_128;
-  cryoInit.period = cryotimerPeriod_4k;
-  cryoInit.enable = true;
-
-  // Interrupt setup
-  CRYOTIMER_IntClear(CRYOTIMER_IF_PERIOD);
-  CRYOTIMER_IntEnable(CRYOTIMER_IEN_PERIOD);
-  NVIC_ClearPendingIRQ(CRYOTIMER_IRQn);
-  NVIC_EnableIRQ(CRYOTIMER_IRQn);
-
-  CRYOTIMER_Init(&cryoInit);
-}
-
-void CRYOTIMER_IRQHandler(void)
-{
-  // Clear the CRYOTIMER interrupt
-  CRYOTIMER_IntClear(CRYOTIMER_IF_PERIOD);
-
-  /*
-   * Force the write to CRYOTIMER_IFC to complete before proceeding to
-   * make sure the interrupt is not re-triggered when exiting this
-   * IRQ handler as the CRYOTIMER is in an asynchronous clock domain.
-   */
-  __DSB();
-}
-
 // Global variables used in calibration ISR
 bool tuned, lastUpGT, lastUpLT;
 uint32_t idealCount, tuningVal, prevUp, prevTuning;
@@ -326,21 +288,27 @@ int main(void)
   CMU_LFXOInit(&lfxoInit);
   CMU_OscillatorEnable(cmuOsc_LFXO, true, true);
 
-  // Start the 16-second CRYOTIMER interrupts
-  startCryo();
+  // Tune the HFRCO once at startup
+  startCal(19000000);
 
-  while(1)
+  // Do other stuff while calibration is ongoing
+  while (!tuned)
   {
-    // Wait for the CRYOTIMER interrupt
-    EMU_EnterEM1();
+    __NOP();
+  }
 
-    // Setup calibration run
-    startCal(19000000);
+  /*
+   * Keep the HFRCO tuned as the temperature drifts.  From here on the
+   * CRYOTIMER interrupt in recal.c checks the HFRCO once a minute, or
+   * sooner if the temperature moves by 2 C, and moves the tuning by
+   * one step per run.
+   */
+  RECAL_Config_t recalConfig = RECAL_CONFIG_DEFAULT;
+  RECAL_Start(&recalConfig);
 
-    // Do other stuff while calibration is ongoing
-    while (!tuned)
-    {
-      __NOP();
-    }
+  while(1)
+  {
+    // Sleep in EM1 so that the clock output remains active
+    EMU_EnterEM1();
   }
 }
@@ -0,0 +1,324 @@
+/***************************************************************************//**
+ * @file recal.c
+ * @brief Background recalibration of the HFRCO against the LFXO.
+ *
+ * @details
+ *   The CRYOTIMER interrupts once a second and is the only interrupt used.
+ *   Each tick picks up the result of the calibration run started on an
+ *   earlier tick, moves the HFRCO tuning by at most one step, and starts
+ *   the next run if one is due. A run is due after config.period ticks,
+ *   when the temperature has moved by config.tempDelta since the last
+ *   run, or straight away while the tuning is still moving.
+ *
+ *   The LFXO clocks the down counter, so a run always lasts the same time
+ *   whatever the HFRCO band, and the HFRCO clocks the up counter for the
+ *   best resolution the 20-bit counter allows. At 19 MHz a run takes
+ *   1808 LFXO ticks (55 ms) and one count is 1 ppm.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2021 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ******************************************************************************/
+
+#include <stddef.h>
+#include "em_device.h"
+#include "em_cmu.h"
+#include "em_cryotimer.h"
+#include "em_emu.h"
+#include "recal.h"
+
+// Width of the calibration counters
+#define COUNTER_MAX       0xFFFFF
+
+// Longest run, half a CRYOTIMER tick so it is done by the next one
+#define REF_TICKS_MAX     16384
+
+// Shortest run that still gives a useful resolution
+#define REF_TICKS_MIN     16
+
+#define TUNING_MAX        (_CMU_HFRCOCTRL_TUNING_MASK >> _CMU_HFRCOCTRL_TUNING_SHIFT)
+
+static RECAL_Config_t recalConfig;
+
+static uint32_t refTicks;       // LFXO ticks per run
+static uint32_t lfxoFreq;       // LFXO frequency, Hz
+static uint64_t idealScaled;    // Ideal up count * lfxoFreq
+
+static bool running;            // A run was started and is not read yet
+static uint32_t ticksSinceRun;  // CRYOTIMER ticks since the last run
+static float lastTemp;          // Temperature at the last run
+
+static int32_t lastStep;        // Step after the last run, -1, 0 or 1
+static int32_t lastError;       // Error of the last run, ppm
+static uint32_t hold;           // Error the tuning settled at, ppm
+
+static volatile int32_t errorPpm;
+static volatile uint32_t runCount;
+static volatile uint32_t stepCount;
+
+/***************************************************************************//**
+ * @brief
+ *   Read the temperature, or 0 on devices without the EMU sensor.
+ ******************************************************************************/
+static float readTemperature(void)
+{
+#if defined(_EMU_TEMP_TEMP_MASK)
+  return EMU_TemperatureGet();
+#else
+  return 0.0f;
+#endif
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Start a single run of the calibration counters.
+ ******************************************************************************/
+static void startRun(void)
+{
+  CMU_CalibrateConfig(refTicks - 1, cmuOsc_LFXO, cmuOsc_HFRCO);
+  CMU_CalibrateCont(false);
+  CMU_CalibrateStart();
+
+  running = true;
+  ticksSinceRun = 0;
+  lastTemp = readTemperature();
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Move the HFRCO tuning by one step.
+ *
+ * @param[in] step
+ *   1 to slow the HFRCO down, -1 to speed it up.
+ *
+ * @return
+ *   true if the tuning moved, false if it is at the end of its range.
+ ******************************************************************************/
+static bool stepTuning(int32_t step)
+{
+  int32_t tuning = (int32_t)CMU_OscillatorTuningGet(cmuOsc_HFRCO) + step;
+
+  if ((tuning < 0) || (tuning > (int32_t)TUNING_MAX)) {
+    return false;
+  }
+
+  CMU_OscillatorTuningSet(cmuOsc_HFRCO, (uint32_t)tuning);
+  stepCount++;
+
+  return true;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Read the last run and apply at most one tuning step.
+ *
+ * @details
+ *   A higher up count means a fast HFRCO, and a higher tuning value slows
+ *   it down. When the error changes sign after a step, the tuning has
+ *   crossed the ideal count; the step is undone if the tuning before it
+ *   was closer, and the error of the closer one is kept as the hold
+ *   level. Later runs only step again once the error grows past the hold
+ *   level and the deadband, so the tuning does not toggle between the two
+ *   values either side of the ideal count.
+ ******************************************************************************/
+static void applyRun(void)
+{
+  uint64_t upScaled = (uint64_t)CMU_CalibrateCountGet() * lfxoFreq;
+  int32_t error = (int32_t)((((int64_t)upScaled - (int64_t)idealScaled)
+                             * 1000000) / (int64_t)idealScaled);
+  uint32_t magnitude = (uint32_t)((error < 0) ? -error : error);
+  uint32_t lastMagnitude = (uint32_t)((lastError < 0) ? -lastError : lastError);
+  int32_t step = (error > 0) ? 1 : -1;
+
+  running = false;
+  errorPpm = error;
+  runCount++;
+
+  if (magnitude <= (hold + recalConfig.deadband)) {
+    // Close enough, leave the tuning alone
+    lastStep = 0;
+  } else if (lastStep == -step) {
+    // Crossed the ideal count, keep whichever tuning was closer
+    if (magnitude > lastMagnitude) {
+      stepTuning(step);
+      hold = lastMagnitude;
+    } else {
+      hold = magnitude;
+    }
+    lastStep = 0;
+  } else {
+    // Still on the same side, step towards the ideal count
+    lastStep = stepTuning(step) ? step : 0;
+    hold = 0;
+  }
+
+  lastError = error;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   CRYOTIMER interrupt, once a second.
+ ******************************************************************************/
+void CRYOTIMER_IRQHandler(void)
+{
+  float temp;
+
+  CRYOTIMER_IntClear(CRYOTIMER_IF_PERIOD);
+
+  /*
+   * Force the write to CRYOTIMER_IFC to complete before proceeding to
+   * make sure the interrupt is not re-triggered when exiting this
+   * IRQ handler as the CRYOTIMER is in an asynchronous clock domain.
+   */
+  __DSB();
+
+  ticksSinceRun++;
+
+  if (running) {
+    applyRun();
+  }
+
+  temp = readTemperature();
+
+  if ((lastStep != 0)
+      || (ticksSinceRun >= recalConfig.period)
+      || ((temp - lastTemp) >= recalConfig.tempDelta)
+      || ((lastTemp - temp) >= recalConfig.tempDelta)) {
+    startRun();
+  }
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Start recalibrating the HFRCO in the background.
+ *
+ * @details
+ *   The HFRCO must already be in the band that holds config->frequency and
+ *   the LFXO must be running. The startup search in the CMU_IRQHandler()
+ *   should have finished, this takes over the calibration counters and
+ *   turns the CALRDY interrupt off. The first run starts straight away.
+ *
+ * @param[in] config
+ *   Recalibration settings, copied.
+ *
+ * @return
+ *   false if the frequency can not be measured.
+ ******************************************************************************/
+bool RECAL_Start(const RECAL_Config_t *config)
+{
+  CRYOTIMER_Init_TypeDef cryoInit = CRYOTIMER_INIT_DEFAULT;
+
+  lfxoFreq = SystemLFXOClockGet();
+  if ((config == NULL) || (config->frequency == 0) || (lfxoFreq == 0)) {
+    return false;
+  }
+
+  recalConfig = *config;
+
+  // Longest run that keeps the up count inside the counter
+  refTicks = (uint32_t)(((uint64_t)COUNTER_MAX * lfxoFreq) / config->frequency);
+  if (refTicks > REF_TICKS_MAX) {
+    refTicks = REF_TICKS_MAX;
+  }
+  if (refTicks < REF_TICKS_MIN) {
+    return false;
+  }
+  idealScaled = (uint64_t)config->frequency * refTicks;
+
+  // The tick interrupt reads the counters, not the CALRDY interrupt
+  NVIC_DisableIRQ(CMU_IRQn);
+  CMU_IntDisable(CMU_IEN_CALRDY);
+  CMU_IntClear(CMU_IFC_CALRDY);
+  CMU_CalibrateStop();
+
+  lastStep = 0;
+  lastError = 0;
+  hold = 0;
+  errorPpm = 0;
+  runCount = 0;
+  stepCount = 0;
+
+  // One second CRYOTIMER ticks from the LFXO
+  CMU_ClockEnable(cmuClock_CRYOTIMER, true);
+  cryoInit.osc = cryotimerOscLFXO;
+  cryoInit.presc = cryotimerPresc_1;
+  cryoInit.period = cryotimerPeriod_32k;
+  cryoInit.enable = false;
+  CRYOTIMER_Init(&cryoInit);
+
+  CRYOTIMER_IntClear(CRYOTIMER_IF_PERIOD);
+  CRYOTIMER_IntEnable(CRYOTIMER_IEN_PERIOD);
+  NVIC_ClearPendingIRQ(CRYOTIMER_IRQn);
+  NVIC_EnableIRQ(CRYOTIMER_IRQn);
+
+  startRun();
+  CRYOTIMER_Enable(true);
+
+  return true;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Stop recalibrating, the tuning is left as it is.
+ ******************************************************************************/
+void RECAL_Stop(void)
+{
+  CRYOTIMER_Enable(false);
+  NVIC_DisableIRQ(CRYOTIMER_IRQn);
+  CRYOTIMER_IntDisable(CRYOTIMER_IEN_PERIOD);
+  CRYOTIMER_IntClear(CRYOTIMER_IF_PERIOD);
+  NVIC_ClearPendingIRQ(CRYOTIMER_IRQn);
+  CMU_CalibrateStop();
+  running = false;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Get the HFRCO error measured by the last run.
+ *
+ * @return
+ *   (measured - set frequency) / set frequency, ppm.
+ ******************************************************************************/
+int32_t RECAL_GetErrorPpm(void)
+{
+  return errorPpm;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Get the number of calibration runs read since RECAL_Start().
+ ******************************************************************************/
+uint32_t RECAL_GetRunCount(void)
+{
+  return runCount;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Get the number of tuning steps made since RECAL_Start().
+ ******************************************************************************/
+uint32_t RECAL_GetStepCount(void)
+{
+  return stepCount;
+}
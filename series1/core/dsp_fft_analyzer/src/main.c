@@ -0,0 +1,328 @@
+/***************************************************************************//**
+ * @file main.c
+ * @brief This project demonstrates a continuous spectrum analyzer: ADC samples
+ * arrive through LDMA ping-pong buffers and are windowed, transformed with the
+ * CMSIS DSP_lib FFT and published as a ring of magnitude spectra.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2022 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ *******************************************************************************
+ * # Evaluation Quality
+ * This code has been minimally tested to ensure that it builds and is suitable 
+ * as a demonstration for evaluation purposes only. This code will be maintained
+ * at the sole discretion of Silicon Labs.
+ ******************************************************************************/
+
+#include "em_device.h"
+#include "em_chip.h"
+#include "em_cmu.h"
+#include "em_emu.h"
+#include "em_core.h"
+#include "em_adc.h"
+#include "em_ldma.h"
+#include "em_prs.h"
+#include "em_timer.h"
+#include "arm_math.h"
+#include <math.h>
+
+// Defines size of FFT
+// Supported arm_rfft_f32 lengths are 128, 512, 2048
+#define FFTSIZE         128
+
+// Samples per LDMA ping-pong buffer; each block is analysed together with
+// the previous one, so consecutive FFT frames overlap by 50%
+#define HOPSIZE         (FFTSIZE / 2)
+
+// Defines sample frequency of input data
+// Use for calculating FFT resolution:
+// Resolution = SAMPLEFREQ / FFTSIZE
+#define SAMPLEFREQ      48000
+
+// Number of magnitude bins per spectrum, DC to SAMPLEFREQ/2
+#define NUM_BINS        (FFTSIZE / 2)
+
+// Number of spectra kept for the application
+#define NUM_SPECTRA     4
+
+#define LDMA_CHANNEL    0
+#define PRS_CHANNEL     0
+
+// ADC input, see readme for the expansion header pin
+#if defined(_EFM32_GIANT_FAMILY)
+#define ADC_INPUT       adcPosSelAPORT4XCH11
+#else
+#define ADC_INPUT       adcPosSelAPORT2XCH9
+#endif
+
+// Instance structures for float32_t RFFT
+static arm_rfft_instance_f32 rfft_instance;
+// Instance structure for float32_t CFFT used by the RFFT
+static arm_cfft_radix4_instance_f32 cfft_instance;
+
+// LDMA ping-pong buffers, 12-bit ADC results
+uint16_t adcBuffer[2][HOPSIZE];
+static LDMA_Descriptor_t descLink[2];
+
+// Last FFTSIZE samples, oldest first, and the windowed copy the RFFT
+// works on (arm_rfft_f32 overwrites its input)
+static float32_t frame[FFTSIZE];
+static float32_t fftInput[FFTSIZE];
+
+// Periodic Hann window, computed at start-up. Hann windows overlapped by
+// half their length add up to a constant, so every sample is weighted
+// equally over two consecutive frames.
+float32_t hannWindow[FFTSIZE];
+
+// Complex frequency data of the last frame
+float32_t freqBuffer[FFTSIZE * 2];
+
+// Ring of magnitude spectra, the newest is
+// spectra[(spectrumCount - 1) % NUM_SPECTRA]
+float32_t spectra[NUM_SPECTRA][NUM_BINS];
+volatile uint32_t spectrumCount;
+
+// Strongest non-DC component of the newest spectrum
+volatile float32_t peakFrequency;
+volatile float32_t peakMagnitude;
+
+// Real time statistics, all in core clock cycles
+volatile uint32_t cyclesPerBlock;
+volatile uint32_t cyclesPerBlockMax;
+volatile uint32_t cyclesBudget;
+volatile uint32_t blocksDropped;
+
+// Actual sample rate after rounding the timer period
+volatile uint32_t sampleRate;
+
+// Blocks completed by the LDMA and not yet processed
+static volatile uint32_t blocksPending;
+
+/**************************************************************************//**
+ * @brief LDMA Handler
+ *****************************************************************************/
+void LDMA_IRQHandler(void)
+{
+  uint32_t pending = LDMA_IntGet();
+
+  LDMA_IntClear(pending);
+
+  // Check for LDMA error
+  if(pending & LDMA_IF_ERROR) {
+    // Loop here to enable the debugger to see what has happened
+    while(1);
+  }
+
+  if(pending & (1 << LDMA_CHANNEL)) {
+    blocksPending++;
+  }
+}
+
+/**************************************************************************//**
+ * @brief ADC initialization, single conversions started by PRS
+ *****************************************************************************/
+void initAdc(void)
+{
+  ADC_Init_TypeDef init = ADC_INIT_DEFAULT;
+  ADC_InitSingle_TypeDef initSingle = ADC_INITSINGLE_DEFAULT;
+
+  CMU_ClockEnable(cmuClock_HFPER, true);
+  CMU_ClockEnable(cmuClock_ADC0, true);
+
+  // Run the ADC from HFPERCLK, at most 16 MHz
+  init.prescale = ADC_PrescaleCalc(16000000, 0);
+  init.timebase = ADC_TimebaseCalc(0);
+
+  initSingle.posSel     = ADC_INPUT;
+  initSingle.diff       = false;
+  initSingle.reference  = adcRef2V5;
+  initSingle.resolution = adcRes12Bit;
+  initSingle.acqTime    = adcAcqTime4;
+
+  // Start one conversion per PRS pulse
+  initSingle.prsEnable = true;
+  initSingle.prsSel    = (ADC_PRSSEL_TypeDef) PRS_CHANNEL;
+
+  ADC_Init(ADC0, &init);
+  ADC_InitSingle(ADC0, &initSingle);
+
+  ADC0->SINGLEFIFOCLEAR = ADC_SINGLEFIFOCLEAR_SINGLEFIFOCLEAR;
+}
+
+/**************************************************************************//**
+ * @brief LDMA initialization, ADC0->SINGLEDATA to the ping-pong buffers
+ *****************************************************************************/
+void initLdma(void)
+{
+  LDMA_Init_t ldmaInit = LDMA_INIT_DEFAULT;
+  LDMA_TransferCfg_t trans =
+    LDMA_TRANSFER_CFG_PERIPHERAL(ldmaPeripheralSignal_ADC0_SINGLE);
+
+  CMU_ClockEnable(cmuClock_LDMA, true);
+  LDMA_Init(&ldmaInit);
+
+  descLink[0] = (LDMA_Descriptor_t)
+    LDMA_DESCRIPTOR_LINKREL_P2M_BYTE(&ADC0->SINGLEDATA, adcBuffer[0],
+                                     HOPSIZE, 1);
+  descLink[1] = (LDMA_Descriptor_t)
+    LDMA_DESCRIPTOR_LINKREL_P2M_BYTE(&ADC0->SINGLEDATA, adcBuffer[1],
+                                     HOPSIZE, -1);
+  descLink[0].xfer.size = ldmaCtrlSizeHalf;
+  descLink[1].xfer.size = ldmaCtrlSizeHalf;
+
+  LDMA_StartTransfer(LDMA_CHANNEL, &trans, descLink);
+}
+
+/**************************************************************************//**
+ * @brief TIMER0 overflows at SAMPLEFREQ and triggers the ADC through PRS
+ *****************************************************************************/
+void initTimer(void)
+{
+  TIMER_Init_TypeDef timerInit = TIMER_INIT_DEFAULT;
+  uint32_t top;
+
+  CMU_ClockEnable(cmuClock_TIMER0, true);
+  CMU_ClockEnable(cmuClock_PRS, true);
+
+  top = (CMU_ClockFreqGet(cmuClock_TIMER0) + SAMPLEFREQ / 2) / SAMPLEFREQ;
+  sampleRate = CMU_ClockFreqGet(cmuClock_TIMER0) / top;
+
+  PRS_SourceSignalSet(PRS_CHANNEL, PRS_CH_CTRL_SOURCESEL_TIMER0,
+                      PRS_CH_CTRL_SIGSEL_TIMER0OF, prsEdgeOff);
+
+  timerInit.enable = false;
+  TIMER_Init(TIMER0, &timerInit);
+  TIMER_TopSet(TIMER0, top - 1);
+  TIMER_Enable(TIMER0, true);
+}
+
+/**************************************************************************//**
+ * @brief Set up the RFFT and the analysis window
+ *****************************************************************************/
+void initAnalyzer(void)
+{
+  // Note valid FFTSIZE values are 128, 512, and 2048
+  arm_rfft_init_f32(&rfft_instance, &cfft_instance, FFTSIZE, 0, 1);
+
+  for(int i = 0; i < FFTSIZE; i++)
+  {
+    hannWindow[i] = 0.5f - 0.5f * cosf(2.0f * PI * i / FFTSIZE);
+  }
+
+  // Measure the processing time of every block
+  CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+  DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+  cyclesBudget = (uint32_t)(((uint64_t)SystemCoreClockGet() * HOPSIZE)
+                            / sampleRate);
+}
+
+/**************************************************************************//**
+ * @brief Turn one completed ping-pong buffer into a new spectrum
+ *****************************************************************************/
+void processBlock(const uint16_t *block)
+{
+  float32_t *spectrum = spectra[spectrumCount % NUM_SPECTRA];
+  float32_t peakValue;
+  uint32_t peakIndex;
+
+  // Slide the frame by one hop and append the new samples,
+  // scaled to -1..1 around mid-scale
+  for(int i = 0; i < HOPSIZE; i++)
+  {
+    frame[i] = frame[i + HOPSIZE];
+    frame[i + HOPSIZE] = ((float32_t)block[i] - 2048.0f) * (1.0f / 2048.0f);
+  }
+
+  // Window time domain data
+  for(int i = 0; i < FFTSIZE; i++)
+  {
+    fftInput[i] = frame[i] * hannWindow[i];
+  }
+
+  arm_rfft_f32(&rfft_instance, fftInput, freqBuffer);
+  arm_cmplx_mag_f32(freqBuffer, spectrum, NUM_BINS);
+
+  // Skip the DC bin when looking for the strongest component
+  arm_max_f32(&spectrum[1], NUM_BINS - 1, &peakValue, &peakIndex);
+  peakMagnitude = peakValue;
+  peakFrequency = (float32_t)((peakIndex + 1) * sampleRate) / FFTSIZE;
+
+  spectrumCount++;
+}
+
+/**************************************************************************//**
+ * @brief Analyze the input continuously
+ *****************************************************************************/
+int main()
+{
+  unsigned int readIndex = 0;
+  uint32_t start;
+  uint32_t skip;
+  CORE_DECLARE_IRQ_STATE;
+
+  CHIP_Init();
+
+  initAdc();
+  initLdma();
+  initTimer();
+  initAnalyzer();
+
+  while(1)
+  {
+    // Sleep until the LDMA completes a buffer. WFI still wakes up on the
+    // pending interrupt, so a block finishing right before it is not missed.
+    CORE_ENTER_CRITICAL();
+    if(blocksPending == 0) {
+      EMU_EnterEM1();
+    }
+    CORE_EXIT_CRITICAL();
+
+    if(blocksPending == 0) {
+      continue;
+    }
+
+    // With more than one block pending the LDMA is already refilling the
+    // older ones, continue with the newest
+    CORE_ENTER_ATOMIC();
+    skip = blocksPending - 1;
+    blocksPending = 1;
+    CORE_EXIT_ATOMIC();
+    if(skip > 0) {
+      blocksDropped += skip;
+      readIndex ^= (skip & 1);
+    }
+
+    start = DWT->CYCCNT;
+    processBlock(adcBuffer[readIndex]);
+    cyclesPerBlock = DWT->CYCCNT - start;
+    if(cyclesPerBlock > cyclesPerBlockMax) {
+      cyclesPerBlockMax = cyclesPerBlock;
+    }
+
+    readIndex ^= 1;
+    CORE_ENTER_ATOMIC();
+    blocksPending--;
+    CORE_EXIT_ATOMIC();
+  }
+}
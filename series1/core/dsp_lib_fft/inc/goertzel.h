@@ -0,0 +1,76 @@
+/***************************************************************************//**
+ * @file goertzel.h
+ *
+ * @brief Goertzel detector for a few frequencies of a sample stream, at a
+ * fraction of the cost of a full FFT.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2020 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ******************************************************************************/
+
+#ifndef GOERTZEL_H
+#define GOERTZEL_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "arm_math.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Frequencies one detector can watch
+#ifndef GOERTZEL_MAX_BINS
+#define GOERTZEL_MAX_BINS     8
+#endif
+
+// One watched frequency
+typedef struct {
+  float32_t coeff;            // 2 cos(w), w = 2 pi f / sample rate
+  float32_t s1;               // Last two outputs of the resonator
+  float32_t s2;
+} GOERTZEL_Bin_t;
+
+typedef struct {
+  uint32_t  bins;             // Frequencies watched
+  uint32_t  blockLength;      // Samples per detection block
+  uint32_t  count;            // Samples of the current block so far
+  float32_t energy;           // Sum of squares of the current block
+  uint32_t  blocks;           // Complete blocks so far
+  GOERTZEL_Bin_t bin[GOERTZEL_MAX_BINS];
+  float32_t power[GOERTZEL_MAX_BINS]; // Share of each bin of the last block
+} GOERTZEL_State_t;
+
+bool GOERTZEL_Init(GOERTZEL_State_t *state, const float32_t *frequency,
+                   uint32_t bins, float32_t sampleRate, uint32_t blockLength);
+uint32_t GOERTZEL_Process(GOERTZEL_State_t *state, const float32_t *src,
+                          uint32_t count);
+uint32_t GOERTZEL_Detect(const GOERTZEL_State_t *state, float32_t threshold);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // GOERTZEL_H
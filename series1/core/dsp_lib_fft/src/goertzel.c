@@ -0,0 +1,229 @@
+/***************************************************************************//**
+ * @file goertzel.c
+ *
+ * @brief Goertzel detector for a few frequencies of a sample stream, at a
+ * fraction of the cost of a full FFT.
+ *
+ * Each watched frequency is a second order resonator run over the samples,
+ * s[n] = x[n] + 2 cos(w) s[n-1] - s[n-2], which takes one multiply and two
+ * adds per sample. At the end of a block of N samples, the power of the
+ * frequency is s1^2 + s2^2 - 2 cos(w) s1 s2, the squared magnitude of one
+ * DFT bin. An N point FFT gives every bin in about N log2(N) operations;
+ * for a handful of frequencies the resonators cost less, need no buffer of
+ * N samples as the samples can come in blocks of any size, and w can be any
+ * frequency rather than a multiple of the sample rate / N.
+ *
+ * The power is reported as a share of the block energy: a tone of
+ * amplitude A at w gives (A N / 2)^2, and the block energy of that tone
+ * alone is A^2 N / 2, so the share 2 |X|^2 / (N energy) is 1 for a pure
+ * tone and 1/2 for each of two tones of the same level, whatever the
+ * signal level.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2020 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ *******************************************************************************
+ * # Evaluation Quality
+ * This code has been minimally tested to ensure that it builds and is suitable
+ * as a demonstration for evaluation purposes only. This code will be maintained
+ * at the sole discretion of Silicon Labs.
+ ******************************************************************************/
+
+#include <math.h>
+#include "goertzel.h"
+
+/**************************************************************************//**
+ * @brief
+ *   Start a new block
+ *****************************************************************************/
+static void restart(GOERTZEL_State_t *state)
+{
+  uint32_t k;
+
+  for (k = 0; k < state->bins; k++) {
+    state->bin[k].s1 = 0.0f;
+    state->bin[k].s2 = 0.0f;
+  }
+  state->energy = 0.0f;
+  state->count = 0;
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Share of the block energy of each bin, at the end of a block
+ *****************************************************************************/
+static void finish(GOERTZEL_State_t *state)
+{
+  GOERTZEL_Bin_t *bin;
+  float32_t scale = 0.0f;
+  uint32_t k;
+
+  if (state->energy > 0.0f) {
+    scale = 2.0f / ((float32_t)state->blockLength * state->energy);
+  }
+
+  for (k = 0; k < state->bins; k++) {
+    bin = &state->bin[k];
+    state->power[k] = scale * (bin->s1 * bin->s1 + bin->s2 * bin->s2
+                               - bin->coeff * bin->s1 * bin->s2);
+  }
+  state->blocks++;
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Run every resonator over part of a block
+ *
+ * @details
+ *   The bins are the outer loop so that each resonator keeps its state in
+ *   registers over the samples.
+ *****************************************************************************/
+static void run(GOERTZEL_State_t *state, const float32_t *src, uint32_t n)
+{
+  float32_t coeff, s0, s1, s2, e;
+  uint32_t i, k;
+
+  for (k = 0; k < state->bins; k++) {
+    coeff = state->bin[k].coeff;
+    s1 = state->bin[k].s1;
+    s2 = state->bin[k].s2;
+    for (i = 0; i < n; i++) {
+      s0 = src[i] + coeff * s1 - s2;
+      s2 = s1;
+      s1 = s0;
+    }
+    state->bin[k].s1 = s1;
+    state->bin[k].s2 = s2;
+  }
+
+  e = 0.0f;
+  for (i = 0; i < n; i++) {
+    e += src[i] * src[i];
+  }
+  state->energy += e;
+  state->count += n;
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Set up a detector
+ *
+ * @param[in] frequency
+ *   The frequencies to watch, in Hz, each below sampleRate / 2.
+ *
+ * @param[in] bins
+ *   Number of frequencies, 1 to GOERTZEL_MAX_BINS.
+ *
+ * @param[in] blockLength
+ *   Samples per detection block; the bins are about sampleRate /
+ *   blockLength wide, so tones closer than that are not told apart.
+ *
+ * @return
+ *   false if the arguments do not fit.
+ *****************************************************************************/
+bool GOERTZEL_Init(GOERTZEL_State_t *state, const float32_t *frequency,
+                   uint32_t bins, float32_t sampleRate, uint32_t blockLength)
+{
+  uint32_t k;
+
+  if ((bins < 1) || (bins > GOERTZEL_MAX_BINS) || (blockLength < 2)) {
+    return false;
+  }
+
+  for (k = 0; k < bins; k++) {
+    if ((frequency[k] < 0.0f) || (frequency[k] >= sampleRate / 2.0f)) {
+      return false;
+    }
+    state->bin[k].coeff = 2.0f * cosf(2.0f * PI * frequency[k] / sampleRate);
+    state->power[k] = 0.0f;
+  }
+
+  state->bins = bins;
+  state->blockLength = blockLength;
+  state->blocks = 0;
+  restart(state);
+
+  return true;
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Feed samples to the detector
+ *
+ * @details
+ *   The samples may come in blocks of any size, such as DMA buffers; a
+ *   detection block that ends in the middle of them is finished there and
+ *   the next one starts with the rest.
+ *
+ * @return
+ *   Number of detection blocks completed, power of each holds the last.
+ *****************************************************************************/
+uint32_t GOERTZEL_Process(GOERTZEL_State_t *state, const float32_t *src,
+                          uint32_t count)
+{
+  uint32_t completed = 0;
+  uint32_t n;
+
+  while (count > 0) {
+    n = state->blockLength - state->count;
+    if (n > count) {
+      n = count;
+    }
+
+    run(state, src, n);
+    src += n;
+    count -= n;
+
+    if (state->count == state->blockLength) {
+      finish(state);
+      restart(state);
+      completed++;
+    }
+  }
+  return completed;
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Bins present in the last complete block
+ *
+ * @param[in] threshold
+ *   Least share of the block energy, 0 to 1; 0.25 finds each tone of a
+ *   DTMF pair of equal levels with some noise and leakage.
+ *
+ * @return
+ *   Bit k set for each bin k at or above the threshold.
+ *****************************************************************************/
+uint32_t GOERTZEL_Detect(const GOERTZEL_State_t *state, float32_t threshold)
+{
+  uint32_t mask = 0;
+  uint32_t k;
+
+  for (k = 0; k < state->bins; k++) {
+    if (state->power[k] >= threshold) {
+      mask |= 1UL << k;
+    }
+  }
+  return mask;
+}
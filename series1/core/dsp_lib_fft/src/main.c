@@ -41,8 +41,13 @@
 #include "em_emu.h"
 #include "arm_math.h"
 #include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include "retargetserial.h"
+#include "benchmark.h"
+#include "goertzel.h"
 
-// Defines size of FFT, test data is 128 samples
+// Defines size of FFT
 // Supported arm_fft_f32 lengths are 128, 512, 2048
 #define FFTSIZE 128
 
@@ -51,6 +56,28 @@
 // Resolution = SAMPLEFREQ / FFTSIZE
 #define SAMPLEFREQ 48000
 
+// Window functions, select one with WINDOW_TYPE
+#define WINDOW_HANN       0
+#define WINDOW_HAMMING    1
+#define WINDOW_BLACKMAN   2
+
+#define WINDOW_TYPE WINDOW_HAMMING
+
+// Test signal, a 10kHz cosine with an amplitude of 10
+#define TESTFREQ 10000
+#define TESTAMPL 10.0f
+
+// Number of times each kernel is timed
+#define BENCHMARK_RUNS 8
+
+// Frequencies the Goertzel detector watches, and the samples it is fed at
+// a time, as they would come from a DMA buffer
+#define GOERTZEL_BINS     4
+#define GOERTZEL_CHUNK    32
+
+// Least share of the block energy of a detected tone
+#define GOERTZEL_THRESHOLD 0.25f
+
 // Instance structures for float32_t RFFT
 static arm_rfft_instance_f32 rfft_instance;
 // Instance structure for float32_t CFFT used by the RFFT
@@ -60,74 +87,131 @@ static arm_cfft_radix4_instance_f32 cfft_instance;
 float32_t freqBuffer[FFTSIZE * 2];
 float32_t magnitudeResponse[FFTSIZE];
 
-// 128 point Hamming window
-// To window real time data, Hamming function is:
-// w = .54 - (1 - .54)*cos(2*pi*SAMPLEINDEX /(FFTSIZE - 1))
-float32_t hammingWindow[128] =
-{
-    0.0800,    0.0806,    0.0823,    0.0851,    0.0890,    0.0940,    0.1001,
-    0.1073,    0.1156,    0.1249,    0.1352,    0.1465,    0.1587,    0.1719,
-    0.1860,    0.2010,    0.2167,    0.2333,    0.2507,    0.2687,    0.2874,
-    0.3067,    0.3266,    0.3470,    0.3679,    0.3892,    0.4109,    0.4329,
-    0.4551,    0.4776,    0.5002,    0.5229,    0.5457,    0.5684,    0.5911,
-    0.6136,    0.6360,    0.6581,    0.6800,    0.7015,    0.7226,    0.7432,
-    0.7634,    0.7830,    0.8020,    0.8204,    0.8381,    0.8551,    0.8712,
-    0.8866,    0.9012,    0.9148,    0.9275,    0.9393,    0.9501,    0.9599,
-    0.9687,    0.9764,    0.9831,    0.9886,    0.9931,    0.9965,    0.9987,
-    0.9999,    0.9999,    0.9987,    0.9965,    0.9931,    0.9886,    0.9831,
-    0.9764,    0.9687,    0.9599,    0.9501,    0.9393,    0.9275,    0.9148,
-    0.9012,    0.8866,    0.8712,    0.8551,    0.8381,    0.8204,    0.8020,
-    0.7830,    0.7634,    0.7432,    0.7226,    0.7015,    0.6800,    0.6581,
-    0.6360,    0.6136,    0.5911,    0.5684,    0.5457,    0.5229,    0.5002,
-    0.4776,    0.4551,    0.4329,    0.4109,    0.3892,    0.3679,    0.3470,
-    0.3266,    0.3067,    0.2874,    0.2687,    0.2507,    0.2333,    0.2167,
-    0.2010,    0.1860,    0.1719,    0.1587,    0.1465,    0.1352,    0.1249,
-    0.1156,    0.1073,    0.1001,    0.0940,    0.0890,    0.0851,    0.0823,
-    0.0806,    0.0800
+// FFTSIZE point window, filled in once by initWindow()
+float32_t window[FFTSIZE];
+
+// Time domain test data
+float32_t testData[FFTSIZE];
+
+// arm_rfft_f32 overwrites its input, each benchmark run works on a copy
+static float32_t fftInput[FFTSIZE];
+
+// Goertzel detector over blocks of FFTSIZE samples, the same resolution
+// as the FFT, and the tones it found in the test signal
+static const float32_t goertzelFrequency[GOERTZEL_BINS] = {
+  1000.0f, 5000.0f, TESTFREQ, 15000.0f
 };
+static GOERTZEL_State_t goertzel;
+uint32_t tonesDetected;
+
+/**************************************************************************//**
+ * @brief Fill the window table for FFTSIZE points
+ * @details
+ *   All three are generalized cosine windows,
+ *   w = a0 - a1*cos(2*pi*SAMPLEINDEX/(FFTSIZE - 1))
+ *          + a2*cos(4*pi*SAMPLEINDEX/(FFTSIZE - 1))
+ *   Hann:     a0 = 0.5,  a1 = 0.5,  a2 = 0
+ *   Hamming:  a0 = 0.54, a1 = 0.46, a2 = 0
+ *   Blackman: a0 = 0.42, a1 = 0.5,  a2 = 0.08
+ *****************************************************************************/
+void initWindow(void)
+{
+#if (WINDOW_TYPE == WINDOW_HANN)
+  const float32_t a0 = 0.5f, a1 = 0.5f, a2 = 0.0f;
+#elif (WINDOW_TYPE == WINDOW_HAMMING)
+  const float32_t a0 = 0.54f, a1 = 0.46f, a2 = 0.0f;
+#elif (WINDOW_TYPE == WINDOW_BLACKMAN)
+  const float32_t a0 = 0.42f, a1 = 0.5f, a2 = 0.08f;
+#else
+#error "Unknown WINDOW_TYPE"
+#endif
+  float32_t phase;
 
-// Test data of a 10kHz cosine wave
-float32_t testData[128] =
+  for(int i = 0; i < FFTSIZE; i++)
+  {
+    phase = 2.0f * PI * i / (FFTSIZE - 1);
+    window[i] = a0 - a1 * cosf(phase) + a2 * cosf(2.0f * phase);
+  }
+}
+
+/**************************************************************************//**
+ * @brief Fill testData with the test cosine sampled at SAMPLEFREQ
+ *****************************************************************************/
+void initTestData(void)
 {
-  0,9.6592579,5,-7.0710678,-8.6602535,2.5881906,10,2.5881906,-8.6602535,
-  -7.0710678,5,9.6592579,6.1232342e-15,-9.6592579,-5,7.0710678,8.6602535,
-  -2.5881906,-10,-2.5881906,8.6602535,7.0710678,-5,-9.6592579,-1.2246468e-14,
-  9.6592579,5,-7.0710678,-8.6602535,2.5881906,10,2.5881906,-8.6602535,
-  -7.0710678,5,9.6592579,-1.7157435e-14,-9.6592579,-5,7.0710678,8.6602535,
-  -2.5881906,-10,-2.5881906,8.6602535,7.0710678,-5,-9.6592579,-2.4492937e-14,
-  9.6592579,5,-7.0710678,-8.6602535,2.5881906,10,2.5881906,-8.6602535,
-  -7.0710678,5,9.6592579,-4.9109666e-15,-9.6592579,-5,7.0710678,8.6602535,
-  -2.5881906,-10,-2.5881906,8.6602535,7.0710678,-5,-9.6592579,3.4314870e-14,
-  9.6592579,5,-7.0710678,-8.6602535,2.5881906,10,2.5881906,-8.6602535,
-  -7.0710678,5,9.6592579,-6.3718772e-14,-9.6592579,-5,7.0710678,8.6602535,
-  -2.5881906,-10,-2.5881906,8.6602535,7.0710678,-5,-9.6592579,-4.8985874e-14,
-  9.6592579,5,-7.0710678,-8.6602535,2.5881906,10,2.5881906,-8.6602535,
-  -7.0710678,5,9.6592579,-2.6463513e-13,-9.6592579,-5,7.0710678,8.6602535,
-  -2.5881906,-10,-2.5881906,8.6602535,7.0710678,-5,-9.6592579,9.8219332e-15,
-  9.6592579,5,-7.0710678,-8.6602535,2.5881906,10,2.5881906
-};
+  for(int i = 0; i < FFTSIZE; i++)
+  {
+    testData[i] = TESTAMPL * cosf(2.0f * PI * TESTFREQ * i / SAMPLEFREQ);
+  }
+}
 
 /**************************************************************************//**
  * @brief Perform FFT and extract signal frequency content
  *****************************************************************************/
 int main()
 {
+  uint32_t start;
+
+  // Cycle counter and serial port for the benchmark results
+  BENCHMARK_Init();
+  RETARGET_SerialInit();
+  RETARGET_SerialCrLf(1);
+
   // Initialize FFTSIZE point rfft configuration.
   // Note valid FFTSIZE values are 128, 512, and 2048
   arm_rfft_init_f32(&rfft_instance, &cfft_instance, FFTSIZE, 0, 1);
 
-  // Window time domain data
-  // Windowing removes discontinuities between first and last time-domain sample
-  // The Hamming window function also reduces spectral leakage
-  for(int i = 0; i < FFTSIZE; i++)
+  initWindow();
+  initTestData();
+
+  GOERTZEL_Init(&goertzel, goertzelFrequency, GOERTZEL_BINS, SAMPLEFREQ,
+                FFTSIZE);
+
+  // The detector needs no window, it runs on the raw test signal, in
+  // chunks to show that a block can arrive in pieces
+  for(int run = 0; run < BENCHMARK_RUNS; run++)
   {
-    testData[i] = testData[i] * hammingWindow[i];
+    BENCHMARK_START(start);
+    for(int i = 0; i < FFTSIZE; i += GOERTZEL_CHUNK)
+    {
+      GOERTZEL_Process(&goertzel, &testData[i], GOERTZEL_CHUNK);
+    }
+    BENCHMARK_STOP("goertzel", start, FFTSIZE);
   }
+  tonesDetected = GOERTZEL_Detect(&goertzel, GOERTZEL_THRESHOLD);
+
+  // Window time domain data
+  // Windowing removes discontinuities between first and last time-domain sample
+  // The window function also reduces spectral leakage
+  BENCHMARK_START(start);
+  arm_mult_f32(testData, window, testData, FFTSIZE);
+  BENCHMARK_STOP("mult_f32 window", start, FFTSIZE);
 
   // Perform FFT and calculate magnitude
   // Uses test waveform as time domain data
-  arm_rfft_f32(&rfft_instance, testData, freqBuffer);
-  arm_cmplx_mag_f32(freqBuffer, magnitudeResponse, FFTSIZE);
+  for(int run = 0; run < BENCHMARK_RUNS; run++)
+  {
+    memcpy(fftInput, testData, sizeof(fftInput));
+
+    BENCHMARK_START(start);
+    arm_rfft_f32(&rfft_instance, fftInput, freqBuffer);
+    BENCHMARK_STOP("rfft_f32", start, FFTSIZE);
+
+    BENCHMARK_START(start);
+    arm_cmplx_mag_f32(freqBuffer, magnitudeResponse, FFTSIZE);
+    BENCHMARK_STOP("cmplx_mag_f32", start, FFTSIZE);
+  }
+
+  printf("\ndsp_lib_fft, FFTSIZE %d\n", FFTSIZE);
+  BENCHMARK_Print();
+
+  // Share of the block energy of each watched frequency, in 1/1000
+  for(int k = 0; k < GOERTZEL_BINS; k++)
+  {
+    printf("goertzel %5d Hz: %4d/1000%s\n", (int)goertzelFrequency[k],
+           (int)(goertzel.power[k] * 1000.0f),
+           (tonesDetected & (1UL << k)) ? " detected" : "");
+  }
 
   while(1)
   {
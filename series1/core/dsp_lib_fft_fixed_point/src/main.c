@@ -0,0 +1,249 @@
+/***************************************************************************//**
+ * @file main.c
+ * @brief This project compares the q15, q31 and float32 real FFTs of the CMSIS
+ * DSP_lib in speed and accuracy on 12-bit integer samples, for FFT lengths
+ * selected at run time.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2022 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ *******************************************************************************
+ * # Evaluation Quality
+ * This code has been minimally tested to ensure that it builds and is suitable 
+ * as a demonstration for evaluation purposes only. This code will be maintained
+ * at the sole discretion of Silicon Labs.
+ ******************************************************************************/
+
+#include "em_device.h"
+#include "em_system.h"
+#include "em_chip.h"
+#include "em_cmu.h"
+#include "em_emu.h"
+#include "arm_math.h"
+#include <math.h>
+#include <stdbool.h>
+
+// Largest FFT length, sets the buffer sizes
+#define MAX_FFTSIZE     2048
+
+// FFT lengths compared at run time
+#define NUM_SIZES       4
+static const uint16_t fftSizes[NUM_SIZES] = { 128, 512, 1024, 2048 };
+
+// Defines sample frequency of input data
+// Use for calculating FFT resolution:
+// Resolution = SAMPLEFREQ / FFTSIZE
+#define SAMPLEFREQ      48000
+
+// Test signal, 12-bit ADC counts around mid-scale
+#define ADC_MIDSCALE    2048
+#define TONE1_FREQ      10000
+#define TONE1_AMPL      1000
+#define TONE2_FREQ      3000
+#define TONE2_AMPL      200
+
+// Results for one FFT length
+typedef struct {
+  uint32_t  size;
+  uint32_t  cyclesF32;      // arm_rfft_fast_f32 + arm_cmplx_mag_f32
+  uint32_t  cyclesQ31;      // arm_rfft_q31 + arm_cmplx_mag_q31
+  uint32_t  cyclesQ15;      // arm_rfft_q15 + arm_cmplx_mag_q15
+  float32_t snrQ31;         // q31 magnitude vs float32 magnitude, dB
+  float32_t snrQ15;         // q15 magnitude vs float32 magnitude, dB
+} FftResult_t;
+
+FftResult_t results[NUM_SIZES];
+
+// FFT length used by runFfts(), change in the debugger to look at the
+// spectra of another length (128, 512, 1024 or 2048)
+volatile uint32_t selectedSize = 512;
+
+// 12-bit integer sensor samples
+int16_t sensorData[MAX_FFTSIZE];
+
+// Transform buffers; the q15/q31 RFFTs and arm_rfft_fast_f32 modify their
+// input, so it is rebuilt from sensorData before each run
+static float32_t inputF32[MAX_FFTSIZE];
+static q31_t inputQ31[MAX_FFTSIZE];
+static q15_t inputQ15[MAX_FFTSIZE];
+static float32_t freqF32[MAX_FFTSIZE];
+static q31_t freqQ31[MAX_FFTSIZE * 2];
+static q15_t freqQ15[MAX_FFTSIZE * 2];
+
+// Magnitude of the bins 0 to size/2 - 1, all scaled to float32 so they
+// can be compared directly
+float32_t magnitudeF32[MAX_FFTSIZE / 2];
+float32_t magnitudeQ31[MAX_FFTSIZE / 2];
+float32_t magnitudeQ15[MAX_FFTSIZE / 2];
+
+// Raw fixed-point magnitudes
+static q31_t magQ31[MAX_FFTSIZE / 2];
+static q15_t magQ15[MAX_FFTSIZE / 2];
+
+/**************************************************************************//**
+ * @brief Fill sensorData with two tones as a 12-bit ADC would sample them
+ *****************************************************************************/
+void generateSensorData(void)
+{
+  float32_t t;
+
+  for(int i = 0; i < MAX_FFTSIZE; i++)
+  {
+    t = (float32_t)i / SAMPLEFREQ;
+    sensorData[i] = ADC_MIDSCALE
+                    + (int16_t)(TONE1_AMPL * cosf(2.0f * PI * TONE1_FREQ * t))
+                    + (int16_t)(TONE2_AMPL * cosf(2.0f * PI * TONE2_FREQ * t));
+  }
+}
+
+/**************************************************************************//**
+ * @brief Convert sensorData to the three input formats
+ * @details
+ *   The 12-bit signed sample is placed in the top bits of the q15/q31
+ *   word, i.e. full scale is 1.0 in all three formats.
+ *****************************************************************************/
+void loadInputs(uint32_t size)
+{
+  int32_t s;
+
+  for(uint32_t i = 0; i < size; i++)
+  {
+    s = sensorData[i] - ADC_MIDSCALE;
+    inputF32[i] = (float32_t)s / 2048.0f;
+    inputQ31[i] = (q31_t)(s * (1 << 20));
+    inputQ15[i] = (q15_t)(s * (1 << 4));
+  }
+}
+
+/**************************************************************************//**
+ * @brief Signal to noise ratio of a magnitude against the float reference
+ *****************************************************************************/
+float32_t compareMagnitude(const float32_t *ref, const float32_t *test,
+                           uint32_t bins)
+{
+  float32_t signal = 0.0f;
+  float32_t noise = 0.0f;
+  float32_t diff;
+
+  // Bin 0 of arm_rfft_fast_f32 holds DC and Nyquist packed, skip it
+  for(uint32_t i = 1; i < bins; i++)
+  {
+    diff = ref[i] - test[i];
+    signal += ref[i] * ref[i];
+    noise += diff * diff;
+  }
+
+  if(noise == 0.0f) {
+    return INFINITY;
+  }
+  return 10.0f * log10f(signal / noise);
+}
+
+/**************************************************************************//**
+ * @brief Run the float32, q31 and q15 FFT of one length and compare them
+ * @param[in] size FFT length, 128, 512, 1024 or 2048
+ * @param[out] result Cycle counts and accuracy
+ * @return false if the length is not supported
+ *****************************************************************************/
+bool runFfts(uint32_t size, FftResult_t *result)
+{
+  arm_rfft_fast_instance_f32 instF32;
+  arm_rfft_instance_q31 instQ31;
+  arm_rfft_instance_q15 instQ15;
+  uint32_t bins = size / 2;
+  uint32_t start;
+  float32_t scale;
+
+  // The fixed-point RFFTs scale their output down by size/2 to avoid
+  // overflow, arm_cmplx_mag_q31/q15 return 2.30/2.14 format
+  scale = (float32_t)(size / 2);
+
+  if((arm_rfft_fast_init_f32(&instF32, size) != ARM_MATH_SUCCESS)
+     || (arm_rfft_init_q31(&instQ31, size, 0, 1) != ARM_MATH_SUCCESS)
+     || (arm_rfft_init_q15(&instQ15, size, 0, 1) != ARM_MATH_SUCCESS)) {
+    return false;
+  }
+
+  result->size = size;
+
+  loadInputs(size);
+
+  start = DWT->CYCCNT;
+  arm_rfft_fast_f32(&instF32, inputF32, freqF32, 0);
+  arm_cmplx_mag_f32(freqF32, magnitudeF32, bins);
+  result->cyclesF32 = DWT->CYCCNT - start;
+
+  start = DWT->CYCCNT;
+  arm_rfft_q31(&instQ31, inputQ31, freqQ31);
+  arm_cmplx_mag_q31(freqQ31, magQ31, bins);
+  result->cyclesQ31 = DWT->CYCCNT - start;
+
+  start = DWT->CYCCNT;
+  arm_rfft_q15(&instQ15, inputQ15, freqQ15);
+  arm_cmplx_mag_q15(freqQ15, magQ15, bins);
+  result->cyclesQ15 = DWT->CYCCNT - start;
+
+  for(uint32_t i = 0; i < bins; i++)
+  {
+    magnitudeQ31[i] = (float32_t)magQ31[i] * scale / 1073741824.0f;
+    magnitudeQ15[i] = (float32_t)magQ15[i] * scale / 16384.0f;
+  }
+
+  result->snrQ31 = compareMagnitude(magnitudeF32, magnitudeQ31, bins);
+  result->snrQ15 = compareMagnitude(magnitudeF32, magnitudeQ15, bins);
+
+  return true;
+}
+
+/**************************************************************************//**
+ * @brief Compare the FFT paths for all supported lengths
+ *****************************************************************************/
+int main()
+{
+  FftResult_t selected;
+
+  CHIP_Init();
+
+  // Enable the DWT cycle counter
+  CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+  DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+  generateSensorData();
+
+  for(int i = 0; i < NUM_SIZES; i++)
+  {
+    runFfts(fftSizes[i], &results[i]);
+  }
+
+  // Leave the spectra of the selected length in the magnitude buffers
+  if((selectedSize > MAX_FFTSIZE) || !runFfts(selectedSize, &selected)) {
+    // Loop here to enable the debugger to see what has happened
+    while(1);
+  }
+
+  while(1)
+  {
+    EMU_EnterEM1();
+  }
+}
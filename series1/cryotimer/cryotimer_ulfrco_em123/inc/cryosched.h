@@ -0,0 +1,89 @@
+/***************************************************************************//**
+ * @file cryosched.h
+ * @brief Periodic task scheduler on the CRYOTIMER wakeup.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2021 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ******************************************************************************/
+
+#ifndef CRYOSCHED_H
+#define CRYOSCHED_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "em_cryotimer.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Longest wakeup period the scheduler programs, as a PERIODSEL exponent.
+// The 32-bit counter is read at least once per 2 ^ 31 prescaled clocks so
+// that it can be extended to 64 bits.
+#define CRYOSCHED_MAX_PERIODSEL   31
+
+struct CRYOSCHED_Task;
+
+// Called from CRYOSCHED_Dispatch() when a task is due
+typedef void (*CRYOSCHED_Callback_t)(struct CRYOSCHED_Task *task, void *data);
+
+// Task state, owned by the caller and zeroed before first use, as for any
+// static task. The fields are private, use the functions below.
+typedef struct CRYOSCHED_Task {
+  struct CRYOSCHED_Task *next;    // Next running task
+  uint64_t due;                   // Quantum the task runs next at
+  uint32_t period;                // Quanta between runs
+  uint32_t periodMs;              // Period in ms, 0 if set in quanta
+  CRYOSCHED_Callback_t callback;
+  void *data;
+  bool running;
+} CRYOSCHED_Task_t;
+
+void CRYOSCHED_Init(CRYOTIMER_Osc_TypeDef osc,
+                    CRYOTIMER_Presc_TypeDef presc,
+                    CRYOTIMER_Period_TypeDef quantum);
+bool CRYOSCHED_Start(CRYOSCHED_Task_t *task,
+                     uint32_t period,
+                     CRYOSCHED_Callback_t callback,
+                     void *data);
+bool CRYOSCHED_StartMs(CRYOSCHED_Task_t *task,
+                       uint32_t periodMs,
+                       CRYOSCHED_Callback_t callback,
+                       void *data);
+void CRYOSCHED_SetRate(uint32_t rate);
+void CRYOSCHED_Stop(CRYOSCHED_Task_t *task);
+bool CRYOSCHED_IsRunning(const CRYOSCHED_Task_t *task);
+void CRYOSCHED_Dispatch(void);
+void CRYOSCHED_Sleep(void);
+uint64_t CRYOSCHED_GetQuanta(void);
+uint32_t CRYOSCHED_GetStride(void);
+uint32_t CRYOSCHED_GetWakeupCount(void);
+uint32_t CRYOSCHED_GetRunCount(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // CRYOSCHED_H
@@ -0,0 +1,546 @@
+/***************************************************************************//**
+ * @file cryosched.c
+ * @brief Periodic task scheduler on the CRYOTIMER wakeup.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2021 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ******************************************************************************/
+
+#include <stddef.h>
+#include "em_device.h"
+#include "em_cmu.h"
+#include "em_core.h"
+#include "em_emu.h"
+#include "em_cryotimer.h"
+#include "cryosched.h"
+
+static CRYOSCHED_Task_t *head;
+
+// Prescaled clocks per quantum and quanta per wakeup, log2
+static uint32_t quantumShift;
+static uint32_t strideShift;
+
+// EM3 with the ULFRCO, EM2 with the LFRCO or LFXO
+static bool em3;
+
+// Prescaled clocks per second, 16 fraction bits, for periods in ms
+static uint32_t rateQ16;
+
+// Counter extended to 64 bits, in prescaled clocks
+static uint32_t lastCount;
+static uint64_t clocks;
+
+// Quantum of the last wakeup event, and whether it has been dispatched
+static volatile uint64_t eventQuantum;
+static volatile bool pending;
+
+static volatile uint32_t wakeupCount;
+static uint32_t runCount;
+
+/***************************************************************************//**
+ * @brief
+ *   Read the counter and extend it to 64 bits, called with interrupts
+ *   disabled.
+ ******************************************************************************/
+static uint64_t readClocks(void)
+{
+  uint32_t count = CRYOTIMER_CounterGet();
+
+  clocks += (uint32_t)(count - lastCount);
+  lastCount = count;
+
+  return clocks;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Get the current quantum, called with interrupts disabled.
+ *
+ * @details
+ *   Never earlier than the quantum of the last wakeup event, which the
+ *   counter may still lag behind when it is read right after the event.
+ ******************************************************************************/
+static uint64_t nowQuantum(void)
+{
+  uint64_t now = readClocks() >> quantumShift;
+
+  return (now < eventQuantum) ? eventQuantum : now;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   First multiple of period after now.
+ ******************************************************************************/
+static uint64_t nextMultiple(uint64_t now, uint32_t period)
+{
+  return ((now / period) + 1) * period;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Milliseconds to the nearest number of quanta at the clock rate, at
+ *   least 1.
+ ******************************************************************************/
+static uint32_t msToQuanta(uint32_t ms)
+{
+  uint32_t shift = 16 + quantumShift;
+  uint64_t quanta = ((((uint64_t)ms * rateQ16) / 1000) + (1ULL << (shift - 1)))
+                    >> shift;
+
+  if (quanta == 0) {
+    return 1;
+  }
+  return (quanta > UINT32_MAX) ? UINT32_MAX : (uint32_t)quanta;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Greatest common divisor.
+ ******************************************************************************/
+static uint32_t gcd(uint32_t a, uint32_t b)
+{
+  uint32_t t;
+
+  while (b != 0) {
+    t = a % b;
+    a = b;
+    b = t;
+  }
+
+  return a;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Remove a task from the list if it is in it.
+ ******************************************************************************/
+static void unlink(CRYOSCHED_Task_t *task)
+{
+  CRYOSCHED_Task_t **link;
+
+  for (link = &head; *link != NULL; link = &(*link)->next) {
+    if (*link == task) {
+      *link = task->next;
+      break;
+    }
+  }
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Stretch the wakeup period to suit the running tasks.
+ *
+ * @details
+ *   The CRYOTIMER can only wake up every power of 2 prescaled clocks, at
+ *   multiples of that period on the counter. Every task runs at multiples
+ *   of its own period in quanta, so waking up every 2 ^ n quanta, where 2 ^ n
+ *   is the largest power of 2 that divides the periods of all tasks, reaches
+ *   every due time and no other wakeup is needed. Called with interrupts
+ *   disabled.
+ ******************************************************************************/
+static void program(void)
+{
+  CRYOSCHED_Task_t *task;
+  uint32_t divisor = 0;
+  uint32_t shift = 0;
+  uint64_t earliest = UINT64_MAX;
+
+  for (task = head; task != NULL; task = task->next) {
+    divisor = gcd(task->period, divisor);
+    if (task->due < earliest) {
+      earliest = task->due;
+    }
+  }
+
+  if (divisor == 0) {
+    // Nothing to run, wake up as seldom as possible
+    shift = CRYOSCHED_MAX_PERIODSEL - quantumShift;
+  } else {
+    while (((divisor & 1) == 0)
+           && ((quantumShift + shift) < CRYOSCHED_MAX_PERIODSEL)) {
+      divisor >>= 1;
+      shift++;
+    }
+  }
+
+  strideShift = shift;
+  CRYOTIMER_PeriodSet(quantumShift + shift);
+
+  // A due time may have passed while the period was being changed
+  if (earliest <= nowQuantum()) {
+    pending = true;
+  }
+}
+
+/***************************************************************************//**
+ * @brief
+ *   CRYOTIMER interrupt, notes the quantum of the wakeup.
+ ******************************************************************************/
+void CRYOTIMER_IRQHandler(void)
+{
+  uint32_t flags = CRYOTIMER_IntGet();
+  uint64_t halfQuantum = (1ULL << quantumShift) >> 1;
+
+  CRYOTIMER_IntClear(flags);
+
+  // Make sure the flag is cleared before returning, the CRYOTIMER runs
+  // in a much slower clock domain
+  __DSB();
+
+  // Round to the nearest quantum, the counter may not have moved on yet
+  eventQuantum = (readClocks() + halfQuantum) >> quantumShift;
+  pending = true;
+  wakeupCount++;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Start the CRYOTIMER with no tasks.
+ *
+ * @param[in] osc
+ *   Oscillator, cryotimerOscULFRCO to sleep in EM3.
+ *
+ * @param[in] presc
+ *   Prescaler of the oscillator.
+ *
+ * @param[in] quantum
+ *   Prescaled clocks in a quantum, the unit of the task periods.
+ ******************************************************************************/
+void CRYOSCHED_Init(CRYOTIMER_Osc_TypeDef osc,
+                    CRYOTIMER_Presc_TypeDef presc,
+                    CRYOTIMER_Period_TypeDef quantum)
+{
+  CRYOTIMER_Init_TypeDef init = CRYOTIMER_INIT_DEFAULT;
+  CORE_DECLARE_IRQ_STATE;
+
+  head = NULL;
+  quantumShift = ((uint32_t)quantum > CRYOSCHED_MAX_PERIODSEL)
+                 ? CRYOSCHED_MAX_PERIODSEL : (uint32_t)quantum;
+  em3 = (osc == cryotimerOscULFRCO);
+  rateQ16 = (em3 ? 1000UL << 16 : 32768UL << 16) >> (uint32_t)presc;
+  lastCount = 0;
+  clocks = 0;
+  eventQuantum = 0;
+  pending = false;
+  wakeupCount = 0;
+  runCount = 0;
+
+  CMU_ClockEnable(cmuClock_CRYOTIMER, true);
+
+  // Initialize disabled, which clears the counter, quantum 0 starts at 0
+  init.osc = osc;
+  init.presc = presc;
+  init.period = (CRYOTIMER_Period_TypeDef)quantumShift;
+  init.enable = false;
+  CRYOTIMER_Init(&init);
+
+  CRYOTIMER_IntClear(CRYOTIMER_IF_PERIOD);
+  CRYOTIMER_IntEnable(CRYOTIMER_IEN_PERIOD);
+  NVIC_ClearPendingIRQ(CRYOTIMER_IRQn);
+  NVIC_EnableIRQ(CRYOTIMER_IRQn);
+
+  CORE_ENTER_CRITICAL();
+  program();
+  CORE_EXIT_CRITICAL();
+
+  CRYOTIMER_Enable(true);
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Put a task in the list, called with interrupts disabled.
+ ******************************************************************************/
+static void startTask(CRYOSCHED_Task_t *task,
+                      uint32_t period,
+                      uint32_t periodMs,
+                      CRYOSCHED_Callback_t callback,
+                      void *data)
+{
+  if (task->running) {
+    unlink(task);
+  }
+
+  task->period = period;
+  task->periodMs = periodMs;
+  task->callback = callback;
+  task->data = data;
+  task->due = nextMultiple(nowQuantum(), period);
+  task->running = true;
+  task->next = head;
+  head = task;
+
+  program();
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Start or restart a periodic task.
+ *
+ * @details
+ *   The task runs at every multiple of period quanta from now on, so that
+ *   tasks with related periods run in the same wakeup.
+ *
+ * @param[in] period
+ *   Quanta between runs, at least 1. The wakeup period is stretched to the
+ *   largest power of 2 that divides the periods of all running tasks;
+ *   periods like 4, 8 and 24 need a wakeup every 4 quanta, while odd
+ *   periods need one every quantum.
+ *
+ * @return
+ *   false if the period is 0.
+ ******************************************************************************/
+bool CRYOSCHED_Start(CRYOSCHED_Task_t *task,
+                     uint32_t period,
+                     CRYOSCHED_Callback_t callback,
+                     void *data)
+{
+  CORE_DECLARE_IRQ_STATE;
+
+  if ((period == 0) || (callback == NULL)) {
+    return false;
+  }
+
+  CORE_ENTER_CRITICAL();
+  startTask(task, period, 0, callback, data);
+  CORE_EXIT_CRITICAL();
+
+  return true;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Start or restart a periodic task with a period in milliseconds.
+ *
+ * @details
+ *   The period is the nearest number of quanta at the clock rate given to
+ *   CRYOSCHED_SetRate(), or at the nominal rate of the oscillator until
+ *   then, and is converted again at each new rate. It is only as fine as a
+ *   quantum, so a task that needs a period closer to its milliseconds
+ *   needs a shorter quantum, and more wakeups.
+ *
+ * @param[in] periodMs
+ *   Milliseconds between runs, at least 1.
+ *
+ * @return
+ *   false if the period is 0.
+ ******************************************************************************/
+bool CRYOSCHED_StartMs(CRYOSCHED_Task_t *task,
+                       uint32_t periodMs,
+                       CRYOSCHED_Callback_t callback,
+                       void *data)
+{
+  CORE_DECLARE_IRQ_STATE;
+
+  if ((periodMs == 0) || (callback == NULL)) {
+    return false;
+  }
+
+  CORE_ENTER_CRITICAL();
+  startTask(task, msToQuanta(periodMs), periodMs, callback, data);
+  CORE_EXIT_CRITICAL();
+
+  return true;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Set the measured rate of the prescaled CRYOTIMER clock.
+ *
+ * @details
+ *   The ULFRCO and LFRCO are far off their nominal rate, see the lfcal
+ *   component for a measurement against the HFXO. The tasks started in
+ *   milliseconds get their periods in quanta at the new rate and run next
+ *   at the next multiple of the new period.
+ *
+ * @param[in] rate
+ *   Prescaled clocks per second, 16 fraction bits.
+ ******************************************************************************/
+void CRYOSCHED_SetRate(uint32_t rate)
+{
+  CRYOSCHED_Task_t *task;
+  uint32_t period;
+  uint64_t now;
+  CORE_DECLARE_IRQ_STATE;
+
+  if (rate == 0) {
+    return;
+  }
+
+  CORE_ENTER_CRITICAL();
+
+  rateQ16 = rate;
+  now = nowQuantum();
+  for (task = head; task != NULL; task = task->next) {
+    if (task->periodMs != 0) {
+      period = msToQuanta(task->periodMs);
+      if (period != task->period) {
+        task->period = period;
+        task->due = nextMultiple(now, period);
+      }
+    }
+  }
+
+  program();
+
+  CORE_EXIT_CRITICAL();
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Stop a task, the wakeup period stretches to suit the others.
+ ******************************************************************************/
+void CRYOSCHED_Stop(CRYOSCHED_Task_t *task)
+{
+  CORE_DECLARE_IRQ_STATE;
+
+  CORE_ENTER_CRITICAL();
+
+  if (task->running) {
+    unlink(task);
+    task->running = false;
+    program();
+  }
+
+  CORE_EXIT_CRITICAL();
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Check if a task is running.
+ ******************************************************************************/
+bool CRYOSCHED_IsRunning(const CRYOSCHED_Task_t *task)
+{
+  return task->running;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Run every task that is due, in one go.
+ *
+ * @details
+ *   Called from the main loop after each wakeup. The callbacks run in this
+ *   context and may start and stop tasks. A task that fell more than a
+ *   period behind runs once and then continues at the next multiple of its
+ *   period.
+ ******************************************************************************/
+void CRYOSCHED_Dispatch(void)
+{
+  CRYOSCHED_Task_t *task;
+  uint64_t now;
+  CORE_DECLARE_IRQ_STATE;
+
+  CORE_ENTER_CRITICAL();
+  pending = false;
+  now = nowQuantum();
+  CORE_EXIT_CRITICAL();
+
+  for (;;) {
+    // Look the list up again after each run, a callback may change it
+    CORE_ENTER_CRITICAL();
+    for (task = head; task != NULL; task = task->next) {
+      if (task->due <= now) {
+        task->due += task->period;
+        if (task->due <= now) {
+          task->due = nextMultiple(now, task->period);
+        }
+        break;
+      }
+    }
+    CORE_EXIT_CRITICAL();
+
+    if (task == NULL) {
+      break;
+    }
+
+    runCount++;
+    task->callback(task, task->data);
+  }
+
+  CORE_ENTER_CRITICAL();
+  program();
+  CORE_EXIT_CRITICAL();
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Sleep until the next wakeup unless one is already waiting.
+ ******************************************************************************/
+void CRYOSCHED_Sleep(void)
+{
+  CORE_DECLARE_IRQ_STATE;
+
+  CORE_ENTER_CRITICAL();
+  if (!pending) {
+    if (em3) {
+      EMU_EnterEM3(false);
+    } else {
+      EMU_EnterEM2(false);
+    }
+  }
+  CORE_EXIT_CRITICAL();
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Get the quanta since CRYOSCHED_Init().
+ ******************************************************************************/
+uint64_t CRYOSCHED_GetQuanta(void)
+{
+  uint64_t now;
+  CORE_DECLARE_IRQ_STATE;
+
+  CORE_ENTER_CRITICAL();
+  now = nowQuantum();
+  CORE_EXIT_CRITICAL();
+
+  return now;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Get the quanta between wakeups for the running tasks.
+ ******************************************************************************/
+uint32_t CRYOSCHED_GetStride(void)
+{
+  return 1UL << strideShift;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Get the number of CRYOTIMER wakeups.
+ ******************************************************************************/
+uint32_t CRYOSCHED_GetWakeupCount(void)
+{
+  return wakeupCount;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Get the number of task runs.
+ ******************************************************************************/
+uint32_t CRYOSCHED_GetRunCount(void)
+{
+  return runCount;
+}
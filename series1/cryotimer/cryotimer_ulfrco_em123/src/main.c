@@ -1,8 +1,8 @@
 /***************************************************************************//**
  * @file main.c
  * @brief This project shows how to use the Cryotimer with the ULFRCO in EM3.
- * The project idles in EM3 while waiting for the interrupt handler to toggle
- * LED0.
+ * The project idles in EM3 and wakes up to run periodic tasks, one of which
+ * toggles LED0.
  *******************************************************************************
  * # License
  * <b>Copyright 2020 Silicon Laboratories Inc. www.silabs.com</b>
@@ -35,6 +35,7 @@
  * at the sole discretion of Silicon Labs.
  ******************************************************************************/
 
+#include <stddef.h>
 #include "em_device.h"
 #include "em_chip.h"
 #include "em_cmu.h"
@@ -42,67 +43,107 @@
 #include "em_gpio.h"
 #include "em_cryotimer.h"
 #include "bsp.h"
+#include "cryosched.h"
+#include "lfcal.h"
 
 // Note: change this to one of the defined periods in em_cryotimer.h
-// Wakeup events occur every 2048 prescaled clock cycles
-#define CRYOTIMER_PERIOD    cryotimerPeriod_2k
+// The task periods are counted in quanta of 256 prescaled clock cycles
+#define CRYOTIMER_QUANTUM   cryotimerPeriod_256
 
 // Note: change this to one of the defined prescalers in em_cryotimer.h
 // The clock is divided by one
 #define CRYOTIMER_PRESCALE  cryotimerPresc_1
 
+// Nominal rate of the ULFRCO clock with CRYOTIMER_PRESCALE
+#define CRYOTIMER_HZ        1000
+
+// LED0 toggles every 2 seconds, about 8 quanta
+#define LED_PERIOD_MS       2000
+
+// The sensor is polled every second, about 4 quanta, and polling stops
+// after POLL_COUNT polls to show the wakeup period stretching
+#define POLL_PERIOD_MS      1000
+#define POLL_COUNT          16
+
+// The ULFRCO is measured over 1 s at startup and then every 256 quanta,
+// about a minute, to follow its drift with the temperature
+#define MEASURE_TICKS       1000
+#define MEASURE_PERIOD      256
+
+static CRYOSCHED_Task_t ledTask;
+static CRYOSCHED_Task_t pollTask;
+static CRYOSCHED_Task_t measureTask;
+
+static volatile bool measureDue;
+
+// Sensor polls, quanta between wakeups, wakeups and task runs
+volatile uint32_t polls;
+volatile uint32_t stride;
+volatile uint32_t wakeups;
+volatile uint32_t runs;
+
+// Measurements of the ULFRCO and its error at the last one, ppm
+volatile uint32_t measurements;
+volatile int32_t errorPpm;
+
 /**************************************************************************//**
  * @brief
- *    Cryotimer interrupt service routine
- *
- * @note
- *    The barrier below is make sure the interrupt flags get cleared before
- *    continuing. This ensures that the interrupt is not retriggered before
- *    exiting the Handler. A barrier like this is generally required when the
- *    peripheral clock is much slower than the CPU core clock.
- *
- * @note
- *    Despite the note above, the barrier is just a precaution. The code
- *    might work without it as well.
+ *    Task that toggles LED0
  *****************************************************************************/
-void CRYOTIMER_IRQHandler(void)
+static void toggleLed(CRYOSCHED_Task_t *task, void *data)
 {
-  // Acknowledge the interrupt
-  uint32_t flags = CRYOTIMER_IntGet();
-  CRYOTIMER_IntClear(flags);
+  (void)task;
+  (void)data;
 
-  // Put a barrier here to ensure interrupts are not retriggered. See note above
-  __DSB();
-
-  // Toggle LED0
   GPIO_PinOutToggle(BSP_GPIO_LED0_PORT, BSP_GPIO_LED0_PIN);
 }
 
 /**************************************************************************//**
  * @brief
- *    Initialize Cryotimer
+ *    Task that stands in for a sensor poll, and stops after POLL_COUNT polls
+ *****************************************************************************/
+static void pollSensor(CRYOSCHED_Task_t *task, void *data)
+{
+  (void)data;
+
+  if (++polls >= POLL_COUNT) {
+    CRYOSCHED_Stop(task);
+  }
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Task that asks the main loop to measure the ULFRCO
+ *****************************************************************************/
+static void measure(CRYOSCHED_Task_t *task, void *data)
+{
+  (void)task;
+  (void)data;
+
+  measureDue = true;
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Measure the ULFRCO against the HFXO and give the rate to the scheduler
  *
- * @note
- *    No need to enable the ULFRCO since it is always on and cannot be shut off
- *    under software control. The ULFRCO is used in this example because it is
- *    the only oscillator capable of running in EM3.
+ * @details
+ *    The core runs from the HFXO for the measurement only, and from the
+ *    HFRCO otherwise. The CRYOTIMER keeps counting and waking up over the
+ *    measurement.
  *****************************************************************************/
-void initCryotimer(void)
+static void measureUlfrco(void)
 {
-  // Enable cryotimer clock
-  CMU_ClockEnable(cmuClock_CRYOTIMER, true);
-
-  // Initialize cryotimer
-  CRYOTIMER_Init_TypeDef init = CRYOTIMER_INIT_DEFAULT;
-  init.osc = cryotimerOscULFRCO;   // Use the ULFRCO
-  init.presc = CRYOTIMER_PRESCALE; // Set the prescaler
-  init.period = CRYOTIMER_PERIOD;  // Set when wakeup events occur
-  init.enable = true;              // Start the cryotimer after initialization is done
-  CRYOTIMER_Init(&init);
-
-  // Enable cryotimer interrupts
-  CRYOTIMER_IntEnable(CRYOTIMER_IEN_PERIOD);
-  NVIC_EnableIRQ(CRYOTIMER_IRQn);
+  CMU_ClockSelectSet(cmuClock_HF, cmuSelect_HFXO);
+
+  if (LFCAL_Measure(CRYOTIMER_CounterGet, 0xFFFFFFFFUL, MEASURE_TICKS)) {
+    CRYOSCHED_SetRate(LFCAL_GetRateQ16());
+    measurements = LFCAL_GetMeasureCount();
+    errorPpm = LFCAL_GetErrorPpm();
+  }
+
+  CMU_ClockSelectSet(cmuClock_HF, cmuSelect_HFRCO);
+  CMU_OscillatorEnable(cmuOsc_HFXO, false, false);
 }
 
 /**************************************************************************//**
@@ -133,10 +174,32 @@ int main(void)
 
   // Initialization
   initGpio();
-  initCryotimer();
 
-  // Go into EM3 and only wake up when the cryotimer interrupt occurs
+  // Initialize the HFXO, only run for the ULFRCO measurements
+  CMU_HFXOInit_TypeDef hfxoInit = CMU_HFXOINIT_DEFAULT;
+  CMU_HFXOInit(&hfxoInit);
+
+  // No need to enable the ULFRCO since it is always on and cannot be shut
+  // off under software control. It is the only oscillator running in EM3.
+  CRYOSCHED_Init(cryotimerOscULFRCO, CRYOTIMER_PRESCALE, CRYOTIMER_QUANTUM);
+  CRYOSCHED_StartMs(&ledTask, LED_PERIOD_MS, toggleLed, NULL);
+  CRYOSCHED_StartMs(&pollTask, POLL_PERIOD_MS, pollSensor, NULL);
+  CRYOSCHED_Start(&measureTask, MEASURE_PERIOD, measure, NULL);
+
+  // Periods in ms are converted at the measured rate from now on
+  LFCAL_Init(CRYOTIMER_HZ);
+  measureUlfrco();
+
+  // Run all due tasks in each wakeup, then go into EM3 until the next one
   while(1) {
-    EMU_EnterEM3(false);
+    CRYOSCHED_Dispatch();
+    if (measureDue) {
+      measureDue = false;
+      measureUlfrco();
+    }
+    stride = CRYOSCHED_GetStride();
+    wakeups = CRYOSCHED_GetWakeupCount();
+    runs = CRYOSCHED_GetRunCount();
+    CRYOSCHED_Sleep();
   }
 }
@@ -51,10 +51,21 @@
 #include "em_rmu.h"
 #include "bsp.h"
 #include "em_msc.h"
+#include "flashlog.h"
 
 // Note: this isn't necessary (just a convenient macro for type-casting the pointer to USERDATA_BASE)
 #define USERDATA ((uint32_t*)USERDATA_BASE)
 
+// Event log in the last pages of main flash, one record per reset
+#define LOG_PAGES           4
+#define LOG_BASE            ((uint32_t*)(FLASH_BASE + FLASH_SIZE \
+                                         - (LOG_PAGES * FLASH_PAGE_SIZE)))
+#define EVENT_RESET         1
+
+// Records in the log, and the EM4 wakeups since the last other reset
+uint32_t logRecords;
+uint32_t logWakeups;
+
 // Note: change this to one of the defined periods in em_cryotimer.h
 // Wakeup events occur every 2048 prescaled clock cycles
 #define CRYOTIMER_PERIOD    cryotimerPeriod_2k
@@ -154,6 +165,44 @@ void initEm4(void)
   EMU_EM4Init(&init);
 }
 
+/**************************************************************************//**
+ * @brief
+ *    Log the reset and count the EM4 wakeups in the log
+ *
+ * @details
+ *    The record time is the Cryotimer count, which runs on through EM4 and
+ *    still holds the time since it was last started until initCryotimer()
+ *    resets it. Reading the log back scans the flash, which only takes
+ *    place here once per reset.
+ *****************************************************************************/
+void logReset(uint32_t resetCause)
+{
+  FLASHLOG_Init_TypeDef init = { LOG_BASE, LOG_PAGES };
+  FLASHLOG_Cursor_TypeDef cursor;
+  FLASHLOG_Record_TypeDef record;
+
+  CMU_ClockEnable(cmuClock_CRYOTIMER, true);
+
+  // Goes on after the newest record, past one torn by a power loss
+  FLASHLOG_Init(&init);
+  FLASHLOG_Append(EVENT_RESET, CRYOTIMER_CounterGet(), resetCause);
+
+  // Write it now, the next step may be EM4
+  FLASHLOG_Flush();
+
+  logRecords = 0;
+  logWakeups = 0;
+  FLASHLOG_Rewind(&cursor);
+  while (FLASHLOG_Next(&cursor, &record)) {
+    logRecords++;
+    if (record.data & RMU_RSTCAUSE_EM4RST) {
+      logWakeups++;
+    } else {
+      logWakeups = 0;
+    }
+  }
+}
+
 /**************************************************************************//**
  * @brief
  *    Main function
@@ -255,6 +304,9 @@ int main(void)
     GPIO_PinModeSet(BSP_GPIO_LED0_PORT, BSP_GPIO_LED0_PIN, gpioModePushPull, 1); // Turn LED0 on
   }
 
+  // Keep a record of this reset in the flash event log
+  logReset(resetCause);
+
   // Initialize and start Cryotimer to run for CRYOTIMER_PERIOD ticks (2 seconds by default)
   initCryotimer();
 
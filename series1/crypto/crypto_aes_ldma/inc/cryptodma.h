@@ -0,0 +1,81 @@
+/***************************************************************************//**
+ * @file cryptodma.h
+ *
+ * @brief AES-128 ECB, CBC and CTR encryption on the CRYPTO module, fed by
+ * the LDMA.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2020 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ******************************************************************************/
+
+#ifndef CRYPTODMA_H
+#define CRYPTODMA_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "em_device.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// CRYPTO module used, parts with two of them call the first one CRYPTO0
+#if defined(CRYPTO0)
+#define CRYPTODMA_DEVICE      CRYPTO0
+#else
+#define CRYPTODMA_DEVICE      CRYPTO
+#endif
+
+// LDMA channels that write the input and read the output
+#define CRYPTODMA_CH_WRITE    0
+#define CRYPTODMA_CH_READ     1
+
+// AES block size in bytes
+#define CRYPTODMA_BLOCK_SIZE  16
+
+// Longest message, one descriptor of at most 2048 words per direction
+#define CRYPTODMA_MAX_LENGTH  8192
+
+typedef enum {
+  cryptoDmaEcb,         // Electronic code book
+  cryptoDmaCbc,         // Cipher block chaining
+  cryptoDmaCtr,         // Counter, 32 bit big endian counter increment
+} CRYPTODMA_Mode_t;
+
+void CRYPTODMA_Init(void);
+bool CRYPTODMA_Encrypt(CRYPTODMA_Mode_t mode,
+                       uint8_t *out,
+                       const uint8_t *in,
+                       uint32_t len,
+                       const uint8_t *key,
+                       const uint8_t *iv);
+bool CRYPTODMA_IsBusy(void);
+void CRYPTODMA_Finish(uint8_t *iv);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // CRYPTODMA_H
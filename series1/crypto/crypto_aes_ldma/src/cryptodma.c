@@ -0,0 +1,231 @@
+/***************************************************************************//**
+ * @file cryptodma.c
+ *
+ * @brief AES-128 ECB, CBC and CTR encryption on the CRYPTO module, fed by
+ * the LDMA.
+ *
+ * The CRYPTO sequencer runs a short program once per 16 byte block until
+ * SEQCTRL.LENGTHA bytes have passed. The program waits for the LDMA to
+ * write a block to DATA0 (DMA0TODATA), encrypts it and hands DATA0 back to
+ * the LDMA (DATATODMA0). CBC keeps the last ciphertext block in DATA1 and
+ * XORs it into the next block, CTR keeps the counter in DATA1 and
+ * increments it with DATA1INC. One LDMA channel writes DATA0 on the CRYPTO
+ * DATA0WR request, a second one reads it on DATA0RD, 4 words per request, so
+ * the core only sets up the LDMA and the key and is free while the whole
+ * message is encrypted.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2020 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ *******************************************************************************
+ * # Evaluation Quality
+ * This code has been minimally tested to ensure that it builds and is suitable 
+ * as a demonstration for evaluation purposes only. This code will be maintained
+ * at the sole discretion of Silicon Labs.
+ ******************************************************************************/
+
+#include <string.h>
+#include "em_device.h"
+#include "em_cmu.h"
+#include "em_crypto.h"
+#include "em_ldma.h"
+
+#include "cryptodma.h"
+
+#if defined(CRYPTO0)
+#define CRYPTO_CLOCK      cmuClock_CRYPTO0
+#define SIGNAL_DATA0WR    ldmaPeripheralSignal_CRYPTO0_DATA0WR
+#define SIGNAL_DATA0RD    ldmaPeripheralSignal_CRYPTO0_DATA0RD
+#else
+#define CRYPTO_CLOCK      cmuClock_CRYPTO
+#define SIGNAL_DATA0WR    ldmaPeripheralSignal_CRYPTO_DATA0WR
+#define SIGNAL_DATA0RD    ldmaPeripheralSignal_CRYPTO_DATA0RD
+#endif
+
+static LDMA_Descriptor_t writeDescriptor;
+static LDMA_Descriptor_t readDescriptor;
+
+static bool active;
+static CRYPTODMA_Mode_t activeMode;
+
+/**************************************************************************//**
+ * @brief
+ *   Enable the CRYPTO clock
+ *
+ * @details
+ *   LDMA_Init() must have been called. The two LDMA channels are only used
+ *   while a message is encrypted.
+ *****************************************************************************/
+void CRYPTODMA_Init(void)
+{
+  CMU_ClockEnable(CRYPTO_CLOCK, true);
+  active = false;
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Start encrypting a message
+ *
+ * @details
+ *   Returns as soon as the LDMA and the sequencer are running; poll
+ *   CRYPTODMA_IsBusy() or sleep in EM1, then call CRYPTODMA_Finish(). The
+ *   buffers must stay untouched until then. The CRYPTO module must not be
+ *   used by other code meanwhile.
+ *
+ * @param[in] mode
+ *   ECB, CBC or CTR.
+ *
+ * @param[out] out
+ *   Ciphertext, word aligned, may be the same as in.
+ *
+ * @param[in] in
+ *   Plaintext, word aligned.
+ *
+ * @param[in] len
+ *   Length in bytes, a multiple of 16 up to CRYPTODMA_MAX_LENGTH.
+ *
+ * @param[in] key
+ *   128 bit key, word aligned.
+ *
+ * @param[in] iv
+ *   CBC initialization vector or CTR initial counter, word aligned, not
+ *   used for ECB.
+ *
+ * @return
+ *   false if the length is not allowed or a message is still in progress.
+ *****************************************************************************/
+bool CRYPTODMA_Encrypt(CRYPTODMA_Mode_t mode,
+                       uint8_t *out,
+                       const uint8_t *in,
+                       uint32_t len,
+                       const uint8_t *key,
+                       const uint8_t *iv)
+{
+  CRYPTO_TypeDef *crypto = CRYPTODMA_DEVICE;
+  CRYPTO_KeyBuf_TypeDef keyBuf;
+  LDMA_TransferCfg_t writeCfg = LDMA_TRANSFER_CFG_PERIPHERAL(SIGNAL_DATA0WR);
+  LDMA_TransferCfg_t readCfg = LDMA_TRANSFER_CFG_PERIPHERAL(SIGNAL_DATA0RD);
+
+  if ((len == 0) || ((len % CRYPTODMA_BLOCK_SIZE) != 0)
+      || (len > CRYPTODMA_MAX_LENGTH) || active) {
+    return false;
+  }
+
+  // AES-128, DMA0 moves a whole 128 bit DATA0 per request, DATA1INC
+  // increments the low 32 bits
+  crypto->CTRL = CRYPTO_CTRL_AES_AES128
+                 | CRYPTO_CTRL_INCWIDTH_INCWIDTH4
+                 | CRYPTO_CTRL_DMA0MODE_FULL
+                 | CRYPTO_CTRL_DMA0RSEL_DATA0;
+  crypto->WAC = 0;
+  crypto->SEQCTRL = len << _CRYPTO_SEQCTRL_LENGTHA_SHIFT;
+  crypto->SEQCTRLB = 0;
+
+  memset(keyBuf, 0, sizeof(keyBuf));
+  memcpy(keyBuf, key, 16);
+  CRYPTO_KeyBufWrite(crypto, keyBuf, cryptoKey128Bits);
+
+  switch (mode) {
+    case cryptoDmaCbc:
+      CRYPTO_DataWrite(&crypto->DATA1, (const uint32_t *)iv);
+      CRYPTO_SEQ_LOAD_5(crypto,
+                        CRYPTO_CMD_INSTR_DMA0TODATA,
+                        CRYPTO_CMD_INSTR_DATA1TODATA0XOR,
+                        CRYPTO_CMD_INSTR_AESENC,
+                        CRYPTO_CMD_INSTR_DATA0TODATA1,
+                        CRYPTO_CMD_INSTR_DATATODMA0);
+      break;
+
+    case cryptoDmaCtr:
+      // The plaintext waits in DATA2 while the counter is encrypted
+      CRYPTO_DataWrite(&crypto->DATA1, (const uint32_t *)iv);
+      CRYPTO_SEQ_LOAD_7(crypto,
+                        CRYPTO_CMD_INSTR_DMA0TODATA,
+                        CRYPTO_CMD_INSTR_DATA0TODATA2,
+                        CRYPTO_CMD_INSTR_DATA1TODATA0,
+                        CRYPTO_CMD_INSTR_AESENC,
+                        CRYPTO_CMD_INSTR_DATA2TODATA0XOR,
+                        CRYPTO_CMD_INSTR_DATA1INC,
+                        CRYPTO_CMD_INSTR_DATATODMA0);
+      break;
+
+    default:
+      CRYPTO_SEQ_LOAD_3(crypto,
+                        CRYPTO_CMD_INSTR_DMA0TODATA,
+                        CRYPTO_CMD_INSTR_AESENC,
+                        CRYPTO_CMD_INSTR_DATATODMA0);
+      break;
+  }
+
+  // 4 words per request, no LDMA interrupt, completion is polled
+  writeDescriptor = (LDMA_Descriptor_t)
+    LDMA_DESCRIPTOR_SINGLE_M2P_WORD(in, &crypto->DATA0, len / 4);
+  writeDescriptor.xfer.blockSize = ldmaCtrlBlockSizeUnit4;
+  writeDescriptor.xfer.doneIfs = 0;
+
+  readDescriptor = (LDMA_Descriptor_t)
+    LDMA_DESCRIPTOR_SINGLE_P2M_WORD(&crypto->DATA0, out, len / 4);
+  readDescriptor.xfer.blockSize = ldmaCtrlBlockSizeUnit4;
+  readDescriptor.xfer.doneIfs = 0;
+
+  active = true;
+  activeMode = mode;
+
+  // Arm the read side first so it is ready when the first block finishes
+  LDMA_StartTransfer(CRYPTODMA_CH_READ, &readCfg, &readDescriptor);
+  LDMA_StartTransfer(CRYPTODMA_CH_WRITE, &writeCfg, &writeDescriptor);
+  crypto->CMD = CRYPTO_CMD_SEQSTART;
+
+  return true;
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Whether the message started by CRYPTODMA_Encrypt() is still in progress
+ *****************************************************************************/
+bool CRYPTODMA_IsBusy(void)
+{
+  return active
+         && (!LDMA_TransferDone(CRYPTODMA_CH_READ)
+             || ((CRYPTODMA_DEVICE->STATUS & CRYPTO_STATUS_SEQRUNNING) != 0));
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Wait for the message to complete and read back the chaining value
+ *
+ * @param[out] iv
+ *   Next CBC initialization vector (the last ciphertext block) or next CTR
+ *   counter, to carry on with the next message; NULL if not needed. Not
+ *   written for ECB.
+ *****************************************************************************/
+void CRYPTODMA_Finish(uint8_t *iv)
+{
+  while (CRYPTODMA_IsBusy()) ;
+
+  if ((iv != NULL) && active && (activeMode != cryptoDmaEcb)) {
+    CRYPTO_DataRead(&CRYPTODMA_DEVICE->DATA1, (uint32_t *)iv);
+  }
+  active = false;
+}
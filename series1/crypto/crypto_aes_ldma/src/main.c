@@ -0,0 +1,276 @@
+/***************************************************************************//**
+ * @file main.c
+ * @brief Measure AES throughput on the CRYPTO module, polled by emlib and
+ * fed by the LDMA, in the same table format as the series 0 aes_benchmark
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2020 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ *******************************************************************************
+ * # Evaluation Quality
+ * This code has been minimally tested to ensure that it builds and is suitable 
+ * as a demonstration for evaluation purposes only. This code will be maintained
+ * at the sole discretion of Silicon Labs.
+ ******************************************************************************/
+
+
+#include <stdio.h>
+#include <string.h>
+#include "em_device.h"
+#include "em_chip.h"
+#include "em_cmu.h"
+#include "em_crypto.h"
+#include "em_ldma.h"
+#include "retargetserial.h"
+#include "benchmark.h"
+#include "cryptodma.h"
+
+// Note: change these to change the buffer sizes that are measured
+//       (each must be a multiple of 16 and at most MAX_DATA_SIZE). The
+//       sizes, key, IV and data match series0/aes/aes_benchmark, so the
+//       tables of both can be compared line by line.
+static const uint32_t dataSizes[] = { 16, 64, 256, 1024, 4096 };
+
+#define SIZE_COUNT      (sizeof(dataSizes) / sizeof(dataSizes[0]))
+
+#define MAX_DATA_SIZE   4096
+#define MAX_DATA_WORDS  (MAX_DATA_SIZE / 4)
+
+// Number of times each case is run, the table shows min/avg/max
+#define BENCHMARK_RUNS  4
+
+// Buffers are word arrays so the LDMA and the CRYPTO library get aligned
+// data
+static uint32_t originalData[MAX_DATA_WORDS];
+static uint32_t encryptedData[MAX_DATA_WORDS];
+static uint32_t referenceData[MAX_DATA_WORDS];
+
+// Note: the first 16 bytes are used as the 128 bit key, the NIST SP 800-38A
+// key 2B7E1516...
+static const uint32_t key[8] = {
+  0x16157E2B, 0xA6D2AE28, 0x8815F7AB, 0x3C4FCF09,
+  0x10EB3D60, 0xBE71CA15, 0xF0AE732B, 0x81777D85
+};
+
+static const uint32_t initVector[4] = {
+  0x03020100, 0x07060504, 0x0B0A0908, 0x0F0E0D0C
+};
+
+// NIST SP 800-38A F.1.1, first block of ECB-AES128
+static const uint32_t nistPlain[4] = {
+  0xE2BEC16B, 0x969F402E, 0x117E3DE9, 0x2A179373
+};
+static const uint32_t nistCipher[4] = {
+  0xB47BD73A, 0x60367A0D, 0xF3CA9EA8, 0x97EF6624
+};
+
+// Counter for CTR mode, reloaded from initVector before each run
+static uint32_t counter[4];
+
+// A flag indicating whether the LDMA results matched the library and the
+// NIST vector. Note: This is only volatile to ensure that it doesn't get
+// optimized out by the compiler before the user checks its value.
+static volatile bool isError;
+
+/***************************************************************************//**
+ * Library (register polled) cases
+ ******************************************************************************/
+
+typedef void (*AesRun_t)(uint32_t len);
+
+#define IN      ((const uint8_t *)originalData)
+#define OUT     ((uint8_t *)encryptedData)
+#define KEY     ((const uint8_t *)key)
+#define IV      ((const uint8_t *)initVector)
+#define DEV     CRYPTODMA_DEVICE
+
+static void runEcb128(uint32_t len) { CRYPTO_AES_ECB128(DEV, OUT, IN, len, KEY, true); }
+static void runEcb256(uint32_t len) { CRYPTO_AES_ECB256(DEV, OUT, IN, len, KEY, true); }
+static void runCbc128(uint32_t len) { CRYPTO_AES_CBC128(DEV, OUT, IN, len, KEY, IV, true); }
+static void runCbc256(uint32_t len) { CRYPTO_AES_CBC256(DEV, OUT, IN, len, KEY, IV, true); }
+
+static void runCtr128(uint32_t len)
+{
+  memcpy(counter, initVector, sizeof(counter));
+  CRYPTO_AES_CTR128(DEV, OUT, IN, len, KEY, (uint8_t *)counter,
+                    CRYPTO_AES_CTRUpdate32Bit);
+}
+
+static void runCtr256(uint32_t len)
+{
+  memcpy(counter, initVector, sizeof(counter));
+  CRYPTO_AES_CTR256(DEV, OUT, IN, len, KEY, (uint8_t *)counter,
+                    CRYPTO_AES_CTRUpdate32Bit);
+}
+
+static const struct {
+  const char *name;
+  AesRun_t   run;
+} libraryCases[] = {
+  { "ecb128 polled", runEcb128 },
+  { "ecb256 polled", runEcb256 },
+  { "cbc128 polled", runCbc128 },
+  { "cbc256 polled", runCbc256 },
+  { "ctr128 polled", runCtr128 },
+  { "ctr256 polled", runCtr256 },
+};
+
+#define LIBRARY_CASE_COUNT (sizeof(libraryCases) / sizeof(libraryCases[0]))
+
+/***************************************************************************//**
+ * LDMA fed cases, each with the library case it must match
+ ******************************************************************************/
+
+static const struct {
+  const char       *name;
+  CRYPTODMA_Mode_t mode;
+  AesRun_t         reference;
+} dmaCases[] = {
+  { "ecb128 dma", cryptoDmaEcb, runEcb128 },
+  { "cbc128 dma", cryptoDmaCbc, runCbc128 },
+  { "ctr128 dma", cryptoDmaCtr, runCtr128 },
+};
+
+#define DMA_CASE_COUNT (sizeof(dmaCases) / sizeof(dmaCases[0]))
+
+/**************************************************************************//**
+ * @brief
+ *    Encrypt a buffer with the LDMA feeding the CRYPTO module
+ *****************************************************************************/
+static void runDma(CRYPTODMA_Mode_t mode, uint32_t len)
+{
+  if (!CRYPTODMA_Encrypt(mode, OUT, IN, len, KEY, IV)) {
+    isError = true;
+    return;
+  }
+
+  // The core is free here, spin instead of sleeping so the cycle counter
+  // keeps running and the table shows the time to finish
+  CRYPTODMA_Finish(NULL);
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Compare the last result with the library result for the same mode
+ *****************************************************************************/
+static void checkResult(AesRun_t reference, uint32_t len)
+{
+  // Keep the result, the library case writes to encryptedData
+  memcpy(referenceData, encryptedData, len);
+  reference(len);
+  if (memcmp(referenceData, encryptedData, len) != 0) {
+    isError = true;
+  }
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Check the LDMA ECB path against the NIST SP 800-38A vector
+ *****************************************************************************/
+static void checkNist(void)
+{
+  uint32_t out[4];
+
+  if (!CRYPTODMA_Encrypt(cryptoDmaEcb, (uint8_t *)out,
+                         (const uint8_t *)nistPlain, sizeof(nistPlain),
+                         KEY, NULL)) {
+    isError = true;
+    return;
+  }
+  CRYPTODMA_Finish(NULL);
+
+  if (memcmp(out, nistCipher, sizeof(out)) != 0) {
+    isError = true;
+  }
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Time all modes and feeding methods for one buffer size
+ *****************************************************************************/
+static void benchmarkSize(uint32_t len)
+{
+  uint32_t start;
+
+  BENCHMARK_Reset();
+
+  for (uint32_t run = 0; run < BENCHMARK_RUNS; run++) {
+    for (uint32_t i = 0; i < LIBRARY_CASE_COUNT; i++) {
+      BENCHMARK_START(start);
+      libraryCases[i].run(len);
+      BENCHMARK_STOP(libraryCases[i].name, start, len);
+    }
+
+    for (uint32_t i = 0; i < DMA_CASE_COUNT; i++) {
+      BENCHMARK_START(start);
+      runDma(dmaCases[i].mode, len);
+      BENCHMARK_STOP(dmaCases[i].name, start, len);
+      checkResult(dmaCases[i].reference, len);
+    }
+  }
+
+  printf("\n%lu bytes\n", (unsigned long)len);
+  BENCHMARK_Print();
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Main function
+ *****************************************************************************/
+int main(void)
+{
+  LDMA_Init_t ldmaInit = LDMA_INIT_DEFAULT;
+
+  // Chip errata
+  CHIP_Init();
+
+  // Cycle counter and serial port for the benchmark results
+  BENCHMARK_Init();
+  RETARGET_SerialInit();
+  RETARGET_SerialCrLf(1);
+
+  CMU_ClockEnable(cmuClock_LDMA, true);
+  LDMA_Init(&ldmaInit);
+  CRYPTODMA_Init();
+
+  // Fill the plaintext with a counting pattern
+  for (uint32_t i = 0; i < MAX_DATA_WORDS; i++) {
+    originalData[i] = 0x03020100 + (i * 0x04040404);
+  }
+
+  printf("\ncrypto_aes_ldma, core clock %lu Hz\n",
+         (unsigned long)SystemCoreClockGet());
+
+  isError = false;
+  checkNist();
+  for (uint32_t i = 0; i < SIZE_COUNT; i++) {
+    benchmarkSize(dataSizes[i]);
+  }
+
+  printf("\nisError = %d\n", isError ? 1 : 0);
+
+  // Pause the debugger here to check if the isError variable is true/false
+  while (1) {
+  }
+}
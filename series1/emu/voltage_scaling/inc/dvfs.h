@@ -0,0 +1,92 @@
+/***************************************************************************//**
+ * @file dvfs.h
+ * @brief Governor for the HFRCO frequency and EM01 voltage scale, driven by
+ * the measured workload of each task.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2021 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ******************************************************************************/
+
+#ifndef DVFS_H
+#define DVFS_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "em_cmu.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// RTCC compare channel that ends each governor window
+#define DVFS_RTCC_CHANNEL     1
+
+// Tasks whose workload is tracked, numbered from 0. Busy time outside any
+// task is tracked too, as one more task.
+#ifndef DVFS_MAX_TASKS
+#define DVFS_MAX_TASKS        4
+#endif
+
+#define DVFS_MAX_POINTS       8
+
+// Frequency and voltage are changed together
+typedef struct {
+  CMU_HFRCOFreq_TypeDef band;   // HFRCO band, the core clock
+  bool lowVoltage;              // VSCALE0, band at most
+                                // CMU_VSCALEEM01_LOWPOWER_VOLTAGE_CLOCK_MAX
+} DVFS_Point_t;
+
+// Operating points available on all Series 1 devices, slowest first
+#define DVFS_POINTS_DEFAULT             \
+  {                                     \
+    { cmuHFRCOFreq_4M0Hz, true },       \
+    { cmuHFRCOFreq_19M0Hz, true },      \
+    { cmuHFRCOFreq_38M0Hz, false },     \
+  }
+
+typedef struct {
+  const DVFS_Point_t *points;   // Slowest first
+  uint32_t pointCount;
+  uint32_t windowTicks;         // 32.768 kHz ticks per governor window
+  uint32_t targetLoad;          // % of a window the workload should fill
+  uint32_t upLoad;              // % busy that jumps to the fastest point
+  uint32_t downWindows;         // Windows wanting less before stepping down
+} DVFS_Config_t;
+
+bool DVFS_Init(const DVFS_Config_t *config);
+void DVFS_TaskBegin(uint32_t task);
+void DVFS_TaskEnd(uint32_t task);
+void DVFS_Idle(void);
+uint32_t DVFS_GetPoint(void);
+uint32_t DVFS_GetTaskLoad(uint32_t task);
+uint32_t DVFS_GetLoad(void);
+uint32_t DVFS_GetSwitchCount(void);
+uint32_t DVFS_GetVScaleErrorCount(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // DVFS_H
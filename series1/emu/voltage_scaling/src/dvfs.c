@@ -0,0 +1,417 @@
+/***************************************************************************//**
+ * @file dvfs.c
+ * @brief Governor for the HFRCO frequency and EM01 voltage scale, driven by
+ * the measured workload of each task.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2021 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ******************************************************************************/
+
+#include <stddef.h>
+#include "em_core.h"
+#include "em_emu.h"
+#include "em_rtcc.h"
+
+#include "dvfs.h"
+
+/*******************************************************************************
+ *******************************   DEFINES   ***********************************
+ ******************************************************************************/
+
+#define DVFS_RTCC_IF          (RTCC_IF_CC0 << DVFS_RTCC_CHANNEL)
+
+// Weight of the last window in the workload of a task, 1 / 2^shift
+#define DVFS_FILTER_SHIFT     2
+
+// Busy time outside any task
+#define DVFS_OTHER            DVFS_MAX_TASKS
+
+/*******************************************************************************
+ ***************************   LOCAL VARIABLES   *******************************
+ ******************************************************************************/
+
+static DVFS_Config_t config;
+static DVFS_Point_t points[DVFS_MAX_POINTS];
+static uint32_t point;
+
+// Window timing in RTCC ticks
+static uint32_t windowStart;
+static uint32_t windowEnd;
+
+// Busy ticks of each task in this window and the start of the ones running
+static uint32_t taskTicks[DVFS_MAX_TASKS + 1];
+static uint32_t taskStart[DVFS_MAX_TASKS];
+static bool taskRunning[DVFS_MAX_TASKS];
+
+// Filtered workload of each task, core clock cycles per second
+static uint32_t taskLoad[DVFS_MAX_TASKS + 1];
+
+// Ticks spent in DVFS_Idle() in this window
+static uint32_t idleTicks;
+static uint32_t idleStart;
+static bool idling;
+
+static uint32_t load;
+static uint32_t downCount;
+static uint32_t switches;
+static uint32_t vscaleErrors;
+
+/***************************************************************************//**
+ * @brief
+ *   Core clock of an operating point. The Series 1 HFRCO bands are
+ *   numbered by their frequency in Hz.
+ ******************************************************************************/
+static uint32_t pointHz(uint32_t index)
+{
+  return (uint32_t)points[index].band;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Move to an operating point
+ *
+ * @details
+ *   The voltage goes up before the clock and the clock down before the
+ *   voltage, as the HFCLK must not be above
+ *   CMU_VSCALEEM01_LOWPOWER_VOLTAGE_CLOCK_MAX at VSCALE0. EMU_EM01Init()
+ *   waits for the scaling to finish; the voltage scale read back then sets
+ *   the flash wait states for the new clock, and a mismatch is counted.
+ ******************************************************************************/
+static void setPoint(uint32_t index)
+{
+  EMU_EM01Init_TypeDef em01Init = EMU_EM01INIT_DEFAULT;
+  EMU_VScaleEM01_TypeDef expected;
+  EMU_VScaleEM01_TypeDef vscale;
+
+  if (points[index].lowVoltage) {
+    expected = emuVScaleEM01_LowPower;
+    CMU_HFRCOBandSet(points[index].band);
+    em01Init.vScaleEM01LowPowerVoltageEnable = true;
+    EMU_EM01Init(&em01Init);
+  } else {
+    expected = emuVScaleEM01_HighPerformance;
+    em01Init.vScaleEM01LowPowerVoltageEnable = false;
+    EMU_EM01Init(&em01Init);
+    CMU_HFRCOBandSet(points[index].band);
+  }
+
+  vscale = EMU_VScaleGet();
+  if (vscale != expected) {
+    vscaleErrors++;
+  }
+  CMU_UpdateWaitStates(SystemCoreClockGet(), (int)vscale);
+
+  if (index != point) {
+    switches++;
+  }
+  point = index;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Update the workload of each task at the end of a window and pick the
+ *   operating point for the next one
+ *
+ * @details
+ *   A task busy for a part of the window at the current clock needs that
+ *   part of the clock in cycles per second. The slowest point whose clock
+ *   covers the summed workload at config.targetLoad is chosen. A window
+ *   busy for config.upLoad or more jumps to the fastest point at once, as
+ *   the workload can not be measured above the current clock. Moving down
+ *   takes config.downWindows windows in a row that want less.
+ ******************************************************************************/
+static void govern(uint32_t now)
+{
+  uint32_t elapsed = now - windowStart;
+  uint32_t busy;
+  uint32_t tracked = 0;
+  uint64_t demand = 0;
+  uint32_t next;
+  uint32_t t;
+
+  windowStart = now;
+  if (elapsed == 0) {
+    return;
+  }
+
+  // Close the intervals still running at the window edge
+  if (idling) {
+    idleTicks += now - idleStart;
+    idleStart = now;
+  }
+  for (t = 0; t < DVFS_MAX_TASKS; t++) {
+    if (taskRunning[t]) {
+      taskTicks[t] += now - taskStart[t];
+      taskStart[t] = now;
+    }
+    tracked += taskTicks[t];
+  }
+
+  busy = (idleTicks < elapsed) ? (elapsed - idleTicks) : 0;
+  taskTicks[DVFS_OTHER] = (busy > tracked) ? (busy - tracked) : 0;
+  load = (busy * 100) / elapsed;
+
+  for (t = 0; t <= DVFS_MAX_TASKS; t++) {
+    uint32_t cps = (uint32_t)(((uint64_t)taskTicks[t] * pointHz(point))
+                              / elapsed);
+
+    if (cps >= taskLoad[t]) {
+      taskLoad[t] += (cps - taskLoad[t]) >> DVFS_FILTER_SHIFT;
+    } else {
+      taskLoad[t] -= (taskLoad[t] - cps) >> DVFS_FILTER_SHIFT;
+    }
+    demand += taskLoad[t];
+    taskTicks[t] = 0;
+  }
+  idleTicks = 0;
+
+  if (load >= config.upLoad) {
+    next = config.pointCount - 1;
+  } else {
+    demand = (demand * 100) / config.targetLoad;
+    for (next = 0; next < (config.pointCount - 1); next++) {
+      if (pointHz(next) >= demand) {
+        break;
+      }
+    }
+  }
+
+  if (next > point) {
+    downCount = 0;
+    setPoint(next);
+  } else if (next < point) {
+    if (++downCount >= config.downWindows) {
+      downCount = 0;
+      setPoint(next);
+    }
+  } else {
+    downCount = 0;
+  }
+}
+
+/***************************************************************************//**
+ * @brief
+ *   End of a governor window
+ ******************************************************************************/
+void RTCC_IRQHandler(void)
+{
+  uint32_t now = RTCC_CounterGet();
+
+  RTCC_IntClear(DVFS_RTCC_IF);
+  windowEnd += config.windowTicks;
+  RTCC_ChannelCCVSet(DVFS_RTCC_CHANNEL, windowEnd);
+
+  govern(now);
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Start the governor at the fastest operating point
+ *
+ * @details
+ *   The RTCC runs from the LFRCO and times the windows and the work of the
+ *   tasks, so the measurements do not depend on the core clock and go on
+ *   in EM1. The HFPERCLK follows the core clock, peripherals clocked from
+ *   it see each change.
+ *
+ * @param[in] cfg
+ *   Operating points, slowest first, and governor settings
+ *
+ * @return
+ *   false if a setting is out of range
+ ******************************************************************************/
+bool DVFS_Init(const DVFS_Config_t *cfg)
+{
+  RTCC_Init_TypeDef rtccInit = RTCC_INIT_DEFAULT;
+  RTCC_CCChConf_TypeDef compare = RTCC_CH_INIT_COMPARE_DEFAULT;
+  uint32_t i;
+
+  if ((cfg == NULL) || (cfg->points == NULL) || (cfg->pointCount == 0)
+      || (cfg->pointCount > DVFS_MAX_POINTS) || (cfg->windowTicks < 2)
+      || (cfg->targetLoad == 0) || (cfg->targetLoad > 100)
+      || (cfg->upLoad == 0) || (cfg->upLoad > 100)) {
+    return false;
+  }
+  for (i = 0; i < cfg->pointCount; i++) {
+    if (cfg->points[i].lowVoltage
+        && (cfg->points[i].band > CMU_VSCALEEM01_LOWPOWER_VOLTAGE_CLOCK_MAX)) {
+      return false;
+    }
+    if ((i > 0) && (cfg->points[i].band <= cfg->points[i - 1].band)) {
+      return false;
+    }
+    points[i] = cfg->points[i];
+  }
+  config = *cfg;
+  config.points = points;
+
+  for (i = 0; i <= DVFS_MAX_TASKS; i++) {
+    taskTicks[i] = 0;
+    taskLoad[i] = 0;
+  }
+  for (i = 0; i < DVFS_MAX_TASKS; i++) {
+    taskRunning[i] = false;
+  }
+  idleTicks = 0;
+  idling = false;
+  downCount = 0;
+  switches = 0;
+  vscaleErrors = 0;
+
+  point = config.pointCount - 1;
+  setPoint(point);
+
+  CMU_ClockEnable(cmuClock_HFLE, true);
+  CMU_ClockSelectSet(cmuClock_LFE, cmuSelect_LFRCO);
+  CMU_ClockEnable(cmuClock_RTCC, true);
+
+  // Count every LFRCO tick
+  rtccInit.presc = rtccCntPresc_1;
+  rtccInit.prescMode = rtccCntTickPresc;
+  RTCC_Init(&rtccInit);
+
+  windowStart = RTCC_CounterGet();
+  windowEnd = windowStart + config.windowTicks;
+  RTCC_ChannelInit(DVFS_RTCC_CHANNEL, &compare);
+  RTCC_ChannelCCVSet(DVFS_RTCC_CHANNEL, windowEnd);
+
+  RTCC_IntClear(DVFS_RTCC_IF);
+  RTCC_IntEnable(DVFS_RTCC_IF);
+  NVIC_ClearPendingIRQ(RTCC_IRQn);
+  NVIC_EnableIRQ(RTCC_IRQn);
+
+  return true;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Mark the start of a piece of work of a task
+ ******************************************************************************/
+void DVFS_TaskBegin(uint32_t task)
+{
+  CORE_DECLARE_IRQ_STATE;
+
+  if (task >= DVFS_MAX_TASKS) {
+    return;
+  }
+
+  CORE_ENTER_CRITICAL();
+  if (!taskRunning[task]) {
+    taskStart[task] = RTCC_CounterGet();
+    taskRunning[task] = true;
+  }
+  CORE_EXIT_CRITICAL();
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Mark the end of a piece of work of a task
+ ******************************************************************************/
+void DVFS_TaskEnd(uint32_t task)
+{
+  CORE_DECLARE_IRQ_STATE;
+
+  if (task >= DVFS_MAX_TASKS) {
+    return;
+  }
+
+  CORE_ENTER_CRITICAL();
+  if (taskRunning[task]) {
+    taskTicks[task] += RTCC_CounterGet() - taskStart[task];
+    taskRunning[task] = false;
+  }
+  CORE_EXIT_CRITICAL();
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Sleep in EM1 until the next interrupt, counted as idle time
+ *
+ * @details
+ *   The interrupt that wakes the CPU runs once the idle time is counted,
+ *   so a window ending in the sleep sees it up to its end.
+ ******************************************************************************/
+void DVFS_Idle(void)
+{
+  CORE_DECLARE_IRQ_STATE;
+
+  CORE_ENTER_CRITICAL();
+  idleStart = RTCC_CounterGet();
+  idling = true;
+  EMU_EnterEM1();
+  idleTicks += RTCC_CounterGet() - idleStart;
+  idling = false;
+  CORE_EXIT_CRITICAL();
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Index of the current operating point in the configuration
+ ******************************************************************************/
+uint32_t DVFS_GetPoint(void)
+{
+  return point;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Filtered workload of a task in core clock cycles per second.
+ *   DVFS_MAX_TASKS returns the busy time outside any task.
+ ******************************************************************************/
+uint32_t DVFS_GetTaskLoad(uint32_t task)
+{
+  if (task > DVFS_MAX_TASKS) {
+    return 0;
+  }
+  return taskLoad[task];
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Busy % of the last window
+ ******************************************************************************/
+uint32_t DVFS_GetLoad(void)
+{
+  return load;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Changes of the operating point since DVFS_Init()
+ ******************************************************************************/
+uint32_t DVFS_GetSwitchCount(void)
+{
+  return switches;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Changes after which EMU_VScaleGet() did not read back the voltage
+ *   scale of the new operating point
+ ******************************************************************************/
+uint32_t DVFS_GetVScaleErrorCount(void)
+{
+  return vscaleErrors;
+}
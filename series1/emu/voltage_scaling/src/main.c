@@ -44,6 +44,27 @@
 
 #include "em_ramfunc.h"
 
+#include "dvfs.h"
+
+// Governor window of 328 LFRCO ticks, about 10 ms
+#define DVFS_WINDOW_TICKS   328
+
+// Run the workload at 70% of the clock, jump to the fastest point at 90%
+// busy and only step down after 10 windows (100 ms) wanting less
+#define DVFS_TARGET_LOAD    70
+#define DVFS_UP_LOAD        90
+#define DVFS_DOWN_WINDOWS   10
+
+// Workload task of the PB0 bursts
+#define TASK_BURST          0
+
+// Each PB0 press computes fib(BURST_FIB) BURST_LENGTH times
+#define BURST_FIB           24
+#define BURST_LENGTH        16
+
+static volatile bool burstRequested;
+static volatile uint32_t bursts;
+
 /**************************************************************************//**
  * @brief GPIO initialization
  *****************************************************************************/
@@ -67,64 +88,13 @@ void initGpio(void)
   NVIC_EnableIRQ(GPIO_ODD_IRQn);
 }
 
-/**************************************************************************//**
- * @brief  Scale Voltage Down
- *****************************************************************************/
-void scaleDown(CMU_HFRCOFreq_TypeDef freq)
-{
-  // HFCLK must be < CMU_VSCALEEM01_LOWPOWER_VOLTAGE_CLOCK_MAX (20 MHz) before scaling down
-  if (freq > CMU_VSCALEEM01_LOWPOWER_VOLTAGE_CLOCK_MAX)
-  {
-    freq = cmuHFRCOFreq_19M0Hz;
-  }
-
-  CMU_HFRCOBandSet(freq);
-
-  // EM0 and 1 initialization structure
-  EMU_EM01Init_TypeDef vsInit;
-
-  // Scaling down from VSCALE2 (1.2 V) to VSCALE0 (1.0 V)
-  vsInit.vScaleEM01LowPowerVoltageEnable = true;
-
-  // Flash wait state at VSCALE0 will be set during scaling voltage down
-  EMU_EM01Init(&vsInit);
-}
-
-/**************************************************************************//**
- * @brief Scale Voltage Up
- *****************************************************************************/
-void scaleUp(CMU_HFRCOFreq_TypeDef freq)
-{
-  // EM0 and 1 initialization structure
-  EMU_EM01Init_TypeDef vsInit;
-
-  // Scaling up from VSCALE0 (1.0 V) to VSCALE2 (1.2 V)
-  vsInit.vScaleEM01LowPowerVoltageEnable = false;
-
-  // Flash wait state at VSCALE2 will be restored during scaling voltage up
-  EMU_EM01Init(&vsInit);
-
-  // HFCLK can now be restored after scaling up
-  CMU_HFRCOBandSet(freq);
-}
-
 /**************************************************************************//**
  * @brief Push Button handler
  *****************************************************************************/
 void GPIO_Handler(void)
 {
-  EMU_VScaleEM01_TypeDef vscale;
-
-  vscale = EMU_VScaleGet();
-
-  if (vscale == emuVScaleEM01_HighPerformance)
-  {
-    scaleDown(cmuHFRCOFreq_19M0Hz);
-  }
-  else
-  {
-    scaleUp(cmuHFRCOFreq_19M0Hz);
-  }
+  // The governor picks the clock and voltage for the burst
+  burstRequested = true;
 
   // Clear all even pin interrupt flags
   GPIO_IntClear(1 << BSP_GPIO_PB0_PIN);
@@ -161,24 +131,19 @@ uint32_t fib(uint32_t n)
 SL_RAMFUNC_DEFINITION_END
 
 /**************************************************************************//**
- * @brief  Runs the processor for profiling purposes
+ * @brief  Runs the processor for a burst of BURST_LENGTH fibonacci numbers
  *****************************************************************************/
 SL_RAMFUNC_DEFINITION_BEGIN
-int fibLoop(void)
+void fibBurst(void)
 {
-  // Infinite loop
-  while(1)
-  {
-    volatile uint32_t temp;
-
-    for(uint32_t i=0; i<0xFFF; i++)
-    {
-      temp = fib(i);
-    }
+  volatile uint32_t temp;
 
-    (void)temp;
+  for (uint32_t i = 0; i < BURST_LENGTH; i++)
+  {
+    temp = fib(BURST_FIB);
   }
 
+  (void)temp;
 }
 SL_RAMFUNC_DEFINITION_END
 
@@ -187,11 +152,41 @@ SL_RAMFUNC_DEFINITION_END
  *****************************************************************************/
 int main(void)
 {
+  const DVFS_Point_t dvfsPoints[] = DVFS_POINTS_DEFAULT;
+  DVFS_Config_t dvfsConfig;
+
   CHIP_Init();
 
   // Configure PB0
   initGpio();
 
-  // Calculate fibonacci numbers to work-out CPU
-  fibLoop();
+  // Start the governor, at the fastest point
+  dvfsConfig.points = dvfsPoints;
+  dvfsConfig.pointCount = sizeof(dvfsPoints) / sizeof(dvfsPoints[0]);
+  dvfsConfig.windowTicks = DVFS_WINDOW_TICKS;
+  dvfsConfig.targetLoad = DVFS_TARGET_LOAD;
+  dvfsConfig.upLoad = DVFS_UP_LOAD;
+  dvfsConfig.downWindows = DVFS_DOWN_WINDOWS;
+  if (!DVFS_Init(&dvfsConfig))
+  {
+    while(1);
+  }
+
+  // Infinite loop
+  while(1)
+  {
+    if (burstRequested)
+    {
+      burstRequested = false;
+
+      // Calculate fibonacci numbers to work-out CPU
+      DVFS_TaskBegin(TASK_BURST);
+      fibBurst();
+      DVFS_TaskEnd(TASK_BURST);
+      bursts++;
+    }
+
+    // Idle time drops the clock and voltage
+    DVFS_Idle();
+  }
 }
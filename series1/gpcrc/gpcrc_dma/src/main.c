@@ -33,10 +33,12 @@
  * at the sole discretion of Silicon Labs.
  ******************************************************************************/
 
+
 #include <stdio.h>
 #include "em_device.h"
 #include "em_chip.h"
 #include "em_cmu.h"
+#include "em_core.h"
 #include "em_gpcrc.h"
 #include "em_ldma.h"
 #include "em_emu.h"
@@ -48,30 +50,57 @@ typedef uint32_t crc_t;
 
 
 #define WIDTH       (8 * sizeof(crc_t))
-#define TOPBIT      (1 << (WIDTH - 1))
 #define POLYNOMIAL  0x04C11DB7
 #define PRESET      0xFFFFFFFF
 
+// Bit reversed polynomial, the GPCRC shifts data in LSB first
+#define POLYNOMIAL_REVERSED 0xEDB88320
+
 // DMA channel used
 #define LDMA_CHANNEL        0
-#define LDMA_CH_MASK        1 << LDMA_CHANNEL
+
+// Longest transfer of a single descriptor
+#define CHUNK_WORDS   ((_LDMA_CH_CTRL_XFERCNT_MASK >> _LDMA_CH_CTRL_XFERCNT_SHIFT) + 1)
+
+// Whole chunks after the first are done by one looping descriptor, the loop
+// counter is 8 bits wide
+#define MAX_CHUNKS    (1 + (_LDMA_CH_LOOP_LOOPCNT_MASK >> _LDMA_CH_LOOP_LOOPCNT_SHIFT) + 1)
+
+// Leading bytes, first chunk, looped chunks, remaining words, trailing
+// bytes and the result read
+#define MAX_DESCRIPTORS     6
+
+// Note: change these to change the RAM buffer that is checked. The odd offset
+// and size show the byte transfers at each end of the word transfers.
+#define DATA_SIZE     5003
+#define DATA_OFFSET   1
+
+// Note: change this to change the size of the flash region that is checked,
+// starting at the start of flash
+#define FLASH_CHECK_SIZE  (64 * 1024)
 
 // Descriptor linked list for LDMA transfer
-LDMA_Descriptor_t descLink[2];
+LDMA_Descriptor_t descLink[MAX_DESCRIPTORS];
 
-// Arbitrary values to cycle through
-uint32_t data[4] = {0, 1, 2, 3};
+// Buffer with arbitrary values to check
+uint8_t data[DATA_SIZE + DATA_OFFSET];
 
-volatile uint32_t   source;
 volatile uint32_t   result;
-volatile uint32_t   i;
+volatile bool       crcDone;
+
+// GPCRC results for the RAM buffer and the flash region, and the software
+// values to compare with
+uint32_t   ramResult;
+uint32_t   flashResult;
+uint32_t   ramSoftResult;
+uint32_t   flashSoftResult;
 
-volatile crc_t      crcTable[256];
+crc_t      crcTable[256];
 
 
 /***************************************************************************//**
  * @brief
- *   Initialize software ctcTable array for fast translations.
+ *   Initialize software crcTable array for fast translations.
  ******************************************************************************/
 void initSoft(void)
 {
@@ -80,17 +109,18 @@ void initSoft(void)
   // Compute the remainder of each possible dividend
   for (int i = 0; i < 256; ++i)
   {
-    // Start with the dividend followed by zeros
-    remainder = i << (WIDTH - 8);
+    // The GPCRC shifts data in LSB first, so the table is built with the
+    // bit reversed polynomial
+    remainder = i;
 
     // Perform modulo-2 division, a bit at a time
     for (uint8_t bit = 8; bit > 0; --bit)
     {
-      // XOR with polynomial if top bit is 1
-      if (remainder & (uint32_t)TOPBIT)
-        remainder = (remainder << 1) ^ POLYNOMIAL;
+      // XOR with polynomial if bottom bit is 1
+      if (remainder & 1)
+        remainder = (remainder >> 1) ^ POLYNOMIAL_REVERSED;
       else
-        remainder = (remainder << 1);
+        remainder = (remainder >> 1);
     }
     // Store the result into the table
     crcTable[i] = remainder;
@@ -99,24 +129,17 @@ void initSoft(void)
 
 /***************************************************************************//**
  * @brief
- *   Software CRC calculation function
+ *   Software CRC calculation function, gives the same result as the GPCRC
+ *   fed with the same bytes
  ******************************************************************************/
-crc_t softCrc(crc_t message, crc_t preset)
+crc_t softCrc(const uint8_t *message, uint32_t length, crc_t preset)
 {
-  uint8_t data, thisByte;
   crc_t remainder = preset;
 
   // Divide the message by the polynomial, a byte at a time
-  for (int byte = 0; byte < sizeof(crc_t); ++byte)
+  for (uint32_t byte = 0; byte < length; ++byte)
   {
-    // Separate out one byte of the message
-    thisByte = (message >> (8*byte)) & 0x0FF;
-
-    // XOR this byte with the current remainder
-    data = thisByte ^ (remainder >> (WIDTH - 8));
-
-    // Set new remainder
-    remainder = crcTable[data] ^ (remainder << 8);
+    remainder = crcTable[(remainder ^ message[byte]) & 0xFF] ^ (remainder >> 8);
   }
   // The final remainder is the CRC
   return (remainder);
@@ -143,39 +166,163 @@ void LDMA_IRQHandler( void )
   // Clear interrupts
   LDMA_IntClear(pending);
 
-  source = data[(++i)%4];
-
-  // Request next transfer
-  LDMA->SWREQ |= LDMA_CH_MASK;
+  // The last descriptor has copied the CRC into result
+  crcDone = true;
+}
 
+/***************************************************************************//**
+ * @brief
+ *   Fill in a descriptor that feeds count words or bytes to the GPCRC
+ *
+ * @note
+ *   See README for why a "M2M" (Memory to memory) descriptor is used here.
+ *   The destination increment is turned off so every unit goes to the same
+ *   GPCRC input register.
+ ******************************************************************************/
+static void setInputDescriptor(LDMA_Descriptor_t *desc, const void *src,
+                               uint32_t count, bool word)
+{
+  if (word)
+  {
+    *desc = (LDMA_Descriptor_t)LDMA_DESCRIPTOR_LINKREL_M2M_WORD(src, &(GPCRC->INPUTDATA), count, 1);
+  }
+  else
+  {
+    *desc = (LDMA_Descriptor_t)LDMA_DESCRIPTOR_LINKREL_M2M_BYTE(src, &(GPCRC->INPUTDATABYTE), count, 1);
+  }
+  desc->xfer.dstInc = ldmaCtrlDstIncNone;
 }
 
 /***************************************************************************//**
  * @brief
- *   Initialize the LDMA controller for descriptor list with looping
+ *   Start a CRC of any memory region, RAM or flash, with the LDMA.
+ *
+ * @details
+ *   The region is split into leading bytes up to the first word boundary,
+ *   word transfers of up to CHUNK_WORDS each and trailing bytes. All chunks
+ *   but the first and the last are done by one descriptor that loops on
+ *   itself, continuing from the current source address. Each descriptor
+ *   moves its whole block on one request, so the data is fed at bus speed.
+ *   A final descriptor copies GPCRC->DATA to result and raises the
+ *   interrupt.
+ *
+ * @param[in] start
+ *   First byte of the region, no alignment needed.
+ *
+ * @param[in] length
+ *   Number of bytes.
+ *
+ * @return
+ *   false if the region needs more chunks than the loop counter allows.
  ******************************************************************************/
-void initLdma(void)
+bool crcStart(const void *start, uint32_t length)
 {
+  const uint8_t *src = start;
+  uint32_t head = (4 - ((uint32_t)src & 3)) & 3;
+  uint32_t words, tail, chunks, rest;
+  uint32_t n = 0;
 
-  LDMA_Init_t init = LDMA_INIT_DEFAULT;
-  LDMA_Init( &init );
+  if (head > length)
+  {
+    head = length;
+  }
+  words  = (length - head) / 4;
+  tail   = (length - head) % 4;
+  chunks = words / CHUNK_WORDS;
+  rest   = words % CHUNK_WORDS;
+
+  if (chunks > MAX_CHUNKS)
+  {
+    return false;
+  }
+
+  // Loop count for the looping descriptor, unused if there is none
+  LDMA_TransferCfg_t transferConfig =
+      LDMA_TRANSFER_CFG_MEMORY_LOOP(chunks > 1 ? chunks - 2 : 0);
+
+  // Leading bytes up to the first word boundary
+  if (head > 0)
+  {
+    setInputDescriptor(&descLink[n++], src, head, false);
+    src += head;
+  }
 
-  // Use looped peripheral transfer configuration macro
-  LDMA_TransferCfg_t transferConfig = LDMA_TRANSFER_CFG_MEMORY();
+  // First whole chunk
+  if (chunks > 0)
+  {
+    setInputDescriptor(&descLink[n++], src, CHUNK_WORDS, true);
+    src += CHUNK_WORDS * 4;
+  }
+
+  // Remaining whole chunks, repeating one descriptor that picks up the
+  // source address where the previous chunk stopped
+  if (chunks > 1)
+  {
+    setInputDescriptor(&descLink[n], 0, CHUNK_WORDS, true);
+    descLink[n].xfer.srcAddrMode = ldmaCtrlSrcAddrModeRel;
+    descLink[n].xfer.decLoopCnt  = 1;
+    descLink[n].xfer.linkAddr    = 0;
+    n++;
+    src += (chunks - 1) * CHUNK_WORDS * 4;
+  }
 
-  // LINK descriptor macros for looping, SINGLE descriptor macro for single transfer
-  // See README for explanation of why a "M2M" (Memory to memory) transfer is used here instead
-  // of a M2P (Memory to Peripheral) or P2M (Peripheral to Memory)
-  descLink[0] = (LDMA_Descriptor_t)LDMA_DESCRIPTOR_LINKREL_M2M_WORD(&source, &(GPCRC->INPUTDATA), 1, 1);
-  descLink[1] = (LDMA_Descriptor_t)LDMA_DESCRIPTOR_LINKREL_M2M_WORD(&(GPCRC->DATA), &result, 1, -1);
+  // Words that don't fill a chunk
+  if (rest > 0)
+  {
+    setInputDescriptor(&descLink[n++], src, rest, true);
+    src += rest * 4;
+  }
+
+  // Trailing bytes
+  if (tail > 0)
+  {
+    setInputDescriptor(&descLink[n++], src, tail, false);
+  }
 
-  // Enable interrupt after second descriptor
-  descLink[1].xfer.doneIfs = true;
+  // Pick up the result, this also resets GPCRC_DATA through autoInit
+  descLink[n] = (LDMA_Descriptor_t)LDMA_DESCRIPTOR_SINGLE_M2M_WORD(&(GPCRC->DATA), &result, 1);
+  descLink[n].xfer.doneIfs = true;
 
-  // Disable automatic triggers for first descriptor
-  descLink[0].xfer.structReq = false;
+  crcDone = false;
+
+  // Start from the preset value
+  GPCRC_Start(GPCRC);
 
   LDMA_StartTransfer(LDMA_CHANNEL, (void*)&transferConfig, (void*)&descLink);
+
+  return true;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Sleep in EM1 until the CRC started by crcStart() is done
+ ******************************************************************************/
+uint32_t crcWait(void)
+{
+  CORE_DECLARE_IRQ_STATE;
+
+  while (!crcDone)
+  {
+    // Check again with interrupts masked so the LDMA interrupt can't
+    // slip in between the check and the sleep; it still wakes the core
+    CORE_ENTER_CRITICAL();
+    if (!crcDone)
+    {
+      EMU_EnterEM1();
+    }
+    CORE_EXIT_CRITICAL();
+  }
+  return result;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Initialize the LDMA controller
+ ******************************************************************************/
+void initLdma(void)
+{
+  LDMA_Init_t init = LDMA_INIT_DEFAULT;
+  LDMA_Init( &init );
 }
 
 /**************************************************************************//**
@@ -218,12 +365,23 @@ int main(void)
   // Initialize array for software method
   initSoft();
 
-  // Set up global variables
-  i = 0;
-  source = data[i++];
+  // Fill the buffer with arbitrary values
+  for (uint32_t i = 0; i < sizeof(data); i++)
+  {
+    data[i] = (uint8_t)(i * 7 + 3);
+  }
+
+  // CRC of an unaligned RAM buffer
+  crcStart(&data[DATA_OFFSET], DATA_SIZE);
+  ramResult = crcWait();
+
+  // CRC of the start of flash, as done to verify a firmware image at boot
+  crcStart((const void *)FLASH_BASE, FLASH_CHECK_SIZE);
+  flashResult = crcWait();
 
-  // Request first transfer
-  LDMA->SWREQ |= LDMA_CH_MASK;
+  // Same CRCs in software for comparison
+  ramSoftResult = softCrc(&data[DATA_OFFSET], DATA_SIZE, PRESET);
+  flashSoftResult = softCrc((const uint8_t *)FLASH_BASE, FLASH_CHECK_SIZE, PRESET);
 
   // Infinite loop
   while(1){
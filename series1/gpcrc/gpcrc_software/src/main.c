@@ -38,6 +38,9 @@
 #include "em_chip.h"
 #include "em_cmu.h"
 #include "em_gpcrc.h"
+#include "retargetserial.h"
+#include "benchmark.h"
+#include "crc32.h"
 
 /* The width of the CRC calculation and result.
  * Modify the typedef for a 16 or 32-bit CRC standard. */
@@ -57,6 +60,14 @@ volatile uint32_t   source[ARRAY_SIZE];
 volatile uint32_t   results[ARRAY_SIZE];
 volatile uint32_t   softResults[ARRAY_SIZE];
 
+// Buffer for the bitwise, table, slice-by-4/8 and GPCRC comparison
+#define BUFFER_SIZE 1024
+
+static uint32_t     buffer[BUFFER_SIZE / 4];
+
+volatile uint32_t   bufferCrc[5];
+volatile bool       bufferMatch;
+
 
 void initSoft(void)
 {
@@ -125,13 +136,78 @@ void initGpcrc (void)
   GPCRC_Start(GPCRC);
 }
 
+/**************************************************************************//**
+ * @brief  Feed a word aligned buffer to the GPCRC and return the CRC
+ *****************************************************************************/
+uint32_t gpcrcBuffer(const uint32_t *data, uint32_t words)
+{
+  for (uint32_t i = 0; i < words; i++)
+  {
+    GPCRC_InputU32(GPCRC, data[i]);
+  }
+  return GPCRC_DataReadBitReversed(GPCRC);
+}
+
+/**************************************************************************//**
+ * @brief  Compare the software CRC32 variants with the GPCRC over a buffer
+ * @details
+ *   The crc32 component gives the same result as the GPCRC with reverseBits
+ *   set and the bit reversed data read, so each variant can be used where
+ *   there is no GPCRC (series 0) or on the host.
+ *****************************************************************************/
+void bufferBenchmark(void)
+{
+  uint32_t start;
+
+  for (int i = 0; i < BUFFER_SIZE / 4; i++) {
+    buffer[i] = (1 + i) * STRIDE;
+  }
+
+  // Builds the tables in RAM, 8 KB for slice-by-8
+  CRC32_Init();
+
+  BENCHMARK_START(start);
+  bufferCrc[0] = CRC32_Bitwise(CRC32_PRESET, buffer, BUFFER_SIZE);
+  BENCHMARK_STOP("crc32 bitwise", start, BUFFER_SIZE);
+
+  BENCHMARK_START(start);
+  bufferCrc[1] = CRC32_Table(CRC32_PRESET, buffer, BUFFER_SIZE);
+  BENCHMARK_STOP("crc32 table", start, BUFFER_SIZE);
+
+  BENCHMARK_START(start);
+  bufferCrc[2] = CRC32_Slice4(CRC32_PRESET, buffer, BUFFER_SIZE);
+  BENCHMARK_STOP("crc32 slice-by-4", start, BUFFER_SIZE);
+
+  BENCHMARK_START(start);
+  bufferCrc[3] = CRC32_Slice8(CRC32_PRESET, buffer, BUFFER_SIZE);
+  BENCHMARK_STOP("crc32 slice-by-8", start, BUFFER_SIZE);
+
+  BENCHMARK_START(start);
+  bufferCrc[4] = gpcrcBuffer(buffer, BUFFER_SIZE / 4);
+  BENCHMARK_STOP("crc32 gpcrc buffer", start, BUFFER_SIZE);
+
+  bufferMatch = true;
+  for (int i = 1; i < 5; i++) {
+    if (bufferCrc[i] != bufferCrc[0]) {
+      bufferMatch = false;
+    }
+  }
+}
+
 /**************************************************************************//**
  * @brief  Main function
  *****************************************************************************/
 int main(void)
 {
+  uint32_t start;
+
   CHIP_Init();
 
+  // Cycle counter and serial port for the benchmark results
+  BENCHMARK_Init();
+  RETARGET_SerialInit();
+  RETARGET_SerialCrLf(1);
+
   // Fill source array with arbitrary values
   for (int i = 0; i < ARRAY_SIZE; i++){
     source[i] = (1 + i) * STRIDE;
@@ -146,15 +222,26 @@ int main(void)
   for (int i = 0; i < ARRAY_SIZE; i++)
   {
     // Get software CRC result
+    BENCHMARK_START(start);
     softResults[i] = softCrc(source[i], PRESET);
+    BENCHMARK_STOP("crc32 software", start, sizeof(crc_t));
 
     // Feed in source
+    BENCHMARK_START(start);
     GPCRC_InputU32(GPCRC, source[i]);
 
     // Read result
     results[i] = GPCRC_DataReadBitReversed(GPCRC);
+    BENCHMARK_STOP("crc32 gpcrc", start, sizeof(uint32_t));
   }
 
+  // Time the software variants and the GPCRC over a larger buffer
+  bufferBenchmark();
+
+  printf("\ngpcrc_software, %d words, %d byte buffer\n", ARRAY_SIZE, BUFFER_SIZE);
+  printf("buffer CRCs %s\n", bufferMatch ? "match" : "differ");
+  BENCHMARK_Print();
+
   // Infinite loop
   while(1);
 }
@@ -0,0 +1,207 @@
+/***************************************************************************//**
+ * @file main.c
+ * @brief Verify memory regions against a CRC-32 at boot and when idle
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2020 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ *******************************************************************************
+ * # Evaluation Quality
+ * This code has been minimally tested to ensure that it builds and is suitable 
+ * as a demonstration for evaluation purposes only. This code will be maintained
+ * at the sole discretion of Silicon Labs.
+ ******************************************************************************/
+
+
+#include "em_device.h"
+#include "em_chip.h"
+#include "em_cmu.h"
+#include "em_core.h"
+#include "em_ldma.h"
+#include "em_emu.h"
+#include "crcverify.h"
+
+// DMA channel used
+#define LDMA_CHANNEL        0
+
+// Note: change this to change the size of the flash region that is checked,
+// starting at the start of flash
+#define FLASH_CHECK_SIZE    (64 * 1024)
+
+// Bytes re-verified per pass of the idle loop
+#define SLICE_SIZE          (4 * 1024)
+
+// Standard CRC-32 check input and its known result
+static const char checkString[] = "123456789";
+#define CHECK_CRC           0xCBF43926
+
+// Results, view these in the debugger
+volatile bool       checkPassed;        // CRC-32 of checkString is correct
+volatile uint32_t   imageCrc;           // CRC-32 of the flash region
+volatile uint32_t   passCount;          // Idle passes that matched imageCrc
+volatile uint32_t   failCount;          // Idle passes that did not match
+
+static volatile bool verifyDone;
+static volatile bool verifyPassed;
+
+/***************************************************************************//**
+ * @brief
+ *   LDMA IRQ handler, forwards to the verify component
+ ******************************************************************************/
+void LDMA_IRQHandler( void )
+{
+  // Check for LDMA error
+  if ( LDMA_IntGet() & LDMA_IF_ERROR )
+  {
+    // Loop here to enable the debugger to see what has happened
+    while (1);
+  }
+
+  CRCVERIFY_IRQHandler();
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Called at the end of a boot time check
+ ******************************************************************************/
+static void bootCheckDone(bool passed, uint32_t crc)
+{
+  (void)crc;
+
+  verifyPassed = passed;
+  verifyDone = true;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Called at the end of every idle re-verification pass
+ ******************************************************************************/
+static void idleCheckDone(bool passed, uint32_t crc)
+{
+  (void)crc;
+
+  if (passed)
+  {
+    passCount++;
+  }
+  else
+  {
+    failCount++;
+  }
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Sleep in EM1 until the boot time check is done
+ ******************************************************************************/
+static bool waitCheck(void)
+{
+  CORE_DECLARE_IRQ_STATE;
+
+  while (!verifyDone)
+  {
+    // Check again with interrupts masked so the LDMA interrupt can't
+    // slip in between the check and the sleep; it still wakes the core
+    CORE_ENTER_CRITICAL();
+    if (!verifyDone)
+    {
+      EMU_EnterEM1();
+    }
+    CORE_EXIT_CRITICAL();
+  }
+  return verifyPassed;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Check a region in the background at boot
+ ******************************************************************************/
+static void startBootCheck(const void *start, uint32_t length, uint32_t expected)
+{
+  CRCVERIFY_Init_t init;
+
+  init.channel   = LDMA_CHANNEL;
+  init.start     = start;
+  init.length    = length;
+  init.expected  = expected;
+  init.sliceSize = 0;
+  init.callback  = bootCheckDone;
+
+  verifyDone = false;
+  CRCVERIFY_Init(&init);
+  CRCVERIFY_Start();
+}
+
+/**************************************************************************//**
+ * @brief  Main function
+ *****************************************************************************/
+int main(void)
+{
+  CRCVERIFY_Init_t init;
+  CORE_DECLARE_IRQ_STATE;
+
+  CHIP_Init();
+
+  // Initialize LDMA
+  LDMA_Init_t ldmaInit = LDMA_INIT_DEFAULT;
+  LDMA_Init( &ldmaInit );
+
+  // Check the component itself against the standard check value
+  startBootCheck(checkString, sizeof(checkString) - 1, CHECK_CRC);
+  checkPassed = waitCheck();
+
+  // Check the flash region in the background. A real application would
+  // take the expected value from the image header written by the build,
+  // here the first pass records it and the idle passes compare against it.
+  startBootCheck((const void *)FLASH_BASE, FLASH_CHECK_SIZE, 0);
+
+  // The rest of the system would be initialized here while the LDMA feeds
+  // the GPCRC
+
+  waitCheck();
+  imageCrc = CRCVERIFY_GetCrc();
+
+  // Re-verify the region a slice at a time from the idle loop
+  init.channel   = LDMA_CHANNEL;
+  init.start     = (const void *)FLASH_BASE;
+  init.length    = FLASH_CHECK_SIZE;
+  init.expected  = imageCrc;
+  init.sliceSize = SLICE_SIZE;
+  init.callback  = idleCheckDone;
+  CRCVERIFY_Init(&init);
+
+  // Infinite loop
+  while(1){
+    // Application work would go here
+
+    // Start the next slice, the LDMA interrupt at its end wakes the core
+    CRCVERIFY_Slice();
+    CORE_ENTER_CRITICAL();
+    if (CRCVERIFY_IsRunning())
+    {
+      EMU_EnterEM1();
+    }
+    CORE_EXIT_CRITICAL();
+  }
+}
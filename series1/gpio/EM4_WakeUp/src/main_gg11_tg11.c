@@ -49,6 +49,59 @@
 
 #define EM4_RSTCAUSE_MASK	RMU_RSTCAUSE_EM4RST
 
+// Presses counted in EM4 for each full wake that toggles the LEDs
+#define PRESSES_PER_WAKE    4
+
+// RTCC retention register that keeps the press count through EM4H
+#define PRESS_COUNT_RET     0
+
+// Presses counted so far, for the debugger
+uint32_t pressCount;
+
+/**************************************************************************//**
+ * @brief
+ *   Handle a button wake from EM4 before any other initialization
+ *
+ * @details
+ *   Called first in main(), before CHIP_Init() and the GPIO setup. A press
+ *   only counts up in an RTCC retention register, which keeps its value in
+ *   EM4H, and goes straight back to EM4H once the button is released. Only
+ *   every PRESSES_PER_WAKE press returns for the full initialization. Any
+ *   other wake returns at once. The RTCC itself is not clocked, its
+ *   retention registers only need the low energy bus clock.
+ *****************************************************************************/
+void fastWake(void)
+{
+  uint32_t presses;
+
+  CMU_ClockEnable(cmuClock_GPIO, true);
+
+  // Only an EM4 wake by the button is handled here
+  if ((RMU_ResetCauseGet() != EM4_RSTCAUSE_MASK)
+      || !(GPIO_EM4GetPinWakeupCause()
+           & (EM4WU_EM4WUEN_MASK << _GPIO_EM4WUEN_EM4WUEN_SHIFT)))
+  {
+    return;
+  }
+
+  CMU_ClockEnable(cmuClock_HFLE, true);
+  presses = RTCC->RET[PRESS_COUNT_RET].REG + 1;
+  RTCC->RET[PRESS_COUNT_RET].REG = presses;
+  if (presses % PRESSES_PER_WAKE == 0)
+  {
+    return;
+  }
+
+  RMU_ResetCauseClear();
+
+  // The GPIO is reset by the wake, wait for the release before EM4H again
+  GPIO_PinModeSet(EM4WU_PORT, EM4WU_PIN, gpioModeInputPullFilter, 1);
+  while (GPIO_PinInGet(EM4WU_PORT, EM4WU_PIN) == 0);
+  GPIO_EM4EnablePinWakeup(EM4WU_EM4WUEN_MASK << _GPIO_EM4WUEN_EM4WUEN_SHIFT, 0);
+
+  EMU_EnterEM4H();
+}
+
 /**************************************************************************//**
  * @brief GPIO initialization
  *****************************************************************************/
@@ -88,6 +141,9 @@ void toggleLEDs(void)
  *****************************************************************************/
 int main(void) 
 {
+  // Count a press and go back to EM4H unless a full wake is due
+  fastWake();
+
   // Chip errata
   CHIP_Init();
 
@@ -104,12 +160,18 @@ int main(void)
   // If the last Reset was due to leaving EM4, toggle LEDs. Else, enter EM4
   if (rstCause == EM4_RSTCAUSE_MASK)
   {
+    CMU_ClockEnable(cmuClock_HFLE, true);
+    pressCount = RTCC->RET[PRESS_COUNT_RET].REG;
     toggleLEDs();
   }
   else
   {
+    // Start counting presses from zero, EM4H keeps the count
+    CMU_ClockEnable(cmuClock_HFLE, true);
+    RTCC->RET[PRESS_COUNT_RET].REG = 0;
+
     for (volatile uint32_t delay = 0; delay < 0xFFF; delay++);
-    EMU_EnterEM4();
+    EMU_EnterEM4H();
   }
 
   // Will never get here!
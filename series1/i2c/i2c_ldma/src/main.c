@@ -0,0 +1,619 @@
+/***************************************************************************//**
+ * @file main.c
+ * @brief This project reads a 512 byte sensor FIFO from another EFM32 over
+ * I2C, once with the emlib transfer state machine run from the I2C interrupt
+ * and once with the LDMA moving the data bytes, and compares the bus time and
+ * the CPU load of the two. The slave side serves its FIFO with the LDMA too.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2020 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ *******************************************************************************
+ * # Evaluation Quality
+ * This code has been minimally tested to ensure that it builds and is suitable 
+ * as a demonstration for evaluation purposes only. This code will be maintained
+ * at the sole discretion of Silicon Labs.
+ ******************************************************************************/
+ 
+#include <stdio.h>
+#include <string.h>
+#include "em_device.h"
+#include "em_chip.h"
+#include "em_i2c.h"
+#include "em_cmu.h"
+#include "em_core.h"
+#include "em_emu.h"
+#include "em_gpio.h"
+#include "em_ldma.h"
+#include "bsp.h"
+
+// Defines
+#define I2C_ADDRESS                     0xE2
+#define I2C_ADDRESS_MASK                0xFE // Must match exact I2C_ADDRESS
+#define I2C_RXBUFFER_SIZE                 10
+
+// Register the master writes before reading the FIFO, as on an IMU
+#define FIFO_REG                        0x74
+
+// Bytes read from the FIFO in one transfer
+#define FIFO_BYTES                       512
+
+// LDMA channels of the slave and of the master
+#define SLAVE_RX_CHANNEL                   0
+#define SLAVE_TX_CHANNEL                   1
+#define MASTER_RX_CHANNEL                  2
+
+// Exception entry and return, not seen by the handler cycle counts
+#define IRQ_ENTRY_EXIT_CYCLES             24
+
+// Master interrupts, the slave only uses ADDR and SSTOP
+#define MASTER_INTERRUPTS  (I2C_IEN_ACK | I2C_IEN_NACK | I2C_IEN_MSTOP \
+                         | I2C_IEN_ARBLOST | I2C_IEN_BUSERR)
+
+// Who the I2C interrupt belongs to
+typedef enum {
+  modeSlave,
+  modeInterrupt,
+  modeLdma,
+} Mode_t;
+
+// Steps of the LDMA read, only the bus events between data phases
+typedef enum {
+  stateAddrWrite,
+  stateRegWrite,
+  stateAddrRead,
+  stateData,
+  stateLast,
+  stateStop,
+} State_t;
+
+// Result of one FIFO read, watch "results" in the debugger
+typedef struct {
+  uint32_t bytes;           // Bytes read and checked
+  uint32_t busUs;           // From START to the end of STOP
+  uint32_t bytesPerSecond;  // Throughput
+  uint32_t interrupts;      // I2C and LDMA handler runs
+  uint32_t handlerCycles;   // Core cycles in the handlers, entry included
+  uint32_t cpuLoad;         // Handler share of the bus time, in 0.1 %
+  bool     ok;              // Transfer completed and the data matched
+} Result_t;
+
+// Buffers++
+uint8_t i2c_fifo[FIFO_BYTES];
+uint8_t i2c_readBuffer[FIFO_BYTES];
+uint8_t i2c_rxBuffer[I2C_RXBUFFER_SIZE];
+uint32_t i2c_rxCount;
+uint32_t i2c_txCount;
+
+// Transmission flags
+volatile bool i2c_rxInProgress;
+volatile bool i2c_startTx;
+
+// Master transfer
+static uint8_t fifoReg = FIFO_REG;
+static volatile Mode_t mode;
+static volatile State_t state;
+static volatile bool masterDone;
+static volatile I2C_TransferReturn_TypeDef masterResult;
+
+// Handler statistics, both kits
+volatile uint32_t handlerRuns;
+volatile uint32_t handlerCycles;
+
+// Interrupt driven read first, LDMA read second
+Result_t results[2];
+
+static LDMA_Descriptor_t slaveRxDesc;
+static LDMA_Descriptor_t slaveTxDesc;
+static LDMA_Descriptor_t masterRxDesc;
+
+/**************************************************************************//**
+ * @brief  Starting oscillators and enabling clocks
+ *****************************************************************************/
+void initCMU(void)
+{
+  // Enabling clock to the I2C, GPIO, LE
+  CMU_ClockEnable(cmuClock_I2C0, true);
+  CMU_ClockEnable(cmuClock_GPIO, true);
+  CMU_ClockEnable(cmuClock_HFLE, true);
+
+  // Starting LFXO and waiting until it is stable
+  CMU_OscillatorEnable(cmuOsc_LFXO, true, true);
+
+  // Count core cycles for the bus time and the handler time
+  CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+  DWT->CYCCNT = 0;
+  DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+}
+
+/**************************************************************************//**
+ * @brief GPIO initialization
+ *****************************************************************************/
+void initGPIO(void)
+{
+  // Configure PB0 as input and int
+  GPIO_PinModeSet(BSP_GPIO_PB0_PORT, BSP_GPIO_PB0_PIN, gpioModeInputPull, 1);
+  GPIO_ExtIntConfig(BSP_GPIO_PB0_PORT, BSP_GPIO_PB0_PIN, BSP_GPIO_PB0_PIN, false, true, true);
+
+  // Configure LED0 and LED1 as output
+  GPIO_PinModeSet(BSP_GPIO_LED0_PORT, BSP_GPIO_LED0_PIN, gpioModePushPull, 0);
+  GPIO_PinModeSet(BSP_GPIO_LED1_PORT, BSP_GPIO_LED1_PIN, gpioModePushPull, 0);
+
+
+  NVIC_ClearPendingIRQ(GPIO_EVEN_IRQn);
+  NVIC_EnableIRQ(GPIO_EVEN_IRQn);
+}
+
+/**************************************************************************//**
+ * @brief  enables I2C slave interrupts
+ *****************************************************************************/
+void enableI2cSlaveInterrupts(void)
+{
+  mode = modeSlave;
+  I2C_IntClear(I2C0, I2C_IFC_ADDR | I2C_IFC_SSTOP);
+  I2C_IntEnable(I2C0, I2C_IEN_ADDR | I2C_IEN_SSTOP);
+  NVIC_EnableIRQ(I2C0_IRQn);
+}
+
+/**************************************************************************//**
+ * @brief  disables I2C interrupts
+ *****************************************************************************/
+void disableI2cInterrupts(void)
+{
+  NVIC_DisableIRQ(I2C0_IRQn);
+  I2C_IntDisable(I2C0, _I2C_IEN_MASK);
+  I2C_IntClear(I2C0, _I2C_IFC_MASK);
+}
+
+/**************************************************************************//**
+ * @brief  Setup I2C
+ *****************************************************************************/
+void initI2C(void)
+{
+  // Using default settings
+  I2C_Init_TypeDef i2cInit = I2C_INIT_DEFAULT;
+  // Use ~400khz SCK
+  i2cInit.freq = I2C_FREQ_FAST_MAX;
+  // Use 6:3 low high SCK ratio
+  i2cInit.clhr = i2cClockHLRAsymetric;
+
+  // Using PC10 (SDA) and PC11 (SCL)
+  GPIO_PinModeSet(gpioPortC, 10, gpioModeWiredAndPullUpFilter, 1);
+  GPIO_PinModeSet(gpioPortC, 11, gpioModeWiredAndPullUpFilter, 1);
+
+  // Enable pins at location 15 as specified in datasheet
+  I2C0->ROUTEPEN = I2C_ROUTEPEN_SDAPEN | I2C_ROUTEPEN_SCLPEN;
+  I2C0->ROUTELOC0 = (I2C0->ROUTELOC0 & (~_I2C_ROUTELOC0_SDALOC_MASK)) | I2C_ROUTELOC0_SDALOC_LOC15;
+  I2C0->ROUTELOC0 = (I2C0->ROUTELOC0 & (~_I2C_ROUTELOC0_SCLLOC_MASK)) | I2C_ROUTELOC0_SCLLOC_LOC15;
+
+  // Initializing the I2C
+  I2C_Init(I2C0, &i2cInit);
+
+  // Setting the status flags
+  i2c_rxInProgress = false;
+  i2c_startTx = false;
+
+  // Setting up to enable slave mode
+  I2C0->SADDR = I2C_ADDRESS;
+  I2C0->SADDRMASK = I2C_ADDRESS_MASK;
+  I2C0->CTRL |= I2C_CTRL_SLAVE | I2C_CTRL_AUTOACK | I2C_CTRL_AUTOSN;
+  enableI2cSlaveInterrupts();
+}
+
+/**************************************************************************//**
+ * @brief  Setup the LDMA and the FIFO contents served as a slave
+ *****************************************************************************/
+void initLDMA(void)
+{
+  LDMA_Init_t init = LDMA_INIT_DEFAULT;
+
+  LDMA_Init(&init);
+
+  // The slave channels are ended by SSTOP, they need no done interrupt
+  slaveRxDesc = (LDMA_Descriptor_t)
+    LDMA_DESCRIPTOR_SINGLE_P2M_BYTE(&I2C0->RXDATA, i2c_rxBuffer, I2C_RXBUFFER_SIZE);
+  slaveRxDesc.xfer.doneIfs = 0;
+  slaveTxDesc = (LDMA_Descriptor_t)
+    LDMA_DESCRIPTOR_SINGLE_M2P_BYTE(i2c_fifo, &I2C0->TXDATA, FIFO_BYTES);
+  slaveTxDesc.xfer.doneIfs = 0;
+
+  // All but the last byte, which the master has to NACK
+  masterRxDesc = (LDMA_Descriptor_t)
+    LDMA_DESCRIPTOR_SINGLE_P2M_BYTE(&I2C0->RXDATA, i2c_readBuffer, FIFO_BYTES - 1);
+
+  for (uint32_t i = 0; i < FIFO_BYTES; i++) {
+    i2c_fifo[i] = (uint8_t)i;
+  }
+}
+
+/**************************************************************************//**
+ * @brief  Start the FIFO read with the LDMA moving the data bytes
+ *****************************************************************************/
+void startLdmaRead(void)
+{
+  state = stateAddrWrite;
+  mode = modeLdma;
+
+  // Ensure buffers are empty and acknowledge the data bytes in hardware
+  I2C0->CMD = I2C_CMD_CLEARPC | I2C_CMD_CLEARTX;
+  if (I2C0->IF & I2C_IF_RXDATAV) {
+    (void)I2C0->RXDATA;
+  }
+  I2C_IntClear(I2C0, _I2C_IFC_MASK);
+  I2C0->CTRL |= I2C_CTRL_AUTOACK;
+  I2C_IntEnable(I2C0, MASTER_INTERRUPTS);
+  NVIC_EnableIRQ(I2C0_IRQn);
+
+  // START with the address for a write of the register number
+  I2C0->CMD = I2C_CMD_START;
+  I2C0->TXDATA = I2C_ADDRESS;
+}
+
+/**************************************************************************//**
+ * @brief  Start the FIFO read with the emlib transfer run from the interrupt
+ *****************************************************************************/
+void startInterruptRead(void)
+{
+  static I2C_TransferSeq_TypeDef i2cTransfer;
+  I2C_TransferReturn_TypeDef result;
+
+  // The state machine acknowledges each byte itself
+  I2C0->CTRL &= ~I2C_CTRL_AUTOACK;
+
+  i2cTransfer.addr          = I2C_ADDRESS;
+  i2cTransfer.flags         = I2C_FLAG_WRITE_READ;
+  i2cTransfer.buf[0].data   = &fifoReg;
+  i2cTransfer.buf[0].len    = 1;
+  i2cTransfer.buf[1].data   = i2c_readBuffer;
+  i2cTransfer.buf[1].len    = FIFO_BYTES;
+
+  mode = modeInterrupt;
+  I2C_IntEnable(I2C0, MASTER_INTERRUPTS | I2C_IEN_RXDATAV);
+
+  // I2C_TransferInit() clears the flags, the handler takes it from there
+  result = I2C_TransferInit(I2C0, &i2cTransfer);
+  if (result != i2cTransferInProgress) {
+    masterResult = result;
+    masterDone = true;
+  }
+  NVIC_EnableIRQ(I2C0_IRQn);
+}
+
+/**************************************************************************//**
+ * @brief  Read the FIFO of the other kit once and record the result
+ *****************************************************************************/
+void measureRead(Mode_t readMode, Result_t *result)
+{
+  uint32_t coreMHz = CMU_ClockFreqGet(cmuClock_CORE) / 1000000;
+  uint32_t runs, cycles, start, busCycles, i;
+
+  memset(i2c_readBuffer, 0, sizeof(i2c_readBuffer));
+  masterDone = false;
+  masterResult = i2cTransferInProgress;
+
+  runs = handlerRuns;
+  cycles = handlerCycles;
+  start = DWT->CYCCNT;
+
+  if (readMode == modeLdma) {
+    startLdmaRead();
+  } else {
+    startInterruptRead();
+  }
+
+  // Stay awake so that the cycle counter keeps the bus time
+  while (!masterDone) {
+  }
+
+  busCycles = DWT->CYCCNT - start;
+  disableI2cInterrupts();
+
+  result->interrupts = handlerRuns - runs;
+  result->handlerCycles = (handlerCycles - cycles)
+                          + (result->interrupts * IRQ_ENTRY_EXIT_CYCLES);
+  result->busUs = busCycles / coreMHz;
+  result->bytesPerSecond = (uint32_t)(((uint64_t)FIFO_BYTES * coreMHz * 1000000)
+                                      / busCycles);
+  result->cpuLoad = (uint32_t)(((uint64_t)result->handlerCycles * 1000)
+                               / busCycles);
+
+  result->bytes = 0;
+  for (i = 0; i < FIFO_BYTES; i++) {
+    if (i2c_readBuffer[i] != (uint8_t)i) {
+      break;
+    }
+    result->bytes++;
+  }
+  result->ok = (masterResult == i2cTransferDone) && (result->bytes == FIFO_BYTES);
+}
+
+/**************************************************************************//**
+ * @brief  Reading the FIFO both ways. Will busy-wait until each read is
+ * complete.
+ *****************************************************************************/
+void performI2CTransfer(void)
+{
+  // Setting LED to indicate transfer
+  GPIO_PinOutSet(BSP_GPIO_LED1_PORT, BSP_GPIO_LED1_PIN);
+
+  measureRead(modeInterrupt, &results[0]);
+  measureRead(modeLdma, &results[1]);
+
+  // Clearing pin to indicate end of transfer
+  GPIO_PinOutClear(BSP_GPIO_LED1_PORT, BSP_GPIO_LED1_PIN);
+  I2C0->CTRL |= I2C_CTRL_AUTOACK;
+  enableI2cSlaveInterrupts();
+}
+
+/**************************************************************************//**
+ * @brief  Receiving I2C data. Along with the I2C interrupt, it will keep the
+  EFM32 in EM1 while the data is received.
+ *****************************************************************************/
+void receiveI2CData(void)
+{
+  while(i2c_rxInProgress)
+  {
+    EMU_EnterEM1();
+  }
+}
+
+/**************************************************************************//**
+ * @brief  Slave address and stop events, the LDMA moves the data
+ *****************************************************************************/
+static void slaveHandler(uint32_t status)
+{
+  LDMA_TransferCfg_t rxCfg =
+    LDMA_TRANSFER_CFG_PERIPHERAL(ldmaPeripheralSignal_I2C0_RXDATAV);
+  LDMA_TransferCfg_t txCfg =
+    LDMA_TRANSFER_CFG_PERIPHERAL(ldmaPeripheralSignal_I2C0_TXBL);
+  uint32_t address;
+
+  if (status & I2C_IF_ADDR)
+  {
+    // Address Match, also after a repeated start
+    i2c_rxInProgress = true;
+    address = I2C0->RXDATA;
+    I2C_IntClear(I2C0, I2C_IFC_ADDR);
+
+    if (address & 1)
+    {
+      // Read from the master, serve the FIFO
+      LDMA_StopTransfer(SLAVE_RX_CHANNEL);
+      I2C0->CMD = I2C_CMD_CLEARTX;
+      LDMA_StartTransfer(SLAVE_TX_CHANNEL, &txCfg, &slaveTxDesc);
+    } else
+    {
+      LDMA_StartTransfer(SLAVE_RX_CHANNEL, &rxCfg, &slaveRxDesc);
+    }
+  }
+
+  if (status & I2C_IF_SSTOP)
+  {
+    // Stop received, reception is ended
+    I2C_IntClear(I2C0, I2C_IFC_SSTOP);
+
+    i2c_rxCount = I2C_RXBUFFER_SIZE
+                  - LDMA_TransferRemainingCount(SLAVE_RX_CHANNEL);
+    i2c_txCount = FIFO_BYTES
+                  - LDMA_TransferRemainingCount(SLAVE_TX_CHANNEL);
+    LDMA_StopTransfer(SLAVE_RX_CHANNEL);
+    LDMA_StopTransfer(SLAVE_TX_CHANNEL);
+
+    // Drop the byte the LDMA wrote after the one the master NACKed
+    I2C0->CMD = I2C_CMD_CLEARTX;
+    i2c_rxInProgress = false;
+  }
+}
+
+/**************************************************************************//**
+ * @brief  Master bus events of the LDMA read
+ *****************************************************************************/
+static void masterLdmaHandler(uint32_t status)
+{
+  LDMA_TransferCfg_t rxCfg =
+    LDMA_TRANSFER_CFG_PERIPHERAL(ldmaPeripheralSignal_I2C0_RXDATAV);
+
+  if (status & (I2C_IF_ARBLOST | I2C_IF_BUSERR))
+  {
+    LDMA_StopTransfer(MASTER_RX_CHANNEL);
+    I2C0->CMD = I2C_CMD_ABORT;
+    masterResult = (status & I2C_IF_ARBLOST) ? i2cTransferArbLost : i2cTransferBusErr;
+    masterDone = true;
+    return;
+  }
+
+  if (status & I2C_IF_NACK)
+  {
+    // Nobody at the address, end the transfer
+    I2C_IntClear(I2C0, I2C_IFC_NACK);
+    LDMA_StopTransfer(MASTER_RX_CHANNEL);
+    I2C0->CMD = I2C_CMD_STOP;
+    masterResult = i2cTransferNack;
+    state = stateStop;
+  } else if (status & I2C_IF_ACK)
+  {
+    I2C_IntClear(I2C0, I2C_IFC_ACK);
+    switch (state)
+    {
+      case stateAddrWrite:
+        I2C0->TXDATA = FIFO_REG;
+        state = stateRegWrite;
+        break;
+
+      case stateRegWrite:
+        // Repeated start, START has to go first or it would be sent as data
+        I2C0->CMD = I2C_CMD_START;
+        I2C0->TXDATA = I2C_ADDRESS | 1;
+        state = stateAddrRead;
+        break;
+
+      case stateAddrRead:
+        LDMA_StartTransfer(MASTER_RX_CHANNEL, &rxCfg, &masterRxDesc);
+        state = stateData;
+        break;
+
+      default:
+        break;
+    }
+  }
+
+  if ((status & I2C_IF_RXDATAV) && (state == stateLast))
+  {
+    // Last byte, NACK it and stop
+    I2C_IntDisable(I2C0, I2C_IEN_RXDATAV);
+    i2c_readBuffer[FIFO_BYTES - 1] = I2C0->RXDATA;
+    I2C0->CMD = I2C_CMD_NACK;
+    I2C0->CMD = I2C_CMD_STOP;
+    masterResult = i2cTransferDone;
+    state = stateStop;
+  }
+
+  if (status & I2C_IF_MSTOP)
+  {
+    I2C_IntClear(I2C0, I2C_IFC_MSTOP);
+    if (state == stateStop)
+    {
+      masterDone = true;
+    }
+  }
+}
+
+/**************************************************************************//**
+ * @brief I2C Interrupt Handler.
+ *        The interrupt table is in assembly startup file startup_efm32.s
+ *****************************************************************************/
+void I2C0_IRQHandler(void)
+{
+  uint32_t start = DWT->CYCCNT;
+  uint32_t status;
+
+  status = I2C0->IF & I2C0->IEN;
+
+  switch (mode)
+  {
+    case modeInterrupt:
+      // One step of the emlib state machine, mostly one byte
+      masterResult = I2C_Transfer(I2C0);
+      if (masterResult != i2cTransferInProgress)
+      {
+        I2C_IntDisable(I2C0, _I2C_IEN_MASK);
+        masterDone = true;
+      }
+      break;
+
+    case modeLdma:
+      masterLdmaHandler(status);
+      break;
+
+    default:
+      slaveHandler(status);
+      break;
+  }
+
+  handlerCycles += DWT->CYCCNT - start;
+  handlerRuns++;
+}
+
+/**************************************************************************//**
+ * @brief LDMA Interrupt Handler, only the master read raises it
+ *****************************************************************************/
+void LDMA_IRQHandler(void)
+{
+  uint32_t start = DWT->CYCCNT;
+  uint32_t pending = LDMA_IntGetEnabled();
+
+  LDMA_IntClear(pending);
+
+  if (pending & (1 << MASTER_RX_CHANNEL))
+  {
+    /*
+     * All but the last byte are in. The last one is being received and
+     * must be NACKed, so turn AUTOACK off before it ends, within the
+     * time of a byte, 22 us at 400 kHz.
+     */
+    I2C0->CTRL &= ~I2C_CTRL_AUTOACK;
+    state = stateLast;
+    I2C_IntEnable(I2C0, I2C_IEN_RXDATAV);
+  }
+
+  handlerCycles += DWT->CYCCNT - start;
+  handlerRuns++;
+}
+
+/***************************************************************************//**
+ * @brief GPIO Interrupt handler
+ ******************************************************************************/
+void GPIO_EVEN_IRQHandler(void)
+{
+  // Clear pending
+  uint32_t interruptMask = GPIO_IntGet();
+  GPIO_IntClear(interruptMask);
+
+  // If RX is not in progress, a new transfer is started
+  if (!i2c_rxInProgress)
+  {
+    disableI2cInterrupts();
+      i2c_startTx = true;
+  }
+}
+
+/**************************************************************************//**
+ * @brief  Main function
+ *****************************************************************************/
+int main(void)
+{
+  // Chip errata
+  CHIP_Init();
+
+  // Configuring clocks in the Clock Management Unit (CMU)
+  initCMU();
+  
+  // Initializations
+  initGPIO();
+  initLDMA();
+
+  // Setting up i2c
+  initI2C();
+
+  //LED ON to indicate operating
+  GPIO_PinOutSet(BSP_GPIO_LED0_PORT, BSP_GPIO_LED0_PIN);
+
+  while (1)
+  {
+    if(i2c_rxInProgress)
+    {
+       // Receiving data
+       receiveI2CData();
+    }else if (i2c_startTx)
+    {
+       // Reading the FIFO of the other kit both ways
+       performI2CTransfer();
+       // Transmission complete
+       i2c_startTx = false;
+    }
+
+    // Forever enter EM2. The RTC or I2C will wake up the EFM32
+    EMU_EnterEM2(false);
+  }
+}
@@ -0,0 +1,82 @@
+/***************************************************************************//**
+ * @file i2scapture.h
+ * @brief Stereo I2S microphone capture into a looped ring of LDMA blocks.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2020 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ******************************************************************************/
+
+#ifndef I2SCAPTURE_H
+#define I2SCAPTURE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// LDMA channels for the left and right channel data of USART3
+#define I2SCAP_LEFT_LDMA_CHANNEL    0
+#define I2SCAP_RIGHT_LDMA_CHANNEL   1
+
+// Ring limits: each block is one descriptor of at most 2048 bytes, and
+// at least two blocks are needed to capture while one is being read
+#define I2SCAP_MIN_BLOCKS           2
+#define I2SCAP_MAX_BLOCKS           8
+#define I2SCAP_MAX_FRAMES           512
+
+// Raw ring words needed for the given block count and frames per block
+#define I2SCAP_RING_WORDS(blocks, frames)   (2 * (blocks) * (frames))
+
+/*
+ * One captured block. Each raw word holds one 32 bit I2S slot with the
+ * bytes in the order received, MSB first; use the pack functions below
+ * to turn them into samples.
+ */
+typedef struct {
+  const uint32_t *left;       // Left channel slots
+  const uint32_t *right;      // Right channel slots
+  uint32_t frames;            // Slots per channel
+  uint32_t sequence;          // Number of the block since I2SCAP_Init()
+} I2SCAP_Block_t;
+
+bool I2SCAP_Init(uint32_t *ring, uint32_t blocks, uint32_t frames);
+void I2SCAP_Stop(void);
+bool I2SCAP_GetBlock(I2SCAP_Block_t *block);
+bool I2SCAP_ReleaseBlock(const I2SCAP_Block_t *block);
+uint32_t I2SCAP_GetDroppedCount(void);
+void I2SCAP_Pack16(const uint32_t *raw, int16_t *out, uint32_t frames);
+void I2SCAP_Pack32(const uint32_t *raw, int32_t *out, uint32_t frames);
+void I2SCAP_Interleave16(const uint32_t *left,
+                         const uint32_t *right,
+                         int16_t *out,
+                         uint32_t frames);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // I2SCAPTURE_H
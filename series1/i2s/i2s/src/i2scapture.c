@@ -0,0 +1,304 @@
+/***************************************************************************//**
+ * @file i2scapture.c
+ * @brief Stereo I2S microphone capture into a looped ring of LDMA blocks.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2020 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ *******************************************************************************
+ * # Evaluation Quality
+ * This code has been minimally tested to ensure that it builds and is suitable 
+ * as a demonstration for evaluation purposes only. This code will be maintained
+ * at the sole discretion of Silicon Labs.
+ ******************************************************************************/
+
+#include "em_device.h"
+#include "em_cmu.h"
+#include "em_core.h"
+#include "em_ldma.h"
+#include "em_usart.h"
+
+#include "i2scapture.h"
+
+// Bytes in one I2S slot with the usartI2sFormatW32D32 format
+#define SLOT_BYTES      4
+
+static LDMA_Descriptor_t leftDesc[I2SCAP_MAX_BLOCKS];
+static LDMA_Descriptor_t rightDesc[I2SCAP_MAX_BLOCKS];
+
+static uint32_t *leftRing;
+static uint32_t *rightRing;
+static uint32_t numBlocks;
+static uint32_t blockFrames;
+
+// Index of the block completed last, in the LDMA interrupt
+static uint32_t lastIndex;
+
+// Blocks completed, written in the LDMA interrupt only, and blocks
+// handed out, written by I2SCAP_GetBlock() only. Both wrap at 2^32.
+static volatile uint32_t writeSeq;
+static volatile uint32_t readSeq;
+static volatile uint32_t dropped;
+
+/**************************************************************************//**
+ * @brief LDMA Handler
+ *
+ * @details
+ *   Only the right channel interrupts. Within each I2S frame the right slot
+ *   follows the left one, so once the right channel completes a block the
+ *   left channel has completed the same block.
+ *****************************************************************************/
+void LDMA_IRQHandler(void)
+{
+  uint32_t pending = LDMA_IntGetEnabled();
+  uint32_t writing, index, advance;
+
+  if (pending & LDMA_IF_ERROR) {
+    __BKPT(0);
+  }
+
+  if (pending & ((1 << I2SCAP_RIGHT_LDMA_CHANNEL) << _LDMA_IFC_DONE_SHIFT)) {
+    // Clear interrupt flag
+    LDMA_IntClear((1 << I2SCAP_RIGHT_LDMA_CHANNEL) << _LDMA_IFC_DONE_SHIFT);
+
+    // The block before the one being written is the one just completed.
+    // Going by the destination also counts completions whose interrupts
+    // were merged because this handler ran late.
+    writing = (LDMA->CH[I2SCAP_RIGHT_LDMA_CHANNEL].DST - (uint32_t)rightRing)
+              / (blockFrames * SLOT_BYTES);
+    index = (writing + numBlocks - 1) % numBlocks;
+    advance = (index + numBlocks - lastIndex) % numBlocks;
+    if (advance == 0) {
+      advance = numBlocks;
+    }
+    lastIndex = index;
+
+    writeSeq += advance;
+  }
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Start capturing both I2S channels of USART3 into a looped ring
+ *
+ * @details
+ *   USART3 must be set up for I2S with the usartI2sFormatW32D32 format,
+ *   8 data bits and dmaSplit, but not enabled yet. Enable it after this
+ *   call so that the first slot read is a left one.
+ *
+ * @param[in] ring
+ *   Raw ring, I2SCAP_RING_WORDS(blocks, frames) words written by the LDMA.
+ *
+ * @param[in] blocks
+ *   Blocks in the ring, I2SCAP_MIN_BLOCKS to I2SCAP_MAX_BLOCKS.
+ *
+ * @param[in] frames
+ *   Frames per block, at most I2SCAP_MAX_FRAMES.
+ *
+ * @return
+ *   false if the arguments do not fit.
+ *****************************************************************************/
+bool I2SCAP_Init(uint32_t *ring, uint32_t blocks, uint32_t frames)
+{
+  LDMA_Init_t ldmaInit = LDMA_INIT_DEFAULT;
+  LDMA_TransferCfg_t leftCfg =
+    LDMA_TRANSFER_CFG_PERIPHERAL(ldmaPeripheralSignal_USART3_RXDATAV);
+  LDMA_TransferCfg_t rightCfg =
+    LDMA_TRANSFER_CFG_PERIPHERAL(ldmaPeripheralSignal_USART3_RXDATAVRIGHT);
+  uint32_t i;
+  int32_t link;
+
+  if ((blocks < I2SCAP_MIN_BLOCKS) || (blocks > I2SCAP_MAX_BLOCKS)
+      || (frames == 0) || (frames > I2SCAP_MAX_FRAMES)) {
+    return false;
+  }
+
+  leftRing = ring;
+  rightRing = ring + (blocks * frames);
+  numBlocks = blocks;
+  blockFrames = frames;
+  lastIndex = blocks - 1;
+  writeSeq = 0;
+  readSeq = 0;
+  dropped = 0;
+
+  // One byte per request, each block links to the next and the last one
+  // back to the first
+  for (i = 0; i < blocks; i++) {
+    link = (i == blocks - 1) ? -(int32_t)i : 1;
+
+    leftDesc[i] = (LDMA_Descriptor_t)
+      LDMA_DESCRIPTOR_LINKREL_P2M_BYTE(&USART3->RXDATA,
+                                       leftRing + (i * frames),
+                                       frames * SLOT_BYTES,
+                                       link);
+    rightDesc[i] = (LDMA_Descriptor_t)
+      LDMA_DESCRIPTOR_LINKREL_P2M_BYTE(&USART3->RXDATA,
+                                       rightRing + (i * frames),
+                                       frames * SLOT_BYTES,
+                                       link);
+
+    leftDesc[i].xfer.ignoreSrec = 0;
+    leftDesc[i].xfer.doneIfs = 0;
+    rightDesc[i].xfer.ignoreSrec = 0;
+    rightDesc[i].xfer.doneIfs = 1;
+  }
+
+  // Enable LDMA clock
+  CMU_ClockEnable(cmuClock_LDMA, true);
+
+  LDMA_Init(&ldmaInit);
+
+  // Start left and right transfers
+  LDMA_StartTransfer(I2SCAP_LEFT_LDMA_CHANNEL, &leftCfg, &leftDesc[0]);
+  LDMA_StartTransfer(I2SCAP_RIGHT_LDMA_CHANNEL, &rightCfg, &rightDesc[0]);
+
+  return true;
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Stop both LDMA transfers
+ *****************************************************************************/
+void I2SCAP_Stop(void)
+{
+  LDMA_StopTransfer(I2SCAP_LEFT_LDMA_CHANNEL);
+  LDMA_StopTransfer(I2SCAP_RIGHT_LDMA_CHANNEL);
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Get the oldest completed block not read yet
+ *
+ * @details
+ *   The block stays valid until the LDMA comes round to it again, one ring
+ *   length minus one block after it was completed. When the reader falls
+ *   further behind, the blocks overwritten in the meantime are dropped
+ *   and the oldest intact one is returned.
+ *
+ * @param[out] block
+ *   The block, call I2SCAP_ReleaseBlock() once done with it.
+ *
+ * @return
+ *   false if no block is waiting.
+ *****************************************************************************/
+bool I2SCAP_GetBlock(I2SCAP_Block_t *block)
+{
+  CORE_DECLARE_IRQ_STATE;
+  uint32_t seq, index;
+
+  CORE_ENTER_CRITICAL();
+  seq = readSeq;
+  if (writeSeq - seq > numBlocks - 1) {
+    dropped += writeSeq - seq - (numBlocks - 1);
+    seq = writeSeq - (numBlocks - 1);
+  }
+  if (seq == writeSeq) {
+    CORE_EXIT_CRITICAL();
+    return false;
+  }
+  readSeq = seq + 1;
+  CORE_EXIT_CRITICAL();
+
+  index = seq % numBlocks;
+  block->left = leftRing + (index * blockFrames);
+  block->right = rightRing + (index * blockFrames);
+  block->frames = blockFrames;
+  block->sequence = seq;
+
+  return true;
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Check that a block was not overwritten while it was being used
+ *
+ * @return
+ *   false if the LDMA has come round to the block, its data is not
+ *   reliable and it is counted as dropped.
+ *****************************************************************************/
+bool I2SCAP_ReleaseBlock(const I2SCAP_Block_t *block)
+{
+  if (writeSeq - block->sequence > numBlocks - 1) {
+    dropped++;
+    return false;
+  }
+  return true;
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Number of blocks overwritten before they were read
+ *****************************************************************************/
+uint32_t I2SCAP_GetDroppedCount(void)
+{
+  return dropped;
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Pack raw slots into 16 bit samples, the top 16 bits of each slot
+ *****************************************************************************/
+void I2SCAP_Pack16(const uint32_t *raw, int16_t *out, uint32_t frames)
+{
+  uint32_t i;
+
+  for (i = 0; i < frames; i++) {
+    out[i] = (int16_t)(__REV(raw[i]) >> 16);
+  }
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Pack raw slots into sign extended 24 bit samples in 32 bit words
+ *****************************************************************************/
+void I2SCAP_Pack32(const uint32_t *raw, int32_t *out, uint32_t frames)
+{
+  uint32_t i;
+
+  for (i = 0; i < frames; i++) {
+    // Arithmetic shift, the microphone data is left justified
+    out[i] = (int32_t)__REV(raw[i]) >> 8;
+  }
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Pack both channels into interleaved 16 bit stereo, left sample first
+ *
+ * @param[out] out
+ *   2 * frames samples.
+ *****************************************************************************/
+void I2SCAP_Interleave16(const uint32_t *left,
+                         const uint32_t *right,
+                         int16_t *out,
+                         uint32_t frames)
+{
+  uint32_t i;
+
+  for (i = 0; i < frames; i++) {
+    out[2 * i] = (int16_t)(__REV(left[i]) >> 16);
+    out[(2 * i) + 1] = (int16_t)(__REV(right[i]) >> 16);
+  }
+}
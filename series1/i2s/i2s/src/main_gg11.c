@@ -39,12 +39,14 @@
 #include "em_chip.h"
 #include "em_gpio.h"
 #include "em_cmu.h"
-#include "em_ldma.h"
+#include "em_core.h"
 #include "em_usart.h"
 #include "em_device.h"
 #include "em_emu.h"
 #include "bsp.h"
 
+#include "i2scapture.h"
+
 // Sample frequency in Hz
 // 8kHz * 512 / 120 = 34133 Hz
 #define SAMPLE_FREQUENCY 34133
@@ -58,17 +60,36 @@
 #define I2S_CLK_PIN     14
 #define I2S_CS_PIN      15
 
-/// Globally declared LDMA link descriptors
-LDMA_Descriptor_t leftDesc;
-LDMA_Descriptor_t rightDesc;
-
-// Buffers to hold microphone input
-#define BUFFER_SIZE 10
-static volatile uint32_t leftBuffer[BUFFER_SIZE];
-int leftBufferIndex = 0;
-
-/// Single byte used to dispose of right microphone data
-uint8_t rightData;
+// Frames per block and blocks in the ring. 64 frames are 1.9 ms of audio
+// at 34133 Hz, so the CPU wakes up every 1.9 ms and has 5.6 ms to take
+// each block before it is overwritten.
+#define BLOCK_FRAMES    64
+#define RING_BLOCKS     4
+
+// Width of the samples handed to the application, 16 or 32. 32 keeps all
+// 24 bits of the microphone data.
+#ifndef SAMPLE_BITS
+#define SAMPLE_BITS     16
+#endif
+
+#if (SAMPLE_BITS == 16)
+typedef int16_t Sample_t;
+#elif (SAMPLE_BITS == 32)
+typedef int32_t Sample_t;
+#else
+#error "SAMPLE_BITS must be 16 or 32"
+#endif
+
+// Raw I2S slots, written by the LDMA
+static uint32_t captureRing[I2SCAP_RING_WORDS(RING_BLOCKS, BLOCK_FRAMES)];
+
+// Latest block of microphone samples for each channel
+Sample_t leftBuffer[BLOCK_FRAMES];
+Sample_t rightBuffer[BLOCK_FRAMES];
+
+// Blocks processed, and blocks lost because the loop fell behind
+volatile uint32_t blocksProcessed;
+volatile uint32_t blocksDropped;
 
 /**************************************************************************//**
  * @brief Configure and start stereo microphone on USART3
@@ -114,73 +135,24 @@ void MICMODE_InitMIC(uint32_t sampleFrequency)
                       | USART_ROUTELOC0_CSLOC_LOC5
                       | USART_ROUTELOC0_CLKLOC_LOC5;
 
-  // Enable USART3
-  USART_Enable(USART3, usartEnable);
+  // USART3 is enabled in main() once the LDMA is waiting for data
 
   // Initialize and set mic_enable pin (PD0)
   GPIO_PinModeSet(MIC_ENABLE_PORT, MIC_ENABLE_PIN, gpioModePushPull, 1);
 }
 
-/**************************************************************************//**
- * @brief Configure and start DMA
- * @detail Starting DMA transfers that transfer the data from the different
- * mic channels to either buffers or dummy variables. We are only using the
- * the left channel's data to show what a buffer of mic data looks like so
- * the DMA transfer for the right channel only puts the right mic data 
- * into a dummy variable
- *****************************************************************************/
-void MICMODE_InitLDMA()
-{
-  // Default LDMA init
-  LDMA_Init_t init = LDMA_INIT_DEFAULT;
-  LDMA_Init(&init);
-
-  // Configure LDMA for transfer from USART to memory (left channel)
-  // LDMA will loop continuously
-  LDMA_TransferCfg_t leftCfg =
-  LDMA_TRANSFER_CFG_PERIPHERAL(ldmaPeripheralSignal_USART3_RXDATAV);
-
-  //Globally store and configure link descriptors for left microphone transfer
-  LDMA_Descriptor_t leftXfer = LDMA_DESCRIPTOR_LINKREL_P2M_BYTE(&USART3->RXDATA, (uint8_t *)leftBuffer, 4 * BUFFER_SIZE, 0);
-  leftDesc = leftXfer;
-  // trigger interrupt on left microphone transfer complete (buffer full)
-  leftDesc.xfer.doneIfs = 1;
-  leftDesc.xfer.ignoreSrec = 0;
-
-  // Configure LDMA for transfer from USART to memory (right channel)
-  // LDMA will loop continuously and discard right channel data
-  LDMA_TransferCfg_t rightCfg =
-  LDMA_TRANSFER_CFG_PERIPHERAL(ldmaPeripheralSignal_USART3_RXDATAVRIGHT);
-
-  // Set up right microphone descriptor
-  LDMA_Descriptor_t rightXfer =
-  LDMA_DESCRIPTOR_LINKREL_P2M_BYTE(&USART3->RXDATA, &rightData, 1, 0);
-  rightDesc = rightXfer;
-  rightDesc.xfer.size = ldmaCtrlSizeByte;
-
-  // Don't trigger interrupts on right microphone transfers
-  rightDesc.xfer.doneIfs = 0;
-  rightDesc.xfer.ignoreSrec = 0;
-
-  // Ensure destination address does not increment
-  rightDesc.xfer.dstInc = 0;
-
-  // Start left and right transfers
-  LDMA_StartTransfer(0, (void *)&leftCfg, (void *)&leftDesc);
-  LDMA_StartTransfer(1, (void *)&rightCfg, (void *)&rightDesc);
-}
-
 /***************************************************************************//**
- * @brief LDMA IRQ handler.
- * @detail Handler that triggers on each complete LDMA transfer and sets the
- * corresponding flag
+ * @brief Unpack one block into the sample buffers
  ******************************************************************************/
-void LDMA_IRQHandler(void)
+void processBlock(const I2SCAP_Block_t *block)
 {
-  // Clear all interrupt flags
-  LDMA->IFC |= 0xFFFFFFFF;
-
-  leftBufferIndex = 0;
+#if (SAMPLE_BITS == 16)
+  I2SCAP_Pack16(block->left, leftBuffer, block->frames);
+  I2SCAP_Pack16(block->right, rightBuffer, block->frames);
+#else
+  I2SCAP_Pack32(block->left, leftBuffer, block->frames);
+  I2SCAP_Pack32(block->right, rightBuffer, block->frames);
+#endif
 }
 
 /***************************************************************************//**
@@ -204,8 +176,32 @@ int main(void)
   // Configuring clocks in the Clock Management Unit (CMU)
   initCMU();
 
+  CORE_DECLARE_IRQ_STATE;
+  I2SCAP_Block_t block;
+
   MICMODE_InitMIC(SAMPLE_FREQUENCY);
-  MICMODE_InitLDMA();
+  if (!I2SCAP_Init(captureRing, RING_BLOCKS, BLOCK_FRAMES)) {
+    __BKPT(0);
+  }
+
+  // Start the I2S clocks, the first slot received is a left one
+  USART_Enable(USART3, usartEnable);
 
-  while (1){}
+  while (1)
+  {
+    // Sleep in EM1 until the LDMA completes a block
+    CORE_ENTER_CRITICAL();
+    if (!I2SCAP_GetBlock(&block)) {
+      EMU_EnterEM1();
+      CORE_EXIT_CRITICAL();
+      continue;
+    }
+    CORE_EXIT_CRITICAL();
+
+    processBlock(&block);
+    if (I2SCAP_ReleaseBlock(&block)) {
+      blocksProcessed++;
+    }
+    blocksDropped = I2SCAP_GetDroppedCount();
+  }
 }
@@ -0,0 +1,78 @@
+/***************************************************************************//**
+ * @file dds.h
+ * @brief Phase accumulator sine synthesis for the IDAC, fed by the LDMA.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2021 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ******************************************************************************/
+
+#ifndef DDS_H
+#define DDS_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "em_idac.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// LDMA channel that writes IDAC0->CURPROG on each TIMER0 overflow
+#define DDS_LDMA_CHANNEL      0
+
+// Fixed sample clock. The output frequency only changes the phase step,
+// so the IDAC always settles in the same time whatever the frequency.
+#ifndef DDS_SAMPLE_RATE
+#define DDS_SAMPLE_RATE       200000
+#endif
+
+// Samples in each half of the ping-pong buffer. The CPU fills a half in
+// one go while the LDMA plays the other, once per DDS_BLOCK samples.
+#ifndef DDS_BLOCK
+#define DDS_BLOCK             256
+#endif
+
+// Quarter wave table entries, as a power of two. Phase bits below the
+// table index are dropped, 6 is plenty for the 5 bit IDAC step.
+#ifndef DDS_QUARTER_BITS
+#define DDS_QUARTER_BITS      6
+#endif
+
+#if (DDS_BLOCK < 2) || (DDS_BLOCK > 2048)
+#error "DDS_BLOCK must be 2 to 2048"
+#endif
+
+bool DDS_Init(IDAC_Range_TypeDef range);
+void DDS_SetFrequency(uint32_t millihertz);
+uint32_t DDS_GetFrequency(void);
+uint32_t DDS_GetResolution(void);
+uint32_t DDS_GetUnderrunCount(void);
+void DDS_Stop(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // DDS_H
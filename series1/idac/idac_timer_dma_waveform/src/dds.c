@@ -0,0 +1,299 @@
+/***************************************************************************//**
+ * @file dds.c
+ * @brief Phase accumulator sine synthesis for the IDAC, fed by the LDMA.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2021 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ *******************************************************************************
+ * # Evaluation Quality
+ * This code has been minimally tested to ensure that it builds and is suitable 
+ * as a demonstration for evaluation purposes only. This code will be maintained
+ * at the sole discretion of Silicon Labs.
+ ******************************************************************************/
+
+#include <math.h>
+
+#include "em_device.h"
+#include "em_cmu.h"
+#include "em_core.h"
+#include "em_idac.h"
+#include "em_ldma.h"
+#include "em_timer.h"
+
+#include "dds.h"
+
+#define QUARTER             (1 << DDS_QUARTER_BITS)
+#define INDEX_SHIFT         (30 - DDS_QUARTER_BITS)
+
+// Largest STEPSEL value, the top of the output swing
+#define STEP_MAX            (_IDAC_CURPROG_STEPSEL_MASK >> _IDAC_CURPROG_STEPSEL_SHIFT)
+
+#define BLOCK_DONE          ((1 << DDS_LDMA_CHANNEL) << _LDMA_IFC_DONE_SHIFT)
+
+/*
+ * CURPROG words for the positive and the negative half wave, tuning and
+ * range included. Entry QUARTER is the peak, so the falling quarters can
+ * index the table backwards without a special case.
+ */
+static uint32_t upper[QUARTER + 1];
+static uint32_t lower[QUARTER + 1];
+
+// Ping-pong buffer, descriptor 0 plays the first half and links to 1
+static uint32_t buffer[2 * DDS_BLOCK];
+static LDMA_Descriptor_t descriptors[2];
+
+static uint32_t phase;
+static volatile uint32_t increment;
+
+// Actual sample rate, the HFPER clock divided by a whole TIMER0 top
+static uint32_t sampleRate;
+
+// Half filled last, so a missed interrupt can be noticed
+static uint32_t lastHalf;
+static volatile uint32_t underrunCount;
+
+/**************************************************************************//**
+ * @brief
+ *   Build the quarter wave tables
+ *
+ * @details
+ *   The steps swing around the middle of the range, 0 to STEP_MAX, with
+ *   the tuning and range bits of CURPROG copied into every word. Writing
+ *   only the low half of CURPROG would clobber the tuning, see the
+ *   reference manual.
+ *****************************************************************************/
+static void buildTables(void)
+{
+  const float pi = 3.14159265f;
+  const float mid = STEP_MAX / 2.0f;
+  uint32_t base = IDAC0->CURPROG & (_IDAC_CURPROG_TUNING_MASK | _IDAC_CURPROG_RANGESEL_MASK);
+  float s;
+
+  for (uint32_t i = 0; i <= QUARTER; i++) {
+    s = mid * sinf((pi / 2) * i / QUARTER);
+    upper[i] = base | ((uint32_t)(mid + s + 0.5f) << _IDAC_CURPROG_STEPSEL_SHIFT);
+    lower[i] = base | ((uint32_t)(mid - s + 0.5f) << _IDAC_CURPROG_STEPSEL_SHIFT);
+  }
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Fill one half of the buffer from the phase accumulator
+ *
+ * @details
+ *   The top two phase bits select the quarter and the next
+ *   DDS_QUARTER_BITS the table entry, so each sample costs an add, a
+ *   shift and a load. The phase wraps at 32 bits, exactly once per
+ *   period of the output.
+ *****************************************************************************/
+static void fillBlock(uint32_t *block)
+{
+  uint32_t p = phase;
+  uint32_t step = increment;
+  uint32_t index;
+
+  for (uint32_t i = 0; i < DDS_BLOCK; i++) {
+    index = (p >> INDEX_SHIFT) & (QUARTER - 1);
+    switch (p >> 30) {
+      case 0:
+        block[i] = upper[index];
+        break;
+      case 1:
+        block[i] = upper[QUARTER - index];
+        break;
+      case 2:
+        block[i] = lower[index];
+        break;
+      default:
+        block[i] = lower[QUARTER - index];
+        break;
+    }
+    p += step;
+  }
+
+  phase = p;
+}
+
+/**************************************************************************//**
+ * @brief  LDMA Handler
+ *****************************************************************************/
+void LDMA_IRQHandler(void)
+{
+  uint32_t pending = LDMA_IntGetEnabled();
+  uint32_t half;
+
+  // Loop here to enable the debugger to see what has happened
+  if (pending & LDMA_IF_ERROR) {
+    __BKPT(0);
+  }
+
+  LDMA_IntClear(BLOCK_DONE);
+
+  /*
+   * The LDMA has already loaded the next descriptor, so the half it is
+   * reading now tells which one has been played. If it is the same as
+   * last time, the half now playing was never refilled and repeats.
+   */
+  if (LDMA->CH[DDS_LDMA_CHANNEL].SRC < (uint32_t)(buffer + DDS_BLOCK)) {
+    half = 1;
+  } else {
+    half = 0;
+  }
+
+  if (half == lastHalf) {
+    underrunCount++;
+  }
+  lastHalf = half;
+
+  fillBlock(buffer + (half * DDS_BLOCK));
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Start the sine output at 0 Hz
+ *
+ * @details
+ *   IDAC0 is initialized and enabled by the caller. TIMER0 overflows at
+ *   DDS_SAMPLE_RATE and the LDMA writes a new CURPROG word from the
+ *   buffer on each overflow. The CPU wakes once per DDS_BLOCK samples to
+ *   refill the half just played. Call DDS_SetFrequency() to start the
+ *   output moving.
+ *
+ * @param[in] range
+ *   IDAC current range. Its production tuning value is loaded as well.
+ *
+ * @return
+ *   false if the HFPER clock is too slow or too fast for DDS_SAMPLE_RATE.
+ *****************************************************************************/
+bool DDS_Init(IDAC_Range_TypeDef range)
+{
+  LDMA_Init_t ldmaInit = LDMA_INIT_DEFAULT;
+  LDMA_TransferCfg_t transferCfg =
+    LDMA_TRANSFER_CFG_PERIPHERAL(ldmaPeripheralSignal_TIMER0_UFOF);
+  TIMER_Init_TypeDef timerInit = TIMER_INIT_DEFAULT;
+  uint32_t top;
+
+  CMU_ClockEnable(cmuClock_TIMER0, true);
+  // The timer runs off of the HFPER clock
+  top = CMU_ClockFreqGet(cmuClock_HFPER) / DDS_SAMPLE_RATE;
+  if ((top < 2) || (top > 0x10000)) {
+    return false;
+  }
+  sampleRate = CMU_ClockFreqGet(cmuClock_HFPER) / top;
+
+  IDAC_RangeSet(IDAC0, range);
+  buildTables();
+
+  phase = 0;
+  increment = 0;
+  lastHalf = 1;
+  underrunCount = 0;
+  fillBlock(buffer);
+  fillBlock(buffer + DDS_BLOCK);
+
+  LDMA_Init(&ldmaInit);
+
+  descriptors[0] = (LDMA_Descriptor_t)
+    LDMA_DESCRIPTOR_LINKREL_M2P_BYTE(buffer, &IDAC0->CURPROG, DDS_BLOCK, 1);
+  descriptors[1] = (LDMA_Descriptor_t)
+    LDMA_DESCRIPTOR_LINKREL_M2P_BYTE(buffer + DDS_BLOCK, &IDAC0->CURPROG, DDS_BLOCK, -1);
+  descriptors[0].xfer.size = ldmaCtrlSizeWord;
+  descriptors[1].xfer.size = ldmaCtrlSizeWord;
+
+  LDMA_StartTransfer(DDS_LDMA_CHANNEL, &transferCfg, &descriptors[0]);
+
+  timerInit.enable = false;
+  TIMER_Init(TIMER0, &timerInit);
+  TIMER_TopSet(TIMER0, top - 1);
+
+  // Automatically clear the LDMA request
+  TIMER0->CTRL |= TIMER_CTRL_DMACLRACT;
+
+  TIMER_Enable(TIMER0, true);
+
+  return true;
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Set the output frequency
+ *
+ * @details
+ *   Only the phase step changes, the phase carries on from where it is,
+ *   so the output moves to the new frequency without a jump. It takes
+ *   effect from the next block filled, one or two blocks from now.
+ *
+ * @param[in] millihertz
+ *   Frequency in mHz, up to half the sample rate. Above that the output
+ *   aliases.
+ *****************************************************************************/
+void DDS_SetFrequency(uint32_t millihertz)
+{
+  increment = (uint32_t)((((uint64_t)millihertz << 32) + (sampleRate * 500ULL))
+                         / (sampleRate * 1000ULL));
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Get the frequency actually produced
+ *
+ * @return
+ *   Frequency in mHz, the requested one rounded to the nearest phase step.
+ *****************************************************************************/
+uint32_t DDS_GetFrequency(void)
+{
+  return (uint32_t)((((uint64_t)increment * sampleRate * 1000) + (1ULL << 31)) >> 32);
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Get the frequency resolution
+ *
+ * @return
+ *   Frequency of a phase step of one, in uHz.
+ *****************************************************************************/
+uint32_t DDS_GetResolution(void)
+{
+  return (uint32_t)(((uint64_t)sampleRate * 1000000) >> 32);
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Get the number of blocks played again because a refill came late
+ *****************************************************************************/
+uint32_t DDS_GetUnderrunCount(void)
+{
+  return underrunCount;
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Stop the output, the IDAC holds the last step written
+ *****************************************************************************/
+void DDS_Stop(void)
+{
+  TIMER_Enable(TIMER0, false);
+  LDMA_StopTransfer(DDS_LDMA_CHANNEL);
+}
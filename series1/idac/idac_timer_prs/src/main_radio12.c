@@ -2,8 +2,11 @@
  * @file main_radio12.c
  * @brief This example shows how to use a timer to control the IDAC through the
  * PRS. The IDAC is configured to enable its output based on the signal it
- * receives from PRS channel 0. The timer generates a square waveform signal
- * that it sends to the PRS. This project operates in EM1.
+ * receives from PRS channel 0. The timer generates a short excitation pulse
+ * once per sample period, and starts an ADC conversion of the IDAC output
+ * through PRS channel 1 while the pulse is on, so the current through a
+ * resistive sensor only flows while it is measured. This project operates
+ * in EM1.
  *******************************************************************************
  * # License
  * <b>Copyright 2020 Silicon Laboratories Inc. www.silabs.com</b>
@@ -40,44 +43,94 @@
 #include "em_cmu.h"
 #include "em_emu.h"
 #include "em_chip.h"
+#include "em_adc.h"
 #include "em_idac.h"
 #include "em_prs.h"
 #include "em_timer.h"
 
-// Setting TOP value to 500 so that frequency is around 296 Hz
-// frequency = HFPERCLK / (2^(PRESC + 1) x (TOP + 1))
-// where HFPERCLK = 19Mhz and PRESC = 6
-#define TOP 500
+// Note: change these to set the sample rate and the excitation window.
+// The IDAC turns on at the start of each period, the ADC conversion starts
+// EXCITE_SETTLE_US later and the IDAC turns off EXCITE_WINDOW_US after the
+// start, so the excitation current flows during EXCITE_WINDOW_US of each
+// period only.
+#define SAMPLE_RATE       100
+#define EXCITE_SETTLE_US  20
+#define EXCITE_WINDOW_US  40
+
+// Excitation current set in initIdac(), in microamps
+#define IDAC_CURRENT_UA   64
+
+#define adcFreq           16000000
+
+// PRS channels: the excitation level and the ADC start pulse
+#define PRS_CH_EXCITE     0
+#define PRS_CH_ADC        1
+
+// Last result, the voltage across the sensor and its resistance
+volatile uint32_t sample;
+volatile uint32_t microvolts;
+volatile uint32_t resistanceOhms;
+
+// Conversions completed, and those that completed after the IDAC turned off
+volatile uint32_t conversions;
+volatile uint32_t lateConversions;
+
+// TIMER0 count at the end of the excitation
+static uint32_t windowTicks;
+
+/**************************************************************************//**
+ * @brief
+ *    Convert microseconds to TIMER0 counts
+ *****************************************************************************/
+static uint32_t usToTicks(uint32_t us)
+{
+  uint32_t timerFreq = CMU_ClockFreqGet(cmuClock_HFPER) / 4;
+
+  return (uint32_t)(((uint64_t)timerFreq * us) / 1000000);
+}
 
 /**************************************************************************//**
  * @brief
  *    Initialize TIMER0
  *
  * @details
- *     Use compare mode and have the PRS follow the output of TIMER0.
- *     Configure TIMER0 to generate a square waveform with
- *     frequency = HFPERCLK / (2^(PRESC + 1) x (TOP + 1))
+ *    TIMER0 counts up and overflows at SAMPLE_RATE. CC0 is set on overflow
+ *    and cleared on its compare match EXCITE_WINDOW_US later, and the PRS
+ *    follows its level to enable the IDAC output. CC1 matches
+ *    EXCITE_SETTLE_US after the overflow and pulses the PRS to start the
+ *    ADC conversion, so both edges of the excitation and the conversion
+ *    come from the same counter and keep their timing.
  *****************************************************************************/
 void initTimer(void)
 {
   // Enable clock for TIMER0 module
   CMU_ClockEnable(cmuClock_TIMER0, true);
 
-  // Initialize compare mode for TIMER0 on channel 0
+  // CC0: excitation, high from overflow to compare match
   TIMER_InitCC_TypeDef timerCCInit = TIMER_INITCC_DEFAULT;
-  timerCCInit.cofoa = timerOutputActionToggle; // Toggle output on capture overflow
-  timerCCInit.mode = timerCCModeCompare;       // Output compare mode
+  timerCCInit.cofoa = timerOutputActionSet;   // Set output on counter overflow
+  timerCCInit.cmoa = timerOutputActionClear;  // Clear output on compare match
+  timerCCInit.mode = timerCCModeCompare;      // Output compare mode
   TIMER_InitCC(TIMER0, 0, &timerCCInit);
 
   // The PRS channel output will follow capture/compare 0 output
   TIMER0->CC[0].CTRL |= TIMER_CC_CTRL_PRSCONF_LEVEL;
 
+  // CC1: ADC start, a PRS pulse on compare match
+  timerCCInit.cofoa = timerOutputActionNone;
+  timerCCInit.cmoa = timerOutputActionNone;
+  TIMER_InitCC(TIMER0, 1, &timerCCInit);
+
+  windowTicks = usToTicks(EXCITE_WINDOW_US);
+  TIMER_CompareSet(TIMER0, 0, windowTicks);
+  TIMER_CompareSet(TIMER0, 1, usToTicks(EXCITE_SETTLE_US));
+
   // Set Top Value
-  TIMER_TopSet(TIMER0, TOP);
+  TIMER_TopSet(TIMER0, (CMU_ClockFreqGet(cmuClock_HFPER) / 4) / SAMPLE_RATE - 1);
 
   // Initialize the TIMER0 module
   TIMER_Init_TypeDef timerInit = TIMER_INIT_DEFAULT;
-  timerInit.prescale = timerPrescale64; // Set prescale to 6 (i.e. divide by 64)
+  timerInit.prescale = timerPrescale4; // Set prescale to 2 (i.e. divide by 4)
   TIMER_Init(TIMER0, &timerInit);
 }
 
@@ -90,9 +143,13 @@ void initPrs(void)
   // Enable PRS clock
   CMU_ClockEnable(cmuClock_PRS, true);
 
-  // Select TIMER0 as source and timer CC0 as signal for channel 0
-  PRS_SourceSignalSet(0, PRS_CH_CTRL_SOURCESEL_TIMER0,
-                         PRS_CH_CTRL_SIGSEL_TIMER0CC0, prsEdgeOff);
+  // Select TIMER0 as source and timer CC0 as signal for the excitation
+  PRS_SourceSignalSet(PRS_CH_EXCITE, PRS_CH_CTRL_SOURCESEL_TIMER0,
+                      PRS_CH_CTRL_SIGSEL_TIMER0CC0, prsEdgeOff);
+
+  // Select TIMER0 as source and timer CC1 as signal for the ADC start
+  PRS_SourceSignalSet(PRS_CH_ADC, PRS_CH_CTRL_SOURCESEL_TIMER0,
+                      PRS_CH_CTRL_SIGSEL_TIMER0CC1, prsEdgeOff);
 }
 
 /**************************************************************************//**
@@ -125,8 +182,74 @@ void initIdac(void)
 
 /**************************************************************************//**
  * @brief
- *    Use a timer to control the IDAC output enable. The IDAC outputs 64
- *    microamps when enabled.
+ *    ADC initialization
+ *
+ * @details
+ *    The ADC converts the IDAC output pin through the other APORT bus,
+ *    started by the PRS pulse from TIMER0 CC1. It warms up for each
+ *    conversion, which the EXCITE_WINDOW_US - EXCITE_SETTLE_US left for
+ *    the conversion allows for.
+ *****************************************************************************/
+void initAdc(void)
+{
+  // Enable ADC0 clock
+  CMU_ClockEnable(cmuClock_ADC0, true);
+
+  // Declare init structs
+  ADC_Init_TypeDef init = ADC_INIT_DEFAULT;
+  ADC_InitSingle_TypeDef initSingle = ADC_INITSINGLE_DEFAULT;
+
+  // Modify init structs and initialize
+  init.prescale = ADC_PrescaleCalc(adcFreq, 0); // Init to max ADC clock for Series 1
+  init.timebase = ADC_TimebaseCalc(0);
+
+  initSingle.diff       = false;        // single ended
+  initSingle.reference  = adcRef2V5;    // internal 2.5V reference
+  initSingle.resolution = adcRes12Bit;  // 12-bit resolution
+  initSingle.acqTime    = adcAcqTime4;  // set acquisition time to meet minimum requirements
+
+  // Select the IDAC output pin as ADC input
+  initSingle.posSel = adcPosSelAPORT2YCH4;
+
+  // Enable PRS trigger and select the ADC start channel
+  initSingle.prsEnable = true;
+  initSingle.prsSel = (ADC_PRSSEL_TypeDef) PRS_CH_ADC;
+
+  ADC_Init(ADC0, &init);
+  ADC_InitSingle(ADC0, &initSingle);
+
+  // Enable ADC Single Conversion Complete interrupt
+  ADC_IntEnable(ADC0, ADC_IEN_SINGLE);
+
+  // Enable ADC interrupts
+  NVIC_ClearPendingIRQ(ADC0_IRQn);
+  NVIC_EnableIRQ(ADC0_IRQn);
+}
+
+/**************************************************************************//**
+ * @brief  ADC Handler
+ *****************************************************************************/
+void ADC0_IRQHandler(void)
+{
+  // The excitation is still on while TIMER0 is below the window end
+  if (TIMER_CounterGet(TIMER0) >= windowTicks) {
+    lateConversions++;
+  }
+
+  // Get ADC result
+  sample = ADC_DataSingleGet(ADC0);
+
+  // Calculate the voltage across the sensor, and its resistance
+  microvolts = (uint32_t)(((uint64_t)sample * 2500000) / 4096);
+  resistanceOhms = microvolts / IDAC_CURRENT_UA;
+
+  conversions++;
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Excite a resistive sensor with 64 microamps from the IDAC, only while
+ *    the ADC measures the voltage across it
  *****************************************************************************/
 int main(void)
 {
@@ -139,11 +262,11 @@ int main(void)
 
   // Initialization
   initIdac();
+  initAdc();
   initPrs();
   initTimer();
 
   while (1) {
-    EMU_EnterEM1(); // Enter EM1 (won't exit)
+    EMU_EnterEM1(); // Enter EM1, the ADC interrupt wakes up once per sample
   }
 }
-
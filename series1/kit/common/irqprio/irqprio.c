@@ -0,0 +1,177 @@
+/***************************************************************************//**
+ * @file
+ * @brief Interrupt priority plan, BASEPRI masks and handler latency statistics.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2022 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ******************************************************************************/
+
+#include "em_core.h"
+#include "irqprio.h"
+
+/***************************************************************************//**
+ * @addtogroup kitdrv
+ * @{
+ ******************************************************************************/
+
+/***************************************************************************//**
+ * @addtogroup IrqPrio
+ * @{
+ ******************************************************************************/
+
+// Deadlines of the sources, taken from the plan
+static uint32_t deadline[IRQPRIO_SOURCES];
+static uint32_t sourceCount;
+
+// Each entry is only written by the handler of its source
+static volatile IRQPRIO_Stats_TypeDef stats[IRQPRIO_SOURCES];
+
+/**************************************************************************//**
+ * @brief Set the priorities of a plan and start the statistics
+ *
+ * @details
+ *    Nothing is changed if a priority is out of range. The first
+ *    IRQPRIO_SOURCES entries get statistics, the source number of each
+ *    is its index in the plan. Starts the DWT cycle counter.
+ *
+ * @param[in] plan
+ *    Interrupts and their priorities.
+ *
+ * @param[in] count
+ *    Entries in the plan.
+ *
+ * @return
+ *    false if a priority is out of range.
+ *****************************************************************************/
+bool IRQPRIO_Apply(const IRQPRIO_Entry_TypeDef *plan, uint32_t count)
+{
+  uint32_t i;
+
+  for (i = 0; i < count; i++) {
+    if (plan[i].priority >= IRQPRIO_LEVELS) {
+      return false;
+    }
+  }
+
+  CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+  DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+  sourceCount = (count < IRQPRIO_SOURCES) ? count : IRQPRIO_SOURCES;
+  for (i = 0; i < sourceCount; i++) {
+    deadline[i] = plan[i].deadline;
+  }
+  IRQPRIO_ResetStats();
+
+  for (i = 0; i < count; i++) {
+    NVIC_SetPriority(plan[i].irq, plan[i].priority);
+  }
+
+  return true;
+}
+
+/**************************************************************************//**
+ * @brief Record a handler run, from the handler of the source
+ *
+ * @param[in] source
+ *    Index of the interrupt in the plan.
+ *
+ * @param[in] latency
+ *    Cycles from the event to the handler entry, 0 if not known.
+ *
+ * @param[in] start
+ *    IRQPRIO_Now() at the handler entry.
+ *****************************************************************************/
+void IRQPRIO_Record(uint32_t source, uint32_t latency, uint32_t start)
+{
+  volatile IRQPRIO_Stats_TypeDef *s;
+  uint32_t duration = IRQPRIO_Now() - start;
+
+  if (source >= sourceCount) {
+    return;
+  }
+
+  s = &stats[source];
+  if (latency > s->maxLatency) {
+    s->maxLatency = latency;
+  }
+  if (duration > s->maxDuration) {
+    s->maxDuration = duration;
+  }
+  if ((deadline[source] != 0) && ((latency + duration) > deadline[source])) {
+    s->overruns++;
+  }
+
+  // Last, IRQPRIO_GetStats() retries when the count has moved
+  s->count++;
+}
+
+/**************************************************************************//**
+ * @brief Copy the statistics of a source
+ *
+ * @details
+ *    Masks no interrupt, so it does not delay the source: the copy is
+ *    taken again if the handler recorded a run in the meantime.
+ *****************************************************************************/
+void IRQPRIO_GetStats(uint32_t source, IRQPRIO_Stats_TypeDef *copy)
+{
+  uint32_t count;
+
+  if (source >= sourceCount) {
+    copy->count = 0;
+    copy->maxLatency = 0;
+    copy->maxDuration = 0;
+    copy->overruns = 0;
+    return;
+  }
+
+  do {
+    count = stats[source].count;
+    copy->maxLatency = stats[source].maxLatency;
+    copy->maxDuration = stats[source].maxDuration;
+    copy->overruns = stats[source].overruns;
+  } while (count != stats[source].count);
+  copy->count = count;
+}
+
+/**************************************************************************//**
+ * @brief Clear the statistics of every source
+ *****************************************************************************/
+void IRQPRIO_ResetStats(void)
+{
+  uint32_t i;
+  CORE_DECLARE_IRQ_STATE;
+
+  CORE_ENTER_CRITICAL();
+  for (i = 0; i < IRQPRIO_SOURCES; i++) {
+    stats[i].count = 0;
+    stats[i].maxLatency = 0;
+    stats[i].maxDuration = 0;
+    stats[i].overruns = 0;
+  }
+  CORE_EXIT_CRITICAL();
+}
+
+/** @} (end group IrqPrio) */
+/** @} (end group kitdrv) */
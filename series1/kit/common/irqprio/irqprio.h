@@ -0,0 +1,147 @@
+/***************************************************************************//**
+ * @file
+ * @brief Interrupt priority plan, BASEPRI masks and handler latency statistics.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2022 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ******************************************************************************/
+
+#ifndef __IRQPRIO_H
+#define __IRQPRIO_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "em_device.h"
+
+/***************************************************************************//**
+ * @addtogroup kitdrv
+ * @{
+ ******************************************************************************/
+
+/***************************************************************************//**
+ * @addtogroup IrqPrio
+ * @brief Interrupt priority plan, BASEPRI masks and handler latency statistics
+ * @details
+ *    After reset every interrupt has priority 0, so no handler preempts
+ *    another: a sample stream waits for a USB or LDMA handler that happens
+ *    to run first, and for every PRIMASK critical section in the drivers.
+ *    IRQPRIO_Apply() sets the priorities of an application's interrupts
+ *    from one table, the plan, with 0 the most urgent and IRQPRIO_LEVELS - 1
+ *    the least. The priority grouping is left as after reset, in which all
+ *    implemented bits preempt.
+ *
+ *    A critical section that only shares data with handlers of a level and
+ *    below masks them with IRQPRIO_ENTER_MASK(level), which raises BASEPRI,
+ *    and leaves the more urgent ones running. The masks nest, an inner one
+ *    never lowers BASEPRI. Level 0 cannot be masked by BASEPRI, so the plan
+ *    keeps it for the handlers that must never wait. For the emlib and USB
+ *    stack critical sections to do the same, build the project with
+ *    CORE_ATOMIC_METHOD=CORE_ATOMIC_METHOD_BASEPRI and
+ *    CORE_ATOMIC_BASE_PRIORITY_LEVEL set to the most urgent level they
+ *    protect: CORE_ENTER_ATOMIC() then masks that level and below only.
+ *    A handler above that level must not share data with them, other than
+ *    through a lock-free queue.
+ *
+ *    For the statistics, each handler of the plan calls IRQPRIO_Now() on
+ *    entry and IRQPRIO_Record() before it returns, with the entry index in
+ *    the plan. The latency from the event to the handler comes from the
+ *    peripheral, such as the counter of the TIMER that raised it, or is 0
+ *    when the peripheral cannot tell. The duration counts the time from
+ *    entry to the record, including the more urgent handlers that preempted
+ *    it, which is how long it delays the less urgent ones. Times are DWT
+ *    cycle counts, core clock cycles.
+ * @{
+ ******************************************************************************/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if !defined(__CORTEX_M) || (__CORTEX_M < 3U)
+#error "IrqPrio needs BASEPRI, Cortex-M3 or M4"
+#endif
+
+/** Sources with statistics, the first entries of the plan */
+#ifndef IRQPRIO_SOURCES
+#define IRQPRIO_SOURCES         8
+#endif
+
+/** Priority levels, 0 the most urgent */
+#define IRQPRIO_LEVELS          (1U << __NVIC_PRIO_BITS)
+
+/** BASEPRI value masking level and the less urgent levels */
+#define IRQPRIO_BASEPRI(level)  ((uint32_t)(level) << (8U - __NVIC_PRIO_BITS))
+
+/** State saved by IRQPRIO_ENTER_MASK() */
+#define IRQPRIO_DECLARE_MASK_STATE  uint32_t irqPrioMask
+
+/** Mask interrupts of level and below, level 1 to IRQPRIO_LEVELS - 1 */
+#define IRQPRIO_ENTER_MASK(level)                  \
+  do {                                             \
+    irqPrioMask = __get_BASEPRI();                 \
+    __set_BASEPRI_MAX(IRQPRIO_BASEPRI(level));     \
+  } while (0)
+
+/** Restore the mask saved by IRQPRIO_ENTER_MASK() */
+#define IRQPRIO_EXIT_MASK()     __set_BASEPRI(irqPrioMask)
+
+/** One interrupt of the plan */
+typedef struct {
+  IRQn_Type irq;          /**< Interrupt */
+  uint8_t   priority;     /**< Level, 0 to IRQPRIO_LEVELS - 1 */
+  uint32_t  deadline;     /**< Cycles from the event to the end of the
+                               handler, 0 for none */
+} IRQPRIO_Entry_TypeDef;
+
+/** Statistics of one source, all only ever count up */
+typedef struct {
+  uint32_t count;         /**< Handler runs recorded */
+  uint32_t maxLatency;    /**< Longest event to handler entry, cycles */
+  uint32_t maxDuration;   /**< Longest handler run, preemption included */
+  uint32_t overruns;      /**< Runs that ended after the deadline */
+} IRQPRIO_Stats_TypeDef;
+
+bool IRQPRIO_Apply(const IRQPRIO_Entry_TypeDef *plan, uint32_t count);
+void IRQPRIO_Record(uint32_t source, uint32_t latency, uint32_t start);
+void IRQPRIO_GetStats(uint32_t source, IRQPRIO_Stats_TypeDef *copy);
+void IRQPRIO_ResetStats(void);
+
+/***************************************************************************//**
+ * @brief
+ *   Cycle count, for the start of a handler.
+ ******************************************************************************/
+__STATIC_INLINE uint32_t IRQPRIO_Now(void)
+{
+  return DWT->CYCCNT;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+/** @} (end group IrqPrio) */
+/** @} (end group kitdrv) */
+
+#endif
@@ -0,0 +1,259 @@
+/***************************************************************************//**
+ * @file
+ * @brief LEUART log output from a RAM ring, sent by the LDMA in EM2.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2022 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ******************************************************************************/
+
+
+#include <string.h>
+#include "em_core.h"
+#include "em_emu.h"
+#include "lelog.h"
+
+/***************************************************************************//**
+ * @addtogroup kitdrv
+ * @{
+ ******************************************************************************/
+
+/***************************************************************************//**
+ * @addtogroup LeLog
+ * @{
+ ******************************************************************************/
+
+static LELOG_Init_t config;
+static LDMA_Descriptor_t descriptor;
+
+// Ring indexes: head is written next, tail is the oldest unsent byte
+static size_t head;
+static size_t tail;
+static volatile size_t pending;
+
+// Bytes the LDMA is sending from tail, 0 when idle
+static volatile size_t inFlight;
+
+static volatile uint32_t dropped;
+static volatile uint32_t waits;
+static volatile uint32_t wakeups;
+
+/**************************************************************************//**
+ * @brief Send the pending bytes up to the end of the ring
+ * @note Called with interrupts masked or from the LDMA interrupt
+ *****************************************************************************/
+static void startChunk(void)
+{
+  LDMA_TransferCfg_t cfg = LDMA_TRANSFER_CFG_PERIPHERAL(config.signal);
+  size_t n = pending;
+
+  if (n > config.size - tail) {
+    n = config.size - tail;
+  }
+  if (n > LDMA_DESCRIPTOR_MAX_XFER_SIZE) {
+    n = LDMA_DESCRIPTOR_MAX_XFER_SIZE;
+  }
+
+  descriptor = (LDMA_Descriptor_t)
+    LDMA_DESCRIPTOR_SINGLE_M2P_BYTE(&config.buffer[tail],
+                                    &config.leuart->TXDATA, n);
+  inFlight = n;
+  LDMA_StartTransfer(config.channel, &cfg, &descriptor);
+}
+
+/**************************************************************************//**
+ * @brief Sleep in EM2 until no more than limit bytes are pending
+ *****************************************************************************/
+static void waitPending(size_t limit)
+{
+  // A pending interrupt still wakes the core with interrupts masked
+  __disable_irq();
+  while (pending > limit) {
+    EMU_EnterEM2(true);
+    __enable_irq();
+    __disable_irq();
+  }
+  __enable_irq();
+}
+
+/**************************************************************************//**
+ * @brief Initialize the log
+ * @details
+ *   The LEUART must be set up and enabled for transmit. TX DMA wakeup in
+ *   EM2 is enabled here.
+ * @param[in] init Configuration, copied
+ * @return false if the configuration is not supported
+ *****************************************************************************/
+bool LELOG_Init(const LELOG_Init_t *init)
+{
+  if ((init->channel >= DMA_CHAN_COUNT) || (init->buffer == NULL)
+      || (init->size == 0) || (init->lowWatermark >= init->size)) {
+    return false;
+  }
+
+  config   = *init;
+  head     = 0;
+  tail     = 0;
+  pending  = 0;
+  inFlight = 0;
+  dropped  = 0;
+  waits    = 0;
+  wakeups  = 0;
+
+  LEUART_TxDmaInEM2Enable(config.leuart, true);
+
+  return true;
+}
+
+/**************************************************************************//**
+ * @brief Append to the log
+ * @param[in] data Bytes to send
+ * @param[in] length Number of bytes
+ * @param[in] wait If the ring fills, sleep in EM2 until it has drained to
+ *   the low watermark instead of dropping the rest. Ignored in interrupts.
+ * @return Bytes appended, the others are counted as dropped
+ *****************************************************************************/
+size_t LELOG_Write(const void *data, size_t length, bool wait)
+{
+  const uint8_t *src = data;
+  size_t written = 0;
+  size_t n, first;
+  CORE_DECLARE_IRQ_STATE;
+
+  if (__get_IPSR() != 0) {
+    wait = false;
+  }
+
+  while (length > 0) {
+    CORE_ENTER_ATOMIC();
+    n = config.size - pending;
+    if (n > length) {
+      n = length;
+    }
+
+    // Copy in up to two parts around the end of the ring
+    first = config.size - head;
+    if (first > n) {
+      first = n;
+    }
+    memcpy(&config.buffer[head], src, first);
+    memcpy(config.buffer, &src[first], n - first);
+    head = (head + n) % config.size;
+    pending += n;
+
+    if ((inFlight == 0) && (pending > 0)) {
+      startChunk();
+    }
+    CORE_EXIT_ATOMIC();
+
+    src     += n;
+    length  -= n;
+    written += n;
+
+    if (length > 0) {
+      if (!wait) {
+        dropped += length;
+        break;
+      }
+      waits++;
+      waitPending(config.lowWatermark);
+    }
+  }
+
+  return written;
+}
+
+/**************************************************************************//**
+ * @brief Sleep in EM2 until the whole log is sent, the last byte included
+ *****************************************************************************/
+void LELOG_Flush(void)
+{
+  waitPending(0);
+
+  while (!(config.leuart->STATUS & LEUART_STATUS_TXC)) {
+  }
+}
+
+/**************************************************************************//**
+ * @brief Get the number of bytes not sent yet
+ *****************************************************************************/
+size_t LELOG_Pending(void)
+{
+  return pending;
+}
+
+/**************************************************************************//**
+ * @brief Get the number of bytes dropped because the ring was full
+ *****************************************************************************/
+uint32_t LELOG_Dropped(void)
+{
+  return dropped;
+}
+
+/**************************************************************************//**
+ * @brief Get the number of writes that slept for the ring to drain
+ *****************************************************************************/
+uint32_t LELOG_Waits(void)
+{
+  return waits;
+}
+
+/**************************************************************************//**
+ * @brief Get the number of LDMA interrupts, the core wakeups of the log
+ *****************************************************************************/
+uint32_t LELOG_Wakeups(void)
+{
+  return wakeups;
+}
+
+/**************************************************************************//**
+ * @brief Handle the LDMA interrupt of the log channel
+ * @details
+ *   Only the done flag of the channel is read and cleared, so other LDMA
+ *   users can share LDMA_IRQHandler().
+ *****************************************************************************/
+void LELOG_IRQHandler(void)
+{
+  uint32_t mask = 1UL << config.channel;
+
+  if (!(LDMA_IntGet() & mask)) {
+    return;
+  }
+  LDMA_IntClear(mask);
+  wakeups++;
+
+  if (inFlight == 0) {
+    return;
+  }
+  tail = (tail + inFlight) % config.size;
+  pending -= inFlight;
+  inFlight = 0;
+
+  if (pending > 0) {
+    startChunk();
+  }
+}
+
+/** @} (end group LeLog) */
+/** @} (end group kitdrv) */
@@ -0,0 +1,100 @@
+/***************************************************************************//**
+ * @file
+ * @brief LEUART log output from a RAM ring, sent by the LDMA in EM2.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2022 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ******************************************************************************/
+
+
+#ifndef __LELOG_H
+#define __LELOG_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "em_device.h"
+#include "em_ldma.h"
+#include "em_leuart.h"
+
+/***************************************************************************//**
+ * @addtogroup kitdrv
+ * @{
+ ******************************************************************************/
+
+/***************************************************************************//**
+ * @addtogroup LeLog
+ * @brief LEUART log output from a RAM ring, sent by the LDMA in EM2
+ * @details
+ *    LELOG_Write() appends to a RAM ring and returns at once; the LDMA
+ *    sends the ring to the LEUART TXDATA register while the core sleeps.
+ *    With TX DMA wakeup in EM2 enabled the LEUART wakes only the LDMA for
+ *    each byte, not the core, so the log costs little more than the EM2
+ *    current.
+ *
+ *    Each transfer sends all bytes pending up to the end of the ring, so
+ *    the core is woken by the LDMA done interrupt once per wrap of the ring
+ *    or per burst of writes, not per line. A full ring drops the rest of a
+ *    write, or, with wait set, sleeps in EM2 until the ring has drained
+ *    to the low watermark and goes on.
+ *
+ *    The application sets up the LEUART (clock, baud rate, route) and
+ *    calls LDMA_Init() first, and calls LELOG_IRQHandler() from its
+ *    LDMA_IRQHandler(). LELOG_Write() may be called from interrupts, but
+ *    never waits there.
+ * @{
+ ******************************************************************************/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Configuration */
+typedef struct {
+  LEUART_TypeDef          *leuart;      /**< LEUART sending the log */
+  unsigned int            channel;      /**< LDMA channel */
+  LDMA_PeripheralSignal_t signal;       /**< TXBL request of the LEUART */
+  uint8_t                 *buffer;      /**< Ring */
+  size_t                  size;         /**< Ring size in bytes */
+  size_t                  lowWatermark; /**< Pending bytes a waiting write goes on at */
+} LELOG_Init_t;
+
+bool     LELOG_Init(const LELOG_Init_t *init);
+size_t   LELOG_Write(const void *data, size_t length, bool wait);
+void     LELOG_Flush(void);
+size_t   LELOG_Pending(void);
+uint32_t LELOG_Dropped(void);
+uint32_t LELOG_Waits(void);
+uint32_t LELOG_Wakeups(void);
+void     LELOG_IRQHandler(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+/** @} (end group LeLog) */
+/** @} (end group kitdrv) */
+
+#endif
@@ -0,0 +1,267 @@
+/***************************************************************************//**
+ * @file
+ * @brief Low frequency clock rate measured against the HFXO, for timing
+ * that does not drift with the ULFRCO or LFRCO error.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2022 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ******************************************************************************/
+
+#include "em_cmu.h"
+#include "em_core.h"
+#include "em_timer.h"
+#include "lfcal.h"
+
+/***************************************************************************//**
+ * @addtogroup kitdrv
+ * @{
+ ******************************************************************************/
+
+/***************************************************************************//**
+ * @addtogroup LfCal
+ * @{
+ ******************************************************************************/
+
+// HFPERCLK counts a measurement aims for, leaving room for a clock up to
+// 50 % slow in the 16-bit TIMER0 counter
+#define MAX_COUNTS        0x8000UL
+
+// Largest prescaler of TIMER0, 2^10
+#define MAX_PRESC         10
+
+static uint32_t nominalHz;
+static uint32_t rateQ16;
+static uint32_t measureCount;
+
+/**************************************************************************//**
+ * @brief Wait for the next tick of the counter
+ *
+ * @return
+ *    The counter after the tick.
+ *****************************************************************************/
+static uint32_t waitTick(LFCAL_CounterGet_t counterGet, uint32_t counterMask)
+{
+  uint32_t first = counterGet() & counterMask;
+  uint32_t count;
+
+  do {
+    count = counterGet() & counterMask;
+  } while (count == first);
+
+  return count;
+}
+
+/**************************************************************************//**
+ * @brief Milliseconds at the measured rate, in ticks with 16 fraction bits
+ *****************************************************************************/
+static uint64_t msToTicksQ16(uint32_t ms)
+{
+  return ((uint64_t)ms * rateQ16) / 1000;
+}
+
+/**************************************************************************//**
+ * @brief Set the nominal rate of the counter
+ *
+ * @details
+ *    Until the first successful LFCAL_Measure(), milliseconds are
+ *    converted at the nominal rate.
+ *
+ * @param[in] hz
+ *    Nominal counter ticks per second, with any prescaler of the timer
+ *    applied, such as 1000 for an RTC on the ULFRCO.
+ *****************************************************************************/
+void LFCAL_Init(uint32_t hz)
+{
+  nominalHz = hz;
+  rateQ16 = hz << 16;
+  measureCount = 0;
+}
+
+/**************************************************************************//**
+ * @brief Measure the rate of the counter against the HFPERCLK
+ *
+ * @details
+ *    TIMER0 counts the HFPERCLK, with the smallest prescaler that keeps
+ *    the window within its 16-bit counter, from one tick of the counter to
+ *    the tick @p ticks later. Interrupts are only disabled around the two
+ *    edges. Run the HFPERCLK from the HFXO for the measurement.
+ *
+ * @param[in] counterGet
+ *    Reads the counter, such as RTC_CounterGet() or CRYOTIMER_CounterGet().
+ *
+ * @param[in] counterMask
+ *    Mask of the counter bits, the counter wraps at counterMask + 1.
+ *
+ * @param[in] ticks
+ *    Length of the window, at least 2 and at most LFCAL_MAX_TICKS and
+ *    counterMask. Longer windows average the jitter of the ULFRCO.
+ *
+ * @return
+ *    false if the window is out of range, was stretched by an interrupt,
+ *    or the rate was more than 50 % off the nominal rate; the last rate
+ *    is kept.
+ *****************************************************************************/
+bool LFCAL_Measure(LFCAL_CounterGet_t counterGet,
+                   uint32_t counterMask,
+                   uint32_t ticks)
+{
+  TIMER_Init_TypeDef timerInit = TIMER_INIT_DEFAULT;
+  uint32_t refHz, counts, begin, end;
+  uint32_t nominalQ16;
+  uint64_t expected, rate;
+  unsigned int presc;
+  bool overflow;
+  CORE_DECLARE_IRQ_STATE;
+
+  if ((nominalHz == 0) || (ticks < 2) || (ticks > LFCAL_MAX_TICKS)
+      || (ticks > counterMask)) {
+    return false;
+  }
+
+  refHz = CMU_ClockFreqGet(cmuClock_HFPER);
+  expected = ((uint64_t)refHz * ticks) / nominalHz;
+  for (presc = 0;
+       ((expected >> presc) >= MAX_COUNTS) && (presc < MAX_PRESC);
+       presc++) {
+  }
+  if ((expected >> presc) >= MAX_COUNTS) {
+    return false;
+  }
+
+  CMU_ClockEnable(cmuClock_HFPER, true);
+  CMU_ClockEnable(cmuClock_TIMER0, true);
+  timerInit.prescale = (TIMER_Prescale_TypeDef)presc;
+  TIMER_TopSet(TIMER0, 0xFFFF);
+  TIMER_Init(TIMER0, &timerInit);
+
+  CORE_ENTER_CRITICAL();
+  begin = waitTick(counterGet, counterMask);
+  TIMER_CounterSet(TIMER0, 0);
+  TIMER_IntClear(TIMER0, TIMER_IF_OF);
+  CORE_EXIT_CRITICAL();
+
+  while (((counterGet() - begin) & counterMask) < (ticks - 1)) {
+  }
+
+  CORE_ENTER_CRITICAL();
+  end = waitTick(counterGet, counterMask);
+  counts = TIMER_CounterGet(TIMER0);
+  overflow = (TIMER_IntGet(TIMER0) & TIMER_IF_OF) != 0;
+  CORE_EXIT_CRITICAL();
+
+  TIMER_Enable(TIMER0, false);
+  CMU_ClockEnable(cmuClock_TIMER0, false);
+
+  if ((((end - begin) & counterMask) != ticks) || overflow || (counts == 0)) {
+    return false;
+  }
+
+  rate = (((uint64_t)ticks * refHz) << 16) / ((uint64_t)counts << presc);
+
+  nominalQ16 = nominalHz << 16;
+  if ((rate < (nominalQ16 / 2)) || (rate > (nominalQ16 + (nominalQ16 / 2)))) {
+    return false;
+  }
+
+  rateQ16 = (uint32_t)rate;
+  measureCount++;
+
+  return true;
+}
+
+/**************************************************************************//**
+ * @brief Get the measured rate, ticks per second with 16 fraction bits
+ *****************************************************************************/
+uint32_t LFCAL_GetRateQ16(void)
+{
+  return rateQ16;
+}
+
+/**************************************************************************//**
+ * @brief Get the error of the clock in parts per million, positive if it
+ *        runs fast
+ *****************************************************************************/
+int32_t LFCAL_GetErrorPpm(void)
+{
+  int64_t error = (int64_t)rateQ16 - ((int64_t)nominalHz << 16);
+
+  if (nominalHz == 0) {
+    return 0;
+  }
+
+  return (int32_t)((error * 1000000) / ((int64_t)nominalHz << 16));
+}
+
+/**************************************************************************//**
+ * @brief Get the number of successful measurements
+ *****************************************************************************/
+uint32_t LFCAL_GetMeasureCount(void)
+{
+  return measureCount;
+}
+
+/**************************************************************************//**
+ * @brief Convert milliseconds to ticks at the measured rate, rounded
+ *
+ * @details
+ *    For a one shot deadline. Periodic deadlines use LFCAL_PeriodTicks(),
+ *    which does not let the rounding add up.
+ *****************************************************************************/
+uint32_t LFCAL_MsToTicks(uint32_t ms)
+{
+  uint64_t ticks = (msToTicksQ16(ms) + 0x8000) >> 16;
+
+  return (ticks > UINT32_MAX) ? UINT32_MAX : (uint32_t)ticks;
+}
+
+/**************************************************************************//**
+ * @brief Ticks of the next period of a periodic deadline
+ *
+ * @details
+ *    The fraction of a tick left over is carried in @p frac to the next
+ *    period, so the periods are whole ticks that average to @p ms at the
+ *    measured rate.
+ *
+ * @param[in] ms
+ *    Period in milliseconds.
+ *
+ * @param[in,out] frac
+ *    Fraction of a tick carried between periods, 16 bits, 0 to start.
+ *
+ * @return
+ *    Ticks until the next deadline.
+ *****************************************************************************/
+uint32_t LFCAL_PeriodTicks(uint32_t ms, uint32_t *frac)
+{
+  uint64_t ticks = msToTicksQ16(ms) + (*frac & 0xFFFF);
+
+  *frac = (uint32_t)ticks & 0xFFFF;
+  ticks >>= 16;
+
+  return (ticks > UINT32_MAX) ? UINT32_MAX : (uint32_t)ticks;
+}
+
+/** @} (end group LfCal) */
+/** @} (end group kitdrv) */
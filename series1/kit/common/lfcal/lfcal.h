@@ -0,0 +1,95 @@
+/***************************************************************************//**
+ * @file
+ * @brief Low frequency clock rate measured against the HFXO, for timing
+ * that does not drift with the ULFRCO or LFRCO error.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2022 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ******************************************************************************/
+
+#ifndef __LFCAL_H
+#define __LFCAL_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "em_device.h"
+
+/***************************************************************************//**
+ * @addtogroup kitdrv
+ * @{
+ ******************************************************************************/
+
+/***************************************************************************//**
+ * @addtogroup LfCal
+ * @brief Rate of a low frequency timer clock, measured against the HFXO
+ * @details
+ *    The ULFRCO is only specified to within tens of percent of its 1 kHz,
+ *    the LFRCO to a few percent of its 32768 Hz, and both drift with the
+ *    temperature and the supply. LFCAL_Measure() finds the actual rate of
+ *    the counter of a low energy timer, such as the RTC or the CRYOTIMER,
+ *    and LFCAL_MsToTicks() and LFCAL_PeriodTicks() turn milliseconds into
+ *    ticks at that rate, so timers on the cheaper oscillators keep time
+ *    without the LFXO running.
+ *
+ *    The measurement counts the HFPERCLK with TIMER0 over a window of
+ *    whole ticks of the counter, from one tick to another, as the CMU
+ *    calibration counters of the lfrco_cal examples count one clock
+ *    against another; the calibration counters cannot take the ULFRCO.
+ *    The HFPERCLK sets the accuracy, so the application runs it from the
+ *    HFXO over the measurement, and repeats the measurement from time to
+ *    time to follow the drift. The CPU waits in EM0 over the window.
+ *
+ *    The component can be used on series 0 and series 1 parts.
+ * @{
+ ******************************************************************************/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Longest measurement window, counter ticks */
+#define LFCAL_MAX_TICKS   (1UL << 23)
+
+/** Reads the counter of the timer whose clock is measured */
+typedef uint32_t (*LFCAL_CounterGet_t)(void);
+
+void      LFCAL_Init(uint32_t nominalHz);
+bool      LFCAL_Measure(LFCAL_CounterGet_t counterGet,
+                        uint32_t counterMask,
+                        uint32_t ticks);
+uint32_t  LFCAL_GetRateQ16(void);
+int32_t   LFCAL_GetErrorPpm(void);
+uint32_t  LFCAL_GetMeasureCount(void);
+uint32_t  LFCAL_MsToTicks(uint32_t ms);
+uint32_t  LFCAL_PeriodTicks(uint32_t ms, uint32_t *frac);
+
+#ifdef __cplusplus
+}
+#endif
+
+/** @} (end group LfCal) */
+/** @} (end group kitdrv) */
+
+#endif
@@ -0,0 +1,267 @@
+/***************************************************************************//**
+ * @file
+ * @brief Delays that sleep in EM2 on the RTCC instead of spinning in EM0.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2022 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ******************************************************************************/
+
+#include "em_cmu.h"
+#include "em_core.h"
+#include "em_emu.h"
+#include "em_rtcc.h"
+#include "lpdelay.h"
+
+/***************************************************************************//**
+ * @addtogroup kitdrv
+ * @{
+ ******************************************************************************/
+
+/***************************************************************************//**
+ * @addtogroup LpDelay
+ * @{
+ ******************************************************************************/
+
+// Calibration spins until at least this many RTCC ticks have passed,
+// about 2 ms, for a cycle loop within 2% of the core clock
+#define CAL_TICKS         64
+
+// Shortest and longest sleep programmed into the compare in one go; a
+// compare closer to the count than the minimum may be missed
+#define MIN_SLEEP_TICKS   2
+#define MAX_SLEEP_TICKS   0x80000000UL
+
+#define CC_IF             (RTCC_IF_CC0 << LPDELAY_CC_CHANNEL)
+#define CC_IEN            (RTCC_IEN_CC0 << LPDELAY_CC_CHANNEL)
+
+static bool               em2;
+static uint32_t           tickFreq;
+static uint32_t           calibratedClock;
+static uint32_t           loopsPerUsQ16;
+static volatile bool      expired;
+static volatile uint32_t  sleepCount;
+static volatile uint32_t  spinCount;
+
+/**************************************************************************//**
+ * @brief The cycle loop, timed by LPDELAY_Calibrate()
+ *****************************************************************************/
+static void spin(uint32_t loops)
+{
+  while (loops--) {
+    __NOP();
+  }
+}
+
+/**************************************************************************//**
+ * @brief Sleep until the RTCC count has moved on by a number of ticks
+ *
+ * @details
+ *    Sleeps with interrupts masked so that the compare can not be missed
+ *    between the check and the sleep, and unmasks them after each wakeup
+ *    so that the RTCC and any other interrupt is handled.
+ *****************************************************************************/
+static void sleepTicks(uint32_t ticks)
+{
+  CORE_DECLARE_IRQ_STATE;
+
+  if (ticks < MIN_SLEEP_TICKS) {
+    ticks = MIN_SLEEP_TICKS;
+  }
+
+  CORE_ENTER_CRITICAL();
+
+  expired = false;
+  RTCC_ChannelCCVSet(LPDELAY_CC_CHANNEL, RTCC_CounterGet() + ticks);
+  RTCC_IntClear(CC_IF);
+  RTCC_IntEnable(CC_IEN);
+
+  while (!expired) {
+    if (em2) {
+      EMU_EnterEM2(true);
+    } else {
+      EMU_EnterEM1();
+    }
+    CORE_EXIT_CRITICAL();
+    CORE_ENTER_CRITICAL();
+  }
+
+  RTCC_IntDisable(CC_IEN);
+  sleepCount++;
+
+  CORE_EXIT_CRITICAL();
+}
+
+/**************************************************************************//**
+ * @brief Sleep for a number of RTCC ticks of any size
+ *****************************************************************************/
+static void sleepLong(uint64_t ticks)
+{
+  uint32_t chunk;
+
+  while (ticks > 0) {
+    chunk = (ticks > MAX_SLEEP_TICKS) ? MAX_SLEEP_TICKS : (uint32_t)ticks;
+    sleepTicks(chunk);
+    ticks -= chunk;
+  }
+}
+
+/**************************************************************************//**
+ * @brief RTCC interrupt, ends the current sleep
+ *****************************************************************************/
+void RTCC_IRQHandler(void)
+{
+  RTCC_IntClear(CC_IF);
+  expired = true;
+}
+
+/**************************************************************************//**
+ * @brief Start the RTCC and calibrate the cycle loop
+ *
+ * @param[in] allowEm2
+ *    true to sleep in EM2, false to sleep in EM1 for applications that
+ *    rely on a peripheral that stops in EM2, such as a TIMER.
+ *****************************************************************************/
+void LPDELAY_Init(bool allowEm2)
+{
+  RTCC_Init_TypeDef rtccInit = RTCC_INIT_DEFAULT;
+  RTCC_CCChConf_TypeDef compare = RTCC_CH_INIT_COMPARE_DEFAULT;
+
+  em2 = allowEm2;
+
+  CMU_ClockEnable(cmuClock_HFLE, true);
+  if (LPDELAY_CLOCK == cmuSelect_LFRCO) {
+    CMU_OscillatorEnable(cmuOsc_LFRCO, true, true);
+  }
+  CMU_ClockSelectSet(cmuClock_LFE, LPDELAY_CLOCK);
+  CMU_ClockEnable(cmuClock_RTCC, true);
+  tickFreq = CMU_ClockFreqGet(cmuClock_RTCC);
+
+  // Free running, one count per tick
+  RTCC_ChannelInit(LPDELAY_CC_CHANNEL, &compare);
+  rtccInit.presc = rtccCntPresc_1;
+  RTCC_Init(&rtccInit);
+
+  RTCC_IntDisable(CC_IEN);
+  RTCC_IntClear(CC_IF);
+  NVIC_ClearPendingIRQ(RTCC_IRQn);
+  NVIC_EnableIRQ(RTCC_IRQn);
+
+  LPDELAY_Calibrate();
+}
+
+/**************************************************************************//**
+ * @brief Time the cycle loop against the RTCC at the current core clock
+ *
+ * @details
+ *    Doubles the loop count until a run lasts CAL_TICKS RTCC ticks, with
+ *    interrupts masked so that they do not stretch the run. This takes up
+ *    to about 4 ms.
+ *****************************************************************************/
+void LPDELAY_Calibrate(void)
+{
+  uint32_t loops = 256;
+  uint32_t start, ticks;
+  CORE_DECLARE_IRQ_STATE;
+
+  CORE_ENTER_ATOMIC();
+
+  for (;;) {
+    // Start on a tick edge
+    start = RTCC_CounterGet();
+    while (RTCC_CounterGet() == start) {
+    }
+    start = RTCC_CounterGet();
+
+    spin(loops);
+
+    ticks = RTCC_CounterGet() - start;
+    if ((ticks >= CAL_TICKS) || (loops >= (1UL << 30))) {
+      break;
+    }
+    loops <<= 1;
+  }
+
+  CORE_EXIT_ATOMIC();
+
+  if (ticks == 0) {
+    ticks = 1;
+  }
+
+  // Loops per microsecond in 16.16 fixed point
+  loopsPerUsQ16 = (uint32_t)((((uint64_t)loops * tickFreq) << 16)
+                             / ((uint64_t)ticks * 1000000));
+  calibratedClock = SystemCoreClockGet();
+}
+
+/**************************************************************************//**
+ * @brief Wait for a number of microseconds
+ *
+ * @details
+ *    Sleeps if us is at least LPDELAY_SLEEP_THRESHOLD_US, rounded up to
+ *    the next RTCC tick, and spins otherwise.
+ *****************************************************************************/
+void LPDELAY_Us(uint32_t us)
+{
+  if (us >= LPDELAY_SLEEP_THRESHOLD_US) {
+    sleepLong((((uint64_t)us * tickFreq) + 999999) / 1000000);
+  } else if (us > 0) {
+    if (SystemCoreClock != calibratedClock) {
+      LPDELAY_Calibrate();
+    }
+    spin((uint32_t)(((uint64_t)us * loopsPerUsQ16) >> 16));
+    spinCount++;
+  }
+}
+
+/**************************************************************************//**
+ * @brief Wait for a number of milliseconds
+ *****************************************************************************/
+void LPDELAY_Ms(uint32_t ms)
+{
+  if (((uint64_t)ms * 1000) >= LPDELAY_SLEEP_THRESHOLD_US) {
+    sleepLong((((uint64_t)ms * tickFreq) + 999) / 1000);
+  } else {
+    LPDELAY_Us(ms * 1000);
+  }
+}
+
+/**************************************************************************//**
+ * @brief Get the number of delays that slept
+ *****************************************************************************/
+uint32_t LPDELAY_GetSleepCount(void)
+{
+  return sleepCount;
+}
+
+/**************************************************************************//**
+ * @brief Get the number of delays that spun in the cycle loop
+ *****************************************************************************/
+uint32_t LPDELAY_GetSpinCount(void)
+{
+  return spinCount;
+}
+
+/** @} (end group LpDelay) */
+/** @} (end group kitdrv) */
@@ -0,0 +1,98 @@
+/***************************************************************************//**
+ * @file
+ * @brief Delays that sleep in EM2 on the RTCC instead of spinning in EM0.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2022 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ******************************************************************************/
+
+#ifndef __LPDELAY_H
+#define __LPDELAY_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "em_device.h"
+
+/***************************************************************************//**
+ * @addtogroup kitdrv
+ * @{
+ ******************************************************************************/
+
+/***************************************************************************//**
+ * @addtogroup LpDelay
+ * @brief Blocking delays that sleep for as long as they can
+ * @details
+ *    A drop-in for the Delay() loops on a 1 ms SysTick interrupt. Delays of
+ *    at least LPDELAY_SLEEP_THRESHOLD_US sleep until an RTCC compare match,
+ *    in EM2 or, if the application needs a peripheral that stops in EM2, in
+ *    EM1. Shorter delays, where waking up would take a good part of the
+ *    delay, spin in a cycle loop that LPDELAY_Init() calibrates against the
+ *    RTCC. No periodic interrupt runs between delays.
+ *
+ *    The RTCC counts the LFECLK without a prescaler, so sleeping delays have
+ *    the resolution of a 32.768 kHz tick, 31 us, and are rounded up to it.
+ *    LPDELAY_Init() selects LPDELAY_CLOCK for the LFECLK and starts the
+ *    LFRCO if that is selected; an LFXO must already be running. The
+ *    component owns the RTCC, compare channel LPDELAY_CC_CHANNEL and the
+ *    RTCC interrupt handler.
+ *
+ *    The cycle loop is calibrated for the core clock at the time of the
+ *    calibration, and is calibrated again on the next short delay after
+ *    SystemCoreClock has changed.
+ * @{
+ ******************************************************************************/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Delays at least this long sleep, shorter ones spin */
+#ifndef LPDELAY_SLEEP_THRESHOLD_US
+#define LPDELAY_SLEEP_THRESHOLD_US  1000
+#endif
+
+/** LFECLK source, cmuSelect_LFRCO or cmuSelect_LFXO */
+#ifndef LPDELAY_CLOCK
+#define LPDELAY_CLOCK               cmuSelect_LFRCO
+#endif
+
+/** RTCC compare channel ending each sleep */
+#define LPDELAY_CC_CHANNEL          0
+
+void      LPDELAY_Init(bool allowEm2);
+void      LPDELAY_Calibrate(void);
+void      LPDELAY_Us(uint32_t us);
+void      LPDELAY_Ms(uint32_t ms);
+uint32_t  LPDELAY_GetSleepCount(void);
+uint32_t  LPDELAY_GetSpinCount(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+/** @} (end group LpDelay) */
+/** @} (end group kitdrv) */
+
+#endif
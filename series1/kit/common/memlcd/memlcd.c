@@ -0,0 +1,394 @@
+/***************************************************************************//**
+ * @file
+ * @brief Sharp memory LCD driver sending only the changed lines by LDMA.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2022 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ******************************************************************************/
+
+#include <stddef.h>
+#include "em_letimer.h"
+#include "em_prs.h"
+#include "em_usart.h"
+#include "memlcd.h"
+
+/***************************************************************************//**
+ * @addtogroup kitdrv
+ * @{
+ ******************************************************************************/
+
+/***************************************************************************//**
+ * @addtogroup MemLcd
+ * @{
+ ******************************************************************************/
+
+#define CMD_UPDATE      0x01    // M0, write lines
+#define CMD_ALL_CLEAR   0x04    // M2, clear the display
+
+// SCS timing of the LS013B7DH03 in microseconds
+#define SCS_SETUP_US    6
+#define SCS_HOLD_US     2
+#define SCS_LOW_US      6
+
+// One line as sent: address, pixel data, dummy byte
+typedef struct {
+  uint8_t address;
+  uint8_t data[MEMLCD_LINE_BYTES];
+  uint8_t dummy;
+} Line_t;
+
+// Lines one descriptor can send
+#define RUN_LINES       (LDMA_DESCRIPTOR_MAX_XFER_SIZE / sizeof(Line_t))
+
+static Line_t frame[MEMLCD_HEIGHT];
+static uint32_t dirty[(MEMLCD_HEIGHT + 31) / 32];
+
+// Sent first and last by every update
+static const uint8_t modeByte = CMD_UPDATE;
+static const uint8_t trailerByte = 0;
+
+// Mode byte, one per run, trailer
+static LDMA_Descriptor_t desc[MEMLCD_MAX_RUNS + 2];
+
+static MEMLCD_Init_TypeDef cfg;
+static volatile bool busy;
+static MEMLCD_Counters_TypeDef counters;
+
+/**************************************************************************//**
+ * @brief Wait at least a number of microseconds
+ *****************************************************************************/
+static void delayUs(uint32_t us)
+{
+  // A loop pass takes more than 4 cycles
+  volatile uint32_t n = ((SystemCoreClock / 4000000UL) + 1) * us;
+
+  while (n > 0) {
+    n--;
+  }
+}
+
+/**************************************************************************//**
+ * @brief Whether a line has changed since it was last sent
+ *****************************************************************************/
+static bool isDirty(uint32_t y)
+{
+  return (dirty[y / 32] & (1UL << (y % 32))) != 0;
+}
+
+/**************************************************************************//**
+ * @brief Wait for the last bit to leave the USART, then deselect
+ *****************************************************************************/
+static void endFrame(void)
+{
+  while (!(cfg.usart->STATUS & USART_STATUS_TXC)) {
+  }
+  delayUs(SCS_HOLD_US);
+  GPIO_PinOutClear(cfg.scsPort, cfg.scsPin);
+}
+
+/**************************************************************************//**
+ * @brief Start the VCOM toggle: LETIMER0 output 0 through PRS to EXTCOMIN
+ *****************************************************************************/
+static void startExtcomin(void)
+{
+  LETIMER_Init_TypeDef init = LETIMER_INIT_DEFAULT;
+
+  CMU_ClockEnable(cmuClock_HFLE, true);
+  if (CMU_ClockSelectGet(cmuClock_LFA) == cmuSelect_Disabled) {
+    CMU_ClockSelectSet(cmuClock_LFA, cmuSelect_LFXO);
+  }
+  CMU_ClockEnable(cmuClock_LETIMER0, true);
+  CMU_ClockEnable(cmuClock_PRS, true);
+
+  // Toggle on each underflow, two per EXTCOMIN period
+  init.comp0Top = true;
+  init.ufoa0 = letimerUFOAToggle;
+  init.repMode = letimerRepeatFree;
+  init.enable = false;
+  init.topValue = CMU_ClockFreqGet(cmuClock_LETIMER0)
+                  / (2 * MEMLCD_EXTCOMIN_HZ);
+
+  // Need REP0 != 0 to toggle on underflow
+  LETIMER_RepeatSet(LETIMER0, 0, 1);
+  LETIMER_Init(LETIMER0, &init);
+
+  PRS_SourceSignalSet(cfg.prsChannel, PRS_CH_CTRL_SOURCESEL_LETIMER0,
+                      PRS_CH_CTRL_SIGSEL_LETIMER0CH0, prsEdgeOff);
+  PRS->ROUTEPEN |= 1UL << cfg.prsChannel;
+  PRS_GpioOutputLocation(cfg.prsChannel, cfg.prsLocation);
+
+  LETIMER_Enable(LETIMER0, true);
+}
+
+/**************************************************************************//**
+ * @brief Set up the display, clear it and start the VCOM toggle
+ *
+ * @details
+ *    Also clears the frame buffer to white. LFA is set to the LFXO if it
+ *    has no clock yet. Call LDMA_Init() before the first update.
+ *
+ * @param[in] init
+ *    Pins and peripherals of the kit, copied.
+ *****************************************************************************/
+void MEMLCD_Init(const MEMLCD_Init_TypeDef *init)
+{
+  USART_InitSync_TypeDef usartInit = USART_INITSYNC_DEFAULT;
+  uint32_t y;
+
+  cfg = *init;
+  busy = false;
+
+  CMU_ClockEnable(cmuClock_GPIO, true);
+  CMU_ClockEnable(cfg.usartClock, true);
+
+  GPIO_PinModeSet(cfg.sclkPort, cfg.sclkPin, gpioModePushPull, 0);
+  GPIO_PinModeSet(cfg.siPort, cfg.siPin, gpioModePushPull, 0);
+  GPIO_PinModeSet(cfg.scsPort, cfg.scsPin, gpioModePushPull, 0);
+  GPIO_PinModeSet(cfg.extcominPort, cfg.extcominPin, gpioModePushPull, 0);
+  GPIO_PinModeSet(cfg.enablePort, cfg.enablePin, gpioModePushPull, 1);
+
+  // Addresses and pixel data go out LSB first
+  usartInit.baudrate = MEMLCD_BAUDRATE;
+  usartInit.msbf = false;
+  usartInit.enable = usartEnableTx;
+  USART_InitSync(cfg.usart, &usartInit);
+  cfg.usart->ROUTELOC0 = cfg.routeLoc;
+  cfg.usart->ROUTEPEN = USART_ROUTEPEN_TXPEN | USART_ROUTEPEN_CLKPEN;
+
+  for (y = 0; y < MEMLCD_HEIGHT; y++) {
+    frame[y].address = (uint8_t)(y + 1);
+    frame[y].dummy = 0;
+  }
+  MEMLCD_Clear(true);
+
+  // The display is white after the clear command, nothing to send
+  for (y = 0; y < sizeof(dirty) / sizeof(dirty[0]); y++) {
+    dirty[y] = 0;
+  }
+
+  GPIO_PinOutSet(cfg.scsPort, cfg.scsPin);
+  delayUs(SCS_SETUP_US);
+  USART_Tx(cfg.usart, CMD_ALL_CLEAR);
+  USART_Tx(cfg.usart, 0);
+  endFrame();
+
+  startExtcomin();
+}
+
+/**************************************************************************//**
+ * @brief Fill the frame buffer
+ *****************************************************************************/
+void MEMLCD_Clear(bool white)
+{
+  MEMLCD_FillRect(0, 0, MEMLCD_WIDTH, MEMLCD_HEIGHT, white);
+}
+
+/**************************************************************************//**
+ * @brief Set one pixel, ignored outside the display
+ *****************************************************************************/
+void MEMLCD_SetPixel(uint32_t x, uint32_t y, bool white)
+{
+  uint8_t *data;
+
+  if ((x >= MEMLCD_WIDTH) || (y >= MEMLCD_HEIGHT)) {
+    return;
+  }
+
+  data = MEMLCD_GetLine(y);
+  if (white) {
+    data[x / 8] |= (uint8_t)(1U << (x % 8));
+  } else {
+    data[x / 8] &= (uint8_t)~(1U << (x % 8));
+  }
+}
+
+/**************************************************************************//**
+ * @brief Fill a rectangle, clipped to the display
+ *****************************************************************************/
+void MEMLCD_FillRect(uint32_t x, uint32_t y, uint32_t width, uint32_t height,
+                     bool white)
+{
+  uint32_t xEnd, yEnd, i;
+  uint8_t *data;
+
+  if ((x >= MEMLCD_WIDTH) || (y >= MEMLCD_HEIGHT)) {
+    return;
+  }
+  xEnd = ((MEMLCD_WIDTH - x) < width) ? MEMLCD_WIDTH : (x + width);
+  yEnd = ((MEMLCD_HEIGHT - y) < height) ? MEMLCD_HEIGHT : (y + height);
+
+  for (; y < yEnd; y++) {
+    data = MEMLCD_GetLine(y);
+    for (i = x; i < xEnd; i++) {
+      if (((i % 8) == 0) && ((i + 8) <= xEnd)) {
+        // Whole bytes at a time
+        data[i / 8] = white ? 0xFF : 0x00;
+        i += 7;
+      } else if (white) {
+        data[i / 8] |= (uint8_t)(1U << (i % 8));
+      } else {
+        data[i / 8] &= (uint8_t)~(1U << (i % 8));
+      }
+    }
+  }
+}
+
+/**************************************************************************//**
+ * @brief Pixel data of a line, marked to be sent by the next update
+ *
+ * @return
+ *    MEMLCD_LINE_BYTES bytes, or NULL if y is outside the display.
+ *****************************************************************************/
+uint8_t *MEMLCD_GetLine(uint32_t y)
+{
+  if (y >= MEMLCD_HEIGHT) {
+    return NULL;
+  }
+  dirty[y / 32] |= 1UL << (y % 32);
+
+  return frame[y].data;
+}
+
+/**************************************************************************//**
+ * @brief Mark lines first to last to be sent, such as after writing them
+ *    through a pointer kept from MEMLCD_GetLine()
+ *****************************************************************************/
+void MEMLCD_MarkDirty(uint32_t first, uint32_t last)
+{
+  uint32_t y;
+
+  for (y = first; (y <= last) && (y < MEMLCD_HEIGHT); y++) {
+    dirty[y / 32] |= 1UL << (y % 32);
+  }
+}
+
+/**************************************************************************//**
+ * @brief Send the changed lines
+ *
+ * @details
+ *    Links one descriptor per run of consecutive changed lines and starts
+ *    the LDMA. Returns at once; MEMLCD_IsBusy() is true until the last
+ *    byte has left the USART.
+ *
+ * @return
+ *    false if the previous update is still in progress.
+ *****************************************************************************/
+bool MEMLCD_Update(void)
+{
+  LDMA_TransferCfg_t xfer = LDMA_TRANSFER_CFG_PERIPHERAL(cfg.txSignal);
+  volatile uint32_t *txData = &cfg.usart->TXDATA;
+  uint32_t y = 0, runs = 0, start;
+
+  if (busy) {
+    return false;
+  }
+
+  while (y < MEMLCD_HEIGHT) {
+    if ((dirty[y / 32] == 0) && ((y % 32) == 0)) {
+      // Skip 32 clean lines at a time
+      y += 32;
+      continue;
+    }
+    if (!isDirty(y)) {
+      y++;
+      continue;
+    }
+    if (runs == MEMLCD_MAX_RUNS) {
+      counters.carried++;
+      break;
+    }
+
+    start = y;
+    while ((y < MEMLCD_HEIGHT) && isDirty(y) && ((y - start) < RUN_LINES)) {
+      dirty[y / 32] &= ~(1UL << (y % 32));
+      y++;
+    }
+    desc[1 + runs] = (LDMA_Descriptor_t)
+                     LDMA_DESCRIPTOR_LINKREL_M2P_BYTE(&frame[start], txData,
+                                                      (y - start) * sizeof(Line_t), 1);
+    runs++;
+    counters.lines += y - start;
+    counters.bytes += (y - start) * sizeof(Line_t);
+  }
+
+  if (runs == 0) {
+    return true;
+  }
+
+  desc[0] = (LDMA_Descriptor_t)
+            LDMA_DESCRIPTOR_LINKREL_M2P_BYTE(&modeByte, txData, 1, 1);
+  desc[1 + runs] = (LDMA_Descriptor_t)
+                   LDMA_DESCRIPTOR_SINGLE_M2P_BYTE(&trailerByte, txData, 1);
+  counters.bytes += 2;
+  counters.updates++;
+
+  busy = true;
+
+  // Low time since the last update, which may just have ended
+  delayUs(SCS_LOW_US);
+  GPIO_PinOutSet(cfg.scsPort, cfg.scsPin);
+  delayUs(SCS_SETUP_US);
+
+  LDMA_StartTransfer(MEMLCD_LDMA_CHANNEL, &xfer, &desc[0]);
+
+  return true;
+}
+
+/**************************************************************************//**
+ * @brief Whether an update is in progress
+ *****************************************************************************/
+bool MEMLCD_IsBusy(void)
+{
+  return busy;
+}
+
+/**************************************************************************//**
+ * @brief Finish an update, call from LDMA_IRQHandler()
+ *
+ * @details
+ *    Waits for the last two bytes to leave the USART, about 16 us at 1 MHz,
+ *    and deselects the display.
+ *****************************************************************************/
+void MEMLCD_IRQHandler(void)
+{
+  if (!(LDMA_IntGet() & (1UL << MEMLCD_LDMA_CHANNEL))) {
+    return;
+  }
+  LDMA_IntClear(1UL << MEMLCD_LDMA_CHANNEL);
+
+  endFrame();
+  busy = false;
+}
+
+/**************************************************************************//**
+ * @brief Copy the counters
+ *****************************************************************************/
+void MEMLCD_GetCounters(MEMLCD_Counters_TypeDef *copy)
+{
+  *copy = counters;
+}
+
+/** @} (end group MemLcd) */
+/** @} (end group kitdrv) */
@@ -0,0 +1,171 @@
+/***************************************************************************//**
+ * @file
+ * @brief Sharp memory LCD driver sending only the changed lines by LDMA.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2022 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ******************************************************************************/
+
+#ifndef __MEMLCD_H
+#define __MEMLCD_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "em_device.h"
+#include "em_cmu.h"
+#include "em_gpio.h"
+#include "em_ldma.h"
+
+/***************************************************************************//**
+ * @addtogroup kitdrv
+ * @{
+ ******************************************************************************/
+
+/***************************************************************************//**
+ * @addtogroup MemLcd
+ * @brief Sharp memory LCD driver sending only the changed lines by LDMA
+ * @details
+ *    Drives the 128x128 LS013B7DH03 memory LCD of the starter kits over a
+ *    USART in SPI mode. A memory LCD keeps each line until it is written
+ *    again, so MEMLCD_Update() sends only the lines drawn since the last
+ *    update, tracked one bit per line.
+ *
+ *    Each line of the frame buffer is stored as it goes out on the wire:
+ *    its address byte, the pixel data and the dummy byte that ends it. A
+ *    run of consecutive changed lines is therefore one block of memory,
+ *    and one LDMA descriptor sends it. MEMLCD_Update() links one descriptor
+ *    per run, after the mode byte and before the trailer byte, into a
+ *    scatter-gather list and starts it; the CPU writes no SPI data. Up to
+ *    MEMLCD_MAX_RUNS runs go in one update, lines left over stay marked
+ *    and go in the next one.
+ *
+ *    The display needs its VCOM polarity inverted at least once per
+ *    second. LETIMER0 toggles its output 0 at 2 * MEMLCD_EXTCOMIN_HZ and a
+ *    PRS channel routes it to the EXTCOMIN pin, so this goes on in EM2
+ *    with no interrupt. The display runs with EXTMODE high, as on the kits.
+ *
+ *    The application calls LDMA_Init() once, does not use the channel for
+ *    anything else, and calls MEMLCD_IRQHandler() from its
+ *    LDMA_IRQHandler(). Lines drawn while an update is in progress are
+ *    marked again and go in the next one.
+ *
+ *    Pixel x of line y is bit x % 8 of byte x / 8, sent first; a set bit
+ *    is a white pixel.
+ * @{
+ ******************************************************************************/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Pixels per line */
+#ifndef MEMLCD_WIDTH
+#define MEMLCD_WIDTH            128
+#endif
+
+/** Lines */
+#ifndef MEMLCD_HEIGHT
+#define MEMLCD_HEIGHT           128
+#endif
+
+/** SPI clock, at most 1.1 MHz for the LS013B7DH03 */
+#ifndef MEMLCD_BAUDRATE
+#define MEMLCD_BAUDRATE         1000000
+#endif
+
+/** LDMA channel of the updates */
+#ifndef MEMLCD_LDMA_CHANNEL
+#define MEMLCD_LDMA_CHANNEL     0
+#endif
+
+/** Runs of changed lines sent by one update */
+#ifndef MEMLCD_MAX_RUNS
+#define MEMLCD_MAX_RUNS         16
+#endif
+
+/** VCOM inversion rate, 1 to 60 Hz */
+#ifndef MEMLCD_EXTCOMIN_HZ
+#define MEMLCD_EXTCOMIN_HZ      32
+#endif
+
+#if (MEMLCD_WIDTH % 8) != 0
+#error "MEMLCD_WIDTH must be a multiple of 8"
+#endif
+
+#if MEMLCD_MAX_RUNS < 1
+#error "MEMLCD_MAX_RUNS must be at least 1"
+#endif
+
+/** Bytes of pixel data per line */
+#define MEMLCD_LINE_BYTES       (MEMLCD_WIDTH / 8)
+
+/** Pins and peripherals of a kit */
+typedef struct {
+  USART_TypeDef           *usart;       /**< USART of the display */
+  CMU_Clock_TypeDef       usartClock;   /**< Its clock */
+  uint32_t                routeLoc;     /**< USART ROUTELOC0, TX and CLK */
+  LDMA_PeripheralSignal_t txSignal;     /**< TXBL signal of the USART */
+  GPIO_Port_TypeDef       sclkPort;     /**< SCLK, USART CLK */
+  uint8_t                 sclkPin;
+  GPIO_Port_TypeDef       siPort;       /**< SI, USART TX */
+  uint8_t                 siPin;
+  GPIO_Port_TypeDef       scsPort;      /**< SCS, chip select, high active */
+  uint8_t                 scsPin;
+  GPIO_Port_TypeDef       enablePort;   /**< Display enable */
+  uint8_t                 enablePin;
+  GPIO_Port_TypeDef       extcominPort; /**< EXTCOMIN, VCOM toggle */
+  uint8_t                 extcominPin;
+  uint8_t                 prsChannel;   /**< PRS channel to EXTCOMIN */
+  uint8_t                 prsLocation;  /**< PRS location of EXTCOMIN */
+} MEMLCD_Init_TypeDef;
+
+/** Counters, all only ever count up */
+typedef struct {
+  uint32_t updates;       /**< Updates started */
+  uint32_t lines;         /**< Lines sent */
+  uint32_t bytes;         /**< Bytes sent */
+  uint32_t carried;       /**< Updates that left lines for the next one */
+} MEMLCD_Counters_TypeDef;
+
+void MEMLCD_Init(const MEMLCD_Init_TypeDef *init);
+void MEMLCD_Clear(bool white);
+void MEMLCD_SetPixel(uint32_t x, uint32_t y, bool white);
+void MEMLCD_FillRect(uint32_t x, uint32_t y, uint32_t width, uint32_t height,
+                     bool white);
+uint8_t *MEMLCD_GetLine(uint32_t y);
+void MEMLCD_MarkDirty(uint32_t first, uint32_t last);
+bool MEMLCD_Update(void);
+bool MEMLCD_IsBusy(void);
+void MEMLCD_IRQHandler(void);
+void MEMLCD_GetCounters(MEMLCD_Counters_TypeDef *counters);
+
+#ifdef __cplusplus
+}
+#endif
+
+/** @} (end group MemLcd) */
+/** @} (end group kitdrv) */
+
+#endif
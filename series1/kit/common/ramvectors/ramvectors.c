@@ -0,0 +1,180 @@
+/***************************************************************************//**
+ * @file
+ * @brief Vector table relocation to RAM.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2022 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ******************************************************************************/
+
+
+#include <stddef.h>
+#include "ramvectors.h"
+
+/***************************************************************************//**
+ * @addtogroup kitdrv
+ * @{
+ ******************************************************************************/
+
+/***************************************************************************//**
+ * @addtogroup RamVectors
+ * @{
+ ******************************************************************************/
+
+// RAM copy of the vector table. It is not initialized by the startup code,
+// RAMVECTORS_Init() fills it in.
+#if defined(__ICCARM__)
+#pragma data_alignment=RAMVECTORS_ALIGNMENT
+static __no_init uint32_t ramTable[RAMVECTORS_COUNT];
+#else
+static uint32_t ramTable[RAMVECTORS_COUNT]
+__attribute__((aligned(RAMVECTORS_ALIGNMENT)));
+#endif
+
+// VTOR before RAMVECTORS_Init(), restored by RAMVECTORS_Deinit()
+static uint32_t flashVtor;
+
+/***************************************************************************//**
+ * @brief
+ *   Copy the vector table to RAM and switch to the copy.
+ *
+ * @details
+ *   The table in use when this is called, normally the one of the startup
+ *   code in flash, is copied, so handlers set with NVIC_SetVector()
+ *   beforehand are kept. Calling it again copies the RAM table onto
+ *   itself and has no effect.
+ ******************************************************************************/
+void RAMVECTORS_Init(void)
+{
+  const uint32_t *table;
+  uint32_t primask;
+  uint32_t i;
+
+  if (RAMVECTORS_IsActive()) {
+    return;
+  }
+
+  // No exception may take the table while it is half copied
+  primask = __get_PRIMASK();
+  __disable_irq();
+
+  flashVtor = SCB->VTOR;
+  table = (const uint32_t *)flashVtor;
+  for (i = 0; i < RAMVECTORS_COUNT; i++) {
+    ramTable[i] = table[i];
+  }
+
+  // Complete the copy before the next exception fetches a vector from it
+  __DSB();
+  SCB->VTOR = (uint32_t)ramTable;
+  __DSB();
+  __ISB();
+
+  __set_PRIMASK(primask);
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Switch back to the vector table in use before RAMVECTORS_Init().
+ *
+ * @details
+ *   Handlers set in the RAM table are not copied back.
+ ******************************************************************************/
+void RAMVECTORS_Deinit(void)
+{
+  if (!RAMVECTORS_IsActive()) {
+    return;
+  }
+
+  SCB->VTOR = flashVtor;
+  __DSB();
+  __ISB();
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Check whether the RAM vector table is in use.
+ *
+ * @return
+ *   True if VTOR points at the RAM table.
+ ******************************************************************************/
+bool RAMVECTORS_IsActive(void)
+{
+  return SCB->VTOR == (uint32_t)ramTable;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Set the handler of an interrupt or exception in the RAM table.
+ *
+ * @param[in] irq
+ *   Interrupt number, negative for the system exceptions.
+ *
+ * @param[in] handler
+ *   Handler to install.
+ *
+ * @return
+ *   False if the RAM table is not in use or @p irq is out of range.
+ ******************************************************************************/
+bool RAMVECTORS_SetHandler(IRQn_Type irq, RAMVECTORS_Handler_t handler)
+{
+  int32_t index = (int32_t)irq + 16;
+
+  if (!RAMVECTORS_IsActive()
+      || (index < 1) || (index >= (int32_t)RAMVECTORS_COUNT)
+      || (handler == NULL)) {
+    return false;
+  }
+
+  // A single aligned word store, the entry is never seen half written
+  ramTable[index] = (uint32_t)handler;
+  __DSB();
+
+  return true;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Get the handler of an interrupt or exception in the table in use.
+ *
+ * @param[in] irq
+ *   Interrupt number, negative for the system exceptions.
+ *
+ * @return
+ *   The handler, or NULL if @p irq is out of range.
+ ******************************************************************************/
+RAMVECTORS_Handler_t RAMVECTORS_GetHandler(IRQn_Type irq)
+{
+  int32_t index = (int32_t)irq + 16;
+  const uint32_t *table = (const uint32_t *)SCB->VTOR;
+
+  if ((index < 1) || (index >= (int32_t)RAMVECTORS_COUNT)) {
+    return NULL;
+  }
+
+  return (RAMVECTORS_Handler_t)table[index];
+}
+
+/** @} (end group RamVectors) */
+/** @} (end group kitdrv) */
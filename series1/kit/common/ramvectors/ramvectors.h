@@ -0,0 +1,94 @@
+/***************************************************************************//**
+ * @file
+ * @brief Vector table relocation to RAM.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2022 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ******************************************************************************/
+
+
+#ifndef __RAMVECTORS_H
+#define __RAMVECTORS_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "em_device.h"
+
+/***************************************************************************//**
+ * @addtogroup kitdrv
+ * @{
+ ******************************************************************************/
+
+/***************************************************************************//**
+ * @addtogroup RamVectors
+ * @brief Vector table relocation to RAM
+ * @details
+ *    Copies the vector table that is in use to RAM and points VTOR at the
+ *    copy. With the table in RAM, the vector fetch of each exception entry
+ *    no longer waits for the flash, and single handlers can be replaced
+ *    at run time with RAMVECTORS_SetHandler().
+ *
+ *    Handlers that have to run from RAM as well are defined between
+ *    SL_RAMFUNC_DEFINITION_BEGIN and SL_RAMFUNC_DEFINITION_END from
+ *    em_ramfunc.h and installed with RAMVECTORS_SetHandler(). Such a
+ *    handler must not call functions in flash, or it waits for the flash
+ *    after all.
+ *
+ *    The table is an aligned part of .bss, so the linker may leave up to
+ *    RAMVECTORS_ALIGNMENT bytes of padding in front of it.
+ * @{
+ ******************************************************************************/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Exception and interrupt entries in the vector table */
+#define RAMVECTORS_COUNT          (16U + EXT_IRQ_COUNT)
+
+/** Alignment of the RAM table: the table size rounded up to a power of two */
+#define RAMVECTORS_ALIGNMENT      512U
+
+#if (RAMVECTORS_COUNT * 4U) > RAMVECTORS_ALIGNMENT
+#error "Vector table larger than RAMVECTORS_ALIGNMENT"
+#endif
+
+/** Interrupt or exception handler */
+typedef void (*RAMVECTORS_Handler_t)(void);
+
+void                 RAMVECTORS_Init(void);
+void                 RAMVECTORS_Deinit(void);
+bool                 RAMVECTORS_IsActive(void);
+bool                 RAMVECTORS_SetHandler(IRQn_Type irq, RAMVECTORS_Handler_t handler);
+RAMVECTORS_Handler_t RAMVECTORS_GetHandler(IRQn_Type irq);
+
+#ifdef __cplusplus
+}
+#endif
+
+/** @} (end group RamVectors) */
+/** @} (end group kitdrv) */
+
+#endif
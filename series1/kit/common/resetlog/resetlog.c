@@ -0,0 +1,305 @@
+/***************************************************************************//**
+ * @file
+ * @brief Reset cause log in flash, kept through every kind of reset.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2022 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ******************************************************************************/
+
+#include "em_msc.h"
+#include "resetlog.h"
+
+/***************************************************************************//**
+ * @addtogroup kitdrv
+ * @{
+ ******************************************************************************/
+
+/***************************************************************************//**
+ * @addtogroup ResetLog
+ * @{
+ ******************************************************************************/
+
+#if (RESETLOG_BYTES % 16) != 0
+#error "RESETLOG_BYTES must be a multiple of the 16 byte entry"
+#endif
+
+#define ERASED  0xFFFFFFFFUL
+#define LOG     ((const RESETLOG_Entry_TypeDef *)RESETLOG_BASE)
+
+// Slot of the next entry, the first one after the last written
+static uint32_t next;
+
+// Boot number of the newest entry
+static uint32_t lastBoot;
+static bool     haveBoot;
+
+// Slot of the entry of this boot, RESETLOG_ENTRIES before RESETLOG_Record()
+static uint32_t current = RESETLOG_ENTRIES;
+
+// Entries kept while the log is compacted
+static RESETLOG_Entry_TypeDef kept[RESETLOG_ENTRIES / 2];
+
+/**************************************************************************//**
+ * @brief Whether a slot has not been written since the last erase
+ *****************************************************************************/
+static bool isErased(const RESETLOG_Entry_TypeDef *entry)
+{
+  return (entry->cause == ERASED) && (entry->timestamp == ERASED)
+         && (entry->boot == ERASED) && (entry->bootTime == ERASED);
+}
+
+/**************************************************************************//**
+ * @brief Whether a slot holds a complete entry
+ *****************************************************************************/
+static bool isValid(const RESETLOG_Entry_TypeDef *entry)
+{
+  return entry->boot != ERASED;
+}
+
+/**************************************************************************//**
+ * @brief Write an entry to an erased slot, the boot number last
+ *****************************************************************************/
+static bool writeEntry(uint32_t slot, const RESETLOG_Entry_TypeDef *entry)
+{
+  bool ok;
+
+  MSC_Init();
+  ok = MSC_WriteWord((uint32_t *)&LOG[slot].cause, &entry->cause, 8)
+       == mscReturnOk;
+  if (ok && (entry->bootTime != ERASED)) {
+    ok = MSC_WriteWord((uint32_t *)&LOG[slot].bootTime, &entry->bootTime, 4)
+         == mscReturnOk;
+  }
+  if (ok) {
+    ok = MSC_WriteWord((uint32_t *)&LOG[slot].boot, &entry->boot, 4)
+         == mscReturnOk;
+  }
+  MSC_Deinit();
+
+  return ok;
+}
+
+/**************************************************************************//**
+ * @brief Erase the log page
+ *****************************************************************************/
+static void erase(void)
+{
+  MSC_Init();
+  MSC_ErasePage((uint32_t *)RESETLOG_BASE);
+  MSC_Deinit();
+  next = 0;
+  current = RESETLOG_ENTRIES;
+}
+
+/**************************************************************************//**
+ * @brief Make room: keep the newest half of the entries and erase the rest
+ *
+ * @details
+ *    A reset while the page is erased and written again loses the kept
+ *    entries, not the ones written after.
+ *****************************************************************************/
+static void compact(void)
+{
+  uint32_t count = 0;
+  uint32_t i = RESETLOG_ENTRIES;
+
+  while ((i > 0) && (count < (RESETLOG_ENTRIES / 2))) {
+    i--;
+    if (isValid(&LOG[i])) {
+      count++;
+      kept[(RESETLOG_ENTRIES / 2) - count] = LOG[i];
+    }
+  }
+
+  erase();
+
+  for (i = (RESETLOG_ENTRIES / 2) - count; i < (RESETLOG_ENTRIES / 2); i++) {
+    writeEntry(next, &kept[i]);
+    next++;
+  }
+}
+
+/**************************************************************************//**
+ * @brief Find the end of the log
+ *
+ * @details
+ *    Call once after reset, before RESETLOG_Record().
+ *****************************************************************************/
+void RESETLOG_Init(void)
+{
+  uint32_t i;
+
+  next = 0;
+  haveBoot = false;
+  current = RESETLOG_ENTRIES;
+
+  for (i = 0; i < RESETLOG_ENTRIES; i++) {
+    if (!isErased(&LOG[i])) {
+      next = i + 1;
+    }
+    if (isValid(&LOG[i])) {
+      lastBoot = LOG[i].boot;
+      haveBoot = true;
+    }
+  }
+}
+
+/**************************************************************************//**
+ * @brief Append the entry of this boot
+ *
+ * @param[in] cause
+ *    Reset cause bits, from RMU_ResetCauseGet().
+ *
+ * @param[in] timestamp
+ *    Time of the boot.
+ *
+ * @return
+ *    false if the flash write failed; the slot is not used again.
+ *****************************************************************************/
+bool RESETLOG_Record(uint32_t cause, uint32_t timestamp)
+{
+  RESETLOG_Entry_TypeDef entry;
+
+  if (next >= RESETLOG_ENTRIES) {
+    compact();
+  }
+
+  entry.cause = cause;
+  entry.timestamp = timestamp;
+  entry.boot = haveBoot ? (lastBoot + 1) : 0;
+  entry.bootTime = ERASED;
+
+  // Kept for the next boot number even if the write fails
+  lastBoot = entry.boot;
+  haveBoot = true;
+  current = next;
+  next++;
+
+  return writeEntry(current, &entry);
+}
+
+/**************************************************************************//**
+ * @brief Add the time this boot took to its entry
+ *
+ * @details
+ *    Call once, when the application is ready.
+ *
+ * @return
+ *    false without an entry for this boot, or if it already has a time.
+ *****************************************************************************/
+bool RESETLOG_SetBootTime(uint32_t bootTime)
+{
+  bool ok;
+
+  if ((current >= RESETLOG_ENTRIES) || (LOG[current].bootTime != ERASED)
+      || (bootTime == ERASED)) {
+    return false;
+  }
+
+  MSC_Init();
+  ok = MSC_WriteWord((uint32_t *)&LOG[current].bootTime, &bootTime, 4)
+       == mscReturnOk;
+  MSC_Deinit();
+
+  return ok;
+}
+
+/**************************************************************************//**
+ * @brief Get the number of complete entries
+ *****************************************************************************/
+uint32_t RESETLOG_Count(void)
+{
+  uint32_t count = 0;
+  uint32_t i;
+
+  for (i = 0; i < next; i++) {
+    if (isValid(&LOG[i])) {
+      count++;
+    }
+  }
+  return count;
+}
+
+/**************************************************************************//**
+ * @brief Get an entry, the oldest first
+ *
+ * @return
+ *    false if index is not below RESETLOG_Count().
+ *****************************************************************************/
+bool RESETLOG_Get(uint32_t index, RESETLOG_Entry_TypeDef *entry)
+{
+  uint32_t i;
+
+  for (i = 0; i < next; i++) {
+    if (isValid(&LOG[i])) {
+      if (index == 0) {
+        *entry = LOG[i];
+        return true;
+      }
+      index--;
+    }
+  }
+  return false;
+}
+
+/**************************************************************************//**
+ * @brief Count the entries, and sum their boot times, for a set of causes
+ *
+ * @param[in] causeMask
+ *    Entries with any of these cause bits are counted.
+ *****************************************************************************/
+void RESETLOG_GetStats(uint32_t causeMask, RESETLOG_Stats_TypeDef *stats)
+{
+  uint32_t i;
+
+  stats->count = 0;
+  stats->timed = 0;
+  stats->bootTimeSum = 0;
+  stats->bootTimeMax = 0;
+
+  for (i = 0; i < next; i++) {
+    if (isValid(&LOG[i]) && (LOG[i].cause & causeMask)) {
+      stats->count++;
+      if (LOG[i].bootTime != ERASED) {
+        stats->timed++;
+        stats->bootTimeSum += LOG[i].bootTime;
+        if (LOG[i].bootTime > stats->bootTimeMax) {
+          stats->bootTimeMax = LOG[i].bootTime;
+        }
+      }
+    }
+  }
+}
+
+/**************************************************************************//**
+ * @brief Erase all entries; boot numbers go on counting
+ *****************************************************************************/
+void RESETLOG_Clear(void)
+{
+  erase();
+}
+
+/** @} (end group ResetLog) */
+/** @} (end group kitdrv) */
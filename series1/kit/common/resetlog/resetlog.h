@@ -0,0 +1,115 @@
+/***************************************************************************//**
+ * @file
+ * @brief Reset cause log in flash, kept through every kind of reset.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2022 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ******************************************************************************/
+
+#ifndef __RESETLOG_H
+#define __RESETLOG_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "em_device.h"
+
+/***************************************************************************//**
+ * @addtogroup kitdrv
+ * @{
+ ******************************************************************************/
+
+/***************************************************************************//**
+ * @addtogroup ResetLog
+ * @brief Persistent log of reset causes and of the time each boot took
+ * @details
+ *    Each boot appends one entry of four words to a flash page, the
+ *    USERDATA page by default: the reset cause bits, a timestamp, the boot
+ *    number and, once the application is up, the time the boot took. Flash
+ *    keeps the log through power on and brown-out resets, which clear the
+ *    retention RAM, so the log shows the resets that cost a full restart.
+ *
+ *    Entries are written with single word writes into erased flash, the
+ *    boot number last, so an entry torn by a reset in the middle of the
+ *    write has no boot number and is skipped. When the log is full, the
+ *    newest half is kept and the page erased and written again; boot
+ *    numbers go on counting, so gaps show the entries that were dropped.
+ *
+ *    The cause bits are what RMU_ResetCauseGet() returns on the device.
+ *    The timestamp and the boot time are in units of the application's
+ *    choice, such as seconds of a clock kept through resets, and core clock
+ *    cycles from reset to ready. Writing flash stalls the core, call the
+ *    functions from the main loop only.
+ * @{
+ ******************************************************************************/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Flash area of the log, a page of its own that nothing else writes */
+#ifndef RESETLOG_BASE
+#define RESETLOG_BASE           USERDATA_BASE
+#endif
+
+/** Bytes of the log, at most the page size */
+#ifndef RESETLOG_BYTES
+#define RESETLOG_BYTES          1024
+#endif
+
+/** One boot */
+typedef struct {
+  uint32_t cause;         /**< Reset cause bits */
+  uint32_t timestamp;     /**< Time of the boot */
+  uint32_t boot;          /**< Boot number */
+  uint32_t bootTime;      /**< Time to ready, 0xFFFFFFFF if never set */
+} RESETLOG_Entry_TypeDef;
+
+/** Entries the log holds */
+#define RESETLOG_ENTRIES        (RESETLOG_BYTES / sizeof(RESETLOG_Entry_TypeDef))
+
+/** Sums over the entries with any of a set of cause bits */
+typedef struct {
+  uint32_t count;         /**< Entries */
+  uint32_t timed;         /**< Entries with a boot time */
+  uint64_t bootTimeSum;   /**< Sum of their boot times */
+  uint32_t bootTimeMax;   /**< Longest boot time */
+} RESETLOG_Stats_TypeDef;
+
+void      RESETLOG_Init(void);
+bool      RESETLOG_Record(uint32_t cause, uint32_t timestamp);
+bool      RESETLOG_SetBootTime(uint32_t bootTime);
+uint32_t  RESETLOG_Count(void);
+bool      RESETLOG_Get(uint32_t index, RESETLOG_Entry_TypeDef *entry);
+void      RESETLOG_GetStats(uint32_t causeMask, RESETLOG_Stats_TypeDef *stats);
+void      RESETLOG_Clear(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+/** @} (end group ResetLog) */
+/** @} (end group kitdrv) */
+
+#endif
@@ -0,0 +1,528 @@
+/***************************************************************************//**
+ * @file
+ * @brief Real-time clock on the RTCC: epoch time, calendar and alarms.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2022 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ******************************************************************************/
+
+#include <stddef.h>
+#include "em_core.h"
+#include "em_rtcc.h"
+#include "rtcclock.h"
+
+/***************************************************************************//**
+ * @addtogroup kitdrv
+ * @{
+ ******************************************************************************/
+
+/***************************************************************************//**
+ * @addtogroup RtcClock
+ * @{
+ ******************************************************************************/
+
+// Check word of a clock that has been set, and of one that has not
+#define CHECK_SET     0x52544353UL
+#define CHECK_UNSET   0x52544355UL
+
+// Retention words after the check word
+#define RET_OFFSET    1
+#define RET_PERIOD    3
+
+// Days from 0000-03-01 to 1970-01-01, and per 400 year era
+#define EPOCH_DAYS    719468UL
+#define ERA_DAYS      146097UL
+
+// Latest year converted; the seconds stay below 2^39
+#define MAX_YEAR      9999U
+
+// Interrupt flags of the alarms, one per compare channel
+#define ALARM_FLAGS   (RTCC_IF_CC0 | RTCC_IF_CC1 | RTCC_IF_CC2)
+
+static volatile uint32_t *retention;
+
+// Seconds at counter 0
+static uint64_t offset;
+static bool     isSet;
+
+// Periods of the alarms, 0 for alarms that fire once
+static uint32_t period[RTCCLOCK_ALARMS];
+
+static RTCCLOCK_Callback_t callback;
+static void *callbackData;
+
+/**************************************************************************//**
+ * @brief Check word of the state, for the retention
+ *****************************************************************************/
+static uint32_t checkWord(void)
+{
+  uint32_t check = isSet ? CHECK_SET : CHECK_UNSET;
+  uint32_t i;
+
+  check ^= (uint32_t)offset ^ (uint32_t)(offset >> 32);
+  for (i = 0; i < RTCCLOCK_ALARMS; i++) {
+    check ^= period[i];
+  }
+
+  return check;
+}
+
+/**************************************************************************//**
+ * @brief Write the state to the retention, the check word last
+ *****************************************************************************/
+static void save(void)
+{
+  uint32_t i;
+
+  retention[RET_OFFSET] = (uint32_t)offset;
+  retention[RET_OFFSET + 1] = (uint32_t)(offset >> 32);
+  for (i = 0; i < RTCCLOCK_ALARMS; i++) {
+    retention[RET_PERIOD + i] = period[i];
+  }
+  retention[0] = checkWord();
+}
+
+/**************************************************************************//**
+ * @brief Read the state back from the retention
+ *
+ * @return
+ *   false if the check word does not match.
+ *****************************************************************************/
+static bool load(void)
+{
+  uint32_t i;
+
+  offset = ((uint64_t)retention[RET_OFFSET + 1] << 32)
+           | retention[RET_OFFSET];
+  for (i = 0; i < RTCCLOCK_ALARMS; i++) {
+    period[i] = retention[RET_PERIOD + i];
+  }
+
+  isSet = true;
+  if (retention[0] == checkWord()) {
+    return true;
+  }
+  isSet = false;
+  return retention[0] == checkWord();
+}
+
+/**************************************************************************//**
+ * @brief Read the counter and the pre-counter of the same tick
+ *
+ * @details
+ *    The pre-counter wraps as the counter steps; the counter read on each
+ *    side of it tells whether it did in between.
+ *****************************************************************************/
+static uint32_t readCounter(uint32_t *ticks)
+{
+  uint32_t count;
+
+  do {
+    count = RTCC_CounterGet();
+    *ticks = RTCC_PreCounterGet();
+  } while (count != RTCC_CounterGet());
+
+  return count;
+}
+
+/**************************************************************************//**
+ * @brief Whether a year is a leap year
+ *****************************************************************************/
+static bool isLeap(uint32_t year)
+{
+  return ((year % 4U) == 0U) && (((year % 100U) != 0U) || ((year % 400U) == 0U));
+}
+
+/**************************************************************************//**
+ * @brief Match of a repeating alarm after the one that has passed
+ *
+ * @details
+ *    Periods that went by without a match, in EM4 with the RTCC stopped by
+ *    a bootloader for example, are skipped rather than fired in a burst.
+ *****************************************************************************/
+static uint32_t nextMatch(uint32_t match, uint32_t alarmPeriod)
+{
+  uint32_t count = RTCC_CounterGet();
+
+  match += alarmPeriod;
+  if ((int32_t)(match - count) <= 0) {
+    match += ((count - match) / alarmPeriod + 1U) * alarmPeriod;
+  }
+
+  return match;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Start the clock, or pick it up after an EM4 wake-up
+ *
+ * @param[in] ret
+ *   RTCCLOCK_RET_WORDS words of RTCC retention registers for the state.
+ *
+ * @param[in] wake
+ *   true if the last reset was an EM4 wake-up, and the RTCC kept running.
+ *
+ * @param[in] alarmCallback
+ *   Called from RTCCLOCK_IRQHandler() for each alarm that fires, or NULL.
+ *
+ * @param[in] data
+ *   Passed to the callback.
+ *
+ * @return
+ *   true if the time and the alarms were kept from before the reset.
+ ******************************************************************************/
+bool RTCCLOCK_Init(volatile uint32_t *ret,
+                   bool wake,
+                   RTCCLOCK_Callback_t alarmCallback,
+                   void *data)
+{
+  RTCC_Init_TypeDef init = RTCC_INIT_DEFAULT;
+  uint32_t i;
+  bool kept;
+
+  retention = ret;
+  callback = alarmCallback;
+  callbackData = data;
+
+  kept = wake && load();
+  if (kept) {
+    // A bootloader that resets the RTCC on its way out stops it; the time
+    // is late by as long as it was stopped
+    if (!(RTCC->CTRL & RTCC_CTRL_ENABLE)) {
+      RTCC_Enable(true);
+    }
+  } else {
+    RTCC_Reset();
+    init.debugRun = false;
+    init.precntWrapOnCCV0 = false;
+    init.cntWrapOnCCV1 = false;
+    init.presc = rtccCntPresc_32768;
+    init.prescMode = rtccCntTickPresc;
+    init.cntMode = rtccCntModeNormal;
+    RTCC_Init(&init);
+
+    offset = 0;
+    isSet = false;
+    for (i = 0; i < RTCCLOCK_ALARMS; i++) {
+      period[i] = 0;
+    }
+    save();
+  }
+
+  // Alarms that fired in EM4 are still flagged and are handled now
+  NVIC_ClearPendingIRQ(RTCC_IRQn);
+  NVIC_EnableIRQ(RTCC_IRQn);
+
+  return kept;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Whether the time has been set since the clock started
+ ******************************************************************************/
+bool RTCCLOCK_IsSet(void)
+{
+  return isSet;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Set the time
+ *
+ * @details
+ *    Alarms that are set keep their time, and those that the new time
+ *    skips over fire at once. Call from the main loop, not while a
+ *    handler can take a timestamp.
+ *
+ * @param[in] seconds
+ *   Seconds since 1970-01-01 00:00:00.
+ ******************************************************************************/
+void RTCCLOCK_Set(uint64_t seconds)
+{
+  uint32_t ticks;
+  uint32_t count;
+  uint32_t shift;
+  uint32_t i;
+  CORE_DECLARE_IRQ_STATE;
+
+  CORE_ENTER_ATOMIC();
+  count = readCounter(&ticks);
+  shift = (uint32_t)((seconds - count) - offset);
+  offset = seconds - count;
+
+  if (isSet) {
+    for (i = 0; i < RTCCLOCK_ALARMS; i++) {
+      if (RTCC->IEN & (RTCC_IEN_CC0 << i)) {
+        RTCC_ChannelCCVSet(i, RTCC_ChannelCCVGet(i) - shift);
+        if ((int32_t)(RTCC_ChannelCCVGet(i) - count) <= 0) {
+          RTCC_IntSet(RTCC_IF_CC0 << i);
+        }
+      }
+    }
+  }
+  isSet = true;
+  save();
+  CORE_EXIT_ATOMIC();
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Timestamp, ticks of 1 / RTCCLOCK_TICK_HZ s since 1970-01-01 00:00:00
+ ******************************************************************************/
+uint64_t RTCCLOCK_Now(void)
+{
+  uint32_t ticks;
+  uint32_t count = readCounter(&ticks);
+
+  return ((offset + count) << RTCCLOCK_TICK_SHIFT) | ticks;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Seconds since 1970-01-01 00:00:00
+ ******************************************************************************/
+uint64_t RTCCLOCK_Seconds(void)
+{
+  return offset + RTCC_CounterGet();
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Date and time of day of a time
+ *
+ * @details
+ *    The year, month and day come from the days since the epoch with the
+ *    days of 400 year eras, centuries, 4 year cycles and years, counted
+ *    from March 1 so that February 29 is the last day of a year. All the
+ *    divisions are by constants.
+ *
+ * @param[in] seconds
+ *   Seconds since 1970-01-01 00:00:00, before the year 10000.
+ *
+ * @param[out] date
+ *   Date and time of day.
+ ******************************************************************************/
+void RTCCLOCK_ToDate(uint64_t seconds, RTCCLOCK_Date_t *date)
+{
+  // 86400 = 128 * 675, so the days take a 32 bit division
+  uint32_t days = (uint32_t)(seconds >> 7) / 675U;
+  uint32_t time = (uint32_t)(seconds - ((uint64_t)days * RTCCLOCK_DAY));
+  uint32_t z = days + EPOCH_DAYS;
+  uint32_t era = z / ERA_DAYS;
+  uint32_t dayOfEra = z - (era * ERA_DAYS);
+  uint32_t yearOfEra = (dayOfEra - (dayOfEra / 1460U) + (dayOfEra / 36524U)
+                        - (dayOfEra / 146096U)) / 365U;
+  uint32_t dayOfYear = dayOfEra - ((365U * yearOfEra) + (yearOfEra / 4U)
+                                   - (yearOfEra / 100U));
+  uint32_t monthFromMarch = ((5U * dayOfYear) + 2U) / 153U;
+  uint32_t month = (monthFromMarch < 10U) ? (monthFromMarch + 3U)
+                   : (monthFromMarch - 9U);
+
+  date->year = (uint16_t)(yearOfEra + (era * 400U) + ((month <= 2U) ? 1U : 0U));
+  date->month = (uint8_t)month;
+  date->day = (uint8_t)(dayOfYear - (((153U * monthFromMarch) + 2U) / 5U) + 1U);
+  date->hour = (uint8_t)(time / 3600U);
+  time -= date->hour * 3600U;
+  date->minute = (uint8_t)(time / 60U);
+  date->second = (uint8_t)(time - (date->minute * 60U));
+  // 1970-01-01 was a Thursday
+  date->weekday = (uint8_t)((days + 4U) % 7U);
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Time of a date and time of day
+ *
+ * @param[in] date
+ *   Date and time of day, from 1970 to 9999; the weekday is ignored.
+ *
+ * @param[out] seconds
+ *   Seconds since 1970-01-01 00:00:00.
+ *
+ * @return
+ *   false if the date or the time of day is not valid.
+ ******************************************************************************/
+bool RTCCLOCK_FromDate(const RTCCLOCK_Date_t *date, uint64_t *seconds)
+{
+  static const uint8_t monthDays[12] = {
+    31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31
+  };
+  uint32_t year;
+  uint32_t era;
+  uint32_t yearOfEra;
+  uint32_t dayOfYear;
+  uint32_t days;
+  uint32_t lastDay;
+
+  if ((date->year < 1970U) || (date->year > MAX_YEAR)
+      || (date->month < 1U) || (date->month > 12U)
+      || (date->hour > 23U) || (date->minute > 59U) || (date->second > 59U)) {
+    return false;
+  }
+  lastDay = monthDays[date->month - 1U];
+  if ((date->month == 2U) && isLeap(date->year)) {
+    lastDay++;
+  }
+  if ((date->day < 1U) || (date->day > lastDay)) {
+    return false;
+  }
+
+  // Years start on March 1
+  year = date->year - ((date->month <= 2U) ? 1U : 0U);
+  era = year / 400U;
+  yearOfEra = year - (era * 400U);
+  dayOfYear = (((153U * ((date->month > 2U) ? (date->month - 3U)
+                         : (date->month + 9U))) + 2U) / 5U) + date->day - 1U;
+  days = (era * ERA_DAYS) + (yearOfEra * 365U) + (yearOfEra / 4U)
+         - (yearOfEra / 100U) + dayOfYear - EPOCH_DAYS;
+
+  *seconds = ((uint64_t)days * RTCCLOCK_DAY) + (date->hour * 3600U)
+             + (date->minute * 60U) + date->second;
+  return true;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Set an alarm
+ *
+ * @details
+ *    A repeating alarm set in the past fires at its next time from now.
+ *    The clock must be set, and the alarm be less than 68 years ahead.
+ *
+ * @param[in] alarm
+ *   Alarm, the compare channel, 0 to RTCCLOCK_ALARMS - 1.
+ *
+ * @param[in] seconds
+ *   Time of the alarm, seconds since 1970-01-01 00:00:00.
+ *
+ * @param[in] alarmPeriod
+ *   Seconds between the times it fires, such as RTCCLOCK_DAY, or 0 to fire
+ *   once.
+ *
+ * @return
+ *   false if the alarm cannot be set.
+ ******************************************************************************/
+bool RTCCLOCK_AlarmSet(uint32_t alarm, uint64_t seconds, uint32_t alarmPeriod)
+{
+  RTCC_CCChConf_TypeDef compare = RTCC_CH_INIT_COMPARE_DEFAULT;
+  uint64_t now;
+
+  if ((alarm >= RTCCLOCK_ALARMS) || !isSet) {
+    return false;
+  }
+
+  now = RTCCLOCK_Seconds();
+  if (seconds <= now) {
+    if (alarmPeriod == 0U) {
+      return false;
+    }
+    seconds += (((now - seconds) / alarmPeriod) + 1U) * alarmPeriod;
+  }
+  if ((seconds - now) > INT32_MAX) {
+    return false;
+  }
+
+  RTCCLOCK_AlarmCancel(alarm);
+  compare.compBase = rtccCompBaseCnt;
+  RTCC_ChannelInit(alarm, &compare);
+  RTCC_ChannelCCVSet(alarm, (uint32_t)(seconds - offset));
+  period[alarm] = alarmPeriod;
+  save();
+  RTCC_IntClear(RTCC_IF_CC0 << alarm);
+  RTCC_IntEnable(RTCC_IEN_CC0 << alarm);
+
+  return true;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Cancel an alarm
+ ******************************************************************************/
+void RTCCLOCK_AlarmCancel(uint32_t alarm)
+{
+  if (alarm >= RTCCLOCK_ALARMS) {
+    return;
+  }
+
+  RTCC_IntDisable(RTCC_IEN_CC0 << alarm);
+  RTCC_IntClear(RTCC_IF_CC0 << alarm);
+  period[alarm] = 0;
+  save();
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Next time of an alarm
+ *
+ * @return
+ *   false if the alarm is not set.
+ ******************************************************************************/
+bool RTCCLOCK_AlarmGet(uint32_t alarm, uint64_t *seconds)
+{
+  uint32_t count;
+
+  if ((alarm >= RTCCLOCK_ALARMS) || !(RTCC->IEN & (RTCC_IEN_CC0 << alarm))) {
+    return false;
+  }
+
+  // Relative to the counter, for an alarm the clock was set past
+  count = RTCC_CounterGet();
+  *seconds = offset + count
+             + (int64_t)(int32_t)(RTCC_ChannelCCVGet(alarm) - count);
+  return true;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Handle the alarms, called from the RTCC interrupt handler
+ *
+ * @details
+ *    A repeating alarm is set again for its next time before the callback
+ *    runs, one that fires once is cancelled.
+ ******************************************************************************/
+void RTCCLOCK_IRQHandler(void)
+{
+  uint32_t flags = RTCC_IntGetEnabled() & ALARM_FLAGS;
+  uint32_t i;
+
+  RTCC_IntClear(flags);
+
+  for (i = 0; i < RTCCLOCK_ALARMS; i++) {
+    if (!(flags & (RTCC_IF_CC0 << i))) {
+      continue;
+    }
+    if (period[i] != 0U) {
+      RTCC_ChannelCCVSet(i, nextMatch(RTCC_ChannelCCVGet(i), period[i]));
+    } else {
+      RTCC_IntDisable(RTCC_IEN_CC0 << i);
+    }
+    if (callback != NULL) {
+      callback(i, callbackData);
+    }
+  }
+}
+
+/** @} (end group RtcClock) */
+/** @} (end group kitdrv) */
@@ -0,0 +1,133 @@
+/***************************************************************************//**
+ * @file
+ * @brief Real-time clock on the RTCC: epoch time, calendar and alarms.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2022 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ******************************************************************************/
+
+#ifndef __RTCCLOCK_H
+#define __RTCCLOCK_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "em_device.h"
+
+/***************************************************************************//**
+ * @addtogroup kitdrv
+ * @{
+ ******************************************************************************/
+
+/***************************************************************************//**
+ * @addtogroup RtcClock
+ * @brief Real-time clock on the RTCC: epoch time, calendar and alarms
+ * @details
+ *    The RTCC runs in normal mode from a 32.768 kHz LFECLK, the pre-counter
+ *    counting ticks and the counter seconds. The time is the seconds since
+ *    1970-01-01 00:00:00, 64 bits, kept as an offset added to the counter,
+ *    so the RTCC never has to be written to set the clock. A timestamp,
+ *    RTCCLOCK_Now(), is three register reads and an add, in ticks of
+ *    1 / 32768 s.
+ *
+ *    The calendar mode of the RTCC is not used: its BCD fields are slow to
+ *    turn into a number, and it cannot count past 2099. RTCCLOCK_ToDate()
+ *    and RTCCLOCK_FromDate() convert between the seconds and a date with a
+ *    fixed handful of multiplies and divisions by constants, no loop over
+ *    the years or months.
+ *
+ *    Each of the three compare channels of the RTCC is an alarm at a time,
+ *    once or repeating with a period in seconds, such as a day. Alarms are
+ *    matches on the counter, so they keep running through EM4 hibernate
+ *    and can wake the device from it with RTCC_EM4WakeupEnable().
+ *
+ *    The offset and the alarm periods are kept in RTCCLOCK_RET_WORDS words
+ *    of the RTCC retention registers, with a check word. After an EM4
+ *    wake-up RTCCLOCK_Init() picks them up and the counter carries on, so
+ *    the time is kept; after any other reset the clock starts again unset.
+ *    An alarm that fired in EM4 is passed to the callback once the RTCC
+ *    interrupt is enabled again. The RTCC interrupt handler of the
+ *    application calls RTCCLOCK_IRQHandler().
+ *
+ *    The LFECLK, LFXO and EM4 latch handling stay with the application, as
+ *    they do for any other RTCC use.
+ * @{
+ ******************************************************************************/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Ticks of RTCCLOCK_Now() per second */
+#define RTCCLOCK_TICK_HZ        32768U
+
+/** Shift from seconds to ticks */
+#define RTCCLOCK_TICK_SHIFT     15U
+
+/** Alarms, one per compare channel */
+#define RTCCLOCK_ALARMS         3U
+
+/** Words of retention used */
+#define RTCCLOCK_RET_WORDS      (3U + RTCCLOCK_ALARMS)
+
+/** Seconds per day, the period of a daily alarm */
+#define RTCCLOCK_DAY            86400U
+
+/** Date and time of day */
+typedef struct {
+  uint16_t year;          /**< 1970 and on */
+  uint8_t  month;         /**< 1 to 12 */
+  uint8_t  day;           /**< 1 to 31 */
+  uint8_t  hour;          /**< 0 to 23 */
+  uint8_t  minute;        /**< 0 to 59 */
+  uint8_t  second;        /**< 0 to 59 */
+  uint8_t  weekday;       /**< 0 Sunday to 6 Saturday, ignored on input */
+} RTCCLOCK_Date_t;
+
+/** Called from RTCCLOCK_IRQHandler() with the alarm that fired */
+typedef void (*RTCCLOCK_Callback_t)(uint32_t alarm, void *data);
+
+bool     RTCCLOCK_Init(volatile uint32_t *ret,
+                       bool wake,
+                       RTCCLOCK_Callback_t callback,
+                       void *data);
+bool     RTCCLOCK_IsSet(void);
+void     RTCCLOCK_Set(uint64_t seconds);
+uint64_t RTCCLOCK_Now(void);
+uint64_t RTCCLOCK_Seconds(void);
+void     RTCCLOCK_ToDate(uint64_t seconds, RTCCLOCK_Date_t *date);
+bool     RTCCLOCK_FromDate(const RTCCLOCK_Date_t *date, uint64_t *seconds);
+bool     RTCCLOCK_AlarmSet(uint32_t alarm, uint64_t seconds, uint32_t period);
+void     RTCCLOCK_AlarmCancel(uint32_t alarm);
+bool     RTCCLOCK_AlarmGet(uint32_t alarm, uint64_t *seconds);
+void     RTCCLOCK_IRQHandler(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+/** @} (end group RtcClock) */
+/** @} (end group kitdrv) */
+
+#endif
@@ -0,0 +1,317 @@
+/***************************************************************************//**
+ * @file
+ * @brief Supply aware deferral and rate limiting of high current operations.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2022 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ******************************************************************************/
+
+#include "em_core.h"
+#include "em_emu.h"
+#include "supguard.h"
+
+/***************************************************************************//**
+ * @addtogroup kitdrv
+ * @{
+ ******************************************************************************/
+
+/***************************************************************************//**
+ * @addtogroup SupGuard
+ * @{
+ ******************************************************************************/
+
+typedef struct {
+  SUPGUARD_Work_t work;
+  void            *arg;
+  bool            waited;
+} Item_t;
+
+static SUPGUARD_Init_TypeDef      config;
+static uint32_t                   vmonFlags;
+
+// Set by the interrupt handler, the times by the calls that pass now
+static volatile bool              low;
+static volatile bool              risen;
+static uint32_t                   goodSince;
+static uint32_t                   lastRun;
+static bool                       haveRun;
+
+// Head is written by SUPGUARD_Submit() only, tail by SUPGUARD_Run() only.
+// Both run freely and wrap at 2^32.
+static Item_t                     queue[SUPGUARD_QUEUE_SIZE];
+static volatile uint32_t          head;
+static volatile uint32_t          tail;
+
+static volatile SUPGUARD_Counters_TypeDef counters;
+
+/**************************************************************************//**
+ * @brief Rise and fall interrupt flags of a VMON channel
+ *****************************************************************************/
+static uint32_t channelFlags(EMU_VmonChannel_TypeDef channel)
+{
+  switch (channel) {
+    case emuVmonChannel_AVDD:
+      return EMU_IF_VMONAVDDFALL | EMU_IF_VMONAVDDRISE;
+    case emuVmonChannel_ALTAVDD:
+      return EMU_IF_VMONALTAVDDFALL | EMU_IF_VMONALTAVDDRISE;
+    case emuVmonChannel_DVDD:
+      return EMU_IF_VMONDVDDFALL | EMU_IF_VMONDVDDRISE;
+    case emuVmonChannel_IOVDD0:
+      return EMU_IF_VMONIO0FALL | EMU_IF_VMONIO0RISE;
+    default:
+      return 0;
+  }
+}
+
+/**************************************************************************//**
+ * @brief Whether an operation may start now
+ *
+ * @details
+ *    Starts the recovery time when the supply has risen since the last
+ *    call. The VMON status is read again, so a fall whose interrupt is
+ *    still pending also holds the operation back.
+ *****************************************************************************/
+static bool ready(uint32_t now)
+{
+  bool isLow;
+  CORE_DECLARE_IRQ_STATE;
+
+  CORE_ENTER_ATOMIC();
+  if (risen) {
+    risen = false;
+    goodSince = now;
+  }
+  isLow = low;
+  CORE_EXIT_ATOMIC();
+
+  if (isLow || !EMU_VmonChannelStatusGet(config.channel)) {
+    return false;
+  }
+  if ((now - goodSince) < config.recoveryTicks) {
+    return false;
+  }
+  if (haveRun && ((now - lastRun) < config.spacingTicks)) {
+    return false;
+  }
+  return true;
+}
+
+/**************************************************************************//**
+ * @brief VMON interrupt, follows the supply between low and good
+ *
+ * @details
+ *    Call from EMU_IRQHandler(). Clears only the flags of the channel
+ *    watched.
+ *****************************************************************************/
+void SUPGUARD_IRQHandler(void)
+{
+  uint32_t flags = EMU_IntGet() & vmonFlags;
+
+  EMU_IntClear(flags);
+
+  if (EMU_VmonChannelStatusGet(config.channel)) {
+    if (low) {
+      low = false;
+      risen = true;
+    }
+  } else if (!low) {
+    low = true;
+    counters.droops++;
+  }
+}
+
+/**************************************************************************//**
+ * @brief Start watching the supply
+ *
+ * @details
+ *    Sets up the VMON channel, with hysteresis if the thresholds differ,
+ *    and enables its rise and fall interrupts. The supply counts as having
+ *    just risen, so the first operation waits for the recovery time.
+ *
+ * @return
+ *    false if the thresholds are out of order, or differ on a channel
+ *    without hysteresis.
+ *****************************************************************************/
+bool SUPGUARD_Init(const SUPGUARD_Init_TypeDef *init)
+{
+  if ((init->riseThreshold < init->fallThreshold)
+      || ((init->riseThreshold != init->fallThreshold)
+          && (init->channel != emuVmonChannel_AVDD))
+      || (channelFlags(init->channel) == 0)) {
+    return false;
+  }
+
+  config = *init;
+  vmonFlags = channelFlags(config.channel);
+
+  if (config.riseThreshold != config.fallThreshold) {
+    EMU_VmonHystInit_TypeDef hystInit = EMU_VMONHYSTINIT_DEFAULT;
+    hystInit.channel = config.channel;
+    hystInit.riseThreshold = config.riseThreshold;
+    hystInit.fallThreshold = config.fallThreshold;
+    EMU_VmonHystInit(&hystInit);
+  } else {
+    EMU_VmonInit_TypeDef vmonInit = EMU_VMONINIT_DEFAULT;
+    vmonInit.channel = config.channel;
+    vmonInit.threshold = config.riseThreshold;
+    EMU_VmonInit(&vmonInit);
+  }
+
+  low = !EMU_VmonChannelStatusGet(config.channel);
+  risen = !low;
+  haveRun = false;
+  head = 0;
+  tail = 0;
+  counters.droops = 0;
+  counters.refused = 0;
+  counters.deferred = 0;
+  counters.run = 0;
+  counters.dropped = 0;
+
+  EMU_IntClear(vmonFlags);
+  EMU_IntEnable(vmonFlags);
+  NVIC_ClearPendingIRQ(EMU_IRQn);
+  NVIC_EnableIRQ(EMU_IRQn);
+
+  return true;
+}
+
+/**************************************************************************//**
+ * @brief Whether the supply is below the fall threshold
+ *****************************************************************************/
+bool SUPGUARD_IsLow(void)
+{
+  return low;
+}
+
+/**************************************************************************//**
+ * @brief Ask to start a high current operation right away
+ *
+ * @details
+ *    Call right before the operation. Returns true, and counts the
+ *    operation for the spacing, if the supply is good and has recovered
+ *    and the last operation is at least the spacing ago.
+ *
+ * @param[in] now
+ *    Current time in the application's ticks.
+ *****************************************************************************/
+bool SUPGUARD_Allow(uint32_t now)
+{
+  if (!ready(now)) {
+    counters.refused++;
+    return false;
+  }
+
+  lastRun = now;
+  haveRun = true;
+  counters.run++;
+  return true;
+}
+
+/**************************************************************************//**
+ * @brief Queue a high current operation for SUPGUARD_Run()
+ *
+ * @details
+ *    Operations run in the order queued. Call from the main loop only.
+ *
+ * @return
+ *    false if the queue is full, the operation is not queued.
+ *****************************************************************************/
+bool SUPGUARD_Submit(SUPGUARD_Work_t work, void *arg)
+{
+  uint32_t h = head;
+
+  if ((h - tail) == SUPGUARD_QUEUE_SIZE) {
+    counters.dropped++;
+    return false;
+  }
+
+  queue[h % SUPGUARD_QUEUE_SIZE].work = work;
+  queue[h % SUPGUARD_QUEUE_SIZE].arg = arg;
+  queue[h % SUPGUARD_QUEUE_SIZE].waited = false;
+  head = h + 1;
+  return true;
+}
+
+/**************************************************************************//**
+ * @brief Run the oldest queued operation if it may start now
+ *
+ * @details
+ *    Runs at most one operation per call, the spacing keeps the next one
+ *    back anyway. Call from the main loop whenever operations are queued,
+ *    and wake up at least every few spacings while they are.
+ *
+ * @param[in] now
+ *    Current time in the application's ticks.
+ *
+ * @return
+ *    Operations still queued.
+ *****************************************************************************/
+uint32_t SUPGUARD_Run(uint32_t now)
+{
+  uint32_t t = tail;
+  Item_t *item;
+
+  if (head == t) {
+    return 0;
+  }
+
+  item = &queue[t % SUPGUARD_QUEUE_SIZE];
+
+  if (!ready(now)) {
+    if (!item->waited) {
+      item->waited = true;
+      counters.deferred++;
+    }
+    return head - t;
+  }
+
+  lastRun = now;
+  haveRun = true;
+  counters.run++;
+
+  // Free the entry before running, the operation may queue another
+  SUPGUARD_Work_t work = item->work;
+  void *arg = item->arg;
+  tail = t + 1;
+  work(arg);
+
+  return head - tail;
+}
+
+/**************************************************************************//**
+ * @brief Copy the counters
+ *****************************************************************************/
+void SUPGUARD_GetCounters(SUPGUARD_Counters_TypeDef *copy)
+{
+  copy->droops = counters.droops;
+  copy->refused = counters.refused;
+  copy->deferred = counters.deferred;
+  copy->run = counters.run;
+  copy->dropped = counters.dropped;
+}
+
+/** @} (end group SupGuard) */
+/** @} (end group kitdrv) */
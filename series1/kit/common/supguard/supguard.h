@@ -0,0 +1,118 @@
+/***************************************************************************//**
+ * @file
+ * @brief Supply aware deferral and rate limiting of high current operations.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2022 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ******************************************************************************/
+
+#ifndef __SUPGUARD_H
+#define __SUPGUARD_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "em_device.h"
+#include "em_emu.h"
+
+/***************************************************************************//**
+ * @addtogroup kitdrv
+ * @{
+ ******************************************************************************/
+
+/***************************************************************************//**
+ * @addtogroup SupGuard
+ * @brief Holds back high current operations while the supply droops
+ * @details
+ *    A coin cell sags under a burst of current, such as a flash erase, a
+ *    long DMA burst, a clock boost or a radio transmission, and a burst
+ *    started while it is already low can pull it below the brown-out
+ *    level and reset the device. SupGuard watches the supply with a VMON
+ *    channel and lets such operations run only while the supply is good.
+ *
+ *    The supply is low once it falls below the soft fall threshold, and
+ *    good again once it has risen above the rise threshold and stayed
+ *    there for the recovery time. Two operations are always at least the
+ *    spacing apart, so that the cell recovers between bursts even while
+ *    the supply is good.
+ *
+ *    An operation either asks SUPGUARD_Allow() right before it starts, and
+ *    skips or retries if refused, or is queued with SUPGUARD_Submit() and
+ *    run later by SUPGUARD_Run(), which the main loop calls. Times are in
+ *    ticks of a clock of the application's choice, passed in with each
+ *    call, such as the RTCC count; the recovery time and spacing use the
+ *    same ticks.
+ *
+ *    The application calls SUPGUARD_IRQHandler() from its EMU_IRQHandler().
+ *    Supply thresholds are in millivolts; different rise and fall
+ *    thresholds need the AVDD channel, the only one with hysteresis.
+ * @{
+ ******************************************************************************/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Operations the queue holds */
+#ifndef SUPGUARD_QUEUE_SIZE
+#define SUPGUARD_QUEUE_SIZE   8
+#endif
+
+/** Configuration */
+typedef struct {
+  EMU_VmonChannel_TypeDef channel;        /**< Supply watched */
+  int                     fallThreshold;  /**< Low below, mV */
+  int                     riseThreshold;  /**< Good again above, mV */
+  uint32_t                recoveryTicks;  /**< Good this long before running */
+  uint32_t                spacingTicks;   /**< Least time between operations */
+} SUPGUARD_Init_TypeDef;
+
+/** A queued operation */
+typedef void (*SUPGUARD_Work_t)(void *arg);
+
+/** Counts since SUPGUARD_Init(), they only ever count up */
+typedef struct {
+  uint32_t droops;      /**< Falls below the fall threshold */
+  uint32_t refused;     /**< SUPGUARD_Allow() calls that returned false */
+  uint32_t deferred;    /**< Queued operations that had to wait */
+  uint32_t run;         /**< Operations allowed or run from the queue */
+  uint32_t dropped;     /**< SUPGUARD_Submit() calls with the queue full */
+} SUPGUARD_Counters_TypeDef;
+
+bool      SUPGUARD_Init(const SUPGUARD_Init_TypeDef *init);
+void      SUPGUARD_IRQHandler(void);
+bool      SUPGUARD_IsLow(void);
+bool      SUPGUARD_Allow(uint32_t now);
+bool      SUPGUARD_Submit(SUPGUARD_Work_t work, void *arg);
+uint32_t  SUPGUARD_Run(uint32_t now);
+void      SUPGUARD_GetCounters(SUPGUARD_Counters_TypeDef *counters);
+
+#ifdef __cplusplus
+}
+#endif
+
+/** @} (end group SupGuard) */
+/** @} (end group kitdrv) */
+
+#endif
@@ -0,0 +1,302 @@
+/***************************************************************************//**
+ * @file
+ * @brief Watchdog supervisor: the WDOG fed only while every task checks in.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2022 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ******************************************************************************/
+
+#include "em_cmu.h"
+#include "em_core.h"
+#include "em_letimer.h"
+#include "em_wdog.h"
+#include "wdogsup.h"
+
+/***************************************************************************//**
+ * @addtogroup kitdrv
+ * @{
+ ******************************************************************************/
+
+/***************************************************************************//**
+ * @addtogroup WdogSup
+ * @{
+ ******************************************************************************/
+
+// Upper half of the retained word, tells a stored mask from garbage
+#define RETAIN_MAGIC      0xA5A50000UL
+#define RETAIN_MAGIC_MASK 0xFFFF0000UL
+
+#define RETAIN_REG        (RTCC->RET[WDOGSUP_RETAIN_WORD].REG)
+
+typedef struct {
+  uint32_t minTicks;
+  uint32_t maxTicks;
+  volatile uint32_t last;   // Tick of the last check-in
+} Task_t;
+
+static Task_t             tasks[WDOGSUP_MAX_TASKS];
+static volatile uint32_t  taskCount;
+static uint32_t           tickMs;
+
+// Written in the LETIMER interrupt only, early also by the check-ins
+static volatile uint32_t  now;
+static volatile uint32_t  failed;
+static volatile uint32_t  early;
+
+static bool               retain;
+static bool               haveLast;
+static uint32_t           lastFailed;
+
+static volatile WDOGSUP_Counters_TypeDef counters;
+
+/**************************************************************************//**
+ * @brief Number of tasks in a mask
+ *****************************************************************************/
+static uint32_t countTasks(uint32_t mask)
+{
+  uint32_t n = 0;
+
+  for (; mask != 0; mask &= mask - 1) {
+    n++;
+  }
+  return n;
+}
+
+/**************************************************************************//**
+ * @brief LETIMER interrupt, checks the tasks and feeds the WDOG
+ *
+ * @details
+ *    Once a task has failed the WDOG is not fed again, even if the task
+ *    recovers: its work may already have been lost.
+ *****************************************************************************/
+void LETIMER0_IRQHandler(void)
+{
+  uint32_t t, i, late = 0, e;
+  CORE_DECLARE_IRQ_STATE;
+
+  LETIMER_IntClear(LETIMER0, LETIMER_IFC_UF);
+
+  t = now + 1;
+  now = t;
+  counters.ticks++;
+
+  for (i = 0; i < taskCount; i++) {
+    if ((t - tasks[i].last) > tasks[i].maxTicks) {
+      late |= 1UL << i;
+    }
+  }
+
+  CORE_ENTER_ATOMIC();
+  e = early;
+  early = 0;
+  CORE_EXIT_ATOMIC();
+
+  counters.lateTasks += countTasks(late & ~failed);
+  failed |= late | e;
+
+  if (failed == 0) {
+    WDOGn_Feed(WDOG0);
+    counters.feeds++;
+  }
+}
+
+/**************************************************************************//**
+ * @brief WDOG warning interrupt, keeps the failed tasks through the reset
+ *****************************************************************************/
+void WDOG0_IRQHandler(void)
+{
+  uint32_t flags = WDOGn_IntGet(WDOG0);
+
+  WDOGn_IntClear(WDOG0, flags);
+
+  if (retain && (flags & WDOG_IF_WARN)) {
+    RETAIN_REG = RETAIN_MAGIC | failed;
+  }
+}
+
+/**************************************************************************//**
+ * @brief Start the WDOG and the checks
+ *
+ * @details
+ *    Reads and clears the failed tasks kept from before the last reset,
+ *    then starts the WDOG with its warning at 75% of the timeout and the
+ *    LETIMER ticks. Register the tasks after this. The tick must be well
+ *    below the WDOG timeout, a quarter of it at most.
+ *****************************************************************************/
+void WDOGSUP_Init(const WDOGSUP_Init_TypeDef *init)
+{
+  WDOG_Init_TypeDef wdogInit = WDOG_INIT_DEFAULT;
+  LETIMER_Init_TypeDef letimerInit = LETIMER_INIT_DEFAULT;
+  uint32_t reg;
+
+  // The retention registers can only be read with the RTCC clocked
+  retain = (CMU->LFECLKEN0 & CMU_LFECLKEN0_RTCC) != 0;
+  reg = retain ? RETAIN_REG : 0;
+  haveLast = (reg & RETAIN_MAGIC_MASK) == RETAIN_MAGIC;
+  lastFailed = haveLast ? (reg & ~RETAIN_MAGIC_MASK) : 0;
+  if (retain) {
+    RETAIN_REG = 0;
+  }
+
+  tickMs = init->tickMs;
+  taskCount = 0;
+  now = 0;
+  failed = 0;
+  early = 0;
+  counters.ticks = 0;
+  counters.feeds = 0;
+  counters.lateTasks = 0;
+  counters.earlyTasks = 0;
+
+  // Runs in EM2 and EM3, the warning at 75% stores the failed tasks
+  CMU_ClockEnable(cmuClock_HFLE, true);
+  wdogInit.clkSel = wdogClkSelULFRCO;
+  wdogInit.debugRun = init->debugRun;
+  wdogInit.em2Run = true;
+  wdogInit.em3Run = true;
+  wdogInit.perSel = init->period;
+  wdogInit.warnSel = wdogWarnTime75pct;
+  WDOGn_Init(WDOG0, &wdogInit);
+
+  WDOGn_IntClear(WDOG0, WDOG_IFC_WARN);
+  WDOGn_IntEnable(WDOG0, WDOG_IEN_WARN);
+  NVIC_ClearPendingIRQ(WDOG0_IRQn);
+  NVIC_EnableIRQ(WDOG0_IRQn);
+
+  // One underflow per tick
+  if (WDOGSUP_CLOCK == cmuSelect_LFRCO) {
+    CMU_OscillatorEnable(cmuOsc_LFRCO, true, true);
+  }
+  CMU_ClockSelectSet(cmuClock_LFA, WDOGSUP_CLOCK);
+  CMU_ClockEnable(cmuClock_LETIMER0, true);
+  letimerInit.enable = false;
+  letimerInit.comp0Top = true;
+  LETIMER_Init(LETIMER0, &letimerInit);
+  LETIMER_CompareSet(LETIMER0, 0,
+                     (uint32_t)(((uint64_t)CMU_ClockFreqGet(cmuClock_LETIMER0)
+                                 * tickMs) / 1000) - 1);
+
+  LETIMER_IntClear(LETIMER0, LETIMER_IFC_UF);
+  LETIMER_IntEnable(LETIMER0, LETIMER_IEN_UF);
+  NVIC_ClearPendingIRQ(LETIMER0_IRQn);
+  NVIC_EnableIRQ(LETIMER0_IRQn);
+
+  LETIMER_Enable(LETIMER0, true);
+}
+
+/**************************************************************************//**
+ * @brief Add a task to the checks
+ *
+ * @details
+ *    The task counts as checked in at the time it is registered. Call from
+ *    the main loop only.
+ *
+ * @param[in] minMs
+ *    Least time between two check-ins, 0 for no least time.
+ *
+ * @param[in] maxMs
+ *    Most time between two check-ins, a few ticks at least.
+ *
+ * @return
+ *    Task number for WDOGSUP_CheckIn(), -1 if the window is empty or
+ *    WDOGSUP_MAX_TASKS are already registered.
+ *****************************************************************************/
+int WDOGSUP_Register(uint32_t minMs, uint32_t maxMs)
+{
+  uint32_t n = taskCount;
+
+  if ((n == WDOGSUP_MAX_TASKS) || (maxMs < tickMs) || (minMs >= maxMs)) {
+    return -1;
+  }
+
+  // Rounded towards the wider window, failures are never false alarms
+  tasks[n].minTicks = minMs / tickMs;
+  tasks[n].maxTicks = (maxMs + tickMs - 1) / tickMs;
+  tasks[n].last = now;
+  taskCount = n + 1;
+
+  return (int)n;
+}
+
+/**************************************************************************//**
+ * @brief Report that a task has completed a unit of work
+ *
+ * @details
+ *    Can be called from interrupt handlers.
+ *****************************************************************************/
+void WDOGSUP_CheckIn(int task)
+{
+  uint32_t t = now;
+  CORE_DECLARE_IRQ_STATE;
+
+  if ((task < 0) || ((uint32_t)task >= taskCount)) {
+    return;
+  }
+
+  if ((t - tasks[task].last) < tasks[task].minTicks) {
+    CORE_ENTER_ATOMIC();
+    early |= 1UL << task;
+    counters.earlyTasks++;
+    CORE_EXIT_ATOMIC();
+  }
+  tasks[task].last = t;
+}
+
+/**************************************************************************//**
+ * @brief Mask of the tasks that have failed, bit n for task n
+ *****************************************************************************/
+uint32_t WDOGSUP_GetFailed(void)
+{
+  return failed;
+}
+
+/**************************************************************************//**
+ * @brief The tasks that had failed when the WDOG last reset the device
+ *
+ * @param[out] mask
+ *    Mask of the failed tasks, 0 if the ticks had stopped.
+ *
+ * @return
+ *    false if WdogSup did not see the last reset coming.
+ *****************************************************************************/
+bool WDOGSUP_GetLastFailed(uint32_t *mask)
+{
+  *mask = lastFailed;
+  return haveLast;
+}
+
+/**************************************************************************//**
+ * @brief Copy the counters
+ *****************************************************************************/
+void WDOGSUP_GetCounters(WDOGSUP_Counters_TypeDef *copy)
+{
+  copy->ticks = counters.ticks;
+  copy->feeds = counters.feeds;
+  copy->lateTasks = counters.lateTasks;
+  copy->earlyTasks = counters.earlyTasks;
+}
+
+/** @} (end group WdogSup) */
+/** @} (end group kitdrv) */
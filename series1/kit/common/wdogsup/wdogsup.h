@@ -0,0 +1,131 @@
+/***************************************************************************//**
+ * @file
+ * @brief Watchdog supervisor: the WDOG fed only while every task checks in.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2022 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ******************************************************************************/
+
+#ifndef __WDOGSUP_H
+#define __WDOGSUP_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "em_device.h"
+#include "em_wdog.h"
+
+/***************************************************************************//**
+ * @addtogroup kitdrv
+ * @{
+ ******************************************************************************/
+
+/***************************************************************************//**
+ * @addtogroup WdogSup
+ * @brief Feeds the watchdog only while every registered task is alive
+ * @details
+ *    Feeding the WDOG from one loop only proves that the loop runs, not
+ *    that the DMA pipelines, interrupt handlers and other work it depends
+ *    on still make progress. With WdogSup each such task registers a
+ *    window and calls WDOGSUP_CheckIn() each time it completes a unit of
+ *    work, from the main loop or an interrupt handler. A LETIMER interrupt
+ *    every tick feeds the WDOG if every task has checked in within its
+ *    window, and stops feeding for good once one has not, so the WDOG
+ *    resets the device.
+ *
+ *    A task fails when more than its maximum time passes without a
+ *    check-in, or when it checks in sooner than its minimum time after the
+ *    last one, which catches a task caught in a loop that keeps reporting
+ *    without doing the work. A minimum of 0 turns the early check off.
+ *    Times are checked to the tick, so a window must be a few ticks wide.
+ *
+ *    The WDOG warning interrupt, at 75% of the timeout, stores the mask of
+ *    the failed tasks in RTCC retention register WDOGSUP_RETAIN_WORD;
+ *    WDOGSUP_Init() reads it back for WDOGSUP_GetLastFailed() and clears
+ *    it. A mask of 0 there means that the ticks themselves stopped, with
+ *    interrupts masked or a handler of higher priority stuck. The register
+ *    is only used while the application keeps the RTCC clocked, and only
+ *    kept through the reset in the limited WDOG reset mode, set with
+ *    RMU_ResetControl(rmuResetWdog, rmuResetModeLimited).
+ *
+ *    The component owns the WDOG, LETIMER0 with the LFACLK it selects, and
+ *    their interrupt handlers. The LETIMER and the WDOG keep running in
+ *    EM2, the CPU wakes up once per tick only. The LETIMER counts 16 bits,
+ *    so a tick is at most 2 seconds with the LFRCO or LFXO.
+ * @{
+ ******************************************************************************/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Tasks that can be registered, at most 16 */
+#ifndef WDOGSUP_MAX_TASKS
+#define WDOGSUP_MAX_TASKS     8
+#endif
+
+/** LFACLK source, cmuSelect_LFRCO, cmuSelect_LFXO or cmuSelect_ULFRCO */
+#ifndef WDOGSUP_CLOCK
+#define WDOGSUP_CLOCK         cmuSelect_LFRCO
+#endif
+
+/** RTCC retention register the failed tasks are kept in through the reset */
+#ifndef WDOGSUP_RETAIN_WORD
+#define WDOGSUP_RETAIN_WORD   31
+#endif
+
+#if WDOGSUP_MAX_TASKS > 16
+#error "WDOGSUP_MAX_TASKS must be at most 16"
+#endif
+
+/** Configuration */
+typedef struct {
+  uint32_t              tickMs;     /**< Time between checks and feeds */
+  WDOG_PeriodSel_TypeDef period;    /**< WDOG timeout, ULFRCO cycles */
+  bool                  debugRun;   /**< Keep the WDOG running when halted */
+} WDOGSUP_Init_TypeDef;
+
+/** Counts since WDOGSUP_Init(), they only ever count up */
+typedef struct {
+  uint32_t ticks;       /**< Checks done */
+  uint32_t feeds;       /**< WDOG feeds */
+  uint32_t lateTasks;   /**< Tasks found past their maximum time */
+  uint32_t earlyTasks;  /**< Check-ins sooner than the minimum time */
+} WDOGSUP_Counters_TypeDef;
+
+void      WDOGSUP_Init(const WDOGSUP_Init_TypeDef *init);
+int       WDOGSUP_Register(uint32_t minMs, uint32_t maxMs);
+void      WDOGSUP_CheckIn(int task);
+uint32_t  WDOGSUP_GetFailed(void);
+bool      WDOGSUP_GetLastFailed(uint32_t *mask);
+void      WDOGSUP_GetCounters(WDOGSUP_Counters_TypeDef *counters);
+
+#ifdef __cplusplus
+}
+#endif
+
+/** @} (end group WdogSup) */
+/** @} (end group kitdrv) */
+
+#endif
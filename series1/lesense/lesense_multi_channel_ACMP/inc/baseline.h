@@ -0,0 +1,68 @@
+/***************************************************************************//**
+ * @file baseline.h
+ * @brief Batched LESENSE counter baseline tracking, fed by the LDMA.
+ *******************************************************************************
+ * @section License
+ * <b>(C) Copyright 2021 Silicon Labs, http://www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ******************************************************************************/
+
+#ifndef BASELINE_H
+#define BASELINE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// LDMA channel that empties the LESENSE result buffer
+#define BASE_LDMA_CHANNEL     0
+
+// Largest batch, count results of all channels over all scans in it
+#define BASE_MAX_BATCH        256
+
+typedef struct {
+  const uint8_t *channels;  // LESENSE channels, in ascending order
+  uint32_t channelCount;
+  uint32_t scansPerBatch;   // Scans collected before the filter runs
+  uint32_t touchPercent;    // Count drop from the baseline that is a touch
+  uint32_t filterShift;     // Baseline follows 1 / 2^filterShift per batch
+  uint32_t recoverBatches;  // Touched batches before the baseline is reset
+} BASE_Config_t;
+
+bool BASE_Init(const BASE_Config_t *config);
+void BASE_Stop(void);
+uint32_t BASE_GetBaseline(uint32_t index);
+uint32_t BASE_GetThreshold(uint32_t index);
+bool BASE_IsTouched(uint32_t index);
+uint32_t BASE_GetBatchCount(void);
+uint32_t BASE_GetOverrunCount(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // BASELINE_H
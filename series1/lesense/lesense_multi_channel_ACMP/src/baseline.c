@@ -0,0 +1,286 @@
+/***************************************************************************//**
+ * @file baseline.c
+ * @brief Batched LESENSE counter baseline tracking, fed by the LDMA.
+ *******************************************************************************
+ * @section License
+ * <b>(C) Copyright 2021 Silicon Labs, http://www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ******************************************************************************/
+
+#include <stddef.h>
+
+#include "em_device.h"
+#include "em_ldma.h"
+#include "em_lesense.h"
+
+#include "baseline.h"
+
+// Done interrupt flag of the LDMA channel
+#define BLOCK_DONE          ((1 << BASE_LDMA_CHANNEL) << _LDMA_IFC_DONE_SHIFT)
+
+// Baselines are kept with 8 fractional bits so slow drift is not lost
+#define FRACTION_BITS       8
+
+// Count results, a half of the ping-pong buffer per batch
+static uint32_t buffer[2][BASE_MAX_BATCH];
+static LDMA_Descriptor_t descriptors[2];
+
+static BASE_Config_t baseConfig;
+static uint32_t batchSize;
+
+// Per channel filter state, in the order of baseConfig.channels
+static uint32_t baseline[LESENSE_NUM_CHANNELS];
+static uint32_t threshold[LESENSE_NUM_CHANNELS];
+static uint32_t touchedBatches[LESENSE_NUM_CHANNELS];
+static bool calibrated;
+
+static volatile uint32_t batchCount;
+static volatile uint32_t overrunCount;
+static uint32_t lastHalf;
+
+/**************************************************************************//**
+ * @brief
+ *   Start the baseline of a channel over from a batch mean
+ *****************************************************************************/
+static void setBaseline(uint32_t index, uint32_t mean)
+{
+  baseline[index] = mean << FRACTION_BITS;
+  touchedBatches[index] = 0;
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Run the filter over one batch of count results
+ *
+ * @details
+ *   Each scan stores one count per channel in channel order. For every
+ *   channel, the batch mean moves the baseline by 1 / 2^filterShift of
+ *   the difference, unless the channel was touched in the batch: a touch
+ *   must not be learned as drift. A channel touched for longer than
+ *   recoverBatches in a row is taken to have stepped to a new level, a
+ *   sensor change or a stuck object, and starts over from the batch mean.
+ *   The first batch after BASE_Init() sets all the baselines.
+ *****************************************************************************/
+static void processBatch(const uint32_t *block)
+{
+  uint32_t count = baseConfig.channelCount;
+  uint32_t sum;
+  uint32_t mean;
+  uint32_t value;
+  uint32_t level;
+  bool touched;
+  uint32_t ch;
+  uint32_t scan;
+
+  for (ch = 0; ch < count; ch++) {
+    sum = 0;
+    touched = false;
+    for (scan = 0; scan < baseConfig.scansPerBatch; scan++) {
+      value = block[(scan * count) + ch] & _LESENSE_BUFDATA_BUFDATA_MASK;
+      sum += value;
+      if (value < threshold[ch]) {
+        touched = true;
+      }
+    }
+    mean = sum / baseConfig.scansPerBatch;
+
+    if (!calibrated) {
+      setBaseline(ch, mean);
+    } else if (touched) {
+      if (++touchedBatches[ch] > baseConfig.recoverBatches) {
+        setBaseline(ch, mean);
+      }
+    } else {
+      // Signed step, the shift of a negative difference rounds down
+      level = mean << FRACTION_BITS;
+      baseline[ch] += (uint32_t)(((int32_t)(level - baseline[ch]))
+                                 >> baseConfig.filterShift);
+      touchedBatches[ch] = 0;
+    }
+
+    level = baseline[ch] >> FRACTION_BITS;
+    threshold[ch] = level - ((level * baseConfig.touchPercent) / 100);
+
+    // The ACMP threshold is unused with acmp0Mode/acmp1Mode Mux
+    LESENSE_ChannelThresSet(baseConfig.channels[ch], 0, threshold[ch]);
+  }
+
+  calibrated = true;
+}
+
+/**************************************************************************//**
+ * @brief  LDMA Handler
+ *****************************************************************************/
+void LDMA_IRQHandler(void)
+{
+  uint32_t pending = LDMA_IntGetEnabled();
+  uint32_t half;
+
+  // Loop here to enable the debugger to see what has happened
+  if (pending & LDMA_IF_ERROR) {
+    __BKPT(0);
+  }
+
+  LDMA_IntClear(BLOCK_DONE);
+
+  /*
+   * The LDMA has already moved on to the next half, so the half it is
+   * writing now tells which one is complete. If it is the same as last
+   * time, a whole batch went by before this interrupt was served.
+   */
+  if (LDMA->CH[BASE_LDMA_CHANNEL].DST < (uint32_t)buffer[1]) {
+    half = 1;
+  } else {
+    half = 0;
+  }
+
+  if (half == lastHalf) {
+    overrunCount++;
+  }
+  lastHalf = half;
+
+  processBatch(buffer[half]);
+  batchCount++;
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Start collecting LESENSE count results and tracking the baselines
+ *
+ * @details
+ *   LESENSE is configured by the caller, with storeCntRes set on the
+ *   channels in the configuration and no others storing results, and
+ *   the scan not yet started. Each result the LESENSE stores in its
+ *   result buffer is an LDMA request, and with wakeupOnDMA set the LDMA
+ *   empties the buffer in EM2 without the CPU; the CPU only wakes once
+ *   per batch to run the filter and write the new count thresholds.
+ *   All thresholds are 0 until the first batch is in, so no channel
+ *   reports a touch before the baselines are known.
+ *
+ * @param[in] config
+ *   Channels and filter settings, copied.
+ *
+ * @return
+ *   false if the batch does not fit BASE_MAX_BATCH or a setting is out
+ *   of range.
+ *****************************************************************************/
+bool BASE_Init(const BASE_Config_t *config)
+{
+  LDMA_Init_t ldmaInit = LDMA_INIT_DEFAULT;
+  LDMA_TransferCfg_t transferCfg =
+    LDMA_TRANSFER_CFG_PERIPHERAL(ldmaPeripheralSignal_LESENSE_BUFDATAV);
+  uint32_t ch;
+
+  if ((config->channelCount == 0)
+      || (config->channelCount > LESENSE_NUM_CHANNELS)
+      || (config->scansPerBatch == 0)
+      || (config->channelCount * config->scansPerBatch > BASE_MAX_BATCH)
+      || (config->touchPercent > 100)
+      || (config->filterShift > 16)) {
+    return false;
+  }
+
+  baseConfig = *config;
+  batchSize = config->channelCount * config->scansPerBatch;
+
+  for (ch = 0; ch < baseConfig.channelCount; ch++) {
+    baseline[ch] = 0;
+    threshold[ch] = 0;
+    touchedBatches[ch] = 0;
+    LESENSE_ChannelThresSet(baseConfig.channels[ch], 0, 0);
+  }
+  calibrated = false;
+  batchCount = 0;
+  overrunCount = 0;
+  lastHalf = 1;
+
+  LDMA_Init(&ldmaInit);
+
+  descriptors[0] = (LDMA_Descriptor_t)
+    LDMA_DESCRIPTOR_LINKREL_P2M_BYTE(&LESENSE->BUFDATA, buffer[0], batchSize, 1);
+  descriptors[1] = (LDMA_Descriptor_t)
+    LDMA_DESCRIPTOR_LINKREL_P2M_BYTE(&LESENSE->BUFDATA, buffer[1], batchSize, -1);
+  descriptors[0].xfer.size = ldmaCtrlSizeWord;
+  descriptors[1].xfer.size = ldmaCtrlSizeWord;
+  descriptors[0].xfer.doneIfs = true;
+  descriptors[1].xfer.doneIfs = true;
+
+  LDMA_StartTransfer(BASE_LDMA_CHANNEL, &transferCfg, &descriptors[0]);
+
+  return true;
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Stop the LDMA, the thresholds stay as they are
+ *****************************************************************************/
+void BASE_Stop(void)
+{
+  LDMA_StopTransfer(BASE_LDMA_CHANNEL);
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Baseline count of a channel, index into the configured channels
+ *****************************************************************************/
+uint32_t BASE_GetBaseline(uint32_t index)
+{
+  return baseline[index] >> FRACTION_BITS;
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Count threshold of a channel, index into the configured channels
+ *****************************************************************************/
+uint32_t BASE_GetThreshold(uint32_t index)
+{
+  return threshold[index];
+}
+
+/**************************************************************************//**
+ * @brief
+ *   true if the channel was touched in the last batch
+ *****************************************************************************/
+bool BASE_IsTouched(uint32_t index)
+{
+  return touchedBatches[index] > 0;
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Number of batches filtered since BASE_Init()
+ *****************************************************************************/
+uint32_t BASE_GetBatchCount(void)
+{
+  return batchCount;
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Number of batches that were overwritten before they were filtered
+ *****************************************************************************/
+uint32_t BASE_GetOverrunCount(void)
+{
+  return overrunCount;
+}
@@ -42,6 +42,8 @@
 #include "em_core.h"
 #include "em_lesense.h"
 
+#include "baseline.h"
+
 #include "bspconfig.h"
 #include "bsp.h"
 
@@ -50,6 +52,16 @@
  /****************************************************************************/
 
   #define LESENSE_SCAN_FREQ 20  // LESENSE scan frequency set to 20Hz
+  #define COUNT_TIME        0x30  // Pulses counted for 48 LF clock cycles
+
+  // Baseline tracking, one batch per second
+  #define SCANS_PER_BATCH   LESENSE_SCAN_FREQ
+  #define TOUCH_PERCENT     10  // Count drop from the baseline for a touch
+  #define FILTER_SHIFT      3   // Baseline follows drift over 8 batches
+  #define RECOVER_BATCHES   30  // Re-baseline after 30 s touched
+
+// LESENSE channels scanned, in ascending order
+static const uint8_t channels[] = { 0, 1, 2, 3 };
 
 /***************************************************************************//*
  * @brief  Sets up the ACMP to count LC sensor pulses
@@ -114,6 +126,10 @@ void setupLESENSE(void)
   LESENSE_ChDesc_TypeDef initLesenseCh = LESENSE_CH_CONF_DEFAULT;
 
   initLesense.coreCtrl.storeScanRes = false;
+
+  // Let the LDMA empty the result buffer in EM2 once it is half full
+  initLesense.coreCtrl.bufTrigLevel = lesenseBufTrigHalf;
+  initLesense.coreCtrl.wakeupOnDMA = lesenseDMAWakeUpBufLevel;
   
   // Enable LESENSE control of the ACMP0positive input mux
   initLesense.perCtrl.acmp0Mode = lesenseACMPModeDisable;
@@ -127,8 +143,13 @@ void setupLESENSE(void)
   // Channel Configuration
   initLesenseCh.enaScanCh = true;  // Enable scan channel
   initLesenseCh.enaInt = true;
-  initLesenseCh.sampleDelay = 0x2;	// Two LF Clock cycle sample delay
-  initLesenseCh.sampleMode = lesenseSampleModeACMP;
+  initLesenseCh.storeCntRes = true;  // Count result to the result buffer
+  initLesenseCh.measDelay = 0;
+  initLesenseCh.sampleDelay = COUNT_TIME;  // End of the counting window
+  initLesenseCh.sampleMode = lesenseSampleModeCounter;
+
+  // A touch lowers the pulse count below the tracked threshold
+  initLesenseCh.compMode = lesenseCompModeLess;
   initLesenseCh.intMode = lesenseSetIntPosEdge;
 
   CMU_ClockSelectSet(cmuClock_LFA, cmuSelect_LFXO);
@@ -153,6 +174,17 @@ void setupLESENSE(void)
   // Enable interrupt in NVIC
   NVIC_EnableIRQ(LESENSE_IRQn);
 
+  // Track the count baselines and thresholds from batches of results
+  BASE_Config_t baseConfig = {
+    .channels = channels,
+    .channelCount = sizeof(channels),
+    .scansPerBatch = SCANS_PER_BATCH,
+    .touchPercent = TOUCH_PERCENT,
+    .filterShift = FILTER_SHIFT,
+    .recoverBatches = RECOVER_BATCHES,
+  };
+  BASE_Init(&baseConfig);
+
   // Start continuous scan
   LESENSE_ScanStart();
 }
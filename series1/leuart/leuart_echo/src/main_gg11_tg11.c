@@ -39,12 +39,21 @@
 #include "em_gpio.h"
 #include "em_leuart.h"
 #include "em_chip.h"
+#include "em_ldma.h"
 
 #define RX_BUFFER_SIZE 80             // Software receive buffer size
 
+// Set to 0 to receive every byte with an interrupt instead of framed messages
+#define FRAMED_RX      1
+
+#define NODE_ADDRESS   '@'            // Start frame, first byte of our messages
+#define END_OF_MESSAGE '\n'           // Signal frame, last byte of a message
+#define RX_DMA_CHANNEL 0              // LDMA channel moving received bytes
+
 static uint32_t rxDataReady = 0;      // Flag indicating receiver does not have data
 static volatile char rxBuffer[RX_BUFFER_SIZE]; // Software receive buffer
 static char txBuffer[RX_BUFFER_SIZE]; // Software transmit buffer
+static uint32_t rxMessages = 0;       // Messages received, one wake each
 
 /**************************************************************************//**
  * @brief
@@ -82,11 +91,62 @@ void initLeuart(void)
   LEUART0->ROUTEPEN  = LEUART_ROUTEPEN_RXPEN | LEUART_ROUTEPEN_TXPEN;
   LEUART0->ROUTELOC0 = LEUART_ROUTELOC0_RXLOC_LOC5 | LEUART_ROUTELOC0_TXLOC_LOC5;
 
+#if FRAMED_RX
+  // Drop everything until our start frame, which unblocks the receiver
+  LEUART0->STARTFRAME = NODE_ADDRESS;
+  LEUART0->SIGFRAME   = END_OF_MESSAGE;
+  LEUART0->CTRL      |= LEUART_CTRL_SFUBRX;
+  LEUART0->CMD        = LEUART_CMD_RXBLOCKEN;
+
+  // Auto wake up DMA when data is received
+  LEUART_RxDmaInEM2Enable(LEUART0, true);
+
+  // Enable LEUART0 end of message/TX interrupts
+  LEUART_IntEnable(LEUART0, LEUART_IEN_SIGF | LEUART_IEN_TXC);
+#else
   // Enable LEUART0 RX/TX interrupts
   LEUART_IntEnable(LEUART0, LEUART_IEN_RXDATAV | LEUART_IEN_TXC);
+#endif
   NVIC_EnableIRQ(LEUART0_IRQn);
 }
 
+#if FRAMED_RX
+/**************************************************************************//**
+ * @brief
+ *    Start the LDMA moving the next message into rxBuffer
+ *
+ * @details
+ *    There is no transfer done interrupt; the end of message interrupt of
+ *    the LEUART is the only wake for a message. A message longer than the
+ *    buffer is cut at RX_BUFFER_SIZE - 1 bytes.
+ *****************************************************************************/
+void startRxDma(void)
+{
+  // The LDMA loads the descriptor at the start, so it must outlive the call
+  static LDMA_Descriptor_t descriptor =
+    LDMA_DESCRIPTOR_SINGLE_P2M_BYTE(&LEUART0->RXDATA, // Peripheral source address
+                                    0,                // Set below
+                                    RX_BUFFER_SIZE - 1);
+  descriptor.xfer.dstAddr = (uint32_t) rxBuffer;
+  descriptor.xfer.doneIfs = 0; // Don't trigger interrupt when done
+
+  LDMA_TransferCfg_t transferConfig =
+    LDMA_TRANSFER_CFG_PERIPHERAL(ldmaPeripheralSignal_LEUART0_RXDATAV);
+  LDMA_StartTransfer(RX_DMA_CHANNEL, &transferConfig, &descriptor);
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Initialize the LDMA module
+ *****************************************************************************/
+void initDma(void)
+{
+  LDMA_Init_t init = LDMA_INIT_DEFAULT;
+  LDMA_Init(&init);
+  startRxDma();
+}
+#endif
+
 /**************************************************************************//**
  * @brief
  *    LEUART0 interrupt service routine
@@ -100,13 +160,29 @@ void LEUART0_IRQHandler(void)
 {
   // Note: These are static because the handler will exit/enter
   //       multiple times to fully transmit a message.
+#if !FRAMED_RX
   static uint32_t rxIndex = 0;
+#endif
   static uint32_t txIndex = 0;
 
   // Acknowledge the interrupt
   uint32_t flags = LEUART_IntGet(LEUART0);
   LEUART_IntClear(LEUART0, flags);
 
+#if FRAMED_RX
+  // End of message: the LDMA has moved all of it once the RX buffer is empty
+  if (flags & LEUART_IF_SIGF) {
+    LEUART0->CMD = LEUART_CMD_RXBLOCKEN; // Wait for the next start frame
+    while ((LEUART0->STATUS & LEUART_STATUS_RXDATAV)
+           && (LDMA_TransferRemainingCount(RX_DMA_CHANNEL) != 0)) ;
+    uint32_t rxLength = RX_BUFFER_SIZE - 1
+                        - LDMA_TransferRemainingCount(RX_DMA_CHANNEL);
+    LDMA_StopTransfer(RX_DMA_CHANNEL);
+    rxBuffer[rxLength] = '\0';
+    rxDataReady = 1;
+    rxMessages++;
+  }
+#else
   // RX portion of the interrupt handler
   if (flags & LEUART_IF_RXDATAV) {
     while (LEUART0->STATUS & LEUART_STATUS_RXDATAV) { // While there is still incoming data
@@ -122,6 +198,7 @@ void LEUART0_IRQHandler(void)
       }
     }
   }
+#endif
 
   // TX portion of the interrupt handler
   if (flags & LEUART_IF_TXC) {
@@ -159,6 +236,9 @@ int main(void)
   // Initialization
   initGpio();
   initLeuart();
+#if FRAMED_RX
+  initDma();
+#endif
 
   // Print the welcome message
   char welcomeString[] = "LEUART echo code example\r\n";
@@ -172,6 +252,15 @@ int main(void)
 
     // When notified by the RX handler, start processing the received data
     if (rxDataReady) {
+#if FRAMED_RX
+      // Echo the message without our address
+      for (i = 0; rxBuffer[i + 1] != 0; i++) {
+        txBuffer[i] = rxBuffer[i + 1]; // Copy rxBuffer into txBuffer
+      }
+      txBuffer[i] = '\0';
+      rxDataReady = 0; // Indicate that we need new data
+      startRxDma();
+#else
       LEUART_IntDisable(LEUART0, LEUART_IEN_RXDATAV | LEUART_IEN_TXC); // Disable interrupts
       for (i = 0; rxBuffer[i] != 0; i++) {
         txBuffer[i] = rxBuffer[i]; // Copy rxBuffer into txBuffer
@@ -179,6 +268,7 @@ int main(void)
       txBuffer[i] = '\0';
       rxDataReady = 0; // Indicate that we need new data
       LEUART_IntEnable(LEUART0, LEUART_IEN_RXDATAV | LEUART_IEN_TXC); // Re-enable interrupts
+#endif
       LEUART_IntSet(LEUART0, LEUART_IFS_TXC);
     }
 
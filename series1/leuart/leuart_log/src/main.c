@@ -0,0 +1,182 @@
+/***************************************************************************//**
+ * @file main.c
+ * @brief Always-on log output on the LEUART, sent by the LDMA from a RAM ring
+ * while the core sleeps in EM2. See the readme.txt for details.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2021 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ *******************************************************************************
+ * # Evaluation Quality
+ * This code has been minimally tested to ensure that it builds and is suitable 
+ * as a demonstration for evaluation purposes only. This code will be maintained
+ * at the sole discretion of Silicon Labs.
+ ******************************************************************************/
+
+#include <stdio.h>
+#include "em_device.h"
+#include "em_cmu.h"
+#include "em_emu.h"
+#include "em_gpio.h"
+#include "em_leuart.h"
+#include "em_chip.h"
+#include "em_ldma.h"
+#include "lelog.h"
+#include "lpdelay.h"
+
+// LDMA channel sending the log
+#define LOG_LDMA_CHANNEL    0
+
+// Log ring, and the pending bytes a waiting write goes on at
+#define LOG_RING_SIZE       512
+#define LOG_LOW_WATERMARK   128
+
+// A status line each second, and a burst of lines every BURST_PERIOD
+// seconds, larger than the ring, to show the writer waiting for it
+#define BURST_PERIOD        10
+#define BURST_LINES         40
+
+static uint8_t logRing[LOG_RING_SIZE];
+
+// Lines appended, and the counters of the log
+volatile uint32_t linesWritten;
+volatile uint32_t bytesDropped;
+volatile uint32_t writerWaits;
+volatile uint32_t logWakeups;
+
+/**************************************************************************//**
+ * @brief
+ *    LDMA interrupt handler, shared with the other LDMA users
+ *****************************************************************************/
+void LDMA_IRQHandler(void)
+{
+  LELOG_IRQHandler();
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Initialize the GPIO pin of the LEUART transmitter
+ *****************************************************************************/
+void initGpio(void)
+{
+  CMU_ClockEnable(cmuClock_GPIO, true);
+  GPIO_PinModeSet(gpioPortD, 10, gpioModePushPull, 1); // TX
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Initialize the LEUART module, transmit only, as the leuart_dma example
+ *****************************************************************************/
+void initLeuart(void)
+{
+  LEUART_Init_TypeDef init = LEUART_INIT_DEFAULT;
+
+  // Enable LE (low energy) clocks
+  CMU_ClockEnable(cmuClock_HFLE, true);
+  CMU_ClockSelectSet(cmuClock_LFB, cmuSelect_LFXO);
+
+  CMU_ClockEnable(cmuClock_LEUART0, true);
+  CMU_ClockDivSet(cmuClock_LEUART0, cmuClkDiv_1);
+
+  init.enable = leuartEnableTx;
+  LEUART_Init(LEUART0, &init);
+
+  // Enable LEUART0 TX on PD10 (see readme.txt for details)
+  LEUART0->ROUTELOC0 = LEUART_ROUTELOC0_TXLOC_LOC18;
+  LEUART0->ROUTEPEN  = LEUART_ROUTEPEN_TXPEN;
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Append a formatted line to the log
+ *****************************************************************************/
+static void logLine(bool wait, const char *format, uint32_t a, uint32_t b)
+{
+  char line[48];
+  int n = snprintf(line, sizeof(line), format, a, b);
+
+  if (n > (int)sizeof(line) - 1) {
+    n = sizeof(line) - 1;
+  }
+  LELOG_Write(line, n, wait);
+  linesWritten++;
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Main function
+ *
+ * @details
+ *    The core wakes up once a second from the RTCC to append a line, and
+ *    for the LDMA interrupt at the end of each transfer of the ring.
+ *****************************************************************************/
+int main(void)
+{
+  LDMA_Init_t ldmaInit = LDMA_INIT_DEFAULT;
+  const LELOG_Init_t logInit = {
+    .leuart = LEUART0,
+    .channel = LOG_LDMA_CHANNEL,
+    .signal = ldmaPeripheralSignal_LEUART0_TXBL,
+    .buffer = logRing,
+    .size = sizeof(logRing),
+    .lowWatermark = LOG_LOW_WATERMARK,
+  };
+  uint32_t seconds = 0;
+  uint32_t i;
+
+  // Chip errata
+  CHIP_Init();
+
+  // Init DCDC regulator with kit specific parameters
+  EMU_DCDCInit_TypeDef dcdcInit = EMU_DCDCINIT_DEFAULT;
+  EMU_DCDCInit(&dcdcInit);
+
+  initGpio();
+  initLeuart();
+  LPDELAY_Init(true);
+
+  CMU_ClockEnable(cmuClock_LDMA, true);
+  LDMA_Init(&ldmaInit);
+  LELOG_Init(&logInit);
+
+  logLine(true, "lelog started, ring %lu bytes, low watermark %lu\r\n",
+          LOG_RING_SIZE, LOG_LOW_WATERMARK);
+
+  while (1) {
+    LPDELAY_Ms(1000);
+    seconds++;
+
+    logLine(false, "t=%lu s, wakeups=%lu\r\n", seconds, LELOG_Wakeups());
+
+    if ((seconds % BURST_PERIOD) == 0) {
+      for (i = 0; i < BURST_LINES; i++) {
+        logLine(true, "burst line %02lu of %lu\r\n", i + 1, BURST_LINES);
+      }
+    }
+
+    bytesDropped = LELOG_Dropped();
+    writerWaits = LELOG_Waits();
+    logWakeups = LELOG_Wakeups();
+  }
+}
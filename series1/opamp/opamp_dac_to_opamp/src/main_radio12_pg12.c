@@ -6,6 +6,12 @@
  * R2 = R1. This results in Vout = Vin * 2. This project also configures the
  * VDAC to output on Channel 0. The user should use a wire to connect the
  * output of the VDAC to the positive input node of the opamp.
+ *
+ * The VDAC streams a 64 point waveform from RAM: TIMER0 paces the LDMA,
+ * which writes one point per overflow to the VDAC channel and loops over
+ * the waveform on its own, so the opamp drives a 1 kHz waveform without
+ * the CPU. Push button PB0 switches between a sine, a triangle, a sawtooth
+ * and a square wave.
  *******************************************************************************
  * # License
  * <b>Copyright 2020 Silicon Laboratories Inc. www.silabs.com</b>
@@ -43,7 +49,11 @@
 #include "em_cmu.h"
 #include "em_emu.h"
 #include "em_opamp.h"
-#include "em_adc.h"
+#include "em_vdac.h"
+#include "em_gpio.h"
+#include "em_timer.h"
+#include "em_ldma.h"
+#include "bsp.h"
 
 // Note: change this to one of the OPAMP_ResSel_TypeDef type defines to select
 //       the R2/R1 resistor ladder ratio. By default this is R2 = R1. This
@@ -54,15 +64,57 @@
 // be either a zero or one
 #define CHANNEL_NUM 0
 
+// Note: change this to set the frequency of the waveform
+#define WAVEFORM_FREQ 1000
+
+// Points per waveform period; TIMER0 overflows once per point
+#define WAVE_POINTS   64
+#define TIMER0_FREQ   (WAVEFORM_FREQ * WAVE_POINTS)
+
+// LDMA channel that writes the VDAC
+#define LDMA_CHANNEL  0
+
+// Waveform shapes, in the order PB0 steps through them
+#define SHAPE_SINE      0
+#define SHAPE_TRIANGLE  1
+#define SHAPE_SAWTOOTH  2
+#define SHAPE_SQUARE    3
+#define NUM_SHAPES      4
+
+// One period of a sine wave, 12-bit VDAC codes
+static const uint16_t sineTable[WAVE_POINTS] = {
+  2048, 2248, 2447, 2642, 2831, 3013, 3185, 3346,
+  3495, 3630, 3750, 3853, 3939, 4007, 4056, 4085,
+  4095, 4085, 4056, 4007, 3939, 3853, 3750, 3630,
+  3495, 3346, 3185, 3013, 2831, 2642, 2447, 2248,
+  2048, 1847, 1648, 1453, 1264, 1082,  910,  749,
+   600,  465,  345,  242,  156,   88,   39,   10,
+     0,   10,   39,   88,  156,  242,  345,  465,
+   600,  749,  910, 1082, 1264, 1453, 1648, 1847,
+};
+
+// The waveform streamed and the next one. One point more than streamed
+// keeps the end of the first buffer apart from the start of the second.
+static uint16_t waveform[2][WAVE_POINTS + 1];
+
+// One self looping descriptor per buffer
+static LDMA_Descriptor_t descriptors[2];
+
+// Buffer of the waveform streamed, and its shape
+static uint32_t active;
+static volatile uint32_t shape;
+
+// Set by the PB0 interrupt
+static volatile bool buttonPressed;
+
 /**************************************************************************//**
  * @brief
  *    VDAC initialization
  *
  * @details
- *    In order to operate in EM2/3 mode, the clock must be set to asynchronous
- *    mode. The prescaler is set because the maximum frequency for the VDAC
- *    clock is 1 MHz. Of course, if you'd like to lower the clock (increase the
- *    prescaler) that is fine too.
+ *    The prescaler is set because the maximum frequency for the VDAC clock is
+ *    1 MHz. The settle time is masked out so that each new point is converted
+ *    right away; the VDAC and TIMER0 stay in EM1.
  *****************************************************************************/
 void initVdac(void)
 {
@@ -73,9 +125,6 @@ void initVdac(void)
   // Enable the VDAC clock
   CMU_ClockEnable(cmuClock_VDAC0, true);
 
-  // VDAC clock source for asynchronous mode is 12 MHz internal VDAC oscillator
-  init.asyncClockMode = true;
-
   // Calculate the VDAC clock prescaler value resulting in a 1 MHz VDAC clock.
   init.prescaler = VDAC_PrescaleCalc(1000000, false, 0);
 
@@ -86,30 +135,187 @@ void initVdac(void)
   VDAC_Init(VDAC0, &init);
   VDAC_InitChannel(VDAC0, &initChannel, CHANNEL_NUM);
 
+  // Set the settle time to zero for maximum update rate (mask it out)
+  VDAC0->OPA[CHANNEL_NUM].TIMER &= ~(_VDAC_OPA_TIMER_SETTLETIME_MASK);
+
   // Enable the VDAC
   VDAC_Enable(VDAC0, CHANNEL_NUM, true);
 }
 
 /**************************************************************************//**
  * @brief
- *    Calculate the digital value that maps to the desired output voltage
+ *    Fill one buffer with one period of a waveform
  *
- * @note
- *    The vRef parameter must match the reference voltage selected during
- *    initialization
+ * @param [out] buf
+ *    WAVE_POINTS 12-bit VDAC codes
+ *
+ * @param [in] waveShape
+ *    One of the SHAPE_ defines
+ *****************************************************************************/
+void fillWaveform(uint16_t *buf, uint32_t waveShape)
+{
+  uint32_t i;
+
+  for (i = 0; i < WAVE_POINTS; i++) {
+    switch (waveShape) {
+      case SHAPE_TRIANGLE:
+        if (i < WAVE_POINTS / 2) {
+          buf[i] = (uint16_t)((i * 4095) / (WAVE_POINTS / 2));
+        } else {
+          buf[i] = (uint16_t)(((WAVE_POINTS - i) * 4095) / (WAVE_POINTS / 2));
+        }
+        break;
+      case SHAPE_SAWTOOTH:
+        buf[i] = (uint16_t)((i * 4095) / (WAVE_POINTS - 1));
+        break;
+      case SHAPE_SQUARE:
+        buf[i] = (i < WAVE_POINTS / 2) ? 4095 : 0;
+        break;
+      default:
+        buf[i] = sineTable[i];
+        break;
+    }
+  }
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Timer initialization
+ *****************************************************************************/
+void initTimer(void)
+{
+  // Enable clock for TIMER0 module
+  CMU_ClockEnable(cmuClock_TIMER0, true);
+
+  // Initialize TIMER0
+  TIMER_Init_TypeDef init = TIMER_INIT_DEFAULT;
+  init.enable = false;
+  TIMER_Init(TIMER0, &init);
+
+  // Set top (reload) value for the timer
+  // Note: the timer runs off of the HFPER clock
+  uint32_t topValue = CMU_ClockFreqGet(cmuClock_HFPER) / TIMER0_FREQ;
+  TIMER_TopBufSet(TIMER0, topValue);
+
+  // Automatically clear the DMA request
+  TIMER0->CTRL |= TIMER_CTRL_DMACLRACT;
+
+  // Enable TIMER0
+  TIMER_Enable(TIMER0, true);
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Initialize the LDMA module
  *
- * @param [in] vOut
- *    Desired output voltage
+ * @details
+ *    Each buffer has a descriptor that links to itself, so the LDMA loops
+ *    over the buffer streamed without interrupts. The transfer is triggered
+ *    by the TIMER0 overflow, one point per overflow.
+ *****************************************************************************/
+void initLdma(void)
+{
+  uint32_t i;
+
+  for (i = 0; i < 2; i++) {
+    descriptors[i] = (LDMA_Descriptor_t)
+      LDMA_DESCRIPTOR_LINKREL_M2P_BYTE(waveform[i],
+                                       (CHANNEL_NUM == 0) ? &VDAC0->CH0DATA
+                                                          : &VDAC0->CH1DATA,
+                                       WAVE_POINTS,
+                                       0);              // Link to same descriptor
+    descriptors[i].xfer.doneIfs = 0;             // Don't trigger interrupt when transfer is done
+    descriptors[i].xfer.size = ldmaCtrlSizeHalf; // Transfer halfwords (VDAC data register is 12 bits)
+  }
+
+  // Start with the sine wave
+  active = 0;
+  shape = SHAPE_SINE;
+  fillWaveform(waveform[active], shape);
+
+  // Trigger on TIMER0 overflow
+  LDMA_TransferCfg_t transferConfig =
+    LDMA_TRANSFER_CFG_PERIPHERAL(ldmaPeripheralSignal_TIMER0_UFOF);
+
+  // LDMA initialization
+  LDMA_Init_t init = LDMA_INIT_DEFAULT;
+  LDMA_Init(&init);
+
+  // Start the transfer
+  LDMA_StartTransfer(LDMA_CHANNEL, &transferConfig, &descriptors[active]);
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Switch the stream to another waveform at the end of a period
  *
- * @param [in] vRef
- *    Reference voltage used by the VDAC
+ * @details
+ *    The new waveform is written to the buffer not streamed, and the
+ *    descriptor streamed is linked to the descriptor of that buffer. The
+ *    LDMA reads the link when it loads the descriptor again, so the switch
+ *    happens at the end of a period, within two periods, without a glitch.
  *
- * @return
- *    The digital value that maps to the desired output voltage
+ * @param [in] waveShape
+ *    One of the SHAPE_ defines
+ *****************************************************************************/
+void streamWaveform(uint32_t waveShape)
+{
+  uint32_t next = active ^ 1;
+  uint32_t start = (uint32_t)waveform[active];
+  uint32_t src;
+
+  // Wait until the previous switch has reached its buffer
+  do {
+    src = LDMA->CH[LDMA_CHANNEL].SRC;
+  } while ((src <= start) || (src > start + (WAVE_POINTS * 2)));
+
+  fillWaveform(waveform[next], waveShape);
+
+  // The next buffer loops on itself, the streamed one moves on to it
+  descriptors[next].xfer.linkAddr = 0;
+  descriptors[active].xfer.linkAddr =
+    ((int32_t)next - (int32_t)active) * LDMA_DESCRIPTOR_NWORDS;
+
+  active = next;
+  shape = waveShape;
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Push button PB0 initialization, a falling edge interrupt
+ *****************************************************************************/
+void initButton(void)
+{
+  CMU_ClockEnable(cmuClock_GPIO, true);
+
+  GPIO_PinModeSet(BSP_GPIO_PB0_PORT, BSP_GPIO_PB0_PIN, gpioModeInputPullFilter, 1);
+  GPIO_ExtIntConfig(BSP_GPIO_PB0_PORT, BSP_GPIO_PB0_PIN, BSP_GPIO_PB0_PIN,
+                    false, true, true);
+
+  NVIC_ClearPendingIRQ(GPIO_EVEN_IRQn);
+  NVIC_EnableIRQ(GPIO_EVEN_IRQn);
+  NVIC_ClearPendingIRQ(GPIO_ODD_IRQn);
+  NVIC_EnableIRQ(GPIO_ODD_IRQn);
+}
+
+/**************************************************************************//**
+ * @brief
+ *    GPIO Even IRQ for pushbuttons on even-numbered pins
  *****************************************************************************/
-uint32_t getVdacValue(float vOut, float vRef)
+void GPIO_EVEN_IRQHandler(void)
 {
-  return (uint32_t)((vOut * 4095) / vRef);
+  GPIO_IntClear(GPIO_IntGet() & 0x5555);
+  buttonPressed = true;
+}
+
+/**************************************************************************//**
+ * @brief
+ *    GPIO Odd IRQ for pushbuttons on odd-numbered pins
+ *****************************************************************************/
+void GPIO_ODD_IRQHandler(void)
+{
+  GPIO_IntClear(GPIO_IntGet() & 0xAAAA);
+  buttonPressed = true;
 }
 
 /**************************************************************************//**
@@ -124,6 +330,7 @@ void initOpamp(void)
   init.resSel   = RESISTOR_SELECT;      // Choose the resistor ladder ratio
   init.posSel   = opaPosSelAPORT3XCH2;  // Choose opamp positive input to come from PD10
   init.outMode  = opaOutModeAPORT3YCH3; // Route opamp output to PD11
+  init.drvStr   = opaDrvStrHigherAccHighStr; // Full drive strength and bandwidth
 
   // Enable OPA2
   OPAMP_Enable(VDAC0, OPA2, &init);
@@ -154,16 +361,21 @@ int main(void)
   // Enable the VDAC clock for accessing the opamp registers
   CMU_ClockEnable(cmuClock_VDAC0, true);
 
-  // Initialize the ADC and OPAMP
+  // Initialize the VDAC and OPAMP, then start streaming
   initVdac();
   initOpamp();
-
-  // Output the 12-bit output value for 1.1 V
-  uint32_t vdacValue = getVdacValue(1.1, 1.25);
-  VDAC_ChannelOutputSet(VDAC0, CHANNEL_NUM, vdacValue);
+  initLdma();
+  initTimer();
+  initButton();
 
   while (1) {
-    EMU_EnterEM3(false);
+    // The LDMA streams the waveform, sleep until PB0 is pressed
+    EMU_EnterEM1();
+
+    if (buttonPressed) {
+      buttonPressed = false;
+      streamWaveform((shape + 1) % NUM_SHAPES);
+    }
   }
 }
 
@@ -0,0 +1,92 @@
+/***************************************************************************//**
+ * @file chopper.h
+ *
+ * @brief Chopped differential measurement: the opamp inputs swapped between
+ * LDMA captured ADC blocks, the offset removed by subtracting the blocks.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2020 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ******************************************************************************/
+
+#ifndef CHOPPER_H
+#define CHOPPER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "em_device.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// LDMA channel that empties ADC0 SINGLEDATA
+#define CHOP_LDMA_CHANNEL     0
+
+// Results per block; the inputs swap once per block, at most 2048
+#ifndef CHOP_BLOCK_SIZE
+#define CHOP_BLOCK_SIZE       256
+#endif
+
+// Results left out at the start of each block while the opamps settle
+#ifndef CHOP_SETTLE
+#define CHOP_SETTLE           16
+#endif
+
+// Chopped results held until CHOP_Read(), a power of 2
+#ifndef CHOP_FIFO_SIZE
+#define CHOP_FIFO_SIZE        16
+#endif
+
+#if (CHOP_FIFO_SIZE & (CHOP_FIFO_SIZE - 1)) != 0
+#error "CHOP_FIFO_SIZE must be a power of 2"
+#endif
+
+#if (CHOP_SETTLE >= CHOP_BLOCK_SIZE) || (CHOP_BLOCK_SIZE > 2048)
+#error "CHOP_SETTLE must be below CHOP_BLOCK_SIZE, at most 2048"
+#endif
+
+// Fraction bits of a chopped result, in ADC codes
+#define CHOP_FRACTION_BITS    8
+
+// Results lost, all counters only ever count up
+typedef struct {
+  uint32_t halvesDropped;     // Blocks overwritten before the interrupt
+  uint32_t fifoOverflows;     // ADC single FIFO overflows (SINGLEOF)
+  uint32_t resultOverruns;    // Results lost to a full FIFO
+} CHOP_Counters_t;
+
+bool CHOP_Init(VDAC_TypeDef *vdac,
+               uint32_t opaRef, uint32_t posSelRef,
+               uint32_t opaGain, uint32_t posSelGain);
+void CHOP_Stop(void);
+uint32_t CHOP_Available(void);
+uint32_t CHOP_Read(int32_t *out, uint32_t max);
+void CHOP_GetCounters(CHOP_Counters_t *counters);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // CHOPPER_H
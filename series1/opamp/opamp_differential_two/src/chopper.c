@@ -0,0 +1,345 @@
+/***************************************************************************//**
+ * @file chopper.c
+ *
+ * @brief Chopped differential measurement: the opamp inputs swapped between
+ * LDMA captured ADC blocks, the offset removed by subtracting the blocks.
+ *
+ * Two linked LDMA descriptors move the results of the repetitive ADC single
+ * conversion of the amplifier output into the two halves of a ring and loop
+ * forever. The LDMA interrupt at the end of each half swaps the two
+ * positive inputs of the amplifier, a write of the POSSEL field of each
+ * opamp MUX register, so the halves alternate between the two polarities.
+ * It then sums the completed half, leaving out the first CHOP_SETTLE
+ * results, and subtracts the mean of each inverted half from the mean of
+ * the normal half before it.
+ *
+ * The differential input changes sign with the swap, but the offsets of
+ * the opamps and of the ADC, and any noise slower than a pair of halves,
+ * do not, so they cancel in the difference. The CPU is only involved once
+ * per half ring, not per conversion.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2020 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ *******************************************************************************
+ * # Evaluation Quality
+ * This code has been minimally tested to ensure that it builds and is suitable
+ * as a demonstration for evaluation purposes only. This code will be maintained
+ * at the sole discretion of Silicon Labs.
+ ******************************************************************************/
+
+#include "em_device.h"
+#include "em_adc.h"
+#include "em_cmu.h"
+#include "em_ldma.h"
+
+#include "chopper.h"
+
+// Input polarities, the other opamp input on each
+#define PHASE_NORMAL    0
+#define PHASE_SWAPPED   1
+
+static LDMA_Descriptor_t descriptors[2];
+
+static uint16_t ring[2][CHOP_BLOCK_SIZE];
+
+static VDAC_TypeDef *opaVdac;
+static uint32_t opa[2];
+static uint32_t posSel[2];
+
+// Polarity each half is captured at, set when the LDMA starts on it
+static uint32_t phase;
+static uint32_t halfPhase[2];
+static uint32_t lastHalf;
+
+// Sum of the last normal half, until its swapped half is summed too
+static uint32_t normalSum;
+static bool haveNormal;
+
+// Head is written in the LDMA interrupt only, tail in CHOP_Read() only.
+// Both run freely and wrap at 2^32.
+static int32_t fifo[CHOP_FIFO_SIZE];
+static volatile uint32_t head;
+static volatile uint32_t tail;
+
+static volatile CHOP_Counters_t counters;
+
+/**************************************************************************//**
+ * @brief
+ *   Connect the inputs of both opamps for one polarity
+ *****************************************************************************/
+static void setPhase(uint32_t p)
+{
+  uint32_t i;
+
+  // The reference opamp gets the gain opamp's input when swapped
+  for (i = 0; i < 2; i++) {
+    opaVdac->OPA[opa[i]].MUX = (opaVdac->OPA[opa[i]].MUX
+                                & ~_VDAC_OPA_MUX_POSSEL_MASK)
+                               | posSel[i ^ p];
+  }
+  phase = p;
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Sum of the settled results of one half ring
+ *****************************************************************************/
+static uint32_t blockSum(const uint16_t *block)
+{
+  uint32_t sum = 0;
+  uint32_t i;
+
+  for (i = CHOP_SETTLE; i < CHOP_BLOCK_SIZE; i++) {
+    sum += block[i];
+  }
+  return sum;
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Queue the difference of a normal and a swapped half
+ *****************************************************************************/
+static void putResult(uint32_t normal, uint32_t swapped)
+{
+  uint32_t h = head;
+  int32_t diff = (int32_t)(normal - swapped);
+
+  if (h - tail == CHOP_FIFO_SIZE) {
+    // Keep the older results, the reader is behind
+    counters.resultOverruns++;
+    return;
+  }
+
+  // Mean difference in ADC codes, with CHOP_FRACTION_BITS below the point
+  fifo[h & (CHOP_FIFO_SIZE - 1)] =
+    (int32_t)(((int64_t)diff << CHOP_FRACTION_BITS)
+              / (CHOP_BLOCK_SIZE - CHOP_SETTLE));
+  head = h + 1;
+}
+
+/**************************************************************************//**
+ * @brief LDMA Handler
+ *****************************************************************************/
+void LDMA_IRQHandler(void)
+{
+  uint32_t pending = LDMA_IntGetEnabled();
+  uint32_t half, sum;
+
+  if (pending & LDMA_IF_ERROR) {
+    __BKPT(0);
+  }
+
+  if (pending & ((1 << CHOP_LDMA_CHANNEL) << _LDMA_IFC_DONE_SHIFT)) {
+    // Clear interrupt flag
+    LDMA_IntClear((1 << CHOP_LDMA_CHANNEL) << _LDMA_IFC_DONE_SHIFT);
+
+    // The half the LDMA is not writing is the one just completed
+    if (LDMA->CH[CHOP_LDMA_CHANNEL].DST < (uint32_t)ring[1]) {
+      half = 1;
+    } else {
+      half = 0;
+    }
+
+    // Swap first: the other half is already being captured, its first
+    // CHOP_SETTLE results cover the swap
+    setPhase(phase ^ 1);
+    halfPhase[half ^ 1] = phase;
+
+    // Both halves completed since the last interrupt, one was overwritten
+    // and the pair is broken
+    if (half == lastHalf) {
+      counters.halvesDropped++;
+      haveNormal = false;
+    }
+    lastHalf = half;
+
+    sum = blockSum(ring[half]);
+    if (halfPhase[half] == PHASE_NORMAL) {
+      normalSum = sum;
+      haveNormal = true;
+    } else if (haveNormal) {
+      putResult(normalSum, sum);
+      haveNormal = false;
+    }
+  }
+
+  if (ADC_IntGet(ADC0) & ADC_IF_SINGLEOF) {
+    ADC_IntClear(ADC0, ADC_IF_SINGLEOF);
+    counters.fifoOverflows++;
+  }
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Start the conversions and chop the inputs of a two opamp amplifier
+ *
+ * @details
+ *   The ADC single conversion must be set up in repetitive mode, with the
+ *   amplifier output as its input, and both opamps enabled with their
+ *   normal inputs before calling this. The conversions start here.
+ *
+ * @param[in] vdac
+ *   VDAC the opamps belong to, VDAC0.
+ *
+ * @param[in] opaRef
+ *   Opamp number of the voltage follower, 0 to 2.
+ *
+ * @param[in] posSelRef
+ *   Its normal positive input, an OPAMP_PosSel_TypeDef APORT X value.
+ *
+ * @param[in] opaGain
+ *   Opamp number of the non-inverting opamp, 0 to 2.
+ *
+ * @param[in] posSelGain
+ *   Its normal positive input, an APORT X value on another bus.
+ *
+ * @return
+ *   false if the arguments do not fit.
+ *****************************************************************************/
+bool CHOP_Init(VDAC_TypeDef *vdac,
+               uint32_t opaRef, uint32_t posSelRef,
+               uint32_t opaGain, uint32_t posSelGain)
+{
+  LDMA_Init_t ldmaInit = LDMA_INIT_DEFAULT;
+  LDMA_TransferCfg_t transferCfg =
+    LDMA_TRANSFER_CFG_PERIPHERAL(ldmaPeripheralSignal_ADC0_SINGLE);
+  uint32_t i;
+
+  if ((vdac == 0) || (opaRef > 2) || (opaGain > 2) || (opaRef == opaGain)
+      || (posSelRef & ~_VDAC_OPA_MUX_POSSEL_MASK)
+      || (posSelGain & ~_VDAC_OPA_MUX_POSSEL_MASK)) {
+    return false;
+  }
+
+  opaVdac = vdac;
+  opa[0] = opaRef;
+  opa[1] = opaGain;
+  posSel[0] = posSelRef;
+  posSel[1] = posSelGain;
+  setPhase(PHASE_NORMAL);
+
+  halfPhase[0] = PHASE_NORMAL;
+  lastHalf = 1;
+  haveNormal = false;
+  head = 0;
+  tail = 0;
+  counters.halvesDropped = 0;
+  counters.fifoOverflows = 0;
+  counters.resultOverruns = 0;
+
+  // Each half links to the other, interrupt when either is full
+  descriptors[0] = (LDMA_Descriptor_t)
+    LDMA_DESCRIPTOR_LINKREL_P2M_BYTE(&(ADC0->SINGLEDATA), ring[0],
+                                     CHOP_BLOCK_SIZE, 1);
+  descriptors[1] = (LDMA_Descriptor_t)
+    LDMA_DESCRIPTOR_LINKREL_P2M_BYTE(&(ADC0->SINGLEDATA), ring[1],
+                                     CHOP_BLOCK_SIZE, -1);
+
+  for (i = 0; i < 2; i++) {
+    descriptors[i].xfer.size = ldmaCtrlSizeHalf;
+    descriptors[i].xfer.doneIfs = 1;
+  }
+
+  // Enable LDMA clock
+  CMU_ClockEnable(cmuClock_LDMA, true);
+
+  LDMA_Init(&ldmaInit);
+
+  // Start from an empty single FIFO
+  ADC0->SINGLEFIFOCLEAR = ADC_SINGLEFIFOCLEAR_SINGLEFIFOCLEAR;
+  ADC_IntClear(ADC0, ADC_IF_SINGLEOF);
+
+  LDMA_StartTransfer(CHOP_LDMA_CHANNEL, &transferCfg, &descriptors[0]);
+
+  ADC_Start(ADC0, adcStartSingle);
+
+  return true;
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Stop the conversions and the LDMA transfer, with the normal inputs
+ *   connected; results still in the FIFO can be read
+ *****************************************************************************/
+void CHOP_Stop(void)
+{
+  ADC0->CMD = ADC_CMD_SINGLESTOP;
+  LDMA_StopTransfer(CHOP_LDMA_CHANNEL);
+  setPhase(PHASE_NORMAL);
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Number of chopped results waiting
+ *****************************************************************************/
+uint32_t CHOP_Available(void)
+{
+  return head - tail;
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Take chopped results out of the FIFO, oldest first
+ *
+ * @param[out] out
+ *   Results, the mean amplifier output of a normal half less that of the
+ *   swapped half after it, in ADC codes * 2^CHOP_FRACTION_BITS.
+ *
+ * @param[in] max
+ *   Results that fit in out.
+ *
+ * @return
+ *   Number of results read.
+ *****************************************************************************/
+uint32_t CHOP_Read(int32_t *out, uint32_t max)
+{
+  uint32_t t, count, i;
+
+  count = CHOP_Available();
+  if (count > max) {
+    count = max;
+  }
+
+  t = tail;
+  for (i = 0; i < count; i++) {
+    out[i] = fifo[(t + i) & (CHOP_FIFO_SIZE - 1)];
+  }
+
+  // Free the entries only after copying them out
+  tail = t + count;
+
+  return count;
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Copy the lost result counters
+ *****************************************************************************/
+void CHOP_GetCounters(CHOP_Counters_t *copy)
+{
+  copy->halvesDropped = counters.halvesDropped;
+  copy->fifoOverflows = counters.fifoOverflows;
+  copy->resultOverruns = counters.resultOverruns;
+}
@@ -1,8 +1,7 @@
 /**************************************************************************//**
  * @main_gg11.c
- * @brief This project operates in EM3 and configures opamp 0 as a voltage
- * follower and opamp 1 as a non-inverting opamp. The equation for Vdiff is
- * shown below:
+ * @brief This project configures opamp 0 as a voltage follower and opamp 1
+ * as a non-inverting opamp. The equation for Vdiff is shown below:
  *
  * Vdiff = (Vin1 - Vin0) * (R2 / R1)
  * Vdiff = Vout1 - Vin1
@@ -13,6 +12,11 @@
  * ladder ratio to be R2 = 3 * R1. This results in
  * Vdiff = (Vin1 - Vin0) * 3
  *
+ * The ADC converts Vout1 continuously and the inputs of the two opamps are
+ * swapped between the blocks the LDMA captures. The difference of a normal
+ * and a swapped block is (Vin1 - Vin0) * (1 + 2 * R2 / R1), without the
+ * offsets of the opamps and the ADC, see chopper.c.
+ *
  * @version 0.0.1
  ******************************************************************************
  * @section License
@@ -30,11 +34,51 @@
 #include "em_cmu.h"
 #include "em_emu.h"
 #include "em_opamp.h"
+#include "em_adc.h"
+#include "chopper.h"
 
 // Note: change this to one of the OPAMP_ResSel_TypeDef type defines to select
 //       the R2/R1 resistor ladder ratio. By default this is R2 = 3 * R1.
 #define RESISTOR_SELECT opaResSelR2eq3R1
 
+// Gain of a chopped result, 1 + 2 * R2/R1 for RESISTOR_SELECT
+#define CHOP_GAIN       7
+
+// ADC reference in millivolts, AVDD as the bridge excitation
+#define VREF_MV         3300
+
+// Chopped results, in the debugger
+static volatile int32_t chopped;         // Latest result, ADC codes * 256
+static volatile int32_t microvolts;      // Vin1 - Vin0 in uV
+static volatile uint32_t resultCount;
+static volatile CHOP_Counters_t lostResults;
+
+/**************************************************************************//**
+ * @brief
+ *    Initialize ADC
+ *****************************************************************************/
+void initAdc(void)
+{
+  // Enable ADC clock
+  CMU_ClockEnable(cmuClock_ADC0, true);
+
+  // Initialize the ADC
+  ADC_Init_TypeDef init = ADC_INIT_DEFAULT;
+  init.timebase = ADC_TimebaseCalc(0);           // Make sure timebase is at least 1 microsecond
+  init.prescale = ADC_PrescaleCalc(16000000, 0); // Init to max ADC clock for Series 1
+  ADC_Init(ADC0, &init);
+
+  // Convert the opamp 1 output continuously
+  ADC_InitSingle_TypeDef initSingle = ADC_INITSINGLE_DEFAULT;
+  initSingle.diff       = 0;              // Single ended
+  initSingle.reference  = adcRefVDD;      // AVDD, ratiometric with the bridge
+  initSingle.resolution = adcRes12Bit;    // 12-bit resolution
+  initSingle.acqTime    = adcAcqTime64;   // About 120 ksps at 19 MHz HFPERCLK
+  initSingle.rep        = true;           // Convert continuously
+  initSingle.posSel     = adcPosSelAPORT4YCH12; // Opamp 1 output on PE12
+  ADC_InitSingle(ADC0, &initSingle);
+}
+
 /**************************************************************************//**
  * @brief
  *    Main function
@@ -45,6 +89,9 @@
  *****************************************************************************/
 int main(void)
 {
+  CHOP_Counters_t counters;
+  int32_t result;
+
   // Chip errata
   CHIP_Init();
 
@@ -65,8 +112,26 @@ int main(void)
   OPAMP_Enable(VDAC0, OPA0, &init0);
   OPAMP_Enable(VDAC0, OPA1, &init1);
 
+  // Start the conversions and swap the opamp inputs between blocks
+  initAdc();
+  if (!CHOP_Init(VDAC0, 0, opaPosSelAPORT3XCH10, 1, opaPosSelAPORT4XCH11)) {
+    __BKPT(0);
+  }
+
   while (1) {
-    EMU_EnterEM3(false); // Enter EM3 (won't exit)
+    // Sleep until the LDMA interrupt completes the next block
+    EMU_EnterEM1();
+
+    while (CHOP_Read(&result, 1) == 1) {
+      // uV = (result * Vref * 1000) / (2^12 bit resolution * 2^8 * gain)
+      chopped = result;
+      microvolts = (int32_t)(((int64_t)result * VREF_MV * 1000)
+                             / ((int64_t)4096 * 256 * CHOP_GAIN));
+      resultCount++;
+    }
+
+    CHOP_GetCounters(&counters);
+    lostResults = counters;
   }
 }
 
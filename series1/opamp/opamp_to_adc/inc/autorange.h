@@ -0,0 +1,104 @@
+/***************************************************************************//**
+ * @file autorange.h
+ *
+ * @brief Auto-ranging opamp front end: ADC blocks moved by the LDMA, the
+ * opamp resistor ladder gain stepped between blocks.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2020 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ******************************************************************************/
+
+#ifndef AUTORANGE_H
+#define AUTORANGE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "em_device.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// LDMA channel that empties ADC0 SINGLEDATA
+#define AR_LDMA_CHANNEL     0
+
+// Blocks in the LDMA ring; a block handed out by AR_Next() stays valid
+// while AR_NUM_BLOCKS - 2 further blocks are captured
+#define AR_NUM_BLOCKS       4
+
+// Samples per block, at most 2048 (one LDMA descriptor)
+#ifndef AR_BLOCK_SIZE
+#define AR_BLOCK_SIZE       256
+#endif
+
+// Non-inverting gains of the resistor ladder, RES0 to RES7
+#define AR_NUM_GAINS        8
+
+// Block peak at or above which the gain steps down, 12-bit result
+#ifndef AR_CLIP_LEVEL
+#define AR_CLIP_LEVEL       4032
+#endif
+
+// The gain steps up when the peak at the next gain stays below this
+#ifndef AR_HIGH_LEVEL
+#define AR_HIGH_LEVEL       3072
+#endif
+
+// ADC reference in millivolts, used by AR_ToMicrovolts()
+#ifndef AR_VREF_MV
+#define AR_VREF_MV          2500
+#endif
+
+// One captured block and the gain it was captured at
+typedef struct {
+  const uint16_t *samples;    // AR_BLOCK_SIZE results, oldest first
+  uint32_t sequence;          // Block number since AR_Init()
+  uint32_t gainIndex;         // Ladder tap, 0 (lowest gain) to 7
+  uint32_t gainQ8;            // Gain * 256
+  uint16_t peak;              // Largest result in the block
+  bool settled;               // false if the gain changed during the block
+} AR_Block_t;
+
+// Blocks lost and gain steps, all counters only ever count up
+typedef struct {
+  uint32_t blocksDropped;     // Blocks overwritten before AR_Next()
+  uint32_t lateInterrupts;    // Blocks the LDMA interrupt was late for
+  uint32_t stepsUp;
+  uint32_t stepsDown;
+  uint32_t clippedBlocks;     // Blocks at the lowest gain that still clip
+} AR_Counters_t;
+
+bool AR_Init(VDAC_TypeDef *vdac, uint32_t opa, uint32_t startGain);
+void AR_Stop(void);
+bool AR_Next(AR_Block_t *block);
+uint32_t AR_GainQ8(uint32_t gainIndex);
+uint32_t AR_ToMicrovolts(uint32_t sample, uint32_t gainQ8);
+void AR_GetCounters(AR_Counters_t *counters);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // AUTORANGE_H
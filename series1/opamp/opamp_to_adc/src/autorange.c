@@ -0,0 +1,361 @@
+/***************************************************************************//**
+ * @file autorange.c
+ *
+ * @brief Auto-ranging opamp front end: ADC blocks moved by the LDMA, the
+ * opamp resistor ladder gain stepped between blocks.
+ *
+ * A looped chain of AR_NUM_BLOCKS LDMA descriptors moves the results of the
+ * repetitive ADC single conversion into a ring of blocks. The LDMA
+ * interrupt at the end of each block finds its peak and tags it with the
+ * gain it was captured at, then picks the gain for the blocks that follow:
+ * one step down if the block clips, one step up if its peak at the next
+ * gain would still stay below AR_HIGH_LEVEL. The step is a write of the
+ * RESSEL field of the opamp MUX register. The CPU is only involved once
+ * per block, not per conversion.
+ *
+ * The capture does not stop for a step, so the block being captured when
+ * the gain changes holds results of both gains and is tagged unsettled.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2020 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ *******************************************************************************
+ * # Evaluation Quality
+ * This code has been minimally tested to ensure that it builds and is suitable
+ * as a demonstration for evaluation purposes only. This code will be maintained
+ * at the sole discretion of Silicon Labs.
+ ******************************************************************************/
+
+#include "em_device.h"
+#include "em_adc.h"
+#include "em_cmu.h"
+#include "em_ldma.h"
+
+#include "autorange.h"
+
+#if (AR_BLOCK_SIZE == 0) || (AR_BLOCK_SIZE > 2048)
+#error "AR_BLOCK_SIZE must be 1 to 2048"
+#endif
+
+// Non-inverting gain of each ladder tap, Vout = Vin * (1 + R2/R1)
+typedef struct {
+  uint32_t resSel;            // VDAC_OPA_MUX_RESSEL value
+  uint32_t gainQ8;            // 1 + R2/R1, * 256
+} Gain_t;
+
+static const Gain_t gains[AR_NUM_GAINS] = {
+  { VDAC_OPA_MUX_RESSEL_RES0,  341 },   // R2 = 1/3 R1,  4/3
+  { VDAC_OPA_MUX_RESSEL_RES1,  512 },   // R2 = R1,      2
+  { VDAC_OPA_MUX_RESSEL_RES2,  683 },   // R2 = 5/3 R1,  8/3
+  { VDAC_OPA_MUX_RESSEL_RES3,  819 },   // R2 = 11/5 R1, 16/5
+  { VDAC_OPA_MUX_RESSEL_RES4, 1024 },   // R2 = 3 R1,    4
+  { VDAC_OPA_MUX_RESSEL_RES5, 1365 },   // R2 = 13/3 R1, 16/3
+  { VDAC_OPA_MUX_RESSEL_RES6, 2048 },   // R2 = 7 R1,    8
+  { VDAC_OPA_MUX_RESSEL_RES7, 4096 },   // R2 = 15 R1,   16
+};
+
+// Tags of a captured block
+typedef struct {
+  uint32_t gainIndex;
+  uint16_t peak;
+  bool settled;
+} Tag_t;
+
+static LDMA_Descriptor_t descriptors[AR_NUM_BLOCKS];
+
+static uint16_t ring[AR_NUM_BLOCKS][AR_BLOCK_SIZE];
+static Tag_t tags[AR_NUM_BLOCKS];
+
+static VDAC_TypeDef *opaVdac;
+static uint32_t opaIndex;
+static uint32_t gainIndex;
+
+// Sequence of the block the last gain step fell into
+static uint32_t stepBlock;
+
+// Blocks tagged, written in the LDMA interrupt only; blocks handed out,
+// in AR_Next() only. Both run freely and wrap at 2^32.
+static volatile uint32_t head;
+static uint32_t tail;
+
+static volatile AR_Counters_t counters;
+
+/**************************************************************************//**
+ * @brief
+ *   Move the opamp to a ladder tap
+ *****************************************************************************/
+static void setGain(uint32_t index)
+{
+  opaVdac->OPA[opaIndex].MUX = (opaVdac->OPA[opaIndex].MUX
+                                & ~_VDAC_OPA_MUX_RESSEL_MASK)
+                               | gains[index].resSel;
+  gainIndex = index;
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Largest result of one block
+ *****************************************************************************/
+static uint16_t blockPeak(const uint16_t *block)
+{
+  uint16_t peak = 0;
+  uint32_t i;
+
+  for (i = 0; i < AR_BLOCK_SIZE; i++) {
+    if (block[i] > peak) {
+      peak = block[i];
+    }
+  }
+  return peak;
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Pick the gain for the next blocks from the latest settled block
+ *****************************************************************************/
+static void adjustGain(const Tag_t *tag)
+{
+  uint32_t g = tag->gainIndex;
+
+  if (tag->peak >= AR_CLIP_LEVEL) {
+    if (g == 0) {
+      counters.clippedBlocks++;
+      return;
+    }
+    setGain(g - 1);
+    counters.stepsDown++;
+  } else if ((g < AR_NUM_GAINS - 1)
+             && ((uint32_t)tag->peak * gains[g + 1].gainQ8
+                 < (uint32_t)AR_HIGH_LEVEL * gains[g].gainQ8)) {
+    setGain(g + 1);
+    counters.stepsUp++;
+  } else {
+    return;
+  }
+
+  // The block the LDMA is writing now mixes both gains
+  stepBlock = head;
+}
+
+/**************************************************************************//**
+ * @brief LDMA Handler
+ *****************************************************************************/
+void LDMA_IRQHandler(void)
+{
+  uint32_t pending = LDMA_IntGetEnabled();
+  uint32_t writing, h, n;
+  Tag_t *tag = 0;
+
+  if (pending & LDMA_IF_ERROR) {
+    __BKPT(0);
+  }
+
+  if (pending & ((1 << AR_LDMA_CHANNEL) << _LDMA_IFC_DONE_SHIFT)) {
+    // Clear interrupt flag
+    LDMA_IntClear((1 << AR_LDMA_CHANNEL) << _LDMA_IFC_DONE_SHIFT);
+
+    // Every block before the one the LDMA is writing is complete
+    writing = ((LDMA->CH[AR_LDMA_CHANNEL].DST - (uint32_t)ring)
+               / (AR_BLOCK_SIZE * sizeof(uint16_t))) % AR_NUM_BLOCKS;
+
+    h = head;
+    for (n = 0; (h % AR_NUM_BLOCKS) != writing; n++, h++) {
+      tag = &tags[h % AR_NUM_BLOCKS];
+      tag->peak = blockPeak(ring[h % AR_NUM_BLOCKS]);
+      tag->gainIndex = gainIndex;
+      tag->settled = (h != stepBlock);
+    }
+    if (n > 1) {
+      counters.lateInterrupts += n - 1;
+    }
+    head = h;
+
+    // Only a block captured at one gain tells where the signal is
+    if ((tag != 0) && tag->settled) {
+      adjustGain(tag);
+    }
+  }
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Start capturing ADC blocks and ranging the opamp gain
+ *
+ * @details
+ *   The ADC single conversion must be set up in repetitive mode, with the
+ *   opamp output as its input, and the opamp enabled as a non-inverting
+ *   amplifier with its resistor ladder to VSS before calling this. The
+ *   conversions start here.
+ *
+ * @param[in] vdac
+ *   VDAC the opamp belongs to, VDAC0.
+ *
+ * @param[in] opa
+ *   Opamp number, 0 to 2.
+ *
+ * @param[in] startGain
+ *   Ladder tap to start at, 0 to AR_NUM_GAINS - 1.
+ *
+ * @return
+ *   false if the arguments do not fit.
+ *****************************************************************************/
+bool AR_Init(VDAC_TypeDef *vdac, uint32_t opa, uint32_t startGain)
+{
+  LDMA_Init_t ldmaInit = LDMA_INIT_DEFAULT;
+  LDMA_TransferCfg_t transferCfg =
+    LDMA_TRANSFER_CFG_PERIPHERAL(ldmaPeripheralSignal_ADC0_SINGLE);
+  uint32_t i;
+
+  if ((vdac == 0) || (opa > 2) || (startGain >= AR_NUM_GAINS)) {
+    return false;
+  }
+
+  opaVdac = vdac;
+  opaIndex = opa;
+  setGain(startGain);
+
+  // The opamp was just enabled, do not range on the first block
+  head = 0;
+  tail = 0;
+  stepBlock = 0;
+  counters.blocksDropped = 0;
+  counters.lateInterrupts = 0;
+  counters.stepsUp = 0;
+  counters.stepsDown = 0;
+  counters.clippedBlocks = 0;
+
+  // Each block links to the next, the last one back to the first
+  for (i = 0; i < AR_NUM_BLOCKS; i++) {
+    descriptors[i] = (LDMA_Descriptor_t)
+      LDMA_DESCRIPTOR_LINKREL_P2M_BYTE(&(ADC0->SINGLEDATA), ring[i],
+                                       AR_BLOCK_SIZE, 1);
+    descriptors[i].xfer.size = ldmaCtrlSizeHalf;
+    descriptors[i].xfer.doneIfs = 1;
+  }
+  descriptors[AR_NUM_BLOCKS - 1].xfer.linkAddr =
+    -(AR_NUM_BLOCKS - 1) * LDMA_DESCRIPTOR_NWORDS;
+
+  // Enable LDMA clock
+  CMU_ClockEnable(cmuClock_LDMA, true);
+
+  LDMA_Init(&ldmaInit);
+
+  // Start from an empty single FIFO
+  ADC0->SINGLEFIFOCLEAR = ADC_SINGLEFIFOCLEAR_SINGLEFIFOCLEAR;
+
+  LDMA_StartTransfer(AR_LDMA_CHANNEL, &transferCfg, &descriptors[0]);
+
+  ADC_Start(ADC0, adcStartSingle);
+
+  return true;
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Stop the conversions and the LDMA transfer
+ *****************************************************************************/
+void AR_Stop(void)
+{
+  ADC0->CMD = ADC_CMD_SINGLESTOP;
+  LDMA_StopTransfer(AR_LDMA_CHANNEL);
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Hand out the oldest captured block not handed out yet
+ *
+ * @param[out] block
+ *   The block and its tags. The samples stay valid while AR_NUM_BLOCKS - 2
+ *   further blocks are captured.
+ *
+ * @return
+ *   false if no block is waiting.
+ *****************************************************************************/
+bool AR_Next(AR_Block_t *block)
+{
+  uint32_t h = head;
+  uint32_t index;
+
+  if (h == tail) {
+    return false;
+  }
+
+  // Skip what the LDMA overwrites next, the reader is behind
+  if (h - tail > AR_NUM_BLOCKS - 2) {
+    counters.blocksDropped += h - tail - (AR_NUM_BLOCKS - 2);
+    tail = h - (AR_NUM_BLOCKS - 2);
+  }
+
+  index = tail % AR_NUM_BLOCKS;
+  block->samples = ring[index];
+  block->sequence = tail;
+  block->gainIndex = tags[index].gainIndex;
+  block->gainQ8 = gains[tags[index].gainIndex].gainQ8;
+  block->peak = tags[index].peak;
+  block->settled = tags[index].settled;
+  tail++;
+
+  return true;
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Gain of a ladder tap * 256
+ *****************************************************************************/
+uint32_t AR_GainQ8(uint32_t gainIndex)
+{
+  if (gainIndex >= AR_NUM_GAINS) {
+    return 0;
+  }
+  return gains[gainIndex].gainQ8;
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Opamp input voltage of a 12-bit result captured at a gain
+ *
+ * @details
+ *   uV = (sample * Vref * 1000 * 256) / (2^12 bit resolution * gainQ8)
+ *****************************************************************************/
+uint32_t AR_ToMicrovolts(uint32_t sample, uint32_t gainQ8)
+{
+  if (gainQ8 == 0) {
+    return 0;
+  }
+  return (uint32_t)(((uint64_t)sample * AR_VREF_MV * 1000 * 256)
+                    / (4096 * (uint64_t)gainQ8));
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Copy the ranging counters
+ *****************************************************************************/
+void AR_GetCounters(AR_Counters_t *copy)
+{
+  copy->blocksDropped = counters.blocksDropped;
+  copy->lateInterrupts = counters.lateInterrupts;
+  copy->stepsUp = counters.stepsUp;
+  copy->stepsDown = counters.stepsDown;
+  copy->clippedBlocks = counters.clippedBlocks;
+}
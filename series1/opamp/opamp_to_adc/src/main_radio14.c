@@ -1,12 +1,12 @@
 /**************************************************************************//**
  * @main_radio14.c
  * @brief This project configures opamp 0 as a non-inverting amplifier whose
- * gain is given by the following equation: Vout = Vin * (1 + R2/R1).
- * By default, this project selects the R2/R1 resistor
- * ladder ratio to be R2 = R1. This results in Vout = Vin * 2. This project also
- * configures the ADC to receive input on the same pin the opamp is outputting
- * to so that the user can enter debug mode to check the ADC conversion of the
- * opamp output.
+ * gain is given by the following equation: Vout = Vin * (1 + R2/R1), and
+ * ranges the gain automatically. The ADC converts the opamp output
+ * continuously and the LDMA moves the results into blocks; between blocks,
+ * the R2/R1 resistor ladder ratio steps down when a block clips and up when
+ * the signal would still fit at the next gain. Each block is tagged with
+ * the gain it was captured at, see autorange.c.
  * @version 0.0.1
  ******************************************************************************
  * @section License
@@ -25,17 +25,25 @@
 #include "em_emu.h"
 #include "em_opamp.h"
 #include "em_adc.h"
+#include "autorange.h"
 
-// Note: change this to one of the OPAMP_ResSel_TypeDef type defines to select
-//       the R2/R1 resistor ladder ratio. By default this is R2 = R1. This
-//       results in Vout = Vin * 2
+// Note: the resistor ladder ratio the ranging starts at, before the first
+//       block is captured. By default this is R2 = R1. This results in
+//       Vout = Vin * 2
 #define RESISTOR_SELECT opaResSelR2eqR1
 
+// Ladder tap of RESISTOR_SELECT, see the gain table in autorange.c
+#define START_GAIN      1
+
 // Note: These aren't necessary and are only provided so that they can be viewed
 // in the debugger. Additionally they are declared as volatile so that they
 // won't be optimized out by the compiler
-static volatile uint32_t sample;
-static volatile uint32_t millivolts;
+static volatile uint32_t sample;        // Last result of the latest block
+static volatile uint32_t gainQ8;        // Its gain * 256
+static volatile uint32_t microvolts;    // Opamp input voltage in uV
+static volatile uint32_t blocksAtGain[AR_NUM_GAINS];
+static volatile uint32_t unsettledBlocks;
+static volatile AR_Counters_t rangeCounters;
 
 /**************************************************************************//**
  * @brief
@@ -58,6 +66,8 @@ void initAdc(void)
   initSingle.reference  = adcRef2V5;           // Internal 2.5V reference
   initSingle.resolution = adcRes12Bit;         // 12-bit resolution
   initSingle.posSel     = adcPosSelAPORT1YCH7; // Choose input to ADC to be on PC7
+  initSingle.acqTime    = adcAcqTime256;       // About 35 ksps at 19 MHz HFPERCLK
+  initSingle.rep        = true;                // Convert continuously
   ADC_InitSingle(ADC0, &initSingle);
 }
 
@@ -97,6 +107,9 @@ void initOpamp(void)
  *****************************************************************************/
 int main(void)
 {
+  AR_Block_t block;
+  AR_Counters_t counters;
+
   // Chip errata
   CHIP_Init();
 
@@ -107,20 +120,32 @@ int main(void)
   initAdc();
   initOpamp();
 
-  while (1) {
-
-    // Start the ADC conversion
-    ADC_Start(ADC0, adcStartSingle);
-
-    // Wait for conversion to complete
-    while(!(ADC0->STATUS & _ADC_STATUS_SINGLEDV_MASK));
+  // Start the conversions and range the gain of OPA0
+  if (!AR_Init(VDAC0, 0, START_GAIN)) {
+    __BKPT(0);
+  }
 
-    // Get ADC result
-    sample = ADC_DataSingleGet(ADC0);
+  while (1) {
 
-    // Calculate input voltage in mV
-    // mV = (sample * 2.5Vref * 1000) / (2^12 bit resolution)
-    millivolts = (sample * 2500) / 4096;
+    // Sleep until the LDMA interrupt tags the next block
+    EMU_EnterEM1();
+
+    while (AR_Next(&block)) {
+      // Results of both gains, skip them
+      if (!block.settled) {
+        unsettledBlocks++;
+        continue;
+      }
+      blocksAtGain[block.gainIndex]++;
+
+      // Scale the last result back to the opamp input
+      sample = block.samples[AR_BLOCK_SIZE - 1];
+      gainQ8 = block.gainQ8;
+      microvolts = AR_ToMicrovolts(sample, block.gainQ8);
+    }
+
+    AR_GetCounters(&counters);
+    rangeCounters = counters;
   }
 }
 
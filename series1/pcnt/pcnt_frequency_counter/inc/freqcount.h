@@ -0,0 +1,77 @@
+/***************************************************************************//**
+ * @file freqcount.h
+ *
+ * @brief Gated PCNT frequency counter with automatic gate time selection.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2021 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ******************************************************************************/
+
+#ifndef FREQCOUNT_H
+#define FREQCOUNT_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "em_pcnt.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// PRS channel carrying the LETIMER0 gate to PCNT0
+#define FREQ_GATE_PRS_CHANNEL   1
+
+// LETIMER0 runs from the 32768 Hz LFXO, 2 ^ 15 ticks per second
+#define FREQ_CLOCK_SHIFT        15
+
+// Gate times are 2 ^ shift ticks, from 32 ticks (1 ms) to 32768 (1 s)
+#define FREQ_GATE_MIN_SHIFT     5
+#define FREQ_GATE_MAX_SHIFT     15
+
+// Ticks between two gates, long enough for the interrupt to reprogram
+// the LETIMER before the next gate opens
+#define FREQ_GATE_IDLE_TICKS    16
+
+// Counts per gate to aim for; 1000 counts is a resolution of 0.1 %. Low
+// frequencies get the longest gate and a resolution of 1 Hz.
+#ifndef FREQ_TARGET_COUNTS
+#define FREQ_TARGET_COUNTS      1000
+#endif
+
+typedef struct {
+  uint32_t frequency;       // Measured frequency in Hz
+  uint32_t resolution;      // Hz per count for this gate time
+  uint32_t counts;          // Edges counted during the gate
+  uint32_t gateTicks;       // Gate time in LETIMER0 ticks
+} FREQ_Result_t;
+
+void FREQ_Init(PCNT_PRSSel_TypeDef input);
+bool FREQ_GetResult(FREQ_Result_t *result);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // FREQCOUNT_H
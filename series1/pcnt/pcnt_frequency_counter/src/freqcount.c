@@ -0,0 +1,265 @@
+/***************************************************************************//**
+ * @file freqcount.c
+ *
+ * @brief Gated PCNT frequency counter with automatic gate time selection.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2021 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ *******************************************************************************
+ * # Evaluation Quality
+ * This code has been minimally tested to ensure that it builds and is suitable 
+ * as a demonstration for evaluation purposes only. This code will be maintained
+ * at the sole discretion of Silicon Labs.
+ ******************************************************************************/
+
+#include "em_cmu.h"
+#include "em_core.h"
+#include "em_device.h"
+#include "em_letimer.h"
+#include "em_pcnt.h"
+#include "em_prs.h"
+
+#include "freqcount.h"
+
+// Counts per gate above which the next gate is halved. Four times the
+// target leaves each gate time a range of 4:1, so it does not hunt.
+#define SHRINK_COUNTS       (4 * FREQ_TARGET_COUNTS)
+
+// Gate time of the measurement in progress
+static uint32_t gateShift;
+
+// The gate now running does not open, see LETIMER0_IRQHandler()
+static bool skipGate;
+
+// Counter wraps, in units of 0x10000 counts, and the last extended count
+static uint32_t wraps;
+static uint32_t lastCount;
+
+static FREQ_Result_t latest;
+static volatile bool haveResult;
+
+/**************************************************************************//**
+ * @brief
+ *   Program the LETIMER for a gate of 2 ^ shift ticks
+ *
+ * @details
+ *   In PWM mode output 0 is active from the COMP1 match until the
+ *   underflow, COMP1 + 1 ticks, and idle from the reload at COMP0 down to
+ *   COMP1. COMP1 takes effect right away, COMP0 at the next reload.
+ *****************************************************************************/
+static void setGate(uint32_t shift)
+{
+  uint32_t ticks = 1 << shift;
+
+  LETIMER_CompareSet(LETIMER0, 0, ticks - 1 + FREQ_GATE_IDLE_TICKS);
+  LETIMER_CompareSet(LETIMER0, 1, ticks - 1);
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Gate time that gives at least FREQ_TARGET_COUNTS
+ *
+ * @details
+ *   The count scales with the gate time, so the one just taken tells how
+ *   many the other gates would give. No counts at all jumps straight to
+ *   the longest gate.
+ *****************************************************************************/
+static uint32_t pickGate(uint32_t counts, uint32_t shift)
+{
+  while ((counts < FREQ_TARGET_COUNTS) && (shift < FREQ_GATE_MAX_SHIFT)) {
+    counts <<= 1;
+    shift++;
+  }
+  while ((counts >= SHRINK_COUNTS) && (shift > FREQ_GATE_MIN_SHIFT)) {
+    counts >>= 1;
+    shift--;
+  }
+
+  return shift;
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Counter value extended to 32 bits with the wraps
+ *
+ * @details
+ *   A wrap whose interrupt is still pending is folded in here. Reading the
+ *   counter again after the flag keeps both in step.
+ *****************************************************************************/
+static uint32_t readCount(void)
+{
+  uint32_t count = PCNT_CounterGet(PCNT0);
+
+  if (PCNT_IntGet(PCNT0) & PCNT_IF_OF) {
+    PCNT_IntClear(PCNT0, PCNT_IFC_OF);
+    wraps += 0x10000;
+    count = PCNT_CounterGet(PCNT0);
+  }
+
+  return wraps + count;
+}
+
+/**************************************************************************//**
+ * @brief  PCNT0 Handler
+ *****************************************************************************/
+void PCNT0_IRQHandler(void)
+{
+  PCNT_IntClear(PCNT0, PCNT_IFC_OF);
+  wraps += 0x10000;
+}
+
+/**************************************************************************//**
+ * @brief  LETIMER0 Handler
+ *
+ * @details
+ *   The gate has just closed, so the counter stands still until the next
+ *   one opens. A shorter gate takes effect in the period that has just
+ *   started. A longer one only once COMP0 is reloaded: the counter now
+ *   starts below the new COMP1, that gate never opens and is skipped.
+ *****************************************************************************/
+void LETIMER0_IRQHandler(void)
+{
+  uint32_t count;
+  uint32_t counts;
+  uint32_t shift;
+
+  LETIMER_IntClear(LETIMER0, LETIMER_IFC_UF);
+
+  count = readCount();
+  counts = count - lastCount;
+  lastCount = count;
+
+  if (skipGate) {
+    skipGate = false;
+    return;
+  }
+
+  // The gate is a power of two ticks, so this is counts * 32768 / ticks
+  latest.frequency = counts << (FREQ_CLOCK_SHIFT - gateShift);
+  latest.resolution = 1 << (FREQ_CLOCK_SHIFT - gateShift);
+  latest.counts = counts;
+  latest.gateTicks = 1 << gateShift;
+  haveResult = true;
+
+  shift = pickGate(counts, gateShift);
+  if (shift != gateShift) {
+    skipGate = (shift > gateShift);
+    gateShift = shift;
+    setGate(shift);
+  }
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Start measuring the frequency of a PRS signal
+ *
+ * @details
+ *   PCNT0 counts the edges of the input in external clock mode, up to the
+ *   top speed of the counter and down to EM3, wherever the PRS source
+ *   runs. LETIMER0 output 0 opens a gate of 1 ms to 1 s for it through
+ *   FREQ_GATE_PRS_CHANNEL, and the interrupt at the end of each gate is
+ *   the only one per measurement, plus one per 65536 counts.
+ *
+ *   The LFA clock has to run from the LFXO, see FREQ_CLOCK_SHIFT. The
+ *   PCNT0 registers are clocked by the input, so it should be running.
+ *
+ * @param[in] input
+ *   PRS channel with the signal to measure, already set up by the caller.
+ *****************************************************************************/
+void FREQ_Init(PCNT_PRSSel_TypeDef input)
+{
+  PCNT_Init_TypeDef pcntInit = PCNT_INIT_DEFAULT;
+  PCNT_TCC_TypeDef pcntTccInit = PCNT_TCC_DEFAULT;
+  LETIMER_Init_TypeDef letimerInit = LETIMER_INIT_DEFAULT;
+
+  gateShift = FREQ_GATE_MIN_SHIFT;
+  skipGate = true;        // The first edges only synchronize the counter
+  wraps = 0;
+  lastCount = 0;
+  haveResult = false;
+
+  // The gate is the LETIMER output; no pin is needed
+  CMU_ClockEnable(cmuClock_PRS, true);
+  PRS_SourceAsyncSignalSet(FREQ_GATE_PRS_CHANNEL,
+                           PRS_CH_CTRL_SOURCESEL_LETIMER0,
+                           PRS_CH_CTRL_SIGSEL_LETIMER0CH0);
+
+  CMU_ClockEnable(cmuClock_PCNT0, true);
+  pcntInit.mode     = pcntModeExtSingle;        // Input is the counter clock
+  pcntInit.top      = 0xFFFF;                   // Full 16 bit range
+  pcntInit.s1CntDir = false;                    // Count up
+  pcntInit.s0PRS    = input;
+
+  // Count only while the gate is high, the default polarity
+  pcntTccInit.tccPRS        = (PCNT_PRSSel_TypeDef)FREQ_GATE_PRS_CHANNEL;
+  pcntTccInit.prsGateEnable = true;
+
+  PCNT_Init(PCNT0, &pcntInit);
+  PCNT_TCCConfiguration(PCNT0, &pcntTccInit);
+  PCNT_PRSInputEnable(PCNT0, pcntPRSInputS0, true);
+
+  PCNT_IntEnable(PCNT0, PCNT_IEN_OF);
+  NVIC_ClearPendingIRQ(PCNT0_IRQn);
+  NVIC_EnableIRQ(PCNT0_IRQn);
+
+  CMU_ClockEnable(cmuClock_LETIMER0, true);
+  letimerInit.enable   = false;
+  letimerInit.comp0Top = true;
+  letimerInit.ufoa0    = letimerUFOAPwm;
+  letimerInit.repMode  = letimerRepeatFree;
+  letimerInit.topValue = (1 << gateShift) - 1 + FREQ_GATE_IDLE_TICKS;
+
+  // Need REP0 != 0 to run PWM
+  LETIMER_RepeatSet(LETIMER0, 0, 1);
+  LETIMER_CompareSet(LETIMER0, 1, (1 << gateShift) - 1);
+  LETIMER_Init(LETIMER0, &letimerInit);
+
+  LETIMER_IntEnable(LETIMER0, LETIMER_IEN_UF);
+  NVIC_ClearPendingIRQ(LETIMER0_IRQn);
+  NVIC_EnableIRQ(LETIMER0_IRQn);
+
+  LETIMER_Enable(LETIMER0, true);
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Copy the result of the last gate
+ *
+ * @return
+ *   true if there is a result that has not been read yet.
+ *****************************************************************************/
+bool FREQ_GetResult(FREQ_Result_t *result)
+{
+  bool fresh;
+
+  CORE_DECLARE_IRQ_STATE;
+  CORE_ENTER_CRITICAL();
+  *result = latest;
+  fresh = haveResult;
+  haveResult = false;
+  CORE_EXIT_CRITICAL();
+
+  return fresh;
+}
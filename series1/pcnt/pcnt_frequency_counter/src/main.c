@@ -0,0 +1,188 @@
+/***************************************************************************//**
+ * @file main.c
+ * @brief This project demonstrates a frequency counter built from the pulse
+ * counter in external clock mode. The LETIMER opens a gate for the counter
+ * through the PRS, and the gate time is picked automatically for every
+ * measurement to reach a target resolution. A TIMER0 PWM signal stepping
+ * from 10 Hz to a few MHz is measured; there is one interrupt per gate.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2021 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ *******************************************************************************
+ * # Evaluation Quality
+ * This code has been minimally tested to ensure that it builds and is suitable 
+ * as a demonstration for evaluation purposes only. This code will be maintained
+ * at the sole discretion of Silicon Labs.
+ ******************************************************************************/
+
+#include "em_chip.h"
+#include "em_cmu.h"
+#include "em_device.h"
+#include "em_emu.h"
+#include "em_gpio.h"
+#include "em_pcnt.h"
+#include "em_prs.h"
+#include "em_timer.h"
+
+#include "bsp.h"
+
+#include "freqcount.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// PRS channel carrying the signal to measure
+#define INPUT_PRS_CHANNEL   0
+
+// Time each test signal is measured for, in LETIMER0 ticks
+#define STEP_TICKS          (3 * 32768)
+
+// Test signals, the actual frequency depends on the TIMER0 clock
+typedef struct {
+  uint32_t frequency;
+  TIMER_Prescale_TypeDef prescale;
+} TestSignal_t;
+
+static const TestSignal_t testSignals[] = {
+  { 10, timerPrescale1024 },
+  { 250, timerPrescale16 },
+  { 4000, timerPrescale1 },
+  { 75000, timerPrescale1 },
+  { 1000000, timerPrescale1 },
+  { 4000000, timerPrescale1 },
+};
+
+#define TEST_SIGNALS        (sizeof(testSignals) / sizeof(testSignals[0]))
+
+/* Frequency generated and frequency measured, in Hz */
+uint32_t testFrequency;
+uint32_t frequency;
+
+/* Hz per count and gate time in LETIMER0 ticks of the last measurement */
+uint32_t resolution;
+uint32_t gateTicks;
+
+/***************************************************************************//**
+ * @brief Test signal setup
+ *        This function starts TIMER0 CC0 in PWM mode at 50 % duty cycle and
+ *        connects it to the PRS channel the frequency counter listens to
+ ******************************************************************************/
+static void setTestSignal(const TestSignal_t *signal)
+{
+  TIMER_Init_TypeDef timerInit = TIMER_INIT_DEFAULT;
+  TIMER_InitCC_TypeDef timerCCInit = TIMER_INITCC_DEFAULT;
+  uint32_t clock;
+  uint32_t top;
+
+  CMU_ClockEnable(cmuClock_TIMER0, true);
+
+  /* Stop while the prescaler changes */
+  TIMER_Enable(TIMER0, false);
+
+  /* The prescaler setting is log2 of the division */
+  clock = CMU_ClockFreqGet(cmuClock_TIMER0) >> signal->prescale;
+  top = clock / signal->frequency;
+  testFrequency = clock / top;
+
+  /* PWM mode, the PRS sees the CC0 output without a pin */
+  timerCCInit.mode = timerCCModePWM;
+  TIMER_InitCC(TIMER0, 0, &timerCCInit);
+
+  TIMER_TopSet(TIMER0, top - 1);
+  TIMER_CompareSet(TIMER0, 0, top / 2);
+
+  timerInit.prescale = signal->prescale;
+  TIMER_Init(TIMER0, &timerInit);
+
+  CMU_ClockEnable(cmuClock_PRS, true);
+  PRS_SourceAsyncSignalSet(INPUT_PRS_CHANNEL, PRS_CH_CTRL_SOURCESEL_TIMER0,
+                           PRS_CH_CTRL_SIGSEL_TIMER0CC0);
+}
+
+/***************************************************************************//**
+ * @brief GPIO setup
+ *        This function configures LED0, which toggles on every measurement
+ ******************************************************************************/
+static void setupGpio(void)
+{
+  CMU_ClockEnable(cmuClock_HFPER, true);
+  CMU_ClockEnable(cmuClock_GPIO, true);
+
+  /* Initialize LED driver */
+  GPIO_PinModeSet(BSP_GPIO_LED0_PORT, BSP_GPIO_LED0_PIN, gpioModePushPull, 0);
+}
+
+/***************************************************************************//**
+ * @brief  Main function
+ ******************************************************************************/
+int main(void)
+{
+  EMU_DCDCInit_TypeDef dcdcInit = EMU_DCDCINIT_DEFAULT;
+  FREQ_Result_t result;
+  uint32_t signal = 0;
+  uint32_t ticks = 0;
+
+  /* Chip errata */
+  CHIP_Init();
+
+  /* Init DCDC regulator with kit specific parameters */
+  EMU_DCDCInit(&dcdcInit);
+
+  /* Use LFXO as LFA clock for LETIMER, the gate time reference */
+  CMU_ClockSelectSet(cmuClock_LFA, cmuSelect_LFXO);
+  CMU_ClockEnable(cmuClock_HFLE, true);
+
+  /* GPIO Initialization */
+  setupGpio();
+
+  /* Start the test signal, then measure it */
+  setTestSignal(&testSignals[signal]);
+  FREQ_Init((PCNT_PRSSel_TypeDef)INPUT_PRS_CHANNEL);
+
+  /*
+   * TIMER0 needs the HF clock, so wait in EM1. An external signal brought
+   * in through a GPIO PRS channel can be measured down to EM3.
+   */
+  while (true) {
+    EMU_EnterEM1();
+
+    if (FREQ_GetResult(&result)) {
+      frequency = result.frequency;
+      resolution = result.resolution;
+      gateTicks = result.gateTicks;
+
+      /* Toggle LED0 */
+      GPIO_PinOutToggle(BSP_GPIO_LED0_PORT, BSP_GPIO_LED0_PIN);
+
+      /* Move on to the next test signal every few seconds */
+      ticks += result.gateTicks + FREQ_GATE_IDLE_TICKS;
+      if (ticks >= STEP_TICKS) {
+        ticks = 0;
+        signal = (signal + 1) % TEST_SIGNALS;
+        setTestSignal(&testSignals[signal]);
+      }
+    }
+  }
+}
@@ -43,17 +43,33 @@
 #include "em_cryotimer.h"
 #include "em_gpio.h"
 #include "em_chip.h"
+#include "resetlog.h"
 
 #include "bspconfig.h"
 
 
+// Reset causes summed from the reset log
+#define RSTCAUSE_BOD (RMU_RSTCAUSE_AVDDBOD | RMU_RSTCAUSE_DVDDBOD \
+                      | RMU_RSTCAUSE_DECBOD)
+
+// Reset log entries copied out at boot, the newest ones
+#define LOG_COPY_ENTRIES 8
+
 // Global Variables 
 unsigned long resetCause;
 volatile uint32_t msTicks; // counts 1ms timeTicks 
 
+// Reset log, in the USERDATA page, for inspection in the debugger
+uint32_t resetLogCount;
+RESETLOG_Entry_TypeDef lastResets[LOG_COPY_ENTRIES];
+RESETLOG_Stats_TypeDef wdogStats;
+RESETLOG_Stats_TypeDef bodStats;
+RESETLOG_Stats_TypeDef porStats;
+
 // Function Declarations 
 void initGPIO(void);
 void startCRYO(void);
+void readResetLog(void);
 
 /**************************************************************************//**
  * @brief SysTick_Handler
@@ -117,6 +133,11 @@ int main(void){
   // Initialize chip 
   CHIP_Init();
 
+  // Count the core clock cycles from here to ready
+  CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+  DWT->CYCCNT = 0;
+  DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
   // Init DCDC regulator with kit specific parameters 
   EMU_DCDCInit_TypeDef dcdcInit = EMU_DCDCINIT_DEFAULT;
   EMU_DCDCInit(&dcdcInit);
@@ -129,9 +150,18 @@ int main(void){
   // Clear Reset causes so we know which reset matters the next time 
   RMU_ResetCauseClear();
 
+  // Log the reset first, a boot that never gets ready is logged too. No
+  // clock runs through every reset on series 1, so there is no timestamp.
+  RESETLOG_Init();
+  RESETLOG_Record(resetCause, 0);
+
   // Setup SysTick Timer for 1 msec interrupts  
   if (SysTick_Config(CMU_ClockFreqGet(cmuClock_CORE) / 1000)) while (1) ;
 
+  // Ready: store the time the boot took and copy the log out
+  RESETLOG_SetBootTime(DWT->CYCCNT);
+  readResetLog();
+
   // Enter loop, and wait for wdog reset 
   while (1)
   {
@@ -173,6 +203,31 @@ int main(void){
   }
 }
 
+/**************************************************************************//**
+ * @brief Copy the newest reset log entries and the cost of each kind of reset
+ *
+ * @details
+ *   The log survives every reset, including power on and brown-out resets.
+ *   The boot time is in core clock cycles from main() to ready.
+ *****************************************************************************/
+void readResetLog(void)
+{
+  uint32_t first, i;
+
+  resetLogCount = RESETLOG_Count();
+  first = (resetLogCount > LOG_COPY_ENTRIES)
+          ? (resetLogCount - LOG_COPY_ENTRIES) : 0;
+  for (i = 0; i < LOG_COPY_ENTRIES; i++) {
+    if (!RESETLOG_Get(first + i, &lastResets[i])) {
+      break;
+    }
+  }
+
+  RESETLOG_GetStats(RMU_RSTCAUSE_WDOGRST, &wdogStats);
+  RESETLOG_GetStats(RSTCAUSE_BOD, &bodStats);
+  RESETLOG_GetStats(RMU_RSTCAUSE_PORST, &porStats);
+}
+
 /**************************************************************************//**
  * @brief GPIO initialization
  *****************************************************************************/
@@ -46,10 +46,13 @@
 #include "em_rtcc.h"
 #include "em_wdog.h"
 #include "retargetserial.h"
+#include "wdogsup.h"
 
 // Global Variables 
 volatile uint32_t msTicks; // counts 1ms timeTicks 
 uint32_t resetCause;
+int printTask;  // checks in from the main loop, once per print
+int tickTask;   // checks in from the SysTick interrupt
 
 // Function Declarations 
 void initCMU(void);
@@ -61,6 +64,15 @@ void initWDOG(void);
 #define WAKEUP_INTERVAL_MS              1000
 #define RTCC_COUNT_BETWEEN_WAKEUP        (((LFRCO_FREQUENCY * WAKEUP_INTERVAL_MS) / 1000)-1)
 
+// Supervisor tick and task windows
+#define SUP_TICK_MS                     50
+#define PRINT_MIN_MS                    500
+#define PRINT_MAX_MS                    2000
+#define TICK_MAX_MS                     100
+
+// Prints before the main loop hangs, to let the supervisor catch it
+#define HANG_AFTER_PRINTS               4
+
 /**************************************************************************//**
  * @brief SysTick_Handler
  * Interrupt Service Routine for system tick counter
@@ -68,6 +80,7 @@ void initWDOG(void);
 void SysTick_Handler(void)
 {
   msTicks++;       // increment counter necessary in Delay()
+  WDOGSUP_CheckIn(tickTask);
 }
 
 /**************************************************************************//**
@@ -87,6 +100,9 @@ void Delay(uint32_t dlyTicks)
  *****************************************************************************/
 int main(void)
 {
+  uint32_t prints = 0;
+  uint32_t failed;
+
   // Chip errata 
   CHIP_Init();
 
@@ -111,22 +127,36 @@ int main(void)
   // Clear Reset causes so we know which reset occurs the next time 
   RMU_ResetCauseClear();
 
-  // Print if the reset was caused by the WDOG timer 
+  // Initialize the Watchdog and its supervisor, and register the tasks
+  initWDOG();
+  printTask = WDOGSUP_Register(PRINT_MIN_MS, PRINT_MAX_MS);
+  tickTask = WDOGSUP_Register(0, TICK_MAX_MS);
+
+  // Print if the reset was caused by the WDOG timer, and which tasks stalled
   if (resetCause & RMU_RSTCAUSE_WDOGRST)
   {
     printf(" -------- WATCHDOG RESET --------\r\n");
+    if (WDOGSUP_GetLastFailed(&failed))
+    {
+      printf(" failed tasks: 0x%lx\r\n", failed);
+    }
   }
 
   // Setup SysTick Timer for 1 msec interrupts  
   if (SysTick_Config(CMU_ClockFreqGet(cmuClock_CORE) / 1000)) while (1) ;
 
-  // Initialize the Watchdog 
-  initWDOG();
-
   while (1)
   {
     // Print out RTCC count here 
     printf("RTCC count: %x\n", (unsigned int)RTCC->CNT);
+    WDOGSUP_CheckIn(printTask);
+
+    // Hang, the SysTick keeps checking in but the print task stalls
+    if (++prints == HANG_AFTER_PRINTS)
+    {
+      printf("Main loop hangs\n");
+      while (1) ;
+    }
     Delay(1000);
   }
 }
@@ -185,14 +215,11 @@ void initRTCC(void)
  *****************************************************************************/
 void initWDOG(void)
 {
-  // Enabling clock to the interface of the low energy modules (including the Watchdog)
-  CMU_ClockEnable(cmuClock_HFLE, true);
-
-  WDOG_Init_TypeDef wdogInit = WDOG_INIT_DEFAULT;
-  wdogInit.clkSel = wdogClkSelULFRCO; // ULFRCO (1 kHz) as clock source
-  wdogInit.perSel = wdogPeriod_8k;    // 8193 clock cycles of a 1 kHz clock  ~8 seconds period
-  // Initializing watchdog with chosen settings 
-  WDOGn_Init(DEFAULT_WDOG, &wdogInit);
-  // Enbale the WDOG 
-  WDOGn_Enable(DEFAULT_WDOG, true);
+  WDOGSUP_Init_TypeDef supInit;
+
+  // ULFRCO (1 kHz) as WDOG clock source, fed from a LETIMER interrupt
+  supInit.tickMs = SUP_TICK_MS;
+  supInit.period = wdogPeriod_2k;    // 2049 clock cycles of a 1 kHz clock  ~2 seconds period
+  supInit.debugRun = false;
+  WDOGSUP_Init(&supInit);
 }
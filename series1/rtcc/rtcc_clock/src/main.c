@@ -0,0 +1,340 @@
+/***************************************************************************//**
+ * @file main.c
+ * @brief This project keeps the date and time with the rtcclock kit driver,
+ * logs a timestamped record at each wake-up from EM4, and raises a daily
+ * alarm.
+ *
+ * The time, the alarms and the record count are kept through EM4 hibernate
+ * in the RTCC retention registers. Because it is not possible to connect
+ * to a device in EM4, there is also an "escape hatch" mechanism available.
+ * Hold down PB0, and upon wake from EM4, the device will turn on LED0 and
+ * LED1 and execute the BKPT instruction.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2020 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ *******************************************************************************
+ * # Evaluation Quality
+ * This code has been minimally tested to ensure that it builds and is suitable 
+ * as a demonstration for evaluation purposes only. This code will be maintained
+ * at the sole discretion of Silicon Labs.
+ ******************************************************************************/
+
+#include <stdio.h>
+
+#include "em_device.h"
+#include "em_chip.h"
+#include "em_cmu.h"
+#include "em_emu.h"
+#include "em_gpio.h"
+#include "em_rmu.h"
+#include "em_rtcc.h"
+
+#include "bsp.h"
+#include "retargetserial.h"
+#include "retargetserialconfig.h"
+
+#include "rtcclock.h"
+
+// Alarms, one per RTCC compare channel
+#define LOG_ALARM     0
+#define DAILY_ALARM   1
+
+// Seconds between records, each one an EM4 wake-up
+#define LOG_PERIOD    10
+
+// Retention register of the record count, after those of the clock
+#define RET_RECORDS   RTCCLOCK_RET_WORDS
+
+// Alarms that fired since the last check, one bit each
+static volatile uint32_t alarms;
+
+/**************************************************************************//**
+ * @brief
+ *    RTCC interrupt handler, the alarms of the clock
+ *****************************************************************************/
+void RTCC_IRQHandler(void)
+{
+  RTCCLOCK_IRQHandler();
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Alarm callback
+ *****************************************************************************/
+static void onAlarm(uint32_t alarm, void *data)
+{
+  (void)data;
+  alarms |= 1UL << alarm;
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Initialize the LF domain clocks.
+ *
+ * @details
+ *    The LFECLK selection, the RTCC clock enable and the LFXO settings are
+ *    latched through EM4 and must be written again, as they were before EM4
+ *    entry, before the unlatch. See the rtcc_em4_wake example for the
+ *    details.
+ *****************************************************************************/
+static void lfClkInit(bool unlatch)
+{
+  CMU->LFECLKSEL = CMU_LFECLKSEL_LFE_LFXO;
+  CMU->LFECLKEN0 = CMU_LFECLKEN0_RTCC;
+
+  // A retained LFXO is still running, it needs no start-up timeout
+  if (unlatch)
+  {
+    CMU->LFXOCTRL = (CMU->LFXOCTRL & (~_CMU_LFXOCTRL_MASK))
+                    | CMU_LFXOCTRL_TIMEOUT_2CYCLES;
+
+    EMU_UnlatchPinRetention();
+  }
+  else
+  {
+    CMU_LFXOInit_TypeDef lfxo = CMU_LFXOINIT_DEFAULT;
+    CMU_LFXOInit(&lfxo);
+  }
+
+  CMU_OscillatorEnable(cmuOsc_LFXO, true, true);
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Read a line from the VCOM, with echo
+ *****************************************************************************/
+static void readLine(char *line, uint32_t size)
+{
+  uint32_t length = 0;
+  int c;
+
+  while (1)
+  {
+    c = RETARGET_ReadChar();
+    if (c < 0)
+      continue;
+    if ((c == '\r') || (c == '\n'))
+      break;
+    if ((c == '\b') && (length > 0))
+      length--;
+    else if (length < size - 1)
+      line[length++] = (char)c;
+    else
+      continue;
+    putchar(c);
+  }
+
+  line[length] = '\0';
+  putchar('\n');
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Print a time as a date, a time of day and milliseconds
+ *****************************************************************************/
+static void printTime(uint64_t ticks)
+{
+  static const char *const weekdays[7] = {
+    "Sun", "Mon", "Tue", "Wed", "Thu", "Fri", "Sat"
+  };
+  RTCCLOCK_Date_t date;
+  uint32_t ms = (((uint32_t)ticks & (RTCCLOCK_TICK_HZ - 1)) * 1000)
+                >> RTCCLOCK_TICK_SHIFT;
+
+  RTCCLOCK_ToDate(ticks >> RTCCLOCK_TICK_SHIFT, &date);
+  printf("%s %04u-%02u-%02u %02u:%02u:%02u.%03lu", weekdays[date.weekday],
+         date.year, date.month, date.day, date.hour, date.minute,
+         date.second, (unsigned long)ms);
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Ask for the date and time and the daily alarm, and set them
+ *****************************************************************************/
+static void setClock(void)
+{
+  RTCCLOCK_Date_t date = { 0 };
+  uint64_t seconds;
+  uint64_t alarm;
+  unsigned int year, month, day, hour, minute, second;
+  char line[32];
+
+  do
+  {
+    printf("\nEnter the date and time as yyyy-mm-dd hh:mm:ss:\n");
+    readLine(line, sizeof(line));
+    if (sscanf(line, "%u-%u-%u %u:%u:%u",
+               &year, &month, &day, &hour, &minute, &second) != 6)
+      continue;
+    date.year = (uint16_t)year;
+    date.month = (uint8_t)month;
+    date.day = (uint8_t)day;
+    date.hour = (uint8_t)hour;
+    date.minute = (uint8_t)minute;
+    date.second = (uint8_t)second;
+  } while (!RTCCLOCK_FromDate(&date, &seconds));
+  RTCCLOCK_Set(seconds);
+
+  do
+  {
+    printf("Enter the time of the daily alarm as hh:mm:ss:\n");
+    readLine(line, sizeof(line));
+    if (sscanf(line, "%u:%u:%u", &hour, &minute, &second) != 3)
+      continue;
+    date.hour = (uint8_t)hour;
+    date.minute = (uint8_t)minute;
+    date.second = (uint8_t)second;
+  } while (!RTCCLOCK_FromDate(&date, &alarm));
+
+  // An alarm earlier in the day first fires tomorrow
+  RTCCLOCK_AlarmSet(DAILY_ALARM, alarm, RTCCLOCK_DAY);
+  RTCCLOCK_AlarmSet(LOG_ALARM, RTCCLOCK_Seconds() + LOG_PERIOD, LOG_PERIOD);
+
+  if (RTCCLOCK_AlarmGet(DAILY_ALARM, &alarm))
+  {
+    printf("Daily alarm at ");
+    printTime(alarm << RTCCLOCK_TICK_SHIFT);
+    printf("\n");
+  }
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Show what a timestamp and a date conversion cost, in core cycles
+ *****************************************************************************/
+static void printCost(void)
+{
+  RTCCLOCK_Date_t date;
+  uint32_t start, nowCycles, dateCycles;
+  uint64_t ticks;
+
+  CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+  DWT->CYCCNT = 0;
+  DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+  start = DWT->CYCCNT;
+  ticks = RTCCLOCK_Now();
+  nowCycles = DWT->CYCCNT - start;
+
+  start = DWT->CYCCNT;
+  RTCCLOCK_ToDate(ticks >> RTCCLOCK_TICK_SHIFT, &date);
+  dateCycles = DWT->CYCCNT - start;
+
+  printf("Timestamp %lu cycles, date conversion %lu cycles\n",
+         (unsigned long)nowCycles, (unsigned long)dateCycles);
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Main function
+ *****************************************************************************/
+int main(void)
+{
+  uint32_t rflags;
+  uint32_t fired;
+  bool wakestate;
+
+  CHIP_Init();
+
+  CMU_ClockEnable(cmuClock_HFLE, true);
+  CMU_ClockEnable(cmuClock_GPIO, true);
+
+  // Only an EM4 wake-up alone keeps the RTCC running
+  rflags = RMU_ResetCauseGet();
+  wakestate = (rflags == RMU_RSTCAUSE_EM4RST);
+  RMU_ResetCauseClear();
+
+  lfClkInit(wakestate);
+
+  /*
+   * Pick up the clock from the RTCC retention registers after an EM4
+   * wake-up, else start it unset. An alarm that woke the device is
+   * handled as soon as the RTCC interrupt is enabled.
+   */
+  if (!RTCCLOCK_Init(&RTCC->RET[0].REG, wakestate, onAlarm, NULL))
+    RTCC->RET[RET_RECORDS].REG = 0;
+
+  RETARGET_SerialInit();
+  RETARGET_SerialCrLf(1);
+
+  if (!RTCCLOCK_IsSet())
+  {
+    printf("\nrtcc_clock\n");
+    setClock();
+    printCost();
+  }
+
+  fired = alarms;
+  alarms = 0;
+
+  // Timestamp the record as it is logged
+  if (fired & (1UL << LOG_ALARM))
+  {
+    RTCC->RET[RET_RECORDS].REG++;
+    printf("Record %lu at ", (unsigned long)RTCC->RET[RET_RECORDS].REG);
+    printTime(RTCCLOCK_Now());
+    printf("\n");
+  }
+  if (fired & (1UL << DAILY_ALARM))
+  {
+    printf("Daily alarm at ");
+    printTime(RTCCLOCK_Now());
+    printf("\n");
+  }
+
+  // Let the last character out before EM4
+#if defined(RETARGET_USART)
+  while (!(RETARGET_UART->STATUS & USART_STATUS_TXC));
+#endif
+
+  // Escape hatch: hold PB0 to stop in EM0 for the debugger
+  GPIO_PinModeSet(BSP_GPIO_PB0_PORT, BSP_GPIO_PB0_PIN, gpioModeInputPullFilter, 1);
+
+  if (GPIO_PinInGet(BSP_GPIO_PB0_PORT, BSP_GPIO_PB0_PIN) == 0)
+  {
+    GPIO_PinModeSet(BSP_GPIO_LED0_PORT, BSP_GPIO_LED0_PIN, gpioModePushPull, 0);
+    GPIO_PinModeSet(BSP_GPIO_LED1_PORT, BSP_GPIO_LED1_PIN, gpioModePushPull, 0);
+    __BKPT(1);
+  }
+  else
+    GPIO_PinModeSet(BSP_GPIO_PB0_PORT, BSP_GPIO_PB0_PIN, gpioModeDisabled, 0);
+
+  /*
+   * Hibernate with the LFXO retained, so that the RTCC keeps counting and
+   * its alarms wake the device.
+   */
+  EMU_EM4Init_TypeDef em4Init = EMU_EM4INIT_DEFAULT;
+  em4Init.em4State = emuEM4Hibernate;
+  em4Init.pinRetentionMode = emuPinRetentionLatch;
+  em4Init.retainLfxo = true;
+
+  EMU_EM4Init(&em4Init);
+  RTCC_EM4WakeupEnable(true);
+
+  EMU_EnterEM4();
+
+  // The CPU should never get here
+  __BKPT(0);
+}
@@ -0,0 +1,75 @@
+/***************************************************************************//**
+ * @file em4node.h
+ * @brief Sample batching in retention registers across EM4 wakeups.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2021 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ******************************************************************************/
+
+#ifndef EM4NODE_H
+#define EM4NODE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Words of the retention area used for the state, ahead of the samples,
+// which are packed two to a word
+#define EM4NODE_HEADER_WORDS  5
+
+// Most samples handed to a flush at once. The retention area holds
+// (words - EM4NODE_HEADER_WORDS) * 2 samples, capped at this.
+#ifndef EM4NODE_MAX_SAMPLES
+#define EM4NODE_MAX_SAMPLES   256
+#endif
+
+// Called to send a batch, with the samples oldest first. Return true
+// once the batch has gone; on false it is kept and offered again.
+typedef bool (*EM4NODE_Flush_t)(const uint16_t *samples,
+                                uint32_t count,
+                                uint32_t batch,
+                                void *data);
+
+bool EM4NODE_Init(volatile uint32_t *ret,
+                  uint32_t words,
+                  bool wake,
+                  uint32_t flushEvery);
+bool EM4NODE_Add(uint16_t sample);
+bool EM4NODE_FlushDue(void);
+bool EM4NODE_Flush(EM4NODE_Flush_t flush, void *data);
+uint32_t EM4NODE_GetWakeCount(void);
+uint32_t EM4NODE_GetSampleCount(void);
+uint32_t EM4NODE_GetCapacity(void);
+uint32_t EM4NODE_GetBatchCount(void);
+uint32_t EM4NODE_GetLostCount(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // EM4NODE_H
@@ -0,0 +1,299 @@
+/***************************************************************************//**
+ * @file em4node.c
+ * @brief Sample batching in retention registers across EM4 wakeups.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2021 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ******************************************************************************/
+
+#include <stddef.h>
+#include "em4node.h"
+
+// Identifies a formatted retention area, and the layout version
+#define MAGIC             0x454D3401UL
+
+// Layout of the state words
+#define W_MAGIC           0
+#define W_WAKES           1
+#define W_COUNT           2   // Samples stored | wakeups since the flush << 16
+#define W_BATCH           3   // Batches flushed | samples lost << 16
+#define W_CHECK           4
+
+#define FIELD_MAX         0xFFFFUL
+
+static volatile uint32_t *store;
+static uint32_t capacity;
+static uint32_t flushPeriod;
+
+// Unpacked batch handed to the flush callback
+static uint16_t batchBuffer[EM4NODE_MAX_SAMPLES];
+
+/***************************************************************************//**
+ * @brief
+ *   Get the low or high 16-bit field of a state word.
+ ******************************************************************************/
+static uint32_t low(uint32_t word)
+{
+  return store[word] & FIELD_MAX;
+}
+
+static uint32_t high(uint32_t word)
+{
+  return store[word] >> 16;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Write both fields of a state word, saturating each at 16 bits.
+ ******************************************************************************/
+static void setFields(uint32_t word, uint32_t lowField, uint32_t highField)
+{
+  if (lowField > FIELD_MAX) {
+    lowField = FIELD_MAX;
+  }
+  if (highField > FIELD_MAX) {
+    highField = FIELD_MAX;
+  }
+  store[word] = lowField | (highField << 16);
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Checksum over the state and the sample words in use.
+ *
+ * @details
+ *   A rotate and XOR per word: cheap, and enough to tell a retention area
+ *   with valid contents from one left in any state by a brownout or by
+ *   other firmware.
+ ******************************************************************************/
+static uint32_t checksum(void)
+{
+  uint32_t words = EM4NODE_HEADER_WORDS + ((low(W_COUNT) + 1) / 2);
+  uint32_t sum = 0x5A5A5A5AUL;
+  uint32_t i;
+
+  for (i = 0; i < words; i++) {
+    if (i != W_CHECK) {
+      sum = ((sum << 1) | (sum >> 31)) ^ store[i];
+    }
+  }
+
+  return sum;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Seal the state after a change, before the next EM4 entry.
+ ******************************************************************************/
+static void commit(void)
+{
+  store[W_CHECK] = checksum();
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Take over the retention area after a reset.
+ *
+ * @details
+ *   After a wakeup from EM4 the batch in the area is kept if its magic word,
+ *   sample count and checksum are valid. Otherwise, and after any other
+ *   reset, the area is formatted with an empty batch. Each call counts as a
+ *   wakeup.
+ *
+ * @param[in] ret
+ *   Retention words, kept through EM4 and accessed as 32-bit words only.
+ *
+ * @param[in] words
+ *   Number of retention words, more than EM4NODE_HEADER_WORDS.
+ *
+ * @param[in] wake
+ *   true if the reset was a wakeup from EM4.
+ *
+ * @param[in] flushEvery
+ *   Wakeups per flush. The batch is also flushed as soon as it is full.
+ *
+ * @return
+ *   true if the batch of the last wakeup was kept.
+ ******************************************************************************/
+bool EM4NODE_Init(volatile uint32_t *ret,
+                  uint32_t words,
+                  bool wake,
+                  uint32_t flushEvery)
+{
+  bool restored;
+
+  store = ret;
+  capacity = (words > EM4NODE_HEADER_WORDS)
+             ? (words - EM4NODE_HEADER_WORDS) * 2 : 0;
+  if (capacity > EM4NODE_MAX_SAMPLES) {
+    capacity = EM4NODE_MAX_SAMPLES;
+  }
+  flushPeriod = (flushEvery > 0) ? flushEvery : 1;
+
+  restored = wake
+             && (store[W_MAGIC] == MAGIC)
+             && (low(W_COUNT) <= capacity)
+             && (store[W_CHECK] == checksum());
+
+  if (!restored) {
+    store[W_MAGIC] = MAGIC;
+    store[W_WAKES] = 0;
+    store[W_COUNT] = 0;
+    store[W_BATCH] = 0;
+  }
+
+  store[W_WAKES]++;
+  setFields(W_COUNT, low(W_COUNT), high(W_COUNT) + 1);
+  commit();
+
+  return restored;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Add a sample to the batch.
+ *
+ * @return
+ *   false if the batch is full, the sample is then counted as lost.
+ ******************************************************************************/
+bool EM4NODE_Add(uint16_t sample)
+{
+  uint32_t count = low(W_COUNT);
+  uint32_t word = EM4NODE_HEADER_WORDS + (count / 2);
+
+  if (count >= capacity) {
+    setFields(W_BATCH, low(W_BATCH), high(W_BATCH) + 1);
+    commit();
+    return false;
+  }
+
+  if (count & 1) {
+    store[word] = (store[word] & FIELD_MAX) | ((uint32_t)sample << 16);
+  } else {
+    store[word] = sample;
+  }
+
+  setFields(W_COUNT, count + 1, high(W_COUNT));
+  commit();
+
+  return true;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Check if the batch should be flushed in this wakeup.
+ *
+ * @return
+ *   true if the batch holds samples and flushEvery wakeups have passed
+ *   since the last flush, or the batch is full.
+ ******************************************************************************/
+bool EM4NODE_FlushDue(void)
+{
+  uint32_t count = low(W_COUNT);
+
+  return (count > 0)
+         && ((high(W_COUNT) >= flushPeriod) || (count >= capacity));
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Hand the batch to a flush callback and empty it once it has gone.
+ *
+ * @details
+ *   The application powers up its radio or UART in the callback, so the
+ *   cost of starting it up is spread over the whole batch.
+ *
+ * @return
+ *   The result of the callback, or false if the batch is empty.
+ ******************************************************************************/
+bool EM4NODE_Flush(EM4NODE_Flush_t flush, void *data)
+{
+  uint32_t count = low(W_COUNT);
+  uint32_t i, word;
+
+  if ((count == 0) || (flush == NULL)) {
+    return false;
+  }
+
+  for (i = 0; i < count; i++) {
+    word = store[EM4NODE_HEADER_WORDS + (i / 2)];
+    batchBuffer[i] = (uint16_t)((i & 1) ? (word >> 16) : word);
+  }
+
+  if (!flush(batchBuffer, count, low(W_BATCH), data)) {
+    return false;
+  }
+
+  setFields(W_COUNT, 0, 0);
+  setFields(W_BATCH, (low(W_BATCH) + 1) & FIELD_MAX, high(W_BATCH));
+  commit();
+
+  return true;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Get the wakeups since the retention area was formatted.
+ ******************************************************************************/
+uint32_t EM4NODE_GetWakeCount(void)
+{
+  return store[W_WAKES];
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Get the samples in the batch.
+ ******************************************************************************/
+uint32_t EM4NODE_GetSampleCount(void)
+{
+  return low(W_COUNT);
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Get the most samples the batch holds.
+ ******************************************************************************/
+uint32_t EM4NODE_GetCapacity(void)
+{
+  return capacity;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Get the batches flushed, modulo 2 ^ 16.
+ ******************************************************************************/
+uint32_t EM4NODE_GetBatchCount(void)
+{
+  return low(W_BATCH);
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Get the samples lost to a full batch, up to 2 ^ 16 - 1.
+ ******************************************************************************/
+uint32_t EM4NODE_GetLostCount(void)
+{
+  return high(W_BATCH);
+}
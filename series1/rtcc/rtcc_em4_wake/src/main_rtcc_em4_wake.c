@@ -45,6 +45,8 @@
  * at the sole discretion of Silicon Labs.
  ******************************************************************************/
 
+#include <stdio.h>
+
 #include "em_device.h"
 #include "em_chip.h"
 #include "em_cmu.h"
@@ -54,6 +56,10 @@
 #include "em_rtcc.h"
 
 #include "bsp.h"
+#include "retargetserial.h"
+#include "retargetserialconfig.h"
+
+#include "em4node.h"
 
 // Configuration Lock Word 0 (holds the bootloader enable bit)
 #define CLW0 *(uint32_t *)(LOCKBITS_BASE + (122 << 2))
@@ -66,6 +72,13 @@
  */
 #define LFXOFREQ  32768
 
+/*
+ * Wakeups per batch.  Each wakeup stores one sample in the RTCC
+ * retention registers, and the UART is only started up to send the
+ * batch once every FLUSH_EVERY wakeups.
+ */
+#define FLUSH_EVERY 12
+
 /**************************************************************************//**
  * @brief
  *    Initialize the LF domain clocks.
@@ -275,6 +288,49 @@ void rtccInit(uint32_t next, bool wake)
   while ((RTCC->SYNCBUSY & RTCC_SYNCBUSY_CMD));
 }
 
+/**************************************************************************//**
+ * @brief
+ *    Take a sample.
+ *
+ * @details
+ *    Stands in for a real sensor read: returns the RTCC count, which
+ *    is the seconds since the last power-on reset.
+ *****************************************************************************/
+uint16_t readSensor(void)
+{
+  return (uint16_t)RTCC_CounterGet();
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Send a batch of samples over the VCOM UART.
+ *
+ * @details
+ *    Stands in for a radio transmission.  The UART is only started up
+ *    in the wakeups that flush a batch, and the last character must be
+ *    out of the shift register before EM4 is entered.
+ *****************************************************************************/
+bool sendBatch(const uint16_t *samples, uint32_t count, uint32_t batch, void *data)
+{
+  uint32_t i;
+  (void)data;
+
+  RETARGET_SerialInit();
+  RETARGET_SerialCrLf(1);
+
+  printf("batch %lu, %lu samples, %lu wakeups:", (unsigned long)batch,
+         (unsigned long)count, (unsigned long)EM4NODE_GetWakeCount());
+  for (i = 0; i < count; i++)
+    printf(" %u", samples[i]);
+  printf("\n");
+
+#if defined(RETARGET_USART)
+  while (!(RETARGET_UART->STATUS & USART_STATUS_TXC));
+#endif
+
+  return true;
+}
+
 /**************************************************************************//**
  * @brief
  *    Main function
@@ -401,6 +457,20 @@ int main(void)
    */
   rtccInit(4, wakestate);
 
+  /*
+   * Keep the batch of samples in the RTCC retention registers, which
+   * the RTCC holds through EM4 hibernate at no extra current.  The
+   * batch is kept after an EM4 wake-up and formatted after any other
+   * reset.  Add this wake-up's sample and send the batch if it is due;
+   * a batch that failed to send is kept and sent again the next time.
+   */
+  EM4NODE_Init(&RTCC->RET[0].REG, sizeof(RTCC->RET) / sizeof(RTCC->RET[0]),
+               wakestate, FLUSH_EVERY);
+  EM4NODE_Add(readSensor());
+
+  if (EM4NODE_FlushDue())
+    EM4NODE_Flush(sendBatch, NULL);
+
   /*
    * When developing/debugging code that enters EM4 it is imperative to
    * have an "escape hatch" type of mechanism, e.g. a way to pause the
@@ -0,0 +1,82 @@
+/***************************************************************************//**
+ * @file servo.h
+ *
+ * @brief Time multiplexed servo driver, TIMER0 outputs rerouted by LDMA.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2021 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ******************************************************************************/
+
+#ifndef SERVO_H
+#define SERVO_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "em_gpio.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// LDMA channel that sets up each slot
+#define SERVO_LDMA_CHANNEL    0
+
+// The 20 ms frame is split into slots of 2.5 ms. In each slot CC0 and
+// CC1 each pulse one servo, so up to 16 servos are driven.
+#define SERVO_SLOTS           8
+#define SERVO_OUTPUTS         2
+#define SERVO_MAX_COUNT       (SERVO_SLOTS * SERVO_OUTPUTS)
+#define SERVO_SLOT_US         2500
+
+// Pulse width limits in us. Pulses end before CC2 at SERVO_GUARD_US
+// moves the outputs on to the pins of the next slot.
+#define SERVO_MIN_US          500
+#define SERVO_MAX_US          2300
+#define SERVO_GUARD_US        2400
+
+/*
+ * Pin of a servo. loc is the TIM0_CC0 location of the pin; the driver
+ * works out the TIM0_CC1 location of the same pin for servos on CC1.
+ * Servo n is pulsed in slot n % SERVO_SLOTS by CC(n / SERVO_SLOTS).
+ */
+typedef struct {
+  GPIO_Port_TypeDef port;
+  uint8_t pin;
+  uint8_t loc;
+} SERVO_Pin_t;
+
+void SERVO_Init(const SERVO_Pin_t *pins, uint32_t count);
+void SERVO_SetProfile(uint32_t servo, uint32_t maxSpeed, uint32_t accel);
+void SERVO_MoveTo(uint32_t servo, uint32_t pulseUs);
+void SERVO_SetPulse(uint32_t servo, uint32_t pulseUs);
+uint32_t SERVO_GetPulse(uint32_t servo);
+bool SERVO_IsMoving(uint32_t servo);
+uint32_t SERVO_GetFrameCount(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SERVO_H
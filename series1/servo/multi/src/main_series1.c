@@ -0,0 +1,121 @@
+/***************************************************************************//**
+ * @file main_series1.c
+ * @brief This project demonstrates driving up to 16 servo motors from one
+ * TIMER. The 20 ms servo frame is split into eight slots and in each slot
+ * the LDMA moves the two PWM outputs on to the next pair of servo pins and
+ * loads their pulse widths, so no interrupt is needed per pulse. Smooth
+ * motion profiles are stepped for all servos once per frame.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2021 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ *******************************************************************************
+ * # Evaluation Quality
+ * This code has been minimally tested to ensure that it builds and is suitable 
+ * as a demonstration for evaluation purposes only. This code will be maintained
+ * at the sole discretion of Silicon Labs.
+ ******************************************************************************/
+
+#include "em_device.h"
+#include "em_cmu.h"
+#include "em_emu.h"
+#include "em_chip.h"
+#include "em_gpio.h"
+#include "servo.h"
+
+// Note: change this to the number of servos connected, up to SERVO_MAX_COUNT
+#define SERVO_COUNT 16
+
+#if SERVO_COUNT > SERVO_MAX_COUNT
+#error "SERVO_COUNT must be at most SERVO_MAX_COUNT"
+#endif
+
+// Ends of the sweep in us
+#define SWEEP_LOW   700
+#define SWEEP_HIGH  2300
+
+/*
+ * Servo pins and their TIM0_CC0 locations. The first eight are pulsed by
+ * CC0 and the rest by CC1, one servo of each in every slot.
+ */
+static const SERVO_Pin_t servoPins[SERVO_MAX_COUNT] = {
+  { gpioPortC, 6,  11 },
+  { gpioPortC, 7,  12 },
+  { gpioPortC, 8,  13 },
+  { gpioPortC, 9,  14 },
+  { gpioPortC, 10, 15 },
+  { gpioPortC, 11, 16 },
+  { gpioPortB, 11, 6  },
+  { gpioPortB, 12, 7  },
+  { gpioPortB, 13, 8  },
+  { gpioPortB, 14, 9  },
+  { gpioPortB, 15, 10 },
+  { gpioPortD, 13, 21 },
+  { gpioPortD, 14, 22 },
+  { gpioPortD, 15, 23 },
+  { gpioPortA, 2,  2  },
+  { gpioPortA, 3,  3  },
+};
+
+/**************************************************************************//**
+ * @brief
+ *    Main function
+ *****************************************************************************/
+int main(void)
+{
+  bool high[SERVO_COUNT];
+  uint32_t frame = 0;
+
+  // Chip errata
+  CHIP_Init();
+
+  // Init DCDC regulator with kit specific parameters
+  EMU_DCDCInit_TypeDef dcdcInit = EMU_DCDCINIT_DEFAULT;
+  EMU_DCDCInit(&dcdcInit);
+
+  // Initializations
+  SERVO_Init(servoPins, SERVO_COUNT);
+
+  // Slower servos further down the list, so the motion fans out
+  for (uint32_t i = 0; i < SERVO_COUNT; i++) {
+    SERVO_SetProfile(i, 2000 - 100 * i, 4000);
+    high[i] = false;
+  }
+
+  while (1) {
+    // The LDMA interrupts once per frame, check the servos each time
+    while (SERVO_GetFrameCount() == frame) {
+      EMU_EnterEM1();
+    }
+    frame = SERVO_GetFrameCount();
+
+    // Send each servo that has arrived to the other end
+    for (uint32_t i = 0; i < SERVO_COUNT; i++) {
+      if (!SERVO_IsMoving(i)) {
+        high[i] = !high[i];
+        SERVO_MoveTo(i, high[i] ? SWEEP_HIGH : SWEEP_LOW);
+      }
+    }
+  }
+}
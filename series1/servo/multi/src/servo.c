@@ -0,0 +1,408 @@
+/***************************************************************************//**
+ * @file servo.c
+ *
+ * @brief Time multiplexed servo driver, TIMER0 outputs rerouted by LDMA.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2021 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ *******************************************************************************
+ * # Evaluation Quality
+ * This code has been minimally tested to ensure that it builds and is suitable 
+ * as a demonstration for evaluation purposes only. This code will be maintained
+ * at the sole discretion of Silicon Labs.
+ ******************************************************************************/
+
+#include "em_device.h"
+#include "em_cmu.h"
+#include "em_core.h"
+#include "em_gpio.h"
+#include "em_ldma.h"
+#include "em_timer.h"
+
+#include "servo.h"
+
+// CC2 needs no pin; its compare event in each slot is the LDMA request
+#define GUARD_CC            2
+#define GUARD_SIGNAL        ldmaPeripheralSignal_TIMER0_CC2
+
+#define FRAME_DONE          ((1 << SERVO_LDMA_CHANNEL) << _LDMA_IFC_DONE_SHIFT)
+
+// Frames per second, for the profile units
+#define FRAME_RATE          (1000000 / (SERVO_SLOTS * SERVO_SLOT_US))
+
+// Positions, speeds and accelerations are kept in 1/256 us per frame
+#define Q                   8
+
+/*
+ * What the LDMA writes at the guard compare of each slot: the route of
+ * CC0 and CC1 for the next slot, and their compare buffers, which the
+ * timer loads at the overflow starting that slot. The outputs are low by
+ * then, so moving them to other pins does not cut a pulse short.
+ */
+typedef struct {
+  uint32_t route;
+  uint32_t pulse[SERVO_OUTPUTS];
+} Slot_t;
+
+static Slot_t slots[SERVO_SLOTS];
+static LDMA_Descriptor_t desc[SERVO_SLOTS][1 + SERVO_OUTPUTS];
+
+// Motion state of each servo, stepped once per frame
+static int32_t position[SERVO_MAX_COUNT];
+static int32_t velocity[SERVO_MAX_COUNT];
+static int32_t target[SERVO_MAX_COUNT];
+static int32_t maxVelocity[SERVO_MAX_COUNT];
+static int32_t acceleration[SERVO_MAX_COUNT];
+
+static uint32_t servoCount;
+static uint32_t timerFreq;
+static volatile uint32_t frames;
+
+/**************************************************************************//**
+ * @brief
+ *   Timer ticks of a time in 1/256 us
+ *****************************************************************************/
+static uint32_t toTicks(int32_t time)
+{
+  return (uint32_t)(((uint64_t)time * timerFreq) / (1000000ULL << Q));
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Clamp a pulse width in us to the limits, in 1/256 us
+ *****************************************************************************/
+static int32_t toPosition(uint32_t pulseUs)
+{
+  if (pulseUs < SERVO_MIN_US) {
+    pulseUs = SERVO_MIN_US;
+  } else if (pulseUs > SERVO_MAX_US) {
+    pulseUs = SERVO_MAX_US;
+  }
+
+  return (int32_t)(pulseUs << Q);
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Move a servo on by one frame
+ *
+ * @details
+ *   Trapezoidal profile: accelerate towards the target up to the maximum
+ *   speed, and brake once the distance left is what it takes to stop.
+ *   Without an acceleration the servo goes straight to the target.
+ *****************************************************************************/
+static void stepProfile(uint32_t n)
+{
+  int32_t dist = target[n] - position[n];
+  int32_t v = velocity[n];
+  int32_t a = acceleration[n];
+  int32_t dir, left;
+  int64_t braking;
+
+  if ((dist == 0) && (v == 0)) {
+    return;
+  }
+
+  if (a == 0) {
+    position[n] = target[n];
+    velocity[n] = 0;
+    return;
+  }
+
+  // Towards the target, or against the motion when already on it
+  if (dist != 0) {
+    dir = (dist > 0) ? 1 : -1;
+  } else {
+    dir = (v > 0) ? -1 : 1;
+  }
+
+  braking = ((int64_t)v * v) / (2 * a);
+  if ((v * dir < 0) || (braking < dist * dir)) {
+    v += dir * a;
+  } else if (v > a) {
+    v -= a;
+  } else if (v < -a) {
+    v += a;
+  } else {
+    v = dir * a;
+  }
+
+  if (v > maxVelocity[n]) {
+    v = maxVelocity[n];
+  } else if (v < -maxVelocity[n]) {
+    v = -maxVelocity[n];
+  }
+
+  position[n] += v;
+  velocity[n] = v;
+
+  // Arrived, about to overshoot or crawling within a step of the target
+  left = target[n] - position[n];
+  if ((dist != 0) && ((left == 0) || ((left > 0) != (dist > 0)))) {
+    position[n] = target[n];
+    velocity[n] = 0;
+  } else if ((left * dir <= a) && (v * dir <= a) && (v * dir >= 0)) {
+    position[n] = target[n];
+    velocity[n] = 0;
+  }
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Step all servos and write the compare values of the next frame
+ *****************************************************************************/
+static void updateFrame(void)
+{
+  for (uint32_t n = 0; n < servoCount; n++) {
+    stepProfile(n);
+    slots[n % SERVO_SLOTS].pulse[n / SERVO_SLOTS] = toTicks(position[n]);
+  }
+}
+
+/**************************************************************************//**
+ * @brief LDMA Handler
+ *****************************************************************************/
+void LDMA_IRQHandler(void)
+{
+  uint32_t pending = LDMA_IntGetEnabled();
+
+  if (pending & LDMA_IF_ERROR) {
+    __BKPT(0);
+  }
+
+  // Once per frame, after the last slot has been set up. The first slot
+  // of the next frame is set up one slot later.
+  if (pending & FRAME_DONE) {
+    LDMA_IntClear(FRAME_DONE);
+    frames++;
+    updateFrame();
+  }
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Start driving servos
+ *
+ * @details
+ *   All servos start centred at 1500 us with no motion profile. Slots with
+ *   no servo on an output keep a compare value of 0, which holds the
+ *   output low.
+ *
+ * @param[in] pins
+ *   Pin of each servo. Servos on CC0 and on CC1 must use pins that have
+ *   a location for that channel.
+ *
+ * @param[in] count
+ *   Number of servos, up to SERVO_MAX_COUNT.
+ *****************************************************************************/
+void SERVO_Init(const SERVO_Pin_t *pins, uint32_t count)
+{
+  TIMER_Init_TypeDef timerInit = TIMER_INIT_DEFAULT;
+  TIMER_InitCC_TypeDef pwmInit = TIMER_INITCC_DEFAULT;
+  TIMER_InitCC_TypeDef guardInit = TIMER_INITCC_DEFAULT;
+  LDMA_Init_t ldmaInit = LDMA_INIT_DEFAULT;
+  LDMA_TransferCfg_t cfg = LDMA_TRANSFER_CFG_PERIPHERAL(GUARD_SIGNAL);
+  uint32_t n, s, loc;
+
+  if (count > SERVO_MAX_COUNT) {
+    count = SERVO_MAX_COUNT;
+  }
+  servoCount = count;
+
+  CMU_ClockEnable(cmuClock_GPIO, true);
+  CMU_ClockEnable(cmuClock_TIMER0, true);
+  timerFreq = CMU_ClockFreqGet(cmuClock_TIMER0) / 8;
+
+  for (s = 0; s < SERVO_SLOTS; s++) {
+    slots[s].route = 0;
+    slots[s].pulse[0] = 0;
+    slots[s].pulse[1] = 0;
+  }
+
+  for (n = 0; n < count; n++) {
+    GPIO_PinModeSet(pins[n].port, pins[n].pin, gpioModePushPull, 0);
+
+    // TIM0_CC1 location n is the pin of TIM0_CC0 location n + 1
+    if (n < SERVO_SLOTS) {
+      loc = pins[n].loc;
+      slots[n].route |= loc << _TIMER_ROUTELOC0_CC0LOC_SHIFT;
+    } else {
+      loc = (pins[n].loc + 31) % 32;
+      slots[n - SERVO_SLOTS].route |= loc << _TIMER_ROUTELOC0_CC1LOC_SHIFT;
+    }
+
+    position[n] = toPosition(1500);
+    target[n] = position[n];
+    velocity[n] = 0;
+    maxVelocity[n] = 0;
+    acceleration[n] = 0;
+  }
+  updateFrame();
+
+  // One chain of descriptors per slot, the first waits for the guard
+  // compare and the others follow straight on
+  for (s = 0; s < SERVO_SLOTS; s++) {
+    desc[s][0] = (LDMA_Descriptor_t)
+      LDMA_DESCRIPTOR_LINKREL_M2P_BYTE(&slots[s].route, &TIMER0->ROUTELOC0, 1, 1);
+    for (n = 0; n < SERVO_OUTPUTS; n++) {
+      desc[s][n + 1] = (LDMA_Descriptor_t)
+        LDMA_DESCRIPTOR_LINKREL_M2P_BYTE(&slots[s].pulse[n], &TIMER0->CC[n].CCVB, 1, 1);
+      desc[s][n + 1].xfer.structReq = 1;
+    }
+    for (n = 0; n <= SERVO_OUTPUTS; n++) {
+      desc[s][n].xfer.size = ldmaCtrlSizeWord;
+      desc[s][n].xfer.doneIfs = 0;
+    }
+  }
+
+  // The last descriptor links back to the first and marks the frame
+  desc[SERVO_SLOTS - 1][SERVO_OUTPUTS].xfer.linkAddr =
+    -(int32_t)((SERVO_SLOTS * (1 + SERVO_OUTPUTS) - 1) * LDMA_DESCRIPTOR_NDWORDS);
+  desc[SERVO_SLOTS - 1][SERVO_OUTPUTS].xfer.doneIfs = 1;
+
+  // Slots of 2.5 ms; PWM on CC0 and CC1, plain compare on CC2. The guard
+  // compare request is cleared by the LDMA, not by a compare buffer write.
+  pwmInit.mode = timerCCModePWM;
+  guardInit.mode = timerCCModeCompare;
+  TIMER_InitCC(TIMER0, 0, &pwmInit);
+  TIMER_InitCC(TIMER0, 1, &pwmInit);
+  TIMER_InitCC(TIMER0, GUARD_CC, &guardInit);
+
+  TIMER_TopSet(TIMER0, toTicks(SERVO_SLOT_US << Q) - 1);
+  TIMER_CompareSet(TIMER0, 0, 0);
+  TIMER_CompareSet(TIMER0, 1, 0);
+  TIMER_CompareSet(TIMER0, GUARD_CC, toTicks(SERVO_GUARD_US << Q));
+
+  TIMER0->ROUTELOC0 = slots[0].route;
+  TIMER0->ROUTEPEN = TIMER_ROUTEPEN_CC0PEN
+                     | ((count > SERVO_SLOTS) ? TIMER_ROUTEPEN_CC1PEN : 0);
+
+  LDMA_Init(&ldmaInit);
+  LDMA_StartTransfer(SERVO_LDMA_CHANNEL, &cfg, &desc[0][0]);
+
+  timerInit.prescale = timerPrescale8;
+  timerInit.dmaClrAct = true;
+  TIMER_Init(TIMER0, &timerInit);
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Set how fast a servo moves to new targets
+ *
+ * @param[in] maxSpeed
+ *   Top speed in us of pulse width per second.
+ *
+ * @param[in] accel
+ *   Acceleration and braking in us per second squared. 0 makes the servo
+ *   jump to each new target.
+ *****************************************************************************/
+void SERVO_SetProfile(uint32_t servo, uint32_t maxSpeed, uint32_t accel)
+{
+  int32_t v = (int32_t)((maxSpeed << Q) / FRAME_RATE);
+  int32_t a = (int32_t)((accel << Q) / (FRAME_RATE * FRAME_RATE));
+
+  if (servo >= servoCount) {
+    return;
+  }
+
+  // Keep a slow profile slow rather than turning it off
+  if ((accel != 0) && (a == 0)) {
+    a = 1;
+  }
+  if (v < a) {
+    v = a;
+  }
+
+  CORE_DECLARE_IRQ_STATE;
+  CORE_ENTER_CRITICAL();
+  maxVelocity[servo] = v;
+  acceleration[servo] = a;
+  CORE_EXIT_CRITICAL();
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Move a servo to a pulse width in us along its profile
+ *****************************************************************************/
+void SERVO_MoveTo(uint32_t servo, uint32_t pulseUs)
+{
+  if (servo < servoCount) {
+    target[servo] = toPosition(pulseUs);
+  }
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Set the pulse width of a servo in us from the next frame on, without
+ *   going through its profile
+ *****************************************************************************/
+void SERVO_SetPulse(uint32_t servo, uint32_t pulseUs)
+{
+  if (servo >= servoCount) {
+    return;
+  }
+
+  CORE_DECLARE_IRQ_STATE;
+  CORE_ENTER_CRITICAL();
+  target[servo] = toPosition(pulseUs);
+  position[servo] = target[servo];
+  velocity[servo] = 0;
+  CORE_EXIT_CRITICAL();
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Pulse width of a servo in us as sent in the current frame
+ *****************************************************************************/
+uint32_t SERVO_GetPulse(uint32_t servo)
+{
+  if (servo >= servoCount) {
+    return 0;
+  }
+
+  return (uint32_t)(position[servo] >> Q);
+}
+
+/**************************************************************************//**
+ * @brief
+ *   True until a servo has reached its target
+ *****************************************************************************/
+bool SERVO_IsMoving(uint32_t servo)
+{
+  if (servo >= servoCount) {
+    return false;
+  }
+
+  return position[servo] != target[servo];
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Frames sent since SERVO_Init(), one every 20 ms
+ *****************************************************************************/
+uint32_t SERVO_GetFrameCount(void)
+{
+  return frames;
+}
@@ -44,6 +44,7 @@
 #include "em_gpio.h"
 #include "em_timer.h"
 #include "bsp.h"
+#include "lpdelay.h"
 
 // Note: change this to set the desired output frequency in Hz
 #define PWM_FREQ 50
@@ -51,10 +52,6 @@
 // Note: change this to set the desired duty cycle (used to update CCVB value)
 static volatile int dutyCyclePercent = 30;
 
-// stores 1 msTicks from the SysTick timer
-volatile uint32_t msTicks;
-
-
 /**************************************************************************//**
  * @brief
  *    Interrupt handler for TIMER1 that changes the duty cycle
@@ -123,27 +120,6 @@ void initTimer(void)
   NVIC_EnableIRQ(TIMER1_IRQn);
 }
 
-/**************************************************************************//**
- * @brief SysTick_Handler
- * Interrupt Service Routine for system tick counter
- *****************************************************************************/
-void SysTick_Handler(void)
-{
-  msTicks++;       // increment counter necessary in Delay()
-}
-
-/**************************************************************************//**
- * @brief Delays number of msTick Systicks (typically 1 ms)
- * @param dlyTicks Number of ticks to delay
- *****************************************************************************/
-void Delay(uint32_t dlyTicks)
-{
-  uint32_t curTicks;
-
-  curTicks = msTicks;
-  while ((msTicks - curTicks) < dlyTicks) ;
-}
-
 /**************************************************************************//**
  * @brief
  *    Main function
@@ -161,21 +137,21 @@ int main(void)
   initGpio();
   initTimer();
 
-  // Setup SysTick Timer for 1 msec interrupts
-  if (SysTick_Config(CMU_ClockFreqGet(cmuClock_CORE) / 1000)) while (1) ;
+  // Sleep through the delays in EM1, the TIMER stops in EM2
+  LPDELAY_Init(false);
 
   while (1)
   {
     for(int i = 0; i < 20; i++)
     {
     	dutyCyclePercent = i;
-    	Delay(60);
+    	LPDELAY_Ms(60);
     }
 
     for(int i = 20; i >= 0; i--)
     {
     	dutyCyclePercent = i;
-    	Delay(60);
+    	LPDELAY_Ms(60);
     }
   }
 }
@@ -0,0 +1,366 @@
+/***************************************************************************//**
+ * @file main.c
+ * @brief Measures the interrupt latency and its jitter from a TIMER compare
+ * match to the first store of the handler, with the vector table and the
+ * handler in flash and in RAM, with and without FPU context and at several
+ * core clocks. See readme.txt for details.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2020 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ *******************************************************************************
+ * # Evaluation Quality
+ * This code has been minimally tested to ensure that it builds and is suitable 
+ * as a demonstration for evaluation purposes only. This code will be maintained
+ * at the sole discretion of Silicon Labs.
+ ******************************************************************************/
+
+#include "em_device.h"
+#include "em_chip.h"
+#include "em_cmu.h"
+#include "em_emu.h"
+#include "em_gpio.h"
+#include "em_prs.h"
+#include "em_ramfunc.h"
+#include "em_timer.h"
+#include "bsp.h"
+#include "ramvectors.h"
+
+/*******************************************************************************
+ *******************************   DEFINES   ***********************************
+ ******************************************************************************/
+
+// Compare matches measured per configuration
+#define RUN_SAMPLES               1000
+
+// TIMER0 counts ahead of the compare match when it is set
+#define COMPARE_LEAD              200
+
+/*
+ * The compare output of TIMER0 CC0 toggles PC10 (location 15) at the match,
+ * the handler toggles LED0, and the PRS takes LED0 to the input capture of
+ * CC1.
+ */
+#define COMPARE_PORT              gpioPortC
+#define COMPARE_PIN               10
+#define COMPARE_LOCATION          TIMER_ROUTELOC0_CC0LOC_LOC15
+#define ISR_PORT                  BSP_GPIO_LED0_PORT
+#define ISR_PIN                   BSP_GPIO_LED0_PIN
+#define ISR_PRS_CHANNEL           0
+
+// FPU context of the interrupted code
+#define FP_NONE                   0   // No FPU context active
+#define FP_LAZY                   1   // Active, lazy stacking
+#define FP_FULL                   2   // Active, stacked on entry
+
+#define NUM_CLOCKS                3
+#define NUM_PLACEMENTS            3
+#define NUM_FP_MODES              3
+#define NUM_RUNS                  (NUM_CLOCKS * NUM_PLACEMENTS * NUM_FP_MODES)
+
+/*******************************************************************************
+ ***************************   GLOBAL VARIABLES   *******************************
+ ******************************************************************************/
+
+// Latency of one configuration
+typedef struct {
+  uint32_t coreHz;          // Core and TIMER0 clock
+  bool ramVectors;          // Vector table in RAM, else in flash
+  bool ramHandler;          // Handler in RAM, else in flash
+  uint8_t fpContext;        // FP_NONE, FP_LAZY or FP_FULL
+  uint32_t samples;         // Compare matches in the statistics
+  uint32_t cyclesMin;       // Compare match to the handler toggling LED0
+  uint32_t cyclesMax;
+  float cyclesMean;
+  uint32_t jitter;          // cyclesMax - cyclesMin
+  float latencyMin;         // The same in ns
+  float latencyMean;
+  float latencyMax;
+} LatencyResult_t;
+
+typedef struct {
+  bool ramVectors;
+  bool ramHandler;
+} Placement_t;
+
+static const CMU_HFRCOFreq_TypeDef clocks[NUM_CLOCKS] = {
+  cmuHFRCOFreq_19M0Hz, cmuHFRCOFreq_26M0Hz, cmuHFRCOFreq_38M0Hz
+};
+
+static const Placement_t placements[NUM_PLACEMENTS] = {
+  { false, false }, { true, false }, { true, true }
+};
+
+static volatile LatencyResult_t results[NUM_RUNS];
+
+// Passes completed over all configurations
+static volatile uint32_t passes;
+
+// Set by the handler
+static volatile bool handled;
+
+// Operand of the floating point operation that makes the FPU context active
+static volatile float fpWork = 1.0f;
+
+/**************************************************************************//**
+ * @brief
+ *    TIMER0 handler in flash, in the vector table of the startup code
+ *
+ * @details
+ *    LED0 is toggled first, its edge is the end of the latency. Registers
+ *    are written directly, as in the RAM handler below, which must not call
+ *    functions in flash.
+ *****************************************************************************/
+void TIMER0_IRQHandler(void)
+{
+  GPIO->P[ISR_PORT].DOUTTGL = 1 << ISR_PIN;
+  TIMER0->IFC = TIMER_IFC_CC0;
+  handled = true;
+}
+
+/**************************************************************************//**
+ * @brief
+ *    TIMER0 handler in RAM, installed in the RAM vector table
+ *****************************************************************************/
+SL_RAMFUNC_DEFINITION_BEGIN
+static void ramTimerHandler(void)
+{
+  GPIO->P[ISR_PORT].DOUTTGL = 1 << ISR_PIN;
+  TIMER0->IFC = TIMER_IFC_CC0;
+  handled = true;
+}
+SL_RAMFUNC_DEFINITION_END
+
+/**************************************************************************//**
+ * @brief
+ *    Set up the pins and the PRS from LED0 to TIMER0
+ *
+ * @details
+ *    The LED0 pin is configured as an external interrupt with no edge
+ *    enabled, which selects its port for the PRS signal. The PRS source
+ *    splits the lower (0-7) and higher (8-15) GPIO pins.
+ *****************************************************************************/
+static void initGpioPrs(void)
+{
+  CMU_ClockEnable(cmuClock_GPIO, true);
+  CMU_ClockEnable(cmuClock_PRS, true);
+
+  GPIO_PinModeSet(COMPARE_PORT, COMPARE_PIN, gpioModePushPull, 0);
+  GPIO_PinModeSet(ISR_PORT, ISR_PIN, gpioModePushPull, 0);
+  GPIO_ExtIntConfig(ISR_PORT, ISR_PIN, ISR_PIN, false, false, false);
+
+  if (ISR_PIN < 8) {
+    PRS_SourceAsyncSignalSet(ISR_PRS_CHANNEL, PRS_CH_CTRL_SOURCESEL_GPIOL,
+                             ISR_PIN);
+  } else {
+    PRS_SourceAsyncSignalSet(ISR_PRS_CHANNEL, PRS_CH_CTRL_SOURCESEL_GPIOH,
+                             ISR_PIN - 8);
+  }
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Start TIMER0 counting the core clock
+ *
+ * @details
+ *    CC0 compares and toggles its output at the match, CC1 captures both
+ *    edges of LED0.
+ *****************************************************************************/
+static void initTimer(void)
+{
+  TIMER_Init_TypeDef timerInit = TIMER_INIT_DEFAULT;
+  TIMER_InitCC_TypeDef compareInit = TIMER_INITCC_DEFAULT;
+  TIMER_InitCC_TypeDef captureInit = TIMER_INITCC_DEFAULT;
+
+  CMU_ClockEnable(cmuClock_HFPER, true);
+  CMU_ClockEnable(cmuClock_TIMER0, true);
+
+  timerInit.enable = false;
+  TIMER_Init(TIMER0, &timerInit);
+
+  compareInit.mode = timerCCModeCompare;
+  compareInit.cmoa = timerOutputActionToggle;
+  TIMER_InitCC(TIMER0, 0, &compareInit);
+
+  captureInit.mode = timerCCModeCapture;
+  captureInit.edge = timerEdgeBoth;
+  captureInit.prsInput = true;
+  captureInit.prsSel = (TIMER_PRSSEL_TypeDef)ISR_PRS_CHANNEL;
+  TIMER_InitCC(TIMER0, 1, &captureInit);
+
+  TIMER0->ROUTELOC0 = (TIMER0->ROUTELOC0 & ~_TIMER_ROUTELOC0_CC0LOC_MASK)
+                      | COMPARE_LOCATION;
+  TIMER0->ROUTEPEN |= TIMER_ROUTEPEN_CC0PEN;
+
+  TIMER_TopSet(TIMER0, TIMER_MaxCount(TIMER0));
+  TIMER_IntClear(TIMER0, _TIMER_IF_MASK);
+  TIMER_IntEnable(TIMER0, TIMER_IEN_CC0);
+  NVIC_ClearPendingIRQ(TIMER0_IRQn);
+  NVIC_EnableIRQ(TIMER0_IRQn);
+
+  TIMER_Enable(TIMER0, true);
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Place the vector table and the handler
+ *****************************************************************************/
+static void setPlacement(bool ramVectors, bool ramHandler)
+{
+  if (ramVectors) {
+    RAMVECTORS_Init();
+    RAMVECTORS_SetHandler(TIMER0_IRQn,
+                          ramHandler ? ramTimerHandler : TIMER0_IRQHandler);
+  } else {
+    RAMVECTORS_Deinit();
+  }
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Set up the FPU context the interrupt finds
+ *
+ * @details
+ *    With lazy stacking the exception entry only reserves room for the
+ *    floating point registers and stores them when the handler uses the
+ *    FPU, which this one does not. Without it, the entry stores them
+ *    whenever the interrupted code has an active FPU context.
+ *****************************************************************************/
+static void setFpContext(uint8_t fpContext)
+{
+  if (fpContext == FP_FULL) {
+    FPU->FPCCR &= ~FPU_FPCCR_LSPEN_Msk;
+  } else {
+    FPU->FPCCR |= FPU_FPCCR_LSPEN_Msk;
+  }
+
+  // Drop the FPU context, a floating point operation makes it active again
+  __set_CONTROL(__get_CONTROL() & ~CONTROL_FPCA_Msk);
+  __ISB();
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Measure one configuration
+ *
+ * @details
+ *    Each compare match is set COMPARE_LEAD counts ahead and the CPU waits
+ *    for the handler in a loop, as a control loop waiting for its next
+ *    period would. The latency is the LED0 edge captured by CC1 less the
+ *    compare value, in TIMER0 counts, which are core cycles. Only integer
+ *    operations run between the samples, so the FPU context stays as set.
+ *
+ * @param[in] r
+ *    Configuration, its statistics are filled in
+ *****************************************************************************/
+static void measure(volatile LatencyResult_t *r)
+{
+  uint32_t mask = TIMER_MaxCount(TIMER0);
+  uint32_t compare, cycles, i;
+  uint32_t min = 0xFFFFFFFF, max = 0;
+  uint64_t sum = 0;
+
+  setPlacement(r->ramVectors, r->ramHandler);
+  setFpContext(r->fpContext);
+
+  for (i = 0; i < RUN_SAMPLES; i++) {
+    // Empty the capture buffer
+    while (TIMER0->STATUS & TIMER_STATUS_ICV1) {
+      TIMER_CaptureGet(TIMER0, 1);
+    }
+
+    if (r->fpContext != FP_NONE) {
+      fpWork = fpWork * 1.0f;
+    }
+
+    handled = false;
+    compare = (TIMER_CounterGet(TIMER0) + COMPARE_LEAD) & mask;
+    TIMER_CompareSet(TIMER0, 0, compare);
+
+    while (!handled) {
+    }
+    while (!(TIMER0->STATUS & TIMER_STATUS_ICV1)) {
+    }
+
+    cycles = (TIMER_CaptureGet(TIMER0, 1) - compare) & mask;
+    sum += cycles;
+    if (cycles < min) {
+      min = cycles;
+    }
+    if (cycles > max) {
+      max = cycles;
+    }
+  }
+
+  r->samples = RUN_SAMPLES;
+  r->cyclesMin = min;
+  r->cyclesMax = max;
+  r->cyclesMean = (float)sum / RUN_SAMPLES;
+  r->jitter = max - min;
+  r->latencyMin = min * 1e9f / r->coreHz;
+  r->latencyMean = r->cyclesMean * 1e9f / r->coreHz;
+  r->latencyMax = max * 1e9f / r->coreHz;
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Main function
+ *****************************************************************************/
+int main(void)
+{
+  volatile LatencyResult_t *r;
+  int c, p, f;
+
+  CHIP_Init();
+
+#ifdef EMU_DCDCINIT_DEFAULT
+  // Init DCDC regulator with kit specific parameters
+  EMU_DCDCInit_TypeDef dcdcInit = EMU_DCDCINIT_DEFAULT;
+  EMU_DCDCInit(&dcdcInit);
+#endif
+
+  initGpioPrs();
+  initTimer();
+
+  // Measure all configurations, over and over
+  while (1) {
+    r = results;
+    for (c = 0; c < NUM_CLOCKS; c++) {
+      // Emlib sets the flash wait states with the clock
+      CMU_HFRCOBandSet(clocks[c]);
+
+      for (p = 0; p < NUM_PLACEMENTS; p++) {
+        for (f = 0; f < NUM_FP_MODES; f++) {
+          r->coreHz = SystemCoreClockGet();
+          r->ramVectors = placements[p].ramVectors;
+          r->ramHandler = placements[p].ramHandler;
+          r->fpContext = f;
+          measure(r);
+          r++;
+        }
+      }
+    }
+    passes++;
+  }
+}
@@ -0,0 +1,112 @@
+/***************************************************************************//**
+ * @file spiseq.h
+ *
+ * @brief SPI master frame sequencer. A sequence of short frames, each with
+ * its own chip select assertion, is built once into one LDMA descriptor
+ * chain that also drives the chip select pin, and then runs back to back
+ * with no CPU work between the frames.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2022 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ******************************************************************************/
+
+#ifndef SPISEQ_H
+#define SPISEQ_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "em_device.h"
+#include "em_ldma.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if defined(_SILICON_LABS_32B_SERIES_1_CONFIG_2)
+// USART2 at location 1, PA6 (MOSI), PA7 (MISO), PA8 (CLK), CS on PA9
+#define SPISEQ_USART          USART2
+#define SPISEQ_USART_CLOCK    cmuClock_USART2
+#define SPISEQ_PORT           gpioPortA
+#define SPISEQ_LOCATION       1
+#define SPISEQ_RX_SIGNAL      ldmaPeripheralSignal_USART2_RXDATAV
+#define SPISEQ_TX_SIGNAL      ldmaPeripheralSignal_USART2_TXEMPTY
+#else
+// USART1 at location 11, PC6 (MOSI), PC7 (MISO), PC8 (CLK), CS on PC9
+#define SPISEQ_USART          USART1
+#define SPISEQ_USART_CLOCK    cmuClock_USART1
+#define SPISEQ_PORT           gpioPortC
+#define SPISEQ_LOCATION       11
+#define SPISEQ_RX_SIGNAL      ldmaPeripheralSignal_USART1_RXDATAV
+#define SPISEQ_TX_SIGNAL      ldmaPeripheralSignal_USART1_TXEMPTY
+#endif
+
+#define SPISEQ_MOSI_PIN       6
+#define SPISEQ_MISO_PIN       7
+#define SPISEQ_CLK_PIN        8
+#define SPISEQ_CS_PIN         9
+
+// LDMA channels for the chain of frames and for the received bytes
+#define SPISEQ_LDMA_CHANNEL_TX  0
+#define SPISEQ_LDMA_CHANNEL_RX  1
+
+// Frames in one sequence, each takes three descriptors
+#ifndef SPISEQ_MAX_FRAMES
+#define SPISEQ_MAX_FRAMES     16
+#endif
+
+// Bytes in one sequence, the 2048 transfers of the one RX descriptor
+#define SPISEQ_MAX_BYTES      2048
+
+// One chip select assertion: length bytes are sent and as many received
+typedef struct {
+  const uint8_t *tx;                  // Data to send, such as a register
+                                      // address followed by dummy bytes
+  uint16_t length;                    // Number of bytes, at least 1
+} SPISEQ_Frame_t;
+
+// Called from the LDMA interrupt once the last frame has ended
+typedef void (*SPISEQ_Callback_t)(void *user);
+
+// A built sequence, reusable until it is built again
+typedef struct {
+  LDMA_Descriptor_t tx[3 * SPISEQ_MAX_FRAMES];  // CS low, data, CS high
+  LDMA_Descriptor_t rx;               // All received bytes, in frame order
+  uint32_t frames;                    // Number of frames
+  uint32_t bytes;                     // Number of bytes of all frames
+} SPISEQ_Sequence_t;
+
+void SPISEQ_Init(uint32_t baudrate);
+bool SPISEQ_Build(SPISEQ_Sequence_t *seq, const SPISEQ_Frame_t *frames,
+                  uint32_t count, uint8_t *rx);
+bool SPISEQ_Start(const SPISEQ_Sequence_t *seq, SPISEQ_Callback_t callback,
+                  void *user);
+bool SPISEQ_IsIdle(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SPISEQ_H
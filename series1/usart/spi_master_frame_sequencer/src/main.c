@@ -0,0 +1,139 @@
+/***************************************************************************//**
+ * @file main.c
+ * @brief Reads several register blocks of an SPI sensor every 10 ms with one
+ * LDMA descriptor chain that frames each block with its own chip select.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2022 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ *******************************************************************************
+ * # Evaluation Quality
+ * This code has been minimally tested to ensure that it builds and is suitable 
+ * as a demonstration for evaluation purposes only. This code will be maintained
+ * at the sole discretion of Silicon Labs.
+ ******************************************************************************/
+
+#include <stddef.h>
+
+#include "em_device.h"
+#include "em_chip.h"
+#include "em_cmu.h"
+#include "em_emu.h"
+#include "em_usart.h"
+
+#include "spiseq.h"
+
+// SCLK frequency
+#define SPI_BAUDRATE        2000000
+
+// Sensor register reads, the read bit is set in the address byte and the
+// register address increments while CS stays low. Adjust to the device.
+#define SENSOR_READ         0x80
+#define SENSOR_REG_ID       0x00
+#define SENSOR_REG_ACCEL    0x2D
+#define SENSOR_REG_GYRO     0x33
+#define SENSOR_REG_TEMP     0x39
+
+// Address byte followed by one dummy byte per data byte
+static const uint8_t readId[]    = { SENSOR_READ | SENSOR_REG_ID, 0 };
+static const uint8_t readAccel[] = { SENSOR_READ | SENSOR_REG_ACCEL, 0, 0, 0, 0, 0, 0 };
+static const uint8_t readGyro[]  = { SENSOR_READ | SENSOR_REG_GYRO, 0, 0, 0, 0, 0, 0 };
+static const uint8_t readTemp[]  = { SENSOR_READ | SENSOR_REG_TEMP, 0, 0 };
+
+static const SPISEQ_Frame_t frames[] = {
+  { readId, sizeof(readId) },
+  { readAccel, sizeof(readAccel) },
+  { readGyro, sizeof(readGyro) },
+  { readTemp, sizeof(readTemp) },
+};
+
+#define FRAME_COUNT   (sizeof(frames) / sizeof(frames[0]))
+#define RX_BUFFER_SIZE  (sizeof(readId) + sizeof(readAccel) \
+                         + sizeof(readGyro) + sizeof(readTemp))
+
+static SPISEQ_Sequence_t sequence;
+
+// Received bytes of all frames, each frame starts with the byte received
+// during its address byte
+uint8_t RxBuffer[RX_BUFFER_SIZE];
+
+// Statistics, watch in the debugger
+volatile uint32_t sequences;      // Sequences completed
+volatile uint32_t missed;         // Ticks at which a sequence still ran
+volatile uint32_t busCycles;      // Core cycles of the last sequence
+uint32_t idealCycles;             // Core cycles of the bytes alone
+
+static uint32_t startCycles;
+
+/**************************************************************************//**
+ * @brief
+ *    Sequence completed, called from the LDMA interrupt
+ *****************************************************************************/
+static void sequenceDone(void *user)
+{
+  (void)user;
+
+  busCycles = DWT->CYCCNT - startCycles;
+  sequences++;
+}
+
+/**************************************************************************//**
+ * @brief
+ *    SysTick interrupt handler, starts a sequence every 10 ms
+ *****************************************************************************/
+void SysTick_Handler(void)
+{
+  startCycles = DWT->CYCCNT;
+  if (!SPISEQ_Start(&sequence, sequenceDone, NULL)) {
+    missed++;
+  }
+}
+
+/**************************************************************************//**
+ * @brief Main function
+ *****************************************************************************/
+int main(void)
+{
+  // Initialize chip
+  CHIP_Init();
+
+  // Cycle counter for the sequence time
+  CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+  DWT->CYCCNT = 0;
+  DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+  SPISEQ_Init(SPI_BAUDRATE);
+  SPISEQ_Build(&sequence, frames, FRAME_COUNT, RxBuffer);
+
+  // What the bytes take on the bus at the actual SCLK, without any gap
+  idealCycles = (CMU_ClockFreqGet(cmuClock_CORE) / 1000) * 8 * RX_BUFFER_SIZE
+                / (USART_BaudrateGet(SPISEQ_USART) / 1000);
+
+  SysTick_Config(CMU_ClockFreqGet(cmuClock_CORE) / 100);
+
+  // The LDMA and the USART need the HF clocks
+  while (1) {
+    EMU_EnterEM1();
+  }
+}
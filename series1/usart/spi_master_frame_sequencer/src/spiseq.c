@@ -0,0 +1,262 @@
+/***************************************************************************//**
+ * @file spiseq.c
+ *
+ * @brief SPI master frame sequencer.
+ *
+ * The TX channel runs one descriptor chain for the whole sequence, three
+ * descriptors per frame:
+ *
+ *   WRITE CS bit to DOUTTGL (CS low) -> frame bytes to TXDATA ->
+ *   WRITE CS bit to DOUTTGL (CS high) -> next frame ...
+ *
+ * The channel is requested by TXEMPTY, set while both the transmit buffer
+ * and the shift register are empty. A byte is only written once the one
+ * before has been shifted out, which costs a few cycles between the bytes
+ * of a frame, but the CS high write that follows the last byte of a frame
+ * cannot run before that byte is out on the bus. CS is a GPIO pin, not
+ * the USART CS, so the chain alone frames the bytes.
+ *
+ * The RX channel moves all received bytes of the sequence, in frame order,
+ * with a single descriptor. The sequence is done when both channels are.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2022 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ *******************************************************************************
+ * # Evaluation Quality
+ * This code has been minimally tested to ensure that it builds and is suitable 
+ * as a demonstration for evaluation purposes only. This code will be maintained
+ * at the sole discretion of Silicon Labs.
+ ******************************************************************************/
+
+#include <stddef.h>
+
+#include "em_device.h"
+#include "em_cmu.h"
+#include "em_core.h"
+#include "em_gpio.h"
+#include "em_ldma.h"
+#include "em_usart.h"
+
+#include "spiseq.h"
+
+#define SPISEQ_CS_MASK        (1UL << SPISEQ_CS_PIN)
+#define SPISEQ_CHANNELS       ((1UL << SPISEQ_LDMA_CHANNEL_TX) \
+                               | (1UL << SPISEQ_LDMA_CHANNEL_RX))
+
+static LDMA_TransferCfg_t txConfig;
+static LDMA_TransferCfg_t rxConfig;
+
+// Running sequence
+static SPISEQ_Callback_t doneCallback;
+static void *doneUser;
+static volatile uint32_t pendingChannels;
+
+/**************************************************************************//**
+ * @brief
+ *    Initialize the USART as SPI master, the pins and the LDMA
+ *
+ * @param[in] baudrate
+ *    SCLK frequency in Hz, mode 0 and MSB first.
+ *****************************************************************************/
+void SPISEQ_Init(uint32_t baudrate)
+{
+  USART_InitSync_TypeDef config = USART_INITSYNC_DEFAULT;
+  LDMA_Init_t ldmaInit = LDMA_INIT_DEFAULT;
+
+  CMU_ClockEnable(cmuClock_GPIO, true);
+  CMU_ClockEnable(SPISEQ_USART_CLOCK, true);
+  CMU_ClockEnable(cmuClock_LDMA, true);
+
+  // CS is driven by the descriptor chain through the GPIO, idle high
+  GPIO_PinModeSet(SPISEQ_PORT, SPISEQ_CLK_PIN, gpioModePushPull, 0);
+  GPIO_PinModeSet(SPISEQ_PORT, SPISEQ_CS_PIN, gpioModePushPull, 1);
+  GPIO_PinModeSet(SPISEQ_PORT, SPISEQ_MOSI_PIN, gpioModePushPull, 1);
+  GPIO_PinModeSet(SPISEQ_PORT, SPISEQ_MISO_PIN, gpioModeInput, 1);
+
+  config.master       = true;
+  config.baudrate     = baudrate;
+  config.autoCsEnable = false;
+  config.clockMode    = usartClockMode0;
+  config.msbf         = true;
+  config.enable       = usartDisable;
+  USART_InitSync(SPISEQ_USART, &config);
+
+  SPISEQ_USART->ROUTELOC0 = (SPISEQ_LOCATION << _USART_ROUTELOC0_CLKLOC_SHIFT)
+                            | (SPISEQ_LOCATION << _USART_ROUTELOC0_TXLOC_SHIFT)
+                            | (SPISEQ_LOCATION << _USART_ROUTELOC0_RXLOC_SHIFT);
+  SPISEQ_USART->ROUTEPEN = USART_ROUTEPEN_CLKPEN | USART_ROUTEPEN_TXPEN
+                           | USART_ROUTEPEN_RXPEN;
+
+  USART_Enable(SPISEQ_USART, usartEnable);
+
+  LDMA_Init(&ldmaInit);
+  txConfig = (LDMA_TransferCfg_t)LDMA_TRANSFER_CFG_PERIPHERAL(SPISEQ_TX_SIGNAL);
+  rxConfig = (LDMA_TransferCfg_t)LDMA_TRANSFER_CFG_PERIPHERAL(SPISEQ_RX_SIGNAL);
+  LDMA_IntEnable(SPISEQ_CHANNELS);
+
+  pendingChannels = 0;
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Build the descriptor chain of a sequence
+ *
+ * @details
+ *    The CS toggles of consecutive frames are two descriptor loads apart,
+ *    a few hundred nanoseconds. A device that needs CS high for longer
+ *    between frames needs a slower core clock or its own frames.
+ *
+ * @param[out] seq
+ *    Sequence to build, must not be running.
+ *
+ * @param[in] frames
+ *    Frames in bus order. Their tx data must stay valid while the sequence
+ *    is in use, the frame array itself is no longer needed.
+ *
+ * @param[in] count
+ *    Number of frames, 1 to SPISEQ_MAX_FRAMES.
+ *
+ * @param[out] rx
+ *    Buffer for the received bytes of all frames one after the other, as
+ *    many as the frames send. Written by each run of the sequence.
+ *
+ * @return
+ *    False if there are too many frames or bytes, or an empty frame.
+ *****************************************************************************/
+bool SPISEQ_Build(SPISEQ_Sequence_t *seq, const SPISEQ_Frame_t *frames,
+                  uint32_t count, uint8_t *rx)
+{
+  volatile uint32_t *csToggle = &GPIO->P[SPISEQ_PORT].DOUTTGL;
+  LDMA_Descriptor_t *d = seq->tx;
+  uint32_t bytes = 0;
+  uint32_t i;
+
+  if ((count == 0) || (count > SPISEQ_MAX_FRAMES)) {
+    return false;
+  }
+
+  for (i = 0; i < count; i++) {
+    if (frames[i].length == 0) {
+      return false;
+    }
+    bytes += frames[i].length;
+  }
+  if (bytes > SPISEQ_MAX_BYTES) {
+    return false;
+  }
+
+  for (i = 0; i < count; i++) {
+    // CS low, the pin is high between frames
+    *d++ = (LDMA_Descriptor_t)LDMA_DESCRIPTOR_LINKREL_WRITE(SPISEQ_CS_MASK,
+                                                            csToggle, 1);
+    *d++ = (LDMA_Descriptor_t)LDMA_DESCRIPTOR_LINKREL_M2P_BYTE(
+      frames[i].tx, &SPISEQ_USART->TXDATA, frames[i].length, 1);
+
+    // CS high, once the last byte has left the shift register
+    if (i < count - 1) {
+      *d++ = (LDMA_Descriptor_t)LDMA_DESCRIPTOR_LINKREL_WRITE(SPISEQ_CS_MASK,
+                                                              csToggle, 1);
+    } else {
+      *d++ = (LDMA_Descriptor_t)LDMA_DESCRIPTOR_SINGLE_WRITE(SPISEQ_CS_MASK,
+                                                             csToggle);
+    }
+  }
+
+  seq->rx = (LDMA_Descriptor_t)LDMA_DESCRIPTOR_SINGLE_P2M_BYTE(
+    &SPISEQ_USART->RXDATA, rx, bytes);
+  seq->frames = count;
+  seq->bytes = bytes;
+
+  return true;
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Run a built sequence
+ *
+ * @param[in] seq
+ *    Sequence, must stay valid until the callback.
+ *
+ * @param[in] callback
+ *    Called from the LDMA interrupt once CS is high after the last frame
+ *    and all bytes have been received, or NULL.
+ *
+ * @param[in] user
+ *    For the callback.
+ *
+ * @return
+ *    False if a sequence is still running.
+ *****************************************************************************/
+bool SPISEQ_Start(const SPISEQ_Sequence_t *seq, SPISEQ_Callback_t callback,
+                  void *user)
+{
+  CORE_DECLARE_IRQ_STATE;
+
+  CORE_ENTER_CRITICAL();
+  if (pendingChannels != 0) {
+    CORE_EXIT_CRITICAL();
+    return false;
+  }
+  pendingChannels = SPISEQ_CHANNELS;
+  CORE_EXIT_CRITICAL();
+
+  doneCallback = callback;
+  doneUser = user;
+
+  // Bytes left from before would shift the received data
+  SPISEQ_USART->CMD = USART_CMD_CLEARRX;
+
+  LDMA_StartTransfer(SPISEQ_LDMA_CHANNEL_RX, &rxConfig, &seq->rx);
+  LDMA_StartTransfer(SPISEQ_LDMA_CHANNEL_TX, &txConfig, seq->tx);
+
+  return true;
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Check whether the last sequence started has completed
+ *****************************************************************************/
+bool SPISEQ_IsIdle(void)
+{
+  return pendingChannels == 0;
+}
+
+/**************************************************************************//**
+ * @brief
+ *    LDMA interrupt handler, one interrupt per channel and sequence
+ *****************************************************************************/
+void LDMA_IRQHandler(void)
+{
+  uint32_t flags = LDMA_IntGetEnabled();
+
+  LDMA_IntClear(flags);
+
+  if ((pendingChannels != 0) && (flags & SPISEQ_CHANNELS)) {
+    pendingChannels &= ~flags;
+    if ((pendingChannels == 0) && doneCallback) {
+      doneCallback(doneUser);
+    }
+  }
+}
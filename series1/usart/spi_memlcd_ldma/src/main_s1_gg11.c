@@ -0,0 +1,147 @@
+/***************************************************************************//**
+ * @file main_s1_gg11.c
+ * @brief Moves a square on the memory LCD, sending only the changed lines.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2020 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ *******************************************************************************
+ * # Evaluation Quality
+ * This code has been minimally tested to ensure that it builds and is suitable 
+ * as a demonstration for evaluation purposes only. This code will be maintained
+ * at the sole discretion of Silicon Labs.
+ ******************************************************************************/
+
+
+#include "em_device.h"
+#include "em_chip.h"
+#include "em_cmu.h"
+#include "em_emu.h"
+#include "em_letimer.h"
+#include "em_ldma.h"
+#include "memlcd.h"
+
+// Side of the square and its step per frame, in pixels
+#define SQUARE_SIZE     16
+#define SQUARE_STEP     2
+
+// Memory LCD of the SLSTK3701A, see the kit's displayconfig.h
+static const MEMLCD_Init_TypeDef lcdInit = {
+  .usart        = USART1,
+  .usartClock   = cmuClock_USART1,
+  .routeLoc     = USART_ROUTELOC0_TXLOC_LOC6 | USART_ROUTELOC0_CLKLOC_LOC6,
+  .txSignal     = ldmaPeripheralSignal_USART1_TXBL,
+  .sclkPort     = gpioPortC,
+  .sclkPin      = 15,
+  .siPort       = gpioPortA,
+  .siPin        = 14,
+  .scsPort      = gpioPortC,
+  .scsPin       = 14,
+  .enablePort   = gpioPortA,
+  .enablePin    = 9,
+  .extcominPort = gpioPortA,
+  .extcominPin  = 11,
+  .prsChannel   = 1,
+  .prsLocation  = 2,
+};
+
+// Set by every VCOM toggle, paces the frames
+static volatile bool frameTick;
+
+// Driver counters, copied after each frame for the debugger
+MEMLCD_Counters_TypeDef lcdCounters;
+
+/**************************************************************************//**
+ * @brief LDMA IRQ handler, the display update is the only LDMA user
+ *****************************************************************************/
+void LDMA_IRQHandler(void)
+{
+  MEMLCD_IRQHandler();
+}
+
+/**************************************************************************//**
+ * @brief LETIMER0 IRQ handler, one underflow per VCOM toggle
+ *****************************************************************************/
+void LETIMER0_IRQHandler(void)
+{
+  LETIMER_IntClear(LETIMER0, LETIMER_IF_UF);
+  frameTick = true;
+}
+
+/**************************************************************************//**
+ * @brief Main function
+ *****************************************************************************/
+int main(void)
+{
+  int32_t x = 0, y = 0;
+  int32_t dx = SQUARE_STEP, dy = SQUARE_STEP;
+
+  // Chip errata
+  CHIP_Init();
+
+  LDMA_Init_t ldmaInit = LDMA_INIT_DEFAULT;
+  LDMA_Init(&ldmaInit);
+
+  // Also starts LETIMER0 for the VCOM toggle, reuse its underflow
+  MEMLCD_Init(&lcdInit);
+  LETIMER_IntClear(LETIMER0, LETIMER_IF_UF);
+  LETIMER_IntEnable(LETIMER0, LETIMER_IEN_UF);
+  NVIC_ClearPendingIRQ(LETIMER0_IRQn);
+  NVIC_EnableIRQ(LETIMER0_IRQn);
+
+  MEMLCD_Clear(true);
+  MEMLCD_FillRect(x, y, SQUARE_SIZE, SQUARE_SIZE, false);
+  MEMLCD_Update();
+
+  while (1) {
+    // The USART and the LDMA need EM1 while an update is sent
+    if (MEMLCD_IsBusy()) {
+      EMU_EnterEM1();
+      continue;
+    }
+
+    MEMLCD_GetCounters(&lcdCounters);
+
+    if (!frameTick) {
+      EMU_EnterEM2(true);
+      continue;
+    }
+    frameTick = false;
+
+    // Erase the old square only, the lines of both are sent
+    MEMLCD_FillRect(x, y, SQUARE_SIZE, SQUARE_SIZE, true);
+
+    x += dx;
+    y += dy;
+    if ((x <= 0) || (x >= MEMLCD_WIDTH - SQUARE_SIZE)) {
+      dx = -dx;
+    }
+    if ((y <= 0) || (y >= MEMLCD_HEIGHT - SQUARE_SIZE)) {
+      dy = -dy;
+    }
+
+    MEMLCD_FillRect(x, y, SQUARE_SIZE, SQUARE_SIZE, false);
+    MEMLCD_Update();
+  }
+}
@@ -0,0 +1,245 @@
+/***************************************************************************//**
+ * @file main.c
+ * @brief Demonstrates a USART SPI slave with its response prearmed in the TX
+ * LDMA channel and the transfer started by chip select through the PRS.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2022 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ *******************************************************************************
+ * # Evaluation Quality
+ * This code has been minimally tested to ensure that it builds and is suitable 
+ * as a demonstration for evaluation purposes only. This code will be maintained
+ * at the sole discretion of Silicon Labs.
+ ******************************************************************************/
+
+#include "em_device.h"
+#include "em_chip.h"
+#include "em_cmu.h"
+#include "em_emu.h"
+#include "em_gpio.h"
+#include "em_ldma.h"
+#include "em_prs.h"
+#include "em_usart.h"
+
+#if defined(_SILICON_LABS_32B_SERIES_1_CONFIG_2)
+// USART2 at location 1, PA6 (MOSI), PA7 (MISO), PA8 (CLK), PA9 (CS)
+#define SPI_USART         USART2
+#define SPI_CLOCK         cmuClock_USART2
+#define SPI_PORT          gpioPortA
+#define SPI_LOCATION      1
+#define SPI_RX_SIGNAL     ldmaPeripheralSignal_USART2_RXDATAV
+#define SPI_TX_SIGNAL     ldmaPeripheralSignal_USART2_TXBL
+#else
+// USART1 at location 11, PC6 (MOSI), PC7 (MISO), PC8 (CLK), PC9 (CS)
+#define SPI_USART         USART1
+#define SPI_CLOCK         cmuClock_USART1
+#define SPI_PORT          gpioPortC
+#define SPI_LOCATION      11
+#define SPI_RX_SIGNAL     ldmaPeripheralSignal_USART1_RXDATAV
+#define SPI_TX_SIGNAL     ldmaPeripheralSignal_USART1_TXBL
+#endif
+
+#define SPI_MOSI_PIN      6
+#define SPI_MISO_PIN      7
+#define SPI_CLK_PIN       8
+#define SPI_CS_PIN        9
+
+// PRS channel carrying the falling edge of CS to the USART
+#define CS_PRS_CHANNEL    0
+
+#define RX_DMA_CHANNEL    0
+#define TX_DMA_CHANNEL    1
+
+#define RX_BUFFER_SIZE    10
+#define TX_BUFFER_SIZE    RX_BUFFER_SIZE
+
+uint8_t RxBuffer[RX_BUFFER_SIZE];
+
+// Response, TxBuffer[0] is replaced with the frame count at each re-arm
+uint8_t TxBuffer[TX_BUFFER_SIZE] = {0xA0, 0xA1, 0xA2, 0xA3, 0xA4, 0xA5, 0xA6, 0xA7, 0xA8, 0xA9};
+
+// Frame statistics, watch in the debugger
+volatile uint32_t frames;       // Chip select assertions ended
+volatile uint32_t lastRxCount;  // Bytes received in the last frame
+volatile uint32_t shortFrames;  // Frames with fewer than RX_BUFFER_SIZE bytes
+
+static LDMA_Descriptor_t ldmaTXDescriptor;
+static LDMA_TransferCfg_t ldmaTXConfig;
+static LDMA_Descriptor_t ldmaRXDescriptor;
+static LDMA_TransferCfg_t ldmaRXConfig;
+
+/**************************************************************************//**
+ * @brief
+ *    Initialize the USART as SPI slave with the receiver and transmitter
+ *    enabled by the PRS
+ *
+ * @details
+ *    The receiver and transmitter stay disabled between frames. The GPIO
+ *    signal of the CS pin goes through the PRS with falling edge detection,
+ *    and the USART trigger sets RXEN and TXEN on the pulse, so both start
+ *    a few HFPERCLK cycles after CS asserts with the first response byte
+ *    already in the transmit buffer. No interrupt is involved.
+ *****************************************************************************/
+void initUSART(void)
+{
+  USART_InitSync_TypeDef config = USART_INITSYNC_DEFAULT;
+  USART_PrsTriggerInit_TypeDef trigger = USART_INITPRSTRIGGER_DEFAULT;
+
+  CMU_ClockEnable(cmuClock_GPIO, true);
+  CMU_ClockEnable(cmuClock_PRS, true);
+  CMU_ClockEnable(SPI_CLOCK, true);
+
+  // Configure GPIO mode, MISO is the only output of a slave
+  GPIO_PinModeSet(SPI_PORT, SPI_CLK_PIN, gpioModeInput, 1);
+  GPIO_PinModeSet(SPI_PORT, SPI_CS_PIN, gpioModeInput, 1);
+  GPIO_PinModeSet(SPI_PORT, SPI_MOSI_PIN, gpioModeInput, 1);
+  GPIO_PinModeSet(SPI_PORT, SPI_MISO_PIN, gpioModePushPull, 1);
+
+  config.master    = false;
+  config.clockMode = usartClockMode0; // clock idle low, sample on rising/first edge
+  config.msbf      = true;            // send MSB first
+  config.enable    = usartDisable;    // Enabled frame by frame through the PRS
+  USART_InitSync(SPI_USART, &config);
+
+  SPI_USART->ROUTELOC0 = (SPI_LOCATION << _USART_ROUTELOC0_CLKLOC_SHIFT)
+                         | (SPI_LOCATION << _USART_ROUTELOC0_CSLOC_SHIFT)
+                         | (SPI_LOCATION << _USART_ROUTELOC0_TXLOC_SHIFT)
+                         | (SPI_LOCATION << _USART_ROUTELOC0_RXLOC_SHIFT);
+  SPI_USART->ROUTEPEN = USART_ROUTEPEN_CLKPEN | USART_ROUTEPEN_CSPEN
+                        | USART_ROUTEPEN_TXPEN | USART_ROUTEPEN_RXPEN;
+
+  // CS pin signal to the PRS, its rising edge interrupt ends the frame
+  GPIO_ExtIntConfig(SPI_PORT, SPI_CS_PIN, SPI_CS_PIN, true, false, true);
+  PRS_SourceSignalSet(CS_PRS_CHANNEL, PRS_CH_CTRL_SOURCESEL_GPIOH,
+                      (uint32_t)(SPI_CS_PIN - 8), prsEdgeNeg);
+
+  trigger.rxTriggerEnable   = true;
+  trigger.txTriggerEnable   = true;
+  trigger.prsTriggerChannel = CS_PRS_CHANNEL;
+  USART_InitPrsTrigger(SPI_USART, &trigger);
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Arm both LDMA channels for the next frame
+ *
+ * @details
+ *    The TX channel writes the first response byte to the empty transmit
+ *    buffer right away, and the next one each time the byte before moves
+ *    to the shift register, so the response keeps ahead of the master at
+ *    any SCLK the USART slave can follow. The RX channel waits for the
+ *    receiver, which is only enabled by the next falling edge of CS.
+ *****************************************************************************/
+static void armFrame(void)
+{
+  TxBuffer[0] = (uint8_t)frames;
+
+  LDMA_StartTransfer(RX_DMA_CHANNEL, &ldmaRXConfig, &ldmaRXDescriptor);
+  LDMA_StartTransfer(TX_DMA_CHANNEL, &ldmaTXConfig, &ldmaTXDescriptor);
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Initialize the LDMA channels, no LDMA interrupts are used
+ *****************************************************************************/
+void initLDMA(void)
+{
+  LDMA_Init_t ldmaInit = LDMA_INIT_DEFAULT;
+
+  CMU_ClockEnable(cmuClock_LDMA, true);
+  LDMA_Init(&ldmaInit);
+
+  ldmaRXDescriptor = (LDMA_Descriptor_t)LDMA_DESCRIPTOR_SINGLE_P2M_BYTE(&(SPI_USART->RXDATA), RxBuffer, RX_BUFFER_SIZE);
+  ldmaRXDescriptor.xfer.doneIfs = 0;
+  ldmaRXConfig = (LDMA_TransferCfg_t)LDMA_TRANSFER_CFG_PERIPHERAL(SPI_RX_SIGNAL);
+
+  ldmaTXDescriptor = (LDMA_Descriptor_t)LDMA_DESCRIPTOR_SINGLE_M2P_BYTE(TxBuffer, &(SPI_USART->TXDATA), TX_BUFFER_SIZE);
+  ldmaTXDescriptor.xfer.doneIfs = 0;
+  ldmaTXConfig = (LDMA_TransferCfg_t)LDMA_TRANSFER_CFG_PERIPHERAL(SPI_TX_SIGNAL);
+
+  armFrame();
+}
+
+/**************************************************************************//**
+ * @brief
+ *    GPIO odd interrupt handler, CS deasserted: the one interrupt of a frame
+ *
+ * @details
+ *    The last byte may still be in RXDATA when the edge is seen, so the RX
+ *    channel is given the time to take it before both channels are stopped.
+ *    The USART is then disabled and both buffers cleared so that bytes left
+ *    over from a short frame are not sent in the next one.
+ *****************************************************************************/
+void GPIO_ODD_IRQHandler(void)
+{
+  uint32_t received;
+
+  GPIO_IntClear(1 << SPI_CS_PIN);
+
+  while ((SPI_USART->STATUS & USART_STATUS_RXDATAV)
+         && !LDMA_TransferDone(RX_DMA_CHANNEL)) {
+  }
+
+  received = RX_BUFFER_SIZE - LDMA_TransferRemainingCount(RX_DMA_CHANNEL);
+  LDMA_StopTransfer(RX_DMA_CHANNEL);
+  LDMA_StopTransfer(TX_DMA_CHANNEL);
+
+  SPI_USART->CMD = USART_CMD_RXDIS | USART_CMD_TXDIS
+                   | USART_CMD_CLEARRX | USART_CMD_CLEARTX;
+
+  lastRxCount = received;
+  if (received < RX_BUFFER_SIZE) {
+    shortFrames++;
+  }
+  frames++;
+
+  armFrame();
+}
+
+/**************************************************************************//**
+ * @brief Main function
+ *****************************************************************************/
+int main(void)
+{
+  // Initialize chip
+  CHIP_Init();
+
+  // The fastest SCLK a USART slave follows is a fraction of HFPERCLK
+  CMU_HFRCOBandSet(cmuHFRCOFreq_38M0Hz);
+
+  // Initialize the USART as SPI slave started by CS through the PRS
+  initUSART();
+
+  // Prearm the response and receive channels
+  initLDMA();
+
+  NVIC_ClearPendingIRQ(GPIO_ODD_IRQn);
+  NVIC_EnableIRQ(GPIO_ODD_IRQn);
+
+  // The LDMA and the USART need the HF clocks, wake only at the end of frames
+  while (1) {
+    EMU_EnterEM1();
+  }
+}
@@ -0,0 +1,97 @@
+/***************************************************************************//**
+ * @file spiseq.h
+ * @brief Periodic SPI transactions paced by the LETIMER, run by the LDMA.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2021 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ******************************************************************************/
+
+#ifndef SPISEQ_H
+#define SPISEQ_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "em_device.h"
+#include "em_ldma.h"
+#include "em_usart.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// PRS channel from LETIMER0 to the LDMA. PRS channels 0 to 7 can set the
+// LDMA SYNC bit of the same number, which starts each transaction.
+#define SPISEQ_PRS_CHANNEL    0
+
+// LDMA channels for the command and the response
+#define SPISEQ_TX_CHANNEL     0
+#define SPISEQ_RX_CHANNEL     1
+
+// Longest transaction, in bytes
+#ifndef SPISEQ_MAX_FRAME
+#define SPISEQ_MAX_FRAME      16
+#endif
+
+// Response ring, in bytes. The CPU is woken up each time a half of it,
+// framesPerBlock transactions, has been received.
+#ifndef SPISEQ_RING_SIZE
+#define SPISEQ_RING_SIZE      512
+#endif
+
+// LFACLK for LETIMER0, cmuSelect_LFXO or cmuSelect_LFRCO
+#ifndef SPISEQ_LFA_CLOCK
+#define SPISEQ_LFA_CLOCK      cmuSelect_LFXO
+#endif
+
+#if (SPISEQ_PRS_CHANNEL > 7)
+#error "SPISEQ_PRS_CHANNEL must be 0 to 7"
+#endif
+
+// Called from the LDMA interrupt with a block of responses, frameLength
+// bytes each. The block is overwritten half a ring later.
+typedef void (*SPISEQ_Callback_t)(const uint8_t *frames, uint32_t count);
+
+typedef struct {
+  USART_TypeDef *usart;             // Synchronous master, AUTOCS enabled
+  LDMA_PeripheralSignal_t txSignal; // ldmaPeripheralSignal_USARTn_TXBL
+  LDMA_PeripheralSignal_t rxSignal; // ldmaPeripheralSignal_USARTn_RXDATAV
+  const uint8_t *command;           // Bytes sent in each transaction
+  uint32_t frameLength;             // Length of the command and response
+  uint32_t rate;                    // Transactions per second
+  uint32_t framesPerBlock;          // Transactions per callback
+  SPISEQ_Callback_t callback;
+} SPISEQ_Init_t;
+
+bool SPISEQ_Start(const SPISEQ_Init_t *init);
+void SPISEQ_Stop(void);
+uint32_t SPISEQ_GetRate(void);
+uint32_t SPISEQ_GetFrameCount(void);
+uint32_t SPISEQ_GetBlockCount(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SPISEQ_H
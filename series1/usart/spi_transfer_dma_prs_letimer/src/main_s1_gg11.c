@@ -39,76 +39,46 @@
 #include "em_gpio.h"
 #include "em_usart.h"
 #include "em_ldma.h"
-#include "em_letimer.h"
-#include "em_prs.h"
+#include "em_emu.h"
 
-#define PRS_TX_CHANNEL    0
-#define PRS_RX_CHANNEL    1
+#include "spiseq.h"
+
+// Transactions per second, and per wakeup of the CPU
+#define TRANSFER_RATE     1000
+#define FRAMES_PER_BLOCK  8
 
 #define TX_BUFFER_SIZE   10
 #define RX_BUFFER_SIZE   TX_BUFFER_SIZE
 
+// Command sent in each transaction
 uint8_t TxBuffer[TX_BUFFER_SIZE] = {0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09};
-int numTransfers = 0;  //Number of transfers completed so far
-
-uint8_t RxBuffer[RX_BUFFER_SIZE] = {0};
-
-// Descriptor and config for the LDMA operation for sending data
-static LDMA_Descriptor_t ldmaTXDescriptor;
-static LDMA_TransferCfg_t ldmaTXConfig;
 
-// Descriptor and config for the LDMA operation for receiving data
-static LDMA_Descriptor_t ldmaRXDescriptor;
-static LDMA_TransferCfg_t ldmaRXConfig;
+// Response to the last transaction of the last block
+uint8_t RxBuffer[RX_BUFFER_SIZE];
 
-// Desired letimer interrupt frequency (in Hz)
-#define letimerDesired  1000
+// Blocks of FRAMES_PER_BLOCK responses received
+volatile uint32_t numBlocks = 0;
 
 /**************************************************************************//**
- * @brief LETIMER initialization
+ * @brief Handle a block of responses
  *
- * Note: The Letimer is being initialized to only generate a number of
- * pulses equal to the size of our TxBuffer
+ * Note: Called by the sequencer from the LDMA interrupt, the only time the
+ * CPU wakes up. An application would process all count responses here;
+ * the example keeps the last one for the debugger.
  *****************************************************************************/
-void initLETIMER(void)
+void processBlock(const uint8_t *frames, uint32_t count)
 {
-  LETIMER_Init_TypeDef letimerInit = LETIMER_INIT_DEFAULT;
-
-  // Enable clock to the LE modules interface
-  CMU_ClockEnable(cmuClock_HFLE, true);
-
-  // Select LFXO for the LETIMER
-  CMU_ClockSelectSet(cmuClock_LFA, cmuSelect_LFXO);
-  CMU_ClockEnable(cmuClock_LETIMER0, true);
-
-  // Reload COMP0 on underflow, idle output, and run in repeat mode
-  letimerInit.comp0Top  = true;
-  letimerInit.ufoa0     = letimerUFOAPulse;
-  letimerInit.repMode   = letimerRepeatDouble;
-
-  // Need REP0 != 0 to pulse on underflow
-  LETIMER_RepeatSet(LETIMER0, 0, 10);
-
-  // calculate the topValue
-  uint32_t topValue = CMU_ClockFreqGet(cmuClock_LETIMER0) / letimerDesired;
-
-  // Compare on wake-up interval count
-  LETIMER_CompareSet(LETIMER0, 0, topValue);
-
-  // Initialize and enable LETIMER
-  LETIMER_Init(LETIMER0, &letimerInit);
+  const uint8_t *last = &frames[(count - 1) * RX_BUFFER_SIZE];
+  uint32_t i;
 
-  // Use LETIMER0 as sync PRS to trigger DMA transfers to the slave
-  CMU_ClockEnable(cmuClock_PRS, true);
-  PRS_SourceSignalSet(PRS_TX_CHANNEL,
-                      PRS_CH_CTRL_SOURCESEL_LETIMER0,
-                      PRS_CH_CTRL_SIGSEL_LETIMER0CH0,
-                      prsEdgePos);
+  for (i = 0; i < RX_BUFFER_SIZE; i++)
+  {
+    RxBuffer[i] = last[i];
+  }
 
-  PRS->DMAREQ0 = PRS_DMAREQ0_PRSSEL_PRSCH0;
+  numBlocks++;
 }
 
-
 /**************************************************************************//**
  * @brief Initialize USART0
  *****************************************************************************/
@@ -144,94 +114,43 @@ void initUSART0 (void)
     // Enable USART pins
     USART0->ROUTEPEN = USART_ROUTEPEN_CLKPEN | USART_ROUTEPEN_CSPEN | USART_ROUTEPEN_TXPEN | USART_ROUTEPEN_RXPEN;
 
-
-    // Using GPIO pin 8 to trigger LDMA transfers using PRS signals
-    CMU_ClockEnable(cmuClock_PRS, true);
-
-    // Configuring the PRS to send the PRS signal to the LDMA Channel 0
-    PRS->DMAREQ0 = PRS_DMAREQ0_PRSSEL_PRSCH0;
-
     // Enable USART0
     USART_Enable(USART0, usartEnable);
 }
 
-/**************************************************************************//**
- * @Initialize LDMA Descriptors
- *
- * Note: The transfer descriptor will be triggered by periodic pulses from the
- * letimer through PRS. While the Rx descriptor waits for packets from the slave
- *****************************************************************************/
-void initLDMA(void)
-{
-  CMU_ClockEnable(cmuClock_LDMA, true);
-  LDMA_Init_t ldmaInit = LDMA_INIT_DEFAULT;
-  LDMA_Init(&ldmaInit); // Initializing default LDMA settings
-
-  // Peripheral to memory transfer, Source: USART0->RXDATA, Destination: RxBuffer, Bytes to receive: 10
-  ldmaRXDescriptor = (LDMA_Descriptor_t)LDMA_DESCRIPTOR_SINGLE_P2M_BYTE(&(USART0->RXDATA), RxBuffer, RX_BUFFER_SIZE);
-  // One byte will transfer everytime the USART RXDATAV flag is high
-  ldmaRXConfig = (LDMA_TransferCfg_t)LDMA_TRANSFER_CFG_PERIPHERAL(ldmaPeripheralSignal_USART0_RXDATAV);
-
-  // Memory to peripheral transfer, Source: TxBuffer, Destination: USART0->TXDATA, Bytes to receive: 10
-  ldmaTXDescriptor = (LDMA_Descriptor_t)LDMA_DESCRIPTOR_SINGLE_M2P_BYTE(TxBuffer, &(USART0->TXDATA), 1);
-  // One byte will transfer everytime the USART TXBL flag is high
-  ldmaTXConfig = (LDMA_TransferCfg_t)LDMA_TRANSFER_CFG_PERIPHERAL(ldmaPeripheralSignal_PRS_REQ0);
-
-  //Starting both ldma transfers are different channels
-  LDMA_StartTransfer(PRS_TX_CHANNEL, &ldmaTXConfig, &ldmaTXDescriptor);
-  LDMA_StartTransfer(PRS_RX_CHANNEL, &ldmaRXConfig, &ldmaRXDescriptor);
-}
-
-/**************************************************************************//**
- * @brief LDMA IRQHandler that triggers the next transfer
- *
- * Note: Since we want to increment our source pointer every transfer, but
- * each new transfer starts back over at the beginning of TxBuffer we have
- * to make a new pointer to the element we want to send each transfer
- * and feed that into our new LDMA descriptor every loop
- *****************************************************************************/
-void LDMA_IRQHandler()
-{
-  uint32_t flags = LDMA_IntGet();
-
-  if(flags & (1 << PRS_TX_CHANNEL))
-  {
-    LDMA_IntClear(1 << PRS_TX_CHANNEL);
-    numTransfers++;
-    if(numTransfers == TX_BUFFER_SIZE)
-    {
-      numTransfers = 0;
-    }
-
-    uint8_t *newPointer = &(TxBuffer[numTransfers]);
-
-    ldmaTXDescriptor = (LDMA_Descriptor_t)LDMA_DESCRIPTOR_SINGLE_M2P_BYTE(newPointer, &(USART0->TXDATA), 1);
-    LDMA_StartTransfer(PRS_TX_CHANNEL, &ldmaTXConfig, &ldmaTXDescriptor);
-  }
-  else
-  {
-    LDMA_StartTransfer(PRS_RX_CHANNEL, &ldmaRXConfig, &ldmaRXDescriptor);
-  }
-}
-
 /**************************************************************************//**
  * @brief Main function
  *****************************************************************************/
 int main(void)
 {
+  SPISEQ_Init_t seq;
+
   // Initialize chip
   CHIP_Init();
 
-  // Initialize LETIMER0 to generate periodic prs interrupts
-  initLETIMER();
-
-  // Initialize USART0 as SPI slave
+  // Initialize USART0 as SPI master
   initUSART0();
 
-  // Setup LDMA channels for transfer across SPI
-  initLDMA();
-
-  // Place breakpoint here and observe RxBuffer after the transfers have completed
+  /*
+   * Send TxBuffer TRANSFER_RATE times per second, paced by LETIMER0
+   * through PRS, and receive the responses with the LDMA. The CPU only
+   * wakes up once per FRAMES_PER_BLOCK transactions.
+   */
+  seq.usart          = USART0;
+  seq.txSignal       = ldmaPeripheralSignal_USART0_TXBL;
+  seq.rxSignal       = ldmaPeripheralSignal_USART0_RXDATAV;
+  seq.command        = TxBuffer;
+  seq.frameLength    = TX_BUFFER_SIZE;
+  seq.rate           = TRANSFER_RATE;
+  seq.framesPerBlock = FRAMES_PER_BLOCK;
+  seq.callback       = processBlock;
+  SPISEQ_Start(&seq);
+
+  // Place breakpoint in processBlock() and observe RxBuffer
   // RxBuffer should contain 0xA0, 0xA1, 0xA2, 0xA3, 0xA4, 0xA5, 0xA6, 0xA7, 0xA8, 0xA9
-  while(1);
+  while(1)
+  {
+    // The USART and LDMA need the HFCLK, so sleep in EM1
+    EMU_EnterEM1();
+  }
 }
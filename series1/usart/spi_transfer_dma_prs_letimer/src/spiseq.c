@@ -0,0 +1,232 @@
+/***************************************************************************//**
+ * @file spiseq.c
+ * @brief Periodic SPI transactions paced by the LETIMER, run by the LDMA.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2021 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ******************************************************************************/
+
+#include <stddef.h>
+#include "em_cmu.h"
+#include "em_letimer.h"
+#include "em_prs.h"
+#include "spiseq.h"
+
+#define SYNC_BIT      (1 << SPISEQ_PRS_CHANNEL)
+
+// Command loop: wait for the LETIMER, clear the trigger, send the command
+static LDMA_Descriptor_t txDesc[3];
+
+// Response ring, two halves that link to each other
+static LDMA_Descriptor_t rxDesc[2];
+
+static uint8_t txFrame[SPISEQ_MAX_FRAME];
+static uint8_t ring[SPISEQ_RING_SIZE];
+
+static SPISEQ_Callback_t blockCallback;
+static uint32_t blockFrames;
+static uint32_t blockBytes;
+static uint32_t half;
+static uint32_t rate;
+static bool running;
+static volatile uint32_t blockCount;
+
+/***************************************************************************//**
+ * @brief
+ *   LDMA interrupt, once per block of responses.
+ ******************************************************************************/
+void LDMA_IRQHandler(void)
+{
+  uint32_t pending = LDMA_IntGet();
+
+  LDMA_IntClear(pending);
+
+  if (pending & LDMA_IF_ERROR) {
+    // Loop here to enable the debugger to see what has happened
+    while (1);
+  }
+
+  if (pending & (1 << SPISEQ_RX_CHANNEL)) {
+    blockCount++;
+    if (blockCallback != NULL) {
+      blockCallback(&ring[half * blockBytes], blockFrames);
+    }
+    half ^= 1;
+  }
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Start the transactions.
+ *
+ * @details
+ *   Each LETIMER0 underflow pulses PRS channel SPISEQ_PRS_CHANNEL, which
+ *   sets the LDMA SYNC bit of the same number. The command channel waits
+ *   for the bit, clears it and writes the command to TXDATA as fast as the
+ *   USART takes it, so that AUTOCS holds CS asserted for the whole
+ *   transaction. The response channel stores every received byte in the
+ *   ring and raises an interrupt once per block. The CPU runs only for the
+ *   callback.
+ *
+ *   A transaction that starts before the last one has finished follows it
+ *   directly, so none are lost unless the rate is more than the SPI clock
+ *   can carry. The USART and the LDMA need the HFCLK, so the device can
+ *   sleep in EM1 but not in EM2 between transactions.
+ *
+ *   The USART must already be initialized as a synchronous master with
+ *   autoCsEnable set and its pins routed. The sequencer initializes the
+ *   LDMA, and owns LETIMER0, the PRS channel, the two LDMA channels and the
+ *   LDMA interrupt handler.
+ *
+ * @param[in] init
+ *   The transaction and its rate.
+ *
+ * @return
+ *   false if the frame is empty or longer than SPISEQ_MAX_FRAME, a block
+ *   does not fit in half of SPISEQ_RING_SIZE, or the rate can not be set.
+ ******************************************************************************/
+bool SPISEQ_Start(const SPISEQ_Init_t *init)
+{
+  LETIMER_Init_TypeDef letimerInit = LETIMER_INIT_DEFAULT;
+  LDMA_Init_t ldmaInit = LDMA_INIT_DEFAULT;
+  LDMA_TransferCfg_t txCfg = LDMA_TRANSFER_CFG_PERIPHERAL(init->txSignal);
+  LDMA_TransferCfg_t rxCfg = LDMA_TRANSFER_CFG_PERIPHERAL(init->rxSignal);
+  uint32_t freq, top, i;
+
+  if ((init->frameLength == 0)
+      || (init->frameLength > SPISEQ_MAX_FRAME)
+      || (init->framesPerBlock == 0)
+      || (init->framesPerBlock * init->frameLength > SPISEQ_RING_SIZE / 2)
+      || (init->rate == 0)) {
+    return false;
+  }
+
+  // LETIMER0 runs from the LFACLK, 1 to 65536 ticks per transaction
+  CMU_ClockEnable(cmuClock_HFLE, true);
+  CMU_ClockSelectSet(cmuClock_LFA, SPISEQ_LFA_CLOCK);
+  CMU_ClockEnable(cmuClock_LETIMER0, true);
+
+  freq = CMU_ClockFreqGet(cmuClock_LETIMER0);
+  top = (freq + init->rate / 2) / init->rate;
+  if ((top == 0) || (top > 0x10000)) {
+    return false;
+  }
+  rate = freq / top;
+
+  SPISEQ_Stop();
+
+  for (i = 0; i < init->frameLength; i++) {
+    txFrame[i] = init->command[i];
+  }
+  blockCallback = init->callback;
+  blockFrames = init->framesPerBlock;
+  blockBytes = init->framesPerBlock * init->frameLength;
+  half = 0;
+  blockCount = 0;
+
+  // The PRS pulse of the LETIMER underflow sets the SYNC bit
+  ldmaInit.ldmaInitCtrlSyncPrsSetEn = SYNC_BIT;
+  CMU_ClockEnable(cmuClock_LDMA, true);
+  LDMA_Init(&ldmaInit);
+
+  txDesc[0] = (LDMA_Descriptor_t)LDMA_DESCRIPTOR_LINKREL_SYNC(0, 0, SYNC_BIT, SYNC_BIT, 1);
+  txDesc[1] = (LDMA_Descriptor_t)LDMA_DESCRIPTOR_LINKREL_SYNC(0, SYNC_BIT, 0, 0, 1);
+  txDesc[2] = (LDMA_Descriptor_t)LDMA_DESCRIPTOR_LINKREL_M2P_BYTE(txFrame, &init->usart->TXDATA, init->frameLength, -2);
+  for (i = 0; i < 3; i++) {
+    txDesc[i].xfer.doneIfs = 0;
+  }
+
+  rxDesc[0] = (LDMA_Descriptor_t)LDMA_DESCRIPTOR_LINKREL_P2M_BYTE(&init->usart->RXDATA, &ring[0], blockBytes, 1);
+  rxDesc[1] = (LDMA_Descriptor_t)LDMA_DESCRIPTOR_LINKREL_P2M_BYTE(&init->usart->RXDATA, &ring[blockBytes], blockBytes, -1);
+  rxDesc[0].xfer.doneIfs = 1;
+  rxDesc[1].xfer.doneIfs = 1;
+
+  // Drop anything received before the first transaction
+  init->usart->CMD = USART_CMD_CLEARRX;
+
+  LDMA_StartTransfer(SPISEQ_RX_CHANNEL, &rxCfg, rxDesc);
+  LDMA_StartTransfer(SPISEQ_TX_CHANNEL, &txCfg, txDesc);
+
+  CMU_ClockEnable(cmuClock_PRS, true);
+  PRS_SourceSignalSet(SPISEQ_PRS_CHANNEL,
+                      PRS_CH_CTRL_SOURCESEL_LETIMER0,
+                      PRS_CH_CTRL_SIGSEL_LETIMER0CH0,
+                      prsEdgePos);
+
+  // Pulse output 0 on each underflow, reloading COMP0, forever. REP0 must
+  // not be 0 for the underflow output action.
+  letimerInit.comp0Top = true;
+  letimerInit.ufoa0 = letimerUFOAPulse;
+  letimerInit.repMode = letimerRepeatFree;
+  letimerInit.enable = false;
+  LETIMER_Init(LETIMER0, &letimerInit);
+  LETIMER_CompareSet(LETIMER0, 0, top - 1);
+  LETIMER_RepeatSet(LETIMER0, 0, 1);
+  LETIMER_Enable(LETIMER0, true);
+
+  running = true;
+  return true;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Stop the transactions after the one in progress.
+ ******************************************************************************/
+void SPISEQ_Stop(void)
+{
+  if (running) {
+    LETIMER_Enable(LETIMER0, false);
+    LDMA_StopTransfer(SPISEQ_TX_CHANNEL);
+    LDMA_StopTransfer(SPISEQ_RX_CHANNEL);
+    running = false;
+  }
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Get the transactions per second, after rounding to whole LFACLK ticks.
+ ******************************************************************************/
+uint32_t SPISEQ_GetRate(void)
+{
+  return rate;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Get the transactions handed to the callback.
+ ******************************************************************************/
+uint32_t SPISEQ_GetFrameCount(void)
+{
+  return blockCount * blockFrames;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Get the blocks of responses received.
+ ******************************************************************************/
+uint32_t SPISEQ_GetBlockCount(void)
+{
+  return blockCount;
+}
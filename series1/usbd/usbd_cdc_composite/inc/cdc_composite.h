@@ -0,0 +1,64 @@
+/***************************************************************************//**
+ * @file cdc_composite.h
+ * @brief USB Communication Device Class (CDC) driver for a composite device
+ * with one ring of buffers per port
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2020 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ******************************************************************************/
+
+#ifndef CDC_COMPOSITE_H
+#define CDC_COMPOSITE_H
+
+#include <stdint.h>
+#include "em_usb.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Counters of one port, cdcStats[] can also be watched in the debugger
+typedef struct {
+  uint32_t rxBytes;     // Bytes received from the host
+  uint32_t rxXfers;     // USB read transfers completed
+  uint32_t txBytes;     // Bytes sent to the host
+  uint32_t txXfers;     // USB write transfers completed
+  uint32_t dropped;     // Bytes cdcWrite() could not queue
+} cdcStats_TypeDef;
+
+int  cdcSetupCmd(const USB_Setup_TypeDef *setup);
+void cdcStateChangeEvent(USBD_State_TypeDef oldState, USBD_State_TypeDef newState);
+
+uint32_t cdcWrite(int port, const void *data, uint32_t length);
+uint32_t cdcWriteSpace(int port);
+void cdcFlush(int port);
+bool cdcIsOpen(int port);
+void cdcGetStats(int port, cdcStats_TypeDef *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // CDC_COMPOSITE_H
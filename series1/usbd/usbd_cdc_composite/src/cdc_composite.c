@@ -0,0 +1,670 @@
+/***************************************************************************//**
+ * @file cdc_composite.c
+ * @brief USB Communication Device Class (CDC) driver for a composite device
+ * with one ring of buffers per port
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2020 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ *******************************************************************************
+ * # Evaluation Quality
+ * This code has been minimally tested to ensure that it builds and is suitable 
+ * as a demonstration for evaluation purposes only. This code will be maintained
+ * at the sole discretion of Silicon Labs.
+ ******************************************************************************/
+
+#include <string.h>
+#include "em_core.h"
+#include "em_usb.h"
+#include "cdc_composite.h"
+
+// The serial port LINE CODING data structure, used to carry information
+// about serial port baudrate, parity, etc. between host and device.
+SL_PACK_START(1)
+typedef struct {
+  uint32_t dwDTERate;   // Baudrate
+  uint8_t  bCharFormat; // Stop bits: 0 = one stop bit, 1 = 1.5 stop bits, 2 = two stop bits
+  uint8_t  bParityType; // Parity: 0 = none, 1 = odd, 2 = even, 3 = mark, 4 = space
+  uint8_t  bDataBits;   // Data bits: 5, 6, 7, 8, or 16
+  uint8_t  dummy;       // To ensure size is a multiple of 4 bytes
+} SL_ATTRIBUTE_PACKED cdcLineCoding_TypeDef;
+SL_PACK_END()
+
+// 115200 baud, one stop bit, no parity, 8 data bits
+#define CDC_LINECODING_DEFAULT  { 115200, 0, 0, 8, 0 }
+
+// The LineCoding variables must be 4-byte aligned. USB CDC runs at bus
+// speed, the line coding of each port is only stored for the host.
+SL_ALIGN(4)
+SL_PACK_START(1)
+static cdcLineCoding_TypeDef SL_ATTRIBUTE_ALIGN(4) cdcLineCoding[CDC_PORTS] = {
+  CDC_LINECODING_DEFAULT,
+  CDC_LINECODING_DEFAULT,
+#if CDC_PORTS > 2
+  CDC_LINECODING_DEFAULT,
+#endif
+};
+SL_PACK_END()
+
+// The data stage of a CDC_SET_LINECODING request is received here and only
+// copied to the port once it has been checked
+SL_ALIGN(4)
+SL_PACK_START(1)
+static cdcLineCoding_TypeDef SL_ATTRIBUTE_ALIGN(4) lineCodingRx;
+SL_PACK_END()
+
+// Port of the CDC_SET_LINECODING request in progress, EP0 requests are
+// handled one at a time
+static int lineCodingPort;
+
+#if ((CDC_CONSOLE_BUF_CNT & (CDC_CONSOLE_BUF_CNT - 1)) != 0)     \
+  || ((CDC_TELEMETRY_BUF_CNT & (CDC_TELEMETRY_BUF_CNT - 1)) != 0) \
+  || ((CDC_DATA_BUF_CNT & (CDC_DATA_BUF_CNT - 1)) != 0)
+#error "The CDC_xxx_BUF_CNT values must be powers of 2"
+#endif
+
+// What a port does with its ring
+typedef enum {
+  cdcRoleEcho,    // OUT packets fill the ring and IN sends them back
+  cdcRoleSource   // cdcWrite() fills the ring, OUT data is thrown away
+} cdcRole_TypeDef;
+
+// Rings of USB transfer buffers, 4-byte aligned for the USB DMA, and the
+// number of bytes in each queued buffer
+STATIC_UBUF(consoleRing, CDC_CONSOLE_BUF_CNT * CDC_CONSOLE_BUF_SIZE);
+STATIC_UBUF(telemetryRing, CDC_TELEMETRY_BUF_CNT * CDC_TELEMETRY_BUF_SIZE);
+static uint32_t consoleLen[CDC_CONSOLE_BUF_CNT];
+static uint32_t telemetryLen[CDC_TELEMETRY_BUF_CNT];
+#if CDC_PORTS > 2
+STATIC_UBUF(dataRing, CDC_DATA_BUF_CNT * CDC_DATA_BUF_SIZE);
+static uint32_t dataLen[CDC_DATA_BUF_CNT];
+#endif
+
+// OUT data of the source ports, received only to be counted and dropped
+STATIC_UBUF(drainBuffer, USB_FS_BULK_EP_MAXSIZE);
+
+// Fixed setup of a port
+typedef struct {
+  cdcRole_TypeDef            role;
+  uint8_t                    *ring;
+  uint32_t                   *bufLen;
+  uint32_t                   bufCnt;
+  uint32_t                   bufSize;
+  USB_XferCompleteCb_TypeDef rxDone;
+  USB_XferCompleteCb_TypeDef txDone;
+} cdcPortConfig_TypeDef;
+
+// Running state of a port. head and tail count up and wrap at 2^32, the
+// buffer in use is the count modulo bufCnt.
+typedef struct {
+  uint32_t head;      // Buffers queued for IN (echo: also the next OUT buffer)
+  uint32_t tail;      // Buffers sent on IN
+  uint32_t fill;      // Bytes cdcWrite() has put into the buffer at head
+  bool     rxActive;  // USB read set up on the OUT endpoint
+  bool     txActive;  // USB write set up on the IN endpoint
+  bool     open;      // The host has set DTR
+} cdcPort_TypeDef;
+
+static bool configured;
+static cdcPort_TypeDef cdcPort[CDC_PORTS];
+static cdcStats_TypeDef cdcStats[CDC_PORTS];
+
+static int portReceived(int port, USB_Status_TypeDef status, uint32_t xferred);
+static int portTransmitted(int port, USB_Status_TypeDef status, uint32_t xferred);
+
+// The transfer complete callbacks do not tell which endpoint they belong to,
+// so each port has its own pair
+#define CDC_PORT_CALLBACKS(name, port)                                   \
+  static int name##Received(USB_Status_TypeDef status, uint32_t xferred, \
+                            uint32_t remaining)                          \
+  {                                                                      \
+    (void) remaining;                                                    \
+    return portReceived(port, status, xferred);                          \
+  }                                                                      \
+  static int name##Transmitted(USB_Status_TypeDef status,                \
+                               uint32_t xferred, uint32_t remaining)     \
+  {                                                                      \
+    (void) remaining;                                                    \
+    return portTransmitted(port, status, xferred);                       \
+  }
+
+CDC_PORT_CALLBACKS(console, CDC_PORT_CONSOLE)
+CDC_PORT_CALLBACKS(telemetry, CDC_PORT_TELEMETRY)
+#if CDC_PORTS > 2
+CDC_PORT_CALLBACKS(data, CDC_PORT_DATA)
+#endif
+
+static const cdcPortConfig_TypeDef cdcPortConfig[CDC_PORTS] = {
+  [CDC_PORT_CONSOLE] = {
+    cdcRoleEcho, consoleRing, consoleLen,
+    CDC_CONSOLE_BUF_CNT, CDC_CONSOLE_BUF_SIZE,
+    consoleReceived, consoleTransmitted
+  },
+  [CDC_PORT_TELEMETRY] = {
+    cdcRoleSource, telemetryRing, telemetryLen,
+    CDC_TELEMETRY_BUF_CNT, CDC_TELEMETRY_BUF_SIZE,
+    telemetryReceived, telemetryTransmitted
+  },
+#if CDC_PORTS > 2
+  [CDC_PORT_DATA] = {
+    cdcRoleEcho, dataRing, dataLen,
+    CDC_DATA_BUF_CNT, CDC_DATA_BUF_SIZE,
+    dataReceived, dataTransmitted
+  },
+#endif
+};
+
+/**************************************************************************//**
+ * @brief
+ *    Buffer of a ring for a head or tail count
+ *****************************************************************************/
+static uint8_t *bufferOf(const cdcPortConfig_TypeDef *cfg, uint32_t count)
+{
+  return cfg->ring + ((count & (cfg->bufCnt - 1)) * cfg->bufSize);
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Port whose control interface a class request is addressed to
+ *
+ * @return
+ *    The port number, -1 if wIndex is not a CDC control interface.
+ *****************************************************************************/
+static int portOfInterface(uint16_t wIndex)
+{
+  int port;
+
+  for (port = 0; port < CDC_PORTS; port++) {
+    if (wIndex == CDC_CTRL_INTERFACE_NO(port)) {
+      return port;
+    }
+  }
+  return -1;
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Setup a USB receive transfer on the OUT endpoint of a port, if the
+ *    ring has a free buffer
+ *
+ * @note
+ *    Must be called with interrupts masked. While no read is set up the
+ *    device NAKs the host on this port only.
+ *****************************************************************************/
+static void rxStart(int port)
+{
+  const cdcPortConfig_TypeDef *cfg = &cdcPortConfig[port];
+  cdcPort_TypeDef *p = &cdcPort[port];
+
+  if (!configured || p->rxActive) {
+    return;
+  }
+
+  if (cfg->role == cdcRoleEcho) {
+    // Ring full, wait for a buffer to be sent back
+    if ((p->head - p->tail) == cfg->bufCnt) {
+      return;
+    }
+    p->rxActive = true;
+    USBD_Read(CDC_EP_DATA_OUT(port), (void*) bufferOf(cfg, p->head),
+              cfg->bufSize, cfg->rxDone);
+  } else {
+    p->rxActive = true;
+    USBD_Read(CDC_EP_DATA_OUT(port), (void*) drainBuffer,
+              USB_FS_BULK_EP_MAXSIZE, cfg->rxDone);
+  }
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Setup a USB transmit transfer on the IN endpoint of a port, if a
+ *    buffer is queued
+ *
+ * @note
+ *    Must be called with interrupts masked.
+ *****************************************************************************/
+static void txStart(int port)
+{
+  const cdcPortConfig_TypeDef *cfg = &cdcPortConfig[port];
+  cdcPort_TypeDef *p = &cdcPort[port];
+
+  if (!configured || p->txActive || (p->head == p->tail)) {
+    return;
+  }
+
+  p->txActive = true;
+  USBD_Write(CDC_EP_DATA_IN(port), (void*) bufferOf(cfg, p->tail),
+             cfg->bufLen[p->tail & (cfg->bufCnt - 1)], cfg->txDone);
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Queue the buffer cdcWrite() has been filling
+ *
+ * @note
+ *    Must be called with interrupts masked.
+ *****************************************************************************/
+static void queueFill(int port)
+{
+  const cdcPortConfig_TypeDef *cfg = &cdcPortConfig[port];
+  cdcPort_TypeDef *p = &cdcPort[port];
+
+  cfg->bufLen[p->head & (cfg->bufCnt - 1)] = p->fill;
+  p->head++;
+  p->fill = 0;
+  txStart(port);
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Callback that gets called when the data stage of a CDC_SET_LINECODING
+ *    setup command has completed
+ *
+ * @param[in] status
+ *    Transfer status code.
+ *
+ * @param[in] xferred
+ *    Number of bytes transferred.
+ *
+ * @param[in] remaining
+ *    Number of bytes not transferred.
+ *
+ * @return
+ *    USB_STATUS_OK if data accepted.
+ *    USB_STATUS_REQ_ERR if data calls for modes we can not support.
+ *****************************************************************************/
+static int lineCodingReceived(USB_Status_TypeDef status, uint32_t xferred, uint32_t remaining)
+{
+  (void) remaining;
+
+  if ((status != USB_STATUS_OK) || (xferred != 7)) {
+    return USB_STATUS_REQ_ERR;
+  }
+
+  // Check bDataBits, valid values are: 5, 6, 7, 8 or 16 bits
+  if (((lineCodingRx.bDataBits < 5) || (lineCodingRx.bDataBits > 8))
+      && (lineCodingRx.bDataBits != 16)) {
+    return USB_STATUS_REQ_ERR;
+  }
+
+  // Check bParityType, valid values are: 0=None 1=Odd 2=Even 3=Mark 4=Space
+  if (lineCodingRx.bParityType > 4) {
+    return USB_STATUS_REQ_ERR;
+  }
+
+  // Check bCharFormat, valid values are: 0=1 1=1.5 2=2 stop bits
+  if (lineCodingRx.bCharFormat > 2) {
+    return USB_STATUS_REQ_ERR;
+  }
+
+  cdcLineCoding[lineCodingPort] = lineCodingRx;
+  return USB_STATUS_OK;
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Callback that gets called whenever a USB setup command is received from
+ *    the host.
+ *
+ * @param[in] setup
+ *    Pointer to a USB setup packet
+ *
+ * @return
+ *    USB_STATUS_OK --> if command was accepted
+ *    USB_STATUS_REQ_UNHANDLED --> when command is unknown, the USB device
+ *                                 stack will handle the request.
+ *****************************************************************************/
+int cdcSetupCmd(const USB_Setup_TypeDef *setup)
+{
+  int retVal = USB_STATUS_REQ_UNHANDLED;
+  int port;
+  CORE_DECLARE_IRQ_STATE;
+
+  if ((setup->Type != USB_SETUP_TYPE_CLASS) || (setup->Recipient != USB_SETUP_RECIPIENT_INTERFACE)) {
+    return retVal;
+  }
+
+  // The interface number tells which port the request is for
+  port = portOfInterface(setup->wIndex);
+  if (port < 0) {
+    return retVal;
+  }
+
+  // Determine the type of setup request
+  switch (setup->bRequest) {
+
+    // USB host is trying to get the line coding settings of a port
+    case USB_CDC_GETLINECODING:
+      if ((setup->wValue == 0)
+            && (setup->wLength == 7)                    // Length of cdcLineCoding
+            && (setup->Direction == USB_SETUP_DIR_IN))  // Transfer direction (from host perspective)
+      {
+        USBD_Write(0, (void*) &cdcLineCoding[port], 7, NULL); // Send current settings to the host
+        retVal = USB_STATUS_OK;
+      }
+      break;
+
+    // USB host is trying to set the line coding settings of a port
+    case USB_CDC_SETLINECODING:
+      if ((setup->wValue == 0)
+            && (setup->wLength == 7)                    // Length of cdcLineCoding
+            && (setup->Direction == USB_SETUP_DIR_OUT)) // Transfer direction (from host perspective)
+      {
+        lineCodingPort = port;
+        USBD_Read(0, (void*) &lineCodingRx, 7, lineCodingReceived); // Get new settings from the host
+        retVal = USB_STATUS_OK;
+      }
+      break;
+
+    // RS-232 signal used to tell the DCE device the DTE device is now present
+    case USB_CDC_SETCTRLLINESTATE:
+      if (setup->wLength == 0) {                         // No data
+        CORE_ENTER_ATOMIC();
+        cdcPort[port].open = (setup->wValue & 1) != 0;   // D0: DTR
+
+        // A closed source port drops what has not been handed to USB yet,
+        // so the next open starts with fresh data
+        if (!cdcPort[port].open && (cdcPortConfig[port].role == cdcRoleSource)) {
+          cdcPort[port].fill = 0;
+          cdcPort[port].head = cdcPort[port].tail + (cdcPort[port].txActive ? 1 : 0);
+        }
+        CORE_EXIT_ATOMIC();
+        retVal = USB_STATUS_OK;
+      }
+      break;
+  }
+
+  return retVal;
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Callback that gets called each time the USB device state is changed.
+ *    Also starts CDC operation on all ports once the device has been
+ *    configured by the USB host.
+ *
+ * @details
+ *    A resume from the suspended state to the configured state keeps the
+ *    rings as they are, the transfers set up before the suspend carry on.
+ *    Any other transition to the configured state starts all ports afresh.
+ *
+ * @note
+ *    Refer to section 4 of the AN0065 USB Device application note for the
+ *    USB stack's state machine
+ *
+ * @param[in] oldState
+ *    The old USB device state
+ *
+ * @param[in] newState
+ *    The new (current) USB device state
+ *****************************************************************************/
+void cdcStateChangeEvent(USBD_State_TypeDef oldState, USBD_State_TypeDef newState)
+{
+  int port;
+  CORE_DECLARE_IRQ_STATE;
+
+  CORE_ENTER_ATOMIC();
+
+  // If the USB device was configured
+  if (newState == USBD_STATE_CONFIGURED) {
+    if (oldState != USBD_STATE_SUSPENDED) {
+      configured = true;
+      for (port = 0; port < CDC_PORTS; port++) {
+        cdcPort[port].head     = 0;
+        cdcPort[port].tail     = 0;
+        cdcPort[port].fill     = 0;
+        cdcPort[port].rxActive = false;
+        cdcPort[port].txActive = false;
+        cdcPort[port].open     = false;
+
+        // Setup a new USB receive transfer on each port's OUT endpoint
+        rxStart(port);
+      }
+    }
+  }
+  // Else if we have been de-configured, the stack has aborted all transfers
+  else if ((oldState == USBD_STATE_CONFIGURED) && (newState != USBD_STATE_SUSPENDED)) {
+    configured = false;
+  }
+
+  CORE_EXIT_ATOMIC();
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Called whenever data is received from the host on the OUT endpoint of
+ *    a port
+ *
+ * @param[in] port
+ *    Port of the endpoint
+ *
+ * @param[in] status
+ *    Transfer status code
+ *
+ * @param[in] xferred
+ *    Number of bytes transferred
+ *
+ * @return
+ *    USB_STATUS_OK
+ *****************************************************************************/
+static int portReceived(int port, USB_Status_TypeDef status, uint32_t xferred)
+{
+  const cdcPortConfig_TypeDef *cfg = &cdcPortConfig[port];
+  cdcPort_TypeDef *p = &cdcPort[port];
+  CORE_DECLARE_IRQ_STATE;
+
+  // Transfers aborted by a reset or a configuration change are not restarted
+  if (status != USB_STATUS_OK) {
+    return USB_STATUS_OK;
+  }
+
+  CORE_ENTER_ATOMIC();
+
+  p->rxActive = false;
+  cdcStats[port].rxBytes += xferred;
+  cdcStats[port].rxXfers++;
+
+  // An echo port sends the packet back from the buffer it arrived in and
+  // receives the next packet into the next buffer of the ring
+  if ((cfg->role == cdcRoleEcho) && (xferred > 0)) {
+    cfg->bufLen[p->head & (cfg->bufCnt - 1)] = xferred;
+    p->head++;
+    txStart(port);
+  }
+
+  rxStart(port);
+
+  CORE_EXIT_ATOMIC();
+  return USB_STATUS_OK;
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Called whenever a buffer has been transmitted to the host on the IN
+ *    endpoint of a port
+ *
+ * @param[in] port
+ *    Port of the endpoint
+ *
+ * @param[in] status
+ *    Transfer status code
+ *
+ * @param[in] xferred
+ *    Number of bytes transferred
+ *
+ * @return
+ *    USB_STATUS_OK
+ *****************************************************************************/
+static int portTransmitted(int port, USB_Status_TypeDef status, uint32_t xferred)
+{
+  cdcPort_TypeDef *p = &cdcPort[port];
+  CORE_DECLARE_IRQ_STATE;
+
+  if (status != USB_STATUS_OK) {
+    return USB_STATUS_OK;
+  }
+
+  CORE_ENTER_ATOMIC();
+
+  p->txActive = false;
+  p->tail++;
+  cdcStats[port].txBytes += xferred;
+  cdcStats[port].txXfers++;
+
+  // The buffer is free again, send the next one and receive into it
+  txStart(port);
+  rxStart(port);
+
+  CORE_EXIT_ATOMIC();
+  return USB_STATUS_OK;
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Queue data to send on a source port
+ *
+ * @details
+ *    The data is copied into the port's ring, a buffer at a time with
+ *    interrupts masked. Full buffers are sent right away, call cdcFlush()
+ *    to send a partly filled one. Never waits for the USB.
+ *
+ * @param[in] port
+ *    A port with the source role, such as CDC_PORT_TELEMETRY
+ *
+ * @param[in] data
+ *    Data to send
+ *
+ * @param[in] length
+ *    Number of bytes
+ *
+ * @return
+ *    Number of bytes queued, less than length if the ring is full or the
+ *    port is not open. The rest is counted in cdcStats_TypeDef.dropped.
+ *****************************************************************************/
+uint32_t cdcWrite(int port, const void *data, uint32_t length)
+{
+  const cdcPortConfig_TypeDef *cfg = &cdcPortConfig[port];
+  cdcPort_TypeDef *p = &cdcPort[port];
+  const uint8_t *src = (const uint8_t *) data;
+  uint32_t done = 0;
+  uint32_t n;
+  CORE_DECLARE_IRQ_STATE;
+
+  if (cfg->role != cdcRoleSource) {
+    return 0;
+  }
+
+  while (done < length) {
+    CORE_ENTER_ATOMIC();
+
+    if (!configured || !p->open || ((p->head - p->tail) == cfg->bufCnt)) {
+      CORE_EXIT_ATOMIC();
+      break;
+    }
+
+    n = cfg->bufSize - p->fill;
+    if (n > length - done) {
+      n = length - done;
+    }
+    memcpy(bufferOf(cfg, p->head) + p->fill, src + done, n);
+    p->fill += n;
+    done += n;
+
+    if (p->fill == cfg->bufSize) {
+      queueFill(port);
+    }
+
+    CORE_EXIT_ATOMIC();
+  }
+
+  if (done < length) {
+    CORE_ENTER_ATOMIC();
+    cdcStats[port].dropped += length - done;
+    CORE_EXIT_ATOMIC();
+  }
+
+  return done;
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Bytes cdcWrite() can queue on a port without dropping any
+ *
+ * @return
+ *    0 if the port is not a source port or is not open.
+ *****************************************************************************/
+uint32_t cdcWriteSpace(int port)
+{
+  const cdcPortConfig_TypeDef *cfg = &cdcPortConfig[port];
+  cdcPort_TypeDef *p = &cdcPort[port];
+  uint32_t space = 0;
+  CORE_DECLARE_IRQ_STATE;
+
+  CORE_ENTER_ATOMIC();
+  if ((cfg->role == cdcRoleSource) && configured && p->open) {
+    space = ((cfg->bufCnt - (p->head - p->tail)) * cfg->bufSize) - p->fill;
+  }
+  CORE_EXIT_ATOMIC();
+
+  return space;
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Send the partly filled buffer of a source port
+ *****************************************************************************/
+void cdcFlush(int port)
+{
+  cdcPort_TypeDef *p = &cdcPort[port];
+  CORE_DECLARE_IRQ_STATE;
+
+  CORE_ENTER_ATOMIC();
+  if (configured && (p->fill > 0)) {
+    queueFill(port);
+  }
+  CORE_EXIT_ATOMIC();
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Whether the host has opened a port (set DTR) in the current
+ *    configuration
+ *****************************************************************************/
+bool cdcIsOpen(int port)
+{
+  return configured && cdcPort[port].open;
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Copy the counters of a port
+ *****************************************************************************/
+void cdcGetStats(int port, cdcStats_TypeDef *stats)
+{
+  CORE_DECLARE_IRQ_STATE;
+
+  CORE_ENTER_ATOMIC();
+  *stats = cdcStats[port];
+  CORE_EXIT_ATOMIC();
+}
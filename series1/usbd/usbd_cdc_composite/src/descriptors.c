@@ -0,0 +1,263 @@
+/***************************************************************************//**
+ * @file descriptors.c
+ * @brief Global descriptors that describe the composite CDC device to the
+ * host.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2020 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ *******************************************************************************
+ * # Evaluation Quality
+ * This code has been minimally tested to ensure that it builds and is suitable 
+ * as a demonstration for evaluation purposes only. This code will be maintained
+ * at the sole discretion of Silicon Labs.
+ ******************************************************************************/
+
+#include "descriptors.h"
+
+// Interface Association descriptor, groups the two interfaces of one port so
+// the host binds one CDC ACM driver to each pair
+#define USB_IAD_DESCSIZE           8
+#define USB_IAD_DESCRIPTOR         0x0B
+#define USB_CLASS_MISC             0xEF
+#define USB_MISC_COMMON            0x02
+#define USB_MISC_PROTOCOL_IAD      0x01
+
+/****************************************************************************
+ * Device Descriptor                                                        *
+ ****************************************************************************/
+SL_ALIGN(4)
+const USB_DeviceDescriptor_TypeDef USBDESC_deviceDesc SL_ATTRIBUTE_ALIGN(4) = {
+  .bLength            = USB_DEVICE_DESCSIZE,    // Descriptor size in bytes
+  .bDescriptorType    = USB_DEVICE_DESCRIPTOR,  // Descriptor type
+  .bcdUSB             = 0x0200,                 // USB version (0200 in BCD = USB 2.0)
+  .bDeviceClass       = USB_CLASS_MISC,         // Class code: functions described by IADs
+  .bDeviceSubClass    = USB_MISC_COMMON,        // Subclass code
+  .bDeviceProtocol    = USB_MISC_PROTOCOL_IAD,  // Protocol code
+  .bMaxPacketSize0    = USB_FS_CTRL_EP_MAXSIZE, // Max packet size for EP0
+  .idVendor           = 0x10C4,                 // Vendor ID
+  .idProduct          = 0x0008,                 // Product ID
+  .bcdDevice          = 0x0000,                 // Release number in BCD
+  .iManufacturer      = 1,                      // Index of string descriptor for manufacturer
+  .iProduct           = 2,                      // Index of string descriptor for product
+  .iSerialNumber      = 0,                      // Index of string descriptor for manufacturer
+  .bNumConfigurations = 1                       // Number of supported configurations
+};
+
+/****************************************************************************
+ * Configuration Descriptor Length Calculation                              *
+ ****************************************************************************/
+#define USB_CDC_UNION_FND_DSSCSIZE 5
+
+#define CDC_FUNCTION_DESC_LEN            \
+  (USB_IAD_DESCSIZE                      \
+   + (USB_INTERFACE_DESCSIZE * 2)        \
+   + (USB_ENDPOINT_DESCSIZE  * 3)        \
+   + USB_CDC_HEADER_FND_DESCSIZE         \
+   + USB_CDC_CALLMNG_FND_DESCSIZE        \
+   + USB_CDC_ACM_FND_DESCSIZE            \
+   + USB_CDC_UNION_FND_DSSCSIZE)
+
+#define CONFIG_DESC_TOTAL_LEN \
+  (USB_CONFIG_DESCSIZE + (CDC_FUNCTION_DESC_LEN * CDC_PORTS))
+
+// First string descriptor index of the port names
+#define PORT_STRING_INDEX          4
+
+/****************************************************************************
+ * Descriptors of one CDC ACM function, n is the port number               *
+ ****************************************************************************/
+#define CDC_FUNCTION_DESC(n)                                                   \
+  /* Interface Association descriptor */                                       \
+  USB_IAD_DESCSIZE,             /* bLength */                                  \
+  USB_IAD_DESCRIPTOR,           /* bDescriptorType */                          \
+  CDC_CTRL_INTERFACE_NO(n),     /* bFirstInterface */                          \
+  2,                            /* bInterfaceCount */                          \
+  USB_CLASS_CDC,                /* bFunctionClass */                           \
+  USB_CLASS_CDC_ACM,            /* bFunctionSubClass */                        \
+  0,                            /* bFunctionProtocol */                        \
+  PORT_STRING_INDEX + (n),      /* iFunction */                                \
+                                                                               \
+  /* CDC Communication CTRL Interface descriptor */                            \
+  USB_INTERFACE_DESCSIZE,       /* bLength */                                  \
+  USB_INTERFACE_DESCRIPTOR,     /* bDescriptorType */                          \
+  CDC_CTRL_INTERFACE_NO(n),     /* bInterfaceNumber */                         \
+  0,                            /* bAlternateSetting */                        \
+  1,                            /* bNumEndpoints */                            \
+  USB_CLASS_CDC,                /* bInterfaceClass */                          \
+  USB_CLASS_CDC_ACM,            /* bInterfaceSubClass */                       \
+  0,                            /* bInterfaceProtocol */                       \
+  PORT_STRING_INDEX + (n),      /* iInterface */                               \
+                                                                               \
+  /* CDC Header Functional descriptor */                                       \
+  USB_CDC_HEADER_FND_DESCSIZE,  /* bFunctionLength */                          \
+  USB_CS_INTERFACE_DESCRIPTOR,  /* bDescriptorType */                          \
+  USB_CLASS_CDC_HFN,            /* bDescriptorSubtype */                       \
+  0x20,                         /* bcdCDC spec.no LSB */                       \
+  0x01,                         /* bcdCDC spec.no MSB */                       \
+                                                                               \
+  /* CDC Call Management Functional descriptor */                              \
+  USB_CDC_CALLMNG_FND_DESCSIZE, /* bFunctionLength */                          \
+  USB_CS_INTERFACE_DESCRIPTOR,  /* bDescriptorType */                          \
+  USB_CLASS_CDC_CMNGFN,         /* bDescriptorSubtype */                       \
+  0,                            /* bmCapabilities */                           \
+  CDC_DATA_INTERFACE_NO(n),     /* bDataInterface */                           \
+                                                                               \
+  /* CDC Abstract Control Management Functional descriptor */                  \
+  USB_CDC_ACM_FND_DESCSIZE,     /* bFunctionLength */                          \
+  USB_CS_INTERFACE_DESCRIPTOR,  /* bDescriptorType */                          \
+  USB_CLASS_CDC_ACMFN,          /* bDescriptorSubtype */                       \
+  0x02,                         /* bmCapabilities: line coding and state */    \
+                                                                               \
+  /* CDC Union Functional descriptor */                                        \
+  USB_CDC_UNION_FND_DSSCSIZE,   /* bFunctionLength */                          \
+  USB_CS_INTERFACE_DESCRIPTOR,  /* bDescriptorType */                          \
+  USB_CLASS_CDC_UNIONFN,        /* bDescriptorSubtype */                       \
+  CDC_CTRL_INTERFACE_NO(n),     /* bControlInterface */                        \
+  CDC_DATA_INTERFACE_NO(n),     /* bSubordinateInterface0 */                   \
+                                                                               \
+  /* CDC Notification endpoint descriptor (IN) (INTERRUPT) */                  \
+  USB_ENDPOINT_DESCSIZE,        /* bLength */                                  \
+  USB_ENDPOINT_DESCRIPTOR,      /* bDescriptorType */                          \
+  CDC_EP_NOTIFY(n),             /* bEndpointAddress (IN) */                    \
+  USB_EPTYPE_INTR,              /* bmAttributes */                             \
+  USB_FS_INTR_EP_MAXSIZE,       /* wMaxPacketSize (LSB) */                     \
+  0,                            /* wMaxPacketSize (MSB) */                     \
+  0xFF,                         /* bInterval */                                \
+                                                                               \
+  /* CDC Data Interface descriptor */                                          \
+  USB_INTERFACE_DESCSIZE,       /* bLength */                                  \
+  USB_INTERFACE_DESCRIPTOR,     /* bDescriptorType */                          \
+  CDC_DATA_INTERFACE_NO(n),     /* bInterfaceNumber */                         \
+  0,                            /* bAlternateSetting */                        \
+  2,                            /* bNumEndpoints */                            \
+  USB_CLASS_CDC_DATA,           /* bInterfaceClass */                          \
+  0,                            /* bInterfaceSubClass */                       \
+  0,                            /* bInterfaceProtocol */                       \
+  0,                            /* iInterface */                               \
+                                                                               \
+  /* CDC Data interface endpoint descriptor (IN) (BULK) */                     \
+  USB_ENDPOINT_DESCSIZE,        /* bLength */                                  \
+  USB_ENDPOINT_DESCRIPTOR,      /* bDescriptorType */                          \
+  CDC_EP_DATA_IN(n),            /* bEndpointAddress (IN) */                    \
+  USB_EPTYPE_BULK,              /* bmAttributes */                             \
+  USB_FS_BULK_EP_MAXSIZE,       /* wMaxPacketSize (LSB) */                     \
+  0,                            /* wMaxPacketSize (MSB) */                     \
+  0,                            /* bInterval */                                \
+                                                                               \
+  /* CDC Data interface endpoint descriptor (OUT) (BULK) */                    \
+  USB_ENDPOINT_DESCSIZE,        /* bLength */                                  \
+  USB_ENDPOINT_DESCRIPTOR,      /* bDescriptorType */                          \
+  CDC_EP_DATA_OUT(n),           /* bEndpointAddress (OUT) */                   \
+  USB_EPTYPE_BULK,              /* bmAttributes */                             \
+  USB_FS_BULK_EP_MAXSIZE,       /* wMaxPacketSize (LSB) */                     \
+  0,                            /* wMaxPacketSize (MSB) */                     \
+  0                             /* bInterval */
+
+/****************************************************************************
+ * Configuration Descriptor and Subordinate Descriptors                     *
+ *  - One Interface Association per port, each with its Interface and       *
+ *    Endpoint Descriptors                                                  *
+ ****************************************************************************/
+SL_ALIGN(4)
+const uint8_t USBDESC_configDesc[] SL_ATTRIBUTE_ALIGN(4) = {
+
+  // Configuration descriptor
+  USB_CONFIG_DESCSIZE,          // bLength
+  USB_CONFIG_DESCRIPTOR,        // bDescriptorType
+  CONFIG_DESC_TOTAL_LEN,        // wTotalLength (LSB)
+  CONFIG_DESC_TOTAL_LEN >> 8,   // wTotalLength (MSB)
+  NUM_INTERFACES,               // bNumInterfaces
+  1,                            // bConfigurationValue
+  0,                            // iConfiguration
+  CONFIG_DESC_BM_RESERVED_D7    // bmAttrib: Self powered
+  | CONFIG_DESC_BM_SELFPOWERED,
+  CONFIG_DESC_MAXPOWER_mA(100), // bMaxPower: 100 mA
+
+  CDC_FUNCTION_DESC(CDC_PORT_CONSOLE),
+  CDC_FUNCTION_DESC(CDC_PORT_TELEMETRY),
+#if CDC_PORTS > 2
+  CDC_FUNCTION_DESC(CDC_PORT_DATA),
+#endif
+};
+
+/****************************************************************************
+ * Optional String Descriptors                                              *
+ ****************************************************************************/
+STATIC_CONST_STRING_DESC_LANGID(langID, 0x04, 0x09); // English
+STATIC_CONST_STRING_DESC(iManufacturer,
+                         'S', 'i', 'l', 'i', 'c', 'o', 'n', ' ', \
+                         'L', 'a', 'b', 'o', 'r', 'a', 't', 'o', 'r', 'i', 'e', 's', ' ', \
+                         'I', 'n', 'c', '.');
+STATIC_CONST_STRING_DESC(iProduct,
+                         'E', 'F', 'M', '3', '2', ' ', \
+                         'U', 'S', 'B', ' ', \
+                         'C', 'D', 'C', ' ', \
+                         'C', 'o', 'm', 'p', 'o', 's', 'i', 't', 'e');
+STATIC_CONST_STRING_DESC(iSerialNumber,
+                         '0', '0', '0', '0', '1', '2', \
+                         '3', '4', '5', '6', '7', '8');
+STATIC_CONST_STRING_DESC(iConsole,
+                         'C', 'o', 'n', 's', 'o', 'l', 'e');
+STATIC_CONST_STRING_DESC(iTelemetry,
+                         'T', 'e', 'l', 'e', 'm', 'e', 't', 'r', 'y');
+#if CDC_PORTS > 2
+STATIC_CONST_STRING_DESC(iData,
+                         'D', 'a', 't', 'a');
+#endif
+const void* const USBDESC_strings[USBDESC_STRING_COUNT] = {
+  &langID,
+  &iManufacturer,
+  &iProduct,
+  &iSerialNumber,
+  &iConsole,   // PORT_STRING_INDEX + CDC_PORT_CONSOLE
+  &iTelemetry, // PORT_STRING_INDEX + CDC_PORT_TELEMETRY
+#if CDC_PORTS > 2
+  &iData,      // PORT_STRING_INDEX + CDC_PORT_DATA
+#endif
+};
+
+/****************************************************************************
+ * Endpoint Buffer Size                                                     *
+ ****************************************************************************/
+// Each multiplier value specifies how much RAM to allocate for each endpoint's
+// FIFO. 1 should be used for control/interrupt endpoints and 2 or more for bulk
+// endpoints. Each number represents X times the endpoint size (e.g. 2 means
+// the RAM allocated will be equal to 2 times the endpoint size). The entries
+// follow the order of the endpoint descriptors in USBDESC_configDesc. The bulk
+// endpoint values of each port are set in usbconfig.h.
+const uint8_t USBDESC_bufferingMultiplier[NUM_EP_USED + 1] = {
+  1,                        // Common Control endpoint
+  1,                        // Console interrupt endpoint
+  CDC_CONSOLE_BUFFERING,    // Console bulk IN endpoint
+  CDC_CONSOLE_BUFFERING,    // Console bulk OUT endpoint
+  1,                        // Telemetry interrupt endpoint
+  CDC_TELEMETRY_BUFFERING,  // Telemetry bulk IN endpoint
+  1,                        // Telemetry bulk OUT endpoint, only drained
+#if CDC_PORTS > 2
+  1,                        // Data interrupt endpoint
+  CDC_DATA_BUFFERING,       // Data bulk IN endpoint
+  CDC_DATA_BUFFERING        // Data bulk OUT endpoint
+#endif
+};
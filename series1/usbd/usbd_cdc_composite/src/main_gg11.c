@@ -0,0 +1,120 @@
+/***************************************************************************//**
+ * @file main_gg11.c
+ * @brief USB CDC composite device example with separate ports for a console,
+ * a telemetry stream and bulk data. The console and data ports echo what the
+ * host sends, the telemetry port streams sequence numbers to the host. Each
+ * port has its own endpoints and ring of buffers, so a busy stream does not
+ * hold up the console.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2020 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ *******************************************************************************
+ * # Evaluation Quality
+ * This code has been minimally tested to ensure that it builds and is suitable 
+ * as a demonstration for evaluation purposes only. This code will be maintained
+ * at the sole discretion of Silicon Labs.
+ ******************************************************************************/
+
+// Generic includes
+#include "em_device.h"
+#include "em_cmu.h"
+#include "em_emu.h"
+#include "em_chip.h"
+#include "em_core.h"
+
+// USB specific includes
+#include "em_usb.h"
+#include "cdc_composite.h"
+#include "descriptors.h"
+
+// Telemetry block, sequence numbers counting up so the host can check that
+// nothing was lost. Written whole, so a block is never split by a full ring.
+#define TELEMETRY_WORDS  64
+static uint32_t telemetry[TELEMETRY_WORDS];
+static uint32_t sequence;
+
+/***************************************************************************//**
+ * @brief
+ *    Main
+ ******************************************************************************/
+int main(void)
+{
+  // Chip errata
+  CHIP_Init();
+
+  // Init DCDC regulator with kit specific parameters
+  EMU_DCDCInit_TypeDef dcdcInit = EMU_DCDCINIT_DEFAULT;
+  EMU_DCDCInit(&dcdcInit);
+
+  // Set the callback functions (see src/cdc_composite.c)
+  const USBD_Callbacks_TypeDef callbacks = {
+    .usbReset        = NULL,
+    .usbStateChange  = cdcStateChangeEvent, // Called when the device changes state
+    .setupCmd        = cdcSetupCmd,         // Called on each setup request from the host
+    .isSelfPowered   = NULL,
+    .sofInt          = NULL
+  };
+
+  // Set the initialization struct descriptors (see src/descriptors.c)
+  const USBD_Init_TypeDef usbInitStruct = {
+    .deviceDescriptor    = &USBDESC_deviceDesc,
+    .configDescriptor    = USBDESC_configDesc,
+    .stringDescriptors   = USBDESC_strings,
+    .numberOfStrings     = sizeof(USBDESC_strings) / sizeof(void*),
+    .callbacks           = &callbacks,
+    .bufferingMultiplier = USBDESC_bufferingMultiplier,
+    .reserved            = 0
+  };
+
+  // Initialize and start USB device stack
+  USBD_Init(&usbInitStruct);
+
+  // Stream telemetry while the host has the port open, the console and
+  // data ports echo from their own rings in the USB interrupt meanwhile
+  while (1) {
+    if (cdcWriteSpace(CDC_PORT_TELEMETRY) >= sizeof(telemetry)) {
+      for (int i = 0; i < TELEMETRY_WORDS; i++) {
+        telemetry[i] = sequence++;
+      }
+      cdcWrite(CDC_PORT_TELEMETRY, telemetry, sizeof(telemetry));
+    } else {
+      // Each open starts again at 0
+      if (!cdcIsOpen(CDC_PORT_TELEMETRY)) {
+        sequence = 0;
+      }
+
+      // Enter EM1 to save energy until the USB interrupt frees a buffer.
+      // Interrupts are masked so one cannot slip in between the check and
+      // the sleep; a pending interrupt still wakes the core.
+      CORE_DECLARE_IRQ_STATE;
+      CORE_ENTER_CRITICAL();
+      if (cdcWriteSpace(CDC_PORT_TELEMETRY) < sizeof(telemetry)) {
+        EMU_EnterEM1();
+      }
+      CORE_EXIT_CRITICAL();
+    }
+  }
+}
+
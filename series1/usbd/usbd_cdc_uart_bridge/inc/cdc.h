@@ -29,10 +29,35 @@
 extern "C" {
 #endif
 
+#ifndef CDC_THROUGHPUT_RATES
+#define CDC_THROUGHPUT_RATES  8   /**< Baud rates kept in the throughput table */
+#endif
+
+/** Bridge throughput measured at one baud rate. */
+typedef struct {
+  uint32_t baudRate;        /**< Baud rate set by the host */
+  uint32_t seconds;         /**< Seconds with traffic in either direction */
+  uint32_t uartToUsbBytes;  /**< Bytes received on the UART and sent on USB */
+  uint32_t usbToUartBytes;  /**< Bytes received on USB and sent on the UART */
+  uint32_t uartToUsbWrites; /**< USB transfers used for uartToUsbBytes */
+  uint32_t usbToUartReads;  /**< USB transfers armed for usbToUartBytes */
+  uint32_t uartToUsbPeak;   /**< Highest UART to USB rate in bytes/s */
+  uint32_t usbToUartPeak;   /**< Highest USB to UART rate in bytes/s */
+  uint32_t rxStalls;        /**< Times the UART receive ring was full */
+  uint32_t rtsHolds;        /**< Times RTS was deasserted at the high water mark */
+  uint32_t rxOverflows;     /**< Seconds with a UART receive overflow */
+} CDC_Throughput_TypeDef;
+
+/** Sources of the interrupt statistics, entries of the priority plan */
+#define CDC_IRQ_SOURCE_LDMA   0   /**< LDMA_IRQHandler() */
+#define CDC_IRQ_SOURCE_STREAM 1   /**< Stress test sample stream */
+
 void CDC_Init(void);
 int  CDC_SetupCmd(const USB_Setup_TypeDef *setup);
 void CDC_StateChangeEvent(USBD_State_TypeDef oldState,
                           USBD_State_TypeDef newState);
+const CDC_Throughput_TypeDef *CDC_GetThroughput(int *count);
+bool CDC_SafeToEnterEM2(void);
 
 #ifdef __cplusplus
 }
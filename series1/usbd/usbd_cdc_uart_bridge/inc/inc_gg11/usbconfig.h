@@ -71,6 +71,9 @@ extern "C" {
 // (clocked by 32 kHz clock) whenever the USB enters suspend mode. If ONVBUSOFF is set, the
 // USB controller will automatically enter low power mode whenever power is lost
 // on VBUS. This requires that the USB regulator is used and that VREGI is connected to VBUS.
+// In low power mode the USB clocks are gated and USBD_SafeToEnterEM2() returns true, the
+// main loop then enters EM2. The USB core keeps its endpoint state, so on resume the stack
+// restores the 48 MHz clock and the transfers set up before the suspend carry on.
 // Needed for emusb/em_usbd.c and emusb/em_usbdint.c
 #define USB_PWRSAVE_MODE (USB_PWRSAVE_MODE_ONSUSPEND | USB_PWRSAVE_MODE_ONVBUSOFF)
 
@@ -80,15 +83,36 @@ extern "C" {
 #define NUM_EP_USED      3
 
 // Specify the number of application timers needed
-// This must at least be 1 for the UartRxTimeout() functionality provided in the Drivers/cdc.c code
+// This must at least be 2, one for the UartRxTimeout() functionality and one for the
+// throughput statistics provided in the src/cdc_gg11.c code
 // Needed for emusb/em_usbtimer.c
-#define NUM_APP_TIMERS   1
+#define NUM_APP_TIMERS   2
 
 // Specify which timer to use for the CDC UartRxTimeout() timer
 // This #define chooses Timer0 by default
 // Needed for Drivers/cdc.c
 #define CDC_TIMER_ID     0
 
+// Specify which timer to use for sampling the throughput once per second
+// Needed for src/cdc_gg11.c
+#define CDC_STATS_TIMER_ID  1
+
+// Ring buffer configuration, the number and size of the buffers in each direction
+// USB OUT buffers must be a multiple of the 64 byte endpoint size
+// Needed for src/cdc_gg11.c
+#define CDC_USB_RX_BUF_CNT  4     // USB OUT to UART TX buffers
+#define CDC_USB_RX_BUF_SIZ  256   // Bytes per USB read
+#define CDC_USB_TX_BUF_CNT  4     // UART RX to USB IN buffers
+#define CDC_USB_TX_BUF_SIZ  255   // Bytes per USB write
+
+// Buffers of the USB OUT ring one USB read may span, and the RAM allocated
+// for the bulk OUT endpoint FIFO in multiples of the 64 byte endpoint size.
+// A read over several buffers takes the packets of a long host transfer back
+// to back, without the NAK time of arming a read per buffer.
+// Needed for src/cdc_gg11.c and src/descriptors.c
+#define CDC_USB_RX_SPAN         4
+#define CDC_BULK_OUT_BUFFERING  4
+
 // Define the interface numbers
 // Needed for Drivers/cdc.c
 #define CDC_CTRL_INTERFACE_NO   0
@@ -122,6 +146,38 @@ extern "C" {
 #define CDC_UART_RX_PORT            gpioPortE
 #define CDC_UART_RX_PIN             11
 
+// Hardware flow control options
+// CTS is handled by the USART and holds back UART TX while the far end is busy,
+// RTS is a GPIO deasserted when the UART RX ring reaches its high water mark
+// Set CDC_FLOW_CONTROL to 0 when CTS/RTS are not connected
+// Needed for src/cdc_gg11.c
+#define CDC_FLOW_CONTROL            1
+#define CDC_UART_CTS_PORT           gpioPortE
+#define CDC_UART_CTS_PIN            14
+#define CDC_UART_RTS_PORT           gpioPortE
+#define CDC_UART_RTS_PIN            15
+#define CDC_UART_ROUTELOC1          USART_ROUTELOC1_CTSLOC_LOC0
+#define CDC_RX_HIGH_WATER           (CDC_USB_TX_BUF_CNT - 1)  // Buffers waiting for USB to deassert RTS
+#define CDC_RX_LOW_WATER            (CDC_USB_TX_BUF_CNT - 2)  // Buffers waiting for USB to assert RTS
+
+// Interrupt priorities, 0 the most urgent, see readme.txt
+// The project sets CORE_ATOMIC_BASE_PRIORITY_LEVEL to CDC_IRQ_PRIO_LDMA, so the
+// emlib and USB stack critical sections mask these and leave level 0 running
+// Needed for src/main_gg11.c
+#define CDC_IRQ_PRIO_LDMA           1     // UART RX ring and UART TX
+#define CDC_IRQ_PRIO_USB            2     // USB stack
+#define CDC_IRQ_PRIO_TIMER          3     // em_usbtimer.c, UartRxTimeout()
+
+// Interrupt stress test, set CDC_IRQ_STRESS to 1 to build it in
+// A TIMER interrupt at level 0 and CDC_STRESS_RATE stands in for a sample stream,
+// handled by TIMER1_IRQHandler() in src/main_gg11.c
+// Needed for src/main_gg11.c and src/cdc_gg11.c
+#define CDC_IRQ_STRESS              0
+#define CDC_STRESS_TIMER            TIMER1
+#define CDC_STRESS_TIMER_CLOCK      cmuClock_TIMER1
+#define CDC_STRESS_TIMER_IRQn       TIMER1_IRQn
+#define CDC_STRESS_RATE             48000 // Samples per second
+
 // This define is used in Drivers/cdc.c, but it is left as an empty define since
 // we are using the STK (starter kit) instead of the DK (development kit)
 #define CDC_ENABLE_DK_UART_SWITCH()
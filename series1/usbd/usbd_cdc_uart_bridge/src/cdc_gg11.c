@@ -33,6 +33,7 @@
  * at the sole discretion of Silicon Labs.
  ******************************************************************************/
 
+#include <string.h>
 #include "em_device.h"
 #include "em_common.h"
 #include "em_cmu.h"
@@ -42,6 +43,9 @@
 #include "em_usart.h"
 #include "em_usb.h"
 #include "cdc.h"
+#if CDC_IRQ_STRESS
+#include "irqprio.h"
+#endif
 
 /* *INDENT-OFF* */
 /**************************************************************************//**
@@ -115,13 +119,81 @@
 /*** Typedef's and defines. ***/
 
 #define CDC_BULK_EP_SIZE  (USB_FS_BULK_EP_MAXSIZE) // This is the max. ep size.
-#define CDC_USB_RX_BUF_SIZ  CDC_BULK_EP_SIZE // Packet size when receiving on USB.
-#define CDC_USB_TX_BUF_SIZ  127    // Packet size when transmitting on USB.
 
-// Calculate a timeout in ms corresponding to 5 char times on current
-// baudrate. Minimum timeout is set to 10 ms.
+// Host to device (USB OUT to UART TX) ring. One USB read spans up to
+// CDC_USB_RX_SPAN free buffers next to each other, and each buffer it fills
+// is sent to the UART straight from the ring by the TX LDMA channel.
+#ifndef CDC_USB_RX_BUF_CNT
+#define CDC_USB_RX_BUF_CNT  4
+#endif
+#ifndef CDC_USB_RX_BUF_SIZ
+#define CDC_USB_RX_BUF_SIZ  (4 * CDC_BULK_EP_SIZE) // Must be a multiple of the ep size.
+#endif
+#ifndef CDC_USB_RX_SPAN
+#define CDC_USB_RX_SPAN     CDC_USB_RX_BUF_CNT
+#endif
+
+// Device to host (UART RX to USB IN) ring. The RX LDMA channel runs through
+// a circular chain of descriptors, one per buffer, and each filled buffer is
+// passed to USBD_Write() as it is. Keep the size one short of a multiple of
+// the ep size so a full buffer always ends with a short packet.
+#ifndef CDC_USB_TX_BUF_CNT
+#define CDC_USB_TX_BUF_CNT  4
+#endif
+#ifndef CDC_USB_TX_BUF_SIZ
+#define CDC_USB_TX_BUF_SIZ  255    // Packet size when transmitting on USB.
+#endif
+
+// USB buffers must be word aligned
+#define CDC_USB_TX_BUF_STRIDE  ((CDC_USB_TX_BUF_SIZ + 3) & ~3)
+
+#if (CDC_USB_RX_BUF_SIZ % CDC_BULK_EP_SIZE) || (CDC_USB_RX_BUF_SIZ > 2048) \
+  || (CDC_USB_TX_BUF_SIZ > 2048) || (CDC_USB_RX_BUF_CNT < 2) || (CDC_USB_TX_BUF_CNT < 2)
+#error "CDC ring buffers must be 2 or more buffers of at most 2048 bytes"
+#endif
+
+#if (CDC_USB_RX_SPAN < 1) || (CDC_USB_RX_SPAN > CDC_USB_RX_BUF_CNT)
+#error "CDC_USB_RX_SPAN must be from 1 to CDC_USB_RX_BUF_CNT buffers"
+#endif
+
+// The UART RX ring is checked every CDC_RX_TICK ms. A partial buffer is sent
+// on USB once the line has been idle for an adaptive time between
+// CDC_RX_IDLE_MIN and CDC_RX_TIMEOUT, see UartRxIdleLimit().
+#define CDC_RX_TICK       1
+
+// Shortest idle time in ms, 2 char times on current baudrate.
+#define CDC_RX_IDLE_MIN   SL_MAX(CDC_RX_TICK, 20000 / (cdcLineCoding.dwDTERate))
+
+// Longest idle time in ms, 5 char times on current baudrate. Minimum timeout
+// is set to 10 ms.
 #define CDC_RX_TIMEOUT    SL_MAX(10U, 50000 / (cdcLineCoding.dwDTERate))
 
+// Weight of a new sample in the fill level and gap averages, 1 / 2^n
+#define CDC_RX_AVG_SHIFT  2
+
+// Hardware flow control. CTS is handled by the USART, which holds back UART
+// TX (and with it the TX LDMA) while the far end is busy. RTS is a GPIO
+// driven from the fill level of the UART RX ring: it is deasserted (high)
+// when CDC_RX_HIGH_WATER buffers wait for USB and asserted again at
+// CDC_RX_LOW_WATER.
+#ifndef CDC_FLOW_CONTROL
+#define CDC_FLOW_CONTROL  0
+#endif
+#ifndef CDC_RX_HIGH_WATER
+#define CDC_RX_HIGH_WATER (CDC_USB_TX_BUF_CNT - 1)
+#endif
+#ifndef CDC_RX_LOW_WATER
+#define CDC_RX_LOW_WATER  (CDC_USB_TX_BUF_CNT - 2)
+#endif
+
+#if CDC_FLOW_CONTROL && ((CDC_RX_HIGH_WATER >= CDC_USB_TX_BUF_CNT) \
+  || (CDC_RX_LOW_WATER >= CDC_RX_HIGH_WATER))
+#error "CDC_RX_LOW_WATER < CDC_RX_HIGH_WATER < CDC_USB_TX_BUF_CNT required"
+#endif
+
+// Throughput is sampled once per CDC_STATS_PERIOD ms
+#define CDC_STATS_PERIOD  1000
+
 // The serial port LINE CODING data structure, used to carry information
 // about serial port baudrate, parity etc. between host and device.
 SL_PACK_START(1)
@@ -138,14 +210,24 @@ SL_PACK_END()
 
 static int  UsbDataReceived(USB_Status_TypeDef status, uint32_t xferred,
                             uint32_t remaining);
+static int  UsbDataTransmitted(USB_Status_TypeDef status, uint32_t xferred,
+                               uint32_t remaining);
 static void DmaSetup(void);
 static int  LineCodingReceived(USB_Status_TypeDef status,
                                uint32_t xferred,
                                uint32_t remaining);
 static void SerialPortInit(void);
 static void UartRxTimeout(void);
-
-static LDMA_Descriptor_t descriptorRx;
+static void StatsTimeout(void);
+static void UsbRxArm(void);
+static void UartRxRun(void);
+static void UartRtsHold(void);
+static void UartRtsUpdate(void);
+static void CdcSuspend(void);
+static void CdcResume(void);
+
+static LDMA_Descriptor_t descriptorRx[CDC_USB_TX_BUF_CNT];
+static LDMA_Descriptor_t descriptorRxLast;
 static LDMA_Descriptor_t descriptorTx;
 static LDMA_TransferCfg_t transferConfigTx;
 static LDMA_TransferCfg_t transferConfigRx;
@@ -164,21 +246,46 @@ static cdcLineCoding_TypeDef SL_ATTRIBUTE_ALIGN(4) cdcLineCoding =
 };
 SL_PACK_END()
 
-STATIC_UBUF(usbRxBuffer0, CDC_USB_RX_BUF_SIZ);    // USB receive buffers.
-STATIC_UBUF(usbRxBuffer1, CDC_USB_RX_BUF_SIZ);
-STATIC_UBUF(uartRxBuffer0, CDC_USB_TX_BUF_SIZ);   // UART receive buffers.
-STATIC_UBUF(uartRxBuffer1, CDC_USB_TX_BUF_SIZ);
-
-static const uint8_t  *usbRxBuffer[2] = { usbRxBuffer0, usbRxBuffer1 };
-static const uint8_t  *uartRxBuffer[2] = { uartRxBuffer0, uartRxBuffer1 };
+// USB receive buffers, sent to the UART in place
+STATIC_UBUF(usbRxBuffer, CDC_USB_RX_BUF_CNT * CDC_USB_RX_BUF_SIZ);
+// UART receive buffers, sent over USB in place
+STATIC_UBUF(uartRxBuffer, CDC_USB_TX_BUF_CNT * CDC_USB_TX_BUF_STRIDE);
+
+#define USB_RX_BUF(i)     (&usbRxBuffer[(i) * CDC_USB_RX_BUF_SIZ])
+#define UART_RX_BUF(i)    (&uartRxBuffer[(i) * CDC_USB_TX_BUF_STRIDE])
+
+// USB OUT to UART TX ring state
+static int            usbRxHead;       // Buffer the next USB read goes to
+static int            uartTxTail;      // Oldest buffer not yet sent to the UART
+static int            usbRxPending;    // Buffers received but not yet sent
+static uint32_t       usbRxLen[CDC_USB_RX_BUF_CNT];
+
+// UART RX to USB IN ring state
+static int            uartRxHead;      // Buffer the RX LDMA is filling
+static int            usbTxTail;       // Oldest buffer not yet sent over USB
+static int            uartRxPending;   // Buffers filled but not yet sent
+static uint32_t       uartRxLen[CDC_USB_TX_BUF_CNT];
+static uint32_t       uartRxLastCount; // Bytes in the head buffer at the last timeout
+static uint32_t       uartRxIdle;      // ms without new chars in the head buffer
+static int32_t        uartRxFillAvg;   // Average fill of sent buffers, 0 to 256
+static int32_t        uartRxGapAvg;    // Average gap between chars in a burst, ms * 16
+static uint32_t       lastUsbTxCnt;
 
-static int            usbRxIndex, usbBytesReceived;
-static int            uartRxIndex, uartRxCount;
-static int            LastUsbTxCnt;
-
-static bool           dmaRxCompleted;
 static bool           usbRxActive, dmaTxActive;
 static bool           usbTxActive, dmaRxActive;
+static bool           usbTxZlp;
+static bool           uartRtsHeld;     // RTS deasserted, far end told to wait
+static bool           usbSuspended;    // Bus suspended while configured, rings kept
+
+// Throughput statistics
+static CDC_Throughput_TypeDef cdcThroughput[CDC_THROUGHPUT_RATES];
+static int            cdcThroughputCount;
+static uint32_t       uartToUsbTotal, usbToUartTotal;
+static uint32_t       uartToUsbLast, usbToUartLast;
+static uint32_t       rxStallTotal, rxStallLast;
+static uint32_t       usbTxWriteTotal, usbTxWriteLast;
+static uint32_t       usbRxReadTotal, usbRxReadLast;
+static uint32_t       rtsHoldTotal, rtsHoldLast;
 
 /** @endcond */
 
@@ -269,43 +376,139 @@ void CDC_StateChangeEvent(USBD_State_TypeDef oldState,
   if (newState == USBD_STATE_CONFIGURED) {
     // We have been configured, start CDC functionality !
 
-    if (oldState == USBD_STATE_SUSPENDED) { // Resume ?
+    if ((oldState == USBD_STATE_SUSPENDED) && usbSuspended) {
+      // Resume, the endpoint transfers set up before the suspend are still
+      // in place, carry on where the rings were left.
+      CdcResume();
+      return;
     }
 
     // Start receiving data from USB host.
-    usbRxIndex  = 0;
-    usbRxActive = true;
-    dmaTxActive = false;
-    USBD_Read(CDC_EP_DATA_OUT, (void*) usbRxBuffer[usbRxIndex],
-              CDC_USB_RX_BUF_SIZ, UsbDataReceived);
+    usbRxHead    = 0;
+    uartTxTail   = 0;
+    usbRxPending = 0;
+    usbRxActive  = false;
+    dmaTxActive  = false;
+    UsbRxArm();
 
     // Start receiving data on UART.
-    uartRxIndex    = 0;
-    LastUsbTxCnt   = 0;
-    uartRxCount    = 0;
-    dmaRxActive    = true;
-    usbTxActive    = false;
-    dmaRxCompleted = true;
-    LDMA_StartTransfer(CDC_UART_RX_DMA_CHANNEL, &transferConfigRx, &descriptorRx);
-
-    USBTIMER_Start(CDC_TIMER_ID, CDC_RX_TIMEOUT, UartRxTimeout);
-  } else if ((oldState == USBD_STATE_CONFIGURED)
+    uartRxHead      = 0;
+    usbTxTail       = 0;
+    uartRxPending   = 0;
+    uartRxLastCount = 0;
+    uartRxIdle      = 0;
+    uartRxFillAvg   = 0;
+    uartRxGapAvg    = 0;
+    lastUsbTxCnt    = 0;
+    usbTxActive     = false;
+    usbTxZlp        = false;
+    dmaRxActive     = false;
+    usbSuspended    = false;
+    uartRtsHeld     = true;
+    UartRxRun();
+    UartRtsUpdate();
+
+    USBTIMER_Start(CDC_TIMER_ID, CDC_RX_TICK, UartRxTimeout);
+    USBTIMER_Start(CDC_STATS_TIMER_ID, CDC_STATS_PERIOD, StatsTimeout);
+  } else if (((oldState == USBD_STATE_CONFIGURED) || usbSuspended)
              && (newState != USBD_STATE_SUSPENDED)) {
-    // We have been de-configured, stop CDC functionality.
+    // We have been de-configured, or reset while suspended, stop CDC
+    // functionality.
     USBTIMER_Stop(CDC_TIMER_ID);
-    // Stop DMA channels.
-    LDMA_StopTransfer(CDC_UART_RX_DMA_CHANNEL | CDC_UART_TX_DMA_CHANNEL);
-  } else if (newState == USBD_STATE_SUSPENDED) {
-    // We have been suspended, stop CDC functionality.
-    // Reduce current consumption to below 2.5 mA.
-    USBTIMER_Stop(CDC_TIMER_ID);
-    // Stop DMA channels.
-    LDMA_StopTransfer(CDC_UART_RX_DMA_CHANNEL | CDC_UART_TX_DMA_CHANNEL);
+    USBTIMER_Stop(CDC_STATS_TIMER_ID);
+    // Stop DMA channels and tell the far end to stop sending.
+    LDMA_StopTransfer(CDC_UART_RX_DMA_CHANNEL);
+    LDMA_StopTransfer(CDC_UART_TX_DMA_CHANNEL);
+    dmaTxActive  = false;
+    usbSuspended = false;
+    UartRtsHold();
+  } else if ((oldState == USBD_STATE_CONFIGURED)
+             && (newState == USBD_STATE_SUSPENDED)) {
+    // We have been suspended, pause CDC functionality. The main loop
+    // enters EM2 once CDC_SafeToEnterEM2() returns true.
+    CdcSuspend();
   }
 }
 
+/**************************************************************************//**
+ * @brief
+ *   Get the throughput measured for each baud rate used so far.
+ *
+ * @param[out] count Number of entries in the returned table.
+ *
+ * @return Table of throughput entries, one per baud rate.
+ *****************************************************************************/
+const CDC_Throughput_TypeDef *CDC_GetThroughput(int *count)
+{
+  *count = cdcThroughputCount;
+  return cdcThroughput;
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Check whether the device may enter EM2.
+ *
+ * @details
+ *   True while the USB stack has put the USB in low power mode, on a
+ *   suspend or with VBUS off, and no UART transmit DMA is running.
+ *   Call with interrupts masked, just before entering the energy mode.
+ *
+ * @return true if EM2 may be entered, false if only EM1.
+ *****************************************************************************/
+bool CDC_SafeToEnterEM2(void)
+{
+  return !dmaTxActive && USBD_SafeToEnterEM2();
+}
+
 /** @cond DO_NOT_INCLUDE_WITH_DOXYGEN */
 
+/**************************************************************************//**
+ * @brief Arm a USB read into the free buffers of the USB OUT ring.
+ *
+ * @details
+ *   The read spans all free buffers from the head up to the end of the ring,
+ *   at most CDC_USB_RX_SPAN of them. The USB core then takes the packets of
+ *   a long host transfer back to back into the ring, through the endpoint
+ *   FIFO of USBDESC_bufferingMultiplier packets, instead of NAKing the host
+ *   at the end of each buffer until the next read is armed. The transfer
+ *   still ends at the first short packet.
+ *
+ * @note
+ *   When the ring is full no read is armed and the USB device NAKs the
+ *   host until the UART has drained a buffer. Nothing is armed while the
+ *   bus is suspended. Must be called with interrupts masked.
+ *****************************************************************************/
+static void UsbRxArm(void)
+{
+  int span;
+
+  if (!usbSuspended && !usbRxActive && (usbRxPending < CDC_USB_RX_BUF_CNT)) {
+    // A read cannot wrap around the end of the ring
+    span = SL_MIN(CDC_USB_RX_BUF_CNT - usbRxPending,
+                  CDC_USB_RX_BUF_CNT - usbRxHead);
+    span = SL_MIN(span, CDC_USB_RX_SPAN);
+    usbRxActive = true;
+    usbRxReadTotal++;
+    USBD_Read(CDC_EP_DATA_OUT, (void*) USB_RX_BUF(usbRxHead),
+              span * CDC_USB_RX_BUF_SIZ, UsbDataReceived);
+  }
+}
+
+/**************************************************************************//**
+ * @brief Start a UART transmit DMA from the oldest received USB buffer.
+ *
+ * @note Must be called with interrupts masked.
+ *****************************************************************************/
+static void UartTxNext(void)
+{
+  if (!usbSuspended && !dmaTxActive && (usbRxPending > 0)) {
+    dmaTxActive = true;
+    descriptorTx.xfer.xferCnt = usbRxLen[uartTxTail] - 1;
+    descriptorTx.xfer.srcAddr = (uint32_t) USB_RX_BUF(uartTxTail);
+    LDMA_StartTransfer(CDC_UART_TX_DMA_CHANNEL, &transferConfigTx, &descriptorTx);
+  }
+}
+
 /**************************************************************************//**
  * @brief Callback function called whenever a new packet with data is received
  *        on USB.
@@ -320,36 +523,40 @@ static int UsbDataReceived(USB_Status_TypeDef status,
                            uint32_t xferred,
                            uint32_t remaining)
 {
+  CORE_DECLARE_IRQ_STATE;
+  uint32_t len;
   (void) remaining;            // Unused parameter.
 
-  if ((status == USB_STATUS_OK) && (xferred > 0)) {
-    usbRxIndex ^= 1;
+  if (status != USB_STATUS_OK) {
+    return USB_STATUS_OK;
+  }
 
-    if (!dmaTxActive) {
-      // dmaTxActive = false means that a new UART Tx DMA can be started.
-      dmaTxActive = true;
-      descriptorTx.xfer.xferCnt = xferred - 1;
-      descriptorTx.xfer.srcAddr = (uint32_t) usbRxBuffer[usbRxIndex ^ 1];
-      LDMA_StartTransfer(CDC_UART_TX_DMA_CHANNEL, &transferConfigTx, &descriptorTx);
+  CORE_ENTER_ATOMIC();
 
-      // Start a new USB receive transfer.
-      USBD_Read(CDC_EP_DATA_OUT, (void*) usbRxBuffer[usbRxIndex],
-                CDC_USB_RX_BUF_SIZ, UsbDataReceived);
-    } else {
-      // The UART transmit DMA callback function will start a new DMA.
-      usbRxActive      = false;
-      usbBytesReceived = xferred;
-    }
+  usbRxActive = false;
+  usbToUartTotal += xferred;
+
+  // Queue the buffers the read has filled for the UART, no copy is made.
+  // The buffers of the span it has not reached stay free.
+  while (xferred > 0) {
+    len = SL_MIN(xferred, CDC_USB_RX_BUF_SIZ);
+    usbRxLen[usbRxHead] = len;
+    usbRxHead = (usbRxHead + 1) % CDC_USB_RX_BUF_CNT;
+    usbRxPending++;
+    xferred -= len;
   }
+
+  // Arm the next read first, so the host is NAKed as briefly as possible,
+  // then start the UART on the oldest buffer if it is idle.
+  UsbRxArm();
+  UartTxNext();
+
+  CORE_EXIT_ATOMIC();
   return USB_STATUS_OK;
 }
 
 /**************************************************************************//**
  * @brief Callback function called whenever a UART transmit DMA has completed.
- *
- * @param[in] channel DMA channel number.
- * @param[in] primary True if this is the primary DMA channel.
- * @param[in] user    Optional user supplied parameter.
  *****************************************************************************/
 static void DmaTxComplete(void)
 {
@@ -361,23 +568,139 @@ static void DmaTxComplete(void)
    */
   CORE_ENTER_ATOMIC();
 
-  if (!usbRxActive) {
-    // usbRxActive = false means that an USB receive packet has been received
+  // The buffer has been sent, give it back to the USB OUT ring.
+  uartTxTail = (uartTxTail + 1) % CDC_USB_RX_BUF_CNT;
+  usbRxPending--;
+  dmaTxActive = false;
 
-    descriptorTx.xfer.xferCnt = usbBytesReceived - 1;
-    descriptorTx.xfer.srcAddr = (uint32_t) usbRxBuffer[usbRxIndex ^ 1];
-    LDMA_StartTransfer(CDC_UART_TX_DMA_CHANNEL, &transferConfigTx, &descriptorTx);
+  UartTxNext();
+  UsbRxArm();
 
-    // Start a new USB receive transfer.
-    usbRxActive = true;
-    USBD_Read(CDC_EP_DATA_OUT, (void*) usbRxBuffer[usbRxIndex],
-              CDC_USB_RX_BUF_SIZ, UsbDataReceived);
-  } else {
-    // The USB receive complete callback function will start a new DMA.
-    dmaTxActive = false;
+  CORE_EXIT_ATOMIC();
+}
+
+/**************************************************************************//**
+ * @brief Send the oldest filled UART buffer over USB.
+ *
+ * @note
+ *   A transfer that is a multiple of the ep size is followed by a zero
+ *   length packet when nothing else is waiting, so the host sees the end
+ *   of the data. Must be called with interrupts masked.
+ *****************************************************************************/
+static void UsbTxNext(void)
+{
+  if (usbSuspended || usbTxActive) {
+    return;
   }
 
-  CORE_EXIT_ATOMIC();
+  if (uartRxPending > 0) {
+    usbTxActive = true;
+    usbTxZlp = false;
+    lastUsbTxCnt = uartRxLen[usbTxTail];
+    usbTxWriteTotal++;
+    USBD_Write(CDC_EP_DATA_IN, (void*) UART_RX_BUF(usbTxTail),
+               lastUsbTxCnt, UsbDataTransmitted);
+  } else if ((lastUsbTxCnt > 0) && ((lastUsbTxCnt % CDC_BULK_EP_SIZE) == 0)) {
+    usbTxActive = true;
+    usbTxZlp = true;
+    lastUsbTxCnt = 0;
+    USBD_Write(CDC_EP_DATA_IN, NULL, 0, UsbDataTransmitted);
+  }
+}
+
+/**************************************************************************//**
+ * @brief Keep the UART RX LDMA running into the UART RX ring.
+ *
+ * @details
+ *   The descriptors form a circle, so once started the LDMA moves from one
+ *   buffer to the next without any help from the CPU. When only one free
+ *   buffer is left the LDMA must stop at the end of it instead of running
+ *   into a buffer still waiting for USB. It is restarted when USB has sent
+ *   a buffer.
+ *
+ * @note Must be called with interrupts masked.
+ *****************************************************************************/
+static void UartRxRun(void)
+{
+  if (usbSuspended) {
+    return;
+  }
+
+  if (!dmaRxActive && (uartRxPending < CDC_USB_TX_BUF_CNT)) {
+    dmaRxActive = true;
+    uartRxLastCount = 0;
+    if (uartRxPending == CDC_USB_TX_BUF_CNT - 1) {
+      // Only one free buffer, use a copy of its descriptor without the link
+      descriptorRxLast = descriptorRx[uartRxHead];
+      descriptorRxLast.xfer.link = 0;
+      LDMA_StartTransfer(CDC_UART_RX_DMA_CHANNEL, &transferConfigRx, &descriptorRxLast);
+    } else {
+      LDMA_StartTransfer(CDC_UART_RX_DMA_CHANNEL, &transferConfigRx,
+                         &descriptorRx[uartRxHead]);
+    }
+  } else if (dmaRxActive && (uartRxPending == CDC_USB_TX_BUF_CNT - 1)) {
+    // The buffer being filled is the last free one, remove the link from
+    // the loaded descriptor so the LDMA stops at the end of it
+    LDMA->CH[CDC_UART_RX_DMA_CHANNEL].LINK &= ~LDMA_CH_LINK_LINK;
+  }
+}
+
+/**************************************************************************//**
+ * @brief Deassert RTS so the far end stops sending.
+ *****************************************************************************/
+static void UartRtsHold(void)
+{
+#if CDC_FLOW_CONTROL
+  GPIO_PinOutSet(CDC_UART_RTS_PORT, CDC_UART_RTS_PIN);
+#endif
+  uartRtsHeld = true;
+}
+
+/**************************************************************************//**
+ * @brief Drive RTS from the number of UART RX buffers waiting for USB.
+ *
+ * @details
+ *   RTS is deasserted at the high water mark while there is still at least
+ *   one free buffer, so chars the far end sends before it reacts are not
+ *   lost. It is asserted again once USB has drained the ring down to the
+ *   low water mark. Without flow control this only records the state.
+ *
+ * @note Must be called with interrupts masked.
+ *****************************************************************************/
+static void UartRtsUpdate(void)
+{
+  if (!uartRtsHeld && (uartRxPending >= CDC_RX_HIGH_WATER)) {
+    UartRtsHold();
+    rtsHoldTotal++;
+  } else if (uartRtsHeld && (uartRxPending <= CDC_RX_LOW_WATER)) {
+#if CDC_FLOW_CONTROL
+    GPIO_PinOutClear(CDC_UART_RTS_PORT, CDC_UART_RTS_PIN);
+#endif
+    uartRtsHeld = false;
+  }
+}
+
+/**************************************************************************//**
+ * @brief Hand the head buffer of the UART RX ring over to USB.
+ *
+ * @param[in] count Number of bytes in the buffer.
+ *
+ * @note Must be called with interrupts masked.
+ *****************************************************************************/
+static void UartRxBufferDone(uint32_t count)
+{
+  uartRxLen[uartRxHead] = count;
+  uartRxHead = (uartRxHead + 1) % CDC_USB_TX_BUF_CNT;
+  uartRxPending++;
+  uartRxLastCount = 0;
+  uartRxIdle = 0;
+  uartToUsbTotal += count;
+
+  UartRtsUpdate();
+
+  // Full buffers mean bulk traffic, small ones interactive traffic
+  uartRxFillAvg += ((int32_t)(count * 256 / CDC_USB_TX_BUF_SIZ) - uartRxFillAvg)
+                   >> CDC_RX_AVG_SHIFT;
 }
 
 /**************************************************************************//**
@@ -394,36 +717,34 @@ static int UsbDataTransmitted(USB_Status_TypeDef status,
                               uint32_t xferred,
                               uint32_t remaining)
 {
+  CORE_DECLARE_IRQ_STATE;
   (void) xferred;              // Unused parameter.
   (void) remaining;            // Unused parameter.
 
-  if (status == USB_STATUS_OK) {
-    if (!dmaRxActive) {
-      // dmaRxActive = false means that a new UART Rx DMA can be started.
+  if (status != USB_STATUS_OK) {
+    return USB_STATUS_OK;
+  }
 
-      USBD_Write(CDC_EP_DATA_IN, (void*) uartRxBuffer[uartRxIndex ^ 1],
-                 uartRxCount, UsbDataTransmitted);
-      LastUsbTxCnt = uartRxCount;
+  CORE_ENTER_ATOMIC();
 
-      dmaRxActive    = true;
-      dmaRxCompleted = true;
-      LDMA_StartTransfer(CDC_UART_RX_DMA_CHANNEL, &transferConfigRx, &descriptorRx);
-      uartRxCount = 0;
-      USBTIMER_Start(CDC_TIMER_ID, CDC_RX_TIMEOUT, UartRxTimeout);
-    } else {
-      // The UART receive DMA callback function will start a new DMA.
-      usbTxActive = false;
-    }
+  usbTxActive = false;
+  if (!usbTxZlp) {
+    // The buffer has been sent, give it back to the UART RX ring.
+    usbTxTail = (usbTxTail + 1) % CDC_USB_TX_BUF_CNT;
+    uartRxPending--;
+    UartRtsUpdate();
   }
+
+  UartRxRun();
+  UsbTxNext();
+
+  CORE_EXIT_ATOMIC();
   return USB_STATUS_OK;
 }
 
 /**************************************************************************//**
- * @brief Callback function called whenever a UART receive DMA has completed.
- *
- * @param[in] channel DMA channel number.
- * @param[in] primary True if this is the primary DMA channel.
- * @param[in] user    Optional user supplied parameter.
+ * @brief Callback function called whenever a UART receive DMA has filled a
+ *        buffer.
  *****************************************************************************/
 static void DmaRxComplete(void)
 {
@@ -435,78 +756,234 @@ static void DmaRxComplete(void)
    */
   CORE_ENTER_ATOMIC();
 
-  uartRxIndex ^= 1;
-
-  if (dmaRxCompleted) {
-    uartRxCount = CDC_USB_TX_BUF_SIZ;
-  } else {
-    uint32_t numRemaining = LDMA_TransferRemainingCount(CDC_UART_RX_DMA_CHANNEL);
-    uartRxCount = CDC_USB_TX_BUF_SIZ - numRemaining;
-  }
+  UartRxBufferDone(CDC_USB_TX_BUF_SIZ);
 
-  if (!usbTxActive) {
-    // usbTxActive = false means that a new USB packet can be transferred.
-    usbTxActive = true;
-    USBD_Write(CDC_EP_DATA_IN, (void*) uartRxBuffer[uartRxIndex ^ 1],
-               uartRxCount, UsbDataTransmitted);
-    LastUsbTxCnt = uartRxCount;
-
-    // Start a new UART receive DMA.
-    dmaRxCompleted = true;
-    descriptorRx.xfer.dstAddr = (uint32_t) uartRxBuffer[uartRxIndex];
-    LDMA_StartTransfer(CDC_UART_RX_DMA_CHANNEL, &transferConfigRx, &descriptorRx);
-    uartRxCount = 0;
-    USBTIMER_Start(CDC_TIMER_ID, CDC_RX_TIMEOUT, UartRxTimeout);
-  } else {
-    // The USB transmit complete callback function will start a new DMA.
+  // The LDMA is still running if it followed the link to the next buffer.
+  if (LDMA_TransferDone(CDC_UART_RX_DMA_CHANNEL)) {
     dmaRxActive = false;
-    USBTIMER_Stop(CDC_TIMER_ID);
+    if (uartRxPending == CDC_USB_TX_BUF_CNT) {
+      // Ring full, the UART is not read until USB catches up.
+      rxStallTotal++;
+    }
   }
 
+  UartRxRun();
+  UsbTxNext();
+
   CORE_EXIT_ATOMIC();
 }
 
 /**************************************************************************//**
  * @brief
- *   Called each time UART Rx timeout period elapses.
+ *   Get how long the line must be idle before a partial buffer is sent.
+ *
+ * @details
+ *   Sparse traffic, such as a person typing, leaves the buffers nearly empty
+ *   and gets flushed after CDC_RX_IDLE_MIN to keep the latency low. Bulk
+ *   traffic fills whole buffers and moves the limit towards CDC_RX_TIMEOUT,
+ *   so short pauses in a burst do not split it into small USB packets. The
+ *   limit is also kept above twice the average gap seen inside bursts.
+ *
+ * @return Idle time in ms.
+ *****************************************************************************/
+static uint32_t UartRxIdleLimit(void)
+{
+  uint32_t idleMin = CDC_RX_IDLE_MIN;
+  uint32_t idleMax = CDC_RX_TIMEOUT;
+  uint32_t limit;
+
+  limit = idleMin + ((idleMax - idleMin) * (uint32_t)uartRxFillAvg) / 256;
+  limit = SL_MAX(limit, (uint32_t)uartRxGapAvg * 2 / 16);
+
+  return SL_MIN(limit, idleMax);
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Stop the UART RX LDMA and send the chars received so far on USB.
+ *
+ * @note Must be called with interrupts masked.
+ *****************************************************************************/
+static void UartRxFlush(void)
+{
+  uint32_t numReceived;
+
+  LDMA_StopTransfer(CDC_UART_RX_DMA_CHANNEL);
+  dmaRxActive = false;
+
+  if (LDMA_IntGet() & (1 << CDC_UART_RX_DMA_CHANNEL)) {
+    // The buffer filled up just before the DMA was stopped, any chars
+    // after that went to the following buffer.
+    LDMA_IntClear(1 << CDC_UART_RX_DMA_CHANNEL);
+    UartRxBufferDone(CDC_USB_TX_BUF_SIZ);
+  }
+  numReceived = CDC_USB_TX_BUF_SIZ
+                - LDMA_TransferRemainingCount(CDC_UART_RX_DMA_CHANNEL);
+  if (LDMA_TransferDone(CDC_UART_RX_DMA_CHANNEL)) {
+    numReceived = 0;
+  }
+  if (numReceived > 0) {
+    UartRxBufferDone(numReceived);
+  }
+
+  UartRxRun();
+  UsbTxNext();
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Called each CDC_RX_TICK ms.
  *   Implements UART Rx rate monitoring, i.e. we must behave differently when
  *   UART Rx rate is slow e.g. when a person is typing characters, and when UART
  *   Rx rate is maximum.
  *****************************************************************************/
 static void UartRxTimeout(void)
 {
-  uint32_t numRemaining = LDMA_TransferRemainingCount(CDC_UART_RX_DMA_CHANNEL);
-  uint32_t numReceived = CDC_USB_TX_BUF_SIZ - numRemaining;
-
-  if ((numReceived == 0) && (LastUsbTxCnt == CDC_BULK_EP_SIZE)) {
-    /*
-     * No activity on UART Rx, send a ZERO length USB package if last USB
-     * USB package sent was CDC_BULK_EP_SIZE (max. EP size) long.
-     */
-    // Stop Rx DMA channel.
-    LDMA_StopTransfer(CDC_UART_RX_DMA_CHANNEL);
-    dmaRxCompleted = false;
-    // Call DMA completion callback.
-    DmaRxComplete();
-    return;
-  }
+  CORE_DECLARE_IRQ_STATE;
+  uint32_t numReceived;
 
-  if ((numReceived > 0) && (numReceived == uartRxCount)) {
-    /*
-     * There is curently no activity on UART Rx but some chars have been
-     * received. Stop DMA and transmit the chars we have got so far on USB.
-     */
-    // Stop Rx DMA channel.
-    LDMA_StopTransfer(CDC_UART_RX_DMA_CHANNEL);
-    dmaRxCompleted = false;
-    // Call DMA completion callback.
-    DmaRxComplete();
-    return;
+  CORE_ENTER_ATOMIC();
+
+  if (dmaRxActive) {
+    numReceived = CDC_USB_TX_BUF_SIZ
+                  - LDMA_TransferRemainingCount(CDC_UART_RX_DMA_CHANNEL);
+
+    if (numReceived != uartRxLastCount) {
+      // New chars, a gap inside the current burst has ended
+      if (uartRxIdle > 0) {
+        uartRxGapAvg += ((int32_t)(uartRxIdle * 16) - uartRxGapAvg)
+                        >> CDC_RX_AVG_SHIFT;
+      }
+      uartRxIdle = 0;
+      uartRxLastCount = numReceived;
+    } else if (numReceived > 0) {
+      uartRxIdle += CDC_RX_TICK;
+      if (uartRxIdle >= UartRxIdleLimit()) {
+        /*
+         * There is curently no activity on UART Rx but some chars have been
+         * received. Stop DMA and transmit the chars we have got so far on USB.
+         */
+        UartRxFlush();
+      }
+    }
   }
 
+  CORE_EXIT_ATOMIC();
+
   // Restart timer to continue monitoring.
-  uartRxCount = numReceived;
-  USBTIMER_Start(CDC_TIMER_ID, CDC_RX_TIMEOUT, UartRxTimeout);
+  USBTIMER_Start(CDC_TIMER_ID, CDC_RX_TICK, UartRxTimeout);
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Called once per CDC_STATS_PERIOD. Records the bytes moved in each
+ *   direction during the last period against the current baud rate.
+ *****************************************************************************/
+static void StatsTimeout(void)
+{
+  CDC_Throughput_TypeDef *entry = NULL;
+  uint32_t toUsb, toUart, stalls, writes, reads, holds;
+  int i;
+
+  toUsb  = uartToUsbTotal - uartToUsbLast;
+  toUart = usbToUartTotal - usbToUartLast;
+  stalls = rxStallTotal - rxStallLast;
+  uartToUsbLast = uartToUsbTotal;
+  usbToUartLast = usbToUartTotal;
+  rxStallLast   = rxStallTotal;
+  writes = usbTxWriteTotal - usbTxWriteLast;
+  usbTxWriteLast = usbTxWriteTotal;
+  reads = usbRxReadTotal - usbRxReadLast;
+  usbRxReadLast = usbRxReadTotal;
+  holds = rtsHoldTotal - rtsHoldLast;
+  rtsHoldLast = rtsHoldTotal;
+
+  if ((toUsb > 0) || (toUart > 0)) {
+    // One entry per baud rate, the last entry is reused when the table is full
+    for (i = 0; i < cdcThroughputCount; i++) {
+      if (cdcThroughput[i].baudRate == cdcLineCoding.dwDTERate) {
+        entry = &cdcThroughput[i];
+        break;
+      }
+    }
+    if (entry == NULL) {
+      if (cdcThroughputCount < CDC_THROUGHPUT_RATES) {
+        cdcThroughputCount++;
+      }
+      entry = &cdcThroughput[cdcThroughputCount - 1];
+      memset(entry, 0, sizeof(*entry));
+      entry->baudRate = cdcLineCoding.dwDTERate;
+    }
+
+    entry->seconds++;
+    entry->uartToUsbBytes += toUsb;
+    entry->usbToUartBytes += toUart;
+    entry->rxStalls       += stalls;
+    entry->uartToUsbWrites += writes;
+    entry->usbToUartReads += reads;
+    entry->rtsHolds       += holds;
+    entry->uartToUsbPeak   = SL_MAX(entry->uartToUsbPeak, toUsb * 1000 / CDC_STATS_PERIOD);
+    entry->usbToUartPeak   = SL_MAX(entry->usbToUartPeak, toUart * 1000 / CDC_STATS_PERIOD);
+
+    // Count UART receive overflows, bytes lost while the RX ring was full
+    if (CDC_UART->IF & USART_IF_RXOF) {
+      USART_IntClear(CDC_UART, USART_IF_RXOF);
+      entry->rxOverflows++;
+    }
+  }
+
+  USBTIMER_Start(CDC_STATS_TIMER_ID, CDC_STATS_PERIOD, StatsTimeout);
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Pause the bridge when the bus is suspended.
+ *
+ * @details
+ *   The far end is told to stop sending and the chars already received are
+ *   kept in the UART RX ring, to be sent after the resume. A UART transmit
+ *   in progress is left to finish, no new one is started. The rings and
+ *   the endpoint transfers are left as they are.
+ *****************************************************************************/
+static void CdcSuspend(void)
+{
+  CORE_DECLARE_IRQ_STATE;
+
+  USBTIMER_Stop(CDC_TIMER_ID);
+  USBTIMER_Stop(CDC_STATS_TIMER_ID);
+
+  CORE_ENTER_ATOMIC();
+
+  usbSuspended = true;
+  UartRtsHold();
+  if (dmaRxActive) {
+    UartRxFlush();
+  }
+
+  CORE_EXIT_ATOMIC();
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Restart the bridge from where it was paused by CdcSuspend().
+ *****************************************************************************/
+static void CdcResume(void)
+{
+  CORE_DECLARE_IRQ_STATE;
+
+  CORE_ENTER_ATOMIC();
+
+  usbSuspended = false;
+  UartRxRun();
+  UartRtsUpdate();
+  UartTxNext();
+  UsbRxArm();
+  UsbTxNext();
+
+  CORE_EXIT_ATOMIC();
+
+  USBTIMER_Start(CDC_TIMER_ID, CDC_RX_TICK, UartRxTimeout);
+  USBTIMER_Start(CDC_STATS_TIMER_ID, CDC_STATS_PERIOD, StatsTimeout);
 }
 
 /**************************************************************************//**
@@ -585,6 +1062,9 @@ static int LineCodingReceived(USB_Status_TypeDef status,
  *****************************************************************************/
 void LDMA_IRQHandler(void)
 {
+#if CDC_IRQ_STRESS
+  uint32_t start = IRQPRIO_Now();
+#endif
   // Get all pending and enabled interrupts.
   uint32_t pending = LDMA_IntGetEnabled();
 
@@ -599,6 +1079,11 @@ void LDMA_IRQHandler(void)
     LDMA_IntClear(0x01 << CDC_UART_RX_DMA_CHANNEL); // Acknowledge the interrupt
     DmaRxComplete(); // Call the DMA RX callback function
   }
+
+#if CDC_IRQ_STRESS
+  // The LDMA cannot tell when the transfer ended, only the duration counts
+  IRQPRIO_Record(CDC_IRQ_SOURCE_LDMA, 0, start);
+#endif
 }
 
 /**************************************************************************//**
@@ -612,11 +1097,12 @@ static void DmaSetup(void)
 
   /*---------- Configure DMA channel for UART Tx. ----------*/
 
-  // Channel descriptor configuration
+  // Channel descriptor configuration, the source and count are set for
+  // each buffer of the USB OUT ring
   descriptorTx = (LDMA_Descriptor_t)
-    LDMA_DESCRIPTOR_SINGLE_M2P_BYTE((void *) usbRxBuffer[usbRxIndex], // Memory source address
-                                    (void *) &(CDC_UART->TXDATA),     // Peripheral destination address
-                                    usbBytesReceived);                // Number of bytes per transfer
+    LDMA_DESCRIPTOR_SINGLE_M2P_BYTE((void *) USB_RX_BUF(0),        // Memory source address
+                                    (void *) &(CDC_UART->TXDATA),  // Peripheral destination address
+                                    CDC_USB_RX_BUF_SIZ);           // Number of bytes per transfer
   descriptorTx.xfer.doneIfs = 1; // Trigger an interrupt when done
 
   // Transfer configuration and trigger selection
@@ -624,12 +1110,16 @@ static void DmaSetup(void)
 
   /*---------- Configure DMA channel for UART Rx. ----------*/
 
-  // Channel descriptor configuration
-  descriptorRx = (LDMA_Descriptor_t)
-    LDMA_DESCRIPTOR_SINGLE_P2M_BYTE((void *) &(CDC_UART->RXDATA),       // Peripheral source address
-                                    (void *) uartRxBuffer[uartRxIndex], // Memory destination address
-                                    CDC_USB_TX_BUF_SIZ);                // Number of bytes per transfer
-  descriptorRx.xfer.doneIfs = 1; // Trigger an interrupt when done
+  // One descriptor per buffer of the UART RX ring, the last one links back
+  // to the first
+  for (int i = 0; i < CDC_USB_TX_BUF_CNT; i++) {
+    descriptorRx[i] = (LDMA_Descriptor_t)
+      LDMA_DESCRIPTOR_LINKREL_P2M_BYTE((void *) &(CDC_UART->RXDATA),            // Peripheral source address
+                                       (void *) UART_RX_BUF(i),                 // Memory destination address
+                                       CDC_USB_TX_BUF_SIZ,                      // Number of bytes per buffer
+                                       (i == CDC_USB_TX_BUF_CNT - 1) ? 1 - CDC_USB_TX_BUF_CNT : 1);
+    descriptorRx[i].xfer.doneIfs = 1; // Trigger an interrupt for each buffer
+  }
 
   // Transfer configuration and trigger selection
   transferConfigRx = (LDMA_TransferCfg_t) LDMA_TRANSFER_CFG_PERIPHERAL(CDC_RX_DMA_SIGNAL);
@@ -649,6 +1139,13 @@ static void SerialPortInit(void)
   GPIO_PinModeSet(CDC_UART_TX_PORT, CDC_UART_TX_PIN, gpioModePushPull, 1);
   GPIO_PinModeSet(CDC_UART_RX_PORT, CDC_UART_RX_PIN, gpioModeInput, 0);
 
+#if CDC_FLOW_CONTROL
+  // CTS is an input with pull-up so an unconnected CTS does not block TX,
+  // RTS starts deasserted until the device is configured.
+  GPIO_PinModeSet(CDC_UART_CTS_PORT, CDC_UART_CTS_PIN, gpioModeInputPull, 1);
+  GPIO_PinModeSet(CDC_UART_RTS_PORT, CDC_UART_RTS_PIN, gpioModePushPull, 1);
+#endif
+
   // Enable DK mainboard RS232/UART switch.
   CDC_ENABLE_DK_UART_SWITCH();
 
@@ -664,6 +1161,13 @@ static void SerialPortInit(void)
   CDC_UART->ROUTEPEN = CDC_UART_ROUTEPEN;
   CDC_UART->ROUTELOC0 = CDC_UART_ROUTELOC0;
 
+#if CDC_FLOW_CONTROL
+  // Let the USART hold back TX while CTS is deasserted.
+  CDC_UART->ROUTEPEN |= USART_ROUTEPEN_CTSPEN;
+  CDC_UART->ROUTELOC1 = CDC_UART_ROUTELOC1;
+  CDC_UART->CTRLX |= USART_CTRLX_CTSEN;
+#endif
+
   // Finally enable it
   USART_Enable(CDC_UART, usartEnable);
 }
@@ -202,9 +202,12 @@ const void* const USBDESC_strings[] = {
 // Each multiplier value specifies how much RAM to allocate for each endpoint's
 // FIFO. 1 should be used for control/interrupt endpoints and 2 should be used
 // for bulk endpoints. Each number represents X times the endpoint size (e.g.
-// 2 means the RAM allocated will be equal to 2 times the endpoint size)
+// 2 means the RAM allocated will be equal to 2 times the endpoint size). The
+// bulk OUT endpoint takes CDC_BULK_OUT_BUFFERING packets so the USB core can
+// accept the packets of a long host transfer back to back.
 const uint8_t USBDESC_bufferingMultiplier[NUM_EP_USED + 1] = {
   1,        // Common Control endpoint
-  1, 2, 2   // CDC interrupt and bulk endpoints
+  1, 2,     // CDC interrupt and bulk IN endpoints
+  CDC_BULK_OUT_BUFFERING // CDC bulk OUT endpoint
 };
 
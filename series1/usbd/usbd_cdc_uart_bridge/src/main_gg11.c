@@ -43,12 +43,100 @@
 #include "em_gpio.h"
 #include "em_chip.h"
 #include "em_emu.h"
+#include "em_core.h"
+#include "em_timer.h"
+#include "irqprio.h"
 
 // USB specific includes
 #include "em_usb.h"
 #include "cdc.h"
 #include "descriptors.h"
 
+#if CDC_IRQ_STRESS
+#if (CORE_ATOMIC_METHOD != CORE_ATOMIC_METHOD_BASEPRI) \
+  || (CORE_ATOMIC_BASE_PRIORITY_LEVEL < 1)
+#error "CDC_IRQ_STRESS needs BASEPRI critical sections that leave level 0 running"
+#endif
+
+// Statistics of the LDMA handler and the stream, copied once per second
+IRQPRIO_Stats_TypeDef irqStats[2];
+
+// Runs more than one and a half periods after the previous one, samples lost
+volatile uint32_t streamMissed;
+
+static uint32_t streamPeriod;       // Cycles per sample
+static uint32_t streamCyclesPerTick;
+static uint32_t streamLast;
+static uint32_t streamSecond;
+static volatile bool statsDue;
+#endif
+
+// Priority plan, the statistics sources first
+static IRQPRIO_Entry_TypeDef irqPlan[] = {
+  { LDMA_IRQn,   CDC_IRQ_PRIO_LDMA,  0 },
+#if CDC_IRQ_STRESS
+  { CDC_STRESS_TIMER_IRQn, 0, 0 },  // Deadline set by streamInit()
+#endif
+  { USB_IRQn,    CDC_IRQ_PRIO_USB,   0 },
+  { TIMER0_IRQn, CDC_IRQ_PRIO_TIMER, 0 },
+};
+
+#if CDC_IRQ_STRESS
+/***************************************************************************//**
+ * @brief
+ *    Sample stream interrupt, one run per CDC_STRESS_RATE period
+ *
+ * @details
+ *    The TIMER counts up from 0 after each overflow, so its counter on entry
+ *    is the latency from the overflow to the handler.
+ ******************************************************************************/
+void TIMER1_IRQHandler(void)
+{
+  uint32_t start = IRQPRIO_Now();
+  uint32_t ticks = TIMER_CounterGet(CDC_STRESS_TIMER);
+
+  TIMER_IntClear(CDC_STRESS_TIMER, TIMER_IF_OF);
+
+  // A run delayed past the next overflow counts from that one
+  if ((start - streamLast) > (streamPeriod + streamPeriod / 2)) {
+    streamMissed++;
+  }
+  streamLast = start;
+
+  if (++streamSecond == CDC_STRESS_RATE) {
+    streamSecond = 0;
+    statsDue = true;
+  }
+
+  IRQPRIO_Record(CDC_IRQ_SOURCE_STREAM, ticks * streamCyclesPerTick, start);
+}
+
+/***************************************************************************//**
+ * @brief
+ *    Start the stress test sample stream
+ ******************************************************************************/
+static void streamInit(void)
+{
+  TIMER_Init_TypeDef init = TIMER_INIT_DEFAULT;
+  uint32_t timerFreq;
+
+  CMU_ClockEnable(CDC_STRESS_TIMER_CLOCK, true);
+  timerFreq = CMU_ClockFreqGet(CDC_STRESS_TIMER_CLOCK);
+  streamCyclesPerTick = CMU_ClockFreqGet(cmuClock_CORE) / timerFreq;
+  streamPeriod = (timerFreq / CDC_STRESS_RATE) * streamCyclesPerTick;
+
+  // Each sample must be handled before the next one is due
+  irqPlan[CDC_IRQ_SOURCE_STREAM].deadline = streamPeriod;
+
+  init.enable = false;
+  TIMER_Init(CDC_STRESS_TIMER, &init);
+  TIMER_TopSet(CDC_STRESS_TIMER, (timerFreq / CDC_STRESS_RATE) - 1);
+  TIMER_IntEnable(CDC_STRESS_TIMER, TIMER_IEN_OF);
+  NVIC_ClearPendingIRQ(CDC_STRESS_TIMER_IRQn);
+  NVIC_EnableIRQ(CDC_STRESS_TIMER_IRQn);
+}
+#endif
+
 /***************************************************************************//**
  * @brief
  *    Entrypoint for the C program
@@ -62,6 +150,13 @@ int main(void)
   EMU_DCDCInit_TypeDef dcdcInit = EMU_DCDCINIT_DEFAULT;
   EMU_DCDCInit(&dcdcInit);
 
+#if CDC_IRQ_STRESS
+  streamInit();
+#endif
+
+  // Set the interrupt priorities before any of them are enabled
+  IRQPRIO_Apply(irqPlan, sizeof(irqPlan) / sizeof(irqPlan[0]));
+
   // Initialize the communication class device
   // (Setup the DMA and USART pins)
   CDC_Init();
@@ -95,9 +190,30 @@ int main(void)
   // USBTIMER_DelayMs( 1000 );
   // USBD_Connect();
 
-  // Enter EM1 to save energy
+#if CDC_IRQ_STRESS
+  streamLast = IRQPRIO_Now();
+  TIMER_Enable(CDC_STRESS_TIMER, true);
+#endif
+
+  // Enter EM2 while the USB is in low power mode (suspended or VBUS off),
+  // EM1 otherwise. Interrupts are masked from the check until the core
+  // sleeps, so a resume in between wakes it at once.
   while (1) {
-    EMU_EnterEM1();
+    CORE_DECLARE_IRQ_STATE;
+    CORE_ENTER_CRITICAL();
+    if (CDC_SafeToEnterEM2()) {
+      EMU_EnterEM2(true);
+    } else {
+      EMU_EnterEM1();
+    }
+    CORE_EXIT_CRITICAL();
+#if CDC_IRQ_STRESS
+    if (statsDue) {
+      statsDue = false;
+      IRQPRIO_GetStats(CDC_IRQ_SOURCE_LDMA, &irqStats[0]);
+      IRQPRIO_GetStats(CDC_IRQ_SOURCE_STREAM, &irqStats[1]);
+    }
+#endif
   }
 }
 
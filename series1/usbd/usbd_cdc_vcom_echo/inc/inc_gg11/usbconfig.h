@@ -71,6 +71,9 @@ extern "C" {
 // (clocked by 32 kHz clock) whenever the USB enters suspend mode. If ONVBUSOFF is set, the
 // USB controller will automatically enter low power mode whenever power is lost
 // on VBUS. This requires that the USB regulator is used and that VREGI is connected to VBUS.
+// In low power mode the USB clocks are gated and USBD_SafeToEnterEM2() returns true, the
+// main loop then enters EM2. The USB core keeps its endpoint state, so on resume the stack
+// restores the 48 MHz clock and the transfers set up before the suspend carry on.
 // Needed for emusb/em_usbd.c and emusb/em_usbdint.c
 #define USB_PWRSAVE_MODE (USB_PWRSAVE_MODE_ONSUSPEND | USB_PWRSAVE_MODE_ONVBUSOFF)
 
@@ -98,6 +101,17 @@ extern "C" {
 #define CDC_EP_DATA_IN   0x81  // Endpoint for CDC data reception (host receives from device)
 #define CDC_EP_NOTIFY    0x82  // Notification endpoint (not used)
 
+// RAM allocated for each bulk endpoint FIFO, in multiples of the 64 byte
+// endpoint size. 2 allows one packet to be moved while the next is on the bus,
+// larger values let the host burst more packets per frame.
+// Needed for src/descriptors.c
+#define CDC_BULK_BUFFERING  2
+
+// Baud rates that select the benchmark modes, any other baud rate echoes
+// Needed for src/cdc_echo.c
+#define CDC_BENCH_BAUD_SINK    2000001  // Throw away all received data
+#define CDC_BENCH_BAUD_SOURCE  2000002  // Send data to the host non-stop
+
 #ifdef __cplusplus
 }
 #endif
@@ -33,6 +33,7 @@
  * at the sole discretion of Silicon Labs.
  ******************************************************************************/
 
+#include "em_core.h"
 #include "em_usb.h"
 #include "cdc.h"
 
@@ -64,15 +65,54 @@ SL_PACK_END()
 // By default, the receive buffer size is same size as the max size of a full speed bulk endpoint
 #define CDC_USB_RX_BUF_SIZE  (USB_FS_BULK_EP_MAXSIZE)
 
-// Create a 4-byte aligned uint8_t array for the USB receive buffer
-STATIC_UBUF(usbRxBuffer, CDC_USB_RX_BUF_SIZE);
+// Note: change this to change the transfer size used by the bulk benchmark
+// modes, it must be a multiple of the endpoint size
+#ifndef CDC_BENCH_XFER_SIZE
+#define CDC_BENCH_XFER_SIZE  (16 * USB_FS_BULK_EP_MAXSIZE)
+#endif
+
+// Create 4-byte aligned uint8_t arrays for the USB receive buffers. Echo mode
+// receives into one buffer while the other one is sent back.
+STATIC_UBUF(usbRxBuffer0, CDC_USB_RX_BUF_SIZE);
+STATIC_UBUF(usbRxBuffer1, CDC_USB_RX_BUF_SIZE);
+static uint8_t * const usbRxBuffer[2] = { usbRxBuffer0, usbRxBuffer1 };
+
+// Buffer used by the bulk benchmark modes, for both directions
+STATIC_UBUF(benchBuffer, CDC_BENCH_XFER_SIZE);
+
+// Operating modes, selected by the baud rate set by the host
+typedef enum {
+  cdcModeEcho,    // Send every packet back
+  cdcModeSink,    // Throw away everything received (host to device throughput)
+  cdcModeSource   // Send full transfers back to back (device to host throughput)
+} cdcMode_TypeDef;
+
+// Byte counters for each direction, they can be watched in the debugger
+typedef struct {
+  uint32_t rxBytes;     // Bytes received from the host
+  uint32_t rxXfers;     // USB read transfers completed
+  uint32_t txBytes;     // Bytes sent to the host
+  uint32_t txXfers;     // USB write transfers completed
+} cdcStats_TypeDef;
+
+static volatile cdcMode_TypeDef cdcMode;
+static cdcStats_TypeDef cdcStats;
+
+// Index of the buffer the next USB read goes to
+static int usbRxIndex;
 
-// Global for letting us know if USB data transmission is currently in progress or not
+// Number of bytes waiting in usbRxBuffer[usbRxIndex ^ 1] in echo mode
+static uint32_t usbRxPending;
+
+// Globals for letting us know if USB data reception/transmission is currently in progress or not
+static bool usbRxActive;
 static bool usbTxActive;
 
 // Function prototypes for receiving/transmitting data over USB
 static int usbDataReceived(USB_Status_TypeDef status, uint32_t xferred, uint32_t remaining);
 static int usbDataTransmitted(USB_Status_TypeDef status, uint32_t xferred, uint32_t remaining);
+static void usbRxStart(void);
+static void usbTxStart(void);
 
 /**************************************************************************//**
 * @brief
@@ -97,6 +137,7 @@ static int lineCodingReceived(USB_Status_TypeDef status, uint32_t xferred, uint3
  (void) remaining;
 
  uint32_t frame = 0;
+ CORE_DECLARE_IRQ_STATE;
 
  // We have received new serial port communication settings from USB host
  if ((status == USB_STATUS_OK) && (xferred == 7)) {
@@ -142,6 +183,20 @@ static int lineCodingReceived(USB_Status_TypeDef status, uint32_t xferred, uint3
      return USB_STATUS_REQ_ERR;
    }
 
+   // The benchmark modes are selected with otherwise unused baud rates
+   if (cdcLineCoding.dwDTERate == CDC_BENCH_BAUD_SINK) {
+     cdcMode = cdcModeSink;
+   } else if (cdcLineCoding.dwDTERate == CDC_BENCH_BAUD_SOURCE) {
+     cdcMode = cdcModeSource;
+   } else {
+     cdcMode = cdcModeEcho;
+   }
+
+   // A source mode transfer can be started right away
+   CORE_ENTER_ATOMIC();
+   usbTxStart();
+   CORE_EXIT_ATOMIC();
+
    return USB_STATUS_OK;
  }
  return USB_STATUS_REQ_ERR;
@@ -236,23 +291,88 @@ void cdcStateChangeEvent(USBD_State_TypeDef oldState, USBD_State_TypeDef newStat
   // If the USB device was configured
   if (newState == USBD_STATE_CONFIGURED) {
 
-    // If we transitioned from the suspended state to the configured state due to bus activity
-    if (oldState == USBD_STATE_SUSPENDED) {} // Currently does nothing
+    // If we transitioned from the suspended state to the configured state due
+    // to bus activity, the transfers set up before the suspend are still in
+    // place and the echo carries on where it was left
+    if (oldState == USBD_STATE_SUSPENDED) {
+      return;
+    }
 
     // Initially, we are waiting to receive data from the USB host over USB
-    usbTxActive = false;
+    usbRxIndex   = 0;
+    usbRxPending = 0;
+    usbRxActive  = false;
+    usbTxActive  = false;
 
     // Setup a new USB receive transfer on the USB host's OUT endpoint
-    USBD_Read(CDC_EP_DATA_OUT, (void*) usbRxBuffer,
-              CDC_USB_RX_BUF_SIZE, usbDataReceived);
+    usbRxStart();
+    usbTxStart();
   }
   // Else if we have been de-configured
   else if ((oldState == USBD_STATE_CONFIGURED) && (newState != USBD_STATE_SUSPENDED)) {
     // Currently nothing is done here
   }
-  // Else if we have been suspended
+  // Else if we have been suspended, the USB stack gates the USB clocks and
+  // the main loop enters EM2 (see USB_PWRSAVE_MODE in usbconfig.h)
   else if (newState == USBD_STATE_SUSPENDED) {
-    // Currently nothing is done here
+    // Nothing to pause, the echo only runs on USB
+  }
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Setup a USB receive transfer on the USB host's OUT endpoint, if the
+ *    current mode has somewhere to put the data
+ *
+ * @note
+ *    Must be called with interrupts masked. While no read is set up the
+ *    device NAKs the host.
+ *****************************************************************************/
+static void usbRxStart(void)
+{
+  if (usbRxActive) {
+    return;
+  }
+
+  if (cdcMode == cdcModeEcho) {
+    // Both buffers in use, wait for the echo to be sent
+    if (usbRxPending > 0) {
+      return;
+    }
+    usbRxActive = true;
+    USBD_Read(CDC_EP_DATA_OUT, (void*) usbRxBuffer[usbRxIndex],
+              CDC_USB_RX_BUF_SIZE, usbDataReceived);
+  } else {
+    usbRxActive = true;
+    USBD_Read(CDC_EP_DATA_OUT, (void*) benchBuffer,
+              CDC_BENCH_XFER_SIZE, usbDataReceived);
+  }
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Setup a USB transmit transfer on the USB host's IN endpoint, if there
+ *    is anything to send in the current mode
+ *
+ * @note
+ *    Must be called with interrupts masked.
+ *****************************************************************************/
+static void usbTxStart(void)
+{
+  if (usbTxActive) {
+    return;
+  }
+
+  if ((cdcMode == cdcModeEcho) && (usbRxPending > 0)) {
+    // Send back the packet waiting in the buffer not used for receiving
+    usbTxActive = true;
+    USBD_Write(CDC_EP_DATA_IN, (void*) usbRxBuffer[usbRxIndex ^ 1],
+               usbRxPending, usbDataTransmitted);
+  } else if (cdcMode == cdcModeSource) {
+    // The contents do not matter, keep the bus busy with full transfers
+    usbTxActive = true;
+    USBD_Write(CDC_EP_DATA_IN, (void*) benchBuffer,
+               CDC_BENCH_XFER_SIZE, usbDataTransmitted);
   }
 }
 
@@ -275,24 +395,31 @@ void cdcStateChangeEvent(USBD_State_TypeDef oldState, USBD_State_TypeDef newStat
  *****************************************************************************/
 static int usbDataReceived(USB_Status_TypeDef status, uint32_t xferred, uint32_t remaining)
 {
+  CORE_DECLARE_IRQ_STATE;
   (void) remaining; // Unused parameter
 
-  // If the status is OK and we actually received data
-  if ((status == USB_STATUS_OK) && (xferred > 0)) {
+  // Transfers aborted by a reset or a configuration change are not restarted
+  if (status != USB_STATUS_OK) {
+    return USB_STATUS_OK;
+  }
 
-    // If the TX line is not busy, we can send a new USB packet
-    if (!usbTxActive) {
+  CORE_ENTER_ATOMIC();
 
-      // Setup a USB transmit transfer
-      usbTxActive = true;
-      USBD_Write(CDC_EP_DATA_IN, (void*) usbRxBuffer,
-          xferred, usbDataTransmitted);
+  usbRxActive = false;
+  cdcStats.rxBytes += xferred;
+  cdcStats.rxXfers++;
 
-      // Setup a new USB receive transfer
-      USBD_Read(CDC_EP_DATA_OUT, (void*) usbRxBuffer,
-          CDC_USB_RX_BUF_SIZE, usbDataReceived);
-    }
+  // In echo mode the packet is sent back from the buffer it arrived in and
+  // the next packet is received into the other buffer
+  if ((cdcMode == cdcModeEcho) && (xferred > 0)) {
+    usbRxPending = xferred;
+    usbRxIndex ^= 1;
   }
+
+  usbTxStart();
+  usbRxStart();
+
+  CORE_EXIT_ATOMIC();
   return USB_STATUS_OK;
 }
 
@@ -315,14 +442,26 @@ static int usbDataReceived(USB_Status_TypeDef status, uint32_t xferred, uint32_t
  *****************************************************************************/
 static int usbDataTransmitted(USB_Status_TypeDef status, uint32_t xferred, uint32_t remaining)
 {
-  (void) xferred;   // Unused parameter
+  CORE_DECLARE_IRQ_STATE;
   (void) remaining; // Unused parameter
 
   // Mark that the USB transmit transaction has been completed
-  if (status == USB_STATUS_OK) {
-    usbTxActive = false;
+  if (status != USB_STATUS_OK) {
+    return USB_STATUS_OK;
   }
 
+  CORE_ENTER_ATOMIC();
+
+  usbTxActive = false;
+  usbRxPending = 0;
+  cdcStats.txBytes += xferred;
+  cdcStats.txXfers++;
+
+  // The echo buffer is free again, start the next transfers
+  usbRxStart();
+  usbTxStart();
+
+  CORE_EXIT_ATOMIC();
   return USB_STATUS_OK;
 }
 
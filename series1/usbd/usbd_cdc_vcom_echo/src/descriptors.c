@@ -203,8 +203,11 @@ const void* const USBDESC_strings[] = {
 // FIFO. 1 should be used for control/interrupt endpoints and 2 should be used
 // for bulk endpoints. Each number represents X times the endpoint size (e.g.
 // 2 means the RAM allocated will be equal to 2 times the endpoint size)
+// The bulk endpoint value is set with CDC_BULK_BUFFERING in usbconfig.h
 const uint8_t USBDESC_bufferingMultiplier[NUM_EP_USED + 1] = {
-  1,        // Common Control endpoint
-  1, 2, 2   // CDC interrupt and bulk endpoints
+  1,                  // Common Control endpoint
+  1,                  // CDC interrupt endpoint
+  CDC_BULK_BUFFERING, // CDC bulk IN endpoint
+  CDC_BULK_BUFFERING  // CDC bulk OUT endpoint
 };
 
@@ -40,6 +40,7 @@
 #include "em_device.h"
 #include "em_cmu.h"
 #include "em_emu.h"
+#include "em_core.h"
 #include "em_chip.h"
 
 // USB specific includes
@@ -83,9 +84,18 @@ int main(void)
   // Initialize and start USB device stack
   USBD_Init(&usbInitStruct);
 
-  // Enter EM1 to save energy
+  // Enter EM2 while the USB is in low power mode (suspended or VBUS off),
+  // EM1 otherwise. Interrupts are masked from the check until the core
+  // sleeps, so a resume in between wakes it at once.
   while (1) {
-    EMU_EnterEM1();
+    CORE_DECLARE_IRQ_STATE;
+    CORE_ENTER_CRITICAL();
+    if (USBD_SafeToEnterEM2()) {
+      EMU_EnterEM2(true);
+    } else {
+      EMU_EnterEM1();
+    }
+    CORE_EXIT_CRITICAL();
   }
 }
 
@@ -0,0 +1,52 @@
+/***************************************************************************//**
+ * @file capture.h
+ * @brief ADC0 capture into a ring of buffers by the LDMA
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2020 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ******************************************************************************/
+
+#ifndef CAPTURE_H
+#define CAPTURE_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// LDMA channel and PRS channel used by the capture
+#define CAPTURE_LDMA_CHANNEL  0
+#define CAPTURE_PRS_CHANNEL   0
+
+void     captureInit(void);
+uint32_t captureStart(uint8_t *ring, uint32_t rate);
+void     captureStop(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // CAPTURE_H
@@ -0,0 +1,67 @@
+/***************************************************************************//**
+ * @file stream.h
+ * @brief Vendor specific bulk IN stream of capture buffers
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2020 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ******************************************************************************/
+
+#ifndef STREAM_H
+#define STREAM_H
+
+#include <stdint.h>
+#include "em_usb.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Vendor requests to the device (bmRequestType 0x40 or 0xC0)
+#define STREAM_REQ_START   0x01  // wValue: source, wIndex: ADC rate in kHz (0 for the default)
+#define STREAM_REQ_STOP    0x02  // No data
+#define STREAM_REQ_STATUS  0x03  // IN, wLength bytes of streamStatus_TypeDef
+
+// Sources of the stream, wValue of STREAM_REQ_START
+#define STREAM_SOURCE_PATTERN  0  // Buffers resent as soon as they are free, a count in the first word
+#define STREAM_SOURCE_ADC      1  // ADC0 samples moved into the ring by the LDMA
+
+// Reply to STREAM_REQ_STATUS, all little endian
+typedef struct {
+  uint32_t bytesSent;   // Bytes sent since STREAM_REQ_START
+  uint32_t xfersSent;   // USB transfers completed
+  uint32_t overruns;    // ADC captures stopped because the host did not keep up
+  uint32_t sampleRate;  // ADC sample rate in Hz, 0 for the pattern
+  uint32_t streaming;   // 1 while the source runs, buffers already filled may still be sent
+} streamStatus_TypeDef;
+
+int  streamSetupCmd(const USB_Setup_TypeDef *setup);
+void streamStateChangeEvent(USBD_State_TypeDef oldState, USBD_State_TypeDef newState);
+void streamBufferFilled(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // STREAM_H
@@ -0,0 +1,194 @@
+/***************************************************************************//**
+ * @file capture.c
+ * @brief ADC0 capture into a ring of buffers by the LDMA
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2020 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ *******************************************************************************
+ * # Evaluation Quality
+ * This code has been minimally tested to ensure that it builds and is suitable 
+ * as a demonstration for evaluation purposes only. This code will be maintained
+ * at the sole discretion of Silicon Labs.
+ ******************************************************************************/
+
+#include "em_device.h"
+#include "em_cmu.h"
+#include "em_adc.h"
+#include "em_ldma.h"
+#include "em_prs.h"
+#include "em_timer.h"
+
+#include "usbconfig.h"
+#include "stream.h"
+#include "capture.h"
+
+// Init to max ADC clock for Series 1
+#define ADC_FREQ        16000000
+
+// Samples moved per LDMA arbitration, also the single FIFO data valid level
+#define ADC_DVL         4
+
+#if (STREAM_BUF_SIZE > 4096) || ((STREAM_BUF_SIZE % (2 * ADC_DVL)) != 0)
+#error "STREAM_BUF_SIZE must be at most 4096 and a multiple of 2 * ADC_DVL"
+#endif
+
+// One descriptor per ring buffer, linked in a circle
+static LDMA_Descriptor_t descriptors[STREAM_BUF_CNT];
+
+/**************************************************************************//**
+ * @brief LDMA Handler
+ *
+ * @details
+ *   Each descriptor interrupts once its buffer is full; the LDMA has already
+ *   moved on to the next buffer of the ring.
+ *****************************************************************************/
+void LDMA_IRQHandler(void)
+{
+  uint32_t pending = LDMA_IntGetEnabled();
+
+  if (pending & LDMA_IF_ERROR) {
+    __BKPT(0);
+  }
+
+  if (pending & ((1 << CAPTURE_LDMA_CHANNEL) << _LDMA_IFC_DONE_SHIFT)) {
+    // Clear interrupt flag
+    LDMA_IntClear((1 << CAPTURE_LDMA_CHANNEL) << _LDMA_IFC_DONE_SHIFT);
+
+    streamBufferFilled();
+  }
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Set up the ADC, the TIMER that paces it and the LDMA, without starting
+ *   a capture
+ *****************************************************************************/
+void captureInit(void)
+{
+  ADC_Init_TypeDef init = ADC_INIT_DEFAULT;
+  ADC_InitSingle_TypeDef initSingle = ADC_INITSINGLE_DEFAULT;
+  TIMER_Init_TypeDef timerInit = TIMER_INIT_DEFAULT;
+  LDMA_Init_t ldmaInit = LDMA_INIT_DEFAULT;
+
+  CMU_ClockEnable(cmuClock_HFPER, true);
+  CMU_ClockEnable(cmuClock_ADC0, true);
+  CMU_ClockEnable(cmuClock_TIMER0, true);
+  CMU_ClockEnable(cmuClock_PRS, true);
+  CMU_ClockEnable(cmuClock_LDMA, true);
+
+  // ADC clocked from HFPERCLK, as fast as it may run
+  init.timebase = ADC_TimebaseCalc(0);
+  init.prescale = ADC_PrescaleCalc(ADC_FREQ, 0);
+
+  // Add external ADC input. See README for corresponding EXP header pin.
+  initSingle.posSel = adcPosSelAPORT4XCH11;
+
+  // Basic ADC single configuration, one conversion per PRS pulse
+  initSingle.diff       = false;        // single-ended
+  initSingle.reference  = adcRef2V5;    // 2.5V reference
+  initSingle.resolution = adcRes12Bit;  // 12-bit resolution
+  initSingle.acqTime    = adcAcqTime2;  // 2 + 13 ADC clocks per conversion
+  initSingle.prsEnable  = true;
+  initSingle.prsSel     = (ADC_PRSSEL_TypeDef) CAPTURE_PRS_CHANNEL;
+
+  ADC_Init(ADC0, &init);
+  ADC_InitSingle(ADC0, &initSingle);
+
+  // Set single data valid level (DVL)
+  ADC0->SINGLECTRLX = (ADC0->SINGLECTRLX & ~_ADC_SINGLECTRLX_DVL_MASK)
+                      | (((ADC_DVL - 1) << _ADC_SINGLECTRLX_DVL_SHIFT) & _ADC_SINGLECTRLX_DVL_MASK);
+
+  // TIMER0 overflows pace the conversions through the PRS
+  timerInit.enable = false;
+  TIMER_Init(TIMER0, &timerInit);
+  PRS_SourceSignalSet(CAPTURE_PRS_CHANNEL, PRS_CH_CTRL_SOURCESEL_TIMER0,
+                      PRS_CH_CTRL_SIGSEL_TIMER0OF, prsEdgeOff);
+
+  LDMA_Init(&ldmaInit);
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Start capturing into the ring
+ *
+ * @details
+ *   The LDMA fills the STREAM_BUF_CNT buffers of the ring in turn, as
+ *   right aligned 12-bit samples in 16-bit words, and calls
+ *   streamBufferFilled() from its interrupt for every full buffer. It goes
+ *   round the ring until captureStop().
+ *
+ * @param[in] ring
+ *   STREAM_BUF_CNT * STREAM_BUF_SIZE bytes, 4-byte aligned.
+ *
+ * @param[in] rate
+ *   Sample rate in Hz.
+ *
+ * @return
+ *   The sample rate set, the TIMER0 clock divided by a whole number.
+ *****************************************************************************/
+uint32_t captureStart(uint8_t *ring, uint32_t rate)
+{
+  LDMA_TransferCfg_t transferCfg =
+    LDMA_TRANSFER_CFG_PERIPHERAL(ldmaPeripheralSignal_ADC0_SINGLE);
+  uint32_t clock = CMU_ClockFreqGet(cmuClock_TIMER0);
+  uint32_t top = (clock + (rate / 2)) / rate;
+  uint32_t i;
+
+  for (i = 0; i < STREAM_BUF_CNT; i++) {
+    descriptors[i] = (LDMA_Descriptor_t)
+      LDMA_DESCRIPTOR_LINKREL_P2M_BYTE(&(ADC0->SINGLEDATA),
+                                       ring + (i * STREAM_BUF_SIZE),
+                                       STREAM_BUF_SIZE / 2, 1);
+    descriptors[i].xfer.size      = ldmaCtrlSizeHalf;
+    descriptors[i].xfer.blockSize = ADC_DVL - 1;  // ADC_DVL units per arbitration
+    descriptors[i].xfer.ignoreSrec = true;        // Wait for ADC_DVL samples
+    descriptors[i].xfer.doneIfs   = 1;
+  }
+
+  // The last buffer links back to the first
+  descriptors[STREAM_BUF_CNT - 1].xfer.linkAddr =
+    -(int32_t)((STREAM_BUF_CNT - 1) * LDMA_DESCRIPTOR_NDWORDS);
+
+  // Start from an empty single FIFO
+  ADC0->SINGLEFIFOCLEAR = ADC_SINGLEFIFOCLEAR_SINGLEFIFOCLEAR;
+
+  LDMA_StartTransfer(CAPTURE_LDMA_CHANNEL, &transferCfg, &descriptors[0]);
+
+  TIMER_TopSet(TIMER0, top - 1);
+  TIMER_CounterSet(TIMER0, 0);
+  TIMER_Enable(TIMER0, true);
+
+  return clock / top;
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Stop the conversions and the LDMA
+ *****************************************************************************/
+void captureStop(void)
+{
+  TIMER_Enable(TIMER0, false);
+  LDMA_StopTransfer(CAPTURE_LDMA_CHANNEL);
+}
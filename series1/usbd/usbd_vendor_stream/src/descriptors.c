@@ -0,0 +1,143 @@
+/***************************************************************************//**
+ * @file descriptors.c
+ * @brief Global descriptors that describe the device to the host.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2020 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ *******************************************************************************
+ * # Evaluation Quality
+ * This code has been minimally tested to ensure that it builds and is suitable 
+ * as a demonstration for evaluation purposes only. This code will be maintained
+ * at the sole discretion of Silicon Labs.
+ ******************************************************************************/
+
+#include "descriptors.h"
+
+/****************************************************************************
+ * Device Descriptor                                                        *
+ ****************************************************************************/
+SL_ALIGN(4)
+const USB_DeviceDescriptor_TypeDef USBDESC_deviceDesc SL_ATTRIBUTE_ALIGN(4) = {
+  .bLength            = USB_DEVICE_DESCSIZE,    // Descriptor size in bytes
+  .bDescriptorType    = USB_DEVICE_DESCRIPTOR,  // Descriptor type
+  .bcdUSB             = 0x0200,                 // USB version (0200 in BCD = USB 2.0)
+  .bDeviceClass       = 0,                      // Class code, in the interface
+  .bDeviceSubClass    = 0,                      // Subclass code
+  .bDeviceProtocol    = 0,                      // Protocol code
+  .bMaxPacketSize0    = USB_FS_CTRL_EP_MAXSIZE, // Max packet size for EP0
+  .idVendor           = 0x10C4,                 // Vendor ID
+  .idProduct          = 0x0009,                 // Product ID, an example only
+  .bcdDevice          = 0x0000,                 // Release number in BCD
+  .iManufacturer      = 1,                      // Index of string descriptor for manufacturer
+  .iProduct           = 2,                      // Index of string descriptor for product
+  .iSerialNumber      = 0,                      // Index of string descriptor for manufacturer
+  .bNumConfigurations = 1                       // Number of supported configurations
+};
+
+/****************************************************************************
+ * Configuration Descriptor Length Calculation                              *
+ ****************************************************************************/
+#define CONFIG_DESC_TOTAL_LEN                  \
+  (USB_CONFIG_DESCSIZE                         \
+   + (USB_INTERFACE_DESCSIZE * NUM_INTERFACES) \
+   + (USB_ENDPOINT_DESCSIZE  * NUM_EP_USED))
+
+/****************************************************************************
+ * Configuration Descriptor and Subordinate Descriptors                     *
+ *  - Interface Descriptors and Endpoint Descriptors                        *
+ ****************************************************************************/
+SL_ALIGN(4)
+const uint8_t USBDESC_configDesc[] SL_ATTRIBUTE_ALIGN(4) = {
+
+  // Configuration descriptor
+  USB_CONFIG_DESCSIZE,          // bLength
+  USB_CONFIG_DESCRIPTOR,        // bDescriptorType
+  CONFIG_DESC_TOTAL_LEN,        // wTotalLength (LSB)
+  CONFIG_DESC_TOTAL_LEN >> 8,   // wTotalLength (MSB)
+  NUM_INTERFACES,               // bNumInterfaces
+  1,                            // bConfigurationValue
+  0,                            // iConfiguration
+  CONFIG_DESC_BM_RESERVED_D7    // bmAttrib: Self powered
+  | CONFIG_DESC_BM_SELFPOWERED,
+  CONFIG_DESC_MAXPOWER_mA(100), // bMaxPower: 100 mA
+
+  // Vendor specific stream Interface descriptor (Interface #0)
+  USB_INTERFACE_DESCSIZE,       // bLength
+  USB_INTERFACE_DESCRIPTOR,     // bDescriptorType
+  STREAM_INTERFACE_NO,          // bInterfaceNumber
+  0,                            // bAlternateSetting
+  NUM_EP_USED,                  // bNumEndpoints
+  0xFF,                         // bInterfaceClass: Vendor specific
+  0,                            // bInterfaceSubClass
+  0,                            // bInterfaceProtocol
+  0,                            // iInterface
+
+  // Stream endpoint descriptor (IN) (BULK)
+  USB_ENDPOINT_DESCSIZE,        // bLength
+  USB_ENDPOINT_DESCRIPTOR,      // bDescriptorType
+  STREAM_EP_IN,                 // bEndpointAddress (IN)
+  USB_EPTYPE_BULK,              // bmAttributes
+  USB_FS_BULK_EP_MAXSIZE,       // wMaxPacketSize (LSB)
+  0,                            // wMaxPacketSize (MSB)
+  0,                            // bInterval
+};
+
+/****************************************************************************
+ * Optional String Descriptors                                              *
+ ****************************************************************************/
+STATIC_CONST_STRING_DESC_LANGID(langID, 0x04, 0x09); // English
+STATIC_CONST_STRING_DESC(iManufacturer,
+                         'S', 'i', 'l', 'i', 'c', 'o', 'n', ' ', \
+                         'L', 'a', 'b', 'o', 'r', 'a', 't', 'o', 'r', 'i', 'e', 's', ' ', \
+                         'I', 'n', 'c', '.');
+STATIC_CONST_STRING_DESC(iProduct,
+                         'E', 'F', 'M', '3', '2', ' ', \
+                         'U', 'S', 'B', ' ', \
+                         'S', 't', 'r', 'e', 'a', 'm', ' ', \
+                         'D', 'e', 'v', 'i', 'c', 'e');
+STATIC_CONST_STRING_DESC(iSerialNumber,
+                         '0', '0', '0', '0', '1', '2', \
+                         '3', '4', '5', '6', '7', '8');
+const void* const USBDESC_strings[] = {
+  &langID,
+  &iManufacturer,
+  &iProduct,
+  &iSerialNumber
+};
+
+/****************************************************************************
+ * Endpoint Buffer Size                                                     *
+ ****************************************************************************/
+// Each multiplier value specifies how much RAM to allocate for each endpoint's
+// FIFO. 1 should be used for control/interrupt endpoints and 2 should be used
+// for bulk endpoints. Each number represents X times the endpoint size (e.g.
+// 2 means the RAM allocated will be equal to 2 times the endpoint size)
+// The stream endpoint value is set with STREAM_BULK_BUFFERING in usbconfig.h,
+// a deep FIFO keeps packets ready while the next transfer is set up
+const uint8_t USBDESC_bufferingMultiplier[NUM_EP_USED + 1] = {
+  1,                    // Common Control endpoint
+  STREAM_BULK_BUFFERING // Stream bulk IN endpoint
+};
+
@@ -0,0 +1,386 @@
+/***************************************************************************//**
+ * @file stream.c
+ * @brief Vendor specific bulk IN stream of capture buffers
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2020 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ *******************************************************************************
+ * # Evaluation Quality
+ * This code has been minimally tested to ensure that it builds and is suitable 
+ * as a demonstration for evaluation purposes only. This code will be maintained
+ * at the sole discretion of Silicon Labs.
+ ******************************************************************************/
+
+#include "em_core.h"
+#include "em_usb.h"
+
+#include "capture.h"
+#include "stream.h"
+
+#if (STREAM_BUF_CNT & (STREAM_BUF_CNT - 1)) != 0
+#error "STREAM_BUF_CNT must be a power of 2"
+#endif
+
+#if (STREAM_BUF_SIZE % USB_FS_BULK_EP_MAXSIZE) != 0
+#error "STREAM_BUF_SIZE must be a multiple of the endpoint size"
+#endif
+
+// Ring of capture buffers, 4-byte aligned for the LDMA and the USB DMA. The
+// USB transfers are sent straight from the ring, nothing is copied.
+STATIC_UBUF(ring, STREAM_BUF_CNT * STREAM_BUF_SIZE);
+
+// head counts the buffers filled and tail the buffers sent, both wrap at
+// 2^32. The buffers in [tail, head) wait for USB, the first inFlight of
+// them are in the USB transfer in progress. The LDMA writes buffer head.
+static uint32_t head;
+static uint32_t tail;
+static uint32_t inFlight;
+
+static bool configured;
+static bool capturing;
+static uint32_t source;
+static uint32_t sequence;
+
+// Reply to STREAM_REQ_STATUS, sent from here by the USB DMA
+SL_ALIGN(4)
+static streamStatus_TypeDef SL_ATTRIBUTE_ALIGN(4) status;
+
+static int dataTransmitted(USB_Status_TypeDef xferStatus, uint32_t xferred, uint32_t remaining);
+
+/**************************************************************************//**
+ * @brief
+ *    Buffer of the ring for a head or tail count
+ *****************************************************************************/
+static uint8_t *bufferOf(uint32_t count)
+{
+  return ring + ((count & (STREAM_BUF_CNT - 1)) * STREAM_BUF_SIZE);
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Queue the next pattern buffer, with a count in its first word
+ *
+ * @note
+ *    Must be called with interrupts masked.
+ *****************************************************************************/
+static void queuePattern(void)
+{
+  uint32_t *word = (uint32_t *) bufferOf(head);
+
+  word[0] = sequence++;
+  head++;
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Hand the ready buffers to the USB stack
+ *
+ * @details
+ *    Buffers next to each other in the ring go out as one transfer of up
+ *    to STREAM_MAX_QUEUE buffers, so the USB core streams packets without
+ *    software in between. The next transfer is set up from the completion
+ *    callback of this one.
+ *
+ * @note
+ *    Must be called with interrupts masked.
+ *****************************************************************************/
+static void txStart(void)
+{
+  uint32_t count = head - tail;
+  uint32_t toEnd = STREAM_BUF_CNT - (tail & (STREAM_BUF_CNT - 1));
+
+  if (!configured || (inFlight > 0) || (count == 0)) {
+    return;
+  }
+
+  // A transfer cannot wrap around the end of the ring
+  if (count > toEnd) {
+    count = toEnd;
+  }
+  if (count > STREAM_MAX_QUEUE) {
+    count = STREAM_MAX_QUEUE;
+  }
+
+  inFlight = count;
+  USBD_Write(STREAM_EP_IN, (void*) bufferOf(tail), count * STREAM_BUF_SIZE,
+             dataTransmitted);
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Stop the stream and drop the buffers not sent
+ *
+ * @note
+ *    Must be called with interrupts masked.
+ *****************************************************************************/
+static void streamStop(void)
+{
+  if (capturing) {
+    captureStop();
+    capturing = false;
+  }
+  status.streaming = 0;
+
+  // The host sees the end of the data in flight
+  if (inFlight > 0) {
+    USBD_AbortTransfer(STREAM_EP_IN);
+    inFlight = 0;
+  }
+  head = 0;
+  tail = 0;
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Start the stream from a source
+ *
+ * @param[in] newSource
+ *    STREAM_SOURCE_PATTERN or STREAM_SOURCE_ADC.
+ *
+ * @param[in] rateKhz
+ *    ADC sample rate in kHz, 0 for STREAM_DEFAULT_RATE_KHZ.
+ *
+ * @return
+ *    false if the source or rate is not supported.
+ *
+ * @note
+ *    Must be called with interrupts masked.
+ *****************************************************************************/
+static bool streamStart(uint32_t newSource, uint32_t rateKhz)
+{
+  uint32_t i;
+
+  if (rateKhz == 0) {
+    rateKhz = STREAM_DEFAULT_RATE_KHZ;
+  }
+  if ((newSource > STREAM_SOURCE_ADC) || (rateKhz > STREAM_MAX_RATE_KHZ)) {
+    return false;
+  }
+
+  streamStop();
+
+  source = newSource;
+  sequence = 0;
+  status.bytesSent = 0;
+  status.xfersSent = 0;
+  status.overruns = 0;
+  status.streaming = 1;
+
+  if (source == STREAM_SOURCE_PATTERN) {
+    // The rest of each buffer keeps whatever it holds, only the count in
+    // the first word is checked
+    for (i = 0; i < STREAM_BUF_CNT; i++) {
+      queuePattern();
+    }
+    status.sampleRate = 0;
+    txStart();
+  } else {
+    status.sampleRate = captureStart(ring, rateKhz * 1000);
+    capturing = true;
+  }
+
+  return true;
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Called from the LDMA interrupt each time the ADC capture has filled a
+ *    buffer of the ring
+ *
+ * @details
+ *    If the LDMA has moved on to the buffer being sent, the host has not
+ *    kept up and the capture is stopped before it overwrites more than a
+ *    few samples. The buffers already filled are still sent.
+ *****************************************************************************/
+void streamBufferFilled(void)
+{
+  CORE_DECLARE_IRQ_STATE;
+
+  CORE_ENTER_ATOMIC();
+
+  if (capturing) {
+    head++;
+    if ((head - tail) >= STREAM_BUF_CNT) {
+      // The LDMA is writing buffer tail again
+      captureStop();
+      capturing = false;
+      status.streaming = 0;
+      status.overruns++;
+    }
+    txStart();
+  }
+
+  CORE_EXIT_ATOMIC();
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Callback that gets called whenever a transfer of buffers has been
+ *    sent to the host
+ *
+ * @param[in] xferStatus
+ *    Transfer status code
+ *
+ * @param[in] xferred
+ *    Number of bytes transferred
+ *
+ * @param[in] remaining
+ *    Number of bytes not transferred
+ *
+ * @return
+ *    USB_STATUS_OK.
+ *****************************************************************************/
+static int dataTransmitted(USB_Status_TypeDef xferStatus, uint32_t xferred, uint32_t remaining)
+{
+  CORE_DECLARE_IRQ_STATE;
+  uint32_t i, count;
+  (void) remaining; // Unused parameter
+
+  // Transfers aborted by a reset, a configuration change or a stop are not
+  // restarted
+  if (xferStatus != USB_STATUS_OK) {
+    return USB_STATUS_OK;
+  }
+
+  CORE_ENTER_ATOMIC();
+
+  count = inFlight;
+  tail += count;
+  inFlight = 0;
+  status.bytesSent += xferred;
+  status.xfersSent++;
+
+  // The pattern buffers go round again at once
+  if (status.streaming && (source == STREAM_SOURCE_PATTERN)) {
+    for (i = 0; i < count; i++) {
+      queuePattern();
+    }
+  }
+
+  txStart();
+
+  CORE_EXIT_ATOMIC();
+  return USB_STATUS_OK;
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Callback that gets called whenever a USB setup command is received from
+ *    the host.
+ *
+ * @param[in] setup
+ *    Pointer to a USB setup packet
+ *
+ * @return
+ *    USB_STATUS_OK --> if command was accepted
+ *    USB_STATUS_REQ_ERR --> if the vendor request is invalid
+ *    USB_STATUS_REQ_UNHANDLED --> when command is unknown, the USB device
+ *                                 stack will handle the request.
+ *****************************************************************************/
+int streamSetupCmd(const USB_Setup_TypeDef *setup)
+{
+  int retVal = USB_STATUS_REQ_UNHANDLED;
+  CORE_DECLARE_IRQ_STATE;
+
+  if ((setup->Type != USB_SETUP_TYPE_VENDOR) || (setup->Recipient != USB_SETUP_RECIPIENT_DEVICE)) {
+    return retVal;
+  }
+
+  CORE_ENTER_ATOMIC();
+
+  switch (setup->bRequest) {
+
+    // Start streaming from the source in wValue
+    case STREAM_REQ_START:
+      if ((setup->wLength == 0) && configured && streamStart(setup->wValue, setup->wIndex)) {
+        retVal = USB_STATUS_OK;
+      } else {
+        retVal = USB_STATUS_REQ_ERR;
+      }
+      break;
+
+    // Stop streaming
+    case STREAM_REQ_STOP:
+      if (setup->wLength == 0) {
+        streamStop();
+        retVal = USB_STATUS_OK;
+      } else {
+        retVal = USB_STATUS_REQ_ERR;
+      }
+      break;
+
+    // Send the counters to the host
+    case STREAM_REQ_STATUS:
+      if ((setup->Direction == USB_SETUP_DIR_IN) && (setup->wLength > 0)) {
+        USBD_Write(0, (void*) &status,
+                   SL_MIN(setup->wLength, sizeof(status)), NULL);
+        retVal = USB_STATUS_OK;
+      } else {
+        retVal = USB_STATUS_REQ_ERR;
+      }
+      break;
+
+    default:
+      retVal = USB_STATUS_REQ_ERR;
+      break;
+  }
+
+  CORE_EXIT_ATOMIC();
+  return retVal;
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Callback that gets called each time the USB device state is changed
+ *
+ * @details
+ *    The stream only starts on STREAM_REQ_START from the host. It stops
+ *    when the device is reset or de-configured and carries on after a
+ *    resume from suspend.
+ *
+ * @param[in] oldState
+ *    The old USB device state
+ *
+ * @param[in] newState
+ *    The new (current) USB device state
+ *****************************************************************************/
+void streamStateChangeEvent(USBD_State_TypeDef oldState, USBD_State_TypeDef newState)
+{
+  CORE_DECLARE_IRQ_STATE;
+
+  CORE_ENTER_ATOMIC();
+
+  if (newState == USBD_STATE_CONFIGURED) {
+    configured = true;
+  }
+  // Else if we have been de-configured, the stack has aborted the transfer
+  else if ((oldState == USBD_STATE_CONFIGURED) && (newState != USBD_STATE_SUSPENDED)) {
+    inFlight = 0;
+    streamStop();
+    configured = false;
+  }
+
+  CORE_EXIT_ATOMIC();
+}
@@ -48,6 +48,41 @@
 /* Change these to change vmon source */
 #define VMON_CHANNEL  emuVmonChannel_AVDD
 
+/* RTCC retention register that counts the dips through EM4H */
+#define DIP_COUNT_RET       0
+
+/* Dips counted so far, for the debugger */
+uint32_t dipCount;
+
+/**************************************************************************//**
+ * @brief
+ *    Handle a VMON wake from EM4H before any other initialization
+ *
+ * @details
+ *    Called first in main(), before CHIP_Init() and the GPIO, VMON and EM4
+ *    setup. The VMON keeps its settings and runs on in EM4H, so one read of
+ *    its status tells a real drop from a dip: if the supply is back above
+ *    THRESHOLD_VOLTAGE, the dip only counts up in an RTCC retention
+ *    register and the device goes straight back to EM4H. A drop, or any
+ *    other wake, returns for the full initialization. The RTCC itself is
+ *    not clocked, its retention registers only need the low energy bus
+ *    clock.
+ *****************************************************************************/
+void fastWake(void)
+{
+  if ((RMU_ResetCauseGet() != RMU_RSTCAUSE_EM4RST)
+      || !EMU_VmonChannelStatusGet(VMON_CHANNEL))
+  {
+    return;
+  }
+
+  CMU_ClockEnable(cmuClock_HFLE, true);
+  RTCC->RET[DIP_COUNT_RET].REG++;
+
+  RMU_ResetCauseClear();
+  EMU_EnterEM4H();
+}
+
 /**************************************************************************//**
  * @brief GPIO initialization
  *****************************************************************************/
@@ -108,6 +143,9 @@ void initEm4(void)
  ******************************************************************************/
 int main()
 {
+  /* Count a dip and go back to EM4H unless the supply stays low */
+  fastWake();
+
   /* Initialize chip */
   CHIP_Init();
 
@@ -127,6 +165,7 @@ int main()
   /* If the last Reset was due to leaving EM4, turn on LED. Else, enter EM4 */
   if (rstCause == RMU_RSTCAUSE_EM4RST)
   {
+    dipCount = RTCC->RET[DIP_COUNT_RET].REG;
     GPIO_PinOutClear(BSP_GPIO_LED0_PORT, BSP_GPIO_LED0_PIN);
     EMU_EnterEM2(false);
   }
@@ -137,6 +176,8 @@ int main()
 	{
 		while(1);
 	}
+    /* Start counting dips from zero */
+    RTCC->RET[DIP_COUNT_RET].REG = 0;
     EMU_EnterEM4H();
   }
 
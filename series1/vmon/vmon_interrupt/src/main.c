@@ -1,6 +1,11 @@
 /***************************************************************************//**
  * @file main.c
  * @brief VMON Interrupt Example
+ *
+ * LED0 shows whether the supply is above the VMON threshold. Flash erases,
+ * started with push button PB0, only run while the supply is good, and at
+ * most one per ERASE_SPACING_MS, so that a sagging coin cell is not pulled
+ * down into a brown-out reset.
  *******************************************************************************
  * # License
  * <b>Copyright 2020 Silicon Laboratories Inc. www.silabs.com</b>
@@ -39,14 +44,48 @@
 #include "em_emu.h"
 #include "em_system.h"
 #include "em_gpio.h"
+#include "em_msc.h"
+#include "em_rtcc.h"
 #include "bsp.h"
+#include "lpdelay.h"
+#include "supguard.h"
 
 /* Change this to change voltage threshold.  Current is 3.0 volts */
 #define THRESHOLD_VOLTAGE    3000
 
-/* Change these to change vmon source */
+/* Soft threshold: high current work is held back below it */
+#define SOFT_FALL_VOLTAGE    2900
+
+/* Change this to change vmon source.  Hysteresis needs AVDD */
 #define VMON_CHANNEL  emuVmonChannel_AVDD
-#define VMON_IF_BOTH_EDGES       EMU_IF_VMONAVDDFALL | EMU_IF_VMONAVDDRISE
+
+/* Supply good this long before an erase, and least time between erases */
+#define RECOVERY_MS          100
+#define ERASE_SPACING_MS     500
+
+/* How often the main loop wakes up while erases are queued */
+#define POLL_MS              20
+
+/* The page each erase clears and writes */
+#define USERDATA ((uint32_t *)USERDATA_BASE)
+
+/* Number of PB0 presses, stored in USERDATA by each erase */
+static uint32_t pressCount;
+
+/* Set by the PB0 interrupt */
+static volatile bool buttonPressed;
+
+/* Counters for the debugger */
+volatile uint32_t erasesDone;
+SUPGUARD_Counters_TypeDef guardCounters;
+
+/**************************************************************************//**
+ * @brief Convert milliseconds to RTCC ticks
+ *****************************************************************************/
+static uint32_t msToTicks(uint32_t ms)
+{
+  return (uint32_t)(((uint64_t)ms * CMU_ClockFreqGet(cmuClock_RTCC)) / 1000);
+}
 
 /**************************************************************************//**
  * @brief GPIO initialization
@@ -58,43 +97,46 @@ void initGpio(void)
 
   // Configure LEDs as output
   GPIO_PinModeSet(BSP_GPIO_LED0_PORT, BSP_GPIO_LED0_PIN, gpioModePushPull, 1);
+
+  // Configure PB0 as input with a falling edge interrupt
+  GPIO_PinModeSet(BSP_GPIO_PB0_PORT, BSP_GPIO_PB0_PIN, gpioModeInputPullFilter, 1);
+  GPIO_ExtIntConfig(BSP_GPIO_PB0_PORT, BSP_GPIO_PB0_PIN, BSP_GPIO_PB0_PIN,
+                    false, true, true);
+
+  NVIC_ClearPendingIRQ(GPIO_EVEN_IRQn);
+  NVIC_EnableIRQ(GPIO_EVEN_IRQn);
+  NVIC_ClearPendingIRQ(GPIO_ODD_IRQn);
+  NVIC_EnableIRQ(GPIO_ODD_IRQn);
 }
 
 /**************************************************************************//**
  * @brief VMON initialization
+ *
+ * @details
+ *    The supply goes low below SOFT_FALL_VOLTAGE and good again above
+ *    THRESHOLD_VOLTAGE, the hysteresis keeps a droop under load from
+ *    toggling it.
  *****************************************************************************/
 void initVmon(void)
 {
-  /* Declare VMON_Init typedef */
-  EMU_VmonInit_TypeDef vmonInit = EMU_VMONINIT_DEFAULT;
-
-  /* Configure channel */
-  vmonInit.channel = VMON_CHANNEL;
-
-  /* Configure threshold */
-  vmonInit.threshold = THRESHOLD_VOLTAGE;
-
-  /* Initialize VMON */
-  EMU_VmonInit(&vmonInit);
+  SUPGUARD_Init_TypeDef guardInit;
 
-  /* Enable VMON for AVDD interrupts*/
-  EMU_IntEnable(VMON_IF_BOTH_EDGES);
+  guardInit.channel       = VMON_CHANNEL;
+  guardInit.fallThreshold = SOFT_FALL_VOLTAGE;
+  guardInit.riseThreshold = THRESHOLD_VOLTAGE;
+  guardInit.recoveryTicks = msToTicks(RECOVERY_MS);
+  guardInit.spacingTicks  = msToTicks(ERASE_SPACING_MS);
 
-  /* Enable VCMP interrupts */
-  NVIC_ClearPendingIRQ(EMU_IRQn);
-  NVIC_EnableIRQ(EMU_IRQn);
+  /* Initialize VMON, enables the EMU interrupt */
+  SUPGUARD_Init(&guardInit);
 }
 
 /**************************************************************************//**
- * @brief  EMU Handler
+ * @brief Show the supply state on LED0, on while the supply is good
  *****************************************************************************/
-void EMU_IRQHandler(void)
+static void showSupply(void)
 {
-  /* Check if voltage has dropped below threshold */
-  bool voltageAboveMax = EMU_VmonChannelStatusGet(VMON_CHANNEL);
-
-  /* Set LED */
-  if (voltageAboveMax)
+  if (!SUPGUARD_IsLow())
   {
     GPIO_PinOutSet(BSP_GPIO_LED0_PORT, BSP_GPIO_LED0_PIN);
   }
@@ -102,8 +144,49 @@ void EMU_IRQHandler(void)
   {
     GPIO_PinOutClear(BSP_GPIO_LED0_PORT, BSP_GPIO_LED0_PIN);
   }
-  /* Clear interrupt flag */
-  EMU_IntClear(VMON_IF_BOTH_EDGES);
+}
+
+/**************************************************************************//**
+ * @brief  EMU Handler
+ *****************************************************************************/
+void EMU_IRQHandler(void)
+{
+  /* Follow the supply, then set LED */
+  SUPGUARD_IRQHandler();
+  showSupply();
+}
+
+/**************************************************************************//**
+ * @brief GPIO Even IRQ for pushbuttons on even-numbered pins
+ *****************************************************************************/
+void GPIO_EVEN_IRQHandler(void)
+{
+  GPIO_IntClear(GPIO_IntGet() & 0x5555);
+  buttonPressed = true;
+}
+
+/**************************************************************************//**
+ * @brief GPIO Odd IRQ for pushbuttons on odd-numbered pins
+ *****************************************************************************/
+void GPIO_ODD_IRQHandler(void)
+{
+  GPIO_IntClear(GPIO_IntGet() & 0xAAAA);
+  buttonPressed = true;
+}
+
+/**************************************************************************//**
+ * @brief High current work: erase USERDATA and store the press count
+ *****************************************************************************/
+static void eraseAndStore(void *arg)
+{
+  uint32_t value = *(uint32_t *)arg;
+
+  MSC_Init();
+  if (MSC_ErasePage(USERDATA) == mscReturnOk) {
+    MSC_WriteWord(USERDATA, &value, 4);
+    erasesDone++;
+  }
+  MSC_Deinit();
 }
 
 /***************************************************************************//**
@@ -111,18 +194,45 @@ void EMU_IRQHandler(void)
  ******************************************************************************/
 int main()
 {
+  uint32_t queued = 0;
+
   /* Initialize chip */
   CHIP_Init();
 
   /* Initialize GPIO */
   initGpio();
 
-  /* Initialize VCMP */
+  /* Start the RTCC, the time base of the guard */
+  LPDELAY_Init(true);
+
+  /* Initialize VMON */
   initVmon();
 
+  /* Show the supply state from the start */
+  showSupply();
+
   /* Enter EM2 whenever not in interrupt */
   while (1)
   {
-    EMU_EnterEM2(false);
+    if (buttonPressed)
+    {
+      buttonPressed = false;
+      pressCount++;
+      SUPGUARD_Submit(eraseAndStore, &pressCount);
+    }
+
+    /* Run the oldest erase if the supply allows it */
+    queued = SUPGUARD_Run(RTCC_CounterGet());
+    SUPGUARD_GetCounters(&guardCounters);
+
+    if (queued > 0)
+    {
+      /* Wake up again to retry, VMON and PB0 interrupts also wake up */
+      LPDELAY_Ms(POLL_MS);
+    }
+    else
+    {
+      EMU_EnterEM2(false);
+    }
   }
 }
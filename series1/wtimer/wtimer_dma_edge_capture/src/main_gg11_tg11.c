@@ -1,8 +1,8 @@
 /***************************************************************************//**
  * @file main_gg11_tg11.c
- * @brief This project demonstrates edge capture with LDMA. The first 512 events
- * captured by WTIMER0 CC0 are transferred to a fixed length buffer by the LDMA.
- * This project captures falling edges.
+ * @brief This project demonstrates edge capture with LDMA. Every event
+ * captured by WTIMER0 CC0 is transferred to a looped ring by the LDMA and read
+ * back as the time between edges. This project captures falling edges.
  *******************************************************************************
  * # License
  * <b>Copyright 2020 Silicon Laboratories Inc. www.silabs.com</b>
@@ -41,17 +41,30 @@
 #include "em_chip.h"
 #include "em_gpio.h"
 #include "em_timer.h"
+#include "em_core.h"
 #include "em_ldma.h"
 
+#include "edgestream.h"
+
 // Timer prescale
 #define WTIMER0_PRESCALE timerPrescale1;
 
-// Buffer size
-#define BUFFER_SIZE 512
+// Captures held until they are read, and deltas read at a time
+#define RING_SIZE   512
+#define DELTA_SIZE  64
+
+// Ring to hold edge capture values, written by the LDMA
+static uint32_t captureRing[RING_SIZE];
+
+// Time between successive falling edges in WTIMER0 clocks, the last batch
+// read
+uint32_t deltas[DELTA_SIZE];
+volatile uint32_t deltaCount;
 
-// Buffer to hold edge capture values
-// Note: needs to be volatile or else the compiler will optimize it out
-static volatile uint32_t buffer[BUFFER_SIZE];
+// Edges read, edges lost to a full ring and WTIMER0 overflows
+volatile uint32_t edgeCount;
+volatile uint32_t overrunCount;
+volatile uint32_t overflowCount;
 
 /**************************************************************************//**
  * @brief
@@ -86,50 +99,13 @@ void initWtimer(void)
   WTIMER0->ROUTEPEN |=  TIMER_ROUTEPEN_CC0PEN;
   WTIMER0->ROUTELOC0 |= TIMER_ROUTELOC0_CC0LOC_LOC7;
 
-  // Initialize timer
+  // Initialize timer, letting the LDMA clear the overflow request as it
+  // does not read TOPB
   TIMER_Init_TypeDef timerInit = TIMER_INIT_DEFAULT;
+  timerInit.dmaClrAct = true;
   TIMER_Init(WTIMER0, &timerInit);
 }
 
-/**************************************************************************//**
-* @brief
-*    Initialize the LDMA module
-*
-* @details
-*    Configure the channel descriptor to use the default peripheral to
-*    memory transfer descriptor. Modify it to not generate an interrupt
-*    upon transfer completion (we don't need it). Additionally, the transfer
-*    configuration selects the WTIMER0_CC0 signal as the trigger for the LDMA
-*    transaction to occur.
-*
-* @note
-*    The descriptor object needs to at least have static scope persistence so
-*    that the reference to the object is valid beyond its first use in
-*    initialization
-*****************************************************************************/
-void initLdma(void)
-{
-  // Channel descriptor configuration
-  static LDMA_Descriptor_t descriptor =
-    LDMA_DESCRIPTOR_SINGLE_P2M_BYTE(&WTIMER0->CC[0].CCV, // Peripheral source address
-                                    &buffer,            // Memory destination address
-                                    BUFFER_SIZE);       // Number of bytes per transfer
-  descriptor.xfer.size     = ldmaCtrlSizeWord; // Unit transfer size
-  descriptor.xfer.doneIfs  = 0;                // Don't trigger interrupt when done
-
-  // Transfer configuration and trigger selection
-  LDMA_TransferCfg_t transferConfig =
-    LDMA_TRANSFER_CFG_PERIPHERAL(ldmaPeripheralSignal_WTIMER0_CC0);
-
-  // LDMA initialization
-  LDMA_Init_t init = LDMA_INIT_DEFAULT;
-  LDMA_Init(&init);
-
-  // Start the transfer
-  uint32_t channelNum = 0;
-  LDMA_StartTransfer(channelNum, &transferConfig, &descriptor);
-}
-
 /**************************************************************************//**
  * @brief
  *    Main function
@@ -143,13 +119,33 @@ int main(void)
   EMU_DCDCInit_TypeDef dcdcInit = EMU_DCDCINIT_DEFAULT;
   EMU_DCDCInit(&dcdcInit);
 
+  CORE_DECLARE_IRQ_STATE;
+  uint32_t count;
+
   // Initializations
   initGpio();
-  initLdma();
   initWtimer();
 
+  if (!EDGES_Init(captureRing, RING_SIZE)) {
+    __BKPT(0);
+  }
+
   while (1) {
-    EMU_EnterEM1(); // Enter EM1 mode (won't exit)
+    // Sleep in EM1 until the LDMA has filled half the ring or the timer has
+    // overflowed; edges arriving in between are stored without waking up
+    CORE_ENTER_CRITICAL();
+    if (EDGES_Available() == 0) {
+      EMU_EnterEM1();
+    }
+    CORE_EXIT_CRITICAL();
+
+    // Take everything stored since the last wake-up
+    while ((count = EDGES_ReadDeltas(deltas, DELTA_SIZE)) > 0) {
+      deltaCount = count;
+      edgeCount += count;
+    }
+    overrunCount = EDGES_GetOverrunCount();
+    overflowCount = EDGES_GetOverflowCount();
   }
 }
 
@@ -0,0 +1,86 @@
+/***************************************************************************//**
+ * @file hybridcap.h
+ *
+ * @brief Long interval capture with the WTIMER while awake and the RTCC in EM2.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2020 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ******************************************************************************/
+
+#ifndef HYBRIDCAP_H
+#define HYBRIDCAP_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// PRS channel carrying the RTCC channel 1 tick marks to WTIMER0 CC1
+#define HCAP_MARK_PRS_CHANNEL   1
+
+// The RTCC runs from the 32768 Hz LFXO, 2 ^ 15 ticks per second
+#define HCAP_CLOCK_SHIFT        15
+
+// Ticks from reading the RTCC counter to the tick that is marked, enough
+// for the compare value to be written before the counter gets there
+#define HCAP_MARK_DELAY         3
+
+// The capture window opens this long before the next edge is due and
+// closes as long after it: 1 / 64 of the last interval, from 2 ms (64
+// ticks) to 1 s. A larger fraction copes with more jitter of the input,
+// at the cost of more time in EM1.
+#ifndef HCAP_GUARD_SHIFT
+#define HCAP_GUARD_SHIFT        6
+#endif
+#define HCAP_GUARD_MIN_TICKS    64
+#define HCAP_GUARD_MAX_TICKS    32768
+
+// Shortest sleep worth going to EM2 for; a window due sooner opens at once
+#define HCAP_MIN_SLEEP_TICKS    16
+
+typedef struct {
+  uint64_t intervalNs;      // Time from the previous edge in nanoseconds
+  bool     precise;         // Both edges caught by the WTIMER, else the
+                            // interval only has the 30.5 us RTCC resolution
+} HCAP_Result_t;
+
+typedef struct {
+  uint32_t precise;         // Edges timed by the WTIMER
+  uint32_t coarse;          // Edges only timed by the RTCC
+  uint32_t timeouts;        // Windows that closed without an edge
+} HCAP_Counters_t;
+
+void HCAP_Init(uint32_t inputPrsChannel);
+bool HCAP_GetResult(HCAP_Result_t *result);
+bool HCAP_Awake(void);
+void HCAP_GetCounters(HCAP_Counters_t *result);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // HYBRIDCAP_H
@@ -0,0 +1,452 @@
+/***************************************************************************//**
+ * @file hybridcap.c
+ *
+ * @brief Long interval capture with the WTIMER while awake and the RTCC in EM2.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2020 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ *******************************************************************************
+ * # Evaluation Quality
+ * This code has been minimally tested to ensure that it builds and is suitable 
+ * as a demonstration for evaluation purposes only. This code will be maintained
+ * at the sole discretion of Silicon Labs.
+ ******************************************************************************/
+
+#include "em_cmu.h"
+#include "em_core.h"
+#include "em_device.h"
+#include "em_prs.h"
+#include "em_rtcc.h"
+#include "em_timer.h"
+
+#include "hybridcap.h"
+
+// RTCC channels: input capture, tick marks and window open and close
+#define CC_EDGE             0
+#define CC_MARK             1
+#define CC_WINDOW           2
+
+// 10 ^ 9 ns per second is 1953125 * 2 ^ 9, so a tick is 1953125 / 2 ^ 6 ns
+#define NS_PER_TICK         1953125
+#define NS_PER_TICK_SHIFT   (HCAP_CLOCK_SHIFT - 9)
+
+typedef enum {
+  stateSleep,               // Only the RTCC captures the input, EM2 is fine
+  stateOpen,                // Window open, waiting for the first tick mark
+  stateArmed,               // First mark taken, the WTIMER waits for the edge
+  stateClosing,             // Edge taken, waiting for the second tick mark
+} State_t;
+
+// Time of an edge: a tick of the RTCC and how long before it the edge came
+typedef struct {
+  uint32_t tick;
+  uint32_t beforeNs;
+  bool     precise;
+} Stamp_t;
+
+static volatile State_t state;
+
+// RTCC tick the mark compare is set to, and the first mark of the window
+// with the WTIMER count captured at it
+static uint32_t markTick;
+static uint32_t openTick;
+static uint32_t openCount;
+
+// WTIMER count captured at the edge
+static uint32_t edgeCount;
+
+// Last edge, the interval before it in ticks, 0 until there is one, and
+// the margin of the window around the next edge
+static Stamp_t last;
+static bool haveLast;
+static uint32_t intervalTicks;
+static uint32_t guardTicks;
+
+static HCAP_Result_t latest;
+static volatile bool haveResult;
+static HCAP_Counters_t counters;
+
+/**************************************************************************//**
+ * @brief
+ *   RTCC ticks to nanoseconds
+ *****************************************************************************/
+static uint64_t ticksToNs(uint32_t ticks)
+{
+  return ((uint64_t)ticks * NS_PER_TICK) >> NS_PER_TICK_SHIFT;
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Mark a tick a few ticks from now
+ *
+ * @details
+ *   The compare match of CC_MARK sends a pulse through
+ *   HCAP_MARK_PRS_CHANNEL, and WTIMER0 CC1 captures its count at the
+ *   start of that tick.
+ *****************************************************************************/
+static void setMark(void)
+{
+  markTick = RTCC_CounterGet() + HCAP_MARK_DELAY;
+  RTCC_ChannelCCVSet(CC_MARK, markTick);
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Open the capture window
+ *
+ * @details
+ *   The WTIMER keeps its captures while it stands still in EM2, and holds
+ *   two per channel, so those left from before are dropped first. The
+ *   window closes guardTicks after the edge is due.
+ *****************************************************************************/
+static void openWindow(void)
+{
+  while (WTIMER0->STATUS & TIMER_STATUS_ICV0) {
+    (void)TIMER_CaptureGet(WTIMER0, 0);
+  }
+  while (WTIMER0->STATUS & TIMER_STATUS_ICV1) {
+    (void)TIMER_CaptureGet(WTIMER0, 1);
+  }
+
+  state = stateOpen;
+  setMark();
+
+  RTCC_ChannelCCVSet(CC_WINDOW, last.tick + intervalTicks + guardTicks);
+  RTCC_IntClear(RTCC_IF_CC2);
+  RTCC_IntEnable(RTCC_IEN_CC2);
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Plan the window for the next edge
+ *
+ * @details
+ *   The next edge is expected one interval after the last one. Until there
+ *   is an interval, or once a window has closed without an edge, the device
+ *   sleeps until the edge and the RTCC times it on its own.
+ *****************************************************************************/
+static void schedule(void)
+{
+  uint32_t wake;
+
+  state = stateSleep;
+  RTCC_IntDisable(RTCC_IEN_CC2);
+
+  if (intervalTicks == 0) {
+    return;
+  }
+
+  guardTicks = intervalTicks >> HCAP_GUARD_SHIFT;
+  if (guardTicks < HCAP_GUARD_MIN_TICKS) {
+    guardTicks = HCAP_GUARD_MIN_TICKS;
+  } else if (guardTicks > HCAP_GUARD_MAX_TICKS) {
+    guardTicks = HCAP_GUARD_MAX_TICKS;
+  }
+
+  wake = last.tick + intervalTicks - guardTicks;
+  if ((int32_t)(wake - RTCC_CounterGet()) < HCAP_MIN_SLEEP_TICKS) {
+    openWindow();
+  } else {
+    RTCC_ChannelCCVSet(CC_WINDOW, wake);
+    RTCC_IntClear(RTCC_IF_CC2);
+    RTCC_IntEnable(RTCC_IEN_CC2);
+  }
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Take the time of an edge and the interval since the one before
+ *
+ * @details
+ *   Both times count from a tick of the RTCC, so the whole ticks between
+ *   them come from the 32768 Hz crystal and only the parts before each
+ *   tick from the WTIMER.
+ *****************************************************************************/
+static void addStamp(const Stamp_t *stamp)
+{
+  if (haveLast) {
+    intervalTicks = stamp->tick - last.tick;
+    latest.intervalNs = ticksToNs(intervalTicks) + last.beforeNs
+                        - stamp->beforeNs;
+    latest.precise = last.precise && stamp->precise;
+    haveResult = true;
+  }
+
+  last = *stamp;
+  haveLast = true;
+
+  schedule();
+}
+
+/**************************************************************************//**
+ * @brief
+ *   The RTCC has captured an input edge
+ *
+ * @details
+ *   With the window armed, WTIMER0 CC0 has captured the same edge to a
+ *   WTIMER clock, and one more mark after it is needed to place it. Else
+ *   the device was in EM2, or the edge came before the first mark, and
+ *   the RTCC capture is the time, to the tick.
+ *****************************************************************************/
+static void edgeCaptured(void)
+{
+  Stamp_t stamp;
+  uint32_t tick = RTCC_ChannelCCVGet(CC_EDGE);
+
+  if (state == stateClosing) {
+    return;
+  }
+
+  if ((state == stateArmed) && (WTIMER0->STATUS & TIMER_STATUS_ICV0)) {
+    edgeCount = TIMER_CaptureGet(WTIMER0, 0);
+    state = stateClosing;
+    setMark();
+    return;
+  }
+
+  stamp.tick = tick;
+  stamp.beforeNs = 0;
+  stamp.precise = false;
+  counters.coarse++;
+  addStamp(&stamp);
+}
+
+/**************************************************************************//**
+ * @brief
+ *   The RTCC has reached a marked tick
+ *
+ * @details
+ *   The second mark gives the WTIMER clocks per tick over the window, so
+ *   the WTIMER count from the edge to that mark converts to time with the
+ *   accuracy of the crystal, whatever the HFRCO frequency.
+ *****************************************************************************/
+static void markReached(void)
+{
+  Stamp_t stamp;
+  uint32_t count;
+  uint64_t clocks;
+
+  if (state == stateSleep) {
+    return;
+  }
+
+  if (!(WTIMER0->STATUS & TIMER_STATUS_ICV1)) {
+    // The WTIMER was stopped, so this window is lost
+    if (state == stateClosing) {
+      stamp.tick = RTCC_ChannelCCVGet(CC_EDGE);
+      stamp.beforeNs = 0;
+      stamp.precise = false;
+      counters.coarse++;
+      addStamp(&stamp);
+    } else {
+      schedule();
+    }
+    return;
+  }
+
+  count = TIMER_CaptureGet(WTIMER0, 1);
+
+  if (state == stateOpen) {
+    openTick = markTick;
+    openCount = count;
+    state = stateArmed;
+  } else if (state == stateClosing) {
+    clocks = (uint64_t)(count - openCount) << NS_PER_TICK_SHIFT;
+    stamp.tick = markTick;
+    stamp.beforeNs = (uint32_t)((uint64_t)(count - edgeCount)
+                                * (markTick - openTick) * NS_PER_TICK
+                                / clocks);
+    stamp.precise = true;
+    counters.precise++;
+    addStamp(&stamp);
+  }
+}
+
+/**************************************************************************//**
+ * @brief
+ *   The window opens, or it closes without an edge
+ *****************************************************************************/
+static void windowTimer(void)
+{
+  if (state == stateSleep) {
+    openWindow();
+  } else if (state != stateClosing) {
+    counters.timeouts++;
+    state = stateSleep;
+    RTCC_IntDisable(RTCC_IEN_CC2);
+  }
+}
+
+/**************************************************************************//**
+ * @brief  RTCC Handler
+ *****************************************************************************/
+void RTCC_IRQHandler(void)
+{
+  uint32_t flags = RTCC_IntGetEnabled();
+
+  RTCC_IntClear(flags);
+
+  if (flags & RTCC_IF_CC1) {
+    markReached();
+  }
+  if (flags & RTCC_IF_CC0) {
+    edgeCaptured();
+  }
+  if (flags & RTCC_IF_CC2) {
+    windowTimer();
+  }
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Start timing the falling edges of a PRS signal
+ *
+ * @details
+ *   RTCC channel 0 captures every edge to a 30.5 us tick, in EM2 as well.
+ *   Once two edges have given an interval, the device sleeps until shortly
+ *   before the next one is due and then stays in EM1, where WTIMER0 CC0
+ *   captures it to a clock of the HFPERCLK. RTCC channel 1 marks a tick
+ *   for WTIMER0 CC1 when the window opens and once more after the edge,
+ *   which ties the WTIMER count to the RTCC. Channel 2 opens and closes
+ *   the window.
+ *
+ *   The interval between two edges is the RTCC ticks between them, with
+ *   the WTIMER only filling in the part of a tick, so it can be as long as
+ *   the 32 bit RTCC counter, 36 hours, at the resolution of the WTIMER.
+ *   An edge outside the window still gets its RTCC time and the interval
+ *   is flagged as not precise.
+ *
+ *   The LFE clock has to run from the LFXO, see HCAP_CLOCK_SHIFT. Edges
+ *   should be at least a few ms apart.
+ *
+ * @param[in] inputPrsChannel
+ *   PRS channel with the signal to time, already set up by the caller. It
+ *   must be asynchronous for the RTCC to see it in EM2.
+ *****************************************************************************/
+void HCAP_Init(uint32_t inputPrsChannel)
+{
+  RTCC_Init_TypeDef rtccInit = RTCC_INIT_DEFAULT;
+  RTCC_CCChConf_TypeDef edgeConf = RTCC_CH_INIT_CAPTURE_DEFAULT;
+  RTCC_CCChConf_TypeDef compareConf = RTCC_CH_INIT_COMPARE_DEFAULT;
+  TIMER_Init_TypeDef timerInit = TIMER_INIT_DEFAULT;
+  TIMER_InitCC_TypeDef timerCCInit = TIMER_INITCC_DEFAULT;
+
+  state = stateSleep;
+  haveLast = false;
+  intervalTicks = 0;
+  haveResult = false;
+  counters.precise = 0;
+  counters.coarse = 0;
+  counters.timeouts = 0;
+
+  CMU_ClockEnable(cmuClock_RTCC, true);
+  rtccInit.enable = false;
+  RTCC_Init(&rtccInit);
+
+  edgeConf.prsSel = (RTCC_PRSSel_TypeDef)inputPrsChannel;
+  edgeConf.inputEdgeSel = rtccInEdgeFalling;
+  RTCC_ChannelInit(CC_EDGE, &edgeConf);
+
+  // A compare match of the mark channel pulses its PRS signal
+  RTCC_ChannelInit(CC_MARK, &compareConf);
+  RTCC_ChannelInit(CC_WINDOW, &compareConf);
+
+  CMU_ClockEnable(cmuClock_PRS, true);
+  PRS_SourceAsyncSignalSet(HCAP_MARK_PRS_CHANNEL,
+                           PRS_CH_CTRL_SOURCESEL_RTCC,
+                           PRS_CH_CTRL_SIGSEL_RTCCCCV1);
+
+  // WTIMER0 runs free over 32 bits, 226 s at 19 MHz; only the flags of
+  // its captures are used, so it needs no interrupt
+  CMU_ClockEnable(cmuClock_WTIMER0, true);
+  timerCCInit.mode = timerCCModeCapture;
+  timerCCInit.prsInput = true;
+  timerCCInit.edge = timerEdgeFalling;
+  timerCCInit.prsSel = (TIMER_PRSSEL_TypeDef)inputPrsChannel;
+  TIMER_InitCC(WTIMER0, 0, &timerCCInit);
+
+  timerCCInit.edge = timerEdgeRising;
+  timerCCInit.prsSel = (TIMER_PRSSEL_TypeDef)HCAP_MARK_PRS_CHANNEL;
+  TIMER_InitCC(WTIMER0, 1, &timerCCInit);
+
+  TIMER_Init(WTIMER0, &timerInit);
+
+  RTCC_IntClear(_RTCC_IF_MASK);
+  RTCC_IntEnable(RTCC_IEN_CC0 | RTCC_IEN_CC1);
+  NVIC_ClearPendingIRQ(RTCC_IRQn);
+  NVIC_EnableIRQ(RTCC_IRQn);
+
+  RTCC_Enable(true);
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Copy the last interval
+ *
+ * @return
+ *   true if there is an interval that has not been read yet.
+ *****************************************************************************/
+bool HCAP_GetResult(HCAP_Result_t *result)
+{
+  bool fresh;
+
+  CORE_DECLARE_IRQ_STATE;
+  CORE_ENTER_CRITICAL();
+  *result = latest;
+  fresh = haveResult;
+  haveResult = false;
+  CORE_EXIT_CRITICAL();
+
+  return fresh;
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Whether the HF clock must keep running
+ *
+ * @details
+ *   While a window is open the WTIMER has to count, so the device may only
+ *   enter EM1. Call it with interrupts masked right before going to sleep,
+ *   so a window that opens in between is not slept through.
+ *
+ * @return
+ *   true for EM1, false if EM2 is fine.
+ *****************************************************************************/
+bool HCAP_Awake(void)
+{
+  return state != stateSleep;
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Copy the counters
+ *****************************************************************************/
+void HCAP_GetCounters(HCAP_Counters_t *result)
+{
+  CORE_DECLARE_IRQ_STATE;
+  CORE_ENTER_CRITICAL();
+  *result = counters;
+  CORE_EXIT_CRITICAL();
+}
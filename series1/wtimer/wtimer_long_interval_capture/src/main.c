@@ -0,0 +1,157 @@
+/***************************************************************************//**
+ * @file main.c
+ * @brief This project demonstrates the measurement of long intervals between
+ * input edges with the WTIMER resolution while the device sleeps in EM2. The
+ * RTCC captures every edge of button 0 through the PRS, in EM2 as well, and
+ * the device only wakes into EM1 around the time the next edge is due, for
+ * WTIMER0 to capture it. Tick marks of the RTCC captured by the WTIMER tie
+ * the two time stamps together.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2020 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ *******************************************************************************
+ * # Evaluation Quality
+ * This code has been minimally tested to ensure that it builds and is suitable 
+ * as a demonstration for evaluation purposes only. This code will be maintained
+ * at the sole discretion of Silicon Labs.
+ ******************************************************************************/
+
+#include "em_device.h"
+#include "em_cmu.h"
+#include "em_core.h"
+#include "em_emu.h"
+#include "em_chip.h"
+#include "em_gpio.h"
+#include "em_prs.h"
+#include "bsp.h"
+
+#include "hybridcap.h"
+
+// PRS channel carrying button 0 to the RTCC and WTIMER0
+#define INPUT_PRS_CHANNEL 0
+
+// Last interval between two presses in nanoseconds, and whether both
+// presses were captured by the WTIMER
+// Note: needs to be volatile or else the compiler will optimize it out
+static volatile uint64_t intervalNs;
+static volatile bool intervalPrecise;
+
+// Edges timed by the WTIMER and by the RTCC alone, and missed windows
+static volatile HCAP_Counters_t counters;
+
+/**************************************************************************//**
+ * @brief
+ *    GPIO initialization
+ *
+ * @note
+ *    We need to configure an external interrupt using GPIO_ExtIntConfig()
+ *    since the GPIO_EXTIPSEL[3:0] bits tell the PRS which port to listen to.
+ *    The GPIO interrupt itself is not enabled, the RTCC interrupt wakes the
+ *    device.
+ *****************************************************************************/
+void initGpio(void)
+{
+  // Enable GPIO clock
+  CMU_ClockEnable(cmuClock_GPIO, true);
+
+  // Configure button 0 as input
+  GPIO_PinModeSet(BSP_GPIO_PB0_PORT, BSP_GPIO_PB0_PIN, gpioModeInputPullFilter, 1);
+
+  // Select button 0 as the interrupt source (configure as disabled since using PRS)
+  GPIO_ExtIntConfig(BSP_GPIO_PB0_PORT, BSP_GPIO_PB0_PIN, BSP_GPIO_PB0_PIN, false, false, false);
+
+  // LED0 toggles on every interval
+  GPIO_PinModeSet(BSP_GPIO_LED0_PORT, BSP_GPIO_LED0_PIN, gpioModePushPull, 0);
+}
+
+/**************************************************************************//**
+ * @brief
+ *    PRS initialization
+ *
+ * @details
+ *    The channel is asynchronous, so it carries the GPIO level in EM2
+ *    without the HF clock, to the RTCC capture. WTIMER0 synchronizes it
+ *    itself when it runs.
+ *****************************************************************************/
+void initPrs(void)
+{
+  // Enable PRS clock
+  CMU_ClockEnable(cmuClock_PRS, true);
+
+  // Select GPIO as source and button 0 GPIO pin as signal for PRS channel 0
+  // Note that the PRS Channel Source Select splits LOWER (0-7) and HIGHER (8-15) GPIO pins
+  if (BSP_GPIO_PB0_PIN < 8) {
+    PRS_SourceAsyncSignalSet(INPUT_PRS_CHANNEL, PRS_CH_CTRL_SOURCESEL_GPIOL, BSP_GPIO_PB0_PIN);
+  } else {
+    PRS_SourceAsyncSignalSet(INPUT_PRS_CHANNEL, PRS_CH_CTRL_SOURCESEL_GPIOH, (uint32_t)(BSP_GPIO_PB0_PIN - 8));
+  }
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Main function
+ *****************************************************************************/
+int main(void)
+{
+  HCAP_Result_t result;
+  HCAP_Counters_t count;
+
+  // Chip errata
+  CHIP_Init();
+
+  // Init DCDC regulator with kit specific parameters
+  EMU_DCDCInit_TypeDef dcdcInit = EMU_DCDCINIT_DEFAULT;
+  EMU_DCDCInit(&dcdcInit);
+
+  // The RTCC counts the LFXO, the time base of the long intervals
+  CMU_ClockEnable(cmuClock_HFLE, true);
+  CMU_ClockSelectSet(cmuClock_LFE, cmuSelect_LFXO);
+
+  // Initializations
+  initGpio();
+  initPrs();
+  HCAP_Init(INPUT_PRS_CHANNEL);
+
+  while (1) {
+    // Sleep in EM2 unless a capture window is open
+    CORE_DECLARE_IRQ_STATE;
+    CORE_ENTER_CRITICAL();
+    if (HCAP_Awake()) {
+      EMU_EnterEM1();
+    } else {
+      EMU_EnterEM2(true);
+    }
+    CORE_EXIT_CRITICAL();
+
+    if (HCAP_GetResult(&result)) {
+      intervalNs = result.intervalNs;
+      intervalPrecise = result.precise;
+      HCAP_GetCounters(&count);
+      counters = count;
+
+      GPIO_PinOutToggle(BSP_GPIO_LED0_PORT, BSP_GPIO_LED0_PIN);
+    }
+  }
+}
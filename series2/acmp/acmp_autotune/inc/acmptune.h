@@ -0,0 +1,87 @@
+/***************************************************************************//**
+ * @file acmptune.h
+ * @brief ACMP hysteresis and threshold auto-tuner: the crossings are counted
+ * by the PCNT through PRS, and only the edges of windows at the target rate
+ * reach the CPU.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2021 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ******************************************************************************/
+
+#ifndef ACMPTUNE_H
+#define ACMPTUNE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "em_acmp.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// PRS channel from the ACMP0 output to the PCNT0 S0 input
+#define ACMPTUNE_PRS_CHANNEL      0
+
+// Hysteresis steps, from none to the widest symmetric level
+#define ACMPTUNE_HYST_STEPS       4
+
+// VREFDIV of the 1.25 V reference, the threshold is 1.25 V * VREFDIV / 63
+#define ACMPTUNE_VREFDIV_MAX      63
+
+// Windows below the target rate before a step back is taken
+#ifndef ACMPTUNE_RELAX_WINDOWS
+#define ACMPTUNE_RELAX_WINDOWS    8
+#endif
+
+// Called from the ACMP interrupt for each qualified edge
+typedef void (*ACMPTUNE_Callback_t)(bool rising);
+
+typedef struct {
+  ACMP_Channel_TypeDef input;       // Positive input, compared to the threshold
+  uint32_t vrefDiv;                 // Nominal threshold, 0 to 63
+  uint32_t thresholdStep;           // VREFDIV step past the widest hysteresis,
+                                    // 0 to adjust the hysteresis only
+  uint32_t windowMs;                // Counting window, 1 to 2000 ms
+  uint32_t targetLow;               // Target crossings per window, as rising
+  uint32_t targetHigh;              // edges of the output
+  ACMPTUNE_Callback_t callback;     // Qualified edges, may be NULL
+} ACMPTUNE_Init_t;
+
+bool ACMPTUNE_Start(const ACMPTUNE_Init_t *init);
+void ACMPTUNE_Stop(void);
+bool ACMPTUNE_IsQualified(void);
+uint32_t ACMPTUNE_GetLevel(void);
+uint32_t ACMPTUNE_GetMaxLevel(void);
+ACMP_HysteresisLevel_TypeDef ACMPTUNE_GetHysteresis(void);
+uint32_t ACMPTUNE_GetVrefDiv(void);
+uint32_t ACMPTUNE_GetLastCount(void);
+uint32_t ACMPTUNE_GetStormWindows(void);
+uint32_t ACMPTUNE_GetQualifiedCount(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // ACMPTUNE_H
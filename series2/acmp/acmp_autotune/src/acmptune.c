@@ -0,0 +1,384 @@
+/***************************************************************************//**
+ * @file acmptune.c
+ * @brief ACMP hysteresis and threshold auto-tuner: the crossings are counted
+ * by the PCNT through PRS, and only the edges of windows at the target rate
+ * reach the CPU.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2021 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ *******************************************************************************
+ * # Evaluation Quality
+ * This code has been minimally tested to ensure that it builds and is suitable 
+ * as a demonstration for evaluation purposes only. This code will be maintained
+ * at the sole discretion of Silicon Labs.
+ ******************************************************************************/
+
+#include <stddef.h>
+#include "em_device.h"
+#include "em_acmp.h"
+#include "em_burtc.h"
+#include "em_cmu.h"
+#include "em_pcnt.h"
+#include "em_prs.h"
+
+#include "acmptune.h"
+
+// The BURTC runs from the 32.768 kHz LFRCO, as the PCNT does
+#define WINDOW_CLOCK_HZ     32768
+
+// Width of the PCNT counter
+#define PCNT_MASK           0xFFFF
+
+/*
+ * Tuning levels, from the most to the least sensitive: first the
+ * hysteresis widens, then the threshold goes up from its nominal value in
+ * steps, with the widest hysteresis kept.
+ */
+static const ACMP_HysteresisLevel_TypeDef hysteresis[ACMPTUNE_HYST_STEPS] = {
+  acmpHysteresisDisabled,
+  acmpHysteresis10Sym,
+  acmpHysteresis20Sym,
+  acmpHysteresis30Sym,
+};
+
+static ACMPTUNE_Init_t config;
+static uint32_t level;
+static uint32_t maxLevel;
+
+// PCNT count at the end of the last window and the crossings in it
+static uint32_t lastCnt;
+static uint32_t lastCount;
+
+// Windows below the target in a row, and over it in all
+static uint32_t quietWindows;
+static uint32_t stormWindows;
+
+static volatile bool qualified;
+static volatile uint32_t qualifiedCount;
+
+/**************************************************************************//**
+ * @brief
+ *   VREFDIV of a tuning level
+ *****************************************************************************/
+static uint32_t levelVrefDiv(uint32_t l)
+{
+  if (l < ACMPTUNE_HYST_STEPS) {
+    return config.vrefDiv;
+  }
+  return config.vrefDiv + ((l - (ACMPTUNE_HYST_STEPS - 1)) * config.thresholdStep);
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Hysteresis of a tuning level
+ *****************************************************************************/
+static ACMP_HysteresisLevel_TypeDef levelHysteresis(uint32_t l)
+{
+  if (l < ACMPTUNE_HYST_STEPS) {
+    return hysteresis[l];
+  }
+  return hysteresis[ACMPTUNE_HYST_STEPS - 1];
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Set up the ACMP for the current level and wait until it is ready
+ *
+ * @details
+ *   The hysteresis and the reference divider can only be written while the
+ *   ACMP is disabled, so it is initialized again. Its output is low while
+ *   it warms up, which the PCNT can count as one more crossing.
+ *****************************************************************************/
+static void applyLevel(void)
+{
+  ACMP_Init_TypeDef init = ACMP_INIT_DEFAULT;
+
+  init.hysteresisLevel = levelHysteresis(level);
+  init.vrefDiv = levelVrefDiv(level);
+  ACMP_Init(ACMP0, &init);
+  ACMP_ChannelSet(ACMP0, acmpInputVREFDIV1V25, config.input);
+
+  while (!(ACMP0->IF & ACMP_IF_ACMPRDY)) {
+  }
+  ACMP_IntClear(ACMP0, ACMP_IF_ACMPRDY | ACMP_IF_RISE | ACMP_IF_FALL);
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Let the edges reach the CPU or keep them away
+ *****************************************************************************/
+static void qualify(bool enable)
+{
+  if (enable == qualified) {
+    return;
+  }
+
+  qualified = enable;
+  if (enable) {
+    ACMP_IntClear(ACMP0, ACMP_IF_RISE | ACMP_IF_FALL);
+    NVIC_ClearPendingIRQ(ACMP0_IRQn);
+    ACMP_IntEnable(ACMP0, ACMP_IEN_RISE | ACMP_IEN_FALL);
+  } else {
+    ACMP_IntDisable(ACMP0, ACMP_IEN_RISE | ACMP_IEN_FALL);
+  }
+}
+
+/**************************************************************************//**
+ * @brief
+ *   End of a counting window: rate the window and tune
+ *
+ * @details
+ *   A window over the target is a storm: its edges are kept from the CPU
+ *   and the next level is taken at once. Only after
+ *   ACMPTUNE_RELAX_WINDOWS windows in a row below the target is the level
+ *   stepped back, so a short quiet spell does not bring the storm back.
+ *****************************************************************************/
+void BURTC_IRQHandler(void)
+{
+  uint32_t cnt, next;
+
+  BURTC_IntClear(BURTC_IF_COMP);
+
+  cnt = PCNT_CounterGet(PCNT0);
+  lastCount = (cnt - lastCnt) & PCNT_MASK;
+  lastCnt = cnt;
+
+  next = level;
+  if (lastCount > config.targetHigh) {
+    stormWindows++;
+    quietWindows = 0;
+    qualify(false);
+    if (level < maxLevel) {
+      next = level + 1;
+    }
+  } else {
+    qualify(true);
+    if (lastCount < config.targetLow) {
+      if (++quietWindows >= ACMPTUNE_RELAX_WINDOWS) {
+        quietWindows = 0;
+        if (level > 0) {
+          next = level - 1;
+        }
+      }
+    } else {
+      quietWindows = 0;
+    }
+  }
+
+  if (next != level) {
+    level = next;
+    applyLevel();
+
+    // The warm-up glitch is not a crossing of the new level
+    lastCnt = PCNT_CounterGet(PCNT0);
+  }
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Qualified edge of the ACMP output
+ *****************************************************************************/
+void ACMP0_IRQHandler(void)
+{
+  uint32_t flags = ACMP_IntGetEnabled(ACMP0);
+
+  ACMP_IntClear(ACMP0, flags);
+
+  if (flags & (ACMP_IF_RISE | ACMP_IF_FALL)) {
+    qualifiedCount++;
+    if (config.callback != NULL) {
+      // Report the state after the edge, both flags can be set at once
+      config.callback((ACMP0->STATUS & ACMP_STATUS_ACMPOUT) != 0);
+    }
+  }
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Start comparing and tuning
+ *
+ * @details
+ *   ACMP0 compares the input to the 1.25 V reference through its divider.
+ *   Its output goes through PRS channel ACMPTUNE_PRS_CHANNEL to PCNT0,
+ *   which counts the rising edges, and the BURTC ends each window. All
+ *   three run in EM2. The application allocates the analog bus to ACMP0
+ *   for the input pin beforehand.
+ *
+ *   The tuner starts at the most sensitive level with the edges kept from
+ *   the CPU, and qualifies them from the first window at most at the
+ *   target rate.
+ *
+ * @param[in] init
+ *   Configuration, copied.
+ *
+ * @return
+ *   false if the configuration is out of range.
+ *****************************************************************************/
+bool ACMPTUNE_Start(const ACMPTUNE_Init_t *init)
+{
+  BURTC_Init_TypeDef burtcInit = BURTC_INIT_DEFAULT;
+  PCNT_Init_TypeDef pcntInit = PCNT_INIT_DEFAULT;
+
+  if ((init->vrefDiv > ACMPTUNE_VREFDIV_MAX)
+      || (init->windowMs < 1) || (init->windowMs > 2000)
+      || (init->targetLow > init->targetHigh)
+      || (init->targetHigh >= PCNT_MASK)) {
+    return false;
+  }
+
+  config = *init;
+  level = 0;
+  maxLevel = ACMPTUNE_HYST_STEPS - 1;
+  if (config.thresholdStep) {
+    maxLevel += (ACMPTUNE_VREFDIV_MAX - config.vrefDiv) / config.thresholdStep;
+  }
+  lastCount = 0;
+  quietWindows = 0;
+  stormWindows = 0;
+  qualified = false;
+  qualifiedCount = 0;
+
+  CMU_ClockEnable(cmuClock_ACMP0, true);
+  CMU_ClockEnable(cmuClock_PRS, true);
+  CMU_ClockEnable(cmuClock_PCNT0, true);
+  CMU_ClockEnable(cmuClock_BURTC, true);
+  CMU_ClockSelectSet(cmuClock_EM23GRPACLK, cmuSelect_LFRCO);
+  CMU_ClockSelectSet(cmuClock_EM4GRPACLK, cmuSelect_LFRCO);
+
+  applyLevel();
+
+  PRS_SourceAsyncSignalSet(ACMPTUNE_PRS_CHANNEL,
+                           PRS_ASYNC_CH_CTRL_SOURCESEL_ACMP0,
+                           _PRS_ASYNC_CH_CTRL_SIGSEL_ACMP0OUT);
+
+  // Count the rising edges of the output, unfiltered, wrapping at 16 bits
+  pcntInit.mode = pcntModeOvsSingle;
+  pcntInit.top = PCNT_MASK;
+  pcntInit.s1CntDir = false;
+  pcntInit.s0PRS = ACMPTUNE_PRS_CHANNEL;
+  PCNT_PRSInputEnable(PCNT0, pcntPRSInputS0, true);
+  PCNT_Init(PCNT0, &pcntInit);
+  lastCnt = PCNT_CounterGet(PCNT0);
+
+  // Compare 0 restarts the count, one interrupt per window
+  BURTC_Reset();
+  burtcInit.compare0Top = true;
+  BURTC_Init(&burtcInit);
+  BURTC_CompareSet(0, ((config.windowMs * WINDOW_CLOCK_HZ) / 1000) - 1);
+
+  NVIC_ClearPendingIRQ(ACMP0_IRQn);
+  NVIC_EnableIRQ(ACMP0_IRQn);
+
+  BURTC_IntClear(BURTC_IF_COMP);
+  BURTC_IntEnable(BURTC_IEN_COMP);
+  NVIC_ClearPendingIRQ(BURTC_IRQn);
+  NVIC_EnableIRQ(BURTC_IRQn);
+
+  return true;
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Stop tuning and keep the edges from the CPU; the ACMP keeps running
+ *****************************************************************************/
+void ACMPTUNE_Stop(void)
+{
+  BURTC_IntDisable(BURTC_IEN_COMP);
+  NVIC_DisableIRQ(BURTC_IRQn);
+  qualify(false);
+  NVIC_DisableIRQ(ACMP0_IRQn);
+}
+
+/**************************************************************************//**
+ * @brief
+ *   True while the edges reach the CPU
+ *****************************************************************************/
+bool ACMPTUNE_IsQualified(void)
+{
+  return qualified;
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Current tuning level, 0 is the most sensitive
+ *****************************************************************************/
+uint32_t ACMPTUNE_GetLevel(void)
+{
+  return level;
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Least sensitive tuning level
+ *****************************************************************************/
+uint32_t ACMPTUNE_GetMaxLevel(void)
+{
+  return maxLevel;
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Hysteresis of the current level
+ *****************************************************************************/
+ACMP_HysteresisLevel_TypeDef ACMPTUNE_GetHysteresis(void)
+{
+  return levelHysteresis(level);
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Reference divider of the current level
+ *****************************************************************************/
+uint32_t ACMPTUNE_GetVrefDiv(void)
+{
+  return levelVrefDiv(level);
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Rising edges counted in the last window
+ *****************************************************************************/
+uint32_t ACMPTUNE_GetLastCount(void)
+{
+  return lastCount;
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Windows over the target rate since ACMPTUNE_Start()
+ *****************************************************************************/
+uint32_t ACMPTUNE_GetStormWindows(void)
+{
+  return stormWindows;
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Qualified edges handled since ACMPTUNE_Start()
+ *****************************************************************************/
+uint32_t ACMPTUNE_GetQualifiedCount(void)
+{
+  return qualifiedCount;
+}
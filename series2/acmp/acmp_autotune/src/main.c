@@ -0,0 +1,184 @@
+/***************************************************************************//**
+ * @file main.c
+ * @brief This project compares an analog input to a threshold with ACMP0 and
+ * tunes the hysteresis and threshold so that the output crosses at a target
+ * rate; only the edges of windows at that rate interrupt the CPU. See
+ * readme.txt for details.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2021 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ *******************************************************************************
+ * # Evaluation Quality
+ * This code has been minimally tested to ensure that it builds and is suitable 
+ * as a demonstration for evaluation purposes only. This code will be maintained
+ * at the sole discretion of Silicon Labs.
+ ******************************************************************************/
+
+#include "em_device.h"
+#include "em_chip.h"
+#include "em_cmu.h"
+#include "em_emu.h"
+#include "em_gpio.h"
+#include "em_acmp.h"
+#include "em_usart.h"
+#include "mx25flash_spi.h"
+#include "bsp.h"
+
+#include "acmptune.h"
+
+#define LED0_PORT           gpioPortB
+#define LED0_PIN            2
+#define ACMP_INPUT_PORT_PIN acmpInputPB1
+
+/*******************************************************************************
+ *******************************   DEFINES   ***********************************
+ ******************************************************************************/
+
+// Nominal threshold 1.25 V * 48 / 63 = 0.95 V, raised by 3 / 63 per level
+// once the hysteresis is at its widest
+#define NOMINAL_VREFDIV           48
+#define THRESHOLD_STEP            3
+
+// Target: 1 to 5 crossings per 100 ms window
+#define WINDOW_MS                 100
+#define TARGET_LOW                1
+#define TARGET_HIGH               5
+
+/* This example enters EM2; Setting this define to 1 enables debug
+ * connectivity in the EMU_CTRL register, which will consume about 0.5uA
+ * additional supply current */
+#define EM2DEBUG                  1
+
+/*******************************************************************************
+ ***************************   GLOBAL VARIABLES   *******************************
+ ******************************************************************************/
+
+// Tuner state, updated after each wakeup for the debugger
+volatile uint32_t level;
+volatile ACMP_HysteresisLevel_TypeDef hysteresis;
+volatile uint32_t vrefDiv;
+volatile uint32_t lastCount;
+volatile uint32_t stormWindows;
+volatile uint32_t qualifiedEdges;
+volatile bool qualified;
+
+/**************************************************************************//**
+ * @brief escapeHatch()
+ * When developing or debugging code that enters EM2 or
+ * lower, it's a good idea to have an "escape hatch" type
+ * mechanism, e.g. a way to pause the device so that a debugger can
+ * connect in order to erase flash, among other things.
+ *
+ * Before proceeding with this example, make sure PB0 is not pressed.
+ * If the PB0 pin is low, turn on LED0 and execute the breakpoint
+ * instruction to stop the processor in EM0 and allow a debug
+ * connection to be made.
+ *****************************************************************************/
+void escapeHatch(void)
+{
+  CMU_ClockEnable(cmuClock_GPIO, true);
+  GPIO_PinModeSet(BSP_GPIO_PB0_PORT, BSP_GPIO_PB0_PIN, gpioModeInputPullFilter, 1);
+  if (GPIO_PinInGet(BSP_GPIO_PB0_PORT, BSP_GPIO_PB0_PIN) == 0) {
+    GPIO_PinModeSet(BSP_GPIO_LED0_PORT, BSP_GPIO_LED0_PIN, gpioModePushPull, 1);
+    __BKPT(0);
+  }
+  // Pin not asserted, so disable input
+  else {
+    GPIO_PinModeSet(BSP_GPIO_PB0_PORT, BSP_GPIO_PB0_PIN, gpioModeDisabled, 0);
+    CMU_ClockEnable(cmuClock_GPIO, false);
+  }
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Qualified edge of the comparator output, LED0 follows it
+ *****************************************************************************/
+static void onEdge(bool rising)
+{
+  if (rising) {
+    GPIO_PinOutSet(LED0_PORT, LED0_PIN);
+  } else {
+    GPIO_PinOutClear(LED0_PORT, LED0_PIN);
+  }
+}
+
+/**************************************************************************//**
+ * @brief  Main function
+ *****************************************************************************/
+int main(void)
+{
+  FlashStatus status;
+  ACMPTUNE_Init_t tune;
+
+  // Use default settings for EM23
+  EMU_EM23Init_TypeDef em23Init = EMU_EM23INIT_DEFAULT;
+
+  // Chip errata
+  CHIP_Init();
+
+  // Recommended recovery procedure for code in development
+  escapeHatch();
+
+#if (EM2DEBUG == 1)
+  EMU->CTRL_SET = EMU_CTRL_EM2DBGEN;
+#endif
+
+  EMU_EM23Init(&em23Init);
+
+  // Init and power-down MX25 SPI flash
+  MX25_init();
+  MX25_RSTEN();
+  MX25_RST(&status);
+  MX25_DP();
+  MX25_deinit();
+
+  CMU_ClockEnable(cmuClock_GPIO, true);
+  GPIO_PinModeSet(LED0_PORT, LED0_PIN, gpioModePushPull, 0);
+
+  // Allocate BODD0 to ACMP0 to be able to use the input
+  GPIO->BBUSALLOC = GPIO_BBUSALLOC_BODD0_ACMP0;
+
+  tune.input = ACMP_INPUT_PORT_PIN;
+  tune.vrefDiv = NOMINAL_VREFDIV;
+  tune.thresholdStep = THRESHOLD_STEP;
+  tune.windowMs = WINDOW_MS;
+  tune.targetLow = TARGET_LOW;
+  tune.targetHigh = TARGET_HIGH;
+  tune.callback = onEdge;
+  ACMPTUNE_Start(&tune);
+
+  // Each window and each qualified edge wakes the device
+  while (1) {
+    EMU_EnterEM2(false);
+
+    level = ACMPTUNE_GetLevel();
+    hysteresis = ACMPTUNE_GetHysteresis();
+    vrefDiv = ACMPTUNE_GetVrefDiv();
+    lastCount = ACMPTUNE_GetLastCount();
+    stormWindows = ACMPTUNE_GetStormWindows();
+    qualifiedEdges = ACMPTUNE_GetQualifiedCount();
+    qualified = ACMPTUNE_IsQualified();
+  }
+}
@@ -0,0 +1,325 @@
+/***************************************************************************//**
+ * @file main.c
+ * @brief This project turns ACMP0 and an RC network into a first order
+ * sigma-delta converter: the comparator drives its own input back through a
+ * pin, and PCNT0 counts the ones of its output in EM2. See readme.txt for
+ * details.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2021 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ *******************************************************************************
+ * # Evaluation Quality
+ * This code has been minimally tested to ensure that it builds and is suitable 
+ * as a demonstration for evaluation purposes only. This code will be maintained
+ * at the sole discretion of Silicon Labs.
+ ******************************************************************************/
+
+#include "em_device.h"
+#include "em_chip.h"
+#include "em_cmu.h"
+#include "em_emu.h"
+#include "em_gpio.h"
+#include "em_acmp.h"
+#include "em_burtc.h"
+#include "em_letimer.h"
+#include "em_pcnt.h"
+#include "em_prs.h"
+#include "em_usart.h"
+#include "mx25flash_spi.h"
+#include "bsp.h"
+
+/*******************************************************************************
+ *******************************   DEFINES   ***********************************
+ ******************************************************************************/
+
+// Summing node of the RC network, ACMP0 positive input
+#define NODE_PORT               gpioPortA
+#define NODE_PIN                5
+#define NODE_ACMP_INPUT         acmpInputPA5
+
+// Feedback pin, the inverted comparator output
+#define FEEDBACK_PORT           gpioPortA
+#define FEEDBACK_PIN            6
+
+// Threshold AVDD * 32 / 63, about AVDD / 2
+#define NODE_VREFDIV            32
+
+// Supply of the feedback pin, full scale of the converter
+#define AVDD_MV                 3300
+
+// LFRCO clock of the LETIMER and the BURTC
+#define LF_CLOCK_HZ             32768
+
+// The output is sampled 8192 times a second, in windows of 4096 samples:
+// a 12 bit result every 0.5 s
+#define SAMPLE_RATE             8192
+#define WINDOW_SAMPLES          4096
+
+// PRS channels; on EFR32xG24 input B of the logic function of a channel is
+// the channel just below
+#define SAMPLE_PRS_CHANNEL      0
+#define ONES_PRS_CHANNEL        1
+
+#define PCNT_MASK               0xFFFF
+
+/* This example enters EM2; Setting this define to 1 enables debug
+ * connectivity in the EMU_CTRL register, which will consume about 0.5uA
+ * additional supply current */
+#define EM2DEBUG                1
+
+/*******************************************************************************
+ ***************************   GLOBAL VARIABLES   *******************************
+ ******************************************************************************/
+
+// Results, updated after each window for the debugger
+volatile uint32_t ones;
+volatile uint32_t inputMv;
+volatile uint32_t windows;
+
+// Count at the end of the last window
+static uint16_t lastCount;
+
+/**************************************************************************//**
+ * @brief escapeHatch()
+ * When developing or debugging code that enters EM2 or
+ * lower, it's a good idea to have an "escape hatch" type
+ * mechanism, e.g. a way to pause the device so that a debugger can
+ * connect in order to erase flash, among other things.
+ *
+ * Before proceeding with this example, make sure PB0 is not pressed.
+ * If the PB0 pin is low, turn on LED0 and execute the breakpoint
+ * instruction to stop the processor in EM0 and allow a debug
+ * connection to be made.
+ *****************************************************************************/
+void escapeHatch(void)
+{
+  CMU_ClockEnable(cmuClock_GPIO, true);
+  GPIO_PinModeSet(BSP_GPIO_PB0_PORT, BSP_GPIO_PB0_PIN, gpioModeInputPullFilter, 1);
+  if (GPIO_PinInGet(BSP_GPIO_PB0_PORT, BSP_GPIO_PB0_PIN) == 0) {
+    GPIO_PinModeSet(BSP_GPIO_LED0_PORT, BSP_GPIO_LED0_PIN, gpioModePushPull, 1);
+    __BKPT(0);
+  }
+  // Pin not asserted, so disable input
+  else {
+    GPIO_PinModeSet(BSP_GPIO_PB0_PORT, BSP_GPIO_PB0_PIN, gpioModeDisabled, 0);
+    CMU_ClockEnable(cmuClock_GPIO, false);
+  }
+}
+
+/**************************************************************************//**
+ * @brief
+ *    ACMP initialization
+ *
+ * @details
+ *    ACMP0 compares the summing node to about AVDD / 2 and drives the
+ *    feedback pin with its output inverted: while the node is above the
+ *    threshold the pin pulls it down, and up while it is below. The
+ *    hysteresis sets how far the node swings around the threshold, and so
+ *    how fast the loop toggles. The PRS gets the output as it is, high
+ *    while the pin pulls down.
+ *****************************************************************************/
+static void initACMP(void)
+{
+  ACMP_Init_TypeDef init = ACMP_INIT_DEFAULT;
+
+  CMU_ClockEnable(cmuClock_ACMP0, true);
+
+  init.hysteresisLevel = acmpHysteresis10Sym;
+  init.vrefDiv = NODE_VREFDIV;
+  ACMP_Init(ACMP0, &init);
+
+  // Allocate AODD0 to ACMP0 to be able to use the input
+  GPIO->ABUSALLOC = GPIO_ABUSALLOC_AODD0_ACMP0;
+  GPIO_PinModeSet(NODE_PORT, NODE_PIN, gpioModeDisabled, 0);
+  ACMP_ChannelSet(ACMP0, acmpInputVREFDIVAVDD, NODE_ACMP_INPUT);
+
+  GPIO_PinModeSet(FEEDBACK_PORT, FEEDBACK_PIN, gpioModePushPull, 0);
+  ACMP_GPIOSetup(ACMP0, FEEDBACK_PORT, FEEDBACK_PIN, true, true);
+
+  while (!(ACMP0->IF & ACMP_IF_ACMPRDY)) {
+  }
+}
+
+/**************************************************************************//**
+ * @brief
+ *    PRS, LETIMER and PCNT initialization
+ *
+ * @details
+ *    The LETIMER pulses for one LFRCO cycle at each sample. The pulse is
+ *    ANDed with the comparator output, so the pulses that get through are
+ *    the samples at which the output was high, the ones. PCNT0 uses them as
+ *    its external clock and counts them, free running at 16 bits. None of
+ *    this needs the CPU, and all of it runs in EM2.
+ *****************************************************************************/
+static void initSampling(void)
+{
+  PCNT_Init_TypeDef pcntInit = PCNT_INIT_DEFAULT;
+  LETIMER_Init_TypeDef letimerInit = LETIMER_INIT_DEFAULT;
+
+  CMU_ClockEnable(cmuClock_PRS, true);
+  CMU_ClockEnable(cmuClock_PCNT0, true);
+  CMU_ClockEnable(cmuClock_LETIMER0, true);
+  CMU_ClockSelectSet(cmuClock_EM23GRPACLK, cmuSelect_LFRCO);
+
+  pcntInit.mode = pcntModeDisable;
+  pcntInit.top = PCNT_MASK;
+  pcntInit.s1CntDir = false;
+  pcntInit.s0PRS = ONES_PRS_CHANNEL;
+  PCNT_PRSInputEnable(PCNT0, pcntPRSInputS0, true);
+  PCNT_Init(PCNT0, &pcntInit);
+  PCNT_Enable(PCNT0, pcntModeExtSingle);
+  CMU->PCNT0CLKCTRL = CMU_PCNT0CLKCTRL_CLKSEL_PCNTS0;
+
+  // A few clock pulses synchronize the externally clocked domain; there
+  // are no ones before the loop runs, so make them in software
+  while (PCNT0->SYNCBUSY) {
+    PRS_PulseTrigger(1 << ONES_PRS_CHANNEL);
+  }
+
+  PRS_SourceAsyncSignalSet(SAMPLE_PRS_CHANNEL,
+                           PRS_ASYNC_CH_CTRL_SOURCESEL_LETIMER0,
+                           PRS_ASYNC_CH_CTRL_SIGSEL_LETIMER0CH0);
+  PRS_SourceAsyncSignalSet(ONES_PRS_CHANNEL,
+                           PRS_ASYNC_CH_CTRL_SOURCESEL_ACMP0,
+                           _PRS_ASYNC_CH_CTRL_SIGSEL_ACMP0OUT);
+  PRS_Combine(ONES_PRS_CHANNEL, SAMPLE_PRS_CHANNEL, prsLogic_A_AND_B);
+
+  // Pulse on each underflow; the counter runs from top to 0, top + 1 ticks
+  letimerInit.comp0Top = true;
+  letimerInit.topValue = (LF_CLOCK_HZ / SAMPLE_RATE) - 1;
+  letimerInit.ufoa0 = letimerUFOAPulse;
+  letimerInit.repMode = letimerRepeatFree;
+  LETIMER_Init(LETIMER0, &letimerInit);
+}
+
+/**************************************************************************//**
+ * @brief
+ *    BURTC initialization, one interrupt per window
+ *
+ * @details
+ *    The BURTC runs from the LFRCO, as the LETIMER does, so each window
+ *    holds exactly WINDOW_SAMPLES samples.
+ *****************************************************************************/
+static void initWindow(void)
+{
+  BURTC_Init_TypeDef burtcInit = BURTC_INIT_DEFAULT;
+
+  CMU_ClockEnable(cmuClock_BURTC, true);
+  CMU_ClockSelectSet(cmuClock_EM4GRPACLK, cmuSelect_LFRCO);
+
+  BURTC_Reset();
+  burtcInit.compare0Top = true;
+  BURTC_Init(&burtcInit);
+  BURTC_CompareSet(0, ((LF_CLOCK_HZ / SAMPLE_RATE) * WINDOW_SAMPLES) - 1);
+
+  BURTC_IntClear(BURTC_IF_COMP);
+  BURTC_IntEnable(BURTC_IEN_COMP);
+  NVIC_ClearPendingIRQ(BURTC_IRQn);
+  NVIC_EnableIRQ(BURTC_IRQn);
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Read the count of ones
+ *
+ * @details
+ *    The counter is clocked by the ones, not by the bus, so it is read
+ *    until two reads agree.
+ *****************************************************************************/
+static uint16_t readCount(void)
+{
+  uint32_t count;
+
+  do {
+    count = PCNT_CounterGet(PCNT0);
+  } while (count != PCNT_CounterGet(PCNT0));
+
+  return (uint16_t)count;
+}
+
+/**************************************************************************//**
+ * @brief
+ *    BURTC interrupt handler, end of a window
+ *
+ * @details
+ *    The loop keeps the average current through the two resistors into the
+ *    node at zero, so with equal resistors and the threshold at AVDD / 2,
+ *    the share of ones is the input over AVDD.
+ *****************************************************************************/
+void BURTC_IRQHandler(void)
+{
+  uint16_t count;
+
+  BURTC_IntClear(BURTC_IF_COMP);
+
+  count = readCount();
+  ones = (uint16_t)(count - lastCount);
+  lastCount = count;
+
+  inputMv = (ones * AVDD_MV) / WINDOW_SAMPLES;
+  windows++;
+}
+
+/**************************************************************************//**
+ * @brief  Main function
+ *****************************************************************************/
+int main(void)
+{
+  FlashStatus status;
+
+  // Use default settings for EM23
+  EMU_EM23Init_TypeDef em23Init = EMU_EM23INIT_DEFAULT;
+
+  // Chip errata
+  CHIP_Init();
+
+  // Recommended recovery procedure for code in development
+  escapeHatch();
+
+#if (EM2DEBUG == 1)
+  EMU->CTRL_SET = EMU_CTRL_EM2DBGEN;
+#endif
+
+  EMU_EM23Init(&em23Init);
+
+  // Init and power-down MX25 SPI flash
+  MX25_init();
+  MX25_RSTEN();
+  MX25_RST(&status);
+  MX25_DP();
+  MX25_deinit();
+
+  CMU_ClockEnable(cmuClock_GPIO, true);
+
+  initACMP();
+  initSampling();
+  lastCount = readCount();
+  initWindow();
+
+  // Only the end of each window wakes the device
+  while (1) {
+    EMU_EnterEM2(false);
+  }
+}
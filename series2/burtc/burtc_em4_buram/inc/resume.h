@@ -0,0 +1,56 @@
+/***************************************************************************//**
+ * @file resume.h
+ * @brief Application state snapshot in BURAM for a fast resume after EM4.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2022 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ******************************************************************************/
+
+#ifndef RESUME_H
+#define RESUME_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// BURAM words used by the snapshot, the first one is free for the caller
+#define RESUME_FIRST_WORD     1
+#define RESUME_HEADER_WORDS   2
+
+// Largest state, the BURAM left after the header
+#define RESUME_MAX_BYTES      ((32 - RESUME_FIRST_WORD - RESUME_HEADER_WORDS) * 4)
+
+bool RESUME_Save(const void *state, uint32_t size, uint16_t version);
+bool RESUME_Restore(void *state, uint32_t size, uint16_t version);
+void RESUME_Invalidate(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // RESUME_H
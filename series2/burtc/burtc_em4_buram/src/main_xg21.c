@@ -45,10 +45,36 @@
 #include "bsp.h"
 #include "retargetserial.h"
 #include "stdio.h"
+#include "resume.h"
+#include "resetlog.h"
 
 // Number of 1 KHz ULFRCO clocks between BURTC interrupts
 #define BURTC_IRQ_PERIOD 	3000
 
+// BURAM word left free by the snapshot: BURTC periods since power on
+#define UPTIME_WORD 0
+
+// Reset causes summed in the reset log report
+#define RSTCAUSE_WDOG (EMU_RSTCAUSE_WDOG0 | EMU_RSTCAUSE_WDOG1)
+#define RSTCAUSE_BOD  (EMU_RSTCAUSE_AVDDBOD | EMU_RSTCAUSE_DVDDBOD \
+                       | EMU_RSTCAUSE_DVDDLEBOD | EMU_RSTCAUSE_DECBOD \
+                       | EMU_RSTCAUSE_IOVDD0BOD)
+
+// Reset log entries printed at boot, the newest ones
+#define LOG_PRINT_ENTRIES 8
+
+// Layout version of AppState_t, change it with the structure
+#define APP_STATE_VERSION 1
+
+// Application state, checkpointed to BURAM before EM4
+typedef struct {
+  uint32_t em4Wakeups;      // EM4 wakeups since the last cold start
+  uint32_t coldCycles;      // Core clock cycles to ready on the cold start
+  uint8_t ledOn;            // LED0 when EM4 was entered
+} AppState_t;
+
+static AppState_t appState;
+
 /**************************************************************************//**
  * @brief  BURTC Handler
  *****************************************************************************/
@@ -56,6 +82,7 @@ void BURTC_IRQHandler(void)
 {
   BURTC_IntClear(BURTC_IF_COMP); // compare match
   GPIO_PinOutToggle(BSP_GPIO_LED0_PORT, BSP_GPIO_LED0_PIN);
+  BURAM->RET[UPTIME_WORD].REG++;
 }
 
 /**************************************************************************//**
@@ -64,7 +91,8 @@ void BURTC_IRQHandler(void)
 void initGPIO(void)
 {
   GPIO_PinModeSet(BSP_GPIO_PB0_PORT, BSP_GPIO_PB0_PIN, gpioModeInput, 1);
-  GPIO_PinModeSet(BSP_GPIO_LED0_PORT, BSP_GPIO_LED0_PIN, gpioModePushPull, 1); // LED on
+  GPIO_PinModeSet(BSP_GPIO_LED0_PORT, BSP_GPIO_LED0_PIN, gpioModePushPull,
+                  appState.ledOn);
 }
 
 /**************************************************************************//**
@@ -89,50 +117,171 @@ void initBURTC(void)
 }
 
 /**************************************************************************//**
- * @brief	Check RSTCAUSE for EM4 wakeups (reset) and save wakeup count
- *          to BURAM
+ * @brief  Take over the BURTC after an EM4 wakeup
+ *
+ * @details
+ *   The BURTC keeps its configuration and goes on counting through EM4, so
+ *   it is not initialized again, which would restart the counter. Only its
+ *   clock and interrupt are set up.
  *****************************************************************************/
-void checkResetCause (void)
+void resumeBURTC(void)
 {
-  uint32_t cause = RMU_ResetCauseGet();
-  RMU_ResetCauseClear();
+  CMU_ClockSelectSet(cmuClock_EM4GRPACLK, cmuSelect_ULFRCO);
 
+  BURTC_IntClear(BURTC_IF_COMP);
+  BURTC_IntEnable(BURTC_IEN_COMP);
+  NVIC_EnableIRQ(BURTC_IRQn);
+}
+
+/**************************************************************************//**
+ * @brief	Print the reset cause, EM4 wakeup count and time to ready
+ *****************************************************************************/
+void reportWakeup(uint32_t cause, bool resumed, uint32_t cycles)
+{
   // Print reset cause
   if (cause & EMU_RSTCAUSE_PIN)
   {
     printf("-- RSTCAUSE = PIN \n");
-    BURAM->RET[0].REG = 0; // reset EM4 wakeup counter
   }
   else if (cause & EMU_RSTCAUSE_EM4)
   {
     printf("-- RSTCAUSE = EM4 wakeup \n");
-    BURAM->RET[0].REG += 1; // increment EM4 wakeup counter
+  }
+
+  if (resumed)
+  {
+    printf("-- Resumed from the BURAM snapshot \n");
+    printf("-- Ready in %lu cycles, %lu on the cold start \n",
+           cycles, appState.coldCycles);
+  }
+  else
+  {
+    printf("-- Cold start, ready in %lu cycles \n", cycles);
   }
 
   // Print # of EM4 wakeups
-  printf("-- Number of EM4 wakeups = %ld \n", BURAM->RET[0].REG);
+  printf("-- Number of EM4 wakeups = %lu \n", appState.em4Wakeups);
   printf("-- BURTC ISR will toggle LED every ~3 seconds \n");
 }
 
+/**************************************************************************//**
+ * @brief	Print one line of reset log statistics
+ *****************************************************************************/
+void reportStats(const char *name, uint32_t causeMask)
+{
+  RESETLOG_Stats_TypeDef stats;
+
+  RESETLOG_GetStats(causeMask, &stats);
+  printf("--   %-9s %3lu resets", name, stats.count);
+  if (stats.timed > 0)
+  {
+    printf(", ready in %lu cycles on average, %lu at most",
+           (uint32_t)(stats.bootTimeSum / stats.timed), stats.bootTimeMax);
+  }
+  printf(" \n");
+}
+
+/**************************************************************************//**
+ * @brief	Print the newest reset log entries and the cost of each kind
+ *
+ * @details
+ *   The log is in the USERDATA page and survives every reset, including
+ *   power on and brown-out resets. Timestamps are milliseconds since power
+ *   on, to the BURTC period; the boot time is in core clock cycles from
+ *   main() to ready.
+ *****************************************************************************/
+void reportResetLog(void)
+{
+  RESETLOG_Entry_TypeDef entry;
+  uint32_t count = RESETLOG_Count();
+  uint32_t i = (count > LOG_PRINT_ENTRIES) ? (count - LOG_PRINT_ENTRIES) : 0;
+
+  printf("-- Reset log, %lu entries \n", count);
+  for (; RESETLOG_Get(i, &entry); i++)
+  {
+    printf("--   boot %5lu  cause 0x%08lx  at %8lu ms", entry.boot,
+           entry.cause, entry.timestamp);
+    if (entry.bootTime != 0xFFFFFFFFUL)
+    {
+      printf("  ready in %lu cycles", entry.bootTime);
+    }
+    printf(" \n");
+  }
+
+  reportStats("watchdog", RSTCAUSE_WDOG);
+  reportStats("brown-out", RSTCAUSE_BOD);
+  reportStats("power on", EMU_RSTCAUSE_POR);
+  reportStats("all", 0xFFFFFFFFUL);
+}
+
 /**************************************************************************//**
  * @brief	Main function
  *****************************************************************************/
 int main(void)
 {
+  uint32_t cause;
+  uint32_t cycles;
+  bool resumed;
+
   CHIP_Init();
+
+  // Count the cycles to ready from here
+  CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+  DWT->CYCCNT = 0;
+  DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+  // Resume after an EM4 wakeup with a good snapshot, else start cold
+  cause = RMU_ResetCauseGet();
+  RMU_ResetCauseClear();
+
+  // Count the BURTC periods since power on in BURAM, which these keep
+  if (!(cause & (EMU_RSTCAUSE_EM4 | EMU_RSTCAUSE_PIN | EMU_RSTCAUSE_SYSREQ
+                 | RSTCAUSE_WDOG | EMU_RSTCAUSE_LOCKUP))) {
+    BURAM->RET[UPTIME_WORD].REG = 0;
+  } else if (cause & EMU_RSTCAUSE_EM4) {
+    // The BURTC compare that woke up from EM4 did not run its handler
+    BURAM->RET[UPTIME_WORD].REG++;
+  }
+
+  // Log the reset first, a boot that never gets ready is logged too
+  RESETLOG_Init();
+  RESETLOG_Record(cause, BURAM->RET[UPTIME_WORD].REG * BURTC_IRQ_PERIOD);
+
+  resumed = (cause & EMU_RSTCAUSE_EM4)
+            && RESUME_Restore(&appState, sizeof(appState), APP_STATE_VERSION);
+
   EMU_UnlatchPinRetention();
 
+  if (resumed) {
+    // What was kept through EM4 is not set up again
+    appState.em4Wakeups++;
+  } else {
+    appState.em4Wakeups = 0;
+    appState.ledOn = 1; // LED on
+  }
+
   // Init
   RETARGET_SerialInit();
   RETARGET_SerialCrLf(1);
-  printf("In EM0 \n");
   initGPIO();
-  initBURTC();
+  if (resumed) {
+    resumeBURTC();
+  } else {
+    initBURTC();
+  }
   EMU_EM4Init_TypeDef em4Init = EMU_EM4INIT_DEFAULT;
   EMU_EM4Init(&em4Init);
 
-  // Check RESETCAUSE, update and print EM4 wakeup count
-  checkResetCause();
+  cycles = DWT->CYCCNT;
+  if (!resumed) {
+    appState.coldCycles = cycles;
+  }
+
+  // Print RESETCAUSE, EM4 wakeup count and the time to ready
+  printf("In EM0 \n");
+  RESETLOG_SetBootTime(cycles);
+  reportWakeup(cause, resumed, cycles);
+  reportResetLog();
 
   // Wait for user to press PB0, reset BURTC counter
   printf("Press PB0 to enter EM4 \n");
@@ -141,6 +290,10 @@ int main(void)
   BURTC_CounterReset(); // reset BURTC counter to wait full ~3 sec before EM4 wakeup
   printf("-- BURTC counter reset \n");
 
+  // Checkpoint the state to BURAM, restored after the EM4 wakeup
+  appState.ledOn = GPIO_PinOutGet(BSP_GPIO_LED0_PORT, BSP_GPIO_LED0_PIN);
+  RESUME_Save(&appState, sizeof(appState), APP_STATE_VERSION);
+
   // Enter EM4
   printf("Entering EM4 and wake on BURTC compare in ~3 seconds \n\n");
   RETARGET_SerialFlush(); // delay for printf to finish
@@ -0,0 +1,196 @@
+/***************************************************************************//**
+ * @file resume.c
+ * @brief Application state snapshot in BURAM for a fast resume after EM4.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2022 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ *******************************************************************************
+ * # Evaluation Quality
+ * This code has been minimally tested to ensure that it builds and is suitable 
+ * as a demonstration for evaluation purposes only. This code will be maintained
+ * at the sole discretion of Silicon Labs.
+ ******************************************************************************/
+
+#include <string.h>
+
+#include "em_device.h"
+#include "em_cmu.h"
+
+#include "resume.h"
+
+/*
+ * Snapshot layout in BURAM, from RESUME_FIRST_WORD:
+ *
+ *   word 0   MAGIC in bits 31:16, the caller's state version in 15:0
+ *   word 1   state size in bytes in bits 31:24, checksum in 23:0
+ *   word 2.. state, padded with zeros to whole words
+ *
+ * BURAM is kept through EM4 and a pin reset, but not a power on reset,
+ * which leaves it random: the magic and the checksum tell a snapshot
+ * from whatever was there.
+ */
+#define MAGIC               0x5E5AUL
+#define STATE_WORDS(size)   (((size) + 3) / 4)
+
+#define RET                 (BURAM->RET + RESUME_FIRST_WORD)
+
+#if (RESUME_FIRST_WORD + RESUME_HEADER_WORDS) >= 32
+#error "RESUME_FIRST_WORD leaves no BURAM for the state"
+#endif
+
+/**************************************************************************//**
+ * @brief
+ *   Checksum over the size and the state words, 24 bits
+ *****************************************************************************/
+static uint32_t checksum(uint32_t size, const uint32_t *words, uint32_t count)
+{
+  uint32_t sum = 0x12345 + size;
+
+  while (count--) {
+    sum = (sum << 5) + (sum >> 19) + *words++;
+  }
+
+  return sum & 0x00FFFFFF;
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Make the BURAM registers accessible
+ *****************************************************************************/
+static void enableBuram(void)
+{
+#if defined(_CMU_CLKEN0_BURAM_MASK)
+  CMU_ClockEnable(cmuClock_BURAM, true);
+#endif
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Checkpoint the application state to BURAM before entering EM4
+ *
+ * @details
+ *   The header is written last, so a reset part way through leaves no
+ *   valid snapshot rather than a mixed one.
+ *
+ * @param[in] state
+ *   State to save, RESUME_MAX_BYTES at most.
+ *
+ * @param[in] size
+ *   Bytes in the state.
+ *
+ * @param[in] version
+ *   Layout version of the state, RESUME_Restore() only accepts the same.
+ *   Change it whenever the state structure changes.
+ *
+ * @return
+ *   false if the state does not fit in BURAM.
+ *****************************************************************************/
+bool RESUME_Save(const void *state, uint32_t size, uint16_t version)
+{
+  uint32_t words[STATE_WORDS(RESUME_MAX_BYTES)];
+  uint32_t count = STATE_WORDS(size);
+  uint32_t i;
+
+  if ((size == 0) || (size > RESUME_MAX_BYTES)) {
+    return false;
+  }
+
+  words[count - 1] = 0;
+  memcpy(words, state, size);
+
+  enableBuram();
+  RET[0].REG = 0;
+  for (i = 0; i < count; i++) {
+    RET[RESUME_HEADER_WORDS + i].REG = words[i];
+  }
+  RET[1].REG = (size << 24) | checksum(size, words, count);
+  RET[0].REG = (MAGIC << 16) | version;
+
+  return true;
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Restore the application state saved before EM4
+ *
+ * @details
+ *   Call first thing in main(), before the peripherals are initialized,
+ *   so that the application can skip what survived EM4. The snapshot
+ *   stays valid, and the application decides from the reset cause
+ *   whether it is resuming; call RESUME_Invalidate() to start cold.
+ *
+ * @param[out] state
+ *   Where to restore the state, left unchanged if there is no snapshot.
+ *
+ * @param[in] size
+ *   Bytes in the state, must match the saved size.
+ *
+ * @param[in] version
+ *   Layout version of the state, must match the saved version.
+ *
+ * @return
+ *   true if a snapshot of this size and version was restored.
+ *****************************************************************************/
+bool RESUME_Restore(void *state, uint32_t size, uint16_t version)
+{
+  uint32_t words[STATE_WORDS(RESUME_MAX_BYTES)];
+  uint32_t count = STATE_WORDS(size);
+  uint32_t header;
+  uint32_t i;
+
+  if ((size == 0) || (size > RESUME_MAX_BYTES)) {
+    return false;
+  }
+
+  enableBuram();
+  if (RET[0].REG != ((MAGIC << 16) | version)) {
+    return false;
+  }
+  header = RET[1].REG;
+  if ((header >> 24) != size) {
+    return false;
+  }
+
+  for (i = 0; i < count; i++) {
+    words[i] = RET[RESUME_HEADER_WORDS + i].REG;
+  }
+  if ((header & 0x00FFFFFF) != checksum(size, words, count)) {
+    return false;
+  }
+
+  memcpy(state, words, size);
+
+  return true;
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Drop the snapshot, the next RESUME_Restore() fails
+ *****************************************************************************/
+void RESUME_Invalidate(void)
+{
+  enableBuram();
+  RET[0].REG = 0;
+}
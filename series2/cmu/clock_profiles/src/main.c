@@ -0,0 +1,179 @@
+/***************************************************************************//**
+ * @file main.c
+ * @brief This project switches the core between precomputed clock profiles
+ * with the clkprofile kit driver: it idles at 1 MHz, sprints at 78 MHz for
+ * a filter burst and drops back, while the VCOM USART keeps its baud rate
+ * in every profile. See readme.txt for details.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2022 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ *******************************************************************************
+ * # Evaluation Quality
+ * This code has been minimally tested to ensure that it builds and is suitable 
+ * as a demonstration for evaluation purposes only. This code will be maintained
+ * at the sole discretion of Silicon Labs.
+ ******************************************************************************/
+
+#include <stdio.h>
+#include "em_device.h"
+#include "em_burtc.h"
+#include "em_chip.h"
+#include "em_cmu.h"
+#include "em_emu.h"
+#include "em_usart.h"
+#include "bsp.h"
+#include "retargetserial.h"
+
+#include "clkprofile.h"
+#include "lpdelay.h"
+
+// Samples and taps of the filter burst run in the compute profile
+#define BURST_SAMPLES     4096
+#define FIR_TAPS          32
+
+// Round trips timed for each pair of profiles
+#define SWITCH_ROUNDS     32
+
+static const char *names[clkprofileCount] = {
+  [clkprofileCompute] = "compute",
+  [clkprofileRadio]   = "radio",
+  [clkprofileAudio]   = "audio",
+  [clkprofileIdle]    = "idle",
+};
+
+static int16_t samples[BURST_SAMPLES];
+static int16_t taps[FIR_TAPS];
+
+// Results, for the debugger
+volatile int32_t firSum;
+volatile uint32_t burstUs;
+volatile uint32_t switchUs[2];
+volatile CLKPROFILE_Counters_TypeDef counters;
+
+/**************************************************************************//**
+ * @brief BURTC ticks to microseconds
+ *****************************************************************************/
+static uint32_t ticksToUs(uint32_t ticks)
+{
+  return (uint32_t)(((uint64_t)ticks * 1000000)
+                    / CMU_ClockFreqGet(cmuClock_EM4GRPACLK));
+}
+
+/**************************************************************************//**
+ * @brief The burst: a FIR filter over the sample buffer
+ *****************************************************************************/
+static int32_t firBurst(void)
+{
+  int32_t sum = 0;
+  uint32_t i, t;
+
+  for (i = FIR_TAPS - 1; i < BURST_SAMPLES; i++) {
+    int32_t acc = 0;
+    for (t = 0; t < FIR_TAPS; t++) {
+      acc += (int32_t)samples[i - t] * taps[t];
+    }
+    sum += acc >> 15;
+  }
+
+  return sum;
+}
+
+/**************************************************************************//**
+ * @brief Average time of one switch between two profiles
+ *****************************************************************************/
+static uint32_t timeSwitches(CLKPROFILE_Id_TypeDef a, CLKPROFILE_Id_TypeDef b)
+{
+  uint32_t start, i;
+
+  start = BURTC_CounterGet();
+  for (i = 0; i < SWITCH_ROUNDS; i++) {
+    CLKPROFILE_Set(a);
+    CLKPROFILE_Set(b);
+  }
+
+  return ticksToUs(BURTC_CounterGet() - start) / (2 * SWITCH_ROUNDS);
+}
+
+/**************************************************************************//**
+ * @brief Main function
+ *****************************************************************************/
+int main(void)
+{
+  CMU_HFXOInit_TypeDef hfxoInit = CMU_HFXOINIT_WSTK_DEFAULT;
+  EMU_DCDCInit_TypeDef dcdcInit = EMU_DCDCINIT_WSTK_DEFAULT;
+  uint32_t i, start;
+
+  CHIP_Init();
+  EMU_DCDCInit(&dcdcInit);
+
+  for (i = 0; i < BURST_SAMPLES; i++) {
+    samples[i] = (int16_t)((i * 2654435761UL) >> 16);
+  }
+  for (i = 0; i < FIR_TAPS; i++) {
+    taps[i] = (int16_t)(32768 / FIR_TAPS);
+  }
+
+  CLKPROFILE_Init(&hfxoInit);
+  CLKPROFILE_Set(clkprofileIdle);
+
+  // Sleep in EM1 between reports, the BURTC also times the switches
+  LPDELAY_Init(false);
+
+  RETARGET_SerialInit();
+  RETARGET_SerialCrLf(1);
+  CLKPROFILE_AddUsart(RETARGET_UART, RETARGET_CLK, 115200);
+
+  printf("\nClock profiles\n");
+
+  while (1) {
+    // One line from each profile, readable only if the baud rate held
+    for (i = 0; i < clkprofileCount; i++) {
+      CLKPROFILE_Set((CLKPROFILE_Id_TypeDef)i);
+      printf("%-7s SYSCLK %8lu Hz PCLK %8lu Hz %6lu baud\n", names[i],
+             SystemCoreClockGet(), CMU_ClockFreqGet(cmuClock_PCLK),
+             USART_BaudrateGet(RETARGET_UART));
+    }
+
+    // Sprint for the burst and drop back, timed with both switches
+    CLKPROFILE_Set(clkprofileIdle);
+    start = BURTC_CounterGet();
+    CLKPROFILE_Set(clkprofileCompute);
+    firSum = firBurst();
+    CLKPROFILE_Set(clkprofileIdle);
+    burstUs = ticksToUs(BURTC_CounterGet() - start);
+
+    switchUs[0] = timeSwitches(clkprofileCompute, clkprofileIdle);
+    switchUs[1] = timeSwitches(clkprofileRadio, clkprofileAudio);
+
+    CLKPROFILE_Set(clkprofileIdle);
+    CLKPROFILE_GetCounters((CLKPROFILE_Counters_TypeDef *)&counters);
+    printf("burst %lu us, switch compute-idle %lu us, radio-audio %lu us,"
+           " %lu switches %lu DPLL locks %lu fails\n\n",
+           burstUs, switchUs[0], switchUs[1], counters.switches,
+           counters.dpllLocks, counters.dpllFails);
+
+    LPDELAY_Ms(1000);
+  }
+}
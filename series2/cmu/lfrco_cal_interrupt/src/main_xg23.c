@@ -35,55 +35,10 @@
  ******************************************************************************/
 
 #include "em_chip.h"
-#include "em_burtc.h"
 #include "em_cmu.h"
 #include "em_emu.h"
 #include "em_gpio.h"
-
-/*
- * Setup the BURTC to generate interrupts at 16-second intervals.
- * The LFRCO is used as the BURTC clock, but the fact that the
- * clock frequency might change due to calibration isn't really
- * relevant for this example.
- */
-void startBURTC(void)
-{
-  BURTC_Init_TypeDef burtcInit = BURTC_INIT_DEFAULT;
-
-  // Set BURTC clock
-  CMU_ClockSelectSet(cmuClock_EM4GRPACLK, cmuSelect_LFRCO);
-  CMU_ClockEnable(cmuClock_BURTC, true);
-
-  // Set BURTC parameters
-  burtcInit.clkDiv = 32768;
-  burtcInit.compare0Top = true;
-  BURTC_Init(&burtcInit);
-
-  BURTC_CounterReset();
-  BURTC_CompareSet(0, 16);
-
-  // Interrupt setup
-  BURTC_IntClear(BURTC_IF_COMP);
-  BURTC_IntEnable(BURTC_IEN_COMP);
-  NVIC_ClearPendingIRQ(BURTC_IRQn);
-  NVIC_EnableIRQ(BURTC_IRQn);
-}
-
-void BURTC_IRQHandler(void)
-{
-  // Disable the BURTC until the next run
-  BURTC_Enable(false);
-
-  // Clear the BURTC interrupt
-  BURTC_IntClear(BURTC_IF_COMP);
-
-  /*
-   * Force the write to BURTC_IFC to complete before proceeding to
-   * make sure the interrupt is not re-triggered when upon exiting this
-   * IRQ handler as the BURTC is in an asynchronous clock domain.
-   */
-  __DSB();
-}
+#include "recal.h"
 
 /*
  * Top value for the calibration down counter.  Maximum allowed is
@@ -330,21 +285,27 @@ int main(void)
   CMU_ClockEnable(cmuClock_GPIO, true);
   CMU_ClkOutPinConfig(0, cmuSelect_LFRCO, 1, gpioPortC, 0);
 
-  while (1)
-  {
-    // Setup calibration run
-    startCal(32768);
+  // Tune the LFRCO once at startup
+  startCal(32768);
 
-    // Do other stuff while calibration is ongoing
-    while (!tuned)
-    {
-      __NOP();
-    }
+  // Do other stuff while calibration is ongoing
+  while (!tuned)
+  {
+    __NOP();
+  }
 
-    // Start the 16-second BURTC interrupts
-    startBURTC();
+  /*
+   * Keep the LFRCO tuned as the temperature drifts.  From here on the
+   * BURTC interrupt in recal.c checks the LFRCO once a minute, or sooner
+   * if the temperature moves by 2 C, and moves the tuning by one step
+   * per run.
+   */
+  RECAL_Config_t recalConfig = RECAL_CONFIG_DEFAULT;
+  RECAL_Start(&recalConfig);
 
-    // Wait for the CRYOTIMER interrupt before repeating
+  while (1)
+  {
+    // Sleep in EM1 so that the clock output remains active
     EMU_EnterEM1();
   }
 }
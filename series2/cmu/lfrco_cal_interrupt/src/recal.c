@@ -0,0 +1,325 @@
+/***************************************************************************//**
+ * @file recal.c
+ * @brief Background recalibration of the LFRCO against the HFXO.
+ *
+ * @details
+ *   The BURTC interrupts once a second and is the only interrupt used.
+ *   Each tick picks up the result of the calibration run started on an
+ *   earlier tick, moves the LFRCO tuning by at most one step, and starts
+ *   the next run if one is due. A run is due after config.period ticks,
+ *   when the temperature has moved by config.tempDelta since the last
+ *   run, or straight away while the tuning is still moving.
+ *
+ *   The LFRCO clocks the down counter and the HFXO the up counter, the
+ *   other way round from the startup search, so the fast clock sets the
+ *   resolution. With a 38.4 MHz HFXO a run takes 894 LFRCO ticks (27 ms)
+ *   and one count is 1 ppm, against about 1100 ppm for one LFRCO count
+ *   in 2^20 counts of the HFXO.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2021 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ******************************************************************************/
+
+#include <stddef.h>
+#include "em_device.h"
+#include "em_burtc.h"
+#include "em_cmu.h"
+#include "em_emu.h"
+#include "recal.h"
+
+// Width of the calibration counters
+#define COUNTER_MAX       0xFFFFF
+
+// Shortest run that still gives a useful resolution
+#define REF_TICKS_MIN     16
+
+// BURTC ticks per second, from the LFRCO divided by 1024
+#define BURTC_DIV         1024
+
+#define TUNING_MAX        (_LFRCO_CAL_FREQTRIM_MASK >> _LFRCO_CAL_FREQTRIM_SHIFT)
+
+static RECAL_Config_t recalConfig;
+
+static uint32_t refTicks;       // LFRCO ticks per run
+static uint64_t idealScaled;    // Ideal up count * frequency
+
+static bool running;            // A run was started and is not read yet
+static uint32_t ticksSinceRun;  // BURTC ticks since the last run
+static float lastTemp;          // Temperature at the last run
+
+static int32_t lastStep;        // Step after the last run, -1, 0 or 1
+static int32_t lastError;       // Error of the last run, ppm
+static uint32_t hold;           // Error the tuning settled at, ppm
+
+static volatile int32_t errorPpm;
+static volatile uint32_t runCount;
+static volatile uint32_t stepCount;
+
+/***************************************************************************//**
+ * @brief
+ *   Read the temperature, or 0 on devices without the EMU sensor.
+ ******************************************************************************/
+static float readTemperature(void)
+{
+#if defined(_EMU_TEMP_TEMP_MASK)
+  return EMU_TemperatureGet();
+#else
+  return 0.0f;
+#endif
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Start a single run of the calibration counters.
+ ******************************************************************************/
+static void startRun(void)
+{
+  CMU_CalibrateConfig(refTicks - 1, cmuSelect_LFRCO, cmuSelect_HFXO);
+  CMU_CalibrateCont(false);
+  CMU_CalibrateStart();
+
+  running = true;
+  ticksSinceRun = 0;
+  lastTemp = readTemperature();
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Move the LFRCO tuning by one step.
+ *
+ * @param[in] step
+ *   1 to speed the LFRCO up, -1 to slow it down.
+ *
+ * @return
+ *   true if the tuning moved, false if it is at the end of its range.
+ ******************************************************************************/
+static bool stepTuning(int32_t step)
+{
+  int32_t tuning = (int32_t)CMU_OscillatorTuningGet(cmuOsc_LFRCO) + step;
+
+  if ((tuning < 0) || (tuning > (int32_t)TUNING_MAX)) {
+    return false;
+  }
+
+  CMU_OscillatorTuningSet(cmuOsc_LFRCO, (uint32_t)tuning);
+  stepCount++;
+
+  return true;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Read the last run and apply at most one tuning step.
+ *
+ * @details
+ *   A higher up count means a slow LFRCO, so the error is the ideal less
+ *   the measured up count, and a higher tuning value speeds the LFRCO up.
+ *   When the error changes sign after a step, the tuning has
+ *   crossed the ideal count; the step is undone if the tuning before it
+ *   was closer, and the error of the closer one is kept as the hold
+ *   level. Later runs only step again once the error grows past the hold
+ *   level and the deadband, so the tuning does not toggle between the two
+ *   values either side of the ideal count.
+ ******************************************************************************/
+static void applyRun(void)
+{
+  uint64_t upScaled = (uint64_t)CMU_CalibrateCountGet() * recalConfig.frequency;
+  int32_t error = (int32_t)((((int64_t)idealScaled - (int64_t)upScaled)
+                             * 1000000) / (int64_t)idealScaled);
+  uint32_t magnitude = (uint32_t)((error < 0) ? -error : error);
+  uint32_t lastMagnitude = (uint32_t)((lastError < 0) ? -lastError : lastError);
+  int32_t step = (error > 0) ? -1 : 1;
+
+  running = false;
+  errorPpm = error;
+  runCount++;
+
+  if (magnitude <= (hold + recalConfig.deadband)) {
+    // Close enough, leave the tuning alone
+    lastStep = 0;
+  } else if (lastStep == -step) {
+    // Crossed the ideal count, keep whichever tuning was closer
+    if (magnitude > lastMagnitude) {
+      stepTuning(step);
+      hold = lastMagnitude;
+    } else {
+      hold = magnitude;
+    }
+    lastStep = 0;
+  } else {
+    // Still on the same side, step towards the ideal count
+    lastStep = stepTuning(step) ? step : 0;
+    hold = 0;
+  }
+
+  lastError = error;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   BURTC interrupt, once a second.
+ ******************************************************************************/
+void BURTC_IRQHandler(void)
+{
+  float temp;
+
+  BURTC_IntClear(BURTC_IF_COMP);
+
+  /*
+   * Force the write to BURTC_IFC to complete before proceeding to
+   * make sure the interrupt is not re-triggered when upon exiting this
+   * IRQ handler as the BURTC is in an asynchronous clock domain.
+   */
+  __DSB();
+
+  ticksSinceRun++;
+
+  if (running) {
+    applyRun();
+  }
+
+  temp = readTemperature();
+
+  if ((lastStep != 0)
+      || (ticksSinceRun >= recalConfig.period)
+      || ((temp - lastTemp) >= recalConfig.tempDelta)
+      || ((lastTemp - temp) >= recalConfig.tempDelta)) {
+    startRun();
+  }
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Start recalibrating the LFRCO in the background.
+ *
+ * @details
+ *   The HFXO must be running. The startup search in the CMU_IRQHandler()
+ *   should have finished, this takes over the calibration counters and
+ *   turns the CALRDY interrupt off. The BURTC is clocked from the LFRCO
+ *   through the EM4GRPACLK. The first run starts straight away.
+ *
+ * @param[in] config
+ *   Recalibration settings, copied.
+ *
+ * @return
+ *   false if the frequency can not be measured.
+ ******************************************************************************/
+bool RECAL_Start(const RECAL_Config_t *config)
+{
+  BURTC_Init_TypeDef burtcInit = BURTC_INIT_DEFAULT;
+  uint32_t hfxoFreq = SystemHFXOClockGet();
+
+  if ((config == NULL) || (config->frequency < BURTC_DIV) || (hfxoFreq == 0)) {
+    return false;
+  }
+
+  recalConfig = *config;
+
+  // Longest run that keeps the up count inside the counter
+  refTicks = (uint32_t)(((uint64_t)COUNTER_MAX * config->frequency) / hfxoFreq);
+  if (refTicks < REF_TICKS_MIN) {
+    return false;
+  }
+  idealScaled = (uint64_t)hfxoFreq * refTicks;
+
+  // The tick interrupt reads the counters, not the CALRDY interrupt
+  NVIC_DisableIRQ(CMU_IRQn);
+  CMU_IntDisable(CMU_IEN_CALRDY);
+  CMU_IntClear(CMU_IF_CALRDY);
+  CMU_CalibrateStop();
+
+  lastStep = 0;
+  lastError = 0;
+  hold = 0;
+  errorPpm = 0;
+  runCount = 0;
+  stepCount = 0;
+
+  // One second BURTC ticks from the LFRCO
+  CMU_ClockSelectSet(cmuClock_EM4GRPACLK, cmuSelect_LFRCO);
+  CMU_ClockEnable(cmuClock_BURTC, true);
+  burtcInit.start = false;
+  burtcInit.clkDiv = BURTC_DIV;
+  burtcInit.compare0Top = true;
+  BURTC_Init(&burtcInit);
+
+  BURTC_CounterReset();
+  BURTC_CompareSet(0, (config->frequency / BURTC_DIV) - 1);
+
+  BURTC_IntClear(BURTC_IF_COMP);
+  BURTC_IntEnable(BURTC_IEN_COMP);
+  NVIC_ClearPendingIRQ(BURTC_IRQn);
+  NVIC_EnableIRQ(BURTC_IRQn);
+
+  startRun();
+  BURTC_Start();
+
+  return true;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Stop recalibrating, the tuning is left as it is.
+ ******************************************************************************/
+void RECAL_Stop(void)
+{
+  BURTC_Stop();
+  NVIC_DisableIRQ(BURTC_IRQn);
+  BURTC_IntDisable(BURTC_IEN_COMP);
+  BURTC_IntClear(BURTC_IF_COMP);
+  NVIC_ClearPendingIRQ(BURTC_IRQn);
+  CMU_CalibrateStop();
+  running = false;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Get the LFRCO error measured by the last run.
+ *
+ * @return
+ *   (measured - set frequency) / set frequency, ppm.
+ ******************************************************************************/
+int32_t RECAL_GetErrorPpm(void)
+{
+  return errorPpm;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Get the number of calibration runs read since RECAL_Start().
+ ******************************************************************************/
+uint32_t RECAL_GetRunCount(void)
+{
+  return runCount;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Get the number of tuning steps made since RECAL_Start().
+ ******************************************************************************/
+uint32_t RECAL_GetStepCount(void)
+{
+  return stepCount;
+}
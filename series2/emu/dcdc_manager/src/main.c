@@ -0,0 +1,196 @@
+/***************************************************************************//**
+ * @file main.c
+ * @brief This project runs the DCDC through the dcdcmgr kit driver: in low
+ * power regulation while idle, with the low noise settings for a flash erase
+ * and in bypass for precision IADC sampling, and reports the IADC noise with
+ * and without the hint. See readme.txt for details.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2022 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ *******************************************************************************
+ * # Evaluation Quality
+ * This code has been minimally tested to ensure that it builds and is suitable 
+ * as a demonstration for evaluation purposes only. This code will be maintained
+ * at the sole discretion of Silicon Labs.
+ ******************************************************************************/
+
+#include <stdio.h>
+#include "em_device.h"
+#include "em_chip.h"
+#include "em_cmu.h"
+#include "em_emu.h"
+#include "em_iadc.h"
+#include "em_msc.h"
+#include "bsp.h"
+#include "retargetserial.h"
+
+#include "dcdcmgr.h"
+
+// Conversions per noise measurement
+#define NOISE_SAMPLES     256
+
+// IADC clocks, CLK_SRC_ADC from the FSRCO and CLK_ADC for the conversions
+#define CLK_SRC_ADC_FREQ  20000000
+#define CLK_ADC_FREQ      10000000
+
+// Flash page erased with the flash erase hint, the last page of the flash
+#define ERASE_PAGE        (FLASH_BASE + FLASH_SIZE - FLASH_PAGE_SIZE)
+
+static const char *modeNames[dcdcmgrModeCount] = {
+  [dcdcmgrModeLowPower] = "low power",
+  [dcdcmgrModeLowNoise] = "low noise",
+  [dcdcmgrModeBypass]   = "bypass",
+};
+
+// Noise of AVDD / 4 in LSB RMS times 100, without and with the hint
+volatile uint32_t noisePlain;
+volatile uint32_t noiseHinted;
+volatile uint32_t erases;
+volatile DCDCMGR_Counters_TypeDef counters;
+
+/**************************************************************************//**
+ * @brief IADC initialization, single conversions of AVDD / 4
+ *****************************************************************************/
+static void initIADC(void)
+{
+  IADC_Init_t init = IADC_INIT_DEFAULT;
+  IADC_AllConfigs_t initAllConfigs = IADC_ALLCONFIGS_DEFAULT;
+  IADC_InitSingle_t initSingle = IADC_INITSINGLE_DEFAULT;
+  IADC_SingleInput_t initSingleInput = IADC_SINGLEINPUT_DEFAULT;
+
+  CMU_ClockEnable(cmuClock_IADC0, true);
+  IADC_reset(IADC0);
+  CMU_ClockSelectSet(cmuClock_IADCCLK, cmuSelect_FSRCO);
+
+  init.warmup = iadcWarmupKeepWarm;
+  init.srcClkPrescale = IADC_calcSrcClkPrescale(IADC0, CLK_SRC_ADC_FREQ, 0);
+
+  // Internal 1.21 V reference with a gain of 0.5, a 2.42 V range
+  initAllConfigs.configs[0].reference = iadcCfgReferenceInt1V2;
+  initAllConfigs.configs[0].vRef = 1210;
+  initAllConfigs.configs[0].analogGain = iadcCfgAnalogGain0P5x;
+  initAllConfigs.configs[0].adcClkPrescale = IADC_calcAdcClkPrescale(IADC0,
+                                                                    CLK_ADC_FREQ,
+                                                                    0,
+                                                                    iadcCfgModeNormal,
+                                                                    init.srcClkPrescale);
+
+  // The lowest oversampling, so that the supply ripple is not averaged out
+  initAllConfigs.configs[0].osrHighSpeed = iadcCfgOsrHighSpeed2x;
+
+  initSingle.alignment = iadcAlignRight12;
+  initSingleInput.posInput = iadcPosInputAvdd;
+  initSingleInput.negInput = iadcNegInputGnd;
+
+  IADC_init(IADC0, &init, &initAllConfigs);
+  IADC_initSingle(IADC0, &initSingle, &initSingleInput);
+}
+
+/**************************************************************************//**
+ * @brief Convert NOISE_SAMPLES times, returns the RMS noise in LSB * 100
+ *****************************************************************************/
+static uint32_t measureNoise(void)
+{
+  uint32_t sum = 0;
+  uint64_t squares = 0;
+  uint32_t i, sample;
+  uint64_t variance;
+  uint32_t root, bit;
+
+  for (i = 0; i < NOISE_SAMPLES; i++) {
+    IADC_command(IADC0, iadcCmdStartSingle);
+    while ((IADC0->STATUS & (_IADC_STATUS_CONVERTING_MASK
+                             | _IADC_STATUS_SINGLEFIFODV_MASK))
+           != IADC_STATUS_SINGLEFIFODV) {
+    }
+    sample = IADC_pullSingleFifoResult(IADC0).data;
+    sum += sample;
+    squares += sample * sample;
+  }
+
+  // Variance times 100 * 100, then its integer square root
+  variance = ((squares * NOISE_SAMPLES) - ((uint64_t)sum * sum)) * 10000
+             / ((uint64_t)NOISE_SAMPLES * NOISE_SAMPLES);
+  root = 0;
+  for (bit = 1UL << 30; bit != 0; bit >>= 2) {
+    if (variance >= (root + bit)) {
+      variance -= root + bit;
+      root = (root >> 1) + bit;
+    } else {
+      root >>= 1;
+    }
+  }
+
+  return root;
+}
+
+/**************************************************************************//**
+ * @brief Main function
+ *****************************************************************************/
+int main(void)
+{
+  EMU_DCDCInit_TypeDef dcdcInit = EMU_DCDCINIT_WSTK_DEFAULT;
+
+  CHIP_Init();
+
+  // The board settings are the low power mode
+  DCDCMGR_Init(&dcdcInit);
+
+  RETARGET_SerialInit();
+  RETARGET_SerialCrLf(1);
+
+  initIADC();
+  MSC_Init();
+
+  printf("\nDCDC manager\n");
+
+  while (1) {
+    // The same conversions, first in the idle mode, then announced
+    noisePlain = measureNoise();
+
+    DCDCMGR_Request(dcdcmgrHintAdcPrecision);
+    noiseHinted = measureNoise();
+    DCDCMGR_Release(dcdcmgrHintAdcPrecision);
+
+    // A flash erase, a step of a few mA for the DCDC to follow
+    DCDCMGR_Request(dcdcmgrHintFlashErase);
+    if (MSC_ErasePage((uint32_t *)ERASE_PAGE) == mscReturnOk) {
+      erases++;
+    }
+    DCDCMGR_Release(dcdcmgrHintFlashErase);
+
+    DCDCMGR_GetCounters((DCDCMGR_Counters_TypeDef *)&counters);
+    printf("AVDD/4 noise %lu.%02lu LSB in %s, %lu.%02lu LSB in %s,"
+           " %lu erases, %lu low noise %lu bypass\n",
+           noisePlain / 100, noisePlain % 100, modeNames[dcdcmgrModeLowPower],
+           noiseHinted / 100, noiseHinted % 100, modeNames[dcdcmgrModeBypass],
+           erases, counters.entered[dcdcmgrModeLowNoise],
+           counters.entered[dcdcmgrModeBypass]);
+
+    // Idle for about a second in low power regulation
+    for (volatile uint32_t i = 0; i < (SystemCoreClockGet() / 8); i++) {
+    }
+  }
+}
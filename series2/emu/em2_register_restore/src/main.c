@@ -0,0 +1,267 @@
+/***************************************************************************//**
+ * @file main.c
+ * @brief This project turns off the EM0/1 peripheral register retention in
+ * EM2 and brings a TIMER back after each wakeup from a copy of its registers
+ * in RAM instead of setting it up again. See readme.txt for details.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2021 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ *******************************************************************************
+ * # Evaluation Quality
+ * This code has been minimally tested to ensure that it builds and is suitable 
+ * as a demonstration for evaluation purposes only. This code will be maintained
+ * at the sole discretion of Silicon Labs.
+ ******************************************************************************/
+
+#include "em_device.h"
+#include "em_burtc.h"
+#include "em_chip.h"
+#include "em_cmu.h"
+#include "em_emu.h"
+#include "em_gpio.h"
+#include "em_ldma.h"
+#include "em_timer.h"
+#include "mx25flash_spi.h"
+#include "bsp.h"
+#include "regsave.h"
+#include "xseries.h"
+
+/*******************************************************************************
+ *******************************   DEFINES   ***********************************
+ ******************************************************************************/
+
+// 1: EM0/1 peripheral registers are lost in EM2 and restored by REGSAVE
+// 0: they are retained, for comparing the EM2 current
+#define PD1_NORETAIN              1
+
+// Enable debug connectivity in EM2, costs about 0.5 uA
+#define EM2DEBUG                  0
+
+// BURTC on the 32.768 kHz LFRCO: 100 ms period, of which 20 ms in EM0
+#define BURTC_FREQ                32768
+#define WAKE_PERIOD_TICKS         (BURTC_FREQ / 10)
+#define ACTIVE_TICKS              (BURTC_FREQ / 50)
+
+// TIMER0 CC0 PWM on PA05 (Expansion Header Pin 12), 10 kHz, 25% duty
+#define PWM_PORT                  gpioPortA
+#define PWM_PIN                   5
+#define PWM_FREQ                  10000
+#define PWM_DUTY_PERCENT          25
+
+/*******************************************************************************
+ ***************************   GLOBAL VARIABLES   ******************************
+ ******************************************************************************/
+
+/*
+ * TIMER0 registers in the order they are written back: the CFG registers
+ * while the TIMER is disabled, then EN, then the registers the TIMER only
+ * takes while enabled. The TIMER is started again by a command afterwards.
+ */
+static const REGSAVE_Range_t timerRanges[] = {
+  REGSAVE_RANGE(TIMER0->CFG, TIMER0->CFG),
+  REGSAVE_RANGE(TIMER0->CC[0].CFG, TIMER0->CC[0].CFG),
+  REGSAVE_RANGE(TIMER0->EN, TIMER0->EN),
+  REGSAVE_RANGE(TIMER0->CTRL, TIMER0->CTRL),
+  REGSAVE_RANGE(TIMER0->TOP, TIMER0->TOP),
+  REGSAVE_RANGE(TIMER0->CC[0].CTRL, TIMER0->CC[0].OC),
+};
+
+static uint32_t timerStore[8];
+static REGSAVE_Context_t timerContext;
+
+// Core clock cycles of the full TIMER setup, measured once
+volatile uint32_t cyclesInit;
+
+// Core clock cycles of the last save and restore
+volatile uint32_t cyclesSave;
+volatile uint32_t cyclesRestore;
+
+// Completed EM2 wakeups
+volatile uint32_t wakeups;
+
+/***************************************************************************//**
+ * @brief
+ *    Powers down the SPI flash on the radio board
+ *
+ * @details
+ *    A JEDEC standard SPI flash boots up in standby mode in order to
+ *    provide immediate access, such as when used it as a boot memory.
+ *
+ *    Typical current draw in standby mode for the MX25R8035F device used
+ *    on EFR32 radio boards is 5 uA.
+ *
+ *    JEDEC standard SPI flash memories have a lower current deep power-down
+ *    mode, which can be entered after sending the relevant commands. This is on
+ *    the order of 0.007 uA for the MX25R8035F.
+ ******************************************************************************/
+void powerDownSpiFlash(void)
+{
+  FlashStatus status;
+
+  MX25_init();
+  MX25_RSTEN();
+  MX25_RST(&status);
+  MX25_DP();
+  MX25_deinit();
+}
+
+/**************************************************************************//**
+ * @brief  BURTC compare, the periodic wakeup
+ *****************************************************************************/
+void BURTC_IRQHandler(void)
+{
+  BURTC_IntClear(BURTC_IF_COMP);
+}
+
+/**************************************************************************//**
+ * @brief  BURTC initialization, free running on the LFRCO
+ *****************************************************************************/
+void initBURTC(void)
+{
+  BURTC_Init_TypeDef burtcInit = BURTC_INIT_DEFAULT;
+
+  CMU_ClockSelectSet(cmuClock_EM4GRPACLK, cmuSelect_LFRCO);
+  CMU_ClockEnable(cmuClock_BURTC, true);
+
+  BURTC_Init(&burtcInit);
+  BURTC_IntClear(BURTC_IF_COMP);
+  BURTC_IntEnable(BURTC_IEN_COMP);
+  NVIC_ClearPendingIRQ(BURTC_IRQn);
+  NVIC_EnableIRQ(BURTC_IRQn);
+}
+
+/**************************************************************************//**
+ * @brief  TIMER0 initialization, PWM on PWM_PORT/PIN
+ *
+ * @details
+ *   The setup the example would have to repeat after each wakeup without
+ *   register retention.
+ *****************************************************************************/
+void initTIMER(void)
+{
+  TIMER_Init_TypeDef timerInit = TIMER_INIT_DEFAULT;
+  TIMER_InitCC_TypeDef timerCCInit = TIMER_INITCC_DEFAULT;
+  uint32_t top;
+
+  timerInit.enable = false;
+  timerCCInit.mode = timerCCModePWM;
+
+  TIMER_Init(TIMER0, &timerInit);
+  TIMER_InitCC(TIMER0, 0, &timerCCInit);
+
+  top = CMU_ClockFreqGet(cmuClock_TIMER0) / PWM_FREQ;
+  TIMER_TopSet(TIMER0, top);
+  TIMER_CompareSet(TIMER0, 0, (top * PWM_DUTY_PERCENT) / 100);
+
+  TIMER_Enable(TIMER0, true);
+}
+
+/**************************************************************************//**
+ * @brief  Sleep in EM2 until the next BURTC compare
+ *****************************************************************************/
+void sleepEM2(void)
+{
+  uint32_t start;
+
+  BURTC_CompareSet(0, BURTC_CounterGet() + WAKE_PERIOD_TICKS - ACTIVE_TICKS);
+
+#if PD1_NORETAIN
+  start = DWT->CYCCNT;
+  REGSAVE_Save(&timerContext);
+  cyclesSave = DWT->CYCCNT - start;
+#endif
+
+  EMU_EnterEM2(false);
+
+  // CFG is locked while the TIMER is enabled, only restore what was lost
+  start = DWT->CYCCNT;
+#if PD1_NORETAIN
+  REGSAVE_Restore(&timerContext);
+#endif
+  TIMER0->CMD = TIMER_CMD_START;
+  cyclesRestore = DWT->CYCCNT - start;
+
+  wakeups++;
+}
+
+/**************************************************************************//**
+ * @brief  Main function
+ *****************************************************************************/
+int main(void)
+{
+  EMU_DCDCInit_TypeDef dcdcInit = EMU_DCDCINIT_DEFAULT;
+  LDMA_Init_t ldmaInit = LDMA_INIT_DEFAULT;
+  uint32_t start;
+
+  CHIP_Init();
+
+  // Recommended recovery procedure for code in development
+  XSERIES_EscapeHatch(BSP_GPIO_PB0_PORT, BSP_GPIO_PB0_PIN,
+                      BSP_GPIO_LED0_PORT, BSP_GPIO_LED0_PIN);
+
+  EMU_DCDCInit(&dcdcInit);
+  powerDownSpiFlash();
+
+#if (EM2DEBUG == 1)
+  XSERIES_EM2DebugEnable();
+#endif
+
+#if PD1_NORETAIN
+  // EM0/1 peripheral registers are reset in EM2, see the reference manual
+  EMU->PD1PARETCTRL_SET = 0x1;
+#endif
+
+  CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+  DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+  CMU_ClockEnable(cmuClock_GPIO, true);
+  CMU_ClockEnable(cmuClock_TIMER0, true);
+  CMU_ClockEnable(cmuClock_LDMA, true);
+  LDMA_Init(&ldmaInit);
+
+  // The pin route is in the GPIO, which keeps its registers in EM2
+  GPIO_PinModeSet(PWM_PORT, PWM_PIN, gpioModePushPull, 0);
+  XSERIES_TimerRouteCc(0, 0, PWM_PORT, PWM_PIN);
+
+  start = DWT->CYCCNT;
+  initTIMER();
+  cyclesInit = DWT->CYCCNT - start;
+
+  REGSAVE_Init(&timerContext, timerRanges,
+               sizeof(timerRanges) / sizeof(timerRanges[0]),
+               timerStore, sizeof(timerStore) / sizeof(timerStore[0]));
+
+  initBURTC();
+
+  while (1) {
+    // PWM in EM0 for ACTIVE_TICKS, then EM2 until the next period
+    start = BURTC_CounterGet();
+    while ((BURTC_CounterGet() - start) < ACTIVE_TICKS) {
+    }
+
+    TIMER0->CMD = TIMER_CMD_STOP;
+    sleepEM2();
+  }
+}
@@ -0,0 +1,672 @@
+/***************************************************************************//**
+ * @file main.c
+ * @brief This project measures the time from a wakeup event to the first
+ * instruction run in EM1, EM2, EM3 and EM4 with the DCDC on and off and with
+ * and without voltage scaling. See readme.txt for details.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2021 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ *******************************************************************************
+ * # Evaluation Quality
+ * This code has been minimally tested to ensure that it builds and is suitable 
+ * as a demonstration for evaluation purposes only. This code will be maintained
+ * at the sole discretion of Silicon Labs.
+ ******************************************************************************/
+
+
+#include "em_device.h"
+#include "em_burtc.h"
+#include "em_chip.h"
+#include "em_cmu.h"
+#include "em_emu.h"
+#include "em_gpio.h"
+#include "em_prs.h"
+#include "em_rmu.h"
+#include "mx25flash_spi.h"
+#include "bspconfig.h"
+
+/*******************************************************************************
+ *******************************   DEFINES   ***********************************
+ ******************************************************************************/
+
+// Wakeup sources
+#define WAKE_BURTC                0   // BURTC compare, timed by the firmware
+#define WAKE_GPIO                 1   // Falling edge on PB03, timed on a scope
+
+#ifndef WAKE_SOURCE
+#define WAKE_SOURCE               WAKE_BURTC
+#endif
+
+/*
+ * The BURTC runs from the 1 kHz ULFRCO, the only oscillator that keeps
+ * running in EM3 as well as EM2 and EM4. A tick is 1 ms, the firmware
+ * measures the part of a tick with the core clock, see stampWakeup().
+ */
+#define WAKE_TICKS                100     // BURTC ticks from sleep to wakeup
+#define RUN_WAKEUPS               20      // Wakeups measured per configuration
+#define GAP_TICKS                 200     // EM0 between two configurations
+
+// Calibration of the core clock cycles per tick and of the fixed offset
+#define TICK_CAL_TICKS            16
+#define CAL_SAMPLES               8
+
+// GPIO output set on the first instruction after each wakeup
+#define MARKER_PORT               gpioPortC
+#define MARKER_PIN                5
+
+// BURTC compare event, through PRS, as the scope reference for EM1 to EM3
+#define REFERENCE_PRS_CH          0
+#define REFERENCE_PORT            gpioPortA
+#define REFERENCE_PIN             5
+
+// Wakeup input for WAKE_GPIO, push button PB1. PB03 is EM4WU pin 4.
+#define WAKE_PORT                 BSP_GPIO_PB1_PORT
+#define WAKE_PIN                  BSP_GPIO_PB1_PIN
+#define WAKE_EM4WU                GPIO_IEN_EM4WUIEN4
+
+// BURAM words that carry the EM4 measurements through each EM4 wakeup
+#define BURAM_MAGIC               0
+#define BURAM_TICK_CYCLES         1
+#define BURAM_OFFSET_CYCLES       2
+#define BURAM_WAKEUPS             3
+#define BURAM_SUM                 4
+#define BURAM_MIN                 5
+#define BURAM_MAX                 6
+
+#define EM4_STATE_MAGIC           0x574B4534  // "WKE4"
+
+/* This example enters EM2 and EM3; Setting this define to 1
+ * enables debug connectivity in the EMU_CTRL register, which will consume about
+ * 0.5uA additional supply current */
+#define EM2DEBUG                  1
+
+/*******************************************************************************
+ ***************************   GLOBAL VARIABLES   *******************************
+ ******************************************************************************/
+
+// Wakeup latency of one energy mode in one supply configuration
+typedef struct {
+  uint8_t mode;             // Energy mode, 1 to 4
+  bool dcdc;                // DCDC regulating, else bypassed
+  bool lowVoltage;          // EM01 (EM1) or EM23 (EM2, EM3) voltage scaling
+  uint32_t wakeups;         // Wakeups in the statistics
+  float latencyMin;         // Wakeup event to first instruction, us
+  float latencyMean;
+  float latencyMax;
+  float current;            // Average uA asleep, entered from the Energy
+                            // Profiler
+} WakeResult_t;
+
+#define NUM_RUNS                  13
+
+// The EM4 entry is measured once after each power on, before the others
+#define EM4_RUN                   (NUM_RUNS - 1)
+
+/*
+ * An EM4 wakeup is a reset and the DCDC starts up in its reset state, so
+ * the configuration before EM4 makes no difference to the latency and EM4
+ * is entered with the DCDC bypassed, as in the em4_no_dcdc example.
+ */
+static volatile WakeResult_t results[NUM_RUNS] = {
+  { .mode = 1, .dcdc = true,  .lowVoltage = false },
+  { .mode = 1, .dcdc = true,  .lowVoltage = true },
+  { .mode = 1, .dcdc = false, .lowVoltage = false },
+  { .mode = 1, .dcdc = false, .lowVoltage = true },
+  { .mode = 2, .dcdc = true,  .lowVoltage = false },
+  { .mode = 2, .dcdc = true,  .lowVoltage = true },
+  { .mode = 2, .dcdc = false, .lowVoltage = false },
+  { .mode = 2, .dcdc = false, .lowVoltage = true },
+  { .mode = 3, .dcdc = true,  .lowVoltage = false },
+  { .mode = 3, .dcdc = true,  .lowVoltage = true },
+  { .mode = 3, .dcdc = false, .lowVoltage = false },
+  { .mode = 3, .dcdc = false, .lowVoltage = true },
+  { .mode = 4, .dcdc = false, .lowVoltage = false },
+};
+
+// Completed passes over the EM1 to EM3 configurations
+static volatile uint32_t passes;
+
+// Core clock cycles per BURTC tick and the offset measured in EM0
+static volatile uint32_t tickCycles;
+static volatile int32_t offsetCycles;
+
+// BURTC count the current wakeup was set for
+static volatile uint32_t wakeCompare;
+
+// Statistics of the current configuration, updated on each wakeup
+static volatile uint32_t runWakeups;
+static volatile int32_t runSum;
+static volatile int32_t runMin;
+static volatile int32_t runMax;
+
+static volatile bool woken;
+
+/***************************************************************************//**
+ * @brief
+ *    Powers down the SPI flash on the radio board
+ *
+ * @details
+ *    A JEDEC standard SPI flash boots up in standby mode in order to
+ *    provide immediate access, such as when used it as a boot memory.
+ *
+ *    Typical current draw in standby mode for the MX25R8035F device used
+ *    on EFR32 radio boards is 5 µA.
+ *
+ *    JEDEC standard SPI flash memories have a lower current deep power-down
+ *    mode, which can be entered after sending the relevant commands. This is on
+ *    the order of 0.007 µA for the MX25R8035F.
+ ******************************************************************************/
+void powerDownSpiFlash(void)
+{
+  FlashStatus status;
+
+  MX25_init();
+  MX25_RSTEN();
+  MX25_RST(&status);
+  MX25_DP();
+  MX25_deinit();
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Timestamp a wakeup on its first instruction
+ *
+ * @details
+ *   The BURTC count is read and the core clock cycles are counted until it
+ *   changes. The next tick falls (count + 1 - compare) ticks after the
+ *   compare tick, so the wakeup came that many ticks less the cycles
+ *   counted after it. The time the interrupt flag takes to set after the
+ *   compare tick and the count takes to read are the same in EM0, where
+ *   calibrate() measures them into offsetCycles.
+ *
+ * @param[in] compare
+ *   BURTC count of the wakeup event
+ *
+ * @return
+ *   Core clock cycles from the wakeup event
+ *****************************************************************************/
+static int32_t stampWakeup(uint32_t compare)
+{
+  uint32_t count;
+  uint32_t start;
+  uint32_t spin;
+
+  // The cycle counter stops with the debug block in EM2 and lower
+  CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+  DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+  count = BURTC_CounterGet();
+  start = DWT->CYCCNT;
+
+  // Scope marker
+  GPIO_PinOutSet(MARKER_PORT, MARKER_PIN);
+
+  while (BURTC_CounterGet() == count) {
+  }
+  spin = DWT->CYCCNT - start;
+
+  return (int32_t)(((count + 1 - compare) * tickCycles) - spin) - offsetCycles;
+}
+
+/**************************************************************************//**
+ * @brief  Add a wakeup latency to the statistics of the configuration
+ *****************************************************************************/
+static void recordWakeup(int32_t cycles)
+{
+  if ((runWakeups == 0) || (cycles < runMin)) {
+    runMin = cycles;
+  }
+  if ((runWakeups == 0) || (cycles > runMax)) {
+    runMax = cycles;
+  }
+  runSum += cycles;
+  runWakeups++;
+}
+
+/**************************************************************************//**
+ * @brief  BURTC compare, the timed wakeup
+ *****************************************************************************/
+void BURTC_IRQHandler(void)
+{
+  int32_t cycles = stampWakeup(wakeCompare);
+
+  BURTC_IntClear(BURTC_IF_COMP);
+  recordWakeup(cycles);
+  woken = true;
+}
+
+/**************************************************************************//**
+ * @brief  PB03 falling edge, the wakeup for a scope to time
+ *****************************************************************************/
+void GPIO_ODD_IRQHandler(void)
+{
+  GPIO_PinOutSet(MARKER_PORT, MARKER_PIN);
+
+  GPIO_IntClear(1 << WAKE_PIN);
+  runWakeups++;
+  woken = true;
+}
+
+/**************************************************************************//**
+ * @brief  GPIO initialization
+ *****************************************************************************/
+void initGPIO(void)
+{
+  CMU_ClockEnable(cmuClock_GPIO, true);
+
+  GPIO_PinModeSet(MARKER_PORT, MARKER_PIN, gpioModePushPull, 0);
+
+#if (WAKE_SOURCE == WAKE_GPIO)
+  // No input filter, it would add to the latency
+  GPIO_PinModeSet(WAKE_PORT, WAKE_PIN, gpioModeInputPull, 1);
+  GPIO_ExtIntConfig(WAKE_PORT, WAKE_PIN, WAKE_PIN, false, true, true);
+  GPIO_EM4EnablePinWakeup(WAKE_EM4WU, 0);
+
+  NVIC_ClearPendingIRQ(GPIO_ODD_IRQn);
+  NVIC_EnableIRQ(GPIO_ODD_IRQn);
+#else
+  // Pulse on each BURTC compare event, a port A pin keeps it in EM2 and EM3
+  CMU_ClockEnable(cmuClock_PRS, true);
+  GPIO_PinModeSet(REFERENCE_PORT, REFERENCE_PIN, gpioModePushPull, 0);
+  PRS_SourceAsyncSignalSet(REFERENCE_PRS_CH, PRS_ASYNC_CH_CTRL_SOURCESEL_BURTC,
+                           PRS_ASYNC_CH_CTRL_SIGSEL_BURTCCOMP);
+  PRS_PinOutput(REFERENCE_PRS_CH, prsTypeAsync, REFERENCE_PORT, REFERENCE_PIN);
+#endif
+}
+
+/**************************************************************************//**
+ * @brief  BURTC initialization, free running on the ULFRCO
+ *
+ * @param[in] resume
+ *   True after an EM4 wakeup. The BURTC went on counting through EM4 and
+ *   keeps its configuration, so it is only taken over.
+ *****************************************************************************/
+void initBURTC(bool resume)
+{
+  BURTC_Init_TypeDef burtcInit = BURTC_INIT_DEFAULT;
+
+  CMU_ClockSelectSet(cmuClock_EM4GRPACLK, cmuSelect_ULFRCO);
+  CMU_ClockEnable(cmuClock_BURTC, true);
+
+  if (!resume) {
+    BURTC_Reset();
+    burtcInit.em4comp = (WAKE_SOURCE == WAKE_BURTC);
+    BURTC_Init(&burtcInit);
+  }
+
+#if (WAKE_SOURCE == WAKE_BURTC)
+  BURTC_IntClear(BURTC_IF_COMP);
+  BURTC_IntEnable(BURTC_IEN_COMP);
+  NVIC_ClearPendingIRQ(BURTC_IRQn);
+  NVIC_EnableIRQ(BURTC_IRQn);
+#endif
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Measure the core clock cycles per BURTC tick and the offset of a
+ *   wakeup timestamp taken in EM0
+ *
+ * @details
+ *   The offset is the time stampWakeup() reports when the CPU was never
+ *   asleep and polls the compare flag instead, and is taken off each
+ *   wakeup latency.
+ *****************************************************************************/
+void calibrate(void)
+{
+  uint32_t count;
+  uint32_t start;
+  int32_t sum = 0;
+
+  NVIC_DisableIRQ(BURTC_IRQn);
+
+  CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+  DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+  // Start on a tick
+  count = BURTC_CounterGet();
+  while (BURTC_CounterGet() == count) {
+  }
+  start = DWT->CYCCNT;
+  count++;
+  while ((BURTC_CounterGet() - count) < TICK_CAL_TICKS) {
+  }
+  tickCycles = ((DWT->CYCCNT - start) + (TICK_CAL_TICKS / 2)) / TICK_CAL_TICKS;
+
+  offsetCycles = 0;
+  for (uint32_t i = 0; i < CAL_SAMPLES; i++) {
+    BURTC_IntClear(BURTC_IF_COMP);
+    wakeCompare = BURTC_CounterGet() + 2;
+    BURTC_CompareSet(0, wakeCompare);
+    while (!(BURTC_IntGet() & BURTC_IF_COMP)) {
+    }
+    sum += stampWakeup(wakeCompare);
+    GPIO_PinOutClear(MARKER_PORT, MARKER_PIN);
+  }
+  offsetCycles = sum / CAL_SAMPLES;
+
+  BURTC_IntClear(BURTC_IF_COMP);
+  NVIC_ClearPendingIRQ(BURTC_IRQn);
+  NVIC_EnableIRQ(BURTC_IRQn);
+}
+
+/**************************************************************************//**
+ * @brief  Set the DCDC mode and voltage scaling of a configuration
+ *****************************************************************************/
+void configureRun(uint32_t run)
+{
+  EMU_EM01Init_TypeDef em01Init = EMU_EM01INIT_DEFAULT;
+  EMU_EM23Init_TypeDef em23Init = EMU_EM23INIT_DEFAULT;
+  bool lowVoltage = results[run].lowVoltage;
+
+  EMU_DCDCModeSet(results[run].dcdc ? emuDcdcMode_Regulation
+                                    : emuDcdcMode_Bypass);
+
+  // EM1 runs at the EM0 voltage, EM2 and EM3 at the EM23 voltage
+  em01Init.vScaleEM01LowPowerVoltageEnable = (results[run].mode == 1)
+                                             && lowVoltage;
+  EMU_EM01Init(&em01Init);
+
+  if ((results[run].mode != 1) && lowVoltage) {
+    em23Init.vScaleEM23Voltage = emuVScaleEM23_LowPower;
+  } else {
+    em23Init.vScaleEM23Voltage = emuVScaleEM23_FastWakeup;
+  }
+  EMU_EM23Init(&em23Init);
+}
+
+/**************************************************************************//**
+ * @brief  Set up the next BURTC wakeup
+ *****************************************************************************/
+static void armWakeup(void)
+{
+#if (WAKE_SOURCE == WAKE_BURTC)
+  wakeCompare = BURTC_CounterGet() + WAKE_TICKS;
+  BURTC_CompareSet(0, wakeCompare);
+#endif
+}
+
+/**************************************************************************//**
+ * @brief  Convert the statistics of a configuration to microseconds
+ *****************************************************************************/
+void storeResult(uint32_t run,
+                 uint32_t wakeups,
+                 int32_t sum,
+                 int32_t min,
+                 int32_t max)
+{
+  float usPerCycle = 1000000.0f / SystemCoreClockGet();
+
+  results[run].wakeups = wakeups;
+#if (WAKE_SOURCE == WAKE_BURTC)
+  if (wakeups > 0) {
+    results[run].latencyMin = min * usPerCycle;
+    results[run].latencyMean = ((float)sum / wakeups) * usPerCycle;
+    results[run].latencyMax = max * usPerCycle;
+  }
+#else
+  (void)sum;
+  (void)min;
+  (void)max;
+  (void)usPerCycle;
+#endif
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Measure RUN_WAKEUPS wakeups from the energy mode of a configuration
+ *
+ * @details
+ *   The CPU sleeps with interrupts enabled, so the first instruction after
+ *   each wakeup is the first one of the interrupt handler. The wakeup is
+ *   entered without restoring the oscillators, the core clock is again
+ *   the HFRCODPLL at 19 MHz as soon as the device wakes up.
+ *****************************************************************************/
+void measureRun(uint32_t run)
+{
+  uint32_t mode = results[run].mode;
+
+  runWakeups = 0;
+  runSum = 0;
+
+  while (runWakeups < RUN_WAKEUPS) {
+    woken = false;
+    GPIO_PinOutClear(MARKER_PORT, MARKER_PIN);
+    armWakeup();
+
+    while (!woken) {
+      if (mode == 1) {
+        EMU_EnterEM1();
+      } else if (mode == 2) {
+        EMU_EnterEM2(false);
+      } else {
+        EMU_EnterEM3(false);
+      }
+    }
+  }
+  GPIO_PinOutClear(MARKER_PORT, MARKER_PIN);
+
+  storeResult(run, runWakeups, runSum, runMin, runMax);
+}
+
+/**************************************************************************//**
+ * @brief  Spend GAP_TICKS in EM0, a step in the Energy Profiler between
+ *         two configurations
+ *****************************************************************************/
+void gapEM0(void)
+{
+  uint32_t start = BURTC_CounterGet();
+
+  while ((BURTC_CounterGet() - start) < GAP_TICKS) {
+  }
+}
+
+/**************************************************************************//**
+ * @brief  Make the BURAM registers accessible
+ *****************************************************************************/
+static void enableBURAM(void)
+{
+#if defined(_CMU_CLKEN0_BURAM_MASK)
+  CMU_ClockEnable(cmuClock_BURAM, true);
+#endif
+}
+
+/**************************************************************************//**
+ * @brief  Set up the next EM4 wakeup and enter EM4
+ *****************************************************************************/
+void enterEM4(void)
+{
+  EMU_EM4Init_TypeDef em4Init = EMU_EM4INIT_DEFAULT;
+
+  GPIO_PinOutClear(MARKER_PORT, MARKER_PIN);
+  armWakeup();
+
+  EMU_DCDCModeSet(emuDcdcMode_Bypass);
+
+  // Keep the marker low through EM4 until it is set after the wakeup
+  em4Init.pinRetentionMode = emuPinRetentionLatch;
+  EMU_EM4Init(&em4Init);
+  EMU_EnterEM4();
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Start the EM4 measurements with the calibration from EM0
+ *****************************************************************************/
+void startEM4(void)
+{
+  BURAM->RET[BURAM_TICK_CYCLES].REG = tickCycles;
+  BURAM->RET[BURAM_OFFSET_CYCLES].REG = (uint32_t)offsetCycles;
+  BURAM->RET[BURAM_WAKEUPS].REG = 0;
+  BURAM->RET[BURAM_SUM].REG = 0;
+  BURAM->RET[BURAM_MIN].REG = 0;
+  BURAM->RET[BURAM_MAX].REG = 0;
+  BURAM->RET[BURAM_MAGIC].REG = EM4_STATE_MAGIC;
+
+  enterEM4();
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Add an EM4 wakeup to the statistics in BURAM
+ *
+ * @return
+ *   True once RUN_WAKEUPS wakeups have been measured
+ *****************************************************************************/
+bool recordEM4(int32_t cycles)
+{
+  uint32_t wakeups = BURAM->RET[BURAM_WAKEUPS].REG;
+
+#if (WAKE_SOURCE == WAKE_BURTC)
+  if ((wakeups == 0) || (cycles < (int32_t)BURAM->RET[BURAM_MIN].REG)) {
+    BURAM->RET[BURAM_MIN].REG = (uint32_t)cycles;
+  }
+  if ((wakeups == 0) || (cycles > (int32_t)BURAM->RET[BURAM_MAX].REG)) {
+    BURAM->RET[BURAM_MAX].REG = (uint32_t)cycles;
+  }
+  BURAM->RET[BURAM_SUM].REG += (uint32_t)cycles;
+#else
+  (void)cycles;
+#endif
+  wakeups++;
+  BURAM->RET[BURAM_WAKEUPS].REG = wakeups;
+
+  return wakeups >= RUN_WAKEUPS;
+}
+
+/**************************************************************************//**
+ * @brief  Main function
+ *****************************************************************************/
+int main(void)
+{
+  EMU_DCDCInit_TypeDef dcdcInit = EMU_DCDCINIT_DEFAULT;
+  bool em4Wakeup;
+  int32_t em4Cycles = 0;
+  uint32_t run;
+
+  /*
+   * Time an EM4 wakeup before anything else. The BURTC and BURAM kept
+   * their state through EM4; the marker is set up and released from pin
+   * retention still low, stampWakeup() sets it.
+   */
+  enableBURAM();
+  em4Wakeup = (RMU_ResetCauseGet() & EMU_RSTCAUSE_EM4)
+              && (BURAM->RET[BURAM_MAGIC].REG == EM4_STATE_MAGIC);
+  if (em4Wakeup) {
+    CMU_ClockEnable(cmuClock_BURTC, true);
+    CMU_ClockEnable(cmuClock_GPIO, true);
+    GPIO_PinModeSet(MARKER_PORT, MARKER_PIN, gpioModePushPull, 0);
+    EMU_UnlatchPinRetention();
+
+#if (WAKE_SOURCE == WAKE_BURTC)
+    tickCycles = BURAM->RET[BURAM_TICK_CYCLES].REG;
+    offsetCycles = (int32_t)BURAM->RET[BURAM_OFFSET_CYCLES].REG;
+    em4Cycles = stampWakeup(BURTC_CompareGet(0));
+#else
+    GPIO_PinOutSet(MARKER_PORT, MARKER_PIN);
+#endif
+  }
+  RMU_ResetCauseClear();
+
+  // Chip errata
+  CHIP_Init();
+
+  // Release the pins after a reset from EM4 with the BURAM state lost
+  EMU_UnlatchPinRetention();
+
+  /*
+   * When developing or debugging code that enters EM2 or
+   *  lower, it's a good idea to have an "escape hatch" type
+   * mechanism, e.g. a way to pause the device so that a debugger can
+   * connect in order to erase flash, among other things.
+   *
+   * Before proceeding with this example, make sure PB0 is not pressed.
+   * If the PB0 pin is low, turn on LED0 and execute the breakpoint
+   * instruction to stop the processor in EM0 and allow a debug
+   * connection to be made.
+   */
+  CMU_ClockEnable(cmuClock_GPIO, true);
+  GPIO_PinModeSet(BSP_GPIO_PB0_PORT, BSP_GPIO_PB0_PIN, gpioModeInputPullFilter, 1);
+  if (GPIO_PinInGet(BSP_GPIO_PB0_PORT, BSP_GPIO_PB0_PIN) == 0) {
+    GPIO_PinModeSet(BSP_GPIO_LED0_PORT, BSP_GPIO_LED0_PIN, gpioModePushPull, 1);
+    __BKPT(0);
+  }
+  // Pin not asserted, so disable input
+  else {
+    GPIO_PinModeSet(BSP_GPIO_PB0_PORT, BSP_GPIO_PB0_PIN, gpioModeDisabled, 0);
+  }
+
+  // Turn on DCDC regulator
+  EMU_DCDCInit(&dcdcInit);
+
+  // The SPI flash stays powered down through EM4
+  if (!em4Wakeup) {
+    powerDownSpiFlash();
+  }
+
+  initGPIO();
+
+  initBURTC(em4Wakeup);
+
+#ifdef EM2DEBUG
+#if (EM2DEBUG == 1)
+  // Enable debug connectivity in EM2
+  EMU->CTRL_SET = EMU_CTRL_EM2DBGEN;
+#endif
+#endif
+
+  // EM4 first, each wakeup comes back here through a reset
+  if (!em4Wakeup) {
+#if (WAKE_SOURCE == WAKE_BURTC)
+    calibrate();
+#endif
+    startEM4();
+  }
+  if (!recordEM4(em4Cycles)) {
+    enterEM4();
+  }
+  storeResult(EM4_RUN,
+              BURAM->RET[BURAM_WAKEUPS].REG,
+              (int32_t)BURAM->RET[BURAM_SUM].REG,
+              (int32_t)BURAM->RET[BURAM_MIN].REG,
+              (int32_t)BURAM->RET[BURAM_MAX].REG);
+  BURAM->RET[BURAM_MAGIC].REG = 0;
+
+#if (WAKE_SOURCE == WAKE_BURTC)
+  calibrate();
+#endif
+
+  // Infinite loop
+  while (1)
+  {
+    for (run = 0; run < EM4_RUN; run++) {
+      configureRun(run);
+      measureRun(run);
+      gapEM0();
+    }
+
+    passes++;
+  }
+}
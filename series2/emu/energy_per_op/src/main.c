@@ -0,0 +1,696 @@
+/***************************************************************************//**
+ * @file main.c
+ * @brief Runs six canonical operations, an FFT, AES-CTR, a CRC, a flash
+ * program, an SPI transfer and a burst of IADC samples, in each clock
+ * profile, times them and marks each run for the Energy Profiler, then
+ * prints the energy of one operation from the currents entered.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2022 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ *******************************************************************************
+ * # Evaluation Quality
+ * This code has been minimally tested to ensure that it builds and is suitable 
+ * as a demonstration for evaluation purposes only. This code will be maintained
+ * at the sole discretion of Silicon Labs.
+ ******************************************************************************/
+
+
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include "em_device.h"
+#include "em_chip.h"
+#include "em_cmu.h"
+#include "em_emu.h"
+#include "em_eusart.h"
+#include "em_gpcrc.h"
+#include "em_gpio.h"
+#include "em_iadc.h"
+#include "em_ldma.h"
+#include "em_msc.h"
+#include "bsp.h"
+#include "mx25flash_config.h"
+#include "retargetserial.h"
+#include "arm_math.h"
+#include "arm_const_structs.h"
+#include "benchmark.h"
+#include "clkprofile.h"
+#include "energymark.h"
+
+/*******************************************************************************
+ *******************************   DEFINES   ***********************************
+ ******************************************************************************/
+
+// Bytes of the AES, CRC, flash and SPI operations
+#define OP_BYTES                  1024
+
+// Points of the complex FFT
+#define FFT_LEN                   128
+
+// Conversions of the IADC operation
+#define IADC_SAMPLES              100
+
+// Length of the marked run of each operation
+#define DWELL_US                  200000
+
+// Supply of the kit, the voltage the Energy Profiler measures the current at
+#define SUPPLY_MV                 3300
+
+// Pages at the end of the main flash programmed by the flash operation
+#define FLASH_PAGES               2
+#define FLASH_AREA                ((uint32_t *)(FLASH_BASE + FLASH_SIZE \
+                                                - (FLASH_PAGES * FLASH_PAGE_SIZE)))
+#define FLASH_OPS                 ((FLASH_PAGES * FLASH_PAGE_SIZE) / OP_BYTES)
+
+/*
+ * EUSART1 in SPI main mode on the pins of the onboard SPI flash, which
+ * ignores the transfers with its chip select kept high.
+ */
+#define SPI_BITRATE               4000000
+#define SPI_MOSI_PORT             MX25_PORT_MOSI
+#define SPI_MOSI_PIN              MX25_PIN_MOSI
+#define SPI_MISO_PORT             MX25_PORT_MISO
+#define SPI_MISO_PIN              MX25_PIN_MISO
+#define SPI_SCLK_PORT             MX25_PORT_SCLK
+#define SPI_SCLK_PIN              MX25_PIN_SCLK
+#define SPI_TX_LDMA_CH            0
+#define SPI_RX_LDMA_CH            1
+
+#define COUNT_OF(a)               (sizeof(a) / sizeof((a)[0]))
+
+/*******************************************************************************
+ ***************************   GLOBAL VARIABLES   *******************************
+ ******************************************************************************/
+
+// One operation: set up before each run, then run any number of times
+typedef struct {
+  const char *name;
+  void (*setup)(void);
+  void (*run)(void);
+  uint32_t maxRuns;         // Runs after setup, 0 for no limit
+} Operation_t;
+
+// Measurements of one operation in one profile
+typedef struct {
+  uint8_t op;               // Index of the operation
+  CLKPROFILE_Id_TypeDef profile;
+  uint32_t sysclk;          // SYSCLK of the profile, Hz
+  bool lowVoltage;          // EM01 voltage scale 1, else 2
+  uint8_t marker;           // ENERGYMARK ID of the marked run
+  uint32_t runs;            // Operations in the marked run
+  uint32_t cycles;          // Core cycles of one operation
+  double us;                // Time of one operation, us
+  double current;           // Average uA over the marker, entered from
+                            // the Energy Profiler
+  double energy;            // uJ of one operation, from the current
+} Result_t;
+
+static void setupNone(void);
+static void runFft(void);
+static void runAesCtr(void);
+static void runCrc(void);
+static void setupFlash(void);
+static void runFlash(void);
+static void setupSpi(void);
+static void runSpi(void);
+static void runIadc(void);
+
+static const Operation_t operations[] = {
+  { "FFT 128",    setupNone,  runFft,    0             },
+  { "AES-CTR 1K", setupNone,  runAesCtr, 0             },
+  { "GPCRC 1K",   setupNone,  runCrc,    0             },
+  { "flash 1K",   setupFlash, runFlash,  FLASH_OPS - 1 },
+  { "SPI DMA 1K", setupSpi,   runSpi,    0             },
+  { "IADC 100",   setupNone,  runIadc,   0             },
+};
+
+#define NUM_OPS                   COUNT_OF(operations)
+#define NUM_CONFIGS               (clkprofileCount * NUM_OPS)
+
+static const char *profileNames[clkprofileCount] = {
+  [clkprofileCompute] = "compute",
+  [clkprofileRadio]   = "radio",
+  [clkprofileAudio]   = "audio",
+  [clkprofileIdle]    = "idle",
+};
+
+volatile Result_t results[NUM_CONFIGS];
+
+// Completed sweeps over all configurations
+volatile uint32_t sweeps;
+
+// Outputs of the operations, kept so none is optimized away
+volatile uint32_t crc;
+volatile uint32_t iadcSum;
+volatile float32_t fftPeak;
+
+// Data of the byte operations, and the SPI receive buffer
+static uint8_t data[OP_BYTES] __attribute__ ((aligned(4)));
+static uint8_t spiRx[OP_BYTES];
+
+// FFT input and the buffer transformed in place, interleaved re and im
+static float32_t fftInput[2 * FFT_LEN];
+static float32_t fftBuffer[2 * FFT_LEN];
+
+// Next flash word to program
+static uint32_t *flashNext;
+
+static LDMA_Descriptor_t spiTxDesc;
+static LDMA_Descriptor_t spiRxDesc;
+
+/*******************************************************************************
+ ******************************   AES-128   ************************************
+ ******************************************************************************/
+
+/*
+ * A compact table based AES-128 for the counter mode operation. The
+ * xG24 has its AES in the Secure Engine, which is reached through the SE
+ * Manager rather than emlib, so this measures the core doing the cipher.
+ */
+static const uint8_t sbox[256] = {
+  0x63, 0x7c, 0x77, 0x7b, 0xf2, 0x6b, 0x6f, 0xc5, 0x30, 0x01, 0x67, 0x2b, 0xfe, 0xd7, 0xab, 0x76,
+  0xca, 0x82, 0xc9, 0x7d, 0xfa, 0x59, 0x47, 0xf0, 0xad, 0xd4, 0xa2, 0xaf, 0x9c, 0xa4, 0x72, 0xc0,
+  0xb7, 0xfd, 0x93, 0x26, 0x36, 0x3f, 0xf7, 0xcc, 0x34, 0xa5, 0xe5, 0xf1, 0x71, 0xd8, 0x31, 0x15,
+  0x04, 0xc7, 0x23, 0xc3, 0x18, 0x96, 0x05, 0x9a, 0x07, 0x12, 0x80, 0xe2, 0xeb, 0x27, 0xb2, 0x75,
+  0x09, 0x83, 0x2c, 0x1a, 0x1b, 0x6e, 0x5a, 0xa0, 0x52, 0x3b, 0xd6, 0xb3, 0x29, 0xe3, 0x2f, 0x84,
+  0x53, 0xd1, 0x00, 0xed, 0x20, 0xfc, 0xb1, 0x5b, 0x6a, 0xcb, 0xbe, 0x39, 0x4a, 0x4c, 0x58, 0xcf,
+  0xd0, 0xef, 0xaa, 0xfb, 0x43, 0x4d, 0x33, 0x85, 0x45, 0xf9, 0x02, 0x7f, 0x50, 0x3c, 0x9f, 0xa8,
+  0x51, 0xa3, 0x40, 0x8f, 0x92, 0x9d, 0x38, 0xf5, 0xbc, 0xb6, 0xda, 0x21, 0x10, 0xff, 0xf3, 0xd2,
+  0xcd, 0x0c, 0x13, 0xec, 0x5f, 0x97, 0x44, 0x17, 0xc4, 0xa7, 0x7e, 0x3d, 0x64, 0x5d, 0x19, 0x73,
+  0x60, 0x81, 0x4f, 0xdc, 0x22, 0x2a, 0x90, 0x88, 0x46, 0xee, 0xb8, 0x14, 0xde, 0x5e, 0x0b, 0xdb,
+  0xe0, 0x32, 0x3a, 0x0a, 0x49, 0x06, 0x24, 0x5c, 0xc2, 0xd3, 0xac, 0x62, 0x91, 0x95, 0xe4, 0x79,
+  0xe7, 0xc8, 0x37, 0x6d, 0x8d, 0xd5, 0x4e, 0xa9, 0x6c, 0x56, 0xf4, 0xea, 0x65, 0x7a, 0xae, 0x08,
+  0xba, 0x78, 0x25, 0x2e, 0x1c, 0xa6, 0xb4, 0xc6, 0xe8, 0xdd, 0x74, 0x1f, 0x4b, 0xbd, 0x8b, 0x8a,
+  0x70, 0x3e, 0xb5, 0x66, 0x48, 0x03, 0xf6, 0x0e, 0x61, 0x35, 0x57, 0xb9, 0x86, 0xc1, 0x1d, 0x9e,
+  0xe1, 0xf8, 0x98, 0x11, 0x69, 0xd9, 0x8e, 0x94, 0x9b, 0x1e, 0x87, 0xe9, 0xce, 0x55, 0x28, 0xdf,
+  0x8c, 0xa1, 0x89, 0x0d, 0xbf, 0xe6, 0x42, 0x68, 0x41, 0x99, 0x2d, 0x0f, 0xb0, 0x54, 0xbb, 0x16
+};
+
+// Key and initial counter block of the AES operation, any values will do
+static const uint8_t aesKey[16] = {
+  0x2b, 0x7e, 0x15, 0x16, 0x28, 0xae, 0xd2, 0xa6,
+  0xab, 0xf7, 0x15, 0x88, 0x09, 0xcf, 0x4f, 0x3c
+};
+static const uint8_t aesIv[16] = {
+  0xf0, 0xf1, 0xf2, 0xf3, 0xf4, 0xf5, 0xf6, 0xf7,
+  0xf8, 0xf9, 0xfa, 0xfb, 0xfc, 0xfd, 0xfe, 0xff
+};
+
+// Expanded key, 11 round keys
+static uint8_t roundKeys[176];
+
+/**************************************************************************//**
+ * @brief  Multiply by x in GF(2^8)
+ *****************************************************************************/
+static uint8_t xtime(uint8_t b)
+{
+  return (uint8_t)((b << 1) ^ ((b & 0x80) ? 0x1b : 0x00));
+}
+
+/**************************************************************************//**
+ * @brief  Expand the AES-128 key into the round keys
+ *****************************************************************************/
+static void aesExpandKey(const uint8_t key[16])
+{
+  uint8_t rcon = 0x01;
+  uint8_t t[4];
+  uint32_t i, j;
+
+  memcpy(roundKeys, key, 16);
+  for (i = 16; i < sizeof(roundKeys); i += 4) {
+    memcpy(t, &roundKeys[i - 4], 4);
+    if ((i % 16) == 0) {
+      uint8_t first = t[0];
+
+      t[0] = sbox[t[1]] ^ rcon;
+      t[1] = sbox[t[2]];
+      t[2] = sbox[t[3]];
+      t[3] = sbox[first];
+      rcon = xtime(rcon);
+    }
+    for (j = 0; j < 4; j++) {
+      roundKeys[i + j] = roundKeys[i + j - 16] ^ t[j];
+    }
+  }
+}
+
+/**************************************************************************//**
+ * @brief  Encrypt one block in place with the expanded key
+ *****************************************************************************/
+static void aesEncryptBlock(uint8_t s[16])
+{
+  uint8_t t[16];
+  uint32_t round, c, i;
+
+  for (i = 0; i < 16; i++) {
+    s[i] ^= roundKeys[i];
+  }
+
+  for (round = 1; round <= 10; round++) {
+    // SubBytes and ShiftRows, the state is in columns of four bytes
+    for (i = 0; i < 16; i++) {
+      t[i] = sbox[s[(i + 4 * (i % 4)) % 16]];
+    }
+
+    // MixColumns, all rounds but the last
+    for (c = 0; c < 16; c += 4) {
+      if (round < 10) {
+        uint8_t all = t[c] ^ t[c + 1] ^ t[c + 2] ^ t[c + 3];
+        uint8_t first = t[c];
+
+        s[c]     = t[c] ^ all ^ xtime(t[c] ^ t[c + 1]);
+        s[c + 1] = t[c + 1] ^ all ^ xtime(t[c + 1] ^ t[c + 2]);
+        s[c + 2] = t[c + 2] ^ all ^ xtime(t[c + 2] ^ t[c + 3]);
+        s[c + 3] = t[c + 3] ^ all ^ xtime(t[c + 3] ^ first);
+      } else {
+        memcpy(&s[c], &t[c], 4);
+      }
+    }
+
+    for (i = 0; i < 16; i++) {
+      s[i] ^= roundKeys[16 * round + i];
+    }
+  }
+}
+
+/*******************************************************************************
+ *****************************   OPERATIONS   **********************************
+ ******************************************************************************/
+
+/**************************************************************************//**
+ * @brief  Nothing to set up
+ *****************************************************************************/
+static void setupNone(void)
+{
+}
+
+/**************************************************************************//**
+ * @brief  One 128 point complex FFT, CMSIS-DSP, in place on a copy
+ *****************************************************************************/
+static void runFft(void)
+{
+  memcpy(fftBuffer, fftInput, sizeof(fftBuffer));
+  arm_cfft_f32(&arm_cfft_sR_f32_len128, fftBuffer, 0, 1);
+  fftPeak = fftBuffer[2 * 5 + 1];
+}
+
+/**************************************************************************//**
+ * @brief  AES-128 CTR over OP_BYTES, in place
+ *
+ * @details
+ *   The key is expanded once at startup, as for a session key. Each 16 byte
+ *   block is XORed with the encrypted counter, the last four bytes of the
+ *   counter block counting up.
+ *****************************************************************************/
+static void runAesCtr(void)
+{
+  uint8_t counter[16], stream[16];
+  uint32_t block, i, n;
+
+  memcpy(counter, aesIv, sizeof(counter));
+  for (block = 0; block < OP_BYTES; block += 16) {
+    memcpy(stream, counter, sizeof(stream));
+    aesEncryptBlock(stream);
+    for (i = 0; i < 16; i++) {
+      data[block + i] ^= stream[i];
+    }
+
+    n = ((uint32_t)counter[12] << 24) | ((uint32_t)counter[13] << 16)
+        | ((uint32_t)counter[14] << 8) | counter[15];
+    n++;
+    counter[12] = (uint8_t)(n >> 24);
+    counter[13] = (uint8_t)(n >> 16);
+    counter[14] = (uint8_t)(n >> 8);
+    counter[15] = (uint8_t)n;
+  }
+}
+
+/**************************************************************************//**
+ * @brief  CRC-32 of OP_BYTES with the GPCRC, fed a word at a time
+ *****************************************************************************/
+static void runCrc(void)
+{
+  const uint32_t *word = (const uint32_t *)data;
+  uint32_t i;
+
+  GPCRC_Start(GPCRC);
+  for (i = 0; i < OP_BYTES / 4; i++) {
+    GPCRC_InputU32(GPCRC, word[i]);
+  }
+  crc = GPCRC_DataRead(GPCRC);
+}
+
+/**************************************************************************//**
+ * @brief  Erase the flash area, outside the marked run
+ *****************************************************************************/
+static void setupFlash(void)
+{
+  uint32_t i;
+
+  for (i = 0; i < FLASH_PAGES; i++) {
+    MSC_ErasePage(FLASH_AREA + (i * FLASH_PAGE_SIZE / 4));
+  }
+  flashNext = FLASH_AREA;
+}
+
+/**************************************************************************//**
+ * @brief  Program OP_BYTES into the next erased part of the flash area
+ *****************************************************************************/
+static void runFlash(void)
+{
+  MSC_WriteWord(flashNext, data, OP_BYTES);
+  flashNext += OP_BYTES / 4;
+}
+
+/**************************************************************************//**
+ * @brief  Set up EUSART1 for the clock of the profile
+ *
+ * @details
+ *    EUSART1 runs from the EM01GRPCCLK, which changes with the profile, so
+ *    its divider is worked out again. The bit rate is SPI_BITRATE where
+ *    the clock allows, at most half of it.
+ *****************************************************************************/
+static void setupSpi(void)
+{
+  EUSART_SpiInit_TypeDef init = EUSART_SPI_MASTER_INIT_DEFAULT_HF;
+  EUSART_SpiAdvancedInit_TypeDef adv = EUSART_SPI_ADVANCED_INIT_DEFAULT;
+  uint32_t maxRate = CMU_ClockFreqGet(cmuClock_EUSART1) / 2;
+
+  adv.msbFirst = true;
+  init.bitRate = (SPI_BITRATE < maxRate) ? SPI_BITRATE : maxRate;
+  init.advancedSettings = &adv;
+  EUSART_SpiInit(EUSART1, &init);
+}
+
+/**************************************************************************//**
+ * @brief  Full duplex SPI transfer of OP_BYTES, both ways by the LDMA
+ *
+ * @details
+ *    The CPU starts both channels and waits for the last received byte,
+ *    which comes in after the last one has been shifted out.
+ *****************************************************************************/
+static void runSpi(void)
+{
+  LDMA_TransferCfg_t txCfg =
+    LDMA_TRANSFER_CFG_PERIPHERAL(ldmaPeripheralSignal_EUSART1_TXFL);
+  LDMA_TransferCfg_t rxCfg =
+    LDMA_TRANSFER_CFG_PERIPHERAL(ldmaPeripheralSignal_EUSART1_RXFL);
+
+  spiTxDesc = (LDMA_Descriptor_t)
+    LDMA_DESCRIPTOR_SINGLE_M2P_BYTE(data, &EUSART1->TXDATA, OP_BYTES);
+  spiRxDesc = (LDMA_Descriptor_t)
+    LDMA_DESCRIPTOR_SINGLE_P2M_BYTE(&EUSART1->RXDATA, spiRx, OP_BYTES);
+  spiTxDesc.xfer.doneIfs = 0;
+  spiRxDesc.xfer.doneIfs = 0;
+
+  LDMA_StartTransfer(SPI_RX_LDMA_CH, &rxCfg, &spiRxDesc);
+  LDMA_StartTransfer(SPI_TX_LDMA_CH, &txCfg, &spiTxDesc);
+
+  while (!LDMA_TransferDone(SPI_RX_LDMA_CH)) {
+  }
+}
+
+/**************************************************************************//**
+ * @brief  IADC_SAMPLES single conversions of AVDD, each started and read
+ *         by the CPU
+ *****************************************************************************/
+static void runIadc(void)
+{
+  uint32_t i, sum = 0;
+
+  for (i = 0; i < IADC_SAMPLES; i++) {
+    IADC_command(IADC0, iadcCmdStartSingle);
+    while (!(IADC0->STATUS & IADC_STATUS_SINGLEFIFODV)) {
+    }
+    sum += IADC_pullSingleFifoResult(IADC0).data;
+  }
+  iadcSum = sum;
+}
+
+/*******************************************************************************
+ ***************************   INITIALIZATION   ********************************
+ ******************************************************************************/
+
+/**************************************************************************//**
+ * @brief  Pins of PB0, of the SPI and of the SPI flash chip select
+ *****************************************************************************/
+static void initGpio(void)
+{
+  CMU_ClockEnable(cmuClock_GPIO, true);
+
+  GPIO_PinModeSet(BSP_GPIO_PB0_PORT, BSP_GPIO_PB0_PIN, gpioModeInputPull, 1);
+
+  // Keep the SPI flash deselected
+  GPIO_PinModeSet(MX25_PORT_CS, MX25_PIN_CS, gpioModePushPull, 1);
+
+  GPIO_PinModeSet(SPI_MOSI_PORT, SPI_MOSI_PIN, gpioModePushPull, 0);
+  GPIO_PinModeSet(SPI_MISO_PORT, SPI_MISO_PIN, gpioModeInput, 0);
+  GPIO_PinModeSet(SPI_SCLK_PORT, SPI_SCLK_PIN, gpioModePushPull, 0);
+
+  CMU_ClockEnable(cmuClock_EUSART1, true);
+  GPIO->EUSARTROUTE[1].TXROUTE = (SPI_MOSI_PORT << _GPIO_EUSART_TXROUTE_PORT_SHIFT)
+                                 | (SPI_MOSI_PIN << _GPIO_EUSART_TXROUTE_PIN_SHIFT);
+  GPIO->EUSARTROUTE[1].RXROUTE = (SPI_MISO_PORT << _GPIO_EUSART_RXROUTE_PORT_SHIFT)
+                                 | (SPI_MISO_PIN << _GPIO_EUSART_RXROUTE_PIN_SHIFT);
+  GPIO->EUSARTROUTE[1].SCLKROUTE = (SPI_SCLK_PORT << _GPIO_EUSART_SCLKROUTE_PORT_SHIFT)
+                                   | (SPI_SCLK_PIN << _GPIO_EUSART_SCLKROUTE_PIN_SHIFT);
+  GPIO->EUSARTROUTE[1].ROUTEEN = GPIO_EUSART_ROUTEEN_RXPEN
+                                 | GPIO_EUSART_ROUTEEN_TXPEN
+                                 | GPIO_EUSART_ROUTEEN_SCLKPEN;
+}
+
+/**************************************************************************//**
+ * @brief  GPCRC initialization, CRC-32 from 0xFFFFFFFF
+ *****************************************************************************/
+static void initGpcrc(void)
+{
+  GPCRC_Init_TypeDef init = GPCRC_INIT_DEFAULT;
+
+  CMU_ClockEnable(cmuClock_GPCRC, true);
+
+  init.initValue = 0xFFFFFFFF;
+  GPCRC_Init(GPCRC, &init);
+}
+
+/**************************************************************************//**
+ * @brief  IADC initialization, single conversions of AVDD / 4
+ *
+ * @details
+ *    The IADC runs from the 20 MHz FSRCO whatever the profile, CLK_ADC at
+ *    10 MHz with 2x oversampling, so a conversion takes the same time in
+ *    every profile. It warms up for each conversion and shuts down
+ *    after it, the normal warmup.
+ *****************************************************************************/
+static void initIadc(void)
+{
+  IADC_Init_t init = IADC_INIT_DEFAULT;
+  IADC_AllConfigs_t initAllConfigs = IADC_ALLCONFIGS_DEFAULT;
+  IADC_InitSingle_t initSingle = IADC_INITSINGLE_DEFAULT;
+  IADC_SingleInput_t singleInput = IADC_SINGLEINPUT_DEFAULT;
+
+  CMU_ClockEnable(cmuClock_IADC0, true);
+  CMU_ClockSelectSet(cmuClock_IADCCLK, cmuSelect_FSRCO);
+
+  init.warmup = iadcWarmupNormal;
+  init.srcClkPrescale = IADC_calcSrcClkPrescale(IADC0, 20000000, 0);
+
+  initAllConfigs.configs[0].reference = iadcCfgReferenceInt1V2;
+  initAllConfigs.configs[0].vRef = 1210;
+  initAllConfigs.configs[0].analogGain = iadcCfgAnalogGain0P5x;
+  initAllConfigs.configs[0].osrHighSpeed = iadcCfgOsrHighSpeed2x;
+  initAllConfigs.configs[0].adcClkPrescale = IADC_calcAdcClkPrescale(IADC0,
+                                                                     10000000,
+                                                                     0,
+                                                                     iadcCfgModeNormal,
+                                                                     init.srcClkPrescale);
+
+  initSingle.alignment = iadcAlignRight16;
+  initSingle.dataValidLevel = iadcFifoCfgDvl1;
+
+  singleInput.posInput = iadcPosInputAvdd;
+  singleInput.negInput = iadcNegInputGnd;
+
+  IADC_init(IADC0, &init, &initAllConfigs);
+  IADC_initSingle(IADC0, &initSingle, &singleInput);
+}
+
+/**************************************************************************//**
+ * @brief  Input data of the operations
+ *****************************************************************************/
+static void initData(void)
+{
+  uint32_t i;
+
+  for (i = 0; i < OP_BYTES; i++) {
+    data[i] = (uint8_t)((i * 2654435761UL) >> 24);
+  }
+
+  // Two tones, bins 5 and 21, and no imaginary part
+  for (i = 0; i < FFT_LEN; i++) {
+    fftInput[2 * i] = sinf(2.0f * PI * 5 * i / FFT_LEN)
+                      + 0.5f * sinf(2.0f * PI * 21 * i / FFT_LEN);
+    fftInput[2 * i + 1] = 0.0f;
+  }
+
+  aesExpandKey(aesKey);
+}
+
+/*******************************************************************************
+ ****************************   MEASUREMENT   **********************************
+ ******************************************************************************/
+
+/**************************************************************************//**
+ * @brief
+ *   Time one operation in the current profile and run it in a marked run
+ *
+ * @details
+ *   A first run, not marked, times the operation and brings its code into
+ *   the cache. The marked run then repeats the operation for about
+ *   DWELL_US, at least once and at most the limit of the operation, so the
+ *   Energy Profiler has enough samples for an average current. The serial
+ *   port is flushed first, so that no transmit interrupt falls inside the
+ *   marked run.
+ *****************************************************************************/
+static void measure(volatile Result_t *result)
+{
+  const Operation_t *op = &operations[result->op];
+  uint32_t start, cycles, runs, i;
+
+  op->setup();
+
+  BENCHMARK_START(start);
+  op->run();
+  cycles = BENCHMARK_Elapsed(start);
+
+  runs = (uint32_t)(((uint64_t)DWELL_US * result->sysclk)
+                    / ((uint64_t)cycles * 1000000));
+  if (runs == 0) {
+    runs = 1;
+  }
+  if ((op->maxRuns != 0) && (runs > op->maxRuns)) {
+    runs = op->maxRuns;
+  }
+
+  RETARGET_SerialFlush();
+
+  ENERGYMARK_BEGIN(result->marker);
+  BENCHMARK_START(start);
+  for (i = 0; i < runs; i++) {
+    op->run();
+  }
+  cycles = BENCHMARK_Elapsed(start);
+  ENERGYMARK_END(result->marker);
+
+  result->runs = runs;
+  result->cycles = cycles / runs;
+  result->us = ((double)cycles * 1000000.0) / ((double)result->sysclk * runs);
+  result->energy = (result->current * SUPPLY_MV * result->us) / 1e9;
+}
+
+/**************************************************************************//**
+ * @brief  Print one configuration
+ *****************************************************************************/
+static void printResult(volatile const Result_t *result)
+{
+  printf("%3u  %-10s  %-7s  %2lu MHz  %u  %5lu  %8lu  %7lu.%01lu",
+         (unsigned int)result->marker, operations[result->op].name,
+         profileNames[result->profile], result->sysclk / 1000000,
+         result->lowVoltage ? 1U : 2U, result->runs, result->cycles,
+         (uint32_t)result->us, (uint32_t)(result->us * 10) % 10);
+  if (result->current > 0) {
+    printf("  %6lu.%01lu  %4lu.%03lu", (uint32_t)result->current,
+           (uint32_t)(result->current * 10) % 10,
+           (uint32_t)result->energy,
+           (uint32_t)(result->energy * 1000) % 1000);
+  }
+  printf("\n");
+}
+
+/**************************************************************************//**
+ * @brief  Main function
+ *****************************************************************************/
+int main(void)
+{
+  CMU_HFXOInit_TypeDef hfxoInit = CMU_HFXOINIT_WSTK_DEFAULT;
+  EMU_DCDCInit_TypeDef dcdcInit = EMU_DCDCINIT_WSTK_DEFAULT;
+  LDMA_Init_t ldmaInit = LDMA_INIT_DEFAULT;
+  uint32_t p, o, i;
+
+  CHIP_Init();
+  EMU_DCDCInit(&dcdcInit);
+
+  ENERGYMARK_Init();
+  BENCHMARK_Init();
+
+  CLKPROFILE_Init(&hfxoInit);
+  CLKPROFILE_Set(clkprofileIdle);
+
+  RETARGET_SerialInit();
+  RETARGET_SerialCrLf(1);
+  CLKPROFILE_AddUsart(RETARGET_UART, RETARGET_CLK, 115200);
+
+  LDMA_Init(&ldmaInit);
+  MSC_Init();
+  initGpio();
+  initGpcrc();
+  initIadc();
+  initData();
+
+  // Every operation in every profile, in the order of the marker IDs
+  i = 0;
+  for (p = 0; p < clkprofileCount; p++) {
+    for (o = 0; o < NUM_OPS; o++) {
+      results[i].op = (uint8_t)o;
+      results[i].profile = (CLKPROFILE_Id_TypeDef)p;
+      results[i].sysclk = CLKPROFILE_GetProfile(results[i].profile)->frequency;
+      results[i].lowVoltage = CLKPROFILE_GetProfile(results[i].profile)->lowVoltage;
+      results[i].marker = (uint8_t)(ENERGYMARK_ID_USER + i);
+      i++;
+    }
+  }
+
+  printf("\nEnergy per operation, %u configurations\n",
+         (unsigned int)NUM_CONFIGS);
+
+  while (1) {
+    printf("\nID   operation   profile  SYSCLK  VS   runs  cycles/op    us/op"
+           "       uA  uJ/op\n");
+    for (i = 0; i < NUM_CONFIGS; i++) {
+      CLKPROFILE_Set(results[i].profile);
+      measure(&results[i]);
+      printResult(&results[i]);
+    }
+    sweeps++;
+
+    // Each sweep erases the flash area, so the next one waits for PB0
+    CLKPROFILE_Set(clkprofileIdle);
+    printf("\nEnter the current of each marker in results[n].current,"
+           " press PB0 for the next sweep\n");
+    while (GPIO_PinInGet(BSP_GPIO_PB0_PORT, BSP_GPIO_PB0_PIN)) {
+    }
+    while (!GPIO_PinInGet(BSP_GPIO_PB0_PORT, BSP_GPIO_PB0_PIN)) {
+    }
+  }
+}
@@ -4,12 +4,11 @@
  * using LDMA to receive inbound data and transmit outbound data while
  * remaining in EM2.
  *
- * After initialization, the MCU goes into EM2 where the receive LDMA
- * channel buffers the specified number of bytes of incoming data.  The
- * LDMA channel done interrupt wakes the device from EM2.  The CPU starts
- * the transmit channel and re-enters EM2.  The LDMA services the EUART
- * transmit FIFO until the specified number of bytes are sent.  The LDMA
- * channel done interrupt again wakes the system. and the process repeats.
+ * After initialization, the MCU goes into EM2 while the receive LDMA
+ * channel writes incoming data round robin into a ring buffer.  The EUART
+ * receive timeout wakes the device once the line has been idle after a
+ * message, however long the message is.  The CPU copies the message out,
+ * starts the transmit channel to echo it and re-enters EM2.
  *
  * NOTE: Throughout this example, EUSART API calls are used to configure
  * and access EUART functionality.  This is because the EUART is a proper
@@ -52,6 +51,7 @@
 #include "em_device.h"
 #include "em_chip.h"
 #include "em_cmu.h"
+#include "em_core.h"
 #include "em_emu.h"
 #include "em_eusart.h"
 #include "em_gpio.h"
@@ -63,11 +63,46 @@
 // BSP for board controller pin macros
 #include "bsp.h"
 
-// Size of the buffer for received data
-#define BUFLEN  10
+// Size of the receive ring, at most 2048 bytes (one LDMA descriptor).
+// A message must be shorter than the ring.
+#define RING_SIZE       256
 
-// Receive data buffer
-uint8_t buffer[BUFLEN];
+// Line idle time that ends a message
+#define RX_TIMEOUT      EUART_CFG1_RXTIMEOUT_TWOFRAMES
+
+// Number of messages that can wait to be echoed
+#define MSG_QUEUE_LEN   8
+
+#if !defined(EUART_IF_RXTO)
+#error "Message framing needs the EUART receive timeout"
+#endif
+
+// Receive ring, written by the LDMA without ever stopping
+uint8_t ring[RING_SIZE];
+
+// Messages as ring offset and length, queued by the receive timeout
+typedef struct {
+  uint16_t start;
+  uint16_t length;
+} Message_t;
+
+static Message_t msgQueue[MSG_QUEUE_LEN];
+static volatile uint32_t msgHead;
+static volatile uint32_t msgTail;
+
+// Ring offset where the next message starts
+static uint32_t msgStart;
+
+// Copy of the message being echoed, the ring keeps receiving meanwhile
+uint8_t buffer[RING_SIZE];
+
+static volatile bool txBusy;
+
+// Message statistics
+// Note: These are only volatile to ensure that they don't get optimized out
+// by the compiler before the user checks their value.
+volatile uint32_t msgCount;
+volatile uint32_t msgDropCount;   // Queue full, message not echoed
 
 // In low-frequency mode, the maximum EUART baud rate is 9600
 #define BAUDRATE             9600
@@ -150,8 +185,19 @@ void initEUART0(void)
   init.advancedSettings->dmaWakeUpOnTx = false;
   init.advancedSettings->dmaHaltOnError = true;
 
-  // Configure and enable EUART0 for low-frequency (EM2) operation
+  // Configure EUART0 for low-frequency (EM2) operation, enable it below
+  init.enable = eusartDisable;
   EUSART_UartInitLf(EUART0, &init);
+
+  // The receive timeout can only be set while EUART0 is disabled
+  EUART0->CFG1 = (EUART0->CFG1 & ~_EUART_CFG1_RXTIMEOUT_MASK) | RX_TIMEOUT;
+  EUSART_Enable(EUART0, eusartEnable);
+
+  // The receive timeout is the only EUART0 interrupt, the LDMA moves the data
+  EUSART_IntClear(EUART0, EUART_IF_RXTO);
+  EUSART_IntEnable(EUART0, EUART_IF_RXTO);
+  NVIC_ClearPendingIRQ(EUART0_RX_IRQn);
+  NVIC_EnableIRQ(EUART0_RX_IRQn);
 }
 
 /**************************************************************************//**
@@ -164,17 +210,75 @@ void initLDMA(void)
   LDMA_Init_t ldmaInit = LDMA_INIT_DEFAULT;
   LDMA_Init(&ldmaInit);
 
-  // Source is buffer, destination is EUART0_TXDATA, and length if BUFLEN
-  ldmaTXDescriptor = (LDMA_Descriptor_t)LDMA_DESCRIPTOR_SINGLE_M2P_BYTE(buffer, &(EUART0->TXDATA), BUFLEN);
-
   // Transfer a byte on free space in the EUART FIFO
   ldmaTXConfig = (LDMA_TransferCfg_t)LDMA_TRANSFER_CFG_PERIPHERAL(ldmaPeripheralSignal_EUART0_TXFL);
 
-  // Source is EUART0_RXDATA, destination is buffer, and length if BUFLEN
-  ldmaRXDescriptor = (LDMA_Descriptor_t)LDMA_DESCRIPTOR_SINGLE_P2M_BYTE(&(EUART0->RXDATA), buffer, BUFLEN);
+  /*
+   * Source is EUART0_RXDATA, destination is the ring.  The descriptor
+   * links to itself, so the channel starts over at the beginning of the
+   * ring after the last byte and never stops.  It raises no interrupt,
+   * the receive timeout is what wakes the CPU.
+   */
+  ldmaRXDescriptor = (LDMA_Descriptor_t)LDMA_DESCRIPTOR_LINKREL_P2M_BYTE(&(EUART0->RXDATA), ring, RING_SIZE, 0);
+  ldmaRXDescriptor.xfer.doneIfs = 0;
 
   // Transfer a byte on receive FIFO level event
   ldmaRXConfig = (LDMA_TransferCfg_t)LDMA_TRANSFER_CFG_PERIPHERAL(ldmaPeripheralSignal_EUART0_RXFL);
+
+  // Start the LDMA receive channel, it runs from here on
+  LDMA_StartTransfer(RX_LDMA_CHANNEL, &ldmaRXConfig, &ldmaRXDescriptor);
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Copy the oldest queued message out of the ring and echo it
+ *****************************************************************************/
+static void echoMessage(void)
+{
+  Message_t *msg = &msgQueue[msgTail];
+  uint32_t i;
+
+  for (i = 0; i < msg->length; i++) {
+    buffer[i] = ring[(msg->start + i) % RING_SIZE];
+  }
+
+  // Source is buffer, destination is EUART0_TXDATA, and length is the message
+  ldmaTXDescriptor = (LDMA_Descriptor_t)LDMA_DESCRIPTOR_SINGLE_M2P_BYTE(buffer, &(EUART0->TXDATA), msg->length);
+
+  txBusy = true;
+  msgTail = (msgTail + 1) % MSG_QUEUE_LEN;
+
+  LDMA_StartTransfer(TX_LDMA_CHANNEL, &ldmaTXConfig, &ldmaTXDescriptor);
+}
+
+/**************************************************************************//**
+ * @brief EUART receive IRQHandler
+ *****************************************************************************/
+void EUART0_RX_IRQHandler(void)
+{
+  uint32_t end;
+  uint32_t next;
+
+  EUSART_IntClear(EUART0, EUART_IF_RXTO);
+
+  // The LDMA has written everything up to its destination address
+  end = (LDMA->CH[RX_LDMA_CHANNEL].DST - (uint32_t)ring) % RING_SIZE;
+
+  if (end == msgStart) {
+    return;
+  }
+
+  next = (msgHead + 1) % MSG_QUEUE_LEN;
+  if (next == msgTail) {
+    msgDropCount++;
+  } else {
+    msgQueue[msgHead].start = msgStart;
+    msgQueue[msgHead].length = (end - msgStart + RING_SIZE) % RING_SIZE;
+    msgHead = next;
+    msgCount++;
+  }
+
+  msgStart = end;
 }
 
 /**************************************************************************//**
@@ -184,17 +288,10 @@ void LDMA_IRQHandler()
 {
   uint32_t flags = LDMA_IntGet();
 
-  // Clear the transmit channel's done flag if set
+  // Clear the transmit channel's done flag if set, the echo is done
   if (flags & (1 << TX_LDMA_CHANNEL)) {
     LDMA_IntClear(1 << TX_LDMA_CHANNEL);
-  }
-
-  /*
-   * Clear the receive channel's done flag if set and change receive
-   * state to done.
-   */
-  if (flags & (1 << RX_LDMA_CHANNEL)) {
-    LDMA_IntClear(1 << RX_LDMA_CHANNEL);
+    txBusy = false;
   }
 
   // Stop in case there was an error
@@ -209,7 +306,7 @@ void LDMA_IRQHandler()
  *****************************************************************************/
 int main(void)
 {
-  uint32_t i;
+  CORE_DECLARE_IRQ_STATE;
 
   // Chip errata
   CHIP_Init();
@@ -258,20 +355,13 @@ int main(void)
 
   while (1)
   {
-    // Zero out buffer
-    for (i = 0; i < BUFLEN; i++)
-      buffer[i] = 0;
-
-    // Start the LDMA receive channel
-    LDMA_StartTransfer(RX_LDMA_CHANNEL, &ldmaRXConfig, &ldmaRXDescriptor);
-
-    // Wait in EM2 while receiving data
-    EMU_EnterEM2(true);
-
-    // start the LDMA transmit channel
-    LDMA_StartTransfer(TX_LDMA_CHANNEL, &ldmaTXConfig, &ldmaTXDescriptor);
-
-    // Wait in EM2 while transmitting data
-    EMU_EnterEM2(true);
+    // Wait in EM2 until a message has arrived and the last echo is done
+    CORE_ENTER_CRITICAL();
+    if (txBusy || (msgTail == msgHead))
+      EMU_EnterEM2(true);
+    CORE_EXIT_CRITICAL();
+
+    if (!txBusy && (msgTail != msgHead))
+      echoMessage();
   }
 }
@@ -51,6 +51,8 @@
 #include "em_eusart.h"
 #include "em_gpio.h"
 
+#include "autobaud.h"
+
 // BSP for board controller pin macros
 #include "bsp.h"
 
@@ -113,11 +115,17 @@ void initEUSART1(void)
   // Default asynchronous initializer (8N1, no flow control)
   EUSART_UartInit_TypeDef init = EUSART_UART_INIT_DEFAULT_HF;
 
-  // Setting baudrate = 0 enables autobaud detection
-  init.baudrate = 0;
+  /*
+   * Start at the baud rate detected on an earlier boot if there is one,
+   * otherwise run autobaud detection on the first character received.
+   */
+  AUTOBAUD_Init(EUSART1, &init, NULL);
 
-  // Configure and enable EUSART1 for high-frequency (EM0/1) operation
-  EUSART_UartInitHf(EUSART1, &init);
+  /*
+   * The receive FIFO level interrupt can be enabled right away as the
+   * autobaud component consumes everything received while detecting.
+   */
+  EUSART_IntEnable(EUSART1, EUSART_IEN_RXFL);
 
   // Enable NVIC EUSART sources
   NVIC_ClearPendingIRQ(EUSART1_RX_IRQn);
@@ -132,33 +140,27 @@ void initEUSART1(void)
  *****************************************************************************/
 void EUSART1_RX_IRQHandler(void)
 {
+  // Autobaud detection and framing errors are handled by the component
+  if (AUTOBAUD_RxIrq()) {
+    return;
+  }
+
   // Get the character just received
   buffer[inpos] = EUSART1->RXDATA;
 
-  // Check for autobaud done interrupt
-  if(EUSART_IntGet(EUSART1) & EUSART_IF_AUTOBAUDDONE) {
-    // Disable Auto Baud Complete interrupt
-    EUSART_IntDisable(EUSART1, EUSART_IEN_AUTOBAUDDONE);
-
-    // Enable receive FIFO level interrupt
-    EUSART_IntEnable(EUSART1, EUSART_IEN_RXFL);
+  // Exit loop on new line or buffer full
+  if ((buffer[inpos] != '\r') && (inpos < BUFLEN - 1)) {
+    inpos++;
   }
-  // Otherwise buffer characters on RX FIFO interrupt
   else {
-    // Exit loop on new line or buffer full
-    if ((buffer[inpos] != '\r') && (inpos < BUFLEN)) {
-      inpos++;
-    }
-    else {
-      receive = false;   // Stop receiving on CR
-    }
+    receive = false;   // Stop receiving on CR
   }
 
   /*
    * The EUSART differs from the USART in that explicit clearing of
    * RX interrupt flags is required even after emptying the RX FIFO.
    */
-  EUSART_IntClear(EUSART1, EUSART_IF_RXFL | EUSART_IF_AUTOBAUDDONE);
+  EUSART_IntClear(EUSART1, EUSART_IF_RXFL);
 }
 
 /**************************************************************************//**
@@ -205,9 +207,6 @@ int main(void)
   initGPIO();
   initEUSART1();
 
-  // Enable interrupt on auto baud completion
-  EUSART_IntEnable(EUSART1, EUSART_IEN_AUTOBAUDDONE);
-
   while (1) {
     // Zero out buffer
     for (i = 0; i < BUFLEN; i++) {
@@ -4,12 +4,15 @@
  * using LDMA to receive inbound data and transmit outbound data while
  * remaining in EM2.
  *
- * After initialization, the MCU goes into EM2 where the receive LDMA
- * channel buffers the specified number of bytes of incoming data.  The
- * LDMA channel done interrupt wakes the device from EM2.  The CPU starts
- * the transmit channel and re-enters EM2.  The LDMA services the EUSART
- * transmit FIFO until the specified number of bytes are sent.  The LDMA
- * channel done interrupt again wakes the system. and the process repeats.
+ * After initialization, the MCU goes into EM2 while the receive LDMA
+ * channel writes incoming data round robin into a ring buffer.  The EUSART
+ * receive timeout wakes the device once the line has been idle after a
+ * message, however long the message is.  The CPU copies the message out,
+ * starts the transmit channel to echo it and re-enters EM2.
+ *
+ * With RX_CRC set, the receive channel also feeds each byte to the GPCRC
+ * right after writing it to the ring, so the CRC-32 of the message is ready
+ * when the receive timeout fires and is echoed after the message.
  *******************************************************************************
  * # License
  * <b>Copyright 2021 Silicon Laboratories Inc. www.silabs.com</b>
@@ -47,8 +50,10 @@
 #include "em_device.h"
 #include "em_chip.h"
 #include "em_cmu.h"
+#include "em_core.h"
 #include "em_emu.h"
 #include "em_eusart.h"
+#include "em_gpcrc.h"
 #include "em_gpio.h"
 #include "em_ldma.h"
 
@@ -58,11 +63,64 @@
 // BSP for board controller pin macros
 #include "bsp.h"
 
-// Size of the buffer for received data
-#define BUFLEN  10
-
-// Receive data buffer
-uint8_t buffer[BUFLEN];
+// Feed the received bytes to the GPCRC as they arrive, 0 to just echo
+#define RX_CRC          1
+
+// Size of the receive ring, at most 2048 bytes (one LDMA descriptor).
+// A message must be shorter than the ring.  The inline CRC takes two
+// descriptors per ring byte, so the ring is smaller then.
+#if RX_CRC
+#define RING_SIZE       64
+#else
+#define RING_SIZE       256
+#endif
+
+// GPCRC_DATA after a message that ends with its own CRC-32, low byte first
+#define CRC_RESIDUE     0xDEBB20E3
+
+// Line idle time that ends a message
+#define RX_TIMEOUT      EUSART_CFG1_RXTIMEOUT_TWOFRAMES
+
+// Number of messages that can wait to be echoed
+#define MSG_QUEUE_LEN   8
+
+#if !defined(EUSART_IF_RXTO)
+#error "Message framing needs the EUSART receive timeout"
+#endif
+
+// Receive ring, written by the LDMA without ever stopping
+uint8_t ring[RING_SIZE];
+
+// Messages as ring offset and length, queued by the receive timeout
+typedef struct {
+  uint16_t start;
+  uint16_t length;
+#if RX_CRC
+  uint32_t crc;
+#endif
+} Message_t;
+
+static Message_t msgQueue[MSG_QUEUE_LEN];
+static volatile uint32_t msgHead;
+static volatile uint32_t msgTail;
+
+// Ring offset where the next message starts
+static uint32_t msgStart;
+
+// Copy of the message being echoed, the ring keeps receiving meanwhile,
+// with room for a space, the CRC-32 in hex and a line end
+uint8_t buffer[RING_SIZE + 11];
+
+static volatile bool txBusy;
+
+// Message statistics
+// Note: These are only volatile to ensure that they don't get optimized out
+// by the compiler before the user checks their value.
+volatile uint32_t msgCount;
+volatile uint32_t msgDropCount;   // Queue full, message not echoed
+#if RX_CRC
+volatile uint32_t msgCrcOkCount;  // Messages ending with their own CRC-32
+#endif
 
 // In low-frequency mode, the maximum EUSART baud rate is 9600
 #define BAUDRATE             9600
@@ -76,7 +134,13 @@ LDMA_Descriptor_t ldmaTXDescriptor;
 LDMA_TransferCfg_t ldmaTXConfig;
 
 // LDMA descriptor and transfer configuration structures for RX channel
+#if RX_CRC
+// Two per ring byte: one from EUSART0_RXDATA to the ring, one from the ring
+// to the GPCRC
+LDMA_Descriptor_t ldmaRXDescriptor[2 * RING_SIZE];
+#else
 LDMA_Descriptor_t ldmaRXDescriptor;
+#endif
 LDMA_TransferCfg_t ldmaRXConfig;
 
 /**************************************************************************//**
@@ -144,9 +208,39 @@ void initEUSART0(void)
   init.advancedSettings->dmaWakeUpOnTx = true;
   init.advancedSettings->dmaHaltOnError = true;
 
-  // Configure and enable EUSART0 for low-frequency (EM2) operation
+  // Configure EUSART0 for low-frequency (EM2) operation, enable it below
+  init.enable = eusartDisable;
   EUSART_UartInitLf(EUSART0, &init);
+
+  // The receive timeout can only be set while EUSART0 is disabled
+  EUSART0->CFG1 = (EUSART0->CFG1 & ~_EUSART_CFG1_RXTIMEOUT_MASK) | RX_TIMEOUT;
+  EUSART_Enable(EUSART0, eusartEnable);
+
+  // The receive timeout is the only EUSART0 interrupt, the LDMA moves the data
+  EUSART_IntClear(EUSART0, EUSART_IF_RXTO);
+  EUSART_IntEnable(EUSART0, EUSART_IF_RXTO);
+  NVIC_ClearPendingIRQ(EUSART0_RX_IRQn);
+  NVIC_EnableIRQ(EUSART0_RX_IRQn);
+}
+
+#if RX_CRC
+/**************************************************************************//**
+ * @brief
+ *    GPCRC initialization
+ *****************************************************************************/
+void initGPCRC(void)
+{
+  GPCRC_Init_TypeDef init = GPCRC_INIT_DEFAULT;
+
+  CMU_ClockEnable(cmuClock_GPCRC, true);
+
+  // CRC-32, start every message from 0xFFFF_FFFF, reset by reading DATA
+  init.initValue = 0xFFFFFFFF;
+  init.autoInit = true;
+  GPCRC_Init(GPCRC, &init);
+  GPCRC_Start(GPCRC);
 }
+#endif
 
 /**************************************************************************//**
  * @brief
@@ -158,17 +252,169 @@ void initLDMA(void)
   LDMA_Init_t ldmaInit = LDMA_INIT_DEFAULT;
   LDMA_Init(&ldmaInit);
 
-  // Source is buffer, destination is EUSART0_TXDATA, and length if BUFLEN
-  ldmaTXDescriptor = (LDMA_Descriptor_t)LDMA_DESCRIPTOR_SINGLE_M2P_BYTE(buffer, &(EUSART0->TXDATA), BUFLEN);
-
   // Transfer a byte on free space in the EUSART FIFO
   ldmaTXConfig = (LDMA_TransferCfg_t)LDMA_TRANSFER_CFG_PERIPHERAL(ldmaPeripheralSignal_EUSART0_TXFL);
 
-  // Source is EUSART0_RXDATA, destination is buffer, and length if BUFLEN
-  ldmaRXDescriptor = (LDMA_Descriptor_t)LDMA_DESCRIPTOR_SINGLE_P2M_BYTE(&(EUSART0->RXDATA), buffer, BUFLEN);
+#if RX_CRC
+  /*
+   * Each ring byte has a pair of descriptors.  The first waits for the
+   * receive FIFO and moves the byte to the ring, the second moves the same
+   * byte on to the GPCRC at once, so the CRC never lags by more than the
+   * byte being received.  Relative addresses do not work here, the two
+   * descriptors load different addresses into the channel, so each pair
+   * has its own.  The links are absolute, so LDMA_CH_LINK tells which
+   * descriptor the channel loads next, and the last pair links back to the
+   * first.  No descriptor raises an interrupt.
+   */
+  for (uint32_t i = 0; i < RING_SIZE; i++) {
+    LDMA_Descriptor_t *desc = &ldmaRXDescriptor[2 * i];
+
+    desc[0] = (LDMA_Descriptor_t)LDMA_DESCRIPTOR_LINKREL_P2M_BYTE(&(EUSART0->RXDATA), &ring[i], 1, 1);
+    desc[1] = (LDMA_Descriptor_t)LDMA_DESCRIPTOR_LINKREL_M2M_BYTE(&ring[i], &(GPCRC->INPUTDATABYTE), 1, 1);
+    desc[0].xfer.doneIfs = 0;
+    desc[1].xfer.doneIfs = 0;
+    desc[1].xfer.dstInc = ldmaCtrlDstIncNone;
+
+    desc[0].xfer.linkMode = ldmaLinkModeAbs;
+    desc[0].xfer.linkAddr = (uint32_t)&desc[1] >> 2;
+    desc[1].xfer.linkMode = ldmaLinkModeAbs;
+    desc[1].xfer.linkAddr = (uint32_t)&ldmaRXDescriptor[(2 * i + 2) % (2 * RING_SIZE)] >> 2;
+  }
+#else
+  /*
+   * Source is EUSART0_RXDATA, destination is the ring.  The descriptor
+   * links to itself, so the channel starts over at the beginning of the
+   * ring after the last byte and never stops.  It raises no interrupt,
+   * the receive timeout is what wakes the CPU.
+   */
+  ldmaRXDescriptor = (LDMA_Descriptor_t)LDMA_DESCRIPTOR_LINKREL_P2M_BYTE(&(EUSART0->RXDATA), ring, RING_SIZE, 0);
+  ldmaRXDescriptor.xfer.doneIfs = 0;
+#endif
 
   // Transfer a byte on receive FIFO level event
   ldmaRXConfig = (LDMA_TransferCfg_t)LDMA_TRANSFER_CFG_PERIPHERAL(ldmaPeripheralSignal_EUSART0_RXFL);
+
+  // Start the LDMA receive channel, it runs from here on
+#if RX_CRC
+  LDMA_StartTransfer(RX_LDMA_CHANNEL, &ldmaRXConfig, &ldmaRXDescriptor[0]);
+#else
+  LDMA_StartTransfer(RX_LDMA_CHANNEL, &ldmaRXConfig, &ldmaRXDescriptor);
+#endif
+}
+
+#if RX_CRC
+/**************************************************************************//**
+ * @brief
+ *    Ring offset the receive channel writes next, once the GPCRC has every
+ *    byte before it
+ *****************************************************************************/
+static uint32_t rxCrcEnd(void)
+{
+  uint32_t next;
+
+  /*
+   * An odd descriptor next means the channel sits in the ring descriptor
+   * of that pair, and every byte before it has been through the GPCRC.  An
+   * even one means the GPCRC descriptor of the last byte is still to run,
+   * which takes a few LDMA cycles in EM0.
+   */
+  do {
+    next = ((LDMA->CH[RX_LDMA_CHANNEL].LINK & _LDMA_CH_LINK_LINKADDR_MASK)
+            - (uint32_t)ldmaRXDescriptor) / sizeof(LDMA_Descriptor_t);
+  } while ((next & 1) == 0);
+
+  return next / 2;
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Write a word as 8 hex digits
+ *****************************************************************************/
+static void putHex(uint8_t *dst, uint32_t value)
+{
+  for (int i = 7; i >= 0; i--) {
+    dst[i] = "0123456789ABCDEF"[value & 0xF];
+    value >>= 4;
+  }
+}
+#endif
+
+/**************************************************************************//**
+ * @brief
+ *    Copy the oldest queued message out of the ring and echo it
+ *****************************************************************************/
+static void echoMessage(void)
+{
+  Message_t *msg = &msgQueue[msgTail];
+  uint32_t i;
+
+  for (i = 0; i < msg->length; i++) {
+    buffer[i] = ring[(msg->start + i) % RING_SIZE];
+  }
+
+#if RX_CRC
+  // Append the CRC-32 of the message, the ones complement of GPCRC_DATA
+  buffer[i++] = ' ';
+  putHex(&buffer[i], ~msg->crc);
+  i += 8;
+  buffer[i++] = '\r';
+  buffer[i++] = '\n';
+#endif
+
+  // Source is buffer, destination is EUSART0_TXDATA, and length is the message
+  ldmaTXDescriptor = (LDMA_Descriptor_t)LDMA_DESCRIPTOR_SINGLE_M2P_BYTE(buffer, &(EUSART0->TXDATA), i);
+
+  txBusy = true;
+  msgTail = (msgTail + 1) % MSG_QUEUE_LEN;
+
+  LDMA_StartTransfer(TX_LDMA_CHANNEL, &ldmaTXConfig, &ldmaTXDescriptor);
+}
+
+/**************************************************************************//**
+ * @brief EUSART receive IRQHandler
+ *****************************************************************************/
+void EUSART0_RX_IRQHandler(void)
+{
+  uint32_t end;
+  uint32_t next;
+
+  EUSART_IntClear(EUSART0, EUSART_IF_RXTO);
+
+#if RX_CRC
+  uint32_t crc;
+
+  // The CRC of the message is ready, reading it starts the next one
+  end = rxCrcEnd();
+  crc = GPCRC_DataRead(GPCRC);
+#else
+  // The LDMA has written everything up to its destination address
+  end = (LDMA->CH[RX_LDMA_CHANNEL].DST - (uint32_t)ring) % RING_SIZE;
+#endif
+
+  if (end == msgStart) {
+    return;
+  }
+
+#if RX_CRC
+  if (crc == CRC_RESIDUE) {
+    msgCrcOkCount++;
+  }
+#endif
+
+  next = (msgHead + 1) % MSG_QUEUE_LEN;
+  if (next == msgTail) {
+    msgDropCount++;
+  } else {
+    msgQueue[msgHead].start = msgStart;
+    msgQueue[msgHead].length = (end - msgStart + RING_SIZE) % RING_SIZE;
+#if RX_CRC
+    msgQueue[msgHead].crc = crc;
+#endif
+    msgHead = next;
+    msgCount++;
+  }
+
+  msgStart = end;
 }
 
 /**************************************************************************//**
@@ -178,17 +424,10 @@ void LDMA_IRQHandler()
 {
   uint32_t flags = LDMA_IntGet();
 
-  // Clear the transmit channel's done flag if set
+  // Clear the transmit channel's done flag if set, the echo is done
   if (flags & (1 << TX_LDMA_CHANNEL)) {
     LDMA_IntClear(1 << TX_LDMA_CHANNEL);
-  }
-
-  /*
-   * Clear the receive channel's done flag if set and change receive
-   * state to done.
-   */
-  if (flags & (1 << RX_LDMA_CHANNEL)) {
-    LDMA_IntClear(1 << RX_LDMA_CHANNEL);
+    txBusy = false;
   }
 
   // Stop in case there was an error
@@ -203,7 +442,7 @@ void LDMA_IRQHandler()
  *****************************************************************************/
 int main(void)
 {
-  uint32_t i;
+  CORE_DECLARE_IRQ_STATE;
 
   // Chip errata
   CHIP_Init();
@@ -248,24 +487,20 @@ int main(void)
   initCMU();
   initGPIO();
   initEUSART0();
+#if RX_CRC
+  initGPCRC();
+#endif
   initLDMA();
 
   while (1)
   {
-    // Zero out buffer
-    for (i = 0; i < BUFLEN; i++)
-      buffer[i] = 0;
-
-    // Start the LDMA receive channel
-    LDMA_StartTransfer(RX_LDMA_CHANNEL, &ldmaRXConfig, &ldmaRXDescriptor);
-
-    // Wait in EM2 while receiving data
-    EMU_EnterEM2(true);
-
-    // start the LDMA transmit channel
-    LDMA_StartTransfer(TX_LDMA_CHANNEL, &ldmaTXConfig, &ldmaTXDescriptor);
-
-    // Wait in EM2 while transmitting data
-    EMU_EnterEM2(true);
+    // Wait in EM2 until a message has arrived and the last echo is done
+    CORE_ENTER_CRITICAL();
+    if (txBusy || (msgTail == msgHead))
+      EMU_EnterEM2(true);
+    CORE_EXIT_CRITICAL();
+
+    if (!txBusy && (msgTail != msgHead))
+      echoMessage();
   }
 }
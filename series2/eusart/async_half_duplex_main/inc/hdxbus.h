@@ -0,0 +1,99 @@
+/***************************************************************************//**
+ * @file hdxbus.h
+ *
+ * @brief Queue of LDMA-driven transactions on a half-duplex UART bus.
+ * EUSART0 is the bus main of an RS-485 or single-wire bus: the LDMA sends
+ * each request, the TX complete interrupt turns the bus around and the LDMA
+ * receives the response, which a TIMER times out.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2021 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ******************************************************************************/
+
+#ifndef HDXBUS_H
+#define HDXBUS_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// LDMA channels for the request and the response
+#define HDX_TX_LDMA_CHANNEL   0
+#define HDX_RX_LDMA_CHANNEL   1
+
+// Bus pins. The driver enable output is high while the main drives the
+// bus, for the DE and /RE inputs of an RS-485 transceiver. On a single-wire
+// bus TX and RX are tied to the wire and the driver enable is left unused.
+#define HDX_TX_PORT           gpioPortC
+#define HDX_TX_PIN            1
+#define HDX_RX_PORT           gpioPortC
+#define HDX_RX_PIN            2
+#define HDX_DE_PORT           gpioPortC
+#define HDX_DE_PIN            3
+
+// Longest request and response, the most one LDMA descriptor can move
+#define HDX_MAX_LENGTH        2048
+
+// Transaction outcome
+typedef enum {
+  hdxStatusQueued,                    // Waiting or running
+  hdxStatusOk,                        // Whole response received
+  hdxStatusTimeout,                   // Response short or missing
+  hdxStatusError                      // Framing or parity error
+} HDX_Status_t;
+
+typedef struct HDX_Transfer HDX_Transfer_t;
+
+// Called from interrupt context once the transaction is over and the bus
+// is released. May submit further transactions, including this one.
+typedef void (*HDX_Callback_t)(HDX_Transfer_t *transfer);
+
+// Request and response exchange with one secondary
+struct HDX_Transfer {
+  const uint8_t *tx;                  // Request, sent whole
+  uint32_t txLength;                  // 1 to HDX_MAX_LENGTH bytes
+  uint8_t *rx;                        // Response buffer
+  uint32_t rxLength;                  // Expected bytes, 0 for no response
+  uint32_t timeoutUs;                 // From the request stop bit to the
+                                      // last response byte
+  HDX_Status_t status;                // Set before the callback
+  uint32_t rxCount;                   // Response bytes received
+  HDX_Callback_t callback;            // Completion callback or NULL
+  void *user;                         // For the callback
+  HDX_Transfer_t *next;               // Private, queue link
+};
+
+void HDX_Init(uint32_t baudrate);
+bool HDX_Submit(HDX_Transfer_t *transfer);
+bool HDX_IsIdle(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // HDXBUS_H
@@ -0,0 +1,385 @@
+/***************************************************************************//**
+ * @file hdxbus.c
+ *
+ * @brief Queue of LDMA-driven transactions on a half-duplex UART bus.
+ *
+ * A transaction takes three interrupts whatever its length:
+ *
+ *   LDMA TX done     the last request byte is in the FIFO, arm TXC
+ *   EUSART0 TXC      the stop bit is out: release the bus, enable the
+ *                    receiver, start the RX channel and the timeout
+ *   LDMA RX done     the response is in, or the TIMER overflow when not
+ *
+ * The receiver is off while the request goes out, so the echo of the
+ * request on a single-wire or RS-485 bus is never received.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2021 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ *******************************************************************************
+ * # Evaluation Quality
+ * This code has been minimally tested to ensure that it builds and is suitable
+ * as a demonstration for evaluation purposes only. This code will be maintained
+ * at the sole discretion of Silicon Labs.
+ ******************************************************************************/
+
+#include <stddef.h>
+
+#include "em_device.h"
+#include "em_cmu.h"
+#include "em_core.h"
+#include "em_eusart.h"
+#include "em_gpio.h"
+#include "em_ldma.h"
+#include "em_timer.h"
+
+#include "hdxbus.h"
+
+// TIMER timing out the responses, 32 bits on EFR32xG24 so even long
+// timeouts need no prescaler
+#define HDX_TIMER             TIMER0
+#define HDX_TIMER_CLOCK       cmuClock_TIMER0
+#define HDX_TIMER_IRQn        TIMER0_IRQn
+
+// Receive errors that fail a response
+#define HDX_RX_ERRORS         (EUSART_IF_FERR | EUSART_IF_PERR | EUSART_IF_RXOF)
+
+// Where the running transaction is
+typedef enum {
+  hdxIdle,
+  hdxRequest,                         // LDMA filling the TX FIFO
+  hdxDrain,                           // Waiting for TX complete
+  hdxResponse                         // Receiving, timeout running
+} HDX_Phase_t;
+
+static LDMA_Descriptor_t txDescriptor;
+static LDMA_Descriptor_t rxDescriptor;
+
+static LDMA_TransferCfg_t txConfig;
+static LDMA_TransferCfg_t rxConfig;
+
+// Transactions waiting, the head is the running one
+static HDX_Transfer_t *queueHead;
+static HDX_Transfer_t *queueTail;
+
+static volatile HDX_Phase_t phase;
+
+// TIMER ticks per microsecond and the largest timeout they allow
+static uint32_t ticksPerUs;
+static uint32_t maxTimeoutUs;
+
+/**************************************************************************//**
+ * @brief
+ *    Drive the bus and start sending the request at the head of the
+ *    queue. Called with interrupts masked or from an interrupt handler.
+ *****************************************************************************/
+static void startNext(void)
+{
+  HDX_Transfer_t *transfer = queueHead;
+
+  if (transfer == NULL) {
+    phase = hdxIdle;
+    return;
+  }
+
+  // Transmitter only. With TX auto-tristate the pin only drives the bus
+  // while a frame is shifted out.
+  EUSART_Enable(EUSART0, eusartEnableTx);
+  GPIO_PinOutSet(HDX_DE_PORT, HDX_DE_PIN);
+
+  phase = hdxRequest;
+
+  txDescriptor = (LDMA_Descriptor_t)
+    LDMA_DESCRIPTOR_SINGLE_M2P_BYTE(transfer->tx, &(EUSART0->TXDATA),
+                                    transfer->txLength);
+  LDMA_StartTransfer(HDX_TX_LDMA_CHANNEL, &txConfig, &txDescriptor);
+}
+
+/**************************************************************************//**
+ * @brief
+ *    End the running transaction, release the bus and start the next one
+ *****************************************************************************/
+static void finish(HDX_Status_t status, uint32_t rxCount)
+{
+  HDX_Transfer_t *transfer = queueHead;
+
+  EUSART_Enable(EUSART0, eusartDisable);
+
+  // Unlinked before the callback, which may submit it again
+  queueHead = transfer->next;
+  if (queueHead == NULL) {
+    queueTail = NULL;
+  }
+  transfer->rxCount = rxCount;
+  transfer->status = status;
+
+  phase = hdxIdle;
+  if (transfer->callback) {
+    transfer->callback(transfer);
+  }
+
+  if (phase == hdxIdle) {
+    startNext();
+  }
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Turn the bus around once the last request stop bit is out
+ *****************************************************************************/
+static void turnaround(void)
+{
+  HDX_Transfer_t *transfer = queueHead;
+
+  // Release the bus before anything else, the secondary may answer at once
+  GPIO_PinOutClear(HDX_DE_PORT, HDX_DE_PIN);
+
+  if (transfer->rxLength == 0) {
+    finish(hdxStatusOk, 0);
+    return;
+  }
+
+  // Drop whatever a late secondary left in the FIFO and its errors, then
+  // listen. The first byte takes a whole frame to arrive, so the LDMA and
+  // the timeout are started after the receiver without losing it.
+  while (EUSART_StatusGet(EUSART0) & EUSART_STATUS_RXFL) {
+    (void)EUSART0->RXDATA;
+  }
+  EUSART_IntClear(EUSART0, HDX_RX_ERRORS);
+  EUSART_Enable(EUSART0, eusartEnableRx);
+
+  phase = hdxResponse;
+
+  rxDescriptor = (LDMA_Descriptor_t)
+    LDMA_DESCRIPTOR_SINGLE_P2M_BYTE(&(EUSART0->RXDATA), transfer->rx,
+                                    transfer->rxLength);
+  LDMA_StartTransfer(HDX_RX_LDMA_CHANNEL, &rxConfig, &rxDescriptor);
+
+  TIMER_TopSet(HDX_TIMER, transfer->timeoutUs * ticksPerUs);
+  TIMER_CounterSet(HDX_TIMER, 0);
+  TIMER_IntClear(HDX_TIMER, TIMER_IF_OF);
+  TIMER_Enable(HDX_TIMER, true);
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Initialize EUSART0, its pins, the LDMA, the timeout TIMER and the
+ *    transaction queue
+ *
+ * @param[in] baudrate
+ *    Bus bit rate, 8 data bits, no parity and 1 stop bit.
+ *****************************************************************************/
+void HDX_Init(uint32_t baudrate)
+{
+  CMU_ClockEnable(cmuClock_GPIO, true);
+  CMU_ClockEnable(cmuClock_EUSART0, true);
+  CMU_ClockEnable(HDX_TIMER_CLOCK, true);
+
+  /*
+   * The TX pin is an open output when the transmitter is idle, so the
+   * pull-up on RX holds a single-wire bus high. The driver enable starts
+   * low, listening, which is also where an RS-485 transceiver fails safe.
+   */
+  GPIO_PinModeSet(HDX_TX_PORT, HDX_TX_PIN, gpioModePushPull, 1);
+  GPIO_PinModeSet(HDX_RX_PORT, HDX_RX_PIN, gpioModeInputPull, 1);
+  GPIO_PinModeSet(HDX_DE_PORT, HDX_DE_PIN, gpioModePushPull, 0);
+
+  GPIO->EUSARTROUTE[0].TXROUTE = (HDX_TX_PORT << _GPIO_EUSART_TXROUTE_PORT_SHIFT)
+      | (HDX_TX_PIN << _GPIO_EUSART_TXROUTE_PIN_SHIFT);
+  GPIO->EUSARTROUTE[0].RXROUTE = (HDX_RX_PORT << _GPIO_EUSART_RXROUTE_PORT_SHIFT)
+      | (HDX_RX_PIN << _GPIO_EUSART_RXROUTE_PIN_SHIFT);
+  GPIO->EUSARTROUTE[0].ROUTEEN = GPIO_EUSART_ROUTEEN_RXPEN
+                                 | GPIO_EUSART_ROUTEEN_TXPEN;
+
+  // High-frequency UART, both directions off until the first transaction
+  EUSART_UartInit_TypeDef init = EUSART_UART_INIT_DEFAULT_HF;
+  EUSART_AdvancedInit_TypeDef advancedInit = EUSART_ADVANCED_INIT_DEFAULT;
+
+  advancedInit.txAutoTristate = true;
+  init.baudrate = baudrate;
+  init.advancedSettings = &advancedInit;
+  init.enable = eusartDisable;
+  EUSART_UartInitHf(EUSART0, &init);
+
+  // TX complete ends the request, the interrupt is armed per transaction
+  EUSART_IntClear(EUSART0, EUSART_IF_TXC);
+  NVIC_ClearPendingIRQ(EUSART0_TX_IRQn);
+  NVIC_EnableIRQ(EUSART0_TX_IRQn);
+
+  // One-shot TIMER counting the timeout up to TOP
+  TIMER_Init_TypeDef timerInit = TIMER_INIT_DEFAULT;
+
+  timerInit.enable = false;
+  timerInit.oneShot = true;
+  timerInit.prescale = timerPrescale1;
+  TIMER_Init(HDX_TIMER, &timerInit);
+  TIMER_IntEnable(HDX_TIMER, TIMER_IEN_OF);
+  NVIC_ClearPendingIRQ(HDX_TIMER_IRQn);
+  NVIC_EnableIRQ(HDX_TIMER_IRQn);
+
+  ticksPerUs = CMU_ClockFreqGet(HDX_TIMER_CLOCK) / 1000000;
+  maxTimeoutUs = TIMER_MaxCount(HDX_TIMER) / ticksPerUs;
+
+  LDMA_Init_t ldmaInit = LDMA_INIT_DEFAULT;
+  LDMA_Init(&ldmaInit);
+
+  // A byte on free space in the TX FIFO, a byte on data in the RX FIFO
+  txConfig = (LDMA_TransferCfg_t)LDMA_TRANSFER_CFG_PERIPHERAL(ldmaPeripheralSignal_EUSART0_TXFL);
+  rxConfig = (LDMA_TransferCfg_t)LDMA_TRANSFER_CFG_PERIPHERAL(ldmaPeripheralSignal_EUSART0_RXFL);
+
+  queueHead = NULL;
+  queueTail = NULL;
+  phase = hdxIdle;
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Queue a transaction. It starts right away if the bus is idle, else
+ *    it runs after the transactions already queued.
+ *
+ * @param[in] transfer
+ *    Transaction, must stay valid until its callback has been called.
+ *
+ * @return
+ *    False if the request is empty, a length is over HDX_MAX_LENGTH or
+ *    the timeout is 0 or over what the TIMER can count.
+ *****************************************************************************/
+bool HDX_Submit(HDX_Transfer_t *transfer)
+{
+  CORE_DECLARE_IRQ_STATE;
+
+  if ((transfer->txLength == 0) || (transfer->txLength > HDX_MAX_LENGTH)
+      || (transfer->rxLength > HDX_MAX_LENGTH)
+      || ((transfer->rxLength > 0)
+          && ((transfer->timeoutUs == 0) || (transfer->timeoutUs > maxTimeoutUs)))) {
+    return false;
+  }
+
+  transfer->status = hdxStatusQueued;
+  transfer->rxCount = 0;
+  transfer->next = NULL;
+
+  CORE_ENTER_CRITICAL();
+  if (queueTail) {
+    queueTail->next = transfer;
+  } else {
+    queueHead = transfer;
+  }
+  queueTail = transfer;
+
+  if (phase == hdxIdle) {
+    startNext();
+  }
+  CORE_EXIT_CRITICAL();
+
+  return true;
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Check whether all queued transactions have completed
+ *****************************************************************************/
+bool HDX_IsIdle(void)
+{
+  return phase == hdxIdle;
+}
+
+/**************************************************************************//**
+ * @brief LDMA IRQHandler
+ *****************************************************************************/
+void LDMA_IRQHandler(void)
+{
+  uint32_t flags = LDMA_IntGet();
+
+  LDMA_IntClear(flags);
+
+  // Stop in case there was an error
+  if (flags & LDMA_IF_ERROR) {
+    __BKPT(0);
+  }
+
+  /*
+   * The last request byte is in the FIFO, up to a FIFO full and the shift
+   * register are still to go out. TXC may be left set from an earlier
+   * FIFO underrun, so it is cleared before the interrupt is enabled.
+   */
+  if ((flags & (1 << HDX_TX_LDMA_CHANNEL)) && (phase == hdxRequest)) {
+    phase = hdxDrain;
+    EUSART_IntClear(EUSART0, EUSART_IF_TXC);
+    EUSART_IntEnable(EUSART0, EUSART_IEN_TXC);
+  }
+
+  if ((flags & (1 << HDX_RX_LDMA_CHANNEL)) && (phase == hdxResponse)) {
+    TIMER_Enable(HDX_TIMER, false);
+    finish((EUSART_IntGet(EUSART0) & HDX_RX_ERRORS)
+           ? hdxStatusError : hdxStatusOk,
+           queueHead->rxLength);
+  }
+}
+
+/**************************************************************************//**
+ * @brief
+ *    The EUSART0 transmit interrupt turns the bus around on TX complete
+ *****************************************************************************/
+void EUSART0_TX_IRQHandler(void)
+{
+  EUSART_IntDisable(EUSART0, EUSART_IEN_TXC);
+  EUSART_IntClear(EUSART0, EUSART_IF_TXC);
+
+  if (phase == hdxDrain) {
+    turnaround();
+  }
+}
+
+/**************************************************************************//**
+ * @brief
+ *    The TIMER overflow ends a response that did not arrive in time
+ *****************************************************************************/
+void TIMER0_IRQHandler(void)
+{
+  uint32_t received;
+
+  TIMER_IntClear(HDX_TIMER, TIMER_IF_OF);
+
+  if (phase != hdxResponse) {
+    return;
+  }
+
+  /*
+   * The response may have completed while this interrupt was pending.
+   * Stopping the channel also masks its done interrupt, so the response
+   * is finished here either way.
+   */
+  LDMA_StopTransfer(HDX_RX_LDMA_CHANNEL);
+  LDMA_IntClear(1 << HDX_RX_LDMA_CHANNEL);
+  received = queueHead->rxLength
+             - LDMA_TransferRemainingCount(HDX_RX_LDMA_CHANNEL);
+
+  if (received < queueHead->rxLength) {
+    finish(hdxStatusTimeout, received);
+  } else {
+    finish((EUSART_IntGet(EUSART0) & HDX_RX_ERRORS)
+           ? hdxStatusError : hdxStatusOk, received);
+  }
+}
@@ -0,0 +1,342 @@
+/***************************************************************************//**
+ * @file main.c
+ *
+ * @brief This project demonstrates a DMA-driven bus main on a half-duplex
+ * UART bus. The main loop polls eight secondary addresses each round through
+ * a queue of request and response transactions; simulated secondaries on
+ * EUSART1 answer four of them and the others time out.
+ *
+ * The pins used in this example are defined below and are described in the
+ * accompanying readme.txt file.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2021 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ *******************************************************************************
+ * # Evaluation Quality
+ * This code has been minimally tested to ensure that it builds and is suitable
+ * as a demonstration for evaluation purposes only. This code will be maintained
+ * at the sole discretion of Silicon Labs.
+ ******************************************************************************/
+
+#include <stddef.h>
+
+#include "em_device.h"
+#include "em_chip.h"
+#include "em_cmu.h"
+#include "em_core.h"
+#include "em_emu.h"
+#include "em_eusart.h"
+#include "em_gpio.h"
+#include "em_timer.h"
+
+#include "bsp.h"
+#include "mx25flash_spi.h"
+#include "hdxbus.h"
+
+// Bus bit rate
+#define BAUDRATE          115200
+
+// Secondary addresses polled each round, 1 to POLL_COUNT
+#define POLL_COUNT        8
+
+// Addresses 1 to SECONDARY_COUNT are answered by the simulated secondaries
+#define SECONDARY_COUNT       4
+
+// Request: address, register, CRC-8
+#define REQUEST_LEN       3
+
+// Response: address, register, value low and high byte, CRC-8
+#define RESPONSE_LEN      5
+
+// Register polled by the bus main, the secondary's read count
+#define REG_READ_COUNT    0
+
+// Time the simulated secondaries take from the request to their response
+#define SECONDARY_TURNAROUND_US   100
+
+/*
+ * Response timeout from the end of the request: the secondary turnaround and
+ * the five response frames of 10 bits at 115200 baud (434 us), with some
+ * margin for a secondary that is slow to answer.
+ */
+#define RESPONSE_TIMEOUT_US   1000
+
+// Simulated secondary pins, on the same bus as EUSART0
+#define SECONDARY_TX_PORT     gpioPortA
+#define SECONDARY_TX_PIN      5
+#define SECONDARY_RX_PORT     gpioPortA
+#define SECONDARY_RX_PIN      6
+
+// Bus main transactions and buffers, one per address
+static HDX_Transfer_t transfers[POLL_COUNT];
+static uint8_t requests[POLL_COUNT][REQUEST_LEN];
+static uint8_t responses[POLL_COUNT][RESPONSE_LEN];
+
+// Results for each address, index 0 is address 1
+volatile uint32_t okCount[POLL_COUNT];
+volatile uint32_t timeoutCount[POLL_COUNT];
+volatile uint32_t errorCount[POLL_COUNT];
+volatile uint16_t lastValue[POLL_COUNT];
+
+// Completed polling rounds
+volatile uint32_t rounds;
+
+// Simulated secondary state
+static uint8_t secondaryRequest[REQUEST_LEN];
+static uint32_t secondaryReceived;
+static uint8_t secondaryResponse[RESPONSE_LEN];
+static uint16_t secondaryReads[SECONDARY_COUNT];
+
+/**************************************************************************//**
+ * @brief
+ *    CRC-8, polynomial x^8 + x^2 + x + 1, initial value 0
+ *****************************************************************************/
+static uint8_t crc8(const uint8_t *data, uint32_t length)
+{
+  uint8_t crc = 0;
+  uint32_t i, bit;
+
+  for (i = 0; i < length; i++) {
+    crc ^= data[i];
+    for (bit = 0; bit < 8; bit++) {
+      crc = (crc & 0x80) ? (uint8_t)((crc << 1) ^ 0x07) : (uint8_t)(crc << 1);
+    }
+  }
+  return crc;
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Simulated secondary initialization: EUSART1 receiving by interrupt and
+ *    TIMER1 timing the turnaround before each response
+ *****************************************************************************/
+void initSecondary(void)
+{
+  CMU_ClockEnable(cmuClock_EUSART1, true);
+  CMU_ClockEnable(cmuClock_TIMER1, true);
+
+  GPIO_PinModeSet(SECONDARY_TX_PORT, SECONDARY_TX_PIN, gpioModePushPull, 1);
+  GPIO_PinModeSet(SECONDARY_RX_PORT, SECONDARY_RX_PIN, gpioModeInput, 0);
+
+  GPIO->EUSARTROUTE[1].TXROUTE = (SECONDARY_TX_PORT << _GPIO_EUSART_TXROUTE_PORT_SHIFT)
+      | (SECONDARY_TX_PIN << _GPIO_EUSART_TXROUTE_PIN_SHIFT);
+  GPIO->EUSARTROUTE[1].RXROUTE = (SECONDARY_RX_PORT << _GPIO_EUSART_RXROUTE_PORT_SHIFT)
+      | (SECONDARY_RX_PIN << _GPIO_EUSART_RXROUTE_PIN_SHIFT);
+  GPIO->EUSARTROUTE[1].ROUTEEN = GPIO_EUSART_ROUTEEN_RXPEN
+                                 | GPIO_EUSART_ROUTEEN_TXPEN;
+
+  // Listening, the pin only drives the bus while a response goes out
+  EUSART_UartInit_TypeDef init = EUSART_UART_INIT_DEFAULT_HF;
+  EUSART_AdvancedInit_TypeDef advancedInit = EUSART_ADVANCED_INIT_DEFAULT;
+
+  advancedInit.txAutoTristate = true;
+  init.baudrate = BAUDRATE;
+  init.advancedSettings = &advancedInit;
+  init.enable = eusartEnableRx;
+  EUSART_UartInitHf(EUSART1, &init);
+
+  EUSART_IntClear(EUSART1, EUSART_IF_RXFL | EUSART_IF_TXC);
+  EUSART_IntEnable(EUSART1, EUSART_IEN_RXFL);
+  NVIC_ClearPendingIRQ(EUSART1_RX_IRQn);
+  NVIC_EnableIRQ(EUSART1_RX_IRQn);
+  NVIC_ClearPendingIRQ(EUSART1_TX_IRQn);
+  NVIC_EnableIRQ(EUSART1_TX_IRQn);
+
+  // One-shot turnaround delay
+  TIMER_Init_TypeDef timerInit = TIMER_INIT_DEFAULT;
+
+  timerInit.enable = false;
+  timerInit.oneShot = true;
+  TIMER_Init(TIMER1, &timerInit);
+  TIMER_TopSet(TIMER1, (CMU_ClockFreqGet(cmuClock_TIMER1) / 1000000)
+               * SECONDARY_TURNAROUND_US);
+  TIMER_IntEnable(TIMER1, TIMER_IEN_OF);
+  NVIC_ClearPendingIRQ(TIMER1_IRQn);
+  NVIC_EnableIRQ(TIMER1_IRQn);
+}
+
+/**************************************************************************//**
+ * @brief
+ *    The EUSART1 receive interrupt collects requests for the simulated
+ *    secondaries. Requests are framed by their CRC: a window of REQUEST_LEN
+ *    bytes slides along the received bytes until it checks.
+ *****************************************************************************/
+void EUSART1_RX_IRQHandler(void)
+{
+  uint8_t address, reg;
+  uint16_t value;
+
+  secondaryRequest[secondaryReceived++] = (uint8_t)EUSART1->RXDATA;
+  EUSART_IntClear(EUSART1, EUSART_IF_RXFL);
+
+  if (secondaryReceived < REQUEST_LEN) {
+    return;
+  }
+
+  if (crc8(secondaryRequest, REQUEST_LEN - 1)
+      != secondaryRequest[REQUEST_LEN - 1]) {
+    secondaryRequest[0] = secondaryRequest[1];
+    secondaryRequest[1] = secondaryRequest[2];
+    secondaryReceived = REQUEST_LEN - 1;
+    return;
+  }
+  secondaryReceived = 0;
+
+  address = secondaryRequest[0];
+  reg = secondaryRequest[1];
+  if ((address < 1) || (address > SECONDARY_COUNT)) {
+    return;
+  }
+
+  value = (reg == REG_READ_COUNT) ? ++secondaryReads[address - 1]
+                                  : (uint16_t)(address * 1000);
+
+  secondaryResponse[0] = address;
+  secondaryResponse[1] = reg;
+  secondaryResponse[2] = (uint8_t)value;
+  secondaryResponse[3] = (uint8_t)(value >> 8);
+  secondaryResponse[4] = crc8(secondaryResponse, RESPONSE_LEN - 1);
+
+  // Answer after the turnaround, as a device would
+  TIMER_CounterSet(TIMER1, 0);
+  TIMER_Enable(TIMER1, true);
+}
+
+/**************************************************************************//**
+ * @brief
+ *    TIMER1 overflow ends the secondary turnaround and sends the response
+ *****************************************************************************/
+void TIMER1_IRQHandler(void)
+{
+  uint32_t i;
+
+  TIMER_IntClear(TIMER1, TIMER_IF_OF);
+
+  // Transmitter only, so the secondary does not receive its own response
+  EUSART_Enable(EUSART1, eusartEnableTx);
+  for (i = 0; i < RESPONSE_LEN; i++) {
+    EUSART_Tx(EUSART1, secondaryResponse[i]);
+  }
+
+  EUSART_IntClear(EUSART1, EUSART_IF_TXC);
+  EUSART_IntEnable(EUSART1, EUSART_IEN_TXC);
+}
+
+/**************************************************************************//**
+ * @brief
+ *    The EUSART1 transmit interrupt goes back to listening once the
+ *    response is out
+ *****************************************************************************/
+void EUSART1_TX_IRQHandler(void)
+{
+  EUSART_IntDisable(EUSART1, EUSART_IEN_TXC);
+  EUSART_IntClear(EUSART1, EUSART_IF_TXC);
+
+  EUSART_Enable(EUSART1, eusartEnableRx);
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Transaction callback, checks the response and counts the outcome for
+ *    the address passed in the user field
+ *****************************************************************************/
+static void transferDone(HDX_Transfer_t *transfer)
+{
+  uint32_t index = (uint32_t)(uintptr_t)transfer->user;
+  const uint8_t *response = transfer->rx;
+
+  if (transfer->status == hdxStatusTimeout) {
+    timeoutCount[index]++;
+  } else if ((transfer->status == hdxStatusOk)
+             && (response[0] == requests[index][0])
+             && (crc8(response, RESPONSE_LEN - 1) == response[RESPONSE_LEN - 1])) {
+    lastValue[index] = (uint16_t)(response[2] | (response[3] << 8));
+    okCount[index]++;
+  } else {
+    errorCount[index]++;
+  }
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Main function
+ *****************************************************************************/
+int main(void)
+{
+  uint32_t i;
+  CORE_DECLARE_IRQ_STATE;
+
+  // Chip errata
+  CHIP_Init();
+
+  // Initialize and power-down MX25 SPI flash
+  FlashStatus status;
+  MX25_init();
+  MX25_RSTEN();
+  MX25_RST(&status);
+  MX25_DP();
+  MX25_deinit();
+
+  // Initialize the bus main and the simulated secondaries
+  HDX_Init(BAUDRATE);
+  initSecondary();
+
+  // Requests never change, so each transaction is set up once
+  for (i = 0; i < POLL_COUNT; i++) {
+    requests[i][0] = (uint8_t)(i + 1);
+    requests[i][1] = REG_READ_COUNT;
+    requests[i][2] = crc8(requests[i], REQUEST_LEN - 1);
+
+    transfers[i].tx = requests[i];
+    transfers[i].txLength = REQUEST_LEN;
+    transfers[i].rx = responses[i];
+    transfers[i].rxLength = RESPONSE_LEN;
+    transfers[i].timeoutUs = RESPONSE_TIMEOUT_US;
+    transfers[i].callback = transferDone;
+    transfers[i].user = (void *)(uintptr_t)i;
+  }
+
+  while (1)
+  {
+    /*
+     * Queue a whole round.  The transactions run one after the other
+     * without the main loop, three interrupts each.
+     */
+    for (i = 0; i < POLL_COUNT; i++) {
+      HDX_Submit(&transfers[i]);
+    }
+
+    // Wait in EM1 until all transactions are done
+    while (!HDX_IsIdle())
+    {
+      CORE_ENTER_CRITICAL();
+      if (!HDX_IsIdle())
+        EMU_EnterEM1();
+      CORE_EXIT_CRITICAL();
+    }
+
+    rounds++;
+  }
+}
@@ -0,0 +1,99 @@
+/***************************************************************************//**
+ * @file spiqueue.h
+ *
+ * @brief Queue of LDMA-driven SPI transactions on EUSART1 in main mode.
+ * Each transaction names a device with its own chip select, bit rate and
+ * clock mode. Queued transactions with the same bit rate and clock mode are
+ * chained into one LDMA descriptor list, so they run back-to-back without
+ * the CPU.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2021 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ******************************************************************************/
+
+#ifndef SPIQUEUE_H
+#define SPIQUEUE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "em_eusart.h"
+#include "em_gpio.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// LDMA channels for receive and transmit servicing
+#define SPIQ_RX_LDMA_CHANNEL  0
+#define SPIQ_TX_LDMA_CHANNEL  1
+
+// Size of each channel's descriptor pool. A transaction of n bytes takes
+// 4 + ceil(n / 2048) receive descriptors. SPIQ_Submit() rejects anything
+// bigger than the whole pool, a transaction that does not fit in what is
+// left of a chain simply starts the next one.
+#ifndef SPIQ_MAX_DESCRIPTORS
+#define SPIQ_MAX_DESCRIPTORS  32
+#endif
+
+// Byte transmitted when a transaction has no transmit buffer
+#define SPIQ_FILL_BYTE        0xFF
+
+// Device on the bus
+typedef struct {
+  GPIO_Port_TypeDef csPort;           // Chip select port
+  uint8_t csPin;                      // Chip select pin, active low
+  uint32_t bitRate;                   // Shift clock in Hz
+  EUSART_ClockMode_TypeDef clockMode; // SPI mode 0 to 3
+  uint32_t csSetupUs;                 // Delay from CS assert to first clock
+} SPIQ_Device_t;
+
+typedef struct SPIQ_Transfer SPIQ_Transfer_t;
+
+// Called from the LDMA interrupt once the last byte has been received and
+// chip select is de-asserted. May submit further transactions.
+typedef void (*SPIQ_Callback_t)(SPIQ_Transfer_t *transfer);
+
+// Full-duplex transaction, CS is asserted for its whole length
+struct SPIQ_Transfer {
+  const SPIQ_Device_t *device;        // Device to talk to
+  const uint8_t *tx;                  // Data to send, NULL sends SPIQ_FILL_BYTE
+  uint8_t *rx;                        // Received data, NULL to discard
+  uint32_t length;                    // Number of bytes, any size
+  SPIQ_Callback_t callback;           // Completion callback or NULL
+  void *user;                         // For the callback
+  SPIQ_Transfer_t *next;              // Private, queue link
+};
+
+void SPIQ_Init(void);
+void SPIQ_DeviceInit(const SPIQ_Device_t *device);
+bool SPIQ_Submit(SPIQ_Transfer_t *transfer);
+bool SPIQ_IsIdle(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SPIQUEUE_H
@@ -2,9 +2,9 @@
  * @file main.c
  *
  * @brief This project demonstrates DMA-driven use of the EUSART in synchronous
- * (SPI) main mode. The main loop starts the LDMA channels, which transmit the
- * specified number of bytes and receive the byte that is shifted in with each
- * outgoing one.
+ * (SPI) main mode. The main loop queues transactions for three devices with
+ * their own chip selects and clock settings, which the LDMA then runs
+ * back-to-back, transmitting and receiving buffers of any size.
  *
  * The pins used in this example are defined below and are described in the
  * accompanying readme.txt file.
@@ -45,46 +45,67 @@
 #include "em_device.h"
 #include "em_chip.h"
 #include "em_cmu.h"
+#include "em_core.h"
 #include "em_emu.h"
-#include "em_eusart.h"
 #include "em_gpio.h"
-#include "em_ldma.h"
 
 #include "bsp.h"
+#include "spiqueue.h"
 
-// SPI ports and pins
-#define EUS1MOSI_PORT   gpioPortC
-#define EUS1MOSI_PIN    1
-#define EUS1MISO_PORT   gpioPortC
-#define EUS1MISO_PIN    2
-#define EUS1SCLK_PORT   gpioPortC
-#define EUS1SCLK_PIN    3
-#define EUS1CS_PORT     gpioPortC
-#define EUS1CS_PIN      0
+// Chip selects, PC0 is the one wired to the spi_secondary_dma board
+#define SECONDARY_CS_PORT gpioPortC
+#define SECONDARY_CS_PIN  0
+#define ADC_CS_PORT       gpioPortC
+#define ADC_CS_PIN        4
+#define DISPLAY_CS_PORT   gpioPortC
+#define DISPLAY_CS_PIN    5
 
-// LDMA channels for receive and transmit servicing
-#define RX_LDMA_CHANNEL 0
-#define TX_LDMA_CHANNEL 1
-
-// LDMA descriptor and transfer configuration structures for TX channel
-LDMA_Descriptor_t ldmaTXDescriptor;
-LDMA_TransferCfg_t ldmaTXConfig;
-
-// LDMA descriptor and transfer configuration structures for RX channel
-LDMA_Descriptor_t ldmaRXDescriptor;
-LDMA_TransferCfg_t ldmaRXConfig;
-
-// Size of the data buffers
+// Size of the data buffers for the secondary board
 #define BUFLEN  10
 
+// Bytes per ADC conversion (command and result)
+#define ADC_LEN 3
+
+// Frame of a 240 x 160 pixel, 1 bit per pixel display. Larger than one
+// LDMA descriptor can move, so it is split into a chain of them.
+#define FRAME_LEN (240 * 160 / 8)
+
+/*
+ * The secondary board needs about 42 microseconds after the chip select
+ * falling edge to arm its own DMA. The ADC shares its clock settings, so
+ * both go out in one chain, the display runs faster and gets a second one.
+ */
+static const SPIQ_Device_t secondary = {
+  SECONDARY_CS_PORT, SECONDARY_CS_PIN, 1000000, eusartClockMode0, 50
+};
+static const SPIQ_Device_t adc = {
+  ADC_CS_PORT, ADC_CS_PIN, 1000000, eusartClockMode0, 0
+};
+static const SPIQ_Device_t display = {
+  DISPLAY_CS_PORT, DISPLAY_CS_PIN, 4000000, eusartClockMode0, 0
+};
+
 // Outgoing data
 uint8_t outbuf[BUFLEN];
 
 // Incoming data
 uint8_t inbuf[BUFLEN];
 
-// Data reception complete
-bool rx_done;
+// ADC conversion command and result
+uint8_t adcCommand[ADC_LEN] = { 0x01, 0x80, 0x00 };
+uint8_t adcResult[ADC_LEN];
+
+// Display frame, transmit only
+uint8_t frame[FRAME_LEN];
+
+static SPIQ_Transfer_t secondaryTransfer;
+static SPIQ_Transfer_t adcTransfer;
+static SPIQ_Transfer_t displayTransfer;
+
+// Completed transactions, passed in the user field of each transaction
+volatile uint32_t secondaryCount;
+volatile uint32_t adcCount;
+volatile uint32_t frameCount;
 
 /**************************************************************************//**
  * @brief
@@ -94,18 +115,6 @@ void initGPIO(void)
 {
   CMU_ClockEnable(cmuClock_GPIO, true);
 
-  // Configure MOSI (TX) pin as an output
-  GPIO_PinModeSet(EUS1MOSI_PORT, EUS1MOSI_PIN, gpioModePushPull, 0);
-
-  // Configure MISO (RX) pin as an input
-  GPIO_PinModeSet(EUS1MISO_PORT, EUS1MISO_PIN, gpioModeInput, 0);
-
-  // Configure SCLK pin as an output low (CPOL = 0)
-  GPIO_PinModeSet(EUS1SCLK_PORT, EUS1SCLK_PIN, gpioModePushPull, 0);
-
-  // Configure CS pin as an output initially high
-  GPIO_PinModeSet(EUS1CS_PORT, EUS1CS_PIN, gpioModePushPull, 1);
-
   // Configure button 0 pin as an input
   GPIO_PinModeSet(BSP_GPIO_PB0_PORT, BSP_GPIO_PB0_PIN, gpioModeInputPull, 1);
 
@@ -124,67 +133,28 @@ void initGPIO(void)
 
 /**************************************************************************//**
  * @brief
- *    EUSART1 initialization
+ *    Transaction callback, counts completions for each device
  *****************************************************************************/
-void initEUSART1(void)
+static void transferDone(SPIQ_Transfer_t *transfer)
 {
-  CMU_ClockEnable(cmuClock_EUSART1, true);
-
-  // SPI advanced configuration (part of the initializer)
-  EUSART_SpiAdvancedInit_TypeDef adv = EUSART_SPI_ADVANCED_INIT_DEFAULT;
-
-  adv.msbFirst = true;        // SPI standard MSB first
-  adv.autoInterFrameTime = 7; // 7 bit times of delay between frames
-                              // to accommodate non-DMA secondaries
-
-  // Default asynchronous initializer (main/master mode and 8-bit data)
-  EUSART_SpiInit_TypeDef init = EUSART_SPI_MASTER_INIT_DEFAULT_HF;
-
-  init.bitRate = 1000000;         // 1 MHz shift clock
-  init.advancedSettings = &adv;   // Advanced settings structure
-
-  /*
-   * Route EUSART1 MOSI, MISO, and SCLK to the specified pins.  CS is
-   * not controlled by EUSART1 so there is no write to the corresponding
-   * EUSARTROUTE register to do this.
-   */
-  GPIO->EUSARTROUTE[1].TXROUTE = (EUS1MOSI_PORT << _GPIO_EUSART_TXROUTE_PORT_SHIFT)
-      | (EUS1MOSI_PIN << _GPIO_EUSART_TXROUTE_PIN_SHIFT);
-  GPIO->EUSARTROUTE[1].RXROUTE = (EUS1MISO_PORT << _GPIO_EUSART_RXROUTE_PORT_SHIFT)
-      | (EUS1MISO_PIN << _GPIO_EUSART_RXROUTE_PIN_SHIFT);
-  GPIO->EUSARTROUTE[1].SCLKROUTE = (EUS1SCLK_PORT << _GPIO_EUSART_SCLKROUTE_PORT_SHIFT)
-      | (EUS1SCLK_PIN << _GPIO_EUSART_SCLKROUTE_PIN_SHIFT);
-
-  // Enable EUSART interface pins
-  GPIO->EUSARTROUTE[1].ROUTEEN = GPIO_EUSART_ROUTEEN_RXPEN |    // MISO
-                                 GPIO_EUSART_ROUTEEN_TXPEN |    // MOSI
-                                 GPIO_EUSART_ROUTEEN_SCLKPEN;
-
-  // Configure and enable EUSART1
-  EUSART_SpiInit(EUSART1, &init);
+  (*(volatile uint32_t *)transfer->user)++;
 }
 
 /**************************************************************************//**
  * @brief
- *    LDMA initialization
+ *    Fill in a transaction
  *****************************************************************************/
-void initLDMA(void)
+static void setupTransfer(SPIQ_Transfer_t *transfer,
+                          const SPIQ_Device_t *device,
+                          const uint8_t *tx, uint8_t *rx, uint32_t length,
+                          volatile uint32_t *count)
 {
-  // First, initialize the LDMA unit itself
-  LDMA_Init_t ldmaInit = LDMA_INIT_DEFAULT;
-  LDMA_Init(&ldmaInit);
-
-  // Source is outbuf, destination is EUSART1_TXDATA, and length if BUFLEN
-  ldmaTXDescriptor = (LDMA_Descriptor_t)LDMA_DESCRIPTOR_SINGLE_M2P_BYTE(outbuf, &(EUSART1->TXDATA), BUFLEN);
-
-  // Transfer a byte on free space in the EUSART FIFO
-  ldmaTXConfig = (LDMA_TransferCfg_t)LDMA_TRANSFER_CFG_PERIPHERAL(ldmaPeripheralSignal_EUSART1_TXFL);
-
-  // Source is EUSART1_RXDATA, destination is inbuf, and length if BUFLEN
-  ldmaRXDescriptor = (LDMA_Descriptor_t)LDMA_DESCRIPTOR_SINGLE_P2M_BYTE(&(EUSART1->RXDATA), inbuf, BUFLEN);
-
-  // Transfer a byte on receive FIFO level event
-  ldmaRXConfig = (LDMA_TransferCfg_t)LDMA_TRANSFER_CFG_PERIPHERAL(ldmaPeripheralSignal_EUSART1_RXFL);
+  transfer->device = device;
+  transfer->tx = tx;
+  transfer->rx = rx;
+  transfer->length = length;
+  transfer->callback = transferDone;
+  transfer->user = (void *)count;
 }
 
 /**************************************************************************//**
@@ -203,32 +173,6 @@ void GPIO_EVEN_IRQHandler(void)
   GPIO_IntClear(1 << BSP_GPIO_PB0_PIN);
 }
 
-/**************************************************************************//**
- * @brief LDMA IRQHandler
- *****************************************************************************/
-void LDMA_IRQHandler()
-{
-  uint32_t flags = LDMA_IntGet();
-
-  // Clear the transmit channel's done flag if set
-  if (flags & (1 << TX_LDMA_CHANNEL))
-    LDMA_IntClear(1 << TX_LDMA_CHANNEL);
-
-  /*
-   * Clear the receive channel's done flag if set and change receive
-   * state to done.
-   */
-  if (flags & (1 << RX_LDMA_CHANNEL))
-  {
-    LDMA_IntClear(1 << RX_LDMA_CHANNEL);
-    rx_done = true;
-  }
-
-  // Stop in case there was an error
-  if (flags & LDMA_IF_ERROR)
-    __BKPT(0);
-}
-
 /**************************************************************************//**
  * @brief
  *    Main function
@@ -236,14 +180,24 @@ void LDMA_IRQHandler()
 int main(void)
 {
   uint32_t i;
+  CORE_DECLARE_IRQ_STATE;
 
   // Chip errata
   CHIP_Init();
 
-  // Initialize GPIO and EUSART1
+  // Initialize GPIO, EUSART1 and the LDMA
   initGPIO();
-  initEUSART1();
-  initLDMA();
+  SPIQ_Init();
+  SPIQ_DeviceInit(&secondary);
+  SPIQ_DeviceInit(&adc);
+  SPIQ_DeviceInit(&display);
+
+  setupTransfer(&secondaryTransfer, &secondary, outbuf, inbuf, BUFLEN,
+                &secondaryCount);
+  setupTransfer(&adcTransfer, &adc, adcCommand, adcResult, ADC_LEN,
+                &adcCount);
+  setupTransfer(&displayTransfer, &display, frame, NULL, FRAME_LEN,
+                &frameCount);
 
   /*
    * Wait for button 0 press before starting.  This happens one time so
@@ -262,27 +216,28 @@ int main(void)
       outbuf[i] = (uint8_t)i;
     }
 
-    // Set the receive state to not done
-    rx_done = false;
+    // Draw a moving stripe pattern
+    for (i = 0; i < FRAME_LEN; i++)
+    {
+      frame[i] = (uint8_t)(i + frameCount);
+    }
 
     /*
-     * Assert chip select (drive low).  Note that the calls to
-     * LDMA_StartTransfer() for the receive and transmit channels take
-     * about 42 microseconds at 19 MHz, which the secondary device
-     * needs in order to service the GPIO falling edge interrupt on
-     * CS and to prepare to receive the incoming data.
+     * Queue all three transactions.  The first one starts immediately,
+     * the ADC transaction is chained behind it and the display frame
+     * follows once the EUSART has been switched to its bit rate.
      */
-    GPIO_PinOutClear(EUS1CS_PORT, EUS1CS_PIN);
-
-    // Start both channels
-    LDMA_StartTransfer(RX_LDMA_CHANNEL, &ldmaRXConfig, &ldmaRXDescriptor);
-    LDMA_StartTransfer(TX_LDMA_CHANNEL, &ldmaTXConfig, &ldmaTXDescriptor);
-
-    // Wait in EM1 until all data is received
-    while (!rx_done)
-      EMU_EnterEM1();
+    SPIQ_Submit(&secondaryTransfer);
+    SPIQ_Submit(&adcTransfer);
+    SPIQ_Submit(&displayTransfer);
 
-    // De-assert chip select upon final byte reception (drive high)
-    GPIO_PinOutSet(EUS1CS_PORT, EUS1CS_PIN);
+    // Wait in EM1 until all transactions are done
+    while (!SPIQ_IsIdle())
+    {
+      CORE_ENTER_CRITICAL();
+      if (!SPIQ_IsIdle())
+        EMU_EnterEM1();
+      CORE_EXIT_CRITICAL();
+    }
   }
 }
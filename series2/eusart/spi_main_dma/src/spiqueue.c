@@ -0,0 +1,456 @@
+/***************************************************************************//**
+ * @file spiqueue.c
+ *
+ * @brief Queue of LDMA-driven SPI transactions on EUSART1 in main mode.
+ *
+ * Every transaction becomes a short run of descriptors on each channel:
+ *
+ *   RX: WRI CS low, SYNC set, P2M pieces of up to 2048 bytes, WRI CS high,
+ *       WRI sequence number (interrupt)
+ *   TX: SYNC wait, SYNC clear, optional M2M delay, M2P pieces
+ *
+ * The receive channel owns chip select. It only de-asserts once the last
+ * byte has been shifted in, and the transmit channel cannot feed the FIFO
+ * for the next transaction until the receive channel has asserted the next
+ * chip select and set the sync bit. Runs of transactions with the same bit
+ * rate and clock mode are linked into one chain, the EUSART is only
+ * reconfigured between chains.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2021 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ *******************************************************************************
+ * # Evaluation Quality
+ * This code has been minimally tested to ensure that it builds and is suitable
+ * as a demonstration for evaluation purposes only. This code will be maintained
+ * at the sole discretion of Silicon Labs.
+ ******************************************************************************/
+
+#include <stddef.h>
+
+#include "em_device.h"
+#include "em_cmu.h"
+#include "em_core.h"
+#include "em_eusart.h"
+#include "em_gpio.h"
+#include "em_ldma.h"
+
+#include "spiqueue.h"
+
+// SPI ports and pins
+#define EUS1MOSI_PORT   gpioPortC
+#define EUS1MOSI_PIN    1
+#define EUS1MISO_PORT   gpioPortC
+#define EUS1MISO_PIN    2
+#define EUS1SCLK_PORT   gpioPortC
+#define EUS1SCLK_PIN    3
+
+// Bit times of delay between frames to accommodate non-DMA secondaries
+#define SPIQ_INTER_FRAME_TIME   7
+
+// Largest LDMA transfer per descriptor
+#define SPIQ_MAX_XFER           2048
+
+// Sync bit handed from the receive to the transmit channel when CS is low
+#define SPIQ_SYNC_CS            (1 << 0)
+
+// Approximate HCLK cycles taken by one word of the delay copy. The delay is
+// only as accurate as this estimate, check CS setup on a scope if a
+// secondary is close to its limit.
+#define SPIQ_DELAY_CYCLES_PER_WORD  4
+
+// Receive descriptors of a transaction, the transmit side never needs more
+#define SPIQ_PIECES(len)        (((len) + SPIQ_MAX_XFER - 1) / SPIQ_MAX_XFER)
+#define SPIQ_RX_DESCRIPTORS(len) (SPIQ_PIECES(len) + 4)
+
+// Descriptor pools, one chain at a time
+static LDMA_Descriptor_t rxDescriptors[SPIQ_MAX_DESCRIPTORS];
+static LDMA_Descriptor_t txDescriptors[SPIQ_MAX_DESCRIPTORS];
+
+static LDMA_TransferCfg_t rxConfig;
+static LDMA_TransferCfg_t txConfig;
+
+// Source of SPIQ_FILL_BYTE and sink of discarded bytes
+static const uint8_t fillByte = SPIQ_FILL_BYTE;
+static uint8_t discardByte;
+
+// Source and destination of the delay copy
+static uint32_t delayWord;
+
+// Transactions waiting for a chain
+static SPIQ_Transfer_t *pendingHead;
+static SPIQ_Transfer_t *pendingTail;
+
+// Transactions in the running chain, the LDMA writes the number of
+// finished ones to chainDone
+static SPIQ_Transfer_t *chainHead;
+static uint32_t chainLength;
+static uint32_t chainCompleted;
+static volatile uint32_t chainDone;
+static volatile bool busy;
+
+// EUSART settings of the running chain, a bit rate of 0 forces a reload
+static uint32_t currentBitRate;
+static EUSART_ClockMode_TypeDef currentClockMode;
+
+static uint32_t hclkMhz;
+
+/**************************************************************************//**
+ * @brief
+ *    Configure EUSART1 for a device's bit rate and clock mode
+ *****************************************************************************/
+static void configureEusart(const SPIQ_Device_t *device)
+{
+  // SPI advanced configuration (part of the initializer)
+  EUSART_SpiAdvancedInit_TypeDef adv = EUSART_SPI_ADVANCED_INIT_DEFAULT;
+
+  adv.msbFirst = true;        // SPI standard MSB first
+  adv.autoInterFrameTime = SPIQ_INTER_FRAME_TIME;
+
+  // Default asynchronous initializer (main/master mode and 8-bit data)
+  EUSART_SpiInit_TypeDef init = EUSART_SPI_MASTER_INIT_DEFAULT_HF;
+
+  init.bitRate = device->bitRate;
+  init.clockMode = device->clockMode;
+  init.advancedSettings = &adv;
+
+  EUSART_SpiInit(EUSART1, &init);
+
+  currentBitRate = device->bitRate;
+  currentClockMode = device->clockMode;
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Check whether two devices can share a chain
+ *****************************************************************************/
+static bool sameSettings(const SPIQ_Device_t *a, const SPIQ_Device_t *b)
+{
+  return (a->bitRate == b->bitRate) && (a->clockMode == b->clockMode);
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Append the descriptors of one transaction to the chain
+ *
+ * @param[in] transfer
+ *    Transaction to add.
+ *
+ * @param[in] sequence
+ *    Position in the chain starting at 1, written to chainDone when done.
+ *
+ * @param[in,out] rxCount
+ *    Receive descriptors used so far.
+ *
+ * @param[in,out] txCount
+ *    Transmit descriptors used so far.
+ *****************************************************************************/
+static void addTransfer(const SPIQ_Transfer_t *transfer, uint32_t sequence,
+                        uint32_t *rxCount, uint32_t *txCount)
+{
+  const SPIQ_Device_t *device = transfer->device;
+  LDMA_Descriptor_t *rx = &rxDescriptors[*rxCount];
+  LDMA_Descriptor_t *tx = &txDescriptors[*txCount];
+  uint32_t left = transfer->length;
+  uint32_t offset = 0;
+  uint32_t n = 0;
+  uint32_t m = 0;
+
+  // Assert chip select, then let the transmit channel go
+  rx[n++] = (LDMA_Descriptor_t)
+    LDMA_DESCRIPTOR_LINKREL_WRITE(1 << device->csPin,
+                                  &GPIO->P_CLR[device->csPort].DOUT, 1);
+  rx[n++] = (LDMA_Descriptor_t)
+    LDMA_DESCRIPTOR_LINKREL_SYNC(SPIQ_SYNC_CS, 0, 0, 0, 1);
+
+  // Wait for chip select, then take the sync bit back for the next one.
+  // A sync descriptor sets and clears before it matches, so this takes two.
+  tx[m++] = (LDMA_Descriptor_t)
+    LDMA_DESCRIPTOR_LINKREL_SYNC(0, 0, SPIQ_SYNC_CS, SPIQ_SYNC_CS, 1);
+  tx[m++] = (LDMA_Descriptor_t)
+    LDMA_DESCRIPTOR_LINKREL_SYNC(0, SPIQ_SYNC_CS, 0, 0, 1);
+
+  // Chip select setup time. The copy runs at bus speed with one request
+  // for the whole descriptor, so the first byte waits until it is done.
+  if (device->csSetupUs) {
+    uint32_t words = (device->csSetupUs * hclkMhz) / SPIQ_DELAY_CYCLES_PER_WORD;
+
+    if (words < 1) {
+      words = 1;
+    } else if (words > SPIQ_MAX_XFER) {
+      words = SPIQ_MAX_XFER;
+    }
+    tx[m] = (LDMA_Descriptor_t)
+      LDMA_DESCRIPTOR_LINKREL_M2M_WORD(&delayWord, &delayWord, words, 1);
+    tx[m].xfer.srcInc = ldmaCtrlSrcIncNone;
+    tx[m].xfer.dstInc = ldmaCtrlDstIncNone;
+    m++;
+  }
+
+  while (left) {
+    uint32_t count = (left > SPIQ_MAX_XFER) ? SPIQ_MAX_XFER : left;
+
+    if (transfer->rx) {
+      rx[n] = (LDMA_Descriptor_t)
+        LDMA_DESCRIPTOR_LINKREL_P2M_BYTE(&(EUSART1->RXDATA),
+                                         transfer->rx + offset, count, 1);
+    } else {
+      rx[n] = (LDMA_Descriptor_t)
+        LDMA_DESCRIPTOR_LINKREL_P2M_BYTE(&(EUSART1->RXDATA),
+                                         &discardByte, count, 1);
+      rx[n].xfer.dstInc = ldmaCtrlDstIncNone;
+    }
+    rx[n++].xfer.doneIfs = 0;
+
+    if (transfer->tx) {
+      tx[m] = (LDMA_Descriptor_t)
+        LDMA_DESCRIPTOR_LINKREL_M2P_BYTE(transfer->tx + offset,
+                                         &(EUSART1->TXDATA), count, 1);
+    } else {
+      tx[m] = (LDMA_Descriptor_t)
+        LDMA_DESCRIPTOR_LINKREL_M2P_BYTE(&fillByte,
+                                         &(EUSART1->TXDATA), count, 1);
+      tx[m].xfer.srcInc = ldmaCtrlSrcIncNone;
+    }
+    tx[m++].xfer.doneIfs = 0;
+
+    left -= count;
+    offset += count;
+  }
+
+  // All bytes are in, so the bus is idle: de-assert chip select and report
+  rx[n++] = (LDMA_Descriptor_t)
+    LDMA_DESCRIPTOR_LINKREL_WRITE(1 << device->csPin,
+                                  &GPIO->P_SET[device->csPort].DOUT, 1);
+  rx[n] = (LDMA_Descriptor_t)
+    LDMA_DESCRIPTOR_LINKREL_WRITE(sequence, &chainDone, 1);
+  rx[n++].wri.doneIfs = 1;
+
+  *rxCount += n;
+  *txCount += m;
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Move the longest run of pending transactions that fits the pools and
+ *    shares the EUSART settings into a chain and start it. Called with
+ *    interrupts masked or from the LDMA interrupt.
+ *****************************************************************************/
+static void startChain(void)
+{
+  SPIQ_Transfer_t *first = pendingHead;
+  SPIQ_Transfer_t *transfer;
+  uint32_t rxCount = 0;
+  uint32_t txCount = 0;
+
+  if (first == NULL) {
+    busy = false;
+    return;
+  }
+
+  if ((currentBitRate != first->device->bitRate)
+      || (currentClockMode != first->device->clockMode)) {
+    configureEusart(first->device);
+  }
+
+  chainHead = first;
+  chainLength = 0;
+  chainCompleted = 0;
+  chainDone = 0;
+
+  transfer = first;
+  while ((transfer != NULL)
+         && sameSettings(transfer->device, first->device)
+         && (rxCount + SPIQ_RX_DESCRIPTORS(transfer->length)
+             <= SPIQ_MAX_DESCRIPTORS)) {
+    addTransfer(transfer, ++chainLength, &rxCount, &txCount);
+    transfer = transfer->next;
+  }
+
+  // Detach the chain from the pending queue
+  pendingHead = transfer;
+  if (pendingHead == NULL) {
+    pendingTail = NULL;
+  }
+
+  // End both descriptor lists
+  rxDescriptors[rxCount - 1].xfer.link = 0;
+  txDescriptors[txCount - 1].xfer.link = 0;
+
+  busy = true;
+
+  // The receive channel goes first, it asserts chip select for the first
+  // transaction and releases the transmit channel
+  LDMA_StartTransfer(SPIQ_RX_LDMA_CHANNEL, &rxConfig, rxDescriptors);
+  LDMA_StartTransfer(SPIQ_TX_LDMA_CHANNEL, &txConfig, txDescriptors);
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Initialize EUSART1 pins, the LDMA and the transaction queue
+ *****************************************************************************/
+void SPIQ_Init(void)
+{
+  CMU_ClockEnable(cmuClock_GPIO, true);
+  CMU_ClockEnable(cmuClock_EUSART1, true);
+
+  // Configure MOSI (TX) pin as an output
+  GPIO_PinModeSet(EUS1MOSI_PORT, EUS1MOSI_PIN, gpioModePushPull, 0);
+
+  // Configure MISO (RX) pin as an input
+  GPIO_PinModeSet(EUS1MISO_PORT, EUS1MISO_PIN, gpioModeInput, 0);
+
+  // Configure SCLK pin as an output low (CPOL = 0)
+  GPIO_PinModeSet(EUS1SCLK_PORT, EUS1SCLK_PIN, gpioModePushPull, 0);
+
+  /*
+   * Route EUSART1 MOSI, MISO, and SCLK to the specified pins.  Chip
+   * selects are GPIOs written by the LDMA, so there is no write to the
+   * corresponding EUSARTROUTE register.
+   */
+  GPIO->EUSARTROUTE[1].TXROUTE = (EUS1MOSI_PORT << _GPIO_EUSART_TXROUTE_PORT_SHIFT)
+      | (EUS1MOSI_PIN << _GPIO_EUSART_TXROUTE_PIN_SHIFT);
+  GPIO->EUSARTROUTE[1].RXROUTE = (EUS1MISO_PORT << _GPIO_EUSART_RXROUTE_PORT_SHIFT)
+      | (EUS1MISO_PIN << _GPIO_EUSART_RXROUTE_PIN_SHIFT);
+  GPIO->EUSARTROUTE[1].SCLKROUTE = (EUS1SCLK_PORT << _GPIO_EUSART_SCLKROUTE_PORT_SHIFT)
+      | (EUS1SCLK_PIN << _GPIO_EUSART_SCLKROUTE_PIN_SHIFT);
+
+  // Enable EUSART interface pins
+  GPIO->EUSARTROUTE[1].ROUTEEN = GPIO_EUSART_ROUTEEN_RXPEN |    // MISO
+                                 GPIO_EUSART_ROUTEEN_TXPEN |    // MOSI
+                                 GPIO_EUSART_ROUTEEN_SCLKPEN;
+
+  // The EUSART is configured for the first chain
+  currentBitRate = 0;
+
+  hclkMhz = CMU_ClockFreqGet(cmuClock_HCLK) / 1000000;
+
+  LDMA_Init_t ldmaInit = LDMA_INIT_DEFAULT;
+  LDMA_Init(&ldmaInit);
+
+  // Transfer a byte on free space in the EUSART FIFO
+  txConfig = (LDMA_TransferCfg_t)LDMA_TRANSFER_CFG_PERIPHERAL(ldmaPeripheralSignal_EUSART1_TXFL);
+
+  // Transfer a byte on receive FIFO level event
+  rxConfig = (LDMA_TransferCfg_t)LDMA_TRANSFER_CFG_PERIPHERAL(ldmaPeripheralSignal_EUSART1_RXFL);
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Configure a device's chip select pin as an output, initially high
+ *****************************************************************************/
+void SPIQ_DeviceInit(const SPIQ_Device_t *device)
+{
+  GPIO_PinModeSet(device->csPort, device->csPin, gpioModePushPull, 1);
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Queue a transaction. It starts right away if the bus is idle, else it
+ *    is chained behind the transactions already queued.
+ *
+ * @param[in] transfer
+ *    Transaction, must stay valid until its callback has been called.
+ *
+ * @return
+ *    False if the transaction is empty or needs more descriptors than
+ *    SPIQ_MAX_DESCRIPTORS.
+ *****************************************************************************/
+bool SPIQ_Submit(SPIQ_Transfer_t *transfer)
+{
+  CORE_DECLARE_IRQ_STATE;
+
+  if ((transfer->length == 0)
+      || (SPIQ_RX_DESCRIPTORS(transfer->length) > SPIQ_MAX_DESCRIPTORS)) {
+    return false;
+  }
+
+  transfer->next = NULL;
+
+  CORE_ENTER_CRITICAL();
+  if (pendingTail) {
+    pendingTail->next = transfer;
+  } else {
+    pendingHead = transfer;
+  }
+  pendingTail = transfer;
+
+  if (!busy) {
+    startChain();
+  }
+  CORE_EXIT_CRITICAL();
+
+  return true;
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Check whether all queued transactions have completed
+ *****************************************************************************/
+bool SPIQ_IsIdle(void)
+{
+  return !busy;
+}
+
+/**************************************************************************//**
+ * @brief LDMA IRQHandler
+ *****************************************************************************/
+void LDMA_IRQHandler(void)
+{
+  uint32_t flags = LDMA_IntGet();
+  uint32_t done;
+
+  LDMA_IntClear(flags);
+
+  // Stop in case there was an error
+  if (flags & LDMA_IF_ERROR) {
+    __BKPT(0);
+  }
+
+  if (!(flags & (1 << SPIQ_RX_LDMA_CHANNEL)) || !busy) {
+    return;
+  }
+
+  // Several transactions can finish before the interrupt is serviced.
+  // Each one is unlinked before its callback, which may submit it again.
+  done = chainDone;
+  while (chainCompleted < done) {
+    SPIQ_Transfer_t *transfer = chainHead;
+
+    chainHead = transfer->next;
+    chainCompleted++;
+
+    if (transfer->callback) {
+      transfer->callback(transfer);
+    }
+  }
+
+  // The last write of the chain ends the receive channel, and all bytes
+  // being received means the transmit channel is done too
+  if (chainCompleted == chainLength) {
+    while (!LDMA_TransferDone(SPIQ_RX_LDMA_CHANNEL)) {
+    }
+    startChain();
+  }
+}
@@ -2,9 +2,9 @@
  * @file main.c
  *
  * @brief This project demonstrates DMA-driven use of the EUSART in synchronous
- * (SPI) secondary (formerly slave) mode.  The main loop starts the LDMA
- * channels, which transmit the specified number of bytes and receive the byte
- * that is shifted in with each outgoing one.
+ * (SPI) secondary (formerly slave) mode.  A looped LDMA descriptor keeps
+ * receiving into a ring buffer, and the chip select rising edge marks where
+ * each variable-length frame ends.
  *
  * The pins used in this example are defined below and are described in the
  * accompanying readme.txt file.
@@ -45,6 +45,7 @@
 #include "em_device.h"
 #include "em_chip.h"
 #include "em_cmu.h"
+#include "em_core.h"
 #include "em_emu.h"
 #include "em_eusart.h"
 #include "em_gpio.h"
@@ -60,29 +61,57 @@
 #define EUS1CS_PORT     gpioPortC
 #define EUS1CS_PIN      0
 
-// LDMA channel for receive and transmit servicing
+// LDMA channel for receive servicing
 #define RX_LDMA_CHANNEL 0
-#define TX_LDMA_CHANNEL 1
 
-// LDMA descriptor and transfer configuration structures for EUSART TX channel
-LDMA_Descriptor_t ldmaTXDescriptor;
-LDMA_TransferCfg_t ldmaTXConfig;
+// Size of the receive ring, at most 2048 bytes (one LDMA descriptor).
+// Frames longer than this cannot be told apart from lost data.
+#define RING_SIZE       1024
+
+// Number of frame boundaries that can wait for the main loop
+#define FRAME_QUEUE_LEN 16
+
+#if (RING_SIZE > 2048)
+#error "RING_SIZE must fit in a single LDMA descriptor"
+#endif
 
 // LDMA descriptor and transfer configuration structures for EUSART RX channel
 LDMA_Descriptor_t ldmaRXDescriptor;
 LDMA_TransferCfg_t ldmaRXConfig;
 
-// Size of the data buffers
-#define BUFLEN  10
-
-// Outgoing data
-uint8_t outbuf[BUFLEN];
-
-// Incoming data
-uint8_t inbuf[BUFLEN];
-
-// Data reception complete
-bool rx_done;
+// Receive ring, written by the LDMA without ever stopping
+uint8_t ring[RING_SIZE];
+
+// Number of times the LDMA has wrapped around the ring
+static volatile uint32_t ringWraps;
+
+/*
+ * Frame boundaries are byte counts since reset: the ring position of the
+ * frame end plus the wraps so far.  Each frame starts where the previous one
+ * ended.
+ */
+typedef struct {
+  uint32_t start;
+  uint32_t end;
+} Frame_t;
+
+static Frame_t frameQueue[FRAME_QUEUE_LEN];
+static volatile uint32_t frameHead;
+static volatile uint32_t frameTail;
+static uint32_t lastBoundary;
+
+// Most recent frame, copied out of the ring by the main loop
+#define FRAME_MAX       256
+uint8_t inbuf[FRAME_MAX];
+volatile uint32_t inbufLength;
+
+// Frame statistics
+// Note: These are only volatile to ensure that they don't get optimized out
+// by the compiler before the user checks their value.
+volatile uint32_t frameCount;
+volatile uint32_t byteCount;
+volatile uint32_t overrunCount;       // Ring lapped before a frame was read
+volatile uint32_t boundaryDropCount;  // Frame queue full, frames merged
 
 /**************************************************************************//**
  * @brief
@@ -120,8 +149,8 @@ void initGPIO(void)
   // Configure CS pin as an input pulled high
   GPIO_PinModeSet(EUS1CS_PORT, EUS1CS_PIN, gpioModeInputPull, 1);
 
-  // Request an interrupt on a CS pin high-to-low transition.
-  GPIO_ExtIntConfig(EUS1CS_PORT, EUS1CS_PIN, EUS1CS_PIN, false, true, true);
+  // Request an interrupt on a CS pin low-to-high transition (frame end)
+  GPIO_ExtIntConfig(EUS1CS_PORT, EUS1CS_PIN, EUS1CS_PIN, true, false, true);
 
   // Enable NVIC GPIO interrupt
 #if (EUS1CS_PIN & 1)
@@ -150,36 +179,14 @@ void initEUSART1(void)
   EUSART_SpiInit_TypeDef init = EUSART_SPI_SLAVE_INIT_DEFAULT_HF;
 
   init.advancedSettings = &adv;   // Advanced settings structure
-  init.enable = eusartDisable;    // Do not enable yet
-
-  // Configure EUSART1
-  EUSART_SpiInit(EUSART1, &init);
+  init.enable = eusartEnableRx;   // Receive only
 
   /*
-   * In polled mode, there should be a delay of reasonable length
-   * between chip select assertion and when the main device begins
-   * clocking the secondary.  This delay is needed to allow the
-   * secondary to recognize the CSn falling edge in order to exit a
-   * low-power mode (especially EM2/3) and to prepare data for
-   * transmission back to the main.
-   *
-   * Unfortunately, the EUSART default behavior assumes that an
-   * extended delay means that the secondary should transmit a default
-   * frame back to the main, which is probably unnecessary.
-   *
-   * To avoid this, the FORCELOAD bit the in the CFG2 register must
-   * be set, but this requires disabling the EUSART because the emlib
-   * advanced initializer for SPI mode does not include an option to
-   * set this (even though it includes a way to set the default frame).
+   * The chip select input is routed to the EUSART, so it ignores the
+   * clock while CS is high and can stay enabled all the time.  Nothing
+   * is transmitted.
    */
-  EUSART1->EN_CLR = EUSART_EN_EN;
-
-  // Wait while the EUSART disables itself
-  while ((EUSART1->EN & EUSART_EN_DISABLING));
-
-  // Set FORCELOAD, then re-enable
-  EUSART1->CFG2_SET = EUSART_CFG2_FORCELOAD;
-  EUSART1->EN_SET = EUSART_EN_EN;
+  EUSART_SpiInit(EUSART1, &init);
 }
 
 /**************************************************************************//**
@@ -192,17 +199,51 @@ void initLDMA(void)
   LDMA_Init_t ldmaInit = LDMA_INIT_DEFAULT;
   LDMA_Init(&ldmaInit);
 
-  // Source is EUSART1_RXDATA, destination is inbuf, and length if BUFLEN
-  ldmaRXDescriptor = (LDMA_Descriptor_t)LDMA_DESCRIPTOR_SINGLE_P2M_BYTE(&(EUSART1->RXDATA), inbuf, BUFLEN);
+  /*
+   * Source is EUSART1_RXDATA, destination is the ring.  The descriptor
+   * links to itself, so the channel reloads the ring start after the last
+   * byte and never stops.  Each wrap raises the done interrupt.
+   */
+  ldmaRXDescriptor = (LDMA_Descriptor_t)LDMA_DESCRIPTOR_LINKREL_P2M_BYTE(&(EUSART1->RXDATA), ring, RING_SIZE, 0);
+  ldmaRXDescriptor.xfer.doneIfs = 1;
 
   // Transfer a byte on receive FIFO level event
   ldmaRXConfig = (LDMA_TransferCfg_t)LDMA_TRANSFER_CFG_PERIPHERAL(ldmaPeripheralSignal_EUSART1_RXFL);
 
-  // Source is outbuf, destination is EUSART1_TXDATA, and length if BUFLEN
-  ldmaTXDescriptor = (LDMA_Descriptor_t)LDMA_DESCRIPTOR_SINGLE_M2P_BYTE(outbuf, &(EUSART1->TXDATA), BUFLEN);
+  LDMA_StartTransfer(RX_LDMA_CHANNEL, &ldmaRXConfig, &ldmaRXDescriptor);
+}
 
-  // Transfer a byte on free space in the EUSART FIFO
-  ldmaTXConfig = (LDMA_TransferCfg_t)LDMA_TRANSFER_CFG_PERIPHERAL(ldmaPeripheralSignal_EUSART1_TXFL);
+/**************************************************************************//**
+ * @brief
+ *    Count a ring wrap if the LDMA has flagged one
+ *****************************************************************************/
+static void countWrap(void)
+{
+  if (LDMA_IntGet() & (1 << RX_LDMA_CHANNEL))
+  {
+    LDMA_IntClear(1 << RX_LDMA_CHANNEL);
+    ringWraps++;
+  }
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Number of bytes written to the ring since reset. Called from
+ *    interrupt handlers of the same priority as the LDMA interrupt.
+ *****************************************************************************/
+static uint32_t ringPosition(void)
+{
+  uint32_t offset;
+
+  countWrap();
+  offset = LDMA->CH[RX_LDMA_CHANNEL].DST - (uint32_t)ring;
+
+  // A wrap between the two reads leaves DST at the ring end
+  countWrap();
+  if (offset >= RING_SIZE)
+    offset = LDMA->CH[RX_LDMA_CHANNEL].DST - (uint32_t)ring;
+
+  return (ringWraps * RING_SIZE) + (offset % RING_SIZE);
 }
 
 /**************************************************************************//**
@@ -212,19 +253,8 @@ void LDMA_IRQHandler()
 {
   uint32_t flags = LDMA_IntGet();
 
-  // Clear the transmit channel's done flag if set
-  if (flags & (1 << TX_LDMA_CHANNEL))
-    LDMA_IntClear(1 << TX_LDMA_CHANNEL);
-
-  /*
-   * Clear the receive channel's done flag if set and change receive
-   * state to done.
-   */
-  if (flags & (1 << RX_LDMA_CHANNEL))
-  {
-    LDMA_IntClear(1 << RX_LDMA_CHANNEL);
-    rx_done = true;
-  }
+  // Receive channel done means the ring wrapped
+  countWrap();
 
   // Stop in case there was an error
   if (flags & LDMA_IF_ERROR)
@@ -240,8 +270,61 @@ void GPIO_ODD_IRQHandler(void)
 void GPIO_EVEN_IRQHandler(void)
 #endif
 {
-  // Clear the falling edge interrupt flag
+  uint32_t end;
+  uint32_t next;
+
+  // Clear the rising edge interrupt flag
   GPIO_IntClear(1 << EUS1CS_PIN);
+
+  // The last byte of the frame may still be in the receive FIFO
+  while (EUSART1->STATUS & EUSART_STATUS_RXFL);
+
+  end = ringPosition();
+
+  // CS glitch or a frame without clocks
+  if (end == lastBoundary)
+    return;
+
+  next = (frameHead + 1) % FRAME_QUEUE_LEN;
+  if (next == frameTail)
+  {
+    // No room, the next boundary covers this frame as well
+    boundaryDropCount++;
+    return;
+  }
+
+  frameQueue[frameHead].start = lastBoundary;
+  frameQueue[frameHead].end = end;
+  frameHead = next;
+  lastBoundary = end;
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Copy a frame out of the ring
+ *
+ * @return
+ *    False if the LDMA has already overwritten part of the frame
+ *****************************************************************************/
+static bool readFrame(const Frame_t *frame)
+{
+  uint32_t length = frame->end - frame->start;
+  uint32_t i;
+  CORE_DECLARE_IRQ_STATE;
+
+  if (length > FRAME_MAX)
+    length = FRAME_MAX;
+
+  for (i = 0; i < length; i++)
+    inbuf[i] = ring[(frame->start + i) % RING_SIZE];
+  inbufLength = length;
+
+  // Anything written past a full ring from the frame start overlapped it
+  CORE_ENTER_CRITICAL();
+  i = ringPosition();
+  CORE_EXIT_CRITICAL();
+
+  return (i - frame->start) <= RING_SIZE;
 }
 
 /**************************************************************************//**
@@ -250,7 +333,7 @@ void GPIO_EVEN_IRQHandler(void)
  *****************************************************************************/
 int main(void)
 {
-  uint32_t i;
+  CORE_DECLARE_IRQ_STATE;
 
   // Chip errata
   CHIP_Init();
@@ -277,44 +360,35 @@ int main(void)
    */
   CMU_UpdateWaitStates(SystemCoreClockGet(), 0);
 
-  // Initialize EUSART1, GPIO, and LDMA
+  // Initialize EUSART1, LDMA, and GPIO.  The ring is running before the
+  // chip select interrupt can record the first boundary.
   initEUSART1();
-  initGPIO();
   initLDMA();
+  initGPIO();
 
   while (1)
   {
-    // Zero incoming buffer and populate outgoing data array
-    for (i = 0; i < BUFLEN; i++)
-    {
-      inbuf[i] = 0;
-      outbuf[i] = (uint8_t)i;
-    }
-
-    // Set the receive state to not done
-    rx_done = false;
-
-    // Now enable the falling edge interrupt on the EUS1CS_PIN
-    GPIO_IntEnable(1 << EUS1CS_PIN);
-
-    // Wait for falling edge on EUS1CS_PIN
-    EMU_EnterEM1();
-
-    // Now enable the EUSART receiver and transmitter
-    EUSART_Enable(EUSART1, eusartEnable);
-
-    // Start both channels
-    LDMA_StartTransfer(TX_LDMA_CHANNEL, &ldmaTXConfig, &ldmaTXDescriptor);
-    LDMA_StartTransfer(RX_LDMA_CHANNEL, &ldmaRXConfig, &ldmaRXDescriptor);
-
-    // Wait in EM1 until all data is received
-    while (!rx_done)
+    // Wait in EM1 until a frame has ended
+    CORE_ENTER_CRITICAL();
+    if (frameTail == frameHead)
       EMU_EnterEM1();
+    CORE_EXIT_CRITICAL();
 
-    // Disable the falling edge interrupt on the EUS1CS_PIN
-    GPIO_IntDisable(1 << EUS1CS_PIN);
-
-    // Disable EUSART receiver and transmitter until next chip select
-    EUSART_Enable(EUSART1, eusartDisable);
+    while (frameTail != frameHead)
+    {
+      Frame_t *frame = &frameQueue[frameTail];
+
+      if (readFrame(frame))
+      {
+        frameCount++;
+        byteCount += frame->end - frame->start;
+      }
+      else
+      {
+        overrunCount++;
+      }
+
+      frameTail = (frameTail + 1) % FRAME_QUEUE_LEN;
+    }
   }
 }
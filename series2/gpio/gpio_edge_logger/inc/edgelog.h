@@ -0,0 +1,79 @@
+/***************************************************************************//**
+ * @file edgelog.h
+ * @brief GPIO edge logger: each edge on a set of pins is timestamped by
+ * TIMER0 and stored with the pin states by the LDMA, without interrupts.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2021 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ******************************************************************************/
+
+#ifndef EDGELOG_H
+#define EDGELOG_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "em_gpio.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// LDMA channels that store the capture times and the pin states
+#define EDGELOG_TIME_LDMA_CHANNEL   0
+#define EDGELOG_PINS_LDMA_CHANNEL   1
+
+// Pins logged, all on one port. Each one adds a PRS channel.
+#define EDGELOG_MAX_PINS            4
+
+// Records in the ring, even and at most two descriptors of 2048 words
+#ifndef EDGELOG_RING_SIZE
+#define EDGELOG_RING_SIZE           1024
+#endif
+
+#if (EDGELOG_RING_SIZE < 4) || (EDGELOG_RING_SIZE > 4096) \
+  || (EDGELOG_RING_SIZE % 2)
+#error "EDGELOG_RING_SIZE must be even and 4 to 4096"
+#endif
+
+// One edge: when it happened and the pins right after it
+typedef struct {
+  uint32_t time;            // TIMER0 count at the edge, wrapping
+  uint32_t pins;            // Port input (DIN), masked with the pins logged
+} EDGELOG_Record_t;
+
+bool EDGELOG_Start(GPIO_Port_TypeDef port, uint32_t pinMask);
+void EDGELOG_Stop(void);
+uint32_t EDGELOG_Available(void);
+uint32_t EDGELOG_Read(EDGELOG_Record_t *out, uint32_t max);
+uint32_t EDGELOG_GetTime(void);
+uint32_t EDGELOG_GetTimerFrequency(void);
+uint32_t EDGELOG_GetOverrunCount(void);
+uint32_t EDGELOG_GetMissedCount(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // EDGELOG_H
@@ -0,0 +1,383 @@
+/***************************************************************************//**
+ * @file edgelog.c
+ * @brief GPIO edge logger: each edge on a set of pins is timestamped by
+ * TIMER0 and stored with the pin states by the LDMA, without interrupts.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2021 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ *******************************************************************************
+ * # Evaluation Quality
+ * This code has been minimally tested to ensure that it builds and is suitable 
+ * as a demonstration for evaluation purposes only. This code will be maintained
+ * at the sole discretion of Silicon Labs.
+ ******************************************************************************/
+
+#include "em_device.h"
+#include "em_cmu.h"
+#include "em_gpio.h"
+#include "em_ldma.h"
+#include "em_prs.h"
+#include "em_timer.h"
+
+#include "prsgraph.h"
+#include "edgelog.h"
+
+/*
+ * The pins are XORed together in the PRS, so an edge on any of them is an
+ * edge of the result. CC0 and CC1 of TIMER0 both capture every edge of
+ * it; the CC0 request stores the capture and the CC1 request the port
+ * input, each with its own LDMA channel. The LDMA does not read the CC1
+ * capture, so the timer is set to clear the requests when the LDMA serves
+ * them.
+ */
+#define LOG_TIMER           TIMER0
+#define TIME_SOURCE         (&LOG_TIMER->CC[0].ICF)
+#define TIME_SIGNAL         ldmaPeripheralSignal_TIMER0_CC0
+#define PINS_SIGNAL         ldmaPeripheralSignal_TIMER0_CC1
+
+#define TIME_DONE           (1 << EDGELOG_TIME_LDMA_CHANNEL)
+#define PINS_DONE           (1 << EDGELOG_PINS_LDMA_CHANNEL)
+
+#define HALF_SIZE           (EDGELOG_RING_SIZE / 2)
+
+// Rings written by the LDMA, record i is times[i] and pinStates[i]
+static uint32_t times[EDGELOG_RING_SIZE];
+static uint32_t pinStates[EDGELOG_RING_SIZE];
+
+// Two halves per ring, each links to the other
+static LDMA_Descriptor_t timeDesc[2];
+static LDMA_Descriptor_t pinsDesc[2];
+
+static uint32_t pinsLogged;
+
+// Halves of the time ring completed, counted from the LDMA done flag
+static uint32_t halvesDone;
+
+// Reader state: records consumed and the ring slot of the next one
+static uint32_t readCount;
+static uint32_t readIndex;
+
+static uint32_t overruns;
+static uint32_t missed;
+
+/**************************************************************************//**
+ * @brief
+ *   Ring slot an LDMA channel writes next
+ *****************************************************************************/
+static uint32_t writeIndex(uint32_t dst, const uint32_t *ring)
+{
+  return ((dst - (uint32_t)ring) / sizeof(uint32_t)) % EDGELOG_RING_SIZE;
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Records written since EDGELOG_Start(), wrapping at 2^32
+ *
+ * @details
+ *   The LDMA sets the done flag of the time channel at the end of each
+ *   half, with its interrupt disabled; the flag is counted here. A half
+ *   that ends between the flag and the slot are read shows up as a slot
+ *   in the other half, and is counted with the flag the next time.
+ *
+ *   A record is complete once both channels have written it. The pin
+ *   channel is at most one record behind or ahead of the time channel.
+ *****************************************************************************/
+static uint32_t writeCount(void)
+{
+  uint32_t timeIndex, pinsIndex, halves, count;
+
+  if (LDMA->IF & TIME_DONE) {
+    LDMA_IntClear(TIME_DONE);
+    halvesDone++;
+  }
+
+  timeIndex = writeIndex(LDMA->CH[EDGELOG_TIME_LDMA_CHANNEL].DST, times);
+  pinsIndex = writeIndex(LDMA->CH[EDGELOG_PINS_LDMA_CHANNEL].DST, pinStates);
+
+  halves = halvesDone;
+  if ((timeIndex >= HALF_SIZE) != (halves & 1)) {
+    halves++;
+  }
+  count = (halves * HALF_SIZE) + (timeIndex - ((halves & 1) * HALF_SIZE));
+
+  if (((timeIndex + EDGELOG_RING_SIZE - pinsIndex) % EDGELOG_RING_SIZE) == 1) {
+    count--;
+  }
+
+  return count;
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Records waiting, skipping what was overwritten
+ *****************************************************************************/
+static uint32_t snapshot(void)
+{
+  uint32_t written, lost;
+
+  // Edges that came while the capture buffer of CC0 was full are lost
+  if (TIMER_IntGet(LOG_TIMER) & TIMER_IF_ICBOF0) {
+    TIMER_IntClear(LOG_TIMER, TIMER_IF_ICBOF0);
+    missed++;
+  }
+
+  written = writeCount();
+
+  // The LDMA has lapped the reader, the oldest records are gone
+  if (written - readCount > EDGELOG_RING_SIZE) {
+    lost = written - readCount - EDGELOG_RING_SIZE;
+    overruns += lost;
+    readCount += lost;
+    readIndex = (readIndex + (lost % EDGELOG_RING_SIZE)) % EDGELOG_RING_SIZE;
+  }
+
+  return written - readCount;
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Start logging the edges on a set of pins
+ *
+ * @details
+ *   The pins keep the mode the application has set; outputs can be logged
+ *   too, their input stays enabled. Each pin is routed to the PRS through
+ *   its external interrupt line, with the interrupt itself left disabled,
+ *   so the pins must not share their interrupt numbers with other pins in
+ *   use as external interrupts.
+ *
+ *   The logger uses TIMER0, LDMA channels EDGELOG_TIME_LDMA_CHANNEL and
+ *   EDGELOG_PINS_LDMA_CHANNEL and one PRS channel per pin, allocated in
+ *   the PRS graph, and reinitializes the LDMA. No interrupt is used, so
+ *   the device can sleep in EM1 while it logs.
+ *
+ * @param[in] port
+ *   Port of the pins.
+ *
+ * @param[in] pinMask
+ *   Pins to log, at most EDGELOG_MAX_PINS.
+ *
+ * @return
+ *   false if no or too many pins are given or no PRS channels are free.
+ *****************************************************************************/
+bool EDGELOG_Start(GPIO_Port_TypeDef port, uint32_t pinMask)
+{
+  TIMER_Init_TypeDef timerInit = TIMER_INIT_DEFAULT;
+  TIMER_InitCC_TypeDef ccInit = TIMER_INITCC_DEFAULT;
+  LDMA_Init_t ldmaInit = LDMA_INIT_DEFAULT;
+  LDMA_TransferCfg_t timeCfg = LDMA_TRANSFER_CFG_PERIPHERAL(TIME_SIGNAL);
+  LDMA_TransferCfg_t pinsCfg = LDMA_TRANSFER_CFG_PERIPHERAL(PINS_SIGNAL);
+  uint32_t pins = 0;
+  uint8_t pin;
+  int node = PRSGRAPH_NONE;
+
+  pinMask &= 0xFFFF;
+  for (pin = 0; pin < 16; pin++) {
+    if (pinMask & (1 << pin)) {
+      pins++;
+    }
+  }
+  if ((pins == 0) || (pins > EDGELOG_MAX_PINS)) {
+    return false;
+  }
+
+  CMU_ClockEnable(cmuClock_GPIO, true);
+  CMU_ClockEnable(cmuClock_PRS, true);
+  CMU_ClockEnable(cmuClock_TIMER0, true);
+  CMU_ClockEnable(cmuClock_LDMA, true);
+
+  // Each pin is one input of a chain of XOR functions
+  PRSGRAPH_Init();
+  for (pin = 0; pin < 16; pin++) {
+    if (pinMask & (1 << pin)) {
+      GPIO_ExtIntConfig(port, pin, pin, false, false, false);
+      if (node == PRSGRAPH_NONE) {
+        node = PRSGRAPH_Source(PRS_ASYNC_CH_CTRL_SOURCESEL_GPIO, pin);
+      } else {
+        node = PRSGRAPH_Logic(PRS_ASYNC_CH_CTRL_SOURCESEL_GPIO, pin,
+                              node, prsLogic_A_XOR_B);
+      }
+    }
+  }
+  if (!PRSGRAPH_Consumer(node, prsConsumerTIMER0_CC0)
+      || !PRSGRAPH_Consumer(node, prsConsumerTIMER0_CC1)
+      || !PRSGRAPH_Build()) {
+    return false;
+  }
+
+  timerInit.enable = false;
+  timerInit.prescale = timerPrescale1;
+  timerInit.dmaClrAct = true;
+
+  // Both channels capture every edge of the XOR of the pins
+  ccInit.eventCtrl = timerEventEveryEdge;
+  ccInit.edge = timerEdgeBoth;
+  ccInit.mode = timerCCModeCapture;
+  ccInit.prsInput = true;
+  ccInit.prsSel = PRSGRAPH_GetChannel(node);
+  ccInit.prsInputType = timerPrsInputAsyncLevel;
+
+  TIMER_Init(LOG_TIMER, &timerInit);
+  TIMER_InitCC(LOG_TIMER, 0, &ccInit);
+  TIMER_InitCC(LOG_TIMER, 1, &ccInit);
+  TIMER_IntClear(LOG_TIMER, _TIMER_IF_MASK);
+
+  pinsLogged = pinMask;
+  halvesDone = 0;
+  readCount = 0;
+  readIndex = 0;
+  overruns = 0;
+  missed = 0;
+
+  LDMA_Init(&ldmaInit);
+
+  timeDesc[0] = (LDMA_Descriptor_t)
+    LDMA_DESCRIPTOR_LINKREL_P2M_WORD(TIME_SOURCE, times, HALF_SIZE, 1);
+  timeDesc[1] = (LDMA_Descriptor_t)
+    LDMA_DESCRIPTOR_LINKREL_P2M_WORD(TIME_SOURCE, times + HALF_SIZE,
+                                     HALF_SIZE, -1);
+  timeDesc[0].xfer.doneIfs = 1;
+  timeDesc[1].xfer.doneIfs = 1;
+
+  pinsDesc[0] = (LDMA_Descriptor_t)
+    LDMA_DESCRIPTOR_LINKREL_P2M_WORD(&GPIO->P[port].DIN, pinStates,
+                                     HALF_SIZE, 1);
+  pinsDesc[1] = (LDMA_Descriptor_t)
+    LDMA_DESCRIPTOR_LINKREL_P2M_WORD(&GPIO->P[port].DIN, pinStates + HALF_SIZE,
+                                     HALF_SIZE, -1);
+  pinsDesc[0].xfer.doneIfs = 0;
+  pinsDesc[1].xfer.doneIfs = 0;
+
+  LDMA_StartTransfer(EDGELOG_TIME_LDMA_CHANNEL, &timeCfg, &timeDesc[0]);
+  LDMA_StartTransfer(EDGELOG_PINS_LDMA_CHANNEL, &pinsCfg, &pinsDesc[0]);
+
+  // The done flag is polled, LDMA_StartTransfer() enables its interrupt
+  LDMA_IntDisable(TIME_DONE | PINS_DONE);
+  LDMA_IntClear(TIME_DONE | PINS_DONE);
+
+  TIMER_Enable(LOG_TIMER, true);
+
+  return true;
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Stop logging; records already stored can still be read
+ *****************************************************************************/
+void EDGELOG_Stop(void)
+{
+  TIMER_Enable(LOG_TIMER, false);
+  LDMA_StopTransfer(EDGELOG_PINS_LDMA_CHANNEL);
+  LDMA_StopTransfer(EDGELOG_TIME_LDMA_CHANNEL);
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Number of records waiting to be read
+ *****************************************************************************/
+uint32_t EDGELOG_Available(void)
+{
+  return snapshot();
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Read records, oldest first
+ *
+ * @details
+ *   Call this or EDGELOG_Available() at least once per half ring of
+ *   edges, or the records written in between can not all be accounted
+ *   for. Records the LDMA has overwritten before they were read are
+ *   counted by EDGELOG_GetOverrunCount().
+ *
+ *   The time is exact to a timer clock. The pin states are read by the
+ *   LDMA right after the capture, so with edges closer together than the
+ *   LDMA takes to serve a request they can already include the next edge.
+ *
+ * @param[out] out
+ *   Records.
+ *
+ * @param[in] max
+ *   Records that fit in out.
+ *
+ * @return
+ *   Number of records read.
+ *****************************************************************************/
+uint32_t EDGELOG_Read(EDGELOG_Record_t *out, uint32_t max)
+{
+  uint32_t count, i;
+
+  count = snapshot();
+  if (count > max) {
+    count = max;
+  }
+
+  for (i = 0; i < count; i++) {
+    out[i].time = times[readIndex];
+    out[i].pins = pinStates[readIndex] & pinsLogged;
+    readIndex = (readIndex + 1) % EDGELOG_RING_SIZE;
+  }
+  readCount += count;
+
+  return count;
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Current count of the timer the records are stamped with
+ *****************************************************************************/
+uint32_t EDGELOG_GetTime(void)
+{
+  return TIMER_CounterGet(LOG_TIMER);
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Clock frequency of the timer the records are stamped with, Hz
+ *****************************************************************************/
+uint32_t EDGELOG_GetTimerFrequency(void)
+{
+  return CMU_ClockFreqGet(cmuClock_TIMER0);
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Number of records lost because the ring was full
+ *****************************************************************************/
+uint32_t EDGELOG_GetOverrunCount(void)
+{
+  return overruns;
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Number of times edges came faster than the LDMA could store them
+ *
+ * @details
+ *   Each count is at least one edge that was captured but not stored.
+ *****************************************************************************/
+uint32_t EDGELOG_GetMissedCount(void)
+{
+  return missed;
+}
@@ -0,0 +1,229 @@
+/***************************************************************************//**
+ * @file main.c
+ * @brief This project logs the edges on four pins with their time and the
+ * pin states, through PRS, TIMER0 and the LDMA without any interrupt, and
+ * decodes a bit-banged clock and data pattern from the log. See readme.txt
+ * for details.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2021 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ *******************************************************************************
+ * # Evaluation Quality
+ * This code has been minimally tested to ensure that it builds and is suitable 
+ * as a demonstration for evaluation purposes only. This code will be maintained
+ * at the sole discretion of Silicon Labs.
+ ******************************************************************************/
+
+#include "em_device.h"
+#include "em_chip.h"
+#include "em_cmu.h"
+#include "em_gpio.h"
+#include "bsp.h"
+
+#include "edgelog.h"
+
+/*******************************************************************************
+ *******************************   DEFINES   ***********************************
+ ******************************************************************************/
+
+// The push buttons and LEDs are all on port B
+#define LOG_PORT                  gpioPortB
+#define LOG_PINS                  ((1 << BSP_GPIO_PB0_PIN)    \
+                                   | (1 << BSP_GPIO_PB1_PIN)  \
+                                   | (1 << BSP_GPIO_LED0_PIN) \
+                                   | (1 << BSP_GPIO_LED1_PIN))
+
+// Bit-banged pattern: LED1 is the clock, LED0 the data, MSB first
+#define CLOCK_PIN                 BSP_GPIO_LED1_PIN
+#define DATA_PIN                  BSP_GPIO_LED0_PIN
+#define PATTERN                   0xA5
+
+// Time between two pin changes of the pattern and between two patterns
+#define STEP_US                   20
+#define FRAME_PERIOD_MS           100
+
+// A clock rise after this much time without one starts a new byte
+#define FRAME_GAP_US              1000
+
+// Latest records kept for the debugger
+#define TRACE_SIZE                32
+
+/*******************************************************************************
+ ***************************   GLOBAL VARIABLES   *******************************
+ ******************************************************************************/
+
+// Latest records, oldest first, and the timer clock they count
+volatile EDGELOG_Record_t trace[TRACE_SIZE];
+volatile uint32_t timerFrequency;
+
+// Records read and edges of the push buttons among them
+volatile uint32_t edges;
+volatile uint32_t buttonEdges;
+
+// Bytes decoded from the pattern and those that did not match it
+volatile uint32_t bytesDecoded;
+volatile uint32_t decodeErrors;
+volatile uint8_t lastByte;
+
+// Ring overruns and edges too close together, from the logger
+volatile uint32_t overruns;
+volatile uint32_t missed;
+
+// Decoder state
+static uint32_t lastPins;
+static uint32_t lastClockRise;
+static uint32_t shift;
+static uint32_t bits;
+
+static uint32_t ticksPerUs;
+
+/**************************************************************************//**
+ * @brief
+ *    Take one record into the trace and the decoder
+ *****************************************************************************/
+static void decode(const EDGELOG_Record_t *r)
+{
+  uint32_t changed = r->pins ^ lastPins;
+  int i;
+
+  for (i = 0; i < TRACE_SIZE - 1; i++) {
+    trace[i] = trace[i + 1];
+  }
+  trace[TRACE_SIZE - 1] = *r;
+  edges++;
+
+  if (changed & ((1 << BSP_GPIO_PB0_PIN) | (1 << BSP_GPIO_PB1_PIN))) {
+    buttonEdges++;
+  }
+
+  // Sample the data on each rising clock edge
+  if ((changed & (1 << CLOCK_PIN)) && (r->pins & (1 << CLOCK_PIN))) {
+    if (r->time - lastClockRise > FRAME_GAP_US * ticksPerUs) {
+      bits = 0;
+      shift = 0;
+    }
+    lastClockRise = r->time;
+
+    shift = (shift << 1) | ((r->pins >> DATA_PIN) & 1);
+    if (++bits == 8) {
+      lastByte = (uint8_t)shift;
+      bytesDecoded++;
+      if (lastByte != PATTERN) {
+        decodeErrors++;
+      }
+      bits = 0;
+      shift = 0;
+    }
+  }
+
+  lastPins = r->pins;
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Read and decode all records logged so far
+ *****************************************************************************/
+static void drainLog(void)
+{
+  EDGELOG_Record_t records[16];
+  uint32_t n, i;
+
+  do {
+    n = EDGELOG_Read(records, 16);
+    for (i = 0; i < n; i++) {
+      decode(&records[i]);
+    }
+  } while (n);
+
+  overruns = EDGELOG_GetOverrunCount();
+  missed = EDGELOG_GetMissedCount();
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Wait on the logger timer, reading the log meanwhile
+ *****************************************************************************/
+static void waitUs(uint32_t us)
+{
+  uint32_t start = EDGELOG_GetTime();
+
+  while (EDGELOG_GetTime() - start < us * ticksPerUs) {
+    drainLog();
+  }
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Bit-bang one byte on the clock and data pins
+ *****************************************************************************/
+static void sendPattern(uint8_t value)
+{
+  int i;
+
+  for (i = 7; i >= 0; i--) {
+    if (value & (1 << i)) {
+      GPIO_PinOutSet(LOG_PORT, DATA_PIN);
+    } else {
+      GPIO_PinOutClear(LOG_PORT, DATA_PIN);
+    }
+    waitUs(STEP_US);
+    GPIO_PinOutSet(LOG_PORT, CLOCK_PIN);
+    waitUs(STEP_US);
+    GPIO_PinOutClear(LOG_PORT, CLOCK_PIN);
+    waitUs(STEP_US);
+  }
+  GPIO_PinOutClear(LOG_PORT, DATA_PIN);
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Main function
+ *****************************************************************************/
+int main(void)
+{
+  CHIP_Init();
+
+  CMU_ClockEnable(cmuClock_GPIO, true);
+
+  // Push buttons as inputs, LEDs as the clock and data outputs
+  GPIO_PinModeSet(BSP_GPIO_PB0_PORT, BSP_GPIO_PB0_PIN, gpioModeInputPullFilter, 1);
+  GPIO_PinModeSet(BSP_GPIO_PB1_PORT, BSP_GPIO_PB1_PIN, gpioModeInputPullFilter, 1);
+  GPIO_PinModeSet(BSP_GPIO_LED0_PORT, BSP_GPIO_LED0_PIN, gpioModePushPull, 0);
+  GPIO_PinModeSet(BSP_GPIO_LED1_PORT, BSP_GPIO_LED1_PIN, gpioModePushPull, 0);
+
+  if (!EDGELOG_Start(LOG_PORT, LOG_PINS)) {
+    // Not enough PRS channels
+    __BKPT(0);
+  }
+
+  timerFrequency = EDGELOG_GetTimerFrequency();
+  ticksPerUs = timerFrequency / 1000000;
+  lastPins = GPIO_PortInGet(LOG_PORT) & LOG_PINS;
+
+  while (1) {
+    sendPattern(PATTERN);
+    waitUs(FRAME_PERIOD_MS * 1000);
+  }
+}
@@ -47,6 +47,57 @@
 #define EM4WU_EM4WUEN_NUM   (9)                       // PD2 is EM4WUEN pin 9
 #define EM4WU_EM4WUEN_MASK  (1 << EM4WU_EM4WUEN_NUM)
 
+// Presses counted in EM4 for each full wake that toggles the LEDs
+#define PRESSES_PER_WAKE    4
+
+// BURAM retention register that keeps the press count through EM4
+#define PRESS_COUNT_RET     0
+
+// Presses counted so far, for the debugger
+uint32_t pressCount;
+
+/**************************************************************************//**
+ * @brief
+ *   Handle a button wake from EM4 before any other initialization
+ *
+ * @details
+ *   Called first in main(), before CHIP_Init() and the clock and GPIO
+ *   setup. A press only counts up in a BURAM retention register, which
+ *   keeps its value in EM4, and goes straight back to EM4 once the button
+ *   is released. Only every PRESSES_PER_WAKE press returns for the full
+ *   initialization. Any other wake returns at once.
+ *****************************************************************************/
+void fastWake(void)
+{
+  uint32_t presses;
+
+  // Only an EM4 wake by the button is handled here
+  if (!(RMU_ResetCauseGet() & EMU_RSTCAUSE_EM4)
+      || !(GPIO_EM4GetPinWakeupCause()
+           & (EM4WU_EM4WUEN_MASK << _GPIO_EM4WUEN_EM4WUEN_SHIFT)))
+  {
+    return;
+  }
+
+  presses = BURAM->RET[PRESS_COUNT_RET].REG + 1;
+  BURAM->RET[PRESS_COUNT_RET].REG = presses;
+  if (presses % PRESSES_PER_WAKE == 0)
+  {
+    return;
+  }
+
+  RMU_ResetCauseClear();
+
+  // The GPIO is reset by the wake, wait for the release before EM4 again
+  GPIO_PinModeSet(EM4WU_PORT, EM4WU_PIN, gpioModeInputPullFilter, 1);
+  while (GPIO_PinInGet(EM4WU_PORT, EM4WU_PIN) == 0);
+  GPIO_EM4EnablePinWakeup(EM4WU_EM4WUEN_MASK << _GPIO_EM4WUEN_EM4WUEN_SHIFT, 0);
+
+  EMU_EM4Init_TypeDef em4Init = EMU_EM4INIT_DEFAULT;
+  EMU_EM4Init(&em4Init);
+  EMU_EnterEM4();
+}
+
 /**************************************************************************//**
  * @brief  Initialize GPIOs for push button and LED
  *****************************************************************************/
@@ -79,6 +130,9 @@ void toggleLEDs(void)
  *****************************************************************************/
 int main(void)
 {
+  // Count a press and go back to EM4 unless a full wake is due
+  fastWake();
+
   // Chip errata
   CHIP_Init();
 
@@ -95,10 +149,13 @@ int main(void)
   // If the last Reset was due to leaving EM4, toggle LEDs. Else, enter EM4
   if(rstCause & EMU_RSTCAUSE_EM4)
   {
+    pressCount = BURAM->RET[PRESS_COUNT_RET].REG;
     toggleLEDs();
   }
   else
   {
+    // Start counting presses from zero
+    BURAM->RET[PRESS_COUNT_RET].REG = 0;
 	EMU_EnterEM4();
   }
 
@@ -43,6 +43,15 @@
 #include "mx25flash_spi.h"
 #include "bsp.h"
 
+// Presses counted in EM4 for each full wake that toggles the LEDs
+#define PRESSES_PER_WAKE    4
+
+// BURAM retention register that keeps the press count through EM4
+#define PRESS_COUNT_RET     0
+
+// Presses counted so far, for the debugger
+uint32_t pressCount;
+
 /**************************************************************************//**
  * A JEDEC standard SPI flash boots up in standby mode in order to
  * provide immediate access, such as when used it as a boot memory.
@@ -101,6 +110,60 @@ void toggleLEDs(void)
   }
 }
 
+/**************************************************************************//**
+ * @brief
+ *   Handle a button wake from EM4 before any other initialization
+ *
+ * @details
+ *   Called first in main(), before CHIP_Init(), the DCDC and the GPIO
+ *   setup. A press only counts up in a BURAM retention register, which
+ *   keeps its value in EM4, and goes straight back to EM4 once the button
+ *   is released. Only every PRESSES_PER_WAKE press returns for the full
+ *   initialization. Any other wake returns at once.
+ *
+ *   The wake resets the GPIO registers while the pins are still latched,
+ *   so the pins in use are set back as they were before they are
+ *   unlatched, and the LEDs never glitch. The DCDC is still in bypass from
+ *   before EM4 and is left so.
+ *****************************************************************************/
+void fastWake(void)
+{
+  uint32_t presses;
+
+  CMU_ClockEnable(cmuClock_GPIO, true);
+
+  // Only an EM4 wake by the button is handled here
+  if (!(RMU_ResetCauseGet() & EMU_RSTCAUSE_EM4)
+      || !(GPIO_EM4GetPinWakeupCause() & GPIO_IEN_EM4WUIEN4))
+  {
+    return;
+  }
+
+  CMU_ClockEnable(cmuClock_BURAM, true);
+  presses = BURAM->RET[PRESS_COUNT_RET].REG + 1;
+  BURAM->RET[PRESS_COUNT_RET].REG = presses;
+  if (presses % PRESSES_PER_WAKE == 0)
+  {
+    return;
+  }
+
+  RMU_ResetCauseClear();
+
+  GPIO_PinModeSet(BSP_GPIO_PB1_PORT, BSP_GPIO_PB1_PIN, gpioModeInputPullFilter, 1);
+  GPIO_PinModeSet(BSP_GPIO_LED0_PORT, BSP_GPIO_LED0_PIN, gpioModePushPull, 0);
+  GPIO_PinModeSet(BSP_GPIO_LED1_PORT, BSP_GPIO_LED1_PIN, gpioModePushPull, 0);
+  EMU_UnlatchPinRetention();
+
+  // Wait for the release before EM4 again
+  while (GPIO_PinInGet(BSP_GPIO_PB1_PORT, BSP_GPIO_PB1_PIN) == 0);
+  GPIO_EM4EnablePinWakeup(GPIO_IEN_EM4WUIEN4, 0);
+
+  EMU_EM4Init_TypeDef em4Init = EMU_EM4INIT_DEFAULT;
+  em4Init.pinRetentionMode = emuPinRetentionLatch;
+  EMU_EM4Init(&em4Init);
+  EMU_EnterEM4();
+}
+
 /**************************************************************************//**
  * @brief Main function
  *****************************************************************************/
@@ -108,6 +171,9 @@ int main(void)
 {
   EMU_DCDCInit_TypeDef dcdcInit = EMU_DCDCINIT_DEFAULT;
 
+  // Count a press and go back to EM4 unless a full wake is due
+  fastWake();
+
   CHIP_Init();
 
   // Turn on DCDC regulator
@@ -150,10 +216,16 @@ int main(void)
   // If the last Reset was due to leaving EM4, toggle LEDs. Else, enter EM4
   if(rstCause & EMU_RSTCAUSE_EM4)
   {
+    CMU_ClockEnable(cmuClock_BURAM, true);
+    pressCount = BURAM->RET[PRESS_COUNT_RET].REG;
     toggleLEDs();
   }
   else
   {
+    // Start counting presses from zero
+    CMU_ClockEnable(cmuClock_BURAM, true);
+    BURAM->RET[PRESS_COUNT_RET].REG = 0;
+
     // Power-down the radio board SPI flash
     powerDownSpiFlash();
 
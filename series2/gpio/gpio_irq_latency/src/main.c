@@ -0,0 +1,236 @@
+/***************************************************************************//**
+ * @file main.c
+ * @brief This project measures the latency from a GPIO edge to the first
+ * instruction of its interrupt handler with the vector table and the handler
+ * in flash and in RAM. See readme.txt for details.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2021 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ *******************************************************************************
+ * # Evaluation Quality
+ * This code has been minimally tested to ensure that it builds and is suitable 
+ * as a demonstration for evaluation purposes only. This code will be maintained
+ * at the sole discretion of Silicon Labs.
+ ******************************************************************************/
+
+#include "em_device.h"
+#include "em_chip.h"
+#include "em_cmu.h"
+#include "em_gpio.h"
+#include "em_ramfunc.h"
+#include "ramvectors.h"
+
+/*******************************************************************************
+ *******************************   DEFINES   ***********************************
+ ******************************************************************************/
+
+// Core clock. Above 40 MHz flash reads take a wait state.
+#define CORE_FREQ                 cmuHFRCODPLLFreq_64M0Hz
+
+// Edges measured per configuration
+#define RUN_EDGES                 1000
+
+/*
+ * Output that makes the edge, read back through its own input. The pin
+ * drives the edge and its input synchronizer takes it to the interrupt,
+ * as it would for an edge from outside. PC05 is odd, so the edge raises
+ * GPIO_ODD_IRQn.
+ */
+#define EDGE_PORT                 gpioPortC
+#define EDGE_PIN                  5
+#define EDGE_IRQn                 GPIO_ODD_IRQn
+
+/*******************************************************************************
+ ***************************   GLOBAL VARIABLES   *******************************
+ ******************************************************************************/
+
+// Latency of one placement of the vector table and the handler
+typedef struct {
+  bool ramVectors;          // Vector table in RAM, else in flash
+  bool ramHandler;          // Handler in RAM, else in flash
+  bool cacheFlushed;        // Instruction cache flushed before each edge
+  uint32_t edges;           // Edges in the statistics
+  uint32_t cyclesMin;       // Edge written to first handler instruction
+  uint32_t cyclesMax;
+  float cyclesMean;
+  uint32_t jitter;          // cyclesMax - cyclesMin
+  float latencyMin;         // The same in ns
+  float latencyMean;
+  float latencyMax;
+} IrqResult_t;
+
+#define NUM_RUNS                  6
+
+static volatile IrqResult_t results[NUM_RUNS] = {
+  { .ramVectors = false, .ramHandler = false, .cacheFlushed = false },
+  { .ramVectors = true,  .ramHandler = false, .cacheFlushed = false },
+  { .ramVectors = true,  .ramHandler = true,  .cacheFlushed = false },
+  { .ramVectors = false, .ramHandler = false, .cacheFlushed = true },
+  { .ramVectors = true,  .ramHandler = false, .cacheFlushed = true },
+  { .ramVectors = true,  .ramHandler = true,  .cacheFlushed = true },
+};
+
+// Passes completed over all configurations
+static volatile uint32_t passes;
+
+// Cycle counter when the handler starts, 0 until then
+static volatile uint32_t entryCycles;
+
+/**************************************************************************//**
+ * @brief
+ *    Edge interrupt handler in flash, in the vector table of the startup
+ *    code
+ *
+ * @details
+ *    The cycle counter is read first. Registers are written directly,
+ *    the emlib functions are not inlined without optimization and would
+ *    be called in flash from the RAM handler below, which does the same.
+ *****************************************************************************/
+void GPIO_ODD_IRQHandler(void)
+{
+  entryCycles = DWT->CYCCNT;
+  GPIO->IF_CLR = 1 << EDGE_PIN;
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Edge interrupt handler in RAM, installed in the RAM vector table
+ *****************************************************************************/
+SL_RAMFUNC_DEFINITION_BEGIN
+static void ramEdgeHandler(void)
+{
+  entryCycles = DWT->CYCCNT;
+  GPIO->IF_CLR = 1 << EDGE_PIN;
+}
+SL_RAMFUNC_DEFINITION_END
+
+/**************************************************************************//**
+ * @brief
+ *    Set up the edge pin and its interrupt
+ *****************************************************************************/
+static void initEdge(void)
+{
+  CMU_ClockEnable(cmuClock_GPIO, true);
+
+  // Push-pull output, its input stays enabled
+  GPIO_PinModeSet(EDGE_PORT, EDGE_PIN, gpioModePushPull, 0);
+
+  // Rising edge only, external interrupt EDGE_PIN
+  GPIO_ExtIntConfig(EDGE_PORT, EDGE_PIN, EDGE_PIN, true, false, true);
+
+  NVIC_ClearPendingIRQ(EDGE_IRQn);
+  NVIC_EnableIRQ(EDGE_IRQn);
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Measure one configuration
+ *
+ * @param[in] r
+ *    Configuration, its statistics are filled in
+ *****************************************************************************/
+static void measure(volatile IrqResult_t *r)
+{
+  uint32_t start, cycles, i;
+  uint32_t min = 0xFFFFFFFF, max = 0;
+  uint64_t sum = 0;
+
+  if (r->ramVectors) {
+    RAMVECTORS_Init();
+    RAMVECTORS_SetHandler(EDGE_IRQn,
+                          r->ramHandler ? ramEdgeHandler : GPIO_ODD_IRQHandler);
+  } else {
+    RAMVECTORS_Deinit();
+  }
+
+  for (i = 0; i < RUN_EDGES; i++) {
+    GPIO_PinOutClear(EDGE_PORT, EDGE_PIN);
+    entryCycles = 0;
+
+    /*
+     * Flushing the cache makes the flash placements fetch their vector and
+     * handler from the flash itself, as they do when other code has
+     * evicted them between two interrupts of a control loop.
+     */
+    if (r->cacheFlushed) {
+      ICACHE0->CMD = ICACHE_CMD_FLUSH;
+    }
+
+    // Make the edge, the register write is part of the latency
+    start = DWT->CYCCNT;
+    GPIO->P_SET[EDGE_PORT].DOUT = 1 << EDGE_PIN;
+    while (entryCycles == 0) {
+    }
+
+    cycles = entryCycles - start;
+    sum += cycles;
+    if (cycles < min) {
+      min = cycles;
+    }
+    if (cycles > max) {
+      max = cycles;
+    }
+  }
+
+  GPIO_PinOutClear(EDGE_PORT, EDGE_PIN);
+
+  r->edges = RUN_EDGES;
+  r->cyclesMin = min;
+  r->cyclesMax = max;
+  r->cyclesMean = (float)sum / RUN_EDGES;
+  r->jitter = max - min;
+  r->latencyMin = min * 1e9f / SystemCoreClock;
+  r->latencyMean = r->cyclesMean * 1e9f / SystemCoreClock;
+  r->latencyMax = max * 1e9f / SystemCoreClock;
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Main function
+ *****************************************************************************/
+int main(void)
+{
+  int i;
+
+  CHIP_Init();
+
+  // Set the core clock, emlib sets the flash wait states with it
+  CMU_HFRCODPLLBandSet(CORE_FREQ);
+
+  // Start the cycle counter
+  CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+  DWT->CYCCNT = 0;
+  DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+  initEdge();
+
+  // Measure all configurations, over and over
+  while (1) {
+    for (i = 0; i < NUM_RUNS; i++) {
+      measure(&results[i]);
+    }
+    passes++;
+  }
+}
@@ -0,0 +1,79 @@
+/***************************************************************************//**
+ * @file slewsweep.h
+ *
+ * @brief Slew rate sweep: the highest error-free SPI loopback rate of each
+ * GPIO slew rate setting.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2020 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ******************************************************************************/
+
+#ifndef SLEWSWEEP_H
+#define SLEWSWEEP_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "em_gpio.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// USART0 SPI loopback: TX, the pin under test, must be wired to RX. All
+// three pins are on the same port, the setting is per port.
+#define SWEEP_PORT          gpioPortC
+#define SWEEP_TX_PIN        0
+#define SWEEP_RX_PIN        1
+#define SWEEP_CLK_PIN       2
+
+// HFRCODPLL band during the sweep, the SPI clock is at most half of it
+#define SWEEP_CLOCK_BAND    cmuHFRCODPLLFreq_38M0Hz
+
+// SPI clock dividers tried, the rate is PCLK / (2 * divider), from the
+// slowest rate up to PCLK / 2
+#define SWEEP_MAX_DIVIDER   16
+
+// Bytes sent and checked at each rate
+#ifndef SWEEP_TEST_BYTES
+#define SWEEP_TEST_BYTES    1024
+#endif
+
+// Slew rate settings, 0 to 7; 0 is also the low drive strength
+#define SWEEP_SETTINGS      8
+
+// Result of one slew rate setting
+typedef struct {
+  uint32_t maxRate;         // Highest rate without errors, bit/s, 0 if none
+  uint32_t failRate;        // Next rate up, where errors showed, 0 if none
+  uint32_t failErrors;      // Bytes wrong at failRate
+} SWEEP_Result_t;
+
+bool SWEEP_Run(SWEEP_Result_t results[SWEEP_SETTINGS]);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SLEWSWEEP_H
@@ -39,6 +39,7 @@
 #include "em_timer.h"
 #include "em_emu.h"
 #include "bsp.h"
+#include "slewsweep.h"
 
 #define SQUARE_WAVE_PORT gpioPortC
 #define SQUARE_WAVE_PIN  0
@@ -48,6 +49,11 @@
 
 uint32_t slewRate = 6;	// Default slew rate
 
+// Highest error-free SPI rate of each slew rate setting, and whether the
+// loopback wire was found
+SWEEP_Result_t sweepResults[SWEEP_SETTINGS];
+bool sweepLooped;
+
 /**************************************************************************//**
  * @brief Setup GPIO interrupt for pushbuttons and PA0 output.
  *****************************************************************************/
@@ -134,6 +140,10 @@ int main(void)
   // Chip errata
   CHIP_Init();
 
+  // Characterize the slew rate settings first, before PC00 is taken over
+  // by the square wave; needs PC00 wired to PC01
+  sweepLooped = SWEEP_Run(sweepResults);
+
   // Initialize Push Buttons and PA0
   gpioSetup();
   
@@ -0,0 +1,223 @@
+/***************************************************************************//**
+ * @file slewsweep.c
+ *
+ * @brief Slew rate sweep: the highest error-free SPI loopback rate of each
+ * GPIO slew rate setting.
+ *
+ * USART0 runs as an SPI master with its TX pin wired back to its RX pin on
+ * the board, so every byte sent is also received through the pin driver
+ * and the wire. For each slew rate setting of the port the SPI clock is
+ * stepped up from PCLK / (2 * SWEEP_MAX_DIVIDER) to PCLK / 2, and a test
+ * pattern is sent and compared at each rate. The sweep of a setting stops
+ * at the first rate with errors: the rate below it is the highest one the
+ * pin and its load carry without errors at that setting.
+ *
+ * Slower edges cut the emissions and the supply noise of a bus, but eat
+ * into the bit time, so the results show the lowest setting that still
+ * carries the rate a bus needs. Load the TX pin like the real bus, with the
+ * same trace length or a capacitor, to see the same limits.
+ *
+ * Even bytes of the pattern are 0x55 and 0xAA in turn, the most edges, odd
+ * bytes come from a 16-bit LFSR, for runs of equal bits. The SPI master
+ * samples RX on its own clock, so the delay of the edges through the pin
+ * counts.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2020 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ *******************************************************************************
+ * # Evaluation Quality
+ * This code has been minimally tested to ensure that it builds and is suitable
+ * as a demonstration for evaluation purposes only. This code will be maintained
+ * at the sole discretion of Silicon Labs.
+ ******************************************************************************/
+
+#include "em_device.h"
+#include "em_cmu.h"
+#include "em_gpio.h"
+#include "em_usart.h"
+
+#include "slewsweep.h"
+
+// Seed of the test pattern LFSR, any value but zero
+#define PATTERN_SEED    0xACE1U
+
+/**************************************************************************//**
+ * @brief
+ *   Byte i of the test pattern, odd bytes from the LFSR
+ *****************************************************************************/
+static uint8_t patternByte(uint32_t i, uint16_t *lfsr)
+{
+  uint16_t l = *lfsr;
+
+  if ((i & 1) == 0) {
+    return (i & 2) ? 0xAA : 0x55;
+  }
+
+  // Galois LFSR, x^16 + x^14 + x^13 + x^11 + 1
+  l = (l >> 1) ^ ((l & 1) ? 0xB400U : 0);
+  *lfsr = l;
+  return (uint8_t)l;
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Send the test pattern at the current rate, count the bytes received
+ *   wrong
+ *****************************************************************************/
+static uint32_t countErrors(void)
+{
+  uint16_t lfsr = PATTERN_SEED;
+  uint32_t errors = 0;
+  uint32_t i;
+  uint8_t tx;
+
+  for (i = 0; i < SWEEP_TEST_BYTES; i++) {
+    tx = patternByte(i, &lfsr);
+    if (USART_SpiTransfer(USART0, tx) != tx) {
+      errors++;
+    }
+  }
+
+  return errors;
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Set the SPI clock to PCLK / (2 * divider)
+ *
+ * @details
+ *   USART_BaudrateSyncSet() rounds the divider for the rate asked, so the
+ *   integer divider is written directly; its integer part starts at bit 8.
+ *****************************************************************************/
+static void setDivider(uint32_t divider)
+{
+  USART0->CLKDIV = (divider - 1) << 8;
+}
+
+/**************************************************************************//**
+ * @brief
+ *   USART0 as an SPI master on the sweep pins
+ *****************************************************************************/
+static void initUsart(void)
+{
+  USART_InitSync_TypeDef init = USART_INITSYNC_DEFAULT;
+
+  // Enable clocks. Note this is not required for EFR32xG21
+  CMU_ClockEnable(cmuClock_GPIO, true);
+  CMU_ClockEnable(cmuClock_USART0, true);
+
+  GPIO_PinModeSet(SWEEP_PORT, SWEEP_TX_PIN, gpioModePushPull, 0);
+  GPIO_PinModeSet(SWEEP_PORT, SWEEP_RX_PIN, gpioModeInput, 0);
+  GPIO_PinModeSet(SWEEP_PORT, SWEEP_CLK_PIN, gpioModePushPull, 0);
+
+  init.msbf = true;
+  USART_InitSync(USART0, &init);
+
+  GPIO->USARTROUTE[0].TXROUTE = (SWEEP_PORT << _GPIO_USART_TXROUTE_PORT_SHIFT)
+                                | (SWEEP_TX_PIN << _GPIO_USART_TXROUTE_PIN_SHIFT);
+  GPIO->USARTROUTE[0].RXROUTE = (SWEEP_PORT << _GPIO_USART_RXROUTE_PORT_SHIFT)
+                                | (SWEEP_RX_PIN << _GPIO_USART_RXROUTE_PIN_SHIFT);
+  GPIO->USARTROUTE[0].CLKROUTE = (SWEEP_PORT << _GPIO_USART_CLKROUTE_PORT_SHIFT)
+                                 | (SWEEP_CLK_PIN << _GPIO_USART_CLKROUTE_PIN_SHIFT);
+  GPIO->USARTROUTE[0].ROUTEEN = GPIO_USART_ROUTEEN_TXPEN
+                                | GPIO_USART_ROUTEEN_CLKPEN;
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Give the sweep pins and USART0 back, all disabled
+ *****************************************************************************/
+static void deinitUsart(void)
+{
+  USART_Reset(USART0);
+  GPIO->USARTROUTE[0].ROUTEEN = 0;
+
+  GPIO_PinModeSet(SWEEP_PORT, SWEEP_TX_PIN, gpioModeDisabled, 0);
+  GPIO_PinModeSet(SWEEP_PORT, SWEEP_RX_PIN, gpioModeDisabled, 0);
+  GPIO_PinModeSet(SWEEP_PORT, SWEEP_CLK_PIN, gpioModeDisabled, 0);
+
+  CMU_ClockEnable(cmuClock_USART0, false);
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Find the highest error-free SPI rate of each slew rate setting
+ *
+ * @details
+ *   Runs the core at SWEEP_CLOCK_BAND for the sweep and restores the band
+ *   it ran at before, and leaves the slew rate of SWEEP_PORT at the last
+ *   setting swept, 7.
+ *
+ * @param[out] results
+ *   One result per setting, indexed by the setting.
+ *
+ * @return
+ *   false if the TX pin is not wired to the RX pin: the pattern did not
+ *   come back at the slowest rate and the strongest setting, and all
+ *   results are 0.
+ *****************************************************************************/
+bool SWEEP_Run(SWEEP_Result_t results[SWEEP_SETTINGS])
+{
+  CMU_HFRCODPLLFreq_TypeDef band = CMU_HFRCODPLLBandGet();
+  uint32_t setting, divider, errors, rate;
+  bool looped;
+
+  CMU_HFRCODPLLBandSet(SWEEP_CLOCK_BAND);
+  initUsart();
+
+  // Check the wire where the pin is sure to keep up
+  GPIO_SlewrateSet(SWEEP_PORT, SWEEP_SETTINGS - 1, SWEEP_SETTINGS - 1);
+  setDivider(SWEEP_MAX_DIVIDER);
+  looped = (countErrors() == 0);
+
+  for (setting = 0; setting < SWEEP_SETTINGS; setting++) {
+    results[setting].maxRate = 0;
+    results[setting].failRate = 0;
+    results[setting].failErrors = 0;
+
+    if (!looped) {
+      continue;
+    }
+
+    GPIO_SlewrateSet(SWEEP_PORT, setting, setting);
+
+    for (divider = SWEEP_MAX_DIVIDER; divider >= 1; divider--) {
+      setDivider(divider);
+      rate = USART_BaudrateGet(USART0);
+      errors = countErrors();
+      if (errors != 0) {
+        results[setting].failRate = rate;
+        results[setting].failErrors = errors;
+        break;
+      }
+      results[setting].maxRate = rate;
+    }
+  }
+
+  deinitUsart();
+  CMU_HFRCODPLLBandSet(band);
+
+  return looped;
+}
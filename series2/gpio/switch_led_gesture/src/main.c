@@ -0,0 +1,161 @@
+/***************************************************************************//**
+ * @file main.c
+ * @brief This project detects clicks, double clicks and long presses of the
+ * push buttons with the gesture kit driver. The button edges start a LETIMER
+ * settle window through the PRS, so the bounce of the contacts does not wake
+ * the CPU, and the device stays in EM2 in between. See readme.txt for
+ * details.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2022 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ *******************************************************************************
+ * # Evaluation Quality
+ * This code has been minimally tested to ensure that it builds and is suitable 
+ * as a demonstration for evaluation purposes only. This code will be maintained
+ * at the sole discretion of Silicon Labs.
+ ******************************************************************************/
+
+#include "em_device.h"
+#include "em_chip.h"
+#include "em_cmu.h"
+#include "em_emu.h"
+#include "em_gpio.h"
+#include "bsp.h"
+
+#include "gesture.h"
+
+// Buttons, in the order of the button numbers passed to the callback
+static const GESTURE_Button_TypeDef buttons[] = {
+  { BSP_GPIO_PB0_PORT, BSP_GPIO_PB0_PIN },
+  { BSP_GPIO_PB1_PORT, BSP_GPIO_PB1_PIN },
+};
+
+#define BUTTONS                   (sizeof(buttons) / sizeof(buttons[0]))
+
+// Gestures of each button, and the wakes it took to find them
+volatile uint32_t clicks[BUTTONS];
+volatile uint32_t doubleClicks[BUTTONS];
+volatile uint32_t longPresses[BUTTONS];
+volatile GESTURE_Counters_TypeDef counters;
+
+/**************************************************************************//**
+ * @brief escapeHatch()
+ * When developing or debugging code that enters EM2 or
+ * lower, it's a good idea to have an "escape hatch" type
+ * mechanism, e.g. a way to pause the device so that a debugger can
+ * connect in order to erase flash, among other things.
+ * Before proceeding with this example, make sure PB0 is not pressed.
+ * If the PB0 pin is low, turn on LED0 and execute the breakpoint
+ * instruction to stop the processor in EM0 and allow a debug
+ * connection to be made.
+ *****************************************************************************/
+void escapeHatch(void)
+{
+  CMU_ClockEnable(cmuClock_GPIO, true);
+  GPIO_PinModeSet(BSP_GPIO_PB0_PORT, BSP_GPIO_PB0_PIN, gpioModeInputPullFilter, 1);
+  if (GPIO_PinInGet(BSP_GPIO_PB0_PORT, BSP_GPIO_PB0_PIN) == 0) {
+    GPIO_PinModeSet(BSP_GPIO_LED0_PORT, BSP_GPIO_LED0_PIN, gpioModePushPull, 1);
+    __BKPT(0);
+  }
+  // Pin not asserted, so disable input
+  else {
+    GPIO_PinModeSet(BSP_GPIO_PB0_PORT, BSP_GPIO_PB0_PIN, gpioModeDisabled, 0);
+    CMU_ClockEnable(cmuClock_GPIO, false);
+  }
+}
+
+/**************************************************************************//**
+ * @brief Gesture callback, from the LETIMER0 and BURTC interrupts
+ *
+ * @details
+ *    A click toggles the LED of the button, a double click toggles both
+ *    LEDs, and a long press turns both LEDs off.
+ *****************************************************************************/
+static void onGesture(uint32_t button, GESTURE_Event_TypeDef event)
+{
+  switch (event) {
+    case gestureClick:
+      clicks[button]++;
+      if (button == 0) {
+        GPIO_PinOutToggle(BSP_GPIO_LED0_PORT, BSP_GPIO_LED0_PIN);
+      } else {
+        GPIO_PinOutToggle(BSP_GPIO_LED1_PORT, BSP_GPIO_LED1_PIN);
+      }
+      break;
+
+    case gestureDoubleClick:
+      doubleClicks[button]++;
+      GPIO_PinOutToggle(BSP_GPIO_LED0_PORT, BSP_GPIO_LED0_PIN);
+      GPIO_PinOutToggle(BSP_GPIO_LED1_PORT, BSP_GPIO_LED1_PIN);
+      break;
+
+    case gestureLongPress:
+      longPresses[button]++;
+      GPIO_PinOutClear(BSP_GPIO_LED0_PORT, BSP_GPIO_LED0_PIN);
+      GPIO_PinOutClear(BSP_GPIO_LED1_PORT, BSP_GPIO_LED1_PIN);
+      break;
+
+    default:
+      break;
+  }
+}
+
+/**************************************************************************//**
+ * @brief  Main function
+ *****************************************************************************/
+int main(void)
+{
+  GESTURE_Init_TypeDef init;
+  GESTURE_Counters_TypeDef count;
+
+  // Chip errata
+  CHIP_Init();
+
+  // Recommended recovery procedure for code in development
+  escapeHatch();
+
+  // The LETIMER and the BURTC count the LFRCO, which runs in EM2
+  CMU_ClockSelectSet(cmuClock_EM23GRPACLK, cmuSelect_LFRCO);
+  CMU_ClockSelectSet(cmuClock_EM4GRPACLK, cmuSelect_LFRCO);
+
+  CMU_ClockEnable(cmuClock_GPIO, true);
+  GPIO_PinModeSet(BSP_GPIO_LED0_PORT, BSP_GPIO_LED0_PIN, gpioModePushPull, 0);
+  GPIO_PinModeSet(BSP_GPIO_LED1_PORT, BSP_GPIO_LED1_PIN, gpioModePushPull, 0);
+
+  init.buttons = buttons;
+  init.count = BUTTONS;
+  init.callback = onGesture;
+  if (!GESTURE_Init(&init)) {
+    while (1) ;
+  }
+
+  while (1) {
+    // Only the end of a settle window or a gesture time wakes the device
+    EMU_EnterEM2(true);
+
+    GESTURE_GetCounters(&count);
+    counters = count;
+  }
+}
@@ -0,0 +1,69 @@
+/***************************************************************************//**
+ * @file i2cregmap.h
+ *
+ * @brief I2C0 follower serving a 256-byte register map. Reads are sent by
+ * the LDMA from a snapshot of the map, the application prepares the next
+ * snapshot in a second copy and swaps it in between transactions.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2022 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ******************************************************************************/
+
+#ifndef I2CREGMAP_H
+#define I2CREGMAP_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Size of the register map, the target address is one byte
+#define I2CRM_SIZE            256
+
+// Set to 0 to send read data from the I2C interrupt one byte at a time
+#ifndef I2CRM_USE_LDMA
+#define I2CRM_USE_LDMA        1
+#endif
+
+// LDMA channel for reads
+#define I2CRM_LDMA_CHANNEL    0
+
+// Byte sent when the leader reads past the end of the map
+#define I2CRM_FILL_BYTE       0xFF
+
+void I2CRM_Init(uint8_t address);
+uint8_t *I2CRM_GetBackBuffer(void);
+void I2CRM_Publish(void);
+bool I2CRM_IsBusy(void);
+uint32_t I2CRM_GetTransactionCount(void);
+uint32_t I2CRM_GetErrorCount(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // I2CREGMAP_H
@@ -0,0 +1,397 @@
+/***************************************************************************//**
+ * @file i2cregmap.c
+ *
+ * @brief I2C0 follower serving a 256-byte register map.
+ *
+ * The leader writes a one byte target address, optionally followed by data
+ * for the registers from there on. A read starts at the last target
+ * address. With I2CRM_USE_LDMA the address match interrupt starts an LDMA
+ * transfer from the target address to the end of the map, followed by
+ * I2CRM_FILL_BYTE for as long as the leader keeps reading. The rest of the
+ * read costs no interrupts until the STOP.
+ *
+ * Reads are served from the front copy of the map. The application writes
+ * the next snapshot into the back copy and publishes it, the copies are
+ * swapped at once if no read is running or else at the end of the read, so
+ * the leader never gets a mix of two snapshots. Writes from the leader go
+ * to both copies.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2022 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ *******************************************************************************
+ * # Evaluation Quality
+ * This code has been minimally tested to ensure that it builds and is suitable 
+ * as a demonstration for evaluation purposes only. This code will be maintained
+ * at the sole discretion of Silicon Labs.
+ ******************************************************************************/
+
+#include <stddef.h>
+
+#include "em_device.h"
+#include "em_cmu.h"
+#include "em_core.h"
+#include "em_gpio.h"
+#include "em_i2c.h"
+
+#include "i2cregmap.h"
+
+#if I2CRM_USE_LDMA
+#include "em_ldma.h"
+#endif
+
+// I2C pins, PA5 (SDA) and PA6 (SCL)
+#define I2CRM_SDA_PORT  gpioPortA
+#define I2CRM_SDA_PIN   5
+#define I2CRM_SCL_PORT  gpioPortA
+#define I2CRM_SCL_PIN   6
+
+// Register map copies, reads are served from regMap[front]
+static uint8_t regMap[2][I2CRM_SIZE];
+static volatile uint32_t front;
+static volatile bool swapPending;
+
+// Target address, set by the first byte of a write
+static uint32_t targetAddress;
+static bool gotTargetAddress;
+
+// Transaction state
+static volatile bool busy;
+static volatile bool reading;
+static volatile uint32_t transactionCount;
+static volatile uint32_t errorCount;
+
+#if I2CRM_USE_LDMA
+// Map from the target address on, then the fill byte forever
+static LDMA_Descriptor_t readDescriptors[2];
+static LDMA_TransferCfg_t txConfig;
+static const uint8_t fillByte = I2CRM_FILL_BYTE;
+#else
+// Next register to send
+static uint32_t readIndex;
+#endif
+
+/**************************************************************************//**
+ * @brief
+ *    Make the back copy of the map the one that is read
+ *****************************************************************************/
+static void swapMaps(void)
+{
+  front ^= 1;
+  swapPending = false;
+}
+
+#if !I2CRM_USE_LDMA
+/**************************************************************************//**
+ * @brief
+ *    Send the next byte of a read
+ *****************************************************************************/
+static void sendByte(void)
+{
+  if (readIndex < I2CRM_SIZE) {
+    I2C0->TXDATA = regMap[front][readIndex++];
+  } else {
+    // Past the end of the map, transfer data as if follower non-responsive
+    I2C0->TXDATA = I2CRM_FILL_BYTE;
+  }
+}
+#endif
+
+/**************************************************************************//**
+ * @brief
+ *    Start sending the map from the target address
+ *****************************************************************************/
+static void startRead(void)
+{
+  reading = true;
+
+#if I2CRM_USE_LDMA
+  readDescriptors[1] = (LDMA_Descriptor_t)LDMA_DESCRIPTOR_LINKREL_M2P_BYTE(
+    &fillByte, &I2C0->TXDATA, 1, 0);
+  readDescriptors[1].xfer.srcInc = ldmaCtrlSrcIncNone;
+
+  if (targetAddress < I2CRM_SIZE) {
+    readDescriptors[0] = (LDMA_Descriptor_t)LDMA_DESCRIPTOR_LINKREL_M2P_BYTE(
+      &regMap[front][targetAddress], &I2C0->TXDATA, I2CRM_SIZE - targetAddress, 1);
+    LDMA_StartTransfer(I2CRM_LDMA_CHANNEL, &txConfig, &readDescriptors[0]);
+  } else {
+    // A write up to the last register leaves nothing but the fill byte
+    LDMA_StartTransfer(I2CRM_LDMA_CHANNEL, &txConfig, &readDescriptors[1]);
+  }
+#else
+  readIndex = targetAddress;
+  sendByte();
+#endif
+}
+
+/**************************************************************************//**
+ * @brief
+ *    End a read, drop the bytes queued for the leader that it did not take
+ *****************************************************************************/
+static void stopRead(void)
+{
+  if (!reading) {
+    return;
+  }
+
+#if I2CRM_USE_LDMA
+  LDMA_StopTransfer(I2CRM_LDMA_CHANNEL);
+#endif
+  I2C0->CMD = I2C_CMD_CLEARTX;
+  reading = false;
+
+  if (swapPending) {
+    swapMaps();
+  }
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Initialize I2C0 as follower on PA5 (SDA) and PA6 (SCL)
+ *
+ * @param[in] address
+ *    Follower address, 7 bits shifted left.
+ *****************************************************************************/
+void I2CRM_Init(uint8_t address)
+{
+  // Use default settings
+  I2C_Init_TypeDef i2cInit = I2C_INIT_DEFAULT;
+  uint32_t flags;
+
+  CMU_ClockEnable(cmuClock_GPIO, true);
+  CMU_ClockEnable(cmuClock_I2C0, true);
+
+  // Configure to be addressable as follower
+  i2cInit.master = false;
+
+  // Enable GPIO pins
+  GPIO_PinModeSet(I2CRM_SDA_PORT, I2CRM_SDA_PIN, gpioModeWiredAndPullUpFilter, 1);
+  GPIO_PinModeSet(I2CRM_SCL_PORT, I2CRM_SCL_PIN, gpioModeWiredAndPullUpFilter, 1);
+
+  // Route I2C pins to GPIO
+  GPIO->I2CROUTE[0].SDAROUTE = (GPIO->I2CROUTE[0].SDAROUTE & ~_GPIO_I2C_SDAROUTE_MASK)
+                        | (I2CRM_SDA_PORT << _GPIO_I2C_SDAROUTE_PORT_SHIFT
+                        | (I2CRM_SDA_PIN << _GPIO_I2C_SDAROUTE_PIN_SHIFT));
+  GPIO->I2CROUTE[0].SCLROUTE = (GPIO->I2CROUTE[0].SCLROUTE & ~_GPIO_I2C_SCLROUTE_MASK)
+                        | (I2CRM_SCL_PORT << _GPIO_I2C_SCLROUTE_PORT_SHIFT
+                        | (I2CRM_SCL_PIN << _GPIO_I2C_SCLROUTE_PIN_SHIFT));
+  GPIO->I2CROUTE[0].ROUTEEN = GPIO_I2C_ROUTEEN_SDAPEN | GPIO_I2C_ROUTEEN_SCLPEN;
+
+  // Initialize the I2C
+  I2C_Init(I2C0, &i2cInit);
+
+  front = 0;
+  swapPending = false;
+  targetAddress = 0;
+  gotTargetAddress = false;
+  busy = false;
+  reading = false;
+
+  // Set up to enable follower mode
+  I2C_SlaveAddressSet(I2C0, address);
+  I2C_SlaveAddressMaskSet(I2C0, 0xFE); // must match exact address
+
+#if I2CRM_USE_LDMA
+  LDMA_Init_t ldmaInit = LDMA_INIT_DEFAULT;
+  LDMA_Init(&ldmaInit);
+
+  // Transfer a byte whenever the transmit buffer has room
+  txConfig = (LDMA_TransferCfg_t)LDMA_TRANSFER_CFG_PERIPHERAL(ldmaPeripheralSignal_I2C0_TXBL);
+
+  // The LDMA feeds reads, so there is no interrupt per byte sent
+  flags = I2C_IEN_ADDR | I2C_IEN_RXDATAV | I2C_IEN_SSTOP | I2C_IEN_BUSERR | I2C_IEN_ARBLOST;
+#else
+  flags = I2C_IEN_ADDR | I2C_IEN_RXDATAV | I2C_IEN_ACK | I2C_IEN_SSTOP | I2C_IEN_BUSERR | I2C_IEN_ARBLOST;
+#endif
+
+  // Configure interrupts
+  I2C_IntClear(I2C0, _I2C_IF_MASK);
+  I2C_IntEnable(I2C0, flags);
+  NVIC_EnableIRQ(I2C0_IRQn);
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Get the copy of the map to write the next snapshot into
+ *
+ * @return
+ *    NULL while the last published snapshot is waiting for a read to end.
+ *    The copy holds the previous snapshot and everything the leader wrote.
+ *****************************************************************************/
+uint8_t *I2CRM_GetBackBuffer(void)
+{
+  if (swapPending) {
+    return NULL;
+  }
+  return regMap[front ^ 1];
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Make the back copy the one the leader reads, at once or at the end of
+ *    the running read
+ *****************************************************************************/
+void I2CRM_Publish(void)
+{
+  CORE_DECLARE_IRQ_STATE;
+
+  CORE_ENTER_ATOMIC();
+  if (reading) {
+    swapPending = true;
+  } else {
+    swapMaps();
+  }
+  CORE_EXIT_ATOMIC();
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Check whether a transaction is in progress. The LDMA needs EM1 or
+ *    higher, EM2 is only safe while idle.
+ *****************************************************************************/
+bool I2CRM_IsBusy(void)
+{
+  return busy;
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Get the number of transactions ended by a STOP
+ *****************************************************************************/
+uint32_t I2CRM_GetTransactionCount(void)
+{
+  return transactionCount;
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Get the number of bus errors and lost arbitrations
+ *****************************************************************************/
+uint32_t I2CRM_GetErrorCount(void)
+{
+  return errorCount;
+}
+
+/***************************************************************************//**
+ * @brief I2C Interrupt Handler
+ ******************************************************************************/
+void I2C0_IRQHandler(void)
+{
+  uint32_t pending;
+  uint32_t rxData;
+
+  pending = I2C0->IF;
+
+  // If some sort of fault, abort transfer.
+  if (pending & (I2C_IF_BUSERR | I2C_IF_ARBLOST)) {
+    stopRead();
+    busy = false;
+    errorCount++;
+
+    I2C_IntClear(I2C0, I2C_IF_BUSERR | I2C_IF_ARBLOST);
+  } else {
+    if (pending & I2C_IF_ADDR) {
+      // Address Match, indicating that reception is started
+      rxData = I2C0->RXDATA;
+      I2C0->CMD = I2C_CMD_ACK;
+      busy = true;
+
+      // A repeated START may end a read without a STOP
+      stopRead();
+
+      if (rxData & 0x1) { // read bit set
+        startRead();
+      } else {
+        gotTargetAddress = false;
+      }
+
+      I2C_IntClear(I2C0, I2C_IF_ADDR | I2C_IF_RXDATAV);
+    } else if (pending & I2C_IF_RXDATAV) {
+      rxData = I2C0->RXDATA;
+
+      if (!gotTargetAddress) {
+        /******************************************************/
+        /* Read target address from leader                    */
+        /******************************************************/
+        // Every one byte target address is valid with a 256-byte map
+        targetAddress = rxData;
+        I2C0->CMD = I2C_CMD_ACK;
+        gotTargetAddress = true;
+      } else {
+        /******************************************************/
+        /* Read new data and write to target address          */
+        /******************************************************/
+        if (targetAddress < I2CRM_SIZE) {
+          // Write to both copies so the next snapshot keeps the new value;
+          // auto increment target address
+          regMap[0][targetAddress] = rxData;
+          regMap[1][targetAddress] = rxData;
+          targetAddress++;
+          I2C0->CMD = I2C_CMD_ACK;
+        } else {
+          I2C0->CMD = I2C_CMD_NACK;
+        }
+      }
+
+      I2C_IntClear(I2C0, I2C_IF_RXDATAV);
+    }
+
+#if !I2CRM_USE_LDMA
+    if (pending & I2C_IF_ACK) {
+      /******************************************************/
+      /* Leader ACK'ed, so requesting more data             */
+      /******************************************************/
+      sendByte();
+
+      I2C_IntClear(I2C0, I2C_IF_ACK);
+    }
+#endif
+
+    if (pending & I2C_IF_SSTOP) {
+      // End of transaction
+      stopRead();
+      busy = false;
+      transactionCount++;
+
+      I2C_IntClear(I2C0, I2C_IF_SSTOP);
+    }
+  }
+}
+
+#if I2CRM_USE_LDMA
+/**************************************************************************//**
+ * @brief LDMA IRQHandler
+ *****************************************************************************/
+void LDMA_IRQHandler(void)
+{
+  uint32_t flags = LDMA_IntGet();
+
+  LDMA_IntClear(flags);
+
+  // Stop in case there was an error
+  if (flags & LDMA_IF_ERROR) {
+    __BKPT(0);
+  }
+}
+#endif
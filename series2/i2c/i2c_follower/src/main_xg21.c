@@ -52,18 +52,14 @@
 #include "em_rtcc.h"
 #include "em_core.h"
 #include "bsp.h"
+#include "i2cregmap.h"
 
 // Defines
 #define I2C_ADDRESS                     0xE2
-#define I2C_BUFFER_SIZE                 10
 
-// Buffers
-uint8_t i2c_Buffer[I2C_BUFFER_SIZE];
-uint8_t i2c_BufferIndex;
-
-// Transmission flags
-volatile bool i2c_gotTargetAddress;
-volatile bool i2c_rxInProgress;
+// Status registers at the end of the register map, read-only for the leader.
+// The number of completed transactions, 32 bits little-endian.
+#define REG_TRANSACTION_COUNT           0xFC
 
 /***************************************************************************//**
  * @brief GPIO initialization
@@ -97,132 +93,28 @@ void initRTCC(void)
  ******************************************************************************/
 void initI2C(void)
 {
-  // Use default settings
-  I2C_Init_TypeDef i2cInit = I2C_INIT_DEFAULT;
-
-  // Configure to be addressable as follower
-  i2cInit.master = false;
-
-  // Enable GPIO pins PA5 (SDA) and PA6 (SCL)
-  GPIO_PinModeSet(gpioPortA, 5, gpioModeWiredAndPullUpFilter, 1);
-  GPIO_PinModeSet(gpioPortA, 6, gpioModeWiredAndPullUpFilter, 1);
-
-  // Route I2C pins to GPIO
-  GPIO->I2CROUTE[0].SDAROUTE = (GPIO->I2CROUTE[0].SDAROUTE & ~_GPIO_I2C_SDAROUTE_MASK)
-                        | (gpioPortA << _GPIO_I2C_SDAROUTE_PORT_SHIFT
-                        | (5 << _GPIO_I2C_SDAROUTE_PIN_SHIFT));
-  GPIO->I2CROUTE[0].SCLROUTE = (GPIO->I2CROUTE[0].SCLROUTE & ~_GPIO_I2C_SCLROUTE_MASK)
-                        | (gpioPortA << _GPIO_I2C_SCLROUTE_PORT_SHIFT
-                        | (6 << _GPIO_I2C_SCLROUTE_PIN_SHIFT));
-  GPIO->I2CROUTE[0].ROUTEEN = GPIO_I2C_ROUTEEN_SDAPEN | GPIO_I2C_ROUTEEN_SCLPEN;
-
-  // Initialize the I2C
-  I2C_Init(I2C0, &i2cInit);
-
-  // Initialize the buffer index
-  i2c_BufferIndex = 0;
-
-  // Set up to enable follower mode
-  I2C_SlaveAddressSet(I2C0, I2C_ADDRESS);
-  I2C_SlaveAddressMaskSet(I2C0, 0xFE); // must match exact address
-
-  // Configure interrupts
-  I2C_IntClear(I2C0, _I2C_IF_MASK);
-  I2C_IntEnable(I2C0, I2C_IEN_ADDR | I2C_IEN_RXDATAV | I2C_IEN_ACK | I2C_IEN_SSTOP | I2C_IEN_BUSERR | I2C_IEN_ARBLOST);
-  NVIC_EnableIRQ(I2C0_IRQn);
+  // Follower on PA5 (SDA) and PA6 (SCL) serving a 256-byte register map
+  I2CRM_Init(I2C_ADDRESS);
 }
 
 /***************************************************************************//**
- * @brief I2C Interrupt Handler
+ * @brief Publish a new snapshot of the status registers. All bytes of a
+ * register change together, the leader never reads half of an update.
  ******************************************************************************/
-void I2C0_IRQHandler(void)
+void publishStatus(void)
 {
-  uint32_t pending;
-  uint32_t rxData;
-
-  pending = I2C0->IF;
-
-  // If some sort of fault, abort transfer.
-  if (pending & (I2C_IF_BUSERR | I2C_IF_ARBLOST)) {
-    i2c_rxInProgress = false;
-    GPIO_PinOutSet(BSP_GPIO_LED1_PORT, BSP_GPIO_LED1_PIN);
-  } else {
-    if (pending & I2C_IF_ADDR) {
-      // Address Match, indicating that reception is started
-      rxData = I2C0->RXDATA;
-      I2C0->CMD = I2C_CMD_ACK;
-      i2c_rxInProgress = true;
-
-      if (rxData & 0x1) { // read bit set
-        if (i2c_BufferIndex < I2C_BUFFER_SIZE) {
-          // Transfer data
-          I2C0->TXDATA     = i2c_Buffer[i2c_BufferIndex++];
-        } else {
-          // Invalid buffer index; transfer data as if follower non-responsive
-          I2C0->TXDATA     = 0xFF;
-        }
-      } else {
-        i2c_gotTargetAddress = false;
-      }
-
-      I2C_IntClear(I2C0, I2C_IF_ADDR | I2C_IF_RXDATAV);
-
-      GPIO_PinOutSet(BSP_GPIO_LED0_PORT, BSP_GPIO_LED0_PIN);
-    } else if (pending & I2C_IF_RXDATAV) {
-      rxData = I2C0->RXDATA;
-
-      if (!i2c_gotTargetAddress) {
-        /******************************************************/
-        /* Read target address from leader                    */
-        /******************************************************/
-        // Verify that target address is valid
-        if (rxData < I2C_BUFFER_SIZE) {
-          // Store target address
-          i2c_BufferIndex = rxData;
-          I2C0->CMD = I2C_CMD_ACK;
-          i2c_gotTargetAddress = true;
-        } else {
-          I2C0->CMD = I2C_CMD_NACK;
-        }
-      } else {
-        /******************************************************/
-        /* Read new data and write to target address          */
-        /******************************************************/
-        // Verify that target address is valid
-        if (i2c_BufferIndex < I2C_BUFFER_SIZE) {
-          // Write new data to target address; auto increment target address
-          i2c_Buffer[i2c_BufferIndex++] = rxData;
-          I2C0->CMD = I2C_CMD_ACK;
-        } else {
-          I2C0->CMD = I2C_CMD_NACK;
-        }
-      }
-
-      I2C_IntClear(I2C0, I2C_IF_RXDATAV);
-    }
-
-    if (pending & I2C_IF_ACK) {
-      /******************************************************/
-      /* Leader ACK'ed, so requesting more data             */
-      /******************************************************/
-      if (i2c_BufferIndex < I2C_BUFFER_SIZE) {
-        // Transfer data
-        I2C0->TXDATA = i2c_Buffer[i2c_BufferIndex++];
-      } else {
-        // Invalid buffer index; transfer data as if follower non-responsive
-        I2C0->TXDATA = 0xFF;
-      }
-
-      I2C_IntClear(I2C0, I2C_IF_ACK);
-    }
+  uint8_t *regs = I2CRM_GetBackBuffer();
+  uint32_t count = I2CRM_GetTransactionCount();
 
-    if (pending & I2C_IF_SSTOP) {
-      // End of transaction
-      i2c_rxInProgress = false;
+  // The last snapshot is still waiting for a read to end
+  if (regs == NULL) {
+    return;
+  }
 
-      I2C_IntClear(I2C0, I2C_IF_SSTOP);
-    }
+  for (int i = 0; i < 4; i++) {
+    regs[REG_TRANSACTION_COUNT + i] = (uint8_t)(count >> (8 * i));
   }
+  I2CRM_Publish();
 }
 
 /***************************************************************************//**
@@ -242,10 +134,19 @@ int main(void)
 
   while (1) {
     // Receiving I2C data; keep in EM1 during transmission
-    while(i2c_rxInProgress) {
+    while (I2CRM_IsBusy()) {
+      GPIO_PinOutSet(BSP_GPIO_LED0_PORT, BSP_GPIO_LED0_PIN);
       EMU_EnterEM1();
     }
 
+    // Set LED1 if an I2C transmission error was encountered
+    if (I2CRM_GetErrorCount() > 0) {
+      GPIO_PinOutSet(BSP_GPIO_LED1_PORT, BSP_GPIO_LED1_PIN);
+    }
+
+    // Update the status registers for the next read
+    publishStatus();
+
     // EM2 entry is a critical section and interrupts are disabled to prevent
     // race conditions
     CORE_DECLARE_IRQ_STATE;
@@ -253,8 +154,11 @@ int main(void)
 
     GPIO_PinOutClear(BSP_GPIO_LED0_PORT, BSP_GPIO_LED0_PIN);
 
-    // Enter EM2; an I2C address match will wake up the device
-    EMU_EnterEM2(true);
+    // Enter EM2; an I2C address match will wake up the device. A
+    // transaction that started since the check above needs EM1.
+    if (!I2CRM_IsBusy()) {
+      EMU_EnterEM2(true);
+    }
 
     CORE_EXIT_CRITICAL();
   }
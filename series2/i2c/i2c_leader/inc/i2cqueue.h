@@ -0,0 +1,95 @@
+/***************************************************************************//**
+ * @file i2cqueue.h
+ *
+ * @brief Queue of interrupt-driven I2C leader transactions on I2C0. Each
+ * transaction writes and then reads a follower in one go, with a repeated
+ * START in between. Payloads longer than I2CQ_LDMA_THRESHOLD bytes are
+ * moved by the LDMA instead of one interrupt per byte.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2021 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ******************************************************************************/
+
+#ifndef I2CQUEUE_H
+#define I2CQUEUE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// LDMA channel for payload transfers
+#define I2CQ_LDMA_CHANNEL     0
+
+// Writes and reads longer than this many bytes use the LDMA. Shorter ones
+// are cheaper to do from the I2C interrupt than to set up a transfer for.
+#ifndef I2CQ_LDMA_THRESHOLD
+#define I2CQ_LDMA_THRESHOLD   4
+#endif
+
+// Longest write or read, the payload of one LDMA descriptor
+#define I2CQ_MAX_LENGTH       2048
+
+// Transaction result
+typedef enum {
+  i2cqStatusPending,                  // Queued or in progress
+  i2cqStatusDone,                     // Completed
+  i2cqStatusNack,                     // Address or data not acknowledged
+  i2cqStatusArbLost,                  // Another leader won the bus
+  i2cqStatusBusError                  // Misplaced START or STOP on the bus
+} I2CQ_Status_t;
+
+typedef struct I2CQ_Transfer I2CQ_Transfer_t;
+
+// Called from the I2C interrupt once the STOP condition has been sent, or
+// right after a bus error. May submit further transactions.
+typedef void (*I2CQ_Callback_t)(I2CQ_Transfer_t *transfer);
+
+// Write txLength bytes, then read rxLength bytes. Either may be 0, a write
+// of just the register address followed by a read is the usual register
+// read.
+struct I2CQ_Transfer {
+  uint16_t address;                   // Follower address, 7 bits shifted left
+  const uint8_t *tx;                  // Data to write
+  uint16_t txLength;                  // Number of bytes to write
+  uint8_t *rx;                        // Buffer for the data read
+  uint16_t rxLength;                  // Number of bytes to read
+  I2CQ_Callback_t callback;           // Completion callback or NULL
+  void *user;                         // For the callback
+  volatile I2CQ_Status_t status;      // Result, set before the callback
+  I2CQ_Transfer_t *next;              // Private, queue link
+};
+
+void I2CQ_Init(uint32_t frequency);
+bool I2CQ_Submit(I2CQ_Transfer_t *transfer);
+bool I2CQ_IsIdle(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // I2CQUEUE_H
@@ -0,0 +1,477 @@
+/***************************************************************************//**
+ * @file i2cqueue.c
+ *
+ * @brief Queue of interrupt-driven I2C leader transactions on I2C0.
+ *
+ * A transaction goes through these states, one I2C interrupt each except
+ * where the LDMA takes over:
+ *
+ *   START + address/W, ACK -> data bytes, ACK each (or LDMA, then TXC)
+ *   repeated START + address/R, ACK -> data bytes (or LDMA for all but
+ *   the last), NACK + STOP on the last byte, MSTOP -> callback
+ *
+ * The LDMA read runs with AUTOACK set so the follower is acknowledged
+ * without the core. Its last descriptor clears AUTOACK again, so the bus
+ * waits on the last byte until the interrupt handler NACKs it.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2022 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ *******************************************************************************
+ * # Evaluation Quality
+ * This code has been minimally tested to ensure that it builds and is suitable 
+ * as a demonstration for evaluation purposes only. This code will be maintained
+ * at the sole discretion of Silicon Labs.
+ ******************************************************************************/
+
+#include <stddef.h>
+
+#include "em_device.h"
+#include "em_cmu.h"
+#include "em_core.h"
+#include "em_gpio.h"
+#include "em_i2c.h"
+#include "em_ldma.h"
+
+#include "i2cqueue.h"
+
+// I2C pins, PA5 (SDA) and PA6 (SCL)
+#define I2CQ_SDA_PORT   gpioPortA
+#define I2CQ_SDA_PIN    5
+#define I2CQ_SCL_PORT   gpioPortA
+#define I2CQ_SCL_PIN    6
+
+// Interrupts that end a transaction in any state
+#define I2CQ_IF_ERRORS  (I2C_IF_ARBLOST | I2C_IF_BUSERR)
+
+// Transaction states
+typedef enum {
+  stateAddrWrite,       // Address with write bit sent, waiting for ACK
+  stateWrite,           // Data byte sent, waiting for ACK
+  stateWriteDma,        // LDMA filling TXDATA, waiting for TXC
+  stateAddrRead,        // Address with read bit sent, waiting for ACK
+  stateRead,            // Waiting for the next data byte
+  stateReadDma,         // LDMA reading all but the last byte
+  stateReadLast,        // Waiting for the last data byte
+  stateStop             // STOP sent, waiting for MSTOP
+} State_t;
+
+// Read payload descriptors: all but the last byte, then clear AUTOACK
+static LDMA_Descriptor_t readDescriptors[2];
+static LDMA_Descriptor_t writeDescriptor;
+
+static LDMA_TransferCfg_t txConfig;
+static LDMA_TransferCfg_t rxConfig;
+
+// Transactions waiting for the bus
+static I2CQ_Transfer_t *pendingHead;
+static I2CQ_Transfer_t *pendingTail;
+
+// Running transaction
+static I2CQ_Transfer_t *current;
+static State_t state;
+static I2CQ_Status_t result;
+static uint32_t txCount;
+static uint32_t rxCount;
+static volatile bool busy;
+
+/**************************************************************************//**
+ * @brief
+ *    Set the I2C interrupts the next state waits for, errors are always on
+ *****************************************************************************/
+static void waitFor(uint32_t flags)
+{
+  I2C0->IEN = I2CQ_IF_ERRORS | flags;
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Send a STOP condition, the transaction ends with status once it is out
+ *****************************************************************************/
+static void sendStop(I2CQ_Status_t status)
+{
+  result = status;
+  state = stateStop;
+  I2C0->CMD = I2C_CMD_STOP;
+  waitFor(I2C_IF_MSTOP);
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Send a START (or repeated START) and the follower address
+ *****************************************************************************/
+static void sendAddress(bool read)
+{
+  I2C0->CMD = I2C_CMD_START;
+
+  // The address is not transmitted until the START has been sent
+  I2C0->TXDATA = (current->address & 0xFE) | (read ? 1 : 0);
+
+  state = read ? stateAddrRead : stateAddrWrite;
+  waitFor(I2C_IF_ACK | I2C_IF_NACK);
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Write phase done, read back or stop
+ *****************************************************************************/
+static void endWrite(void)
+{
+  if (current->rxLength > 0) {
+    sendAddress(true);
+  } else {
+    sendStop(i2cqStatusDone);
+  }
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Send the next byte of the write phase, the whole remaining payload if
+ *    it is long enough for the LDMA
+ *****************************************************************************/
+static void writeNext(void)
+{
+  uint32_t left = current->txLength - txCount;
+
+  if (left == 0) {
+    endWrite();
+  } else if (left > I2CQ_LDMA_THRESHOLD) {
+    writeDescriptor = (LDMA_Descriptor_t)LDMA_DESCRIPTOR_SINGLE_M2P_BYTE(
+      &current->tx[txCount], &I2C0->TXDATA, left);
+    writeDescriptor.xfer.doneIfs = 0;
+    txCount += left;
+
+    // TXC may still be set from the address byte
+    I2C_IntClear(I2C0, I2C_IF_TXC);
+    state = stateWriteDma;
+    waitFor(I2C_IF_TXC | I2C_IF_NACK);
+    LDMA_StartTransfer(I2CQ_LDMA_CHANNEL, &txConfig, &writeDescriptor);
+  } else {
+    I2C0->TXDATA = current->tx[txCount++];
+    state = stateWrite;
+    waitFor(I2C_IF_ACK | I2C_IF_NACK);
+  }
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Address acknowledged for reading, start receiving
+ *****************************************************************************/
+static void startRead(void)
+{
+  uint32_t count = current->rxLength - 1;
+
+  if (current->rxLength > I2CQ_LDMA_THRESHOLD) {
+    readDescriptors[0] = (LDMA_Descriptor_t)LDMA_DESCRIPTOR_LINKREL_P2M_BYTE(
+      &I2C0->RXDATA, current->rx, count, 1);
+    readDescriptors[1] = (LDMA_Descriptor_t)LDMA_DESCRIPTOR_SINGLE_WRITE(
+      I2C_CTRL_AUTOACK, &I2C0->CTRL_CLR);
+    rxCount = count;
+
+    // Acknowledge bytes as they arrive, the LDMA only needs to read them
+    I2C0->CTRL_SET = I2C_CTRL_AUTOACK;
+    state = stateReadDma;
+    waitFor(0);
+    LDMA_StartTransfer(I2CQ_LDMA_CHANNEL, &rxConfig, readDescriptors);
+  } else {
+    state = (current->rxLength == 1) ? stateReadLast : stateRead;
+    waitFor(I2C_IF_RXDATAV);
+  }
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Take a received byte, ACK it to get the next one or NACK and stop
+ *    after the last
+ *****************************************************************************/
+static void readByte(void)
+{
+  current->rx[rxCount++] = I2C0->RXDATA;
+
+  if (rxCount < current->rxLength) {
+    if (rxCount == (uint32_t)current->rxLength - 1) {
+      state = stateReadLast;
+    }
+    I2C0->CMD = I2C_CMD_ACK;
+  } else {
+    I2C0->CMD = I2C_CMD_NACK;
+    sendStop(i2cqStatusDone);
+  }
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Start the next queued transaction, if any
+ *****************************************************************************/
+static void startNext(void)
+{
+  current = pendingHead;
+  if (current == NULL) {
+    busy = false;
+    return;
+  }
+
+  pendingHead = current->next;
+  if (pendingHead == NULL) {
+    pendingTail = NULL;
+  }
+
+  busy = true;
+  txCount = 0;
+  rxCount = 0;
+
+  // Abort whatever an earlier error left behind and flush the buffers
+  if (I2C0->STATE & I2C_STATE_BUSY) {
+    I2C0->CMD = I2C_CMD_ABORT;
+  }
+  I2C0->CMD = I2C_CMD_CLEARPC | I2C_CMD_CLEARTX;
+  I2C0->CTRL_CLR = I2C_CTRL_AUTOACK;
+  I2C_IntClear(I2C0, _I2C_IF_MASK);
+
+  sendAddress(current->txLength == 0);
+}
+
+/**************************************************************************//**
+ * @brief
+ *    End the running transaction and move on to the next one
+ *****************************************************************************/
+static void finish(I2CQ_Status_t status)
+{
+  I2CQ_Transfer_t *transfer = current;
+
+  waitFor(0);
+  LDMA_StopTransfer(I2CQ_LDMA_CHANNEL);
+  I2C0->CTRL_CLR = I2C_CTRL_AUTOACK;
+
+  // Unlink before the callback, which may submit the transaction again
+  current = NULL;
+  transfer->status = status;
+  if (transfer->callback) {
+    transfer->callback(transfer);
+  }
+
+  startNext();
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Initialize I2C0 as leader, its pins, the LDMA and the queue
+ *
+ * @param[in] frequency
+ *    Bus clock in Hz, up to I2C_FREQ_FASTPLUS_MAX.
+ *****************************************************************************/
+void I2CQ_Init(uint32_t frequency)
+{
+  I2C_Init_TypeDef i2cInit = I2C_INIT_DEFAULT;
+
+  CMU_ClockEnable(cmuClock_GPIO, true);
+  CMU_ClockEnable(cmuClock_I2C0, true);
+
+  GPIO_PinModeSet(I2CQ_SDA_PORT, I2CQ_SDA_PIN, gpioModeWiredAndPullUpFilter, 1);
+  GPIO_PinModeSet(I2CQ_SCL_PORT, I2CQ_SCL_PIN, gpioModeWiredAndPullUpFilter, 1);
+
+  // Route I2C pins to GPIO
+  GPIO->I2CROUTE[0].SDAROUTE = (GPIO->I2CROUTE[0].SDAROUTE & ~_GPIO_I2C_SDAROUTE_MASK)
+                        | (I2CQ_SDA_PORT << _GPIO_I2C_SDAROUTE_PORT_SHIFT
+                        | (I2CQ_SDA_PIN << _GPIO_I2C_SDAROUTE_PIN_SHIFT));
+  GPIO->I2CROUTE[0].SCLROUTE = (GPIO->I2CROUTE[0].SCLROUTE & ~_GPIO_I2C_SCLROUTE_MASK)
+                        | (I2CQ_SCL_PORT << _GPIO_I2C_SCLROUTE_PORT_SHIFT
+                        | (I2CQ_SCL_PIN << _GPIO_I2C_SCLROUTE_PIN_SHIFT));
+  GPIO->I2CROUTE[0].ROUTEEN = GPIO_I2C_ROUTEEN_SDAPEN | GPIO_I2C_ROUTEEN_SCLPEN;
+
+  // Above 100 kHz the clock needs the asymmetric low/high ratio
+  i2cInit.freq = frequency;
+  if (frequency > I2C_FREQ_STANDARD_MAX) {
+    i2cInit.clhr = i2cClockHLRAsymetric;
+  }
+  if (frequency > I2C_FREQ_FAST_MAX) {
+    i2cInit.clhr = i2cClockHLRFast;
+  }
+  I2C_Init(I2C0, &i2cInit);
+
+  // ACK, NACK and STOP are all sent by the state machine
+  I2C0->CTRL = 0;
+
+  LDMA_Init_t ldmaInit = LDMA_INIT_DEFAULT;
+  LDMA_Init(&ldmaInit);
+
+  // Transfer a byte whenever the transmit buffer has room or a byte has
+  // been received
+  txConfig = (LDMA_TransferCfg_t)LDMA_TRANSFER_CFG_PERIPHERAL(ldmaPeripheralSignal_I2C0_TXBL);
+  rxConfig = (LDMA_TransferCfg_t)LDMA_TRANSFER_CFG_PERIPHERAL(ldmaPeripheralSignal_I2C0_RXDATAV);
+
+  pendingHead = NULL;
+  pendingTail = NULL;
+  current = NULL;
+  busy = false;
+
+  I2C0->IEN = 0;
+  NVIC_ClearPendingIRQ(I2C0_IRQn);
+  NVIC_EnableIRQ(I2C0_IRQn);
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Queue a transaction. It starts right away if the bus is idle.
+ *
+ * @param[in] transfer
+ *    Transaction, must stay valid until its callback has been called.
+ *
+ * @return
+ *    False if the transaction is empty or a phase is longer than
+ *    I2CQ_MAX_LENGTH.
+ *****************************************************************************/
+bool I2CQ_Submit(I2CQ_Transfer_t *transfer)
+{
+  CORE_DECLARE_IRQ_STATE;
+
+  if (((transfer->txLength == 0) && (transfer->rxLength == 0))
+      || (transfer->txLength > I2CQ_MAX_LENGTH)
+      || (transfer->rxLength > I2CQ_MAX_LENGTH)) {
+    return false;
+  }
+
+  transfer->status = i2cqStatusPending;
+  transfer->next = NULL;
+
+  CORE_ENTER_CRITICAL();
+  if (pendingTail) {
+    pendingTail->next = transfer;
+  } else {
+    pendingHead = transfer;
+  }
+  pendingTail = transfer;
+
+  if (!busy) {
+    startNext();
+  }
+  CORE_EXIT_CRITICAL();
+
+  return true;
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Check whether all queued transactions have completed
+ *****************************************************************************/
+bool I2CQ_IsIdle(void)
+{
+  return !busy;
+}
+
+/**************************************************************************//**
+ * @brief I2C0 IRQHandler
+ *****************************************************************************/
+void I2C0_IRQHandler(void)
+{
+  uint32_t flags = I2C_IntGetEnabled(I2C0);
+
+  I2C_IntClear(I2C0, flags);
+
+  if (current == NULL) {
+    return;
+  }
+
+  // The bus is lost, there is no STOP to wait for
+  if (flags & I2CQ_IF_ERRORS) {
+    I2C0->CMD = I2C_CMD_ABORT;
+    finish((flags & I2C_IF_ARBLOST) ? i2cqStatusArbLost : i2cqStatusBusError);
+    return;
+  }
+
+  switch (state) {
+    case stateAddrWrite:
+    case stateWrite:
+    case stateAddrRead:
+      if (flags & I2C_IF_NACK) {
+        I2C0->CMD = I2C_CMD_CLEARTX;
+        sendStop(i2cqStatusNack);
+      } else if (flags & I2C_IF_ACK) {
+        if (state == stateAddrRead) {
+          startRead();
+        } else {
+          writeNext();
+        }
+      }
+      break;
+
+    case stateWriteDma:
+      if (flags & I2C_IF_NACK) {
+        LDMA_StopTransfer(I2CQ_LDMA_CHANNEL);
+        I2C0->CMD = I2C_CMD_CLEARTX;
+        sendStop(i2cqStatusNack);
+      } else if ((flags & I2C_IF_TXC) && LDMA_TransferDone(I2CQ_LDMA_CHANNEL)
+                 && (I2C0->STATUS & I2C_STATUS_TXBL)) {
+        // TXC is also set if the LDMA falls behind the bus for a moment,
+        // only the one after the last byte ends the write
+        endWrite();
+      }
+      break;
+
+    case stateRead:
+    case stateReadLast:
+      if (I2C0->STATUS & I2C_STATUS_RXDATAV) {
+        readByte();
+      }
+      break;
+
+    case stateStop:
+      if (flags & I2C_IF_MSTOP) {
+        finish(result);
+      }
+      break;
+
+    default:
+      break;
+  }
+}
+
+/**************************************************************************//**
+ * @brief LDMA IRQHandler
+ *****************************************************************************/
+void LDMA_IRQHandler(void)
+{
+  uint32_t flags = LDMA_IntGet();
+
+  LDMA_IntClear(flags);
+
+  // Stop in case there was an error
+  if (flags & LDMA_IF_ERROR) {
+    __BKPT(0);
+  }
+
+  if (!(flags & (1 << I2CQ_LDMA_CHANNEL)) || (state != stateReadDma)) {
+    return;
+  }
+
+  // All but the last byte are in and AUTOACK is off, the last byte may
+  // already be waiting
+  state = stateReadLast;
+  I2C_IntClear(I2C0, I2C_IF_RXDATAV);
+  if (I2C0->STATUS & I2C_STATUS_RXDATAV) {
+    readByte();
+  } else {
+    waitFor(I2C_IF_RXDATAV);
+  }
+}
@@ -51,21 +51,32 @@
 #include <stdio.h>
 #include "em_device.h"
 #include "em_chip.h"
-#include "em_i2c.h"
 #include "em_cmu.h"
+#include "em_core.h"
 #include "em_emu.h"
 #include "em_gpio.h"
+#include "em_i2c.h"
 #include "bsp.h"
 
+#include "i2cqueue.h"
+
 // Defines
 #define I2C_FOLLOWER_ADDRESS              0xE2
 #define I2C_TXBUFFER_SIZE                 10
 #define I2C_RXBUFFER_SIZE                 10
 
-// Buffers
-uint8_t i2c_txBuffer[I2C_TXBUFFER_SIZE];
+// Buffers, the transmit buffer starts with the target register address
+uint8_t i2c_txBuffer[I2C_TXBUFFER_SIZE + 1];
 uint8_t i2c_rxBuffer[I2C_RXBUFFER_SIZE];
 
+// Target register address for reads
+static const uint8_t i2c_targetAddress = 0;
+
+// Transactions: read, write new values, read back
+static I2CQ_Transfer_t readTransfer;
+static I2CQ_Transfer_t writeTransfer;
+static I2CQ_Transfer_t verifyTransfer;
+
 // Transmission flags
 volatile bool i2c_startTx;
 
@@ -74,8 +85,7 @@ volatile bool i2c_startTx;
  ******************************************************************************/
 void initCMU(void)
 {
-  // Enable clocks to the I2C and GPIO
-  CMU_ClockEnable(cmuClock_I2C0, true);
+  // Enable clock to the GPIO, the I2C clock is enabled by I2CQ_Init()
   CMU_ClockEnable(cmuClock_GPIO, true);
   /*
    * Note: For EFR32xG21 radio devices, library function calls to
@@ -108,98 +118,60 @@ void initGPIO(void)
  ******************************************************************************/
 void initI2C(void)
 {
-  // Use default settings
-  I2C_Init_TypeDef i2cInit = I2C_INIT_DEFAULT;
-
-  // Using PA5 (SDA) and PA6 (SCL)
-  GPIO_PinModeSet(gpioPortA, 5, gpioModeWiredAndPullUpFilter, 1);
-  GPIO_PinModeSet(gpioPortA, 6, gpioModeWiredAndPullUpFilter, 1);
-
-  // Route I2C pins to GPIO
-  GPIO->I2CROUTE[0].SDAROUTE = (GPIO->I2CROUTE[0].SDAROUTE & ~_GPIO_I2C_SDAROUTE_MASK)
-                        | (gpioPortA << _GPIO_I2C_SDAROUTE_PORT_SHIFT
-                        | (5 << _GPIO_I2C_SDAROUTE_PIN_SHIFT));
-  GPIO->I2CROUTE[0].SCLROUTE = (GPIO->I2CROUTE[0].SCLROUTE & ~_GPIO_I2C_SCLROUTE_MASK)
-                        | (gpioPortA << _GPIO_I2C_SCLROUTE_PORT_SHIFT
-                        | (6 << _GPIO_I2C_SCLROUTE_PIN_SHIFT));
-  GPIO->I2CROUTE[0].ROUTEEN = GPIO_I2C_ROUTEEN_SDAPEN | GPIO_I2C_ROUTEEN_SCLPEN;
-
-  // Initialize the I2C
-  I2C_Init(I2C0, &i2cInit);
+  // Standard mode, PA5 (SDA) and PA6 (SCL)
+  I2CQ_Init(I2C_FREQ_STANDARD_MAX);
 
   // Set the status flags and index
   i2c_startTx = false;
-
-  // Enable automatic STOP on NACK
-  I2C0->CTRL = I2C_CTRL_AUTOSN;
 }
 
 /***************************************************************************//**
- * @brief I2C read numBytes from follower device starting at target address
+ * @brief Prepare a read of numBytes from the follower starting at the target
+ * address. The target address is written first, then the data is read after
+ * a repeated START.
  ******************************************************************************/
-void I2C_LeaderRead(uint16_t followerAddress, uint8_t targetAddress, uint8_t *rxBuff, uint8_t numBytes)
+void I2C_LeaderRead(I2CQ_Transfer_t *transfer, uint16_t followerAddress,
+                    const uint8_t *targetAddress, uint8_t *rxBuff, uint16_t numBytes)
 {
-  // Transfer structure
-  I2C_TransferSeq_TypeDef i2cTransfer;
-  I2C_TransferReturn_TypeDef result;
-
-  // Initialize I2C transfer
-  i2cTransfer.addr          = followerAddress;
-  i2cTransfer.flags         = I2C_FLAG_WRITE_READ; // must write target address before reading
-  i2cTransfer.buf[0].data   = &targetAddress;
-  i2cTransfer.buf[0].len    = 1;
-  i2cTransfer.buf[1].data   = rxBuff;
-  i2cTransfer.buf[1].len    = numBytes;
-
-  result = I2C_TransferInit(I2C0, &i2cTransfer);
-
-  // Send data
-  while (result == i2cTransferInProgress) {
-    result = I2C_Transfer(I2C0);
-  }
-
-  if (result != i2cTransferDone) {
-    // LED1 ON and infinite while loop to indicate I2C transmission problem
-    GPIO_PinOutSet(BSP_GPIO_LED1_PORT, BSP_GPIO_LED1_PIN);
-    while(1);
-  }
+  transfer->address  = followerAddress;
+  transfer->tx       = targetAddress;
+  transfer->txLength = 1;
+  transfer->rx       = rxBuff;
+  transfer->rxLength = numBytes;
+  transfer->callback = NULL;
 }
 
 /***************************************************************************//**
- * @brief I2C write numBytes to follower device starting at target address
+ * @brief Prepare a write of numBytes to the follower. txBuff holds the target
+ * address followed by the data.
  ******************************************************************************/
-void I2C_LeaderWrite(uint16_t followerAddress, uint8_t targetAddress, uint8_t *txBuff, uint8_t numBytes)
+void I2C_LeaderWrite(I2CQ_Transfer_t *transfer, uint16_t followerAddress,
+                     const uint8_t *txBuff, uint16_t numBytes)
 {
-  // Transfer structure
-  I2C_TransferSeq_TypeDef i2cTransfer;
-  I2C_TransferReturn_TypeDef result;
-  uint8_t txBuffer[I2C_TXBUFFER_SIZE + 1];
-
-  txBuffer[0] = targetAddress;
-  for(int i = 0; i < numBytes; i++)
-  {
-      txBuffer[i + 1] = txBuff[i];
-  }
-
-  // Initialize I2C transfer
-  i2cTransfer.addr          = followerAddress;
-  i2cTransfer.flags         = I2C_FLAG_WRITE;
-  i2cTransfer.buf[0].data   = txBuffer;
-  i2cTransfer.buf[0].len    = numBytes + 1;
-  i2cTransfer.buf[1].data   = NULL;
-  i2cTransfer.buf[1].len    = 0;
-
-  result = I2C_TransferInit(I2C0, &i2cTransfer);
-
-  // Send data
-  while (result == i2cTransferInProgress) {
-    result = I2C_Transfer(I2C0);
-  }
+  transfer->address  = followerAddress;
+  transfer->tx       = txBuff;
+  transfer->txLength = numBytes + 1;
+  transfer->rx       = NULL;
+  transfer->rxLength = 0;
+  transfer->callback = NULL;
+}
 
-  if (result != i2cTransferDone) {
-    // LED1 ON and infinite while loop to indicate I2C transmission problem
-    GPIO_PinOutSet(BSP_GPIO_LED1_PORT, BSP_GPIO_LED1_PIN);
-    while(1);
+/***************************************************************************//**
+ * @brief Sleep in EM1 until all queued transactions are done
+ ******************************************************************************/
+void waitI2C(void)
+{
+  CORE_DECLARE_IRQ_STATE;
+
+  while (!I2CQ_IsIdle()) {
+    // The last transaction may complete between the check and the sleep,
+    // so check again with interrupts masked. A pending interrupt still
+    // wakes the core from EM1.
+    CORE_ENTER_CRITICAL();
+    if (!I2CQ_IsIdle()) {
+      EMU_EnterEM1();
+    }
+    CORE_EXIT_CRITICAL();
   }
 }
 
@@ -212,23 +184,40 @@ bool testI2C(void)
   bool I2CWriteVerify;
 
   // Initial read of bytes from follower
-  I2C_LeaderRead(I2C_FOLLOWER_ADDRESS, 0, i2c_rxBuffer, I2C_RXBUFFER_SIZE);
+  I2C_LeaderRead(&readTransfer, I2C_FOLLOWER_ADDRESS, &i2c_targetAddress,
+                 i2c_rxBuffer, I2C_RXBUFFER_SIZE);
+  I2CQ_Submit(&readTransfer);
+  waitI2C();
+
+  if (readTransfer.status != i2cqStatusDone) {
+    return false;
+  }
 
   // Increment received values and prepare to write back to follower
+  i2c_txBuffer[0] = i2c_targetAddress;
   for (i = 0; i < I2C_RXBUFFER_SIZE; i++) {
-    i2c_txBuffer[i] = i2c_rxBuffer[i] + 1;
+    i2c_txBuffer[i + 1] = i2c_rxBuffer[i] + 1;
   }
 
-  // Block write new values to follower
-  I2C_LeaderWrite(I2C_FOLLOWER_ADDRESS, 0, i2c_txBuffer, I2C_TXBUFFER_SIZE);
-
-  // Block read from follower
-  I2C_LeaderRead(I2C_FOLLOWER_ADDRESS, 0, i2c_rxBuffer, I2C_RXBUFFER_SIZE);
+  // Queue the block write and the block read back, the second one starts
+  // from the I2C interrupt as soon as the first one is done
+  I2C_LeaderWrite(&writeTransfer, I2C_FOLLOWER_ADDRESS, i2c_txBuffer,
+                  I2C_TXBUFFER_SIZE);
+  I2C_LeaderRead(&verifyTransfer, I2C_FOLLOWER_ADDRESS, &i2c_targetAddress,
+                 i2c_rxBuffer, I2C_RXBUFFER_SIZE);
+  I2CQ_Submit(&writeTransfer);
+  I2CQ_Submit(&verifyTransfer);
+  waitI2C();
+
+  if ((writeTransfer.status != i2cqStatusDone)
+      || (verifyTransfer.status != i2cqStatusDone)) {
+    return false;
+  }
 
   // Verify I2C transmission
   I2CWriteVerify = true;
   for (i = 0; i < I2C_RXBUFFER_SIZE; i++) {
-    if (i2c_txBuffer[i] != i2c_rxBuffer[i]) {
+    if (i2c_txBuffer[i + 1] != i2c_rxBuffer[i]) {
       I2CWriteVerify = false;
       break;
     }
@@ -246,9 +235,6 @@ void GPIO_EVEN_IRQHandler(void)
   uint32_t interruptMask = GPIO_IntGet();
   GPIO_IntClear(interruptMask);
 
-  // Re-enable I2C
-  I2C_Enable(I2C0, true);
-
   i2c_startTx = true;
 }
 
@@ -257,6 +243,8 @@ void GPIO_EVEN_IRQHandler(void)
  ******************************************************************************/
 int main(void)
 {
+  CORE_DECLARE_IRQ_STATE;
+
   // Chip errata
   CHIP_Init();
 
@@ -266,6 +254,13 @@ int main(void)
   initI2C();
 
   while (1) {
+    // Sleep in EM1 until the button is pressed
+    CORE_ENTER_CRITICAL();
+    if (!i2c_startTx) {
+      EMU_EnterEM1();
+    }
+    CORE_EXIT_CRITICAL();
+
     if (i2c_startTx) {
       // Transmitting data
       if (testI2C() == false) {
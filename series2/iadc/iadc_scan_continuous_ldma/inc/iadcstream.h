@@ -0,0 +1,73 @@
+/***************************************************************************//**
+ * @file iadcstream.h
+ *
+ * @brief Continuous IADC scan into a looped LDMA ring, delivered in halves.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2021 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ******************************************************************************/
+
+#ifndef IADCSTREAM_H
+#define IADCSTREAM_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// LDMA channel that empties the scan FIFO
+#define IADCS_LDMA_CHANNEL    0
+
+// Largest ring, two descriptors of at most 2048 words each
+#define IADCS_MAX_RING        4096
+
+/*
+ * Scan FIFO word with showId set and right aligned results, as unpacked
+ * by IADC_pullScanFifoResult(): the scan table entry in bits 28:24 and
+ * the conversion result below it.
+ */
+#define IADCS_ID(word)        (((word) >> 24) & 0x1F)
+#define IADCS_DATA(word)      ((word) & 0x00FFFFFF)
+
+// Called from the LDMA interrupt with each half of the ring just filled.
+// The LDMA goes on writing the other half, so the data stays valid for
+// the time it takes to fill one half.
+typedef void (*IADCS_Callback_t)(const uint32_t *block, uint32_t count);
+
+bool IADCS_Init(uint32_t *ring, uint32_t size, IADCS_Callback_t callback);
+void IADCS_Stop(void);
+uint32_t IADCS_GetDroppedCount(void);
+bool IADCS_Demux(const uint32_t *block,
+                 uint32_t count,
+                 uint32_t channels,
+                 uint16_t *const out[]);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // IADCSTREAM_H
@@ -0,0 +1,239 @@
+/***************************************************************************//**
+ * @file iadcstream.c
+ *
+ * @brief Continuous IADC scan into a looped LDMA ring, delivered in halves.
+ *
+ * Two linked descriptors each fill one half of the ring and link to each
+ * other, so the LDMA empties the scan FIFO without ever stopping. Both
+ * raise the channel interrupt when done, which hands the half just
+ * filled to the application while the LDMA fills the other one.
+ *
+ * IADCS_Demux() unpacks a half from the interleaved FIFO word format
+ * into one contiguous array per scan table entry, so filters can then
+ * run over each channel without looking at the scan ID of every sample.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2021 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ *******************************************************************************
+ * # Evaluation Quality
+ * This code has been minimally tested to ensure that it builds and is suitable 
+ * as a demonstration for evaluation purposes only. This code will be maintained
+ * at the sole discretion of Silicon Labs.
+ ******************************************************************************/
+
+#include <stddef.h>
+
+#include "em_device.h"
+#include "em_ldma.h"
+
+#include "iadcstream.h"
+
+// Ring halves, descriptor 0 fills the first and links to descriptor 1
+static LDMA_Descriptor_t descriptors[2];
+
+static uint32_t *ringStart;
+static uint32_t halfSize;
+static IADCS_Callback_t blockCallback;
+
+// Half delivered last, so a missed interrupt can be noticed
+static uint32_t lastHalf;
+static volatile uint32_t droppedCount;
+
+/**************************************************************************//**
+ * @brief
+ *   Set up the LDMA ring and start emptying the scan FIFO into it
+ *
+ * @details
+ *   The scan itself is configured and started by the caller, with
+ *   fifoDmaWakeup and showId set in IADC_InitScan_t. As the scan always
+ *   starts at the first entry, every half begins with the first channel
+ *   if size / 2 is a multiple of the number of entries in the scan.
+ *
+ * @param[in] ring
+ *   Ring buffer, word aligned.
+ *
+ * @param[in] size
+ *   Ring size in words, even and at most IADCS_MAX_RING.
+ *
+ * @param[in] callback
+ *   Called from the LDMA interrupt with each half filled, may be NULL.
+ *
+ * @return
+ *   false if size is out of range.
+ *****************************************************************************/
+bool IADCS_Init(uint32_t *ring, uint32_t size, IADCS_Callback_t callback)
+{
+  LDMA_Init_t init = LDMA_INIT_DEFAULT;
+
+  // Trigger LDMA transfer on IADC scan FIFO level
+  LDMA_TransferCfg_t transferCfg =
+    LDMA_TRANSFER_CFG_PERIPHERAL(ldmaPeripheralSignal_IADC0_IADC_SCAN);
+
+  if ((size < 2) || (size % 2) || (size > IADCS_MAX_RING)) {
+    return false;
+  }
+
+  ringStart = ring;
+  halfSize = size / 2;
+  blockCallback = callback;
+  lastHalf = 1;
+  droppedCount = 0;
+
+  LDMA_Init(&init);
+
+  /*
+   * The relative link is counted in descriptors, so the first one jumps
+   * forward to the second and the second back to the first. Linked
+   * descriptors do not set the done flag by default.
+   */
+  descriptors[0] = (LDMA_Descriptor_t)
+    LDMA_DESCRIPTOR_LINKREL_P2M_WORD(&(IADC0->SCANFIFODATA), ring, halfSize, 1);
+  descriptors[1] = (LDMA_Descriptor_t)
+    LDMA_DESCRIPTOR_LINKREL_P2M_WORD(&(IADC0->SCANFIFODATA), ring + halfSize, halfSize, -1);
+  descriptors[0].xfer.doneIfs = 1;
+  descriptors[1].xfer.doneIfs = 1;
+
+  LDMA_StartTransfer(IADCS_LDMA_CHANNEL, &transferCfg, &descriptors[0]);
+
+  return true;
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Stop the LDMA ring. Stop the scan first so the FIFO is not left to
+ *   overflow.
+ *****************************************************************************/
+void IADCS_Stop(void)
+{
+  LDMA_StopTransfer(IADCS_LDMA_CHANNEL);
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Number of halves filled that were not handed to the callback because
+ *   the LDMA interrupt was served too late.
+ *****************************************************************************/
+uint32_t IADCS_GetDroppedCount(void)
+{
+  return droppedCount;
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Split a half of the ring into one array per channel
+ *
+ * @details
+ *   Only the scan IDs of the first and the last frame are checked. A
+ *   frame is one result from each scan table entry in turn, which only
+ *   gets out of step if the scan FIFO overflows. Results are truncated
+ *   to 16 bits, enough for the right aligned 12 and 16 bit formats.
+ *
+ * @param[in] block
+ *   Part of the ring, count words starting with the first channel.
+ *
+ * @param[in] count
+ *   Number of words, a multiple of channels.
+ *
+ * @param[in] channels
+ *   Number of entries in the scan, the scan table entries 0 to
+ *   channels - 1.
+ *
+ * @param[out] out
+ *   One array of count / channels results per channel.
+ *
+ * @return
+ *   false if the block does not start with channel 0, nothing is written.
+ *****************************************************************************/
+bool IADCS_Demux(const uint32_t *block,
+                 uint32_t count,
+                 uint32_t channels,
+                 uint16_t *const out[])
+{
+  uint32_t frames;
+  const uint32_t *last;
+  uint32_t ch, i;
+
+  if ((channels == 0) || (count < channels) || (count % channels)) {
+    return false;
+  }
+
+  frames = count / channels;
+  last = block + ((frames - 1) * channels);
+
+  for (ch = 0; ch < channels; ch++) {
+    if ((IADCS_ID(block[ch]) != ch) || (IADCS_ID(last[ch]) != ch)) {
+      return false;
+    }
+  }
+
+  for (ch = 0; ch < channels; ch++) {
+    const uint32_t *src = block + ch;
+    uint16_t *dst = out[ch];
+
+    for (i = 0; i < frames; i++) {
+      dst[i] = (uint16_t)IADCS_DATA(*src);
+      src += channels;
+    }
+  }
+
+  return true;
+}
+
+/**************************************************************************//**
+ * @brief  LDMA Handler
+ *****************************************************************************/
+void LDMA_IRQHandler(void)
+{
+  uint32_t pending = LDMA_IntGetEnabled();
+  uint32_t half;
+
+  // Loop here to enable the debugger to see what has happened
+  if (pending & LDMA_IF_ERROR) {
+    __BKPT(0);
+  }
+
+  LDMA_IntClear(1 << IADCS_LDMA_CHANNEL);
+
+  /*
+   * The LDMA has already loaded the next descriptor, so the half it is
+   * writing now tells which one is complete. If it is the same as last
+   * time, the interrupt came too late for a whole half, which has been
+   * overwritten by now.
+   */
+  if (LDMA->CH[IADCS_LDMA_CHANNEL].DST < (uint32_t)(ringStart + halfSize)) {
+    half = 1;
+  } else {
+    half = 0;
+  }
+
+  if (half == lastHalf) {
+    droppedCount++;
+  }
+  lastHalf = half;
+
+  if (blockCallback != NULL) {
+    blockCallback(ringStart + (half * halfSize), halfSize);
+  }
+}
@@ -3,7 +3,9 @@
  *
  * @brief Uses the IADC to take repeated, non-blocking measurements on
  * two external inputs while asleep without any processor overhead.  The
- * LDMA saves results to RAM each time the FIFO fills up.
+ * LDMA streams the results into a ring buffer and interrupts each time
+ * half of it is full, and the main loop splits each half into one array
+ * per input.
  *******************************************************************************
  * # License
  * <b>Copyright 2021 Silicon Laboratories Inc. www.silabs.com</b>
@@ -39,20 +41,44 @@
 #include "em_device.h"
 #include "em_chip.h"
 #include "em_cmu.h"
+#include "em_core.h"
 #include "em_emu.h"
 #include "em_iadc.h"
 #include "em_ldma.h"
 #include "em_gpio.h"
 
 #include "bspconfig.h"
+#include "dspfilter.h"
+#include "iadcstream.h"
 
 /*******************************************************************************
  *******************************   DEFINES   ***********************************
  ******************************************************************************/
 
-// How many samples to capture
+// Size of the sample ring, each half holds NUM_SAMPLES / 2 results
 #define NUM_SAMPLES         1024
 
+// Number of scan table entries, and results per entry in each half
+#define NUM_CHANNELS        2
+#define CHANNEL_SAMPLES     (NUM_SAMPLES / 2 / NUM_CHANNELS)
+
+#if ((NUM_SAMPLES / 2) % NUM_CHANNELS)
+#error "Half of NUM_SAMPLES must hold a whole number of scans"
+#endif
+
+// Rate of each input: 833 ksps, see initIADC(), shared by the scan
+#define SAMPLEFREQ          (833333 / NUM_CHANNELS)
+
+/*
+ * Lowpass corner of both inputs.  Input 0 goes through a second order
+ * Butterworth biquad, input 1 through a linear phase FIR filter with
+ * FILTER_TAPS taps.  Both run in q15 and must finish within a half of the
+ * ring, about 615 us, or that half is counted in blocksDropped.
+ */
+#define FILTER_CORNER       10000
+#define FILTER_STAGES       1
+#define FILTER_TAPS         16
+
 // Set CLK_ADC to 10 MHz
 #define CLK_SRC_ADC_FREQ    20000000  // CLK_SRC_ADC
 #define CLK_ADC_FREQ        10000000  // CLK_ADC - 10 MHz max in normal mode
@@ -79,10 +105,7 @@
 #define IADC_INPUT_1_BUS          BBUSALLOC
 #define IADC_INPUT_1_BUSALLOC     GPIO_BBUSALLOC_BODD0_ADC0
 
-// Use specified LDMA channel
-#define IADC_LDMA_CH              0
-
-// GPIO output toggle to notify LDMA transfer complete
+// GPIO output toggle to notify that half of the ring is full
 #define GPIO_OUTPUT_0_PORT        gpioPortC
 #define GPIO_OUTPUT_0_PIN         5
 
@@ -97,12 +120,42 @@
  ***************************   GLOBAL VARIABLES   *******************************
  ******************************************************************************/
 
-/// Globally declared LDMA link descriptor
-LDMA_Descriptor_t descriptor;
-
-// Buffer to store IADC samples
+// Ring the LDMA stores IADC samples in, interleaved and tagged with IDs
 uint32_t scanBuffer[NUM_SAMPLES];
 
+// The last half of the ring unpacked, one array per input
+uint16_t channel0Data[CHANNEL_SAMPLES];
+uint16_t channel1Data[CHANNEL_SAMPLES];
+
+static uint16_t *const channelData[NUM_CHANNELS] = {
+  channel0Data,
+  channel1Data
+};
+
+// The last half of each input filtered, signed with mid scale at 0
+q15_t channel0Filtered[CHANNEL_SAMPLES];
+q15_t channel1Filtered[CHANNEL_SAMPLES];
+
+// One input scaled to Q15, the filters take signed samples
+static q15_t channelScaled[CHANNEL_SAMPLES];
+
+// Filters, their state carries from one half of the ring to the next
+static DSPFILTER_BiquadQ15_TypeDef channel0Filter;
+static DSPFILTER_FirQ15_TypeDef channel1Filter;
+
+// Half of the ring waiting to be unpacked, set from the LDMA interrupt
+static const uint32_t *volatile readyBlock;
+
+// Average of each input over the last half, and counts of the halves that
+// were missed, not processed in time or did not start with the first input
+volatile uint32_t channelAverage[NUM_CHANNELS];
+volatile uint32_t halvesMissed;
+volatile uint32_t blocksDropped;
+volatile uint32_t blocksMisaligned;
+
+// Core clock cycles spent filtering the last half, both inputs
+volatile uint32_t filterCycles;
+
 /**************************************************************************//**
  * @brief  GPIO initialization
  *****************************************************************************/
@@ -186,10 +239,14 @@ void initIADC(void)
    *
    * Enable DMA wake-up to save the results when the specified FIFO
    * level is hit.
+   *
+   * Tag each FIFO entry with its scan table entry ID, so the unpacking
+   * can check that a half of the ring begins with the first input.
    */
   initScan.triggerAction = iadcTriggerActionContinuous;
   initScan.dataValidLevel = iadcFifoCfgDvl2;
   initScan.fifoDmaWakeup = true;
+  initScan.showId = true;
 
   /*
    * Configure entries in the scan table.  CH0 is single-ended from
@@ -215,62 +272,100 @@ void initIADC(void)
 }
 
 /**************************************************************************//**
- * @brief
- *   LDMA initialization
- *
- * @param[in] buffer
- *   pointer to the array where ADC results will be stored.
- * @param[in] size
- *   size of the array
+ * @brief  Filter initialization
  *****************************************************************************/
-void initLDMA(uint32_t *buffer, uint32_t size)
+void initFilters(void)
 {
-  // Declare LDMA init structs
-  LDMA_Init_t init = LDMA_INIT_DEFAULT;
+  DSPFILTER_Init_TypeDef init;
 
-  // Initialize LDMA with default configuration
-  LDMA_Init(&init);
+  init.type       = dspFilterLowpass;
+  init.sampleRate = SAMPLEFREQ;
+  init.frequency  = FILTER_CORNER;
+  init.q          = 0;
 
-  // Trigger LDMA transfer on IADC scan completion
-  LDMA_TransferCfg_t transferCfg =
-    LDMA_TRANSFER_CFG_PERIPHERAL(ldmaPeripheralSignal_IADC0_IADC_SCAN);
+  init.length = FILTER_STAGES;
+  DSPFILTER_BiquadInitQ15(&channel0Filter, &init);
 
-  /*
-   * Set up a linked descriptor to save scan results to the
-   * user-specified buffer.  By linking the descriptor to itself
-   * (the last argument is the relative jump in terms of the number of
-   * descriptors), transfers will run continuously until firmware
-   * otherwise stops them.
-   */
-  descriptor =
-    (LDMA_Descriptor_t)LDMA_DESCRIPTOR_LINKREL_P2M_WORD(&(IADC0->SCANFIFODATA), buffer, size, 0);
+  init.length = FILTER_TAPS;
+  DSPFILTER_FirInitQ15(&channel1Filter, &init);
 
-  /*
-   * Start the transfer.  The LDMA request and interrupt after saving
-   * the specified number of IADC conversion results.
-   */
-  LDMA_StartTransfer(IADC_LDMA_CH, (void*)&transferCfg, (void*)&descriptor);
+  // Count core clock cycles for filterCycles
+  CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+  DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
 }
 
 /**************************************************************************//**
- * @brief  LDMA Handler
+ * @brief
+ *   Called from the LDMA interrupt each time half of the ring is full
+ *
+ * @param[in] block
+ *   The half just filled.
+ * @param[in] count
+ *   Number of results in it.
  *****************************************************************************/
-void LDMA_IRQHandler(void)
+static void blockReady(const uint32_t *block, uint32_t count)
 {
-  // Clear interrupt flags
-  LDMA_IntClear(1 << IADC_LDMA_CH);
+  (void)count;
+
+  /*
+   * Unpacking is left to the main loop, which has until the LDMA has
+   * filled the other half.  A block still waiting at this point was
+   * not processed in time and is dropped.
+   */
+  if (readyBlock != NULL) {
+    blocksDropped++;
+  }
+  readyBlock = block;
 
   /*
-   * Toggle GPIO to signal LDMA transfer is complete.  The low/high
-   * time will be NUM_SAMPLES divided by the sampling rate, the
+   * Toggle GPIO to signal half of the ring is full.  The low/high time
+   * will be NUM_SAMPLES / 2 divided by the sampling rate, the
    * calculations for which are explained above.  For the example
-   * defaults (1024 samples and a sampling rate of 833 ksps), the
-   * low/high time will be around 1.23 ms, subject to FSRCO tuning
+   * defaults (512 samples and a sampling rate of 833 ksps), the
+   * low/high time will be around 615 us, subject to FSRCO tuning
    * accuracy.
    */
   GPIO_PinOutToggle(GPIO_OUTPUT_0_PORT, GPIO_OUTPUT_0_PIN);
 }
 
+/**************************************************************************//**
+ * @brief
+ *   Unpack a half of the ring, average each input over it and filter it
+ *
+ * @param[in] block
+ *   The half to process.
+ *****************************************************************************/
+static void processBlock(const uint32_t *block)
+{
+  uint32_t ch, i, sum, start;
+
+  if (!IADCS_Demux(block, NUM_SAMPLES / 2, NUM_CHANNELS, channelData)) {
+    blocksMisaligned++;
+    return;
+  }
+
+  // Each input is now contiguous, so filters run without branching on IDs
+  for (ch = 0; ch < NUM_CHANNELS; ch++) {
+    sum = 0;
+    for (i = 0; i < CHANNEL_SAMPLES; i++) {
+      sum += channelData[ch][i];
+    }
+    channelAverage[ch] = sum / CHANNEL_SAMPLES;
+  }
+
+  start = DWT->CYCCNT;
+
+  DSPFILTER_Unsigned12ToQ15(channel0Data, channelScaled, CHANNEL_SAMPLES);
+  DSPFILTER_BiquadQ15(&channel0Filter, channelScaled, channel0Filtered,
+                      CHANNEL_SAMPLES);
+
+  DSPFILTER_Unsigned12ToQ15(channel1Data, channelScaled, CHANNEL_SAMPLES);
+  DSPFILTER_FirQ15(&channel1Filter, channelScaled, channel1Filtered,
+                   CHANNEL_SAMPLES);
+
+  filterCycles = DWT->CYCCNT - start;
+}
+
 /**************************************************************************//**
  * @brief  Main function
  *****************************************************************************/
@@ -282,6 +377,8 @@ int main(void)
 
   initIADC();
 
+  initFilters();
+
 #ifdef EM2DEBUG
 #if (EM2DEBUG == 1)
   // Enable debug connectivity in EM2
@@ -289,13 +386,30 @@ int main(void)
 #endif
 #endif
 
-  initLDMA(scanBuffer, NUM_SAMPLES);
+  IADCS_Init(scanBuffer, NUM_SAMPLES, blockReady);
 
   // Start scan
   IADC_command(IADC0, iadcCmdStartScan);
 
   while (1) {
-    // Sleep until LDMA transfer completes
-    EMU_EnterEM2(true);
+    const uint32_t *block;
+    CORE_DECLARE_IRQ_STATE;
+
+    // Sleep until half of the ring is full, checking with interrupts
+    // masked so a block that is ready just now does not wait for the next
+    CORE_ENTER_CRITICAL();
+    if (readyBlock == NULL) {
+      EMU_EnterEM2(true);
+    }
+    block = readyBlock;
+    readyBlock = NULL;
+    CORE_EXIT_CRITICAL();
+
+    if (block != NULL) {
+      processBlock(block);
+    }
+
+    // Halves the LDMA interrupt itself was too late for
+    halvesMissed = IADCS_GetDroppedCount();
   }
 }
@@ -0,0 +1,85 @@
+/***************************************************************************//**
+ * @file flashpipe.h
+ *
+ * @brief Sample stream into MX25 flash pages by non-blocking page program.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2021 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ******************************************************************************/
+
+#ifndef FLASHPIPE_H
+#define FLASHPIPE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "mx25flash_spi.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// RAM pages queued for the flash, they cover the stall of a sector erase
+#ifndef FLASHP_PAGES
+#define FLASHP_PAGES          16
+#endif
+
+// Pages per 4 kB sector
+#define FLASHP_SECTOR_PAGES   (Sector_Offset / Page_Offset)
+
+// Flash area of the stream, written as a ring of sectors
+typedef struct {
+  uint32_t base;          // First sector, sector aligned
+  uint32_t sectors;       // Sectors, at least 2
+  bool     pack12;        // Two 12 bit samples in three bytes
+} FLASHP_Init_t;
+
+// Counters, all only ever count up
+typedef struct {
+  uint32_t samples;       // Samples queued
+  uint32_t bytes;         // Bytes queued
+  uint32_t dropped;       // Samples lost to a full queue
+  uint32_t pages;         // Pages programmed
+  uint32_t erases;        // Sectors erased
+  uint32_t errors;        // Program or erase timeouts
+  uint32_t programMs;     // Time from page programs to their completion
+  uint32_t eraseMs;       // Time from sector erases to their completion
+  uint32_t shiftUs;       // Time shifting page data out, in us
+  uint32_t maxQueued;     // Most full pages waiting at once
+} FLASHP_Stats_t;
+
+bool FLASHP_Init(const FLASHP_Init_t *init);
+bool FLASHP_Write(const uint32_t *words, uint32_t count);
+bool FLASHP_WriteBytes(const void *data, uint32_t length, uint32_t samples);
+bool FLASHP_Process(uint32_t now);
+bool FLASHP_Idle(void);
+void FLASHP_GetStats(FLASHP_Stats_t *stats);
+uint32_t FLASHP_SustainedBytes(const FLASHP_Stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // FLASHPIPE_H
@@ -0,0 +1,418 @@
+/***************************************************************************//**
+ * @file flashpipe.c
+ *
+ * @brief Sample stream into MX25 flash pages by non-blocking page program.
+ *
+ * Two linked descriptors each fill one half of the ring and link to each
+ * other, so the LDMA empties the scan FIFO without ever stopping. Both
+ * raise the channel interrupt when done, which hands the half just
+ * filled to the application while the LDMA fills the other one.
+ *
+ * IADCS_Demux() unpacks a half from the interleaved FIFO word format
+ * into one contiguous array per scan table entry, so filters can then
+ * run over each channel without looking at the scan ID of every sample.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2021 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ *******************************************************************************
+ * # Evaluation Quality
+ * This code has been minimally tested to ensure that it builds and is suitable 
+ * as a demonstration for evaluation purposes only. This code will be maintained
+ * at the sole discretion of Silicon Labs.
+ ******************************************************************************/
+
+
+#include "em_device.h"
+
+#include "flashpipe.h"
+
+// Page queue: full pages from sendPage up to fillPage, then the page being
+// filled. Both indexes run freely.
+static uint8_t pages[FLASHP_PAGES][Page_Offset];
+static uint32_t fillPage;
+static uint32_t fillBytes;
+static uint32_t sendPage;
+
+// Ring of sectors, the next page goes to writeAddr
+static uint32_t areaBase;
+static uint32_t areaSize;
+static uint32_t writeAddr;
+
+// Pages erased from writeAddr on, up to two sectors
+static uint32_t erasedPages;
+
+// Packing, the first of two 12 bit samples waits for the second
+static bool pack12;
+static bool pendingHalf;
+static uint16_t pendingSample;
+
+// Time the flash operation in progress was started
+static uint32_t opStart;
+static uint32_t lastNow;
+
+static FLASHP_Stats_t stats;
+
+/**************************************************************************//**
+ * @brief
+ *   Free bytes in the page queue
+ *****************************************************************************/
+static uint32_t freeBytes(void)
+{
+  return ((FLASHP_PAGES - (fillPage - sendPage)) * Page_Offset) - fillBytes;
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Append a byte to the page being filled, the caller checks for room
+ *****************************************************************************/
+static void putByte(uint8_t byte)
+{
+  pages[fillPage % FLASHP_PAGES][fillBytes++] = byte;
+
+  if (fillBytes == Page_Offset) {
+    fillBytes = 0;
+    fillPage++;
+    if ((fillPage - sendPage) > stats.maxQueued) {
+      stats.maxQueued = fillPage - sendPage;
+    }
+  }
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Flash address a number of bytes after the next page, in the ring
+ *****************************************************************************/
+static uint32_t ahead(uint32_t bytes)
+{
+  return areaBase + (((writeAddr - areaBase) + bytes) % areaSize);
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Called from MX25_PollAsync() when a page program is done
+ *****************************************************************************/
+static void programDone(ReturnMsg status)
+{
+  stats.programMs += lastNow - opStart;
+  if (status != FlashOperationSuccess) {
+    stats.errors++;
+  }
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Called from MX25_PollAsync() when a sector erase is done
+ *
+ * @details
+ *   A sector that timed out is written all the same, its pages may then
+ *   not read back as written.
+ *****************************************************************************/
+static void eraseDone(ReturnMsg status)
+{
+  stats.eraseMs += lastNow - opStart;
+  stats.erases++;
+  erasedPages += FLASHP_SECTOR_PAGES;
+  if (status != FlashOperationSuccess) {
+    stats.errors++;
+  }
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Start a stream at the first sector of the area
+ *
+ * @details
+ *   Call after MX25_init(). The stream starts over at each call, and the
+ *   first sector is erased by the first FLASHP_Process() calls. Once the
+ *   ring is full each sector erased ahead takes the oldest data with it.
+ *
+ * @param[in] init
+ *   Area and format of the stream.
+ *
+ * @return
+ *   false if the area does not fit the flash.
+ *****************************************************************************/
+bool FLASHP_Init(const FLASHP_Init_t *init)
+{
+  if ((init->sectors < 2)
+      || ((init->base % Sector_Offset) != 0)
+      || ((init->base + (init->sectors * Sector_Offset)) > FlashSize)) {
+    return false;
+  }
+
+  areaBase = init->base;
+  areaSize = init->sectors * Sector_Offset;
+  writeAddr = areaBase;
+  erasedPages = 0;
+
+  pack12 = init->pack12;
+  pendingHalf = false;
+
+  fillPage = 0;
+  fillBytes = 0;
+  sendPage = 0;
+
+  stats.samples = 0;
+  stats.bytes = 0;
+  stats.dropped = 0;
+  stats.pages = 0;
+  stats.erases = 0;
+  stats.errors = 0;
+  stats.programMs = 0;
+  stats.eraseMs = 0;
+  stats.shiftUs = 0;
+  stats.maxQueued = 0;
+
+  // Count core clock cycles to time the page shifts
+  CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+  DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+  return true;
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Queue samples for the flash
+ *
+ * @details
+ *   Only copies the samples into the page queue, call from thread context
+ *   as FLASHP_Process(). The samples are the low 16 bits of each word, the
+ *   low 12 when packed; packed samples go as their low byte, then the high
+ *   nibble of the first with the low nibble of the second, then the high
+ *   byte of the second. A block that does not fit is dropped whole, so the
+ *   stream stays aligned on samples.
+ *
+ * @param[in] words
+ *   Samples, one per word.
+ *
+ * @param[in] count
+ *   Number of samples.
+ *
+ * @return
+ *   false if the queue is full and the block was dropped.
+ *****************************************************************************/
+bool FLASHP_Write(const uint32_t *words, uint32_t count)
+{
+  uint32_t bytes, i;
+  uint16_t sample;
+
+  if (pack12) {
+    bytes = ((count + (pendingHalf ? 1 : 0)) / 2) * 3;
+  } else {
+    bytes = count * 2;
+  }
+
+  if (bytes > freeBytes()) {
+    stats.dropped += count;
+    return false;
+  }
+
+  for (i = 0; i < count; i++) {
+    if (!pack12) {
+      putByte((uint8_t)words[i]);
+      putByte((uint8_t)(words[i] >> 8));
+      continue;
+    }
+
+    sample = (uint16_t)(words[i] & 0x0FFF);
+    if (!pendingHalf) {
+      pendingSample = sample;
+      pendingHalf = true;
+      continue;
+    }
+
+    putByte((uint8_t)pendingSample);
+    putByte((uint8_t)((pendingSample >> 8) | (sample << 4)));
+    putByte((uint8_t)(sample >> 4));
+    pendingHalf = false;
+  }
+
+  stats.samples += count;
+  stats.bytes += bytes;
+
+  return true;
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Queue bytes already in their stored format, such as coded blocks
+ *
+ * @details
+ *   As FLASHP_Write(), but the bytes go as they are. Do not mix with
+ *   packed samples, a sample waiting for the second of its pair would
+ *   end up after the bytes.
+ *
+ * @param[in] data
+ *   Bytes to store.
+ *
+ * @param[in] length
+ *   Number of bytes.
+ *
+ * @param[in] samples
+ *   Number of samples they hold, for the counters.
+ *
+ * @return
+ *   false if the queue is full and the bytes were dropped.
+ *****************************************************************************/
+bool FLASHP_WriteBytes(const void *data, uint32_t length, uint32_t samples)
+{
+  const uint8_t *byte = data;
+  uint32_t i;
+
+  if (length > freeBytes()) {
+    stats.dropped += samples;
+    return false;
+  }
+
+  for (i = 0; i < length; i++) {
+    putByte(byte[i]);
+  }
+
+  stats.samples += samples;
+  stats.bytes += length;
+
+  return true;
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Move the stream on to the flash
+ *
+ * @details
+ *   Call from the main loop at least every MX25_ASYNC_POLL_MS while
+ *   FLASHP_Idle() is false, and after each FLASHP_Write(). Polls the
+ *   flash operation in progress; once the flash is free it programs the
+ *   next full page, ahead of everything else, or erases the next sector
+ *   ahead. One sector is kept erased beyond the one being written when
+ *   there is nothing to program, so an erase shares the idle time of the
+ *   flash and the queue only covers the erases the writes catch up with.
+ *
+ *   Each page is shifted out here by MX25_PP_Async(), only the program
+ *   time of the flash is left to the polls.
+ *
+ * @param[in] now
+ *   Time in ms, it times the flash operations.
+ *
+ * @return
+ *   false if there was nothing to do.
+ *****************************************************************************/
+bool FLASHP_Process(uint32_t now)
+{
+  uint32_t start;
+
+  lastNow = now;
+
+  if (MX25_AsyncBusy() && (MX25_PollAsync() == FlashIsBusy)) {
+    return true;
+  }
+
+  if ((fillPage != sendPage) && (erasedPages > 0)) {
+    start = DWT->CYCCNT;
+    if (MX25_PP_Async(writeAddr, pages[sendPage % FLASHP_PAGES],
+                      Page_Offset, programDone) != FlashOperationSuccess) {
+      return true;
+    }
+    stats.shiftUs += (DWT->CYCCNT - start) / (SystemCoreClock / 1000000);
+    stats.pages++;
+    opStart = now;
+
+    // The page data is already out, the RAM page is free again
+    sendPage++;
+    erasedPages--;
+    writeAddr = ahead(Page_Offset);
+    return true;
+  }
+
+  if (erasedPages <= FLASHP_SECTOR_PAGES) {
+    if (MX25_SE_Async(ahead(erasedPages * Page_Offset), eraseDone)
+        != FlashOperationSuccess) {
+      return true;
+    }
+    opStart = now;
+    return true;
+  }
+
+  return false;
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Whether nothing is queued and no flash operation is in progress
+ *
+ * @details
+ *   Data still in the page being filled waits for more samples.
+ *****************************************************************************/
+bool FLASHP_Idle(void)
+{
+  return !MX25_AsyncBusy()
+         && (fillPage == sendPage)
+         && (erasedPages > FLASHP_SECTOR_PAGES);
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Copy the counters
+ *****************************************************************************/
+void FLASHP_GetStats(FLASHP_Stats_t *copy)
+{
+  *copy = stats;
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Bytes per second the flash would take with no idle time
+ *
+ * @details
+ *   A sector takes FLASHP_SECTOR_PAGES page programs, each shifting the
+ *   page out and then waiting for the flash, and one erase. The mean of
+ *   each so far gives the time per sector, so the rate includes the
+ *   resolution of the polls. Any steady data rate above it fills the
+ *   queue sooner or later.
+ *
+ * @param[in] counters
+ *   Counters from FLASHP_GetStats().
+ *
+ * @return
+ *   Sustained bytes per second, 0 until a page and an erase were timed.
+ *****************************************************************************/
+uint32_t FLASHP_SustainedBytes(const FLASHP_Stats_t *counters)
+{
+  uint64_t pageUs, sectorUs;
+
+  if ((counters->pages == 0) || (counters->erases == 0)) {
+    return 0;
+  }
+
+  pageUs = (((uint64_t)counters->programMs * 1000) + counters->shiftUs)
+           / counters->pages;
+  sectorUs = (pageUs * FLASHP_SECTOR_PAGES)
+             + (((uint64_t)counters->eraseMs * 1000) / counters->erases);
+
+  if (sectorUs == 0) {
+    return 0;
+  }
+
+  return (uint32_t)(((uint64_t)Sector_Offset * 1000000) / sectorUs);
+}
@@ -0,0 +1,470 @@
+/***************************************************************************//**
+ * @file main_scan_flash_log.c
+ *
+ * @brief Captures a timed IADC scan of two inputs to the MX25 SPI flash.
+ * The LDMA streams the results into a ring buffer and interrupts each
+ * time half of it is full; the main loop packs each half into RAM pages
+ * and programs them into the flash with the non-blocking page program,
+ * erasing the sectors ahead, and reports the throughput once a second.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2021 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ *******************************************************************************
+ * # Evaluation Quality
+ * This code has been minimally tested to ensure that it builds and is suitable 
+ * as a demonstration for evaluation purposes only. This code will be maintained
+ * at the sole discretion of Silicon Labs.
+ ******************************************************************************/
+
+#include <stdio.h>
+
+#include "em_device.h"
+#include "em_chip.h"
+#include "em_cmu.h"
+#include "em_core.h"
+#include "em_emu.h"
+#include "em_iadc.h"
+#include "em_ldma.h"
+#include "em_gpio.h"
+
+#include "retargetserial.h"
+#include "mx25flash_spi.h"
+#include "flashpipe.h"
+#include "iadcstream.h"
+#include "samplecodec.h"
+
+/*******************************************************************************
+ *******************************   DEFINES   ***********************************
+ ******************************************************************************/
+
+// Scans per second, each converts both inputs
+#define SCAN_RATE           2000
+#define NUM_CHANNELS        2
+
+// Size of the sample ring, each half holds 50 ms of scans at SCAN_RATE
+#define NUM_SAMPLES         400
+#define CHANNEL_SAMPLES     (NUM_SAMPLES / 2 / NUM_CHANNELS)
+
+// Flash area, 512 kB from 256 kB up
+#define LOG_BASE            0x40000
+#define LOG_SECTORS         128
+
+/*
+ * Stored format: 0 for 16 bit samples, interleaved; 1 for two 12 bit
+ * samples in 3 bytes, interleaved; 2 for a delta and Rice coded block
+ * per input and half of the ring, input 0 first.
+ */
+#define LOG_FORMAT          2
+#define LOG_PACK12          (LOG_FORMAT == 1)
+#define LOG_CODED           (LOG_FORMAT == 2)
+
+// Halves of the ring per report, one second of scans
+#define HALVES_PER_REPORT   ((SCAN_RATE * NUM_CHANNELS) / (NUM_SAMPLES / 2))
+
+// Set CLK_ADC to 10 MHz
+#define CLK_SRC_ADC_FREQ    20000000  // CLK_SRC_ADC
+#define CLK_ADC_FREQ        10000000  // CLK_ADC - 10 MHz max in normal mode
+
+/*
+ * Specify the IADC input using the IADC_PosInput_t typedef.  This
+ * must be paired with a corresponding macro definition that allocates
+ * the corresponding ABUS to the IADC.  These are...
+ *
+ * GPIO->ABUSALLOC |= GPIO_ABUSALLOC_AEVEN0_ADC0
+ * GPIO->ABUSALLOC |= GPIO_ABUSALLOC_AODD0_ADC0
+ * GPIO->BBUSALLOC |= GPIO_BBUSALLOC_BEVEN0_ADC0
+ * GPIO->BBUSALLOC |= GPIO_BBUSALLOC_BODD0_ADC0
+ * GPIO->CDBUSALLOC |= GPIO_CDBUSALLOC_CDEVEN0_ADC0
+ * GPIO->CDBUSALLOC |= GPIO_CDBUSALLOC_CDODD0_ADC0
+ *
+ * ...for port A, port B, and port C/D pins, even and odd, respectively.
+ */
+#define IADC_INPUT_0_PORT_PIN     iadcPosInputPortBPin0;
+#define IADC_INPUT_1_PORT_PIN     iadcPosInputPortBPin1;
+
+#define IADC_INPUT_0_BUS          BBUSALLOC
+#define IADC_INPUT_0_BUSALLOC     GPIO_BBUSALLOC_BEVEN0_ADC0
+#define IADC_INPUT_1_BUS          BBUSALLOC
+#define IADC_INPUT_1_BUSALLOC     GPIO_BBUSALLOC_BODD0_ADC0
+
+#if ((SCAN_RATE * NUM_CHANNELS) % (NUM_SAMPLES / 2)) != 0
+#error "A second of scans must fill a whole number of halves"
+#endif
+
+/*******************************************************************************
+ ***************************   GLOBAL VARIABLES   *******************************
+ ******************************************************************************/
+
+// Ring the LDMA stores IADC samples in, interleaved and tagged with IDs
+uint32_t scanBuffer[NUM_SAMPLES];
+
+// The last half of the ring unpacked, one array per input, and coded
+uint16_t channel0Data[CHANNEL_SAMPLES];
+uint16_t channel1Data[CHANNEL_SAMPLES];
+
+static uint16_t *const channelData[NUM_CHANNELS] = {
+  channel0Data,
+  channel1Data
+};
+
+static uint8_t codeBuffer[NUM_CHANNELS
+                          * SAMPLECODEC_MAX_BYTES(CHANNEL_SAMPLES)];
+
+// Core clock cycles spent coding the last half, both inputs, and coded
+// blocks that did not decode back to the samples
+volatile uint32_t codecCycles;
+volatile uint32_t codecErrors;
+
+// Half of the ring waiting to be written, set from the LDMA interrupt
+static const uint32_t *volatile readyBlock;
+
+// Halves missed by the LDMA interrupt, not handed to the flash in time or
+// not starting with the first input
+volatile uint32_t halvesMissed;
+volatile uint32_t blocksDropped;
+volatile uint32_t blocksMisaligned;
+
+// Time while awake, SysTick does not run in EM2
+static volatile uint32_t msTicks;
+
+/**************************************************************************//**
+ * @brief  SysTick interrupt handler, the flash poll tick
+ *****************************************************************************/
+void SysTick_Handler(void)
+{
+  msTicks++;
+}
+
+/**************************************************************************//**
+ * @brief  IADC initialization
+ *****************************************************************************/
+void initIADC(void)
+{
+  // Declare initialization structures
+  IADC_Init_t init = IADC_INIT_DEFAULT;
+  IADC_AllConfigs_t initAllConfigs = IADC_ALLCONFIGS_DEFAULT;
+  IADC_InitScan_t initScan = IADC_INITSCAN_DEFAULT;
+
+  // Scan table structure
+  IADC_ScanTable_t scanTable = IADC_SCANTABLE_DEFAULT;
+
+  CMU_ClockEnable(cmuClock_IADC0, true);
+
+  // Use the FSRC0 as the IADC clock so it can run in EM2
+  CMU_ClockSelectSet(cmuClock_IADCCLK, cmuSelect_FSRCO);
+
+  // Shutdown between conversions to reduce current
+  init.warmup = iadcWarmupNormal;
+
+  // Set the HFSCLK prescale value here
+  init.srcClkPrescale = IADC_calcSrcClkPrescale(IADC0, CLK_SRC_ADC_FREQ, 0);
+
+  // The IADC local timer counts CLK_SRC_ADC cycles
+  init.timerCycles = CMU_ClockFreqGet(cmuClock_IADCCLK) / SCAN_RATE;
+
+  /*
+   * Configuration 0 is used by both scan and single conversions by
+   * default.  Use internal bandgap as the reference and specify the
+   * reference voltage in mV.
+   *
+   * Resolution is not configurable directly but is based on the
+   * selected oversampling ratio (osrHighSpeed), which defaults to
+   * 2x and generates 12-bit results.
+   */
+  initAllConfigs.configs[0].reference = iadcCfgReferenceInt1V2;
+  initAllConfigs.configs[0].vRef = 1210;
+  initAllConfigs.configs[0].osrHighSpeed = iadcCfgOsrHighSpeed2x;
+  initAllConfigs.configs[0].analogGain = iadcCfgAnalogGain0P5x;
+
+  // Divides CLK_SRC_ADC to set the CLK_ADC frequency
+  initAllConfigs.configs[0].adcClkPrescale = IADC_calcAdcClkPrescale(IADC0,
+                                                                     CLK_ADC_FREQ,
+                                                                     0,
+                                                                     iadcCfgModeNormal,
+                                                                     init.srcClkPrescale);
+
+  /*
+   * The local timer triggers each scan, started together with the scan
+   * in main().  The LDMA empties the FIFO, also in EM2, and each entry
+   * is tagged with its scan table entry ID so a half of the ring can be
+   * checked to begin with the first input.
+   */
+  initScan.triggerSelect = iadcTriggerSelTimer;
+  initScan.dataValidLevel = iadcFifoCfgDvl2;
+  initScan.fifoDmaWakeup = true;
+  initScan.showId = true;
+
+  /*
+   * Configure entries in the scan table.  CH0 is single-ended from
+   * input 0; CH1 is single-ended from input 1.
+   */
+  scanTable.entries[0].posInput = IADC_INPUT_0_PORT_PIN;
+  scanTable.entries[0].negInput = iadcNegInputGnd;
+  scanTable.entries[0].includeInScan = true;
+
+  scanTable.entries[1].posInput = IADC_INPUT_1_PORT_PIN;
+  scanTable.entries[1].negInput = iadcNegInputGnd;
+  scanTable.entries[1].includeInScan = true;
+
+  // Initialize IADC
+  IADC_init(IADC0, &init, &initAllConfigs);
+
+  // Initialize scan
+  IADC_initScan(IADC0, &initScan, &scanTable);
+
+  // Allocate the analog bus for ADC0 inputs
+  GPIO->IADC_INPUT_0_BUS |= IADC_INPUT_0_BUSALLOC;
+  GPIO->IADC_INPUT_1_BUS |= IADC_INPUT_1_BUSALLOC;
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Called from the LDMA interrupt each time half of the ring is full
+ *
+ * @param[in] block
+ *   The half just filled.
+ * @param[in] count
+ *   Number of results in it.
+ *****************************************************************************/
+static void blockReady(const uint32_t *block, uint32_t count)
+{
+  (void)count;
+
+  // The main loop has until the LDMA has filled the other half
+  if (readyBlock != NULL) {
+    blocksDropped++;
+  }
+  readyBlock = block;
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Split a half of the ring into its inputs and code each for the flash
+ *
+ * @details
+ *   The blocks of both inputs are queued together, or dropped together
+ *   if the queue is full. Each decodes on its own, as its header holds
+ *   the sample count and the first sample.
+ *
+ * @param[in] block
+ *   The half to write.
+ *****************************************************************************/
+static void writeCoded(const uint32_t *block)
+{
+  uint32_t ch, length = 0, start;
+
+  if (!IADCS_Demux(block, NUM_SAMPLES / 2, NUM_CHANNELS, channelData)) {
+    blocksMisaligned++;
+    return;
+  }
+
+  start = DWT->CYCCNT;
+  for (ch = 0; ch < NUM_CHANNELS; ch++) {
+    length += SAMPLECODEC_Encode((const int16_t *)channelData[ch],
+                                 CHANNEL_SAMPLES, &codeBuffer[length]);
+  }
+  codecCycles = DWT->CYCCNT - start;
+
+  // A full queue is counted by the pipe
+  FLASHP_WriteBytes(codeBuffer, length, NUM_SAMPLES / 2);
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Decode the last coded block of input 0 and compare it with the input
+ *****************************************************************************/
+static void checkCoded(void)
+{
+  static int16_t decoded[CHANNEL_SAMPLES];
+  uint32_t count, i;
+
+  if (SAMPLECODEC_Decode(codeBuffer, sizeof(codeBuffer), decoded,
+                         CHANNEL_SAMPLES, &count) == 0) {
+    codecErrors++;
+    return;
+  }
+
+  for (i = 0; i < CHANNEL_SAMPLES; i++) {
+    if ((uint16_t)decoded[i] != channel0Data[i]) {
+      codecErrors++;
+      return;
+    }
+  }
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Queue a half of the ring for the flash
+ *
+ * @param[in] block
+ *   The half to write.
+ *****************************************************************************/
+static void writeBlock(const uint32_t *block)
+{
+  const uint32_t *last = block + (NUM_SAMPLES / 2) - NUM_CHANNELS;
+
+  if (LOG_CODED) {
+    writeCoded(block);
+    return;
+  }
+
+  // Only whole scans go to the flash, so the inputs stay in order there
+  if ((IADCS_ID(block[0]) != 0) || (IADCS_ID(last[0]) != 0)) {
+    blocksMisaligned++;
+    return;
+  }
+
+  // A full queue is counted by the pipe
+  FLASHP_Write(block, NUM_SAMPLES / 2);
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Print the throughput of the last second and the sustained rate
+ *
+ * @details
+ *   The size is the bytes queued in the last second against 16 bits per
+ *   sample. The sustained rate is the most the flash has been able to
+ *   take, from the mean page program and erase times so far, as samples
+ *   per second at the size of the last second. The busy time is the part
+ *   of the second the flash spent programming and erasing, in EM1; the
+ *   rest is spent in EM2 but for the LDMA interrupts.
+ *****************************************************************************/
+static void report(uint32_t seconds)
+{
+  static FLASHP_Stats_t last;
+  FLASHP_Stats_t now;
+  uint32_t bytes, samples, sustained, busyMs;
+
+  FLASHP_GetStats(&now);
+
+  bytes = now.bytes - last.bytes;
+  samples = now.samples - last.samples;
+  sustained = (bytes == 0) ? 0
+              : (uint32_t)(((uint64_t)FLASHP_SustainedBytes(&now) * samples)
+                           / bytes);
+  busyMs = (now.programMs - last.programMs) + (now.eraseMs - last.eraseMs);
+
+  printf("%5lu s %6lu B/s %3lu%% size %4lu pages %3lu erases %6lu dropped"
+         " %2lu queued %3lu%% busy, sustained %6lu S/s",
+         seconds,
+         bytes,
+         (samples == 0) ? 0 : (bytes * 50) / samples,
+         now.pages - last.pages,
+         now.erases - last.erases,
+         now.dropped,
+         now.maxQueued,
+         busyMs / 10,
+         sustained);
+
+  if (LOG_CODED) {
+    checkCoded();
+    printf(", %lu cycles/sample %s",
+           codecCycles / (NUM_SAMPLES / 2),
+           (codecErrors == 0) ? "OK" : "CODEC MISMATCH");
+  }
+  printf("\n");
+
+  last = now;
+}
+
+/**************************************************************************//**
+ * @brief  Main function
+ *****************************************************************************/
+int main(void)
+{
+  FLASHP_Init_t pipeInit;
+  uint32_t halves = 0;
+  uint32_t seconds = 0;
+  uint32_t lastTick = 0;
+
+  CHIP_Init();
+
+  // Retarget to USART1 so that USART0 stays with the flash
+  RETARGET_SerialInit();
+  RETARGET_SerialCrLf(1);
+
+  MX25_init();
+
+  pipeInit.base = LOG_BASE;
+  pipeInit.sectors = LOG_SECTORS;
+  pipeInit.pack12 = LOG_PACK12;
+  if (!FLASHP_Init(&pipeInit)) {
+    while (1) ;
+  }
+
+  printf("\nIADC to MX25, %u scans/s of %u inputs, format %u\n",
+         SCAN_RATE, NUM_CHANNELS, LOG_FORMAT);
+
+  // 1 ms tick while awake, the flash poll period
+  if (SysTick_Config(CMU_ClockFreqGet(cmuClock_SYSCLK) / 1000)) while (1) ;
+
+  initIADC();
+
+  IADCS_Init(scanBuffer, NUM_SAMPLES, blockReady);
+
+  // Start the scan and the timer that triggers it
+  IADC_command(IADC0, iadcCmdStartScan);
+  IADC_command(IADC0, iadcCmdEnableTimer);
+
+  while (1) {
+    const uint32_t *block;
+    CORE_DECLARE_IRQ_STATE;
+
+    /*
+     * Sleep until half of the ring is full or, while the flash has work,
+     * the next tick; checking with interrupts masked so a block that is
+     * ready just now does not wait.  The USART and SysTick need EM1.
+     */
+    CORE_ENTER_CRITICAL();
+    if ((readyBlock == NULL) && (msTicks == lastTick)) {
+      if (FLASHP_Idle()) {
+        EMU_EnterEM2(true);
+      } else {
+        EMU_EnterEM1();
+      }
+    }
+    block = readyBlock;
+    readyBlock = NULL;
+    CORE_EXIT_CRITICAL();
+
+    lastTick = msTicks;
+
+    if (block != NULL) {
+      writeBlock(block);
+
+      if (++halves == HALVES_PER_REPORT) {
+        halves = 0;
+        report(++seconds);
+      }
+    }
+
+    // Polls the flash and starts the next page or erase once it is free
+    FLASHP_Process(lastTick);
+
+    // Halves the LDMA interrupt itself was too late for
+    halvesMissed = IADCS_GetDroppedCount();
+  }
+}
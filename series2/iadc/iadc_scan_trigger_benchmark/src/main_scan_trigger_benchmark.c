@@ -0,0 +1,649 @@
+/***************************************************************************//**
+ * @file main_scan_trigger_benchmark.c
+ * @brief Compare the sampling jitter and the supply current of the IADC
+ * local timer, LETIMER/PRS and TIMER/PRS as scan trigger sources.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2021 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ *******************************************************************************
+ * # Evaluation Quality
+ * This code has been minimally tested to ensure that it builds and is suitable 
+ * as a demonstration for evaluation purposes only. This code will be maintained
+ * at the sole discretion of Silicon Labs.
+ ******************************************************************************/
+
+
+#include <math.h>
+#include "em_device.h"
+#include "em_chip.h"
+#include "em_core.h"
+#include "em_cmu.h"
+#include "em_emu.h"
+#include "em_gpio.h"
+#include "em_iadc.h"
+#include "em_ldma.h"
+#include "em_letimer.h"
+#include "em_prs.h"
+#include "em_timer.h"
+#include "bsp.h"
+
+/*******************************************************************************
+ *******************************   DEFINES   ***********************************
+ ******************************************************************************/
+
+// Set CLK_ADC to 10 MHz, CLK_SRC_ADC from the FSRCO so the IADC runs in EM2
+#define CLK_SRC_ADC_FREQ        20000000  // CLK_SRC_ADC
+#define CLK_ADC_FREQ            10000000  // CLK_ADC - 10 MHz max in normal mode
+
+// Number of scan channels
+#define NUM_INPUTS 2
+
+/*
+ * Specify the IADC input using the IADC_PosInput_t typedef.  This
+ * must be paired with a corresponding macro definition that allocates
+ * the corresponding ABUS to the IADC.  These are...
+ *
+ * GPIO->ABUSALLOC |= GPIO_ABUSALLOC_AEVEN0_ADC0
+ * GPIO->ABUSALLOC |= GPIO_ABUSALLOC_AODD0_ADC0
+ * GPIO->BBUSALLOC |= GPIO_BBUSALLOC_BEVEN0_ADC0
+ * GPIO->BBUSALLOC |= GPIO_BBUSALLOC_BODD0_ADC0
+ * GPIO->CDBUSALLOC |= GPIO_CDBUSALLOC_CDEVEN0_ADC0
+ * GPIO->CDBUSALLOC |= GPIO_CDBUSALLOC_CDODD0_ADC0
+ *
+ * ...for port A, port B, and port C/D pins, even and odd, respectively.
+ */
+#define IADC_INPUT_0_PORT_PIN     iadcPosInputPortBPin0;
+#define IADC_INPUT_1_PORT_PIN     iadcPosInputPortBPin1;
+
+#define IADC_INPUT_0_BUS          BBUSALLOC
+#define IADC_INPUT_0_BUSALLOC     GPIO_BBUSALLOC_BEVEN0_ADC0
+#define IADC_INPUT_1_BUS          BBUSALLOC
+#define IADC_INPUT_1_BUSALLOC     GPIO_BBUSALLOC_BODD0_ADC0
+
+// GPIO output, high while a trigger source runs its energy phase
+#define GPIO_OUTPUT_0_PORT        gpioPortC
+#define GPIO_OUTPUT_0_PIN         5
+
+#if defined(BSP_WSTK_BRD4181A) || defined(BSP_WSTK_BRD4182A)
+// HFXO frequency set for BRD4181A and BRD4182A
+#define HFXO_FREQ               38400000
+#else
+// HFXO frequency for rest of radio boards
+#define HFXO_FREQ               39000000
+#endif
+
+// Scan rate of every trigger source: LFXO / 32, FSRCO / 19531 and
+// HFXO / 37500 (38.4 MHz) or HFXO / 38086 (39 MHz)
+#define SCAN_RATE               1024
+
+// Scans timestamped in each jitter phase, one second
+#define JITTER_SCANS            1024
+
+// The first scans after starting include the IADC and reference warmup and
+// are left out of the statistics
+#define JITTER_SKIP             2
+
+// Length of each energy phase in seconds
+#define ENERGY_SECONDS          10
+
+// Scans per LDMA interrupt, the core wakes up twice per second
+#define SCAN_BLOCK              512
+
+// LDMA channels emptying the scan FIFO and the TIMER0 capture FIFO
+#define SCAN_LDMA_CH            0
+#define TIME_LDMA_CH            1
+
+// PRS channels from the trigger source to the IADC and from the IADC scan
+// table done pulse to TIMER0 CC0 capture
+#define TRIGGER_PRS_CH          0
+#define TIMESTAMP_PRS_CH        1
+
+/* This example enters EM2 in the energy phases; Setting this define to 1
+ * enables debug connectivity in the EMU_CTRL register, which will consume about
+ * 0.5uA additional supply current */
+#define EM2DEBUG                  1
+
+/*******************************************************************************
+ ***************************   GLOBAL VARIABLES   *******************************
+ ******************************************************************************/
+
+// Scan trigger sources under test
+typedef enum {
+  triggerIadcTimer,       // IADC local timer, FSRCO
+  triggerLetimerPrs,      // LETIMER0 underflow through PRS, LFXO
+  triggerTimerPrs,        // TIMER1 overflow through PRS, HFXO
+  NUM_TRIGGERS
+} Trigger_t;
+
+// Measurements of one trigger source
+typedef struct {
+  const char *name;
+  uint32_t energyMode;      // Lowest energy mode the source runs in
+  double scanRate;          // Scans per second, against the HFXO
+  double intervalMin;       // Shortest scan to scan interval, ns
+  double intervalMax;       // Longest scan to scan interval, ns
+  double jitterPeakToPeak;  // intervalMax - intervalMin, ns
+  double jitterRms;         // Standard deviation of the interval, ns
+  uint32_t fifoOverflows;   // Phases that lost results, should stay 0
+  double current;           // Average uA over the energy phase, entered
+                            // from the Energy Profiler
+  double currentPerKsps;    // current per 1000 conversions per second
+} TriggerResult_t;
+
+static volatile TriggerResult_t results[NUM_TRIGGERS] = {
+  [triggerIadcTimer]  = { .name = "IADC timer",  .energyMode = 2 },
+  [triggerLetimerPrs] = { .name = "LETIMER/PRS", .energyMode = 2 },
+  [triggerTimerPrs]   = { .name = "TIMER/PRS",   .energyMode = 1 },
+};
+
+// Completed passes over all trigger sources
+static volatile uint32_t passes;
+
+// TIMER0 count at the end of each scan in the jitter phase
+static uint32_t timestamps[JITTER_SCANS];
+
+// Scan results, overwritten continuously; only the timing is of interest
+static uint32_t scanBuffer[SCAN_BLOCK * NUM_INPUTS];
+
+static LDMA_Descriptor_t scanDescriptor;
+static LDMA_Descriptor_t timeDescriptor;
+
+static volatile uint32_t blocksDone;
+static volatile bool timestampsDone;
+
+// TIMER0 count frequency
+static uint32_t timestampFreq;
+
+/**************************************************************************//**
+ * @brief  CMU initialization
+ *****************************************************************************/
+void initCMU(void)
+{
+  // Initialization structure for HFXO configuration
+  CMU_HFXOInit_TypeDef hfxoInit = CMU_HFXOINIT_DEFAULT;
+  CMU_LFXOInit_TypeDef lfxoInit = CMU_LFXOINIT_DEFAULT;
+
+  // Check if device has HFXO configuration information in DEVINFO page
+  if (DEVINFO->MODULEINFO & DEVINFO_MODULEINFO_HFXOCALVAL) {
+    // Use the DEVINFO page's CTUNE values
+    hfxoInit.ctuneXoAna = (DEVINFO->MODXOCAL & DEVINFO_MODXOCAL_HFXOCTUNEXOANA_DEFAULT)
+        >> _DEVINFO_MODXOCAL_HFXOCTUNEXOANA_SHIFT;
+    hfxoInit.ctuneXiAna = (DEVINFO->MODXOCAL & DEVINFO_MODXOCAL_HFXOCTUNEXIANA_DEFAULT)
+        >> _DEVINFO_MODXOCAL_HFXOCTUNEXIANA_SHIFT;
+  }
+
+  // Configure HFXO settings
+  CMU_HFXOInit(&hfxoInit);
+
+  // Set system HFXO frequency
+  SystemHFXOClockSet(HFXO_FREQ);
+
+  // Enable HFXO oscillator, and wait for it to be stable
+  CMU_OscillatorEnable(cmuOsc_HFXO, true, true);
+
+  // Select HFXO as the EM01GRPA clock, TIMER0 and TIMER1 count it
+  CMU_ClockSelectSet(cmuClock_EM01GRPACLK, cmuSelect_HFXO);
+
+  // Select LFXO for the LETIMER
+  CMU_LFXOInit(&lfxoInit);
+  CMU_ClockSelectSet(cmuClock_EM23GRPACLK, cmuSelect_LFXO);
+}
+
+/**************************************************************************//**
+ * @brief  GPIO initialization
+ *****************************************************************************/
+void initGPIO(void)
+{
+  /*
+   * On EFR32xG21 devices, CMU_ClockEnable() calls have no effect as
+   * clocks are enabled/disabled on-demand in response to peripheral
+   * requests.  Deleting such lines is safe on xG21 devices and will
+   * provide a small reduction in code size.
+   */
+  CMU_ClockEnable(cmuClock_GPIO, true);
+
+  // Output set during each energy phase, to find them in the Energy Profiler
+  GPIO_PinModeSet(GPIO_OUTPUT_0_PORT, GPIO_OUTPUT_0_PIN, gpioModePushPull, 0);
+}
+
+/**************************************************************************//**
+ * @brief  IADC initialization
+ *
+ * @param[in] trigger
+ *   Trigger source of the scans
+ *****************************************************************************/
+void initIADC(Trigger_t trigger)
+{
+  // Declare initialization structures
+  IADC_Init_t init = IADC_INIT_DEFAULT;
+  IADC_AllConfigs_t initAllConfigs = IADC_ALLCONFIGS_DEFAULT;
+  IADC_InitScan_t initScan = IADC_INITSCAN_DEFAULT;
+
+  // Scan table structure
+  IADC_ScanTable_t scanTable = IADC_SCANTABLE_DEFAULT;
+
+  CMU_ClockEnable(cmuClock_IADC0, true);
+
+  // Start from the reset configuration, the trigger changes between phases
+  IADC_reset(IADC0);
+
+  // Configure IADC clock source for use while in EM2
+  CMU_ClockSelectSet(cmuClock_IADCCLK, cmuSelect_FSRCO);  // FSRCO - 20MHz
+
+  // Shutdown between conversions to reduce current
+  init.warmup = iadcWarmupNormal;
+
+  // Set the HFSCLK prescale value here
+  init.srcClkPrescale = IADC_calcSrcClkPrescale(IADC0, CLK_SRC_ADC_FREQ, 0);
+
+  // The IADC local timer counts CLK_SRC_ADC cycles
+  init.timerCycles = CMU_ClockFreqGet(cmuClock_IADCCLK) / SCAN_RATE;
+
+  /*
+   * Configuration 0 is used by both scan and single conversions by
+   * default.  Use internal bandgap as the reference and specify the
+   * reference voltage in mV.
+   *
+   * Resolution is not configurable directly but is based on the
+   * selected oversampling ratio (osrHighSpeed), which defaults to
+   * 2x and generates 12-bit results.
+   */
+  initAllConfigs.configs[0].reference = iadcCfgReferenceInt1V2;
+  initAllConfigs.configs[0].vRef = 1210;
+  initAllConfigs.configs[0].osrHighSpeed = iadcCfgOsrHighSpeed2x;
+  initAllConfigs.configs[0].analogGain = iadcCfgAnalogGain0P5x;
+
+  // Divides CLK_SRC_ADC to set the CLK_ADC frequency
+  initAllConfigs.configs[0].adcClkPrescale = IADC_calcAdcClkPrescale(IADC0,
+                                                                     CLK_ADC_FREQ,
+                                                                     0,
+                                                                     iadcCfgModeNormal,
+                                                                     init.srcClkPrescale);
+
+  /*
+   * The local timer or a PRS pulse triggers each scan.  With a PRS
+   * trigger the scan is armed right away; the local timer is started
+   * together with the scan in startTrigger().
+   *
+   * The LDMA empties the FIFO, also in EM2.
+   */
+  if (trigger == triggerIadcTimer) {
+    initScan.triggerSelect = iadcTriggerSelTimer;
+  } else {
+    initScan.triggerSelect = iadcTriggerSelPrs0PosEdge;
+    initScan.start = true;
+  }
+  initScan.dataValidLevel = iadcFifoCfgDvl2;
+  initScan.fifoDmaWakeup = true;
+
+  /*
+   * Configure entries in the scan table.  CH0 is single-ended from
+   * input 0; CH1 is single-ended from input 1.
+   */
+  scanTable.entries[0].posInput = IADC_INPUT_0_PORT_PIN;
+  scanTable.entries[0].negInput = iadcNegInputGnd;
+  scanTable.entries[0].includeInScan = true;
+
+  scanTable.entries[1].posInput = IADC_INPUT_1_PORT_PIN;
+  scanTable.entries[1].negInput = iadcNegInputGnd;
+  scanTable.entries[1].includeInScan = true;
+
+  // Initialize IADC
+  IADC_init(IADC0, &init, &initAllConfigs);
+
+  // Initialize scan
+  IADC_initScan(IADC0, &initScan, &scanTable);
+
+  // Allocate the analog bus for ADC0 inputs
+  GPIO->IADC_INPUT_0_BUS |= IADC_INPUT_0_BUSALLOC;
+  GPIO->IADC_INPUT_1_BUS |= IADC_INPUT_1_BUSALLOC;
+}
+
+/**************************************************************************//**
+ * @brief  LETIMER and TIMER1 initialization, both left stopped
+ *****************************************************************************/
+void initTriggerTimers(void)
+{
+  LETIMER_Init_TypeDef letimerInit = LETIMER_INIT_DEFAULT;
+  TIMER_Init_TypeDef timerInit = TIMER_INIT_DEFAULT;
+
+  CMU_ClockEnable(cmuClock_LETIMER0, true);
+  CMU_ClockEnable(cmuClock_TIMER1, true);
+
+  // Pulse on each underflow; the counter runs from top to 0, top + 1 ticks
+  letimerInit.enable = false;
+  letimerInit.comp0Top = true;
+  letimerInit.topValue = CMU_ClockFreqGet(cmuClock_LETIMER0) / SCAN_RATE - 1;
+  letimerInit.ufoa0 = letimerUFOAPulse;
+  letimerInit.repMode = letimerRepeatFree;
+
+  LETIMER_Init(LETIMER0, &letimerInit);
+
+  // Overflow once per scan, the PRS carries the overflow pulse
+  timerInit.enable = false;
+
+  TIMER_Init(TIMER1, &timerInit);
+  TIMER_TopSet(TIMER1, CMU_ClockFreqGet(cmuClock_TIMER1) / SCAN_RATE - 1);
+}
+
+/**************************************************************************//**
+ * @brief  TIMER0 and PRS initialization for the scan timestamps
+ *****************************************************************************/
+void initTimestamps(void)
+{
+  TIMER_Init_TypeDef timerInit = TIMER_INIT_DEFAULT;
+  TIMER_InitCC_TypeDef timerCCInit = TIMER_INITCC_DEFAULT;
+
+  CMU_ClockEnable(cmuClock_PRS, true);
+  CMU_ClockEnable(cmuClock_TIMER0, true);
+
+  // Route the IADC scan table done pulse to TIMER0 CC0
+  PRS_SourceAsyncSignalSet(TIMESTAMP_PRS_CH, PRS_ASYNC_CH_CTRL_SOURCESEL_IADC0,
+                           PRS_ASYNC_CH_CTRL_SIGSEL_IADC0SCANTABLEDONE);
+  PRS_ConnectConsumer(TIMESTAMP_PRS_CH, prsTypeAsync, prsConsumerTIMER0_CC0);
+
+  // Free running 32-bit count of the HFXO, captured on the PRS pulse
+  timerInit.enable = false;
+  timerCCInit.prsSel = TIMESTAMP_PRS_CH;
+  timerCCInit.edge = timerEdgeRising;
+  timerCCInit.mode = timerCCModeCapture;
+  timerCCInit.prsInput = true;
+  timerCCInit.prsInputType = timerPrsInputAsyncPulse;
+
+  TIMER_Init(TIMER0, &timerInit);
+  TIMER_InitCC(TIMER0, 0, &timerCCInit);
+
+  timestampFreq = CMU_ClockFreqGet(cmuClock_TIMER0);
+}
+
+/**************************************************************************//**
+ * @brief  Start scans from a trigger source
+ *****************************************************************************/
+void startTrigger(Trigger_t trigger)
+{
+  switch (trigger) {
+    case triggerIadcTimer:
+      // Enable the IADC timer (must be after the IADC is initialized)
+      IADC_command(IADC0, iadcCmdEnableTimer);
+      IADC_command(IADC0, iadcCmdStartScan);
+      break;
+
+    case triggerLetimerPrs:
+      PRS_SourceAsyncSignalSet(TRIGGER_PRS_CH, PRS_ASYNC_CH_CTRL_SOURCESEL_LETIMER0,
+                               PRS_ASYNC_CH_CTRL_SIGSEL_LETIMER0CH0);
+      PRS_ConnectConsumer(TRIGGER_PRS_CH, prsTypeAsync, prsConsumerIADC0_SCANTRIGGER);
+      LETIMER_Enable(LETIMER0, true);
+      break;
+
+    case triggerTimerPrs:
+      PRS_SourceAsyncSignalSet(TRIGGER_PRS_CH, PRS_ASYNC_CH_CTRL_SOURCESEL_TIMER1,
+                               PRS_ASYNC_CH_CTRL_SIGSEL_TIMER1OF);
+      PRS_ConnectConsumer(TRIGGER_PRS_CH, prsTypeAsync, prsConsumerIADC0_SCANTRIGGER);
+      TIMER_Enable(TIMER1, true);
+      break;
+
+    default:
+      break;
+  }
+}
+
+/**************************************************************************//**
+ * @brief  Stop the trigger source and the scan LDMA channel
+ *****************************************************************************/
+void stopTrigger(Trigger_t trigger)
+{
+  switch (trigger) {
+    case triggerIadcTimer:
+      IADC_command(IADC0, iadcCmdDisableTimer);
+      break;
+
+    case triggerLetimerPrs:
+      LETIMER_Enable(LETIMER0, false);
+      break;
+
+    case triggerTimerPrs:
+      TIMER_Enable(TIMER1, false);
+      break;
+
+    default:
+      break;
+  }
+
+  IADC_command(IADC0, iadcCmdStopScan);
+  LDMA_StopTransfer(SCAN_LDMA_CH);
+
+  // A phase that lost results is not a fair comparison
+  if (IADC_getInt(IADC0) & IADC_IF_SCANFIFOOF) {
+    results[trigger].fifoOverflows++;
+  }
+}
+
+/**************************************************************************//**
+ * @brief  Start the looped LDMA transfer emptying the scan FIFO
+ *****************************************************************************/
+void startScanLdma(void)
+{
+  LDMA_TransferCfg_t transferCfg =
+    LDMA_TRANSFER_CFG_PERIPHERAL(ldmaPeripheralSignal_IADC0_IADC_SCAN);
+
+  // Link to itself, interrupt after each block of scans
+  scanDescriptor = (LDMA_Descriptor_t)
+    LDMA_DESCRIPTOR_LINKREL_P2M_WORD(&IADC0->SCANFIFODATA, scanBuffer,
+                                     SCAN_BLOCK * NUM_INPUTS, 0);
+  scanDescriptor.xfer.doneIfs = 1;
+  scanDescriptor.xfer.ignoreSrec = 0;
+
+  blocksDone = 0;
+  LDMA_StartTransfer(SCAN_LDMA_CH, &transferCfg, &scanDescriptor);
+}
+
+/**************************************************************************//**
+ * @brief  Start the LDMA transfer of JITTER_SCANS timestamps
+ *****************************************************************************/
+void startTimeLdma(void)
+{
+  LDMA_TransferCfg_t transferCfg =
+    LDMA_TRANSFER_CFG_PERIPHERAL(ldmaPeripheralSignal_TIMER0_CC0);
+
+  timeDescriptor = (LDMA_Descriptor_t)
+    LDMA_DESCRIPTOR_SINGLE_P2M_WORD(&(TIMER0->CC[0].ICF), timestamps,
+                                    JITTER_SCANS);
+  timeDescriptor.xfer.ignoreSrec = 0;
+
+  timestampsDone = false;
+  LDMA_StartTransfer(TIME_LDMA_CH, &transferCfg, &timeDescriptor);
+}
+
+/**************************************************************************//**
+ * @brief  LDMA Handler
+ *****************************************************************************/
+void LDMA_IRQHandler(void)
+{
+  uint32_t pending = LDMA_IntGetEnabled();
+
+  if (pending & LDMA_IF_ERROR) {
+    __BKPT(0);
+  }
+
+  if (pending & (1 << SCAN_LDMA_CH)) {
+    LDMA_IntClear(1 << SCAN_LDMA_CH);
+    blocksDone++;
+  }
+
+  if (pending & (1 << TIME_LDMA_CH)) {
+    LDMA_IntClear(1 << TIME_LDMA_CH);
+    timestampsDone = true;
+  }
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Timestamp JITTER_SCANS scans and work out the interval statistics
+ *
+ * @details
+ *   TIMER0 does not count in EM2, so this phase runs in EM1 for every
+ *   trigger source.  The timestamps are taken at the end of each scan,
+ *   the conversion time is the same for every scan and drops out of the
+ *   intervals.  The resolution is one HFXO period, about 26 ns.
+ *****************************************************************************/
+void measureJitter(Trigger_t trigger)
+{
+  uint32_t i, interval, min, max;
+  uint32_t count = JITTER_SCANS - JITTER_SKIP;
+  uint64_t sum = 0;
+  double mean, deviation, variance = 0;
+  double tickNs = 1e9 / timestampFreq;
+
+  initIADC(trigger);
+
+  TIMER_Enable(TIMER0, true);
+
+  // Throw away captures left over from the last phase
+  while (!(TIMER0->STATUS & TIMER_STATUS_ICFEMPTY0)) {
+    TIMER_CaptureGet(TIMER0, 0);
+  }
+
+  startScanLdma();
+  startTimeLdma();
+  startTrigger(trigger);
+
+  while (!timestampsDone) {
+    CORE_DECLARE_IRQ_STATE;
+
+    CORE_ENTER_CRITICAL();
+    if (!timestampsDone) {
+      EMU_EnterEM1();
+    }
+    CORE_EXIT_CRITICAL();
+  }
+
+  stopTrigger(trigger);
+  TIMER_Enable(TIMER0, false);
+
+  min = UINT32_MAX;
+  max = 0;
+  for (i = JITTER_SKIP; i < JITTER_SCANS; i++) {
+    // Unsigned difference, correct across the counter wrap
+    interval = timestamps[i] - timestamps[i - 1];
+    sum += interval;
+    if (interval < min) {
+      min = interval;
+    }
+    if (interval > max) {
+      max = interval;
+    }
+  }
+  mean = (double)sum / count;
+
+  for (i = JITTER_SKIP; i < JITTER_SCANS; i++) {
+    deviation = (double)(timestamps[i] - timestamps[i - 1]) - mean;
+    variance += deviation * deviation;
+  }
+  variance /= count;
+
+  results[trigger].scanRate = timestampFreq / mean;
+  results[trigger].intervalMin = min * tickNs;
+  results[trigger].intervalMax = max * tickNs;
+  results[trigger].jitterPeakToPeak = (max - min) * tickNs;
+  results[trigger].jitterRms = sqrt(variance) * tickNs;
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Scan for ENERGY_SECONDS in the lowest energy mode the trigger source
+ *   runs in, for the Energy Profiler to measure the average current
+ *****************************************************************************/
+void measureEnergy(Trigger_t trigger)
+{
+  const uint32_t blocks = ENERGY_SECONDS * SCAN_RATE / SCAN_BLOCK;
+
+  initIADC(trigger);
+  startScanLdma();
+
+  GPIO_PinOutSet(GPIO_OUTPUT_0_PORT, GPIO_OUTPUT_0_PIN);
+  startTrigger(trigger);
+
+  while (blocksDone < blocks) {
+    CORE_DECLARE_IRQ_STATE;
+
+    CORE_ENTER_CRITICAL();
+    if (blocksDone < blocks) {
+      if (results[trigger].energyMode == 2) {
+        EMU_EnterEM2(true);
+      } else {
+        EMU_EnterEM1();
+      }
+    }
+    CORE_EXIT_CRITICAL();
+  }
+
+  stopTrigger(trigger);
+  GPIO_PinOutClear(GPIO_OUTPUT_0_PORT, GPIO_OUTPUT_0_PIN);
+}
+
+/**************************************************************************//**
+ * @brief  Main function
+ *****************************************************************************/
+int main(void)
+{
+  LDMA_Init_t ldmaInit = LDMA_INIT_DEFAULT;
+  Trigger_t trigger;
+
+  CHIP_Init();
+
+  initCMU();
+
+  initGPIO();
+
+  initTriggerTimers();
+
+  initTimestamps();
+
+  LDMA_Init(&ldmaInit);
+
+#ifdef EM2DEBUG
+#if (EM2DEBUG == 1)
+  // Enable debug connectivity in EM2
+  EMU->CTRL_SET = EMU_CTRL_EM2DBGEN;
+#endif
+#endif
+
+  // Infinite loop
+  while (1)
+  {
+    for (trigger = triggerIadcTimer; trigger < NUM_TRIGGERS; trigger++) {
+      measureJitter(trigger);
+      measureEnergy(trigger);
+
+      // Current per 1000 conversions per second, NUM_INPUTS per scan
+      if (results[trigger].current > 0) {
+        results[trigger].currentPerKsps = results[trigger].current
+          / (results[trigger].scanRate * NUM_INPUTS / 1000);
+      }
+    }
+
+    passes++;
+  }
+}
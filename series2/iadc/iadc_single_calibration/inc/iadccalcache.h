@@ -0,0 +1,71 @@
+/***************************************************************************//**
+ * @file iadccalcache.h
+ *
+ * @brief IADC gain and offset calibration results kept in USERDATA.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2020 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ******************************************************************************/
+
+#ifndef IADCCALCACHE_H
+#define IADCCALCACHE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Width of a temperature band in degrees C, bands start at -40 C
+#ifndef IADCCAL_BAND_WIDTH
+#define IADCCAL_BAND_WIDTH      20
+#endif
+
+// Most different keys kept when the USERDATA page is full and compacted
+#define IADCCAL_MAX_KEYS        16
+
+/*
+ * Cache key for one IADC configuration: the reference (IADC_CfgReference_t),
+ * the high speed oversampling ratio (IADC_CfgOsrHighSpeed_t), the analog
+ * gain (IADC_CfgAnalogGain_t) and the temperature band the calibration was
+ * done in.  The SCALE register value only holds for this combination.
+ */
+#define IADCCAL_KEY(reference, osr, gain, band) \
+  ((((uint32_t)(reference) & 0xFF) << 24)       \
+   | (((uint32_t)(osr) & 0xFF) << 16)           \
+   | (((uint32_t)(gain) & 0xFF) << 8)           \
+   | ((uint32_t)(band) & 0xFF))
+
+uint32_t IADCCAL_TemperatureBand(void);
+bool IADCCAL_Load(uint32_t key, uint32_t *scale);
+void IADCCAL_Store(uint32_t key, uint32_t scale);
+void IADCCAL_Clear(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // IADCCALCACHE_H
@@ -0,0 +1,214 @@
+/***************************************************************************//**
+ * @file iadccalcache.c
+ *
+ * @brief IADC gain and offset calibration results kept in USERDATA.
+ *
+ * The USERDATA page is used as a log of three word entries: the key, the
+ * IADC SCALE register value and a check word. New results are appended,
+ * so the last valid entry for a key is the current one, and the page is
+ * only erased when it is full. The latest entry of each key is then
+ * written back to the erased page.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2021 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ *******************************************************************************
+ * # Evaluation Quality
+ * This code has been minimally tested to ensure that it builds and is suitable 
+ * as a demonstration for evaluation purposes only. This code will be maintained
+ * at the sole discretion of Silicon Labs.
+ ******************************************************************************/
+
+#include "em_device.h"
+#include "em_emu.h"
+#include "em_msc.h"
+
+#include "iadccalcache.h"
+
+#if !defined(USERDATA_BASE) || !defined(USERDATA_SIZE)
+#error "This device has no USERDATA page"
+#endif
+
+// Check word, distinguishes an entry from a partly written one
+#define CAL_MAGIC       0x1ADCCA1BUL
+
+// Lowest temperature of the first band, bands are numbered from 0
+#define BAND_MIN_TEMP   (-40)
+
+typedef struct {
+  uint32_t key;
+  uint32_t scale;
+  uint32_t check;
+} CalEntry_t;
+
+#define LOG             ((volatile CalEntry_t *)USERDATA_BASE)
+#define LOG_ENTRIES     (USERDATA_SIZE / sizeof(CalEntry_t))
+
+/**************************************************************************//**
+ * @brief
+ *   Check a log entry
+ *****************************************************************************/
+static bool isValid(volatile const CalEntry_t *entry)
+{
+  return (entry->key != 0xFFFFFFFFUL)
+         && (entry->check == (entry->key ^ entry->scale ^ CAL_MAGIC));
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Find the first erased log entry, LOG_ENTRIES if the log is full
+ *****************************************************************************/
+static uint32_t logEnd(void)
+{
+  uint32_t i;
+
+  for (i = 0; i < LOG_ENTRIES; i++) {
+    if ((LOG[i].key == 0xFFFFFFFFUL)
+        && (LOG[i].scale == 0xFFFFFFFFUL)
+        && (LOG[i].check == 0xFFFFFFFFUL)) {
+      break;
+    }
+  }
+  return i;
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Temperature band of the die temperature measured by the EMU
+ *
+ * @details
+ *   Band 0 is everything below -40 C + IADCCAL_BAND_WIDTH, the bands above
+ *   are IADCCAL_BAND_WIDTH degrees wide each.
+ *****************************************************************************/
+uint32_t IADCCAL_TemperatureBand(void)
+{
+  float temp = EMU_TemperatureGet();
+
+  if (temp < BAND_MIN_TEMP) {
+    return 0;
+  }
+  return (uint32_t)((temp - BAND_MIN_TEMP) / IADCCAL_BAND_WIDTH);
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Look up the calibration result for a configuration
+ *
+ * @param[in] key
+ *   Configuration and temperature band, see IADCCAL_KEY().
+ *
+ * @param[out] scale
+ *   IADC SCALE register value found.
+ *
+ * @return
+ *   false if there is no valid result for this key.
+ *****************************************************************************/
+bool IADCCAL_Load(uint32_t key, uint32_t *scale)
+{
+  uint32_t i = logEnd();
+
+  // The newest entry for the key wins
+  while (i-- > 0) {
+    if ((LOG[i].key == key) && isValid(&LOG[i])) {
+      *scale = LOG[i].scale;
+      return true;
+    }
+  }
+  return false;
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Store the calibration result for a configuration
+ *
+ * @details
+ *   Nothing is written if the newest entry for the key already holds this
+ *   value. When the page is full, it is erased and the newest entry of up to
+ *   IADCCAL_MAX_KEYS other keys is written back, so a full page costs one
+ *   erase every LOG_ENTRIES stores at most.
+ *
+ * @param[in] key
+ *   Configuration and temperature band, see IADCCAL_KEY().
+ *
+ * @param[in] scale
+ *   IADC SCALE register value.
+ *****************************************************************************/
+void IADCCAL_Store(uint32_t key, uint32_t scale)
+{
+  CalEntry_t keep[IADCCAL_MAX_KEYS];
+  CalEntry_t entry;
+  uint32_t kept = 0;
+  uint32_t current;
+  uint32_t end, i, k;
+
+  if (IADCCAL_Load(key, &current) && (current == scale)) {
+    return;
+  }
+
+  entry.key = key;
+  entry.scale = scale;
+  entry.check = key ^ scale ^ CAL_MAGIC;
+
+  end = logEnd();
+
+  MSC_Init();
+
+  if (end == LOG_ENTRIES) {
+    // Newest entry of every other key, walking back from the end
+    for (i = LOG_ENTRIES; (i-- > 0) && (kept < IADCCAL_MAX_KEYS); ) {
+      if ((LOG[i].key == key) || !isValid(&LOG[i])) {
+        continue;
+      }
+      for (k = 0; (k < kept) && (keep[k].key != LOG[i].key); k++) {
+      }
+      if (k == kept) {
+        keep[kept].key = LOG[i].key;
+        keep[kept].scale = LOG[i].scale;
+        keep[kept].check = LOG[i].check;
+        kept++;
+      }
+    }
+
+    MSC_ErasePage((uint32_t *)USERDATA_BASE);
+    if (kept > 0) {
+      MSC_WriteWord((uint32_t *)USERDATA_BASE, keep, kept * sizeof(CalEntry_t));
+    }
+    end = kept;
+  }
+
+  MSC_WriteWord((uint32_t *)&LOG[end], &entry, sizeof(entry));
+
+  MSC_Deinit();
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Forget all stored calibration results
+ *****************************************************************************/
+void IADCCAL_Clear(void)
+{
+  MSC_Init();
+  MSC_ErasePage((uint32_t *)USERDATA_BASE);
+  MSC_Deinit();
+}
@@ -41,8 +41,10 @@
 #include "em_cmu.h"
 #include "em_iadc.h"
 #include "em_gpio.h"
+#include "em_emu.h"
 #include "em_ldma.h"
 #include "bsp.h"
+#include "iadccalcache.h"
 
 /*******************************************************************************
  *******************************   DEFINES   ***********************************
@@ -83,6 +85,11 @@
 // Push-buttons are active-low
 #define PB_PRESSED (0)
 
+// Configuration the calibration result belongs to, see initIADC()
+#define CAL_REFERENCE             iadcCfgReferenceVddx
+#define CAL_OSR                   iadcCfgOsrHighSpeed2x
+#define CAL_GAIN                  iadcCfgAnalogGain1x
+
 /*******************************************************************************
  ***************************   GLOBAL VARIABLES   *******************************
  ******************************************************************************/
@@ -90,6 +97,15 @@
 static volatile IADC_Result_t sample;
 static volatile double singleResult; // Volts
 
+// Where the scale in use came from, for inspection in the debugger
+typedef enum {
+  calFromCache,           // Stored result for this configuration and band
+  calMeasured,            // Measured now and stored
+} CalSource_t;
+
+static volatile CalSource_t calibrationSource;
+static volatile uint32_t calibrationKey;
+
 /**************************************************************************//**
  * @brief  GPIO Initializer
  *****************************************************************************/
@@ -135,7 +151,7 @@ void initIADC (void)
 
   // Configuration 0 is used by both scan and single conversions by default
   // Use unbuffered AVDD as reference
-  initAllConfigs.configs[0].reference = iadcCfgReferenceVddx;
+  initAllConfigs.configs[0].reference = CAL_REFERENCE;
   initAllConfigs.configs[0].vRef = 3300;
 
   // Divides CLK_SRC_ADC to set the CLK_ADC frequency
@@ -145,6 +161,9 @@ void initIADC (void)
                                              iadcCfgModeNormal,
                                              init.srcClkPrescale);
 
+  initAllConfigs.configs[0].osrHighSpeed = CAL_OSR;
+  initAllConfigs.configs[0].analogGain = CAL_GAIN;
+
   initAllConfigs.configs[0].twosComplement = iadcCfgTwosCompBipolar; // Force IADC to use bipolar inputs for conversion
 
   // Assign pins to positive and negative inputs in differential mode
@@ -213,9 +232,10 @@ void IADCRescale(uint32_t newScale)
 }
 
 /**************************************************************************//**
- * @brief  Main function
+ * @brief  Measure a full scale and a zero input, return the SCALE
+ *         register value correcting the gain and offset
  *****************************************************************************/
-int main(void)
+uint32_t calibrate(void)
 {
   uint32_t scale;
   double calibration_gain13lsb;
@@ -225,12 +245,6 @@ int main(void)
   uint32_t IADC_CALIBRATED_GAIN13LSB;
   int32_t IADC_CALIBRATED_OFFSET;
 
-  CHIP_Init();
-
-  initGPIO();
-
-  initIADC();
-
   // Set initial offset to maximum negative and initial gain to 1.0
   scale = IADC_SCALE_GAIN3MSB_GAIN100 | IADC_SCALE_GAIN13LSB_DEFAULT | IADC_SCALE_OFFSET_MAX_NEG;
 
@@ -297,6 +311,41 @@ int main(void)
               | (IADC_CALIBRATED_OFFSET & _IADC_SCALE_OFFSET_MASK);
   }
 
+  return scale;
+}
+
+/**************************************************************************//**
+ * @brief  Main function
+ *****************************************************************************/
+int main(void)
+{
+  uint32_t scale;
+
+  CHIP_Init();
+
+  initGPIO();
+
+  initIADC();
+
+  // Holding PB0 through reset throws away all stored results
+  if (GPIO_PinInGet(BSP_GPIO_PB0_PORT, BSP_GPIO_PB0_PIN) == PB_PRESSED) {
+    IADCCAL_Clear();
+    while(GPIO_PinInGet(BSP_GPIO_PB0_PORT, BSP_GPIO_PB0_PIN) == PB_PRESSED);
+  }
+
+  // Reuse the result for this configuration and temperature band if there
+  // is one, else run the calibration once and keep it
+  calibrationKey = IADCCAL_KEY(CAL_REFERENCE, CAL_OSR, CAL_GAIN,
+                               IADCCAL_TemperatureBand());
+
+  if (IADCCAL_Load(calibrationKey, &scale)) {
+    calibrationSource = calFromCache;
+  } else {
+    scale = calibrate();
+    IADCCAL_Store(calibrationKey, scale);
+    calibrationSource = calMeasured;
+  }
+
   IADCRescale(scale);
 
   // Infinite loop
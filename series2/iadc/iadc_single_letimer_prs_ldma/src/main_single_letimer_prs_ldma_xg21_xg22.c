@@ -78,7 +78,7 @@
 #define IADC_INPUT_0_BUSALLOC     GPIO_ABUSALLOC_AODD0_ADC0
 
 // Desired LETIMER frequency in Hz
-#define LETIMER_FREQ              1
+#define LETIMER_FREQ              32
 
 // LETIMER GPIO toggle port/pin (toggled in EM2; requires port A/B GPIO)
 #define LETIMER_OUTPUT_0_PORT     gpioPortB
@@ -88,8 +88,24 @@
 #define IADC_LDMA_CH              0
 #define PRS_CHANNEL               0
 
-// How many samples to capture
-#define NUM_SAMPLES               10
+/*
+ * The LDMA fills a ring of NUM_BATCHES blocks of BATCH_SAMPLES each and
+ * wakes the CPU when a block is full, the wake watermark.  At 32 Hz a
+ * batch of 512 samples is a wake every 16 seconds.  The other blocks
+ * keep filling while a full one is processed.
+ */
+#define BATCH_SAMPLES             512
+#define NUM_BATCHES               4
+#define NUM_SAMPLES               (BATCH_SAMPLES * NUM_BATCHES)
+
+// Low pass filter weight of a new sample, 1 / 2^FILTER_SHIFT
+#define FILTER_SHIFT              2
+
+// Bytes of compressed samples kept, the oldest are overwritten
+#define ARCHIVE_SIZE              4096
+
+// Delta byte that escapes a full 16-bit sample
+#define DELTA_ESCAPE              0x80
 
 /*
  * This example enters EM2 in the main while() loop; Setting this #define
@@ -102,12 +118,32 @@
  ***************************   GLOBAL VARIABLES   *******************************
  ******************************************************************************/
 
-// Globally declared LDMA link descriptor
-LDMA_Descriptor_t descriptor;
+// Globally declared LDMA link descriptors, one per batch
+LDMA_Descriptor_t descriptors[NUM_BATCHES];
 
-// Buffer for IADC samples
+// Buffer for IADC samples, all RAM is retained in EM2
 uint32_t singleBuffer[NUM_SAMPLES];
 
+// Batches filled by the LDMA and batches processed
+volatile uint32_t batchesFilled;
+uint32_t batchesProcessed;
+
+// Batches overwritten by the LDMA before they were processed
+uint32_t batchesLost;
+
+// Filter state, the filtered sample times 2^FILTER_SHIFT
+uint32_t filterState;
+
+// Last filtered sample, the base of the next delta
+int32_t lastFiltered;
+
+// Filtered samples, delta coded, and the total bytes written to it
+uint8_t archive[ARCHIVE_SIZE];
+uint32_t archiveBytes;
+
+// Samples that did not fit a delta byte
+uint32_t escapes;
+
 /**************************************************************************//**
  * @brief  GPIO initialization
  *****************************************************************************/
@@ -206,9 +242,11 @@ void initIADC(void)
   /*
    * Trigger conversions on the PRS rising edge input.
    *
-   * Set the SINGLEFIFODVL flag when there are 2 entries in the scan
-   * FIFO.  Note that in this example, the interrupt associated with
-   * the SINGLEFIFODVL flag in the IADC_IF register is not used.
+   * Set the SINGLEFIFODVL flag when there is 1 entry in the single
+   * FIFO, so that the last sample of a batch is not held back until
+   * the next conversion.  Note that in this example, the interrupt
+   * associated with the SINGLEFIFODVL flag in the IADC_IF register is
+   * not used.
    *
    * Enable DMA wake-up to save the results when the specified FIFO
    * level is hit.
@@ -216,7 +254,7 @@ void initIADC(void)
    * Allow a single conversion to start as soon as there is a trigger.
    */
   initSingle.triggerSelect = iadcTriggerSelPrs0PosEdge;
-  initSingle.dataValidLevel = iadcFifoCfgDvl2;
+  initSingle.dataValidLevel = iadcFifoCfgDvl1;
   initSingle.fifoDmaWakeup = true;
   initSingle.start = true;
 
@@ -276,25 +314,34 @@ void initLETIMER(void)
  * @param[in] buffer
  *   pointer to the array where ADC results will be stored.
  * @param[in] size
- *   size of the array
+ *   size of the array, a multiple of BATCH_SAMPLES
  *****************************************************************************/
 void initLDMA(uint32_t *buffer, uint32_t size)
 {
   LDMA_Init_t init = LDMA_INIT_DEFAULT;
+  uint32_t i, batches = size / BATCH_SAMPLES;
 
   // Trigger LDMA transfer on IADC single completion
   LDMA_TransferCfg_t transferCfg =
     LDMA_TRANSFER_CFG_PERIPHERAL(ldmaPeripheralSignal_IADC0_IADC_SINGLE);
 
   /*
-   * Set up a linked descriptor to save scan results to the
-   * user-specified buffer.  By linking the descriptor to itself
-   * (the last argument is the relative jump in terms of the number of
-   * descriptors), transfers will run continuously until firmware
-   * otherwise stops them.
+   * Set up one linked descriptor per batch to save the results to
+   * consecutive blocks of the user-specified buffer.  Each descriptor
+   * links to the next one (the last argument is the relative jump in
+   * terms of the number of descriptors) and the last one back to the
+   * first, so transfers run continuously around the buffer until
+   * firmware otherwise stops them.  Each descriptor requests an
+   * interrupt when its block is full.
    */
-  descriptor =
-    (LDMA_Descriptor_t)LDMA_DESCRIPTOR_LINKREL_P2M_WORD(&IADC0->SINGLEFIFODATA, buffer, size, 0);
+  for (i = 0; i < batches; i++) {
+    descriptors[i] =
+      (LDMA_Descriptor_t)LDMA_DESCRIPTOR_LINKREL_P2M_WORD(&IADC0->SINGLEFIFODATA,
+                                                          &buffer[i * BATCH_SAMPLES],
+                                                          BATCH_SAMPLES,
+                                                          1);
+  }
+  descriptors[batches - 1].xfer.linkAddr = -(int32_t)(batches - 1) * 4;
 
   // Initialize LDMA with default configuration
   LDMA_Init(&init);
@@ -304,7 +351,7 @@ void initLDMA(uint32_t *buffer, uint32_t size)
    * the LETIMER counts down to 0 and generates a pulse that is
    * routed to the IADC scan trigger input via the PRS.
    */
-  LDMA_StartTransfer(IADC_LDMA_CH, &transferCfg, &descriptor);
+  LDMA_StartTransfer(IADC_LDMA_CH, &transferCfg, &descriptors[0]);
 }
 
 /**************************************************************************//**
@@ -315,10 +362,52 @@ void LDMA_IRQHandler(void)
   // Clear interrupt flags
   LDMA_IntClear(1 << IADC_LDMA_CH);
 
+  // A batch is full, leave it to the main loop
+  batchesFilled++;
+
   // Toggle LED0 to notify that transfers are complete
   GPIO_PinOutToggle(BSP_GPIO_LED0_PORT, BSP_GPIO_LED0_PIN);
 }
 
+/**************************************************************************//**
+ * @brief
+ *   Filter a batch and append it to the archive
+ *
+ * @details
+ *   Each sample goes through a first order low pass filter and the
+ *   filtered sample is stored as the signed byte difference from the
+ *   one before, or as DELTA_ESCAPE and the full sample when the
+ *   difference does not fit.  A slowly changing input takes one byte
+ *   per sample instead of the four of the LDMA buffer.
+ *
+ * @param[in] batch
+ *   pointer to the BATCH_SAMPLES results of the batch
+ *****************************************************************************/
+void processBatch(const uint32_t *batch)
+{
+  uint32_t i, sample;
+  int32_t filtered, delta;
+
+  for (i = 0; i < BATCH_SAMPLES; i++) {
+    sample = batch[i] & _IADC_SINGLEFIFODATA_DATA_MASK;
+
+    filterState += sample - (filterState >> FILTER_SHIFT);
+    filtered = (int32_t)(filterState >> FILTER_SHIFT);
+
+    delta = filtered - lastFiltered;
+    lastFiltered = filtered;
+
+    if ((delta > -DELTA_ESCAPE) && (delta < DELTA_ESCAPE)) {
+      archive[archiveBytes++ % ARCHIVE_SIZE] = (uint8_t)delta;
+    } else {
+      archive[archiveBytes++ % ARCHIVE_SIZE] = DELTA_ESCAPE;
+      archive[archiveBytes++ % ARCHIVE_SIZE] = (uint8_t)(filtered >> 8);
+      archive[archiveBytes++ % ARCHIVE_SIZE] = (uint8_t)filtered;
+      escapes++;
+    }
+  }
+}
+
 /**************************************************************************//**
  * @brief  Main function
  *****************************************************************************/
@@ -346,6 +435,18 @@ int main(void)
 
   while (1)
   {
+    // Process the batches filled since the last wake
+    while (batchesProcessed != batchesFilled) {
+      // Skip the batches the LDMA has already started to overwrite
+      if ((batchesFilled - batchesProcessed) >= NUM_BATCHES) {
+        batchesLost += batchesFilled - batchesProcessed - (NUM_BATCHES - 1);
+        batchesProcessed = batchesFilled - (NUM_BATCHES - 1);
+      }
+
+      processBatch(&singleBuffer[(batchesProcessed % NUM_BATCHES) * BATCH_SAMPLES]);
+      batchesProcessed++;
+    }
+
     // Enter EM2 sleep
     EMU_EnterEM2(true);
   }
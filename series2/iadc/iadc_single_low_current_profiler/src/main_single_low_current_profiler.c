@@ -0,0 +1,525 @@
+/***************************************************************************//**
+ * @file main_single_low_current_profiler.c
+ * @brief Sweeps the IADC clocks, warmup mode, oversampling and trigger
+ * source, measures the effective resolution of each configuration on a
+ * stable input and marks each one for the Energy Profiler, then prints the
+ * configurations that no other one beats on both resolution and current.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2022 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ *******************************************************************************
+ * # Evaluation Quality
+ * This code has been minimally tested to ensure that it builds and is suitable 
+ * as a demonstration for evaluation purposes only. This code will be maintained
+ * at the sole discretion of Silicon Labs.
+ ******************************************************************************/
+
+#include <stdio.h>
+#include <math.h>
+#include "em_device.h"
+#include "em_chip.h"
+#include "em_core.h"
+#include "em_cmu.h"
+#include "em_emu.h"
+#include "em_gpio.h"
+#include "em_iadc.h"
+#include "em_ldma.h"
+#include "em_letimer.h"
+#include "em_prs.h"
+#include "bsp.h"
+#include "retargetserial.h"
+#include "energymark.h"
+
+/*******************************************************************************
+ *******************************   DEFINES   ***********************************
+ ******************************************************************************/
+
+/*
+ * Specify the IADC input using the IADC_PosInput_t typedef.  The input
+ * must hold still for the noise to be the IADC's own: AVDD / 4, from the
+ * kit supply, needs no wiring.  For an external reference on a pin, for
+ * example port A pin 5, set the port/pin and define the analog bus
+ * allocation to go with it...
+ *
+ * #define IADC_INPUT_0_PORT_PIN     iadcPosInputPortAPin5
+ * #define IADC_INPUT_0_BUS          ABUSALLOC
+ * #define IADC_INPUT_0_BUSALLOC     GPIO_ABUSALLOC_AODD0_ADC0
+ */
+#define IADC_INPUT_0_PORT_PIN     iadcPosInputAvdd
+
+// Rate of every configuration, FSRCO / timer cycles or LFXO / 32
+#define SAMPLE_RATE               1024
+
+// Conversions per configuration, one second, the dwell for the current
+#define NUM_SAMPLES               SAMPLE_RATE
+
+// Conversions left out of the statistics, the first after the start
+#define SKIP_SAMPLES              8
+
+// Results are 16 bits whatever the oversampling
+#define RESULT_BITS               16
+
+// Use specified LDMA/PRS channel
+#define IADC_LDMA_CH              0
+#define PRS_CHANNEL               0
+
+/*
+ * This example enters EM2 for each configuration; Setting this #define
+ * to 1 enables debug connectivity in EM2, which the energy markers need
+ * to reach the debugger and which increases current consumption by about
+ * 0.5 uA in every configuration.
+ */
+#define EM2DEBUG                  1
+
+#define COUNT_OF(a)               (sizeof(a) / sizeof((a)[0]))
+
+/*******************************************************************************
+ ***************************   GLOBAL VARIABLES   *******************************
+ ******************************************************************************/
+
+// CLK_SRC_ADC and CLK_ADC pairs, both from the 20 MHz FSRCO
+static const struct {
+  uint32_t srcFreq;
+  uint32_t adcFreq;
+} clocks[] = {
+  { 20000000, 10000000 },
+  { 10000000,  5000000 },
+  {  5000000,  1000000 },
+};
+
+static const IADC_Warmup_t warmups[] = {
+  iadcWarmupNormal,         // Shut down between conversions
+  iadcWarmupKeepInStandby,  // Standby between conversions
+  iadcWarmupKeepWarm,       // Kept on
+};
+
+static const struct {
+  IADC_CfgOsrHighSpeed_t osr;
+  uint32_t ratio;
+} osrs[] = {
+  { iadcCfgOsrHighSpeed2x,  2 },  // 12 bits
+  { iadcCfgOsrHighSpeed8x,  8 },  // 14 bits
+  { iadcCfgOsrHighSpeed32x, 32 }, // 16 bits
+};
+
+// Trigger sources
+typedef enum {
+  triggerIadcTimer,         // IADC local timer, counts CLK_SRC_ADC
+  triggerLetimerPrs,        // LETIMER0 underflow through PRS, LFXO
+  NUM_TRIGGERS
+} Trigger_t;
+
+#define NUM_CONFIGS (COUNT_OF(clocks) * COUNT_OF(warmups) * COUNT_OF(osrs) * NUM_TRIGGERS)
+
+// Measurements of one configuration
+typedef struct {
+  uint32_t srcFreq;         // CLK_SRC_ADC, Hz
+  uint32_t adcFreq;         // CLK_ADC, Hz
+  IADC_Warmup_t warmup;
+  uint32_t osr;             // Oversampling ratio
+  Trigger_t trigger;
+  uint32_t conversionNs;    // ((4 * OSR) + 2) / CLK_ADC, without warmup
+  double mean;              // Mean result
+  double noiseRms;          // Standard deviation of the results, LSB
+  double enob;              // Effective bits from the noise
+  uint8_t marker;           // ENERGYMARK ID of the dwell
+  double current;           // Average uA over the marker, entered from
+                            // the Energy Profiler
+  bool pareto;              // No other configuration has more bits for
+                            // less current
+} Result_t;
+
+volatile Result_t results[NUM_CONFIGS];
+
+// Completed sweeps over all configurations
+volatile uint32_t sweeps;
+
+static const char *warmupNames[] = {
+  [iadcWarmupNormal]        = "normal",
+  [iadcWarmupKeepInStandby] = "standby",
+  [iadcWarmupKeepWarm]      = "warm",
+};
+
+static const char *triggerNames[NUM_TRIGGERS] = {
+  [triggerIadcTimer]  = "timer",
+  [triggerLetimerPrs] = "LETIMER",
+};
+
+// Globally declared LDMA descriptor
+static LDMA_Descriptor_t descriptor;
+
+// Buffer for IADC samples
+static uint32_t singleBuffer[NUM_SAMPLES];
+
+static volatile bool samplesDone;
+
+/**************************************************************************//**
+ * @brief  CMU initialization, the LFXO for the LETIMER
+ *****************************************************************************/
+void initCMU(void)
+{
+  CMU_LFXOInit_TypeDef lfxoInit = CMU_LFXOINIT_DEFAULT;
+
+  CMU_LFXOInit(&lfxoInit);
+  CMU_ClockSelectSet(cmuClock_EM23GRPACLK, cmuSelect_LFXO);
+}
+
+/**************************************************************************//**
+ * @brief  LETIMER and PRS initialization, the LETIMER left stopped
+ *****************************************************************************/
+void initLETIMER(void)
+{
+  LETIMER_Init_TypeDef letimerInit = LETIMER_INIT_DEFAULT;
+
+  CMU_ClockEnable(cmuClock_LETIMER0, true);
+  CMU_ClockEnable(cmuClock_PRS, true);
+
+  // Pulse on each underflow; the counter runs from top to 0, top + 1 ticks
+  letimerInit.enable = false;
+  letimerInit.comp0Top = true;
+  letimerInit.topValue = CMU_ClockFreqGet(cmuClock_LETIMER0) / SAMPLE_RATE - 1;
+  letimerInit.ufoa0 = letimerUFOAPulse;
+  letimerInit.repMode = letimerRepeatFree;
+
+  LETIMER_Init(LETIMER0, &letimerInit);
+
+  // Connect the LETIMER to the IADC single trigger
+  PRS_SourceAsyncSignalSet(PRS_CHANNEL,
+                           PRS_ASYNC_CH_CTRL_SOURCESEL_LETIMER0,
+                           PRS_ASYNC_CH_CTRL_SIGSEL_LETIMER0CH0);
+  PRS_ConnectConsumer(PRS_CHANNEL,
+                      prsTypeAsync,
+                      prsConsumerIADC0_SINGLETRIGGER);
+}
+
+/**************************************************************************//**
+ * @brief  IADC initialization for one configuration
+ *****************************************************************************/
+void initIADC(volatile const Result_t *config)
+{
+  // Declare initialization structures
+  IADC_Init_t init = IADC_INIT_DEFAULT;
+  IADC_AllConfigs_t initAllConfigs = IADC_ALLCONFIGS_DEFAULT;
+  IADC_InitSingle_t initSingle = IADC_INITSINGLE_DEFAULT;
+  IADC_SingleInput_t singleInput = IADC_SINGLEINPUT_DEFAULT;
+
+  CMU_ClockEnable(cmuClock_IADC0, true);
+
+  // Start from the reset configuration, every setting changes
+  IADC_reset(IADC0);
+
+  // Use the FSRC0 as the IADC clock so it can run in EM2
+  CMU_ClockSelectSet(cmuClock_IADCCLK, cmuSelect_FSRCO);
+
+  init.warmup = config->warmup;
+  init.srcClkPrescale = IADC_calcSrcClkPrescale(IADC0, config->srcFreq, 0);
+
+  // The IADC local timer counts CLK_SRC_ADC cycles
+  init.timerCycles = config->srcFreq / SAMPLE_RATE;
+
+  // Internal bandgap reference with 0.5x gain, a 2.42 V full scale
+  initAllConfigs.configs[0].reference = iadcCfgReferenceInt1V2;
+  initAllConfigs.configs[0].vRef = 1210;
+  initAllConfigs.configs[0].analogGain = iadcCfgAnalogGain0P5x;
+  initAllConfigs.configs[0].osrHighSpeed = osrs[0].osr;
+  for (uint32_t i = 0; i < COUNT_OF(osrs); i++) {
+    if (osrs[i].ratio == config->osr) {
+      initAllConfigs.configs[0].osrHighSpeed = osrs[i].osr;
+    }
+  }
+  initAllConfigs.configs[0].adcClkPrescale = IADC_calcAdcClkPrescale(IADC0,
+                                                                     config->adcFreq,
+                                                                     0,
+                                                                     iadcCfgModeNormal,
+                                                                     init.srcClkPrescale);
+
+  /*
+   * The local timer or a PRS pulse triggers each conversion.  With a
+   * PRS trigger the conversion is armed right away; the local timer is
+   * started in startTrigger().  The LDMA empties the FIFO after each
+   * conversion, also in EM2.
+   */
+  if (config->trigger == triggerIadcTimer) {
+    initSingle.triggerSelect = iadcTriggerSelTimer;
+  } else {
+    initSingle.triggerSelect = iadcTriggerSelPrs0PosEdge;
+  }
+  initSingle.start = true;
+  initSingle.alignment = iadcAlignRight16;
+  initSingle.dataValidLevel = iadcFifoCfgDvl1;
+  initSingle.fifoDmaWakeup = true;
+
+  singleInput.posInput = IADC_INPUT_0_PORT_PIN;
+  singleInput.negInput = iadcNegInputGnd;
+
+  IADC_init(IADC0, &init, &initAllConfigs);
+  IADC_initSingle(IADC0, &initSingle, &singleInput);
+
+#if defined(IADC_INPUT_0_BUS)
+  // Allocate the analog bus for IADC0 inputs
+  GPIO->IADC_INPUT_0_BUS |= IADC_INPUT_0_BUSALLOC;
+#endif
+}
+
+/**************************************************************************//**
+ * @brief  Start conversions from a trigger source
+ *****************************************************************************/
+void startTrigger(Trigger_t trigger)
+{
+  if (trigger == triggerIadcTimer) {
+    // Enable the IADC timer (must be after the IADC is initialized)
+    IADC_command(IADC0, iadcCmdEnableTimer);
+  } else {
+    LETIMER_Enable(LETIMER0, true);
+  }
+}
+
+/**************************************************************************//**
+ * @brief  Stop the trigger source and the IADC
+ *****************************************************************************/
+void stopTrigger(Trigger_t trigger)
+{
+  if (trigger == triggerIadcTimer) {
+    IADC_command(IADC0, iadcCmdDisableTimer);
+  } else {
+    LETIMER_Enable(LETIMER0, false);
+  }
+
+  IADC_command(IADC0, iadcCmdStopSingle);
+  LDMA_StopTransfer(IADC_LDMA_CH);
+}
+
+/**************************************************************************//**
+ * @brief  Start the LDMA transfer of NUM_SAMPLES results
+ *****************************************************************************/
+void startLDMA(void)
+{
+  LDMA_TransferCfg_t transferCfg =
+    LDMA_TRANSFER_CFG_PERIPHERAL(ldmaPeripheralSignal_IADC0_IADC_SINGLE);
+
+  descriptor = (LDMA_Descriptor_t)
+    LDMA_DESCRIPTOR_SINGLE_P2M_WORD(&IADC0->SINGLEFIFODATA, singleBuffer,
+                                    NUM_SAMPLES);
+
+  samplesDone = false;
+  LDMA_StartTransfer(IADC_LDMA_CH, &transferCfg, &descriptor);
+}
+
+/**************************************************************************//**
+ * @brief  LDMA IRQ Handler
+ *****************************************************************************/
+void LDMA_IRQHandler(void)
+{
+  // Clear interrupt flags
+  LDMA_IntClear(1 << IADC_LDMA_CH);
+
+  samplesDone = true;
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Convert NUM_SAMPLES times in one configuration and work out the
+ *   effective resolution
+ *
+ * @details
+ *   The CPU sleeps in EM2 for the whole second of conversions, which is
+ *   marked with the ENERGYMARK ID of the configuration, so the average
+ *   current over the marked region is the current of the configuration.
+ *   The effective number of bits is the result width less the bits the
+ *   noise takes up, log2(noise * sqrt(12)), as for a quantizer of that
+ *   many bits; a noise below one LSB counts as the full result width.
+ *****************************************************************************/
+void measure(volatile Result_t *result)
+{
+  uint32_t i;
+  uint32_t count = NUM_SAMPLES - SKIP_SAMPLES;
+  double sum = 0, deviation, variance = 0, span;
+
+  initIADC(result);
+  startLDMA();
+
+  ENERGYMARK_BEGIN(result->marker);
+  startTrigger(result->trigger);
+
+  while (!samplesDone) {
+    CORE_DECLARE_IRQ_STATE;
+
+    CORE_ENTER_CRITICAL();
+    if (!samplesDone) {
+      EMU_EnterEM2(true);
+    }
+    CORE_EXIT_CRITICAL();
+  }
+
+  stopTrigger(result->trigger);
+  ENERGYMARK_END(result->marker);
+
+  for (i = SKIP_SAMPLES; i < NUM_SAMPLES; i++) {
+    sum += singleBuffer[i] & _IADC_SINGLEFIFODATA_DATA_MASK;
+  }
+  result->mean = sum / count;
+
+  for (i = SKIP_SAMPLES; i < NUM_SAMPLES; i++) {
+    deviation = (singleBuffer[i] & _IADC_SINGLEFIFODATA_DATA_MASK) - result->mean;
+    variance += deviation * deviation;
+  }
+  variance /= count;
+
+  result->noiseRms = sqrt(variance);
+  span = result->noiseRms * sqrt(12.0);
+  result->enob = (span > 1.0) ? RESULT_BITS - log2(span) : RESULT_BITS;
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Mark the configurations on the Pareto front of resolution and current
+ *
+ * @details
+ *   Only configurations with a current entered take part.  A
+ *   configuration is on the front when no other one has at least its
+ *   resolution for at most its current, and is better in one of them.
+ *****************************************************************************/
+uint32_t markPareto(void)
+{
+  uint32_t i, j, front = 0;
+
+  for (i = 0; i < NUM_CONFIGS; i++) {
+    results[i].pareto = results[i].current > 0;
+    for (j = 0; (j < NUM_CONFIGS) && results[i].pareto; j++) {
+      if ((j != i) && (results[j].current > 0)
+          && (results[j].enob >= results[i].enob)
+          && (results[j].current <= results[i].current)
+          && ((results[j].enob > results[i].enob)
+              || (results[j].current < results[i].current))) {
+        results[i].pareto = false;
+      }
+    }
+    if (results[i].pareto) {
+      front++;
+    }
+  }
+
+  return front;
+}
+
+/**************************************************************************//**
+ * @brief  Print one configuration
+ *****************************************************************************/
+void printResult(volatile const Result_t *result)
+{
+  printf("%3u  %2lu/%2lu MHz  %-7s  %2lux  %-7s  %6lu ns  %5lu.%02lu  %2lu.%02lu",
+         (unsigned int)result->marker,
+         result->srcFreq / 1000000, result->adcFreq / 1000000,
+         warmupNames[result->warmup], result->osr,
+         triggerNames[result->trigger], result->conversionNs,
+         (uint32_t)result->noiseRms,
+         (uint32_t)(result->noiseRms * 100) % 100,
+         (uint32_t)result->enob,
+         (uint32_t)(result->enob * 100) % 100);
+  if (result->current > 0) {
+    printf("  %5lu.%01lu", (uint32_t)result->current,
+           (uint32_t)(result->current * 10) % 10);
+  }
+  printf("\n");
+}
+
+/**************************************************************************//**
+ * @brief  Main function
+ *****************************************************************************/
+int main(void)
+{
+  LDMA_Init_t ldmaInit = LDMA_INIT_DEFAULT;
+  uint32_t c, w, o, t, i, front;
+
+  CHIP_Init();
+
+  ENERGYMARK_Init();
+
+  initCMU();
+
+  initLETIMER();
+
+  LDMA_Init(&ldmaInit);
+
+  RETARGET_SerialInit();
+  RETARGET_SerialCrLf(1);
+
+#ifdef EM2DEBUG
+#if (EM2DEBUG == 1)
+  // Enable debug connectivity in EM2
+  EMU->CTRL_SET = EMU_CTRL_EM2DBGEN;
+#endif
+#endif
+
+  // Every combination, in the order of the marker IDs
+  i = 0;
+  for (c = 0; c < COUNT_OF(clocks); c++) {
+    for (w = 0; w < COUNT_OF(warmups); w++) {
+      for (o = 0; o < COUNT_OF(osrs); o++) {
+        for (t = 0; t < NUM_TRIGGERS; t++) {
+          results[i].srcFreq = clocks[c].srcFreq;
+          results[i].adcFreq = clocks[c].adcFreq;
+          results[i].warmup = warmups[w];
+          results[i].osr = osrs[o].ratio;
+          results[i].trigger = (Trigger_t)t;
+          results[i].conversionNs = (uint32_t)(((4ULL * osrs[o].ratio + 2)
+                                                * 1000000000ULL)
+                                               / clocks[c].adcFreq);
+          results[i].marker = (uint8_t)(ENERGYMARK_ID_USER + i);
+          i++;
+        }
+      }
+    }
+  }
+
+  printf("\nIADC low current profiler, %u configurations at %u samples/s\n",
+         (unsigned int)NUM_CONFIGS, (unsigned int)SAMPLE_RATE);
+
+  while (1)
+  {
+    printf("\nID   CLK_SRC/ADC  warmup   OSR  trigger  convert    noise   ENOB    uA\n");
+    for (i = 0; i < NUM_CONFIGS; i++) {
+      // The USART stops in EM2, let the last line out first
+      RETARGET_SerialFlush();
+      measure(&results[i]);
+      printResult(&results[i]);
+    }
+
+    front = markPareto();
+    if (front == 0) {
+      printf("\nEnter the current of each marker in results[n].current"
+             " for the Pareto table\n");
+    } else {
+      printf("\nPareto table, %lu configurations\n", front);
+      for (i = 0; i < NUM_CONFIGS; i++) {
+        if (results[i].pareto) {
+          printResult(&results[i]);
+        }
+      }
+    }
+
+    sweeps++;
+  }
+}
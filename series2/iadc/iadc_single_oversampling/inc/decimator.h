@@ -0,0 +1,80 @@
+/***************************************************************************//**
+ * @file decimator.h
+ *
+ * @brief CIC decimator with FIR droop compensation for IADC results.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2021 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ******************************************************************************/
+
+#ifndef DECIMATOR_H
+#define DECIMATOR_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Number of integrator and comb stages, 1 to 4. Each stage attenuates
+// the noise folding back into the output band further, but the register
+// width limits the ratio: INPUT_BITS + ORDER * log2(ratio) <= 32.
+#ifndef DECIM_CIC_ORDER
+#define DECIM_CIC_ORDER       2
+#endif
+
+// Width of the unsigned input results and of the output results
+#define DECIM_INPUT_BITS      16
+#define DECIM_OUTPUT_BITS     24
+
+#if (DECIM_CIC_ORDER < 1) || (DECIM_CIC_ORDER > 4)
+#error "DECIM_CIC_ORDER must be 1 to 4"
+#endif
+
+// Decimator state. The fields are private, use the functions below.
+typedef struct {
+  uint32_t integrator[DECIM_CIC_ORDER];   // Integrator sums, wrapping
+  uint32_t comb[DECIM_CIC_ORDER];         // Comb delays
+  uint32_t ratio;                         // Input results per output
+  uint32_t phase;                         // Inputs since the last output
+  uint32_t gain;                          // DC gain, ratio ^ order
+  bool compensate;                        // Run the FIR stage
+  int32_t fir[2];                         // FIR delay line
+} DECIM_Context_t;
+
+bool DECIM_Init(DECIM_Context_t *ctx, uint32_t ratio, bool compensate);
+uint32_t DECIM_Process(DECIM_Context_t *ctx,
+                       const uint32_t *in,
+                       uint32_t count,
+                       int32_t *out,
+                       uint32_t maxOut);
+uint32_t DECIM_MaxRatio(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // DECIMATOR_H
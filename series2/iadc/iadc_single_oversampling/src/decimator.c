@@ -0,0 +1,259 @@
+/***************************************************************************//**
+ * @file decimator.c
+ *
+ * @brief CIC decimator with FIR droop compensation for IADC results.
+ *
+ * The IADC oversampling and digital averaging stop at 16 bits in normal
+ * mode. This stage averages further in software: a CIC filter of
+ * DECIM_CIC_ORDER integrators at the input rate and as many combs at the
+ * output rate reduces the rate by any ratio with additions only. The
+ * integrators wrap modulo 2^32, which the combs undo as long as the
+ * output fits in 32 bits, so no wider arithmetic is needed per input.
+ *
+ * The CIC passband falls off towards the output Nyquist frequency. The
+ * optional 3-tap FIR stage (-1, 10, -1) / 8 at the output rate lifts it
+ * back up, with unity gain at DC. Outputs are scaled to DECIM_OUTPUT_BITS
+ * unsigned bits, the first few after DECIM_Init() are settling.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2021 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ *******************************************************************************
+ * # Evaluation Quality
+ * This code has been minimally tested to ensure that it builds and is suitable 
+ * as a demonstration for evaluation purposes only. This code will be maintained
+ * at the sole discretion of Silicon Labs.
+ ******************************************************************************/
+
+#include <stddef.h>
+
+#include "decimator.h"
+
+// Input results are right aligned, anything above them is ignored
+#define DECIM_INPUT_MASK      ((1UL << DECIM_INPUT_BITS) - 1)
+#define DECIM_INPUT_MAX       DECIM_INPUT_MASK
+#define DECIM_OUTPUT_MAX      ((1L << DECIM_OUTPUT_BITS) - 1)
+
+/**************************************************************************//**
+ * @brief
+ *   DC gain of a CIC filter, or 0 if a full scale input would not fit in
+ *   32 bits.
+ *****************************************************************************/
+static uint32_t cicGain(uint32_t ratio)
+{
+  uint64_t gain = 1;
+  int i;
+
+  for (i = 0; i < DECIM_CIC_ORDER; i++) {
+    gain *= ratio;
+    if ((gain * DECIM_INPUT_MAX) > 0xFFFFFFFFULL) {
+      return 0;
+    }
+  }
+
+  return (uint32_t)gain;
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Largest ratio DECIM_Init() accepts for the configured order.
+ *****************************************************************************/
+uint32_t DECIM_MaxRatio(void)
+{
+  uint32_t ratio = 2;
+
+  while (cicGain(ratio + 1) != 0) {
+    ratio++;
+  }
+
+  return ratio;
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Reset a decimator and set its ratio
+ *
+ * @param[out] ctx
+ *   Decimator state.
+ *
+ * @param[in] ratio
+ *   Input results per output, 2 to DECIM_MaxRatio().
+ *
+ * @param[in] compensate
+ *   true to run the FIR droop compensation after the CIC filter.
+ *
+ * @return
+ *   false if the ratio is out of range.
+ *****************************************************************************/
+bool DECIM_Init(DECIM_Context_t *ctx, uint32_t ratio, bool compensate)
+{
+  int i;
+
+  ctx->gain = (ratio >= 2) ? cicGain(ratio) : 0;
+  if (ctx->gain == 0) {
+    return false;
+  }
+
+  for (i = 0; i < DECIM_CIC_ORDER; i++) {
+    ctx->integrator[i] = 0;
+    ctx->comb[i] = 0;
+  }
+  ctx->ratio = ratio;
+  ctx->phase = 0;
+  ctx->compensate = compensate;
+  ctx->fir[0] = 0;
+  ctx->fir[1] = 0;
+
+  return true;
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Run the integrators over a run of inputs that does not cross an
+ *   output, keeping the sums in registers.
+ *****************************************************************************/
+static void integrate(DECIM_Context_t *ctx, const uint32_t *in, uint32_t count)
+{
+  uint32_t acc[DECIM_CIC_ORDER];
+  uint32_t x;
+  uint32_t i;
+  int s;
+
+  for (s = 0; s < DECIM_CIC_ORDER; s++) {
+    acc[s] = ctx->integrator[s];
+  }
+
+  for (i = 0; i < count; i++) {
+    x = in[i] & DECIM_INPUT_MASK;
+    for (s = 0; s < DECIM_CIC_ORDER; s++) {
+      acc[s] += x;
+      x = acc[s];
+    }
+  }
+
+  for (s = 0; s < DECIM_CIC_ORDER; s++) {
+    ctx->integrator[s] = acc[s];
+  }
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Run the combs and the FIR stage for one output
+ *****************************************************************************/
+static int32_t output(DECIM_Context_t *ctx)
+{
+  uint32_t y = ctx->integrator[DECIM_CIC_ORDER - 1];
+  uint32_t delayed;
+  int32_t x, v;
+  int s;
+
+  for (s = 0; s < DECIM_CIC_ORDER; s++) {
+    delayed = ctx->comb[s];
+    ctx->comb[s] = y;
+    y -= delayed;
+  }
+
+  // Scale from 0 to DECIM_INPUT_MAX * gain to the output width, rounded.
+  // Only one division per output, i.e. per ratio inputs.
+  x = (int32_t)((((uint64_t)y << (DECIM_OUTPUT_BITS - DECIM_INPUT_BITS))
+                 + (ctx->gain / 2)) / ctx->gain);
+
+  if (!ctx->compensate) {
+    return x;
+  }
+
+  // Symmetric FIR, the output is one sample behind the CIC output
+  v = ((10 * ctx->fir[0]) - x - ctx->fir[1]) / 8;
+  ctx->fir[1] = ctx->fir[0];
+  ctx->fir[0] = x;
+
+  if (v < 0) {
+    v = 0;
+  } else if (v > DECIM_OUTPUT_MAX) {
+    v = DECIM_OUTPUT_MAX;
+  }
+
+  return v;
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Decimate a block of IADC results
+ *
+ * @details
+ *   The state carries over between calls, so blocks can be of any length
+ *   and do not need to be a multiple of the ratio.
+ *
+ * @param[in,out] ctx
+ *   Decimator state.
+ *
+ * @param[in] in
+ *   IADC FIFO words with right aligned DECIM_INPUT_BITS bit results.
+ *
+ * @param[in] count
+ *   Number of input words.
+ *
+ * @param[out] out
+ *   Output results, DECIM_OUTPUT_BITS bits unsigned.
+ *
+ * @param[in] maxOut
+ *   Size of out. The filter state is kept up to date for outputs that do
+ *   not fit, but they are lost.
+ *
+ * @return
+ *   Number of outputs written.
+ *****************************************************************************/
+uint32_t DECIM_Process(DECIM_Context_t *ctx,
+                       const uint32_t *in,
+                       uint32_t count,
+                       int32_t *out,
+                       uint32_t maxOut)
+{
+  uint32_t written = 0;
+  uint32_t run;
+  int32_t result;
+
+  while (count > 0) {
+    // Inputs up to the next output
+    run = ctx->ratio - ctx->phase;
+    if (run > count) {
+      run = count;
+    }
+
+    integrate(ctx, in, run);
+    in += run;
+    count -= run;
+    ctx->phase += run;
+
+    if (ctx->phase == ctx->ratio) {
+      ctx->phase = 0;
+      result = output(ctx);
+      if (written < maxOut) {
+        out[written++] = result;
+      }
+    }
+  }
+
+  return written;
+}
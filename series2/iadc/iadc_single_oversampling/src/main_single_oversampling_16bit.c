@@ -3,7 +3,8 @@
  * while asleep and setting the oversampling field to achieve a 16-bit
  * resolution conversion. Sample clock is 10 MHz, and oversampling rate is 32.
  * This gives a sampling frequency of about 77 kHz. The IADC reads GPIO pins PC5
- * as input.
+ * as input. The LDMA collects the results, and a CIC decimator in software
+ * averages them further to 24-bit results at a lower rate.
  *******************************************************************************
  * # License
  * <b>Copyright 2021 Silicon Laboratories Inc. www.silabs.com</b>
@@ -39,11 +40,16 @@
 #include "em_device.h"
 #include "em_chip.h"
 #include "em_cmu.h"
+#include "em_core.h"
 #include "em_emu.h"
 #include "em_iadc.h"
 #include "em_gpio.h"
+#include "em_ldma.h"
 #include "em_prs.h"
 
+#include "benchmark.h"
+#include "decimator.h"
+
 /*******************************************************************************
  *******************************   DEFINES   ***********************************
  ******************************************************************************/
@@ -58,6 +64,21 @@
 // CLK_ADC; IADC_SCHEDx PRESCALE has 10 valid bits
 #define CLK_ADC_FREQ             10000000
 
+// IADC sample rate, conversion time = ((4 * OSRHS) + 2) / fCLK_ADC. IADC_OSR
+// must match the osrHighSpeed setting in initIADC().
+#define IADC_OSR                 32
+#define IADC_SAMPLE_RATE         (CLK_ADC_FREQ / ((4 * IADC_OSR) + 2))
+
+// Use specified LDMA channel
+#define IADC_LDMA_CH             0
+
+// Size of the LDMA sample ring, each half is decimated in one go
+#define NUM_SAMPLES              1024
+#define BLOCK_SAMPLES            (NUM_SAMPLES / 2)
+
+// Most outputs one half can give, with the smallest ratio of 2
+#define MAX_BLOCK_OUTPUTS        ((BLOCK_SAMPLES / 2) + 1)
+
 /*
  * Specify the IADC input using the IADC_PosInput_t typedef.  This
  * must be paired with a corresponding macro definition that allocates
@@ -93,9 +114,44 @@
  ******************************************************************************/
 
 // Stores latest ADC sample and converts to volts
-static volatile IADC_Result_t sample;
+static volatile uint32_t sample;
 static volatile double singleResult;
 
+/*
+ * Software decimation ratio and FIR droop compensation, read once at
+ * start-up so they can be changed in the debugger before running.  The
+ * output rate is IADC_SAMPLE_RATE / decimationRatio, about 300 Hz for the
+ * default of 256.  Each factor of 4 in the ratio halves the white noise,
+ * adding one bit of resolution.
+ */
+volatile uint32_t decimationRatio = 256;
+volatile bool decimationCompensate = true;
+
+// Latest decimated result, 24 bits, and converted to volts
+static volatile int32_t decimatedSample;
+static volatile double decimatedResult;
+
+/*
+ * Cycle budget of the decimator: the core clock cycles one half of the
+ * ring takes to fill, the cycles the last half took to decimate, and
+ * the highest load seen so far in percent.  The load must stay below
+ * 100 percent, or halves are dropped while the IADC keeps converting.
+ */
+volatile uint32_t cycleBudget;
+volatile uint32_t cyclesUsed;
+volatile uint32_t peakLoad;
+volatile uint32_t blocksDropped;
+
+// Ring the LDMA writes IADC results to, in two halves
+static uint32_t sampleBuffer[NUM_SAMPLES];
+static LDMA_Descriptor_t descriptors[2];
+
+// Half of the ring waiting to be decimated, set from the LDMA interrupt
+static const uint32_t *volatile readyBlock;
+
+static DECIM_Context_t decimator;
+static int32_t decimated[MAX_BLOCK_OUTPUTS];
+
 /**************************************************************************//**
  * @brief  GPIO Initializer
  *****************************************************************************/
@@ -178,6 +234,9 @@ void initIADC(void)
   // Single initialization
   initSingle.dataValidLevel = iadcFifoCfgDvl1;
 
+  // Request the LDMA, also in EM2, each time a result is in the FIFO
+  initSingle.fifoDmaWakeup = true;
+
   // Set conversions to run continuously
   initSingle.triggerAction = iadcTriggerActionContinuous;
 
@@ -198,28 +257,88 @@ void initIADC(void)
 
   // Allocate the analog bus for ADC0 inputs
   GPIO->IADC_INPUT_0_BUS |= IADC_INPUT_0_BUSALLOC;
+}
+
+/**************************************************************************//**
+ * @brief  LDMA Initializer
+ *****************************************************************************/
+void initLDMA(void)
+{
+  LDMA_Init_t init = LDMA_INIT_DEFAULT;
 
-  // Enable interrupts on single conversion completion
-  IADC_enableInt(IADC0, IADC_IEN_SINGLEDONE);
+  // Trigger LDMA transfer on IADC single FIFO level
+  LDMA_TransferCfg_t transferCfg =
+    LDMA_TRANSFER_CFG_PERIPHERAL(ldmaPeripheralSignal_IADC0_IADC_SINGLE);
 
-  // Enable ADC interrupts
-  NVIC_ClearPendingIRQ(IADC_IRQn);
-  NVIC_EnableIRQ(IADC_IRQn);
+  LDMA_Init(&init);
+
+  /*
+   * Two descriptors that link to each other, one for each half of the
+   * ring, so the LDMA never stops.  Each interrupts when its half is
+   * full, while the other half is being filled.
+   */
+  descriptors[0] = (LDMA_Descriptor_t)
+    LDMA_DESCRIPTOR_LINKREL_P2M_WORD(&(IADC0->SINGLEFIFODATA), sampleBuffer, BLOCK_SAMPLES, 1);
+  descriptors[1] = (LDMA_Descriptor_t)
+    LDMA_DESCRIPTOR_LINKREL_P2M_WORD(&(IADC0->SINGLEFIFODATA), sampleBuffer + BLOCK_SAMPLES, BLOCK_SAMPLES, -1);
+  descriptors[0].xfer.doneIfs = 1;
+  descriptors[1].xfer.doneIfs = 1;
+
+  LDMA_StartTransfer(IADC_LDMA_CH, (void*)&transferCfg, (void*)&descriptors[0]);
 }
 
 /**************************************************************************//**
- * @brief  IADC interrupt handler
+ * @brief  LDMA interrupt handler
  *****************************************************************************/
-void IADC_IRQHandler(void)
+void LDMA_IRQHandler(void)
 {
-  // Read most recent single conversion result
-  sample = IADC_readSingleResult(IADC0);
+  uint32_t pending = LDMA_IntGetEnabled();
+
+  // Loop here to enable the debugger to see what has happened
+  if (pending & LDMA_IF_ERROR) {
+    __BKPT(0);
+  }
+
+  LDMA_IntClear(1 << IADC_LDMA_CH);
+
+  // The LDMA is already writing the other half, the one before it is full
+  if (readyBlock != NULL) {
+    blocksDropped++;
+  }
+  if (LDMA->CH[IADC_LDMA_CH].DST < (uint32_t)(sampleBuffer + BLOCK_SAMPLES)) {
+    readyBlock = sampleBuffer + BLOCK_SAMPLES;
+  } else {
+    readyBlock = sampleBuffer;
+  }
+}
+
+/**************************************************************************//**
+ * @brief  Decimate one half of the ring and track the cycle budget
+ *****************************************************************************/
+void processBlock(const uint32_t *block)
+{
+  uint32_t start, load, count;
+
+  BENCHMARK_START(start);
+  count = DECIM_Process(&decimator, block, BLOCK_SAMPLES,
+                        decimated, MAX_BLOCK_OUTPUTS);
+  cyclesUsed = BENCHMARK_Elapsed(start);
+  BENCHMARK_Record("decimate", cyclesUsed, BLOCK_SAMPLES);
+
+  load = (uint32_t)(((uint64_t)cyclesUsed * 100) / cycleBudget);
+  if (load > peakLoad) {
+    peakLoad = load;
+  }
 
   // For single-ended the result range is 0 to +Vref, i.e., 16 bits for the
-  // conversion value.
-  singleResult = sample.data * 2.42 / 0xFFFF;
+  // conversion value, and 24 bits after decimation.
+  sample = block[BLOCK_SAMPLES - 1] & 0xFFFF;
+  singleResult = sample * 2.42 / 0xFFFF;
 
-  IADC_clearInt(IADC0, IADC_IF_SINGLEDONE);
+  if (count > 0) {
+    decimatedSample = decimated[count - 1];
+    decimatedResult = decimatedSample * 2.42 / 0xFFFFFF;
+  }
 }
 
 /**************************************************************************//**
@@ -238,6 +357,19 @@ int main(void)
   // Initialize the IADC
   initIADC();
 
+  // Fall back to the default ratio if the one set is out of range
+  if (!DECIM_Init(&decimator, decimationRatio, decimationCompensate)) {
+    decimationRatio = 256;
+    DECIM_Init(&decimator, decimationRatio, decimationCompensate);
+  }
+
+  // Core clock cycles available per half of the ring
+  BENCHMARK_Init();
+  cycleBudget = (uint32_t)(((uint64_t)SystemCoreClockGet() * BLOCK_SAMPLES)
+                           / IADC_SAMPLE_RATE);
+
+  initLDMA();
+
 #ifdef EM2DEBUG
 #if (EM2DEBUG == 1)
   // Enable debug connectivity in EM2
@@ -250,7 +382,20 @@ int main(void)
 
   while (1)
   {
-    // Enter EM2 sleep, woken by IADC interrupt
-    EMU_EnterEM2(true);
+    const uint32_t *block;
+    CORE_DECLARE_IRQ_STATE;
+
+    // Enter EM2 sleep, woken by the LDMA interrupt when half the ring is full
+    CORE_ENTER_CRITICAL();
+    if (readyBlock == NULL) {
+      EMU_EnterEM2(true);
+    }
+    block = readyBlock;
+    readyBlock = NULL;
+    CORE_EXIT_CRITICAL();
+
+    if (block != NULL) {
+      processBlock(block);
+    }
   }
 }
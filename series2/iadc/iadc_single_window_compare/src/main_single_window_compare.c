@@ -2,6 +2,9 @@
  * @brief Uses the IADC as a window comparator on a single pin. Input is taken
  * on PC05 and PB01 (WSTK LED0) toggles on each comparator trigger. The most
  * recent sample within the window comparison is also stored globally.
+ * With WINDOW_LOGGING set, the LDMA logs every sample with a timestamp, the
+ * CPU wakes once per half of the log and LED0 toggles every EVENT_COUNT
+ * samples within the window.
  *******************************************************************************
  * # License
  * <b>Copyright 2021 Silicon Laboratories Inc. www.silabs.com</b>
@@ -37,9 +40,13 @@
 #include "em_device.h"
 #include "em_chip.h"
 #include "em_cmu.h"
+#include "em_core.h"
 #include "em_emu.h"
 #include "em_iadc.h"
 #include "em_gpio.h"
+#include "em_ldma.h"
+#include "em_prs.h"
+#include "em_timer.h"
 #include "bsp.h"
 
 /*******************************************************************************
@@ -80,6 +87,44 @@
 // CTUNE value for the radio board HFXO oscillator
 #define HFXO_CTUNE_VALUE        BSP_HFXO_CTUNE
 
+/*
+ * Setting this #define to 1 logs every sample with a timestamp instead of
+ * interrupting on each sample within the window.  The compare result is
+ * neither an LDMA request nor a PRS signal, so the LDMA cannot pick out
+ * the samples within the window by itself.  Instead the CPU wakes each
+ * time half of the log is full, skips the half straight away unless the
+ * window compare flag has been set, and otherwise copies the samples
+ * within the window to the event log.
+ */
+#define WINDOW_LOGGING          1
+
+#if (WINDOW_LOGGING == 1)
+// Samples in the log, each half holds 51 ms at 10 ksps.  A larger log
+// means fewer wakeups.
+#define LOG_SAMPLES             1024
+#define LOG_HALF                (LOG_SAMPLES / 2)
+
+// Samples within the window kept in the event log, and the number of them
+// after which LED0 toggles
+#define EVENT_LOG_SIZE          64
+#define EVENT_COUNT             100
+
+// LDMA channels for the samples and their timestamps
+#define SAMPLE_LDMA_CH          0
+#define TIME_LDMA_CH            1
+
+// PRS channel from the IADC conversion done pulse to TIMER0 CC0 capture
+#define IADC_PRS_CH             0
+
+// Timestamps are TIMER0 counts, HFXO / 32 = 1.2 MHz
+#define TIMESTAMP_PRESCALE      timerPrescale32
+
+// Same test as the window comparator: the 12-bit result against the upper
+// 12 bits of the 16-bit left-justified bounds
+#define IN_WINDOW(data)         ((((data) << 4) >= WINDOW_LOWER_BOUND) \
+                                 && (((data) << 4) <= WINDOW_UPPER_BOUND))
+#endif
+
 /*******************************************************************************
  ***************************   GLOBAL VARIABLES   *******************************
  ******************************************************************************/
@@ -88,6 +133,35 @@
 static volatile IADC_Result_t sample;
 static volatile double singleResult;
 
+#if (WINDOW_LOGGING == 1)
+// One sample within the window and the TIMER0 count at its conversion
+typedef struct {
+  uint32_t timestamp;
+  uint32_t data;
+} WindowEvent_t;
+
+// Rings the LDMA fills, entry i of each belongs to the same conversion
+static uint32_t sampleLog[LOG_SAMPLES];
+static uint32_t timeLog[LOG_SAMPLES];
+
+static LDMA_Descriptor_t sampleDescriptors[2];
+static LDMA_Descriptor_t timeDescriptor;
+
+// Half of the log waiting to be checked, set from the LDMA interrupt
+static volatile int readyHalf = -1;
+
+// The last EVENT_LOG_SIZE samples within the window, eventCount is the
+// total so far and eventCount % EVENT_LOG_SIZE the next entry written
+WindowEvent_t eventLog[EVENT_LOG_SIZE];
+volatile uint32_t eventCount;
+
+// CPU wakeups, halves of the log actually searched, halves not checked in
+// time
+volatile uint32_t halvesChecked;
+volatile uint32_t halvesSearched;
+volatile uint32_t halvesDropped;
+#endif
+
 /**************************************************************************//**
  * @brief  GPIO Initializer
  *****************************************************************************/
@@ -164,6 +238,11 @@ void initIADC (void)
   // Enable window comparisons on this input
   initSingleInput.compare = true;
 
+#if (WINDOW_LOGGING == 1)
+  // Request the LDMA each time a result is in the FIFO
+  initSingle.fifoDmaWakeup = true;
+#endif
+
   // Initialize IADC
   IADC_init(IADC0, &init, &initAllConfigs);
 
@@ -173,14 +252,143 @@ void initIADC (void)
   // Allocate the analog bus for ADC0 inputs
   GPIO->IADC_INPUT_0_BUS |= IADC_INPUT_0_BUSALLOC;
 
+#if (WINDOW_LOGGING == 0)
   // Enable interrupts on window comparison match
   IADC_enableInt(IADC0, IADC_IEN_SINGLECMP);
 
   // Enable ADC interrupts
   NVIC_ClearPendingIRQ(IADC_IRQn);
   NVIC_EnableIRQ(IADC_IRQn);
+#endif
+}
+
+#if (WINDOW_LOGGING == 1)
+/**************************************************************************//**
+ * @brief  TIMER and PRS Initializer for the sample timestamps
+ *****************************************************************************/
+void initTimestamps(void)
+{
+  TIMER_Init_TypeDef timerInit = TIMER_INIT_DEFAULT;
+  TIMER_InitCC_TypeDef timerCCInit = TIMER_INITCC_DEFAULT;
+
+  CMU_ClockEnable(cmuClock_PRS, true);
+  CMU_ClockEnable(cmuClock_TIMER0, true);
+
+  // Route the IADC conversion done pulse to TIMER0 CC0
+  PRS_SourceAsyncSignalSet(IADC_PRS_CH, PRS_ASYNC_CH_CTRL_SOURCESEL_IADC0,
+                           PRS_ASYNC_CH_CTRL_SIGSEL_IADC0SINGLEDONE);
+  PRS_ConnectConsumer(IADC_PRS_CH, prsTypeAsync, prsConsumerTIMER0_CC0);
+
+  // Free running 32-bit count, captured on every conversion
+  timerInit.enable = false;
+  timerInit.prescale = TIMESTAMP_PRESCALE;
+  timerCCInit.prsSel = IADC_PRS_CH;
+  timerCCInit.edge = timerEdgeRising;
+  timerCCInit.mode = timerCCModeCapture;
+  timerCCInit.prsInput = true;
+  timerCCInit.prsInputType = timerPrsInputAsyncPulse;
+
+  TIMER_Init(TIMER0, &timerInit);
+  TIMER_InitCC(TIMER0, 0, &timerCCInit);
+  TIMER_Enable(TIMER0, true);
 }
 
+/**************************************************************************//**
+ * @brief  LDMA Initializer for the sample and timestamp logs
+ *****************************************************************************/
+void initLDMA(void)
+{
+  LDMA_Init_t init = LDMA_INIT_DEFAULT;
+  LDMA_TransferCfg_t sampleCfg =
+    LDMA_TRANSFER_CFG_PERIPHERAL(ldmaPeripheralSignal_IADC0_IADC_SINGLE);
+  LDMA_TransferCfg_t timeCfg =
+    LDMA_TRANSFER_CFG_PERIPHERAL(ldmaPeripheralSignal_TIMER0_CC0);
+
+  LDMA_Init(&init);
+
+  /*
+   * Samples: one descriptor per half of the log, linked to each other so
+   * the LDMA never stops, each interrupting when its half is full.
+   */
+  sampleDescriptors[0] = (LDMA_Descriptor_t)
+    LDMA_DESCRIPTOR_LINKREL_P2M_WORD(&(IADC0->SINGLEFIFODATA), sampleLog, LOG_HALF, 1);
+  sampleDescriptors[1] = (LDMA_Descriptor_t)
+    LDMA_DESCRIPTOR_LINKREL_P2M_WORD(&(IADC0->SINGLEFIFODATA), sampleLog + LOG_HALF, LOG_HALF, -1);
+  sampleDescriptors[0].xfer.doneIfs = 1;
+  sampleDescriptors[1].xfer.doneIfs = 1;
+
+  /*
+   * Timestamps: one descriptor over the whole log linked to itself.  It
+   * moves one capture per conversion, just like the sample channel, so
+   * the two logs stay in step without an interrupt of their own.
+   */
+  timeDescriptor = (LDMA_Descriptor_t)
+    LDMA_DESCRIPTOR_LINKREL_P2M_WORD(&(TIMER0->CC[0].ICF), timeLog, LOG_SAMPLES, 0);
+  timeDescriptor.xfer.ignoreSrec = 0;
+
+  LDMA_StartTransfer(TIME_LDMA_CH, (void*)&timeCfg, (void*)&timeDescriptor);
+  LDMA_StartTransfer(SAMPLE_LDMA_CH, (void*)&sampleCfg, (void*)&sampleDescriptors[0]);
+}
+
+/**************************************************************************//**
+ * @brief  LDMA interrupt handler
+ *****************************************************************************/
+void LDMA_IRQHandler(void)
+{
+  uint32_t pending = LDMA_IntGetEnabled();
+
+  // Loop here to enable the debugger to see what has happened
+  if (pending & LDMA_IF_ERROR) {
+    __BKPT(0);
+  }
+
+  LDMA_IntClear(1 << SAMPLE_LDMA_CH);
+
+  // The LDMA is already writing the other half, the one before it is full
+  if (readyHalf >= 0) {
+    halvesDropped++;
+  }
+  if (LDMA->CH[SAMPLE_LDMA_CH].DST < (uint32_t)(sampleLog + LOG_HALF)) {
+    readyHalf = 1;
+  } else {
+    readyHalf = 0;
+  }
+}
+
+/**************************************************************************//**
+ * @brief  Copy the samples within the window from one half of the log
+ *****************************************************************************/
+void searchHalf(int half)
+{
+  const uint32_t *data = sampleLog + (half * LOG_HALF);
+  const uint32_t *time = timeLog + (half * LOG_HALF);
+  uint32_t count = eventCount;
+  uint32_t i;
+
+  for (i = 0; i < LOG_HALF; i++) {
+    if (IN_WINDOW(data[i])) {
+      eventLog[count % EVENT_LOG_SIZE].timestamp = time[i];
+      eventLog[count % EVENT_LOG_SIZE].data = data[i];
+      count++;
+
+      // Toggle WSTK LED0 every EVENT_COUNT samples within the window
+      if ((count % EVENT_COUNT) == 0) {
+        GPIO_PinOutToggle(BSP_GPIO_LED0_PORT, BSP_GPIO_LED0_PIN);
+      }
+    }
+  }
+
+  if (count != eventCount) {
+    // Most recent sample within the window, converted as below
+    sample.data = eventLog[(count - 1) % EVENT_LOG_SIZE].data;
+    singleResult = sample.data * 2.42 / 0xFFF;
+    eventCount = count;
+  }
+
+  halvesSearched++;
+}
+#endif
+
 void initHFXO(void)
 {
   // Initialization structure for HFXO configuration
@@ -200,6 +408,7 @@ void initHFXO(void)
   CMU_OscillatorEnable(cmuOsc_HFXO, true, true);
 }
 
+#if (WINDOW_LOGGING == 0)
 /**************************************************************************//**
  * @brief  IADC interrupt handler
  *****************************************************************************/
@@ -219,6 +428,7 @@ void IADC_IRQHandler(void)
   // Toggle WSTK LED0 to signal compare event
   GPIO_PinOutToggle(BSP_GPIO_LED0_PORT, BSP_GPIO_LED0_PIN);
 }
+#endif
 
 /**************************************************************************//**
  * @brief  Main function
@@ -236,9 +446,53 @@ int main(void)
   // Initialize the IADC
   initIADC();
 
+#if (WINDOW_LOGGING == 1)
+  initTimestamps();
+  initLDMA();
+#endif
+
   // Start scan
   IADC_command(IADC0, iadcCmdStartSingle);
 
+#if (WINDOW_LOGGING == 1)
+  bool searchNext = false;
+
+  while (1) {
+    int half;
+    bool compared;
+    CORE_DECLARE_IRQ_STATE;
+
+    // Sleep in EM1, the IADC and TIMER0 run from the HFXO, until half of
+    // the log is full
+    CORE_ENTER_CRITICAL();
+    if (readyHalf < 0) {
+      EMU_EnterEM1();
+    }
+    half = readyHalf;
+    readyHalf = -1;
+    CORE_EXIT_CRITICAL();
+
+    if (half < 0) {
+      continue;
+    }
+    halvesChecked++;
+
+    /*
+     * The window compare flag is set by any sample within the window since
+     * it was last cleared.  It may already have been set by a sample in the
+     * half the LDMA is filling now, so that half is searched next time even
+     * if the flag stays clear until then.
+     */
+    compared = (IADC_getInt(IADC0) & IADC_IF_SINGLECMP) != 0;
+    IADC_clearInt(IADC0, IADC_IF_SINGLECMP);
+
+    if (compared || searchNext) {
+      searchHalf(half);
+    }
+    searchNext = compared;
+  }
+#else
   // Infinite loop
   while(1);
+#endif
 }
@@ -0,0 +1,95 @@
+/***************************************************************************//**
+ * @file vibration.h
+ *
+ * @brief Band energy features and threshold alarms of vibration frames.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2021 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ******************************************************************************/
+
+#ifndef VIBRATION_H
+#define VIBRATION_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "arm_math.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Samples in a frame of one axis, a length arm_rfft_fast_f32() supports
+#define VIB_FFT_SIZE          512
+
+// Frequency bands each frame is reduced to
+#define VIB_BANDS             4
+
+// Frames averaged into the baseline of each band before any alarm
+#define VIB_LEARN_FRAMES      64
+
+/*
+ * A band raises its alarm once its power has stayed over VIB_ALARM_RATIO
+ * times its baseline (6 dB) for VIB_ALARM_FRAMES frames in a row, and
+ * clears it once it has stayed under VIB_CLEAR_RATIO times (3 dB) as long.
+ * The baseline is at least VIB_MIN_POWER, so a quiet input does not alarm
+ * on the quantization noise.
+ */
+#define VIB_ALARM_RATIO       4.0f
+#define VIB_CLEAR_RATIO       2.0f
+#define VIB_ALARM_FRAMES      3
+#define VIB_MIN_POWER         1.0f
+
+// Window, FFT and bands, shared by all axes as they are analyzed in turn
+typedef struct {
+  arm_rfft_fast_instance_f32 rfft;
+  float32_t window[VIB_FFT_SIZE];
+  float32_t scale;                  // Sum of |X|^2 to mean square
+  uint16_t bandBin[VIB_BANDS + 1];  // First bin of each band, then the end
+  float32_t frame[VIB_FFT_SIZE];    // Windowed frame, overwritten by the FFT
+  float32_t spectrum[VIB_FFT_SIZE]; // arm_rfft_fast_f32() packed output
+} VIB_Analyzer_t;
+
+// Features and alarms of one axis
+typedef struct {
+  float32_t rms[VIB_BANDS];         // RMS of each band in the last frame, LSB
+  float32_t baseline[VIB_BANDS];    // Mean power of each band learnt, LSB^2
+  uint32_t count[VIB_BANDS];        // Frames in a row past the alarm or clear level
+  uint32_t alarms;                  // Bit n set while band n is in alarm
+  uint32_t frames;                  // Frames analyzed
+} VIB_Axis_t;
+
+bool VIB_Init(VIB_Analyzer_t *vib, float32_t sampleRate, const float32_t *edges);
+void VIB_Window(VIB_Analyzer_t *vib, const uint16_t *samples);
+void VIB_Transform(VIB_Analyzer_t *vib);
+void VIB_Bands(VIB_Analyzer_t *vib, VIB_Axis_t *axis);
+uint32_t VIB_Update(VIB_Axis_t *axis);
+bool VIB_IsLearning(const VIB_Axis_t *axis);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // VIBRATION_H
@@ -0,0 +1,762 @@
+/***************************************************************************//**
+ * @file main_vibration_monitor.c
+ *
+ * @brief Vibration monitor for predictive maintenance.  The IADC scans two
+ * accelerometer axes at 8 ksps each, triggered by its local timer, and the
+ * LDMA streams the results into a ring while the device sleeps in EM2.
+ * Each half of the ring is a frame of 512 samples per axis, which is
+ * windowed, transformed with a real FFT and reduced to the RMS of four
+ * frequency bands.  The bands are compared to the baseline learnt at
+ * startup, and alarms and a report with the cycle and energy budget of a
+ * frame go out on the EUSART by LDMA.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2021 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ *******************************************************************************
+ * # Evaluation Quality
+ * This code has been minimally tested to ensure that it builds and is suitable 
+ * as a demonstration for evaluation purposes only. This code will be maintained
+ * at the sole discretion of Silicon Labs.
+ ******************************************************************************/
+
+#include "em_device.h"
+#include "em_chip.h"
+#include "em_cmu.h"
+#include "em_core.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "em_device.h"
+#include "em_chip.h"
+#include "em_cmu.h"
+#include "em_core.h"
+#include "em_emu.h"
+#include "em_eusart.h"
+#include "em_gpio.h"
+#include "em_iadc.h"
+#include "em_ldma.h"
+
+#include "bspconfig.h"
+#include "benchmark.h"
+#include "energymark.h"
+#include "iadcstream.h"
+#include "vibration.h"
+
+/*******************************************************************************
+ *******************************   DEFINES   ***********************************
+ ******************************************************************************/
+
+// Scan table entries, one per accelerometer axis
+#define NUM_AXES            2
+
+// Each half of the ring is one frame, VIB_FFT_SIZE scans of all the axes
+#define NUM_SAMPLES         (2 * VIB_FFT_SIZE * NUM_AXES)
+
+#if (NUM_SAMPLES > IADCS_MAX_RING)
+#error "The ring of two frames must fit in IADCS_MAX_RING"
+#endif
+
+/*
+ * Scans per second, the sample rate of each axis, set by the IADC local
+ * timer.  A frame takes VIB_FFT_SIZE / SAMPLE_RATE, 64 ms, and the bins of
+ * the FFT are SAMPLE_RATE / VIB_FFT_SIZE, 15.6 Hz, apart.
+ */
+#define SAMPLE_RATE         8000
+
+// Set CLK_ADC to 10 MHz
+#define CLK_SRC_ADC_FREQ    20000000  // CLK_SRC_ADC
+#define CLK_ADC_FREQ        10000000  // CLK_ADC - 10 MHz max in normal mode
+
+// Highest scan rate of the IADC, 833 ksps shared by the axes, see initIADC()
+#define IADC_MAX_RATE       (833333 / NUM_AXES)
+
+/*
+ * Specify the IADC input using the IADC_PosInput_t typedef.  This
+ * must be paired with a corresponding macro definition that allocates
+ * the corresponding ABUS to the IADC.  These are...
+ *
+ * GPIO->ABUSALLOC |= GPIO_ABUSALLOC_AEVEN0_ADC0
+ * GPIO->ABUSALLOC |= GPIO_ABUSALLOC_AODD0_ADC0
+ * GPIO->BBUSALLOC |= GPIO_BBUSALLOC_BEVEN0_ADC0
+ * GPIO->BBUSALLOC |= GPIO_BBUSALLOC_BODD0_ADC0
+ * GPIO->CDBUSALLOC |= GPIO_CDBUSALLOC_CDEVEN0_ADC0
+ * GPIO->CDBUSALLOC |= GPIO_CDBUSALLOC_CDODD0_ADC0
+ *
+ * ...for port A, port B, and port C/D pins, even and odd, respectively.
+ * PB00 is the VCOM enable on this board, so the axes are on port A.
+ */
+#define IADC_INPUT_0_PORT_PIN     iadcPosInputPortAPin0;
+#define IADC_INPUT_1_PORT_PIN     iadcPosInputPortAPin6;
+
+#define IADC_INPUT_0_BUS          ABUSALLOC
+#define IADC_INPUT_0_BUSALLOC     GPIO_ABUSALLOC_AEVEN0_ADC0
+#define IADC_INPUT_1_BUS          ABUSALLOC
+#define IADC_INPUT_1_BUSALLOC     GPIO_ABUSALLOC_AEVEN0_ADC0
+
+/*
+ * Full scale of the inputs, the 1.21 V reference at a gain of 0.5, in mV,
+ * and the 12 bit results it is split into
+ */
+#define FULL_SCALE_MV       2420
+#define FULL_SCALE_LSB      4096
+
+// Report on the VCOM every REPORT_FRAMES frames, about once a second
+#define REPORT_FRAMES       16
+
+// EUSART0 runs from the EM01GRPCCLK, so only while the core is in EM0 or EM1
+#define BAUDRATE            115200
+
+// LDMA channel sending the reports, channel 0 empties the scan FIFO
+#define TX_LDMA_CHANNEL     1
+#if (TX_LDMA_CHANNEL == IADCS_LDMA_CHANNEL)
+#error "The report needs an LDMA channel of its own"
+#endif
+
+// Supply of the kit for the energy of a frame, mV
+#define SUPPLY_MV           3300
+
+// Energy Profiler marker of the processing of a frame
+#define MARKER_FRAME        ENERGYMARK_ID_USER
+
+/*
+ * This example enters EM2 in the main while() loop. Setting this
+ * #define to 1 enables debug connectivity in EM2, which increases
+ * current consumption by about 0.5 uA.
+ */
+#define EM2DEBUG                  1
+
+/*******************************************************************************
+ ***************************   GLOBAL VARIABLES   *******************************
+ ******************************************************************************/
+
+// Ring the LDMA stores IADC samples in, interleaved and tagged with IDs
+static uint32_t scanBuffer[NUM_SAMPLES];
+
+// The last frame unpacked, one array per axis
+static uint16_t axisData[NUM_AXES][VIB_FFT_SIZE];
+
+static uint16_t *const axisArrays[NUM_AXES] = {
+  axisData[0],
+  axisData[1]
+};
+
+/*
+ * Band edges in Hz: running speed and its first harmonics, imbalance and
+ * misalignment; gear mesh and blade pass; and the two upper bands where
+ * bearing defects show first
+ */
+static const float32_t bandEdges[VIB_BANDS + 1] = {
+  20.0f, 250.0f, 1000.0f, 2000.0f, 4000.0f
+};
+
+static const char *const bandNames[VIB_BANDS] = {
+  "20-250 Hz", "250-1000 Hz", "1-2 kHz", "2-4 kHz"
+};
+
+// FFT and window, shared by the axes, and the features of each axis
+static VIB_Analyzer_t analyzer;
+VIB_Axis_t axes[NUM_AXES];
+
+// Half of the ring waiting to be analyzed, set from the LDMA interrupt
+static const uint32_t *volatile readyBlock;
+
+// Report text, sent by the LDMA straight from here
+static char txBuffer[768];
+static LDMA_Descriptor_t txDescriptor;
+static bool txStarted;
+
+/*
+ * Counts of the frames analyzed, the halves missed by the LDMA interrupt,
+ * frames not analyzed in time or not starting with the first axis, and
+ * report and alarm texts dropped as the previous one was still being sent
+ */
+volatile uint32_t frames;
+volatile uint32_t halvesMissed;
+volatile uint32_t framesDropped;
+volatile uint32_t framesMisaligned;
+volatile uint32_t textsDropped;
+
+/*
+ * Budget of the last report: core clock cycles of a frame, on average and
+ * at most, the share of the frame time spent in them in units of 0.01%, and
+ * the highest sample rate per axis this leaves time for
+ */
+volatile uint32_t frameCycles;
+volatile uint32_t frameCyclesMax;
+volatile uint32_t loadPermyriad;
+volatile uint32_t maxSampleRate;
+
+/*
+ * Currents of the frame marker and of EM2 in between, in uA, read from the
+ * Energy Profiler and entered here in the debugger.  Once both are set,
+ * the reports give the energy of a frame.
+ */
+volatile uint32_t activeCurrent;
+volatile uint32_t sleepCurrent;
+volatile uint32_t frameEnergyNj;
+
+/**************************************************************************//**
+ * @brief  GPIO initialization
+ *****************************************************************************/
+void initGPIO(void)
+{
+  /*
+   * On EFR32xG21 devices, CMU_ClockEnable() calls have no effect as
+   * clocks are enabled/disabled on-demand in response to peripheral
+   * requests.  Deleting such lines is safe on xG21 devices and will
+   * provide a small reduction in code size.
+   */
+  CMU_ClockEnable(cmuClock_GPIO, true);
+
+  // LED0 is on while any band of any axis is in alarm
+  GPIO_PinModeSet(BSP_GPIO_LED0_PORT, BSP_GPIO_LED0_PIN, gpioModePushPull, 0);
+
+  // Configure the EUSART TX pin to the board controller as an output
+  GPIO_PinModeSet(BSP_BCC_TXPORT, BSP_BCC_TXPIN, gpioModePushPull, 1);
+
+  // Route EUSART0 TX to the board controller, nothing is received
+  GPIO->EUSARTROUTE[0].TXROUTE = (BSP_BCC_TXPORT << _GPIO_EUSART_TXROUTE_PORT_SHIFT)
+      | (BSP_BCC_TXPIN << _GPIO_EUSART_TXROUTE_PIN_SHIFT);
+  GPIO->EUSARTROUTE[0].ROUTEEN = GPIO_EUSART_ROUTEEN_TXPEN;
+
+  /*
+   * Configure the BCC_ENABLE pin as output and set high.  This enables
+   * the virtual COM port (VCOM) connection to the board controller and
+   * permits serial port traffic over the debug connection to the host
+   * PC.
+   */
+  GPIO_PinModeSet(BSP_BCC_ENABLE_PORT, BSP_BCC_ENABLE_PIN, gpioModePushPull, 1);
+}
+
+/**************************************************************************//**
+ * @brief  EUSART0 initialization, transmit only
+ *****************************************************************************/
+void initEUSART0(void)
+{
+  EUSART_UartInit_TypeDef init = EUSART_UART_INIT_DEFAULT_HF;
+
+  CMU_ClockSelectSet(cmuClock_EUSART0CLK, cmuSelect_EM01GRPCCLK);
+  CMU_ClockEnable(cmuClock_EUSART0, true);
+
+  init.baudrate = BAUDRATE;
+  EUSART_UartInitHf(EUSART0, &init);
+}
+
+/**************************************************************************//**
+ * @brief  IADC initialization
+ *****************************************************************************/
+void initIADC(void)
+{
+  // Declare initialization structures
+  IADC_Init_t init = IADC_INIT_DEFAULT;
+  IADC_AllConfigs_t initAllConfigs = IADC_ALLCONFIGS_DEFAULT;
+  IADC_InitScan_t initScan = IADC_INITSCAN_DEFAULT;
+
+  // Scan table structure
+  IADC_ScanTable_t scanTable = IADC_SCANTABLE_DEFAULT;
+
+  CMU_ClockEnable(cmuClock_IADC0, true);
+
+  // Use the FSRC0 as the IADC clock so it can run in EM2
+  CMU_ClockSelectSet(cmuClock_IADCCLK, cmuSelect_FSRCO);
+
+  // Shutdown between conversions to reduce current
+  init.warmup = iadcWarmupNormal;
+
+  // Set the HFSCLK prescale value here
+  init.srcClkPrescale = IADC_calcSrcClkPrescale(IADC0, CLK_SRC_ADC_FREQ, 0);
+
+  // The IADC local timer runs at CLK_SRC_ADC_FREQ and starts each scan
+  init.timerCycles = CLK_SRC_ADC_FREQ / SAMPLE_RATE;
+
+  /*
+   * Configuration 0 is used by both scan and single conversions by
+   * default.  Use internal bandgap as the reference and specify the
+   * reference voltage in mV.
+   *
+   * Resolution is not configurable directly but is based on the
+   * selected oversampling ratio (osrHighSpeed), which defaults to
+   * 2x and generates 12-bit results.
+   */
+  initAllConfigs.configs[0].reference = iadcCfgReferenceInt1V2;
+  initAllConfigs.configs[0].vRef = 1210;
+  initAllConfigs.configs[0].osrHighSpeed = iadcCfgOsrHighSpeed2x;
+  initAllConfigs.configs[0].analogGain = iadcCfgAnalogGain0P5x;
+
+  /*
+   * CLK_SRC_ADC must be prescaled by some value greater than 1 to
+   * derive the intended CLK_ADC frequency.
+   *
+   * Based on the default 2x oversampling rate (OSRHS)...
+   *
+   * conversion time = ((4 * OSRHS) + 2) / fCLK_ADC
+   *
+   * ...which results in a maximum sampling rate of 833 ksps with the
+   * 2-clock input multiplexer switching time is included.
+   */
+  initAllConfigs.configs[0].adcClkPrescale = IADC_calcAdcClkPrescale(IADC0,
+                                                                     CLK_ADC_FREQ,
+                                                                     0,
+                                                                     iadcCfgModeNormal,
+                                                                     init.srcClkPrescale);
+
+  /*
+   * The IADC local timer triggers a scan of both axes.
+   *
+   * Set the SCANFIFODVL flag when scan FIFO holds 2 entries, one scan,
+   * and wake the LDMA up to empty the FIFO in EM2.
+   *
+   * Tag each FIFO entry with its scan table entry ID, so the unpacking
+   * can check that a frame begins with the first axis.
+   */
+  initScan.triggerSelect = iadcTriggerSelTimer;
+  initScan.dataValidLevel = iadcFifoCfgDvl2;
+  initScan.fifoDmaWakeup = true;
+  initScan.showId = true;
+
+  /*
+   * Configure entries in the scan table.  CH0 is single-ended from
+   * axis 0; CH1 is single-ended from axis 1.
+   */
+  scanTable.entries[0].posInput = IADC_INPUT_0_PORT_PIN;
+  scanTable.entries[0].negInput = iadcNegInputGnd;
+  scanTable.entries[0].includeInScan = true;
+
+  scanTable.entries[1].posInput = IADC_INPUT_1_PORT_PIN;
+  scanTable.entries[1].negInput = iadcNegInputGnd;
+  scanTable.entries[1].includeInScan = true;
+
+  // Initialize IADC
+  IADC_init(IADC0, &init, &initAllConfigs);
+
+  // Initialize scan
+  IADC_initScan(IADC0, &initScan, &scanTable);
+
+  // Allocate the analog bus for ADC0 inputs
+  GPIO->IADC_INPUT_0_BUS |= IADC_INPUT_0_BUSALLOC;
+  GPIO->IADC_INPUT_1_BUS |= IADC_INPUT_1_BUSALLOC;
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Called from the LDMA interrupt each time half of the ring is full
+ *
+ * @param[in] block
+ *   The half just filled, one frame.
+ * @param[in] count
+ *   Number of results in it.
+ *****************************************************************************/
+static void blockReady(const uint32_t *block, uint32_t count)
+{
+  (void)count;
+
+  /*
+   * The frame is analyzed in the main loop, which has until the LDMA has
+   * filled the other half.  A frame still waiting at this point was not
+   * analyzed in time and is dropped.
+   */
+  if (readyBlock != NULL) {
+    framesDropped++;
+  }
+  readyBlock = block;
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Tell if the last report has been sent, down to its last stop bit
+ *****************************************************************************/
+static bool txIdle(void)
+{
+  return !txStarted
+         || (LDMA_TransferDone(TX_LDMA_CHANNEL)
+             && (EUSART0->STATUS & EUSART_STATUS_TXC));
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Send len bytes of txBuffer on EUSART0 by LDMA
+ *
+ * @details
+ *   The descriptor raises no interrupt, txIdle() tells when it is done.
+ *   The channel moves a byte each time the TX FIFO has room.
+ *****************************************************************************/
+static void txStart(uint32_t len)
+{
+  LDMA_TransferCfg_t config =
+    LDMA_TRANSFER_CFG_PERIPHERAL(ldmaPeripheralSignal_EUSART0_TXFL);
+
+  txDescriptor = (LDMA_Descriptor_t)
+    LDMA_DESCRIPTOR_SINGLE_M2P_BYTE(txBuffer, &(EUSART0->TXDATA), len);
+  txDescriptor.xfer.doneIfs = 0;
+
+  txStarted = true;
+  LDMA_StartTransfer(TX_LDMA_CHANNEL, &config, &txDescriptor);
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Band RMS in units of 0.1 mV
+ *****************************************************************************/
+static uint32_t rmsTenthMv(float32_t rms)
+{
+  return (uint32_t)((rms * FULL_SCALE_MV * 10.0f / FULL_SCALE_LSB) + 0.5f);
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Power of a band over its baseline, in units of 0.1 dB
+ *****************************************************************************/
+static int32_t overBaselineTenthDb(const VIB_Axis_t *axis, uint32_t band)
+{
+  float32_t power = axis->rms[band] * axis->rms[band];
+
+  return (int32_t)lroundf(100.0f * log10f(fmaxf(power, VIB_MIN_POWER)
+                                          / axis->baseline[band]));
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Append a signed value in tenths with one decimal
+ *****************************************************************************/
+static int putTenths(char *dst, size_t size, int32_t value)
+{
+  uint32_t magnitude = (value < 0) ? (uint32_t)-value : (uint32_t)value;
+
+  return snprintf(dst, size, " %c%lu.%lu", (value < 0) ? '-' : '+',
+                  (unsigned long)(magnitude / 10),
+                  (unsigned long)(magnitude % 10));
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Unpack and analyze a frame of all the axes
+ *
+ * @details
+ *   Each step is timed with the benchmark kit driver, and the whole frame
+ *   is marked for the Energy Profiler.
+ *
+ * @param[in] block
+ *   The half of the ring to analyze.
+ *
+ * @return
+ *   The bands whose alarm changed, VIB_BANDS bits per axis, axis 0 in the
+ *   lowest bits.
+ *****************************************************************************/
+static uint32_t analyzeFrame(const uint32_t *block)
+{
+  uint32_t changed = 0;
+  uint32_t start, t;
+  uint32_t axis;
+  bool aligned;
+
+  ENERGYMARK_BEGIN(MARKER_FRAME);
+  BENCHMARK_START(start);
+
+  BENCHMARK_START(t);
+  aligned = IADCS_Demux(block, NUM_SAMPLES / 2, NUM_AXES, axisArrays);
+  BENCHMARK_STOP("demux", t, NUM_SAMPLES / 2);
+
+  if (aligned) {
+    for (axis = 0; axis < NUM_AXES; axis++) {
+      BENCHMARK_START(t);
+      VIB_Window(&analyzer, axisData[axis]);
+      BENCHMARK_STOP("window", t, VIB_FFT_SIZE);
+
+      BENCHMARK_START(t);
+      VIB_Transform(&analyzer);
+      BENCHMARK_STOP("fft", t, VIB_FFT_SIZE);
+
+      BENCHMARK_START(t);
+      VIB_Bands(&analyzer, &axes[axis]);
+      BENCHMARK_STOP("bands", t, VIB_FFT_SIZE / 2);
+
+      BENCHMARK_START(t);
+      changed |= VIB_Update(&axes[axis]) << (axis * VIB_BANDS);
+      BENCHMARK_STOP("alarm", t, VIB_BANDS);
+    }
+    frames++;
+  } else {
+    framesMisaligned++;
+  }
+
+  BENCHMARK_STOP("frame", start, NUM_SAMPLES / 2);
+  ENERGYMARK_END(MARKER_FRAME);
+
+  return changed;
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Write a line for each alarm raised or cleared by the last frame
+ *
+ * @return
+ *   Length of the text.
+ *****************************************************************************/
+static uint32_t formatAlarms(char *dst, size_t size, uint32_t changed)
+{
+  const VIB_Axis_t *a;
+  uint32_t axis, band, bit;
+  size_t len = 0;
+
+  for (axis = 0; axis < NUM_AXES; axis++) {
+    a = &axes[axis];
+    for (band = 0; band < VIB_BANDS; band++) {
+      bit = 1UL << (axis * VIB_BANDS + band);
+      if (((changed & bit) == 0) || (len >= size)) {
+        continue;
+      }
+      len += snprintf(&dst[len], size - len, "%s axis %lu %s",
+                      (a->alarms & (1UL << band)) ? "ALARM" : "clear",
+                      (unsigned long)axis, bandNames[band]);
+      if (len < size) {
+        len += putTenths(&dst[len], size - len, overBaselineTenthDb(a, band));
+      }
+      if (len < size) {
+        len += snprintf(&dst[len], size - len, " dB\r\n");
+      }
+    }
+  }
+
+  return (len < size) ? len : (size - 1);
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Work out the budget of a frame from the benchmark results
+ *
+ * @details
+ *   The highest sample rate is the one at which the slowest frame takes
+ *   all of the frame time, or the IADC limit if that is lower.  The energy
+ *   of a frame is the charge drawn while the frame marker is high and in
+ *   EM2 for the rest of the frame time, times the supply voltage.
+ *****************************************************************************/
+static void updateBudget(const BENCHMARK_Entry_t *frame)
+{
+  uint32_t clock = SystemCoreClockGet();
+  uint64_t frameTimeUs = (1000000ULL * VIB_FFT_SIZE) / SAMPLE_RATE;
+  uint64_t activeUs, rate;
+
+  frameCycles = (uint32_t)(frame->total / frame->runs);
+  frameCyclesMax = frame->max;
+
+  loadPermyriad = (uint32_t)(((uint64_t)frameCycles * SAMPLE_RATE * 10000)
+                             / ((uint64_t)clock * VIB_FFT_SIZE));
+
+  rate = ((uint64_t)clock * VIB_FFT_SIZE) / SL_MAX(frameCyclesMax, 1UL);
+  maxSampleRate = (uint32_t)SL_MIN(rate, (uint64_t)IADC_MAX_RATE);
+
+  // mV * uA * us is fJ
+  activeUs = ((uint64_t)frameCycles * 1000000) / clock;
+  if ((activeCurrent > 0) && (sleepCurrent > 0) && (activeUs < frameTimeUs)) {
+    frameEnergyNj = (uint32_t)((SUPPLY_MV
+                                * ((activeCurrent * activeUs)
+                                   + (sleepCurrent * (frameTimeUs - activeUs))))
+                               / 1000000);
+  } else {
+    frameEnergyNj = 0;
+  }
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Write the report: the band RMS and level of each axis and the cycle
+ *   and energy budget of a frame since the last report
+ *
+ * @return
+ *   Length of the text.
+ *****************************************************************************/
+static uint32_t formatReport(char *dst, size_t size)
+{
+  const BENCHMARK_Entry_t *e;
+  const BENCHMARK_Entry_t *frame = NULL;
+  const VIB_Axis_t *a;
+  uint32_t axis, band;
+  unsigned int i;
+  size_t len;
+
+  len = snprintf(dst, size, "\r\nframe %lu%s\r\n", (unsigned long)frames,
+                 VIB_IsLearning(&axes[0]) ? ", learning the baseline" : "");
+
+  for (axis = 0; (axis < NUM_AXES) && (len < size); axis++) {
+    a = &axes[axis];
+    len += snprintf(&dst[len], size - len, "axis %lu mV", (unsigned long)axis);
+    for (band = 0; (band < VIB_BANDS) && (len < size); band++) {
+      uint32_t rms = rmsTenthMv(a->rms[band]);
+      len += snprintf(&dst[len], size - len, " %lu.%lu",
+                      (unsigned long)(rms / 10), (unsigned long)(rms % 10));
+    }
+    if (!VIB_IsLearning(a) && (len < size)) {
+      len += snprintf(&dst[len], size - len, ", dB");
+      for (band = 0; (band < VIB_BANDS) && (len < size); band++) {
+        len += putTenths(&dst[len], size - len, overBaselineTenthDb(a, band));
+      }
+    }
+    if (len < size) {
+      len += snprintf(&dst[len], size - len, ", alarms 0x%lx\r\n",
+                      (unsigned long)a->alarms);
+    }
+  }
+
+  // Average cycles per run of each step, the per axis steps run twice
+  if (len < size) {
+    len += snprintf(&dst[len], size - len, "cycles");
+  }
+  for (i = 0; (i < BENCHMARK_Count()) && (len < size); i++) {
+    e = BENCHMARK_Get(i);
+    len += snprintf(&dst[len], size - len, " %s %lu", e->name,
+                    (unsigned long)(e->total / e->runs));
+    if (strcmp(e->name, "frame") == 0) {
+      frame = e;
+    }
+  }
+
+  if (frame != NULL) {
+    updateBudget(frame);
+    if (len < size) {
+      len += snprintf(&dst[len], size - len,
+                      ", max %lu\r\nload %lu.%02lu%% at %lu MHz,"
+                      " up to %lu sps per axis\r\n",
+                      (unsigned long)frameCyclesMax,
+                      (unsigned long)(loadPermyriad / 100),
+                      (unsigned long)(loadPermyriad % 100),
+                      (unsigned long)(SystemCoreClockGet() / 1000000),
+                      (unsigned long)maxSampleRate);
+    }
+    if (len < size) {
+      if (frameEnergyNj > 0) {
+        len += snprintf(&dst[len], size - len, "energy %lu.%03lu uJ per frame\r\n",
+                        (unsigned long)(frameEnergyNj / 1000),
+                        (unsigned long)(frameEnergyNj % 1000));
+      } else {
+        len += snprintf(&dst[len], size - len,
+                        "energy: enter activeCurrent and sleepCurrent\r\n");
+      }
+    }
+  }
+
+  // The next report covers the frames from here
+  BENCHMARK_Reset();
+
+  return (len < size) ? len : (size - 1);
+}
+
+/**************************************************************************//**
+ * @brief  Main function
+ *****************************************************************************/
+int main(void)
+{
+  uint32_t changed, analyzed, len;
+  const uint32_t *block;
+  bool report;
+
+  CHIP_Init();
+
+  initGPIO();
+
+  initEUSART0();
+
+  initIADC();
+
+  // Cycle counter for the budget, and the Energy Profiler markers
+  BENCHMARK_Init();
+  ENERGYMARK_Init();
+
+  if (!VIB_Init(&analyzer, SAMPLE_RATE, bandEdges)) {
+    // The band edges do not fit the FFT, see bandEdges
+    __BKPT(0);
+  }
+
+#ifdef EM2DEBUG
+#if (EM2DEBUG == 1)
+  // Enable debug connectivity in EM2
+  EMU->CTRL_SET = EMU_CTRL_EM2DBGEN;
+#endif
+#endif
+
+  // IADCS_Init() initializes the LDMA, the report channel is set up after
+  IADCS_Init(scanBuffer, NUM_SAMPLES, blockReady);
+
+  // Start the scan and the IADC timer that triggers it
+  IADC_command(IADC0, iadcCmdStartScan);
+  IADC_command(IADC0, iadcCmdEnableTimer);
+
+  while (1) {
+    CORE_DECLARE_IRQ_STATE;
+
+    /*
+     * Sleep until a frame is ready, checking with interrupts masked so a
+     * frame that is ready just now does not wait for the next.  EUSART0
+     * only runs in EM1, so EM2 waits until the last text has been sent.
+     */
+    CORE_ENTER_CRITICAL();
+    if (readyBlock == NULL) {
+      if (txIdle()) {
+        EMU_EnterEM2(true);
+      } else {
+        EMU_EnterEM1();
+      }
+    }
+    block = readyBlock;
+    readyBlock = NULL;
+    CORE_EXIT_CRITICAL();
+
+    // Halves the LDMA interrupt itself was too late for
+    halvesMissed = IADCS_GetDroppedCount();
+
+    if (block == NULL) {
+      continue;
+    }
+
+    analyzed = frames;
+    changed = analyzeFrame(block);
+    report = (frames != analyzed) && ((frames % REPORT_FRAMES) == 0);
+
+    if ((axes[0].alarms | axes[1].alarms) != 0) {
+      GPIO_PinOutSet(BSP_GPIO_LED0_PORT, BSP_GPIO_LED0_PIN);
+    } else {
+      GPIO_PinOutClear(BSP_GPIO_LED0_PORT, BSP_GPIO_LED0_PIN);
+    }
+
+    if ((changed == 0) && !report) {
+      continue;
+    }
+
+    // The texts of this frame go out together, once the last ones are out
+    if (!txIdle()) {
+      textsDropped++;
+      continue;
+    }
+
+    len = formatAlarms(txBuffer, sizeof(txBuffer), changed);
+    if (report) {
+      len += formatReport(&txBuffer[len], sizeof(txBuffer) - len);
+    }
+    if (len > 0) {
+      txStart(len);
+    }
+  }
+}
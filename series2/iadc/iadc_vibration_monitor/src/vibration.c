@@ -0,0 +1,235 @@
+/***************************************************************************//**
+ * @file vibration.c
+ *
+ * @brief Band energy features and threshold alarms of vibration frames.
+ *
+ * Each frame of one axis has its mean removed, is multiplied by a Hann
+ * window and goes through a real FFT with CMSIS-DSP. The power of the
+ * bins in each band, scaled by Parseval's theorem, gives the RMS of the
+ * signal in that band. The first VIB_LEARN_FRAMES frames of each axis set
+ * the baseline of its bands, and later frames raise and clear an alarm per
+ * band against it, with hysteresis and a debounce of a few frames.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2021 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ *******************************************************************************
+ * # Evaluation Quality
+ * This code has been minimally tested to ensure that it builds and is suitable 
+ * as a demonstration for evaluation purposes only. This code will be maintained
+ * at the sole discretion of Silicon Labs.
+ ******************************************************************************/
+
+#include <math.h>
+
+#include "vibration.h"
+
+/**************************************************************************//**
+ * @brief
+ *   Set up the window, the FFT and the bins of each band
+ *
+ * @param[out] vib
+ *   Analyzer state.
+ *
+ * @param[in] sampleRate
+ *   Samples per second of each axis.
+ *
+ * @param[in] edges
+ *   VIB_BANDS + 1 band edges in Hz, rising, band n from edges[n] up to
+ *   edges[n + 1]. The last edge is at most sampleRate / 2.
+ *
+ * @return
+ *   false if the edges do not give each band at least one bin.
+ *****************************************************************************/
+bool VIB_Init(VIB_Analyzer_t *vib, float32_t sampleRate, const float32_t *edges)
+{
+  float32_t binHz = sampleRate / VIB_FFT_SIZE;
+  float32_t sumSquares = 0.0f;
+  uint32_t i, bin;
+
+  if (arm_rfft_fast_init_f32(&vib->rfft, VIB_FFT_SIZE) != ARM_MATH_SUCCESS) {
+    return false;
+  }
+
+  /*
+   * Periodic Hann window, which has no gap at the frame boundary, so the
+   * frames could overlap by half with no ripple. The mean square of the
+   * windowed frame is that of the frame times the mean of the squared
+   * window, which the scale takes out again.
+   */
+  for (i = 0; i < VIB_FFT_SIZE; i++) {
+    vib->window[i] = 0.5f - 0.5f * cosf(2.0f * PI * i / VIB_FFT_SIZE);
+    sumSquares += vib->window[i] * vib->window[i];
+  }
+
+  /*
+   * A bin holds half of the power of its frequency, the other half is in
+   * the negative frequency bin, so the one sided sum counts twice. The
+   * FFT is unscaled: Parseval's theorem divides the sum of |X|^2 by
+   * VIB_FFT_SIZE^2, and the window takes sumSquares / VIB_FFT_SIZE.
+   */
+  vib->scale = 2.0f / (VIB_FFT_SIZE * sumSquares);
+
+  // Bin 0 is the mean, removed before the FFT, and VIB_FFT_SIZE / 2 the
+  // Nyquist frequency, packed in the imaginary part of bin 0
+  for (i = 0; i <= VIB_BANDS; i++) {
+    bin = (uint32_t)ceilf(edges[i] / binHz);
+    if (bin < 1) {
+      bin = 1;
+    }
+    if (bin > VIB_FFT_SIZE / 2) {
+      return false;
+    }
+    if ((i > 0) && (bin <= vib->bandBin[i - 1])) {
+      return false;
+    }
+    vib->bandBin[i] = (uint16_t)bin;
+  }
+
+  return true;
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Remove the mean of a frame and window it into the FFT input
+ *
+ * @param[in,out] vib
+ *   Analyzer state, the frame is written to vib->frame.
+ *
+ * @param[in] samples
+ *   VIB_FFT_SIZE results of one axis, as unpacked by IADCS_Demux().
+ *****************************************************************************/
+void VIB_Window(VIB_Analyzer_t *vib, const uint16_t *samples)
+{
+  uint32_t sum = 0;
+  float32_t mean;
+  uint32_t i;
+
+  for (i = 0; i < VIB_FFT_SIZE; i++) {
+    sum += samples[i];
+  }
+  mean = (float32_t)sum / VIB_FFT_SIZE;
+
+  for (i = 0; i < VIB_FFT_SIZE; i++) {
+    vib->frame[i] = ((float32_t)samples[i] - mean) * vib->window[i];
+  }
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Real FFT of the windowed frame into vib->spectrum
+ *
+ * @note
+ *   arm_rfft_fast_f32() uses the frame as scratch space.
+ *****************************************************************************/
+void VIB_Transform(VIB_Analyzer_t *vib)
+{
+  arm_rfft_fast_f32(&vib->rfft, vib->frame, vib->spectrum, 0);
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Reduce the spectrum to the RMS of each band
+ *
+ * @param[in] vib
+ *   Analyzer state with the spectrum of the frame.
+ *
+ * @param[out] axis
+ *   Axis the frame was taken from, its rms[] is written.
+ *****************************************************************************/
+void VIB_Bands(VIB_Analyzer_t *vib, VIB_Axis_t *axis)
+{
+  const float32_t *bin;
+  float32_t power;
+  uint32_t band, k;
+
+  for (band = 0; band < VIB_BANDS; band++) {
+    power = 0.0f;
+    bin = &vib->spectrum[2 * vib->bandBin[band]];
+    for (k = vib->bandBin[band]; k < vib->bandBin[band + 1]; k++) {
+      power += (bin[0] * bin[0]) + (bin[1] * bin[1]);
+      bin += 2;
+    }
+    axis->rms[band] = sqrtf(power * vib->scale);
+  }
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Learn the baseline, then update the alarms with the last frame
+ *
+ * @param[in,out] axis
+ *   Axis with the band RMS of its last frame from VIB_Bands().
+ *
+ * @return
+ *   The bands whose alarm was raised or cleared by this frame, one bit per
+ *   band. The alarms now set are in axis->alarms.
+ *****************************************************************************/
+uint32_t VIB_Update(VIB_Axis_t *axis)
+{
+  uint32_t changed = 0;
+  float32_t power;
+  uint32_t band, mask;
+  bool past;
+
+  for (band = 0; band < VIB_BANDS; band++) {
+    power = axis->rms[band] * axis->rms[band];
+    mask = 1UL << band;
+
+    if (axis->frames < VIB_LEARN_FRAMES) {
+      axis->baseline[band] += power / VIB_LEARN_FRAMES;
+      if (axis->frames == (VIB_LEARN_FRAMES - 1)) {
+        axis->baseline[band] = fmaxf(axis->baseline[band], VIB_MIN_POWER);
+      }
+      continue;
+    }
+
+    if (axis->alarms & mask) {
+      past = power < (axis->baseline[band] * VIB_CLEAR_RATIO);
+    } else {
+      past = power > (axis->baseline[band] * VIB_ALARM_RATIO);
+    }
+
+    // Only a level passed in every frame of a row changes the alarm
+    axis->count[band] = past ? (axis->count[band] + 1) : 0;
+    if (axis->count[band] >= VIB_ALARM_FRAMES) {
+      axis->count[band] = 0;
+      axis->alarms ^= mask;
+      changed |= mask;
+    }
+  }
+
+  axis->frames++;
+
+  return changed;
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Tell if the axis is still learning its baseline
+ *****************************************************************************/
+bool VIB_IsLearning(const VIB_Axis_t *axis)
+{
+  return axis->frames < VIB_LEARN_FRAMES;
+}
@@ -32,6 +32,9 @@
 #ifndef BSPCONFIG_H
 #define BSPCONFIG_H
 
+/* Tuned settings, selected with BSP_PERFORMANCE */
+#include "bspperfconfig.h"
+
 #define BSP_STK
 #define BSP_WSTK
 #define BSP_WSTK_BRD4186A
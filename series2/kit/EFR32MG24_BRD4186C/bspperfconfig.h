@@ -0,0 +1,118 @@
+/***************************************************************************//**
+ * @file
+ * @brief Performance profile of the board configuration.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2022 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ******************************************************************************/
+
+#ifndef BSPPERFCONFIG_H
+#define BSPPERFCONFIG_H
+
+/***************************************************************************//**
+ *
+ * The configuration headers of this board, bspconfig.h,
+ * retargetserialconfig.h and mx25flash_config.h, keep the conservative
+ * defaults of the drivers. Defining BSP_PERFORMANCE to 1 in the project
+ * selects the tuned settings below for all of them at once:
+ *
+ * +----------------------------------------------------------------------+
+ * | Setting           | Default             | BSP_PERFORMANCE            |
+ * |----------------------------------------------------------------------+
+ * | retargetserial    | 115200 baud, IRQ    | 921600 baud, LDMA TX and   |
+ * |                   | RX, 8 byte RX buf.  | RX, 1024/512 byte buffers  |
+ * | mx25flash_spi     | 8 MHz, CPU driven   | PCLK / 2, LDMA transfers   |
+ * | Clocks            | 19 MHz HFRCODPLL    | BSP_PERF_CLKPROFILE, 78    |
+ * |                   |                     | MHz DPLL locked to HFXO    |
+ * | Hot code          | flash               | BSP_PERF_RAMFUNC_* in RAM  |
+ * +----------------------------------------------------------------------+
+ *
+ * Any of the settings can still be overridden in the project, as each is
+ * only defined here when it is not defined yet. The LDMA channels of the
+ * two drivers are the top four channels, see retargetserial.c and
+ * mx25flash_spi.c.
+ *
+ ******************************************************************************/
+
+#ifndef BSP_PERFORMANCE
+#define BSP_PERFORMANCE           0
+#endif
+
+#if (BSP_PERFORMANCE == 1)
+
+/* retargetserial: the VCOM of the board controller runs at up to 921600
+ * baud. */
+#if !defined(RETARGET_BAUDRATE)
+#define RETARGET_BAUDRATE         921600
+#endif
+#if !defined(RETARGET_TX_DMA)
+#define RETARGET_TX_DMA
+#endif
+#if !defined(RETARGET_RX_DMA)
+#define RETARGET_RX_DMA
+#endif
+#if !defined(RETARGET_TXBUFSIZE)
+#define RETARGET_TXBUFSIZE        1024
+#endif
+#if !defined(RXBUFSIZE)
+#define RXBUFSIZE                 512
+#endif
+
+/* mx25flash_spi: the USART runs the SPI clock at up to PCLK / 2, so asking
+ * for more than the 33 MHz of the MX25R8035F in its low power mode gives
+ * the highest rate the clock allows, 19.5 MHz with the compute profile. */
+#if !defined(MX25_BAUDRATE)
+#define MX25_BAUDRATE             33000000
+#endif
+#if !defined(MX25_USE_LDMA)
+#define MX25_USE_LDMA
+#endif
+
+/* Clocks: the profile of the clkprofile kit driver (kit/common/clkprofile)
+ * to run from, set up with CMU_HFXOINIT_WSTK_DEFAULT of bspconfig.h:
+ *
+ *   CMU_HFXOInit_TypeDef hfxoInit = CMU_HFXOINIT_WSTK_DEFAULT;
+ *   CLKPROFILE_Init(&hfxoInit);
+ *   CLKPROFILE_Set(BSP_PERF_CLKPROFILE);
+ */
+#if !defined(BSP_PERF_CLKPROFILE)
+#define BSP_PERF_CLKPROFILE       clkprofileCompute
+#endif
+
+/* Hot code: functions defined between BSP_PERF_RAMFUNC_BEGIN and
+ * BSP_PERF_RAMFUNC_END run from RAM with no flash wait states. They must
+ * not call functions in flash, or they wait for the flash after all. */
+#include "em_ramfunc.h"
+#define BSP_PERF_RAMFUNC_BEGIN    SL_RAMFUNC_DEFINITION_BEGIN
+#define BSP_PERF_RAMFUNC_END      SL_RAMFUNC_DEFINITION_END
+
+#else
+
+#define BSP_PERF_RAMFUNC_BEGIN
+#define BSP_PERF_RAMFUNC_END
+
+#endif /* BSP_PERFORMANCE */
+
+#endif /* BSPPERFCONFIG_H */
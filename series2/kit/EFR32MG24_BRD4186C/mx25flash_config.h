@@ -33,6 +33,7 @@
 
 #include "em_device.h"
 #include "em_gpio.h"
+#include "bspperfconfig.h"
 
 #define MX25_PORT_MOSI         gpioPortC
 #define MX25_PIN_MOSI          1
@@ -47,4 +48,8 @@
 #define MX25_USART_ROUTE       GPIO->USARTROUTE[0]
 #define MX25_USART_CLK         cmuClock_USART0
 
+/* LDMA request signals used when MX25_USE_LDMA is defined */
+#define MX25_LDMA_RX_SIGNAL    ldmaPeripheralSignal_USART0_RXDATAV
+#define MX25_LDMA_TX_SIGNAL    ldmaPeripheralSignal_USART0_TXBL
+
 #endif // MX25CONFIG_H
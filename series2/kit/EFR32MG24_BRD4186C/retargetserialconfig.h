@@ -32,6 +32,7 @@
 #define RETARGETSERIALCONFIG_H
 
 #include "bsp.h"
+#include "bspperfconfig.h"
 
 /***************************************************************************//**
  *
@@ -74,6 +75,8 @@
   #define RETARGET_RXPORT      gpioPortA                    /* UART reception port */
   #define RETARGET_RXPIN       9                            /* UART reception pin */
   #define RETARGET_USART       1                            /* Includes em_usart.h */
+  #define RETARGET_TX_LDMA_SIGNAL  ldmaPeripheralSignal_USART0_TXBL /* RETARGET_TX_DMA request */
+  #define RETARGET_RX_LDMA_SIGNAL  ldmaPeripheralSignal_USART0_RXDATAV /* RETARGET_RX_DMA request */
 #elif defined(RETARGET_USART1)
   #define RETARGET_IRQ_NAME    USART1_RX_IRQHandler         /* UART IRQ Handler */
   #define RETARGET_CLK         cmuClock_USART1              /* HFPER Clock */
@@ -87,6 +90,8 @@
   #define RETARGET_RXPORT      gpioPortA                    /* UART reception port */
   #define RETARGET_RXPIN       9                            /* UART reception pin */
   #define RETARGET_USART       1                            /* Includes em_usart.h */
+  #define RETARGET_TX_LDMA_SIGNAL  ldmaPeripheralSignal_USART1_TXBL /* RETARGET_TX_DMA request */
+  #define RETARGET_RX_LDMA_SIGNAL  ldmaPeripheralSignal_USART1_RXDATAV /* RETARGET_RX_DMA request */
 #else
 #error "Illegal USART selection."
 #endif
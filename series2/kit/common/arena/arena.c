@@ -0,0 +1,307 @@
+/***************************************************************************//**
+ * @file
+ * @brief Deterministic arena and fixed-block pool allocator.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2022 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ******************************************************************************/
+
+
+#include "em_core.h"
+#include "arena.h"
+
+/***************************************************************************//**
+ * @addtogroup kitdrv
+ * @{
+ ******************************************************************************/
+
+/***************************************************************************//**
+ * @addtogroup Arena
+ * @{
+ ******************************************************************************/
+
+/***************************************************************************//**
+ * @brief
+ *   Bytes from the arena's fill level to the next multiple of align.
+ ******************************************************************************/
+static size_t padding(const ARENA_Arena_t *arena, size_t align)
+{
+  uintptr_t next = (uintptr_t)arena->base + arena->used;
+
+  return (size_t)((align - (next & (align - 1))) & (align - 1));
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Make an arena over a block of memory.
+ *
+ * @param[in] arena
+ *   Arena to initialize.
+ *
+ * @param[in] memory
+ *   Memory the arena hands out, owned by the arena from now on.
+ *
+ * @param[in] size
+ *   Bytes of memory.
+ ******************************************************************************/
+void ARENA_Init(ARENA_Arena_t *arena, void *memory, size_t size)
+{
+  arena->base = (uint8_t *)memory;
+  arena->size = size;
+  arena->used = 0;
+  arena->peak = 0;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Allocate from an arena.
+ *
+ * @param[in] arena
+ *   Arena.
+ *
+ * @param[in] size
+ *   Bytes to allocate, not cleared.
+ *
+ * @param[in] align
+ *   Alignment of the block, a power of two, or 0 for ARENA_ALIGN_DEFAULT.
+ *
+ * @return
+ *   The block, or NULL if the arena has not enough memory left.
+ ******************************************************************************/
+void *ARENA_Alloc(ARENA_Arena_t *arena, size_t size, size_t align)
+{
+  size_t pad;
+  void *block;
+
+  if (align == 0) {
+    align = ARENA_ALIGN_DEFAULT;
+  }
+  if ((align & (align - 1)) != 0) {
+    return NULL;
+  }
+
+  pad = padding(arena, align);
+  if ((pad > (arena->size - arena->used))
+      || (size > (arena->size - arena->used - pad))) {
+    return NULL;
+  }
+
+  block = arena->base + arena->used + pad;
+  arena->used += pad + size;
+  if (arena->used > arena->peak) {
+    arena->peak = arena->used;
+  }
+
+  return block;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Record the fill level of an arena, for ARENA_Release().
+ ******************************************************************************/
+ARENA_Mark_t ARENA_Mark(const ARENA_Arena_t *arena)
+{
+  return arena->used;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Free everything allocated since a mark.
+ *
+ * @details
+ *   Pools made after the mark are freed with their blocks and must not be
+ *   used any more. A mark above the fill level does nothing.
+ *
+ * @param[in] arena
+ *   Arena.
+ *
+ * @param[in] mark
+ *   Fill level from ARENA_Mark().
+ ******************************************************************************/
+void ARENA_Release(ARENA_Arena_t *arena, ARENA_Mark_t mark)
+{
+  if (mark < arena->used) {
+    arena->used = mark;
+  }
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Free everything the arena has handed out.
+ ******************************************************************************/
+void ARENA_Reset(ARENA_Arena_t *arena)
+{
+  arena->used = 0;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Largest block ARENA_Alloc() can allocate with an alignment.
+ *
+ * @param[in] arena
+ *   Arena.
+ *
+ * @param[in] align
+ *   Alignment, a power of two, or 0 for ARENA_ALIGN_DEFAULT.
+ ******************************************************************************/
+size_t ARENA_Available(const ARENA_Arena_t *arena, size_t align)
+{
+  size_t pad;
+
+  pad = padding(arena, (align == 0) ? ARENA_ALIGN_DEFAULT : align);
+  if (pad > (arena->size - arena->used)) {
+    return 0;
+  }
+
+  return arena->size - arena->used - pad;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Carve a pool of fixed size blocks from an arena.
+ *
+ * @details
+ *   Takes count blocks from the arena at once. The pool lives until the
+ *   arena is released below it.
+ *
+ * @param[in] pool
+ *   Pool to initialize.
+ *
+ * @param[in] arena
+ *   Arena the blocks are taken from.
+ *
+ * @param[in] blockSize
+ *   Bytes per block, rounded up to the alignment and to hold a pointer.
+ *
+ * @param[in] count
+ *   Blocks.
+ *
+ * @param[in] align
+ *   Alignment of each block, a power of two, or 0 for
+ *   ARENA_ALIGN_DEFAULT.
+ *
+ * @return
+ *   true if the arena had room for all blocks.
+ ******************************************************************************/
+bool ARENA_PoolInit(ARENA_Pool_t *pool, ARENA_Arena_t *arena,
+                    size_t blockSize, uint32_t count, size_t align)
+{
+  ARENA_Free_t *block;
+  uint32_t i;
+
+  if (align == 0) {
+    align = ARENA_ALIGN_DEFAULT;
+  }
+  if (align < sizeof(void *)) {
+    align = sizeof(void *);
+  }
+  if ((count == 0) || ((align & (align - 1)) != 0)) {
+    return false;
+  }
+
+  blockSize = (blockSize + align - 1) & ~(align - 1);
+  if ((blockSize == 0) || (count > (SIZE_MAX / blockSize))) {
+    return false;
+  }
+
+  pool->base = ARENA_Alloc(arena, blockSize * count, align);
+  if (pool->base == NULL) {
+    return false;
+  }
+
+  pool->blockSize = blockSize;
+  pool->count = count;
+  pool->used = 0;
+  pool->peak = 0;
+
+  // Chain all blocks in address order
+  pool->free = NULL;
+  for (i = count; i > 0; i--) {
+    block = (ARENA_Free_t *)(pool->base + (i - 1) * blockSize);
+    block->next = pool->free;
+    pool->free = block;
+  }
+
+  return true;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Take a block from a pool.
+ *
+ * @return
+ *   The block, not cleared, or NULL if all blocks are in use.
+ ******************************************************************************/
+void *ARENA_PoolAlloc(ARENA_Pool_t *pool)
+{
+  CORE_DECLARE_IRQ_STATE;
+  ARENA_Free_t *block;
+
+  CORE_ENTER_ATOMIC();
+  block = pool->free;
+  if (block != NULL) {
+    pool->free = block->next;
+    pool->used++;
+    if (pool->used > pool->peak) {
+      pool->peak = pool->used;
+    }
+  }
+  CORE_EXIT_ATOMIC();
+
+  return block;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Give a block back to its pool.
+ *
+ * @param[in] pool
+ *   Pool the block came from.
+ *
+ * @param[in] block
+ *   Block from ARENA_PoolAlloc(). NULL and blocks of other pools are
+ *   ignored.
+ ******************************************************************************/
+void ARENA_PoolFree(ARENA_Pool_t *pool, void *block)
+{
+  CORE_DECLARE_IRQ_STATE;
+  uintptr_t offset = (uintptr_t)block - (uintptr_t)pool->base;
+
+  if ((block == NULL)
+      || ((uintptr_t)block < (uintptr_t)pool->base)
+      || (offset >= (uintptr_t)pool->blockSize * pool->count)
+      || ((offset % pool->blockSize) != 0)) {
+    return;
+  }
+
+  CORE_ENTER_ATOMIC();
+  ((ARENA_Free_t *)block)->next = pool->free;
+  pool->free = (ARENA_Free_t *)block;
+  pool->used--;
+  CORE_EXIT_ATOMIC();
+}
+
+/** @} (end group Arena) */
+/** @} (end group kitdrv) */
@@ -0,0 +1,126 @@
+/***************************************************************************//**
+ * @file
+ * @brief Deterministic arena and fixed-block pool allocator.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2022 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ******************************************************************************/
+
+
+#ifndef __ARENA_H
+#define __ARENA_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/***************************************************************************//**
+ * @addtogroup kitdrv
+ * @{
+ ******************************************************************************/
+
+/***************************************************************************//**
+ * @addtogroup Arena
+ * @brief Deterministic arena and fixed-block pool allocator
+ * @details
+ *    Run time sized buffers for drivers and examples, drawn from one block
+ *    of memory the application provides, instead of a global array sized
+ *    for the largest case of each feature. Features that never run at the
+ *    same time share the memory.
+ *
+ *    An arena hands out memory from the bottom up. ARENA_Mark() records
+ *    the fill level, ARENA_Release() frees everything allocated after the
+ *    mark at once, so a mode allocates its buffers after a mark and frees
+ *    them all when it ends. ARENA_Reset() frees the whole arena. There is
+ *    no per block free and no fragmentation; every call takes constant
+ *    time.
+ *
+ *    A pool is carved from an arena once and hands out fixed size blocks,
+ *    such as DMA buffers, in constant time and in any order. The blocks
+ *    are aligned as requested, ARENA_ALIGN_DMA suits every LDMA transfer
+ *    size. ARENA_PoolAlloc() and ARENA_PoolFree() may be called from
+ *    interrupt handlers; the arena functions may not.
+ *
+ *    The memory can be any RAM, for instance a static array or a block
+ *    from NORETAIN_Alloc().
+ * @{
+ ******************************************************************************/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Alignment for any scalar type */
+#define ARENA_ALIGN_DEFAULT   8U
+
+/** Alignment for DMA buffers: word transfers of the LDMA */
+#define ARENA_ALIGN_DMA       4U
+
+/** Arena over a block of memory */
+typedef struct {
+  uint8_t *base;          /**< First byte */
+  size_t  size;           /**< Bytes */
+  size_t  used;           /**< Bytes allocated, including alignment */
+  size_t  peak;           /**< Highest fill level since ARENA_Init() */
+} ARENA_Arena_t;
+
+/** Fill level of an arena, from ARENA_Mark() */
+typedef size_t ARENA_Mark_t;
+
+/** Free block of a pool, linked through the block itself */
+typedef struct ARENA_Free {
+  struct ARENA_Free *next;
+} ARENA_Free_t;
+
+/** Pool of fixed size blocks */
+typedef struct {
+  ARENA_Free_t      *free;        /**< First free block */
+  uint8_t           *base;        /**< First block */
+  size_t            blockSize;    /**< Bytes per block, including padding */
+  uint32_t          count;        /**< Blocks */
+  volatile uint32_t used;         /**< Blocks allocated */
+  uint32_t          peak;         /**< Highest used since the pool was made */
+} ARENA_Pool_t;
+
+void         ARENA_Init(ARENA_Arena_t *arena, void *memory, size_t size);
+void         *ARENA_Alloc(ARENA_Arena_t *arena, size_t size, size_t align);
+ARENA_Mark_t ARENA_Mark(const ARENA_Arena_t *arena);
+void         ARENA_Release(ARENA_Arena_t *arena, ARENA_Mark_t mark);
+void         ARENA_Reset(ARENA_Arena_t *arena);
+size_t       ARENA_Available(const ARENA_Arena_t *arena, size_t align);
+
+bool         ARENA_PoolInit(ARENA_Pool_t *pool, ARENA_Arena_t *arena,
+                            size_t blockSize, uint32_t count, size_t align);
+void         *ARENA_PoolAlloc(ARENA_Pool_t *pool);
+void         ARENA_PoolFree(ARENA_Pool_t *pool, void *block);
+
+#ifdef __cplusplus
+}
+#endif
+
+/** @} (end group Arena) */
+/** @} (end group kitdrv) */
+
+#endif
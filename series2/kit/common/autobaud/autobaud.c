@@ -0,0 +1,364 @@
+/***************************************************************************//**
+ * @file
+ * @brief Asynchronous EUSART automatic baud rate detection with a cached rate.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2022 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ******************************************************************************/
+
+#include <stddef.h>
+#include "em_cmu.h"
+#include "em_core.h"
+#if defined(AUTOBAUD_STORAGE_USERDATA)
+#include "em_msc.h"
+#endif
+#include "autobaud.h"
+
+/***************************************************************************//**
+ * @addtogroup kitdrv
+ * @{
+ ******************************************************************************/
+
+/***************************************************************************//**
+ * @addtogroup Autobaud
+ * @{
+ ******************************************************************************/
+
+// The rate is stored next to a copy XOR'ed with this, so erased flash or
+// random retention register contents are not taken for a rate
+#define STORE_MAGIC       0xA5C35A3CUL
+
+// Stored or detected rates outside this range are not used
+#define MIN_BAUDRATE      300
+#define MAX_BAUDRATE      4000000
+
+// Detected rates within this many percent of a standard rate are rounded
+#define SNAP_PERCENT      3
+
+#if defined(AUTOBAUD_STORAGE_USERDATA)
+#if !defined(USERDATA_BASE) || !defined(USERDATA_SIZE)
+#error "This device has no USERDATA page"
+#endif
+
+// The USERDATA page as a log of two word entries, the last one is current
+#define LOG             ((uint32_t *)USERDATA_BASE)
+#define LOG_ENTRIES     (USERDATA_SIZE / 8)
+#endif
+
+static const uint32_t standardRates[] = {
+  1200, 2400, 4800, 9600, 14400, 19200, 28800, 38400, 57600,
+  115200, 230400, 460800, 921600, 1000000, 2000000, 3000000
+};
+
+static EUSART_TypeDef           *eusart;
+static EUSART_UartInit_TypeDef  config;
+static AUTOBAUD_Callback_t      lockCallback;
+static volatile bool            locked;
+static volatile uint32_t        baudrate;
+static uint32_t                 ferrCount;
+
+/***************************************************************************//**
+ * @brief
+ *   Check a stored rate against its copy and the supported range
+ ******************************************************************************/
+static bool isValid(uint32_t rate, uint32_t check)
+{
+  return (check == (rate ^ STORE_MAGIC))
+         && (rate >= MIN_BAUDRATE)
+         && (rate <= MAX_BAUDRATE);
+}
+
+#if defined(AUTOBAUD_STORAGE_USERDATA)
+/***************************************************************************//**
+ * @brief
+ *   Find the first erased log entry, LOG_ENTRIES if the log is full
+ ******************************************************************************/
+static uint32_t logEnd(void)
+{
+  uint32_t i;
+
+  for (i = 0; i < LOG_ENTRIES; i++) {
+    if ((LOG[2 * i] == 0xFFFFFFFFUL) && (LOG[2 * i + 1] == 0xFFFFFFFFUL)) {
+      break;
+    }
+  }
+  return i;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Get the stored rate, 0 if there is none
+ ******************************************************************************/
+static uint32_t loadRate(void)
+{
+  uint32_t end = logEnd();
+
+  if ((end > 0) && isValid(LOG[2 * end - 2], LOG[2 * end - 1])) {
+    return LOG[2 * end - 2];
+  }
+  return 0;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Append a rate to the log, 0 marks the stored rate invalid. The page is
+ *   erased and the log starts over when it is full.
+ ******************************************************************************/
+static void storeRate(uint32_t rate)
+{
+  uint32_t entry[2] = { rate, rate ^ STORE_MAGIC };
+  uint32_t end = logEnd();
+
+  // Skip the write if the last entry already holds this rate
+  if ((end > 0) && (LOG[2 * end - 2] == entry[0]) && (LOG[2 * end - 1] == entry[1])) {
+    return;
+  }
+
+  MSC_Init();
+  if (end == LOG_ENTRIES) {
+    MSC_ErasePage(LOG);
+    end = 0;
+  }
+  MSC_WriteWord(&LOG[2 * end], entry, sizeof(entry));
+  MSC_Deinit();
+}
+#else
+/***************************************************************************//**
+ * @brief
+ *   Get the stored rate, 0 if there is none
+ ******************************************************************************/
+static uint32_t loadRate(void)
+{
+  uint32_t rate  = BURAM->RET[AUTOBAUD_BURAM_INDEX].REG;
+  uint32_t check = BURAM->RET[AUTOBAUD_BURAM_INDEX + 1].REG;
+
+  return isValid(rate, check) ? rate : 0;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Store a rate, 0 marks the stored rate invalid
+ ******************************************************************************/
+static void storeRate(uint32_t rate)
+{
+  BURAM->RET[AUTOBAUD_BURAM_INDEX].REG     = rate;
+  BURAM->RET[AUTOBAUD_BURAM_INDEX + 1].REG = rate ^ STORE_MAGIC;
+}
+#endif
+
+/***************************************************************************//**
+ * @brief
+ *   Round a detected rate to a standard rate if it is close to one. The
+ *   hardware measures the SYNC frame with a resolution of a few percent.
+ ******************************************************************************/
+static uint32_t snapRate(uint32_t measured)
+{
+  uint32_t i, diff;
+
+  for (i = 0; i < sizeof(standardRates) / sizeof(standardRates[0]); i++) {
+    diff = (measured > standardRates[i]) ? measured - standardRates[i]
+                                         : standardRates[i] - measured;
+    if (diff * 100 <= standardRates[i] * SNAP_PERCENT) {
+      return standardRates[i];
+    }
+  }
+  return measured;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Throw away everything in the RX FIFO
+ ******************************************************************************/
+static void drainRx(void)
+{
+  while (EUSART_StatusGet(eusart) & EUSART_STATUS_RXFL) {
+    (void)eusart->RXDATA;
+  }
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Initialize the EUSART at a rate, 0 runs detection. The interrupts the
+ *   application had enabled are enabled again afterwards.
+ ******************************************************************************/
+static void startAt(uint32_t rate)
+{
+  EUSART_UartInit_TypeDef init = config;
+  uint32_t ien = eusart->IEN & ~(EUSART_IEN_AUTOBAUDDONE | EUSART_IEN_FERR);
+
+  locked    = false;
+  baudrate  = 0;
+  ferrCount = 0;
+
+  // Setting baudrate = 0 enables autobaud detection
+  init.baudrate = rate;
+  EUSART_UartInitHf(eusart, &init);
+
+  EUSART_IntDisable(eusart, _EUSART_IEN_MASK);
+  EUSART_IntClear(eusart, _EUSART_IF_MASK);
+
+  if (rate == 0) {
+    EUSART_IntEnable(eusart, ien | EUSART_IEN_AUTOBAUDDONE);
+  } else {
+    baudrate = rate;
+    locked   = true;
+    EUSART_IntEnable(eusart, ien | EUSART_IEN_FERR);
+  }
+}
+
+/**************************************************************************//**
+ * @brief Bring up the EUSART at the stored rate or start detection
+ * @param[in] usart EUSART to use, its clock enabled and pins routed
+ * @param[in] init Asynchronous configuration, copied. The baudrate field
+ *   is ignored.
+ * @param[in] callback Called when detection locks on a rate, may be NULL
+ * @return true if a stored rate was used, false if detection is running
+ *****************************************************************************/
+bool AUTOBAUD_Init(EUSART_TypeDef *usart,
+                   const EUSART_UartInit_TypeDef *init,
+                   AUTOBAUD_Callback_t callback)
+{
+  uint32_t rate;
+
+  eusart       = usart;
+  config       = *init;
+  lockCallback = callback;
+
+#if !defined(AUTOBAUD_STORAGE_USERDATA) && defined(_CMU_CLKEN0_BURAM_MASK)
+  CMU_ClockEnable(cmuClock_BURAM, true);
+#endif
+
+  rate = loadRate();
+  startAt(rate);
+
+  return (rate != 0);
+}
+
+/**************************************************************************//**
+ * @brief Handle the autobaud part of the EUSART RX interrupt
+ * @details
+ *   While detecting, all received data is consumed. Once locked, frames
+ *   with framing errors are thrown away and everything else is left to
+ *   the application.
+ * @return true if the interrupt was handled, false if the application
+ *   should read the RX FIFO
+ *****************************************************************************/
+bool AUTOBAUD_RxIrq(void)
+{
+  uint32_t flags = EUSART_IntGetEnabled(eusart);
+  uint8_t c;
+
+  if (!locked) {
+    if (!(flags & EUSART_IF_AUTOBAUDDONE)) {
+      // Nothing can be received correctly before the rate is known
+      drainRx();
+      EUSART_IntClear(eusart, EUSART_IF_RXFL);
+      return true;
+    }
+
+    // The frame that was measured
+    c = eusart->RXDATA;
+    drainRx();
+    EUSART_IntClear(eusart, EUSART_IF_AUTOBAUDDONE | EUSART_IF_RXFL);
+
+    // Any other character gives a wrong rate, wait for the next SYNC
+    if (c != AUTOBAUD_SYNC_CHAR) {
+      startAt(0);
+      return true;
+    }
+
+    baudrate = snapRate(EUSART_BaudrateGet(eusart));
+    EUSART_BaudrateSet(eusart, 0, baudrate);
+    storeRate(baudrate);
+
+    EUSART_IntDisable(eusart, EUSART_IEN_AUTOBAUDDONE);
+    EUSART_IntEnable(eusart, EUSART_IEN_FERR);
+    ferrCount = 0;
+    locked    = true;
+
+    if (lockCallback != NULL) {
+      lockCallback(baudrate);
+    }
+    return true;
+  }
+
+  if (flags & EUSART_IF_FERR) {
+    // The FIFO may hold more frames received at the wrong rate
+    drainRx();
+    EUSART_IntClear(eusart, EUSART_IF_FERR | EUSART_IF_RXFL);
+
+    // The link rate has changed, detect it again
+    if (++ferrCount >= AUTOBAUD_FERR_LIMIT) {
+      storeRate(0);
+      startAt(0);
+    }
+    return true;
+  }
+
+  // A good frame ends the run of framing errors
+  if (flags & EUSART_IF_RXFL) {
+    ferrCount = 0;
+  }
+  return false;
+}
+
+/**************************************************************************//**
+ * @brief Run detection again, the stored rate is kept until it completes
+ *****************************************************************************/
+void AUTOBAUD_Restart(void)
+{
+  CORE_DECLARE_IRQ_STATE;
+
+  CORE_ENTER_ATOMIC();
+  startAt(0);
+  CORE_EXIT_ATOMIC();
+}
+
+/**************************************************************************//**
+ * @brief Clear the stored rate, the next AUTOBAUD_Init() runs detection
+ *****************************************************************************/
+void AUTOBAUD_Forget(void)
+{
+  storeRate(0);
+}
+
+/**************************************************************************//**
+ * @brief Check whether the EUSART runs at a known rate
+ *****************************************************************************/
+bool AUTOBAUD_IsLocked(void)
+{
+  return locked;
+}
+
+/**************************************************************************//**
+ * @brief Get the current rate, 0 while detecting
+ *****************************************************************************/
+uint32_t AUTOBAUD_GetBaudrate(void)
+{
+  return baudrate;
+}
+
+/** @} (end group Autobaud) */
+/** @} (end group kitdrv) */
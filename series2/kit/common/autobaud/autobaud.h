@@ -0,0 +1,112 @@
+/***************************************************************************//**
+ * @file
+ * @brief Asynchronous EUSART automatic baud rate detection with a cached rate.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2022 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ******************************************************************************/
+
+#ifndef __AUTOBAUD_H
+#define __AUTOBAUD_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "em_device.h"
+#include "em_eusart.h"
+
+/***************************************************************************//**
+ * @addtogroup kitdrv
+ * @{
+ ******************************************************************************/
+
+/***************************************************************************//**
+ * @addtogroup Autobaud
+ * @brief EUSART automatic baud rate detection that remembers the last rate
+ * @details
+ *    Brings up an asynchronous EUSART at the baud rate detected on an
+ *    earlier boot, and only runs the hardware autobaud detection when
+ *    there is no stored rate or the stored one stops working.
+ *
+ *    While detecting, the first frame received must be the SYNC character
+ *    0x55 ('U'). Any other character measures a wrong rate, so it is
+ *    dropped and detection starts over. The measured rate is rounded to
+ *    the nearest standard rate when it is within 3% of one, then stored.
+ *
+ *    By default the rate is kept in two BURAM retention registers, which
+ *    survive resets and EM4 but not a power loss. Define
+ *    AUTOBAUD_STORAGE_USERDATA to keep it in the USERDATA page instead.
+ *    The page is then used as a log of rates and erased when full, so it
+ *    must not hold anything else. The erase stalls the core for a few
+ *    milliseconds, long enough to overrun the RX FIFO.
+ *
+ *    AUTOBAUD_FERR_LIMIT framing errors in a row, with no good frame in
+ *    between, mean the link rate has changed. The stored rate is then
+ *    forgotten and detection runs again.
+ *
+ *    The application enables the EUSART clock, routes the pins and enables
+ *    the EUSART RX interrupt in the NVIC. It calls AUTOBAUD_RxIrq() at the
+ *    start of the RX interrupt handler and returns at once if it returns
+ *    true. The EUSART is initialized again whenever detection restarts, so
+ *    data still in the TX FIFO is lost.
+ * @{
+ ******************************************************************************/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Character the link partner sends to start detection */
+#define AUTOBAUD_SYNC_CHAR          0x55
+
+/** Framing errors in a row before detection runs again */
+#ifndef AUTOBAUD_FERR_LIMIT
+#define AUTOBAUD_FERR_LIMIT         4
+#endif
+
+/** First of the two BURAM retention registers holding the rate */
+#ifndef AUTOBAUD_BURAM_INDEX
+#define AUTOBAUD_BURAM_INDEX        30
+#endif
+
+/** Called from AUTOBAUD_RxIrq() when detection has locked on a rate */
+typedef void (*AUTOBAUD_Callback_t)(uint32_t baudrate);
+
+bool      AUTOBAUD_Init(EUSART_TypeDef *eusart,
+                        const EUSART_UartInit_TypeDef *init,
+                        AUTOBAUD_Callback_t callback);
+bool      AUTOBAUD_RxIrq(void);
+void      AUTOBAUD_Restart(void);
+void      AUTOBAUD_Forget(void);
+bool      AUTOBAUD_IsLocked(void);
+uint32_t  AUTOBAUD_GetBaudrate(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+/** @} (end group Autobaud) */
+/** @} (end group kitdrv) */
+
+#endif
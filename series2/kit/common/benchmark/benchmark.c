@@ -0,0 +1,194 @@
+/***************************************************************************//**
+ * @file
+ * @brief Cycle counter benchmark harness.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2022 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ******************************************************************************/
+
+#include <stdio.h>
+#include <string.h>
+#include "benchmark.h"
+
+/***************************************************************************//**
+ * @addtogroup kitdrv
+ * @{
+ ******************************************************************************/
+
+/***************************************************************************//**
+ * @addtogroup Benchmark
+ * @{
+ ******************************************************************************/
+
+static BENCHMARK_Entry_t results[BENCHMARK_MAX_ENTRIES];
+static unsigned int      resultCount;
+static uint32_t          overhead;
+
+/**************************************************************************//**
+ * @brief Start the cycle counter and measure the cost of a start/stop pair
+ *****************************************************************************/
+void BENCHMARK_Init(void)
+{
+  uint32_t start, cycles;
+  int i;
+
+#if (__CORTEX_M >= 3U)
+  CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+  DWT->CYCCNT = 0;
+  DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+#else
+  SysTick->LOAD = BENCHMARK_COUNTER_MASK;
+  SysTick->VAL  = 0;
+  SysTick->CTRL = SysTick_CTRL_CLKSOURCE_Msk | SysTick_CTRL_ENABLE_Msk;
+#endif
+
+  // Keep the fastest empty measurement as the overhead
+  overhead = 0;
+  cycles = BENCHMARK_COUNTER_MASK;
+  for (i = 0; i < 8; i++) {
+    BENCHMARK_START(start);
+    start = BENCHMARK_Elapsed(start);
+    if (start < cycles) {
+      cycles = start;
+    }
+  }
+  overhead = cycles;
+
+  BENCHMARK_Reset();
+}
+
+/**************************************************************************//**
+ * @brief Get the cycles since a BENCHMARK_START(), without the overhead
+ *****************************************************************************/
+uint32_t BENCHMARK_Elapsed(uint32_t start)
+{
+  uint32_t cycles = (BENCHMARK_Now() - start) & BENCHMARK_COUNTER_MASK;
+
+  return (cycles > overhead) ? (cycles - overhead) : 0;
+}
+
+/**************************************************************************//**
+ * @brief Add one run to the results of a named section
+ * @param[in] name Section name; the pointer is stored, use a string literal
+ * @param[in] cycles Cycles taken by the run
+ * @param[in] units Bytes or samples processed per run, 0 if not applicable
+ *****************************************************************************/
+void BENCHMARK_Record(const char *name, uint32_t cycles, uint32_t units)
+{
+  BENCHMARK_Entry_t *entry = NULL;
+  unsigned int i;
+
+  for (i = 0; i < resultCount; i++) {
+    if (strcmp(results[i].name, name) == 0) {
+      entry = &results[i];
+      break;
+    }
+  }
+
+  if (entry == NULL) {
+    if (resultCount >= BENCHMARK_MAX_ENTRIES) {
+      return;
+    }
+    entry = &results[resultCount++];
+    entry->name  = name;
+    entry->runs  = 0;
+    entry->min   = UINT32_MAX;
+    entry->max   = 0;
+    entry->total = 0;
+  }
+
+  entry->units = units;
+  entry->runs++;
+  entry->total += cycles;
+  if (cycles < entry->min) {
+    entry->min = cycles;
+  }
+  if (cycles > entry->max) {
+    entry->max = cycles;
+  }
+}
+
+/**************************************************************************//**
+ * @brief Get the number of named sections recorded
+ *****************************************************************************/
+unsigned int BENCHMARK_Count(void)
+{
+  return resultCount;
+}
+
+/**************************************************************************//**
+ * @brief Get the results of a section, NULL if index is out of range
+ *****************************************************************************/
+const BENCHMARK_Entry_t *BENCHMARK_Get(unsigned int index)
+{
+  return (index < resultCount) ? &results[index] : NULL;
+}
+
+/**************************************************************************//**
+ * @brief Clear the results table
+ *****************************************************************************/
+void BENCHMARK_Reset(void)
+{
+  resultCount = 0;
+}
+
+/**************************************************************************//**
+ * @brief Print the results table
+ * @details
+ *   Cycles per unit and the average time are printed with one decimal, in
+ *   integer arithmetic so no floating point printf support is needed.
+ *****************************************************************************/
+void BENCHMARK_Print(void)
+{
+  const BENCHMARK_Entry_t *e;
+  uint32_t clock = SystemCoreClockGet();
+  uint32_t avg, perUnit, ns;
+  unsigned int i;
+
+  printf("\nBenchmark, core clock %lu Hz\n", (unsigned long)clock);
+  printf("%-20s %6s %10s %10s %10s %10s %12s\n",
+         "name", "runs", "min", "avg", "max", "cyc/unit", "avg us");
+
+  for (i = 0; i < resultCount; i++) {
+    e = &results[i];
+    avg = (uint32_t)(e->total / e->runs);
+    ns = (uint32_t)(((uint64_t)avg * 1000000000ULL) / clock);
+
+    printf("%-20s %6lu %10lu %10lu %10lu ", e->name, (unsigned long)e->runs,
+           (unsigned long)e->min, (unsigned long)avg, (unsigned long)e->max);
+    if (e->units != 0) {
+      perUnit = (uint32_t)(((uint64_t)avg * 10 + e->units / 2) / e->units);
+      printf("%8lu.%lu ", (unsigned long)(perUnit / 10),
+             (unsigned long)(perUnit % 10));
+    } else {
+      printf("%10s ", "-");
+    }
+    printf("%10lu.%lu\n", (unsigned long)(ns / 1000),
+           (unsigned long)((ns % 1000) / 100));
+  }
+}
+
+/** @} (end group Benchmark) */
+/** @} (end group kitdrv) */
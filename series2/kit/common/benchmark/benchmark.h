@@ -0,0 +1,121 @@
+/***************************************************************************//**
+ * @file
+ * @brief Cycle counter benchmark harness.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2022 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ******************************************************************************/
+
+#ifndef __BENCHMARK_H
+#define __BENCHMARK_H
+
+#include <stdint.h>
+#include "em_device.h"
+
+/***************************************************************************//**
+ * @addtogroup kitdrv
+ * @{
+ ******************************************************************************/
+
+/***************************************************************************//**
+ * @addtogroup Benchmark
+ * @brief Cycle counter benchmark harness
+ * @details
+ *    Times code sections in core clock cycles and collects the runs of
+ *    each named section (min, average, max) in a results table that can
+ *    be read in the debugger or printed with BENCHMARK_Print().
+ *
+ *    Cortex-M3, M4 and M33 parts use the DWT cycle counter. Cortex-M0+
+ *    parts have no DWT cycle counter, the free running SysTick is used
+ *    instead; sections must then be shorter than 2^24 cycles.
+ *
+ *    BENCHMARK_Print() uses printf(); the application sets up the
+ *    retarget serial port (RETARGET_SerialInit()) beforehand.
+ *
+ *    The harness only depends on CMSIS and can be used on series 0, 1
+ *    and 2 parts.
+ * @{
+ ******************************************************************************/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef BENCHMARK_MAX_ENTRIES
+#define BENCHMARK_MAX_ENTRIES     16    /**< Named sections in the results table */
+#endif
+
+#if (__CORTEX_M >= 3U)
+#define BENCHMARK_COUNTER_MASK    0xFFFFFFFFUL
+#else
+#define BENCHMARK_COUNTER_MASK    0x00FFFFFFUL
+#endif
+
+/** Results of one named section */
+typedef struct {
+  const char  *name;                    /**< Section name, not copied */
+  uint32_t    units;                    /**< Bytes or samples per run, 0 if unused */
+  uint32_t    runs;                     /**< Number of runs recorded */
+  uint32_t    min;                      /**< Fastest run, cycles */
+  uint32_t    max;                      /**< Slowest run, cycles */
+  uint64_t    total;                    /**< Sum of all runs, cycles */
+} BENCHMARK_Entry_t;
+
+/***************************************************************************//**
+ * @brief Read the cycle counter
+ ******************************************************************************/
+__STATIC_INLINE uint32_t BENCHMARK_Now(void)
+{
+#if (__CORTEX_M >= 3U)
+  return DWT->CYCCNT;
+#else
+  // SysTick counts down
+  return BENCHMARK_COUNTER_MASK - SysTick->VAL;
+#endif
+}
+
+/** Store the current cycle count in the uint32_t variable @p t */
+#define BENCHMARK_START(t)            ((t) = BENCHMARK_Now())
+
+/** Record the cycles since BENCHMARK_START(t) under @p name */
+#define BENCHMARK_STOP(name, t, units) \
+  BENCHMARK_Record((name), BENCHMARK_Elapsed(t), (units))
+
+void                    BENCHMARK_Init(void);
+uint32_t                BENCHMARK_Elapsed(uint32_t start);
+void                    BENCHMARK_Record(const char *name, uint32_t cycles, uint32_t units);
+unsigned int            BENCHMARK_Count(void);
+const BENCHMARK_Entry_t *BENCHMARK_Get(unsigned int index);
+void                    BENCHMARK_Reset(void);
+void                    BENCHMARK_Print(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+/** @} (end group Benchmark) */
+/** @} (end group kitdrv) */
+
+#endif
@@ -32,6 +32,7 @@
 
 #include "em_chip.h"
 #include "em_cmu.h"
+#include "em_core.h"
 #include "em_emu.h"
 #include "em_gpio.h"
 
@@ -54,6 +55,84 @@
 #define MFG_CTUNE_ADDR 0x0FE00100UL
 #define MFG_CTUNE_VAL  (*((uint16_t *) (MFG_CTUNE_ADDR)))
 
+// Start the crystals without waiting for them and switch the clock trees
+// over from the oscillator ready interrupts, see BSP_initClocks()
+#if !defined(HAL_CLK_XO_ASYNC)
+#define HAL_CLK_XO_ASYNC 0
+#endif
+
+// Keep the HFXO CTUNE and the core bias current found by the first startup
+// in BURAM, so warm boots and EM4 wakeups skip the core bias optimization
+#if !defined(HAL_CLK_HFXO_CAL_CACHE)
+#define HAL_CLK_HFXO_CAL_CACHE 0
+#endif
+
+// First of the two BURAM registers the HFXO calibration is kept in
+#if !defined(HAL_CLK_HFXO_CAL_BURAM_REG)
+#define HAL_CLK_HFXO_CAL_BURAM_REG 30
+#endif
+
+#if HAL_CLK_HFXO_CAL_CACHE
+  #if !BSP_CLK_HFXO_PRESENT || !defined(_SILICON_LABS_32B_SERIES_2) || !defined(BURAM_PRESENT)
+    #error "HAL_CLK_HFXO_CAL_CACHE needs a Series 2 device with HFXO and BURAM"
+  #endif
+  #if (HAL_CLK_HFXO_CAL_BURAM_REG + 1) >= 32
+    #error "HAL_CLK_HFXO_CAL_BURAM_REG leaves no room for the calibration"
+  #endif
+#define HFXO_CAL_MAGIC 0xC7B1UL
+#endif
+
+// Crystals the clock trees wait for
+#define CLK_XO_HFXO    0x1
+#define CLK_XO_LFXO    0x2
+
+// Crystal the HF clock tree runs from, directly or as the DPLL reference
+#if (HAL_CLK_HFCLK_SOURCE == HAL_CLK_HFCLK_SOURCE_HFXO)
+#define CLK_HF_XO      CLK_XO_HFXO
+#elif (HAL_CLK_HFCLK_SOURCE == HAL_CLK_HFCLK_SOURCE_HFRCODPLL) && defined(HAL_CLK_PLL_CONFIGURATION)
+  #if defined(_SILICON_LABS_32B_SERIES_2_CONFIG_1) \
+  && (HAL_CLK_PLL_CONFIGURATION == HAL_CLK_PLL_CONFIGURATION_40MHZ)
+#define CLK_HF_XO      CLK_XO_LFXO
+  #else
+#define CLK_HF_XO      CLK_XO_HFXO
+  #endif
+#else
+#define CLK_HF_XO      0
+#endif
+
+// Crystal the LF clock trees run from
+#if (HAL_CLK_LFACLK_SOURCE == HAL_CLK_LFCLK_SOURCE_LFXO)   \
+  || (HAL_CLK_LFBCLK_SOURCE == HAL_CLK_LFCLK_SOURCE_LFXO)  \
+  || (HAL_CLK_LFCCLK_SOURCE == HAL_CLK_LFCLK_SOURCE_LFXO)  \
+  || (HAL_CLK_LFECLK_SOURCE == HAL_CLK_LFCLK_SOURCE_LFXO)  \
+  || (HAL_CLK_EM23CLK_SOURCE == HAL_CLK_LFCLK_SOURCE_LFXO) \
+  || (HAL_CLK_EM4CLK_SOURCE == HAL_CLK_LFCLK_SOURCE_LFXO)  \
+  || (HAL_CLK_RTCCCLK_SOURCE == HAL_CLK_LFCLK_SOURCE_LFXO) \
+  || (HAL_CLK_WDOGCLK_SOURCE == HAL_CLK_LFCLK_SOURCE_LFXO)
+  #if !BSP_CLK_LFXO_PRESENT
+    #error "Cannot select LFXO when LFXO is not present"
+  #endif
+#define CLK_LF_XO      CLK_XO_LFXO
+#else
+#define CLK_LF_XO      0
+#endif
+
+#if HAL_CLK_XO_ASYNC
+  #if defined(_SILICON_LABS_32B_SERIES_2_CONFIG_1)
+#define BSP_HFXO_IRQn        HFXO00_IRQn
+#define BSP_HFXO_IRQHandler  HFXO00_IRQHandler
+  #elif defined(_SILICON_LABS_32B_SERIES_2)
+#define BSP_HFXO_IRQn        HFXO0_IRQn
+#define BSP_HFXO_IRQHandler  HFXO0_IRQHandler
+  #endif
+
+// Crystals that have reported ready
+static volatile uint32_t clocksXoReady;
+#endif
+
+// Clock trees on their configured source, BSP_CLOCKS_x
+static volatile uint32_t clocksDone;
+
 void BSP_initDevice(void)
 {
   // Device errata
@@ -120,74 +199,67 @@ void BSP_initEmu(void)
 #endif //HAL_EMU_ENABLE
 }
 
-void BSP_initClocks(void)
+#if HAL_CLK_HFXO_CAL_CACHE
+/***************************************************************************//**
+ * HFXO calibration in BURAM, register HAL_CLK_HFXO_CAL_BURAM_REG:
+ *
+ *   bits 31:16  HFXO_CAL_MAGIC
+ *   bits 15:8   CTUNE the core bias current was optimized with
+ *   bits 7:0    optimized core bias current, HFXO0->XTALCTRL.COREBIASANA
+ *
+ * The next register holds the complement. BURAM comes up random after a
+ * power on reset and is kept through every other reset and through EM4.
+ ******************************************************************************/
+static void hfxoCalRestore(CMU_HFXOInit_TypeDef *hfxoInit)
 {
-  // --------------------------------
-  // Initialize HFXO if present
+  uint32_t cal;
 
-#if BSP_CLK_HFXO_PRESENT
-  // HFXO
-  CMU_HFXOInit_TypeDef hfxoInit = BSP_CLK_HFXO_INIT;
-  int ctune = -1;
-
-#if defined(_DEVINFO_MODXOCAL_HFXOCTUNE_MASK) // Series 1
-  if ((DEVINFO->MODULEINFO & _DEVINFO_MODULEINFO_HFXOCALVAL_MASK) == 0) {
-    ctune = DEVINFO->MODXOCAL & _DEVINFO_MODXOCAL_HFXOCTUNE_MASK;
-  }
-#elif defined(_DEVINFO_MODXOCAL_HFXOCTUNEXIANA_MASK) // Series 2
-  if ((DEVINFO->MODULEINFO & _DEVINFO_MODULEINFO_HFXOCALVAL_MASK) == 0) {
-    ctune = DEVINFO->MODXOCAL & _DEVINFO_MODXOCAL_HFXOCTUNEXIANA_MASK;
-  }
+#if defined(_CMU_CLKEN0_BURAM_MASK)
+  CMU_ClockEnable(cmuClock_BURAM, true);
 #endif
-
-  if ((ctune == -1) && (MFG_CTUNE_EN == 1) && (MFG_CTUNE_VAL != 0xFFFF)) {
-    ctune = MFG_CTUNE_VAL;
-  }
-
-#if defined(BSP_CLK_HFXO_CTUNE) && BSP_CLK_HFXO_CTUNE >= 0
-  if (ctune == -1) {
-    ctune = BSP_CLK_HFXO_CTUNE;
-  }
+#if defined(_CMU_CLKEN0_HFXO0_MASK)
+  CMU_ClockEnable(cmuClock_HFXO, true);
 #endif
 
-  if (ctune != -1) {
-#if defined(_SILICON_LABS_32B_SERIES_1)
-    hfxoInit.ctuneSteadyState = ctune;
-#elif defined(_SILICON_LABS_32B_SERIES_2)
-    hfxoInit.ctuneXoAna = ctune;
-    hfxoInit.ctuneXiAna = ctune;
-#endif
+  cal = BURAM->RET[HAL_CLK_HFXO_CAL_BURAM_REG].REG;
+  if (((cal >> 16) != HFXO_CAL_MAGIC)
+      || (BURAM->RET[HAL_CLK_HFXO_CAL_BURAM_REG + 1].REG != ~cal)
+      || (((cal >> 8) & 0xFFUL) != (uint32_t)hfxoInit->ctuneXiAna)) {
+    // Nothing kept, or kept for another CTUNE: run the full startup
+    HFXO0->XTALCTRL_CLR = HFXO_XTALCTRL_SKIPCOREBIASOPT;
+    return;
   }
-  CMU_HFXOInit(&hfxoInit);
-  SystemHFXOClockSet(BSP_CLK_HFXO_FREQ);
-#endif // BSP_CLK_HFXO_PRESENT
-
-  // --------------------------------
-  // Initialize LFXO if present
-
-#if BSP_CLK_LFXO_PRESENT
-  // LFXO
-  CMU_LFXOInit_TypeDef lfxoInit = BSP_CLK_LFXO_INIT;
-
-#if defined(BSP_CLK_LFXO_CTUNE) && BSP_CLK_LFXO_CTUNE > 0
-
-#if defined(_SILICON_LABS_32B_SERIES_2)
-  lfxoInit.capTune = BSP_CLK_LFXO_CTUNE;
-#elif defined(_CMU_LFXOCTRL_MASK)
-  lfxoInit.ctune = BSP_CLK_LFXO_CTUNE;
-#endif
-
-#endif // BSP_CLK_LFXO_CTUNE > 0
 
-  CMU_LFXOInit(&lfxoInit);
+  // Start right at the optimized core bias current. CMU_HFXOInit() keeps
+  // SKIPCOREBIASOPT, so it must be set while the registers are unlocked.
+  hfxoInit->coreBiasAna = (uint8_t)(cal & 0xFFUL);
+  HFXO0->XTALCTRL_SET = HFXO_XTALCTRL_SKIPCOREBIASOPT;
+}
 
-  // Set system LFXO frequency
-  SystemLFXOClockSet(BSP_CLK_LFXO_FREQ);
-#endif // BSP_CLK_LFXO_PRESENT
+void BSP_saveHfxoCal(void)
+{
+  uint32_t xtalctrl = HFXO0->XTALCTRL;
+  uint32_t cal;
+
+  // A startup that skipped the optimization was restored from BURAM, and
+  // until the optimization completes the core bias is not worth keeping
+  if ((xtalctrl & HFXO_XTALCTRL_SKIPCOREBIASOPT)
+      || !(HFXO0->STATUS & HFXO_STATUS_COREBIASOPTRDY)) {
+    return;
+  }
 
-  // --------------------------------
-  // Enable HFXO if selected as HFCLK
+  cal = (HFXO_CAL_MAGIC << 16)
+        | (((xtalctrl & _HFXO_XTALCTRL_CTUNEXIANA_MASK)
+            >> _HFXO_XTALCTRL_CTUNEXIANA_SHIFT) << 8)
+        | ((xtalctrl & _HFXO_XTALCTRL_COREBIASANA_MASK)
+           >> _HFXO_XTALCTRL_COREBIASANA_SHIFT);
+  BURAM->RET[HAL_CLK_HFXO_CAL_BURAM_REG].REG     = cal;
+  BURAM->RET[HAL_CLK_HFXO_CAL_BURAM_REG + 1].REG = ~cal;
+}
+#endif // HAL_CLK_HFXO_CAL_CACHE
 
+static void selectHfClock(void)
+{
 #if (HAL_CLK_HFCLK_SOURCE == HAL_CLK_HFCLK_SOURCE_HFXO)
   // Enable HFXO oscillator, and wait for it to be stable
   CMU_OscillatorEnable(cmuOsc_HFXO, true, true);
@@ -257,22 +329,14 @@ void BSP_initClocks(void)
   #error "Must define HAL_CLK_HFCLK_SOURCE"
 #endif // HAL_CLK_HFCLK_SOURCE
 
-  // --------------------------------
-  // Enable LFXO if selected as LFCLK
-
-#if (HAL_CLK_LFACLK_SOURCE == HAL_CLK_LFCLK_SOURCE_LFXO)   \
-  || (HAL_CLK_LFBCLK_SOURCE == HAL_CLK_LFCLK_SOURCE_LFXO)  \
-  || (HAL_CLK_LFCCLK_SOURCE == HAL_CLK_LFCLK_SOURCE_LFXO)  \
-  || (HAL_CLK_LFECLK_SOURCE == HAL_CLK_LFCLK_SOURCE_LFXO)  \
-  || (HAL_CLK_EM23CLK_SOURCE == HAL_CLK_LFCLK_SOURCE_LFXO) \
-  || (HAL_CLK_EM4CLK_SOURCE == HAL_CLK_LFCLK_SOURCE_LFXO)  \
-  || (HAL_CLK_RTCCCLK_SOURCE == HAL_CLK_LFCLK_SOURCE_LFXO) \
-  || (HAL_CLK_WDOGCLK_SOURCE == HAL_CLK_LFCLK_SOURCE_LFXO)
-  #if !BSP_CLK_LFXO_PRESENT
-    #error "Cannot select LFXO when LFXO is not present"
-  #endif
+#if HAL_CLK_HFXO_CAL_CACHE && (CLK_HF_XO == CLK_XO_HFXO)
+  // The HFXO is stable now, keep what its startup found for the next boot
+  BSP_saveHfxoCal();
 #endif
+}
 
+static void selectLfClocks(void)
+{
   // ------------------------
   // Series 0/1
 
@@ -389,11 +453,247 @@ void BSP_initClocks(void)
 #endif
 }
 
+#if HAL_CLK_XO_ASYNC
+static void serviceClocks(void)
+{
+  CORE_DECLARE_IRQ_STATE;
+
+  CORE_ENTER_ATOMIC();
+
+  // Collect the crystals that are ready, only the ready flags are cleared.
+  // The status also counts, a crystal left running by a bootloader does
+  // not report ready again.
+#if defined(_SILICON_LABS_32B_SERIES_2)
+#if (CLK_HF_XO | CLK_LF_XO) & CLK_XO_HFXO
+  HFXO0->IF_CLR = HFXO_IF_RDY;
+  if (HFXO0->STATUS & HFXO_STATUS_RDY) {
+    clocksXoReady |= CLK_XO_HFXO;
+  }
+#endif
+#if (CLK_HF_XO | CLK_LF_XO) & CLK_XO_LFXO
+  LFXO->IF_CLR = LFXO_IF_RDY;
+  if (LFXO->STATUS & LFXO_STATUS_RDY) {
+    clocksXoReady |= CLK_XO_LFXO;
+  }
+#endif
+#else
+  CMU_IntClear(CMU_IF_HFXORDY | CMU_IF_LFXORDY);
+  if (CMU->STATUS & CMU_STATUS_HFXORDY) {
+    clocksXoReady |= CLK_XO_HFXO;
+  }
+  if (CMU->STATUS & CMU_STATUS_LFXORDY) {
+    clocksXoReady |= CLK_XO_LFXO;
+  }
+#endif
+
+  // Switch each clock tree once the crystal it runs from is stable, the
+  // select calls below do not wait any more
+  if (!(clocksDone & BSP_CLOCKS_HF)
+      && ((clocksXoReady & CLK_HF_XO) == CLK_HF_XO)) {
+    selectHfClock();
+    clocksDone |= BSP_CLOCKS_HF;
+  }
+  if (!(clocksDone & BSP_CLOCKS_LF)
+      && ((clocksXoReady & CLK_LF_XO) == CLK_LF_XO)) {
+    selectLfClocks();
+    clocksDone |= BSP_CLOCKS_LF;
+  }
+
+  // All trees switched, the ready interrupts are no longer needed
+  if (clocksDone == BSP_CLOCKS_ALL) {
+#if defined(_SILICON_LABS_32B_SERIES_2)
+#if (CLK_HF_XO | CLK_LF_XO) & CLK_XO_HFXO
+    HFXO0->IEN_CLR = HFXO_IEN_RDY;
+    NVIC_DisableIRQ(BSP_HFXO_IRQn);
+#endif
+#if (CLK_HF_XO | CLK_LF_XO) & CLK_XO_LFXO
+    LFXO->IEN_CLR = LFXO_IEN_RDY;
+    NVIC_DisableIRQ(LFXO_IRQn);
+#endif
+#elif (CLK_HF_XO | CLK_LF_XO)
+    CMU_IntDisable(CMU_IEN_HFXORDY | CMU_IEN_LFXORDY);
+    NVIC_DisableIRQ(CMU_IRQn);
+#endif
+  }
+
+  CORE_EXIT_ATOMIC();
+}
+
+static void startClocks(void)
+{
+  clocksXoReady = 0;
+  clocksDone    = 0;
+
+  // Enable the ready interrupt of each crystal a clock tree waits for
+#if defined(_SILICON_LABS_32B_SERIES_2)
+#if (CLK_HF_XO | CLK_LF_XO) & CLK_XO_HFXO
+  HFXO0->IF_CLR  = HFXO_IF_RDY;
+  HFXO0->IEN_SET = HFXO_IEN_RDY;
+  NVIC_ClearPendingIRQ(BSP_HFXO_IRQn);
+  NVIC_EnableIRQ(BSP_HFXO_IRQn);
+#endif
+#if (CLK_HF_XO | CLK_LF_XO) & CLK_XO_LFXO
+  LFXO->IF_CLR  = LFXO_IF_RDY;
+  LFXO->IEN_SET = LFXO_IEN_RDY;
+  NVIC_ClearPendingIRQ(LFXO_IRQn);
+  NVIC_EnableIRQ(LFXO_IRQn);
+#endif
+#else
+  CMU_IntClear(CMU_IF_HFXORDY | CMU_IF_LFXORDY);
+#if (CLK_HF_XO | CLK_LF_XO) & CLK_XO_HFXO
+  CMU_IntEnable(CMU_IEN_HFXORDY);
+#endif
+#if (CLK_HF_XO | CLK_LF_XO) & CLK_XO_LFXO
+  CMU_IntEnable(CMU_IEN_LFXORDY);
+#endif
+#if (CLK_HF_XO | CLK_LF_XO)
+  NVIC_ClearPendingIRQ(CMU_IRQn);
+  NVIC_EnableIRQ(CMU_IRQn);
+#endif
+#endif
+
+  // Start all crystals at once, the core keeps running from its reset clock
+#if (CLK_HF_XO | CLK_LF_XO) & CLK_XO_HFXO
+  CMU_OscillatorEnable(cmuOsc_HFXO, true, false);
+#endif
+#if (CLK_HF_XO | CLK_LF_XO) & CLK_XO_LFXO
+  CMU_OscillatorEnable(cmuOsc_LFXO, true, false);
+#endif
+
+  // Clock trees that wait for no crystal are switched right away
+  serviceClocks();
+}
+
+#if defined(_SILICON_LABS_32B_SERIES_2)
+#if (CLK_HF_XO | CLK_LF_XO) & CLK_XO_HFXO
+void BSP_HFXO_IRQHandler(void)
+{
+  serviceClocks();
+}
+#endif
+
+#if (CLK_HF_XO | CLK_LF_XO) & CLK_XO_LFXO
+void LFXO_IRQHandler(void)
+{
+  serviceClocks();
+}
+#endif
+#elif (CLK_HF_XO | CLK_LF_XO)
+void CMU_IRQHandler(void)
+{
+  serviceClocks();
+}
+#endif
+#endif // HAL_CLK_XO_ASYNC
+
+void BSP_initClocks(void)
+{
+  // --------------------------------
+  // Initialize HFXO if present
+
+#if BSP_CLK_HFXO_PRESENT
+  // HFXO
+  CMU_HFXOInit_TypeDef hfxoInit = BSP_CLK_HFXO_INIT;
+  int ctune = -1;
+
+#if defined(_DEVINFO_MODXOCAL_HFXOCTUNE_MASK) // Series 1
+  if ((DEVINFO->MODULEINFO & _DEVINFO_MODULEINFO_HFXOCALVAL_MASK) == 0) {
+    ctune = DEVINFO->MODXOCAL & _DEVINFO_MODXOCAL_HFXOCTUNE_MASK;
+  }
+#elif defined(_DEVINFO_MODXOCAL_HFXOCTUNEXIANA_MASK) // Series 2
+  if ((DEVINFO->MODULEINFO & _DEVINFO_MODULEINFO_HFXOCALVAL_MASK) == 0) {
+    ctune = DEVINFO->MODXOCAL & _DEVINFO_MODXOCAL_HFXOCTUNEXIANA_MASK;
+  }
+#endif
+
+  if ((ctune == -1) && (MFG_CTUNE_EN == 1) && (MFG_CTUNE_VAL != 0xFFFF)) {
+    ctune = MFG_CTUNE_VAL;
+  }
+
+#if defined(BSP_CLK_HFXO_CTUNE) && BSP_CLK_HFXO_CTUNE >= 0
+  if (ctune == -1) {
+    ctune = BSP_CLK_HFXO_CTUNE;
+  }
+#endif
+
+  if (ctune != -1) {
+#if defined(_SILICON_LABS_32B_SERIES_1)
+    hfxoInit.ctuneSteadyState = ctune;
+#elif defined(_SILICON_LABS_32B_SERIES_2)
+    hfxoInit.ctuneXoAna = ctune;
+    hfxoInit.ctuneXiAna = ctune;
+#endif
+  }
+#if HAL_CLK_HFXO_CAL_CACHE
+  hfxoCalRestore(&hfxoInit);
+#endif
+  CMU_HFXOInit(&hfxoInit);
+  SystemHFXOClockSet(BSP_CLK_HFXO_FREQ);
+#endif // BSP_CLK_HFXO_PRESENT
+
+  // --------------------------------
+  // Initialize LFXO if present
+
+#if BSP_CLK_LFXO_PRESENT
+  // LFXO
+  CMU_LFXOInit_TypeDef lfxoInit = BSP_CLK_LFXO_INIT;
+
+#if defined(BSP_CLK_LFXO_CTUNE) && BSP_CLK_LFXO_CTUNE > 0
+
+#if defined(_SILICON_LABS_32B_SERIES_2)
+  lfxoInit.capTune = BSP_CLK_LFXO_CTUNE;
+#elif defined(_CMU_LFXOCTRL_MASK)
+  lfxoInit.ctune = BSP_CLK_LFXO_CTUNE;
+#endif
+
+#endif // BSP_CLK_LFXO_CTUNE > 0
+
+  CMU_LFXOInit(&lfxoInit);
+
+  // Set system LFXO frequency
+  SystemLFXOClockSet(BSP_CLK_LFXO_FREQ);
+#endif // BSP_CLK_LFXO_PRESENT
+
+#if HAL_CLK_XO_ASYNC
+  // Switch the clock trees over as their crystals become ready
+  startClocks();
+#else
+  selectHfClock();
+  selectLfClocks();
+  clocksDone = BSP_CLOCKS_ALL;
+#endif
+}
+
+bool BSP_clocksReady(uint32_t clocks)
+{
+  return (clocksDone & clocks) == clocks;
+}
+
+void BSP_waitClocks(uint32_t clocks)
+{
+  CORE_DECLARE_IRQ_STATE;
+
+  while (!BSP_clocksReady(clocks)) {
+    // Sleep until the next oscillator ready interrupt
+    CORE_ENTER_CRITICAL();
+    if (!BSP_clocksReady(clocks)) {
+      EMU_EnterEM1();
+    }
+    CORE_EXIT_CRITICAL();
+  }
+}
+
 void BSP_initBoard(void)
 {
   // Board functionality necessarily needs GPIO
   CMU_ClockEnable(cmuClock_GPIO, true);
 
+#if HAL_CLK_XO_ASYNC && (HAL_IOEXP_ENABLE || HAL_I2CSENSOR_ENABLE || defined(BSP_SERIAL_APP_PORT))
+  // The I2C and UART dividers are set from the HF clock, so it must be on
+  // its final source first. The LF clock trees may still be switching.
+  BSP_waitClocks(BSP_CLOCKS_HF);
+#endif
+
   // Initialize IO expander
 #if HAL_IOEXP_ENABLE
   BSP_Init(BSP_INIT_IOEXP);
@@ -30,6 +30,9 @@
 #ifndef BSP_INIT_H
 #define BSP_INIT_H
 
+#include <stdbool.h>
+#include <stdint.h>
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -53,6 +56,10 @@ extern "C" {
  * @{
  ******************************************************************************/
 
+#define BSP_CLOCKS_HF   0x1   /**< HF clock tree on its configured source */
+#define BSP_CLOCKS_LF   0x2   /**< LF clock trees on their configured sources */
+#define BSP_CLOCKS_ALL  (BSP_CLOCKS_HF | BSP_CLOCKS_LF) /**< All clock trees */
+
 /***************************************************************************//**
  * @brief Initialize the device using HAL config settings
  *
@@ -82,9 +89,51 @@ void BSP_initEmu(void);
  *
  * @details Initialize HFXO and LFXO crystal oscillators if present.
  *          Select clock sources for HF and LF clock trees.
+ *
+ *          With HAL_CLK_XO_ASYNC set to 1 this function does not wait for
+ *          the crystals. It starts all of them at once and returns with the
+ *          core still on its reset clock; each clock tree is switched over
+ *          from the ready interrupt of the crystal it runs from, while the
+ *          rest of the application initializes. The BSP then owns
+ *          CMU_IRQHandler on Series 1 and the HFXO and LFXO interrupt
+ *          handlers on Series 2. Peripherals clocked from the HF clock tree
+ *          must be set up after BSP_waitClocks(BSP_CLOCKS_HF).
+ *
+ *          With HAL_CLK_HFXO_CAL_CACHE set to 1 on Series 2 the CTUNE and
+ *          the core bias current found by the first HFXO startup are kept
+ *          in BURAM. Later boots with the same CTUNE, resets other than a
+ *          power on reset and EM4 wakeups, start the HFXO at that core bias
+ *          and skip the core bias optimization, which shortens the startup.
  ******************************************************************************/
 void BSP_initClocks(void);
 
+/***************************************************************************//**
+ * @brief Keep the HFXO calibration in BURAM for the next boot
+ *
+ * @details Only with HAL_CLK_HFXO_CAL_CACHE. Called by the BSP once the HF
+ *          clock tree runs from the HFXO. When the HFXO is started for
+ *          another user, such as the radio, call it after the HFXO is ready.
+ *          Does nothing before a core bias optimization has completed.
+ ******************************************************************************/
+void BSP_saveHfxoCal(void);
+
+/***************************************************************************//**
+ * @brief Check if clock trees are on their configured sources
+ *
+ * @param[in] clocks BSP_CLOCKS_HF, BSP_CLOCKS_LF or BSP_CLOCKS_ALL
+ *
+ * @return true once all clock trees in @p clocks have been switched, always
+ *         true after BSP_initClocks() without HAL_CLK_XO_ASYNC
+ ******************************************************************************/
+bool BSP_clocksReady(uint32_t clocks);
+
+/***************************************************************************//**
+ * @brief Wait in EM1 until clock trees are on their configured sources
+ *
+ * @param[in] clocks BSP_CLOCKS_HF, BSP_CLOCKS_LF or BSP_CLOCKS_ALL
+ ******************************************************************************/
+void BSP_waitClocks(uint32_t clocks);
+
 /***************************************************************************//**
  * @brief Initialize board based on HAL configuration
  *
@@ -0,0 +1,350 @@
+/***************************************************************************//**
+ * @file
+ * @brief Precomputed clock profiles with fast switching between them.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2022 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ******************************************************************************/
+
+#include "em_cmu.h"
+#include "em_core.h"
+#include "em_emu.h"
+#include "em_usart.h"
+#include "clkprofile.h"
+
+/***************************************************************************//**
+ * @addtogroup kitdrv
+ * @{
+ ******************************************************************************/
+
+/***************************************************************************//**
+ * @addtogroup ClkProfile
+ * @{
+ ******************************************************************************/
+
+#if !defined(DPLL_PRESENT)
+#error "Clock profiles need the DPLL"
+#endif
+
+// The profiles. The DPLL output is fHFXO * (N + 1) / (M + 1), 39 MHz * 2
+// for the compute profile, and the HFXO runs at 39 MHz on every board this
+// table is for.
+static const CLKPROFILE_Profile_TypeDef profiles[clkprofileCount] = {
+  [clkprofileCompute] = { 78000000, cmuSelect_HFRCODPLL, true, 3999, 1999,
+                          cmuHFRCODPLLFreq_80M0Hz, cmuClkDiv_2, false },
+  [clkprofileRadio]   = { 39000000, cmuSelect_HFXO, false, 0, 0,
+                          cmuHFRCODPLLFreq_38M0Hz, cmuClkDiv_1, false },
+  [clkprofileAudio]   = { 19000000, cmuSelect_HFRCODPLL, false, 0, 0,
+                          cmuHFRCODPLLFreq_19M0Hz, cmuClkDiv_1, true },
+  [clkprofileIdle]    = { 1000000, cmuSelect_HFRCODPLL, false, 0, 0,
+                          cmuHFRCODPLLFreq_1M0Hz, cmuClkDiv_1, true },
+};
+
+// Oversampling from the best to the least, the lower ones for a USART
+// clock too slow for 16 times the baud rate
+static const struct {
+  USART_OVS_TypeDef ovs;
+  uint32_t          factor;
+} oversampling[] = {
+  { usartOVS16, 16 },
+  { usartOVS8, 8 },
+  { usartOVS6, 6 },
+  { usartOVS4, 4 },
+};
+
+typedef struct {
+  USART_TypeDef     *usart;
+  CMU_Clock_TypeDef clock;
+  uint32_t          baudrate;
+  uint32_t          refFreq;    // USART clock the divider was set for
+} Usart_t;
+
+static Usart_t usarts[CLKPROFILE_MAX_USARTS];
+static uint32_t usartCount;
+
+// Profile in use, clkprofileCount before the first CLKPROFILE_Set()
+static CLKPROFILE_Id_TypeDef current = clkprofileCount;
+
+// DPLL enabled by a profile
+static bool dpllOn;
+
+static CLKPROFILE_Counters_TypeDef counters;
+
+/**************************************************************************//**
+ * @brief Set the EM01 voltage scale
+ *****************************************************************************/
+static void setVoltage(bool low)
+{
+#if defined(EMU_VSCALE_EM01_PRESENT)
+  EMU_EM01Init_TypeDef em01Init = EMU_EM01INIT_DEFAULT;
+
+  if ((EMU_VScaleGet() == emuVScaleEM01_LowPower) != low) {
+    em01Init.vScaleEM01LowPowerVoltageEnable = low;
+    EMU_EM01Init(&em01Init);
+  }
+#else
+  (void)low;
+#endif
+}
+
+/**************************************************************************//**
+ * @brief Stop the DPLL, the HFRCODPLL keeps running at its last tuning
+ *****************************************************************************/
+static void stopDpll(void)
+{
+  if (dpllOn) {
+    DPLL0->EN_CLR = DPLL_EN_EN;
+#if defined(_DPLL_EN_DISABLING_MASK)
+    while (DPLL0->EN & _DPLL_EN_DISABLING_MASK) {
+    }
+#endif
+    dpllOn = false;
+  }
+}
+
+/**************************************************************************//**
+ * @brief Lock the DPLL for a profile, with the core on the HFXO
+ *****************************************************************************/
+static bool lockDpll(CLKPROFILE_Id_TypeDef id)
+{
+  const CLKPROFILE_Profile_TypeDef *p = &profiles[id];
+  CMU_DPLLInit_TypeDef dpllInit = {
+    p->frequency, p->dpllN, p->dpllM, cmuSelect_HFXO,
+    cmuDPLLEdgeSel_Fall, cmuDPLLLockMode_Freq, true, false
+  };
+  uint32_t tries;
+
+  stopDpll();
+
+  // CMU_DPLLLock() tunes the HFRCODPLL to the band of the frequency before
+  // it enables the DPLL, which then only has to pull in the last percent
+  dpllOn = true;
+  for (tries = 0; tries < CLKPROFILE_DPLL_TRIES; tries++) {
+    if (CMU_DPLLLock(&dpllInit)) {
+      counters.dpllLocks++;
+      return true;
+    }
+  }
+
+  stopDpll();
+  counters.dpllFails++;
+  return false;
+}
+
+/**************************************************************************//**
+ * @brief Set the clock divider of a USART for its clock now
+ *****************************************************************************/
+static void rebaud(Usart_t *u)
+{
+  uint32_t refFreq = CMU_ClockFreqGet(u->clock);
+  uint32_t i;
+
+  if (refFreq == u->refFreq) {
+    return;
+  }
+
+  for (i = 0; i < (sizeof(oversampling) / sizeof(oversampling[0])) - 1; i++) {
+    if (refFreq >= (oversampling[i].factor * u->baudrate)) {
+      break;
+    }
+  }
+
+  USART_BaudrateAsyncSet(u->usart, refFreq, u->baudrate, oversampling[i].ovs);
+  u->refFreq = refFreq;
+  counters.rebauds++;
+}
+
+/**************************************************************************//**
+ * @brief Set up the HFXO for the profiles that use it
+ *
+ * @param[in] hfxoInit
+ *    HFXO configuration of the board, such as CMU_HFXOINIT_WSTK_DEFAULT.
+ *    The HFXO must run at 39 MHz.
+ *
+ * @details
+ *    Leaves the clocks as they are until the first CLKPROFILE_Set().
+ *****************************************************************************/
+void CLKPROFILE_Init(const CMU_HFXOInit_TypeDef *hfxoInit)
+{
+  CMU_HFXOInit(hfxoInit);
+
+#if CLKPROFILE_HFXO_KEEP
+  CMU_OscillatorEnable(cmuOsc_HFXO, true, true);
+#endif
+
+  current = clkprofileCount;
+}
+
+/**************************************************************************//**
+ * @brief Keep the baud rate of a USART through profile switches
+ *
+ * @param[in] usart
+ *    The USART, set up for asynchronous operation.
+ *
+ * @param[in] clock
+ *    Its clock, such as cmuClock_USART0.
+ *
+ * @param[in] baudrate
+ *    The baud rate to keep.
+ *
+ * @return
+ *    false if CLKPROFILE_MAX_USARTS are already kept.
+ *****************************************************************************/
+bool CLKPROFILE_AddUsart(USART_TypeDef *usart, CMU_Clock_TypeDef clock,
+                         uint32_t baudrate)
+{
+  Usart_t *u;
+
+  if (usartCount >= CLKPROFILE_MAX_USARTS) {
+    return false;
+  }
+
+  u = &usarts[usartCount++];
+  u->usart = usart;
+  u->clock = clock;
+  u->baudrate = baudrate;
+  u->refFreq = 0;
+  rebaud(u);
+
+  return true;
+}
+
+/**************************************************************************//**
+ * @brief Switch to a profile
+ *
+ * @details
+ *    Runs with interrupts masked, from a few microseconds between the HFXO
+ *    profiles or between the HFRCODPLL bands to the HFXO startup time when
+ *    the HFXO is off.
+ *
+ * @return
+ *    false if the DPLL did not lock. The core is then left on the HFXO in
+ *    the radio profile.
+ *****************************************************************************/
+bool CLKPROFILE_Set(CLKPROFILE_Id_TypeDef id)
+{
+  const CLKPROFILE_Profile_TypeDef *p;
+  bool ok = true;
+  uint32_t i;
+  CORE_DECLARE_IRQ_STATE;
+
+  EFM_ASSERT(id < clkprofileCount);
+
+  if (id == current) {
+    return true;
+  }
+  p = &profiles[id];
+
+  CORE_ENTER_CRITICAL();
+
+  // A frame cut by the divider change would be garbled
+  for (i = 0; i < usartCount; i++) {
+    while (!(usarts[i].usart->STATUS & USART_STATUS_TXIDLE)) {
+    }
+  }
+
+  // Raise the voltage before the clock, and keep the PCLK within its limit
+  // at any SYSCLK while the SYSCLK moves
+  if (!p->lowVoltage) {
+    setVoltage(false);
+  }
+  CMU_ClockDivSet(cmuClock_PCLK, cmuClkDiv_2);
+
+  if ((p->source == cmuSelect_HFXO) || p->dpll) {
+    // Hold the HFXO on until the SYSCLK or the DPLL requests it
+    CMU_OscillatorEnable(cmuOsc_HFXO, true, true);
+    CMU_ClockSelectSet(cmuClock_SYSCLK, cmuSelect_HFXO);
+
+    if (p->dpll) {
+      ok = lockDpll(id);
+      if (ok) {
+        CMU_ClockSelectSet(cmuClock_SYSCLK, cmuSelect_HFRCODPLL);
+      } else {
+        id = clkprofileRadio;
+        p = &profiles[id];
+      }
+    } else {
+      stopDpll();
+    }
+  } else {
+    // The HFRCODPLL may be the SYSCLK, emlib raises the wait states first
+    stopDpll();
+    CMU_HFRCODPLLBandSet(p->band);
+    CMU_ClockSelectSet(cmuClock_SYSCLK, cmuSelect_HFRCODPLL);
+  }
+
+#if !CLKPROFILE_HFXO_KEEP
+  // On demand from here on, so it stops unless the profile uses it
+  CMU_OscillatorEnable(cmuOsc_HFXO, false, false);
+#endif
+
+  CMU_ClockDivSet(cmuClock_PCLK, p->pclkDiv);
+  if (p->lowVoltage) {
+    setVoltage(true);
+  }
+
+  for (i = 0; i < usartCount; i++) {
+    rebaud(&usarts[i]);
+  }
+
+  current = id;
+  counters.switches++;
+
+  CORE_EXIT_CRITICAL();
+
+  return ok;
+}
+
+/**************************************************************************//**
+ * @brief Get the profile in use, clkprofileCount before the first switch
+ *****************************************************************************/
+CLKPROFILE_Id_TypeDef CLKPROFILE_Get(void)
+{
+  return current;
+}
+
+/**************************************************************************//**
+ * @brief Get the settings of a profile
+ *****************************************************************************/
+const CLKPROFILE_Profile_TypeDef *CLKPROFILE_GetProfile(CLKPROFILE_Id_TypeDef id)
+{
+  EFM_ASSERT(id < clkprofileCount);
+  return &profiles[id];
+}
+
+/**************************************************************************//**
+ * @brief Get the counters
+ *****************************************************************************/
+void CLKPROFILE_GetCounters(CLKPROFILE_Counters_TypeDef *copy)
+{
+  CORE_DECLARE_IRQ_STATE;
+
+  CORE_ENTER_CRITICAL();
+  *copy = counters;
+  CORE_EXIT_CRITICAL();
+}
+
+/** @} (end group ClkProfile) */
+/** @} (end group kitdrv) */
@@ -0,0 +1,143 @@
+/***************************************************************************//**
+ * @file
+ * @brief Precomputed clock profiles with fast switching between them.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2022 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ******************************************************************************/
+
+#ifndef __CLKPROFILE_H
+#define __CLKPROFILE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "em_device.h"
+#include "em_cmu.h"
+
+/***************************************************************************//**
+ * @addtogroup kitdrv
+ * @{
+ ******************************************************************************/
+
+/***************************************************************************//**
+ * @addtogroup ClkProfile
+ * @brief Precomputed clock profiles with fast switching between them
+ * @details
+ *    A profile is a SYSCLK source and frequency with the PCLK divider and
+ *    the EM01 voltage scale that go with it. The table is fixed at build
+ *    time, DPLL factors included, so CLKPROFILE_Set() only writes
+ *    registers and waits for the oscillators:
+ *
+ *    - compute: 78 MHz, the HFRCODPLL locked to the HFXO by the DPLL
+ *    - radio: 39 MHz, the HFXO
+ *    - audio: 19 MHz, the HFRCODPLL free running
+ *    - idle: 1 MHz, the HFRCODPLL free running
+ *
+ *    The core never runs from an oscillator that is still settling. It
+ *    moves to the HFXO while the DPLL locks, and CMU_DPLLLock() presets
+ *    the HFRCODPLL band to the target first, so the lock takes tens of
+ *    microseconds rather than a search from the current band. The flash wait
+ *    states are raised by emlib before each clock goes up and lowered
+ *    after it comes down. The voltage is raised before the clock and
+ *    lowered after it.
+ *
+ *    The HFXO runs on demand, only while a profile uses it, unless
+ *    CLKPROFILE_HFXO_KEEP is set. Starting it again takes a few hundred
+ *    microseconds and is most of the time of a switch from the idle or
+ *    audio profile to the radio or compute profile.
+ *
+ *    USARTs added with CLKPROFILE_AddUsart() keep their baud rate: the
+ *    switch waits for their transmitters to go idle, with interrupts
+ *    masked so that no new frame starts, and sets their clock dividers for
+ *    the new clock, with a lower oversampling where the clock is too slow
+ *    for 16. A frame being received during a switch can be lost, so
+ *    switch between messages.
+ * @{
+ ******************************************************************************/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** USARTs that keep their baud rate through a switch */
+#ifndef CLKPROFILE_MAX_USARTS
+#define CLKPROFILE_MAX_USARTS   2
+#endif
+
+/** Keep the HFXO running in every profile, for faster switches */
+#ifndef CLKPROFILE_HFXO_KEEP
+#define CLKPROFILE_HFXO_KEEP    0
+#endif
+
+/** DPLL lock attempts before CLKPROFILE_Set() gives up */
+#ifndef CLKPROFILE_DPLL_TRIES
+#define CLKPROFILE_DPLL_TRIES   3
+#endif
+
+/** Profiles */
+typedef enum {
+  clkprofileCompute,      /**< 78 MHz, HFRCODPLL locked to the HFXO */
+  clkprofileRadio,        /**< 39 MHz, HFXO */
+  clkprofileAudio,        /**< 19 MHz, HFRCODPLL free running */
+  clkprofileIdle,         /**< 1 MHz, HFRCODPLL free running */
+  clkprofileCount
+} CLKPROFILE_Id_TypeDef;
+
+/** One profile of the table */
+typedef struct {
+  uint32_t                  frequency;  /**< SYSCLK in Hz */
+  CMU_Select_TypeDef        source;     /**< cmuSelect_HFXO or cmuSelect_HFRCODPLL */
+  bool                      dpll;       /**< Lock the HFRCODPLL to the HFXO */
+  uint16_t                  dpllN;      /**< DPLL factor N, with dpll */
+  uint16_t                  dpllM;      /**< DPLL factor M, with dpll */
+  CMU_HFRCODPLLFreq_TypeDef band;       /**< Band of a free running HFRCODPLL */
+  CMU_ClkDiv_Enum           pclkDiv;    /**< PCLK divider, PCLK at most 50 MHz */
+  bool                      lowVoltage; /**< EM01 voltage scale 1, up to 40 MHz */
+} CLKPROFILE_Profile_TypeDef;
+
+/** Counters, all only ever count up */
+typedef struct {
+  uint32_t switches;      /**< Profile changes */
+  uint32_t dpllLocks;     /**< DPLL locks */
+  uint32_t dpllFails;     /**< Switches left on the HFXO, the DPLL did not lock */
+  uint32_t rebauds;       /**< USART clock dividers set */
+} CLKPROFILE_Counters_TypeDef;
+
+void CLKPROFILE_Init(const CMU_HFXOInit_TypeDef *hfxoInit);
+bool CLKPROFILE_AddUsart(USART_TypeDef *usart, CMU_Clock_TypeDef clock,
+                         uint32_t baudrate);
+bool CLKPROFILE_Set(CLKPROFILE_Id_TypeDef id);
+CLKPROFILE_Id_TypeDef CLKPROFILE_Get(void);
+const CLKPROFILE_Profile_TypeDef *CLKPROFILE_GetProfile(CLKPROFILE_Id_TypeDef id);
+void CLKPROFILE_GetCounters(CLKPROFILE_Counters_TypeDef *counters);
+
+#ifdef __cplusplus
+}
+#endif
+
+/** @} (end group ClkProfile) */
+/** @} (end group kitdrv) */
+
+#endif
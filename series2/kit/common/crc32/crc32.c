@@ -0,0 +1,191 @@
+/***************************************************************************//**
+ * @file
+ * @brief Table driven software CRC-32 matching the GPCRC.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2022 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ******************************************************************************/
+
+#include "crc32.h"
+
+/***************************************************************************//**
+ * @addtogroup kitdrv
+ * @{
+ ******************************************************************************/
+
+/***************************************************************************//**
+ * @addtogroup Crc32
+ * @{
+ ******************************************************************************/
+
+// table[k][i] is the CRC of byte i followed by k zero bytes
+static uint32_t table[CRC32_SLICES][256];
+
+/**************************************************************************//**
+ * @brief Build the lookup tables, call once before the table variants
+ *****************************************************************************/
+void CRC32_Init(void)
+{
+  uint32_t remainder;
+  unsigned int i, k;
+
+  for (i = 0; i < 256; i++) {
+    remainder = (uint32_t)i << 24;
+    for (k = 0; k < 8; k++) {
+      if (remainder & 0x80000000UL) {
+        remainder = (remainder << 1) ^ CRC32_POLYNOMIAL;
+      } else {
+        remainder = (remainder << 1);
+      }
+    }
+    table[0][i] = remainder;
+  }
+
+  // Each further table adds one zero byte to the one before
+  for (k = 1; k < CRC32_SLICES; k++) {
+    for (i = 0; i < 256; i++) {
+      remainder = table[k - 1][i];
+      table[k][i] = (remainder << 8) ^ table[0][remainder >> 24];
+    }
+  }
+}
+
+/**************************************************************************//**
+ * @brief CRC a buffer one bit at a time, needs no tables
+ * @param[in] crc CRC32_PRESET or the result of the previous block
+ * @param[in] data Data, no alignment needed
+ * @param[in] length Number of bytes
+ * @return Updated CRC
+ *****************************************************************************/
+uint32_t CRC32_Bitwise(uint32_t crc, const void *data, size_t length)
+{
+  const uint8_t *p = data;
+  unsigned int bit;
+
+  while (length--) {
+    crc ^= (uint32_t)*p++ << 24;
+    for (bit = 0; bit < 8; bit++) {
+      if (crc & 0x80000000UL) {
+        crc = (crc << 1) ^ CRC32_POLYNOMIAL;
+      } else {
+        crc = (crc << 1);
+      }
+    }
+  }
+  return crc;
+}
+
+/**************************************************************************//**
+ * @brief CRC a buffer one byte at a time with a 256 entry table
+ * @param[in] crc CRC32_PRESET or the result of the previous block
+ * @param[in] data Data, no alignment needed
+ * @param[in] length Number of bytes
+ * @return Updated CRC
+ *****************************************************************************/
+uint32_t CRC32_Table(uint32_t crc, const void *data, size_t length)
+{
+  const uint8_t *p = data;
+
+  while (length--) {
+    crc = (crc << 8) ^ table[0][(crc >> 24) ^ *p++];
+  }
+  return crc;
+}
+
+#if (CRC32_SLICES >= 4)
+// Fold four message bytes into the CRC with one lookup per byte
+#define SLICE4(crc, p)                                     \
+  do {                                                     \
+    (crc) ^= ((uint32_t)(p)[0] << 24) | ((uint32_t)(p)[1] << 16) \
+             | ((uint32_t)(p)[2] << 8) | (uint32_t)(p)[3];  \
+    (crc) = table[3][(crc) >> 24]                          \
+            ^ table[2][((crc) >> 16) & 0xFF]               \
+            ^ table[1][((crc) >> 8) & 0xFF]                \
+            ^ table[0][(crc) & 0xFF];                      \
+  } while (0)
+#endif
+
+/**************************************************************************//**
+ * @brief CRC a buffer four bytes at a time
+ * @details
+ *   The bytes are loaded one at a time, so the result does not depend on
+ *   the alignment or on the byte order of the CPU.
+ * @param[in] crc CRC32_PRESET or the result of the previous block
+ * @param[in] data Data, no alignment needed
+ * @param[in] length Number of bytes
+ * @return Updated CRC
+ *****************************************************************************/
+uint32_t CRC32_Slice4(uint32_t crc, const void *data, size_t length)
+{
+#if (CRC32_SLICES >= 4)
+  const uint8_t *p = data;
+
+  while (length >= 4) {
+    SLICE4(crc, p);
+    p += 4;
+    length -= 4;
+  }
+  return CRC32_Table(crc, p, length);
+#else
+  return CRC32_Table(crc, data, length);
+#endif
+}
+
+/**************************************************************************//**
+ * @brief CRC a buffer eight bytes at a time
+ * @param[in] crc CRC32_PRESET or the result of the previous block
+ * @param[in] data Data, no alignment needed
+ * @param[in] length Number of bytes
+ * @return Updated CRC
+ *****************************************************************************/
+uint32_t CRC32_Slice8(uint32_t crc, const void *data, size_t length)
+{
+#if (CRC32_SLICES >= 8)
+  const uint8_t *p = data;
+
+  while (length >= 8) {
+    // The CRC is folded into the first four bytes, the second four only
+    // need their own contribution shifted past the remaining bytes
+    crc ^= ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16)
+           | ((uint32_t)p[2] << 8) | (uint32_t)p[3];
+    crc = table[7][crc >> 24]
+          ^ table[6][(crc >> 16) & 0xFF]
+          ^ table[5][(crc >> 8) & 0xFF]
+          ^ table[4][crc & 0xFF]
+          ^ table[3][p[4]]
+          ^ table[2][p[5]]
+          ^ table[1][p[6]]
+          ^ table[0][p[7]];
+    p += 8;
+    length -= 8;
+  }
+  return CRC32_Slice4(crc, p, length);
+#else
+  return CRC32_Slice4(crc, data, length);
+#endif
+}
+
+/** @} (end group Crc32) */
+/** @} (end group kitdrv) */
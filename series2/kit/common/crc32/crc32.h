@@ -0,0 +1,91 @@
+/***************************************************************************//**
+ * @file
+ * @brief Table driven software CRC-32 matching the GPCRC.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2022 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ******************************************************************************/
+
+#ifndef __CRC32_H
+#define __CRC32_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/***************************************************************************//**
+ * @addtogroup kitdrv
+ * @{
+ ******************************************************************************/
+
+/***************************************************************************//**
+ * @addtogroup Crc32
+ * @brief Software CRC-32 with bitwise, table and slice-by-4/8 variants
+ * @details
+ *    All variants give the same result as the GPCRC set up as in the
+ *    gpcrc_software example: polynomial 0x04C11DB7, reverseBits set and
+ *    the result read with GPCRC_DataReadBitReversed(). That is a non
+ *    reflected (MSB first) CRC over the bytes in memory order, with no
+ *    final XOR. Pass the preset (0xFFFFFFFF) as crc for the first block and
+ *    the previous result for each following block.
+ *
+ *    The code is plain C99 without device headers, so it builds for
+ *    series 0 parts without a GPCRC and for host tools.
+ *
+ *    CRC32_Init() builds CRC32_SLICES tables of 256 words in RAM: 8 KB for
+ *    slice-by-8, 4 KB for slice-by-4 and 1 KB when only the byte table is
+ *    used. Define CRC32_SLICES as 1 or 4 on small parts; the slice-by-8
+ *    and slice-by-4 functions then fall back to the widest variant built.
+ * @{
+ ******************************************************************************/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef CRC32_SLICES
+#define CRC32_SLICES        8           /**< Tables built, 1, 4 or 8 */
+#endif
+
+#if (CRC32_SLICES != 1) && (CRC32_SLICES != 4) && (CRC32_SLICES != 8)
+#error "CRC32_SLICES must be 1, 4 or 8"
+#endif
+
+#define CRC32_POLYNOMIAL    0x04C11DB7UL  /**< IEEE 802.3 polynomial */
+#define CRC32_PRESET        0xFFFFFFFFUL  /**< Start value, as the GPCRC init value */
+
+void      CRC32_Init(void);
+uint32_t  CRC32_Bitwise(uint32_t crc, const void *data, size_t length);
+uint32_t  CRC32_Table(uint32_t crc, const void *data, size_t length);
+uint32_t  CRC32_Slice4(uint32_t crc, const void *data, size_t length);
+uint32_t  CRC32_Slice8(uint32_t crc, const void *data, size_t length);
+
+#ifdef __cplusplus
+}
+#endif
+
+/** @} (end group Crc32) */
+/** @} (end group kitdrv) */
+
+#endif
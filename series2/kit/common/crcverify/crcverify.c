@@ -0,0 +1,354 @@
+/***************************************************************************//**
+ * @file
+ * @brief Verify memory regions against a CRC-32 with the GPCRC and LDMA.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2022 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ******************************************************************************/
+
+#include <stddef.h>
+#include "em_cmu.h"
+#include "em_gpcrc.h"
+#include "em_ldma.h"
+#include "crcverify.h"
+
+/***************************************************************************//**
+ * @addtogroup kitdrv
+ * @{
+ ******************************************************************************/
+
+/***************************************************************************//**
+ * @addtogroup CrcVerify
+ * @{
+ ******************************************************************************/
+
+// Longest transfer of a single descriptor, in words
+#define CHUNK_WORDS     ((_LDMA_CH_CTRL_XFERCNT_MASK >> _LDMA_CH_CTRL_XFERCNT_SHIFT) + 1)
+
+// Whole chunks per transfer: the first one plus one descriptor repeated by
+// the channel loop counter
+#define MAX_CHUNKS      (1 + (_LDMA_CH_LOOP_LOOPCNT_MASK >> _LDMA_CH_LOOP_LOOPCNT_SHIFT) + 1)
+
+// Longest region handed to the LDMA at once, longer ones are split
+#define MAX_TRANSFER    (MAX_CHUNKS * CHUNK_WORDS * 4)
+
+// Leading bytes, first chunk, looped chunks, remaining words, trailing
+// bytes and the result read
+#define DESCRIPTORS     6
+
+static CRCVERIFY_Init_t   config;
+static LDMA_Descriptor_t  descList[DESCRIPTORS];
+
+static volatile uint32_t            gpcrcData;      // Written by the last descriptor
+static uint32_t                     runningCrc;     // GPCRC register value between transfers
+static uint32_t                     position;       // Bytes checked in this pass
+static uint32_t                     transferLength; // Bytes in the running transfer
+static bool                         chained;        // Start(): IRQ starts the next transfer
+static volatile bool                running;        // LDMA transfer in progress
+static volatile bool                busy;           // Pass in progress
+static volatile CRCVERIFY_Status_t  status;
+static volatile uint32_t            lastCrc;
+
+/***************************************************************************//**
+ * @brief
+ *   Fill in a descriptor that feeds count words or bytes to the GPCRC.
+ *   The destination does not increment, every unit goes to the same GPCRC
+ *   input register.
+ ******************************************************************************/
+static void setInput(LDMA_Descriptor_t *desc, const void *src,
+                     uint32_t count, bool word)
+{
+  if (word) {
+    *desc = (LDMA_Descriptor_t)LDMA_DESCRIPTOR_LINKREL_M2M_WORD(src, &GPCRC->INPUTDATA, count, 1);
+  } else {
+    *desc = (LDMA_Descriptor_t)LDMA_DESCRIPTOR_LINKREL_M2M_BYTE(src, &GPCRC->INPUTDATABYTE, count, 1);
+  }
+  desc->xfer.dstInc = ldmaCtrlDstIncNone;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Feed length bytes from src to the GPCRC, continuing from runningCrc.
+ *   length is at most MAX_TRANSFER.
+ ******************************************************************************/
+static void startTransfer(const uint8_t *src, uint32_t length)
+{
+  uint32_t head = (4 - ((uint32_t)src & 3)) & 3;
+  uint32_t words, tail, chunks, rest;
+  unsigned int n = 0;
+
+  if (head > length) {
+    head = length;
+  }
+  words  = (length - head) / 4;
+  tail   = (length - head) % 4;
+  chunks = words / CHUNK_WORDS;
+  rest   = words % CHUNK_WORDS;
+
+  // Loop count for the repeated descriptor, unused if there is none
+  LDMA_TransferCfg_t cfg = LDMA_TRANSFER_CFG_MEMORY_LOOP(chunks > 1 ? chunks - 2 : 0);
+
+  if (head > 0) {
+    setInput(&descList[n++], src, head, false);
+    src += head;
+  }
+  if (chunks > 0) {
+    setInput(&descList[n++], src, CHUNK_WORDS, true);
+    src += CHUNK_WORDS * 4;
+  }
+  if (chunks > 1) {
+    // Repeats on itself, each time continuing where the last chunk stopped
+    setInput(&descList[n], NULL, CHUNK_WORDS, true);
+    descList[n].xfer.srcAddrMode = ldmaCtrlSrcAddrModeRel;
+    descList[n].xfer.decLoopCnt  = 1;
+    descList[n].xfer.linkAddr    = 0;
+    n++;
+    src += (chunks - 1) * CHUNK_WORDS * 4;
+  }
+  if (rest > 0) {
+    setInput(&descList[n++], src, rest, true);
+    src += rest * 4;
+  }
+  if (tail > 0) {
+    setInput(&descList[n++], src, tail, false);
+  }
+
+  // Copy the CRC out and raise the channel interrupt
+  descList[n] = (LDMA_Descriptor_t)LDMA_DESCRIPTOR_SINGLE_M2M_WORD(&GPCRC->DATA, &gpcrcData, 1);
+  descList[n].xfer.doneIfs = true;
+
+  transferLength = length;
+  running        = true;
+
+  // Restore the running CRC, other code may have used the GPCRC
+  GPCRC_InitValueSet(GPCRC, runningCrc);
+  GPCRC_Start(GPCRC);
+
+  LDMA_StartTransfer(config.channel, &cfg, descList);
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Start the next transfer of the current pass
+ ******************************************************************************/
+static void startNext(uint32_t maxLength)
+{
+  uint32_t length = config.length - position;
+
+  if (length > maxLength) {
+    length = maxLength;
+  }
+  startTransfer((const uint8_t *)config.start + position, length);
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Begin a new pass over the region
+ ******************************************************************************/
+static void beginPass(void)
+{
+  position   = 0;
+  runningCrc = 0xFFFFFFFFUL;
+  busy       = true;
+  if (status == crcVerifyIdle) {
+    status = crcVerifyBusy;
+  }
+}
+
+/***************************************************************************//**
+ * @brief
+ *   A pass is complete, report the result
+ ******************************************************************************/
+static void endPass(void)
+{
+  bool passed;
+
+  lastCrc = ~runningCrc;
+  passed  = (lastCrc == config.expected);
+  status  = passed ? crcVerifyPassed : crcVerifyFailed;
+  busy    = false;
+
+  if (config.callback != NULL) {
+    config.callback(passed, lastCrc);
+  }
+}
+
+/**************************************************************************//**
+ * @brief Set up the GPCRC for the region check
+ * @details
+ *   The GPCRC is configured for CRC-32 with polynomial 0x04C11DB7. A
+ *   sliceSize of 0 lets CRCVERIFY_Slice() check the whole region at once.
+ * @param[in] init Region configuration, copied
+ * @return false if the configuration is not supported
+ *****************************************************************************/
+bool CRCVERIFY_Init(const CRCVERIFY_Init_t *init)
+{
+  GPCRC_Init_TypeDef gpcrcInit = GPCRC_INIT_DEFAULT;
+
+  if (init->channel >= DMA_CHAN_COUNT) {
+    return false;
+  }
+
+  config = *init;
+  if ((config.sliceSize == 0) || (config.sliceSize > MAX_TRANSFER)) {
+    config.sliceSize = MAX_TRANSFER;
+  }
+
+  busy    = false;
+  running = false;
+  status  = crcVerifyIdle;
+  lastCrc = 0;
+
+  CMU_ClockEnable(cmuClock_GPCRC, true);
+
+  // Reflected CRC-32: polynomial 0x04C11DB7, data shifted in LSB first
+  gpcrcInit.crcPoly   = 0x04C11DB7;
+  gpcrcInit.initValue = 0xFFFFFFFFUL;
+  gpcrcInit.autoInit  = false;
+  GPCRC_Init(GPCRC, &gpcrcInit);
+
+  return true;
+}
+
+/**************************************************************************//**
+ * @brief Check the whole region in the background
+ * @details
+ *   The region is fed to the GPCRC back to back, split into transfers the
+ *   LDMA can handle. The callback is called when done.
+ * @return false if a pass is already in progress
+ *****************************************************************************/
+bool CRCVERIFY_Start(void)
+{
+  if (busy) {
+    return false;
+  }
+
+  beginPass();
+  if (config.length == 0) {
+    endPass();
+    return true;
+  }
+  chained = true;
+  startNext(MAX_TRANSFER);
+
+  return true;
+}
+
+/**************************************************************************//**
+ * @brief Check the next sliceSize bytes of the region
+ * @details
+ *   Call from the idle loop. Starts a new pass after the previous one has
+ *   completed, the callback is called at the end of each pass.
+ * @return false if the previous slice is still running
+ *****************************************************************************/
+bool CRCVERIFY_Slice(void)
+{
+  if (running) {
+    return false;
+  }
+
+  if (!busy) {
+    beginPass();
+    if (config.length == 0) {
+      endPass();
+      return true;
+    }
+  }
+  chained = false;
+  startNext(config.sliceSize);
+
+  return true;
+}
+
+/**************************************************************************//**
+ * @brief Check whether a pass over the region is in progress
+ *****************************************************************************/
+bool CRCVERIFY_IsBusy(void)
+{
+  return busy;
+}
+
+/**************************************************************************//**
+ * @brief Check whether an LDMA transfer is running
+ * @details
+ *   Use with interrupts masked before sleeping, the end of the transfer
+ *   raises the LDMA interrupt that wakes the core.
+ *****************************************************************************/
+bool CRCVERIFY_IsRunning(void)
+{
+  return running;
+}
+
+/**************************************************************************//**
+ * @brief Get the result of the last complete pass
+ * @details
+ *   The result of a pass stays valid while the next pass is running, so the
+ *   status only returns to crcVerifyBusy before the first pass completes.
+ *****************************************************************************/
+CRCVERIFY_Status_t CRCVERIFY_GetStatus(void)
+{
+  return status;
+}
+
+/**************************************************************************//**
+ * @brief Get the CRC-32 calculated by the last complete pass
+ *****************************************************************************/
+uint32_t CRCVERIFY_GetCrc(void)
+{
+  return lastCrc;
+}
+
+/**************************************************************************//**
+ * @brief Handle the LDMA interrupt of the check channel
+ * @details
+ *   Returns without doing anything if the channel has not completed, so
+ *   several LDMA users can share LDMA_IRQHandler().
+ *****************************************************************************/
+void CRCVERIFY_IRQHandler(void)
+{
+  uint32_t mask = 1UL << config.channel;
+
+  if (!(LDMA_IntGet() & mask)) {
+    return;
+  }
+  LDMA_IntClear(mask);
+
+  if (!running) {
+    return;
+  }
+  running = false;
+
+  runningCrc = gpcrcData;
+  position  += transferLength;
+
+  if (position >= config.length) {
+    endPass();
+  } else if (chained) {
+    startNext(MAX_TRANSFER);
+  }
+}
+
+/** @} (end group CrcVerify) */
+/** @} (end group kitdrv) */
@@ -0,0 +1,107 @@
+/***************************************************************************//**
+ * @file
+ * @brief Verify memory regions against a CRC-32 with the GPCRC and LDMA.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2022 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ******************************************************************************/
+
+#ifndef __CRCVERIFY_H
+#define __CRCVERIFY_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "em_device.h"
+
+/***************************************************************************//**
+ * @addtogroup kitdrv
+ * @{
+ ******************************************************************************/
+
+/***************************************************************************//**
+ * @addtogroup CrcVerify
+ * @brief Memory region integrity check with the GPCRC fed by the LDMA
+ * @details
+ *    Checks a region of flash or RAM, such as a firmware image, against an
+ *    expected CRC-32 (polynomial 0x04C11DB7, reflected, preset and final
+ *    XOR 0xFFFFFFFF, the value zlib and most image tools give).
+ *
+ *    The LDMA feeds the whole region to the GPCRC with block transfers
+ *    while the core runs other code or sleeps. A region can be checked in
+ *    one go with CRCVERIFY_Start(), for example while the rest of the
+ *    system is initialized, or CRCVERIFY_Slice() can be called from an idle
+ *    loop to check sliceSize bytes at a time. The running CRC is kept
+ *    between slices, so other code can use the GPCRC in between. After the
+ *    last slice the next call starts over at the start of the region, so
+ *    calling it from the idle loop re-verifies the region continuously.
+ *
+ *    The result is given to the callback and can be polled with
+ *    CRCVERIFY_GetStatus(). The application calls LDMA_Init() and calls
+ *    CRCVERIFY_IRQHandler() from LDMA_IRQHandler().
+ * @{
+ ******************************************************************************/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Check status */
+typedef enum {
+  crcVerifyIdle,          /**< Not started */
+  crcVerifyBusy,          /**< Region partly checked */
+  crcVerifyPassed,        /**< Last complete pass matched */
+  crcVerifyFailed         /**< Last complete pass did not match */
+} CRCVERIFY_Status_t;
+
+/** Called from CRCVERIFY_IRQHandler() after each complete pass */
+typedef void (*CRCVERIFY_Callback_t)(bool passed, uint32_t crc);
+
+/** Region configuration */
+typedef struct {
+  unsigned int          channel;      /**< LDMA channel */
+  const void            *start;       /**< First byte, no alignment needed */
+  uint32_t              length;       /**< Number of bytes */
+  uint32_t              expected;     /**< Expected CRC-32 */
+  uint32_t              sliceSize;    /**< Bytes per CRCVERIFY_Slice() call */
+  CRCVERIFY_Callback_t  callback;     /**< Completion callback, may be NULL */
+} CRCVERIFY_Init_t;
+
+bool                CRCVERIFY_Init(const CRCVERIFY_Init_t *init);
+bool                CRCVERIFY_Start(void);
+bool                CRCVERIFY_Slice(void);
+bool                CRCVERIFY_IsBusy(void);
+bool                CRCVERIFY_IsRunning(void);
+CRCVERIFY_Status_t  CRCVERIFY_GetStatus(void);
+uint32_t            CRCVERIFY_GetCrc(void);
+void                CRCVERIFY_IRQHandler(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+/** @} (end group CrcVerify) */
+/** @} (end group kitdrv) */
+
+#endif
@@ -0,0 +1,201 @@
+/***************************************************************************//**
+ * @file
+ * @brief DCDC mode manager driven by workload hints.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2022 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ******************************************************************************/
+
+#include "em_core.h"
+#include "em_emu.h"
+#include "dcdcmgr.h"
+
+/***************************************************************************//**
+ * @addtogroup kitdrv
+ * @{
+ ******************************************************************************/
+
+/***************************************************************************//**
+ * @addtogroup DcdcMgr
+ * @{
+ ******************************************************************************/
+
+#if !defined(DCDC_PRESENT)
+#error "The DCDC manager needs a DCDC"
+#endif
+
+// Mode each hint needs
+static const DCDCMGR_Mode_TypeDef hintMode[dcdcmgrHintCount] = {
+  [dcdcmgrHintFlashErase]   = dcdcmgrModeLowNoise,
+  [dcdcmgrHintRadio]        = dcdcmgrModeLowNoise,
+  [dcdcmgrHintAdcPrecision] = dcdcmgrModeBypass,
+};
+
+// Requests held per hint
+static uint8_t held[dcdcmgrHintCount];
+
+static DCDCMGR_Mode_TypeDef mode;
+
+#if defined(_DCDC_EM01CTRL0_DRVSPEED_MASK)
+// EM01CTRL0 of the low power mode, as DCDCMGR_Init() left it
+static uint32_t lowPowerEm01;
+#endif
+
+static DCDCMGR_Counters_TypeDef counters;
+
+/**************************************************************************//**
+ * @brief Set the EM01 peak current and drive speed of the regulation
+ *****************************************************************************/
+static void setRegulation(DCDCMGR_Mode_TypeDef to)
+{
+#if defined(_DCDC_EM01CTRL0_DRVSPEED_MASK)
+  uint32_t em01 = lowPowerEm01;
+
+  if (to == dcdcmgrModeLowNoise) {
+    em01 = (em01 & ~(_DCDC_EM01CTRL0_IPKVAL_MASK | _DCDC_EM01CTRL0_DRVSPEED_MASK))
+           | ((uint32_t)DCDCMGR_LOWNOISE_PEAK << _DCDC_EM01CTRL0_IPKVAL_SHIFT)
+           | ((uint32_t)emuDcdcDriveSpeed_BestEmi << _DCDC_EM01CTRL0_DRVSPEED_SHIFT);
+  }
+
+  DCDC->LOCK = DCDC_LOCK_LOCKKEY_UNLOCKKEY;
+  DCDC->EM01CTRL0 = em01;
+#else
+  (void)to;
+#endif
+}
+
+/**************************************************************************//**
+ * @brief Move the DCDC to the mode the held requests need
+ *****************************************************************************/
+static void update(void)
+{
+  DCDCMGR_Mode_TypeDef to = dcdcmgrModeLowPower;
+  uint32_t i;
+
+  for (i = 0; i < dcdcmgrHintCount; i++) {
+    if (held[i] && (hintMode[i] > to)) {
+      to = hintMode[i];
+    }
+  }
+
+  if (to == mode) {
+    return;
+  }
+
+  if (to == dcdcmgrModeBypass) {
+    EMU_DCDCModeSet(emuDcdcMode_Bypass);
+  } else {
+    // Settle the regulation settings before the DCDC starts switching
+    setRegulation(to);
+    if (mode == dcdcmgrModeBypass) {
+      EMU_DCDCModeSet(emuDcdcMode_Regulation);
+    }
+  }
+
+  mode = to;
+  counters.entered[to]++;
+}
+
+/**************************************************************************//**
+ * @brief Start the DCDC in the low power mode
+ *
+ * @param[in] dcdcInit
+ *    DCDC configuration of the board, such as EMU_DCDCINIT_WSTK_DEFAULT,
+ *    with the EM01 settings of the low power mode. It must select
+ *    regulation.
+ *****************************************************************************/
+void DCDCMGR_Init(const EMU_DCDCInit_TypeDef *dcdcInit)
+{
+  uint32_t i;
+
+  EMU_DCDCInit(dcdcInit);
+
+#if defined(_DCDC_EM01CTRL0_DRVSPEED_MASK)
+  lowPowerEm01 = DCDC->EM01CTRL0;
+#endif
+
+  for (i = 0; i < dcdcmgrHintCount; i++) {
+    held[i] = 0;
+  }
+  mode = dcdcmgrModeLowPower;
+}
+
+/**************************************************************************//**
+ * @brief Announce a workload, returns once the DCDC is in its mode
+ *****************************************************************************/
+void DCDCMGR_Request(DCDCMGR_Hint_TypeDef hint)
+{
+  CORE_DECLARE_IRQ_STATE;
+
+  EFM_ASSERT(hint < dcdcmgrHintCount);
+
+  CORE_ENTER_CRITICAL();
+  EFM_ASSERT(held[hint] < UINT8_MAX);
+  held[hint]++;
+  counters.requests[hint]++;
+  update();
+  CORE_EXIT_CRITICAL();
+}
+
+/**************************************************************************//**
+ * @brief End a workload announced with DCDCMGR_Request()
+ *****************************************************************************/
+void DCDCMGR_Release(DCDCMGR_Hint_TypeDef hint)
+{
+  CORE_DECLARE_IRQ_STATE;
+
+  EFM_ASSERT(hint < dcdcmgrHintCount);
+
+  CORE_ENTER_CRITICAL();
+  EFM_ASSERT(held[hint] > 0);
+  if (held[hint] > 0) {
+    held[hint]--;
+  }
+  update();
+  CORE_EXIT_CRITICAL();
+}
+
+/**************************************************************************//**
+ * @brief Get the mode the DCDC is in
+ *****************************************************************************/
+DCDCMGR_Mode_TypeDef DCDCMGR_GetMode(void)
+{
+  return mode;
+}
+
+/**************************************************************************//**
+ * @brief Get the counters
+ *****************************************************************************/
+void DCDCMGR_GetCounters(DCDCMGR_Counters_TypeDef *copy)
+{
+  CORE_DECLARE_IRQ_STATE;
+
+  CORE_ENTER_CRITICAL();
+  *copy = counters;
+  CORE_EXIT_CRITICAL();
+}
+
+/** @} (end group DcdcMgr) */
+/** @} (end group kitdrv) */
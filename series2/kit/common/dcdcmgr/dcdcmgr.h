@@ -0,0 +1,113 @@
+/***************************************************************************//**
+ * @file
+ * @brief DCDC mode manager driven by workload hints.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2022 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ******************************************************************************/
+
+#ifndef __DCDCMGR_H
+#define __DCDCMGR_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "em_device.h"
+#include "em_emu.h"
+
+/***************************************************************************//**
+ * @addtogroup kitdrv
+ * @{
+ ******************************************************************************/
+
+/***************************************************************************//**
+ * @addtogroup DcdcMgr
+ * @brief DCDC mode manager driven by workload hints
+ * @details
+ *    Drivers tell the manager what is about to happen with
+ *    DCDCMGR_Request() and DCDCMGR_Release() around the work, and the
+ *    manager runs the DCDC in the mode that the most demanding request
+ *    needs, and in the low power mode when there is none:
+ *
+ *    - low power: regulation with the EM01 settings passed to
+ *      DCDCMGR_Init(), tuned for efficiency at light load
+ *    - low noise: regulation with the slowest switch edges and the full
+ *      peak current, for less ripple and EMI and headroom for load steps,
+ *      asked for by a flash erase or a radio burst
+ *    - bypass: the DCDC does not switch at all and DVDD is the supply, for
+ *      precision ADC sampling; it draws the supply current unconverted,
+ *      so only for as long as the sampling lasts
+ *
+ *    Bypass wins over low noise, and low noise over low power. Requests
+ *    are counted per hint and may nest. DCDCMGR_Request() returns once
+ *    the DCDC is in the mode, so the work can start at once; it may be
+ *    called from interrupts. The EM23 settings are left as they are.
+ * @{
+ ******************************************************************************/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** EM01 peak current in the low noise mode */
+#ifndef DCDCMGR_LOWNOISE_PEAK
+#define DCDCMGR_LOWNOISE_PEAK     emuDcdcPeakCurrent_Load60mA
+#endif
+
+/** Modes, in rising order of precedence */
+typedef enum {
+  dcdcmgrModeLowPower,      /**< Regulation, settings from DCDCMGR_Init() */
+  dcdcmgrModeLowNoise,      /**< Regulation, slow edges, full peak current */
+  dcdcmgrModeBypass,        /**< No switching, DVDD is the supply */
+  dcdcmgrModeCount
+} DCDCMGR_Mode_TypeDef;
+
+/** Workloads a driver may announce */
+typedef enum {
+  dcdcmgrHintFlashErase,    /**< Flash erase or write, low noise */
+  dcdcmgrHintRadio,         /**< Radio burst, low noise */
+  dcdcmgrHintAdcPrecision,  /**< Precision ADC sampling, bypass */
+  dcdcmgrHintCount
+} DCDCMGR_Hint_TypeDef;
+
+/** Counters, all only ever count up */
+typedef struct {
+  uint32_t requests[dcdcmgrHintCount];  /**< DCDCMGR_Request() calls per hint */
+  uint32_t entered[dcdcmgrModeCount];   /**< Switches into each mode */
+} DCDCMGR_Counters_TypeDef;
+
+void DCDCMGR_Init(const EMU_DCDCInit_TypeDef *dcdcInit);
+void DCDCMGR_Request(DCDCMGR_Hint_TypeDef hint);
+void DCDCMGR_Release(DCDCMGR_Hint_TypeDef hint);
+DCDCMGR_Mode_TypeDef DCDCMGR_GetMode(void);
+void DCDCMGR_GetCounters(DCDCMGR_Counters_TypeDef *copy);
+
+#ifdef __cplusplus
+}
+#endif
+
+/** @} (end group DcdcMgr) */
+/** @} (end group kitdrv) */
+
+#endif
@@ -0,0 +1,238 @@
+/***************************************************************************//**
+ * @file
+ * @brief PL230 DMA buffer ring for continuous peripheral streaming.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2022 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ******************************************************************************/
+
+
+#include <stddef.h>
+#include "em_core.h"
+#include "dmastream.h"
+
+/***************************************************************************//**
+ * @addtogroup kitdrv
+ * @{
+ ******************************************************************************/
+
+/***************************************************************************//**
+ * @addtogroup DmaStream
+ * @{
+ ******************************************************************************/
+
+/**************************************************************************//**
+ * @brief Get the destination of a buffer's DMA cycle
+ *****************************************************************************/
+static void *dstOf(DMASTREAM_Stream_t *stream, unsigned int index)
+{
+  if (stream->init.direction == dmaStreamPeriToMem) {
+    return stream->init.buffers[index];
+  }
+  return (void *)stream->init.periAddr;
+}
+
+/**************************************************************************//**
+ * @brief Get the source of a buffer's DMA cycle
+ *****************************************************************************/
+static const void *srcOf(DMASTREAM_Stream_t *stream, unsigned int index)
+{
+  if (stream->init.direction == dmaStreamPeriToMem) {
+    return (const void *)stream->init.periAddr;
+  }
+  return stream->init.buffers[index];
+}
+
+/**************************************************************************//**
+ * @brief emlib DMA callback, a descriptor completed its buffer
+ * @details
+ *   The descriptor is pointed at the buffer after the one the other
+ *   descriptor is moving now.
+ *****************************************************************************/
+static void dmaDone(unsigned int channel, bool primary, void *user)
+{
+  DMASTREAM_Stream_t *stream = user;
+  unsigned int index, next;
+
+  (void)channel;
+
+  if (!stream->running) {
+    return;
+  }
+
+  index = stream->dmaIndex;
+  next  = (index + 2) % stream->init.count;
+  DMA_RefreshPingPong(stream->init.channel, primary, false,
+                      dstOf(stream, next), srcOf(stream, next),
+                      stream->init.length - 1, false);
+
+  stream->dmaIndex = (index + 1) % stream->init.count;
+
+  if (stream->ready == stream->init.count - 1) {
+    // The DMA is now working on the oldest unreleased buffer
+    stream->readIndex = (stream->readIndex + 1) % stream->init.count;
+    stream->overruns++;
+  } else {
+    stream->ready++;
+  }
+
+  if (stream->init.callback != NULL) {
+    stream->init.callback(stream, index, stream->init.buffers[index]);
+  }
+}
+
+/**************************************************************************//**
+ * @brief Initialize a stream and configure its channel
+ * @param[out] stream Stream state
+ * @param[in] init Configuration, copied into the stream
+ * @return false if the configuration is not supported
+ *****************************************************************************/
+bool DMASTREAM_Init(DMASTREAM_Stream_t *stream, const DMASTREAM_Init_t *init)
+{
+  DMA_CfgChannel_TypeDef chnlCfg;
+  DMA_CfgDescr_TypeDef descrCfg;
+  DMA_DataInc_TypeDef inc = (DMA_DataInc_TypeDef)init->size;
+
+  if ((init->channel >= DMA_CHAN_COUNT)
+      || (init->count < 2) || (init->count > DMASTREAM_MAX_BUFFERS)
+      || (init->length == 0) || (init->length > DMASTREAM_MAX_LENGTH)) {
+    return false;
+  }
+
+  stream->init       = *init;
+  stream->cb.cbFunc  = dmaDone;
+  stream->cb.userPtr = stream;
+
+  chnlCfg.highPri   = false;
+  chnlCfg.enableInt = true;
+  chnlCfg.select    = init->select;
+  chnlCfg.cb        = &stream->cb;
+  DMA_CfgChannel(init->channel, &chnlCfg);
+
+  // One unit per request, the buffer side increments
+  descrCfg.dstInc  = (init->direction == dmaStreamPeriToMem) ? inc : dmaDataIncNone;
+  descrCfg.srcInc  = (init->direction == dmaStreamPeriToMem) ? dmaDataIncNone : inc;
+  descrCfg.size    = init->size;
+  descrCfg.arbRate = dmaArbitrate1;
+  descrCfg.hprot   = 0;
+  DMA_CfgDescr(init->channel, true, &descrCfg);
+  DMA_CfgDescr(init->channel, false, &descrCfg);
+
+  stream->dmaIndex  = 0;
+  stream->readIndex = 0;
+  stream->ready     = 0;
+  stream->overruns  = 0;
+  stream->running   = false;
+
+  return true;
+}
+
+/**************************************************************************//**
+ * @brief Start the stream at the first buffer
+ * @details
+ *   For memory to peripheral the buffers must be filled before this call.
+ *****************************************************************************/
+void DMASTREAM_Start(DMASTREAM_Stream_t *stream)
+{
+  stream->dmaIndex  = 0;
+  stream->readIndex = 0;
+  stream->ready     = 0;
+  stream->running   = true;
+
+  DMA_ActivatePingPong(stream->init.channel, false,
+                       dstOf(stream, 0), srcOf(stream, 0),
+                       stream->init.length - 1,
+                       dstOf(stream, 1), srcOf(stream, 1),
+                       stream->init.length - 1);
+}
+
+/**************************************************************************//**
+ * @brief Stop the stream
+ *****************************************************************************/
+void DMASTREAM_Stop(DMASTREAM_Stream_t *stream)
+{
+  DMA_ChannelEnable(stream->init.channel, false);
+  stream->running = false;
+}
+
+/**************************************************************************//**
+ * @brief Get the oldest completed buffer
+ * @details
+ *   The buffer stays owned by the application until it is passed to
+ *   DMASTREAM_Release(). Calling this again before releasing returns
+ *   the same buffer.
+ * @return Buffer address, or NULL if no buffer has completed
+ *****************************************************************************/
+void *DMASTREAM_Acquire(DMASTREAM_Stream_t *stream)
+{
+  void *buffer = NULL;
+  CORE_DECLARE_IRQ_STATE;
+
+  CORE_ENTER_ATOMIC();
+  if (stream->ready > 0) {
+    buffer = stream->init.buffers[stream->readIndex];
+  }
+  CORE_EXIT_ATOMIC();
+
+  return buffer;
+}
+
+/**************************************************************************//**
+ * @brief Give a buffer from DMASTREAM_Acquire() back to the DMA
+ * @details
+ *   Nothing happens if the buffer was already dropped because of an
+ *   overrun while the application held it.
+ *****************************************************************************/
+void DMASTREAM_Release(DMASTREAM_Stream_t *stream, void *buffer)
+{
+  CORE_DECLARE_IRQ_STATE;
+
+  CORE_ENTER_ATOMIC();
+  if ((stream->ready > 0)
+      && (stream->init.buffers[stream->readIndex] == buffer)) {
+    stream->readIndex = (stream->readIndex + 1) % stream->init.count;
+    stream->ready--;
+  }
+  CORE_EXIT_ATOMIC();
+}
+
+/**************************************************************************//**
+ * @brief Get the number of completed buffers not released yet
+ *****************************************************************************/
+unsigned int DMASTREAM_ReadyCount(DMASTREAM_Stream_t *stream)
+{
+  return stream->ready;
+}
+
+/**************************************************************************//**
+ * @brief Get the number of buffers dropped because the DMA caught up
+ *****************************************************************************/
+uint32_t DMASTREAM_Overruns(DMASTREAM_Stream_t *stream)
+{
+  return stream->overruns;
+}
+
+/** @} (end group DmaStream) */
+/** @} (end group kitdrv) */
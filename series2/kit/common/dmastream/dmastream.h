@@ -0,0 +1,142 @@
+/***************************************************************************//**
+ * @file
+ * @brief PL230 DMA buffer ring for continuous peripheral streaming.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2022 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ******************************************************************************/
+
+
+#ifndef __DMASTREAM_H
+#define __DMASTREAM_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "em_dma.h"
+
+/***************************************************************************//**
+ * @addtogroup kitdrv
+ * @{
+ ******************************************************************************/
+
+/***************************************************************************//**
+ * @addtogroup DmaStream
+ * @brief PL230 DMA buffer ring for continuous peripheral streaming
+ * @details
+ *    The series 0 DMA counterpart of the LdmaStream driver, with the same
+ *    API under the DMASTREAM_ prefix and a DMAREQ_xxx select in place of
+ *    the LDMA signal, so streaming code can be shared with series 1 and 2:
+ *    the DMA moves data between a peripheral register and a ring of N
+ *    application buffers. This generalizes the ping-pong (N = 2) example.
+ *
+ *    The ring runs on the ping-pong mode of the channel. The primary and
+ *    the alternate descriptor take the buffers in turn; when one
+ *    completes, the emlib DMA callback points it at the buffer after the
+ *    one the other descriptor is moving. Unlike the LDMA ring, which
+ *    loops in hardware, the DMA interrupt must therefore not be held off
+ *    for a whole buffer, or the channel stops at the end of the other
+ *    buffer. Scatter-gather mode does not loop either, so it can not be
+ *    used for the ring.
+ *
+ *    Completed buffers are handed to the application without copying,
+ *    either through the ready callback (interrupt context) or by
+ *    DMASTREAM_Acquire()/DMASTREAM_Release() from the main loop.
+ *    For peripheral to memory a completed buffer holds new data; for
+ *    memory to peripheral it has been sent and can be refilled.
+ *
+ *    The DMA does not wait for the application. If it wraps around onto
+ *    a buffer that has not been released the oldest buffer is dropped
+ *    and counted as an overrun.
+ *
+ *    The application calls DMA_Init() once with the control block, as
+ *    with any emlib DMA user. The emlib DMA_IRQHandler() calls the stream,
+ *    so there is no interrupt hook to call.
+ * @{
+ ******************************************************************************/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef DMASTREAM_MAX_BUFFERS
+#define DMASTREAM_MAX_BUFFERS     8     /**< Maximum buffers per stream */
+#endif
+
+#define DMASTREAM_MAX_LENGTH      1024  /**< Units of one DMA cycle */
+
+struct DMASTREAM_Stream;
+
+/** Called from the DMA interrupt each time a buffer completes */
+typedef void (*DMASTREAM_Callback_t)(struct DMASTREAM_Stream *stream,
+                                     unsigned int index,
+                                     void *buffer);
+
+/** Transfer direction */
+typedef enum {
+  dmaStreamPeriToMem,                   /**< Peripheral register to buffers */
+  dmaStreamMemToPeri                    /**< Buffers to peripheral register */
+} DMASTREAM_Direction_t;
+
+/** Stream configuration */
+typedef struct {
+  unsigned int            channel;      /**< DMA channel */
+  uint32_t                select;       /**< Peripheral request, DMAREQ_xxx */
+  DMASTREAM_Direction_t   direction;    /**< Transfer direction */
+  volatile void           *periAddr;    /**< Peripheral data register */
+  DMA_DataSize_TypeDef    size;         /**< Unit size, byte/half/word */
+  void * const            *buffers;     /**< Buffer addresses */
+  unsigned int            count;        /**< Number of buffers, 2..DMASTREAM_MAX_BUFFERS */
+  unsigned int            length;       /**< Units per buffer */
+  DMASTREAM_Callback_t    callback;     /**< Ready callback, may be NULL */
+  void                    *user;        /**< Application data for the callback */
+} DMASTREAM_Init_t;
+
+/** Stream state, treat as opaque */
+typedef struct DMASTREAM_Stream {
+  DMASTREAM_Init_t        init;
+  DMA_CB_TypeDef          cb;           /**< emlib callback of the channel */
+  volatile unsigned int   dmaIndex;     /**< Buffer the DMA is working on */
+  volatile unsigned int   readIndex;    /**< Oldest completed buffer */
+  volatile unsigned int   ready;        /**< Completed, not released buffers */
+  volatile uint32_t       overruns;     /**< Buffers dropped */
+  bool                    running;
+} DMASTREAM_Stream_t;
+
+bool         DMASTREAM_Init(DMASTREAM_Stream_t *stream, const DMASTREAM_Init_t *init);
+void         DMASTREAM_Start(DMASTREAM_Stream_t *stream);
+void         DMASTREAM_Stop(DMASTREAM_Stream_t *stream);
+void         *DMASTREAM_Acquire(DMASTREAM_Stream_t *stream);
+void         DMASTREAM_Release(DMASTREAM_Stream_t *stream, void *buffer);
+unsigned int DMASTREAM_ReadyCount(DMASTREAM_Stream_t *stream);
+uint32_t     DMASTREAM_Overruns(DMASTREAM_Stream_t *stream);
+
+#ifdef __cplusplus
+}
+#endif
+
+/** @} (end group DmaStream) */
+/** @} (end group kitdrv) */
+
+#endif
@@ -0,0 +1,181 @@
+/***************************************************************************//**
+ * @file
+ * @brief Code region markers for energy profiling.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2022 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ******************************************************************************/
+
+#ifndef __ENERGYMARK_H
+#define __ENERGYMARK_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/***************************************************************************//**
+ * @addtogroup kitdrv
+ * @{
+ ******************************************************************************/
+
+/***************************************************************************//**
+ * @addtogroup EnergyMark
+ * @brief Code region markers for energy profiling
+ * @details
+ *    ENERGYMARK_BEGIN() and ENERGYMARK_END() mark the start and the end of
+ *    a code region, such as an interrupt handler, an FFT or a flash write,
+ *    so the current in an Energy Profiler or scope capture can be put down
+ *    to the code that drew it. The energy of one operation is its average
+ *    current times its duration times the supply voltage.
+ *
+ *    Each marker has an ID, ENERGYMARK_ID_x. A marker is shown in two ways,
+ *    each of which can be left out:
+ *
+ *    - GPIO: the first ENERGYMARK_GPIO_PINS IDs each drive a pin, from
+ *      ENERGYMARK_PIN of ENERGYMARK_PORT up, high inside the region. The
+ *      pins go to a scope or logic analyzer next to the current probe.
+ *    - ITM: every marker sends a one byte event on ITM stimulus port
+ *      ENERGYMARK_ITM_PORT, the ID with bit 7 set at the start and clear at
+ *      the end. The debugger timestamps the events on SWO. Nothing is sent
+ *      while the debugger has not enabled the port, so the markers cost no
+ *      time then.
+ *
+ *    The kit drivers mark their interrupt handlers and blocking operations.
+ *    The markers compile to nothing unless ENERGYMARK_ENABLE is 1, set for
+ *    the whole project with the other ENERGYMARK_x settings, for instance
+ *    as compiler defines. ENERGYMARK_Init() sets up the pins and the SWO
+ *    output once in main().
+ * @{
+ ******************************************************************************/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if !defined(ENERGYMARK_ENABLE)
+#define ENERGYMARK_ENABLE       0   /**< 1 to build the markers in */
+#endif
+
+#if !defined(ENERGYMARK_GPIO_PINS)
+#define ENERGYMARK_GPIO_PINS    0   /**< IDs shown on a pin, from ID 0 */
+#endif
+
+#if !defined(ENERGYMARK_ITM)
+#define ENERGYMARK_ITM          1   /**< 1 to send ITM events */
+#endif
+
+#if !defined(ENERGYMARK_ITM_PORT)
+#define ENERGYMARK_ITM_PORT     8   /**< ITM stimulus port of the events */
+#endif
+
+/** Marker IDs of the application and the kit drivers, up to 127 */
+#define ENERGYMARK_ID_APP         0U  /**< Free for the application */
+#define ENERGYMARK_ID_LDMASTREAM  1U  /**< LDMASTREAM_IRQHandler() */
+#define ENERGYMARK_ID_LDMAMGR     2U  /**< LDMAMGR_IRQHandler() */
+#define ENERGYMARK_ID_FLASH       3U  /**< MX25_PP() and MX25_SE() */
+#define ENERGYMARK_ID_USER        8U  /**< First ID for the application */
+
+#if ENERGYMARK_ENABLE
+
+#include "em_device.h"
+#include "em_cmu.h"
+#include "em_gpio.h"
+
+#if (ENERGYMARK_GPIO_PINS > 0) && !(defined(ENERGYMARK_PORT) && defined(ENERGYMARK_PIN))
+#error "ENERGYMARK_GPIO_PINS needs ENERGYMARK_PORT and ENERGYMARK_PIN"
+#endif
+
+/***************************************************************************//**
+ * @brief
+ *   Set up the marker pins and the SWO output.
+ ******************************************************************************/
+__STATIC_INLINE void ENERGYMARK_Init(void)
+{
+#if ENERGYMARK_GPIO_PINS > 0
+  unsigned int i;
+
+  CMU_ClockEnable(cmuClock_GPIO, true);
+  for (i = 0; i < ENERGYMARK_GPIO_PINS; i++) {
+    GPIO_PinModeSet(ENERGYMARK_PORT, ENERGYMARK_PIN + i, gpioModePushPull, 0);
+  }
+#endif
+#if ENERGYMARK_ITM
+  // The ITM and the SWO baud rate are set up by the debugger
+  CMU_ClockEnable(cmuClock_GPIO, true);
+  GPIO_DbgSWOEnable(true);
+#endif
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Show the start or the end of a region, use the macros below.
+ ******************************************************************************/
+__STATIC_INLINE void ENERGYMARK_Mark(uint32_t id, bool begin)
+{
+#if ENERGYMARK_GPIO_PINS > 0
+  if (id < ENERGYMARK_GPIO_PINS) {
+    if (begin) {
+      GPIO_PinOutSet(ENERGYMARK_PORT, ENERGYMARK_PIN + id);
+    } else {
+      GPIO_PinOutClear(ENERGYMARK_PORT, ENERGYMARK_PIN + id);
+    }
+  }
+#endif
+#if ENERGYMARK_ITM
+  // Only once the debugger has enabled the port, as in ITM_SendChar()
+  if ((ITM->TCR & ITM_TCR_ITMENA_Msk)
+      && (ITM->TER & (1UL << ENERGYMARK_ITM_PORT))) {
+    while (ITM->PORT[ENERGYMARK_ITM_PORT].u32 == 0UL) {
+    }
+    ITM->PORT[ENERGYMARK_ITM_PORT].u8 = (uint8_t)(id | (begin ? 0x80U : 0U));
+  }
+#endif
+  (void)id;
+  (void)begin;
+}
+
+/** Start of a region */
+#define ENERGYMARK_BEGIN(id)    ENERGYMARK_Mark((id), true)
+/** End of a region */
+#define ENERGYMARK_END(id)      ENERGYMARK_Mark((id), false)
+/** Region of no length, an event */
+#define ENERGYMARK_EVENT(id)    do { ENERGYMARK_BEGIN(id); ENERGYMARK_END(id); } while (0)
+
+#else
+
+#define ENERGYMARK_Init()       do { } while (0)
+#define ENERGYMARK_BEGIN(id)    do { } while (0)
+#define ENERGYMARK_END(id)      do { } while (0)
+#define ENERGYMARK_EVENT(id)    do { } while (0)
+
+#endif // ENERGYMARK_ENABLE
+
+#ifdef __cplusplus
+}
+#endif
+
+/** @} (end group EnergyMark) */
+/** @} (end group kitdrv) */
+
+#endif
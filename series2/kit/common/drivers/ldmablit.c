@@ -0,0 +1,291 @@
+/***************************************************************************//**
+ * @file
+ * @brief LDMA 2D blit and fill of rectangles in memory.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2022 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ******************************************************************************/
+
+#include <stddef.h>
+#include "em_core.h"
+#include "ldmablit.h"
+
+/***************************************************************************//**
+ * @addtogroup kitdrv
+ * @{
+ ******************************************************************************/
+
+/***************************************************************************//**
+ * @addtogroup LdmaBlit
+ * @{
+ ******************************************************************************/
+
+// Repeats of a descriptor on one load of the loop counter
+#define LOOP_REPEATS        256
+
+// First row, a loop descriptor per segment, a loop counter write between
+// two segments and the final write that raises the done flag
+#define NUM_DESCRIPTORS     ((2 * LDMABLIT_MAX_SEGMENTS) + 1)
+
+static const LDMA_CtrlSize_t unitSize[3] = {
+  ldmaCtrlSizeByte, ldmaCtrlSizeHalf, ldmaCtrlSizeWord
+};
+
+static LDMA_Descriptor_t   desc[NUM_DESCRIPTORS];
+static uint32_t            fillWord;    // Read by the LDMA during a fill
+static volatile bool       busy;
+static LDMABLIT_Callback_t doneCallback;
+static void                *doneUser;
+
+/**************************************************************************//**
+ * @brief Take the channel for a blit
+ * @return false if a blit is already running
+ *****************************************************************************/
+static bool claim(void)
+{
+  bool claimed = false;
+  CORE_DECLARE_IRQ_STATE;
+
+  CORE_ENTER_ATOMIC();
+  if (!busy) {
+    busy = true;
+    claimed = true;
+  }
+  CORE_EXIT_ATOMIC();
+
+  return claimed;
+}
+
+/**************************************************************************//**
+ * @brief Set a descriptor up for one row
+ *****************************************************************************/
+static void setRow(LDMA_Descriptor_t *d, LDMA_CtrlSize_t size, bool fill)
+{
+  d->xfer.size      = size;
+  d->xfer.blockSize = LDMABLIT_BLOCK_SIZE;
+  d->xfer.doneIfs   = 0;
+  if (fill) {
+    d->xfer.srcInc = ldmaCtrlSrcIncNone;
+  }
+}
+
+/**************************************************************************//**
+ * @brief Build the descriptors of a blit and start it
+ * @param[in] fill Read every element from fillWord instead of the source
+ * @param[in] value Fill element value
+ * @return false if the rectangle is not supported, nothing is started then
+ *****************************************************************************/
+static bool start(const LDMABLIT_Blit_t *blit, bool fill, uint32_t value,
+                  LDMABLIT_Callback_t callback, void *user)
+{
+  LDMA_TransferCfg_t cfg;
+  uint32_t elem = 1UL << blit->size;
+  uint32_t rowBytes = blit->width * elem;
+  uint32_t src = fill ? (uint32_t)(uintptr_t)&fillWord
+                 : (uint32_t)(uintptr_t)blit->src;
+  uint32_t dst = (uint32_t)(uintptr_t)blit->dst;
+  uint32_t srcGap = 0, dstGap = 0;
+  uint32_t align, shift, units, rows, repeats, loopCnt = 0;
+  unsigned int i;
+
+  if ((blit->width == 0) || (blit->height == 0)
+      || (blit->height > LDMABLIT_MAX_HEIGHT)) {
+    return false;
+  }
+
+  // The strides only matter from the second row on
+  align = dst | rowBytes;
+  if (!fill) {
+    align |= src;
+  }
+  if (blit->height > 1) {
+    if ((blit->dstStride < rowBytes)
+        || (!fill && (blit->srcStride < rowBytes))) {
+      return false;
+    }
+    dstGap = blit->dstStride - rowBytes;
+    srcGap = fill ? 0 : blit->srcStride - rowBytes;
+    align |= dstGap | srcGap;
+  }
+  if (align & (elem - 1)) {
+    return false;
+  }
+
+  // Widest unit all addresses stay aligned to
+  shift = ((align & 3) == 0) ? 2 : (((align & 1) == 0) ? 1 : 0);
+  units = rowBytes >> shift;
+  if (units > LDMA_DESCRIPTOR_MAX_XFER_SIZE) {
+    return false;
+  }
+
+  if (!claim()) {
+    return false;
+  }
+
+  // Repeat the element over the word, wider units then read it alike
+  if (fill) {
+    if (blit->size == ldmaCtrlSizeByte) {
+      fillWord = 0x01010101UL * (value & 0xFF);
+    } else if (blit->size == ldmaCtrlSizeHalf) {
+      fillWord = 0x00010001UL * (value & 0xFFFF);
+    } else {
+      fillWord = value;
+    }
+  }
+
+  // First row, absolute addresses
+  desc[0] = (LDMA_Descriptor_t)
+    LDMA_DESCRIPTOR_LINKREL_M2M_BYTE(src, dst, units, 1);
+  setRow(&desc[0], unitSize[shift], fill);
+  i = 1;
+
+  // The other rows, in segments of up to LOOP_REPEATS repeats
+  rows = blit->height - 1;
+  while (rows > 0) {
+    repeats = (rows < LOOP_REPEATS) ? rows : LOOP_REPEATS;
+    if (i == 1) {
+      // The first segment takes the loop count from the transfer config
+      loopCnt = repeats - 1;
+    } else {
+      desc[i++] = (LDMA_Descriptor_t)
+        LDMA_DESCRIPTOR_LINKREL_WRITE(repeats - 1,
+                                      &LDMA->CH[LDMABLIT_CHANNEL].LOOP, 1);
+    }
+
+    // Repeats on itself, then goes on with the next descriptor in memory
+    desc[i] = (LDMA_Descriptor_t)
+      LDMA_DESCRIPTOR_LINKREL_M2M_BYTE(srcGap, dstGap, units, 0);
+    setRow(&desc[i], unitSize[shift], fill);
+    desc[i].xfer.dstAddrMode = ldmaCtrlDstAddrModeRel;
+    if (!fill) {
+      desc[i].xfer.srcAddrMode = ldmaCtrlSrcAddrModeRel;
+    } else {
+      desc[i].xfer.srcAddr = src;
+    }
+    desc[i].xfer.decLoopCnt = 1;
+    i++;
+    rows -= repeats;
+  }
+
+  if (i == 1) {
+    desc[0].xfer.link    = 0;
+    desc[0].xfer.doneIfs = 1;
+  } else {
+    // A looped descriptor raises its done flag on every repeat, the
+    // last write only once at the end
+    desc[i] = (LDMA_Descriptor_t)
+      LDMA_DESCRIPTOR_SINGLE_WRITE(0, &LDMA->CH[LDMABLIT_CHANNEL].LOOP);
+    desc[i].wri.doneIfs = 1;
+  }
+
+  doneCallback = callback;
+  doneUser     = user;
+  cfg = (LDMA_TransferCfg_t)LDMA_TRANSFER_CFG_MEMORY_LOOP(loopCnt);
+  LDMA_StartTransfer(LDMABLIT_CHANNEL, &cfg, &desc[0]);
+
+  return true;
+}
+
+/**************************************************************************//**
+ * @brief Start copying a rectangle
+ * @details
+ *   The source and destination must not overlap and stay untouched until
+ *   the callback.
+ * @param[in] blit Rectangle, not used after this returns
+ * @param[in] callback Called when the copy is done, may be NULL
+ * @param[in] user Passed to the callback
+ * @return false if a blit is already running or the rectangle is not
+ *   supported: a row longer than LDMA_DESCRIPTOR_MAX_XFER_SIZE units, a
+ *   stride shorter than a row or addresses not aligned to the elements
+ *****************************************************************************/
+bool LDMABLIT_Copy(const LDMABLIT_Blit_t *blit,
+                   LDMABLIT_Callback_t callback, void *user)
+{
+  return start(blit, false, 0, callback, user);
+}
+
+/**************************************************************************//**
+ * @brief Start filling a rectangle with one element value
+ * @details
+ *   Works as LDMABLIT_Copy(); src and srcStride are not used.
+ * @param[in] value Element value, the low bits for bytes and half words
+ *****************************************************************************/
+bool LDMABLIT_Fill(const LDMABLIT_Blit_t *blit, uint32_t value,
+                   LDMABLIT_Callback_t callback, void *user)
+{
+  return start(blit, true, value, callback, user);
+}
+
+/**************************************************************************//**
+ * @brief Check if a blit is running
+ *****************************************************************************/
+bool LDMABLIT_IsBusy(void)
+{
+  return busy;
+}
+
+/**************************************************************************//**
+ * @brief Wait until the LDMA has moved the whole rectangle
+ * @details
+ *   The callback still follows from LDMABLIT_IRQHandler().
+ *****************************************************************************/
+void LDMABLIT_Wait(void)
+{
+  if (!busy) {
+    return;
+  }
+  while (!LDMA_TransferDone(LDMABLIT_CHANNEL)) {
+  }
+}
+
+/**************************************************************************//**
+ * @brief Handle the LDMA interrupt of the reserved channel
+ * @details
+ *   Only the done flag of LDMABLIT_CHANNEL is read and cleared, so other
+ *   LDMA users can share LDMA_IRQHandler().
+ *****************************************************************************/
+void LDMABLIT_IRQHandler(void)
+{
+  uint32_t mask = 1UL << LDMABLIT_CHANNEL;
+  LDMABLIT_Callback_t callback;
+
+  if (!(LDMA_IntGet() & mask)) {
+    return;
+  }
+  LDMA_IntClear(mask);
+
+  if (!busy) {
+    return;
+  }
+
+  callback = doneCallback;
+  busy = false;
+  if (callback != NULL) {
+    callback(doneUser);
+  }
+}
+
+/** @} (end group LdmaBlit) */
+/** @} (end group kitdrv) */
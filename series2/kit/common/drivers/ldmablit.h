@@ -0,0 +1,113 @@
+/***************************************************************************//**
+ * @file
+ * @brief LDMA 2D blit and fill of rectangles in memory.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2022 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ******************************************************************************/
+
+#ifndef __LDMABLIT_H
+#define __LDMABLIT_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "em_ldma.h"
+
+/***************************************************************************//**
+ * @addtogroup kitdrv
+ * @{
+ ******************************************************************************/
+
+/***************************************************************************//**
+ * @addtogroup LdmaBlit
+ * @brief LDMA 2D blit and fill of rectangles in memory
+ * @details
+ *    Copies a rectangle of elements between two 2D buffers of any row
+ *    stride, or fills a rectangle with one value, without a CPU loop over
+ *    the rows. The first row is moved by a descriptor with the absolute
+ *    addresses. The others are moved by one descriptor that repeats on the
+ *    channel loop counter; it adds the gap between the rows to the source
+ *    and destination with relative addressing. The loop counter holds up
+ *    to 256 repeats, taller rectangles load it again with a write
+ *    descriptor between segments of 256 rows.
+ *
+ *    Elements are moved as words or half words when the addresses, the
+ *    strides and the row length allow, whatever their own size.
+ *
+ *    One blit runs at a time on LDMABLIT_CHANNEL. The application calls
+ *    LDMA_Init() once, does not use the channel for anything else and
+ *    calls LDMABLIT_IRQHandler() from its LDMA_IRQHandler().
+ * @{
+ ******************************************************************************/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef LDMABLIT_CHANNEL
+#define LDMABLIT_CHANNEL          (DMA_CHAN_COUNT - 6)  /**< Reserved channel, below the LdmaMem one */
+#endif
+
+#ifndef LDMABLIT_MAX_SEGMENTS
+#define LDMABLIT_MAX_SEGMENTS     2     /**< Segments of 256 rows after the first row */
+#endif
+
+#ifndef LDMABLIT_BLOCK_SIZE
+#define LDMABLIT_BLOCK_SIZE       ldmaCtrlBlockSizeUnit8  /**< Units moved before the LDMA arbitrates */
+#endif
+
+/** Tallest rectangle */
+#define LDMABLIT_MAX_HEIGHT       (1 + (256 * LDMABLIT_MAX_SEGMENTS))
+
+/** Called from LDMABLIT_IRQHandler() when a blit is done */
+typedef void (*LDMABLIT_Callback_t)(void *user);
+
+/** Rectangle to move */
+typedef struct {
+  const void      *src;                 /**< First source element, unused by a fill */
+  uint32_t        srcStride;            /**< Bytes from a source row to the next */
+  void            *dst;                 /**< First destination element */
+  uint32_t        dstStride;            /**< Bytes from a destination row to the next */
+  uint32_t        width;                /**< Elements per row */
+  uint32_t        height;               /**< Rows, 1..LDMABLIT_MAX_HEIGHT */
+  LDMA_CtrlSize_t size;                 /**< Element size, byte/half/word */
+} LDMABLIT_Blit_t;
+
+bool LDMABLIT_Copy(const LDMABLIT_Blit_t *blit,
+                   LDMABLIT_Callback_t callback, void *user);
+bool LDMABLIT_Fill(const LDMABLIT_Blit_t *blit, uint32_t value,
+                   LDMABLIT_Callback_t callback, void *user);
+bool LDMABLIT_IsBusy(void);
+void LDMABLIT_Wait(void);
+void LDMABLIT_IRQHandler(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+/** @} (end group LdmaBlit) */
+/** @} (end group kitdrv) */
+
+#endif
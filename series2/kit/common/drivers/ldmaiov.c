@@ -0,0 +1,261 @@
+/***************************************************************************//**
+ * @file
+ * @brief LDMA scatter-gather of I/O vectors on descriptor chains.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2022 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ******************************************************************************/
+
+#include <stddef.h>
+#include "em_core.h"
+#include "ldmaiov.h"
+
+/***************************************************************************//**
+ * @addtogroup kitdrv
+ * @{
+ ******************************************************************************/
+
+/***************************************************************************//**
+ * @addtogroup LdmaIov
+ * @{
+ ******************************************************************************/
+
+/** What the vectors are moved to or from */
+typedef enum {
+  iovSend,                              /**< Vectors to the peripheral */
+  iovReceive,                           /**< Peripheral to the vectors */
+  iovGather,                            /**< Vectors to memory */
+  iovScatter                            /**< Memory to the vectors */
+} LdmaIovMode_t;
+
+/**************************************************************************//**
+ * @brief Build a descriptor chain over the vectors and start it
+ * @param[in] mem Memory buffer for a gather or a scatter
+ * @return false if the channel is busy or the vectors need more
+ *   descriptors than the pool has
+ *****************************************************************************/
+static bool start(LDMAIOV_Channel_t *channel, LdmaIovMode_t mode,
+                  const LDMAIOV_Vec_t *iov, unsigned int count, uint32_t mem,
+                  LDMAIOV_Callback_t callback, void *user)
+{
+  LDMA_TransferCfg_t cfg = LDMA_TRANSFER_CFG_MEMORY();
+  LDMA_Descriptor_t *d;
+  uint32_t peri = (uint32_t)(uintptr_t)channel->init.periAddr;
+  uint32_t addr, chunk, src, dst;
+  unsigned int i, n = 0;
+  size_t left;
+  bool claimed = false;
+  CORE_DECLARE_IRQ_STATE;
+
+  // Descriptors needed, a vector takes one per maximum transfer
+  for (i = 0; i < count; i++) {
+    n += (iov[i].len + LDMA_DESCRIPTOR_MAX_XFER_SIZE - 1)
+         / LDMA_DESCRIPTOR_MAX_XFER_SIZE;
+  }
+  if ((n == 0) || (n > LDMAIOV_MAX_DESCRIPTORS)) {
+    return false;
+  }
+
+  CORE_ENTER_ATOMIC();
+  if (!channel->busy) {
+    channel->busy = true;
+    claimed = true;
+  }
+  CORE_EXIT_ATOMIC();
+  if (!claimed) {
+    return false;
+  }
+
+  n = 0;
+  for (i = 0; i < count; i++) {
+    addr = (uint32_t)(uintptr_t)iov[i].base;
+    left = iov[i].len;
+
+    while (left > 0) {
+      chunk = (left < LDMA_DESCRIPTOR_MAX_XFER_SIZE)
+              ? left : LDMA_DESCRIPTOR_MAX_XFER_SIZE;
+      d = &channel->desc[n];
+
+      if (mode == iovSend) {
+        *d = (LDMA_Descriptor_t)
+          LDMA_DESCRIPTOR_LINKREL_M2P_BYTE(addr, peri, chunk, 1);
+      } else if (mode == iovReceive) {
+        *d = (LDMA_Descriptor_t)
+          LDMA_DESCRIPTOR_LINKREL_P2M_BYTE(peri, addr, chunk, 1);
+      } else {
+        src = (mode == iovGather) ? addr : mem;
+        dst = (mode == iovGather) ? mem : addr;
+        if (((src | dst | chunk) & 3) == 0) {
+          *d = (LDMA_Descriptor_t)
+            LDMA_DESCRIPTOR_LINKREL_M2M_WORD(src, dst, chunk / 4, 1);
+        } else {
+          *d = (LDMA_Descriptor_t)
+            LDMA_DESCRIPTOR_LINKREL_M2M_BYTE(src, dst, chunk, 1);
+        }
+        mem += chunk;
+      }
+      d->xfer.doneIfs = 0;
+
+      addr += chunk;
+      left -= chunk;
+      n++;
+    }
+  }
+
+  channel->desc[n - 1].xfer.link    = 0;
+  channel->desc[n - 1].xfer.doneIfs = 1;
+  channel->callback = callback;
+  channel->user     = user;
+
+  if ((mode == iovSend) || (mode == iovReceive)) {
+    cfg = (LDMA_TransferCfg_t)LDMA_TRANSFER_CFG_PERIPHERAL(channel->init.signal);
+  }
+  LDMA_StartTransfer(channel->init.channel, &cfg, &channel->desc[0]);
+
+  return true;
+}
+
+/**************************************************************************//**
+ * @brief Initialize a channel
+ * @param[out] channel Channel state
+ * @param[in] init Configuration, copied into the channel
+ * @return false if the LDMA channel does not exist
+ *****************************************************************************/
+bool LDMAIOV_Init(LDMAIOV_Channel_t *channel, const LDMAIOV_Init_t *init)
+{
+  if (init->channel >= DMA_CHAN_COUNT) {
+    return false;
+  }
+
+  channel->init     = *init;
+  channel->busy     = false;
+  channel->callback = NULL;
+  channel->user     = NULL;
+
+  return true;
+}
+
+/**************************************************************************//**
+ * @brief Start sending the vectors in order to the peripheral
+ * @param[in] callback Called when all vectors are sent, may be NULL
+ * @param[in] user Passed to the callback
+ * @return false if the channel is busy or the vectors do not fit the
+ *   descriptor pool, nothing is sent then
+ *****************************************************************************/
+bool LDMAIOV_Send(LDMAIOV_Channel_t *channel,
+                  const LDMAIOV_Vec_t *iov, unsigned int count,
+                  LDMAIOV_Callback_t callback, void *user)
+{
+  return start(channel, iovSend, iov, count, 0, callback, user);
+}
+
+/**************************************************************************//**
+ * @brief Start receiving from the peripheral into the vectors in order
+ * @details
+ *   Works as LDMAIOV_Send(). The callback is called once all vectors are
+ *   full.
+ *****************************************************************************/
+bool LDMAIOV_Receive(LDMAIOV_Channel_t *channel,
+                     const LDMAIOV_Vec_t *iov, unsigned int count,
+                     LDMAIOV_Callback_t callback, void *user)
+{
+  return start(channel, iovReceive, iov, count, 0, callback, user);
+}
+
+/**************************************************************************//**
+ * @brief Start copying the vectors in order into one buffer
+ * @details
+ *   Works as LDMAIOV_Send(). @p dst must hold LDMAIOV_Length() bytes.
+ *****************************************************************************/
+bool LDMAIOV_Gather(LDMAIOV_Channel_t *channel,
+                    const LDMAIOV_Vec_t *iov, unsigned int count, void *dst,
+                    LDMAIOV_Callback_t callback, void *user)
+{
+  return start(channel, iovGather, iov, count, (uint32_t)(uintptr_t)dst,
+               callback, user);
+}
+
+/**************************************************************************//**
+ * @brief Start copying one buffer in order into the vectors
+ * @details
+ *   Works as LDMAIOV_Send(). @p src must hold LDMAIOV_Length() bytes.
+ *****************************************************************************/
+bool LDMAIOV_Scatter(LDMAIOV_Channel_t *channel, const void *src,
+                     const LDMAIOV_Vec_t *iov, unsigned int count,
+                     LDMAIOV_Callback_t callback, void *user)
+{
+  return start(channel, iovScatter, iov, count, (uint32_t)(uintptr_t)src,
+               callback, user);
+}
+
+/**************************************************************************//**
+ * @brief Get the total length of the vectors in bytes
+ *****************************************************************************/
+size_t LDMAIOV_Length(const LDMAIOV_Vec_t *iov, unsigned int count)
+{
+  size_t length = 0;
+  unsigned int i;
+
+  for (i = 0; i < count; i++) {
+    length += iov[i].len;
+  }
+  return length;
+}
+
+/**************************************************************************//**
+ * @brief Check if the channel is still moving vectors
+ *****************************************************************************/
+bool LDMAIOV_IsBusy(LDMAIOV_Channel_t *channel)
+{
+  return channel->busy;
+}
+
+/**************************************************************************//**
+ * @brief Handle the LDMA interrupt of a channel
+ * @details
+ *   Only the done flag of the channel is read and cleared, so several
+ *   channels and other LDMA users can share LDMA_IRQHandler().
+ *****************************************************************************/
+void LDMAIOV_IRQHandler(LDMAIOV_Channel_t *channel)
+{
+  uint32_t mask = 1UL << channel->init.channel;
+
+  if (!(LDMA_IntGet() & mask)) {
+    return;
+  }
+  LDMA_IntClear(mask);
+
+  if (!channel->busy) {
+    return;
+  }
+  channel->busy = false;
+
+  if (channel->callback != NULL) {
+    channel->callback(channel, channel->user);
+  }
+}
+
+/** @} (end group LdmaIov) */
+/** @} (end group kitdrv) */
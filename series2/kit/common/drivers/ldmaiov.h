@@ -0,0 +1,130 @@
+/***************************************************************************//**
+ * @file
+ * @brief LDMA scatter-gather of I/O vectors on descriptor chains.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2022 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ******************************************************************************/
+
+#ifndef __LDMAIOV_H
+#define __LDMAIOV_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "em_ldma.h"
+
+/***************************************************************************//**
+ * @addtogroup kitdrv
+ * @{
+ ******************************************************************************/
+
+/***************************************************************************//**
+ * @addtogroup LdmaIov
+ * @brief LDMA scatter-gather of I/O vectors on descriptor chains
+ * @details
+ *    Moves a list of (base, len) vectors in one LDMA run: each vector gets
+ *    a descriptor from the channel's pool, linked in list order, so a
+ *    packet made of a header, a payload and a trailer in separate buffers
+ *    is sent without copying it together first. Vectors longer than
+ *    LDMA_DESCRIPTOR_MAX_XFER_SIZE bytes take several descriptors and
+ *    zero length vectors none.
+ *
+ *    LDMAIOV_Send() gathers the vectors into a peripheral data register
+ *    and LDMAIOV_Receive() scatters the register into the vectors, one byte
+ *    per peripheral request. LDMAIOV_Gather() and LDMAIOV_Scatter() do the
+ *    same with one contiguous memory buffer, in words where the vector
+ *    allows.
+ *
+ *    The call returns once the LDMA is started; the buffers belong to the
+ *    LDMA until the callback, the vector list itself can be reused right
+ *    away. For a transmitter the callback means the last byte is in its
+ *    FIFO, not yet on the pin.
+ *
+ *    The application calls LDMA_Init() once and calls LDMAIOV_IRQHandler()
+ *    for each channel from its LDMA_IRQHandler().
+ * @{
+ ******************************************************************************/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef LDMAIOV_MAX_DESCRIPTORS
+#define LDMAIOV_MAX_DESCRIPTORS   8     /**< Descriptor pool of each channel */
+#endif
+
+struct LDMAIOV_Channel;
+
+/** Called from LDMAIOV_IRQHandler() when all vectors are moved */
+typedef void (*LDMAIOV_Callback_t)(struct LDMAIOV_Channel *channel, void *user);
+
+/** One buffer of the list, as struct iovec */
+typedef struct {
+  void                    *base;        /**< Buffer address */
+  size_t                  len;          /**< Buffer length in bytes */
+} LDMAIOV_Vec_t;
+
+/** Channel configuration */
+typedef struct {
+  unsigned int            channel;      /**< LDMA channel */
+  LDMA_PeripheralSignal_t signal;       /**< Peripheral request, Send and Receive only */
+  volatile void           *periAddr;    /**< Peripheral data register, Send and Receive only */
+} LDMAIOV_Init_t;
+
+/** Channel state, treat as opaque */
+typedef struct LDMAIOV_Channel {
+  LDMAIOV_Init_t          init;
+  LDMA_Descriptor_t       desc[LDMAIOV_MAX_DESCRIPTORS];
+  volatile bool           busy;
+  LDMAIOV_Callback_t      callback;
+  void                    *user;
+} LDMAIOV_Channel_t;
+
+bool   LDMAIOV_Init(LDMAIOV_Channel_t *channel, const LDMAIOV_Init_t *init);
+bool   LDMAIOV_Send(LDMAIOV_Channel_t *channel,
+                    const LDMAIOV_Vec_t *iov, unsigned int count,
+                    LDMAIOV_Callback_t callback, void *user);
+bool   LDMAIOV_Receive(LDMAIOV_Channel_t *channel,
+                       const LDMAIOV_Vec_t *iov, unsigned int count,
+                       LDMAIOV_Callback_t callback, void *user);
+bool   LDMAIOV_Gather(LDMAIOV_Channel_t *channel,
+                      const LDMAIOV_Vec_t *iov, unsigned int count, void *dst,
+                      LDMAIOV_Callback_t callback, void *user);
+bool   LDMAIOV_Scatter(LDMAIOV_Channel_t *channel, const void *src,
+                       const LDMAIOV_Vec_t *iov, unsigned int count,
+                       LDMAIOV_Callback_t callback, void *user);
+size_t LDMAIOV_Length(const LDMAIOV_Vec_t *iov, unsigned int count);
+bool   LDMAIOV_IsBusy(LDMAIOV_Channel_t *channel);
+void   LDMAIOV_IRQHandler(LDMAIOV_Channel_t *channel);
+
+#ifdef __cplusplus
+}
+#endif
+
+/** @} (end group LdmaIov) */
+/** @} (end group kitdrv) */
+
+#endif
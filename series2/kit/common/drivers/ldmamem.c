@@ -0,0 +1,367 @@
+/***************************************************************************//**
+ * @file
+ * @brief LDMA memcpy() and memset() for large RAM to RAM moves.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2022 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ******************************************************************************/
+
+#include <string.h>
+#include "em_core.h"
+#include "ldmamem.h"
+
+/***************************************************************************//**
+ * @addtogroup kitdrv
+ * @{
+ ******************************************************************************/
+
+/***************************************************************************//**
+ * @addtogroup LdmaMem
+ * @{
+ ******************************************************************************/
+
+/** Part of a move still to be handed to the LDMA */
+typedef struct {
+  uint32_t        dst;                  /**< Next destination address */
+  uint32_t        src;                  /**< Next source address, fillWord for a fill */
+  bool            fill;                 /**< Source does not increment */
+  uint32_t        units;                /**< Units not started yet */
+  LDMA_CtrlSize_t size;                 /**< Unit size */
+} LdmaMemMove_t;
+
+static const LDMA_CtrlSize_t unitSize[3] = {
+  ldmaCtrlSizeByte, ldmaCtrlSizeHalf, ldmaCtrlSizeWord
+};
+
+static LDMA_Descriptor_t  desc[LDMAMEM_MAX_DESCRIPTORS];
+static LdmaMemMove_t      move;
+static uint32_t           fillWord;     // Read by the LDMA during a fill
+static size_t             threshold = LDMAMEM_THRESHOLD;
+static volatile bool      busy;
+static LDMAMEM_Callback_t doneCallback;
+static void               *doneUser;
+
+/**************************************************************************//**
+ * @brief Take the channel for a move
+ * @return false if a move is already running
+ *****************************************************************************/
+static bool claim(void)
+{
+  bool claimed = false;
+  CORE_DECLARE_IRQ_STATE;
+
+  CORE_ENTER_ATOMIC();
+  if (!busy) {
+    busy = true;
+    claimed = true;
+  }
+  CORE_EXIT_ATOMIC();
+
+  return claimed;
+}
+
+/**************************************************************************//**
+ * @brief Split a move into a CPU head, an LDMA body and a CPU tail
+ * @details
+ *   The unit is the largest the source and destination can both be
+ *   aligned to, a fill always uses words. The head brings the destination
+ *   to a unit boundary, the tail holds the bytes after the last unit.
+ * @param[in] src Source, NULL for a fill
+ * @return false if the move is too short for the LDMA
+ *****************************************************************************/
+static bool prepare(void *dst, const void *src, size_t n,
+                    size_t *head, size_t *tail)
+{
+  uintptr_t diff = 0;
+  uint32_t shift;
+  uint32_t unit;
+
+  if ((n == 0) || (n < threshold)) {
+    return false;
+  }
+
+  if (src != NULL) {
+    diff = ((uintptr_t)dst ^ (uintptr_t)src) & 3;
+  }
+  shift = (diff == 0) ? 2 : ((diff & 1) ? 0 : 1);
+  unit = 1UL << shift;
+
+  *head = (unit - ((uintptr_t)dst & (unit - 1))) & (unit - 1);
+  if (n < (*head + unit)) {
+    return false;
+  }
+  move.units = (uint32_t)((n - *head) >> shift);
+  *tail = n - *head - ((size_t)move.units << shift);
+
+  move.dst  = (uint32_t)(uintptr_t)dst + *head;
+  move.src  = (src != NULL) ? (uint32_t)(uintptr_t)src + *head
+                            : (uint32_t)(uintptr_t)&fillWord;
+  move.fill = (src == NULL);
+  move.size = unitSize[shift];
+
+  return true;
+}
+
+/**************************************************************************//**
+ * @brief Start the LDMA on the next part of the move
+ * @details
+ *   Up to LDMAMEM_MAX_DESCRIPTORS linked descriptors are started at once;
+ *   longer moves are continued when the chain is done.
+ * @param[in] irq Set the done flag at the end of the chain
+ *****************************************************************************/
+static void startChain(bool irq)
+{
+  LDMA_TransferCfg_t cfg = LDMA_TRANSFER_CFG_MEMORY();
+  unsigned int i = 0;
+  uint32_t count;
+
+  while ((move.units > 0) && (i < LDMAMEM_MAX_DESCRIPTORS)) {
+    count = (move.units < LDMA_DESCRIPTOR_MAX_XFER_SIZE)
+            ? move.units : LDMA_DESCRIPTOR_MAX_XFER_SIZE;
+
+    desc[i] = (LDMA_Descriptor_t)
+      LDMA_DESCRIPTOR_LINKREL_M2M_BYTE(move.src, move.dst, count, 1);
+    desc[i].xfer.size      = move.size;
+    desc[i].xfer.blockSize = LDMAMEM_BLOCK_SIZE;
+    desc[i].xfer.doneIfs   = 0;
+    if (move.fill) {
+      desc[i].xfer.srcInc = ldmaCtrlSrcIncNone;
+    } else {
+      move.src += count << move.size;
+    }
+    move.dst   += count << move.size;
+    move.units -= count;
+    i++;
+  }
+  desc[i - 1].xfer.link    = 0;
+  desc[i - 1].xfer.doneIfs = irq;
+
+  LDMA_StartTransfer(LDMAMEM_CHANNEL, &cfg, &desc[0]);
+}
+
+/**************************************************************************//**
+ * @brief Run the prepared move to its end and release the channel
+ *****************************************************************************/
+static void runBlocking(void)
+{
+  startChain(false);
+  while (true) {
+    while (!LDMA_TransferDone(LDMAMEM_CHANNEL)) {
+    }
+    if (move.units == 0) {
+      break;
+    }
+    startChain(false);
+  }
+  busy = false;
+}
+
+/**************************************************************************//**
+ * @brief Copy @p n bytes from @p src to @p dst, as memcpy()
+ * @details
+ *   The CPU does the copy if it is shorter than the threshold or if an
+ *   asynchronous move is running, so this can be called from interrupts.
+ * @return @p dst
+ *****************************************************************************/
+void *LDMAMEM_Memcpy(void *dst, const void *src, size_t n)
+{
+  size_t head;
+  size_t tail;
+
+  if (!claim()) {
+    return memcpy(dst, src, n);
+  }
+  if (!prepare(dst, src, n, &head, &tail)) {
+    busy = false;
+    return memcpy(dst, src, n);
+  }
+
+  memcpy(dst, src, head);
+  memcpy((uint8_t *)dst + n - tail, (const uint8_t *)src + n - tail, tail);
+  runBlocking();
+
+  return dst;
+}
+
+/**************************************************************************//**
+ * @brief Fill @p n bytes at @p dst with the byte @p c, as memset()
+ * @details
+ *   Falls back to the CPU as LDMAMEM_Memcpy() does.
+ * @return @p dst
+ *****************************************************************************/
+void *LDMAMEM_Memset(void *dst, int c, size_t n)
+{
+  size_t head;
+  size_t tail;
+
+  if (!claim()) {
+    return memset(dst, c, n);
+  }
+  if (!prepare(dst, NULL, n, &head, &tail)) {
+    busy = false;
+    return memset(dst, c, n);
+  }
+
+  fillWord = 0x01010101UL * (uint8_t)c;
+  memset(dst, c, head);
+  memset((uint8_t *)dst + n - tail, c, tail);
+  runBlocking();
+
+  return dst;
+}
+
+/**************************************************************************//**
+ * @brief Start copying @p n bytes from @p src to @p dst
+ * @details
+ *   Returns once the LDMA is started. The buffers must stay untouched
+ *   until the callback. A copy shorter than the threshold is done by the
+ *   CPU and the callback is called before this returns.
+ * @param[in] callback Called when the copy is done, may be NULL
+ * @param[in] user Passed to the callback
+ * @return false if a move is already running, nothing is copied then
+ *****************************************************************************/
+bool LDMAMEM_MemcpyAsync(void *dst, const void *src, size_t n,
+                         LDMAMEM_Callback_t callback, void *user)
+{
+  size_t head;
+  size_t tail;
+
+  if (!claim()) {
+    return false;
+  }
+  if (!prepare(dst, src, n, &head, &tail)) {
+    busy = false;
+    memcpy(dst, src, n);
+    if (callback != NULL) {
+      callback(user);
+    }
+    return true;
+  }
+
+  memcpy(dst, src, head);
+  memcpy((uint8_t *)dst + n - tail, (const uint8_t *)src + n - tail, tail);
+  doneCallback = callback;
+  doneUser     = user;
+  startChain(true);
+
+  return true;
+}
+
+/**************************************************************************//**
+ * @brief Start filling @p n bytes at @p dst with the byte @p c
+ * @details
+ *   Works as LDMAMEM_MemcpyAsync().
+ * @return false if a move is already running, nothing is filled then
+ *****************************************************************************/
+bool LDMAMEM_MemsetAsync(void *dst, int c, size_t n,
+                         LDMAMEM_Callback_t callback, void *user)
+{
+  size_t head;
+  size_t tail;
+
+  if (!claim()) {
+    return false;
+  }
+  if (!prepare(dst, NULL, n, &head, &tail)) {
+    busy = false;
+    memset(dst, c, n);
+    if (callback != NULL) {
+      callback(user);
+    }
+    return true;
+  }
+
+  fillWord = 0x01010101UL * (uint8_t)c;
+  memset(dst, c, head);
+  memset((uint8_t *)dst + n - tail, c, tail);
+  doneCallback = callback;
+  doneUser     = user;
+  startChain(true);
+
+  return true;
+}
+
+/**************************************************************************//**
+ * @brief Check if a move is running on the LDMA
+ *****************************************************************************/
+bool LDMAMEM_IsBusy(void)
+{
+  return busy;
+}
+
+/**************************************************************************//**
+ * @brief Set the shortest move in bytes done by the LDMA
+ * @details
+ *   0 sends every move that has a whole aligned unit to the LDMA. The
+ *   best value depends on the core clock and on the other bus masters;
+ *   the ldma_memcpy example measures it.
+ *****************************************************************************/
+void LDMAMEM_SetThreshold(size_t bytes)
+{
+  threshold = bytes;
+}
+
+/**************************************************************************//**
+ * @brief Get the shortest move in bytes done by the LDMA
+ *****************************************************************************/
+size_t LDMAMEM_GetThreshold(void)
+{
+  return threshold;
+}
+
+/**************************************************************************//**
+ * @brief Handle the LDMA interrupt of the reserved channel
+ * @details
+ *   Only the done flag of LDMAMEM_CHANNEL is read and cleared, so other
+ *   LDMA users can share LDMA_IRQHandler(). Continues a move longer than
+ *   one descriptor chain and calls the callback at its end.
+ *****************************************************************************/
+void LDMAMEM_IRQHandler(void)
+{
+  uint32_t mask = 1UL << LDMAMEM_CHANNEL;
+  LDMAMEM_Callback_t callback;
+
+  if (!(LDMA_IntGet() & mask)) {
+    return;
+  }
+  LDMA_IntClear(mask);
+
+  if (!busy) {
+    return;
+  }
+  if (move.units > 0) {
+    startChain(true);
+    return;
+  }
+
+  callback = doneCallback;
+  busy = false;
+  if (callback != NULL) {
+    callback(doneUser);
+  }
+}
+
+/** @} (end group LdmaMem) */
+/** @} (end group kitdrv) */
@@ -0,0 +1,111 @@
+/***************************************************************************//**
+ * @file
+ * @brief LDMA memcpy() and memset() for large RAM to RAM moves.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2022 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ******************************************************************************/
+
+#ifndef __LDMAMEM_H
+#define __LDMAMEM_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "em_ldma.h"
+
+/***************************************************************************//**
+ * @addtogroup kitdrv
+ * @{
+ ******************************************************************************/
+
+/***************************************************************************//**
+ * @addtogroup LdmaMem
+ * @brief LDMA memcpy() and memset() for large RAM to RAM moves
+ * @details
+ *    LDMAMEM_Memcpy() and LDMAMEM_Memset() take the arguments of memcpy()
+ *    and memset(). Moves shorter than the threshold are done by the CPU,
+ *    setting up the LDMA would take longer. Longer moves are done on a
+ *    channel reserved for this driver, with the largest unit the alignment
+ *    of the addresses allows: words when the source and destination are
+ *    aligned alike, else half words or bytes. The bytes before the first
+ *    and after the last aligned unit are copied by the CPU before the LDMA
+ *    starts.
+ *
+ *    LDMAMEM_MemcpyAsync() and LDMAMEM_MemsetAsync() return as soon as the
+ *    LDMA is started, so the core keeps working, and call the callback
+ *    from LDMAMEM_IRQHandler() when the move is done. Only one move runs
+ *    at a time. While it runs the blocking functions fall back to the CPU
+ *    and the asynchronous ones return false.
+ *
+ *    As with memcpy(), the source and destination must not overlap. The
+ *    application calls LDMA_Init() once, does not use LDMAMEM_CHANNEL for
+ *    anything else and calls LDMAMEM_IRQHandler() from its
+ *    LDMA_IRQHandler().
+ * @{
+ ******************************************************************************/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef LDMAMEM_CHANNEL
+#define LDMAMEM_CHANNEL           (DMA_CHAN_COUNT - 5)  /**< Reserved channel, below the MX25 and retarget ones */
+#endif
+
+#ifndef LDMAMEM_THRESHOLD
+#define LDMAMEM_THRESHOLD         128   /**< Default moves in bytes from which the LDMA is used */
+#endif
+
+#ifndef LDMAMEM_MAX_DESCRIPTORS
+#define LDMAMEM_MAX_DESCRIPTORS   8     /**< Linked descriptors, LDMA_DESCRIPTOR_MAX_XFER_SIZE units each */
+#endif
+
+#ifndef LDMAMEM_BLOCK_SIZE
+#define LDMAMEM_BLOCK_SIZE        ldmaCtrlBlockSizeUnit8  /**< Units moved before the LDMA arbitrates */
+#endif
+
+/** Called from LDMAMEM_IRQHandler() when an asynchronous move is done */
+typedef void (*LDMAMEM_Callback_t)(void *user);
+
+void   *LDMAMEM_Memcpy(void *dst, const void *src, size_t n);
+void   *LDMAMEM_Memset(void *dst, int c, size_t n);
+bool   LDMAMEM_MemcpyAsync(void *dst, const void *src, size_t n,
+                           LDMAMEM_Callback_t callback, void *user);
+bool   LDMAMEM_MemsetAsync(void *dst, int c, size_t n,
+                           LDMAMEM_Callback_t callback, void *user);
+bool   LDMAMEM_IsBusy(void);
+void   LDMAMEM_SetThreshold(size_t bytes);
+size_t LDMAMEM_GetThreshold(void);
+void   LDMAMEM_IRQHandler(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+/** @} (end group LdmaMem) */
+/** @} (end group kitdrv) */
+
+#endif
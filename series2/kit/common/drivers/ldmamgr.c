@@ -0,0 +1,313 @@
+/***************************************************************************//**
+ * @file
+ * @brief LDMA channel manager and descriptor pool.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2022 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ******************************************************************************/
+
+#include <stddef.h>
+#include "em_core.h"
+#include "energymark.h"
+#include "ldmamgr.h"
+
+/***************************************************************************//**
+ * @addtogroup kitdrv
+ * @{
+ ******************************************************************************/
+
+/***************************************************************************//**
+ * @addtogroup LdmaMgr
+ * @{
+ ******************************************************************************/
+
+#define ALL_CHANNELS        ((1UL << DMA_CHAN_COUNT) - 1)
+
+static unsigned int            numFixed;
+static uint32_t                usedMask;      // Allocated or reserved
+static uint32_t                managedMask;   // Allocated, dispatched here
+static LDMAMGR_Callback_t      callbacks[DMA_CHAN_COUNT];
+static void                    *users[DMA_CHAN_COUNT];
+static LDMAMGR_ErrorCallback_t errorCallback;
+
+static LDMA_Descriptor_t       pool[LDMAMGR_POOL_BLOCKS * LDMAMGR_BLOCK_SIZE];
+static uint32_t                poolUsed;      // One bit per block
+
+/**************************************************************************//**
+ * @brief Mask of @p blocks blocks from block 0
+ *****************************************************************************/
+static uint32_t blockRun(unsigned int blocks)
+{
+  return (blocks >= 32) ? 0xFFFFFFFFUL : ((1UL << blocks) - 1);
+}
+
+/**************************************************************************//**
+ * @brief Initialize the LDMA and release all channels and descriptors
+ * @param[in] init LDMA configuration, its numFixed sets the channels
+ *   allocated with ldmaMgrPriorityHigh
+ *****************************************************************************/
+void LDMAMGR_Init(const LDMA_Init_t *init)
+{
+  unsigned int i;
+
+  numFixed      = init->ldmaInitCtrlNumFixed;
+  usedMask      = 0;
+  managedMask   = 0;
+  poolUsed      = 0;
+  errorCallback = NULL;
+  for (i = 0; i < DMA_CHAN_COUNT; i++) {
+    callbacks[i] = NULL;
+    users[i]     = NULL;
+  }
+
+  LDMA_Init(init);
+}
+
+/**************************************************************************//**
+ * @brief Allocate a free channel
+ * @param[in] priority ldmaMgrPriorityHigh for a fixed priority channel,
+ *   ldmaMgrPriorityNormal for a round robin one, or the highest free
+ *   channel if all round robin channels are taken
+ * @param[in] callback Called on the done flag of the channel, may be NULL
+ * @param[in] user Passed to the callback
+ * @return Channel number, -1 if no channel is free
+ *****************************************************************************/
+int LDMAMGR_Alloc(LDMAMGR_Priority_t priority,
+                  LDMAMGR_Callback_t callback, void *user)
+{
+  int channel = -1;
+  int i;
+  CORE_DECLARE_IRQ_STATE;
+
+  CORE_ENTER_ATOMIC();
+  if (priority == ldmaMgrPriorityHigh) {
+    for (i = 0; (i < (int)numFixed) && (i < DMA_CHAN_COUNT); i++) {
+      if (!(usedMask & (1UL << i))) {
+        channel = i;
+        break;
+      }
+    }
+  } else {
+    for (i = DMA_CHAN_COUNT - 1; i >= 0; i--) {
+      if (!(usedMask & (1UL << i))) {
+        channel = i;
+        break;
+      }
+    }
+  }
+  if (channel >= 0) {
+    usedMask          |= 1UL << channel;
+    managedMask       |= 1UL << channel;
+    callbacks[channel] = callback;
+    users[channel]     = user;
+  }
+  CORE_EXIT_ATOMIC();
+
+  return channel;
+}
+
+/**************************************************************************//**
+ * @brief Take a given channel out of the allocation
+ * @details
+ *   For drivers with a fixed channel and their own interrupt hook. The
+ *   flag of the channel is not touched by LDMAMGR_IRQHandler().
+ * @return false if the channel is already taken or does not exist
+ *****************************************************************************/
+bool LDMAMGR_Reserve(unsigned int channel)
+{
+  bool reserved = false;
+  CORE_DECLARE_IRQ_STATE;
+
+  if (channel >= DMA_CHAN_COUNT) {
+    return false;
+  }
+
+  CORE_ENTER_ATOMIC();
+  if (!(usedMask & (1UL << channel))) {
+    usedMask |= 1UL << channel;
+    reserved = true;
+  }
+  CORE_EXIT_ATOMIC();
+
+  return reserved;
+}
+
+/**************************************************************************//**
+ * @brief Stop a channel and give it back
+ *****************************************************************************/
+void LDMAMGR_Free(unsigned int channel)
+{
+  CORE_DECLARE_IRQ_STATE;
+
+  if (channel >= DMA_CHAN_COUNT) {
+    return;
+  }
+
+  LDMA_StopTransfer(channel);
+
+  CORE_ENTER_ATOMIC();
+  usedMask          &= ~(1UL << channel);
+  managedMask       &= ~(1UL << channel);
+  callbacks[channel] = NULL;
+  users[channel]     = NULL;
+  LDMA_IntClear(1UL << channel);
+  CORE_EXIT_ATOMIC();
+}
+
+/**************************************************************************//**
+ * @brief Check if a channel has fixed priority
+ *****************************************************************************/
+bool LDMAMGR_IsFixedPriority(unsigned int channel)
+{
+  return channel < numFixed;
+}
+
+/**************************************************************************//**
+ * @brief Get the channels neither allocated nor reserved, one bit each
+ *****************************************************************************/
+uint32_t LDMAMGR_FreeMask(void)
+{
+  return ~usedMask & ALL_CHANNELS;
+}
+
+/**************************************************************************//**
+ * @brief Set the function called on an LDMA bus error
+ * @details
+ *   The LDMA stops all channels on an error. Without a callback the
+ *   error flag is only cleared.
+ *****************************************************************************/
+void LDMAMGR_SetErrorCallback(LDMAMGR_ErrorCallback_t callback)
+{
+  errorCallback = callback;
+}
+
+/**************************************************************************//**
+ * @brief Allocate contiguous descriptors from the pool
+ * @details
+ *   Whole blocks of LDMAMGR_BLOCK_SIZE descriptors are taken, first fit.
+ * @return First descriptor, NULL if no run of free blocks is long enough
+ *****************************************************************************/
+LDMA_Descriptor_t *LDMAMGR_DescAlloc(unsigned int count)
+{
+  LDMA_Descriptor_t *desc = NULL;
+  unsigned int blocks = (count + LDMAMGR_BLOCK_SIZE - 1) / LDMAMGR_BLOCK_SIZE;
+  uint32_t run;
+  unsigned int i;
+  CORE_DECLARE_IRQ_STATE;
+
+  if ((count == 0) || (blocks > LDMAMGR_POOL_BLOCKS)) {
+    return NULL;
+  }
+  run = blockRun(blocks);
+
+  CORE_ENTER_ATOMIC();
+  for (i = 0; (i + blocks) <= LDMAMGR_POOL_BLOCKS; i++) {
+    if (!(poolUsed & (run << i))) {
+      poolUsed |= run << i;
+      desc = &pool[i * LDMAMGR_BLOCK_SIZE];
+      break;
+    }
+  }
+  CORE_EXIT_ATOMIC();
+
+  return desc;
+}
+
+/**************************************************************************//**
+ * @brief Give descriptors from LDMAMGR_DescAlloc() back to the pool
+ * @param[in] desc First descriptor
+ * @param[in] count Descriptors allocated
+ *****************************************************************************/
+void LDMAMGR_DescFree(LDMA_Descriptor_t *desc, unsigned int count)
+{
+  unsigned int blocks = (count + LDMAMGR_BLOCK_SIZE - 1) / LDMAMGR_BLOCK_SIZE;
+  unsigned int first;
+  CORE_DECLARE_IRQ_STATE;
+
+  if ((desc < pool) || (desc >= &pool[LDMAMGR_POOL_BLOCKS * LDMAMGR_BLOCK_SIZE])
+      || (count == 0)) {
+    return;
+  }
+  first = (unsigned int)(desc - pool) / LDMAMGR_BLOCK_SIZE;
+  if ((first + blocks) > LDMAMGR_POOL_BLOCKS) {
+    return;
+  }
+
+  CORE_ENTER_ATOMIC();
+  poolUsed &= ~(blockRun(blocks) << first);
+  CORE_EXIT_ATOMIC();
+}
+
+/**************************************************************************//**
+ * @brief Get the number of free pool blocks
+ *****************************************************************************/
+unsigned int LDMAMGR_DescFreeBlocks(void)
+{
+  uint32_t freeBlocks = ~poolUsed & blockRun(LDMAMGR_POOL_BLOCKS);
+  unsigned int count = 0;
+
+  while (freeBlocks) {
+    freeBlocks &= freeBlocks - 1;
+    count++;
+  }
+  return count;
+}
+
+/**************************************************************************//**
+ * @brief Dispatch the LDMA interrupt to the allocated channels
+ * @details
+ *   The done flags of the allocated channels are cleared and their
+ *   callbacks called, channel 0 first. The flags of reserved channels are
+ *   left to their drivers.
+ *****************************************************************************/
+void LDMAMGR_IRQHandler(void)
+{
+  uint32_t pending = LDMA_IntGet();
+  unsigned int i;
+
+  if (pending & LDMA_IF_ERROR) {
+    LDMA_IntClear(LDMA_IF_ERROR);
+    if (errorCallback != NULL) {
+      errorCallback();
+    }
+  }
+
+  pending &= managedMask;
+  if (pending == 0) {
+    return;
+  }
+  LDMA_IntClear(pending);
+
+  ENERGYMARK_BEGIN(ENERGYMARK_ID_LDMAMGR);
+  for (i = 0; i < DMA_CHAN_COUNT; i++) {
+    if ((pending & (1UL << i)) && (callbacks[i] != NULL)) {
+      callbacks[i](i, users[i]);
+    }
+  }
+  ENERGYMARK_END(ENERGYMARK_ID_LDMAMGR);
+}
+
+/** @} (end group LdmaMgr) */
+/** @} (end group kitdrv) */
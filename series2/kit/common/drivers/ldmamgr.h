@@ -0,0 +1,120 @@
+/***************************************************************************//**
+ * @file
+ * @brief LDMA channel manager and descriptor pool.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2022 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ******************************************************************************/
+
+#ifndef __LDMAMGR_H
+#define __LDMAMGR_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "em_ldma.h"
+
+/***************************************************************************//**
+ * @addtogroup kitdrv
+ * @{
+ ******************************************************************************/
+
+/***************************************************************************//**
+ * @addtogroup LdmaMgr
+ * @brief LDMA channel manager and descriptor pool
+ * @details
+ *    Hands out LDMA channels at run time so several LDMA users can share
+ *    one firmware without agreeing on channel numbers, and dispatches the
+ *    done interrupt of each channel to the callback it was allocated with.
+ *
+ *    Channels below the numFixed of the LDMA_Init_t have fixed priority,
+ *    the lower the number the higher; the others share the bus round
+ *    robin. Allocating with ldmaMgrPriorityHigh takes the lowest free fixed
+ *    channel, ldmaMgrPriorityNormal the highest free channel, so the two
+ *    meet in the middle.
+ *
+ *    Drivers with a fixed default channel, such as ldmamem or the MX25
+ *    flash driver, keep their own interrupt hook; their channel is taken
+ *    out of the allocation with LDMAMGR_Reserve() and its flag is left to
+ *    the hook.
+ *
+ *    The descriptor pool hands out runs of blocks of LDMAMGR_BLOCK_SIZE
+ *    descriptors, contiguous so they can be linked with relative links,
+ *    instead of a static descriptor array per user.
+ *
+ *    The application calls LDMAMGR_Init() instead of LDMA_Init() and
+ *    calls LDMAMGR_IRQHandler() from its LDMA_IRQHandler(), next to the
+ *    hooks of the drivers with reserved channels.
+ * @{
+ ******************************************************************************/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef LDMAMGR_BLOCK_SIZE
+#define LDMAMGR_BLOCK_SIZE        4     /**< Descriptors per pool block */
+#endif
+
+#ifndef LDMAMGR_POOL_BLOCKS
+#define LDMAMGR_POOL_BLOCKS       16    /**< Blocks in the pool, up to 32 */
+#endif
+
+#if (LDMAMGR_POOL_BLOCKS < 1) || (LDMAMGR_POOL_BLOCKS > 32)
+#error "LDMAMGR_POOL_BLOCKS must be 1 to 32"
+#endif
+
+/** Called from LDMAMGR_IRQHandler() when the channel raises its done flag */
+typedef void (*LDMAMGR_Callback_t)(unsigned int channel, void *user);
+
+/** Called from LDMAMGR_IRQHandler() on an LDMA bus error */
+typedef void (*LDMAMGR_ErrorCallback_t)(void);
+
+/** Channel priority */
+typedef enum {
+  ldmaMgrPriorityNormal,                /**< Round robin if possible */
+  ldmaMgrPriorityHigh                   /**< Fixed priority, 0..numFixed - 1 */
+} LDMAMGR_Priority_t;
+
+void              LDMAMGR_Init(const LDMA_Init_t *init);
+int               LDMAMGR_Alloc(LDMAMGR_Priority_t priority,
+                                LDMAMGR_Callback_t callback, void *user);
+bool              LDMAMGR_Reserve(unsigned int channel);
+void              LDMAMGR_Free(unsigned int channel);
+bool              LDMAMGR_IsFixedPriority(unsigned int channel);
+uint32_t          LDMAMGR_FreeMask(void);
+void              LDMAMGR_SetErrorCallback(LDMAMGR_ErrorCallback_t callback);
+LDMA_Descriptor_t *LDMAMGR_DescAlloc(unsigned int count);
+void              LDMAMGR_DescFree(LDMA_Descriptor_t *desc, unsigned int count);
+unsigned int      LDMAMGR_DescFreeBlocks(void);
+void              LDMAMGR_IRQHandler(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+/** @} (end group LdmaMgr) */
+/** @} (end group kitdrv) */
+
+#endif
@@ -0,0 +1,313 @@
+/***************************************************************************//**
+ * @file
+ * @brief LDMA multi-channel pipelines synchronized with the SYNC bits.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2022 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ******************************************************************************/
+
+
+#include <stddef.h>
+#include "ldmapipe.h"
+
+/***************************************************************************//**
+ * @addtogroup kitdrv
+ * @{
+ ******************************************************************************/
+
+/***************************************************************************//**
+ * @addtogroup LdmaPipe
+ * @{
+ ******************************************************************************/
+
+/**************************************************************************//**
+ * @brief Get the SYNC bit of a stage for a slot
+ *****************************************************************************/
+static uint32_t token(const LDMAPIPE_Pipe_t *pipe, unsigned int stage,
+                      unsigned int slot)
+{
+  return 1UL << (pipe->syncShift + (stage * pipe->slotCount) + slot);
+}
+
+/**************************************************************************//**
+ * @brief Get all SYNC bits of the pipeline
+ *****************************************************************************/
+static uint32_t tokenMask(const LDMAPIPE_Pipe_t *pipe)
+{
+  unsigned int bits = pipe->stageCount * pipe->slotCount;
+
+  return ((1UL << bits) - 1) << pipe->syncShift;
+}
+
+/**************************************************************************//**
+ * @brief Build the descriptor loop of a stage
+ * @details
+ *   For each slot: wait for the stage's bit, move the block, then clear
+ *   the bit and set the one of the next stage. The last descriptor links
+ *   back to the first, so the stage runs until stopped.
+ *****************************************************************************/
+static void buildStage(LDMAPIPE_Pipe_t *pipe, unsigned int k)
+{
+  const LDMAPIPE_Stage_t *stage = &pipe->stage[k];
+  unsigned int next = (k + 1) % pipe->stageCount;
+  unsigned int units = pipe->slotBytes >> stage->size;
+  uint32_t addr = (uint32_t)(uintptr_t)stage->addr;
+  uint32_t slot, own;
+  LDMA_Descriptor_t *d = pipe->desc[k];
+  unsigned int i;
+
+  for (i = 0; i < pipe->slotCount; i++) {
+    slot = (uint32_t)(uintptr_t)pipe->slot[i];
+    own  = token(pipe, k, i);
+
+    d[0] = (LDMA_Descriptor_t)LDMA_DESCRIPTOR_LINKREL_SYNC(0, 0, own, own, 1);
+
+    if (stage->dir == ldmaPipeFromPeri) {
+      d[1] = (LDMA_Descriptor_t)
+        LDMA_DESCRIPTOR_LINKREL_P2M_BYTE(addr, slot, units, 1);
+    } else if (stage->dir == ldmaPipeToPeri) {
+      d[1] = (LDMA_Descriptor_t)
+        LDMA_DESCRIPTOR_LINKREL_M2P_BYTE(slot, addr, units, 1);
+    } else {
+      d[1] = (LDMA_Descriptor_t)
+        LDMA_DESCRIPTOR_LINKREL_M2M_BYTE(slot, addr, units, 1);
+    }
+    d[1].xfer.size = stage->size;
+
+    // Without a request the block moves as soon as the slot is ours
+    if (stage->signal == ldmaPeripheralSignal_NONE) {
+      d[1].xfer.structReq = 1;
+      d[1].xfer.reqMode   = ldmaCtrlReqModeAll;
+    } else {
+      d[1].xfer.structReq = 0;
+      d[1].xfer.reqMode   = ldmaCtrlReqModeBlock;
+      d[1].xfer.blockSize = ldmaCtrlBlockSizeUnit1;
+    }
+    d[1].xfer.doneIfs = (next == 0) ? 1 : 0;
+
+    d[2] = (LDMA_Descriptor_t)
+      LDMA_DESCRIPTOR_LINKREL_SYNC(token(pipe, next, i), own, 0, 0, 1);
+
+    d += 3;
+  }
+
+  // Back from the last slot to the first
+  d[-1].sync.linkAddr = -(int32_t)((3 * pipe->slotCount) - 1)
+                        * LDMA_DESCRIPTOR_NDWORDS;
+}
+
+/**************************************************************************//**
+ * @brief Initialize a pipeline without stages
+ * @param[out] pipe Pipeline state
+ * @param[in] slots Slot buffers, copied, each of slotBytes and word aligned
+ * @param[in] slotCount Slot buffers, 1 to LDMAPIPE_MAX_SLOTS; 2 lets one
+ *   stage fill a slot while the next empties the other
+ * @param[in] slotBytes Block size
+ * @param[in] syncShift First SYNC bit used, the pipeline takes
+ *   stages * slotCount bits from here
+ * @return false if the slot configuration is not supported
+ *****************************************************************************/
+bool LDMAPIPE_Init(LDMAPIPE_Pipe_t *pipe,
+                   void * const *slots, unsigned int slotCount,
+                   size_t slotBytes, unsigned int syncShift)
+{
+  unsigned int i;
+
+  if ((slotCount == 0) || (slotCount > LDMAPIPE_MAX_SLOTS)
+      || (slotBytes == 0) || (syncShift + (2 * slotCount) > LDMAPIPE_SYNC_BITS)) {
+    return false;
+  }
+
+  for (i = 0; i < slotCount; i++) {
+    pipe->slot[i] = slots[i];
+  }
+  pipe->slotCount  = slotCount;
+  pipe->slotBytes  = slotBytes;
+  pipe->syncShift  = syncShift;
+  pipe->stageCount = 0;
+  pipe->running    = false;
+  pipe->blocks     = 0;
+  pipe->callback   = NULL;
+  pipe->user       = NULL;
+
+  return true;
+}
+
+/**************************************************************************//**
+ * @brief Add the next stage to the pipeline
+ * @details
+ *   The first stage added gets the slots first, so it normally fills
+ *   them. The block must be a whole number of units and at most
+ *   LDMA_DESCRIPTOR_MAX_XFER_SIZE of them.
+ * @param[in] stage Stage configuration, copied
+ * @return false if the pipeline is running or full, the channel is in use
+ *   or does not exist, the SYNC bits run out or the block does not fit
+ *****************************************************************************/
+bool LDMAPIPE_AddStage(LDMAPIPE_Pipe_t *pipe, const LDMAPIPE_Stage_t *stage)
+{
+  size_t unit = 1U << stage->size;
+  unsigned int i;
+
+  if (pipe->running || (pipe->stageCount >= LDMAPIPE_MAX_STAGES)
+      || (stage->channel >= DMA_CHAN_COUNT)) {
+    return false;
+  }
+  if (pipe->syncShift + ((pipe->stageCount + 1) * pipe->slotCount)
+      > LDMAPIPE_SYNC_BITS) {
+    return false;
+  }
+  if (((pipe->slotBytes % unit) != 0)
+      || ((pipe->slotBytes / unit) > LDMA_DESCRIPTOR_MAX_XFER_SIZE)) {
+    return false;
+  }
+  for (i = 0; i < pipe->stageCount; i++) {
+    if (pipe->stage[i].channel == stage->channel) {
+      return false;
+    }
+  }
+
+  pipe->stage[pipe->stageCount++] = *stage;
+
+  return true;
+}
+
+/**************************************************************************//**
+ * @brief Start the pipeline
+ * @details
+ *   All channels are started waiting on their SYNC bits, then the bits of
+ *   stage 0 are set for all slots, which lets the first block in. The
+ *   peripherals must be set up first; a stage that reads a peripheral
+ *   starts with its next request.
+ * @param[in] callback Called after each block of the last stage, may be NULL
+ * @param[in] user Passed to the callback
+ * @return false if the pipeline is running or has fewer than 2 stages
+ *****************************************************************************/
+bool LDMAPIPE_Start(LDMAPIPE_Pipe_t *pipe,
+                    LDMAPIPE_Callback_t callback, void *user)
+{
+  LDMA_TransferCfg_t cfg;
+  uint32_t start = 0;
+  unsigned int i;
+
+  if (pipe->running || (pipe->stageCount < 2)) {
+    return false;
+  }
+
+  for (i = 0; i < pipe->stageCount; i++) {
+    buildStage(pipe, i);
+  }
+
+  pipe->blocks   = 0;
+  pipe->callback = callback;
+  pipe->user     = user;
+  pipe->running  = true;
+
+  LDMA->SYNCSWCLR = tokenMask(pipe);
+
+  for (i = 0; i < pipe->stageCount; i++) {
+    if (pipe->stage[i].signal == ldmaPeripheralSignal_NONE) {
+      cfg = (LDMA_TransferCfg_t)LDMA_TRANSFER_CFG_MEMORY();
+    } else {
+      cfg = (LDMA_TransferCfg_t)
+            LDMA_TRANSFER_CFG_PERIPHERAL(pipe->stage[i].signal);
+    }
+    LDMA_StartTransfer(pipe->stage[i].channel, &cfg, pipe->desc[i]);
+  }
+
+  for (i = 0; i < pipe->slotCount; i++) {
+    start |= token(pipe, 0, i);
+  }
+  LDMA->SYNCSWSET = start;
+
+  return true;
+}
+
+/**************************************************************************//**
+ * @brief Stop all stages of the pipeline
+ * @details
+ *   The blocks in flight are dropped and their SYNC bits cleared; the
+ *   stages can be changed and the pipeline started again.
+ *****************************************************************************/
+void LDMAPIPE_Stop(LDMAPIPE_Pipe_t *pipe)
+{
+  unsigned int i;
+
+  if (!pipe->running) {
+    return;
+  }
+
+  for (i = 0; i < pipe->stageCount; i++) {
+    LDMA_StopTransfer(pipe->stage[i].channel);
+  }
+  LDMA->SYNCSWCLR = tokenMask(pipe);
+  LDMA_IntClear(1UL << pipe->stage[pipe->stageCount - 1].channel);
+
+  pipe->running = false;
+}
+
+/**************************************************************************//**
+ * @brief Check if the pipeline is running
+ *****************************************************************************/
+bool LDMAPIPE_IsRunning(LDMAPIPE_Pipe_t *pipe)
+{
+  return pipe->running;
+}
+
+/**************************************************************************//**
+ * @brief Get the blocks the last stage moved since LDMAPIPE_Start()
+ *****************************************************************************/
+uint32_t LDMAPIPE_Blocks(LDMAPIPE_Pipe_t *pipe)
+{
+  return pipe->blocks;
+}
+
+/**************************************************************************//**
+ * @brief Handle the LDMA interrupt of the pipeline
+ * @details
+ *   Only the done flag of the last stage is read and cleared, so several
+ *   pipelines and other LDMA users can share LDMA_IRQHandler().
+ *****************************************************************************/
+void LDMAPIPE_IRQHandler(LDMAPIPE_Pipe_t *pipe)
+{
+  uint32_t mask;
+
+  if (!pipe->running) {
+    return;
+  }
+
+  mask = 1UL << pipe->stage[pipe->stageCount - 1].channel;
+  if (!(LDMA_IntGet() & mask)) {
+    return;
+  }
+  LDMA_IntClear(mask);
+
+  pipe->blocks++;
+  if (pipe->callback != NULL) {
+    pipe->callback(pipe, pipe->blocks, pipe->user);
+  }
+}
+
+/** @} (end group LdmaPipe) */
+/** @} (end group kitdrv) */
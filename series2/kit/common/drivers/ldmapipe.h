@@ -0,0 +1,151 @@
+/***************************************************************************//**
+ * @file
+ * @brief LDMA multi-channel pipelines synchronized with the SYNC bits.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2022 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ******************************************************************************/
+
+
+#ifndef __LDMAPIPE_H
+#define __LDMAPIPE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "em_ldma.h"
+
+/***************************************************************************//**
+ * @addtogroup kitdrv
+ * @{
+ ******************************************************************************/
+
+/***************************************************************************//**
+ * @addtogroup LdmaPipe
+ * @brief LDMA multi-channel pipelines synchronized with the SYNC bits
+ * @details
+ *    Runs a chain of stages, one LDMA channel each, over a ring of slot
+ *    buffers: stage 0 moves a block into a slot, for example from the IADC,
+ *    then hands the slot to stage 1, which moves it on, for example into
+ *    the GPCRC, and so on; the last stage hands the slot back to stage 0.
+ *    The hand-off is made by the LDMA itself with the SYNC bits, so once
+ *    started the pipeline runs without the CPU, and each stage waits in
+ *    hardware for the stage before it. A slow stage, such as a UART, holds
+ *    the stages before it back once all slots are in use.
+ *
+ *    Each stage owns one SYNC bit per slot, set while the slot is its
+ *    turn. A stage loops over the slots with three descriptors each: a
+ *    SYNC waiting for its bit, the block transfer and a SYNC clearing its
+ *    bit and setting the bit of the next stage. The pipeline takes
+ *    stages * slots SYNC bits from syncShift up, all 8 for 4 stages of
+ *    2 slots.
+ *
+ *    A stage with a peripheral request moves one unit per request, one
+ *    with ldmaPeripheralSignal_NONE moves the whole block as soon as it
+ *    has the slot. The last stage raises the channel done flag after each
+ *    block; LDMAPIPE_IRQHandler() counts the blocks and calls the callback,
+ *    by then the slot is already handed back to stage 0.
+ *
+ *    The application calls LDMA_Init() once and calls LDMAPIPE_IRQHandler()
+ *    from its LDMA_IRQHandler(). Channels may come from LDMAMGR_Alloc().
+ * @{
+ ******************************************************************************/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef LDMAPIPE_MAX_STAGES
+#define LDMAPIPE_MAX_STAGES       4     /**< Stages of a pipeline */
+#endif
+
+#ifndef LDMAPIPE_MAX_SLOTS
+#define LDMAPIPE_MAX_SLOTS        2     /**< Slot buffers of a pipeline */
+#endif
+
+#define LDMAPIPE_SYNC_BITS        8     /**< LDMA SYNC bits */
+
+#if (LDMAPIPE_MAX_STAGES < 2) || (LDMAPIPE_MAX_SLOTS < 1) \
+  || (LDMAPIPE_MAX_SLOTS > LDMAPIPE_SYNC_BITS / 2)
+#error "LDMAPIPE_MAX_STAGES must be 2 or more and LDMAPIPE_MAX_SLOTS 1 to 4"
+#endif
+
+struct LDMAPIPE_Pipe;
+
+/** Called from LDMAPIPE_IRQHandler() after the last stage moved a block */
+typedef void (*LDMAPIPE_Callback_t)(struct LDMAPIPE_Pipe *pipe,
+                                    uint32_t blocks, void *user);
+
+/** What a stage moves */
+typedef enum {
+  ldmaPipeFromPeri,                     /**< Peripheral register into the slot */
+  ldmaPipeToPeri,                       /**< Slot into a peripheral register */
+  ldmaPipeToMem                         /**< Slot into a memory buffer */
+} LDMAPIPE_Dir_t;
+
+/** Stage configuration */
+typedef struct {
+  unsigned int            channel;      /**< LDMA channel */
+  LDMAPIPE_Dir_t          dir;          /**< Direction of the block transfer */
+  LDMA_PeripheralSignal_t signal;       /**< Request, ldmaPeripheralSignal_NONE for none */
+  volatile void           *addr;        /**< Peripheral register, or memory of slotBytes */
+  LDMA_CtrlSize_t         size;         /**< Unit size */
+} LDMAPIPE_Stage_t;
+
+/** Pipeline state, treat as opaque */
+typedef struct LDMAPIPE_Pipe {
+  LDMAPIPE_Stage_t        stage[LDMAPIPE_MAX_STAGES];
+  unsigned int            stageCount;
+  void                    *slot[LDMAPIPE_MAX_SLOTS];
+  unsigned int            slotCount;
+  size_t                  slotBytes;
+  unsigned int            syncShift;
+  LDMA_Descriptor_t       desc[LDMAPIPE_MAX_STAGES][3 * LDMAPIPE_MAX_SLOTS];
+  volatile bool           running;
+  volatile uint32_t       blocks;
+  LDMAPIPE_Callback_t     callback;
+  void                    *user;
+} LDMAPIPE_Pipe_t;
+
+bool     LDMAPIPE_Init(LDMAPIPE_Pipe_t *pipe,
+                       void * const *slots, unsigned int slotCount,
+                       size_t slotBytes, unsigned int syncShift);
+bool     LDMAPIPE_AddStage(LDMAPIPE_Pipe_t *pipe,
+                           const LDMAPIPE_Stage_t *stage);
+bool     LDMAPIPE_Start(LDMAPIPE_Pipe_t *pipe,
+                        LDMAPIPE_Callback_t callback, void *user);
+void     LDMAPIPE_Stop(LDMAPIPE_Pipe_t *pipe);
+bool     LDMAPIPE_IsRunning(LDMAPIPE_Pipe_t *pipe);
+uint32_t LDMAPIPE_Blocks(LDMAPIPE_Pipe_t *pipe);
+void     LDMAPIPE_IRQHandler(LDMAPIPE_Pipe_t *pipe);
+
+#ifdef __cplusplus
+}
+#endif
+
+/** @} (end group LdmaPipe) */
+/** @} (end group kitdrv) */
+
+#endif
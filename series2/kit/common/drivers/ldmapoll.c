@@ -0,0 +1,237 @@
+/***************************************************************************//**
+ * @file
+ * @brief LDMA register poller on a looped descriptor program.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2022 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ******************************************************************************/
+
+#include <stddef.h>
+#include "em_core.h"
+#include "ldmapoll.h"
+
+/***************************************************************************//**
+ * @addtogroup kitdrv
+ * @{
+ ******************************************************************************/
+
+/***************************************************************************//**
+ * @addtogroup LdmaPoll
+ * @{
+ ******************************************************************************/
+
+/**************************************************************************//**
+ * @brief Set a descriptor up to read one register
+ * @param[in] dst Absolute address to write, 0 to write after the previous
+ *   register
+ * @param[in] first Wait for the request instead of following right away
+ *****************************************************************************/
+static void setRead(LDMA_Descriptor_t *d, const volatile uint32_t *reg,
+                    uint32_t *dst, bool first)
+{
+  *d = (LDMA_Descriptor_t)
+    LDMA_DESCRIPTOR_LINKREL_M2M_WORD(reg, dst, 1, 1);
+  d->xfer.srcInc    = ldmaCtrlSrcIncNone;
+  d->xfer.doneIfs   = 0;
+  d->xfer.structReq = first ? 0 : 1;
+  if (dst == NULL) {
+    d->xfer.dstAddrMode = ldmaCtrlDstAddrModeRel;
+    d->xfer.dstAddr     = 0;
+  }
+}
+
+/**************************************************************************//**
+ * @brief Build the descriptors of one batch
+ * @param[in] next First descriptor of the batch that follows
+ *****************************************************************************/
+static void buildBatch(LDMAPOLL_Poller_t *poller, unsigned int batch,
+                       const LDMA_Descriptor_t *next)
+{
+  const LDMAPOLL_Init_t *init = &poller->init;
+  LDMA_Descriptor_t *d = poller->desc[batch];
+  unsigned int count = init->regCount;
+  unsigned int i, n = 0;
+
+  // First row, from the start of the batch
+  for (i = 0; i < count; i++) {
+    setRead(&d[n++], init->regs[i],
+            (i == 0) ? &init->table[batch * init->batchRows * count] : NULL,
+            i == 0);
+  }
+
+  if (init->batchRows > 1) {
+    // The other rows, the last read repeats the row on the loop counter
+    // and then goes on with the next descriptor in memory
+    for (i = 0; i < count; i++) {
+      setRead(&d[n++], init->regs[i], NULL, i == 0);
+    }
+    d[n - 1].xfer.decLoopCnt = 1;
+    d[n - 1].xfer.linkAddr = -(int32_t)(count - 1) * 4;
+
+    // Loop count for the next batch, raises the done flag once per batch
+    // and links to the next batch, the last one back to the first
+    d[n] = (LDMA_Descriptor_t)
+      LDMA_DESCRIPTOR_LINKREL_WRITE(init->batchRows - 2,
+                                    &LDMA->CH[init->channel].LOOP, 1);
+    d[n].wri.doneIfs  = 1;
+    d[n].wri.linkAddr = (int32_t)(next - &d[n]) * 4;
+  } else {
+    d[n - 1].xfer.doneIfs  = 1;
+    d[n - 1].xfer.linkAddr = (int32_t)(next - &d[n - 1]) * 4;
+  }
+}
+
+/**************************************************************************//**
+ * @brief Initialize a poller and build its descriptor program
+ * @param[out] poller Poller state
+ * @param[in] init Configuration, copied into the poller; the register list
+ *   and the table must stay valid while the poller runs
+ * @return false if the LDMA channel does not exist or the sizes are out of
+ *   range, nothing is built then
+ *****************************************************************************/
+bool LDMAPOLL_Init(LDMAPOLL_Poller_t *poller, const LDMAPOLL_Init_t *init)
+{
+  unsigned int b;
+
+  if ((init->channel >= DMA_CHAN_COUNT)
+      || (init->regs == NULL) || (init->table == NULL)
+      || (init->regCount == 0) || (init->regCount > LDMAPOLL_MAX_REGS)
+      || (init->batchRows == 0) || (init->batchRows > LDMAPOLL_MAX_BATCH_ROWS)
+      || (init->batches == 0) || (init->batches > LDMAPOLL_MAX_BATCHES)) {
+    return false;
+  }
+
+  poller->init       = *init;
+  poller->batch      = 0;
+  poller->batchCount = 0;
+  poller->running    = false;
+
+  for (b = 0; b < init->batches; b++) {
+    buildBatch(poller, b, poller->desc[(b + 1) % init->batches]);
+  }
+
+  return true;
+}
+
+/**************************************************************************//**
+ * @brief Start reading a row on every request, from the first batch
+ * @details
+ *   The first request after this fills the first row of the table.
+ *****************************************************************************/
+void LDMAPOLL_Start(LDMAPOLL_Poller_t *poller)
+{
+  const LDMAPOLL_Init_t *init = &poller->init;
+  uint32_t loopCnt = (init->batchRows > 1) ? (init->batchRows - 2) : 0;
+  LDMA_TransferCfg_t cfg =
+    LDMA_TRANSFER_CFG_PERIPHERAL_LOOP(init->signal, loopCnt);
+
+  LDMAPOLL_Stop(poller);
+
+  poller->batch      = 0;
+  poller->batchCount = 0;
+  poller->running    = true;
+  LDMA_StartTransfer(init->channel, &cfg, &poller->desc[0][0]);
+}
+
+/**************************************************************************//**
+ * @brief Stop the poller; the rows already read stay in the table
+ *****************************************************************************/
+void LDMAPOLL_Stop(LDMAPOLL_Poller_t *poller)
+{
+  if (!poller->running) {
+    return;
+  }
+  LDMA_StopTransfer(poller->init.channel);
+  LDMA_IntClear(1UL << poller->init.channel);
+  poller->running = false;
+}
+
+/**************************************************************************//**
+ * @brief Check if the poller is running
+ *****************************************************************************/
+bool LDMAPOLL_IsRunning(LDMAPOLL_Poller_t *poller)
+{
+  return poller->running;
+}
+
+/**************************************************************************//**
+ * @brief Get the number of batches completed since LDMAPOLL_Start()
+ *****************************************************************************/
+uint32_t LDMAPOLL_GetBatchCount(LDMAPOLL_Poller_t *poller)
+{
+  return poller->batchCount;
+}
+
+/**************************************************************************//**
+ * @brief Get the row of the table the LDMA writes next
+ * @details
+ *   Rows before it in its batch are complete, so the CPU can look at a
+ *   batch before it is full. A row being read may be counted as done.
+ *****************************************************************************/
+unsigned int LDMAPOLL_GetRowIndex(LDMAPOLL_Poller_t *poller)
+{
+  const LDMAPOLL_Init_t *init = &poller->init;
+  uint32_t offset = LDMA->CH[init->channel].DST
+                    - (uint32_t)(uintptr_t)init->table;
+  unsigned int rows = init->batches * init->batchRows;
+
+  // Words written, to rows; after the last row the LDMA wraps around
+  return (offset / (4 * init->regCount)) % rows;
+}
+
+/**************************************************************************//**
+ * @brief Handle the LDMA interrupt of the poller's channel
+ * @details
+ *   Only the done flag of the channel is read and cleared, so other LDMA
+ *   users can share LDMA_IRQHandler().
+ *****************************************************************************/
+void LDMAPOLL_IRQHandler(LDMAPOLL_Poller_t *poller)
+{
+  const LDMAPOLL_Init_t *init = &poller->init;
+  uint32_t mask = 1UL << init->channel;
+  unsigned int batch;
+
+  if (!(LDMA_IntGet() & mask)) {
+    return;
+  }
+  LDMA_IntClear(mask);
+
+  if (!poller->running) {
+    return;
+  }
+
+  batch = poller->batch;
+  poller->batch = (batch + 1) % init->batches;
+  poller->batchCount++;
+
+  if (init->callback != NULL) {
+    init->callback(poller,
+                   &init->table[batch * init->batchRows * init->regCount],
+                   init->batchRows, init->user);
+  }
+}
+
+/** @} (end group LdmaPoll) */
+/** @} (end group kitdrv) */
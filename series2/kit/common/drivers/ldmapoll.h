@@ -0,0 +1,140 @@
+/***************************************************************************//**
+ * @file
+ * @brief LDMA register poller on a looped descriptor program.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2022 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ******************************************************************************/
+
+#ifndef __LDMAPOLL_H
+#define __LDMAPOLL_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "em_ldma.h"
+
+/***************************************************************************//**
+ * @addtogroup kitdrv
+ * @{
+ ******************************************************************************/
+
+/***************************************************************************//**
+ * @addtogroup LdmaPoll
+ * @brief LDMA register poller on a looped descriptor program
+ * @details
+ *    Reads a list of peripheral registers, such as a GPIO DIN, a PCNT CNT
+ *    and an ACMP STATUS, into one row of a RAM table on each request of a
+ *    peripheral, typically the overflow of a timer, with no CPU. Putting
+ *    the count of a free running timer first in the list stamps each row.
+ *
+ *    The table is a ring of batches of rows. Each register of a row is one
+ *    descriptor: the first waits for the request, the others follow right
+ *    away. The first row of a batch writes from the start of the batch,
+ *    the other rows are the same descriptors again on the loop counter,
+ *    each writing after the previous one. The batch ends in a write of the
+ *    loop counter for the next batch, which raises the done flag, and the
+ *    last batch links back to the first, so the program runs until
+ *    stopped. A batch takes 2 * regCount + 1 descriptors whatever its
+ *    number of rows.
+ *
+ *    The callback is called from LDMAPOLL_IRQHandler() with each full
+ *    batch, while the LDMA fills the next one. It must be done with the
+ *    rows within one batch of requests, or they are overwritten.
+ *
+ *    The rows are read within a few LDMA cycles of the request each, but
+ *    the registers of a row are read one after the other, not at the same
+ *    instant. A request while a row is still being read is served after
+ *    it, so a request period shorter than a row starts to drop rows.
+ *
+ *    The application calls LDMA_Init() once and calls LDMAPOLL_IRQHandler()
+ *    from its LDMA_IRQHandler(). The peripheral request must be cleared by
+ *    the LDMA serving it; set dmaClrAct in the TIMER_Init_TypeDef of a
+ *    timer.
+ * @{
+ ******************************************************************************/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef LDMAPOLL_MAX_REGS
+#define LDMAPOLL_MAX_REGS         8     /**< Registers in a row */
+#endif
+
+#ifndef LDMAPOLL_MAX_BATCHES
+#define LDMAPOLL_MAX_BATCHES      2     /**< Batches in the table */
+#endif
+
+/** Rows of a batch, the first and 256 repeats on the loop counter */
+#define LDMAPOLL_MAX_BATCH_ROWS   257
+
+/** Descriptors of a batch */
+#define LDMAPOLL_BATCH_DESCRIPTORS  ((2 * LDMAPOLL_MAX_REGS) + 1)
+
+struct LDMAPOLL_Poller;
+
+/** Called from LDMAPOLL_IRQHandler() with a full batch of rows */
+typedef void (*LDMAPOLL_Callback_t)(struct LDMAPOLL_Poller *poller,
+                                    const uint32_t *rows, unsigned int count,
+                                    void *user);
+
+/** Poller configuration */
+typedef struct {
+  unsigned int            channel;      /**< LDMA channel */
+  LDMA_PeripheralSignal_t signal;       /**< Request reading a row */
+  const volatile uint32_t * const *regs; /**< Registers of a row, in order */
+  unsigned int            regCount;     /**< Registers of a row, 1 to LDMAPOLL_MAX_REGS */
+  uint32_t                *table;       /**< batches * batchRows * regCount words */
+  unsigned int            batchRows;    /**< Rows of a batch, 1 to LDMAPOLL_MAX_BATCH_ROWS */
+  unsigned int            batches;      /**< Batches in the table, 1 to LDMAPOLL_MAX_BATCHES */
+  LDMAPOLL_Callback_t     callback;     /**< Called with each full batch, may be NULL */
+  void                    *user;        /**< Passed to the callback */
+} LDMAPOLL_Init_t;
+
+/** Poller state, treat as opaque */
+typedef struct LDMAPOLL_Poller {
+  LDMAPOLL_Init_t         init;
+  LDMA_Descriptor_t       desc[LDMAPOLL_MAX_BATCHES][LDMAPOLL_BATCH_DESCRIPTORS];
+  unsigned int            batch;        /**< Next batch to complete */
+  volatile uint32_t       batchCount;   /**< Batches completed */
+  volatile bool           running;
+} LDMAPOLL_Poller_t;
+
+bool     LDMAPOLL_Init(LDMAPOLL_Poller_t *poller, const LDMAPOLL_Init_t *init);
+void     LDMAPOLL_Start(LDMAPOLL_Poller_t *poller);
+void     LDMAPOLL_Stop(LDMAPOLL_Poller_t *poller);
+bool     LDMAPOLL_IsRunning(LDMAPOLL_Poller_t *poller);
+uint32_t LDMAPOLL_GetBatchCount(LDMAPOLL_Poller_t *poller);
+unsigned int LDMAPOLL_GetRowIndex(LDMAPOLL_Poller_t *poller);
+void     LDMAPOLL_IRQHandler(LDMAPOLL_Poller_t *poller);
+
+#ifdef __cplusplus
+}
+#endif
+
+/** @} (end group LdmaPoll) */
+/** @} (end group kitdrv) */
+
+#endif
@@ -0,0 +1,214 @@
+/***************************************************************************//**
+ * @file
+ * @brief LDMA ring of N buffers for continuous peripheral streaming.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2022 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ******************************************************************************/
+
+#include <stddef.h>
+#include "em_core.h"
+#include "energymark.h"
+#include "ldmastream.h"
+
+/***************************************************************************//**
+ * @addtogroup kitdrv
+ * @{
+ ******************************************************************************/
+
+/***************************************************************************//**
+ * @addtogroup LdmaStream
+ * @{
+ ******************************************************************************/
+
+/**************************************************************************//**
+ * @brief Initialize a stream and build its descriptor ring
+ * @param[out] stream Stream state
+ * @param[in] init Configuration, copied into the stream
+ * @return false if the configuration is not supported
+ *****************************************************************************/
+bool LDMASTREAM_Init(LDMASTREAM_Stream_t *stream, const LDMASTREAM_Init_t *init)
+{
+  unsigned int i;
+  int link;
+
+  if ((init->count < 2) || (init->count > LDMASTREAM_MAX_BUFFERS)
+      || (init->length == 0) || (init->length > LDMA_DESCRIPTOR_MAX_XFER_SIZE)) {
+    return false;
+  }
+
+  stream->init = *init;
+
+  for (i = 0; i < init->count; i++) {
+    // Each descriptor links to the next one, the last back to the first
+    link = (i == init->count - 1) ? -(int)(init->count - 1) : 1;
+
+    if (init->direction == ldmaStreamPeriToMem) {
+      stream->desc[i] = (LDMA_Descriptor_t)
+        LDMA_DESCRIPTOR_LINKREL_P2M_BYTE(init->periAddr, init->buffers[i],
+                                         init->length, link);
+    } else {
+      stream->desc[i] = (LDMA_Descriptor_t)
+        LDMA_DESCRIPTOR_LINKREL_M2P_BYTE(init->buffers[i], init->periAddr,
+                                         init->length, link);
+    }
+    stream->desc[i].xfer.size    = init->size;
+    stream->desc[i].xfer.doneIfs = 1;
+  }
+
+  stream->dmaIndex  = 0;
+  stream->readIndex = 0;
+  stream->ready     = 0;
+  stream->overruns  = 0;
+  stream->running   = false;
+
+  return true;
+}
+
+/**************************************************************************//**
+ * @brief Start the stream at the first buffer
+ * @details
+ *   For memory to peripheral the buffers must be filled before this call.
+ *****************************************************************************/
+void LDMASTREAM_Start(LDMASTREAM_Stream_t *stream)
+{
+  LDMA_TransferCfg_t cfg = LDMA_TRANSFER_CFG_PERIPHERAL(stream->init.signal);
+
+  stream->dmaIndex  = 0;
+  stream->readIndex = 0;
+  stream->ready     = 0;
+  stream->running   = true;
+
+  LDMA_StartTransfer(stream->init.channel, &cfg, &stream->desc[0]);
+}
+
+/**************************************************************************//**
+ * @brief Stop the stream
+ *****************************************************************************/
+void LDMASTREAM_Stop(LDMASTREAM_Stream_t *stream)
+{
+  LDMA_StopTransfer(stream->init.channel);
+  stream->running = false;
+}
+
+/**************************************************************************//**
+ * @brief Get the oldest completed buffer
+ * @details
+ *   The buffer stays owned by the application until it is passed to
+ *   LDMASTREAM_Release(). Calling this again before releasing returns
+ *   the same buffer.
+ * @return Buffer address, or NULL if no buffer has completed
+ *****************************************************************************/
+void *LDMASTREAM_Acquire(LDMASTREAM_Stream_t *stream)
+{
+  void *buffer = NULL;
+  CORE_DECLARE_IRQ_STATE;
+
+  CORE_ENTER_ATOMIC();
+  if (stream->ready > 0) {
+    buffer = stream->init.buffers[stream->readIndex];
+  }
+  CORE_EXIT_ATOMIC();
+
+  return buffer;
+}
+
+/**************************************************************************//**
+ * @brief Give a buffer from LDMASTREAM_Acquire() back to the LDMA
+ * @details
+ *   Nothing happens if the buffer was already dropped because of an
+ *   overrun while the application held it.
+ *****************************************************************************/
+void LDMASTREAM_Release(LDMASTREAM_Stream_t *stream, void *buffer)
+{
+  CORE_DECLARE_IRQ_STATE;
+
+  CORE_ENTER_ATOMIC();
+  if ((stream->ready > 0)
+      && (stream->init.buffers[stream->readIndex] == buffer)) {
+    stream->readIndex = (stream->readIndex + 1) % stream->init.count;
+    stream->ready--;
+  }
+  CORE_EXIT_ATOMIC();
+}
+
+/**************************************************************************//**
+ * @brief Get the number of completed buffers not released yet
+ *****************************************************************************/
+unsigned int LDMASTREAM_ReadyCount(LDMASTREAM_Stream_t *stream)
+{
+  return stream->ready;
+}
+
+/**************************************************************************//**
+ * @brief Get the number of buffers dropped because the LDMA caught up
+ *****************************************************************************/
+uint32_t LDMASTREAM_Overruns(LDMASTREAM_Stream_t *stream)
+{
+  return stream->overruns;
+}
+
+/**************************************************************************//**
+ * @brief Handle the LDMA interrupt of a stream
+ * @details
+ *   Only the done flag of the stream's channel is read and cleared, so
+ *   several streams and other LDMA users can share LDMA_IRQHandler().
+ *****************************************************************************/
+void LDMASTREAM_IRQHandler(LDMASTREAM_Stream_t *stream)
+{
+  uint32_t mask = 1UL << stream->init.channel;
+  unsigned int index;
+
+  if (!(LDMA_IntGet() & mask)) {
+    return;
+  }
+  LDMA_IntClear(mask);
+
+  if (!stream->running) {
+    return;
+  }
+
+  ENERGYMARK_BEGIN(ENERGYMARK_ID_LDMASTREAM);
+
+  index = stream->dmaIndex;
+  stream->dmaIndex = (index + 1) % stream->init.count;
+
+  if (stream->ready == stream->init.count - 1) {
+    // The LDMA is now working on the oldest unreleased buffer
+    stream->readIndex = (stream->readIndex + 1) % stream->init.count;
+    stream->overruns++;
+  } else {
+    stream->ready++;
+  }
+
+  if (stream->init.callback != NULL) {
+    stream->init.callback(stream, index, stream->init.buffers[index]);
+  }
+
+  ENERGYMARK_END(ENERGYMARK_ID_LDMASTREAM);
+}
+
+/** @} (end group LdmaStream) */
+/** @} (end group kitdrv) */
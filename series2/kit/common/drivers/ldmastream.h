@@ -0,0 +1,128 @@
+/***************************************************************************//**
+ * @file
+ * @brief LDMA ring of N buffers for continuous peripheral streaming.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2022 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ******************************************************************************/
+
+#ifndef __LDMASTREAM_H
+#define __LDMASTREAM_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "em_ldma.h"
+
+/***************************************************************************//**
+ * @addtogroup kitdrv
+ * @{
+ ******************************************************************************/
+
+/***************************************************************************//**
+ * @addtogroup LdmaStream
+ * @brief LDMA buffer ring for continuous peripheral streaming
+ * @details
+ *    The LDMA moves data between a peripheral register and a ring of N
+ *    application buffers, using one descriptor per buffer linked in a
+ *    circle. This generalizes the ping-pong (N = 2) descriptor pair.
+ *
+ *    Completed buffers are handed to the application without copying,
+ *    either through the ready callback (interrupt context) or by
+ *    LDMASTREAM_Acquire()/LDMASTREAM_Release() from the main loop.
+ *    For peripheral to memory a completed buffer holds new data; for
+ *    memory to peripheral it has been sent and can be refilled.
+ *
+ *    The LDMA does not wait for the application. If it wraps around onto
+ *    a buffer that has not been released the oldest buffer is dropped
+ *    and counted as an overrun.
+ *
+ *    The application calls LDMA_Init() once and calls
+ *    LDMASTREAM_IRQHandler() for each stream from its LDMA_IRQHandler().
+ * @{
+ ******************************************************************************/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef LDMASTREAM_MAX_BUFFERS
+#define LDMASTREAM_MAX_BUFFERS    8     /**< Maximum buffers per stream */
+#endif
+
+struct LDMASTREAM_Stream;
+
+/** Called from LDMASTREAM_IRQHandler() each time a buffer completes */
+typedef void (*LDMASTREAM_Callback_t)(struct LDMASTREAM_Stream *stream,
+                                      unsigned int index,
+                                      void *buffer);
+
+/** Transfer direction */
+typedef enum {
+  ldmaStreamPeriToMem,                  /**< Peripheral register to buffers */
+  ldmaStreamMemToPeri                   /**< Buffers to peripheral register */
+} LDMASTREAM_Direction_t;
+
+/** Stream configuration */
+typedef struct {
+  unsigned int            channel;      /**< LDMA channel */
+  LDMA_PeripheralSignal_t signal;       /**< Peripheral request signal */
+  LDMASTREAM_Direction_t  direction;    /**< Transfer direction */
+  volatile void           *periAddr;    /**< Peripheral data register */
+  LDMA_CtrlSize_t         size;         /**< Unit size, byte/half/word */
+  void * const            *buffers;     /**< Buffer addresses */
+  unsigned int            count;        /**< Number of buffers, 2..LDMASTREAM_MAX_BUFFERS */
+  unsigned int            length;       /**< Units per buffer */
+  LDMASTREAM_Callback_t   callback;     /**< Ready callback, may be NULL */
+  void                    *user;        /**< Application data for the callback */
+} LDMASTREAM_Init_t;
+
+/** Stream state, treat as opaque */
+typedef struct LDMASTREAM_Stream {
+  LDMASTREAM_Init_t       init;
+  LDMA_Descriptor_t       desc[LDMASTREAM_MAX_BUFFERS];
+  volatile unsigned int   dmaIndex;     /**< Buffer the LDMA is working on */
+  volatile unsigned int   readIndex;    /**< Oldest completed buffer */
+  volatile unsigned int   ready;        /**< Completed, not released buffers */
+  volatile uint32_t       overruns;     /**< Buffers dropped */
+  bool                    running;
+} LDMASTREAM_Stream_t;
+
+bool         LDMASTREAM_Init(LDMASTREAM_Stream_t *stream, const LDMASTREAM_Init_t *init);
+void         LDMASTREAM_Start(LDMASTREAM_Stream_t *stream);
+void         LDMASTREAM_Stop(LDMASTREAM_Stream_t *stream);
+void         *LDMASTREAM_Acquire(LDMASTREAM_Stream_t *stream);
+void         LDMASTREAM_Release(LDMASTREAM_Stream_t *stream, void *buffer);
+unsigned int LDMASTREAM_ReadyCount(LDMASTREAM_Stream_t *stream);
+uint32_t     LDMASTREAM_Overruns(LDMASTREAM_Stream_t *stream);
+void         LDMASTREAM_IRQHandler(LDMASTREAM_Stream_t *stream);
+
+#ifdef __cplusplus
+}
+#endif
+
+/** @} (end group LdmaStream) */
+/** @} (end group kitdrv) */
+
+#endif
@@ -8,9 +8,20 @@
  */
 
 #include "mx25flash_spi.h"
+#include <stddef.h>
+#include <string.h>
 #include "em_gpio.h"
 #include "em_usart.h"
 #include "em_cmu.h"
+#ifdef MX25_USE_LDMA
+#include "em_ldma.h"
+#include "em_emu.h"
+#include "em_core.h"
+#endif
+#include "energymark.h"
+#ifdef MX25_SPIBUS
+#include "spibus.h"
+#endif
 
 /* If the USART for the MX25 driver is not defined, these functions are unavailable */
 #ifdef MX25_USART
@@ -30,6 +41,71 @@
 #define MX25_BAUDRATE   8000000
 #endif
 
+/* Set while the SPI pins are driven by GPIO for a dual I/O transfer */
+static bool                     dualIoActive = false;
+static bool                     dualIoOutput;
+
+#ifdef MX25_SPIBUS
+static SPIBUS_Client_TypeDef    busClient;
+#endif
+
+/* Cached device parameters, see MX25_SessionRefresh */
+static MX25_Session             flashSession;
+
+/* State of the non-blocking program/erase in progress */
+static volatile bool            asyncBusy = false;
+static uint32_t                 asyncPollsLeft;
+static MX25_AsyncCallback       asyncCallback;
+
+#ifdef MX25_AUTO_DP
+/* Deep power down state, see MX25_PowerTick */
+static MX25_PowerState          powerState;
+static uint32_t                 powerIdleTicks;
+static uint32_t                 powerWakeStart;
+static uint32_t                 powerWakeCycles;
+#endif
+
+#ifdef MX25_USE_LDMA
+/* Default to the two highest channels so examples can keep using 0 and up */
+#ifndef MX25_LDMA_RX_CHANNEL
+#define MX25_LDMA_RX_CHANNEL   (DMA_CHAN_COUNT - 2)
+#endif
+#ifndef MX25_LDMA_TX_CHANNEL
+#define MX25_LDMA_TX_CHANNEL   (DMA_CHAN_COUNT - 1)
+#endif
+#if !defined(MX25_LDMA_RX_SIGNAL) || !defined(MX25_LDMA_TX_SIGNAL)
+#error "MX25_LDMA_RX_SIGNAL and MX25_LDMA_TX_SIGNAL must be defined in mx25flash_config.h"
+#endif
+
+/* State of the LDMA read in progress */
+static volatile bool            dmaBusy = false;
+static uint8_t                  *dmaTarget;
+static uint32_t                 dmaRemaining;
+static MX25_TransferCallback    dmaCallback;
+/* Dummy byte clocked out on MOSI while reading */
+static const uint8_t            dmaTxDummy = 0xFF;
+#endif
+
+#ifdef MX25_READ_CACHE
+#ifndef MX25_CACHE_LINE_SIZE
+#define MX25_CACHE_LINE_SIZE   64
+#endif
+#ifndef MX25_CACHE_LINES
+#define MX25_CACHE_LINES       4
+#endif
+#if (MX25_CACHE_LINE_SIZE & (MX25_CACHE_LINE_SIZE - 1)) != 0
+#error "MX25_CACHE_LINE_SIZE must be a power of two"
+#endif
+#define CACHE_TAG_INVALID      0xFFFFFFFF
+
+/* Read cache lines, tagged with the flash address of their first byte.
+   The tags are set to CACHE_TAG_INVALID in MX25_init. */
+static uint8_t                  cacheData[MX25_CACHE_LINES][MX25_CACHE_LINE_SIZE];
+static uint32_t                 cacheTag[MX25_CACHE_LINES];
+static uint32_t                 cacheVictim;
+static uint32_t                 cacheLastFill = CACHE_TAG_INVALID;
+#endif
+
 /* Local functions */
 
 /* Basic functions */
@@ -38,6 +114,11 @@ void CS_Low( void );
 void InsertDummyCycle( uint8_t dummy_cycle );
 void SendByte( uint8_t byte_value, uint8_t transfer_type );
 uint8_t GetByte( uint8_t transfer_type );
+static void DualIoEnter( bool output );
+static void DualIoExit( void );
+#ifdef MX25_AUTO_DP
+static void PowerResume( void );
+#endif
 
 /* Utility functions */
 void Wait_Flash_WarmUp( void );
@@ -49,10 +130,17 @@ bool IsFlashQIO( void );
 bool IsFlash4Byte( void );
 void SendFlashAddr( uint32_t flash_address, uint8_t io_mode, bool addr_4byte_mode );
 uint8_t GetDummyCycle( uint32_t default_cycle );
+void SessionReadRegs( void );
 
 
 void MX25_init( void )
 {
+#ifdef MX25_SPIBUS
+   /* The bus pins and the USART belong to the bus, the flash is a client
+      in SPI mode 0 with its own chip select */
+   SPIBUS_ClientInit( &busClient, MX25_PORT_CS, MX25_PIN_CS, MX25_BAUDRATE,
+                      usartClockMode0, true );
+#else
    USART_InitSync_TypeDef init = USART_INITSYNC_DEFAULT;
 
    CMU_ClockEnable( cmuClock_GPIO, true );
@@ -86,13 +174,35 @@ void MX25_init( void )
                             | USART_ROUTEPEN_TXPEN
                             | USART_ROUTEPEN_CLKPEN );
 
+#endif
+#endif // MX25_SPIBUS
+#ifdef MX25_AUTO_DP
+   /* The flash may still be in deep power down, the first command releases
+      it. tRDP is timed with the DWT cycle counter at the current clock. */
+   CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+   DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+   powerWakeCycles = (uint32_t)( ((uint64_t)CMU_ClockFreqGet( cmuClock_SYSCLK ) * tRDP)
+                                 / 1000000000UL ) + 1;
+   powerState = MX25_PowerDown;
+   powerIdleTicks = 0;
 #endif
    /* Wait for flash warm-up */
    Initial_Spi();
+
+   /* Capture address mode, QE bit, dummy cycles and size once */
+   MX25_SessionRefresh();
+
+#ifdef MX25_READ_CACHE
+   MX25_CacheInvalidate();
+#endif
 }
 
 void MX25_deinit( void )
 {
+#ifdef MX25_SPIBUS
+  /* Only the chip select is the flash's, the bus goes on for the others */
+  GPIO_PinModeSet( MX25_PORT_CS,   MX25_PIN_CS,   gpioModeDisabled, 1);
+#else
   GPIO_PinModeSet( MX25_PORT_MOSI, MX25_PIN_MOSI, gpioModeDisabled, 0);
   GPIO_PinModeSet( MX25_PORT_MISO, MX25_PIN_MISO, gpioModeDisabled, 0);
   GPIO_PinModeSet( MX25_PORT_SCLK, MX25_PIN_SCLK, gpioModeDisabled, 1);
@@ -111,6 +221,9 @@ void MX25_deinit( void )
 #endif
 
   CMU_ClockEnable( MX25_USART_CLK, false );
+#endif // MX25_SPIBUS
+
+  flashSession.valid = false;
 }
 
 /*
@@ -153,12 +266,97 @@ void Initial_Spi()
  */
 void CS_Low()
 {
+#ifdef MX25_SPIBUS
+   // Wait for the other clients, then switch the bus to the flash settings
+   SPIBUS_Acquire( &busClient );
+#endif
+#ifdef MX25_AUTO_DP
+   // Every command starts here: wake the flash and restart the idle time
+   if( powerState != MX25_PowerActive )
+      PowerResume();
+   powerIdleTicks = 0;
+#endif
    GPIO_PinOutClear( MX25_PORT_CS, MX25_PIN_CS );
 }
 
 void CS_High()
 {
    GPIO_PinOutSet( MX25_PORT_CS, MX25_PIN_CS );
+
+   if( dualIoActive )
+      DualIoExit();
+
+#ifdef MX25_SPIBUS
+   SPIBUS_Release( &busClient );
+#endif
+}
+
+/*
+ * Function:       DualIoEnter
+ * Arguments:      output, true to drive IO0/IO1, false to sample them
+ * Description:    The USART has no dual data mode, so dual I/O phases are
+ *                 done by GPIO. The USART is disconnected from the pins,
+ *                 SCLK is driven idle low (SPI mode 0) and MOSI/MISO are
+ *                 used as IO0/IO1 in the requested direction.
+ * Return Message: None.
+ */
+static void DualIoEnter( bool output )
+{
+   if( !dualIoActive )
+   {
+#ifdef _GPIO_USART_ROUTEEN_MASK
+      MX25_USART_ROUTE.ROUTEEN = 0;
+#else
+      MX25_USART->ROUTEPEN = 0;
+#endif
+      GPIO_PinModeSet( MX25_PORT_SCLK, MX25_PIN_SCLK, gpioModePushPull, 0 );
+      dualIoActive = true;
+      dualIoOutput = !output;
+   }
+
+   if( dualIoOutput != output )
+   {
+      GPIO_PinModeSet( MX25_PORT_MOSI, MX25_PIN_MOSI, output ? gpioModePushPull : gpioModeInput, 0 );
+      GPIO_PinModeSet( MX25_PORT_MISO, MX25_PIN_MISO, output ? gpioModePushPull : gpioModeInput, 0 );
+      dualIoOutput = output;
+   }
+}
+
+/*
+ * Function:       DualIoExit
+ * Arguments:      None.
+ * Description:    Give the pins back to the USART after a dual I/O phase.
+ * Return Message: None.
+ */
+static void DualIoExit( void )
+{
+   GPIO_PinModeSet( MX25_PORT_MOSI, MX25_PIN_MOSI, gpioModePushPull, 1 );
+   GPIO_PinModeSet( MX25_PORT_MISO, MX25_PIN_MISO, gpioModeInput,    0 );
+   GPIO_PinModeSet( MX25_PORT_SCLK, MX25_PIN_SCLK, gpioModePushPull, 1 );
+
+#ifdef _GPIO_USART_ROUTEEN_MASK
+   MX25_USART_ROUTE.ROUTEEN = (  GPIO_USART_ROUTEEN_RXPEN
+                              | GPIO_USART_ROUTEEN_TXPEN
+                              | GPIO_USART_ROUTEEN_CLKPEN );
+#else
+   MX25_USART->ROUTEPEN  = (  USART_ROUTEPEN_RXPEN
+                            | USART_ROUTEPEN_TXPEN
+                            | USART_ROUTEPEN_CLKPEN );
+#endif
+   dualIoActive = false;
+}
+
+/*
+ * Function:       DualIoClock
+ * Arguments:      None.
+ * Description:    One SCLK pulse. The flash samples IO0/IO1 and the MCU
+ *                 must sample them while SCLK is high.
+ * Return Message: None.
+ */
+static inline void DualIoClock( void )
+{
+   GPIO_PinOutSet( MX25_PORT_SCLK, MX25_PIN_SCLK );
+   GPIO_PinOutClear( MX25_PORT_SCLK, MX25_PIN_SCLK );
 }
 
 /*
@@ -171,6 +369,18 @@ void InsertDummyCycle( uint8_t dummy_cycle )
 {
    int i;
 
+   // After a dual I/O address phase the dummy cycles are clocked by
+   // GPIO as well, which also allows counts that are not a multiple of 8
+   if( dualIoActive )
+   {
+      DualIoEnter( false );
+      for( i = 0; i < dummy_cycle; i++ )
+      {
+         DualIoClock();
+      }
+      return;
+   }
+
    for( i = 0; i < dummy_cycle/8; i++ )
    {
       USART_SpiTransfer( MX25_USART, 0xff );
@@ -194,6 +404,8 @@ void InsertDummyCycle( uint8_t dummy_cycle )
  */
 void SendByte( uint8_t byte_value, uint8_t transfer_type )
 {
+   int i;
+
    switch( transfer_type )
    {
 #ifdef SIO
@@ -203,7 +415,20 @@ void SendByte( uint8_t byte_value, uint8_t transfer_type )
 #endif
 #ifdef DIO
    case DIO: // Dual I/O
-      //--- IO mode not supported! ---//
+      // IO1 (MISO) carries the odd bits, IO0 (MOSI) the even bits
+      DualIoEnter( true );
+      for( i = 6; i >= 0; i -= 2 )
+      {
+         if( byte_value & (2 << i) )
+            GPIO_PinOutSet( MX25_PORT_MISO, MX25_PIN_MISO );
+         else
+            GPIO_PinOutClear( MX25_PORT_MISO, MX25_PIN_MISO );
+         if( byte_value & (1 << i) )
+            GPIO_PinOutSet( MX25_PORT_MOSI, MX25_PIN_MOSI );
+         else
+            GPIO_PinOutClear( MX25_PORT_MOSI, MX25_PIN_MOSI );
+         DualIoClock();
+      }
       break;
 #endif
 #ifdef QIO
@@ -255,6 +480,7 @@ void SendByte( uint8_t byte_value, uint8_t transfer_type )
 uint8_t GetByte( uint8_t transfer_type )
 {
    uint8_t data_buf = 0;
+   int i;
 
    switch( transfer_type )
    {
@@ -266,7 +492,15 @@ uint8_t GetByte( uint8_t transfer_type )
 #endif
 #ifdef DIO
    case DIO: // Dual I/O
-      //--- IO mode not supported! ---//
+      DualIoEnter( false );
+      for( i = 0; i < 4; i++ )
+      {
+         GPIO_PinOutSet( MX25_PORT_SCLK, MX25_PIN_SCLK );
+         data_buf = (data_buf << 2)
+                  | (GPIO_PinInGet( MX25_PORT_MISO, MX25_PIN_MISO ) << 1)
+                  | GPIO_PinInGet( MX25_PORT_MOSI, MX25_PIN_MOSI );
+         GPIO_PinOutClear( MX25_PORT_SCLK, MX25_PIN_SCLK );
+      }
       break;
 #endif
 #ifdef QIO
@@ -395,6 +629,8 @@ bool IsFlashQIO( void )
     return TRUE;
 #else
     uint8_t  gDataBuffer;
+    if( flashSession.valid )
+        return flashSession.quadEnable;
     MX25_RDSR( &gDataBuffer );
     if( (gDataBuffer & FLASH_QE_MASK) == FLASH_QE_MASK )
         return TRUE;
@@ -419,6 +655,8 @@ bool IsFlash4Byte( void )
         return FALSE;
     #else
         uint8_t  gDataBuffer;
+        if( flashSession.valid )
+            return flashSession.addr4Byte;
         MX25_RDSCUR( &gDataBuffer );
         if( (gDataBuffer & FLASH_4BYTE_MASK) == FLASH_4BYTE_MASK )
             return TRUE;
@@ -468,7 +706,10 @@ uint8_t GetDummyCycle( uint32_t default_cycle )
 #ifdef FLASH_CMD_RDCR
     uint8_t gDataBuffer;
     uint8_t dummy_cycle = default_cycle;
-    MX25_RDCR( &gDataBuffer );
+    if( flashSession.valid )
+        gDataBuffer = flashSession.configReg;
+    else
+        MX25_RDCR( &gDataBuffer );
     #ifdef SUPPORT_CR_DC
         // product support 1-bit dummy cycle configuration
         if( (gDataBuffer & FLASH_DC_MASK) == FLASH_DC_MASK )
@@ -502,6 +743,106 @@ uint8_t GetDummyCycle( uint32_t default_cycle )
 #endif
 }
 
+/*
+ * Function:       SessionReadRegs
+ * Arguments:      None.
+ * Description:    Read address mode, QE bit and dummy cycle configuration
+ *                 from the flash registers into the session.
+ * Return Message: None.
+ */
+void SessionReadRegs( void )
+{
+    // Query the registers, not the cached values
+    flashSession.valid = false;
+
+    flashSession.addr4Byte  = IsFlash4Byte();
+    flashSession.quadEnable = IsFlashQIO();
+#ifdef FLASH_CMD_RDCR
+    MX25_RDCR( &flashSession.configReg );
+#else
+    flashSession.configReg = 0;
+#endif
+    flashSession.dcFastRead = GetDummyCycle( DUMMY_CONF_FASTREAD );
+    flashSession.dc2Read    = GetDummyCycle( DUMMY_CONF_2READ );
+    flashSession.dc4Read    = GetDummyCycle( DUMMY_CONF_4READ );
+    flashSession.dcDRead    = GetDummyCycle( DUMMY_CONF_DREAD );
+    flashSession.dcQRead    = GetDummyCycle( DUMMY_CONF_QREAD );
+
+    flashSession.valid = true;
+}
+
+/*
+ * Function:       MX25_SessionRefresh
+ * Arguments:      None.
+ * Description:    Capture the flash session: size and supported read
+ *                 modes from the SFDP basic flash parameter table (JESD216),
+ *                 address mode, QE bit and dummy cycles from the registers.
+ *                 Called by MX25_init; call again after MX25_RST.
+ *                 If no valid SFDP table is found FlashSize and all read
+ *                 modes are assumed.
+ * Return Message: FlashIsBusy, FlashOperationSuccess
+ */
+ReturnMsg MX25_SessionRefresh( void )
+{
+    uint8_t  sfdp[16];
+    uint32_t ptp, dword;
+
+    if( IsFlashBusy() )    return FlashIsBusy;
+
+    flashSession.valid     = false;
+    flashSession.sfdpValid = false;
+    flashSession.capacity  = FlashSize;
+    flashSession.readModes = MX25_READ_MODE_DREAD | MX25_READ_MODE_2READ
+                           | MX25_READ_MODE_QREAD | MX25_READ_MODE_4READ;
+
+    // SFDP header and first (basic) parameter header
+    MX25_RDSFDP( 0, sfdp, 16 );
+    if( sfdp[0] == 'S' && sfdp[1] == 'F' && sfdp[2] == 'D' && sfdp[3] == 'P'
+        && sfdp[8] == 0x00 && sfdp[11] >= 2 )
+    {
+        ptp = sfdp[12] | (sfdp[13] << 8) | (sfdp[14] << 16);
+
+        // DWORD1 (fast read support) and DWORD2 (density)
+        MX25_RDSFDP( ptp, sfdp, 8 );
+
+        dword = sfdp[0] | (sfdp[1] << 8) | (sfdp[2] << 16) | ((uint32_t)sfdp[3] << 24);
+        flashSession.readModes = 0;
+        if( dword & (1 << 16) ) flashSession.readModes |= MX25_READ_MODE_DREAD;
+        if( dword & (1 << 20) ) flashSession.readModes |= MX25_READ_MODE_2READ;
+        if( dword & (1 << 22) ) flashSession.readModes |= MX25_READ_MODE_QREAD;
+        if( dword & (1 << 21) ) flashSession.readModes |= MX25_READ_MODE_4READ;
+
+        dword = sfdp[4] | (sfdp[5] << 8) | (sfdp[6] << 16) | ((uint32_t)sfdp[7] << 24);
+        if( dword & 0x80000000 )
+        {
+            // Density is 2^N bits, only sizes up to 4 GB can be described
+            if( (dword & 0x7FFFFFFF) >= 3 && (dword & 0x7FFFFFFF) < 35 )
+                flashSession.capacity = 1UL << ((dword & 0x7FFFFFFF) - 3);
+        }
+        else
+        {
+            // Density is N+1 bits
+            flashSession.capacity = (dword >> 3) + 1;
+        }
+        flashSession.sfdpValid = true;
+    }
+
+    SessionReadRegs();
+
+    return FlashOperationSuccess;
+}
+
+/*
+ * Function:       MX25_GetSession
+ * Arguments:      None.
+ * Description:    Get the parameters captured by MX25_SessionRefresh.
+ * Return Message: Pointer to the flash session
+ */
+const MX25_Session *MX25_GetSession( void )
+{
+    return &flashSession;
+}
+
 
 
 /*
@@ -666,11 +1007,14 @@ ReturnMsg MX25_WRSR( uint8_t UpdateValue )
     CS_High();
 
 
-    if( WaitFlashReady( WriteStatusRegCycleTime ) )
-        return FlashOperationSuccess;
-    else
+    if( !WaitFlashReady( WriteStatusRegCycleTime ) )
         return FlashTimeOut;
 
+    // QE and dummy cycle bits may have changed
+    if( flashSession.valid )
+        SessionReadRegs();
+
+    return FlashOperationSuccess;
 }
 
 /*
@@ -1122,6 +1466,11 @@ ReturnMsg MX25_WREN( void )
     // Chip select go high to end a flash command
     CS_High();
 
+#ifdef MX25_READ_CACHE
+    // Every program/erase/register write is preceded by WREN
+    MX25_CacheInvalidate();
+#endif
+
     return FlashOperationSuccess;
 }
 
@@ -1164,6 +1513,7 @@ ReturnMsg MX25_PP( uint32_t flash_address, uint8_t *source_address, uint32_t byt
 {
     uint32_t index;
     uint8_t  addr_4byte_mode;
+    ReturnMsg result;
 
     // Check flash address
     if( flash_address > FlashSize ) return FlashAddressInvalid;
@@ -1177,6 +1527,8 @@ ReturnMsg MX25_PP( uint32_t flash_address, uint8_t *source_address, uint32_t byt
     else
         addr_4byte_mode = FALSE; // 3-byte mode
 
+    ENERGYMARK_BEGIN( ENERGYMARK_ID_FLASH );
+
     // Setting Write Enable Latch bit
     MX25_WREN();
 
@@ -1198,9 +1550,12 @@ ReturnMsg MX25_PP( uint32_t flash_address, uint8_t *source_address, uint32_t byt
     CS_High();
 
     if( WaitFlashReady( PageProgramCycleTime ) )
-        return FlashOperationSuccess;
+        result = FlashOperationSuccess;
     else
-        return FlashTimeOut;
+        result = FlashTimeOut;
+
+    ENERGYMARK_END( ENERGYMARK_ID_FLASH );
+    return result;
 }
 
 
@@ -1278,6 +1633,7 @@ ReturnMsg MX25_4PP( uint32_t flash_address, uint8_t *source_address, uint32_t by
 ReturnMsg MX25_SE( uint32_t flash_address )
 {
     uint8_t  addr_4byte_mode;
+    ReturnMsg result;
 
     // Check flash address
     if( flash_address > FlashSize ) return FlashAddressInvalid;
@@ -1291,6 +1647,8 @@ ReturnMsg MX25_SE( uint32_t flash_address )
     else
         addr_4byte_mode = FALSE; // 3-byte mode
 
+    ENERGYMARK_BEGIN( ENERGYMARK_ID_FLASH );
+
     // Setting Write Enable Latch bit
     MX25_WREN();
 
@@ -1305,9 +1663,12 @@ ReturnMsg MX25_SE( uint32_t flash_address )
     CS_High();
 
     if( WaitFlashReady( SectorEraseCycleTime ) )
-        return FlashOperationSuccess;
+        result = FlashOperationSuccess;
     else
-        return FlashTimeOut;
+        result = FlashTimeOut;
+
+    ENERGYMARK_END( ENERGYMARK_ID_FLASH );
+    return result;
 }
 
 /*
@@ -1456,6 +1817,10 @@ ReturnMsg MX25_DP( void )
     // Chip select go high to end a flash command
     CS_High();
 
+#ifdef MX25_AUTO_DP
+    powerState = MX25_PowerDown;
+#endif
+
     return FlashOperationSuccess;
 }
 
@@ -1568,6 +1933,7 @@ ReturnMsg MX25_RST( FlashStatus *fsptr )
     // Reset current state
     fsptr->ArrangeOpt = FALSE;
     fsptr->ModeReg = 0x00;
+    flashSession.valid = false;
 
     return FlashOperationSuccess;
 }
@@ -1646,4 +2012,633 @@ ReturnMsg MX25_NOP( void )
     return FlashOperationSuccess;
 }
 
+#ifdef MX25_READ_CACHE
+
+/*
+ * Cached Read Command
+ */
+
+/*
+ * Function:       CacheFind
+ * Arguments:      line_address, flash address of the first byte of a line
+ * Description:    Look up a line in the read cache.
+ * Return Message: Index of the line, or -1 on a miss
+ */
+static int CacheFind( uint32_t line_address )
+{
+    int i;
+
+    for( i = 0; i < MX25_CACHE_LINES; i++ )
+    {
+        if( cacheTag[i] == line_address )
+            return i;
+    }
+    return -1;
+}
+
+/*
+ * Function:       CacheFill
+ * Arguments:      line_address, flash address of the first byte of a line
+ * Description:    Load a line into the cache. If the miss directly follows
+ *                 the previous fill the next line is prefetched in the
+ *                 same READ command.
+ * Return Message: Index of the loaded line
+ */
+static int CacheFill( uint32_t line_address )
+{
+    uint32_t slot[2];
+    uint32_t count = 1;
+    uint32_t line, index;
+    uint8_t  addr_4byte_mode;
+
+    slot[0] = cacheVictim;
+    cacheVictim = (cacheVictim + 1) % MX25_CACHE_LINES;
+
+    // Sequential access: fetch one line ahead
+    if( MX25_CACHE_LINES > 1
+        && line_address == cacheLastFill + MX25_CACHE_LINE_SIZE
+        && line_address + MX25_CACHE_LINE_SIZE < FlashSize
+        && CacheFind( line_address + MX25_CACHE_LINE_SIZE ) < 0 )
+    {
+        slot[1] = cacheVictim;
+        cacheVictim = (cacheVictim + 1) % MX25_CACHE_LINES;
+        count = 2;
+    }
+
+    // Check 3-byte or 4-byte mode
+    if( IsFlash4Byte() )
+        addr_4byte_mode = TRUE;  // 4-byte mode
+    else
+        addr_4byte_mode = FALSE; // 3-byte mode
+
+    // Chip select go low to start a flash command
+    CS_Low();
+
+    // Write READ command and address
+    SendByte( FLASH_CMD_READ, SIO );
+    SendFlashAddr( line_address, SIO, addr_4byte_mode );
+
+    // READ keeps streaming, so the prefetched line needs no new address
+    for( line = 0; line < count; line++ )
+    {
+        for( index = 0; index < MX25_CACHE_LINE_SIZE; index++ )
+        {
+            cacheData[slot[line]][index] = GetByte( SIO );
+        }
+        cacheTag[slot[line]] = line_address + line * MX25_CACHE_LINE_SIZE;
+    }
+
+    // Chip select go high to end a flash command
+    CS_High();
+
+    cacheLastFill = line_address + (count - 1) * MX25_CACHE_LINE_SIZE;
+
+    return slot[0];
+}
+
+/*
+ * Function:       MX25_CachedRead
+ * Arguments:      flash_address, 32 bit flash memory address
+ *                 target_address, buffer address to store returned data
+ *                 byte_length, length of returned data in byte unit
+ * Description:    Same result as MX25_READ, but served from the read
+ *                 cache. Flash is only accessed on a cache miss, one
+ *                 line (or two when reading sequentially) at a time.
+ * Return Message: FlashAddressInvalid, FlashOperationSuccess
+ */
+ReturnMsg MX25_CachedRead( uint32_t flash_address, uint8_t *target_address, uint32_t byte_length )
+{
+    uint32_t line_address, offset, chunk;
+    int      line;
+
+    // Check flash address
+    if( flash_address > FlashSize ) return FlashAddressInvalid;
+
+    while( byte_length > 0 )
+    {
+        line_address = flash_address & ~(uint32_t)(MX25_CACHE_LINE_SIZE - 1);
+        offset       = flash_address - line_address;
+        chunk        = MX25_CACHE_LINE_SIZE - offset;
+        if( chunk > byte_length )
+            chunk = byte_length;
+
+        line = CacheFind( line_address );
+        if( line < 0 )
+            line = CacheFill( line_address );
+
+        memcpy( target_address, &cacheData[line][offset], chunk );
+
+        flash_address  += chunk;
+        target_address += chunk;
+        byte_length    -= chunk;
+    }
+
+    return FlashOperationSuccess;
+}
+
+/*
+ * Function:       MX25_CacheInvalidate
+ * Arguments:      None.
+ * Description:    Drop all cached lines. Called automatically from
+ *                 MX25_WREN, so program and erase commands keep the
+ *                 cache coherent.
+ * Return Message: None.
+ */
+void MX25_CacheInvalidate( void )
+{
+    int i;
+
+    for( i = 0; i < MX25_CACHE_LINES; i++ )
+    {
+        cacheTag[i] = CACHE_TAG_INVALID;
+    }
+    cacheLastFill = CACHE_TAG_INVALID;
+}
+
+#endif //MX25_READ_CACHE
+
+/*
+ * Non-blocking Program/Erase Command
+ */
+
+/*
+ * Function:       StartAsyncCmd
+ * Arguments:      cmd, program or erase command code
+ *                 flash_address, 32 bit flash memory address
+ *                 send_addr, TRUE if the command takes an address
+ *                 source_address, data to program (NULL for erase)
+ *                 byte_length, byte length of data to program
+ *                 max_time_ms, worst case operation time in ms
+ *                 callback, called from MX25_PollAsync() on completion
+ * Description:    Issue a program/erase command without waiting for the
+ *                 WIP bit to clear. The page data is still shifted out
+ *                 here; only the internal program/erase time is deferred.
+ * Return Message: FlashAddressInvalid, FlashIsBusy, FlashOperationSuccess
+ */
+static ReturnMsg StartAsyncCmd( uint8_t cmd, uint32_t flash_address, bool send_addr,
+                                uint8_t *source_address, uint32_t byte_length,
+                                uint32_t max_time_ms, MX25_AsyncCallback callback )
+{
+    uint32_t index;
+    uint8_t  addr_4byte_mode;
+
+    // Check flash address
+    if( send_addr && flash_address > FlashSize ) return FlashAddressInvalid;
+
+    // Check driver or flash is busy or not
+    if( asyncBusy || IsFlashBusy() )    return FlashIsBusy;
+
+    // Check 3-byte or 4-byte mode
+    if( IsFlash4Byte() )
+        addr_4byte_mode = TRUE;  // 4-byte mode
+    else
+        addr_4byte_mode = FALSE; // 3-byte mode
+
+    // Setting Write Enable Latch bit
+    MX25_WREN();
+
+    // Chip select go low to start a flash command
+    CS_Low();
+
+    SendByte( cmd, SIO );
+    if( send_addr )
+        SendFlashAddr( flash_address, SIO, addr_4byte_mode );
+
+    for( index=0; index < byte_length; index++ )
+    {
+        SendByte( *(source_address + index), SIO );
+    }
+
+    // Chip select go high to end a flash command
+    CS_High();
+
+    // One extra poll so the last partial period is covered
+    asyncPollsLeft = max_time_ms / MX25_ASYNC_POLL_MS + 1;
+    asyncCallback  = callback;
+    asyncBusy      = true;
+
+    return FlashOperationSuccess;
+}
+
+/*
+ * Function:       MX25_PP_Async
+ * Arguments:      flash_address, 32 bit flash memory address
+ *                 source_address, buffer address of source data to program
+ *                 byte_length, byte length of data to programm
+ *                 callback, completion callback, may be NULL
+ * Description:    Non-blocking version of MX25_PP. Completion is reported
+ *                 by MX25_PollAsync().
+ * Return Message: FlashAddressInvalid, FlashIsBusy, FlashOperationSuccess
+ */
+ReturnMsg MX25_PP_Async( uint32_t flash_address, uint8_t *source_address, uint32_t byte_length, MX25_AsyncCallback callback )
+{
+    return StartAsyncCmd( FLASH_CMD_PP, flash_address, TRUE, source_address, byte_length,
+                          tPP / 1000000, callback );
+}
+
+/*
+ * Function:       MX25_SE_Async
+ * Arguments:      flash_address, 32 bit flash memory address
+ *                 callback, completion callback, may be NULL
+ * Description:    Non-blocking version of MX25_SE (4KB sector erase).
+ * Return Message: FlashAddressInvalid, FlashIsBusy, FlashOperationSuccess
+ */
+ReturnMsg MX25_SE_Async( uint32_t flash_address, MX25_AsyncCallback callback )
+{
+    return StartAsyncCmd( FLASH_CMD_SE, flash_address, TRUE, NULL, 0,
+                          tSE / 1000000, callback );
+}
+
+/*
+ * Function:       MX25_BE32K_Async
+ * Arguments:      flash_address, 32 bit flash memory address
+ *                 callback, completion callback, may be NULL
+ * Description:    Non-blocking version of MX25_BE32K (32KB block erase).
+ * Return Message: FlashAddressInvalid, FlashIsBusy, FlashOperationSuccess
+ */
+ReturnMsg MX25_BE32K_Async( uint32_t flash_address, MX25_AsyncCallback callback )
+{
+    return StartAsyncCmd( FLASH_CMD_BE32K, flash_address, TRUE, NULL, 0,
+                          tBE32 / 1000000, callback );
+}
+
+/*
+ * Function:       MX25_BE_Async
+ * Arguments:      flash_address, 32 bit flash memory address
+ *                 callback, completion callback, may be NULL
+ * Description:    Non-blocking version of MX25_BE (64KB block erase).
+ * Return Message: FlashAddressInvalid, FlashIsBusy, FlashOperationSuccess
+ */
+ReturnMsg MX25_BE_Async( uint32_t flash_address, MX25_AsyncCallback callback )
+{
+    return StartAsyncCmd( FLASH_CMD_BE, flash_address, TRUE, NULL, 0,
+                          tBE / 1000000, callback );
+}
+
+/*
+ * Function:       MX25_CE_Async
+ * Arguments:      callback, completion callback, may be NULL
+ * Description:    Non-blocking version of MX25_CE (chip erase).
+ * Return Message: FlashIsBusy, FlashOperationSuccess
+ */
+ReturnMsg MX25_CE_Async( MX25_AsyncCallback callback )
+{
+    // CE_period is a loop count, convert it back to ms
+    return StartAsyncCmd( FLASH_CMD_CE, 0, FALSE, NULL, 0,
+                          CE_period / (1000000 / (CLK_PERIOD * Min_Cycle_Per_Inst * One_Loop_Inst)),
+                          callback );
+}
+
+/*
+ * Function:       MX25_PollAsync
+ * Arguments:      None.
+ * Description:    Check the WIP bit of the operation started by one of the
+ *                 *_Async functions. Call this every MX25_ASYNC_POLL_MS
+ *                 ms from thread context, the SPI bus is used. When the
+ *                 operation ends the callback (if any) is called with the
+ *                 final status.
+ * Return Message: FlashIsBusy, FlashOperationSuccess, FlashTimeOut
+ */
+ReturnMsg MX25_PollAsync( void )
+{
+    ReturnMsg status;
+    MX25_AsyncCallback callback;
+
+    if( !asyncBusy )
+        return FlashOperationSuccess;
+
+    if( IsFlashBusy() )
+    {
+        if( --asyncPollsLeft > 0 )
+            return FlashIsBusy;
+        status = FlashTimeOut;
+    }
+    else
+    {
+        status = FlashOperationSuccess;
+    }
+
+    callback  = asyncCallback;
+    asyncBusy = false;
+    if( callback != NULL )
+        callback( status );
+
+    return status;
+}
+
+/*
+ * Function:       MX25_AsyncBusy
+ * Arguments:      None.
+ * Description:    Check if a non-blocking program/erase is in progress.
+ * Return Message: true if MX25_PollAsync() has not yet reported completion
+ */
+bool MX25_AsyncBusy( void )
+{
+    return asyncBusy;
+}
+
+#ifdef MX25_USE_LDMA
+
+/*
+ * LDMA Read Command
+ */
+
+/*
+ * Function:       StartDmaChunk
+ * Arguments:      None.
+ * Description:    Start the RX and TX channels for the next chunk of the
+ *                 read in progress. One chunk is at most
+ *                 LDMA_DESCRIPTOR_MAX_XFER_SIZE bytes.
+ * Return Message: None.
+ */
+static void StartDmaChunk( void )
+{
+    static LDMA_Descriptor_t rxDesc;
+    static LDMA_Descriptor_t txDesc;
+    LDMA_TransferCfg_t rxCfg = LDMA_TRANSFER_CFG_PERIPHERAL( MX25_LDMA_RX_SIGNAL );
+    LDMA_TransferCfg_t txCfg = LDMA_TRANSFER_CFG_PERIPHERAL( MX25_LDMA_TX_SIGNAL );
+    uint32_t chunk = dmaRemaining;
+
+    if( chunk > LDMA_DESCRIPTOR_MAX_XFER_SIZE )
+        chunk = LDMA_DESCRIPTOR_MAX_XFER_SIZE;
+
+    // RXDATA -> target buffer, interrupt when the chunk has been received
+    rxDesc = (LDMA_Descriptor_t)LDMA_DESCRIPTOR_SINGLE_P2M_BYTE( &MX25_USART->RXDATA, dmaTarget, chunk );
+
+    // Fixed dummy byte -> TXDATA, generates the SPI clock for the read
+    txDesc = (LDMA_Descriptor_t)LDMA_DESCRIPTOR_SINGLE_M2P_BYTE( &dmaTxDummy, &MX25_USART->TXDATA, chunk );
+    txDesc.xfer.srcInc  = ldmaCtrlSrcIncNone;
+    txDesc.xfer.doneIfs = 0;
+
+    dmaTarget    += chunk;
+    dmaRemaining -= chunk;
+
+    // Receive channel must be armed before the first byte is clocked out
+    LDMA_StartTransfer( MX25_LDMA_RX_CHANNEL, &rxCfg, &rxDesc );
+    LDMA_StartTransfer( MX25_LDMA_TX_CHANNEL, &txCfg, &txDesc );
+}
+
+/*
+ * Function:       StartDmaRead
+ * Arguments:      command, read command to issue
+ *                 dummy_cycle, number of dummy cycles after the address
+ *                 flash_address, 32 bit flash memory address
+ *                 target_address, buffer address to store returned data
+ *                 byte_length, length of returned data in byte unit
+ *                 callback, function called on completion or NULL
+ * Description:    Send the command and address with the CPU, then hand the
+ *                 data phase over to the LDMA. If callback is NULL the
+ *                 function sleeps in EM1 until the read is complete.
+ * Return Message: FlashAddressInvalid, FlashIsBusy, FlashOperationSuccess
+ */
+static ReturnMsg StartDmaRead( uint8_t command, uint8_t dummy_cycle, uint32_t flash_address,
+                               uint8_t *target_address, uint32_t byte_length,
+                               MX25_TransferCallback callback )
+{
+    uint8_t  addr_4byte_mode;
+
+    // Check flash address
+    if( flash_address > FlashSize ) return FlashAddressInvalid;
+
+    // Only one LDMA read can be in flight
+    if( dmaBusy ) return FlashIsBusy;
+
+    // Check 3-byte or 4-byte mode
+    if( IsFlash4Byte() )
+        addr_4byte_mode = TRUE;  // 4-byte mode
+    else
+        addr_4byte_mode = FALSE; // 3-byte mode
+
+    // Chip select go low to start a flash command
+    CS_Low();
+
+    // Write command, address and dummy cycle
+    SendByte( command, SIO );
+    SendFlashAddr( flash_address, SIO, addr_4byte_mode );
+    InsertDummyCycle( dummy_cycle );
+
+    if( byte_length == 0 ){
+        CS_High();
+        if( callback != NULL )
+            callback( FlashOperationSuccess );
+        return FlashOperationSuccess;
+    }
+
+    dmaTarget    = target_address;
+    dmaRemaining = byte_length;
+    dmaCallback  = callback;
+    dmaBusy      = true;
+
+    StartDmaChunk();
+
+    if( callback == NULL ){
+        // Blocking call: sleep until the LDMA interrupt ends the transfer
+        CORE_DECLARE_IRQ_STATE;
+        CORE_ENTER_CRITICAL();
+        while( dmaBusy ){
+            EMU_EnterEM1();
+            CORE_EXIT_CRITICAL();
+            CORE_ENTER_CRITICAL();
+        }
+        CORE_EXIT_CRITICAL();
+    }
+
+    return FlashOperationSuccess;
+}
+
+/*
+ * Function:       MX25_READ_LDMA
+ * Arguments:      flash_address, 32 bit flash memory address
+ *                 target_address, buffer address to store returned data
+ *                 byte_length, length of returned data in byte unit
+ *                 callback, function called on completion or NULL to block
+ * Description:    The READ instruction with the data phase moved by LDMA.
+ * Return Message: FlashAddressInvalid, FlashIsBusy, FlashOperationSuccess
+ */
+ReturnMsg MX25_READ_LDMA( uint32_t flash_address, uint8_t *target_address, uint32_t byte_length, MX25_TransferCallback callback )
+{
+    return StartDmaRead( FLASH_CMD_READ, 0, flash_address, target_address, byte_length, callback );
+}
+
+/*
+ * Function:       MX25_FASTREAD_LDMA
+ * Arguments:      flash_address, 32 bit flash memory address
+ *                 target_address, buffer address to store returned data
+ *                 byte_length, length of returned data in byte unit
+ *                 callback, function called on completion or NULL to block
+ * Description:    The FASTREAD instruction with the data phase moved by LDMA.
+ * Return Message: FlashAddressInvalid, FlashIsBusy, FlashOperationSuccess
+ */
+ReturnMsg MX25_FASTREAD_LDMA( uint32_t flash_address, uint8_t *target_address, uint32_t byte_length, MX25_TransferCallback callback )
+{
+    return StartDmaRead( FLASH_CMD_FASTREAD, GetDummyCycle( DUMMY_CONF_FASTREAD ),
+                         flash_address, target_address, byte_length, callback );
+}
+
+/*
+ * Function:       MX25_LDMA_Busy
+ * Arguments:      None.
+ * Description:    Check if an LDMA read is in progress.
+ * Return Message: TRUE, FALSE
+ */
+bool MX25_LDMA_Busy( void )
+{
+    return dmaBusy;
+}
+
+/*
+ * Function:       MX25_LDMA_IRQHandler
+ * Arguments:      None.
+ * Description:    Service the MX25 RX channel. Must be called from the
+ *                 application's LDMA_IRQHandler(). Flags of other
+ *                 channels are left untouched.
+ * Return Message: None.
+ */
+void MX25_LDMA_IRQHandler( void )
+{
+    uint32_t mask = 1UL << MX25_LDMA_RX_CHANNEL;
+
+    if( (LDMA_IntGet() & LDMA_IntGetEnabled() & mask) == 0 )
+        return;
+
+    LDMA_IntClear( mask );
+
+    if( dmaRemaining > 0 ){
+        StartDmaChunk();
+        return;
+    }
+
+    // Wait for the last dummy byte to finish shifting before releasing CS
+    while( !(MX25_USART->STATUS & USART_STATUS_TXC) );
+    CS_High();
+
+    dmaBusy = false;
+    if( dmaCallback != NULL )
+        dmaCallback( FlashOperationSuccess );
+}
+
+#endif //MX25_USE_LDMA
+
+#ifdef MX25_AUTO_DP
+
+/*
+ * Deep Power Down Management
+ */
+
+/*
+ * Function:       PowerRelease
+ * Arguments:      None.
+ * Description:    Pulse CS low to release the flash from deep power down
+ *                 and start timing tRDP. Two GPIO writes take longer than
+ *                 the tCRDP minimum pulse width.
+ * Return Message: None.
+ */
+static void PowerRelease( void )
+{
+    GPIO_PinOutClear( MX25_PORT_CS, MX25_PIN_CS );
+    GPIO_PinOutSet( MX25_PORT_CS, MX25_PIN_CS );
+
+    powerWakeStart = DWT->CYCCNT;
+    powerState     = MX25_PowerWaking;
+}
+
+/*
+ * Function:       PowerResume
+ * Arguments:      None.
+ * Description:    Make the flash accept a command. Waits only for the part
+ *                 of tRDP that has not passed since the release. The cycle
+ *                 counter stops while the core sleeps, which can only make
+ *                 the wait longer than needed.
+ * Return Message: None.
+ */
+static void PowerResume( void )
+{
+    if( powerState == MX25_PowerDown )
+        PowerRelease();
+
+    while( (DWT->CYCCNT - powerWakeStart) < powerWakeCycles );
+
+    powerState = MX25_PowerActive;
+}
+
+/*
+ * Function:       MX25_PowerTick
+ * Arguments:      None.
+ * Description:    Count idle time. Call every millisecond from thread
+ *                 context, the SPI bus is used. Puts the flash in deep
+ *                 power down after MX25_DP_IDLE_MS ticks without a command.
+ * Return Message: None.
+ */
+void MX25_PowerTick( void )
+{
+    if( powerState == MX25_PowerDown )
+        return;
+
+    if( ++powerIdleTicks >= MX25_DP_IDLE_MS )
+        MX25_PowerSleep();
+}
+
+/*
+ * Function:       MX25_PowerWake
+ * Arguments:      None.
+ * Description:    Release the flash from deep power down without waiting,
+ *                 tRDP runs while the caller does other work.
+ * Return Message: None.
+ */
+void MX25_PowerWake( void )
+{
+    if( powerState == MX25_PowerDown ){
+#ifdef MX25_SPIBUS
+        // No other client may be clocking the bus during the CS pulse
+        SPIBUS_Acquire( &busClient );
+        PowerRelease();
+        SPIBUS_Release( &busClient );
+#else
+        PowerRelease();
+#endif
+        powerIdleTicks = 0;
+    }
+}
+
+/*
+ * Function:       MX25_PowerSleep
+ * Arguments:      None.
+ * Description:    Put the flash in deep power down now. Does nothing while
+ *                 a non-blocking program/erase or an LDMA read is running.
+ * Return Message: None.
+ */
+void MX25_PowerSleep( void )
+{
+    if( (powerState == MX25_PowerDown) || asyncBusy )
+        return;
+#ifdef MX25_USE_LDMA
+    if( dmaBusy )
+        return;
+#endif
+
+    // Chip select go low to start a flash command
+    CS_Low();
+
+    // Deep Power Down Mode command
+    SendByte( FLASH_CMD_DP, SIO );
+
+    // Chip select go high to end a flash command
+    CS_High();
+
+    powerState = MX25_PowerDown;
+}
+
+/*
+ * Function:       MX25_GetPowerState
+ * Arguments:      None.
+ * Description:    Get the deep power down state.
+ * Return Message: MX25_PowerActive, MX25_PowerWaking, MX25_PowerDown
+ */
+MX25_PowerState MX25_GetPowerState( void )
+{
+    return powerState;
+}
+
+#endif //MX25_AUTO_DP
+
 #endif //MX25_USART
@@ -84,6 +84,7 @@
 #define    CE_period        15625000       // tCE /  ( CLK_PERIOD * Min_Cycle_Per_Inst *One_Loop_Inst)
 #define    tW               40000000       // 40ms
 #define    tDP              10000          // 10us
+#define    tRDP             35000          // 35us, release from deep power down
 #define    tBP              100000         // 100us
 #define    tPP              10000000       // 10ms
 #define    tSE              240000000      // 240ms
@@ -225,8 +226,37 @@ struct sFlashStatus{
 
 typedef struct sFlashStatus FlashStatus;
 
+// Read modes advertised in the SFDP basic flash parameter table
+#define    MX25_READ_MODE_DREAD    0x01    // 1-1-2
+#define    MX25_READ_MODE_2READ    0x02    // 1-2-2
+#define    MX25_READ_MODE_QREAD    0x04    // 1-1-4
+#define    MX25_READ_MODE_4READ    0x08    // 1-4-4
+
+/* Flash session
+ * Device parameters captured once by MX25_init (from SFDP and the
+ * status/configuration/security registers) so that commands do not
+ * have to query them again. Kept up to date by MX25_WRSR; invalidated
+ * by MX25_RST until MX25_SessionRefresh is called.
+ */
+typedef struct {
+    bool       valid;        // false: registers are queried per command
+    bool       sfdpValid;    // false: capacity/readModes are the defaults
+    uint32_t   capacity;     // device size in bytes
+    bool       addr4Byte;    // 4-byte address mode active
+    bool       quadEnable;   // QE bit set
+    uint8_t    readModes;    // MX25_READ_MODE_* mask
+    uint8_t    configReg;    // configuration register (dummy cycle bits)
+    uint8_t    dcFastRead;   // dummy cycles for each read command
+    uint8_t    dc2Read;
+    uint8_t    dc4Read;
+    uint8_t    dcDRead;
+    uint8_t    dcQRead;
+} MX25_Session;
+
 void MX25_init( void );
 void MX25_deinit( void );
+ReturnMsg MX25_SessionRefresh( void );
+const MX25_Session *MX25_GetSession( void );
 
 /* Flash commands */
 ReturnMsg MX25_RDID( uint32_t *Identification );
@@ -273,6 +303,91 @@ ReturnMsg MX25_PGM_ERS_S( void );
 ReturnMsg MX25_PGM_ERS_R( void );
 ReturnMsg MX25_NOP( void );
 
+/*
+  Read cache
+  Define MX25_READ_CACHE in the project to enable these functions.
+  MX25_CACHE_LINES lines of MX25_CACHE_LINE_SIZE bytes are kept in RAM.
+*/
+#ifdef MX25_READ_CACHE
+ReturnMsg MX25_CachedRead( uint32_t flash_address, uint8_t *target_address, uint32_t byte_length );
+void MX25_CacheInvalidate( void );
+#endif
+
+/*
+  Non-blocking program/erase
+  The command is issued and the call returns right away. MX25_PollAsync()
+  must then be called periodically (e.g. from a timer or RTCC tick every
+  MX25_ASYNC_POLL_MS milliseconds) until it no longer returns FlashIsBusy.
+*/
+#ifndef MX25_ASYNC_POLL_MS
+#define MX25_ASYNC_POLL_MS    1
+#endif
+
+typedef void (*MX25_AsyncCallback)( ReturnMsg status );
+
+ReturnMsg MX25_PP_Async( uint32_t flash_address, uint8_t *source_address, uint32_t byte_length, MX25_AsyncCallback callback );
+ReturnMsg MX25_SE_Async( uint32_t flash_address, MX25_AsyncCallback callback );
+ReturnMsg MX25_BE32K_Async( uint32_t flash_address, MX25_AsyncCallback callback );
+ReturnMsg MX25_BE_Async( uint32_t flash_address, MX25_AsyncCallback callback );
+ReturnMsg MX25_CE_Async( MX25_AsyncCallback callback );
+ReturnMsg MX25_PollAsync( void );
+bool MX25_AsyncBusy( void );
+
+/*
+  LDMA bulk read
+  Define MX25_USE_LDMA in the project to enable these functions.
+  The application must call LDMA_Init() before the first transfer and
+  call MX25_LDMA_IRQHandler() from its LDMA_IRQHandler().
+*/
+#ifdef MX25_USE_LDMA
+typedef void (*MX25_TransferCallback)( ReturnMsg status );
+
+ReturnMsg MX25_READ_LDMA( uint32_t flash_address, uint8_t *target_address, uint32_t byte_length, MX25_TransferCallback callback );
+ReturnMsg MX25_FASTREAD_LDMA( uint32_t flash_address, uint8_t *target_address, uint32_t byte_length, MX25_TransferCallback callback );
+bool MX25_LDMA_Busy( void );
+void MX25_LDMA_IRQHandler( void );
+#endif
+
+/*
+  Automatic deep power down
+  Define MX25_AUTO_DP in the project to enable these functions.
+  MX25_PowerTick() must be called every millisecond from thread context.
+  After MX25_DP_IDLE_MS ticks without a command the flash is put in deep
+  power down. The next command releases it and waits only for what is left
+  of tRDP, timed with the DWT cycle counter. MX25_PowerWake() releases the
+  flash ahead of an access known to be coming, so that access does not wait.
+*/
+#ifdef MX25_AUTO_DP
+#ifndef MX25_DP_IDLE_MS
+#define MX25_DP_IDLE_MS       10
+#endif
+
+typedef enum {
+    MX25_PowerActive,        // accepting commands
+    MX25_PowerWaking,        // released, tRDP not yet over
+    MX25_PowerDown,          // in deep power down
+} MX25_PowerState;
+
+void MX25_PowerTick( void );
+void MX25_PowerWake( void );
+void MX25_PowerSleep( void );
+MX25_PowerState MX25_GetPowerState( void );
+#endif
+
+/*
+  Shared SPI bus
+  Define MX25_SPIBUS in the project to share MX25_USART with other devices
+  through the spibus kit driver (kit/common/spibus). The application calls
+  SPIBUS_Init() for the bus pins before MX25_init(), which then only sets up
+  the flash as a bus client. Each command holds the bus from CS low to CS
+  high, an LDMA read until it is complete, and the USART switches back to
+  the flash settings when another client used it in between. Commands then
+  must not be issued from interrupts, MX25_PollAsync() included.
+*/
+#ifdef MX25_SPIBUS
+#include "spibus.h"
+#endif
+
 
 
 
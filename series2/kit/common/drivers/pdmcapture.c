@@ -0,0 +1,246 @@
+/***************************************************************************//**
+ * @file
+ * @brief PDM capture into an LDMA buffer ring.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2022 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ******************************************************************************/
+
+#include <stddef.h>
+#include "em_cmu.h"
+#include "pdmcapture.h"
+
+/***************************************************************************//**
+ * @addtogroup kitdrv
+ * @{
+ ******************************************************************************/
+
+/***************************************************************************//**
+ * @addtogroup PdmCapture
+ * @{
+ ******************************************************************************/
+
+static LDMASTREAM_Stream_t    stream;
+static void                   *bufferList[PDMCAPTURE_MAX_BUFFERS];
+static PDMCAPTURE_Callback_t  readyCallback;
+static PDM_Init_TypeDef       pdmConfig;
+static bool                   running;
+
+static void streamReady(LDMASTREAM_Stream_t *s, unsigned int index, void *buffer)
+{
+  (void)s;
+  (void)index;
+
+  if (readyCallback != NULL) {
+    readyCallback((const uint32_t *)buffer);
+  }
+}
+
+/**************************************************************************//**
+ * @brief Configure the PDM and build the LDMA buffer ring
+ * @details
+ *   The PDM is initialized but not started, whatever pdmInit->start says.
+ * @param[in] init Ring configuration
+ * @param[in] pdmInit PDM configuration
+ * @return false if the ring configuration is not supported
+ *****************************************************************************/
+bool PDMCAPTURE_Init(const PDMCAPTURE_Init_t *init,
+                     const PDM_Init_TypeDef *pdmInit)
+{
+  LDMASTREAM_Init_t streamInit;
+  unsigned int i;
+
+  if ((init->count < 2) || (init->count > PDMCAPTURE_MAX_BUFFERS)) {
+    return false;
+  }
+
+  for (i = 0; i < init->count; i++) {
+    bufferList[i] = init->buffers[i];
+  }
+
+  streamInit.channel   = init->channel;
+  streamInit.signal    = ldmaPeripheralSignal_PDM_RXDATAV;
+  streamInit.direction = ldmaStreamPeriToMem;
+  streamInit.periAddr  = &PDM->RXDATA;
+  streamInit.size      = ldmaCtrlSizeWord;
+  streamInit.buffers   = bufferList;
+  streamInit.count     = init->count;
+  streamInit.length    = init->length;
+  streamInit.callback  = streamReady;
+  streamInit.user      = NULL;
+
+  if (!LDMASTREAM_Init(&stream, &streamInit)) {
+    return false;
+  }
+  readyCallback = init->callback;
+
+  pdmConfig = *pdmInit;
+  pdmConfig.start = false;
+  running = false;
+
+  PDM_Reset(PDM);
+  PDM_Init(PDM, &pdmConfig);
+
+  return true;
+}
+
+/**************************************************************************//**
+ * @brief Start filling the ring from the first buffer
+ *****************************************************************************/
+void PDMCAPTURE_Start(void)
+{
+  PDM_FifoFlush(PDM);
+  LDMASTREAM_Start(&stream);
+  PDM_Start(PDM);
+  running = true;
+}
+
+/**************************************************************************//**
+ * @brief Stop the PDM and the LDMA
+ *****************************************************************************/
+void PDMCAPTURE_Stop(void)
+{
+  PDM_Stop(PDM);
+  LDMASTREAM_Stop(&stream);
+  running = false;
+}
+
+/**************************************************************************//**
+ * @brief Get the oldest filled buffer
+ * @details
+ *   The LDMA does not write to the buffer until it is passed to
+ *   PDMCAPTURE_ReleaseBuffer(), unless the ring overruns.
+ * @return Buffer of PDMCAPTURE_BufferLength() words, or NULL if none is ready
+ *****************************************************************************/
+const uint32_t *PDMCAPTURE_GetBuffer(void)
+{
+  return (const uint32_t *)LDMASTREAM_Acquire(&stream);
+}
+
+/**************************************************************************//**
+ * @brief Give a buffer from PDMCAPTURE_GetBuffer() back to the LDMA
+ *****************************************************************************/
+void PDMCAPTURE_ReleaseBuffer(const uint32_t *buffer)
+{
+  LDMASTREAM_Release(&stream, (void *)buffer);
+}
+
+/**************************************************************************//**
+ * @brief Get the number of filled buffers waiting for the consumer
+ *****************************************************************************/
+unsigned int PDMCAPTURE_ReadyCount(void)
+{
+  return LDMASTREAM_ReadyCount(&stream);
+}
+
+/**************************************************************************//**
+ * @brief Get the number of buffers dropped because the consumer fell behind
+ *****************************************************************************/
+uint32_t PDMCAPTURE_Overruns(void)
+{
+  return LDMASTREAM_Overruns(&stream);
+}
+
+/**************************************************************************//**
+ * @brief Get the number of words in each buffer
+ *****************************************************************************/
+unsigned int PDMCAPTURE_BufferLength(void)
+{
+  return stream.init.length;
+}
+
+/**************************************************************************//**
+ * @brief Change the prescaler, decimation ratio, filter order and gain
+ * @details
+ *   The PDM registers only take a new configuration while disabled, so a
+ *   running capture is stopped, the PDM set up again and the capture
+ *   restarted from the first buffer; the samples in the FIFO and in the
+ *   buffer being filled are dropped. The consumer must not hold a buffer.
+ *   The decimation filter settles within a few samples of the new rate.
+ * @param[in] profile New settings
+ * @return false if a setting does not fit its register field
+ *****************************************************************************/
+bool PDMCAPTURE_SetProfile(const PDMCAPTURE_Profile_t *profile)
+{
+  bool wasRunning = running;
+
+  if ((profile->dsr == 0)
+      || ((profile->dsr << _PDM_CTRL_DSR_SHIFT) & ~_PDM_CTRL_DSR_MASK)
+      || ((profile->gain << _PDM_CTRL_GAIN_SHIFT) & ~_PDM_CTRL_GAIN_MASK)
+      || ((profile->prescaler << _PDM_CFG1_PRESC_SHIFT)
+          & ~_PDM_CFG1_PRESC_MASK)) {
+    return false;
+  }
+
+  if (wasRunning) {
+    PDMCAPTURE_Stop();
+  }
+
+  pdmConfig.prescaler   = profile->prescaler;
+  pdmConfig.dsr         = profile->dsr;
+  pdmConfig.filterOrder = profile->filterOrder;
+  pdmConfig.gain        = profile->gain;
+
+  PDM_Reset(PDM);
+  PDM_Init(PDM, &pdmConfig);
+
+  if (wasRunning) {
+    PDMCAPTURE_Start();
+  }
+
+  return true;
+}
+
+/**************************************************************************//**
+ * @brief Get the settings in use
+ *****************************************************************************/
+void PDMCAPTURE_GetProfile(PDMCAPTURE_Profile_t *profile)
+{
+  profile->prescaler   = pdmConfig.prescaler;
+  profile->dsr         = pdmConfig.dsr;
+  profile->filterOrder = pdmConfig.filterOrder;
+  profile->gain        = pdmConfig.gain;
+}
+
+/**************************************************************************//**
+ * @brief Get the PCM sample rate of the settings in use
+ * @return Frames per second, PDMREF / (prescaler + 1) / dsr
+ *****************************************************************************/
+uint32_t PDMCAPTURE_SampleRate(void)
+{
+  return CMU_ClockFreqGet(cmuClock_PDMREF)
+         / (pdmConfig.prescaler + 1) / pdmConfig.dsr;
+}
+
+/**************************************************************************//**
+ * @brief Handle the LDMA interrupt of the capture channel
+ *****************************************************************************/
+void PDMCAPTURE_IRQHandler(void)
+{
+  LDMASTREAM_IRQHandler(&stream);
+}
+
+/** @} (end group PdmCapture) */
+/** @} (end group kitdrv) */
@@ -0,0 +1,125 @@
+/***************************************************************************//**
+ * @file
+ * @brief PDM capture into an LDMA buffer ring.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2022 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ******************************************************************************/
+
+#ifndef __PDMCAPTURE_H
+#define __PDMCAPTURE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "em_pdm.h"
+#include "ldmastream.h"
+
+/***************************************************************************//**
+ * @addtogroup kitdrv
+ * @{
+ ******************************************************************************/
+
+/***************************************************************************//**
+ * @addtogroup PdmCapture
+ * @brief PDM capture into a ring of application buffers
+ * @details
+ *    The LDMA copies PDM RXDATA words straight into a ring of N
+ *    application buffers (see @ref LdmaStream). The number of buffers and
+ *    their length are set at run time, so the ring can be made deep
+ *    enough to cover the longest processing step.
+ *
+ *    The consumer takes the oldest completed buffer with
+ *    PDMCAPTURE_GetBuffer(), works on it in place and hands it back with
+ *    PDMCAPTURE_ReleaseBuffer(). If the consumer falls behind by a whole
+ *    ring the oldest buffer is dropped and counted in
+ *    PDMCAPTURE_Overruns().
+ *
+ *    Clocks, GPIO and PDMROUTE are board specific and set up by the
+ *    application before PDMCAPTURE_Init(). The application also calls
+ *    LDMA_Init() and calls PDMCAPTURE_IRQHandler() from LDMA_IRQHandler().
+ *
+ *    With dataFormat set to pdmDataFormatDouble16 each word holds one
+ *    stereo frame, use PDMCAPTURE_LEFT() and PDMCAPTURE_RIGHT() to split it.
+ *
+ *    The PDM clock prescaler, decimation ratio, filter order and gain form
+ *    a profile that PDMCAPTURE_SetProfile() changes at run time, for
+ *    instance between a low power and a high fidelity setting; a running
+ *    capture restarts with the new sample rate from the first buffer.
+ * @{
+ ******************************************************************************/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define PDMCAPTURE_MAX_BUFFERS    LDMASTREAM_MAX_BUFFERS  /**< Maximum ring depth */
+
+/** Channel 0 sample of a pdmDataFormatDouble16 word */
+#define PDMCAPTURE_LEFT(w)        ((int16_t)((w) & 0xFFFF))
+/** Channel 1 sample of a pdmDataFormatDouble16 word */
+#define PDMCAPTURE_RIGHT(w)       ((int16_t)((w) >> 16))
+
+/** Called from PDMCAPTURE_IRQHandler() each time a buffer has been filled */
+typedef void (*PDMCAPTURE_Callback_t)(const uint32_t *buffer);
+
+/** Decimation settings of the PDM */
+typedef struct {
+  uint32_t                prescaler;    /**< PDM clock is PDMREF / (prescaler + 1) */
+  uint32_t                dsr;          /**< Down sampling ratio, PDM clocks per sample */
+  PDM_FilterOrder_TypeDef filterOrder;  /**< Order of the decimation filter */
+  uint32_t                gain;         /**< Filter output gain */
+} PDMCAPTURE_Profile_t;
+
+/** Capture configuration */
+typedef struct {
+  unsigned int           channel;       /**< LDMA channel */
+  uint32_t * const       *buffers;      /**< Buffer addresses, word aligned */
+  unsigned int           count;         /**< Number of buffers, 2..PDMCAPTURE_MAX_BUFFERS */
+  unsigned int           length;        /**< Words per buffer */
+  PDMCAPTURE_Callback_t  callback;      /**< Ready callback, may be NULL */
+} PDMCAPTURE_Init_t;
+
+bool            PDMCAPTURE_Init(const PDMCAPTURE_Init_t *init,
+                                const PDM_Init_TypeDef *pdmInit);
+void            PDMCAPTURE_Start(void);
+void            PDMCAPTURE_Stop(void);
+const uint32_t  *PDMCAPTURE_GetBuffer(void);
+void            PDMCAPTURE_ReleaseBuffer(const uint32_t *buffer);
+unsigned int    PDMCAPTURE_ReadyCount(void);
+uint32_t        PDMCAPTURE_Overruns(void);
+unsigned int    PDMCAPTURE_BufferLength(void);
+bool            PDMCAPTURE_SetProfile(const PDMCAPTURE_Profile_t *profile);
+void            PDMCAPTURE_GetProfile(PDMCAPTURE_Profile_t *profile);
+uint32_t        PDMCAPTURE_SampleRate(void);
+void            PDMCAPTURE_IRQHandler(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+/** @} (end group PdmCapture) */
+/** @} (end group kitdrv) */
+
+#endif
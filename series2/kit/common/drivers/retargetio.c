@@ -40,6 +40,7 @@
 
 extern int RETARGET_ReadChar(void);
 extern int RETARGET_WriteChar(char c);
+extern int RETARGET_WriteBuf(const char *buf, int len);
 
 #if !defined(__CROSSWORKS_ARM) && defined(__GNUC__)
 
@@ -226,15 +227,9 @@ int _read(int file, char *ptr, int len)
  *****************************************************************************/
 int _write(int file, const char *ptr, int len)
 {
-  int txCount;
-
   (void) file;
 
-  for (txCount = 0; txCount < len; txCount++) {
-    RETARGET_WriteChar(*ptr++);
-  }
-
-  return len;
+  return RETARGET_WriteBuf(ptr, len);
 }
 #endif /* !defined( __CROSSWORKS_ARM ) && defined( __GNUC__ ) */
 
@@ -277,12 +272,7 @@ _STD_BEGIN
  *****************************************************************************/
 static int TxBuf(uint8_t *buffer, int nbytes)
 {
-  int i;
-
-  for (i = 0; i < nbytes; i++) {
-    RETARGET_WriteChar(*buffer++);
-  }
-  return nbytes;
+  return RETARGET_WriteBuf((const char *) buffer, nbytes);
 }
 
 /*
@@ -0,0 +1,112 @@
+/***************************************************************************//**
+ * @file
+ * @brief Deferred binary logging over the retarget serial port.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2022 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ******************************************************************************/
+
+#include <stdarg.h>
+#include <string.h>
+#include "retargetserial.h"
+#include "retargetlog.h"
+
+/***************************************************************************//**
+ * @addtogroup kitdrv
+ * @{
+ ******************************************************************************/
+
+/***************************************************************************//**
+ * @addtogroup RetargetLog
+ * @{
+ ******************************************************************************/
+
+static uint32_t dropped = 0;    /**< Records with too many arguments */
+
+/**************************************************************************//**
+ * @brief Send one log record
+ * @param[in] id Message ID, index in the RETARGETLOG_MESSAGES list
+ * @param[in] argc Number of uint32_t arguments that follow
+ *****************************************************************************/
+void RETARGETLOG_Write(uint8_t id, int argc, ...)
+{
+  uint8_t  record[3 + 4 * RETARGETLOG_MAX_ARGS + 1];
+  uint8_t  checksum = 0;
+  uint32_t arg;
+  va_list  args;
+  int      len = 0;
+  int      i;
+
+  if ((argc < 0) || (argc > RETARGETLOG_MAX_ARGS)) {
+    dropped++;
+    return;
+  }
+
+  record[len++] = RETARGETLOG_SYNC;
+  record[len++] = id;
+  record[len++] = (uint8_t) argc;
+
+  va_start(args, argc);
+  for (i = 0; i < argc; i++) {
+    arg = va_arg(args, uint32_t);
+    record[len++] = (uint8_t) arg;
+    record[len++] = (uint8_t) (arg >> 8);
+    record[len++] = (uint8_t) (arg >> 16);
+    record[len++] = (uint8_t) (arg >> 24);
+  }
+  va_end(args);
+
+  for (i = 1; i < len; i++) {
+    checksum ^= record[i];
+  }
+  record[len++] = checksum;
+
+  RETARGET_WriteBin(record, len);
+}
+
+/**************************************************************************//**
+ * @brief Pass a float as a log argument
+ * @param[in] f Value to log
+ * @return The IEEE 754 bit pattern of f
+ *****************************************************************************/
+uint32_t RETARGETLOG_Float(float f)
+{
+  uint32_t bits;
+
+  memcpy(&bits, &f, sizeof(bits));
+  return bits;
+}
+
+/**************************************************************************//**
+ * @brief Get the number of records that were not sent
+ * @return Number of records dropped because of an invalid argument count
+ *****************************************************************************/
+uint32_t RETARGETLOG_DropCount(void)
+{
+  return dropped;
+}
+
+/** @} (end group RetargetLog) */
+/** @} (end group kitdrv) */
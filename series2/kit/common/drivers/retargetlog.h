@@ -0,0 +1,107 @@
+/***************************************************************************//**
+ * @file
+ * @brief Deferred binary logging over the retarget serial port.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2022 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ******************************************************************************/
+
+#ifndef __RETARGETLOG_H
+#define __RETARGETLOG_H
+
+#include <stdint.h>
+
+/***************************************************************************//**
+ * @addtogroup kitdrv
+ * @{
+ ******************************************************************************/
+
+/***************************************************************************//**
+ * @addtogroup RetargetLog
+ * @brief Deferred binary logging
+ * @details
+ *    Instead of formatting text on the device, a log call sends a message
+ *    ID and its raw 32-bit arguments. The format strings only exist on the
+ *    host, where ../scripts/retargetlog_decode.py prints the text.
+ *
+ *    The messages are listed once by the application:
+ *
+ *    @code
+ *    #define RETARGETLOG_MESSAGES                            \
+ *      RETARGETLOG_MSG(LOG_BOOT,   "boot, reset cause 0x%x") \
+ *      RETARGETLOG_MSG(LOG_SAMPLE, "ch%u = %d mV")
+ *
+ *    enum { RETARGETLOG_MESSAGES };
+ *
+ *    RETARGETLOG_2(LOG_SAMPLE, channel, millivolts);
+ *    @endcode
+ *
+ *    The decoder reads the same RETARGETLOG_MSG() lines from the source,
+ *    IDs are assigned in the order of the list. Use RETARGETLOG_Float()
+ *    for %f/%e/%g arguments.
+ *
+ *    Each record is 0xA5, ID, argument count, the arguments (little endian)
+ *    and an XOR checksum, so it can be mixed with printf text on the same
+ *    port. With RETARGET_TX_DMA the record goes into the retargetserial TX
+ *    ring and is sent by LDMA; the call does not wait for the UART.
+ * @{
+ ******************************************************************************/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef RETARGETLOG_MAX_ARGS
+#define RETARGETLOG_MAX_ARGS    8          /**< Maximum arguments per record */
+#endif
+
+#define RETARGETLOG_SYNC        0xA5       /**< First byte of each record */
+
+/** Expands a message list entry to its enum ID */
+#define RETARGETLOG_MSG(name, fmt)    name,
+
+#define RETARGETLOG_0(id) \
+  RETARGETLOG_Write((id), 0)
+#define RETARGETLOG_1(id, a) \
+  RETARGETLOG_Write((id), 1, (uint32_t)(a))
+#define RETARGETLOG_2(id, a, b) \
+  RETARGETLOG_Write((id), 2, (uint32_t)(a), (uint32_t)(b))
+#define RETARGETLOG_3(id, a, b, c) \
+  RETARGETLOG_Write((id), 3, (uint32_t)(a), (uint32_t)(b), (uint32_t)(c))
+#define RETARGETLOG_4(id, a, b, c, d) \
+  RETARGETLOG_Write((id), 4, (uint32_t)(a), (uint32_t)(b), (uint32_t)(c), (uint32_t)(d))
+
+void     RETARGETLOG_Write(uint8_t id, int argc, ...);
+uint32_t RETARGETLOG_Float(float f);
+uint32_t RETARGETLOG_DropCount(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+/** @} (end group RetargetLog) */
+/** @} (end group kitdrv) */
+
+#endif
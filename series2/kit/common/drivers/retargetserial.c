@@ -39,6 +39,7 @@
 #include "em_core.h"
 #include "em_gpio.h"
 #include "retargetserial.h"
+#include "spscq.h"
 #if defined(SL_CATALOG_POWER_MANAGER_PRESENT)
 #include "sl_power_manager.h"
 #endif
@@ -71,20 +72,79 @@
 #include "em_leuart.h"
 #endif
 
+#if defined(RETARGET_TX_DMA) || defined(RETARGET_RX_DMA)
+#include "em_ldma.h"
+#endif
+
+/* Baud rate of the USART or EUSART, LEUARTs keep their own */
+#ifndef RETARGET_BAUDRATE
+#define RETARGET_BAUDRATE    115200                 /**< Baud rate */
+#endif
+
 /* Receive buffer */
 #ifndef RXBUFSIZE
+#if defined(RETARGET_RX_DMA)
+#define RXBUFSIZE    128                        /**< Buffer size for RX */
+#else
 #define RXBUFSIZE    8                          /**< Buffer size for RX */
 #endif
+#endif
+#if defined(RETARGET_RX_DMA)
 static volatile int     rxReadIndex  = 0;       /**< Index in buffer to be read */
 static volatile int     rxWriteIndex = 0;       /**< Index in buffer to be written to */
 static volatile int     rxCount      = 0;       /**< Keeps track of how much data which are stored in the buffer */
 static volatile uint8_t rxBuffer[RXBUFSIZE];    /**< Buffer to store data */
+#else
+/* Filled by the RX interrupt, emptied by RETARGET_ReadChar(), lock-free */
+static uint8_t          rxBuffer[RXBUFSIZE];    /**< Buffer to store data */
+static SPSCQ_Queue_t    rxQueue;                /**< Queue over rxBuffer */
+static volatile bool    rxStalled   = false;    /**< RX interrupt disabled on a full queue */
+#endif
 static uint8_t          LFtoCRLF    = 0;        /**< LF to CRLF conversion disabled */
 static bool             initialized = false;    /**< Initialize UART/LEUART */
 #if defined(SL_CATALOG_POWER_MANAGER_PRESENT)
 static bool             em1HasBeenRequired = false; /**< EM1 requirement indicator */
 #endif
 
+#if defined(RETARGET_TX_DMA)
+/* Transmit ring buffer, drained by LDMA */
+#ifndef RETARGET_TXBUFSIZE
+#define RETARGET_TXBUFSIZE    256                   /**< Buffer size for TX */
+#endif
+#ifndef RETARGET_TX_LDMA_CHANNEL
+#define RETARGET_TX_LDMA_CHANNEL    (DMA_CHAN_COUNT - 3) /**< Below the MX25 flash channels */
+#endif
+#if !defined(RETARGET_TX_LDMA_SIGNAL)
+#error "RETARGET_TX_LDMA_SIGNAL must be defined in retargetserialconfig.h"
+#endif
+static uint8_t           txBuffer[RETARGET_TXBUFSIZE]; /**< Buffer to store data */
+static volatile int      txReadIndex  = 0;      /**< Index of the first byte not yet sent */
+static volatile int      txWriteIndex = 0;      /**< Index in buffer to be written to */
+static volatile int      txCount      = 0;      /**< Bytes in the buffer, including the DMA chunk */
+static volatile int      txDmaLength  = 0;      /**< Bytes in the running DMA transfer */
+static volatile uint32_t txDropped    = 0;      /**< Bytes dropped on a full buffer */
+static LDMA_Descriptor_t txDesc;                /**< Descriptor for the running transfer */
+#endif
+
+#if defined(RETARGET_RX_DMA)
+/* rxBuffer is filled by a looped LDMA descriptor, rxWriteIndex and
+ * rxCount are derived from the channel's remaining transfer count. */
+#ifndef RETARGET_RX_LDMA_CHANNEL
+#define RETARGET_RX_LDMA_CHANNEL    (DMA_CHAN_COUNT - 4) /**< Below the TX channel */
+#endif
+#if !defined(RETARGET_RX_LDMA_SIGNAL)
+#error "RETARGET_RX_LDMA_SIGNAL must be defined in retargetserialconfig.h"
+#endif
+#ifndef RETARGET_RX_IDLE_BAUDS
+#define RETARGET_RX_IDLE_BAUDS    20                /**< Idle time in bit periods before the idle callback */
+#endif
+#if RXBUFSIZE > LDMA_DESCRIPTOR_MAX_XFER_SIZE
+#error "RXBUFSIZE is larger than one LDMA descriptor can transfer"
+#endif
+static LDMA_Descriptor_t      rxDesc;           /**< Descriptor linked to itself */
+static void                   (*rxIdleCallback)(void) = NULL; /**< Called on RX idle */
+#endif
+
 /**************************************************************************//**
  * @brief Disable RX interrupt
  *****************************************************************************/
@@ -113,11 +173,212 @@ static void enableRxInterrupt()
 #endif
 }
 
+#if defined(RETARGET_TX_DMA)
+/**************************************************************************//**
+ * @brief Start a DMA transfer of the oldest contiguous run in the TX buffer
+ * @note Must be called with interrupts disabled
+ *****************************************************************************/
+static void txDmaStart(void)
+{
+  LDMA_TransferCfg_t cfg = LDMA_TRANSFER_CFG_PERIPHERAL(RETARGET_TX_LDMA_SIGNAL);
+  int length;
+
+  if ((txDmaLength > 0) || (txCount == 0)) {
+    return;
+  }
+
+  /* Stop at the end of the buffer, the rest is sent by the next transfer */
+  length = txCount;
+  if (length > RETARGET_TXBUFSIZE - txReadIndex) {
+    length = RETARGET_TXBUFSIZE - txReadIndex;
+  }
+  if (length > LDMA_DESCRIPTOR_MAX_XFER_SIZE) {
+    length = LDMA_DESCRIPTOR_MAX_XFER_SIZE;
+  }
+
+  txDesc = (LDMA_Descriptor_t)
+           LDMA_DESCRIPTOR_SINGLE_M2P_BYTE(&txBuffer[txReadIndex],
+                                           &RETARGET_UART->TXDATA,
+                                           length);
+  txDmaLength = length;
+
+#if defined(SL_CATALOG_POWER_MANAGER_PRESENT)
+  /* The UART needs EM1 while the transfer is running */
+  sl_power_manager_add_em_requirement(SL_POWER_MANAGER_EM1);
+#endif
+  LDMA_StartTransfer(RETARGET_TX_LDMA_CHANNEL, &cfg, &txDesc);
+}
+
+/**************************************************************************//**
+ * @brief Put one byte into the TX buffer
+ * @details
+ *   When the buffer is full the byte is dropped if RETARGET_TX_DROP is
+ *   defined or when called with interrupts disabled. Otherwise the call
+ *   waits for the DMA to make room.
+ * @param[in] irqState State saved by the caller's CORE_ENTER_ATOMIC()
+ * @note Must be called inside CORE_ENTER_ATOMIC(), which is left
+ *       temporarily while waiting
+ *****************************************************************************/
+static void txPut(uint8_t c, CORE_irqState_t irqState)
+{
+  while (txCount == RETARGET_TXBUFSIZE) {
+#if !defined(RETARGET_TX_DROP)
+    if (irqState == 0) {
+      /* Interrupts were enabled by the caller, let the LDMA
+       * interrupt free up space */
+      txDmaStart();
+      CORE_EXIT_ATOMIC();
+      CORE_ENTER_ATOMIC();
+      continue;
+    }
+#endif
+    txDropped++;
+    return;
+  }
+
+  txBuffer[txWriteIndex] = c;
+  txWriteIndex++;
+  if (txWriteIndex == RETARGET_TXBUFSIZE) {
+    txWriteIndex = 0;
+  }
+  txCount++;
+}
+
+/**************************************************************************//**
+ * @brief LDMA interrupt handler for the TX channel
+ * @details
+ *   The application owns LDMA_IRQHandler() and must call this function from
+ *   it. Only the flag of RETARGET_TX_LDMA_CHANNEL is handled.
+ *****************************************************************************/
+void RETARGET_LDMA_IRQHandler(void)
+{
+  uint32_t mask = 1UL << RETARGET_TX_LDMA_CHANNEL;
+
+  if (!(LDMA_IntGet() & mask)) {
+    return;
+  }
+  LDMA_IntClear(mask);
+
+  txReadIndex += txDmaLength;
+  if (txReadIndex == RETARGET_TXBUFSIZE) {
+    txReadIndex = 0;
+  }
+  txCount    -= txDmaLength;
+  txDmaLength = 0;
+#if defined(SL_CATALOG_POWER_MANAGER_PRESENT)
+  sl_power_manager_remove_em_requirement(SL_POWER_MANAGER_EM1);
+#endif
+
+  txDmaStart();
+}
+
+/**************************************************************************//**
+ * @brief Get the number of bytes dropped because the TX buffer was full
+ * @return Number of dropped bytes since start-up
+ *****************************************************************************/
+uint32_t RETARGET_TxDropCount(void)
+{
+  return txDropped;
+}
+#endif /* RETARGET_TX_DMA */
+
+#if defined(RETARGET_RX_DMA)
+/**************************************************************************//**
+ * @brief Start the circular RX transfer and the RX idle timeout
+ * @details
+ *   The descriptor links to itself, so the LDMA keeps writing rxBuffer
+ *   round robin without interrupts. The only interrupt left is the RX
+ *   timeout (EUSART RXTO, USART TIMECMP1), signalled once the line has
+ *   been idle after a burst. LEUART has no timeout, it is polled only.
+ *****************************************************************************/
+static void rxDmaStart(void)
+{
+  LDMA_TransferCfg_t cfg = LDMA_TRANSFER_CFG_PERIPHERAL(RETARGET_RX_LDMA_SIGNAL);
+
+  disableRxInterrupt();
+
+  rxDesc = (LDMA_Descriptor_t)
+           LDMA_DESCRIPTOR_LINKREL_P2M_BYTE(&RETARGET_UART->RXDATA,
+                                            rxBuffer, RXBUFSIZE, 0);
+  rxDesc.xfer.doneIfs = 0;
+  LDMA_StartTransfer(RETARGET_RX_LDMA_CHANNEL, &cfg, &rxDesc);
+
+#if defined(RETARGET_EUSART) && defined(EUSART_IF_RXTO)
+  (void)RETARGET_RX_IDLE_BAUDS;
+  EUSART_Enable(RETARGET_UART, eusartDisable);
+  RETARGET_UART->CFG1 = (RETARGET_UART->CFG1 & ~_EUSART_CFG1_RXTIMEOUT_MASK)
+                        | EUSART_CFG1_RXTIMEOUT_TWOFRAMES;
+  EUSART_Enable(RETARGET_UART, eusartEnable);
+  EUSART_IntClear(RETARGET_UART, EUSART_IF_RXTO);
+  EUSART_IntEnable(RETARGET_UART, EUSART_IF_RXTO);
+#elif defined(RETARGET_USART) && defined(USART_TIMECMP1_TSTART_RXEOF)
+  RETARGET_UART->TIMECMP1 = USART_TIMECMP1_TSTART_RXEOF
+                            | USART_TIMECMP1_TSTOP_RXACT
+                            | USART_TIMECMP1_RESTARTEN
+                            | (RETARGET_RX_IDLE_BAUDS << _USART_TIMECMP1_TCMPVAL_SHIFT);
+  USART_IntClear(RETARGET_UART, USART_IF_TCMP1);
+  USART_IntEnable(RETARGET_UART, USART_IF_TCMP1);
+#else
+  (void)RETARGET_RX_IDLE_BAUDS;
+#endif
+}
+
+/**************************************************************************//**
+ * @brief Set a callback for the end of an RX burst
+ * @param[in] callback
+ *   Called from interrupt context when the RX line has been idle for
+ *   RETARGET_RX_IDLE_BAUDS bit periods (two frames on EUSART) after data
+ *   was received. NULL to disable.
+ *****************************************************************************/
+void RETARGET_SetRxIdleCallback(void (*callback)(void))
+{
+  rxIdleCallback = callback;
+}
+
+/**************************************************************************//**
+ * @brief Number of received bytes not read yet
+ * @note Must be called with interrupts disabled
+ *****************************************************************************/
+static int rxDmaAvailable(void)
+{
+  rxWriteIndex = RXBUFSIZE
+                 - (int)LDMA_TransferRemainingCount(RETARGET_RX_LDMA_CHANNEL);
+  if (rxWriteIndex == RXBUFSIZE) {
+    rxWriteIndex = 0;
+  }
+  rxCount = rxWriteIndex - rxReadIndex;
+  if (rxCount < 0) {
+    rxCount += RXBUFSIZE;
+  }
+  return rxCount;
+}
+#endif /* RETARGET_RX_DMA */
+
 /**************************************************************************//**
  * @brief UART/LEUART IRQ Handler
  *****************************************************************************/
 void RETARGET_IRQ_NAME(void)
 {
+#if defined(RETARGET_RX_DMA)
+  /* Data is moved by the LDMA, only the RX timeout ends up here */
+  bool idle = false;
+
+#if defined(RETARGET_EUSART) && defined(EUSART_IF_RXTO)
+  if (RETARGET_UART->IF & EUSART_IF_RXTO) {
+    RETARGET_UART->IF_CLR = EUSART_IF_RXTO;
+    idle = true;
+  }
+#elif defined(RETARGET_USART) && defined(USART_TIMECMP1_TSTART_RXEOF)
+  if (RETARGET_UART->IF & USART_IF_TCMP1) {
+    USART_IntClear(RETARGET_UART, USART_IF_TCMP1);
+    idle = true;
+  }
+#endif
+  if (idle && (rxIdleCallback != NULL)) {
+    rxIdleCallback();
+  }
+#else
+
 #if defined(RETARGET_EUSART)
   if (RETARGET_UART->IF & EUSART_IF_RXFL) {
 #elif defined(RETARGET_USART)
@@ -126,25 +387,22 @@ void RETARGET_IRQ_NAME(void)
   if (RETARGET_UART->IF & LEUART_IF_RXDATAV) {
 #endif
 
-    if (rxCount < RXBUFSIZE) {
+    if (SPSCQ_Free(&rxQueue) > 0) {
       /* There is room for data in the RX buffer so we store the data. */
-      rxBuffer[rxWriteIndex] = RETARGET_RX(RETARGET_UART);
-      rxWriteIndex++;
-      rxCount++;
-      if (rxWriteIndex == RXBUFSIZE) {
-        rxWriteIndex = 0;
-      }
+      (void)SPSCQ_PushByte(&rxQueue, RETARGET_RX(RETARGET_UART));
     } else {
       /* The RX buffer is full so we must wait for the RETARGET_ReadChar()
        * function to make some more room in the buffer. RX interrupts are
        * disabled to let the ISR exit. The RX interrupt will be enabled in
-       * RETARGET_ReadChar(). */
+       * RETARGET_ReadChar(), which sees rxStalled. */
       disableRxInterrupt();
+      rxStalled = true;
     }
 #if defined(RETARGET_EUSART)
     RETARGET_UART->IF_CLR = EUSART_IF_RXFL;
 #endif
   }
+#endif /* RETARGET_RX_DMA */
 }
 
 /**************************************************************************//**
@@ -165,6 +423,10 @@ void RETARGET_SerialCrLf(int on)
  *****************************************************************************/
 void RETARGET_SerialInit(void)
 {
+#if !defined(RETARGET_RX_DMA)
+  SPSCQ_Init(&rxQueue, rxBuffer, RXBUFSIZE, 1);
+#endif
+
   /* Enable peripheral clocks */
 #if defined(_CMU_HFPERCLKEN0_MASK)
   CMU_ClockEnable(cmuClock_HFPER, true);
@@ -187,6 +449,7 @@ void RETARGET_SerialInit(void)
 
   /* Configure USART for basic async operation */
   init.enable = eusartDisable;
+  init.baudrate = RETARGET_BAUDRATE;
   EUSART_UartInitHf(eusart, &init);
 
   /* Enable pins at correct UART/USART location. */
@@ -221,6 +484,7 @@ void RETARGET_SerialInit(void)
 
   /* Configure USART for basic async operation */
   init.enable = usartDisable;
+  init.baudrate = RETARGET_BAUDRATE;
   USART_InitAsync(usart, &init);
 
 #if defined(GPIO_USART_ROUTEEN_TXPEN)
@@ -316,6 +580,11 @@ void RETARGET_SerialInit(void)
   LEUART_Enable(leuart, leuartEnable);
 #endif
 
+#if defined(RETARGET_RX_DMA)
+  /* Hand RX over to the LDMA */
+  rxDmaStart();
+#endif
+
 #if !defined(__CROSSWORKS_ARM) && defined(__GNUC__)
   setvbuf(stdout, NULL, _IONBF, 0);   /*Set unbuffered mode for stdout (newlib)*/
 #endif
@@ -330,27 +599,41 @@ void RETARGET_SerialInit(void)
 int RETARGET_ReadChar(void)
 {
   int c = -1;
+#if defined(RETARGET_RX_DMA)
   CORE_DECLARE_IRQ_STATE;
+#else
+  uint8_t byte;
+#endif
 
   if (initialized == false) {
     RETARGET_SerialInit();
   }
 
+#if defined(RETARGET_RX_DMA)
   CORE_ENTER_ATOMIC();
-  if (rxCount > 0) {
+  /* Unread data is overwritten if more than RXBUFSIZE bytes arrive */
+  if (rxDmaAvailable() > 0) {
     c = rxBuffer[rxReadIndex];
     rxReadIndex++;
     if (rxReadIndex == RXBUFSIZE) {
       rxReadIndex = 0;
     }
     rxCount--;
-    /* Unconditionally enable the RX interrupt. RX interrupts are disabled when
-     * a buffer full condition is entered. This way flow control can be handled
-     * automatically by the hardware. */
-    enableRxInterrupt();
   }
-
   CORE_EXIT_ATOMIC();
+#else
+  /* The interrupt only writes the queue head, so no critical section */
+  if (SPSCQ_PopByte(&rxQueue, &byte)) {
+    c = byte;
+    /* The RX interrupt is disabled when a buffer full condition is entered
+     * and only then; with RX stopped it cannot race this enable. This way
+     * flow control can be handled automatically by the hardware. */
+    if (rxStalled) {
+      rxStalled = false;
+      enableRxInterrupt();
+    }
+  }
+#endif
 
   return c;
 }
@@ -366,15 +649,93 @@ int RETARGET_WriteChar(char c)
     RETARGET_SerialInit();
   }
 
+#if defined(RETARGET_TX_DMA)
+  CORE_DECLARE_IRQ_STATE;
+
+  CORE_ENTER_ATOMIC();
+  /* Add CR or LF to CRLF if enabled */
+  if (LFtoCRLF && (c == '\n')) {
+    txPut('\r', irqState);
+  }
+  txPut(c, irqState);
+  txDmaStart();
+  CORE_EXIT_ATOMIC();
+#else
   /* Add CR or LF to CRLF if enabled */
   if (LFtoCRLF && (c == '\n')) {
     RETARGET_TX(RETARGET_UART, '\r');
   }
   RETARGET_TX(RETARGET_UART, c);
+#endif
 
   return c;
 }
 
+/**************************************************************************//**
+ * @brief Transmit a buffer, with LF to CRLF conversion if crlf is non-zero
+ *****************************************************************************/
+static int writeBuf(const uint8_t *buf, int len, uint8_t crlf)
+{
+  int i;
+
+  if (initialized == false) {
+    RETARGET_SerialInit();
+  }
+
+#if defined(RETARGET_TX_DMA)
+  CORE_DECLARE_IRQ_STATE;
+
+  CORE_ENTER_ATOMIC();
+  for (i = 0; i < len; i++) {
+    if (crlf && (buf[i] == '\n')) {
+      txPut('\r', irqState);
+    }
+    txPut(buf[i], irqState);
+  }
+  txDmaStart();
+  CORE_EXIT_ATOMIC();
+#else
+  for (i = 0; i < len; i++) {
+    if (crlf && (buf[i] == '\n')) {
+      RETARGET_TX(RETARGET_UART, '\r');
+    }
+    RETARGET_TX(RETARGET_UART, buf[i]);
+  }
+#endif
+
+  return len;
+}
+
+/**************************************************************************//**
+ * @brief Transmit a buffer to USART/LEUART
+ * @details
+ *   Same output as calling RETARGET_WriteChar() for each byte, but the
+ *   LF to CRLF conversion and the UART or TX buffer access are done in one
+ *   pass over the buffer. With RETARGET_TX_DMA one DMA transfer is started
+ *   for the whole buffer.
+ * @param[in] buf Characters to transmit
+ * @param[in] len Number of characters in buf
+ * @return Number of characters consumed from buf
+ *****************************************************************************/
+int RETARGET_WriteBuf(const char *buf, int len)
+{
+  return writeBuf((const uint8_t *) buf, len, LFtoCRLF);
+}
+
+/**************************************************************************//**
+ * @brief Transmit binary data to USART/LEUART
+ * @details
+ *   Like RETARGET_WriteBuf() but without LF to CRLF conversion, for binary
+ *   records such as the ones written by retargetlog.
+ * @param[in] buf Data to transmit
+ * @param[in] len Number of bytes in buf
+ * @return Number of bytes consumed from buf
+ *****************************************************************************/
+int RETARGET_WriteBin(const uint8_t *buf, int len)
+{
+  return writeBuf(buf, len, 0);
+}
+
 /**************************************************************************//**
  * @brief Enable hardware flow control. (RTS + CTS)
  * @return true if hardware flow control was enabled and false otherwise.
@@ -399,9 +760,16 @@ bool RETARGET_SerialEnableFlowControl(void)
 
 /**************************************************************************//**
  * @brief Flush UART/LEUART
+ * @details
+ *   With RETARGET_TX_DMA the TX buffer is drained first. This needs the
+ *   LDMA interrupt, so do not call it with interrupts disabled.
  *****************************************************************************/
 void RETARGET_SerialFlush(void)
 {
+#if defined(RETARGET_TX_DMA)
+  while (txCount > 0) ;
+#endif
+
 #if defined(RETARGET_EUSART)
 
 #define _GENERIC_UART_STATUS_IDLE     EUSART_STATUS_TXIDLE
@@ -434,7 +802,8 @@ void RETARGET_SerialFlush(void)
  *
  * @detail
  *   Because transmits are blocking, the Energy Mode will stay in EM0 until all
- *   data has been transmitted independent of this setting.
+ *   data has been transmitted independent of this setting. With
+ *   RETARGET_TX_DMA, EM1 is required while the TX buffer is being sent.
  *
  *   Some serial ports require EM0 or EM1 to receive data. If the application
  *   enter EM2 or lower, the serial port will in that case not receive data.
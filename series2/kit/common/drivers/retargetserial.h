@@ -37,6 +37,7 @@
 #include "retargetserialconfig.h"
 #endif
 #include <stdbool.h>
+#include <stdint.h>
 
 /***************************************************************************//**
  * @addtogroup kitdrv
@@ -63,6 +64,8 @@ int __getchar(void);
 
 int  RETARGET_ReadChar(void);
 int  RETARGET_WriteChar(char c);
+int  RETARGET_WriteBuf(const char *buf, int len);
+int  RETARGET_WriteBin(const uint8_t *buf, int len);
 
 void RETARGET_SerialCrLf(int on);
 void RETARGET_SerialInit(void);
@@ -71,6 +74,20 @@ void RETARGET_SerialFlush(void);
 
 void RETARGET_RequireEm1(bool requireEm1);
 
+#if defined(RETARGET_TX_DMA)
+/* Non-blocking TX through an LDMA drained ring buffer. The application
+ * must call LDMA_Init() before RETARGET_SerialInit() and call
+ * RETARGET_LDMA_IRQHandler() from its LDMA_IRQHandler(). */
+void     RETARGET_LDMA_IRQHandler(void);
+uint32_t RETARGET_TxDropCount(void);
+#endif
+
+#if defined(RETARGET_RX_DMA)
+/* RX into a circular LDMA buffer, no interrupt per received byte.
+ * LDMA_Init() must be called before RETARGET_SerialInit(). */
+void RETARGET_SetRxIdleCallback(void (*callback)(void));
+#endif
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,328 @@
+/***************************************************************************//**
+ * @file
+ * @brief Provide stdio retargeting to the ITM and the SWO pin.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2022 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ******************************************************************************/
+
+#define CURRENT_MODULE_NAME    "RETARGETSWO"
+
+#if defined(SL_COMPONENT_CATALOG_PRESENT)
+#include "sl_component_catalog.h"
+#endif
+#include <stdio.h>
+#include "em_device.h"
+#include "em_cmu.h"
+#include "em_gpio.h"
+#include "retargetswo.h"
+#if defined(SL_CATALOG_POWER_MANAGER_PRESENT)
+#include "sl_power_manager.h"
+#endif
+
+/***************************************************************************//**
+ * @addtogroup kitdrv
+ * @{
+ ******************************************************************************/
+
+/***************************************************************************//**
+ * @addtogroup RetargetSwo
+ * @{
+ ******************************************************************************/
+
+#if (RETARGET_SWO_PORT < 0) || (RETARGET_SWO_PORT > 31)
+#error "RETARGET_SWO_PORT must be an ITM stimulus port, 0 to 31"
+#endif
+
+#if !defined(_SILICON_LABS_32B_SERIES_2)
+#error "retargetswo.c supports series 2 devices only"
+#endif
+
+/** Written by the debugger, read by ITM_ReceiveChar() */
+volatile int32_t ITM_RxBuffer = ITM_RXBUFFER_EMPTY;
+
+static uint8_t  LFtoCRLF    = 0;        /**< LF to CRLF conversion disabled */
+static bool     initialized = false;    /**< TPIU and ITM set up */
+static uint32_t swoFreq     = 0;        /**< SWO bit rate set, Hz */
+#if defined(SL_CATALOG_POWER_MANAGER_PRESENT)
+static bool     em1HasBeenRequired = false; /**< EM1 requirement indicator */
+#endif
+
+/**************************************************************************//**
+ * @brief Check if the stimulus port is enabled, as in ITM_SendChar()
+ *****************************************************************************/
+static bool portEnabled(void)
+{
+  return ((ITM->TCR & ITM_TCR_ITMENA_Msk) != 0UL)
+         && ((ITM->TER & (1UL << RETARGET_SWO_PORT)) != 0UL);
+}
+
+/**************************************************************************//**
+ * @brief Send up to four bytes in one stimulus port write
+ * @param[in] word The bytes, the first one in the least significant byte
+ * @param[in] len Number of bytes in word, 1 to 4
+ *****************************************************************************/
+static void portWrite(uint32_t word, int len)
+{
+  // The port reads 1 while its FIFO has room
+  while (ITM->PORT[RETARGET_SWO_PORT].u32 == 0UL) {
+  }
+  if (len == 4) {
+    ITM->PORT[RETARGET_SWO_PORT].u32 = word;
+  } else if (len == 2) {
+    ITM->PORT[RETARGET_SWO_PORT].u16 = (uint16_t)word;
+  } else {
+    ITM->PORT[RETARGET_SWO_PORT].u8 = (uint8_t)word;
+    if (len == 3) {
+      while (ITM->PORT[RETARGET_SWO_PORT].u32 == 0UL) {
+      }
+      ITM->PORT[RETARGET_SWO_PORT].u16 = (uint16_t)(word >> 8);
+    }
+  }
+}
+
+/**************************************************************************//**
+ * @brief Send data, four bytes per stimulus port write where possible
+ * @param[in] buf Data to transmit
+ * @param[in] len Number of bytes in buf
+ * @param[in] crlf Nonzero to insert a CR before each LF
+ * @return Number of bytes consumed from buf
+ *****************************************************************************/
+static int writeBuf(const uint8_t *buf, int len, uint8_t crlf)
+{
+  uint32_t word = 0;
+  int      fill = 0;
+  int      i;
+
+  if (initialized == false) {
+    RETARGET_SerialInit();
+  }
+
+  // Dropped without a debugger, with no time spent waiting
+  if (!portEnabled()) {
+    return len;
+  }
+
+  for (i = 0; i < len; i++) {
+    if (crlf && (buf[i] == '\n')) {
+      word |= (uint32_t)'\r' << (8 * fill);
+      if (++fill == 4) {
+        portWrite(word, 4);
+        word = 0;
+        fill = 0;
+      }
+    }
+    word |= (uint32_t)buf[i] << (8 * fill);
+    if (++fill == 4) {
+      portWrite(word, 4);
+      word = 0;
+      fill = 0;
+    }
+  }
+  if (fill > 0) {
+    portWrite(word, fill);
+  }
+
+  return len;
+}
+
+/**************************************************************************//**
+ * @brief Enable or disable LF to CRLF conversion
+ * @param[in] on If non-zero, automatic LF to CRLF conversion will be enabled
+ *****************************************************************************/
+void RETARGET_SerialCrLf(int on)
+{
+  if (on) {
+    LFtoCRLF = 1;
+  } else {
+    LFtoCRLF = 0;
+  }
+}
+
+/**************************************************************************//**
+ * @brief Route the ITM to the SWO pin
+ * @details
+ *   With RETARGET_SWO_SETUP 1 the TPIU is set to the NRZ protocol at the
+ *   trace clock divided down to RETARGET_SWO_FREQ, rounded to the nearest
+ *   divider, and the ITM and the stimulus port are enabled. This overrides
+ *   the setup of a debugger that is already connected.
+ *****************************************************************************/
+void RETARGET_SerialInit(void)
+{
+  CMU_ClockEnable(cmuClock_GPIO, true);
+  GPIO_DbgSWOEnable(true);
+#if defined(GPIO_SWV_PORT)
+  GPIO_PinModeSet((GPIO_Port_TypeDef)GPIO_SWV_PORT, GPIO_SWV_PIN,
+                  gpioModePushPull, 1);
+#endif
+
+#if RETARGET_SWO_SETUP
+  {
+    uint32_t traceClock;
+    uint32_t div;
+
+#if defined(_CMU_TRACECLKCTRL_MASK)
+    traceClock = CMU_ClockFreqGet(cmuClock_TRACECLK);
+#else
+    traceClock = CMU_ClockFreqGet(cmuClock_HCLK);
+#endif
+    div = (traceClock + (RETARGET_SWO_FREQ / 2)) / RETARGET_SWO_FREQ;
+    if (div == 0) {
+      div = 1;
+    }
+    swoFreq = traceClock / div;
+
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    TPI->ACPR = div - 1;
+    TPI->SPPR = 2;                      // NRZ, the UART protocol
+    TPI->FFCR = 0x100;                  // Formatter off, ITM only
+    ITM->LAR  = 0xC5ACCE55;             // Unlock the ITM registers
+    ITM->TCR  = (1UL << ITM_TCR_TRACEBUSID_Pos)
+                | ITM_TCR_SYNCENA_Msk
+                | ITM_TCR_ITMENA_Msk;
+    ITM->TER |= 1UL << RETARGET_SWO_PORT;
+  }
+#endif
+
+  initialized = true;
+}
+
+/**************************************************************************//**
+ * @brief Get the SWO bit rate set by RETARGET_SerialInit()
+ * @return Bit rate in Hz, 0 with RETARGET_SWO_SETUP 0 or before the setup
+ *****************************************************************************/
+uint32_t RETARGET_SwoFrequency(void)
+{
+  return swoFreq;
+}
+
+/**************************************************************************//**
+ * @brief Receive a byte from the debugger through ITM_RxBuffer
+ * @return -1 on failure, or positive character integer on sucesss
+ *****************************************************************************/
+int RETARGET_ReadChar(void)
+{
+  if (initialized == false) {
+    RETARGET_SerialInit();
+  }
+
+  return ITM_ReceiveChar();
+}
+
+/**************************************************************************//**
+ * @brief Transmit single byte to the ITM
+ * @param c Character to transmit
+ * @return Transmitted character
+ *****************************************************************************/
+int RETARGET_WriteChar(char c)
+{
+  uint8_t b = (uint8_t)c;
+
+  writeBuf(&b, 1, LFtoCRLF);
+
+  return c;
+}
+
+/**************************************************************************//**
+ * @brief Transmit a buffer to the ITM
+ * @details
+ *   Four bytes go out in each stimulus port write, the CPU waits only
+ *   while the ITM FIFO is full.
+ * @param[in] buf Data to transmit
+ * @param[in] len Number of bytes in buf
+ * @return Number of bytes consumed from buf
+ *****************************************************************************/
+int RETARGET_WriteBuf(const char *buf, int len)
+{
+  return writeBuf((const uint8_t *) buf, len, LFtoCRLF);
+}
+
+/**************************************************************************//**
+ * @brief Transmit binary data to the ITM
+ * @details
+ *   Like RETARGET_WriteBuf() but without LF to CRLF conversion, for binary
+ *   records such as the ones written by retargetlog.
+ * @param[in] buf Data to transmit
+ * @param[in] len Number of bytes in buf
+ * @return Number of bytes consumed from buf
+ *****************************************************************************/
+int RETARGET_WriteBin(const uint8_t *buf, int len)
+{
+  return writeBuf(buf, len, 0);
+}
+
+/**************************************************************************//**
+ * @brief Enable hardware flow control
+ * @return false, SWO has no flow control
+ *****************************************************************************/
+bool RETARGET_SerialEnableFlowControl(void)
+{
+  return false;
+}
+
+/**************************************************************************//**
+ * @brief Wait until the ITM has passed all data on to the TPIU
+ *****************************************************************************/
+void RETARGET_SerialFlush(void)
+{
+  if (portEnabled()) {
+    while (ITM->TCR & ITM_TCR_BUSY_Msk) {
+    }
+  }
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Control the Energy Mode level required by the RETARGET SWO module.
+ *
+ * @detail
+ *   The trace clock stops in EM2 and lower, and data still in the ITM
+ *   FIFO is lost there. Require EM1 while tracing if the application
+ *   sleeps, or call RETARGET_SerialFlush() before entering EM2.
+ *
+ * @note
+ *    If the power manager is not available, the RETARGET SWO module does
+ *    not control the Energy Modes.
+ *
+ * @param[in] requireEm1
+ *   A bool to tell wether EM1 is required or not.
+ *****************************************************************************/
+void RETARGET_RequireEm1(bool requireEm1)
+{
+#if defined(SL_CATALOG_POWER_MANAGER_PRESENT)
+  if (requireEm1 && !em1HasBeenRequired) {
+    sl_power_manager_add_em_requirement(SL_POWER_MANAGER_EM1);
+    em1HasBeenRequired = true;
+  } else if (!requireEm1 && em1HasBeenRequired) {
+    sl_power_manager_remove_em_requirement(SL_POWER_MANAGER_EM1);
+    em1HasBeenRequired = false;
+  }
+#else
+  (void)requireEm1;
+#endif
+}
+
+/** @} (end group RetargetSwo) */
+/** @} (end group kitdrv) */
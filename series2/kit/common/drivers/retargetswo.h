@@ -0,0 +1,90 @@
+/***************************************************************************//**
+ * @file
+ * @brief Retarget stdio to the ITM and the SWO pin.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2022 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ******************************************************************************/
+
+#ifndef __RETARGETSWO_H
+#define __RETARGETSWO_H
+
+#include "retargetserial.h"
+
+/***************************************************************************//**
+ * @addtogroup kitdrv
+ * @{
+ ******************************************************************************/
+
+/***************************************************************************//**
+ * @addtogroup RetargetSwo
+ * @brief Standard I/O retargeting to the ITM and the SWO pin
+ * @details
+ *    retargetswo.c takes the place of retargetserial.c in a project and
+ *    provides the same RETARGET_x functions, so retargetio.c, retargetlog
+ *    and the application run unchanged. The data goes to an ITM stimulus
+ *    port, RETARGET_SWO_PORT, and out of the SWO pin to the debugger, so no
+ *    UART and no pins other than SWO are used. One 32 bit write to the ITM
+ *    sends four bytes; the CPU only waits when the ITM FIFO is full.
+ *
+ *    With RETARGET_SWO_SETUP 1, RETARGET_SerialInit() programs the TPIU
+ *    for the NRZ (UART) protocol at RETARGET_SWO_FREQ, as close as the
+ *    trace clock divides, and enables the port. RETARGET_SwoFrequency()
+ *    returns the frequency set, to be entered in the SWO viewer. With
+ *    RETARGET_SWO_SETUP 0, the debugger sets up the TPIU and the ITM.
+ *
+ *    Nothing is sent while the port is not enabled, so output costs no
+ *    time without a debugger. There is no receive channel apart from the
+ *    debugger written ITM_RxBuffer of CMSIS, which RETARGET_ReadChar()
+ *    reads.
+ * @{
+ ******************************************************************************/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if !defined(RETARGET_SWO_PORT)
+#define RETARGET_SWO_PORT     0         /**< ITM stimulus port */
+#endif
+
+#if !defined(RETARGET_SWO_SETUP)
+#define RETARGET_SWO_SETUP    1         /**< 1 to set up the TPIU and the ITM */
+#endif
+
+#if !defined(RETARGET_SWO_FREQ)
+#define RETARGET_SWO_FREQ     4000000   /**< SWO bit rate in Hz, NRZ */
+#endif
+
+uint32_t RETARGET_SwoFrequency(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+/** @} (end group RetargetSwo) */
+/** @} (end group kitdrv) */
+
+#endif
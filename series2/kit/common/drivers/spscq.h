@@ -0,0 +1,272 @@
+/***************************************************************************//**
+ * @file
+ * @brief Lock-free single producer, single consumer queue.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2022 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ******************************************************************************/
+
+#ifndef __SPSCQ_H
+#define __SPSCQ_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include "em_device.h"
+
+/***************************************************************************//**
+ * @addtogroup kitdrv
+ * @{
+ ******************************************************************************/
+
+/***************************************************************************//**
+ * @addtogroup Spscq
+ * @brief Lock-free single producer, single consumer queue
+ * @details
+ *    Hands data from one interrupt handler to the main loop, or the other
+ *    way, without a critical section. Only the producer writes the head
+ *    and only the consumer writes the tail, so neither has to mask
+ *    interrupts to update them: a 32-bit aligned store is atomic on every
+ *    Cortex-M. __DMB() orders the element copies against the index stores,
+ *    so the consumer never sees the head move before the data it covers,
+ *    and the producer never reuses a slot before it has been read.
+ *
+ *    Both indices count from 0 to 2 * size - 1, so a full queue and an
+ *    empty one differ and every slot is used, with any size and no divide.
+ *    SPSCQ_Push() and SPSCQ_Pop() move a batch of elements with at most two
+ *    memcpy() calls, one on each side of the wrap, and publish the batch
+ *    with one index store.
+ *
+ *    There must be one producer and one consumer only. An interrupt handler
+ *    that shares a queue with another interrupt of a different priority, or
+ *    two threads of the main loop on the same side, still need a lock.
+ * @{
+ ******************************************************************************/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Queue of fixed size elements over a buffer of the application */
+typedef struct {
+  uint8_t           *buffer;      /**< size * elementSize bytes */
+  uint32_t          size;         /**< Elements the buffer holds */
+  uint32_t          elementSize;  /**< Bytes per element */
+  volatile uint32_t head;         /**< Written by the producer only */
+  volatile uint32_t tail;         /**< Written by the consumer only */
+} SPSCQ_Queue_t;
+
+/***************************************************************************//**
+ * @brief
+ *   Set up an empty queue, before either side uses it.
+ ******************************************************************************/
+__STATIC_INLINE void SPSCQ_Init(SPSCQ_Queue_t *queue, void *buffer,
+                                uint32_t size, uint32_t elementSize)
+{
+  queue->buffer = (uint8_t *)buffer;
+  queue->size = size;
+  queue->elementSize = elementSize;
+  queue->head = 0;
+  queue->tail = 0;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Index after moving count elements on from index, below 2 * size.
+ ******************************************************************************/
+__STATIC_INLINE uint32_t SPSCQ_Advance(const SPSCQ_Queue_t *queue,
+                                       uint32_t index, uint32_t count)
+{
+  index += count;
+  if (index >= 2 * queue->size) {
+    index -= 2 * queue->size;
+  }
+  return index;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Elements queued between a head and a tail.
+ ******************************************************************************/
+__STATIC_INLINE uint32_t SPSCQ_Used(const SPSCQ_Queue_t *queue,
+                                    uint32_t head, uint32_t tail)
+{
+  return (head >= tail) ? (head - tail) : (head + 2 * queue->size - tail);
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Elements queued. Exact for the consumer, a low bound for the producer.
+ ******************************************************************************/
+__STATIC_INLINE uint32_t SPSCQ_Count(const SPSCQ_Queue_t *queue)
+{
+  return SPSCQ_Used(queue, queue->head, queue->tail);
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Free elements. Exact for the producer, a low bound for the consumer.
+ ******************************************************************************/
+__STATIC_INLINE uint32_t SPSCQ_Free(const SPSCQ_Queue_t *queue)
+{
+  return queue->size - SPSCQ_Count(queue);
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Copy up to count elements in, producer side only.
+ *
+ * @return
+ *   Elements queued, less than count if the queue filled up.
+ ******************************************************************************/
+__STATIC_INLINE uint32_t SPSCQ_Push(SPSCQ_Queue_t *queue, const void *data,
+                                    uint32_t count)
+{
+  const uint8_t *src = (const uint8_t *)data;
+  uint32_t head = queue->head;
+  uint32_t room = queue->size - SPSCQ_Used(queue, head, queue->tail);
+  uint32_t slot, first;
+
+  if (count > room) {
+    count = room;
+  }
+  if (count == 0) {
+    return 0;
+  }
+
+  // The slots must be read out before they are written again
+  __DMB();
+
+  slot = (head >= queue->size) ? (head - queue->size) : head;
+  first = queue->size - slot;
+  if (first > count) {
+    first = count;
+  }
+  memcpy(&queue->buffer[slot * queue->elementSize], src,
+         first * queue->elementSize);
+  memcpy(queue->buffer, &src[first * queue->elementSize],
+         (count - first) * queue->elementSize);
+
+  // Data before head
+  __DMB();
+  queue->head = SPSCQ_Advance(queue, head, count);
+
+  return count;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Copy up to count elements out, consumer side only.
+ *
+ * @return
+ *   Elements taken, less than count if the queue ran empty.
+ ******************************************************************************/
+__STATIC_INLINE uint32_t SPSCQ_Pop(SPSCQ_Queue_t *queue, void *data,
+                                   uint32_t count)
+{
+  uint8_t *dst = (uint8_t *)data;
+  uint32_t tail = queue->tail;
+  uint32_t used = SPSCQ_Used(queue, queue->head, tail);
+  uint32_t slot, first;
+
+  if (count > used) {
+    count = used;
+  }
+  if (count == 0) {
+    return 0;
+  }
+
+  // Head before data
+  __DMB();
+
+  slot = (tail >= queue->size) ? (tail - queue->size) : tail;
+  first = queue->size - slot;
+  if (first > count) {
+    first = count;
+  }
+  memcpy(dst, &queue->buffer[slot * queue->elementSize],
+         first * queue->elementSize);
+  memcpy(&dst[first * queue->elementSize], queue->buffer,
+         (count - first) * queue->elementSize);
+
+  // Data read before the slots are given back
+  __DMB();
+  queue->tail = SPSCQ_Advance(queue, tail, count);
+
+  return count;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Queue one byte, producer side only, elementSize 1.
+ *
+ * @return
+ *   false if the queue is full.
+ ******************************************************************************/
+__STATIC_INLINE bool SPSCQ_PushByte(SPSCQ_Queue_t *queue, uint8_t byte)
+{
+  uint32_t head = queue->head;
+
+  if (SPSCQ_Used(queue, head, queue->tail) == queue->size) {
+    return false;
+  }
+  __DMB();
+  queue->buffer[(head >= queue->size) ? (head - queue->size) : head] = byte;
+  __DMB();
+  queue->head = SPSCQ_Advance(queue, head, 1);
+
+  return true;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Take one byte, consumer side only, elementSize 1.
+ *
+ * @return
+ *   false if the queue is empty.
+ ******************************************************************************/
+__STATIC_INLINE bool SPSCQ_PopByte(SPSCQ_Queue_t *queue, uint8_t *byte)
+{
+  uint32_t tail = queue->tail;
+
+  if (queue->head == tail) {
+    return false;
+  }
+  __DMB();
+  *byte = queue->buffer[(tail >= queue->size) ? (tail - queue->size) : tail];
+  __DMB();
+  queue->tail = SPSCQ_Advance(queue, tail, 1);
+
+  return true;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+/** @} (end group Spscq) */
+/** @} (end group kitdrv) */
+
+#endif
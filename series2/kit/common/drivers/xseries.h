@@ -0,0 +1,263 @@
+/***************************************************************************//**
+ * @file
+ * @brief Compile-time helpers for the differences between series 2 devices.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2022 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ******************************************************************************/
+
+#ifndef __XSERIES_H
+#define __XSERIES_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "em_device.h"
+#include "em_cmu.h"
+#include "em_gpio.h"
+
+/***************************************************************************//**
+ * @addtogroup kitdrv
+ * @{
+ ******************************************************************************/
+
+/***************************************************************************//**
+ * @addtogroup XSeries
+ * @brief Compile-time helpers for the differences between series 2 devices
+ * @details
+ *    The series 2 devices differ in a few register layouts and power
+ *    domains that the examples otherwise handle with one main file per
+ *    device. The helpers below resolve these differences from the device
+ *    header at build time, so one source builds for all of them with the
+ *    same code each device would have had in its own file:
+ *
+ *    - XSERIES_CONFIG is the series 2 configuration, 1 for xG21, 2 for
+ *      xG22, 3 for xG23 and so on, for the rare #if a helper can not hide.
+ *    - XSERIES_LETIMER_ROUTE is the LETIMER0 route register block, an
+ *      array of one on xG21 and xG22 and a single block on later devices.
+ *    - XSERIES_LetimerRouteOut(), XSERIES_TimerRouteCc() and
+ *      XSERIES_UsartRoute() route a peripheral signal to a pin.
+ *    - XSERIES_IadcWaitDisabled() waits for the IADC to finish disabling,
+ *      on the devices where disabling is not immediate.
+ *    - XSERIES_EM2DebugEnable() keeps the debugger connected in EM2 on the
+ *      devices where this is not the default.
+ *    - XSERIES_EscapeHatch() halts at startup while a button is held, so
+ *      a debugger can connect to a device that sleeps in EM2.
+ *
+ *    The streaming drivers, UartRing for the USART and LdmaStream for the
+ *    IADC and the other LDMA peripherals, already build for all series 2
+ *    devices from one source; these helpers do the same for the setup code
+ *    around them.
+ * @{
+ ******************************************************************************/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if !defined(_SILICON_LABS_32B_SERIES_2)
+#error "xseries.h supports series 2 devices only"
+#endif
+
+/** Series 2 configuration of the device, 1 for xG21, 2 for xG22... */
+#define XSERIES_CONFIG    _SILICON_LABS_32B_SERIES_2_CONFIG
+
+#if (XSERIES_CONFIG == 1) || (XSERIES_CONFIG == 2)
+#define XSERIES_LETIMER_ROUTE    (GPIO->LETIMERROUTE[0])  /**< LETIMER0 route registers */
+#else
+#define XSERIES_LETIMER_ROUTE    (GPIO->LETIMERROUTE)     /**< LETIMER0 route registers */
+#endif
+
+/***************************************************************************//**
+ * @brief
+ *   Route a LETIMER0 output to a pin and enable it.
+ *
+ * @param[in] out
+ *   LETIMER output, 0 or 1.
+ *
+ * @param[in] port
+ *   GPIO port, A or B from EM2.
+ *
+ * @param[in] pin
+ *   GPIO pin.
+ ******************************************************************************/
+__STATIC_INLINE void XSERIES_LetimerRouteOut(unsigned int out,
+                                             GPIO_Port_TypeDef port,
+                                             unsigned int pin)
+{
+  uint32_t route = ((uint32_t)port << _GPIO_LETIMER_OUT0ROUTE_PORT_SHIFT)
+                   | (pin << _GPIO_LETIMER_OUT0ROUTE_PIN_SHIFT);
+
+  if (out == 0) {
+    XSERIES_LETIMER_ROUTE.OUT0ROUTE = route;
+    XSERIES_LETIMER_ROUTE.ROUTEEN |= GPIO_LETIMER_ROUTEEN_OUT0PEN;
+  } else {
+    XSERIES_LETIMER_ROUTE.OUT1ROUTE = route;
+    XSERIES_LETIMER_ROUTE.ROUTEEN |= GPIO_LETIMER_ROUTEEN_OUT1PEN;
+  }
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Route a TIMER capture/compare channel to a pin and enable it.
+ *
+ * @param[in] timer
+ *   TIMER number.
+ *
+ * @param[in] cc
+ *   Capture/compare channel, 0 to 2.
+ *
+ * @param[in] port
+ *   GPIO port.
+ *
+ * @param[in] pin
+ *   GPIO pin.
+ ******************************************************************************/
+__STATIC_INLINE void XSERIES_TimerRouteCc(unsigned int timer,
+                                          unsigned int cc,
+                                          GPIO_Port_TypeDef port,
+                                          unsigned int pin)
+{
+  uint32_t route = ((uint32_t)port << _GPIO_TIMER_CC0ROUTE_PORT_SHIFT)
+                   | (pin << _GPIO_TIMER_CC0ROUTE_PIN_SHIFT);
+
+  if (cc == 0) {
+    GPIO->TIMERROUTE[timer].CC0ROUTE = route;
+  } else if (cc == 1) {
+    GPIO->TIMERROUTE[timer].CC1ROUTE = route;
+  } else {
+    GPIO->TIMERROUTE[timer].CC2ROUTE = route;
+  }
+  GPIO->TIMERROUTE[timer].ROUTEEN |= GPIO_TIMER_ROUTEEN_CC0PEN << cc;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Route the TX and RX signals of a USART to pins and enable them.
+ *
+ * @param[in] usart
+ *   USART number.
+ *
+ * @param[in] txPort
+ *   GPIO port of TX.
+ *
+ * @param[in] txPin
+ *   GPIO pin of TX.
+ *
+ * @param[in] rxPort
+ *   GPIO port of RX.
+ *
+ * @param[in] rxPin
+ *   GPIO pin of RX.
+ ******************************************************************************/
+__STATIC_INLINE void XSERIES_UsartRoute(unsigned int usart,
+                                        GPIO_Port_TypeDef txPort,
+                                        unsigned int txPin,
+                                        GPIO_Port_TypeDef rxPort,
+                                        unsigned int rxPin)
+{
+  GPIO->USARTROUTE[usart].TXROUTE =
+    ((uint32_t)txPort << _GPIO_USART_TXROUTE_PORT_SHIFT)
+    | (txPin << _GPIO_USART_TXROUTE_PIN_SHIFT);
+  GPIO->USARTROUTE[usart].RXROUTE =
+    ((uint32_t)rxPort << _GPIO_USART_RXROUTE_PORT_SHIFT)
+    | (rxPin << _GPIO_USART_RXROUTE_PIN_SHIFT);
+  GPIO->USARTROUTE[usart].ROUTEEN = GPIO_USART_ROUTEEN_TXPEN
+                                    | GPIO_USART_ROUTEEN_RXPEN;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Wait until the IADC has finished disabling after a write to IADC0->EN.
+ ******************************************************************************/
+__STATIC_INLINE void XSERIES_IadcWaitDisabled(void)
+{
+#if defined(_IADC_EN_DISABLING_MASK)
+  while ((IADC0->EN & _IADC_EN_DISABLING_MASK) == IADC_EN_DISABLING) {
+  }
+#endif
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Keep the debug block powered in EM2.
+ *
+ * @details
+ *   From xG22 the debug block is powered down in EM2, so the debugger
+ *   loses the device once it sleeps. The debug block stays powered as
+ *   long as its power sub-domain is held on by an EM2 peripheral in it,
+ *   which is not the case for the LETIMER from xG23. This costs about
+ *   0.5 uA in EM2. There is nothing to do on xG21.
+ ******************************************************************************/
+__STATIC_INLINE void XSERIES_EM2DebugEnable(void)
+{
+#if defined(EMU_CTRL_EM2DBGEN)
+  EMU->CTRL_SET = EMU_CTRL_EM2DBGEN;
+#endif
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Halt at startup while a button is held.
+ *
+ * @details
+ *   An example that sleeps in EM2 from the start keeps the debugger from
+ *   connecting to erase or program it. Holding the button through a reset
+ *   turns on the LED and stops the core at a breakpoint instruction in
+ *   EM0 instead.
+ *
+ * @param[in] buttonPort
+ *   GPIO port of the button, low when pressed.
+ *
+ * @param[in] buttonPin
+ *   GPIO pin of the button.
+ *
+ * @param[in] ledPort
+ *   GPIO port of the LED.
+ *
+ * @param[in] ledPin
+ *   GPIO pin of the LED.
+ ******************************************************************************/
+__STATIC_INLINE void XSERIES_EscapeHatch(GPIO_Port_TypeDef buttonPort,
+                                         unsigned int buttonPin,
+                                         GPIO_Port_TypeDef ledPort,
+                                         unsigned int ledPin)
+{
+  CMU_ClockEnable(cmuClock_GPIO, true);
+  GPIO_PinModeSet(buttonPort, buttonPin, gpioModeInputPullFilter, 1);
+  if (GPIO_PinInGet(buttonPort, buttonPin) == 0) {
+    GPIO_PinModeSet(ledPort, ledPin, gpioModePushPull, 1);
+    __BKPT(0);
+  }
+  GPIO_PinModeSet(buttonPort, buttonPin, gpioModeDisabled, 0);
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+/** @} (end group XSeries) */
+/** @} (end group kitdrv) */
+
+#endif
@@ -0,0 +1,428 @@
+/***************************************************************************//**
+ * @file
+ * @brief Biquad and FIR filter stages over CMSIS-DSP for streamed samples.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2022 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ******************************************************************************/
+
+#include <math.h>
+#include "dspfilter.h"
+
+/***************************************************************************//**
+ * @addtogroup kitdrv
+ * @{
+ ******************************************************************************/
+
+/***************************************************************************//**
+ * @addtogroup DspFilter
+ * @{
+ ******************************************************************************/
+
+/**************************************************************************//**
+ * @brief Whether a design is one the filters can take
+ *****************************************************************************/
+static bool isValid(const DSPFILTER_Init_TypeDef *init, uint32_t minLength,
+                    uint32_t maxLength)
+{
+  if ((init->sampleRate <= 0.0f)
+      || (init->frequency <= 0.0f)
+      || (init->frequency >= (init->sampleRate / 2.0f))
+      || (init->length < minLength)
+      || (init->length > maxLength)) {
+    return false;
+  }
+  if (((init->type == dspFilterBandpass) || (init->type == dspFilterNotch))
+      && (init->q <= 0.0f)) {
+    return false;
+  }
+  return true;
+}
+
+/**************************************************************************//**
+ * @brief Round to Q15, saturated
+ *****************************************************************************/
+static q15_t toQ15(float32_t x)
+{
+  int32_t v = (int32_t)lroundf(x * 32768.0f);
+
+  if (v > 32767) {
+    v = 32767;
+  } else if (v < -32768) {
+    v = -32768;
+  }
+  return (q15_t)v;
+}
+
+/**************************************************************************//**
+ * @brief Design the biquad cascade
+ *
+ * @details
+ *    Second order sections after the Audio EQ Cookbook, normalized by a0
+ *    and stored as {b0, b1, b2, -a1, -a2}, the order and the feedback sign
+ *    CMSIS-DSP takes.
+ *
+ *    A Butterworth of order 2n has its poles evenly spread on a half
+ *    circle; stage k, counting from 1, gets the pair of poles with
+ *    Q = 1 / (2 sin((2k - 1) pi / 4n)), and all stages share the corner.
+ *
+ * @param[out] coeffs
+ *    Five coefficients per stage.
+ *****************************************************************************/
+static void designBiquads(const DSPFILTER_Init_TypeDef *init,
+                          float32_t *coeffs)
+{
+  float32_t w0 = 2.0f * PI * init->frequency / init->sampleRate;
+  float32_t cw = cosf(w0);
+  float32_t sw = sinf(w0);
+  float32_t q, alpha, a0, b0, b1, b2;
+  uint32_t k;
+
+  for (k = 0; k < init->length; k++) {
+    if ((init->type == dspFilterLowpass) || (init->type == dspFilterHighpass)) {
+      q = 1.0f / (2.0f * sinf((float32_t)(2 * k + 1) * PI
+                              / (float32_t)(4 * init->length)));
+    } else {
+      q = init->q;
+    }
+    alpha = sw / (2.0f * q);
+
+    switch (init->type) {
+      case dspFilterLowpass:
+        b0 = (1.0f - cw) / 2.0f;
+        b1 = 1.0f - cw;
+        b2 = b0;
+        break;
+
+      case dspFilterHighpass:
+        b0 = (1.0f + cw) / 2.0f;
+        b1 = -(1.0f + cw);
+        b2 = b0;
+        break;
+
+      case dspFilterBandpass:
+        b0 = alpha;
+        b1 = 0.0f;
+        b2 = -alpha;
+        break;
+
+      default:
+        b0 = 1.0f;
+        b1 = -2.0f * cw;
+        b2 = 1.0f;
+        break;
+    }
+
+    a0 = 1.0f + alpha;
+    coeffs[0] = b0 / a0;
+    coeffs[1] = b1 / a0;
+    coeffs[2] = b2 / a0;
+    coeffs[3] = 2.0f * cw / a0;
+    coeffs[4] = -(1.0f - alpha) / a0;
+    coeffs += 5;
+  }
+}
+
+/**************************************************************************//**
+ * @brief Design the FIR filter
+ *
+ * @details
+ *    Windowed sinc, scaled to a DC gain of 1. The highpass is the lowpass
+ *    subtracted from a unit impulse at the centre tap, so it needs an odd
+ *    number of taps. The taps are symmetric, the time reversed order
+ *    CMSIS-DSP takes is the same.
+ *
+ * @param[out] coeffs
+ *    init->length taps.
+ *****************************************************************************/
+static void designFir(const DSPFILTER_Init_TypeDef *init, float32_t *coeffs)
+{
+  float32_t fc = init->frequency / init->sampleRate;
+  float32_t half = (float32_t)(init->length - 1) / 2.0f;
+  float32_t sum = 0.0f;
+  float32_t x;
+  uint32_t n;
+
+  for (n = 0; n < init->length; n++) {
+    x = (float32_t)n - half;
+    if (x == 0.0f) {
+      coeffs[n] = 2.0f * fc;
+    } else {
+      coeffs[n] = sinf(2.0f * PI * fc * x) / (PI * x);
+    }
+    coeffs[n] *= 0.54f - 0.46f * cosf(2.0f * PI * (float32_t)n / (2.0f * half));
+    sum += coeffs[n];
+  }
+
+  for (n = 0; n < init->length; n++) {
+    coeffs[n] /= sum;
+  }
+
+  if (init->type == dspFilterHighpass) {
+    for (n = 0; n < init->length; n++) {
+      coeffs[n] = -coeffs[n];
+    }
+    coeffs[init->length / 2] += 1.0f;
+  }
+}
+
+/**************************************************************************//**
+ * @brief Whether an FIR design is a response the FIR filters can take
+ *****************************************************************************/
+static bool isFirType(const DSPFILTER_Init_TypeDef *init)
+{
+  return (init->type == dspFilterLowpass)
+         || ((init->type == dspFilterHighpass) && (init->length & 1));
+}
+
+/**************************************************************************//**
+ * @brief Design a float32_t biquad cascade and clear its state
+ *
+ * @param[in] init
+ *    Design, length is the number of stages, 1 to DSPFILTER_MAX_STAGES.
+ *
+ * @return
+ *    false if the design does not fit.
+ *****************************************************************************/
+bool DSPFILTER_BiquadInitF32(DSPFILTER_BiquadF32_TypeDef *filter,
+                             const DSPFILTER_Init_TypeDef *init)
+{
+  if (!isValid(init, 1, DSPFILTER_MAX_STAGES)) {
+    return false;
+  }
+
+  designBiquads(init, filter->coeffs);
+  arm_biquad_cascade_df1_init_f32(&filter->instance, (uint8_t)init->length,
+                                  filter->coeffs, filter->state);
+  return true;
+}
+
+/**************************************************************************//**
+ * @brief Design a q15_t biquad cascade and clear its state
+ *
+ * @details
+ *    Lowpass and highpass feedback coefficients come close to 2, so the
+ *    coefficients are scaled down by the smallest power of 2 that brings
+ *    them all below 1, and CMSIS-DSP shifts the sum back up by as much.
+ *
+ * @param[in] init
+ *    Design, length is the number of stages, 1 to DSPFILTER_MAX_STAGES.
+ *
+ * @return
+ *    false if the design does not fit.
+ *****************************************************************************/
+bool DSPFILTER_BiquadInitQ15(DSPFILTER_BiquadQ15_TypeDef *filter,
+                             const DSPFILTER_Init_TypeDef *init)
+{
+  float32_t coeffs[5 * DSPFILTER_MAX_STAGES];
+  float32_t largest = 0.0f;
+  float32_t scale;
+  uint32_t postShift = 0;
+  uint32_t i, k;
+
+  if (!isValid(init, 1, DSPFILTER_MAX_STAGES)) {
+    return false;
+  }
+
+  designBiquads(init, coeffs);
+
+  for (i = 0; i < 5 * init->length; i++) {
+    if (fabsf(coeffs[i]) > largest) {
+      largest = fabsf(coeffs[i]);
+    }
+  }
+  while (largest >= (float32_t)(1UL << postShift)) {
+    postShift++;
+  }
+  scale = 1.0f / (float32_t)(1UL << postShift);
+
+  // The q15 cascade takes {b0, 0, b1, b2, -a1, -a2} per stage
+  for (k = 0; k < init->length; k++) {
+    filter->coeffs[6 * k + 0] = toQ15(coeffs[5 * k + 0] * scale);
+    filter->coeffs[6 * k + 1] = 0;
+    filter->coeffs[6 * k + 2] = toQ15(coeffs[5 * k + 1] * scale);
+    filter->coeffs[6 * k + 3] = toQ15(coeffs[5 * k + 2] * scale);
+    filter->coeffs[6 * k + 4] = toQ15(coeffs[5 * k + 3] * scale);
+    filter->coeffs[6 * k + 5] = toQ15(coeffs[5 * k + 4] * scale);
+  }
+
+  arm_biquad_cascade_df1_init_q15(&filter->instance, (uint8_t)init->length,
+                                  filter->coeffs, filter->state,
+                                  (int8_t)postShift);
+  return true;
+}
+
+/**************************************************************************//**
+ * @brief Design a float32_t FIR filter and clear its state
+ *
+ * @param[in] init
+ *    Design, lowpass or highpass; length is the number of taps, 3 to
+ *    DSPFILTER_MAX_TAPS, odd for a highpass.
+ *
+ * @return
+ *    false if the design does not fit.
+ *****************************************************************************/
+bool DSPFILTER_FirInitF32(DSPFILTER_FirF32_TypeDef *filter,
+                          const DSPFILTER_Init_TypeDef *init)
+{
+  if (!isValid(init, 3, DSPFILTER_MAX_TAPS) || !isFirType(init)) {
+    return false;
+  }
+
+  designFir(init, filter->coeffs);
+  arm_fir_init_f32(&filter->instance, (uint16_t)init->length,
+                   filter->coeffs, filter->state, DSPFILTER_MAX_BLOCK);
+  return true;
+}
+
+/**************************************************************************//**
+ * @brief Design a q15_t FIR filter and clear its state
+ *
+ * @details
+ *    An odd number of taps gets a zero tap at the end, which leaves the
+ *    response and the delay as they are.
+ *
+ * @param[in] init
+ *    Design, lowpass or highpass; length is the number of taps, 3 to
+ *    DSPFILTER_MAX_TAPS - 1 if odd, odd for a highpass.
+ *
+ * @return
+ *    false if the design does not fit.
+ *****************************************************************************/
+bool DSPFILTER_FirInitQ15(DSPFILTER_FirQ15_TypeDef *filter,
+                          const DSPFILTER_Init_TypeDef *init)
+{
+  float32_t coeffs[DSPFILTER_MAX_TAPS];
+  uint32_t taps = (init->length + 1) & ~(uint32_t)1;
+  uint32_t n;
+
+  if (!isValid(init, 3, DSPFILTER_MAX_TAPS - (init->length & 1))
+      || !isFirType(init)) {
+    return false;
+  }
+
+  designFir(init, coeffs);
+  for (n = 0; n < init->length; n++) {
+    filter->coeffs[n] = toQ15(coeffs[n]);
+  }
+  if (taps != init->length) {
+    filter->coeffs[taps - 1] = 0;
+  }
+
+  return arm_fir_init_q15(&filter->instance, (uint16_t)taps, filter->coeffs,
+                          filter->state, DSPFILTER_MAX_BLOCK) == ARM_MATH_SUCCESS;
+}
+
+/**************************************************************************//**
+ * @brief Filter a block of float32_t samples
+ *
+ * @details
+ *    The state carries over to the next call. The source and destination
+ *    may be the same buffer.
+ *****************************************************************************/
+void DSPFILTER_BiquadF32(DSPFILTER_BiquadF32_TypeDef *filter,
+                         const float32_t *src, float32_t *dst,
+                         uint32_t count)
+{
+  // Older CMSIS-DSP releases take a source pointer that is not const
+  arm_biquad_cascade_df1_f32(&filter->instance, (float32_t *)src, dst, count);
+}
+
+/**************************************************************************//**
+ * @brief Filter a block of q15_t samples
+ *
+ * @details
+ *    The state carries over to the next call. The source and destination
+ *    may be the same buffer.
+ *****************************************************************************/
+void DSPFILTER_BiquadQ15(DSPFILTER_BiquadQ15_TypeDef *filter,
+                         const q15_t *src, q15_t *dst, uint32_t count)
+{
+  arm_biquad_cascade_df1_q15(&filter->instance, (q15_t *)src, dst, count);
+}
+
+/**************************************************************************//**
+ * @brief Filter a block of float32_t samples
+ *
+ * @details
+ *    The state carries over to the next call. Blocks longer than
+ *    DSPFILTER_MAX_BLOCK are filtered in parts. The source and destination
+ *    must not overlap.
+ *****************************************************************************/
+void DSPFILTER_FirF32(DSPFILTER_FirF32_TypeDef *filter,
+                      const float32_t *src, float32_t *dst, uint32_t count)
+{
+  uint32_t n;
+
+  while (count > 0) {
+    n = (count < DSPFILTER_MAX_BLOCK) ? count : DSPFILTER_MAX_BLOCK;
+    arm_fir_f32(&filter->instance, (float32_t *)src, dst, n);
+    src += n;
+    dst += n;
+    count -= n;
+  }
+}
+
+/**************************************************************************//**
+ * @brief Filter a block of q15_t samples
+ *
+ * @details
+ *    The state carries over to the next call. Blocks longer than
+ *    DSPFILTER_MAX_BLOCK are filtered in parts. The source and destination
+ *    must not overlap.
+ *****************************************************************************/
+void DSPFILTER_FirQ15(DSPFILTER_FirQ15_TypeDef *filter,
+                      const q15_t *src, q15_t *dst, uint32_t count)
+{
+  uint32_t n;
+
+  while (count > 0) {
+    n = (count < DSPFILTER_MAX_BLOCK) ? count : DSPFILTER_MAX_BLOCK;
+    arm_fir_q15(&filter->instance, (q15_t *)src, dst, n);
+    src += n;
+    dst += n;
+    count -= n;
+  }
+}
+
+/**************************************************************************//**
+ * @brief Scale unsigned 12 bit results, such as from the IADC, to Q15
+ *
+ * @details
+ *    Mid scale becomes 0 and full scale 32752. The source and destination
+ *    may be the same buffer.
+ *****************************************************************************/
+void DSPFILTER_Unsigned12ToQ15(const uint16_t *src, q15_t *dst,
+                               uint32_t count)
+{
+  uint32_t i;
+
+  for (i = 0; i < count; i++) {
+    dst[i] = (q15_t)(((int32_t)(src[i] & 0xFFF) - 2048) * 16);
+  }
+}
+
+/** @} (end group DspFilter) */
+/** @} (end group kitdrv) */
@@ -0,0 +1,171 @@
+/***************************************************************************//**
+ * @file
+ * @brief Biquad and FIR filter stages over CMSIS-DSP for streamed samples.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2022 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ******************************************************************************/
+
+#ifndef __DSPFILTER_H
+#define __DSPFILTER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "arm_math.h"
+
+/***************************************************************************//**
+ * @addtogroup kitdrv
+ * @{
+ ******************************************************************************/
+
+/***************************************************************************//**
+ * @addtogroup DspFilter
+ * @brief Biquad and FIR filter stages over CMSIS-DSP for streamed samples
+ * @details
+ *    Each filter bundles a CMSIS-DSP instance with its coefficients and its
+ *    state, so a filter is one static variable. The state carries over from
+ *    one call to the next, and a stream filtered one block at a time, such
+ *    as each half of an LDMA ping-pong ring, comes out the same as if it
+ *    had been filtered in one go.
+ *
+ *    The coefficients are designed at init from the sample rate and the
+ *    corner frequency, so they follow the SAMPLEFREQ of the example rather
+ *    than being worked out offline:
+ *    - Biquads cascade up to DSPFILTER_MAX_STAGES second order sections,
+ *      Direct Form I. A lowpass or highpass of n stages is a Butterworth of
+ *      order 2n; bandpass and notch stages all use the same centre and Q.
+ *    - FIR filters are windowed sinc lowpass or highpass, Hamming window,
+ *      with unity gain in the passband. The delay is (taps - 1) / 2
+ *      samples. A highpass needs an odd number of taps; the q15 filter
+ *      pads an odd number with a zero tap, as CMSIS-DSP wants it even.
+ *
+ *    Both come in float32_t and q15_t. The f32 filters are for parts with
+ *    an FPU and samples that have been scaled already; the q15 filters run
+ *    on 16 bit samples such as IADC or PDM results with the DSP extension,
+ *    with saturating arithmetic and coefficients scaled into Q15 with a
+ *    postShift. Biquad corners below about a hundredth of the sample rate
+ *    are better run in f32: their poles sit so close to the unit circle
+ *    that q15 coefficients move them noticeably.
+ * @{
+ ******************************************************************************/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Second order sections of a biquad cascade */
+#ifndef DSPFILTER_MAX_STAGES
+#define DSPFILTER_MAX_STAGES    4
+#endif
+
+/** Taps of an FIR filter */
+#ifndef DSPFILTER_MAX_TAPS
+#define DSPFILTER_MAX_TAPS      64
+#endif
+
+/** Samples processed by one FIR call, sizes the FIR state */
+#ifndef DSPFILTER_MAX_BLOCK
+#define DSPFILTER_MAX_BLOCK     256
+#endif
+
+#if (DSPFILTER_MAX_TAPS < 4) || (DSPFILTER_MAX_TAPS & 1)
+#error "DSPFILTER_MAX_TAPS must be even and at least 4"
+#endif
+
+/** Filter responses */
+typedef enum {
+  dspFilterLowpass,
+  dspFilterHighpass,
+  dspFilterBandpass,      /**< Biquad only, 0 dB at the centre */
+  dspFilterNotch,         /**< Biquad only */
+} DSPFILTER_Type_TypeDef;
+
+/** Filter design */
+typedef struct {
+  DSPFILTER_Type_TypeDef type;
+  float32_t sampleRate;   /**< Sample rate of the stream, Hz */
+  float32_t frequency;    /**< Corner or centre, below sampleRate / 2, Hz */
+  float32_t q;            /**< Bandpass and notch stages, ignored otherwise */
+  uint32_t  length;       /**< Biquad stages, or FIR taps */
+} DSPFILTER_Init_TypeDef;
+
+/** Biquad cascade, float32_t */
+typedef struct {
+  arm_biquad_casd_df1_inst_f32 instance;
+  float32_t coeffs[5 * DSPFILTER_MAX_STAGES];
+  float32_t state[4 * DSPFILTER_MAX_STAGES];
+} DSPFILTER_BiquadF32_TypeDef;
+
+/** Biquad cascade, q15_t */
+typedef struct {
+  arm_biquad_casd_df1_inst_q15 instance;
+  q15_t coeffs[6 * DSPFILTER_MAX_STAGES];
+  q15_t state[4 * DSPFILTER_MAX_STAGES];
+} DSPFILTER_BiquadQ15_TypeDef;
+
+/** FIR filter, float32_t */
+typedef struct {
+  arm_fir_instance_f32 instance;
+  float32_t coeffs[DSPFILTER_MAX_TAPS];
+  float32_t state[DSPFILTER_MAX_TAPS + DSPFILTER_MAX_BLOCK - 1];
+} DSPFILTER_FirF32_TypeDef;
+
+/** FIR filter, q15_t */
+typedef struct {
+  arm_fir_instance_q15 instance;
+  q15_t coeffs[DSPFILTER_MAX_TAPS];
+  q15_t state[DSPFILTER_MAX_TAPS + DSPFILTER_MAX_BLOCK];
+} DSPFILTER_FirQ15_TypeDef;
+
+bool DSPFILTER_BiquadInitF32(DSPFILTER_BiquadF32_TypeDef *filter,
+                             const DSPFILTER_Init_TypeDef *init);
+bool DSPFILTER_BiquadInitQ15(DSPFILTER_BiquadQ15_TypeDef *filter,
+                             const DSPFILTER_Init_TypeDef *init);
+bool DSPFILTER_FirInitF32(DSPFILTER_FirF32_TypeDef *filter,
+                          const DSPFILTER_Init_TypeDef *init);
+bool DSPFILTER_FirInitQ15(DSPFILTER_FirQ15_TypeDef *filter,
+                          const DSPFILTER_Init_TypeDef *init);
+
+void DSPFILTER_BiquadF32(DSPFILTER_BiquadF32_TypeDef *filter,
+                         const float32_t *src, float32_t *dst,
+                         uint32_t count);
+void DSPFILTER_BiquadQ15(DSPFILTER_BiquadQ15_TypeDef *filter,
+                         const q15_t *src, q15_t *dst, uint32_t count);
+void DSPFILTER_FirF32(DSPFILTER_FirF32_TypeDef *filter,
+                      const float32_t *src, float32_t *dst, uint32_t count);
+void DSPFILTER_FirQ15(DSPFILTER_FirQ15_TypeDef *filter,
+                      const q15_t *src, q15_t *dst, uint32_t count);
+
+void DSPFILTER_Unsigned12ToQ15(const uint16_t *src, q15_t *dst,
+                               uint32_t count);
+
+#ifdef __cplusplus
+}
+#endif
+
+/** @} (end group DspFilter) */
+/** @} (end group kitdrv) */
+
+#endif
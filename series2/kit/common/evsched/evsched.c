@@ -0,0 +1,359 @@
+/***************************************************************************//**
+ * @file
+ * @brief Run to completion event scheduler with energy mode selection when idle.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2022 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ******************************************************************************/
+
+#include "em_core.h"
+#include "em_emu.h"
+#include "evsched.h"
+
+/***************************************************************************//**
+ * @addtogroup kitdrv
+ * @{
+ ******************************************************************************/
+
+/***************************************************************************//**
+ * @addtogroup EvSched
+ * @{
+ ******************************************************************************/
+
+#define QUEUE_MASK      (EVSCHED_QUEUE_SIZE - 1)
+
+typedef struct {
+  uint32_t event;
+  uint32_t data;
+} Entry_t;
+
+// Head counts the slots claimed by EVSCHED_Post(), tail the slots freed by
+// EVSCHED_Dispatch(); both run freely and wrap at 2^32.
+typedef struct {
+  Entry_t entry[EVSCHED_QUEUE_SIZE];
+  volatile uint32_t head;
+  volatile uint32_t tail;
+} Queue_t;
+
+static Queue_t queues[EVSCHED_PRIORITIES];
+
+static EVSCHED_Handler_t handlers[EVSCHED_MAX_EVENTS];
+static uint8_t priorities[EVSCHED_MAX_EVENTS];
+
+// Number of locks on each energy mode, indexed by the mode
+static volatile uint32_t locks[4];
+
+static volatile EVSCHED_Counters_TypeDef counters;
+
+/**************************************************************************//**
+ * @brief Claim the next slot of a queue
+ *
+ * @return
+ *    false if the queue is full.
+ *****************************************************************************/
+static bool claimSlot(Queue_t *queue, uint32_t *slot)
+{
+#if (__CORTEX_M >= 3U)
+  uint32_t head;
+
+  do {
+    head = __LDREXW(&queue->head);
+    if ((head - queue->tail) >= EVSCHED_QUEUE_SIZE) {
+      __CLREX();
+      return false;
+    }
+  } while (__STREXW(head + 1, &queue->head) != 0);
+
+  *slot = head;
+  return true;
+#else
+  bool claimed = false;
+  CORE_DECLARE_IRQ_STATE;
+
+  CORE_ENTER_ATOMIC();
+  if ((queue->head - queue->tail) < EVSCHED_QUEUE_SIZE) {
+    *slot = queue->head++;
+    claimed = true;
+  }
+  CORE_EXIT_ATOMIC();
+
+  return claimed;
+#endif
+}
+
+/**************************************************************************//**
+ * @brief Add one to a counter that interrupts of any priority update
+ *****************************************************************************/
+static void increment(volatile uint32_t *counter)
+{
+#if (__CORTEX_M >= 3U)
+  uint32_t value;
+
+  do {
+    value = __LDREXW(counter);
+  } while (__STREXW(value + 1, counter) != 0);
+#else
+  CORE_DECLARE_IRQ_STATE;
+
+  CORE_ENTER_ATOMIC();
+  (*counter)++;
+  CORE_EXIT_ATOMIC();
+#endif
+}
+
+/**************************************************************************//**
+ * @brief Whether every queue is empty
+ *****************************************************************************/
+static bool isIdle(void)
+{
+  uint32_t p;
+
+  for (p = 0; p < EVSCHED_PRIORITIES; p++) {
+    if (queues[p].head != queues[p].tail) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/**************************************************************************//**
+ * @brief Deepest energy mode no driver has locked out
+ *****************************************************************************/
+static uint32_t deepestMode(void)
+{
+  uint32_t mode = EVSCHED_DEEPEST_EM;
+
+  if ((mode >= 3) && (locks[3] > 0)) {
+    mode = 2;
+  }
+  if ((mode >= 2) && (locks[2] > 0)) {
+    mode = 1;
+  }
+  return mode;
+}
+
+/**************************************************************************//**
+ * @brief Empty the queues and forget every handler and lock
+ *
+ * @details
+ *    Call once before registering handlers and enabling the interrupts
+ *    that post events.
+ *****************************************************************************/
+void EVSCHED_Init(void)
+{
+  uint32_t i;
+
+  for (i = 0; i < EVSCHED_PRIORITIES; i++) {
+    queues[i].head = 0;
+    queues[i].tail = 0;
+  }
+  for (i = 0; i < EVSCHED_MAX_EVENTS; i++) {
+    handlers[i] = NULL;
+    priorities[i] = 0;
+  }
+  for (i = 0; i < 4; i++) {
+    locks[i] = 0;
+    counters.sleeps[i] = 0;
+  }
+  counters.posted = 0;
+  counters.dispatched = 0;
+  counters.dropped = 0;
+}
+
+/**************************************************************************//**
+ * @brief Set the handler and the priority of an event
+ *
+ * @details
+ *    Register each event before it can be posted.
+ *
+ * @param[in] event
+ *    Event number, below EVSCHED_MAX_EVENTS.
+ *
+ * @param[in] priority
+ *    Queue of the event, 0 the highest, below EVSCHED_PRIORITIES.
+ *
+ * @return
+ *    false if the event or the priority is out of range.
+ *****************************************************************************/
+bool EVSCHED_Register(uint32_t event, uint32_t priority,
+                      EVSCHED_Handler_t handler)
+{
+  if ((event >= EVSCHED_MAX_EVENTS) || (priority >= EVSCHED_PRIORITIES)) {
+    return false;
+  }
+
+  priorities[event] = (uint8_t)priority;
+  handlers[event] = handler;
+  return true;
+}
+
+/**************************************************************************//**
+ * @brief Queue an event for its handler
+ *
+ * @details
+ *    May be called from interrupts of any priority and from handlers.
+ *    The handler runs later in thread mode, from EVSCHED_Run().
+ *
+ * @param[in] data
+ *    Passed to the handler, such as the buffer just filled.
+ *
+ * @return
+ *    false if the event has no handler or its queue is full; the event is
+ *    then dropped.
+ *****************************************************************************/
+bool EVSCHED_Post(uint32_t event, uint32_t data)
+{
+  Queue_t *queue;
+  uint32_t slot;
+
+  if ((event >= EVSCHED_MAX_EVENTS) || (handlers[event] == NULL)) {
+    return false;
+  }
+
+  queue = &queues[priorities[event]];
+  if (!claimSlot(queue, &slot)) {
+    increment(&counters.dropped);
+    return false;
+  }
+
+  queue->entry[slot & QUEUE_MASK].event = event;
+  queue->entry[slot & QUEUE_MASK].data = data;
+  increment(&counters.posted);
+
+  return true;
+}
+
+/**************************************************************************//**
+ * @brief Run the handler of the oldest event of the highest priority
+ *
+ * @details
+ *    Thread mode only. The slot is freed before the handler runs, so the
+ *    handler may post again, also to its own queue.
+ *
+ * @return
+ *    false if every queue was empty.
+ *****************************************************************************/
+bool EVSCHED_Dispatch(void)
+{
+  Queue_t *queue;
+  Entry_t entry;
+  uint32_t p, tail;
+
+  for (p = 0; p < EVSCHED_PRIORITIES; p++) {
+    queue = &queues[p];
+    tail = queue->tail;
+    if (tail != queue->head) {
+      // Read the entry only after seeing the head that covers it
+      __DMB();
+      entry = queue->entry[tail & QUEUE_MASK];
+      queue->tail = tail + 1;
+
+      counters.dispatched++;
+      handlers[entry.event](entry.data);
+      return true;
+    }
+  }
+  return false;
+}
+
+/**************************************************************************//**
+ * @brief Run handlers and sleep when there are none, never returns
+ *
+ * @details
+ *    Takes the place of the main loop. The queues are checked again with
+ *    interrupts masked before each sleep; an interrupt pending at that
+ *    point ends the sleep at once, and the core only takes it after
+ *    waking, as with the while(1) loops this replaces.
+ *****************************************************************************/
+void EVSCHED_Run(void)
+{
+  uint32_t mode;
+  CORE_DECLARE_IRQ_STATE;
+
+  while (1) {
+    if (EVSCHED_Dispatch()) {
+      continue;
+    }
+
+    CORE_ENTER_CRITICAL();
+    if (isIdle()) {
+      mode = deepestMode();
+      counters.sleeps[mode]++;
+      if (mode == 1) {
+        EMU_EnterEM1();
+      } else if (mode == 2) {
+        EMU_EnterEM2(true);
+      } else {
+        EMU_EnterEM3(true);
+      }
+    }
+    CORE_EXIT_CRITICAL();
+  }
+}
+
+/**************************************************************************//**
+ * @brief Keep the scheduler out of an energy mode and those below it
+ *
+ * @details
+ *    A driver locks out the modes it can not run in while it is active,
+ *    such as evschedEM2 while a transfer needs the HF clocks, and unlocks
+ *    them when done. Locks count, every lock needs its unlock.
+ *****************************************************************************/
+void EVSCHED_EnergyModeLock(EVSCHED_EnergyMode_TypeDef mode)
+{
+  increment(&locks[mode]);
+}
+
+/**************************************************************************//**
+ * @brief Undo one EVSCHED_EnergyModeLock() of the same mode
+ *****************************************************************************/
+void EVSCHED_EnergyModeUnlock(EVSCHED_EnergyMode_TypeDef mode)
+{
+  CORE_DECLARE_IRQ_STATE;
+
+  CORE_ENTER_ATOMIC();
+  if (locks[mode] > 0) {
+    locks[mode]--;
+  }
+  CORE_EXIT_ATOMIC();
+}
+
+/**************************************************************************//**
+ * @brief Copy the counters
+ *****************************************************************************/
+void EVSCHED_GetCounters(EVSCHED_Counters_TypeDef *copy)
+{
+  uint32_t i;
+
+  copy->posted = counters.posted;
+  copy->dispatched = counters.dispatched;
+  copy->dropped = counters.dropped;
+  for (i = 0; i < 4; i++) {
+    copy->sleeps[i] = counters.sleeps[i];
+  }
+}
+
+/** @} (end group EvSched) */
+/** @} (end group kitdrv) */
@@ -0,0 +1,143 @@
+/***************************************************************************//**
+ * @file
+ * @brief Run to completion event scheduler with energy mode selection when idle.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2022 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ******************************************************************************/
+
+#ifndef __EVSCHED_H
+#define __EVSCHED_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "em_device.h"
+
+/***************************************************************************//**
+ * @addtogroup kitdrv
+ * @{
+ ******************************************************************************/
+
+/***************************************************************************//**
+ * @addtogroup EvSched
+ * @brief Run to completion event scheduler with energy mode selection when idle
+ * @details
+ *    Replaces the while(1) { EMU_EnterEM1(); ... } loop and the flags it
+ *    polls. Interrupt handlers post an event, a number with a 32 bit data
+ *    word, and return; EVSCHED_Run() calls the handler of each event in
+ *    thread mode, one at a time and each to completion, so handlers never
+ *    preempt each other and need no locking between them. Several drivers
+ *    in one application each get their events in the order they posted
+ *    them, and no driver has to know about the sleep of the others.
+ *
+ *    Each event is registered with a priority, 0 the highest, and each
+ *    priority has its own queue. The scheduler always runs the oldest
+ *    event of the highest priority queue that is not empty, so a burst of
+ *    low priority work holds up a high priority event for at most one
+ *    handler. Within a queue, events run in the order they were posted.
+ *
+ *    EVSCHED_Post() takes no lock: on Cortex-M3, M4 and M33 parts it
+ *    claims a queue slot with LDREX/STREX, so interrupts stay enabled and
+ *    one of any priority may post while another is posting. Handlers only
+ *    run in thread mode, after every interrupt that claimed a slot has
+ *    filled it. Cortex-M0+ parts have no exclusive access and claim the
+ *    slot with interrupts masked for a few cycles. A full queue drops the
+ *    event and counts it.
+ *
+ *    With every queue empty the scheduler sleeps in the deepest energy
+ *    mode that no driver has locked out with EVSCHED_EnergyModeLock(),
+ *    down to EVSCHED_DEEPEST_EM. The queues are checked with interrupts
+ *    masked just before, so an event posted at that moment wakes the core
+ *    at once rather than after the next interrupt.
+ * @{
+ ******************************************************************************/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Event numbers, 0 to EVSCHED_MAX_EVENTS - 1 */
+#ifndef EVSCHED_MAX_EVENTS
+#define EVSCHED_MAX_EVENTS      16
+#endif
+
+/** Priorities, each with a queue; 0 is the highest */
+#ifndef EVSCHED_PRIORITIES
+#define EVSCHED_PRIORITIES      3
+#endif
+
+/** Events each queue holds, a power of 2 */
+#ifndef EVSCHED_QUEUE_SIZE
+#define EVSCHED_QUEUE_SIZE      16
+#endif
+
+/** Deepest energy mode the scheduler sleeps in, 1 to 3 */
+#ifndef EVSCHED_DEEPEST_EM
+#define EVSCHED_DEEPEST_EM      2
+#endif
+
+#if (EVSCHED_QUEUE_SIZE & (EVSCHED_QUEUE_SIZE - 1)) != 0
+#error "EVSCHED_QUEUE_SIZE must be a power of 2"
+#endif
+
+#if (EVSCHED_DEEPEST_EM < 1) || (EVSCHED_DEEPEST_EM > 3)
+#error "EVSCHED_DEEPEST_EM must be 1 to 3"
+#endif
+
+/** Energy modes a driver can lock out */
+typedef enum {
+  evschedEM2 = 2,           /**< Lock out EM2 and deeper, sleep in EM1 */
+  evschedEM3 = 3,           /**< Lock out EM3, sleep in EM2 at most */
+} EVSCHED_EnergyMode_TypeDef;
+
+/** Called in thread mode for each posted event */
+typedef void (*EVSCHED_Handler_t)(uint32_t data);
+
+/** Counters, all only ever count up */
+typedef struct {
+  uint32_t posted;          /**< Events queued */
+  uint32_t dispatched;      /**< Handlers run */
+  uint32_t dropped;         /**< Events lost to a full queue */
+  uint32_t sleeps[4];       /**< Sleeps in EM1 to EM3, index 1 to 3 */
+} EVSCHED_Counters_TypeDef;
+
+void EVSCHED_Init(void);
+bool EVSCHED_Register(uint32_t event, uint32_t priority,
+                      EVSCHED_Handler_t handler);
+bool EVSCHED_Post(uint32_t event, uint32_t data);
+bool EVSCHED_Dispatch(void);
+void EVSCHED_Run(void);
+void EVSCHED_EnergyModeLock(EVSCHED_EnergyMode_TypeDef mode);
+void EVSCHED_EnergyModeUnlock(EVSCHED_EnergyMode_TypeDef mode);
+void EVSCHED_GetCounters(EVSCHED_Counters_TypeDef *counters);
+
+#ifdef __cplusplus
+}
+#endif
+
+/** @} (end group EvSched) */
+/** @} (end group kitdrv) */
+
+#endif
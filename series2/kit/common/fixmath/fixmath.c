@@ -0,0 +1,411 @@
+/***************************************************************************//**
+ * @file
+ * @brief Fixed-point math kernels for parts with and without an FPU or DSP.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2022 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ******************************************************************************/
+
+#include <string.h>
+#include "fixmath.h"
+
+/***************************************************************************//**
+ * @addtogroup kitdrv
+ * @{
+ ******************************************************************************/
+
+/***************************************************************************//**
+ * @addtogroup FixMath
+ * @{
+ ******************************************************************************/
+
+#if (__CORTEX_M < 3U)
+// CORDIC rotation angles atan(2^-i), binary angles with 8 more bits
+static const int32_t cordicAngle[16] = {
+  2097152, 1238021, 654136, 332050, 166669, 83416, 41718, 20860,
+  10430, 5215, 2608, 1304, 652, 326, 163, 81
+};
+#else
+// atan(r) = r * (c0 + c1 r^2 + c2 r^4 + c3 r^6 + c4 r^8), |r| <= 1, within
+// 1e-5 rad; Q15, highest power first
+static const int32_t atanPoly[5] = { 683, -2790, 5903, -10823, 32764 };
+
+// 2^16 / pi, radians in Q15 to binary angles in Q16
+#define RAD_TO_ANGLE        20861
+#endif
+
+/**************************************************************************//**
+ * @brief Floor of a * b / 2^31, the full Q31 product
+ *****************************************************************************/
+static int64_t productQ31(int32_t a, int32_t b)
+{
+#if (__CORTEX_M >= 3U)
+  // One SMULL
+  return ((int64_t)a * b) >> 31;
+#else
+  // No 64 bit multiply, four 16 x 16 products instead of the library call
+  int32_t ah = a >> 16, bh = b >> 16;
+  uint32_t al = (uint32_t)a & 0xFFFF, bl = (uint32_t)b & 0xFFFF;
+  int32_t hi = ah * bh;
+  int32_t m1 = ah * (int32_t)bl;
+  int32_t m2 = (int32_t)al * bh;
+  int32_t c = (int32_t)((al * bl) >> 16);
+  int32_t mid;
+
+  // (m1 + m2 + c) / 2 without overflow, then the other 14 bits
+  mid = (m1 >> 1) + (m2 >> 1) + (c >> 1) + (((m1 & 1) + (m2 & 1) + (c & 1)) >> 1);
+  return ((int64_t)hi * 2) + (mid >> 14);
+#endif
+}
+
+/**************************************************************************//**
+ * @brief Multiply two Q31 numbers, saturating -1 * -1 to the largest Q31
+ *****************************************************************************/
+int32_t FIXMATH_MulQ31(int32_t a, int32_t b)
+{
+  int64_t p = productQ31(a, b);
+
+  return (p > INT32_MAX) ? INT32_MAX : (int32_t)p;
+}
+
+/**************************************************************************//**
+ * @brief Dot product of two Q15 vectors
+ * @return Sum of the products in Q30, with 33 bits of headroom
+ *****************************************************************************/
+int64_t FIXMATH_DotQ15(const int16_t *a, const int16_t *b, uint32_t n)
+{
+  int64_t sum = 0;
+
+#if defined(__ARM_FEATURE_DSP) && (__ARM_FEATURE_DSP == 1)
+  uint32_t x, y;
+
+  // Two products a step; the loads may be unaligned on these cores
+  while (n >= 2) {
+    memcpy(&x, a, sizeof(x));
+    memcpy(&y, b, sizeof(y));
+    sum = (int64_t)__SMLALD(x, y, (uint64_t)sum);
+    a += 2;
+    b += 2;
+    n -= 2;
+  }
+#endif
+
+  while (n > 0) {
+    sum += (int32_t)*a++ * *b++;
+    n--;
+  }
+  return sum;
+}
+
+/**************************************************************************//**
+ * @brief Dot product of two Q31 vectors
+ * @return Sum of the products in Q31, with 32 bits of headroom
+ *****************************************************************************/
+int64_t FIXMATH_DotQ31(const int32_t *a, const int32_t *b, uint32_t n)
+{
+  int64_t sum = 0;
+
+  while (n > 0) {
+    sum += productQ31(*a++, *b++);
+    n--;
+  }
+  return sum;
+}
+
+/**************************************************************************//**
+ * @brief Angle of the vector (x, y)
+ * @details
+ *   Within 2 of 65536 of a turn, 0.011 degrees, over the whole circle;
+ *   atan2(0, 0) is 0. Only the ratio of y and x counts, so they can be in
+ *   any unit, counts, Q15 or Q31.
+ * @return Binary angle, -32768 to 32767 for -pi to just below pi
+ *****************************************************************************/
+int16_t FIXMATH_Atan2(int32_t y, int32_t x)
+{
+#if (__CORTEX_M < 3U)
+  // Vectoring CORDIC: rotate (x, y) onto the x axis by +-atan(2^-i) steps
+  int32_t angle = 0, t;
+  uint32_t ax, ay, m;
+  int i, shift = 0;
+
+  if ((x == 0) && (y == 0)) {
+    return 0;
+  }
+
+  // Scale to 2^27 to 2^28, room for the CORDIC gain of 1.65
+  ax = (x < 0) ? -(uint32_t)x : (uint32_t)x;
+  ay = (y < 0) ? -(uint32_t)y : (uint32_t)y;
+  m = ax | ay;
+  while (m >= (1UL << 28)) {
+    m >>= 1;
+    shift--;
+  }
+  for (i = 16; i > 0; i >>= 1) {
+    if (m < (1UL << (28 - i))) {
+      m <<= i;
+      shift += i;
+    }
+  }
+  if (shift < 0) {
+    x >>= -shift;
+    y >>= -shift;
+  } else {
+    x = (int32_t)((uint32_t)x << shift);
+    y = (int32_t)((uint32_t)y << shift);
+  }
+
+  // Into the right half plane first, the CORDIC covers +-99 degrees
+  if (x < 0) {
+    t = x;
+    if (y >= 0) {
+      x = y;
+      y = -t;
+      angle = 16384L << 8;
+    } else {
+      x = -y;
+      y = t;
+      angle = -(16384L << 8);
+    }
+  }
+
+  for (i = 0; i < 16; i++) {
+    t = x;
+    if (y > 0) {
+      x += y >> i;
+      y -= t >> i;
+      angle += cordicAngle[i];
+    } else {
+      x -= y >> i;
+      y += t >> i;
+      angle -= cordicAngle[i];
+    }
+  }
+
+  return (int16_t)(uint16_t)((angle + 128) >> 8);
+#else
+  // Division and polynomial in the first octant, then mirrored
+  uint32_t ax, ay, lo, hi, r, z;
+  int32_t p, angle;
+  int i, shift;
+
+  if ((x == 0) && (y == 0)) {
+    return 0;
+  }
+
+  ax = (x < 0) ? -(uint32_t)x : (uint32_t)x;
+  ay = (y < 0) ? -(uint32_t)y : (uint32_t)y;
+  lo = (ax < ay) ? ax : ay;
+  hi = (ax < ay) ? ay : ax;
+
+  // Both below 2^16 so the Q15 ratio fits a 32 bit division
+  shift = 16 - (int)__CLZ(hi);
+  if (shift > 0) {
+    lo >>= shift;
+    hi >>= shift;
+  }
+  r = (lo << 15) / hi;
+  z = (r * r) >> 15;
+
+  p = atanPoly[0];
+  for (i = 1; i < 5; i++) {
+    p = ((p * (int32_t)z) >> 15) + atanPoly[i];
+  }
+
+  // Radians in Q15 to binary angles, 0 to 8192
+  angle = (int32_t)(((((int64_t)p * (int32_t)r) >> 15) * RAD_TO_ANGLE + 32768) >> 16);
+
+  if (ay > ax) {
+    angle = 16384 - angle;
+  }
+  if (x < 0) {
+    angle = 32768 - angle;
+  }
+  if (y < 0) {
+    angle = -angle;
+  }
+  return (int16_t)(uint16_t)angle;
+#endif
+}
+
+/**************************************************************************//**
+ * @brief Integer square root, rounded down
+ *****************************************************************************/
+uint16_t FIXMATH_Sqrt32(uint32_t x)
+{
+#if (__CORTEX_M < 3U)
+  // A bit of the root per step, shifts and subtracts only
+  uint32_t root = 0, bit = 1UL << 30;
+
+  while (bit > x) {
+    bit >>= 2;
+  }
+  while (bit != 0) {
+    if (x >= root + bit) {
+      x -= root + bit;
+      root = (root >> 1) + bit;
+    } else {
+      root >>= 1;
+    }
+    bit >>= 2;
+  }
+  return (uint16_t)root;
+#else
+  // Newton steps down from a power of two above the root
+  uint32_t root, next;
+
+  if (x == 0) {
+    return 0;
+  }
+  root = 1UL << ((33 - __CLZ(x)) / 2);
+  next = (root + (x / root)) / 2;
+  while (next < root) {
+    root = next;
+    next = (root + (x / root)) / 2;
+  }
+  return (uint16_t)root;
+#endif
+}
+
+/**************************************************************************//**
+ * @brief Set a moving average up over a ring
+ * @param[in] ring Ring of @p length samples, kept by the filter
+ * @param[in] length Samples averaged, a power of two up to
+ *   FIXMATH_MAX_AVERAGE; length times the largest sample must fit 31 bits
+ * @return false if the length is not a power of two or too long
+ *****************************************************************************/
+bool FIXMATH_AverageInit(FIXMATH_Average_t *avg, int32_t *ring, uint32_t length)
+{
+  uint32_t shift = 0;
+
+  if ((length == 0) || (length > FIXMATH_MAX_AVERAGE)
+      || (length & (length - 1))) {
+    return false;
+  }
+  while ((1UL << shift) < length) {
+    shift++;
+  }
+
+  avg->ring   = ring;
+  avg->length = length;
+  avg->shift  = shift;
+  avg->index  = 0;
+  avg->sum    = 0;
+  avg->primed = false;
+  return true;
+}
+
+/**************************************************************************//**
+ * @brief Add a sample to a moving average
+ * @return Average of the last length samples, rounded
+ *****************************************************************************/
+int32_t FIXMATH_AverageAdd(FIXMATH_Average_t *avg, int32_t sample)
+{
+  uint32_t i;
+
+  if (!avg->primed) {
+    for (i = 0; i < avg->length; i++) {
+      avg->ring[i] = sample;
+    }
+    avg->sum = sample * (int32_t)avg->length;
+    avg->primed = true;
+  }
+
+  avg->sum += sample - avg->ring[avg->index];
+  avg->ring[avg->index] = sample;
+  avg->index = (avg->index + 1) & (avg->length - 1);
+
+  return (avg->sum + (int32_t)(avg->length >> 1)) >> avg->shift;
+}
+
+/**************************************************************************//**
+ * @brief Set a moving median up over a ring
+ * @param[in] ring Ring of @p length samples, kept by the filter
+ * @param[in] sorted Another @p length samples, kept by the filter
+ * @param[in] length Samples, odd, up to FIXMATH_MAX_MEDIAN
+ * @return false if the length is even or too long
+ *****************************************************************************/
+bool FIXMATH_MedianInit(FIXMATH_Median_t *med, int32_t *ring, int32_t *sorted,
+                        uint32_t length)
+{
+  if (((length & 1) == 0) || (length > FIXMATH_MAX_MEDIAN)) {
+    return false;
+  }
+
+  med->ring   = ring;
+  med->sorted = sorted;
+  med->length = length;
+  med->index  = 0;
+  med->primed = false;
+  return true;
+}
+
+/**************************************************************************//**
+ * @brief Add a sample to a moving median
+ * @details
+ *   The oldest sample leaves the sorted copy and the new one moves into
+ *   its place, in one pass over at most length samples.
+ * @return Median of the last length samples
+ *****************************************************************************/
+int32_t FIXMATH_MedianAdd(FIXMATH_Median_t *med, int32_t sample)
+{
+  int32_t *sorted = med->sorted;
+  int32_t old;
+  uint32_t i;
+
+  if (!med->primed) {
+    for (i = 0; i < med->length; i++) {
+      med->ring[i] = sample;
+      sorted[i] = sample;
+    }
+    med->primed = true;
+  }
+
+  old = med->ring[med->index];
+  med->ring[med->index] = sample;
+  med->index = (med->index + 1 == med->length) ? 0 : med->index + 1;
+
+  // Where the oldest sample is, the new one takes its slot and moves on
+  i = 0;
+  while (sorted[i] != old) {
+    i++;
+  }
+  if (sample > old) {
+    while ((i + 1 < med->length) && (sorted[i + 1] < sample)) {
+      sorted[i] = sorted[i + 1];
+      i++;
+    }
+  } else {
+    while ((i > 0) && (sorted[i - 1] > sample)) {
+      sorted[i] = sorted[i - 1];
+      i--;
+    }
+  }
+  sorted[i] = sample;
+
+  return sorted[med->length / 2];
+}
+
+/** @} (end group FixMath) */
+/** @} (end group kitdrv) */
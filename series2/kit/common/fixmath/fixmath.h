@@ -0,0 +1,160 @@
+/***************************************************************************//**
+ * @file
+ * @brief Fixed-point math kernels for parts with and without an FPU or DSP.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2022 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ******************************************************************************/
+
+#ifndef __FIXMATH_H
+#define __FIXMATH_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "em_device.h"
+
+/***************************************************************************//**
+ * @addtogroup kitdrv
+ * @{
+ ******************************************************************************/
+
+/***************************************************************************//**
+ * @addtogroup FixMath
+ * @brief Fixed-point math kernels for parts with and without an FPU or DSP
+ * @details
+ *    Q15 and Q31 multiplies and dot products, atan2 and square roots, and
+ *    moving average and median filters over ring buffers, in integer
+ *    arithmetic only. CMSIS-DSP float kernels are emulated in software on
+ *    the Cortex-M0+ and Cortex-M3 parts, and its fixed-point kernels are
+ *    written for the DSP extension; these are written for each core:
+ *    - Cortex-M0+ (EFM32HG, EFM32ZG) has no divide, no 64 bit multiply and
+ *      no saturation: nothing here divides, the Q31 multiply is built from
+ *      16 bit partial products, atan2 is a shift and add CORDIC and the
+ *      square root takes a bit per step.
+ *    - Cortex-M3 and up have a divide, CLZ and SSAT: atan2 is a division
+ *      and a polynomial and the square root a few Newton steps.
+ *    - With the DSP extension (Cortex-M4, Cortex-M33 of series 2), the
+ *      Q15 dot product takes two products per SMLALD.
+ *
+ *    Angles are binary, a full turn is 65536: the int16_t wraps at +-pi,
+ *    which is +-32768, and FIXMATH_ANGLE_DEG converts from degrees.
+ *
+ *    The filters keep the last @p length samples in a ring the caller
+ *    provides. They start full of the first sample, so the first outputs
+ *    are ready at once, and take constant time per sample, with no
+ *    division: the average length is a power of two.
+ *
+ *    The component only depends on CMSIS and can be used on series 0, 1
+ *    and 2 parts.
+ * @{
+ ******************************************************************************/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Binary angle of @p deg degrees, a constant */
+#define FIXMATH_ANGLE_DEG(deg)    ((int16_t)((deg) * 32768L / 180))
+
+/** Largest average and median lengths */
+#define FIXMATH_MAX_AVERAGE       65536
+#define FIXMATH_MAX_MEDIAN        255
+
+/** Moving average state, treat as opaque */
+typedef struct {
+  int32_t  *ring;                       /**< Last samples */
+  uint32_t length;                      /**< Samples averaged, a power of two */
+  uint32_t shift;                       /**< log2(length) */
+  uint32_t index;                       /**< Oldest sample */
+  int32_t  sum;                         /**< Sum of the ring */
+  bool     primed;                      /**< Ring holds samples */
+} FIXMATH_Average_t;
+
+/** Moving median state, treat as opaque */
+typedef struct {
+  int32_t  *ring;                       /**< Last samples, in arrival order */
+  int32_t  *sorted;                     /**< The same samples, sorted */
+  uint32_t length;                      /**< Samples, odd */
+  uint32_t index;                       /**< Oldest sample */
+  bool     primed;                      /**< Ring holds samples */
+} FIXMATH_Median_t;
+
+/***************************************************************************//**
+ * @brief Multiply two Q15 numbers, saturating -1 * -1 to the largest Q15
+ ******************************************************************************/
+__STATIC_INLINE int16_t FIXMATH_MulQ15(int16_t a, int16_t b)
+{
+  int32_t p = ((int32_t)a * b) >> 15;
+
+#if (__CORTEX_M >= 3U)
+  return (int16_t)__SSAT(p, 16);
+#else
+  return (p > INT16_MAX) ? INT16_MAX : (int16_t)p;
+#endif
+}
+
+/***************************************************************************//**
+ * @brief Add two Q15 numbers, saturating
+ ******************************************************************************/
+__STATIC_INLINE int16_t FIXMATH_AddQ15(int16_t a, int16_t b)
+{
+  int32_t s = (int32_t)a + b;
+
+#if (__CORTEX_M >= 3U)
+  return (int16_t)__SSAT(s, 16);
+#else
+  return (s > INT16_MAX) ? INT16_MAX : ((s < INT16_MIN) ? INT16_MIN : (int16_t)s);
+#endif
+}
+
+uint16_t FIXMATH_Sqrt32(uint32_t x);
+
+/***************************************************************************//**
+ * @brief Square root of a Q15 number, 0 for negative ones
+ ******************************************************************************/
+__STATIC_INLINE int16_t FIXMATH_SqrtQ15(int16_t x)
+{
+  return (x <= 0) ? 0 : (int16_t)FIXMATH_Sqrt32((uint32_t)x << 15);
+}
+
+int32_t  FIXMATH_MulQ31(int32_t a, int32_t b);
+int64_t  FIXMATH_DotQ15(const int16_t *a, const int16_t *b, uint32_t n);
+int64_t  FIXMATH_DotQ31(const int32_t *a, const int32_t *b, uint32_t n);
+int16_t  FIXMATH_Atan2(int32_t y, int32_t x);
+
+bool     FIXMATH_AverageInit(FIXMATH_Average_t *avg, int32_t *ring, uint32_t length);
+int32_t  FIXMATH_AverageAdd(FIXMATH_Average_t *avg, int32_t sample);
+bool     FIXMATH_MedianInit(FIXMATH_Median_t *med, int32_t *ring, int32_t *sorted,
+                            uint32_t length);
+int32_t  FIXMATH_MedianAdd(FIXMATH_Median_t *med, int32_t sample);
+
+#ifdef __cplusplus
+}
+#endif
+
+/** @} (end group FixMath) */
+/** @} (end group kitdrv) */
+
+#endif
@@ -0,0 +1,416 @@
+/***************************************************************************//**
+ * @file
+ * @brief Circular event log over flash pages, appended from RAM in batches.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2022 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ******************************************************************************/
+
+#include "em_core.h"
+#include "em_msc.h"
+#include "flashlog.h"
+
+/***************************************************************************//**
+ * @addtogroup kitdrv
+ * @{
+ ******************************************************************************/
+
+/***************************************************************************//**
+ * @addtogroup FlashLog
+ * @{
+ ******************************************************************************/
+
+#define ERASED          0xFFFFFFFFUL
+#define SLOTS_PER_PAGE  (FLASH_PAGE_SIZE / sizeof(FLASHLOG_Record_TypeDef))
+
+// Log area, SLOTS_PER_PAGE records per page
+static FLASHLOG_Record_TypeDef *area;
+static uint32_t pageCount;
+static uint32_t slotCount;
+
+// Slot the next record goes to, always in erased flash
+static uint32_t head;
+
+// Sequence number of the next event
+static uint32_t sequence;
+
+// Head is written in FLASHLOG_Append() only, tail in writeBatch() only.
+// Both run freely and wrap at 2^32.
+static FLASHLOG_Record_TypeDef queue[FLASHLOG_QUEUE];
+static volatile uint32_t queueHead;
+static volatile uint32_t queueTail;
+
+// Records of one write, a linear copy of the queue
+static FLASHLOG_Record_TypeDef batch[FLASHLOG_BATCH];
+
+static volatile FLASHLOG_Counters_TypeDef counters;
+
+/**************************************************************************//**
+ * @brief Check word of a record
+ *****************************************************************************/
+static uint16_t checkOf(const FLASHLOG_Record_TypeDef *record)
+{
+  uint32_t c;
+
+  c = record->sequence ^ record->time ^ record->data
+      ^ ((uint32_t)record->event << 16) ^ 0x5AC3A53CUL;
+  c ^= c >> 16;
+
+  return (uint16_t)c;
+}
+
+/**************************************************************************//**
+ * @brief Whether a slot holds a complete record
+ *
+ * @details
+ *    The event and check word is written last, a record torn before it
+ *    still has FLASHLOG_EVENT_NONE there.
+ *****************************************************************************/
+static bool isValid(const FLASHLOG_Record_TypeDef *record)
+{
+  return (record->event != FLASHLOG_EVENT_NONE)
+         && (record->check == checkOf(record));
+}
+
+/**************************************************************************//**
+ * @brief Whether a slot has not been written since the last erase
+ *****************************************************************************/
+static bool isErased(const FLASHLOG_Record_TypeDef *record)
+{
+  const uint32_t *word = (const uint32_t *)record;
+  uint32_t i;
+
+  for (i = 0; i < sizeof(*record) / 4; i++) {
+    if (word[i] != ERASED) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/**************************************************************************//**
+ * @brief Whether every slot of a page is erased
+ *****************************************************************************/
+static bool isPageErased(uint32_t page)
+{
+  uint32_t i;
+
+  for (i = page * SLOTS_PER_PAGE; i < (page + 1) * SLOTS_PER_PAGE; i++) {
+    if (!isErased(&area[i])) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/**************************************************************************//**
+ * @brief Erase a page of the log
+ *****************************************************************************/
+static bool erasePage(uint32_t page)
+{
+  bool ok;
+
+  MSC_Init();
+  ok = MSC_ErasePage((uint32_t *)&area[page * SLOTS_PER_PAGE]) == mscReturnOk;
+  MSC_Deinit();
+  counters.erases++;
+
+  return ok;
+}
+
+/**************************************************************************//**
+ * @brief Write queued records, up to a batch and the end of the page
+ *
+ * @param[in] force
+ *    Write even if less than FLASHLOG_BATCH records are queued.
+ *
+ * @return
+ *    false if nothing was written.
+ *****************************************************************************/
+static bool writeBatch(bool force)
+{
+  uint32_t pending = queueHead - queueTail;
+  uint32_t room, count, t, i;
+
+  if ((pending == 0) || (!force && (pending < FLASHLOG_BATCH))) {
+    return false;
+  }
+
+  count = (pending < FLASHLOG_BATCH) ? pending : FLASHLOG_BATCH;
+  room = SLOTS_PER_PAGE - (head % SLOTS_PER_PAGE);
+  if (count > room) {
+    count = room;
+  }
+
+  t = queueTail;
+  for (i = 0; i < count; i++) {
+    batch[i] = queue[(t + i) & (FLASHLOG_QUEUE - 1)];
+  }
+
+  // Free the entries only after copying them out
+  queueTail = t + count;
+
+  MSC_Init();
+  if (MSC_WriteWord((uint32_t *)&area[head], batch,
+                    count * sizeof(batch[0])) == mscReturnOk) {
+    counters.written += count;
+  } else {
+    // The slots are not used again, the next records go after them
+    counters.writeErrors++;
+  }
+  MSC_Deinit();
+
+  head = (head + count) % slotCount;
+
+  // Entered a new page: keep the one after it erased
+  if ((head % SLOTS_PER_PAGE) == 0) {
+    erasePage(((head / SLOTS_PER_PAGE) + 1) % pageCount);
+  }
+
+  return true;
+}
+
+/**************************************************************************//**
+ * @brief Find the end of the log after reset
+ *
+ * @details
+ *    Scans every slot for the newest valid record and goes on at the first
+ *    erased slot after it. Erases the page written next if it is not
+ *    erased, which takes a page erase time; all pages are erased if the
+ *    area holds no valid record.
+ *
+ * @param[in] init
+ *    Flash area of the log, pages the application does not use otherwise.
+ *
+ * @return
+ *    false if the area does not fit.
+ *****************************************************************************/
+bool FLASHLOG_Init(const FLASHLOG_Init_TypeDef *init)
+{
+  uint32_t newest = 0;
+  bool found = false;
+  uint32_t i, page;
+
+  if ((init->pages < 2)
+      || (((uint32_t)init->base & (FLASH_PAGE_SIZE - 1)) != 0)) {
+    return false;
+  }
+
+  area = (FLASHLOG_Record_TypeDef *)init->base;
+  pageCount = init->pages;
+  slotCount = pageCount * SLOTS_PER_PAGE;
+
+  queueHead = 0;
+  queueTail = 0;
+  counters.appended = 0;
+  counters.dropped = 0;
+  counters.written = 0;
+  counters.writeErrors = 0;
+  counters.erases = 0;
+  counters.skipped = 0;
+
+  // Newest valid record, sequence numbers compared across the wrap
+  for (i = 0; i < slotCount; i++) {
+    if (isValid(&area[i])) {
+      if (!found
+          || ((int32_t)(area[i].sequence - area[newest].sequence) > 0)) {
+        newest = i;
+        found = true;
+      }
+    } else if (!isErased(&area[i])) {
+      counters.skipped++;
+    }
+  }
+
+  if (!found) {
+    head = 0;
+    sequence = 0;
+    for (page = 0; page < pageCount; page++) {
+      if (!isPageErased(page)) {
+        erasePage(page);
+      }
+    }
+    return true;
+  }
+
+  sequence = area[newest].sequence + 1;
+
+  // Past any torn record, at most to the end of the page
+  head = newest + 1;
+  while (((head % SLOTS_PER_PAGE) != 0) && !isErased(&area[head])) {
+    head++;
+  }
+  head %= slotCount;
+
+  // A new page must be erased, and so must the one after the head
+  page = head / SLOTS_PER_PAGE;
+  if (((head % SLOTS_PER_PAGE) == 0) && !isPageErased(page)) {
+    erasePage(page);
+  }
+  page = (page + 1) % pageCount;
+  if (!isPageErased(page)) {
+    erasePage(page);
+  }
+
+  return true;
+}
+
+/**************************************************************************//**
+ * @brief Queue an event
+ *
+ * @details
+ *    Only copies the event to RAM, may be called from interrupts.
+ *
+ * @param[in] event
+ *    Event number, any but FLASHLOG_EVENT_NONE.
+ *
+ * @param[in] time
+ *    Time of the event, in units of the application's choice.
+ *
+ * @param[in] data
+ *    Event data.
+ *
+ * @return
+ *    false if the queue is full and the event was dropped.
+ *****************************************************************************/
+bool FLASHLOG_Append(uint16_t event, uint32_t time, uint32_t data)
+{
+  FLASHLOG_Record_TypeDef *record;
+  CORE_DECLARE_IRQ_STATE;
+
+  if (event == FLASHLOG_EVENT_NONE) {
+    return false;
+  }
+
+  CORE_ENTER_ATOMIC();
+
+  if ((queueHead - queueTail) == FLASHLOG_QUEUE) {
+    counters.dropped++;
+    CORE_EXIT_ATOMIC();
+    return false;
+  }
+
+  record = &queue[queueHead & (FLASHLOG_QUEUE - 1)];
+  record->sequence = sequence++;
+  record->time = time;
+  record->data = data;
+  record->event = event;
+  record->check = checkOf(record);
+  queueHead++;
+  counters.appended++;
+
+  CORE_EXIT_ATOMIC();
+
+  return true;
+}
+
+/**************************************************************************//**
+ * @brief Write a batch of queued records
+ *
+ * @details
+ *    Call from the main loop. Writes once FLASHLOG_BATCH records are
+ *    queued, and erases a page when the writes reach a new one.
+ *
+ * @return
+ *    false if nothing was written.
+ *****************************************************************************/
+bool FLASHLOG_Service(void)
+{
+  return writeBatch(false);
+}
+
+/**************************************************************************//**
+ * @brief Write every queued record, such as before entering EM4
+ *****************************************************************************/
+void FLASHLOG_Flush(void)
+{
+  while (writeBatch(true)) {
+  }
+}
+
+/**************************************************************************//**
+ * @brief Number of events queued and not yet written
+ *****************************************************************************/
+uint32_t FLASHLOG_Pending(void)
+{
+  return queueHead - queueTail;
+}
+
+/**************************************************************************//**
+ * @brief Start reading at the oldest record in flash
+ *
+ * @details
+ *    The oldest page is the one after the erased page ahead of the head.
+ *    Records still queued are not read, call FLASHLOG_Flush() first.
+ *****************************************************************************/
+void FLASHLOG_Rewind(FLASHLOG_Cursor_TypeDef *cursor)
+{
+  uint32_t oldest = (((head / SLOTS_PER_PAGE) + 2) % pageCount)
+                    * SLOTS_PER_PAGE;
+
+  cursor->slot = oldest;
+  cursor->left = (head + slotCount - oldest) % slotCount;
+}
+
+/**************************************************************************//**
+ * @brief Read the next record, oldest first
+ *
+ * @return
+ *    false at the end of the log.
+ *****************************************************************************/
+bool FLASHLOG_Next(FLASHLOG_Cursor_TypeDef *cursor,
+                   FLASHLOG_Record_TypeDef *record)
+{
+  const FLASHLOG_Record_TypeDef *slot;
+
+  while (cursor->left > 0) {
+    slot = &area[cursor->slot];
+    cursor->slot = (cursor->slot + 1) % slotCount;
+    cursor->left--;
+
+    // Torn records are skipped
+    if (isValid(slot)) {
+      *record = *slot;
+      return true;
+    }
+  }
+  return false;
+}
+
+/**************************************************************************//**
+ * @brief Copy the counters
+ *****************************************************************************/
+void FLASHLOG_GetCounters(FLASHLOG_Counters_TypeDef *copy)
+{
+  copy->appended = counters.appended;
+  copy->dropped = counters.dropped;
+  copy->written = counters.written;
+  copy->writeErrors = counters.writeErrors;
+  copy->erases = counters.erases;
+  copy->skipped = counters.skipped;
+}
+
+/** @} (end group FlashLog) */
+/** @} (end group kitdrv) */
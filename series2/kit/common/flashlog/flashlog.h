@@ -0,0 +1,143 @@
+/***************************************************************************//**
+ * @file
+ * @brief Circular event log over flash pages, appended from RAM in batches.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2022 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ******************************************************************************/
+
+#ifndef __FLASHLOG_H
+#define __FLASHLOG_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "em_device.h"
+
+/***************************************************************************//**
+ * @addtogroup kitdrv
+ * @{
+ ******************************************************************************/
+
+/***************************************************************************//**
+ * @addtogroup FlashLog
+ * @brief Circular event log over flash pages, appended from RAM in batches
+ * @details
+ *    FLASHLOG_Append() only copies the event into a RAM queue, so it may be
+ *    called at a high rate and from interrupts. FLASHLOG_Service(), called
+ *    from the main loop, writes FLASHLOG_BATCH queued records at a time
+ *    with one MSC_WriteWord() call, as aligned words into erased flash.
+ *
+ *    The pages form a ring. The page after the one being written is always
+ *    kept erased, so a write never waits for an erase: when the writes
+ *    reach a new page, FLASHLOG_Service() erases the page after it, and
+ *    the oldest records go with it. The log keeps the records of the
+ *    pages - 2 pages before the one being written, and those written so
+ *    far in that page.
+ *
+ *    Each record carries a sequence number and a check word, written last.
+ *    FLASHLOG_Init() scans the pages after reset and goes on after the
+ *    newest valid record. A record torn by a reset during its write fails
+ *    the check and is skipped, and an erase cut short is done again.
+ *
+ *    Writing and erasing flash stall code fetches from flash, so the queue
+ *    must hold the events that arrive during an erase or a batch write.
+ *    A full queue drops the event and counts it.
+ * @{
+ ******************************************************************************/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Records queued in RAM, a power of 2 */
+#ifndef FLASHLOG_QUEUE
+#define FLASHLOG_QUEUE          64
+#endif
+
+/** Records written by one FLASHLOG_Service() call, at most FLASHLOG_QUEUE */
+#ifndef FLASHLOG_BATCH
+#define FLASHLOG_BATCH          8
+#endif
+
+#if (FLASHLOG_QUEUE & (FLASHLOG_QUEUE - 1)) != 0
+#error "FLASHLOG_QUEUE must be a power of 2"
+#endif
+
+#if (FLASHLOG_BATCH < 1) || (FLASHLOG_BATCH > FLASHLOG_QUEUE)
+#error "FLASHLOG_BATCH must be 1 to FLASHLOG_QUEUE"
+#endif
+
+/** Event number that is never logged, it marks an erased record */
+#define FLASHLOG_EVENT_NONE     0xFFFF
+
+/** One event, four words in flash */
+typedef struct {
+  uint32_t sequence;      /**< Counts up from the first record */
+  uint32_t time;          /**< Time of the event */
+  uint32_t data;          /**< Event data */
+  uint16_t event;         /**< Event number */
+  uint16_t check;         /**< Check of the other fields */
+} FLASHLOG_Record_TypeDef;
+
+/** Flash area of the log */
+typedef struct {
+  uint32_t *base;         /**< First page, page aligned */
+  uint32_t pages;         /**< Pages, at least 2 */
+} FLASHLOG_Init_TypeDef;
+
+/** Position of a reader */
+typedef struct {
+  uint32_t slot;          /**< Next record slot */
+  uint32_t left;          /**< Slots left before the end of the log */
+} FLASHLOG_Cursor_TypeDef;
+
+/** Counters, all only ever count up */
+typedef struct {
+  uint32_t appended;      /**< Events queued */
+  uint32_t dropped;       /**< Events lost to a full queue */
+  uint32_t written;       /**< Records written to flash */
+  uint32_t writeErrors;   /**< Batch writes that failed */
+  uint32_t erases;        /**< Pages erased */
+  uint32_t skipped;       /**< Torn records found by FLASHLOG_Init() */
+} FLASHLOG_Counters_TypeDef;
+
+bool FLASHLOG_Init(const FLASHLOG_Init_TypeDef *init);
+bool FLASHLOG_Append(uint16_t event, uint32_t time, uint32_t data);
+bool FLASHLOG_Service(void);
+void FLASHLOG_Flush(void);
+uint32_t FLASHLOG_Pending(void);
+void FLASHLOG_Rewind(FLASHLOG_Cursor_TypeDef *cursor);
+bool FLASHLOG_Next(FLASHLOG_Cursor_TypeDef *cursor,
+                   FLASHLOG_Record_TypeDef *record);
+void FLASHLOG_GetCounters(FLASHLOG_Counters_TypeDef *counters);
+
+#ifdef __cplusplus
+}
+#endif
+
+/** @} (end group FlashLog) */
+/** @} (end group kitdrv) */
+
+#endif
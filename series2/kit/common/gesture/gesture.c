@@ -0,0 +1,390 @@
+/***************************************************************************//**
+ * @file
+ * @brief Button debounce and gestures qualified by a LETIMER window.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2022 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ******************************************************************************/
+
+#include "em_burtc.h"
+#include "em_cmu.h"
+#include "em_gpio.h"
+#include "em_letimer.h"
+#include "em_prs.h"
+#include "prsgraph.h"
+#include "gesture.h"
+
+/***************************************************************************//**
+ * @addtogroup kitdrv
+ * @{
+ ******************************************************************************/
+
+/***************************************************************************//**
+ * @addtogroup Gesture
+ * @{
+ ******************************************************************************/
+
+typedef enum {
+  stateUp,                // Released, nothing pending
+  stateDown,              // Pressed, waiting for the long press time
+  stateGap,               // Released after a short press, waiting for the
+                          // double click time
+  stateSecond,            // Pressed again within the double click time
+  stateHeld,              // Long press reported, waiting for the release
+} State_t;
+
+typedef struct {
+  State_t  state;
+  uint32_t deadline;      // BURTC count the state times out at
+} Button_t;
+
+static GESTURE_Button_TypeDef pins[GESTURE_MAX_BUTTONS];
+static Button_t buttons[GESTURE_MAX_BUTTONS];
+static uint32_t buttonCount;
+static GESTURE_Callback_t callback;
+
+// Qualified state, one bit per button set while pressed
+static volatile uint32_t pressed;
+
+// Times in BURTC ticks
+static uint32_t settleTicks;
+static uint32_t longTicks;
+static uint32_t doubleTicks;
+
+static volatile GESTURE_Counters_TypeDef counters;
+
+/**************************************************************************//**
+ * @brief Read the buttons, one bit per button set while it is low
+ *****************************************************************************/
+static uint32_t readButtons(void)
+{
+  uint32_t state = 0;
+  uint32_t i;
+
+  for (i = 0; i < buttonCount; i++) {
+    if (GPIO_PinInGet(pins[i].port, pins[i].pin) == 0) {
+      state |= 1 << i;
+    }
+  }
+
+  return state;
+}
+
+/**************************************************************************//**
+ * @brief Whether a button waits for its deadline
+ *****************************************************************************/
+static bool isPending(const Button_t *button)
+{
+  return (button->state == stateDown)
+         || (button->state == stateGap)
+         || (button->state == stateSecond);
+}
+
+/**************************************************************************//**
+ * @brief Set the BURTC compare to the first deadline of all the buttons
+ *
+ * @details
+ *    The compare only matches on the count itself, so a deadline that has
+ *    passed by the time the compare is written, or every deadline of a
+ *    press that has been waiting longer than itself, is handled by
+ *    pending the interrupt.
+ *****************************************************************************/
+static void armTimer(void)
+{
+  uint32_t now = BURTC_CounterGet();
+  uint32_t next = 0;
+  int32_t soonest = INT32_MAX;
+  bool any = false;
+  uint32_t i;
+
+  for (i = 0; i < buttonCount; i++) {
+    if (isPending(&buttons[i])
+        && ((int32_t)(buttons[i].deadline - now) < soonest)) {
+      soonest = (int32_t)(buttons[i].deadline - now);
+      next = buttons[i].deadline;
+      any = true;
+    }
+  }
+
+  if (!any) {
+    BURTC_IntDisable(BURTC_IEN_COMP);
+    return;
+  }
+
+  BURTC_CompareSet(0, next);
+  BURTC_IntClear(BURTC_IF_COMP);
+  BURTC_IntEnable(BURTC_IEN_COMP);
+
+  if ((int32_t)(next - BURTC_CounterGet()) <= 0) {
+    NVIC_SetPendingIRQ(BURTC_IRQn);
+  }
+}
+
+/**************************************************************************//**
+ * @brief A qualified press or release of a button
+ *
+ * @param[in] time
+ *    BURTC count at the first edge of the burst.
+ *****************************************************************************/
+static void buttonEdge(uint32_t i, bool down, uint32_t time)
+{
+  Button_t *button = &buttons[i];
+
+  counters.edges++;
+
+  if (down) {
+    callback(i, gesturePress);
+    button->state = (button->state == stateGap) ? stateSecond : stateDown;
+    button->deadline = time + longTicks;
+    return;
+  }
+
+  callback(i, gestureRelease);
+  switch (button->state) {
+    case stateDown:
+      button->state = stateGap;
+      button->deadline = time + doubleTicks;
+      break;
+
+    case stateSecond:
+      button->state = stateUp;
+      callback(i, gestureDoubleClick);
+      break;
+
+    default:
+      button->state = stateUp;
+      break;
+  }
+}
+
+/**************************************************************************//**
+ * @brief A button has reached its deadline
+ *
+ * @details
+ *    A long second press ends the first press as a click of its own.
+ *****************************************************************************/
+static void buttonTimeout(uint32_t i)
+{
+  Button_t *button = &buttons[i];
+
+  switch (button->state) {
+    case stateSecond:
+      callback(i, gestureClick);
+    // fall through
+    case stateDown:
+      button->state = stateHeld;
+      callback(i, gestureLongPress);
+      break;
+
+    case stateGap:
+      button->state = stateUp;
+      callback(i, gestureClick);
+      break;
+
+    default:
+      break;
+  }
+}
+
+/**************************************************************************//**
+ * @brief LETIMER0 interrupt, the end of a settle window
+ *
+ * @details
+ *    REP0 is set again before the buttons are read, so an edge that comes
+ *    after the reading starts a new window, and its level is read then.
+ *****************************************************************************/
+void LETIMER0_IRQHandler(void)
+{
+  uint32_t time;
+  uint32_t state;
+  uint32_t changed;
+  uint32_t i;
+
+  LETIMER_IntClear(LETIMER0, LETIMER_IF_UF);
+  LETIMER_RepeatSet(LETIMER0, 0, 1);
+  counters.windows++;
+
+  time = BURTC_CounterGet() - settleTicks;
+  state = readButtons();
+  changed = state ^ pressed;
+  pressed = state;
+
+  for (i = 0; i < buttonCount; i++) {
+    if (changed & (1 << i)) {
+      buttonEdge(i, (state & (1 << i)) != 0, time);
+    }
+  }
+
+  armTimer();
+}
+
+/**************************************************************************//**
+ * @brief BURTC interrupt, a click or long press time has passed
+ *****************************************************************************/
+void BURTC_IRQHandler(void)
+{
+  uint32_t now;
+  uint32_t i;
+
+  BURTC_IntClear(BURTC_IF_COMP);
+  counters.timeouts++;
+
+  now = BURTC_CounterGet();
+  for (i = 0; i < buttonCount; i++) {
+    if (isPending(&buttons[i])
+        && ((int32_t)(now - buttons[i].deadline) >= 0)) {
+      buttonTimeout(i);
+    }
+  }
+
+  armTimer();
+}
+
+/**************************************************************************//**
+ * @brief Set up the buttons, the PRS, LETIMER0 and the BURTC
+ *
+ * @details
+ *    Each button has a GPIO external interrupt of its pin number for its
+ *    PRS signal, with the interrupt itself disabled, so two buttons can
+ *    not have the same pin number. The buttons get a pull-up and the
+ *    input filter. Buttons pressed at this point are taken as pressed,
+ *    without an event.
+ *
+ * @return
+ *    false if there are no or too many buttons, two with the same pin
+ *    number, or not enough free PRS channels.
+ *****************************************************************************/
+bool GESTURE_Init(const GESTURE_Init_TypeDef *init)
+{
+  LETIMER_Init_TypeDef letimerInit = LETIMER_INIT_DEFAULT;
+  BURTC_Init_TypeDef burtcInit = BURTC_INIT_DEFAULT;
+  uint32_t burtcFreq;
+  uint32_t pinMask = 0;
+  int node = PRSGRAPH_NONE;
+  uint32_t i;
+
+  if ((init->count == 0) || (init->count > GESTURE_MAX_BUTTONS)
+      || (init->callback == NULL)) {
+    return false;
+  }
+  for (i = 0; i < init->count; i++) {
+    if (pinMask & (1 << init->buttons[i].pin)) {
+      return false;
+    }
+    pinMask |= 1 << init->buttons[i].pin;
+  }
+
+  CMU_ClockEnable(cmuClock_GPIO, true);
+  CMU_ClockEnable(cmuClock_PRS, true);
+  CMU_ClockEnable(cmuClock_LETIMER0, true);
+  CMU_ClockEnable(cmuClock_BURTC, true);
+
+  buttonCount = init->count;
+  callback = init->callback;
+
+  // An edge of any button is an edge at the end of the chain of XORs
+  PRSGRAPH_Init();
+  for (i = 0; i < buttonCount; i++) {
+    pins[i] = init->buttons[i];
+    buttons[i].state = stateUp;
+    GPIO_PinModeSet(pins[i].port, pins[i].pin, gpioModeInputPullFilter, 1);
+    GPIO_ExtIntConfig(pins[i].port, pins[i].pin, pins[i].pin,
+                      false, false, false);
+    if (node == PRSGRAPH_NONE) {
+      node = PRSGRAPH_Source(PRS_ASYNC_CH_CTRL_SOURCESEL_GPIO, pins[i].pin);
+    } else {
+      node = PRSGRAPH_Logic(PRS_ASYNC_CH_CTRL_SOURCESEL_GPIO, pins[i].pin,
+                            node, prsLogic_A_XOR_B);
+    }
+  }
+  if (!PRSGRAPH_Consumer(node, prsConsumerLETIMER0_START)
+      || !PRSGRAPH_Build()) {
+    return false;
+  }
+
+  burtcFreq = CMU_ClockFreqGet(cmuClock_EM4GRPACLK);
+  settleTicks = burtcFreq * GESTURE_SETTLE_MS / 1000;
+  longTicks = burtcFreq * GESTURE_LONG_MS / 1000;
+  doubleTicks = burtcFreq * GESTURE_DOUBLE_MS / 1000;
+
+  counters.windows = 0;
+  counters.edges = 0;
+  counters.timeouts = 0;
+
+  // Free running, one count per tick
+  burtcInit.clkDiv = 1;
+  burtcInit.compare0Top = false;
+  BURTC_Init(&burtcInit);
+  BURTC_IntDisable(BURTC_IEN_COMP);
+  BURTC_IntClear(BURTC_IF_COMP);
+  NVIC_ClearPendingIRQ(BURTC_IRQn);
+  NVIC_EnableIRQ(BURTC_IRQn);
+
+  // Either edge of the PRS signal starts the LETIMER when it is stopped,
+  // set while it is disabled
+  LETIMER0->EN_CLR = LETIMER_EN_EN;
+  LETIMER0->PRSMODE = LETIMER_PRSMODE_PRSSTARTMODE_BOTH;
+
+  // One period of the settle time, then the LETIMER stops again. It
+  // starts from the top, so the first window is as long as the others.
+  letimerInit.enable = false;
+  letimerInit.comp0Top = true;
+  letimerInit.topValue = CMU_ClockFreqGet(cmuClock_LETIMER0)
+                         * GESTURE_SETTLE_MS / 1000;
+  letimerInit.repMode = letimerRepeatOneshot;
+  LETIMER_Init(LETIMER0, &letimerInit);
+  LETIMER_CounterSet(LETIMER0, letimerInit.topValue);
+  LETIMER_RepeatSet(LETIMER0, 0, 1);
+
+  pressed = readButtons();
+
+  LETIMER_IntClear(LETIMER0, LETIMER_IF_UF);
+  LETIMER_IntEnable(LETIMER0, LETIMER_IEN_UF);
+  NVIC_ClearPendingIRQ(LETIMER0_IRQn);
+  NVIC_EnableIRQ(LETIMER0_IRQn);
+
+  return true;
+}
+
+/**************************************************************************//**
+ * @brief Qualified state of a button
+ *****************************************************************************/
+bool GESTURE_IsPressed(uint32_t button)
+{
+  return (pressed & (1 << button)) != 0;
+}
+
+/**************************************************************************//**
+ * @brief Copy the counters
+ *****************************************************************************/
+void GESTURE_GetCounters(GESTURE_Counters_TypeDef *copy)
+{
+  copy->windows = counters.windows;
+  copy->edges = counters.edges;
+  copy->timeouts = counters.timeouts;
+}
+
+/** @} (end group Gesture) */
+/** @} (end group kitdrv) */
@@ -0,0 +1,145 @@
+/***************************************************************************//**
+ * @file
+ * @brief Button debounce and gestures qualified by a LETIMER window.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2022 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ******************************************************************************/
+
+#ifndef __GESTURE_H
+#define __GESTURE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "em_device.h"
+#include "em_gpio.h"
+
+/***************************************************************************//**
+ * @addtogroup kitdrv
+ * @{
+ ******************************************************************************/
+
+/***************************************************************************//**
+ * @addtogroup Gesture
+ * @brief Button debounce and gesture detection on a LETIMER window, few wakes
+ * @details
+ *    The buttons are XORed together in a chain of PRS logic functions,
+ *    allocated with the PrsGraph driver, so an edge of any button is an
+ *    edge of the result. That edge starts LETIMER0 through its PRS start
+ *    input, in one-shot mode for GESTURE_SETTLE_MS. Edges while it runs,
+ *    the bounce of the contacts, do not restart it and do not interrupt
+ *    the CPU. The underflow at the end of the window is the only wake: the
+ *    buttons are read once, after they have settled, and each one that
+ *    reads other than before has a qualified press or release.
+ *
+ *    The gestures are found from the qualified edges and the BURTC count:
+ *    - gesturePress and gestureRelease for every qualified edge
+ *    - gestureClick, a press shorter than GESTURE_LONG_MS not followed by
+ *      another press within GESTURE_DOUBLE_MS of its release
+ *    - gestureDoubleClick, at the release of the second of two such
+ *      presses
+ *    - gestureLongPress, once a press has lasted GESTURE_LONG_MS, while
+ *      the button is still held; its release gives no click
+ *    A click is only known once the double click time has passed, so it
+ *    takes one more wake, on a BURTC compare match, and so does a long
+ *    press. No interrupt runs while no button is pressed or waiting.
+ *
+ *    The callback is called from the LETIMER0 and BURTC interrupts. The
+ *    component owns LETIMER0, the BURTC and both interrupt handlers, and
+ *    builds its own PrsGraph graph. The EM23GRPACLK and EM4GRPACLK are
+ *    selected by the caller; both keep running in EM2, where the buttons
+ *    must be on port A or B.
+ * @{
+ ******************************************************************************/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Buttons, at most one per PRS channel */
+#ifndef GESTURE_MAX_BUTTONS
+#define GESTURE_MAX_BUTTONS     4
+#endif
+
+/** Time from the first edge to the reading of the buttons */
+#ifndef GESTURE_SETTLE_MS
+#define GESTURE_SETTLE_MS       20
+#endif
+
+/** Presses at least this long are long presses */
+#ifndef GESTURE_LONG_MS
+#define GESTURE_LONG_MS         600
+#endif
+
+/** Time from a release to the next press of a double click */
+#ifndef GESTURE_DOUBLE_MS
+#define GESTURE_DOUBLE_MS       300
+#endif
+
+/** Button events */
+typedef enum {
+  gesturePress,           /**< Qualified press */
+  gestureRelease,         /**< Qualified release */
+  gestureClick,           /**< Short press, no second one followed */
+  gestureDoubleClick,     /**< Two short presses in a row */
+  gestureLongPress,       /**< Press held for GESTURE_LONG_MS */
+} GESTURE_Event_TypeDef;
+
+/** Event callback, with the index of the button in the init structure */
+typedef void (*GESTURE_Callback_t)(uint32_t button,
+                                   GESTURE_Event_TypeDef event);
+
+/** Button pins, low when pressed */
+typedef struct {
+  GPIO_Port_TypeDef port;
+  uint8_t           pin;
+} GESTURE_Button_TypeDef;
+
+/** Buttons and callback */
+typedef struct {
+  const GESTURE_Button_TypeDef *buttons;
+  uint32_t                     count;
+  GESTURE_Callback_t           callback;
+} GESTURE_Init_TypeDef;
+
+/** Counters, all only ever count up */
+typedef struct {
+  uint32_t windows;       /**< LETIMER wakes, one per burst of edges */
+  uint32_t edges;         /**< Qualified presses and releases */
+  uint32_t timeouts;      /**< BURTC wakes for clicks and long presses */
+} GESTURE_Counters_TypeDef;
+
+bool GESTURE_Init(const GESTURE_Init_TypeDef *init);
+bool GESTURE_IsPressed(uint32_t button);
+void GESTURE_GetCounters(GESTURE_Counters_TypeDef *copy);
+
+#ifdef __cplusplus
+}
+#endif
+
+/** @} (end group Gesture) */
+/** @} (end group kitdrv) */
+
+#endif
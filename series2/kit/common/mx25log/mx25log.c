@@ -0,0 +1,881 @@
+/***************************************************************************//**
+ * @file
+ * @brief Log structured file store over the MX25 SPI flash.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2022 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ******************************************************************************/
+
+#include <stddef.h>
+#include <string.h>
+#include "em_core.h"
+#include "mx25log.h"
+
+/***************************************************************************//**
+ * @addtogroup kitdrv
+ * @{
+ ******************************************************************************/
+
+/***************************************************************************//**
+ * @addtogroup Mx25Log
+ * @{
+ ******************************************************************************/
+
+#define PAGES_PER_SECTOR  (Sector_Offset / Page_Offset)
+
+// File number of an erased page, or of a queued page that was cancelled
+#define FILE_NONE         0xFF
+
+// Page marks the file deleted, the offset field holds the boundary
+#define FLAG_DELETE       0x01
+
+// Page header, the first 16 bytes of each page
+typedef struct {
+  uint32_t sequence;        // Program order across the log
+  uint32_t offset;          // Offset of the data in the file
+  uint8_t  file;            // File number
+  uint8_t  flags;           // FLAG_DELETE
+  uint16_t length;          // Data bytes in the page
+  uint16_t dataCheck;       // Check of the data bytes
+  uint16_t headerCheck;     // Check of the fields above
+} Header_t;
+
+typedef struct {
+  Header_t header;
+  uint8_t  data[MX25LOG_PAGE_DATA];
+} Page_t;
+
+// Flash operation in progress
+typedef enum {
+  opNone,
+  opProgram,                // Queued page being programmed
+  opCopyRead,               // Live page being read by the LDMA
+  opCopyProgram,            // Live page being programmed at the head
+  opErase,                  // Collected sector being erased
+} Op_t;
+
+static MX25LOG_Init_TypeDef config;
+
+// RAM index: a bit per file found in each sector
+static uint8_t sectorFiles[MX25LOG_MAX_SECTORS];
+
+// Sectors in use run from tail to headSector, the rest are erased
+static uint32_t tail;
+static uint32_t headSector;
+static uint32_t headPage;
+static uint32_t freeSectors;
+static uint32_t sequence;
+
+// Size of each file, and the sequence its pages must reach to be live
+static uint32_t fileSize[MX25LOG_MAX_FILES];
+static uint32_t boundary[MX25LOG_MAX_FILES];
+
+// Page buffers: free, being filled by a file, or queued for programming
+static Page_t buffers[MX25LOG_BUFFERS];
+static uint32_t freeMask;
+static int8_t filling[MX25LOG_MAX_FILES];
+static uint8_t queue[MX25LOG_BUFFERS];
+static uint32_t queueFirst;
+static uint32_t queueCount;
+
+static volatile Op_t op;
+static uint32_t programBuffer;
+
+// Collection of the tail sector
+static bool collecting;
+static bool dropping;
+static bool full;
+static uint32_t collectPage;
+static Page_t copyPage;
+
+// Data of a page read back by MX25LOG_Read()
+static uint8_t readData[MX25LOG_PAGE_DATA];
+
+static MX25LOG_Counters_TypeDef counters;
+
+/**************************************************************************//**
+ * @brief Fletcher-16 check, neither byte is ever 0xFF
+ *****************************************************************************/
+static uint16_t check16(const void *data, uint32_t length)
+{
+  const uint8_t *p = data;
+  uint32_t a = 0;
+  uint32_t b = 0;
+  uint32_t i;
+
+  for (i = 0; i < length; i++) {
+    a = (a + p[i]) % 255;
+    b = (b + a) % 255;
+  }
+  return (uint16_t)((b << 8) | a);
+}
+
+static uint32_t sectorAddress(uint32_t sector)
+{
+  return config.base + (sector * Sector_Offset);
+}
+
+static uint32_t pageAddress(uint32_t sector, uint32_t page)
+{
+  return sectorAddress(sector) + (page * Page_Offset);
+}
+
+static uint32_t nextSector(uint32_t sector)
+{
+  return (sector + 1) % config.sectors;
+}
+
+static uint32_t prevSector(uint32_t sector)
+{
+  return (sector + config.sectors - 1) % config.sectors;
+}
+
+static bool isErased(const Header_t *header)
+{
+  const uint32_t *word = (const uint32_t *)header;
+  uint32_t i;
+
+  for (i = 0; i < sizeof(*header) / 4; i++) {
+    if (word[i] != 0xFFFFFFFFUL) {
+      return false;
+    }
+  }
+  return true;
+}
+
+static bool isValid(const Header_t *header)
+{
+  return (header->file < MX25LOG_MAX_FILES)
+         && (header->length <= MX25LOG_PAGE_DATA)
+         && (header->headerCheck
+             == check16(header, offsetof(Header_t, headerCheck)));
+}
+
+/**************************************************************************//**
+ * @brief Whether a page must be kept when its sector is collected
+ *
+ * @details
+ *    Data pages older than the newest delete of their file are dead; of
+ *    the delete pages only the newest one is kept.
+ *****************************************************************************/
+static bool isLive(const Header_t *header)
+{
+  if (!isValid(header)) {
+    return false;
+  }
+  if (header->flags & FLAG_DELETE) {
+    return header->offset == boundary[header->file];
+  }
+  return (int32_t)(header->sequence - boundary[header->file]) >= 0;
+}
+
+static void readHeader(uint32_t sector, uint32_t page, Header_t *header)
+{
+  MX25_READ(pageAddress(sector, page), (uint8_t *)header, sizeof(*header));
+}
+
+/**************************************************************************//**
+ * @brief Take a free page buffer, call with interrupts masked
+ *
+ * @return
+ *    Buffer index, -1 if none is free.
+ *****************************************************************************/
+static int takeBuffer(uint8_t file, uint8_t flags, uint32_t offset)
+{
+  Page_t *page;
+  int i;
+
+  for (i = 0; i < MX25LOG_BUFFERS; i++) {
+    if (freeMask & (1UL << i)) {
+      freeMask &= ~(1UL << i);
+      page = &buffers[i];
+      memset(page, 0xFF, sizeof(*page));
+      page->header.file   = file;
+      page->header.flags  = flags;
+      page->header.offset = offset;
+      page->header.length = 0;
+      return i;
+    }
+  }
+  return -1;
+}
+
+/**************************************************************************//**
+ * @brief Queue a buffer for programming, call with interrupts masked
+ *****************************************************************************/
+static void queueBuffer(int index)
+{
+  queue[(queueFirst + queueCount) % MX25LOG_BUFFERS] = (uint8_t)index;
+  queueCount++;
+}
+
+/**************************************************************************//**
+ * @brief Move the head to a new sector if it is full
+ *
+ * @param[in] reserve
+ *    Keep one erased sector for the pages moved by collection.
+ *
+ * @return
+ *    false if there is no room.
+ *****************************************************************************/
+static bool headRoom(bool reserve)
+{
+  if (headPage < PAGES_PER_SECTOR) {
+    return true;
+  }
+  if (freeSectors <= (reserve ? 1U : 0U)) {
+    return false;
+  }
+  headSector = nextSector(headSector);
+  headPage = 0;
+  freeSectors--;
+  sectorFiles[headSector] = 0;
+  return true;
+}
+
+/**************************************************************************//**
+ * @brief Program a page at the head with the next sequence number
+ *****************************************************************************/
+static bool startProgram(Page_t *page, Op_t what)
+{
+  page->header.sequence = sequence;
+  page->header.headerCheck = check16(&page->header,
+                                     offsetof(Header_t, headerCheck));
+
+  if (MX25_PP_Async(pageAddress(headSector, headPage), (uint8_t *)page,
+                    Page_Offset, NULL) != FlashOperationSuccess) {
+    return false;
+  }
+  sequence++;
+  op = what;
+  return true;
+}
+
+/**************************************************************************//**
+ * @brief Account for a completed program or erase
+ *****************************************************************************/
+static void finishOp(ReturnMsg status)
+{
+  CORE_DECLARE_IRQ_STATE;
+  const Page_t *page;
+
+  if (status != FlashOperationSuccess) {
+    counters.flashErrors++;
+  }
+
+  if (op == opErase) {
+    if (status == FlashOperationSuccess) {
+      counters.sectorsErased++;
+    }
+    sectorFiles[tail] = 0;
+    tail = nextSector(tail);
+    freeSectors++;
+    collecting = false;
+  } else {
+    page = (op == opProgram) ? &buffers[programBuffer] : &copyPage;
+    if (status == FlashOperationSuccess) {
+      sectorFiles[headSector] |= 1U << page->header.file;
+      if (op == opProgram) {
+        counters.pagesWritten++;
+      } else {
+        counters.pagesCopied++;
+      }
+    }
+
+    // The page is used even if the program failed
+    headPage++;
+
+    if (op == opProgram) {
+      CORE_ENTER_ATOMIC();
+      freeMask |= 1UL << programBuffer;
+      CORE_EXIT_ATOMIC();
+    }
+  }
+
+  op = opNone;
+}
+
+#ifdef MX25_USE_LDMA
+/**************************************************************************//**
+ * @brief LDMA read of a page to move done, MX25LOG_Process() goes on
+ *****************************************************************************/
+static void copyReadDone(ReturnMsg status)
+{
+  (void)status;
+}
+#endif
+
+/**************************************************************************//**
+ * @brief Decide how to collect the tail sector
+ *
+ * @details
+ *    A tail that holds only live pages frees nothing when moved, so it is
+ *    dropped with wrap set, and the log is full otherwise.
+ *****************************************************************************/
+static void startCollect(void)
+{
+  Header_t header;
+  uint32_t live = 0;
+  uint32_t p;
+
+  for (p = 0; p < PAGES_PER_SECTOR; p++) {
+    readHeader(tail, p, &header);
+    if (isLive(&header)) {
+      live++;
+    }
+  }
+
+  if (live == PAGES_PER_SECTOR) {
+    if (!config.wrap) {
+      full = true;
+      return;
+    }
+    dropping = true;
+  } else {
+    dropping = false;
+  }
+
+  collectPage = 0;
+  collecting = true;
+}
+
+/**************************************************************************//**
+ * @brief Move the next live page of the tail, or erase it when done
+ *****************************************************************************/
+static void collectStep(void)
+{
+  ReturnMsg status;
+  uint32_t address;
+
+  while (collectPage < PAGES_PER_SECTOR) {
+    readHeader(tail, collectPage, &copyPage.header);
+    if (!isLive(&copyPage.header)) {
+      collectPage++;
+      continue;
+    }
+    if (dropping) {
+      counters.pagesDropped++;
+      collectPage++;
+      continue;
+    }
+
+    // The reserve sector makes room for any live page
+    if (!headRoom(false)) {
+      return;
+    }
+
+    address = pageAddress(tail, collectPage);
+#ifdef MX25_USE_LDMA
+    status = MX25_READ_LDMA(address, (uint8_t *)&copyPage, Page_Offset,
+                            copyReadDone);
+    if (status == FlashOperationSuccess) {
+      op = opCopyRead;
+      collectPage++;
+    }
+#else
+    status = MX25_READ(address, (uint8_t *)&copyPage, Page_Offset);
+    if ((status == FlashOperationSuccess)
+        && startProgram(&copyPage, opCopyProgram)) {
+      collectPage++;
+    }
+#endif
+    return;
+  }
+
+  if (MX25_SE_Async(sectorAddress(tail), NULL) == FlashOperationSuccess) {
+    op = opErase;
+  }
+}
+
+/**************************************************************************//**
+ * @brief Rebuild the RAM index from the page headers
+ *
+ * @details
+ *    Call once after MX25_init(), and after LDMA_Init() if MX25_USE_LDMA is
+ *    defined. Reads every page header, erases sectors left over from an
+ *    interrupted collection and waits for those erases.
+ *
+ * @param[in] init
+ *    Area of the log, sector aligned, used by nothing else.
+ *
+ * @return
+ *    false if the area does not fit.
+ *****************************************************************************/
+bool MX25LOG_Init(const MX25LOG_Init_TypeDef *init)
+{
+  static uint8_t used[(MX25LOG_MAX_SECTORS + 7) / 8];
+  Header_t header;
+  uint32_t newest = 0;
+  bool found = false;
+  uint32_t run, s, p, i, end;
+
+  if ((init->sectors < 3) || (init->sectors > MX25LOG_MAX_SECTORS)
+      || ((init->base % Sector_Offset) != 0)
+      || ((init->base + (init->sectors * Sector_Offset)) > FlashSize)) {
+    return false;
+  }
+
+  config = *init;
+  freeMask = (1UL << MX25LOG_BUFFERS) - 1;
+  queueFirst = 0;
+  queueCount = 0;
+  op = opNone;
+  collecting = false;
+  full = false;
+  memset(&counters, 0, sizeof(counters));
+  memset(used, 0, sizeof(used));
+  for (i = 0; i < MX25LOG_MAX_FILES; i++) {
+    filling[i] = -1;
+    fileSize[i] = 0;
+    boundary[i] = 0;
+  }
+
+  // Sectors in use, the newest page and the newest delete of each file
+  for (s = 0; s < config.sectors; s++) {
+    sectorFiles[s] = 0;
+    for (p = 0; p < PAGES_PER_SECTOR; p++) {
+      readHeader(s, p, &header);
+      if (isErased(&header)) {
+        continue;
+      }
+      used[s / 8] |= 1U << (s % 8);
+      if (!isValid(&header)) {
+        counters.tornPages++;
+        continue;
+      }
+      sectorFiles[s] |= 1U << header.file;
+      if (!found || ((int32_t)(header.sequence - sequence) > 0)) {
+        sequence = header.sequence;
+        newest = s;
+        found = true;
+      }
+      if ((header.flags & FLAG_DELETE)
+          && ((int32_t)(header.offset - boundary[header.file]) > 0)) {
+        boundary[header.file] = header.offset;
+      }
+    }
+  }
+
+  if (!found) {
+    // Nothing to keep, start over at the first sector
+    for (s = 0; s < config.sectors; s++) {
+      if (used[s / 8] & (1U << (s % 8))) {
+        MX25_SE(sectorAddress(s));
+        counters.sectorsErased++;
+      }
+      sectorFiles[s] = 0;
+    }
+    sequence = 0;
+    tail = 0;
+    headSector = 0;
+    headPage = 0;
+    freeSectors = config.sectors - 1;
+    return true;
+  }
+
+  // Go on after the last page written in the newest sector
+  sequence++;
+  headSector = newest;
+  headPage = 0;
+  for (p = 0; p < PAGES_PER_SECTOR; p++) {
+    readHeader(headSector, p, &header);
+    if (!isErased(&header)) {
+      headPage = p + 1;
+    }
+  }
+
+  // The sectors in use run back from the head
+  tail = headSector;
+  run = 1;
+  while ((run < config.sectors)
+         && (used[prevSector(tail) / 8] & (1U << (prevSector(tail) % 8)))) {
+    tail = prevSector(tail);
+    run++;
+  }
+  freeSectors = config.sectors - run;
+
+  // Anything outside the run is left from an interrupted collection
+  for (s = nextSector(headSector), i = 0; i < freeSectors;
+       s = nextSector(s), i++) {
+    if (used[s / 8] & (1U << (s % 8))) {
+      MX25_SE(sectorAddress(s));
+      counters.sectorsErased++;
+    }
+    sectorFiles[s] = 0;
+  }
+
+  // The last sector collected may look erased after a cut short erase
+  if (freeSectors > 0) {
+    s = prevSector(tail);
+    for (p = 0; p < PAGES_PER_SECTOR; p++) {
+      MX25_READ(pageAddress(s, p), (uint8_t *)&copyPage, Page_Offset);
+      for (i = 0; i < Page_Offset; i++) {
+        if (((uint8_t *)&copyPage)[i] != 0xFF) {
+          break;
+        }
+      }
+      if (i < Page_Offset) {
+        MX25_SE(sectorAddress(s));
+        counters.sectorsErased++;
+        break;
+      }
+    }
+  }
+
+  // File sizes, from the live data pages
+  for (s = tail, i = 0; i < run; s = nextSector(s), i++) {
+    for (p = 0; p < PAGES_PER_SECTOR; p++) {
+      readHeader(s, p, &header);
+      if (isLive(&header) && !(header.flags & FLAG_DELETE)) {
+        end = header.offset + header.length;
+        if (end > fileSize[header.file]) {
+          fileSize[header.file] = end;
+        }
+      }
+    }
+  }
+
+  return true;
+}
+
+/**************************************************************************//**
+ * @brief Append data to a file
+ *
+ * @details
+ *    Copies the data to RAM page buffers, may be called from interrupts.
+ *
+ * @return
+ *    mx25logNoBuffer or mx25logFull if some of the data was dropped.
+ *****************************************************************************/
+MX25LOG_Status_TypeDef MX25LOG_Append(uint8_t file, const void *data,
+                                      uint32_t length)
+{
+  MX25LOG_Status_TypeDef status = mx25logOk;
+  const uint8_t *src = data;
+  Page_t *page;
+  uint32_t n;
+  int index;
+  CORE_DECLARE_IRQ_STATE;
+
+  if (file >= MX25LOG_MAX_FILES) {
+    return mx25logBadFile;
+  }
+
+  CORE_ENTER_ATOMIC();
+
+  if (full) {
+    counters.bytesDropped += length;
+    CORE_EXIT_ATOMIC();
+    return mx25logFull;
+  }
+
+  while (length > 0) {
+    if (filling[file] < 0) {
+      index = takeBuffer(file, 0, fileSize[file]);
+      if (index < 0) {
+        counters.bytesDropped += length;
+        status = mx25logNoBuffer;
+        break;
+      }
+      filling[file] = (int8_t)index;
+    }
+
+    page = &buffers[filling[file]];
+    n = MX25LOG_PAGE_DATA - page->header.length;
+    if (n > length) {
+      n = length;
+    }
+    memcpy(&page->data[page->header.length], src, n);
+    page->header.length += n;
+    fileSize[file] += n;
+    src += n;
+    length -= n;
+
+    if (page->header.length == MX25LOG_PAGE_DATA) {
+      queueBuffer(filling[file]);
+      filling[file] = -1;
+    }
+  }
+
+  CORE_EXIT_ATOMIC();
+
+  return status;
+}
+
+/**************************************************************************//**
+ * @brief Queue the partly filled page of a file for programming
+ *****************************************************************************/
+MX25LOG_Status_TypeDef MX25LOG_Flush(uint8_t file)
+{
+  CORE_DECLARE_IRQ_STATE;
+
+  if (file >= MX25LOG_MAX_FILES) {
+    return mx25logBadFile;
+  }
+
+  CORE_ENTER_ATOMIC();
+  if (filling[file] >= 0) {
+    queueBuffer(filling[file]);
+    filling[file] = -1;
+  }
+  CORE_EXIT_ATOMIC();
+
+  return mx25logOk;
+}
+
+/**************************************************************************//**
+ * @brief Delete a file, its size goes back to 0
+ *
+ * @details
+ *    Call from the main loop. Data not yet programmed is dropped at once;
+ *    the delete is kept through a reset once MX25LOG_Process() has
+ *    programmed the delete page. Collection then skips the file's pages.
+ *****************************************************************************/
+MX25LOG_Status_TypeDef MX25LOG_Delete(uint8_t file)
+{
+  Page_t *page;
+  uint32_t i;
+  int index;
+  CORE_DECLARE_IRQ_STATE;
+
+  if (file >= MX25LOG_MAX_FILES) {
+    return mx25logBadFile;
+  }
+
+  CORE_ENTER_ATOMIC();
+
+  // Every page in flash now is older than the boundary
+  index = takeBuffer(file, FLAG_DELETE, sequence);
+  if (index < 0) {
+    CORE_EXIT_ATOMIC();
+    return mx25logNoBuffer;
+  }
+
+  for (i = 0; i < queueCount; i++) {
+    page = &buffers[queue[(queueFirst + i) % MX25LOG_BUFFERS]];
+    if (page->header.file == file) {
+      page->header.file = FILE_NONE;
+    }
+  }
+  if (filling[file] >= 0) {
+    freeMask |= 1UL << filling[file];
+    filling[file] = -1;
+  }
+
+  queueBuffer(index);
+  boundary[file] = sequence;
+  fileSize[file] = 0;
+  full = false;
+
+  CORE_EXIT_ATOMIC();
+
+  return mx25logOk;
+}
+
+/**************************************************************************//**
+ * @brief Read data of a file from flash
+ *
+ * @details
+ *    Only pages already programmed are read. Each page read is checked
+ *    against its data check.
+ *
+ * @param[out] count
+ *    Bytes from offset to the end of the data found, may be NULL.
+ *
+ * @return
+ *    mx25logBusy while a program, erase or LDMA read is in progress.
+ *****************************************************************************/
+MX25LOG_Status_TypeDef MX25LOG_Read(uint8_t file, uint32_t offset,
+                                    void *buffer, uint32_t length,
+                                    uint32_t *count)
+{
+  MX25LOG_Status_TypeDef status = mx25logOk;
+  uint8_t *dst = buffer;
+  Header_t header;
+  uint32_t s, p, i, pages;
+  uint32_t from, to, found = 0;
+
+  if (count != NULL) {
+    *count = 0;
+  }
+  if (file >= MX25LOG_MAX_FILES) {
+    return mx25logBadFile;
+  }
+  if (op != opNone) {
+    return mx25logBusy;
+  }
+
+  for (s = tail, i = 0; ; s = nextSector(s), i++) {
+    if (sectorFiles[s] & (1U << file)) {
+      pages = (s == headSector) ? headPage : PAGES_PER_SECTOR;
+      for (p = 0; p < pages; p++) {
+        readHeader(s, p, &header);
+        if ((header.file != file) || (header.flags & FLAG_DELETE)
+            || !isLive(&header)
+            || (header.offset >= offset + length)
+            || (header.offset + header.length <= offset)) {
+          continue;
+        }
+
+        MX25_READ(pageAddress(s, p) + sizeof(Header_t), readData,
+                  header.length);
+        if (check16(readData, header.length) != header.dataCheck) {
+          status = mx25logCorrupt;
+          continue;
+        }
+
+        // Part of the page inside the range
+        from = (header.offset > offset) ? header.offset : offset;
+        to = header.offset + header.length;
+        if (to > offset + length) {
+          to = offset + length;
+        }
+        memcpy(&dst[from - offset], &readData[from - header.offset],
+               to - from);
+        if (to - offset > found) {
+          found = to - offset;
+        }
+      }
+    }
+    if (s == headSector) {
+      break;
+    }
+  }
+
+  if (count != NULL) {
+    *count = found;
+  }
+  return status;
+}
+
+/**************************************************************************//**
+ * @brief Bytes appended to a file, including those still in RAM
+ *****************************************************************************/
+uint32_t MX25LOG_Size(uint8_t file)
+{
+  return (file < MX25LOG_MAX_FILES) ? fileSize[file] : 0;
+}
+
+/**************************************************************************//**
+ * @brief Run the next step of programming, collection or erase
+ *
+ * @details
+ *    Call from the main loop every MX25_ASYNC_POLL_MS, it polls the flash
+ *    with MX25_PollAsync() and never waits for it.
+ *
+ * @return
+ *    true while there is work left.
+ *****************************************************************************/
+bool MX25LOG_Process(void)
+{
+  ReturnMsg status;
+  Page_t *page;
+  int index;
+  CORE_DECLARE_IRQ_STATE;
+
+  if ((op == opProgram) || (op == opCopyProgram) || (op == opErase)) {
+    status = MX25_PollAsync();
+    if (status == FlashIsBusy) {
+      return true;
+    }
+    finishOp(status);
+  }
+
+#ifdef MX25_USE_LDMA
+  if (op == opCopyRead) {
+    if (MX25_LDMA_Busy()) {
+      return true;
+    }
+    op = opNone;
+    if (!startProgram(&copyPage, opCopyProgram)) {
+      // Read the page again next time
+      collectPage--;
+    }
+    return true;
+  }
+#endif
+
+  if (collecting) {
+    collectStep();
+    return true;
+  }
+
+  // Keep a sector in reserve for the live pages of the oldest one
+  if (!full && (freeSectors <= 1) && (tail != headSector)) {
+    startCollect();
+    if (collecting) {
+      collectStep();
+      return true;
+    }
+  }
+
+  if (queueCount == 0) {
+    return false;
+  }
+
+  index = queue[queueFirst];
+  page = &buffers[index];
+
+  if (page->header.file != FILE_NONE) {
+    if (!headRoom(!(page->header.flags & FLAG_DELETE))) {
+      return true;
+    }
+    page->header.dataCheck = check16(page->data, page->header.length);
+    if (!startProgram(page, opProgram)) {
+      return true;
+    }
+    programBuffer = (uint32_t)index;
+  }
+
+  CORE_ENTER_ATOMIC();
+  queueFirst = (queueFirst + 1) % MX25LOG_BUFFERS;
+  queueCount--;
+  if (page->header.file == FILE_NONE) {
+    // Cancelled by MX25LOG_Delete()
+    freeMask |= 1UL << index;
+  }
+  CORE_EXIT_ATOMIC();
+
+  return true;
+}
+
+/**************************************************************************//**
+ * @brief Whether everything appended and flushed is in flash
+ *****************************************************************************/
+bool MX25LOG_Idle(void)
+{
+  return (op == opNone) && !collecting && (queueCount == 0);
+}
+
+/**************************************************************************//**
+ * @brief Copy the counters
+ *****************************************************************************/
+void MX25LOG_GetCounters(MX25LOG_Counters_TypeDef *copy)
+{
+  *copy = counters;
+}
+
+/** @} (end group Mx25Log) */
+/** @} (end group kitdrv) */
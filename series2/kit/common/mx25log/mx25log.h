@@ -0,0 +1,153 @@
+/***************************************************************************//**
+ * @file
+ * @brief Log structured file store over the MX25 SPI flash.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2022 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ******************************************************************************/
+
+#ifndef __MX25LOG_H
+#define __MX25LOG_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "mx25flash_spi.h"
+
+/***************************************************************************//**
+ * @addtogroup kitdrv
+ * @{
+ ******************************************************************************/
+
+/***************************************************************************//**
+ * @addtogroup Mx25Log
+ * @brief Log structured file store over the MX25 SPI flash
+ * @details
+ *    A few append-only files, up to MX25LOG_MAX_FILES, share an area of
+ *    4 kB sectors that is written as one circular log of 256 byte pages.
+ *    Each page holds a 16 byte header, with the file number, the offset of
+ *    the data in the file, a sequence number and checks, and up to
+ *    MX25LOG_PAGE_DATA bytes of data of one file.
+ *
+ *    MX25LOG_Append() only copies data into a RAM page buffer, so it never
+ *    waits for the flash and may be called from a sampling interrupt. Full
+ *    pages are programmed with MX25_PP_Async() by MX25LOG_Process(), which
+ *    the main loop calls every MX25_ASYNC_POLL_MS. Sectors are erased with
+ *    MX25_SE_Async(), also from MX25LOG_Process().
+ *
+ *    The sector after the one being written is kept erased. When no other
+ *    sector is left, the oldest sector is collected: its live pages are
+ *    copied to the head of the log, read by the LDMA when MX25_USE_LDMA is
+ *    defined, and the sector is erased. Pages of deleted files are not
+ *    copied, and with wrap set the oldest pages are dropped when the log is
+ *    full of live data. Every sector is erased once per lap of the log, so
+ *    the wear is level, and data that is never deleted is moved along.
+ *
+ *    MX25LOG_Init() reads every page header once after reset to rebuild
+ *    the RAM index: the files present in each sector and the size of each
+ *    file. A page torn by a reset fails its header check and is skipped.
+ *    Only data in flash can be read, data still in RAM is lost on a reset;
+ *    MX25LOG_Flush() writes the partly filled page of a file.
+ * @{
+ ******************************************************************************/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Files, numbered 0 to MX25LOG_MAX_FILES - 1, at most 8 */
+#ifndef MX25LOG_MAX_FILES
+#define MX25LOG_MAX_FILES       4
+#endif
+
+/** Sectors the RAM index can hold, one byte of RAM each */
+#ifndef MX25LOG_MAX_SECTORS
+#define MX25LOG_MAX_SECTORS     256
+#endif
+
+/** RAM page buffers, shared by the files; more cover longer flash stalls */
+#ifndef MX25LOG_BUFFERS
+#define MX25LOG_BUFFERS         6
+#endif
+
+#if (MX25LOG_MAX_FILES < 1) || (MX25LOG_MAX_FILES > 8)
+#error "MX25LOG_MAX_FILES must be 1 to 8"
+#endif
+
+#if MX25LOG_BUFFERS < 2
+#error "MX25LOG_BUFFERS must be at least 2"
+#endif
+
+/** Data bytes per 256 byte page */
+#define MX25LOG_PAGE_DATA       (Page_Offset - 16)
+
+/** Return values */
+typedef enum {
+  mx25logOk,
+  mx25logBusy,            /**< Flash operation in progress, try again */
+  mx25logNoBuffer,        /**< No free page buffer, data dropped */
+  mx25logFull,            /**< Log full of live data, data dropped */
+  mx25logBadFile,         /**< No such file number */
+  mx25logCorrupt,         /**< A page read back failed its data check */
+} MX25LOG_Status_TypeDef;
+
+/** Area of the log */
+typedef struct {
+  uint32_t base;          /**< Flash address of the first sector */
+  uint32_t sectors;       /**< Sectors, 3 to MX25LOG_MAX_SECTORS */
+  bool     wrap;          /**< Drop the oldest data when full */
+} MX25LOG_Init_TypeDef;
+
+/** Counters, all only ever count up */
+typedef struct {
+  uint32_t pagesWritten;  /**< Data and delete pages programmed */
+  uint32_t pagesCopied;   /**< Live pages moved by collection */
+  uint32_t pagesDropped;  /**< Live pages erased by wrapping */
+  uint32_t sectorsErased; /**< Sector erases */
+  uint32_t bytesDropped;  /**< Appended bytes lost, no buffer or full */
+  uint32_t flashErrors;   /**< Program or erase timeouts */
+  uint32_t tornPages;     /**< Pages found torn by MX25LOG_Init() */
+} MX25LOG_Counters_TypeDef;
+
+bool MX25LOG_Init(const MX25LOG_Init_TypeDef *init);
+MX25LOG_Status_TypeDef MX25LOG_Append(uint8_t file, const void *data,
+                                      uint32_t length);
+MX25LOG_Status_TypeDef MX25LOG_Flush(uint8_t file);
+MX25LOG_Status_TypeDef MX25LOG_Delete(uint8_t file);
+MX25LOG_Status_TypeDef MX25LOG_Read(uint8_t file, uint32_t offset,
+                                    void *buffer, uint32_t length,
+                                    uint32_t *count);
+uint32_t MX25LOG_Size(uint8_t file);
+bool MX25LOG_Process(void);
+bool MX25LOG_Idle(void);
+void MX25LOG_GetCounters(MX25LOG_Counters_TypeDef *counters);
+
+#ifdef __cplusplus
+}
+#endif
+
+/** @} (end group Mx25Log) */
+/** @} (end group kitdrv) */
+
+#endif
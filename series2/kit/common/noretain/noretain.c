@@ -0,0 +1,152 @@
+/***************************************************************************//**
+ * @file
+ * @brief Non-retained RAM buffers and heap for Series 2.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2022 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ******************************************************************************/
+
+
+#include "em_device.h"
+#include "em_emu.h"
+#include "noretain.h"
+
+/***************************************************************************//**
+ * @addtogroup kitdrv
+ * @{
+ ******************************************************************************/
+
+/***************************************************************************//**
+ * @addtogroup NoRetain
+ * @{
+ ******************************************************************************/
+
+#if !defined(__GNUC__)
+#error "NoRetain needs the GCC 16 KB RAM retention linker scripts"
+#endif
+
+// Set by the linker script: the RAM_NORET region and the part of it the
+// .noretain section leaves for the heap
+extern char __NoRetainRamStart[];
+extern char __NoRetainHeapBase[];
+extern char __NoRetainHeapLimit[];
+
+// Next free byte of the heap, 0 until the first allocation
+static uintptr_t heapNext;
+
+/***************************************************************************//**
+ * @brief
+ *   First free byte of the heap, aligned
+ ******************************************************************************/
+static uintptr_t heapStart(void)
+{
+  return ((uintptr_t)__NoRetainHeapBase + NORETAIN_ALIGN - 1)
+         & ~(uintptr_t)(NORETAIN_ALIGN - 1);
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Free all NORETAIN_Alloc() blocks at once.
+ ******************************************************************************/
+void NORETAIN_Reset(void)
+{
+  heapNext = heapStart();
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Allocate a block of non-retained RAM.
+ *
+ * @details
+ *   The block is not cleared and is aligned to NORETAIN_ALIGN. It stays
+ *   allocated until NORETAIN_Reset(), but its content is lost in EM2 and
+ *   EM3 after NORETAIN_PowerDown().
+ *
+ * @param[in] size
+ *   Bytes to allocate.
+ *
+ * @return
+ *   The block, or NULL if the heap has less than @p size bytes left.
+ ******************************************************************************/
+void *NORETAIN_Alloc(size_t size)
+{
+  uintptr_t block;
+
+  if (heapNext == 0) {
+    NORETAIN_Reset();
+  }
+
+  size = (size + NORETAIN_ALIGN - 1) & ~(size_t)(NORETAIN_ALIGN - 1);
+  if (size > NORETAIN_Available()) {
+    return NULL;
+  }
+
+  block = heapNext;
+  heapNext += size;
+  return (void *)block;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Bytes the heap has left.
+ ******************************************************************************/
+size_t NORETAIN_Available(void)
+{
+  uintptr_t next = (heapNext == 0) ? heapStart() : heapNext;
+  uintptr_t limit = (uintptr_t)__NoRetainHeapLimit;
+
+  return (next < limit) ? (size_t)(limit - next) : 0;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Check if a pointer is in non-retained RAM.
+ *
+ * @details
+ *   Useful to assert that nothing meant to survive a sleep was placed
+ *   there.
+ ******************************************************************************/
+bool NORETAIN_Contains(const void *p)
+{
+  return ((uintptr_t)p >= (uintptr_t)__NoRetainRamStart)
+         && ((uintptr_t)p < (uintptr_t)__NoRetainHeapLimit);
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Stop retaining the RAM_NORET blocks in EM2 and EM3.
+ *
+ * @details
+ *   Takes effect from the next EM2 or EM3 entry and lasts until reset. The
+ *   blocks keep working in EM0 and EM1. Any DMA into non-retained RAM must
+ *   be stopped before each sleep.
+ ******************************************************************************/
+void NORETAIN_PowerDown(void)
+{
+  EMU_RamPowerDown((uint32_t)__NoRetainRamStart, 0);
+}
+
+/** @} (end group NoRetain) */
+/** @} (end group kitdrv) */
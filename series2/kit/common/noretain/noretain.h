@@ -0,0 +1,92 @@
+/***************************************************************************//**
+ * @file
+ * @brief Non-retained RAM buffers and heap for Series 2.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2022 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ******************************************************************************/
+
+
+#ifndef __NORETAIN_H
+#define __NORETAIN_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/***************************************************************************//**
+ * @addtogroup kitdrv
+ * @{
+ ******************************************************************************/
+
+/***************************************************************************//**
+ * @addtogroup NoRetain
+ * @brief Non-retained RAM buffers and heap
+ * @details
+ *    The 16 KB RAM retention linker scripts in linker_scripts split RAM in
+ *    two regions. RAM, the first 16 KB block, holds the data, the stack
+ *    and the heap of malloc() and is retained in EM2 and EM3. RAM_NORET,
+ *    the rest, holds the .noretain section and the non-retained heap of
+ *    this driver. After NORETAIN_PowerDown() the RAM_NORET blocks are no
+ *    longer retained in EM2 and EM3, which saves their retention current.
+ *
+ *    Non-retained RAM works as any other RAM in EM0 and EM1, but holds
+ *    garbage after every wakeup from EM2 or EM3, and after a reset: it is
+ *    neither loaded nor zeroed by the startup code. It suits scratch
+ *    buffers that are filled and used between two sleeps, such as FFT
+ *    work areas and DMA rings, which are stopped before the sleep.
+ *
+ *    Static buffers are placed with NORETAIN_BUFFER, dynamic ones come
+ *    from NORETAIN_Alloc(). The heap is an arena: allocations are freed
+ *    all at once with NORETAIN_Reset(), typically at the start of each
+ *    work cycle. Only GCC with the 16 KB retention linker scripts is
+ *    supported.
+ * @{
+ ******************************************************************************/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Place a static buffer in non-retained RAM, not initialized */
+#define NORETAIN_BUFFER   __attribute__((section(".noretain")))
+
+/** Alignment of each NORETAIN_Alloc() block, enough for any type */
+#define NORETAIN_ALIGN    8U
+
+void   NORETAIN_Reset(void);
+void  *NORETAIN_Alloc(size_t size);
+size_t NORETAIN_Available(void);
+bool   NORETAIN_Contains(const void *p);
+void   NORETAIN_PowerDown(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+/** @} (end group NoRetain) */
+/** @} (end group kitdrv) */
+
+#endif
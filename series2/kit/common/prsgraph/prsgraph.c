@@ -0,0 +1,428 @@
+/***************************************************************************//**
+ * @file
+ * @brief Channel allocation for chains of PRS producers, logic and consumers.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2022 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ******************************************************************************/
+
+#include "em_cmu.h"
+#include "prsgraph.h"
+
+/***************************************************************************//**
+ * @addtogroup kitdrv
+ * @{
+ ******************************************************************************/
+
+/***************************************************************************//**
+ * @addtogroup PrsGraph
+ * @{
+ ******************************************************************************/
+
+// Logic input B must come from the channel just below on these devices
+#if (_SILICON_LABS_32B_SERIES_2_CONFIG == 1) \
+  || (_SILICON_LABS_32B_SERIES_2_CONFIG == 4)
+#define INPUT_B_ADJACENT
+#endif
+
+#define ALL_CHANNELS      ((1UL << PRS_ASYNC_CHAN_COUNT) - 1)
+
+// Channels that can be routed to ports A and B, and to ports C and D
+#define LOW_PIN_CHANNELS  (0x03FUL & ALL_CHANNELS)
+#define HIGH_PIN_CHANNELS (0xFC0UL & ALL_CHANNELS)
+
+typedef struct {
+  uint32_t    source;     // Producer, and logic input A
+  uint32_t    signal;
+  int         inputB;     // Node for logic input B, or PRSGRAPH_NONE
+  PRS_Logic_t logic;
+  uint32_t    allowed;    // Channels the node can be placed at
+  int         channel;    // Channel allocated by PRSGRAPH_Build()
+} Node_t;
+
+typedef struct {
+  int         node;
+  bool        pin;        // Pin, or consumer
+  uint32_t    target;     // Consumer, or port << 8 | pin
+} Link_t;
+
+static Node_t   nodes[PRSGRAPH_MAX_NODES];
+static Link_t   links[PRSGRAPH_MAX_LINKS];
+static uint32_t nodeCount;
+static uint32_t linkCount;
+static uint32_t reserved;
+static bool     built;
+
+/**************************************************************************//**
+ * @brief Check that a node has been declared
+ *****************************************************************************/
+static bool validNode(int node)
+{
+  return (node >= 0) && ((uint32_t)node < nodeCount);
+}
+
+/**************************************************************************//**
+ * @brief Declare a node, returns its index or PRSGRAPH_NONE
+ *****************************************************************************/
+static int addNode(uint32_t source,
+                   uint32_t signal,
+                   int inputB,
+                   PRS_Logic_t logic)
+{
+  Node_t *n;
+
+  if (built || (nodeCount >= PRSGRAPH_MAX_NODES)) {
+    return PRSGRAPH_NONE;
+  }
+
+  n = &nodes[nodeCount];
+  n->source = source;
+  n->signal = signal;
+  n->inputB = inputB;
+  n->logic = logic;
+  n->allowed = ALL_CHANNELS;
+  n->channel = PRSGRAPH_NONE;
+
+  return (int)nodeCount++;
+}
+
+/**************************************************************************//**
+ * @brief Find the link that drives a consumer or pin, or PRSGRAPH_NONE
+ *****************************************************************************/
+static int findLink(bool pin, uint32_t target)
+{
+  uint32_t i;
+
+  for (i = 0; i < linkCount; i++) {
+    if ((links[i].pin == pin) && (links[i].target == target)) {
+      return (int)i;
+    }
+  }
+
+  return PRSGRAPH_NONE;
+}
+
+/**************************************************************************//**
+ * @brief Record a link, unless its target is already driven
+ *****************************************************************************/
+static bool addLink(int node, bool pin, uint32_t target)
+{
+  int other = findLink(pin, target);
+
+  if (other != PRSGRAPH_NONE) {
+    // Declaring the same link again is harmless, a second driver is not
+    return links[other].node == node;
+  }
+  if (built || (linkCount >= PRSGRAPH_MAX_LINKS)) {
+    return false;
+  }
+
+  links[linkCount].node = node;
+  links[linkCount].pin = pin;
+  links[linkCount].target = target;
+  linkCount++;
+
+  return true;
+}
+
+/**************************************************************************//**
+ * @brief Count the bits set in a channel mask
+ *****************************************************************************/
+static uint32_t countChannels(uint32_t mask)
+{
+  uint32_t count = 0;
+
+  while (mask) {
+    mask &= mask - 1;
+    count++;
+  }
+
+  return count;
+}
+
+/**************************************************************************//**
+ * @brief Check that there are enough free channels for each pin group
+ *
+ * @details
+ *    Rules out the graphs that can not fit before the search, which would
+ *    otherwise try every order of the nodes before giving up.
+ *****************************************************************************/
+static bool enoughChannels(void)
+{
+  uint32_t free = ALL_CHANNELS & ~reserved;
+  uint32_t low = 0, high = 0;
+  uint32_t i;
+
+  for (i = 0; i < nodeCount; i++) {
+    if (nodes[i].allowed == LOW_PIN_CHANNELS) {
+      low++;
+    } else if (nodes[i].allowed == HIGH_PIN_CHANNELS) {
+      high++;
+    }
+  }
+
+  return (nodeCount <= countChannels(free))
+         && (low <= countChannels(free & LOW_PIN_CHANNELS))
+         && (high <= countChannels(free & HIGH_PIN_CHANNELS));
+}
+
+/**************************************************************************//**
+ * @brief Place the nodes from the given one on, backtracking on a dead end
+ *
+ * @details
+ *    Nodes are placed in the order they were declared, so the node feeding
+ *    input B of a logic node is always placed first.
+ *****************************************************************************/
+static bool place(uint32_t index, uint32_t used)
+{
+  Node_t *n;
+  uint32_t candidates;
+  int ch;
+
+  if (index == nodeCount) {
+    return true;
+  }
+
+  n = &nodes[index];
+  candidates = n->allowed & ~used & ~reserved;
+
+#if defined(INPUT_B_ADJACENT)
+  if (n->inputB != PRSGRAPH_NONE) {
+    candidates &= (1UL << (nodes[n->inputB].channel + 1)) & ALL_CHANNELS;
+  }
+#endif
+
+  for (ch = 0; ch < PRS_ASYNC_CHAN_COUNT; ch++) {
+    if (candidates & (1UL << ch)) {
+      n->channel = ch;
+      if (place(index + 1, used | (1UL << ch))) {
+        return true;
+      }
+    }
+  }
+
+  n->channel = PRSGRAPH_NONE;
+  return false;
+}
+
+/**************************************************************************//**
+ * @brief Start declaring a new graph
+ *****************************************************************************/
+void PRSGRAPH_Init(void)
+{
+  nodeCount = 0;
+  linkCount = 0;
+  reserved = 0;
+  built = false;
+}
+
+/**************************************************************************//**
+ * @brief Keep channels out of the allocation
+ *
+ * @param[in] channelMask
+ *    Bit n set to leave asynchronous channel n alone. Adds to the channels
+ *    reserved before.
+ *****************************************************************************/
+void PRSGRAPH_Reserve(uint32_t channelMask)
+{
+  reserved |= channelMask & ALL_CHANNELS;
+}
+
+/**************************************************************************//**
+ * @brief Declare a producer
+ *
+ * @param[in] source
+ *    PRS_ASYNC_CH_CTRL_SOURCESEL_xxx, as for PRS_SourceAsyncSignalSet().
+ *
+ * @param[in] signal
+ *    The signal of the source, as for PRS_SourceAsyncSignalSet().
+ *
+ * @return
+ *    The node, or PRSGRAPH_NONE if the graph is full or already built.
+ *****************************************************************************/
+int PRSGRAPH_Source(uint32_t source, uint32_t signal)
+{
+  return addNode(source, signal, PRSGRAPH_NONE, prsLogic_A);
+}
+
+/**************************************************************************//**
+ * @brief Declare a logic function of a producer and another node
+ *
+ * @details
+ *    The producer is input A and the output of the inputB node input B.
+ *    Chains of logic functions are built by using one logic node as input
+ *    B of the next.
+ *
+ * @param[in] source
+ *    PRS_ASYNC_CH_CTRL_SOURCESEL_xxx of input A.
+ *
+ * @param[in] signal
+ *    The signal of the source of input A.
+ *
+ * @param[in] inputB
+ *    Node for input B, or PRSGRAPH_NONE for a function of input A only,
+ *    such as prsLogic_Not_A.
+ *
+ * @param[in] logic
+ *    The logic function.
+ *
+ * @return
+ *    The node, or PRSGRAPH_NONE if inputB has not been declared, or the
+ *    graph is full or already built.
+ *****************************************************************************/
+int PRSGRAPH_Logic(uint32_t source,
+                   uint32_t signal,
+                   int inputB,
+                   PRS_Logic_t logic)
+{
+  if ((inputB != PRSGRAPH_NONE) && !validNode(inputB)) {
+    return PRSGRAPH_NONE;
+  }
+
+  return addNode(source, signal, inputB, logic);
+}
+
+/**************************************************************************//**
+ * @brief Drive a consumer from a node
+ *
+ * @return
+ *    false if the node has not been declared, or another node already
+ *    drives the consumer.
+ *****************************************************************************/
+bool PRSGRAPH_Consumer(int node, PRS_Consumer_t consumer)
+{
+  if (!validNode(node)) {
+    return false;
+  }
+
+  return addLink(node, false, (uint32_t)consumer);
+}
+
+/**************************************************************************//**
+ * @brief Drive a pin from a node
+ *
+ * @return
+ *    false if the node has not been declared, another node already drives
+ *    the pin, or the node already drives a pin of the other port group.
+ *****************************************************************************/
+bool PRSGRAPH_Pin(int node, GPIO_Port_TypeDef port, uint8_t pin)
+{
+  uint32_t group;
+
+  if (!validNode(node)) {
+    return false;
+  }
+
+  group = (port <= gpioPortB) ? LOW_PIN_CHANNELS : HIGH_PIN_CHANNELS;
+  if (!(nodes[node].allowed & group)) {
+    return false;
+  }
+  if (!addLink(node, true, ((uint32_t)port << 8) | pin)) {
+    return false;
+  }
+
+  nodes[node].allowed &= group;
+  return true;
+}
+
+/**************************************************************************//**
+ * @brief Allocate the channels and configure the PRS
+ *
+ * @details
+ *    The producers and logic functions are configured before the consumers
+ *    and pins are connected, so the consumers only see the final outputs.
+ *    The PRS is not touched if the graph does not fit.
+ *
+ * @return
+ *    false if no allocation meets the constraints.
+ *****************************************************************************/
+bool PRSGRAPH_Build(void)
+{
+  uint32_t i;
+  Node_t *n;
+  Link_t *l;
+
+  if (built) {
+    return true;
+  }
+  if (!enoughChannels() || !place(0, 0)) {
+    return false;
+  }
+
+  CMU_ClockEnable(cmuClock_PRS, true);
+
+  for (i = 0; i < nodeCount; i++) {
+    n = &nodes[i];
+    PRS_SourceAsyncSignalSet(n->channel, n->source, n->signal);
+  }
+
+  for (i = 0; i < nodeCount; i++) {
+    n = &nodes[i];
+    if (n->inputB != PRSGRAPH_NONE) {
+      PRS_Combine(n->channel, nodes[n->inputB].channel, n->logic);
+    } else if (n->logic != prsLogic_A) {
+      // Functions of input A only, input B is not used
+      PRS->ASYNC_CH[n->channel].CTRL =
+        (PRS->ASYNC_CH[n->channel].CTRL & ~_PRS_ASYNC_CH_CTRL_FNSEL_MASK)
+        | ((uint32_t)n->logic << _PRS_ASYNC_CH_CTRL_FNSEL_SHIFT);
+    }
+  }
+
+  for (i = 0; i < linkCount; i++) {
+    l = &links[i];
+    if (l->pin) {
+      PRS_PinOutput(nodes[l->node].channel, prsTypeAsync,
+                    (GPIO_Port_TypeDef)(l->target >> 8), l->target & 0xFF);
+    } else {
+      PRS_ConnectConsumer(nodes[l->node].channel, prsTypeAsync,
+                          (PRS_Consumer_t)l->target);
+    }
+  }
+
+  built = true;
+  return true;
+}
+
+/**************************************************************************//**
+ * @brief Get the channel allocated to a node
+ *
+ * @return
+ *    The asynchronous channel, or PRSGRAPH_NONE before PRSGRAPH_Build().
+ *****************************************************************************/
+int PRSGRAPH_GetChannel(int node)
+{
+  return (built && validNode(node)) ? nodes[node].channel : PRSGRAPH_NONE;
+}
+
+/**************************************************************************//**
+ * @brief Get the nodes declared
+ *****************************************************************************/
+uint32_t PRSGRAPH_GetNodeCount(void)
+{
+  return nodeCount;
+}
+
+/** @} (end group PrsGraph) */
+/** @} (end group kitdrv) */
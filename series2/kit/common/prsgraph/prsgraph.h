@@ -0,0 +1,109 @@
+/***************************************************************************//**
+ * @file
+ * @brief Channel allocation for chains of PRS producers, logic and consumers.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2022 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ******************************************************************************/
+
+#ifndef __PRSGRAPH_H
+#define __PRSGRAPH_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "em_device.h"
+#include "em_gpio.h"
+#include "em_prs.h"
+
+/***************************************************************************//**
+ * @addtogroup kitdrv
+ * @{
+ ******************************************************************************/
+
+/***************************************************************************//**
+ * @addtogroup PrsGraph
+ * @brief Declare PRS links, let the allocator pick the channels
+ * @details
+ *    Instead of fixing a channel number for each PRS link by hand, the
+ *    application declares a graph: producers, logic functions that
+ *    combine a producer with the output of another node, and the
+ *    consumers and pins each node drives. PRSGRAPH_Build() then finds an
+ *    asynchronous channel for every node that meets the constraints of
+ *    the device, checks that no consumer or pin is driven twice, and only
+ *    then configures the PRS.
+ *
+ *    The constraints taken into account are:
+ *    - Input A of the logic function of a channel is its own producer,
+ *      input B is the output of any other channel. On EFR32xG21 and
+ *      EFR32xG24, input B can only be the channel just below, which the
+ *      allocator then places the node at.
+ *    - Channels 0 to 5 can only be routed to pins of ports A and B,
+ *      channels 6 to 11 to pins of ports C and D.
+ *    - Channels in the mask passed to PRSGRAPH_Reserve(), for example
+ *      those set up by hand or by a radio stack, are not used.
+ *
+ *    Nodes are plain indices returned by the functions that declare them,
+ *    and graphs are declared once, at start-up. Calling PRSGRAPH_Init()
+ *    again starts a new graph but does not undo the PRS configuration of
+ *    the last one.
+ * @{
+ ******************************************************************************/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** No node, for nodes without a logic input B */
+#define PRSGRAPH_NONE           (-1)
+
+/** Most nodes in a graph, one per asynchronous channel */
+#define PRSGRAPH_MAX_NODES      PRS_ASYNC_CHAN_COUNT
+
+/** Most consumer and pin links in a graph */
+#ifndef PRSGRAPH_MAX_LINKS
+#define PRSGRAPH_MAX_LINKS      16
+#endif
+
+void  PRSGRAPH_Init(void);
+void  PRSGRAPH_Reserve(uint32_t channelMask);
+int   PRSGRAPH_Source(uint32_t source, uint32_t signal);
+int   PRSGRAPH_Logic(uint32_t source,
+                     uint32_t signal,
+                     int inputB,
+                     PRS_Logic_t logic);
+bool  PRSGRAPH_Consumer(int node, PRS_Consumer_t consumer);
+bool  PRSGRAPH_Pin(int node, GPIO_Port_TypeDef port, uint8_t pin);
+bool  PRSGRAPH_Build(void);
+int   PRSGRAPH_GetChannel(int node);
+uint32_t PRSGRAPH_GetNodeCount(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+/** @} (end group PrsGraph) */
+/** @} (end group kitdrv) */
+
+#endif
@@ -0,0 +1,80 @@
+/***************************************************************************//**
+ * @file
+ * @brief Constant register images for straight-line peripheral setup.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2022 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ******************************************************************************/
+
+
+#include "regimage.h"
+
+/***************************************************************************//**
+ * @addtogroup kitdrv
+ * @{
+ ******************************************************************************/
+
+/***************************************************************************//**
+ * @addtogroup RegImage
+ * @{
+ ******************************************************************************/
+
+/***************************************************************************//**
+ * @brief
+ *   Write a register image to the peripherals.
+ *
+ * @param[in] image
+ *   The entries, in the order they are applied.
+ *
+ * @param[in] count
+ *   Number of entries, REGIMAGE_COUNT() of the array.
+ ******************************************************************************/
+void REGIMAGE_Apply(const REGIMAGE_Entry_t *image, size_t count)
+{
+  const REGIMAGE_Entry_t *end = image + count;
+
+  for (; image < end; image++) {
+    volatile uint32_t *reg =
+      (volatile uint32_t *)(image->addr & ~REGIMAGE_OP_MASK);
+
+    switch (image->addr & REGIMAGE_OP_MASK) {
+      case REGIMAGE_OP_WRITE:
+        *reg = image->value;
+        break;
+
+      case REGIMAGE_OP_FIELD:
+        *reg = (*reg & ~image->mask) | image->value;
+        break;
+
+      default:
+        while ((*reg & image->mask) != image->value) {
+        }
+        break;
+    }
+  }
+}
+
+/** @} (end group RegImage) */
+/** @} (end group kitdrv) */
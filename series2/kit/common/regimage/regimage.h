@@ -0,0 +1,128 @@
+/***************************************************************************//**
+ * @file
+ * @brief Constant register images for straight-line peripheral setup.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2022 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ******************************************************************************/
+
+
+#ifndef __REGIMAGE_H
+#define __REGIMAGE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "em_device.h"
+
+/***************************************************************************//**
+ * @addtogroup kitdrv
+ * @{
+ ******************************************************************************/
+
+/***************************************************************************//**
+ * @addtogroup RegImage
+ * @brief Constant register images for straight-line peripheral setup
+ * @details
+ *    A peripheral setup through the emlib init functions builds a
+ *    *_Init_TypeDef on the stack and passes it to a *_Init() routine that
+ *    turns every field into register bits, with a branch per option. On
+ *    every wakeup from EM4, which is a reset, all of this runs again to
+ *    reach the same register values.
+ *
+ *    A register image is the result of that work, computed by the compiler:
+ *    a const table in flash of the register writes of one configuration,
+ *    with their values built from the register field macros of the device
+ *    header. REGIMAGE_Apply() runs down the table, so setting up the
+ *    peripheral after a wakeup is a short loop of stores with no decisions
+ *    left to make.
+ *
+ *    Each entry is one of:
+ *
+ *    - REGIMAGE_WRITE(reg, value): store value.
+ *    - REGIMAGE_FIELD(reg, mask, value): read, replace the mask bits by
+ *      value and store, for registers shared with other drivers, such as
+ *      the GPIO mode registers.
+ *    - REGIMAGE_WAIT(reg, mask, value): wait until the mask bits read as
+ *      value, such as a SYNCBUSY bit after a command.
+ *
+ *    REGIMAGE_GPIO_MODE() is the image of GPIO_PinModeSet(). The entries
+ *    go in the order the emlib init function writes the registers, the
+ *    order the reference manual requires. The table holds the register
+ *    addresses, so an image is for one peripheral instance.
+ * @{
+ ******************************************************************************/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Entry operations, kept in the two low bits of the register address */
+#define REGIMAGE_OP_WRITE     0U  /**< Store the value */
+#define REGIMAGE_OP_FIELD     1U  /**< Read, modify the mask bits, store */
+#define REGIMAGE_OP_WAIT      2U  /**< Wait for the mask bits to read value */
+#define REGIMAGE_OP_MASK      3U  /**< Operation bits of addr */
+
+/** One register operation of an image */
+typedef struct {
+  uint32_t addr;    /**< Register address | REGIMAGE_OP_x */
+  uint32_t mask;    /**< Bits changed or tested, all for a write */
+  uint32_t value;   /**< Value written or waited for */
+} REGIMAGE_Entry_t;
+
+/** Store value in reg */
+#define REGIMAGE_WRITE(reg, value) \
+  { (uint32_t)&(reg) | REGIMAGE_OP_WRITE, 0xFFFFFFFFUL, (uint32_t)(value) }
+
+/** Replace the mask bits of reg by value */
+#define REGIMAGE_FIELD(reg, mask, value) \
+  { (uint32_t)&(reg) | REGIMAGE_OP_FIELD, (uint32_t)(mask), (uint32_t)(value) }
+
+/** Wait until the mask bits of reg read as value */
+#define REGIMAGE_WAIT(reg, mask, value) \
+  { (uint32_t)&(reg) | REGIMAGE_OP_WAIT, (uint32_t)(mask), (uint32_t)(value) }
+
+/** Number of entries of an image array */
+#define REGIMAGE_COUNT(image)    (sizeof(image) / sizeof((image)[0]))
+
+#if defined(_SILICON_LABS_32B_SERIES_2)
+/** GPIO_PinModeSet(port, pin, mode, out), two entries: DOUT, then the mode */
+#define REGIMAGE_GPIO_MODE(port, pin, mode, out)                             \
+  REGIMAGE_FIELD(GPIO->P[port].DOUT, 1UL << (pin),                           \
+                 (uint32_t)((out) ? 1UL : 0UL) << (pin)),                    \
+  REGIMAGE_FIELD(*(((pin) < 8) ? &GPIO->P[port].MODEL : &GPIO->P[port].MODEH), \
+                 0xFUL << (((pin) % 8) * 4),                                 \
+                 (uint32_t)(mode) << (((pin) % 8) * 4))
+#endif
+
+void REGIMAGE_Apply(const REGIMAGE_Entry_t *image, size_t count);
+
+#ifdef __cplusplus
+}
+#endif
+
+/** @} (end group RegImage) */
+/** @} (end group kitdrv) */
+
+#endif
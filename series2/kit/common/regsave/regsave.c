@@ -0,0 +1,211 @@
+/***************************************************************************//**
+ * @file
+ * @brief Peripheral register save and restore across EM2 and EM3.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2022 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ******************************************************************************/
+
+
+
+#include "regsave.h"
+
+/***************************************************************************//**
+ * @addtogroup kitdrv
+ * @{
+ ******************************************************************************/
+
+/***************************************************************************//**
+ * @addtogroup RegSave
+ * @{
+ ******************************************************************************/
+
+/***************************************************************************//**
+ * @brief
+ *   Run a prepared descriptor chain on the reserved channel to its end.
+ ******************************************************************************/
+static void runChain(LDMA_Descriptor_t *desc)
+{
+  LDMA_TransferCfg_t cfg = LDMA_TRANSFER_CFG_MEMORY();
+
+  LDMA_StartTransfer(REGSAVE_CHANNEL, &cfg, desc);
+  while (!LDMA_TransferDone(REGSAVE_CHANNEL)) {
+  }
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Number of registers in a list of ranges, the size of the store.
+ *
+ * @param[in] ranges
+ *   The ranges.
+ *
+ * @param[in] rangeCount
+ *   Number of ranges.
+ *
+ * @return
+ *   The store size in words.
+ ******************************************************************************/
+size_t REGSAVE_Words(const REGSAVE_Range_t *ranges, size_t rangeCount)
+{
+  size_t words = 0;
+  size_t i;
+
+  for (i = 0; i < rangeCount; i++) {
+    words += ranges[i].count;
+  }
+
+  return words;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Set up a context for a list of register ranges.
+ *
+ * @details
+ *   Builds the descriptors of both directions and takes a copy of the
+ *   LDMA configuration, so LDMA_Init() must have been called.
+ *
+ * @param[out] ctx
+ *   The context, in retained RAM.
+ *
+ * @param[in] ranges
+ *   The ranges in restore order, kept by the context.
+ *
+ * @param[in] rangeCount
+ *   Number of ranges, up to REGSAVE_MAX_RANGES.
+ *
+ * @param[in] store
+ *   Words for the register values, in retained RAM.
+ *
+ * @param[in] storeWords
+ *   Size of the store, at least REGSAVE_Words() of the ranges.
+ *
+ * @return
+ *   False if there are too many ranges, a range is empty or longer than
+ *   one descriptor moves, or the store is too small.
+ ******************************************************************************/
+bool REGSAVE_Init(REGSAVE_Context_t *ctx, const REGSAVE_Range_t *ranges,
+                  size_t rangeCount, uint32_t *store, size_t storeWords)
+{
+  uint32_t *slot = store;
+  size_t i;
+
+  if ((rangeCount == 0) || (rangeCount > REGSAVE_MAX_RANGES)
+      || (REGSAVE_Words(ranges, rangeCount) > storeWords)) {
+    return false;
+  }
+  for (i = 0; i < rangeCount; i++) {
+    if ((ranges[i].count == 0)
+        || (ranges[i].count > LDMA_DESCRIPTOR_MAX_XFER_SIZE)) {
+      return false;
+    }
+  }
+
+  ctx->ranges     = ranges;
+  ctx->rangeCount = rangeCount;
+  ctx->store      = store;
+  ctx->words      = REGSAVE_Words(ranges, rangeCount);
+  ctx->useLdma    = (ctx->words >= REGSAVE_LDMA_THRESHOLD);
+  ctx->ldmaCtrl   = LDMA->CTRL;
+  ctx->ldmaIen    = LDMA->IEN;
+
+  for (i = 0; i < rangeCount; i++) {
+    ctx->saveDesc[i] = (LDMA_Descriptor_t)
+      LDMA_DESCRIPTOR_LINKREL_M2M_WORD(ranges[i].first, slot,
+                                       ranges[i].count, 1);
+    ctx->saveDesc[i].xfer.doneIfs = 0;
+    ctx->restoreDesc[i] = (LDMA_Descriptor_t)
+      LDMA_DESCRIPTOR_LINKREL_M2M_WORD(slot, ranges[i].first,
+                                       ranges[i].count, 1);
+    ctx->restoreDesc[i].xfer.doneIfs = 0;
+    slot += ranges[i].count;
+  }
+  ctx->saveDesc[rangeCount - 1].xfer.link    = 0;
+  ctx->restoreDesc[rangeCount - 1].xfer.link = 0;
+
+  return true;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Copy the registers to the store, right before the sleep.
+ *
+ * @param[in] ctx
+ *   The context.
+ ******************************************************************************/
+void REGSAVE_Save(REGSAVE_Context_t *ctx)
+{
+  const REGSAVE_Range_t *range;
+  uint32_t *slot = ctx->store;
+  uint32_t j;
+
+  if (ctx->useLdma) {
+    runChain(ctx->saveDesc);
+    return;
+  }
+  for (range = ctx->ranges; range < ctx->ranges + ctx->rangeCount; range++) {
+    for (j = 0; j < range->count; j++) {
+      *slot++ = range->first[j];
+    }
+  }
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Write the store back to the registers, right after the wakeup.
+ *
+ * @details
+ *   Does nothing to registers that were retained but writes them all the
+ *   same, so it can be called after every wakeup.
+ *
+ * @param[in] ctx
+ *   The context.
+ ******************************************************************************/
+void REGSAVE_Restore(REGSAVE_Context_t *ctx)
+{
+  const REGSAVE_Range_t *range;
+  const uint32_t *slot = ctx->store;
+  uint32_t j;
+
+  if (ctx->useLdma) {
+    // The LDMA lost its registers with the other EM0/1 peripherals
+    if ((LDMA->EN & LDMA_EN_EN) == 0U) {
+      LDMA->EN   = LDMA_EN_EN;
+      LDMA->CTRL = ctx->ldmaCtrl;
+      LDMA->IEN  = ctx->ldmaIen;
+    }
+    runChain(ctx->restoreDesc);
+    return;
+  }
+  for (range = ctx->ranges; range < ctx->ranges + ctx->rangeCount; range++) {
+    for (j = 0; j < range->count; j++) {
+      range->first[j] = *slot++;
+    }
+  }
+}
+
+/** @} (end group RegSave) */
+/** @} (end group kitdrv) */
@@ -0,0 +1,135 @@
+/***************************************************************************//**
+ * @file
+ * @brief Peripheral register save and restore across EM2 and EM3.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2022 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ******************************************************************************/
+
+
+#ifndef __REGSAVE_H
+#define __REGSAVE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "em_device.h"
+#include "em_ldma.h"
+
+/***************************************************************************//**
+ * @addtogroup kitdrv
+ * @{
+ ******************************************************************************/
+
+/***************************************************************************//**
+ * @addtogroup RegSave
+ * @brief Peripheral register save and restore across EM2 and EM3
+ * @details
+ *    From xG22, bit 0 of EMU_PD1PARETCTRL turns off the retention of the
+ *    EM0/1 peripheral registers in EM2 and EM3, which saves 0.2 to 0.5 uA.
+ *    The registers of the TIMERs, USARTs, the LDMA and the other EM0/1
+ *    peripherals are then reset on each wakeup, and the application would
+ *    have to go through its whole peripheral setup again.
+ *
+ *    This driver copies a list of register ranges to a store in RAM,
+ *    which is retained, before the sleep, and writes them back after the
+ *    wakeup. The ranges are set up once with REGSAVE_Init(), which also
+ *    builds the LDMA descriptors of both directions, one per range, so
+ *    REGSAVE_Save() and REGSAVE_Restore() only start a channel and wait
+ *    for it. Contexts of fewer than REGSAVE_LDMA_THRESHOLD words are
+ *    copied by the CPU instead, which is faster for a few registers.
+ *    The LDMA is an EM0/1 peripheral itself: REGSAVE_Restore() brings its
+ *    own registers back first if they were lost.
+ *
+ *    The ranges are restored in the order of the list, each from its
+ *    lowest address up, which must be an order the peripheral accepts:
+ *    most series 2 peripherals take their CFG registers only while
+ *    disabled, and their other registers only while enabled, so a
+ *    peripheral takes a range for its CFG registers, then its EN
+ *    register, then its control and data registers. Registers that act
+ *    on a write, like CMD, IF or a TX data register, must not be in a
+ *    range; the application issues the commands, such as a TIMER start,
+ *    after REGSAVE_Restore(). The peripheral clocks are enabled in the
+ *    CMU, which is retained.
+ *
+ *    The application calls LDMA_Init() once before REGSAVE_Init(), does
+ *    not use REGSAVE_CHANNEL for anything else, and keeps the context,
+ *    the ranges and the store in RAM that is retained in EM2.
+ * @{
+ ******************************************************************************/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef REGSAVE_CHANNEL
+#define REGSAVE_CHANNEL           (DMA_CHAN_COUNT - 6)  /**< Reserved channel, below the LdmaMem one */
+#endif
+
+#ifndef REGSAVE_MAX_RANGES
+#define REGSAVE_MAX_RANGES        8     /**< Ranges per context, one descriptor each way */
+#endif
+
+#ifndef REGSAVE_LDMA_THRESHOLD
+#define REGSAVE_LDMA_THRESHOLD    32    /**< Words from which the LDMA copies */
+#endif
+
+/** Consecutive 32 bit registers */
+typedef struct {
+  volatile uint32_t *first;   /**< Lowest register */
+  uint32_t          count;    /**< Registers from first up */
+} REGSAVE_Range_t;
+
+/** Range from register first to register last, both included */
+#define REGSAVE_RANGE(first, last) \
+  { &(first), (uint32_t)(&(last) - &(first)) + 1U }
+
+/** A list of ranges with its store and descriptors */
+typedef struct {
+  const REGSAVE_Range_t *ranges;                    /**< Ranges, in restore order */
+  size_t                rangeCount;                 /**< Number of ranges */
+  uint32_t              *store;                     /**< Register values */
+  size_t                words;                      /**< Registers in all ranges */
+  bool                  useLdma;                    /**< At least the threshold */
+  uint32_t              ldmaCtrl;                   /**< LDMA CTRL at REGSAVE_Init() */
+  uint32_t              ldmaIen;                    /**< LDMA IEN at REGSAVE_Init() */
+  LDMA_Descriptor_t     saveDesc[REGSAVE_MAX_RANGES];    /**< Registers to store */
+  LDMA_Descriptor_t     restoreDesc[REGSAVE_MAX_RANGES]; /**< Store to registers */
+} REGSAVE_Context_t;
+
+bool   REGSAVE_Init(REGSAVE_Context_t *ctx, const REGSAVE_Range_t *ranges,
+                    size_t rangeCount, uint32_t *store, size_t storeWords);
+size_t REGSAVE_Words(const REGSAVE_Range_t *ranges, size_t rangeCount);
+void   REGSAVE_Save(REGSAVE_Context_t *ctx);
+void   REGSAVE_Restore(REGSAVE_Context_t *ctx);
+
+#ifdef __cplusplus
+}
+#endif
+
+/** @} (end group RegSave) */
+/** @} (end group kitdrv) */
+
+#endif
@@ -0,0 +1,323 @@
+/***************************************************************************//**
+ * @file
+ * @brief Lossless delta and Rice coding of sample blocks.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2022 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ******************************************************************************/
+
+#include "samplecodec.h"
+
+/***************************************************************************//**
+ * @addtogroup kitdrv
+ * @{
+ ******************************************************************************/
+
+/***************************************************************************//**
+ * @addtogroup SampleCodec
+ * @{
+ ******************************************************************************/
+
+// k of a block stored as plain samples
+#define K_RAW           0x0F
+
+// Largest k of a coded block
+#define K_MAX           14
+
+// Bits are collected in a word and written out a byte at a time
+typedef struct {
+  uint8_t  *out;
+  uint32_t acc;
+  uint32_t bits;
+} Writer_t;
+
+typedef struct {
+  const uint8_t *in;
+  const uint8_t *end;
+  uint32_t      acc;
+  uint32_t      bits;
+} Reader_t;
+
+/**************************************************************************//**
+ * @brief Zig-zag map a wrapped difference: 0, -1, 1, -2 to 0, 1, 2, 3
+ *****************************************************************************/
+static uint32_t zigzag(int16_t sample, int16_t previous)
+{
+  int16_t d = (int16_t)(uint16_t)((uint16_t)sample - (uint16_t)previous);
+
+  return (uint16_t)(((uint16_t)d << 1) ^ (uint16_t)(d >> 15));
+}
+
+/**************************************************************************//**
+ * @brief Append up to 24 bits, the writer holds less than 8 on entry
+ *****************************************************************************/
+static void putBits(Writer_t *w, uint32_t value, uint32_t bits)
+{
+  w->acc = (w->acc << bits) | value;
+  w->bits += bits;
+  while (w->bits >= 8) {
+    w->bits -= 8;
+    *w->out++ = (uint8_t)(w->acc >> w->bits);
+  }
+}
+
+/**************************************************************************//**
+ * @brief Take the next bits, up to 24; false past the end of the block
+ *****************************************************************************/
+static bool getBits(Reader_t *r, uint32_t bits, uint32_t *value)
+{
+  while (r->bits < bits) {
+    if (r->in == r->end) {
+      return false;
+    }
+    r->acc = (r->acc << 8) | *r->in++;
+    r->bits += 8;
+  }
+  r->bits -= bits;
+  *value = (r->acc >> r->bits) & ((1UL << bits) - 1);
+  return true;
+}
+
+/**************************************************************************//**
+ * @brief Count the ones before the next zero, up to SAMPLECODEC_ESCAPE
+ *****************************************************************************/
+static bool getUnary(Reader_t *r, uint32_t *ones)
+{
+  uint32_t bit;
+
+  *ones = 0;
+  while (*ones < SAMPLECODEC_ESCAPE) {
+    if (!getBits(r, 1, &bit)) {
+      return false;
+    }
+    if (bit == 0) {
+      break;
+    }
+    (*ones)++;
+  }
+  return true;
+}
+
+/**************************************************************************//**
+ * @brief Rice parameter for a block, from the sum of its mapped differences
+ *
+ * @details
+ *    The largest k with 2^k at most the mean, which comes close to the
+ *    shortest code for differences with a Laplacian spread.
+ *****************************************************************************/
+static uint32_t chooseK(uint32_t sum, uint32_t count)
+{
+  uint32_t k = 0;
+
+  while ((k < K_MAX) && (((uint64_t)count << (k + 1)) <= sum)) {
+    k++;
+  }
+  return k;
+}
+
+/**************************************************************************//**
+ * @brief Store a block as plain samples, little endian
+ *****************************************************************************/
+static uint32_t storeRaw(const int16_t *samples, uint32_t count, uint8_t *out)
+{
+  uint32_t i;
+
+  out[0] = K_RAW;
+  out[1] = (uint8_t)count;
+  out[2] = (uint8_t)(count >> 8);
+  for (i = 0; i < count; i++) {
+    out[3 + (2 * i)] = (uint8_t)samples[i];
+    out[4 + (2 * i)] = (uint8_t)((uint16_t)samples[i] >> 8);
+  }
+
+  return 3 + (2 * count);
+}
+
+/**************************************************************************//**
+ * @brief Code a block of samples
+ *
+ * @param[in] samples
+ *    Samples of one channel, in order.
+ *
+ * @param[in] count
+ *    Number of samples, 1 to SAMPLECODEC_MAX_BLOCK.
+ *
+ * @param[out] out
+ *    Coded block, room for SAMPLECODEC_MAX_BYTES(count) bytes.
+ *
+ * @return
+ *    Bytes written, 0 if count is out of range.
+ *****************************************************************************/
+uint32_t SAMPLECODEC_Encode(const int16_t *samples, uint32_t count,
+                            uint8_t *out)
+{
+  Writer_t w;
+  uint32_t sum = 0;
+  uint32_t rawBytes, k, u, q, i;
+  const uint8_t *limit;
+
+  if ((count == 0) || (count > SAMPLECODEC_MAX_BLOCK)) {
+    return 0;
+  }
+
+  rawBytes = 3 + (2 * count);
+
+  for (i = 1; i < count; i++) {
+    sum += zigzag(samples[i], samples[i - 1]);
+  }
+  k = chooseK(sum, count - 1);
+
+  out[0] = (uint8_t)k;
+  out[1] = (uint8_t)count;
+  out[2] = (uint8_t)(count >> 8);
+  out[3] = (uint8_t)samples[0];
+  out[4] = (uint8_t)((uint16_t)samples[0] >> 8);
+
+  w.out = out + SAMPLECODEC_HEADER_BYTES;
+  w.acc = 0;
+  w.bits = 0;
+
+  // A sample writes at most 4 bytes, so stopping here stays in the buffer
+  limit = out + rawBytes - 4;
+
+  for (i = 1; i < count; i++) {
+    u = zigzag(samples[i], samples[i - 1]);
+    q = u >> k;
+
+    if (q < SAMPLECODEC_ESCAPE) {
+      // q ones and a zero, then the low k bits
+      putBits(&w, ((1UL << q) - 1) << 1, q + 1);
+      putBits(&w, u & ((1UL << k) - 1), k);
+    } else {
+      putBits(&w, (1UL << SAMPLECODEC_ESCAPE) - 1, SAMPLECODEC_ESCAPE);
+      putBits(&w, u, 16);
+    }
+
+    if (w.out >= limit) {
+      return storeRaw(samples, count, out);
+    }
+  }
+
+  // Pad the last byte with zeros
+  if (w.bits > 0) {
+    putBits(&w, 0, 8 - w.bits);
+  }
+
+  if ((uint32_t)(w.out - out) >= rawBytes) {
+    return storeRaw(samples, count, out);
+  }
+
+  return (uint32_t)(w.out - out);
+}
+
+/**************************************************************************//**
+ * @brief Decode a block
+ *
+ * @param[in] in
+ *    Start of a coded block.
+ *
+ * @param[in] length
+ *    Bytes available from in, the block may be followed by others.
+ *
+ * @param[out] samples
+ *    Decoded samples.
+ *
+ * @param[in] maxCount
+ *    Room in samples.
+ *
+ * @param[out] count
+ *    Number of samples decoded.
+ *
+ * @return
+ *    Bytes the block takes, where the next one starts; 0 if the block is
+ *    not valid, cut short or holds more than maxCount samples.
+ *****************************************************************************/
+uint32_t SAMPLECODEC_Decode(const uint8_t *in, uint32_t length,
+                            int16_t *samples, uint32_t maxCount,
+                            uint32_t *count)
+{
+  Reader_t r;
+  uint32_t k, n, q, u, i;
+  uint16_t previous;
+
+  if (length < 3) {
+    return 0;
+  }
+
+  k = in[0];
+  n = in[1] | ((uint32_t)in[2] << 8);
+  if ((n == 0) || (n > maxCount)) {
+    return 0;
+  }
+
+  if (k == K_RAW) {
+    if (length < (3 + (2 * n))) {
+      return 0;
+    }
+    for (i = 0; i < n; i++) {
+      samples[i] = (int16_t)(in[3 + (2 * i)]
+                             | ((uint16_t)in[4 + (2 * i)] << 8));
+    }
+    *count = n;
+    return 3 + (2 * n);
+  }
+
+  if ((k > K_MAX) || (length < SAMPLECODEC_HEADER_BYTES)) {
+    return 0;
+  }
+
+  previous = (uint16_t)(in[3] | ((uint16_t)in[4] << 8));
+  samples[0] = (int16_t)previous;
+
+  r.in = in + SAMPLECODEC_HEADER_BYTES;
+  r.end = in + length;
+  r.acc = 0;
+  r.bits = 0;
+
+  for (i = 1; i < n; i++) {
+    if (!getUnary(&r, &q)) {
+      return 0;
+    }
+    if (q < SAMPLECODEC_ESCAPE) {
+      if (!getBits(&r, k, &u)) {
+        return 0;
+      }
+      u |= q << k;
+    } else if (!getBits(&r, 16, &u)) {
+      return 0;
+    }
+
+    // Undo the zig-zag map, the difference wraps like the samples
+    previous = (uint16_t)(previous + ((u >> 1) ^ (0U - (u & 1))));
+    samples[i] = (int16_t)previous;
+  }
+
+  // The padding bits of the last byte are taken with it
+  *count = n;
+  return (uint32_t)(r.in - in);
+}
+
+/** @} (end group SampleCodec) */
+/** @} (end group kitdrv) */
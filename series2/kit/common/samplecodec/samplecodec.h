@@ -0,0 +1,105 @@
+/***************************************************************************//**
+ * @file
+ * @brief Lossless delta and Rice coding of sample blocks.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2022 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ******************************************************************************/
+
+#ifndef __SAMPLECODEC_H
+#define __SAMPLECODEC_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/***************************************************************************//**
+ * @addtogroup kitdrv
+ * @{
+ ******************************************************************************/
+
+/***************************************************************************//**
+ * @addtogroup SampleCodec
+ * @brief Lossless delta and Rice coding of sample blocks
+ * @details
+ *    Compresses blocks of 16 bit samples of one channel, such as an input
+ *    of the IADC split out by IADCS_Demux() or a channel of PDM results,
+ *    before they are stored or sent. Each sample is coded as its
+ *    difference from the one before, wrapped to 16 bits and zig-zag
+ *    mapped so small differences of either sign give small numbers, in a
+ *    Rice code: the number shifted right by k in unary, then its low k
+ *    bits. k is chosen per block from the mean difference, so a slowly
+ *    varying signal takes a few bits per sample.
+ *
+ *    Every block decodes on its own: a 5 byte header holds k, the sample
+ *    count and the first sample, and the code is padded to a whole byte.
+ *    A difference whose unary part would be SAMPLECODEC_ESCAPE bits or
+ *    more is sent as the escape and the 16 bit number instead, and a
+ *    block that does not come out smaller than its samples is stored as
+ *    they are. A block therefore never takes more than
+ *    SAMPLECODEC_MAX_BYTES(count), and the work per sample is bounded: one
+ *    pass to choose k and one to code, each without a loop per bit.
+ *
+ *    The code is written most significant bit first. The functions keep
+ *    no state and may be called for several streams in turn.
+ * @{
+ ******************************************************************************/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Unary bits that mark an escaped difference, at most 16 */
+#ifndef SAMPLECODEC_ESCAPE
+#define SAMPLECODEC_ESCAPE      16
+#endif
+
+#if (SAMPLECODEC_ESCAPE < 2) || (SAMPLECODEC_ESCAPE > 16)
+#error "SAMPLECODEC_ESCAPE must be 2 to 16"
+#endif
+
+/** Block header: k, count and first sample */
+#define SAMPLECODEC_HEADER_BYTES  5
+
+/** Largest coded size of a block of count samples */
+#define SAMPLECODEC_MAX_BYTES(count) \
+  (SAMPLECODEC_HEADER_BYTES + (2 * (count)))
+
+/** Largest block, the count is 16 bits */
+#define SAMPLECODEC_MAX_BLOCK   0xFFFF
+
+uint32_t SAMPLECODEC_Encode(const int16_t *samples, uint32_t count,
+                            uint8_t *out);
+uint32_t SAMPLECODEC_Decode(const uint8_t *in, uint32_t length,
+                            int16_t *samples, uint32_t maxCount,
+                            uint32_t *count);
+
+#ifdef __cplusplus
+}
+#endif
+
+/** @} (end group SampleCodec) */
+/** @} (end group kitdrv) */
+
+#endif
@@ -0,0 +1,172 @@
+#!/usr/bin/env python3
+"""Measure USB CDC latency and throughput against usbd_cdc_vcom_echo.
+
+The device echoes every packet at normal baud rates. Two otherwise unused
+baud rates switch it to a benchmark mode (see the example's usbconfig.h):
+  2000001  sink, all data from the host is thrown away
+  2000002  source, the device sends full transfers non-stop
+The baud rate only selects the mode, USB CDC runs at bus speed regardless.
+
+Tests:
+  latency   round trip time of 1 to 64 byte packets in echo mode
+  out       sustained host to device throughput in sink mode
+  in        sustained device to host throughput in source mode
+
+With --stream the telemetry port of usbd_cdc_composite is read in the
+background while the tests run, to show that the stream does not hold up
+the port under test. The stream is a 32-bit little endian count, every word
+is checked and gaps are reported. Only the latency test applies to the
+composite device, its console and data ports always echo.
+
+Examples:
+  cdc_bench.py --port COM7
+  cdc_bench.py --port /dev/ttyACM0 --test latency --count 2000
+  cdc_bench.py --port /dev/ttyACM0 --test out --test in --seconds 10
+  cdc_bench.py --port /dev/ttyACM0 --test latency --stream /dev/ttyACM1
+"""
+
+import argparse
+import os
+import struct
+import sys
+import threading
+import time
+
+BAUD_ECHO = 115200
+BAUD_SINK = 2000001
+BAUD_SOURCE = 2000002
+
+LATENCY_SIZES = (1, 2, 4, 8, 16, 32, 63, 64)
+BULK_CHUNK = 16384
+
+
+def set_mode(ser, baud):
+    """Select a device mode and drop anything left over from the last one."""
+    ser.baudrate = baud
+    time.sleep(0.05)
+    ser.reset_input_buffer()
+
+
+def percentile(values, pct):
+    values = sorted(values)
+    return values[min(len(values) - 1, int(len(values) * pct / 100.0))]
+
+
+def test_latency(ser, count):
+    set_mode(ser, BAUD_ECHO)
+    print('latency, %d round trips per size' % count)
+    print('%6s %10s %10s %10s %10s' % ('bytes', 'min us', 'avg us', 'p99 us', 'max us'))
+    for size in LATENCY_SIZES:
+        samples = []
+        for i in range(count):
+            data = bytes((i + n) & 0xFF for n in range(size))
+            start = time.perf_counter()
+            ser.write(data)
+            echo = ser.read(size)
+            samples.append((time.perf_counter() - start) * 1e6)
+            if echo != data:
+                sys.exit('echo mismatch at %d bytes: sent %s got %s'
+                         % (size, data.hex(), echo.hex()))
+        print('%6d %10.0f %10.0f %10.0f %10.0f'
+              % (size, min(samples), sum(samples) / len(samples),
+                 percentile(samples, 99), max(samples)))
+
+
+def test_out(ser, seconds):
+    set_mode(ser, BAUD_SINK)
+    chunk = os.urandom(BULK_CHUNK)
+    total = 0
+    start = time.perf_counter()
+    while time.perf_counter() - start < seconds:
+        total += ser.write(chunk)
+    ser.flush()
+    elapsed = time.perf_counter() - start
+    print('host to device: %d bytes in %.2f s, %.1f kB/s'
+          % (total, elapsed, total / elapsed / 1000))
+
+
+def test_in(ser, seconds):
+    set_mode(ser, BAUD_SOURCE)
+    total = 0
+    start = time.perf_counter()
+    while time.perf_counter() - start < seconds:
+        total += len(ser.read(BULK_CHUNK))
+    elapsed = time.perf_counter() - start
+    set_mode(ser, BAUD_ECHO)
+    print('device to host: %d bytes in %.2f s, %.1f kB/s'
+          % (total, elapsed, total / elapsed / 1000))
+
+
+class StreamReader(threading.Thread):
+    """Drain a counting stream and check that no word is lost."""
+
+    def __init__(self, ser):
+        super().__init__(daemon=True)
+        self.ser = ser
+        self.running = True
+        self.total = 0
+        self.gaps = 0
+        self.expected = None
+        self.elapsed = 0.0
+
+    def run(self):
+        # Words queued before this open are thrown away
+        time.sleep(0.1)
+        self.ser.reset_input_buffer()
+        pending = b''
+        start = time.perf_counter()
+        while self.running:
+            data = self.ser.read(BULK_CHUNK)
+            self.total += len(data)
+            pending += data
+            words = len(pending) // 4
+            for (word,) in struct.iter_unpack('<I', pending[:words * 4]):
+                if self.expected is not None and word != self.expected:
+                    self.gaps += 1
+                self.expected = (word + 1) & 0xFFFFFFFF
+            pending = pending[words * 4:]
+        self.elapsed = time.perf_counter() - start
+
+    def stop(self):
+        self.running = False
+        self.join()
+        print('stream: %d bytes in %.2f s, %.1f kB/s, %d gaps'
+              % (self.total, self.elapsed, self.total / self.elapsed / 1000,
+                 self.gaps))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__,
+                                     formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument('--port', required=True, help='CDC port of the device')
+    parser.add_argument('--test', action='append', choices=('latency', 'out', 'in'),
+                        help='test to run (repeatable), default all')
+    parser.add_argument('--count', type=int, default=500,
+                        help='round trips per packet size, default 500')
+    parser.add_argument('--seconds', type=float, default=5.0,
+                        help='duration of each throughput test, default 5')
+    parser.add_argument('--stream',
+                        help='telemetry port to read while the tests run')
+    args = parser.parse_args()
+
+    import serial
+    reader = None
+    if args.stream:
+        reader = StreamReader(serial.Serial(args.stream, BAUD_ECHO, timeout=0.1))
+        reader.start()
+    with serial.Serial(args.port, BAUD_ECHO, timeout=1) as ser:
+        for test in args.test or ('latency', 'out', 'in'):
+            if test == 'latency':
+                test_latency(ser, args.count)
+            elif test == 'out':
+                test_out(ser, args.seconds)
+            else:
+                test_in(ser, args.seconds)
+        set_mode(ser, BAUD_ECHO)
+    if reader:
+        reader.stop()
+        reader.ser.close()
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,159 @@
+#!/usr/bin/env python3
+"""Decode retargetlog records from a serial port or a capture file.
+
+The message table is read from the RETARGETLOG_MSG(name, "format") entries
+in the given C sources; IDs are assigned in the order they appear, the same
+way the RETARGETLOG_MESSAGES enum does on the device. Bytes that are not
+part of a valid record (plain printf output) are passed through unchanged.
+
+Examples:
+  retargetlog_decode.py -s ../src/main.c capture.bin
+  retargetlog_decode.py -s ../src/main.c --port COM5 --baud 115200
+"""
+
+import argparse
+import re
+import struct
+import sys
+
+SYNC = 0xA5
+MAX_ARGS = 8
+
+MSG_RE = re.compile(r'RETARGETLOG_MSG\(\s*(\w+)\s*,\s*"((?:[^"\\]|\\.)*)"\s*\)')
+CONV_RE = re.compile(r'%[-+ #0]*\d*(?:\.\d+)?(?:hh|h|ll|l|z|j|t)?([diouxXcsfFeEgGp%])')
+
+
+def load_messages(paths):
+    """Return a list of (name, format) in ID order."""
+    msgs = []
+    for path in paths:
+        with open(path, encoding='utf-8', errors='replace') as f:
+            text = f.read()
+        # Skip the macro definition in retargetlog.h itself
+        for m in MSG_RE.finditer(text):
+            if m.group(1) == 'name':
+                continue
+            fmt = bytes(m.group(2), 'utf-8').decode('unicode_escape')
+            msgs.append((m.group(1), fmt))
+    return msgs
+
+
+def format_record(fmt, args):
+    """Apply a printf style format to raw 32-bit arguments."""
+    values = []
+    it = iter(args)
+    py_fmt = []
+    pos = 0
+    for m in CONV_RE.finditer(fmt):
+        py_fmt.append(fmt[pos:m.start()].replace('%', '%%'))
+        pos = m.end()
+        conv = m.group(1)
+        if conv == '%':
+            py_fmt.append('%%')
+            continue
+        spec = re.sub(r'(hh|h|ll|l|z|j|t)', '', m.group(0))
+        raw = next(it, 0)
+        if conv in 'di':
+            values.append(struct.unpack('<i', struct.pack('<I', raw))[0])
+        elif conv in 'fFeEgG':
+            values.append(struct.unpack('<f', struct.pack('<I', raw))[0])
+        elif conv == 'c':
+            values.append(chr(raw & 0xFF))
+        elif conv == 's':
+            # Strings are not sent, show the pointer
+            spec = spec[:-1] + 's'
+            values.append('<0x%08x>' % raw)
+        elif conv == 'p':
+            spec = '0x%08x'
+            values.append(raw)
+        else:
+            values.append(raw)
+        py_fmt.append(spec)
+    py_fmt.append(fmt[pos:].replace('%', '%%'))
+    return ''.join(py_fmt) % tuple(values)
+
+
+class Decoder:
+    def __init__(self, msgs, out):
+        self.msgs = msgs
+        self.out = out
+        self.buf = bytearray()
+
+    def feed(self, data):
+        self.buf += data
+        while self.buf:
+            if self.buf[0] != SYNC:
+                idx = self.buf.find(SYNC)
+                text = self.buf if idx < 0 else self.buf[:idx]
+                self.out.write(text.decode('utf-8', errors='replace'))
+                del self.buf[:len(text)]
+                continue
+            if len(self.buf) < 3:
+                return
+            argc = self.buf[2]
+            size = 3 + 4 * argc + 1
+            if argc > MAX_ARGS:
+                self._passthrough()
+                continue
+            if len(self.buf) < size:
+                return
+            rec = self.buf[:size]
+            checksum = 0
+            for b in rec[1:-1]:
+                checksum ^= b
+            if checksum != rec[-1]:
+                self._passthrough()
+                continue
+            del self.buf[:size]
+            self._emit(rec[1], struct.unpack('<%dI' % argc, bytes(rec[3:-1])))
+        self.out.flush()
+
+    def _passthrough(self):
+        # Not a record after all, print the sync byte as text
+        self.out.write(self.buf[:1].decode('latin-1'))
+        del self.buf[:1]
+
+    def _emit(self, msg_id, args):
+        if msg_id < len(self.msgs):
+            name, fmt = self.msgs[msg_id]
+            try:
+                text = format_record(fmt, args)
+            except (TypeError, ValueError):
+                text = '%s %s' % (name, ' '.join('0x%08x' % a for a in args))
+        else:
+            text = '<unknown id %d> %s' % (msg_id, ' '.join('0x%08x' % a for a in args))
+        if not text.endswith('\n'):
+            text += '\n'
+        self.out.write(text)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__,
+                                     formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument('-s', '--source', action='append', required=True,
+                        help='C file with the RETARGETLOG_MSG() list (repeatable)')
+    parser.add_argument('--port', help='serial port to read (needs pyserial)')
+    parser.add_argument('--baud', type=int, default=115200)
+    parser.add_argument('capture', nargs='?', help='binary capture file, default stdin')
+    args = parser.parse_args()
+
+    msgs = load_messages(args.source)
+    dec = Decoder(msgs, sys.stdout)
+
+    if args.port:
+        import serial
+        with serial.Serial(args.port, args.baud, timeout=0.1) as ser:
+            while True:
+                dec.feed(ser.read(256))
+    else:
+        f = open(args.capture, 'rb') if args.capture else sys.stdin.buffer
+        while True:
+            data = f.read(4096)
+            if not data:
+                break
+            dec.feed(data)
+        dec.out.write(dec.buf.decode('latin-1'))
+
+
+if __name__ == '__main__':
+    main()
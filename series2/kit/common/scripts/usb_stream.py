@@ -0,0 +1,142 @@
+#!/usr/bin/env python3
+"""Read the bulk stream of usbd_vendor_stream and report the throughput.
+
+The device is a vendor specific USB device, vendor ID 0x10C4 and product
+ID 0x0009, with one bulk IN endpoint. Vendor requests on EP0 control it
+(see the example's inc/stream.h):
+  0x01  start, wValue source (0 pattern, 1 ADC), wIndex ADC rate in kHz
+  0x02  stop
+  0x03  status, five 32-bit little endian words: bytes sent, transfers
+        sent, overruns, sample rate in Hz, streaming
+
+In pattern mode the first word of every 4096 byte buffer counts up, every
+buffer is checked and gaps are reported. In ADC mode every sample is a
+12-bit result in a 16-bit little endian word, the range seen is reported.
+
+On Windows the device needs the WinUSB driver, for example bound with
+Zadig. On Linux run with sudo or add a udev rule for the device.
+
+Examples:
+  usb_stream.py
+  usb_stream.py --seconds 10
+  usb_stream.py --adc --rate 500
+"""
+
+import argparse
+import struct
+import sys
+import time
+
+VENDOR_ID = 0x10C4
+PRODUCT_ID = 0x0009
+
+EP_IN = 0x81
+REQ_START = 0x01
+REQ_STOP = 0x02
+REQ_STATUS = 0x03
+SOURCE_PATTERN = 0
+SOURCE_ADC = 1
+
+# STREAM_BUF_SIZE and STREAM_BUF_CNT * STREAM_BUF_SIZE in usbconfig.h
+BUF_SIZE = 4096
+READ_SIZE = 8 * BUF_SIZE
+
+
+def vendor_out(dev, request, value=0, index=0):
+    dev.ctrl_transfer(0x40, request, value, index, None)
+
+
+def read_status(dev):
+    data = bytes(dev.ctrl_transfer(0xC0, REQ_STATUS, 0, 0, 20))
+    return struct.unpack('<5I', data)
+
+
+def drain(dev):
+    """Throw away data left in the host and device queues."""
+    import usb.core
+    while True:
+        try:
+            dev.read(EP_IN, READ_SIZE, timeout=50)
+        except usb.core.USBTimeoutError:
+            return
+
+
+def check_pattern(data, expected):
+    """Check the count of each buffer, return (next count, gaps)."""
+    gaps = 0
+    for offset in range(0, len(data) - 3, BUF_SIZE):
+        (count,) = struct.unpack_from('<I', data, offset)
+        if expected is not None and count != expected:
+            gaps += 1
+        expected = (count + 1) & 0xFFFFFFFF
+    return expected, gaps
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__,
+                                     formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument('--adc', action='store_true',
+                        help='stream ADC samples instead of the test pattern')
+    parser.add_argument('--rate', type=int, default=0,
+                        help='ADC sample rate in kHz, default the device default')
+    parser.add_argument('--seconds', type=float, default=5.0,
+                        help='duration of the stream, default 5')
+    args = parser.parse_args()
+
+    import usb.core
+    dev = usb.core.find(idVendor=VENDOR_ID, idProduct=PRODUCT_ID)
+    if dev is None:
+        sys.exit('device %04x:%04x not found' % (VENDOR_ID, PRODUCT_ID))
+    dev.set_configuration()
+
+    vendor_out(dev, REQ_STOP)
+    drain(dev)
+    vendor_out(dev, REQ_START, SOURCE_ADC if args.adc else SOURCE_PATTERN,
+               args.rate)
+
+    total = 0
+    gaps = 0
+    expected = None
+    low = 0xFFFF
+    high = 0
+    pending = b''
+    start = time.perf_counter()
+    while time.perf_counter() - start < args.seconds:
+        try:
+            data = bytes(dev.read(EP_IN, READ_SIZE, timeout=1000))
+        except usb.core.USBTimeoutError:
+            # An ADC overrun ends the stream
+            break
+        total += len(data)
+        pending += data
+        if args.adc:
+            samples = struct.unpack('<%dH' % (len(pending) // 2),
+                                    pending[:len(pending) // 2 * 2])
+            if samples:
+                low = min(low, min(samples))
+                high = max(high, max(samples))
+            pending = pending[len(samples) * 2:]
+        else:
+            whole = len(pending) // BUF_SIZE * BUF_SIZE
+            expected, found = check_pattern(pending[:whole], expected)
+            gaps += found
+            pending = pending[whole:]
+    elapsed = time.perf_counter() - start
+
+    bytes_sent, xfers, overruns, rate, streaming = read_status(dev)
+    vendor_out(dev, REQ_STOP)
+    drain(dev)
+
+    print('stream: %d bytes in %.2f s, %.1f kB/s'
+          % (total, elapsed, total / elapsed / 1000))
+    if args.adc:
+        print('adc: %d Hz, %.1f kB/s expected, samples %d to %d'
+              % (rate, rate * 2 / 1000.0, low, high))
+    else:
+        print('pattern: %d gaps' % gaps)
+    print('device: %d bytes in %d transfers, %d overruns, %s'
+          % (bytes_sent, xfers, overruns, 'streaming' if streaming else 'stopped'))
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,406 @@
+/***************************************************************************//**
+ * @file
+ * @brief SPI bus shared by several devices, with queued LDMA transfers.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2022 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ******************************************************************************/
+
+
+#include <stddef.h>
+#include "em_core.h"
+#include "spibus.h"
+
+/***************************************************************************//**
+ * @addtogroup kitdrv
+ * @{
+ ******************************************************************************/
+
+/***************************************************************************//**
+ * @addtogroup SpiBus
+ * @{
+ ******************************************************************************/
+
+#define CTRL_MODE_MASK  (_USART_CTRL_CLKPOL_MASK | _USART_CTRL_CLKPHA_MASK \
+                         | _USART_CTRL_MSBF_MASK)
+
+static USART_TypeDef *usart;
+static CMU_Clock_TypeDef usartClock;
+static LDMA_PeripheralSignal_t rxSignal;
+static LDMA_PeripheralSignal_t txSignal;
+
+// Client whose settings are in the USART, NULL after SPIBUS_Init()
+static const SPIBUS_Client_TypeDef *current;
+
+// Set from SPIBUS_Acquire() or the start of a queued transfer until the
+// bus is free again; a queued transfer in progress is active
+static volatile bool busy;
+static SPIBUS_Transfer_TypeDef *volatile active;
+
+// Transfers waiting for the bus, oldest first
+static SPIBUS_Transfer_TypeDef *queueHead;
+static SPIBUS_Transfer_TypeDef *queueTail;
+
+// Sent when a transfer has no tx bytes, and where dropped rx bytes go
+static const uint8_t txDummy = 0xFF;
+static uint8_t rxDummy;
+
+static volatile SPIBUS_Counters_TypeDef counters;
+
+/**************************************************************************//**
+ * @brief Put the settings of a client in the USART, if not there already
+ *
+ * @details
+ *    Called with the bus held for the client, so the chip selects are all
+ *    high and SCLK may take its new idle level. The receiver and
+ *    transmitter are off while CTRL changes.
+ *****************************************************************************/
+static void applyClient(const SPIBUS_Client_TypeDef *client)
+{
+  if (client == current) {
+    return;
+  }
+
+  usart->CMD = USART_CMD_RXDIS | USART_CMD_TXDIS;
+  usart->CLKDIV = client->clkdiv;
+  usart->CTRL = (usart->CTRL & ~CTRL_MODE_MASK) | client->ctrl;
+  usart->CMD = USART_CMD_CLEARRX | USART_CMD_CLEARTX
+               | USART_CMD_RXEN | USART_CMD_TXEN;
+
+  current = client;
+  counters.switches++;
+}
+
+/**************************************************************************//**
+ * @brief Start a queued transfer, the bus is held for it
+ *****************************************************************************/
+static void startTransfer(SPIBUS_Transfer_TypeDef *transfer)
+{
+  static LDMA_Descriptor_t rxDesc;
+  static LDMA_Descriptor_t txDesc;
+  LDMA_TransferCfg_t rxCfg = LDMA_TRANSFER_CFG_PERIPHERAL(rxSignal);
+  LDMA_TransferCfg_t txCfg = LDMA_TRANSFER_CFG_PERIPHERAL(txSignal);
+
+  active = transfer;
+  applyClient(transfer->client);
+
+  // RXDATA -> rx buffer, the done interrupt comes after the last byte
+  if (transfer->rx != NULL) {
+    rxDesc = (LDMA_Descriptor_t)LDMA_DESCRIPTOR_SINGLE_P2M_BYTE(
+      &usart->RXDATA, transfer->rx, transfer->length);
+  } else {
+    rxDesc = (LDMA_Descriptor_t)LDMA_DESCRIPTOR_SINGLE_P2M_BYTE(
+      &usart->RXDATA, &rxDummy, transfer->length);
+    rxDesc.xfer.dstInc = ldmaCtrlDstIncNone;
+  }
+
+  // tx buffer -> TXDATA, generates the SPI clock
+  if (transfer->tx != NULL) {
+    txDesc = (LDMA_Descriptor_t)LDMA_DESCRIPTOR_SINGLE_M2P_BYTE(
+      transfer->tx, &usart->TXDATA, transfer->length);
+  } else {
+    txDesc = (LDMA_Descriptor_t)LDMA_DESCRIPTOR_SINGLE_M2P_BYTE(
+      &txDummy, &usart->TXDATA, transfer->length);
+    txDesc.xfer.srcInc = ldmaCtrlSrcIncNone;
+  }
+  txDesc.xfer.doneIfs = 0;
+
+  usart->CMD = USART_CMD_CLEARRX;
+  GPIO_PinOutClear(transfer->client->csPort, transfer->client->csPin);
+
+  // The receive channel must be armed before the first byte is clocked out
+  LDMA_StartTransfer(SPIBUS_LDMA_RX_CHANNEL, &rxCfg, &rxDesc);
+  LDMA_StartTransfer(SPIBUS_LDMA_TX_CHANNEL, &txCfg, &txDesc);
+}
+
+/**************************************************************************//**
+ * @brief Hand the free bus to the oldest queued transfer, if any
+ *
+ * @details
+ *    Called with interrupts masked or from the LDMA interrupt.
+ *****************************************************************************/
+static void startNext(void)
+{
+  SPIBUS_Transfer_TypeDef *transfer = queueHead;
+
+  if (transfer == NULL) {
+    busy = false;
+    return;
+  }
+
+  queueHead = transfer->next;
+  if (queueHead == NULL) {
+    queueTail = NULL;
+  }
+  startTransfer(transfer);
+}
+
+/**************************************************************************//**
+ * @brief Set up the USART and pins of the bus
+ *
+ * @details
+ *    Call after LDMA_Init() and before SPIBUS_ClientInit(). The bit rate,
+ *    clock mode and bit order are set for each client when it gets the bus.
+ *****************************************************************************/
+void SPIBUS_Init(const SPIBUS_Init_TypeDef *init)
+{
+  USART_InitSync_TypeDef usartInit = USART_INITSYNC_DEFAULT;
+
+  usart = init->usart;
+  usartClock = init->clock;
+  rxSignal = init->rxSignal;
+  txSignal = init->txSignal;
+
+  CMU_ClockEnable(cmuClock_GPIO, true);
+  CMU_ClockEnable(usartClock, true);
+
+  usartInit.msbf = true;
+  USART_InitSync(usart, &usartInit);
+
+  GPIO_PinModeSet(init->mosiPort, init->mosiPin, gpioModePushPull, 1);
+  GPIO_PinModeSet(init->misoPort, init->misoPin, gpioModeInput, 0);
+  GPIO_PinModeSet(init->sclkPort, init->sclkPin, gpioModePushPull, 0);
+
+  GPIO->USARTROUTE[init->routeIndex].CLKROUTE =
+    ((uint32_t)init->sclkPort << _GPIO_USART_CLKROUTE_PORT_SHIFT)
+    | ((uint32_t)init->sclkPin << _GPIO_USART_CLKROUTE_PIN_SHIFT);
+  GPIO->USARTROUTE[init->routeIndex].RXROUTE =
+    ((uint32_t)init->misoPort << _GPIO_USART_RXROUTE_PORT_SHIFT)
+    | ((uint32_t)init->misoPin << _GPIO_USART_RXROUTE_PIN_SHIFT);
+  GPIO->USARTROUTE[init->routeIndex].TXROUTE =
+    ((uint32_t)init->mosiPort << _GPIO_USART_TXROUTE_PORT_SHIFT)
+    | ((uint32_t)init->mosiPin << _GPIO_USART_TXROUTE_PIN_SHIFT);
+  GPIO->USARTROUTE[init->routeIndex].ROUTEEN = GPIO_USART_ROUTEEN_RXPEN
+                                               | GPIO_USART_ROUTEEN_TXPEN
+                                               | GPIO_USART_ROUTEEN_CLKPEN;
+
+  current = NULL;
+  busy = false;
+  active = NULL;
+  queueHead = NULL;
+  queueTail = NULL;
+  counters.acquired = 0;
+  counters.waited = 0;
+  counters.transfers = 0;
+  counters.switches = 0;
+}
+
+/**************************************************************************//**
+ * @brief Work out the settings of a device and set up its chip select
+ *
+ * @details
+ *    The bit rate is the highest the USART clock gives up to baudrate, so
+ *    the USART clock must not change after this call.
+ *
+ * @param[out] client
+ *    Kept by the caller for as long as the device is used.
+ *
+ * @param[in] clockMode
+ *    SPI mode of the device, usartClockMode0 to usartClockMode3.
+ *
+ * @param[in] msbf
+ *    true to send the most significant bit first.
+ *****************************************************************************/
+void SPIBUS_ClientInit(SPIBUS_Client_TypeDef *client,
+                       GPIO_Port_TypeDef csPort, uint8_t csPin,
+                       uint32_t baudrate, USART_ClockMode_TypeDef clockMode,
+                       bool msbf)
+{
+  uint32_t div;
+
+  // Same rounding as USART_BaudrateSyncSet(), never faster than asked
+  div = (CMU_ClockFreqGet(usartClock) - 1) / (2 * baudrate);
+  div <<= _USART_CLKDIV_DIV_SHIFT;
+  if (div > _USART_CLKDIV_DIV_MASK) {
+    div = _USART_CLKDIV_DIV_MASK;
+  }
+
+  client->csPort = csPort;
+  client->csPin = csPin;
+  client->clkdiv = div & _USART_CLKDIV_DIV_MASK;
+  client->ctrl = (uint32_t)clockMode | (msbf ? USART_CTRL_MSBF : 0);
+
+  GPIO_PinModeSet(csPort, csPin, gpioModePushPull, 1);
+}
+
+/**************************************************************************//**
+ * @brief Hold the bus for a client, waiting for it if needed
+ *
+ * @details
+ *    The bus has the settings of the client on return, the client drives
+ *    its own chip select with the USART until SPIBUS_Release().
+ *****************************************************************************/
+void SPIBUS_Acquire(const SPIBUS_Client_TypeDef *client)
+{
+  if (SPIBUS_TryAcquire(client)) {
+    return;
+  }
+
+  counters.waited++;
+  while (!SPIBUS_TryAcquire(client)) {
+  }
+}
+
+/**************************************************************************//**
+ * @brief Hold the bus for a client if it is free
+ *
+ * @return
+ *    false if the bus is held or moving a queued transfer.
+ *****************************************************************************/
+bool SPIBUS_TryAcquire(const SPIBUS_Client_TypeDef *client)
+{
+  CORE_DECLARE_IRQ_STATE;
+
+  CORE_ENTER_ATOMIC();
+  if (busy) {
+    CORE_EXIT_ATOMIC();
+    return false;
+  }
+  busy = true;
+  counters.acquired++;
+  CORE_EXIT_ATOMIC();
+
+  applyClient(client);
+
+  return true;
+}
+
+/**************************************************************************//**
+ * @brief Free the bus held by SPIBUS_Acquire()
+ *
+ * @details
+ *    The chip select of the client must be high. The oldest queued
+ *    transfer, if any, starts at once.
+ *****************************************************************************/
+void SPIBUS_Release(const SPIBUS_Client_TypeDef *client)
+{
+  CORE_DECLARE_IRQ_STATE;
+
+  (void)client;
+
+  CORE_ENTER_ATOMIC();
+  startNext();
+  CORE_EXIT_ATOMIC();
+}
+
+/**************************************************************************//**
+ * @brief USART of the bus, for the transfers of a client holding it
+ *****************************************************************************/
+USART_TypeDef *SPIBUS_Usart(void)
+{
+  return usart;
+}
+
+/**************************************************************************//**
+ * @brief Queue a transfer
+ *
+ * @details
+ *    Starts the transfer at once if the bus is free. May be called from
+ *    interrupts, including the callback of another transfer. The transfer
+ *    and its buffers must stay in place until done is set.
+ *
+ * @return
+ *    false if the length is not 1 to SPIBUS_MAX_TRANSFER.
+ *****************************************************************************/
+bool SPIBUS_Queue(SPIBUS_Transfer_TypeDef *transfer)
+{
+  CORE_DECLARE_IRQ_STATE;
+
+  if ((transfer->length == 0) || (transfer->length > SPIBUS_MAX_TRANSFER)) {
+    return false;
+  }
+
+  transfer->done = false;
+  transfer->next = NULL;
+
+  CORE_ENTER_ATOMIC();
+  if (!busy) {
+    busy = true;
+    startTransfer(transfer);
+  } else if (queueTail == NULL) {
+    queueHead = transfer;
+    queueTail = transfer;
+  } else {
+    queueTail->next = transfer;
+    queueTail = transfer;
+  }
+  CORE_EXIT_ATOMIC();
+
+  return true;
+}
+
+/**************************************************************************//**
+ * @brief Whether the bus is free and no transfer is queued
+ *****************************************************************************/
+bool SPIBUS_Idle(void)
+{
+  return !busy;
+}
+
+/**************************************************************************//**
+ * @brief Finish the active transfer and start the next
+ *
+ * @details
+ *    Call from the application's LDMA_IRQHandler(). Flags of other
+ *    channels are left untouched.
+ *****************************************************************************/
+void SPIBUS_IRQHandler(void)
+{
+  uint32_t mask = 1UL << SPIBUS_LDMA_RX_CHANNEL;
+  SPIBUS_Transfer_TypeDef *transfer;
+
+  if ((LDMA_IntGet() & LDMA_IntGetEnabled() & mask) == 0) {
+    return;
+  }
+
+  LDMA_IntClear(mask);
+
+  // The last byte has been received, so it has been clocked out in full
+  transfer = active;
+  active = NULL;
+  GPIO_PinOutSet(transfer->client->csPort, transfer->client->csPin);
+  counters.transfers++;
+
+  startNext();
+
+  transfer->done = true;
+  if (transfer->callback != NULL) {
+    transfer->callback(transfer);
+  }
+}
+
+/**************************************************************************//**
+ * @brief Copy the counters
+ *****************************************************************************/
+void SPIBUS_GetCounters(SPIBUS_Counters_TypeDef *copy)
+{
+  copy->acquired = counters.acquired;
+  copy->waited = counters.waited;
+  copy->transfers = counters.transfers;
+  copy->switches = counters.switches;
+}
+
+/** @} (end group SpiBus) */
+/** @} (end group kitdrv) */
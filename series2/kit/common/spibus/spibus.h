@@ -0,0 +1,165 @@
+/***************************************************************************//**
+ * @file
+ * @brief SPI bus shared by several devices, with queued LDMA transfers.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2022 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ******************************************************************************/
+
+
+#ifndef __SPIBUS_H
+#define __SPIBUS_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "em_device.h"
+#include "em_cmu.h"
+#include "em_gpio.h"
+#include "em_ldma.h"
+#include "em_usart.h"
+
+/***************************************************************************//**
+ * @addtogroup kitdrv
+ * @{
+ ******************************************************************************/
+
+/***************************************************************************//**
+ * @addtogroup SpiBus
+ * @brief SPI bus shared by several devices, with queued LDMA transfers
+ * @details
+ *    One USART in SPI master mode drives SCLK, MOSI and MISO for every
+ *    device on the bus, each device is a client with its own chip select,
+ *    bit rate, clock mode and bit order. SPIBUS_ClientInit() works out the
+ *    CLKDIV and CTRL bits of a client once, so switching the bus from one
+ *    client to another is two register writes, and none at all when the
+ *    same client uses the bus again.
+ *
+ *    A client either holds the bus for a transaction of its own, between
+ *    SPIBUS_Acquire() and SPIBUS_Release(), as the MX25 flash driver does
+ *    around each command when MX25_SPIBUS is defined, or queues transfers
+ *    with SPIBUS_Queue(). A queued transfer is moved by the LDMA with the
+ *    chip select driven by the bus; it starts at once if the bus is free,
+ *    else when the bus is released, and queued transfers go before a
+ *    waiting SPIBUS_Acquire(). The callback of a transfer runs in the LDMA
+ *    interrupt and may queue the next one; a client that always queues
+ *    again from its callback keeps the bus from SPIBUS_Acquire().
+ *
+ *    SPIBUS_Acquire() waits for the queued transfers to finish, so it must
+ *    not be called from an interrupt of the same or a higher priority than
+ *    LDMA_IRQn. The application calls LDMA_Init() before SPIBUS_Init() and
+ *    SPIBUS_IRQHandler() from its LDMA_IRQHandler().
+ * @{
+ ******************************************************************************/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** LDMA channel receiving queued transfers */
+#ifndef SPIBUS_LDMA_RX_CHANNEL
+#define SPIBUS_LDMA_RX_CHANNEL  (DMA_CHAN_COUNT - 4)
+#endif
+
+/** LDMA channel sending queued transfers */
+#ifndef SPIBUS_LDMA_TX_CHANNEL
+#define SPIBUS_LDMA_TX_CHANNEL  (DMA_CHAN_COUNT - 3)
+#endif
+
+#if SPIBUS_LDMA_RX_CHANNEL == SPIBUS_LDMA_TX_CHANNEL
+#error "SPIBUS_LDMA_RX_CHANNEL and SPIBUS_LDMA_TX_CHANNEL must differ"
+#endif
+
+/** Longest queued transfer, one LDMA descriptor */
+#define SPIBUS_MAX_TRANSFER     LDMA_DESCRIPTOR_MAX_XFER_SIZE
+
+/** USART and pins of the bus */
+typedef struct {
+  USART_TypeDef *usart;
+  CMU_Clock_TypeDef clock;            /**< Clock of the USART */
+  uint8_t routeIndex;                 /**< Index of GPIO->USARTROUTE[] */
+  GPIO_Port_TypeDef mosiPort;
+  uint8_t mosiPin;
+  GPIO_Port_TypeDef misoPort;
+  uint8_t misoPin;
+  GPIO_Port_TypeDef sclkPort;
+  uint8_t sclkPin;
+  LDMA_PeripheralSignal_t rxSignal;   /**< RXDATAV signal of the USART */
+  LDMA_PeripheralSignal_t txSignal;   /**< TXBL signal of the USART */
+} SPIBUS_Init_TypeDef;
+
+/** One device on the bus, filled in by SPIBUS_ClientInit() */
+typedef struct {
+  GPIO_Port_TypeDef csPort;
+  uint8_t csPin;
+  uint32_t clkdiv;                    /**< USART CLKDIV of the bit rate */
+  uint32_t ctrl;                      /**< USART CTRL clock mode and order */
+} SPIBUS_Client_TypeDef;
+
+struct SPIBUS_Transfer;
+
+/** Called in the LDMA interrupt when a queued transfer has finished */
+typedef void (*SPIBUS_Callback_TypeDef)(struct SPIBUS_Transfer *transfer);
+
+/** Queued transfer, owned by the bus from SPIBUS_Queue() to its callback */
+typedef struct SPIBUS_Transfer {
+  const SPIBUS_Client_TypeDef *client;
+  const uint8_t *tx;                  /**< Bytes sent, NULL sends 0xFF */
+  uint8_t *rx;                        /**< Bytes received, NULL drops them */
+  uint16_t length;                    /**< 1 to SPIBUS_MAX_TRANSFER bytes */
+  SPIBUS_Callback_TypeDef callback;   /**< NULL for none */
+  volatile bool done;                 /**< Set before the callback */
+  struct SPIBUS_Transfer *next;       /**< Used by the bus */
+} SPIBUS_Transfer_TypeDef;
+
+/** Counters, all only ever count up */
+typedef struct {
+  uint32_t acquired;                  /**< Holds by SPIBUS_Acquire() */
+  uint32_t waited;                    /**< Holds that waited for the bus */
+  uint32_t transfers;                 /**< Queued transfers finished */
+  uint32_t switches;                  /**< Changes of the bus settings */
+} SPIBUS_Counters_TypeDef;
+
+void SPIBUS_Init(const SPIBUS_Init_TypeDef *init);
+void SPIBUS_ClientInit(SPIBUS_Client_TypeDef *client,
+                       GPIO_Port_TypeDef csPort, uint8_t csPin,
+                       uint32_t baudrate, USART_ClockMode_TypeDef clockMode,
+                       bool msbf);
+void SPIBUS_Acquire(const SPIBUS_Client_TypeDef *client);
+bool SPIBUS_TryAcquire(const SPIBUS_Client_TypeDef *client);
+void SPIBUS_Release(const SPIBUS_Client_TypeDef *client);
+USART_TypeDef *SPIBUS_Usart(void);
+bool SPIBUS_Queue(SPIBUS_Transfer_TypeDef *transfer);
+bool SPIBUS_Idle(void);
+void SPIBUS_IRQHandler(void);
+void SPIBUS_GetCounters(SPIBUS_Counters_TypeDef *counters);
+
+#ifdef __cplusplus
+}
+#endif
+
+/** @} (end group SpiBus) */
+/** @} (end group kitdrv) */
+
+#endif
@@ -0,0 +1,339 @@
+/***************************************************************************//**
+ * @file
+ * @brief Monotonic nanosecond timestamps from the RTC and a TIMER.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2022 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ******************************************************************************/
+
+#include "em_cmu.h"
+#include "em_core.h"
+#include "em_timer.h"
+#if defined(RTCC_PRESENT)
+#include "em_rtcc.h"
+#else
+#include "peripheral_sysrtc.h"
+#endif
+#include "timestamp.h"
+
+/***************************************************************************//**
+ * @addtogroup kitdrv
+ * @{
+ ******************************************************************************/
+
+/***************************************************************************//**
+ * @addtogroup Timestamp
+ * @{
+ ******************************************************************************/
+
+// The RTC must tick at 32.768 kHz, 2 ^ TICK_SHIFT Hz
+#define TICK_SHIFT        15
+#define TICK_MASK         ((1UL << TICK_SHIFT) - 1)
+
+// Whole nanoseconds in a tick, the most a time within a tick can add
+#define TICK_NS           30517
+
+#define NS_PER_S          1000000000ULL
+
+static uint32_t           countMask;
+static uint32_t           cyclesQ16;
+static uint32_t           nsPerCycleQ16;
+static uint32_t           anchorTick;
+static uint64_t           anchorQ16;
+static uint32_t           rtcHigh;
+static uint32_t           rtcLast;
+static uint64_t           lastNs;
+static uint32_t           corrections;
+
+/**************************************************************************//**
+ * @brief Read the RTC count
+ *****************************************************************************/
+static uint32_t rtcCount(void)
+{
+#if defined(RTCC_PRESENT)
+  return RTCC_CounterGet();
+#else
+  return sl_sysrtc_get_counter();
+#endif
+}
+
+/**************************************************************************//**
+ * @brief Start the RTC unless it is already running
+ *
+ * @return The RTC tick frequency
+ *****************************************************************************/
+static uint32_t rtcStart(void)
+{
+#if defined(RTCC_PRESENT)
+  RTCC_Init_TypeDef rtccInit = RTCC_INIT_DEFAULT;
+
+  CMU_ClockEnable(cmuClock_RTCC, true);
+  if ((RTCC->STATUS & RTCC_STATUS_RUNNING) == 0) {
+    CMU_ClockSelectSet(cmuClock_RTCCCLK, TIMESTAMP_RTC_CLOCK);
+    rtccInit.presc = rtccCntPresc_1;
+    RTCC_Init(&rtccInit);
+  }
+  return CMU_ClockFreqGet(cmuClock_RTCC);
+#else
+  sl_sysrtc_config_t sysrtcConfig = SYSRTC_CONFIG_DEFAULT;
+
+  CMU_ClockEnable(cmuClock_SYSRTC, true);
+  if ((SYSRTC0->STATUS & SYSRTC_STATUS_RUNNING) == 0) {
+    CMU_ClockSelectSet(cmuClock_SYSRTCCLK, TIMESTAMP_RTC_CLOCK);
+    sl_sysrtc_init(&sysrtcConfig);
+    sl_sysrtc_enable();
+  }
+  return CMU_ClockFreqGet(cmuClock_SYSRTC);
+#endif
+}
+
+/**************************************************************************//**
+ * @brief Extend an RTC count to 64 bits, called with interrupts masked
+ *****************************************************************************/
+static uint64_t extend(uint32_t tick)
+{
+  if (tick < rtcLast) {
+    rtcHigh++;
+  }
+  rtcLast = tick;
+
+  return ((uint64_t)rtcHigh << 32) | tick;
+}
+
+/**************************************************************************//**
+ * @brief Read the RTC and TIMER counts of the same tick
+ *
+ * @details
+ *    The RTC is read again after the TIMER and both are read once more if
+ *    it has moved on, so the TIMER count always lies within the tick.
+ *****************************************************************************/
+static uint32_t readPair(uint32_t *count)
+{
+  uint32_t tick;
+
+  do {
+    tick = rtcCount();
+    *count = TIMER_CounterGet(TIMESTAMP_TIMER);
+  } while (rtcCount() != tick);
+
+  return tick;
+}
+
+/**************************************************************************//**
+ * @brief Wait for the next RTC tick edge and read the TIMER right on it
+ *****************************************************************************/
+static uint32_t waitEdge(uint32_t *count)
+{
+  uint32_t start = rtcCount();
+  uint32_t tick;
+
+  while ((tick = rtcCount()) == start) {
+  }
+  *count = TIMER_CounterGet(TIMESTAMP_TIMER);
+
+  return tick;
+}
+
+/**************************************************************************//**
+ * @brief Start the RTC and TIMER and calibrate the clock
+ *
+ * @return
+ *    false if the RTC does not tick at 32.768 kHz.
+ *****************************************************************************/
+bool TIMESTAMP_Init(void)
+{
+  TIMER_Init_TypeDef timerInit = TIMER_INIT_DEFAULT;
+
+  if (rtcStart() != (1UL << TICK_SHIFT)) {
+    return false;
+  }
+
+  // Free running over the whole count range
+  CMU_ClockEnable(TIMESTAMP_TIMER_CLOCK, true);
+  timerInit.enable = true;
+  timerInit.prescale = timerPrescale1;
+  TIMER_Init(TIMESTAMP_TIMER, &timerInit);
+  countMask = TIMER_MaxCount(TIMESTAMP_TIMER);
+  TIMER_TopSet(TIMESTAMP_TIMER, countMask);
+
+  rtcHigh = 0;
+  rtcLast = rtcCount();
+  lastNs = 0;
+  corrections = 0;
+
+  TIMESTAMP_Calibrate();
+  return true;
+}
+
+/**************************************************************************//**
+ * @brief Measure the TIMER cycles per RTC tick and anchor the clock
+ *
+ * @details
+ *    Adds up the TIMER cycles of TIMESTAMP_CAL_TICKS ticks, one tick at a
+ *    time so that a 16-bit TIMER does not wrap in between. Interrupts are
+ *    masked for the whole measurement, about 2 ms.
+ *****************************************************************************/
+void TIMESTAMP_Calibrate(void)
+{
+  uint32_t tick, count, prev, i;
+  uint64_t total = 0;
+  CORE_DECLARE_IRQ_STATE;
+
+  CORE_ENTER_ATOMIC();
+
+  waitEdge(&prev);
+  for (i = 0; i < TIMESTAMP_CAL_TICKS; i++) {
+    tick = waitEdge(&count);
+    total += (count - prev) & countMask;
+    prev = count;
+  }
+
+  anchorTick = tick;
+  anchorQ16 = (uint64_t)count << 16;
+  extend(tick);
+
+  // Cycles per tick and nanoseconds per cycle, both in 16.16 fixed point
+  cyclesQ16 = (uint32_t)((total << 16) / TIMESTAMP_CAL_TICKS);
+  if (cyclesQ16 == 0) {
+    cyclesQ16 = 1;
+  }
+  nsPerCycleQ16 = (uint32_t)(((NS_PER_S << 32) >> TICK_SHIFT) / cyclesQ16);
+
+  CORE_EXIT_ATOMIC();
+}
+
+/**************************************************************************//**
+ * @brief Anchor the clock on the next RTC tick edge
+ *
+ * @details
+ *    Call after a wakeup from EM2 to get back the resolution of the TIMER.
+ *    Waits at most one tick, 31 us, with interrupts masked.
+ *****************************************************************************/
+void TIMESTAMP_Resync(void)
+{
+  uint32_t tick, count;
+  CORE_DECLARE_IRQ_STATE;
+
+  CORE_ENTER_ATOMIC();
+
+  tick = waitEdge(&count);
+  extend(tick);
+  anchorTick = tick;
+  anchorQ16 = (uint64_t)count << 16;
+
+  CORE_EXIT_ATOMIC();
+}
+
+/**************************************************************************//**
+ * @brief Get the time since TIMESTAMP_Init() in nanoseconds
+ *
+ * @details
+ *    Never less than the time returned before, and never more than one
+ *    tick away from the RTC. Safe to call from interrupt handlers, it does
+ *    not divide and does not wait.
+ *****************************************************************************/
+uint64_t TIMESTAMP_GetNs(void)
+{
+  uint32_t tick, count, edge, frac, limit, fineNs;
+  uint64_t ticks, ns;
+  CORE_DECLARE_IRQ_STATE;
+
+  CORE_ENTER_ATOMIC();
+
+  tick = readPair(&count);
+  ticks = extend(tick);
+
+  // Predict the TIMER count at the edge of this tick
+  anchorQ16 += (uint64_t)(tick - anchorTick) * cyclesQ16;
+  anchorTick = tick;
+  edge = (uint32_t)(anchorQ16 >> 16) & countMask;
+
+  // The count must lie within the tick, move the anchor if it does not
+  frac = (count - edge) & countMask;
+  limit = (cyclesQ16 + 0xFFFF) >> 16;
+  if (frac >= limit) {
+    if (frac > (countMask >> 1)) {
+      // The edge was predicted after the count
+      anchorQ16 -= (uint64_t)((edge - count) & countMask) << 16;
+      frac = 0;
+    } else {
+      // The edge was predicted more than a tick before the count
+      anchorQ16 += (uint64_t)(frac - limit + 1) << 16;
+      frac = limit - 1;
+    }
+    corrections++;
+  }
+
+  fineNs = (uint32_t)(((uint64_t)frac * nsPerCycleQ16) >> 16);
+  if (fineNs > TICK_NS) {
+    fineNs = TICK_NS;
+  }
+
+  ns = (ticks >> TICK_SHIFT) * NS_PER_S
+       + (((ticks & TICK_MASK) * NS_PER_S) >> TICK_SHIFT)
+       + fineNs;
+  if (ns < lastNs) {
+    ns = lastNs;
+  }
+  lastNs = ns;
+
+  CORE_EXIT_ATOMIC();
+
+  return ns;
+}
+
+/**************************************************************************//**
+ * @brief Get the RTC count extended to 64 bits
+ *****************************************************************************/
+uint64_t TIMESTAMP_GetTicks(void)
+{
+  uint64_t ticks;
+  CORE_DECLARE_IRQ_STATE;
+
+  CORE_ENTER_ATOMIC();
+  ticks = extend(rtcCount());
+  CORE_EXIT_ATOMIC();
+
+  return ticks;
+}
+
+/**************************************************************************//**
+ * @brief Get the measured TIMER cycles per RTC tick in 16.16 fixed point
+ *****************************************************************************/
+uint32_t TIMESTAMP_GetCyclesPerTick(void)
+{
+  return cyclesQ16;
+}
+
+/**************************************************************************//**
+ * @brief Get the number of times the anchor was moved back into the tick
+ *****************************************************************************/
+uint32_t TIMESTAMP_GetCorrectionCount(void)
+{
+  return corrections;
+}
+
+/** @} (end group Timestamp) */
+/** @} (end group kitdrv) */
@@ -0,0 +1,111 @@
+/***************************************************************************//**
+ * @file
+ * @brief Monotonic nanosecond timestamps from the RTC and a TIMER.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2022 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ******************************************************************************/
+
+#ifndef __TIMESTAMP_H
+#define __TIMESTAMP_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "em_device.h"
+
+/***************************************************************************//**
+ * @addtogroup kitdrv
+ * @{
+ ******************************************************************************/
+
+/***************************************************************************//**
+ * @addtogroup Timestamp
+ * @brief Monotonic 64-bit nanosecond clock, cheap enough for interrupts
+ * @details
+ *    The RTC, the RTCC on devices that have one and the SYSRTC otherwise,
+ *    counts 32.768 kHz ticks of 30.5 us and keeps counting in EM2. A TIMER
+ *    counting the EM01GRPACLK splits each tick into core clock cycles, but
+ *    wraps and stops in EM2. TIMESTAMP_GetNs() combines both: the RTC count
+ *    gives the time of the last tick edge, and the TIMER count since that
+ *    edge, reduced modulo the TIMER width, gives the time within the tick.
+ *
+ *    The TIMER count at each tick edge is predicted from an anchor, a TIMER
+ *    count read right on an edge, and the measured TIMER cycles per tick.
+ *    Whenever a reading shows that the prediction has drifted out of the
+ *    tick, the anchor is moved back into it, so the clock follows the RTC
+ *    over any period and the two counters never need an interrupt. The
+ *    TIMER only has to cover one tick, a 16-bit TIMER is enough.
+ *
+ *    After EM2 the TIMER has stood still and the prediction is off by an
+ *    unknown part of a tick; the clock stays monotonic, but only has tick
+ *    resolution until TIMESTAMP_Resync() has anchored it again, which
+ *    waits for the next tick edge, at most 31 us. TIMESTAMP_Calibrate()
+ *    measures the cycles per tick again after a change of the TIMER clock.
+ *
+ *    The component starts the RTC without a prescaler if it is not running
+ *    yet, and shares it otherwise; an LFXO selected by TIMESTAMP_RTC_CLOCK
+ *    must have been set up with CMU_LFXOInit() first. The component does
+ *    not use any RTC channel or interrupt. The RTC count is extended to 64
+ *    bits in software, so the clock must be read at least once per RTC
+ *    wrap, 36 hours.
+ * @{
+ ******************************************************************************/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** TIMER that splits the RTC ticks, and its clock */
+#ifndef TIMESTAMP_TIMER
+#define TIMESTAMP_TIMER             TIMER1
+#define TIMESTAMP_TIMER_CLOCK       cmuClock_TIMER1
+#endif
+
+/** RTC clock source, cmuSelect_LFRCO or cmuSelect_LFXO */
+#ifndef TIMESTAMP_RTC_CLOCK
+#define TIMESTAMP_RTC_CLOCK         cmuSelect_LFRCO
+#endif
+
+/** RTC ticks timed by TIMESTAMP_Calibrate(), about 2 ms */
+#ifndef TIMESTAMP_CAL_TICKS
+#define TIMESTAMP_CAL_TICKS         64
+#endif
+
+bool      TIMESTAMP_Init(void);
+void      TIMESTAMP_Calibrate(void);
+void      TIMESTAMP_Resync(void);
+uint64_t  TIMESTAMP_GetNs(void);
+uint64_t  TIMESTAMP_GetTicks(void);
+uint32_t  TIMESTAMP_GetCyclesPerTick(void);
+uint32_t  TIMESTAMP_GetCorrectionCount(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+/** @} (end group Timestamp) */
+/** @} (end group kitdrv) */
+
+#endif
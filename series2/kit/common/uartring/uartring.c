@@ -0,0 +1,302 @@
+/***************************************************************************//**
+ * @file
+ * @brief Full-duplex USART driver on LDMA-fed RX and TX rings.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2022 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ******************************************************************************/
+
+
+#include <stddef.h>
+#include <string.h>
+#include "uartring.h"
+
+/***************************************************************************//**
+ * @addtogroup kitdrv
+ * @{
+ ******************************************************************************/
+
+/***************************************************************************//**
+ * @addtogroup UartRing
+ * @{
+ ******************************************************************************/
+
+/**************************************************************************//**
+ * @brief Get the RX bytes received so far, counting freely
+ * @details
+ *   The halves count says which half the LDMA was in at the last
+ *   interrupt. If the channel has moved into the next half since and the
+ *   interrupt is still to come, the destination address is up to a half
+ *   ahead of it, which the masked difference still counts right.
+ *****************************************************************************/
+static uint32_t rxHead(UARTRING_Handle_t *handle)
+{
+  uint32_t size = handle->init.rxSize;
+  uint32_t halves = handle->rxHalves;
+  uint32_t offset = LDMA->CH[handle->init.rxChannel].DST
+                    - (uint32_t)(uintptr_t)handle->init.rxBuffer;
+
+  return (halves * (size / 2))
+         + ((offset - (halves & 1) * (size / 2)) & (size - 1));
+}
+
+/**************************************************************************//**
+ * @brief Start sending the bytes written, up to the ring end and at most
+ *   half the ring. Only called with the TX channel idle.
+ *****************************************************************************/
+static void txStart(UARTRING_Handle_t *handle)
+{
+  LDMA_TransferCfg_t cfg = LDMA_TRANSFER_CFG_PERIPHERAL(handle->init.txSignal);
+  uint32_t size = handle->init.txSize;
+  uint32_t tail = handle->txTail;
+  uint32_t chunk = handle->txHead - tail;
+  uint32_t index = tail & (size - 1);
+
+  if (chunk > size - index) {
+    chunk = size - index;
+  }
+  if ((size > 2) && (chunk > size / 2)) {
+    chunk = size / 2;
+  }
+  if (chunk > LDMA_DESCRIPTOR_MAX_XFER_SIZE) {
+    chunk = LDMA_DESCRIPTOR_MAX_XFER_SIZE;
+  }
+  handle->txChunk = chunk;
+
+  handle->txDesc = (LDMA_Descriptor_t)
+    LDMA_DESCRIPTOR_SINGLE_M2P_BYTE(&handle->init.txBuffer[index],
+                                    &handle->init.usart->TXDATA, chunk);
+  LDMA_StartTransfer(handle->init.txChannel, &cfg, &handle->txDesc);
+}
+
+/**************************************************************************//**
+ * @brief Initialize the rings and start receiving
+ * @param[out] handle Driver state
+ * @param[in] init Configuration, copied into the handle
+ * @return false if a ring size is not a power of two in range or a channel
+ *   does not exist
+ *****************************************************************************/
+bool UARTRING_Init(UARTRING_Handle_t *handle, const UARTRING_Init_t *init)
+{
+  LDMA_TransferCfg_t cfg = LDMA_TRANSFER_CFG_PERIPHERAL(init->rxSignal);
+  USART_TypeDef *usart = init->usart;
+  uint32_t half = init->rxSize / 2;
+
+  if ((init->rxSize < 4) || (half > LDMA_DESCRIPTOR_MAX_XFER_SIZE)
+      || (init->rxSize & (init->rxSize - 1))
+      || (init->txSize < 2) || (init->txSize & (init->txSize - 1))
+      || (init->rxChannel >= DMA_CHAN_COUNT)
+      || (init->txChannel >= DMA_CHAN_COUNT)
+      || (init->rxChannel == init->txChannel)) {
+    return false;
+  }
+
+  handle->init       = *init;
+  handle->rxHalves   = 0;
+  handle->rxTail     = 0;
+  handle->txHead     = 0;
+  handle->txTail     = 0;
+  handle->txChunk    = 0;
+  handle->txBusy     = false;
+  handle->rxOverruns = 0;
+
+  // Two halves linked into a loop, each half done interrupts
+  handle->rxDesc[0] = (LDMA_Descriptor_t)
+    LDMA_DESCRIPTOR_LINKREL_P2M_BYTE(&usart->RXDATA, init->rxBuffer, half, 1);
+  handle->rxDesc[1] = (LDMA_Descriptor_t)
+    LDMA_DESCRIPTOR_LINKREL_P2M_BYTE(&usart->RXDATA, init->rxBuffer + half,
+                                     half, -1);
+  handle->rxDesc[0].xfer.doneIfs = 1;
+  handle->rxDesc[1].xfer.doneIfs = 1;
+
+  /*
+   * The RX timer starts at the end of each received frame and stops when
+   * the next one starts, so it only reaches the compare value once a
+   * burst has ended.
+   */
+  usart->TIMECMP1 = USART_TIMECMP1_TSTART_RXEOF
+                    | USART_TIMECMP1_TSTOP_RXACT
+                    | (UARTRING_RX_IDLE_BITS << _USART_TIMECMP1_TCMPVAL_SHIFT);
+  USART_IntClear(usart, USART_IF_TCMP1);
+  USART_IntEnable(usart, USART_IEN_TCMP1);
+
+  LDMA_StartTransfer(init->rxChannel, &cfg, &handle->rxDesc[0]);
+
+  return true;
+}
+
+/**************************************************************************//**
+ * @brief Read received bytes
+ * @return Bytes copied to @p data, 0 to @p len, never waits
+ *****************************************************************************/
+size_t UARTRING_Read(UARTRING_Handle_t *handle, void *data, size_t len)
+{
+  uint32_t size = handle->init.rxSize;
+  uint32_t head = rxHead(handle);
+  uint32_t tail = handle->rxTail;
+  uint32_t index, part;
+  uint8_t *dst = data;
+
+  // The LDMA has lapped the reader, keep the last half ring
+  if (head - tail > size) {
+    tail = head - size / 2;
+    handle->rxOverruns++;
+  }
+
+  if (len > head - tail) {
+    len = head - tail;
+  }
+
+  index = tail & (size - 1);
+  part = (len < size - index) ? len : size - index;
+  memcpy(dst, &handle->init.rxBuffer[index], part);
+  memcpy(dst + part, handle->init.rxBuffer, len - part);
+
+  handle->rxTail = tail + len;
+
+  return len;
+}
+
+/**************************************************************************//**
+ * @brief Queue bytes to send
+ * @details
+ *   Single producer: call from one context only, the main loop or one
+ *   interrupt handler.
+ * @return Bytes queued, less than @p len when the TX ring is full,
+ *   never waits
+ *****************************************************************************/
+size_t UARTRING_Write(UARTRING_Handle_t *handle, const void *data, size_t len)
+{
+  uint32_t size = handle->init.txSize;
+  uint32_t head = handle->txHead;
+  uint32_t room = size - (head - handle->txTail);
+  uint32_t index, part;
+  const uint8_t *src = data;
+
+  if (len > room) {
+    len = room;
+  }
+  if (len == 0) {
+    return 0;
+  }
+
+  index = head & (size - 1);
+  part = (len < size - index) ? len : size - index;
+  memcpy(&handle->init.txBuffer[index], src, part);
+  memcpy(handle->init.txBuffer, src + part, len - part);
+
+  // The bytes must be in RAM before the LDMA can see the new head
+  __DMB();
+  handle->txHead = head + len;
+
+  /*
+   * The LDMA interrupt only ends a transfer when the head has not moved,
+   * and it can not run in the middle of this check while the channel is
+   * idle, so the channel is started exactly once.
+   */
+  if (!handle->txBusy) {
+    handle->txBusy = true;
+    txStart(handle);
+  }
+
+  return len;
+}
+
+/**************************************************************************//**
+ * @brief Get the number of received bytes waiting to be read
+ *****************************************************************************/
+size_t UARTRING_RxAvailable(UARTRING_Handle_t *handle)
+{
+  uint32_t pending = rxHead(handle) - handle->rxTail;
+
+  return (pending > handle->init.rxSize) ? handle->init.rxSize : pending;
+}
+
+/**************************************************************************//**
+ * @brief Get the free space in the TX ring
+ *****************************************************************************/
+size_t UARTRING_TxFree(UARTRING_Handle_t *handle)
+{
+  return handle->init.txSize - (handle->txHead - handle->txTail);
+}
+
+/**************************************************************************//**
+ * @brief Check if all bytes written are in the USART
+ * @details
+ *   The last bytes may still be in the USART transmit buffer, wait for its
+ *   TXC flag too before a baud rate change or EM2.
+ *****************************************************************************/
+bool UARTRING_TxIdle(UARTRING_Handle_t *handle)
+{
+  return !handle->txBusy;
+}
+
+/**************************************************************************//**
+ * @brief Get the number of RX ring overruns
+ *****************************************************************************/
+uint32_t UARTRING_RxOverruns(UARTRING_Handle_t *handle)
+{
+  return handle->rxOverruns;
+}
+
+/**************************************************************************//**
+ * @brief Handle the LDMA and the USART interrupts of the driver
+ * @details
+ *   Only the done flags of the two channels and the RX timer flag of the
+ *   USART are read and cleared, so other LDMA channels and USART
+ *   interrupts can share the handlers. The RX timer interrupt has nothing
+ *   to do but wake the core.
+ *****************************************************************************/
+void UARTRING_IRQHandler(UARTRING_Handle_t *handle)
+{
+  uint32_t rxMask = 1UL << handle->init.rxChannel;
+  uint32_t txMask = 1UL << handle->init.txChannel;
+  uint32_t flags = LDMA_IntGet() & (rxMask | txMask);
+
+  if (USART_IntGet(handle->init.usart) & USART_IF_TCMP1) {
+    USART_IntClear(handle->init.usart, USART_IF_TCMP1);
+  }
+
+  if (flags == 0) {
+    return;
+  }
+  LDMA_IntClear(flags);
+
+  if (flags & rxMask) {
+    handle->rxHalves++;
+  }
+
+  if ((flags & txMask) && handle->txBusy) {
+    handle->txTail += handle->txChunk;
+    if (handle->txHead != handle->txTail) {
+      txStart(handle);
+    } else {
+      handle->txBusy = false;
+    }
+  }
+}
+
+/** @} (end group UartRing) */
+/** @} (end group kitdrv) */
@@ -0,0 +1,137 @@
+/***************************************************************************//**
+ * @file
+ * @brief Full-duplex USART driver on LDMA-fed RX and TX rings.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2022 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ******************************************************************************/
+
+
+#ifndef __UARTRING_H
+#define __UARTRING_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "em_device.h"
+#include "em_ldma.h"
+#include "em_usart.h"
+
+/***************************************************************************//**
+ * @addtogroup kitdrv
+ * @{
+ ******************************************************************************/
+
+/***************************************************************************//**
+ * @addtogroup UartRing
+ * @brief Full-duplex USART driver on LDMA-fed RX and TX rings
+ * @details
+ *    Each direction has its own RAM ring with one producer and one
+ *    consumer, so the rings need no locks: the application is the
+ *    consumer of the RX ring and the producer of the TX ring, the LDMA
+ *    and the driver interrupts are the other side. Each index is written
+ *    by one side only and counts bytes freely, the ring position is the
+ *    index modulo the ring size, which is a power of two.
+ *
+ *    The LDMA moves every byte, so the interrupt load does not grow with
+ *    the baud rate and the driver holds up at 1 Mbaud in both directions
+ *    at once. The RX channel loops over the RX ring in two halves and
+ *    never stops; the driver counts the halves in the LDMA interrupt and
+ *    takes the position inside the half from the channel's destination
+ *    address, so received bytes are readable as soon as they are in RAM.
+ *    The USART RX timer interrupts UARTRING_RX_IDLE_BITS bit times after
+ *    the last frame of a burst, so the core also wakes up for a few
+ *    bytes that do not fill a half. The TX channel sends the bytes
+ *    written up to the ring end, at most half the ring at a time, so the
+ *    application can refill one half while the other goes out.
+ *
+ *    Without a consumer the RX ring is overwritten. A read that finds the
+ *    LDMA more than a ring ahead skips to the last half ring received and
+ *    counts an overrun. The LDMA interrupt must not be held off for half
+ *    an RX ring of bytes, 160 us for a 32 byte ring at 1 Mbaud.
+ *
+ *    The application sets up the USART (clock, baud rate, route) and
+ *    calls LDMA_Init() first, calls UARTRING_IRQHandler() from its
+ *    LDMA_IRQHandler() and from the USART RX and TX IRQ handlers, and
+ *    enables both USART interrupts in the NVIC.
+ * @{
+ ******************************************************************************/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef UARTRING_RX_IDLE_BITS
+#define UARTRING_RX_IDLE_BITS     20    /**< RX idle bit times before waking, 1 to 255 */
+#endif
+
+#if (UARTRING_RX_IDLE_BITS < 1) || (UARTRING_RX_IDLE_BITS > 255)
+#error "UARTRING_RX_IDLE_BITS must be 1 to 255"
+#endif
+
+/** Configuration */
+typedef struct {
+  USART_TypeDef           *usart;       /**< USART in asynchronous mode */
+  unsigned int            rxChannel;    /**< LDMA channel filling the RX ring */
+  unsigned int            txChannel;    /**< LDMA channel sending the TX ring */
+  LDMA_PeripheralSignal_t rxSignal;     /**< RXDATAV request of the USART */
+  LDMA_PeripheralSignal_t txSignal;     /**< TXBL request of the USART */
+  uint8_t                 *rxBuffer;    /**< RX ring */
+  size_t                  rxSize;       /**< RX ring bytes, power of two, 4 to 4096 */
+  uint8_t                 *txBuffer;    /**< TX ring */
+  size_t                  txSize;       /**< TX ring bytes, power of two, 2 or more */
+} UARTRING_Init_t;
+
+/** Driver state, treat as opaque */
+typedef struct {
+  UARTRING_Init_t         init;
+  LDMA_Descriptor_t       rxDesc[2];
+  LDMA_Descriptor_t       txDesc;
+  volatile uint32_t       rxHalves;     /**< RX halves filled, interrupt side */
+  volatile uint32_t       rxTail;       /**< RX bytes read, application side */
+  volatile uint32_t       txHead;       /**< TX bytes written, application side */
+  volatile uint32_t       txTail;       /**< TX bytes sent, interrupt side */
+  volatile uint32_t       txChunk;      /**< Bytes in the running TX transfer */
+  volatile bool           txBusy;
+  volatile uint32_t       rxOverruns;
+} UARTRING_Handle_t;
+
+bool     UARTRING_Init(UARTRING_Handle_t *handle, const UARTRING_Init_t *init);
+size_t   UARTRING_Read(UARTRING_Handle_t *handle, void *data, size_t len);
+size_t   UARTRING_Write(UARTRING_Handle_t *handle, const void *data, size_t len);
+size_t   UARTRING_RxAvailable(UARTRING_Handle_t *handle);
+size_t   UARTRING_TxFree(UARTRING_Handle_t *handle);
+bool     UARTRING_TxIdle(UARTRING_Handle_t *handle);
+uint32_t UARTRING_RxOverruns(UARTRING_Handle_t *handle);
+void     UARTRING_IRQHandler(UARTRING_Handle_t *handle);
+
+#ifdef __cplusplus
+}
+#endif
+
+/** @} (end group UartRing) */
+/** @} (end group kitdrv) */
+
+#endif
@@ -0,0 +1,294 @@
+/***************************************************************************//**
+ * @file main.c
+ * @brief Frame buffer fills, crops and partial updates with the ldmablit
+ * driver. See readme.txt for details.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2021 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ *******************************************************************************
+ * # Evaluation Quality
+ * This code has been minimally tested to ensure that it builds and is suitable 
+ * as a demonstration for evaluation purposes only. This code will be maintained
+ * at the sole discretion of Silicon Labs.
+ ******************************************************************************/
+
+#include <stdint.h>
+#include "em_device.h"
+#include "em_chip.h"
+#include "em_cmu.h"
+#include "em_emu.h"
+#include "em_ldma.h"
+#include "ldmablit.h"
+
+/*******************************************************************************
+ *******************************   DEFINES   ***********************************
+ ******************************************************************************/
+
+// 16-bit colour frame buffer and the image cropped into it
+#define FB_WIDTH            96
+#define FB_HEIGHT           64
+#define IMAGE_WIDTH         40
+#define IMAGE_HEIGHT        30
+
+// Crop of the image, and where it goes in the frame buffer
+#define CROP_X              5
+#define CROP_Y              4
+#define CROP_WIDTH          24
+#define CROP_HEIGHT         20
+#define DEST_X              33
+#define DEST_Y              21
+
+#define BACKGROUND          0x001F
+
+// 1-bit frame buffer of a 160 x 320 memory LCD, 20 bytes per line plus a
+// line address and a dummy byte for an SPI update straight from memory
+#define LCD_LINES           320
+#define LCD_STRIDE          22
+
+// Partial update taller than one loop counter segment, at odd addresses
+#define PART_X              3
+#define PART_Y              10
+#define PART_WIDTH          11
+#define PART_HEIGHT         300
+
+/*******************************************************************************
+ ***************************   GLOBAL VARIABLES   *******************************
+ ******************************************************************************/
+
+static uint16_t frameBuffer[FB_HEIGHT][FB_WIDTH];
+static uint16_t image[IMAGE_HEIGHT][IMAGE_WIDTH];
+static uint8_t lcdBuffer[LCD_LINES][LCD_STRIDE];
+static uint8_t lcdShadow[LCD_LINES][LCD_STRIDE];
+
+// The LDMA result matches the CPU reference
+static volatile bool fillOk;
+static volatile bool cropOk;
+static volatile bool partOk;
+
+// Cycles of the crop by CPU loops and by the LDMA, while the CPU waits
+static volatile uint32_t cpuCycles;
+static volatile uint32_t ldmaCycles;
+
+// Blits completed, counted by the callback
+static volatile uint32_t blitsDone;
+
+// Passes completed over all blits
+static volatile uint32_t passes;
+
+/**************************************************************************//**
+ * @brief
+ *    LDMA interrupt handler, shared with the other LDMA users
+ *****************************************************************************/
+void LDMA_IRQHandler(void)
+{
+  LDMABLIT_IRQHandler();
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Called by LDMABLIT_IRQHandler() at the end of each blit
+ *****************************************************************************/
+static void blitDone(void *user)
+{
+  (void)user;
+  blitsDone++;
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Start a blit and sleep in EM1 until it is done
+ *****************************************************************************/
+static bool runBlit(const LDMABLIT_Blit_t *blit, bool fill, uint32_t value)
+{
+  uint32_t done = blitsDone;
+  bool started;
+
+  if (fill) {
+    started = LDMABLIT_Fill(blit, value, blitDone, NULL);
+  } else {
+    started = LDMABLIT_Copy(blit, blitDone, NULL);
+  }
+  if (!started) {
+    return false;
+  }
+
+  // A pending interrupt still wakes the core with interrupts masked, so
+  // the blit can not complete between the check and the sleep unnoticed
+  __disable_irq();
+  while (blitsDone == done) {
+    EMU_EnterEM1();
+    __enable_irq();
+    __disable_irq();
+  }
+  __enable_irq();
+  return true;
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Fill the frame buffer with the background colour and check it
+ *****************************************************************************/
+static void checkFill(void)
+{
+  LDMABLIT_Blit_t blit = {
+    .dst = frameBuffer,
+    .dstStride = sizeof(frameBuffer[0]),
+    .width = FB_WIDTH,
+    .height = FB_HEIGHT,
+    .size = ldmaCtrlSizeHalf,
+  };
+  uint32_t x, y;
+
+  fillOk = runBlit(&blit, true, BACKGROUND);
+  for (y = 0; y < FB_HEIGHT; y++) {
+    for (x = 0; x < FB_WIDTH; x++) {
+      if (frameBuffer[y][x] != BACKGROUND) {
+        fillOk = false;
+      }
+    }
+  }
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Crop the image into the frame buffer, time it against CPU loops and
+ *    check it
+ *****************************************************************************/
+static void checkCrop(void)
+{
+  LDMABLIT_Blit_t blit = {
+    .src = &image[CROP_Y][CROP_X],
+    .srcStride = sizeof(image[0]),
+    .dst = &frameBuffer[DEST_Y][DEST_X],
+    .dstStride = sizeof(frameBuffer[0]),
+    .width = CROP_WIDTH,
+    .height = CROP_HEIGHT,
+    .size = ldmaCtrlSizeHalf,
+  };
+  uint32_t start, x, y;
+  bool inside;
+
+  start = DWT->CYCCNT;
+  for (y = 0; y < CROP_HEIGHT; y++) {
+    for (x = 0; x < CROP_WIDTH; x++) {
+      frameBuffer[DEST_Y + y][DEST_X + x] = image[CROP_Y + y][CROP_X + x];
+    }
+  }
+  cpuCycles = DWT->CYCCNT - start;
+
+  checkFill();
+
+  start = DWT->CYCCNT;
+  cropOk = LDMABLIT_Copy(&blit, blitDone, NULL);
+  LDMABLIT_Wait();
+  ldmaCycles = DWT->CYCCNT - start;
+  while (LDMABLIT_IsBusy()) {
+  }
+
+  // The crop and the background around it
+  for (y = 0; y < FB_HEIGHT; y++) {
+    for (x = 0; x < FB_WIDTH; x++) {
+      inside = (x >= DEST_X) && (x < DEST_X + CROP_WIDTH)
+               && (y >= DEST_Y) && (y < DEST_Y + CROP_HEIGHT);
+      if (frameBuffer[y][x] != (inside
+                                ? image[CROP_Y + y - DEST_Y][CROP_X + x - DEST_X]
+                                : BACKGROUND)) {
+        cropOk = false;
+      }
+    }
+  }
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Update a tall part of the memory LCD buffer from its shadow and check
+ *    it
+ *****************************************************************************/
+static void checkPartialUpdate(void)
+{
+  LDMABLIT_Blit_t blit = {
+    .src = &lcdShadow[PART_Y][PART_X],
+    .srcStride = LCD_STRIDE,
+    .dst = &lcdBuffer[PART_Y][PART_X],
+    .dstStride = LCD_STRIDE,
+    .width = PART_WIDTH,
+    .height = PART_HEIGHT,
+    .size = ldmaCtrlSizeByte,
+  };
+  uint32_t x, y;
+  bool inside;
+
+  for (y = 0; y < LCD_LINES; y++) {
+    for (x = 0; x < LCD_STRIDE; x++) {
+      lcdBuffer[y][x] = 0;
+      lcdShadow[y][x] = (uint8_t)((y * 3) + x + passes);
+    }
+  }
+
+  partOk = runBlit(&blit, false, 0);
+  for (y = 0; y < LCD_LINES; y++) {
+    for (x = 0; x < LCD_STRIDE; x++) {
+      inside = (x >= PART_X) && (x < PART_X + PART_WIDTH)
+               && (y >= PART_Y) && (y < PART_Y + PART_HEIGHT);
+      if (lcdBuffer[y][x] != (inside ? lcdShadow[y][x] : 0)) {
+        partOk = false;
+      }
+    }
+  }
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Main function
+ *****************************************************************************/
+int main(void)
+{
+  LDMA_Init_t init = LDMA_INIT_DEFAULT;
+  uint32_t x, y;
+
+  CHIP_Init();
+
+  // Start the cycle counter
+  CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+  DWT->CYCCNT = 0;
+  DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+  CMU_ClockEnable(cmuClock_LDMA, true);
+  LDMA_Init(&init);
+
+  for (y = 0; y < IMAGE_HEIGHT; y++) {
+    for (x = 0; x < IMAGE_WIDTH; x++) {
+      image[y][x] = (uint16_t)((y << 8) | x);
+    }
+  }
+
+  // Run and check all blits, over and over
+  while (1) {
+    checkFill();
+    checkCrop();
+    checkPartialUpdate();
+    passes++;
+  }
+}
@@ -0,0 +1,693 @@
+/***************************************************************************//**
+ * @file main.c
+ * @brief Measures LDMA throughput for memory to memory, looped, linked, 2D and
+ * peripheral to memory transfers and for several active channels. See
+ * readme.txt for details.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2021 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ *******************************************************************************
+ * # Evaluation Quality
+ * This code has been minimally tested to ensure that it builds and is suitable 
+ * as a demonstration for evaluation purposes only. This code will be maintained
+ * at the sole discretion of Silicon Labs.
+ ******************************************************************************/
+
+#include <string.h>
+#include "em_device.h"
+#include "em_chip.h"
+#include "em_cmu.h"
+#include "em_iadc.h"
+#include "em_ldma.h"
+#include "em_usart.h"
+
+/*******************************************************************************
+ *******************************   DEFINES   ***********************************
+ ******************************************************************************/
+
+// Core clock, the highest without a flash wait state
+#define CORE_FREQ                 cmuHFRCODPLLFreq_39M0Hz
+
+// Transfers timed per result, the fastest is kept
+#define RUNS                      4
+
+// Buffer size, words
+#define BUFFER_WORDS              2048
+
+// Memory to memory block sizes, bytes; a descriptor moves at most 2048 units
+#define NUM_M2M_SIZES             5
+#define NUM_M2M_UNITS             3
+
+// Bytes moved by the looped, linked and 2D transfers
+#define CHAIN_BYTES               2048
+#define NUM_LOOPED                4
+#define NUM_LINKED                6
+#define MAX_LINKED                64
+
+// 2D copy of a 32 x 16 word window out of a 64 x 32 word image
+#define IMAGE_WIDTH               64
+#define IMAGE_HEIGHT              32
+#define WINDOW_WIDTH              32
+#define WINDOW_HEIGHT             16
+#define WINDOW_ROW                8
+#define WINDOW_COL                16
+
+// Peripheral to memory transfers
+#define P2M_SPI                   0
+#define P2M_UART                  1
+#define P2M_ADC                   2
+#define NUM_P2M                   3
+#define P2M_BYTES                 1024
+#define ADC_SAMPLES               1024
+
+// SPI bit rate, emlib sets the closest, at most half the USART clock
+#define SPI_BITRATE               20000000
+#define UART_BAUDRATE             1000000
+
+// IADC clocks and conversion time at the default 2x oversampling
+#define CLK_SRC_ADC_FREQ          20000000
+#define CLK_ADC_FREQ              10000000
+#define ADC_CYCLES_PER_SAMPLE     ((4 * 2) + 2)
+
+// Arbitration between memory to memory channels
+#define ARB_CHANNELS              4
+#define ARB_WORDS                 (BUFFER_WORDS / ARB_CHANNELS)
+#define NUM_ARB_CONFIGS           4
+
+// LDMA channels
+#define M2M_CHANNEL               0
+#define RX_CHANNEL                0
+#define TX_CHANNEL                1
+
+/*******************************************************************************
+ ***************************   GLOBAL VARIABLES   *******************************
+ ******************************************************************************/
+
+// One memory to memory transfer
+typedef struct {
+  uint32_t unitBytes;         // Bytes per unit, 1, 2 or 4
+  uint32_t bytes;             // Bytes moved
+  uint32_t cycles;            // From the request to the channel done
+  uint32_t kBps;              // Throughput, kB/s
+  bool ok;                    // The copy matches the source
+} M2mResult_t;
+
+// A transfer of CHAIN_BYTES as loops, linked descriptors or 2D rows
+typedef struct {
+  uint32_t count;             // Loops, descriptors or rows
+  uint32_t bytes;             // Bytes moved
+  uint32_t cycles;            // From the request to the channel done
+  uint32_t kBps;              // Throughput, kB/s
+  int32_t overheadCycles;     // Cost of each loop, descriptor or row
+                              // after the first, against one descriptor
+  bool ok;                    // The copy matches the source
+} ChainResult_t;
+
+// A transfer from a peripheral
+typedef struct {
+  uint32_t units;             // Bytes or samples moved
+  uint32_t cycles;            // From the start to the channel done
+  uint32_t ratePerSec;        // Units per second
+  uint32_t nominalPerSec;     // Units per second the peripheral is set for
+  uint32_t efficiency;        // ratePerSec in % of nominalPerSec
+  bool ok;                    // Data right and no overflow
+} P2mResult_t;
+
+// ARB_CHANNELS copies of ARB_WORDS started together
+typedef struct {
+  uint32_t blockUnits;        // Units moved per arbitration, 0 for all
+  uint32_t numFixed;          // Channels with fixed priority
+  uint32_t ch0ArbSlots;       // Round robin slots of channel 0
+  uint32_t doneCycles[ARB_CHANNELS];
+  uint32_t totalCycles;       // Until the last channel is done
+  uint32_t kBps;              // Throughput of all channels, kB/s
+} ArbResult_t;
+
+typedef struct {
+  LDMA_CtrlBlockSize_t blockSize;
+  uint32_t blockUnits;
+  uint32_t numFixed;
+  LDMA_CfgArbSlots_t ch0ArbSlots;
+  uint32_t ch0Slots;
+} ArbConfig_t;
+
+static const uint32_t m2mSizes[NUM_M2M_SIZES] = { 16, 64, 256, 1024, 2048 };
+
+static const LDMA_CtrlSize_t m2mUnits[NUM_M2M_UNITS] = {
+  ldmaCtrlSizeByte, ldmaCtrlSizeHalf, ldmaCtrlSizeWord
+};
+
+static const uint32_t loopCounts[NUM_LOOPED] = { 4, 16, 64, 256 };
+
+static const uint32_t linkCounts[NUM_LINKED] = { 2, 4, 8, 16, 32, 64 };
+
+static const ArbConfig_t arbConfigs[NUM_ARB_CONFIGS] = {
+  // Round robin, one unit per turn
+  { ldmaCtrlBlockSizeUnit1, 1, 0, ldmaCfgArbSlotsAs1, 1 },
+  // Round robin, each channel moves all its units before the next one
+  { ldmaCtrlBlockSizeAll, 0, 0, ldmaCfgArbSlotsAs1, 1 },
+  // Round robin, channel 0 gets 8 turns for each turn of the others
+  { ldmaCtrlBlockSizeUnit1, 1, 0, ldmaCfgArbSlotsAs8, 8 },
+  // Fixed priority, channel 0 first
+  { ldmaCtrlBlockSizeUnit1, 1, ARB_CHANNELS, ldmaCfgArbSlotsAs1, 1 },
+};
+
+static volatile M2mResult_t m2m[NUM_M2M_UNITS * NUM_M2M_SIZES];
+static volatile ChainResult_t looped[NUM_LOOPED];
+static volatile ChainResult_t linked[NUM_LINKED];
+static volatile ChainResult_t copy2d;
+static volatile P2mResult_t p2m[NUM_P2M];
+static volatile ArbResult_t arbitration[NUM_ARB_CONFIGS];
+
+// Passes completed over all measurements
+static volatile uint32_t passes;
+
+static uint32_t coreHz;
+
+// Cycles of one descriptor moving CHAIN_BYTES in words
+static uint32_t chainBaseCycles;
+
+static uint32_t srcBuffer[BUFFER_WORDS];
+static uint32_t dstBuffer[BUFFER_WORDS];
+
+static LDMA_Descriptor_t descriptors[MAX_LINKED];
+
+/**************************************************************************//**
+ * @brief
+ *    LDMA interrupt handler, no channel raises its done interrupt.
+ *****************************************************************************/
+void LDMA_IRQHandler(void)
+{
+  uint32_t pending = LDMA_IntGet();
+
+  LDMA_IntClear(pending);
+
+  // Stop in case there was an error
+  if (pending & LDMA_IF_ERROR) {
+    __BKPT(0);
+  }
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Throughput of a transfer, kB/s at the core clock
+ *****************************************************************************/
+static uint32_t kBps(uint32_t bytes, uint32_t cycles)
+{
+  return (uint32_t)(((uint64_t)bytes * coreHz) / ((uint64_t)cycles * 1000));
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Wait for channels to be done
+ *
+ * @details
+ *    The CHDONE register is polled, so each time is late by up to one turn
+ *    of the loop, a few tens of cycles.
+ *
+ * @param[in] mask
+ *    Channels to wait for
+ *
+ * @param[in] start
+ *    DWT cycle count the channels were started at
+ *
+ * @param[out] doneCycles
+ *    Cycles to each channel done, indexed by channel, may be NULL
+ *
+ * @return
+ *    Cycles to the last channel done
+ *****************************************************************************/
+static uint32_t waitDone(uint32_t mask, uint32_t start, uint32_t *doneCycles)
+{
+  uint32_t pending = mask;
+  uint32_t cycles = 0;
+  uint32_t done, ch;
+
+  while (pending) {
+    done = LDMA->CHDONE & pending;
+    if (done) {
+      cycles = DWT->CYCCNT - start;
+      for (ch = 0; doneCycles && (ch < ARB_CHANNELS); ch++) {
+        if (done & (1 << ch)) {
+          doneCycles[ch] = cycles;
+        }
+      }
+      pending &= ~done;
+    }
+  }
+
+  return cycles;
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Start loaded memory to memory channels with one software request
+ *****************************************************************************/
+static uint32_t runChannels(uint32_t mask, uint32_t *doneCycles)
+{
+  uint32_t start;
+
+  LDMA->CHDONE_CLR = mask;
+  start = DWT->CYCCNT;
+  LDMA->SWREQ = mask;
+
+  return waitDone(mask, start, doneCycles);
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Time a memory to memory transfer, the fastest of RUNS
+ *
+ * @details
+ *    The first descriptor waits for the software request, so that the
+ *    time does not include LDMA_StartTransfer().
+ *****************************************************************************/
+static uint32_t timeTransfer(const LDMA_TransferCfg_t *cfg,
+                             LDMA_Descriptor_t *first)
+{
+  uint32_t cycles, i;
+  uint32_t min = 0xFFFFFFFF;
+
+  first->xfer.structReq = 0;
+
+  for (i = 0; i < RUNS; i++) {
+    LDMA_StartTransfer(M2M_CHANNEL, cfg, first);
+    cycles = runChannels(1 << M2M_CHANNEL, NULL);
+    if (cycles < min) {
+      min = cycles;
+    }
+  }
+
+  return min;
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Single descriptor copies of bytes, half words and words
+ *****************************************************************************/
+static void measureM2m(void)
+{
+  LDMA_TransferCfg_t cfg = LDMA_TRANSFER_CFG_MEMORY();
+  LDMA_Descriptor_t *desc = &descriptors[0];
+  volatile M2mResult_t *r;
+  uint32_t u, s;
+
+  for (u = 0; u < NUM_M2M_UNITS; u++) {
+    for (s = 0; s < NUM_M2M_SIZES; s++) {
+      r = &m2m[(u * NUM_M2M_SIZES) + s];
+
+      *desc = (LDMA_Descriptor_t)LDMA_DESCRIPTOR_SINGLE_M2M_BYTE(
+        srcBuffer, dstBuffer, m2mSizes[s] >> m2mUnits[u]);
+      desc->xfer.size = m2mUnits[u];
+      desc->xfer.doneIfs = 0;
+
+      memset(dstBuffer, 0, m2mSizes[s]);
+      r->unitBytes = 1 << m2mUnits[u];
+      r->bytes = m2mSizes[s];
+      r->cycles = timeTransfer(&cfg, desc);
+      r->kBps = kBps(m2mSizes[s], r->cycles);
+      r->ok = (memcmp(dstBuffer, srcBuffer, m2mSizes[s]) == 0);
+
+      if ((m2mUnits[u] == ldmaCtrlSizeWord) && (m2mSizes[s] == CHAIN_BYTES)) {
+        chainBaseCycles = r->cycles;
+      }
+    }
+  }
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Fill in a looped, linked or 2D result
+ *****************************************************************************/
+static void setChainResult(volatile ChainResult_t *r, uint32_t count,
+                           uint32_t cycles, bool ok)
+{
+  r->count = count;
+  r->bytes = CHAIN_BYTES;
+  r->cycles = cycles;
+  r->kBps = kBps(CHAIN_BYTES, cycles);
+  r->overheadCycles = ((int32_t)cycles - (int32_t)chainBaseCycles)
+                      / (int32_t)(count - 1);
+  r->ok = ok;
+}
+
+/**************************************************************************//**
+ * @brief
+ *    One descriptor run again for each loop, as in ldma_single_looped
+ *
+ * @details
+ *    Each loop moves the same CHAIN_BYTES / loops bytes again, so the
+ *    channel moves CHAIN_BYTES in all.
+ *****************************************************************************/
+static void measureLooped(void)
+{
+  LDMA_TransferCfg_t cfg;
+  LDMA_Descriptor_t *desc = &descriptors[0];
+  uint32_t i, chunk, cycles;
+
+  for (i = 0; i < NUM_LOOPED; i++) {
+    chunk = CHAIN_BYTES / loopCounts[i];
+
+    cfg = (LDMA_TransferCfg_t)LDMA_TRANSFER_CFG_MEMORY_LOOP(loopCounts[i] - 1);
+    *desc = (LDMA_Descriptor_t)LDMA_DESCRIPTOR_SINGLE_M2M_WORD(
+      srcBuffer, dstBuffer, chunk / 4);
+    desc->xfer.decLoopCnt = 1;
+    desc->xfer.doneIfs = 0;
+
+    memset(dstBuffer, 0, CHAIN_BYTES);
+    cycles = timeTransfer(&cfg, desc);
+    setChainResult(&looped[i], loopCounts[i], cycles,
+                   memcmp(dstBuffer, srcBuffer, chunk) == 0);
+  }
+}
+
+/**************************************************************************//**
+ * @brief
+ *    CHAIN_BYTES split over a list of linked descriptors
+ *****************************************************************************/
+static void measureLinked(void)
+{
+  LDMA_TransferCfg_t cfg = LDMA_TRANSFER_CFG_MEMORY();
+  uint32_t i, d, count, chunk;
+
+  for (i = 0; i < NUM_LINKED; i++) {
+    count = linkCounts[i];
+    chunk = CHAIN_BYTES / count;
+
+    for (d = 0; d < count; d++) {
+      descriptors[d] = (LDMA_Descriptor_t)LDMA_DESCRIPTOR_LINKREL_M2M_WORD(
+        (uint8_t *)srcBuffer + (d * chunk),
+        (uint8_t *)dstBuffer + (d * chunk),
+        chunk / 4,
+        1);
+      descriptors[d].xfer.doneIfs = 0;
+    }
+    descriptors[count - 1].xfer.link = 0;
+
+    memset(dstBuffer, 0, CHAIN_BYTES);
+    setChainResult(&linked[i], count, timeTransfer(&cfg, &descriptors[0]),
+                   memcmp(dstBuffer, srcBuffer, CHAIN_BYTES) == 0);
+  }
+}
+
+/**************************************************************************//**
+ * @brief
+ *    2D copy of a window out of an image, as in ldma_2d_copy
+ *
+ * @details
+ *    The first descriptor moves the first row and links to the second,
+ *    which skips to the next row with relative addresses and loops for the
+ *    other rows.
+ *****************************************************************************/
+static void measure2d(void)
+{
+  LDMA_TransferCfg_t cfg =
+    LDMA_TRANSFER_CFG_MEMORY_LOOP(WINDOW_HEIGHT - 2);
+  uint32_t offset = (WINDOW_ROW * IMAGE_WIDTH) + WINDOW_COL;
+  uint32_t cycles, row;
+  bool ok = true;
+
+  descriptors[0] = (LDMA_Descriptor_t)LDMA_DESCRIPTOR_LINKREL_M2M_WORD(
+    &srcBuffer[offset], &dstBuffer[offset], WINDOW_WIDTH, 1);
+  descriptors[0].xfer.doneIfs = 0;
+
+  descriptors[1] = (LDMA_Descriptor_t)LDMA_DESCRIPTOR_LINKREL_M2M_WORD(
+    (IMAGE_WIDTH - WINDOW_WIDTH) * 4,
+    (IMAGE_WIDTH - WINDOW_WIDTH) * 4,
+    WINDOW_WIDTH,
+    0);
+  descriptors[1].xfer.srcAddrMode = ldmaCtrlSrcAddrModeRel;
+  descriptors[1].xfer.dstAddrMode = ldmaCtrlDstAddrModeRel;
+  descriptors[1].xfer.decLoopCnt = 1;
+  descriptors[1].xfer.doneIfs = 0;
+  descriptors[1].xfer.link = 0;
+
+  memset(dstBuffer, 0, sizeof(dstBuffer));
+  cycles = timeTransfer(&cfg, &descriptors[0]);
+
+  for (row = 0; row < WINDOW_HEIGHT; row++) {
+    if (memcmp(&dstBuffer[offset + (row * IMAGE_WIDTH)],
+               &srcBuffer[offset + (row * IMAGE_WIDTH)],
+               WINDOW_WIDTH * 4) != 0) {
+      ok = false;
+    }
+  }
+
+  setChainResult(&copy2d, WINDOW_HEIGHT, cycles, ok);
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Fill in a peripheral to memory result
+ *****************************************************************************/
+static void setP2mResult(volatile P2mResult_t *r, uint32_t units,
+                         uint32_t cycles, uint32_t nominal, bool ok)
+{
+  r->units = units;
+  r->cycles = cycles;
+  r->ratePerSec = (uint32_t)(((uint64_t)units * coreHz) / cycles);
+  r->nominalPerSec = nominal;
+  r->efficiency = (uint32_t)(((uint64_t)r->ratePerSec * 100) / nominal);
+  r->ok = ok;
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Receive P2M_BYTES in internal loopback; USART0 must be initialized
+ *
+ * @details
+ *    One channel feeds TXDATA on TXBL and the other empties RXDATA on
+ *    RXDATAV, so the time is that of the receive channel.
+ *
+ * @param[in] bitsPerByte
+ *    Bit times each byte takes on the line
+ *****************************************************************************/
+static void measureUsart(volatile P2mResult_t *r, uint32_t bitsPerByte)
+{
+  LDMA_TransferCfg_t rxCfg =
+    LDMA_TRANSFER_CFG_PERIPHERAL(ldmaPeripheralSignal_USART0_RXDATAV);
+  LDMA_TransferCfg_t txCfg =
+    LDMA_TRANSFER_CFG_PERIPHERAL(ldmaPeripheralSignal_USART0_TXBL);
+  uint8_t *rx = (uint8_t *)dstBuffer;
+  uint8_t *tx = (uint8_t *)srcBuffer;
+  uint32_t start, cycles;
+  bool ok;
+
+  // Internal loopback, no pins are used
+  USART0->CTRL_SET = USART_CTRL_LOOPBK;
+  USART0->CMD = USART_CMD_CLEARRX | USART_CMD_CLEARTX;
+  USART_IntClear(USART0, _USART_IF_MASK);
+
+  descriptors[0] = (LDMA_Descriptor_t)LDMA_DESCRIPTOR_SINGLE_P2M_BYTE(
+    &USART0->RXDATA, rx, P2M_BYTES);
+  descriptors[0].xfer.doneIfs = 0;
+  descriptors[1] = (LDMA_Descriptor_t)LDMA_DESCRIPTOR_SINGLE_M2P_BYTE(
+    tx, &USART0->TXDATA, P2M_BYTES);
+  descriptors[1].xfer.doneIfs = 0;
+
+  memset(rx, 0, P2M_BYTES);
+  LDMA->CHDONE_CLR = 1 << RX_CHANNEL;
+  LDMA_StartTransfer(RX_CHANNEL, &rxCfg, &descriptors[0]);
+
+  start = DWT->CYCCNT;
+  LDMA_StartTransfer(TX_CHANNEL, &txCfg, &descriptors[1]);
+  cycles = waitDone(1 << RX_CHANNEL, start, NULL);
+
+  ok = (memcmp(rx, tx, P2M_BYTES) == 0)
+       && !(USART_IntGet(USART0) & USART_IF_RXOF);
+
+  setP2mResult(r, P2M_BYTES, cycles,
+               USART_BaudrateGet(USART0) / bitsPerByte, ok);
+
+  USART_Reset(USART0);
+}
+
+/**************************************************************************//**
+ * @brief
+ *    USART0 as an SPI main and as a UART, in internal loopback
+ *****************************************************************************/
+static void measureSerial(void)
+{
+  USART_InitSync_TypeDef spiInit = USART_INITSYNC_DEFAULT;
+  USART_InitAsync_TypeDef uartInit = USART_INITASYNC_DEFAULT;
+
+  CMU_ClockEnable(cmuClock_USART0, true);
+
+  spiInit.baudrate = SPI_BITRATE;
+  USART_InitSync(USART0, &spiInit);
+  measureUsart(&p2m[P2M_SPI], 8);
+
+  // Start bit, 8 data bits and a stop bit
+  uartInit.baudrate = UART_BAUDRATE;
+  USART_InitAsync(USART0, &uartInit);
+  measureUsart(&p2m[P2M_UART], 10);
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Continuous IADC conversions of ground, read from the single FIFO
+ *****************************************************************************/
+static void measureAdc(void)
+{
+  IADC_Init_t init = IADC_INIT_DEFAULT;
+  IADC_AllConfigs_t initAllConfigs = IADC_ALLCONFIGS_DEFAULT;
+  IADC_InitSingle_t initSingle = IADC_INITSINGLE_DEFAULT;
+  IADC_SingleInput_t singleInput = IADC_SINGLEINPUT_DEFAULT;
+  LDMA_TransferCfg_t cfg =
+    LDMA_TRANSFER_CFG_PERIPHERAL(ldmaPeripheralSignal_IADC0_IADC_SINGLE);
+  uint32_t start, cycles;
+  bool ok;
+
+  CMU_ClockEnable(cmuClock_IADC0, true);
+  CMU_ClockSelectSet(cmuClock_IADCCLK, cmuSelect_FSRCO);
+
+  init.srcClkPrescale = IADC_calcSrcClkPrescale(IADC0, CLK_SRC_ADC_FREQ, 0);
+  init.warmup = iadcWarmupKeepWarm;
+
+  initAllConfigs.configs[0].reference = iadcCfgReferenceInt1V2;
+  initAllConfigs.configs[0].vRef = 1210;
+  initAllConfigs.configs[0].osrHighSpeed = iadcCfgOsrHighSpeed2x;
+  initAllConfigs.configs[0].adcClkPrescale =
+    IADC_calcAdcClkPrescale(IADC0, CLK_ADC_FREQ, 0, iadcCfgModeNormal,
+                            init.srcClkPrescale);
+
+  // Convert back to back, request the LDMA for each result
+  initSingle.triggerAction = iadcTriggerActionContinuous;
+  initSingle.dataValidLevel = iadcFifoCfgDvl1;
+  initSingle.fifoDmaWakeup = true;
+
+  singleInput.posInput = iadcPosInputGnd;
+  singleInput.negInput = iadcNegInputGnd;
+
+  IADC_init(IADC0, &init, &initAllConfigs);
+  IADC_initSingle(IADC0, &initSingle, &singleInput);
+  IADC_clearInt(IADC0, _IADC_IF_MASK);
+
+  descriptors[0] = (LDMA_Descriptor_t)LDMA_DESCRIPTOR_SINGLE_P2M_WORD(
+    &IADC0->SINGLEFIFODATA, dstBuffer, ADC_SAMPLES);
+  descriptors[0].xfer.doneIfs = 0;
+
+  LDMA->CHDONE_CLR = 1 << RX_CHANNEL;
+  LDMA_StartTransfer(RX_CHANNEL, &cfg, &descriptors[0]);
+
+  start = DWT->CYCCNT;
+  IADC_command(IADC0, iadcCmdStartSingle);
+  cycles = waitDone(1 << RX_CHANNEL, start, NULL);
+  IADC_command(IADC0, iadcCmdStopSingle);
+
+  ok = !(IADC_getInt(IADC0) & IADC_IF_SINGLEFIFOOF);
+
+  setP2mResult(&p2m[P2M_ADC], ADC_SAMPLES, cycles,
+               CLK_ADC_FREQ / ADC_CYCLES_PER_SAMPLE, ok);
+
+  IADC_reset(IADC0);
+}
+
+/**************************************************************************//**
+ * @brief
+ *    ARB_CHANNELS copies started by the same request, for each arbitration
+ *    setting
+ *****************************************************************************/
+static void measureArbitration(void)
+{
+  LDMA_TransferCfg_t cfg;
+  const ArbConfig_t *config;
+  volatile ArbResult_t *r;
+  uint32_t doneCycles[ARB_CHANNELS];
+  uint32_t i, ch;
+
+  for (i = 0; i < NUM_ARB_CONFIGS; i++) {
+    config = &arbConfigs[i];
+    r = &arbitration[i];
+
+    LDMA->CTRL = (LDMA->CTRL & ~_LDMA_CTRL_NUMFIXED_MASK)
+                 | (config->numFixed << _LDMA_CTRL_NUMFIXED_SHIFT);
+
+    for (ch = 0; ch < ARB_CHANNELS; ch++) {
+      cfg = (LDMA_TransferCfg_t)LDMA_TRANSFER_CFG_MEMORY();
+      if (ch == 0) {
+        cfg.ldmaCfgArbSlots = config->ch0ArbSlots;
+      }
+
+      descriptors[ch] = (LDMA_Descriptor_t)LDMA_DESCRIPTOR_SINGLE_M2M_WORD(
+        &srcBuffer[ch * ARB_WORDS], &dstBuffer[ch * ARB_WORDS], ARB_WORDS);
+      descriptors[ch].xfer.blockSize = config->blockSize;
+      descriptors[ch].xfer.structReq = 0;
+      descriptors[ch].xfer.doneIfs = 0;
+
+      LDMA_StartTransfer(ch, &cfg, &descriptors[ch]);
+    }
+
+    r->blockUnits = config->blockUnits;
+    r->numFixed = config->numFixed;
+    r->ch0ArbSlots = config->ch0Slots;
+    r->totalCycles = runChannels((1 << ARB_CHANNELS) - 1, doneCycles);
+    r->kBps = kBps(ARB_CHANNELS * ARB_WORDS * 4, r->totalCycles);
+    for (ch = 0; ch < ARB_CHANNELS; ch++) {
+      r->doneCycles[ch] = doneCycles[ch];
+    }
+  }
+
+  LDMA->CTRL &= ~_LDMA_CTRL_NUMFIXED_MASK;
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Main function
+ *****************************************************************************/
+int main(void)
+{
+  LDMA_Init_t init = LDMA_INIT_DEFAULT;
+  uint32_t i;
+
+  CHIP_Init();
+
+  CMU_HFRCODPLLBandSet(CORE_FREQ);
+  coreHz = SystemCoreClockGet();
+
+  // Start the cycle counter
+  CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+  DWT->CYCCNT = 0;
+  DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+  CMU_ClockEnable(cmuClock_LDMA, true);
+  LDMA_Init(&init);
+
+  for (i = 0; i < sizeof(srcBuffer); i++) {
+    ((uint8_t *)srcBuffer)[i] = (uint8_t)((i * 7) + 3);
+  }
+
+  // Measure everything, over and over
+  while (1) {
+    measureM2m();
+    measureLooped();
+    measureLinked();
+    measure2d();
+    measureSerial();
+    measureAdc();
+    measureArbitration();
+    passes++;
+  }
+}
@@ -0,0 +1,271 @@
+/***************************************************************************//**
+ * @file main.c
+ * @brief Shares the LDMA between several users with the ldmamgr channel
+ * manager and descriptor pool. See readme.txt for details.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2021 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ *******************************************************************************
+ * # Evaluation Quality
+ * This code has been minimally tested to ensure that it builds and is suitable 
+ * as a demonstration for evaluation purposes only. This code will be maintained
+ * at the sole discretion of Silicon Labs.
+ ******************************************************************************/
+
+#include <string.h>
+#include "em_device.h"
+#include "em_chip.h"
+#include "em_cmu.h"
+#include "em_emu.h"
+#include "em_ldma.h"
+#include "ldmamem.h"
+#include "ldmamgr.h"
+
+/*******************************************************************************
+ *******************************   DEFINES   ***********************************
+ ******************************************************************************/
+
+// Fixed priority channels, 0 and 1, for ldmaMgrPriorityHigh
+#define NUM_FIXED           2
+
+// Segments of the two gather jobs, and bytes per segment
+#define HIGH_SEGMENTS       6
+#define NORMAL_SEGMENTS     3
+#define SEGMENT_SIZE        256
+
+// Copy done by the ldmamem driver on its reserved channel
+#define MEMCPY_SIZE         2048
+
+/*******************************************************************************
+ ***************************   GLOBAL VARIABLES   *******************************
+ ******************************************************************************/
+
+// A gather of segments into one buffer on an allocated channel
+typedef struct {
+  LDMAMGR_Priority_t priority;
+  unsigned int segments;
+  uint8_t (*src)[SEGMENT_SIZE];
+  uint8_t *dst;
+  int channel;                    // Allocated channel, -1 if none
+  LDMA_Descriptor_t *desc;        // Pool descriptors, NULL if none
+  volatile uint32_t done;         // Completions, counted by the callback
+  uint32_t errors;                // Gathers that do not match the segments
+} GatherJob_t;
+
+static uint8_t highSrc[HIGH_SEGMENTS][SEGMENT_SIZE];
+static uint8_t highDst[HIGH_SEGMENTS * SEGMENT_SIZE];
+static uint8_t normalSrc[NORMAL_SEGMENTS][SEGMENT_SIZE];
+static uint8_t normalDst[NORMAL_SEGMENTS * SEGMENT_SIZE];
+static uint8_t memcpySrc[MEMCPY_SIZE];
+static uint8_t memcpyDst[MEMCPY_SIZE];
+
+static GatherJob_t jobs[2] = {
+  { ldmaMgrPriorityHigh, HIGH_SEGMENTS, highSrc, highDst, -1, NULL, 0, 0 },
+  { ldmaMgrPriorityNormal, NORMAL_SEGMENTS, normalSrc, normalDst, -1, NULL, 0, 0 },
+};
+
+// Channels and pool blocks free while all jobs run, and after
+static volatile uint32_t busyFreeMask;
+static volatile unsigned int busyFreeBlocks;
+static volatile uint32_t idleFreeMask;
+static volatile unsigned int idleFreeBlocks;
+
+// ldmamem copies done, and copies that do not match
+static volatile uint32_t memcpyDone;
+static volatile uint32_t memcpyErrors;
+
+// Allocations refused, and LDMA bus errors
+static volatile uint32_t allocErrors;
+static volatile uint32_t busErrors;
+
+// Passes completed
+static volatile uint32_t passes;
+
+/**************************************************************************//**
+ * @brief
+ *    LDMA interrupt handler, the manager dispatches the allocated channels
+ *    and ldmamem handles its reserved one
+ *****************************************************************************/
+void LDMA_IRQHandler(void)
+{
+  LDMAMGR_IRQHandler();
+  LDMAMEM_IRQHandler();
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Called by LDMAMGR_IRQHandler() when a gather job is done
+ *****************************************************************************/
+static void jobCallback(unsigned int channel, void *user)
+{
+  (void)channel;
+  ((GatherJob_t *)user)->done++;
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Called by LDMAMEM_IRQHandler() when the copy is done
+ *****************************************************************************/
+static void memcpyCallback(void *user)
+{
+  (void)user;
+  memcpyDone++;
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Called by LDMAMGR_IRQHandler() on a bus error
+ *****************************************************************************/
+static void errorCallback(void)
+{
+  busErrors++;
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Allocate a channel and pool descriptors for a job and start it
+ *****************************************************************************/
+static bool startJob(GatherJob_t *job)
+{
+  LDMA_TransferCfg_t cfg = LDMA_TRANSFER_CFG_MEMORY();
+  unsigned int i;
+
+  job->channel = LDMAMGR_Alloc(job->priority, jobCallback, job);
+  job->desc = LDMAMGR_DescAlloc(job->segments);
+  if ((job->channel < 0) || (job->desc == NULL)) {
+    return false;
+  }
+
+  // One linked descriptor per segment, the last one raises the done flag
+  for (i = 0; i < job->segments; i++) {
+    job->desc[i] = (LDMA_Descriptor_t)
+      LDMA_DESCRIPTOR_LINKREL_M2M_WORD(job->src[i], &job->dst[i * SEGMENT_SIZE],
+                                       SEGMENT_SIZE / 4, 1);
+    job->desc[i].xfer.doneIfs = 0;
+  }
+  job->desc[job->segments - 1].xfer.link = 0;
+  job->desc[job->segments - 1].xfer.doneIfs = 1;
+
+  memset(job->dst, 0, job->segments * SEGMENT_SIZE);
+  LDMA_StartTransfer(job->channel, &cfg, job->desc);
+
+  return true;
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Check a finished job and give its channel and descriptors back
+ *****************************************************************************/
+static void finishJob(GatherJob_t *job)
+{
+  unsigned int i;
+
+  if (job->channel >= 0) {
+    for (i = 0; i < job->segments; i++) {
+      if (memcmp(&job->dst[i * SEGMENT_SIZE], job->src[i], SEGMENT_SIZE) != 0) {
+        job->errors++;
+        break;
+      }
+    }
+    LDMAMGR_Free(job->channel);
+    job->channel = -1;
+  }
+  if (job->desc != NULL) {
+    LDMAMGR_DescFree(job->desc, job->segments);
+    job->desc = NULL;
+  }
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Main function
+ *****************************************************************************/
+int main(void)
+{
+  LDMA_Init_t init = LDMA_INIT_DEFAULT;
+  uint32_t done[2], copies;
+  unsigned int i, j;
+  bool started, copying;
+
+  CHIP_Init();
+
+  for (i = 0; i < SEGMENT_SIZE; i++) {
+    for (j = 0; j < HIGH_SEGMENTS; j++) {
+      highSrc[j][i] = (uint8_t)(i + j);
+    }
+    for (j = 0; j < NORMAL_SEGMENTS; j++) {
+      normalSrc[j][i] = (uint8_t)(~i + j);
+    }
+  }
+  for (i = 0; i < MEMCPY_SIZE; i++) {
+    memcpySrc[i] = (uint8_t)(i * 5);
+  }
+
+  CMU_ClockEnable(cmuClock_LDMA, true);
+  init.ldmaInitCtrlNumFixed = NUM_FIXED;
+  LDMAMGR_Init(&init);
+  LDMAMGR_SetErrorCallback(errorCallback);
+
+  // ldmamem keeps its fixed channel and its own interrupt hook
+  LDMAMGR_Reserve(LDMAMEM_CHANNEL);
+
+  while (1) {
+    done[0] = jobs[0].done;
+    done[1] = jobs[1].done;
+    copies = memcpyDone;
+
+    // Run both jobs and an ldmamem copy at the same time
+    started = startJob(&jobs[0]) && startJob(&jobs[1]);
+    memset(memcpyDst, 0, MEMCPY_SIZE);
+    copying = LDMAMEM_MemcpyAsync(memcpyDst, memcpySrc, MEMCPY_SIZE,
+                                  memcpyCallback, NULL);
+    busyFreeMask = LDMAMGR_FreeMask();
+    busyFreeBlocks = LDMAMGR_DescFreeBlocks();
+
+    // A pending interrupt still wakes the core with interrupts masked
+    __disable_irq();
+    while ((copying && (memcpyDone == copies))
+           || (started && ((jobs[0].done == done[0])
+                           || (jobs[1].done == done[1])))) {
+      EMU_EnterEM1();
+      __enable_irq();
+      __disable_irq();
+    }
+    __enable_irq();
+
+    if (!started) {
+      allocErrors++;
+    }
+    finishJob(&jobs[0]);
+    finishJob(&jobs[1]);
+    if (!copying || (memcmp(memcpyDst, memcpySrc, MEMCPY_SIZE) != 0)) {
+      memcpyErrors++;
+    }
+
+    idleFreeMask = LDMAMGR_FreeMask();
+    idleFreeBlocks = LDMAMGR_DescFreeBlocks();
+    passes++;
+  }
+}
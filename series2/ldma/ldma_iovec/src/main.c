@@ -0,0 +1,304 @@
+/***************************************************************************//**
+ * @file main.c
+ * @brief Sends packets from separate header, payload and trailer buffers
+ * over the VCOM with the ldmaiov driver. See readme.txt for details.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2021 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ *******************************************************************************
+ * # Evaluation Quality
+ * This code has been minimally tested to ensure that it builds and is suitable 
+ * as a demonstration for evaluation purposes only. This code will be maintained
+ * at the sole discretion of Silicon Labs.
+ ******************************************************************************/
+
+#include <string.h>
+#include "em_device.h"
+#include "em_chip.h"
+#include "em_cmu.h"
+#include "em_emu.h"
+#include "em_gpio.h"
+#include "em_ldma.h"
+#include "em_usart.h"
+#include "bsp.h"
+#include "crc32.h"
+#include "ldmaiov.h"
+#include "lpdelay.h"
+
+/*******************************************************************************
+ *******************************   DEFINES   ***********************************
+ ******************************************************************************/
+
+// Channels, the VCOM transmitter and the memory copies
+#define TX_LDMA_CHANNEL     0
+#define MEM_LDMA_CHANNEL    1
+
+// Time between two packets
+#define PACKET_PERIOD_MS    100
+
+// Header "$PKT,ssss,", payload, trailer "*cccccccc\r\n"
+#define HEADER_LEN          10
+#define TRAILER_LEN         11
+#define MAX_PAYLOAD         48
+#define MAX_PACKET          (HEADER_LEN + MAX_PAYLOAD + TRAILER_LEN)
+
+// Header, payload and trailer of a packet
+#define NUM_VECS            3
+
+/*******************************************************************************
+ ***************************   GLOBAL VARIABLES   *******************************
+ ******************************************************************************/
+
+static const char text[] =
+  "The quick brown fox jumps over the lazy dog and keeps on running. ";
+
+static LDMAIOV_Channel_t txChannel;
+static LDMAIOV_Channel_t memChannel;
+
+// The packet stays in three separate buffers
+static char header[HEADER_LEN];
+static char payload[MAX_PAYLOAD];
+static char trailer[TRAILER_LEN];
+
+// Gathered copy of the packet and the buffers it is scattered back into
+static uint8_t packet[MAX_PACKET];
+static char headerCopy[HEADER_LEN];
+static char payloadCopy[MAX_PAYLOAD];
+static char trailerCopy[TRAILER_LEN];
+
+// Gather and scatter match the buffers, counted over all packets
+static volatile uint32_t gatherErrors;
+static volatile uint32_t scatterErrors;
+
+// Packets sent, and vector lists the LDMA refused
+static volatile uint32_t packetsSent;
+static volatile uint32_t startErrors;
+
+// Channels done, set by the callback
+static volatile bool txDone;
+static volatile bool memDone;
+
+/**************************************************************************//**
+ * @brief
+ *    LDMA interrupt handler, shared with the other LDMA users
+ *****************************************************************************/
+void LDMA_IRQHandler(void)
+{
+  LDMAIOV_IRQHandler(&txChannel);
+  LDMAIOV_IRQHandler(&memChannel);
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Called by LDMAIOV_IRQHandler() when a channel has moved all vectors
+ *****************************************************************************/
+static void iovDone(LDMAIOV_Channel_t *channel, void *user)
+{
+  (void)channel;
+  *(volatile bool *)user = true;
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Sleep in EM1 until the flag is set by the callback
+ *****************************************************************************/
+static void waitFor(volatile bool *flag)
+{
+  // A pending interrupt still wakes the core with interrupts masked
+  __disable_irq();
+  while (!*flag) {
+    EMU_EnterEM1();
+    __enable_irq();
+    __disable_irq();
+  }
+  __enable_irq();
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Write a value as hexadecimal digits
+ *****************************************************************************/
+static void putHex(char *dst, uint32_t value, unsigned int digits)
+{
+  static const char hex[] = "0123456789ABCDEF";
+
+  while (digits > 0) {
+    digits--;
+    dst[digits] = hex[value & 0xF];
+    value >>= 4;
+  }
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Fill the header, payload and trailer of a packet, in place
+ *
+ * @return
+ *    Payload length
+ *****************************************************************************/
+static uint32_t buildPacket(uint32_t seq)
+{
+  uint32_t len = 1 + (seq % MAX_PAYLOAD);
+  uint32_t start = seq % (sizeof(text) - 1);
+  uint32_t crc, i;
+
+  memcpy(header, "$PKT,", 5);
+  putHex(&header[5], seq, 4);
+  header[9] = ',';
+
+  for (i = 0; i < len; i++) {
+    payload[i] = text[(start + i) % (sizeof(text) - 1)];
+  }
+
+  // CRC over the header and the payload, as the receiver checks it
+  crc = CRC32_Bitwise(CRC32_PRESET, header, HEADER_LEN);
+  crc = CRC32_Bitwise(crc, payload, len);
+  trailer[0] = '*';
+  putHex(&trailer[1], crc, 8);
+  trailer[9] = '\r';
+  trailer[10] = '\n';
+
+  return len;
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Gather the packet into one buffer and scatter it back, and check both
+ *****************************************************************************/
+static void checkMemory(const LDMAIOV_Vec_t *iov, uint32_t len)
+{
+  const LDMAIOV_Vec_t copies[NUM_VECS] = {
+    { headerCopy, HEADER_LEN },
+    { payloadCopy, len },
+    { trailerCopy, TRAILER_LEN },
+  };
+
+  memDone = false;
+  if (!LDMAIOV_Gather(&memChannel, iov, NUM_VECS, packet,
+                      iovDone, (void *)&memDone)) {
+    startErrors++;
+    return;
+  }
+  waitFor(&memDone);
+
+  if ((memcmp(packet, header, HEADER_LEN) != 0)
+      || (memcmp(&packet[HEADER_LEN], payload, len) != 0)
+      || (memcmp(&packet[HEADER_LEN + len], trailer, TRAILER_LEN) != 0)) {
+    gatherErrors++;
+  }
+
+  memDone = false;
+  if (!LDMAIOV_Scatter(&memChannel, packet, copies, NUM_VECS,
+                       iovDone, (void *)&memDone)) {
+    startErrors++;
+    return;
+  }
+  waitFor(&memDone);
+
+  if ((memcmp(headerCopy, header, HEADER_LEN) != 0)
+      || (memcmp(payloadCopy, payload, len) != 0)
+      || (memcmp(trailerCopy, trailer, TRAILER_LEN) != 0)) {
+    scatterErrors++;
+  }
+}
+
+/**************************************************************************//**
+ * @brief
+ *    USART0 to the board controller, as the async_polled example
+ *****************************************************************************/
+static void initUsart(void)
+{
+  USART_InitAsync_TypeDef init = USART_INITASYNC_DEFAULT;
+
+  CMU_ClockEnable(cmuClock_GPIO, true);
+  CMU_ClockEnable(cmuClock_USART0, true);
+
+  GPIO_PinModeSet(BSP_BCC_TXPORT, BSP_BCC_TXPIN, gpioModePushPull, 1);
+  GPIO_PinModeSet(BSP_BCC_RXPORT, BSP_BCC_RXPIN, gpioModeInput, 0);
+
+  // Enable the VCOM connection to the board controller
+  GPIO_PinModeSet(BSP_BCC_ENABLE_PORT, BSP_BCC_ENABLE_PIN, gpioModePushPull, 1);
+
+  GPIO->USARTROUTE[0].TXROUTE = (BSP_BCC_TXPORT << _GPIO_USART_TXROUTE_PORT_SHIFT)
+            | (BSP_BCC_TXPIN << _GPIO_USART_TXROUTE_PIN_SHIFT);
+  GPIO->USARTROUTE[0].RXROUTE = (BSP_BCC_RXPORT << _GPIO_USART_RXROUTE_PORT_SHIFT)
+            | (BSP_BCC_RXPIN << _GPIO_USART_RXROUTE_PIN_SHIFT);
+  GPIO->USARTROUTE[0].ROUTEEN = GPIO_USART_ROUTEEN_RXPEN | GPIO_USART_ROUTEEN_TXPEN;
+
+  USART_InitAsync(USART0, &init);
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Main function
+ *****************************************************************************/
+int main(void)
+{
+  LDMA_Init_t ldmaInit = LDMA_INIT_DEFAULT;
+  const LDMAIOV_Init_t txInit = {
+    .channel = TX_LDMA_CHANNEL,
+    .signal = ldmaPeripheralSignal_USART0_TXBL,
+    .periAddr = &USART0->TXDATA,
+  };
+  const LDMAIOV_Init_t memInit = {
+    .channel = MEM_LDMA_CHANNEL,
+  };
+  LDMAIOV_Vec_t iov[NUM_VECS] = {
+    { header, HEADER_LEN },
+    { payload, 0 },
+    { trailer, TRAILER_LEN },
+  };
+  uint32_t seq = 0;
+
+  CHIP_Init();
+
+  initUsart();
+  LPDELAY_Init(true);
+
+  CMU_ClockEnable(cmuClock_LDMA, true);
+  LDMA_Init(&ldmaInit);
+  LDMAIOV_Init(&txChannel, &txInit);
+  LDMAIOV_Init(&memChannel, &memInit);
+
+  while (1) {
+    iov[1].len = buildPacket(seq++);
+
+    checkMemory(iov, iov[1].len);
+
+    // Send the three buffers as one packet, straight from where they are
+    txDone = false;
+    if (LDMAIOV_Send(&txChannel, iov, NUM_VECS, iovDone, (void *)&txDone)) {
+      waitFor(&txDone);
+      packetsSent++;
+    } else {
+      startErrors++;
+    }
+
+    // The last bytes are still in the transmitter, let them out before EM2
+    while (!(USART0->STATUS & USART_STATUS_TXC)) {
+    }
+    LPDELAY_Ms(PACKET_PERIOD_MS);
+  }
+}
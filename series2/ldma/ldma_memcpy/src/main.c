@@ -0,0 +1,274 @@
+/***************************************************************************//**
+ * @file main.c
+ * @brief Compares CPU and LDMA memcpy() and memset() over a range of sizes
+ * with the ldmamem driver. See readme.txt for details.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2021 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ *******************************************************************************
+ * # Evaluation Quality
+ * This code has been minimally tested to ensure that it builds and is suitable 
+ * as a demonstration for evaluation purposes only. This code will be maintained
+ * at the sole discretion of Silicon Labs.
+ ******************************************************************************/
+
+#include <string.h>
+#include "em_device.h"
+#include "em_chip.h"
+#include "em_cmu.h"
+#include "em_ldma.h"
+#include "ldmamem.h"
+
+/*******************************************************************************
+ *******************************   DEFINES   ***********************************
+ ******************************************************************************/
+
+// Core clock, the highest without a flash wait state
+#define CORE_FREQ                 cmuHFRCODPLLFreq_39M0Hz
+
+// Largest move measured, and the buffer size
+#define MAX_SIZE                  4096
+
+// Moves timed per result, the fastest is kept
+#define RUN_MOVES                 16
+
+// Moves measured, for each destination offset
+#define NUM_SIZES                 7
+#define NUM_OFFSETS               3
+
+/*******************************************************************************
+ ***************************   GLOBAL VARIABLES   *******************************
+ ******************************************************************************/
+
+// Cycles of one move by the CPU and by the LDMA
+typedef struct {
+  uint32_t size;            // Bytes moved
+  uint32_t offset;          // Destination offset from the source alignment
+  uint32_t cpuCycles;       // memcpy()
+  uint32_t ldmaCycles;      // LDMAMEM_Memcpy() with the threshold at 0
+  bool ok;                  // Both copies match the source
+} MemcpyResult_t;
+
+static const uint32_t sizes[NUM_SIZES] = { 16, 32, 64, 128, 256, 1024, 4096 };
+
+// Offset 0 moves words, 2 half words and 1 bytes
+static const uint32_t offsets[NUM_OFFSETS] = { 0, 2, 1 };
+
+static volatile MemcpyResult_t results[NUM_OFFSETS * NUM_SIZES];
+
+// Shortest size the LDMA is faster at, for each offset, 0 if none
+static volatile uint32_t crossover[NUM_OFFSETS];
+
+// LDMAMEM_Memset() result matches memset()
+static volatile bool memsetOk;
+
+// Loops of other work while an asynchronous copy of MAX_SIZE ran
+static volatile uint32_t asyncWork;
+static volatile uint32_t asyncDone;
+static volatile bool asyncOk;
+
+// Passes completed over all measurements
+static volatile uint32_t passes;
+
+static uint32_t srcBuffer[(MAX_SIZE / 4) + 1];
+static uint32_t dstBuffer[(MAX_SIZE / 4) + 1];
+static uint32_t workBuffer[64];
+
+/**************************************************************************//**
+ * @brief
+ *    LDMA interrupt handler, shared with the other LDMA users
+ *****************************************************************************/
+void LDMA_IRQHandler(void)
+{
+  LDMAMEM_IRQHandler();
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Called by LDMAMEM_IRQHandler() at the end of the asynchronous copy
+ *****************************************************************************/
+static void asyncCallback(void *user)
+{
+  (void)user;
+  asyncDone++;
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Time a copy, the fastest of RUN_MOVES
+ *
+ * @param[in] ldma
+ *    Copy with LDMAMEM_Memcpy(), else with memcpy()
+ *
+ * @param[out] ok
+ *    Cleared if the copy does not match the source
+ *****************************************************************************/
+static uint32_t timeCopy(bool ldma, uint8_t *dst, const uint8_t *src,
+                         uint32_t size, bool *ok)
+{
+  uint32_t start, cycles, i;
+  uint32_t min = 0xFFFFFFFF;
+
+  for (i = 0; i < RUN_MOVES; i++) {
+    memset(dst, 0, size);
+    start = DWT->CYCCNT;
+    if (ldma) {
+      LDMAMEM_Memcpy(dst, src, size);
+    } else {
+      memcpy(dst, src, size);
+    }
+    cycles = DWT->CYCCNT - start;
+    if (cycles < min) {
+      min = cycles;
+    }
+    if (memcmp(dst, src, size) != 0) {
+      *ok = false;
+    }
+  }
+
+  return min;
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Compare the CPU and the LDMA for all sizes and offsets
+ *****************************************************************************/
+static void measureCopies(void)
+{
+  const uint8_t *src = (const uint8_t *)srcBuffer;
+  uint8_t *dst;
+  volatile MemcpyResult_t *r;
+  uint32_t o, s;
+  bool ok;
+
+  LDMAMEM_SetThreshold(0);
+
+  for (o = 0; o < NUM_OFFSETS; o++) {
+    dst = (uint8_t *)dstBuffer + offsets[o];
+    crossover[o] = 0;
+
+    for (s = 0; s < NUM_SIZES; s++) {
+      r = &results[(o * NUM_SIZES) + s];
+      ok = true;
+      r->size = sizes[s];
+      r->offset = offsets[o];
+      r->cpuCycles = timeCopy(false, dst, src, sizes[s], &ok);
+      r->ldmaCycles = timeCopy(true, dst, src, sizes[s], &ok);
+      r->ok = ok;
+
+      if ((crossover[o] == 0) && (r->ldmaCycles < r->cpuCycles)) {
+        crossover[o] = sizes[s];
+      }
+    }
+  }
+
+  // Word moves are the common case, use their crossover from now on
+  LDMAMEM_SetThreshold(crossover[0] ? crossover[0] : LDMAMEM_THRESHOLD);
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Fill an unaligned block with the LDMA and check it
+ *****************************************************************************/
+static void checkMemset(void)
+{
+  uint8_t *dst = (uint8_t *)dstBuffer + 1;
+  uint32_t i;
+
+  memset(dstBuffer, 0, sizeof(dstBuffer));
+  LDMAMEM_Memset(dst, 0x5A, MAX_SIZE - 2);
+
+  memsetOk = (((uint8_t *)dstBuffer)[0] == 0)
+             && (dst[MAX_SIZE - 2] == 0);
+  for (i = 0; i < MAX_SIZE - 2; i++) {
+    if (dst[i] != 0x5A) {
+      memsetOk = false;
+    }
+  }
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Copy MAX_SIZE bytes in the background and keep the CPU busy meanwhile
+ *****************************************************************************/
+static void checkAsync(void)
+{
+  uint32_t done = asyncDone;
+  uint32_t i, sum = 0;
+
+  memset(dstBuffer, 0, sizeof(dstBuffer));
+  asyncWork = 0;
+
+  if (!LDMAMEM_MemcpyAsync(dstBuffer, srcBuffer, MAX_SIZE,
+                           asyncCallback, NULL)) {
+    asyncOk = false;
+    return;
+  }
+
+  // Work on other data in the meantime
+  while (asyncDone == done) {
+    for (i = 0; i < 64; i++) {
+      sum += workBuffer[i];
+    }
+    workBuffer[asyncWork & 63] = sum;
+    asyncWork++;
+  }
+
+  asyncOk = (memcmp(dstBuffer, srcBuffer, MAX_SIZE) == 0);
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Main function
+ *****************************************************************************/
+int main(void)
+{
+  LDMA_Init_t init = LDMA_INIT_DEFAULT;
+  uint32_t i;
+
+  CHIP_Init();
+
+  CMU_HFRCODPLLBandSet(CORE_FREQ);
+
+  // Start the cycle counter
+  CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+  DWT->CYCCNT = 0;
+  DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+  CMU_ClockEnable(cmuClock_LDMA, true);
+  LDMA_Init(&init);
+
+  for (i = 0; i < sizeof(srcBuffer); i++) {
+    ((uint8_t *)srcBuffer)[i] = (uint8_t)((i * 7) + 3);
+  }
+
+  // Measure and check everything, over and over
+  while (1) {
+    measureCopies();
+    checkMemset();
+    checkAsync();
+    passes++;
+  }
+}
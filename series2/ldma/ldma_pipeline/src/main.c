@@ -0,0 +1,329 @@
+/***************************************************************************//**
+ * @file main.c
+ * @brief Streams IADC results to the VCOM and the GPCRC through a four
+ * stage LDMA pipeline with the ldmapipe driver. See readme.txt for details.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2021 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ *******************************************************************************
+ * # Evaluation Quality
+ * This code has been minimally tested to ensure that it builds and is suitable 
+ * as a demonstration for evaluation purposes only. This code will be maintained
+ * at the sole discretion of Silicon Labs.
+ ******************************************************************************/
+
+#include "em_device.h"
+#include "em_chip.h"
+#include "em_cmu.h"
+#include "em_emu.h"
+#include "em_gpcrc.h"
+#include "em_gpio.h"
+#include "em_iadc.h"
+#include "em_ldma.h"
+#include "em_usart.h"
+#include "bsp.h"
+#include "crc32.h"
+#include "ldmapipe.h"
+
+/*******************************************************************************
+ *******************************   DEFINES   ***********************************
+ ******************************************************************************/
+
+// Channels of the four stages
+#define IADC_LDMA_CHANNEL   0
+#define TX_LDMA_CHANNEL     1
+#define TAP_LDMA_CHANNEL    2
+#define CRC_LDMA_CHANNEL    3
+
+// IADC conversions per second, started by the IADC local timer. The VCOM
+// moves about 11500 bytes per second, 2800 results; above that the
+// transmitter holds the pipeline back and the IADC FIFO overflows.
+#define SAMPLE_RATE         1000
+
+// Set CLK_ADC to 10 MHz, CLK_SRC_ADC from the FSRCO
+#define CLK_SRC_ADC_FREQ    20000000
+#define CLK_ADC_FREQ        10000000
+
+// The IADC measures PA05, Expansion Header Pin 12
+#define IADC_INPUT_PORT_PIN iadcPosInputPortAPin5
+#define IADC_INPUT_BUS      ABUSALLOC
+#define IADC_INPUT_BUSALLOC GPIO_ABUSALLOC_AODD0_ADC0
+
+// Results per block, two slots
+#define SLOT_SAMPLES        32
+#define NUM_SLOTS           2
+
+/*******************************************************************************
+ ***************************   GLOBAL VARIABLES   *******************************
+ ******************************************************************************/
+
+static LDMAPIPE_Pipe_t pipe;
+
+// Slots handed down the pipeline, and the tap stage's copy of the last block
+static uint32_t slotBuffer[NUM_SLOTS][SLOT_SAMPLES];
+static uint32_t tap[SLOT_SAMPLES];
+
+// Blocks through all four stages, and blocks the GPCRC, which saw every
+// result, does not agree on with the CRC-32 of the tapped copies
+static volatile uint32_t blocks;
+static volatile uint32_t crcErrors;
+
+// Running CRC-32, from the GPCRC and worked out again from the tap
+static volatile uint32_t gpcrcValue;
+static uint32_t tapCrc = CRC32_PRESET;
+
+// Mean and span of the last block, in IADC codes
+static volatile uint32_t blockMean;
+static volatile uint32_t blockSpan;
+
+// Results lost to IADC FIFO overflows, with the pipeline held back
+static volatile uint32_t fifoOverflows;
+
+// Pipeline refused to start
+static volatile bool startError;
+
+/**************************************************************************//**
+ * @brief
+ *    LDMA interrupt handler, shared with the other LDMA users
+ *****************************************************************************/
+void LDMA_IRQHandler(void)
+{
+  LDMAPIPE_IRQHandler(&pipe);
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Called by LDMAPIPE_IRQHandler() after the GPCRC stage took a block
+ *
+ * @details
+ *    The tap and the GPCRC are next written by the LDMA once the IADC has
+ *    filled the next slot, SLOT_SAMPLES results later.
+ *****************************************************************************/
+static void blockDone(LDMAPIPE_Pipe_t *p, uint32_t count, void *user)
+{
+  uint32_t min = UINT32_MAX, max = 0, sum = 0;
+  unsigned int i;
+
+  (void)p;
+  (void)user;
+
+  for (i = 0; i < SLOT_SAMPLES; i++) {
+    sum += tap[i];
+    if (tap[i] < min) {
+      min = tap[i];
+    }
+    if (tap[i] > max) {
+      max = tap[i];
+    }
+  }
+  blockMean = sum / SLOT_SAMPLES;
+  blockSpan = max - min;
+
+  tapCrc = CRC32_Bitwise(tapCrc, tap, sizeof(tap));
+  gpcrcValue = GPCRC_DataReadBitReversed(GPCRC);
+  if (gpcrcValue != tapCrc) {
+    crcErrors++;
+    // Carry on from the GPCRC, so one bad block is counted once
+    tapCrc = gpcrcValue;
+  }
+
+  if (IADC_getInt(IADC0) & IADC_IF_SINGLEFIFOOF) {
+    IADC_clearInt(IADC0, IADC_IF_SINGLEFIFOOF);
+    fifoOverflows++;
+  }
+
+  blocks = count;
+}
+
+/**************************************************************************//**
+ * @brief
+ *    USART0 to the board controller, as the async_polled example
+ *****************************************************************************/
+static void initUsart(void)
+{
+  USART_InitAsync_TypeDef init = USART_INITASYNC_DEFAULT;
+
+  CMU_ClockEnable(cmuClock_GPIO, true);
+  CMU_ClockEnable(cmuClock_USART0, true);
+
+  GPIO_PinModeSet(BSP_BCC_TXPORT, BSP_BCC_TXPIN, gpioModePushPull, 1);
+  GPIO_PinModeSet(BSP_BCC_RXPORT, BSP_BCC_RXPIN, gpioModeInput, 0);
+
+  // Enable the VCOM connection to the board controller
+  GPIO_PinModeSet(BSP_BCC_ENABLE_PORT, BSP_BCC_ENABLE_PIN, gpioModePushPull, 1);
+
+  GPIO->USARTROUTE[0].TXROUTE = (BSP_BCC_TXPORT << _GPIO_USART_TXROUTE_PORT_SHIFT)
+            | (BSP_BCC_TXPIN << _GPIO_USART_TXROUTE_PIN_SHIFT);
+  GPIO->USARTROUTE[0].RXROUTE = (BSP_BCC_RXPORT << _GPIO_USART_RXROUTE_PORT_SHIFT)
+            | (BSP_BCC_RXPIN << _GPIO_USART_RXROUTE_PIN_SHIFT);
+  GPIO->USARTROUTE[0].ROUTEEN = GPIO_USART_ROUTEEN_RXPEN | GPIO_USART_ROUTEEN_TXPEN;
+
+  USART_InitAsync(USART0, &init);
+}
+
+/**************************************************************************//**
+ * @brief
+ *    GPCRC as in the gpcrc_software example, one CRC-32 over the stream
+ *****************************************************************************/
+static void initGpcrc(void)
+{
+  GPCRC_Init_TypeDef init = GPCRC_INIT_DEFAULT;
+
+  CMU_ClockEnable(cmuClock_GPCRC, true);
+
+  init.initValue = CRC32_PRESET;
+  init.autoInit = false;      // Keep GPCRC_DATA when it is read
+  init.reverseBits = true;    // Same result as the crc32 component
+
+  GPCRC_Init(GPCRC, &init);
+  GPCRC_Start(GPCRC);
+}
+
+/**************************************************************************//**
+ * @brief
+ *    IADC single conversions started by the IADC local timer, each result
+ *    a request of the IADC stage
+ *****************************************************************************/
+static void initIadc(void)
+{
+  IADC_Init_t init = IADC_INIT_DEFAULT;
+  IADC_AllConfigs_t initAllConfigs = IADC_ALLCONFIGS_DEFAULT;
+  IADC_InitSingle_t initSingle = IADC_INITSINGLE_DEFAULT;
+  IADC_SingleInput_t initSingleInput = IADC_SINGLEINPUT_DEFAULT;
+
+  CMU_ClockEnable(cmuClock_IADC0, true);
+  CMU_ClockSelectSet(cmuClock_IADCCLK, cmuSelect_FSRCO);
+
+  init.warmup = iadcWarmupNormal;
+  init.srcClkPrescale = IADC_calcSrcClkPrescale(IADC0, CLK_SRC_ADC_FREQ, 0);
+
+  // The IADC local timer counts CLK_SRC_ADC cycles
+  init.timerCycles = CMU_ClockFreqGet(cmuClock_IADCCLK) / SAMPLE_RATE;
+
+  initAllConfigs.configs[0].reference = iadcCfgReferenceInt1V2;
+  initAllConfigs.configs[0].vRef = 1210;
+  initAllConfigs.configs[0].osrHighSpeed = iadcCfgOsrHighSpeed2x;
+  initAllConfigs.configs[0].analogGain = iadcCfgAnalogGain0P5x;
+  initAllConfigs.configs[0].adcClkPrescale = IADC_calcAdcClkPrescale(IADC0,
+                                                                     CLK_ADC_FREQ,
+                                                                     0,
+                                                                     iadcCfgModeNormal,
+                                                                     init.srcClkPrescale);
+
+  // A request for each result
+  initSingle.triggerSelect = iadcTriggerSelTimer;
+  initSingle.dataValidLevel = iadcFifoCfgDvl1;
+  initSingle.fifoDmaWakeup = true;
+
+  initSingleInput.posInput = IADC_INPUT_PORT_PIN;
+  initSingleInput.negInput = iadcNegInputGnd;
+
+  IADC_init(IADC0, &init, &initAllConfigs);
+  IADC_initSingle(IADC0, &initSingle, &initSingleInput);
+
+  GPIO->IADC_INPUT_BUS |= IADC_INPUT_BUSALLOC;
+  IADC_clearInt(IADC0, _IADC_IF_MASK);
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Build the pipeline IADC -> slot -> VCOM -> tap -> GPCRC
+ *****************************************************************************/
+static bool initPipeline(void)
+{
+  void * const slots[NUM_SLOTS] = { slotBuffer[0], slotBuffer[1] };
+  const LDMAPIPE_Stage_t stages[] = {
+    {
+      .channel = IADC_LDMA_CHANNEL,
+      .dir = ldmaPipeFromPeri,
+      .signal = ldmaPeripheralSignal_IADC0_IADC_SINGLE,
+      .addr = &IADC0->SINGLEFIFODATA,
+      .size = ldmaCtrlSizeWord,
+    },
+    {
+      .channel = TX_LDMA_CHANNEL,
+      .dir = ldmaPipeToPeri,
+      .signal = ldmaPeripheralSignal_USART0_TXBL,
+      .addr = &USART0->TXDATA,
+      .size = ldmaCtrlSizeByte,
+    },
+    {
+      .channel = TAP_LDMA_CHANNEL,
+      .dir = ldmaPipeToMem,
+      .signal = ldmaPeripheralSignal_NONE,
+      .addr = tap,
+      .size = ldmaCtrlSizeWord,
+    },
+    {
+      .channel = CRC_LDMA_CHANNEL,
+      .dir = ldmaPipeToPeri,
+      .signal = ldmaPeripheralSignal_NONE,
+      .addr = &GPCRC->INPUTDATA,
+      .size = ldmaCtrlSizeWord,
+    },
+  };
+  unsigned int i;
+
+  if (!LDMAPIPE_Init(&pipe, slots, NUM_SLOTS, sizeof(slotBuffer[0]), 0)) {
+    return false;
+  }
+  for (i = 0; i < sizeof(stages) / sizeof(stages[0]); i++) {
+    if (!LDMAPIPE_AddStage(&pipe, &stages[i])) {
+      return false;
+    }
+  }
+  return LDMAPIPE_Start(&pipe, blockDone, NULL);
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Main function
+ *****************************************************************************/
+int main(void)
+{
+  LDMA_Init_t ldmaInit = LDMA_INIT_DEFAULT;
+
+  CHIP_Init();
+
+  initUsart();
+  initGpcrc();
+  initIadc();
+
+  CMU_ClockEnable(cmuClock_LDMA, true);
+  LDMA_Init(&ldmaInit);
+
+  // The stages wait on their SYNC bits, the timer lets the first result in
+  if (initPipeline()) {
+    IADC_command(IADC0, iadcCmdStartSingle);
+    IADC_command(IADC0, iadcCmdEnableTimer);
+  } else {
+    startError = true;
+  }
+
+  // The LDMA runs the stages, the core only wakes up once a block
+  while (1) {
+    EMU_EnterEM1();
+  }
+}
@@ -0,0 +1,311 @@
+/***************************************************************************//**
+ * @file main.c
+ * @brief Polls GPIO, PCNT and ACMP registers into a timestamped RAM table
+ * every millisecond with the ldmapoll driver. See readme.txt for details.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2021 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ *******************************************************************************
+ * # Evaluation Quality
+ * This code has been minimally tested to ensure that it builds and is suitable 
+ * as a demonstration for evaluation purposes only. This code will be maintained
+ * at the sole discretion of Silicon Labs.
+ ******************************************************************************/
+
+
+#include "em_device.h"
+#include "em_chip.h"
+#include "em_cmu.h"
+#include "em_emu.h"
+#include "em_gpio.h"
+#include "em_acmp.h"
+#include "em_ldma.h"
+#include "em_pcnt.h"
+#include "em_prs.h"
+#include "em_timer.h"
+#include "bsp.h"
+#include "ldmapoll.h"
+
+/*******************************************************************************
+ *******************************   DEFINES   ***********************************
+ ******************************************************************************/
+
+// Channel of the poller
+#define POLL_LDMA_CHANNEL   0
+
+// Rows a second, each one on an overflow of TIMER1
+#define POLL_RATE_HZ        1000
+
+// Two batches of 100 rows, the CPU wakes up every 100 ms
+#define BATCH_ROWS          100
+#define NUM_BATCHES         2
+
+// PRS channel from PB1 to the PCNT
+#define PCNT_PRS_CH         0
+
+/*******************************************************************************
+ ***************************   GLOBAL VARIABLES   *******************************
+ ******************************************************************************/
+
+// One row of the table, the registers in the order of pollRegs
+typedef struct {
+  uint32_t stamp;                       // TIMER0 count
+  uint32_t pins;                        // GPIO port B input
+  uint32_t count;                       // PCNT0 count of PB1 presses
+  uint32_t acmp;                        // ACMP0 status, PB0 against 1.25 V
+} Snapshot_t;
+
+#define NUM_REGS            (sizeof(Snapshot_t) / sizeof(uint32_t))
+
+static const volatile uint32_t * const pollRegs[NUM_REGS] = {
+  &TIMER0->CNT,
+  &GPIO->P[gpioPortB].DIN,
+  &PCNT0->CNT,
+  &ACMP0->STATUS,
+};
+
+static LDMAPOLL_Poller_t poller;
+static Snapshot_t table[NUM_BATCHES * BATCH_ROWS];
+
+// Last row of the previous batch, the first row of a batch is compared to it
+static Snapshot_t last;
+static bool haveLast;
+
+// Ticks of TIMER0 between two rows
+static uint32_t expectedPeriod;
+
+// PCNT0 count before the first press
+static uint32_t countBase;
+
+// Results, over all batches
+static volatile uint32_t batchesDone;   // CPU wake-ups to process a batch
+static volatile uint32_t pb0Presses;    // PB0 falls seen in GPIO DIN
+static volatile uint32_t acmpFalls;     // PB0 falls seen by ACMP0
+static volatile uint32_t pb1Presses;    // PB1 falls seen in GPIO DIN
+static volatile uint32_t pb1Count;      // PB1 presses counted by PCNT0
+static volatile uint32_t minPeriod;     // Shortest time between rows, ticks
+static volatile uint32_t maxPeriod;     // Longest time between rows, ticks
+static volatile uint32_t missedRows;    // Gaps of more than 1.5 periods
+
+/**************************************************************************//**
+ * @brief
+ *    LDMA interrupt handler, shared with the other LDMA users
+ *****************************************************************************/
+void LDMA_IRQHandler(void)
+{
+  LDMAPOLL_IRQHandler(&poller);
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Count a fall of the bits in mask from one row to the next
+ *****************************************************************************/
+static uint32_t falls(uint32_t before, uint32_t after, uint32_t mask)
+{
+  return ((before & mask) && !(after & mask)) ? 1 : 0;
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Called by LDMAPOLL_IRQHandler() with a full batch, while the LDMA
+ *    fills the other one
+ *****************************************************************************/
+static void batchDone(LDMAPOLL_Poller_t *p, const uint32_t *rows,
+                      unsigned int count, void *user)
+{
+  const Snapshot_t *row = (const Snapshot_t *)rows;
+  const Snapshot_t *prev;
+  uint32_t period;
+  unsigned int i;
+
+  (void)p;
+  (void)user;
+
+  for (i = 0; i < count; i++) {
+    if (i > 0) {
+      prev = &row[i - 1];
+    } else if (haveLast) {
+      prev = &last;
+    } else {
+      continue;
+    }
+
+    // The timer count the LDMA read first thing on each request
+    period = row[i].stamp - prev->stamp;
+    if (period < minPeriod) {
+      minPeriod = period;
+    }
+    if (period > maxPeriod) {
+      maxPeriod = period;
+    }
+    if (period > expectedPeriod + (expectedPeriod / 2)) {
+      missedRows++;
+    }
+
+    // The buttons are active low
+    pb0Presses += falls(prev->pins, row[i].pins, 1 << BSP_GPIO_PB0_PIN);
+    pb1Presses += falls(prev->pins, row[i].pins, 1 << BSP_GPIO_PB1_PIN);
+    acmpFalls  += falls(prev->acmp, row[i].acmp, ACMP_STATUS_ACMPOUT);
+  }
+
+  last = row[count - 1];
+  haveLast = true;
+  pb1Count = (last.count - countBase) & _PCNT_CNT_MASK;
+  batchesDone++;
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Push buttons, PB0 also read by ACMP0 and PB1 counted by PCNT0
+ *****************************************************************************/
+static void initGpio(void)
+{
+  CMU_ClockEnable(cmuClock_GPIO, true);
+
+  // The buttons have pull-ups on the board
+  GPIO_PinModeSet(BSP_GPIO_PB0_PORT, BSP_GPIO_PB0_PIN, gpioModeInput, 1);
+  GPIO_PinModeSet(BSP_GPIO_PB1_PORT, BSP_GPIO_PB1_PIN, gpioModeInput, 1);
+
+  // PB1 to the PRS, no interrupt
+  GPIO_ExtIntConfig(BSP_GPIO_PB1_PORT, BSP_GPIO_PB1_PIN, BSP_GPIO_PB1_PIN,
+                    false, false, false);
+}
+
+/**************************************************************************//**
+ * @brief
+ *    ACMP0 compares PB0 to 1.25 V, as in the acmp_polled example
+ *****************************************************************************/
+static void initAcmp(void)
+{
+  ACMP_Init_TypeDef init = ACMP_INIT_DEFAULT;
+
+  CMU_ClockEnable(cmuClock_ACMP0, true);
+  ACMP_Init(ACMP0, &init);
+
+  // PB0 is on PB01, an odd pin of port B
+  GPIO->BBUSALLOC = GPIO_BBUSALLOC_BODD0_ACMP0;
+  ACMP_ChannelSet(ACMP0, acmpInputVREFDIV1V25, acmpInputPB1);
+
+  while (!(ACMP0->IF & ACMP_IF_ACMPRDY)) {
+  }
+}
+
+/**************************************************************************//**
+ * @brief
+ *    PCNT0 counts PB1 presses from the PRS, as in pcnt_extclk_single_overflow
+ *****************************************************************************/
+static void initPcnt(void)
+{
+  PCNT_Init_TypeDef init = PCNT_INIT_DEFAULT;
+
+  CMU_ClockEnable(cmuClock_PRS, true);
+  CMU_ClockEnable(cmuClock_PCNT0, true);
+
+  PRS_SourceAsyncSignalSet(PCNT_PRS_CH, PRS_ASYNC_CH_CTRL_SOURCESEL_GPIO,
+                           BSP_GPIO_PB1_PIN);
+
+  init.mode  = pcntModeDisable;
+  init.s0PRS = PCNT_PRS_CH;
+  PCNT_PRSInputEnable(PCNT0, pcntPRSInputS0, true);
+  PCNT_Init(PCNT0, &init);
+  PCNT_Enable(PCNT0, pcntModeExtSingle);
+  CMU->PCNT0CLKCTRL = CMU_PCNT0CLKCTRL_CLKSEL_PCNTS0;
+
+  // A few pulses on the external clock synchronize its domain, they are
+  // counted too
+  while (PCNT0->SYNCBUSY) {
+    PRS_PulseTrigger(1 << PCNT_PRS_CH);
+  }
+  countBase = PCNT_CounterGet(PCNT0);
+}
+
+/**************************************************************************//**
+ * @brief
+ *    TIMER0 counts freely for the time stamps, TIMER1 requests the rows
+ *****************************************************************************/
+static void initTimers(void)
+{
+  TIMER_Init_TypeDef init = TIMER_INIT_DEFAULT;
+  uint32_t freq;
+
+  CMU_ClockEnable(cmuClock_TIMER0, true);
+  CMU_ClockEnable(cmuClock_TIMER1, true);
+
+  // 32-bit count at the full timer clock
+  init.prescale = timerPrescale1;
+  TIMER_Init(TIMER0, &init);
+
+  // The LDMA clears the overflow request as it serves it
+  init.enable = false;
+  init.dmaClrAct = true;
+  TIMER_Init(TIMER1, &init);
+
+  freq = CMU_ClockFreqGet(cmuClock_TIMER1);
+  TIMER_TopSet(TIMER1, (freq / POLL_RATE_HZ) - 1);
+  expectedPeriod = CMU_ClockFreqGet(cmuClock_TIMER0) / POLL_RATE_HZ;
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Main function
+ *****************************************************************************/
+int main(void)
+{
+  LDMA_Init_t ldmaInit = LDMA_INIT_DEFAULT;
+  const LDMAPOLL_Init_t pollInit = {
+    .channel = POLL_LDMA_CHANNEL,
+    .signal = ldmaPeripheralSignal_TIMER1_UFOF,
+    .regs = pollRegs,
+    .regCount = NUM_REGS,
+    .table = (uint32_t *)table,
+    .batchRows = BATCH_ROWS,
+    .batches = NUM_BATCHES,
+    .callback = batchDone,
+    .user = NULL,
+  };
+
+  CHIP_Init();
+
+  initGpio();
+  initAcmp();
+  initPcnt();
+  initTimers();
+
+  minPeriod = UINT32_MAX;
+  maxPeriod = 0;
+
+  CMU_ClockEnable(cmuClock_LDMA, true);
+  LDMA_Init(&ldmaInit);
+  LDMAPOLL_Init(&poller, &pollInit);
+  LDMAPOLL_Start(&poller);
+
+  // The rows start with the first overflow
+  TIMER_Enable(TIMER1, true);
+
+  // The timers stop in EM2, the LDMA reads the registers in EM1
+  while (1) {
+    EMU_EnterEM1();
+  }
+}
@@ -0,0 +1,90 @@
+/***************************************************************************//**
+ * @file lesdec.h
+ * @brief Table driven LESENSE decoder configuration.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2021 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ******************************************************************************/
+
+#ifndef LESDEC_H
+#define LESDEC_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "em_lesense.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Decoder states and sensor inputs. Input bit n is the result of the n-th
+// decoder input channel, shifted into the decoder with shiftRes.
+#define LDEC_MAX_STATES       16
+#define LDEC_MAX_INPUTS       4
+
+// Compare every input of the machine
+#define LDEC_ALL_INPUTS       ((1 << LDEC_MAX_INPUTS) - 1)
+
+// One arc of the state machine: in state "from", when the compared inputs
+// equal "input", go to state "to", do "action" and optionally interrupt.
+typedef struct {
+  uint8_t from;
+  uint8_t input;                       // Sensor pattern, bit per input
+  uint8_t care;                        // Inputs compared, others ignored
+  uint8_t to;
+  LESENSE_StTransAct_TypeDef action;   // PRS output or count on the arc
+  bool interrupt;                      // Set the DEC interrupt flag
+} LDEC_Arc_t;
+
+// A state machine. Inputs without an arc leave the state unchanged, so
+// only the arcs that change state or have an action need to be listed.
+typedef struct {
+  uint8_t inputs;                      // Sensor inputs used, 1 to 4
+  uint8_t initialState;
+  const LDEC_Arc_t *arcs;
+  uint32_t arcCount;
+} LDEC_Machine_t;
+
+typedef enum {
+  ldecOk,
+  ldecErrInputs,                       // inputs out of range
+  ldecErrTooManyArcs,                  // More arcs than the decoder has
+  ldecErrState,                        // State number out of range
+  ldecErrInput,                        // input outside the compared inputs
+  ldecErrAmbiguous,                    // Two arcs leave a state on the
+                                       // same input
+} LDEC_Status_t;
+
+LDEC_Status_t LDEC_Compile(const LDEC_Machine_t *machine,
+                           LESENSE_DecStAll_TypeDef *states,
+                           uint32_t *badArc);
+LDEC_Status_t LDEC_Load(const LDEC_Machine_t *machine, uint32_t *badArc);
+uint32_t LDEC_MaxArcs(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // LESDEC_H
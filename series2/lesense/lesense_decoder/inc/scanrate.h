@@ -0,0 +1,58 @@
+/***************************************************************************//**
+ * @file scanrate.h
+ * @brief Adaptive LESENSE scan rate, fast on activity and decaying to idle.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2021 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ******************************************************************************/
+
+#ifndef SCANRATE_H
+#define SCANRATE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+  uint32_t idleRate;        // Scans per second with no activity
+  uint32_t activeRate;      // Scans per second right after activity
+  uint32_t holdTime;        // ms at each rate before halving it
+  uint32_t activityFlags;   // LESENSE interrupt flags that count as activity
+} SRATE_Config_t;
+
+bool SRATE_Init(const SRATE_Config_t *config);
+void SRATE_Update(uint32_t flags);
+void SRATE_Activity(void);
+uint32_t SRATE_GetRate(void);
+uint32_t SRATE_GetChangeCount(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SCANRATE_H
@@ -0,0 +1,211 @@
+/***************************************************************************//**
+ * @file lesdec.c
+ * @brief Table driven LESENSE decoder configuration.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2021 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ *******************************************************************************
+ * # Evaluation Quality
+ * This code has been minimally tested to ensure that it builds and is suitable
+ * as a demonstration for evaluation purposes only. This code will be maintained
+ * at the sole discretion of Silicon Labs.
+ ******************************************************************************/
+
+#include <stddef.h>
+
+#include "em_device.h"
+#include "em_lesense.h"
+
+#include "lesdec.h"
+
+// Arcs in the decoder, the length of the configuration table
+#define MAX_ARCS            (sizeof(((LESENSE_DecStAll_TypeDef *)0)->St) \
+                             / sizeof(((LESENSE_DecStAll_TypeDef *)0)->St[0]))
+
+/**************************************************************************//**
+ * @brief
+ *   Check that no two arcs leave the same state on the same input
+ *
+ * @details
+ *   Two arcs conflict when they start in the same state and every input
+ *   compared by both has the same value in both. The decoder would then
+ *   act on whichever it evaluates first, so the table would not mean what
+ *   it says.
+ *****************************************************************************/
+static bool findConflict(const LDEC_Machine_t *machine,
+                         uint32_t arc,
+                         uint8_t used)
+{
+  const LDEC_Arc_t *a = &machine->arcs[arc];
+  const LDEC_Arc_t *b;
+  uint8_t both;
+
+  for (uint32_t i = 0; i < arc; i++) {
+    b = &machine->arcs[i];
+    both = a->care & b->care & used;
+    if ((a->from == b->from) && ((a->input & both) == (b->input & both))) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Compile a state machine into a decoder configuration
+ *
+ * @details
+ *   Each arc becomes one decoder state condition with compMask set for
+ *   the inputs it ignores, including all inputs above machine->inputs.
+ *   The conditions left over are parked on a state the machine never
+ *   enters, or, if it uses every state, turned into self loops without
+ *   an action, so they can never change the state or signal anything.
+ *
+ * @param[in] machine
+ *   State machine to compile.
+ *
+ * @param[out] states
+ *   Decoder configuration for LESENSE_DecoderStateAllConfig().
+ *
+ * @param[out] badArc
+ *   Index of the arc that failed to compile, may be NULL.
+ *
+ * @return
+ *   ldecOk, or the reason the machine does not fit the decoder.
+ *****************************************************************************/
+LDEC_Status_t LDEC_Compile(const LDEC_Machine_t *machine,
+                           LESENSE_DecStAll_TypeDef *states,
+                           uint32_t *badArc)
+{
+  const LESENSE_DecStAll_TypeDef defaults = LESENSE_DECODER_CONF_DEFAULT;
+  uint8_t used;
+  uint32_t entered;
+  uint8_t parked = 0;
+  const LDEC_Arc_t *arc;
+  LDEC_Status_t status = ldecOk;
+  uint32_t i;
+
+  if ((machine->inputs == 0) || (machine->inputs > LDEC_MAX_INPUTS)) {
+    return ldecErrInputs;
+  }
+  if (machine->arcCount > MAX_ARCS) {
+    return ldecErrTooManyArcs;
+  }
+  if (machine->initialState >= LDEC_MAX_STATES) {
+    return ldecErrState;
+  }
+
+  used = (1 << machine->inputs) - 1;
+  entered = 1u << machine->initialState;
+  *states = defaults;
+
+  for (i = 0; i < machine->arcCount; i++) {
+    arc = &machine->arcs[i];
+
+    if ((arc->from >= LDEC_MAX_STATES) || (arc->to >= LDEC_MAX_STATES)) {
+      status = ldecErrState;
+    } else if (arc->input & ~(arc->care & used)) {
+      status = ldecErrInput;
+    } else if (findConflict(machine, i, used)) {
+      status = ldecErrAmbiguous;
+    }
+    if (status != ldecOk) {
+      if (badArc != NULL) {
+        *badArc = i;
+      }
+      return status;
+    }
+
+    states->St[i].curState = arc->from;
+    states->St[i].nextState = arc->to;
+    states->St[i].compVal = arc->input;
+    states->St[i].compMask = (uint8_t)(LDEC_ALL_INPUTS & ~(arc->care & used));
+    states->St[i].prsAct = arc->action;
+    states->St[i].setInt = arc->interrupt;
+
+    entered |= (1u << arc->from) | (1u << arc->to);
+  }
+
+  // Highest state never entered, state 0 if they all are
+  for (i = LDEC_MAX_STATES; i > 0; i--) {
+    if (!(entered & (1u << (i - 1)))) {
+      parked = (uint8_t)(i - 1);
+      break;
+    }
+  }
+
+  for (i = machine->arcCount; i < MAX_ARCS; i++) {
+    states->St[i].curState = parked;
+    states->St[i].nextState = parked;
+    states->St[i].compVal = 0;
+    states->St[i].compMask = LDEC_ALL_INPUTS;
+    states->St[i].prsAct = lesenseTransActNone;
+    states->St[i].setInt = false;
+  }
+
+  return ldecOk;
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Compile a state machine and load it into the LESENSE decoder
+ *
+ * @details
+ *   The decoder is left in machine->initialState. Call with LESENSE
+ *   initialized and before the scan is started.
+ *
+ * @param[in] machine
+ *   State machine to load.
+ *
+ * @param[out] badArc
+ *   Index of the arc that failed to compile, may be NULL.
+ *
+ * @return
+ *   ldecOk, or the reason the machine does not fit the decoder, in which
+ *   case the decoder is left as it was.
+ *****************************************************************************/
+LDEC_Status_t LDEC_Load(const LDEC_Machine_t *machine, uint32_t *badArc)
+{
+  static LESENSE_DecStAll_TypeDef states;
+  LDEC_Status_t status;
+
+  status = LDEC_Compile(machine, &states, badArc);
+  if (status == ldecOk) {
+    LESENSE_DecoderStateAllConfig(&states);
+    LESENSE_DecoderStateSet(machine->initialState);
+  }
+
+  return status;
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Number of arcs the decoder has room for
+ *****************************************************************************/
+uint32_t LDEC_MaxArcs(void)
+{
+  return MAX_ARCS;
+}
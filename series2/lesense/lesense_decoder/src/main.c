@@ -43,6 +43,8 @@
 #include "em_emu.h"
 #include "em_gpio.h"
 #include "em_core.h"
+#include "lesdec.h"
+#include "scanrate.h"
 #include "em_lesense.h"
 #include "bspconfig.h"
 #include "bsp.h"
@@ -50,7 +52,9 @@
 
 #define PD01REGNORETAIN   0  // EM0/1 peripheral register retention
 #define EM2_DEBUG         1  // EM2 debug enable
-#define SCAN_FREQ         8  // 8 Hz
+#define SCAN_FREQ_IDLE    2  // 2 Hz with the buttons untouched
+#define SCAN_FREQ_ACTIVE  32 // 32 Hz after a decoder transition
+#define SCAN_HOLD_MS      1000 // ms at each rate before halving it
 #define STATE_LED         1  // state transition LED demo, turn off to view
                              // state transition current consumption
 #define NO_TURN           0
@@ -58,6 +62,28 @@
 #define RIGHT_TURN        2
 #define BOTH_TURN         3
 
+// Decoder state machine: TURN_MACHINE or SWIPE_MACHINE
+#define TURN_MACHINE      0
+#define SWIPE_MACHINE     1
+#define DECODER_MACHINE   TURN_MACHINE
+
+// Swipe machine states, the LED states above show the last swipe
+#define SWIPE_IDLE        NO_TURN
+#define SWIPE_LEFT        LEFT_TURN
+#define SWIPE_RIGHT       RIGHT_TURN
+#define RIGHT_PB0         4   // PB0 pressed
+#define RIGHT_BOTH        5   // then PB1 too
+#define RIGHT_PB1         6   // then PB0 released
+#define LEFT_PB1          7
+#define LEFT_BOTH         8
+#define LEFT_PB0          9
+
+// Decoder inputs: channel 0 (PB0) in bit 0, channel 1 (PB1) in bit 1
+#define IN_NONE           0x0
+#define IN_PB0            0x1
+#define IN_PB1            0x2
+#define IN_BOTH           0x3
+
 // Determine the BBUSALLOC to allocate to ACMP0
 #if (BSP_GPIO_PB0_PIN % 2 == 0 && BSP_GPIO_PB1_PIN % 2 == 0)
   #define GPIO_BBUSALLOC   GPIO_BBUSALLOC_BEVEN0_ACMP0
@@ -68,6 +94,68 @@
 #endif
 
 uint32_t decoder_state;
+uint32_t decoder_badArc;
+
+#if (DECODER_MACHINE == TURN_MACHINE)
+/*
+ * Turn detector, a Moore machine whose state is the button pattern. Every
+ * change of pattern is an arc with an interrupt; a pattern without an arc,
+ * the one the state already stands for, leaves the state as it is, so the
+ * four self loops of each state are not needed.
+ */
+static const LDEC_Arc_t decoderArcs[] = {
+  // from        input    care             to          action     interrupt
+  { NO_TURN,     IN_PB0,  LDEC_ALL_INPUTS, LEFT_TURN,  lesenseTransActNone, true },
+  { NO_TURN,     IN_PB1,  LDEC_ALL_INPUTS, RIGHT_TURN, lesenseTransActNone, true },
+  { NO_TURN,     IN_BOTH, LDEC_ALL_INPUTS, BOTH_TURN,  lesenseTransActNone, true },
+  { LEFT_TURN,   IN_NONE, LDEC_ALL_INPUTS, NO_TURN,    lesenseTransActNone, true },
+  { LEFT_TURN,   IN_PB1,  LDEC_ALL_INPUTS, RIGHT_TURN, lesenseTransActNone, true },
+  { LEFT_TURN,   IN_BOTH, LDEC_ALL_INPUTS, BOTH_TURN,  lesenseTransActNone, true },
+  { RIGHT_TURN,  IN_NONE, LDEC_ALL_INPUTS, NO_TURN,    lesenseTransActNone, true },
+  { RIGHT_TURN,  IN_PB0,  LDEC_ALL_INPUTS, LEFT_TURN,  lesenseTransActNone, true },
+  { RIGHT_TURN,  IN_BOTH, LDEC_ALL_INPUTS, BOTH_TURN,  lesenseTransActNone, true },
+  { BOTH_TURN,   IN_NONE, LDEC_ALL_INPUTS, NO_TURN,    lesenseTransActNone, true },
+  { BOTH_TURN,   IN_PB0,  LDEC_ALL_INPUTS, LEFT_TURN,  lesenseTransActNone, true },
+  { BOTH_TURN,   IN_PB1,  LDEC_ALL_INPUTS, RIGHT_TURN, lesenseTransActNone, true },
+};
+#else
+/*
+ * Swipe detector. A right swipe rolls a finger from PB0 over to PB1:
+ * PB0, both, PB1, none; a left swipe goes the other way. The whole
+ * gesture is followed by the decoder and only a completed swipe
+ * interrupts, so the CPU wakes once per gesture rather than per edge.
+ * Arcs with a partial care mask abort a gesture on a release out of
+ * order whatever the other button does.
+ */
+static const LDEC_Arc_t decoderArcs[] = {
+  // from        input    care             to          action     interrupt
+  { SWIPE_IDLE,  IN_PB0,  LDEC_ALL_INPUTS, RIGHT_PB0,  lesenseTransActNone, false },
+  { SWIPE_IDLE,  IN_PB1,  LDEC_ALL_INPUTS, LEFT_PB1,   lesenseTransActNone, false },
+  { SWIPE_LEFT,  IN_PB0,  LDEC_ALL_INPUTS, RIGHT_PB0,  lesenseTransActNone, false },
+  { SWIPE_LEFT,  IN_PB1,  LDEC_ALL_INPUTS, LEFT_PB1,   lesenseTransActNone, false },
+  { SWIPE_RIGHT, IN_PB0,  LDEC_ALL_INPUTS, RIGHT_PB0,  lesenseTransActNone, false },
+  { SWIPE_RIGHT, IN_PB1,  LDEC_ALL_INPUTS, LEFT_PB1,   lesenseTransActNone, false },
+
+  { RIGHT_PB0,   IN_BOTH, LDEC_ALL_INPUTS, RIGHT_BOTH, lesenseTransActNone, false },
+  { RIGHT_PB0,   IN_NONE, IN_PB0,          SWIPE_IDLE, lesenseTransActNone, false },
+  { RIGHT_BOTH,  IN_PB1,  LDEC_ALL_INPUTS, RIGHT_PB1,  lesenseTransActNone, false },
+  { RIGHT_BOTH,  IN_NONE, IN_PB1,          SWIPE_IDLE, lesenseTransActNone, false },
+  { RIGHT_PB1,   IN_NONE, LDEC_ALL_INPUTS, SWIPE_RIGHT, lesenseTransActNone, true },
+
+  { LEFT_PB1,    IN_BOTH, LDEC_ALL_INPUTS, LEFT_BOTH,  lesenseTransActNone, false },
+  { LEFT_PB1,    IN_NONE, IN_PB1,          SWIPE_IDLE, lesenseTransActNone, false },
+  { LEFT_BOTH,   IN_PB0,  LDEC_ALL_INPUTS, LEFT_PB0,   lesenseTransActNone, false },
+  { LEFT_BOTH,   IN_NONE, IN_PB0,          SWIPE_IDLE, lesenseTransActNone, false },
+  { LEFT_PB0,    IN_NONE, LDEC_ALL_INPUTS, SWIPE_LEFT, lesenseTransActNone, true },
+};
+#endif
+
+static const LDEC_Machine_t decoderMachine = {
+  .inputs = 2,
+  .initialState = NO_TURN,
+  .arcs = decoderArcs,
+  .arcCount = sizeof(decoderArcs) / sizeof(decoderArcs[0]),
+};
 
 /**************************************************************************//**
  * @brief LESENSE interrupt handler
@@ -84,6 +172,9 @@ void LESENSE_IRQHandler(void)
     // Check current decoder state
     decoder_state = LESENSE_DecoderStateGet();
   }
+
+  // Scan faster after a transition, decaying back to the idle rate
+  SRATE_Update(flags);
 }
 
 /**************************************************************************//**
@@ -197,115 +288,24 @@ void initLESENSE(void)
   //Initialize LESENSE interface
   LESENSE_Init(&initLesense, true);
 
-  /****************************************************************************
-    * @description: Configure LESENSE decoder states
-    * There are a total of 2 push buttons to be scanned so a total of four
-    * states are needed. The initial starting state is state 0, and state
-    * transition will happen when the compare value matches with the sensorState
-    * result on the non-masked channel.
-    ***************************************************************************/
-  LESENSE_DecStAll_TypeDef initStAll = LESENSE_DECODER_CONF_DEFAULT;
-
-  initStAll.St[0].curState  = 0;     // state 0 = no_turn
-  initStAll.St[0].nextState = 0;     // Set next state to itself
-  initStAll.St[0].compMask  = 0xC;   // enable both channels
-  initStAll.St[0].compVal   = 0x00;  // no button pressed
-
-  initStAll.St[1].curState  = 0;     // state 0 = no_turn
-  initStAll.St[1].nextState = 1;     // Set next state to 1 = left_turn
-  initStAll.St[1].compMask  = 0xC;   // enable both channels
-  initStAll.St[1].compVal   = 0x01;  // compare match on PB0 detect
-  initStAll.St[1].setInt    = true;  // enable interrupt upon match
-
-  initStAll.St[2].curState  = 0;     // state 0 = no_turn
-  initStAll.St[2].nextState = 2;     // Set next state to 2 = right_turn
-  initStAll.St[2].compMask  = 0xC;   // enable both channels
-  initStAll.St[2].compVal   = 0x02;  // compare match on PB1 detect
-  initStAll.St[2].setInt    = true;  // enable interrupt upon match
-
-  initStAll.St[3].curState  = 0;     // state 0 = no_turn
-  initStAll.St[3].nextState = 3;     // Set next state to 3 = both_turn
-  initStAll.St[3].compMask  = 0xC;   // enable both channels
-  initStAll.St[3].compVal   = 0x03;  // compare match on both buttons
-  initStAll.St[3].setInt    = true;  // enable interrupt upon match
-
-  initStAll.St[4].curState  = 1;     // state 1 = left_turn
-  initStAll.St[4].nextState = 0;     // Set next state to state 0 = no_turn
-  initStAll.St[4].compMask  = 0xC;   // enable both channels
-  initStAll.St[4].compVal   = 0x00;  // if no press, go back to state 0
-  initStAll.St[4].setInt    = true;  // enable interrupt upon match
-
-  initStAll.St[5].curState  = 1;     // state 1 = left_turn
-  initStAll.St[5].nextState = 1;     // Set next state to itself
-  initStAll.St[5].compMask  = 0xC;   // enable both channels
-  initStAll.St[5].compVal   = 0x01;  // compare match on PB0
-
-  initStAll.St[6].curState  = 1;     // state 1 = left_turn
-  initStAll.St[6].nextState = 2;     // Set next state to state 2 = right_turn
-  initStAll.St[6].compMask  = 0xC;   // enable both channels
-  initStAll.St[6].compVal   = 0x02;  // compare match on PB1
-  initStAll.St[6].setInt    = true;  // enable interrupt upon match
-
-  initStAll.St[7].curState  = 1;     // state 1 = left_turn
-  initStAll.St[7].nextState = 3;     // Set next state to state 3 = both_turn
-  initStAll.St[7].compMask  = 0xC;   // enable both channels
-  initStAll.St[7].compVal   = 0x03;  // compare match on both channel
-  initStAll.St[7].setInt    = true;  // enable interrupt upon match
-
-  initStAll.St[8].curState  = 3;     // state 3 = both_turn
-  initStAll.St[8].nextState = 3;     // Set next state to itself
-  initStAll.St[8].compMask  = 0xC;   // enable both channels
-  initStAll.St[8].compVal   = 0x03;  // if both pressed, stay in state 3
-
-  initStAll.St[9].curState  = 3;     // state 3 = both_turn
-  initStAll.St[9].nextState = 1;     // Set next state to state 1 = left_turn
-  initStAll.St[9].compMask  = 0xC;   // enable both channels
-  initStAll.St[9].compVal   = 0x01;  // compare match on PB0
-  initStAll.St[9].setInt    = true;  // enable interrupt upon match
-
-  initStAll.St[10].curState  = 3;     // state 3 = both_turn
-  initStAll.St[10].nextState = 2;     // Set next state to state 2 = right_turn
-  initStAll.St[10].compMask  = 0xC;   // enable both channels
-  initStAll.St[10].compVal   = 0x02;  // compare match on PB1
-  initStAll.St[10].setInt    = true;  // enable interrupt upon match
-
-  initStAll.St[11].curState  = 3;     // state 3 = both_turn
-  initStAll.St[11].nextState = 0;     // Set next state to state 0 = no_turn
-  initStAll.St[11].compMask  = 0xC;   // enable both channels
-  initStAll.St[11].compVal   = 0x00;  // if none pressed, go to state 0
-  initStAll.St[11].setInt    = true;  // enable interrupt upon match
-
-  initStAll.St[12].curState  = 2;     // state 2 = right_turn
-  initStAll.St[12].nextState = 0;     // Set next state to state 0 = no_turn
-  initStAll.St[12].compMask  = 0xC;   // enable both channels
-  initStAll.St[12].compVal   = 0x00;  // if none pressed, go to state 0
-  initStAll.St[12].setInt    = true;  // enable interrupt upon match
-
-  initStAll.St[13].curState  = 2;     // state 2 = right_turn
-  initStAll.St[13].nextState = 1;     // Set next state to state 1 = left_turn
-  initStAll.St[13].compMask  = 0xC;   // enable both channels
-  initStAll.St[13].compVal   = 0x01;  // compare match on PB0
-  initStAll.St[13].setInt    = true;  // enable interrupt upon match
-
-  initStAll.St[14].curState  = 2;     // state 2 = right_turn
-  initStAll.St[14].nextState = 2;     // Set next state to itself
-  initStAll.St[14].compMask  = 0xC;   // enable both channels
-  initStAll.St[14].compVal   = 0x02;  // compare match on PB1
-
-  initStAll.St[15].curState  = 2;     // state 2 = right_turn
-  initStAll.St[15].nextState = 3;     // Set next state to state 3 = both_turn
-  initStAll.St[15].compMask  = 0xC;   // enable both channels
-  initStAll.St[15].compVal   = 0x03;  // compare match on both buttons
-  initStAll.St[15].setInt    = true;  // enable interrupt upon match
-
-  LESENSE_DecoderStateAllConfig(&initStAll); // Initialize decoder
+  // Compile the selected state machine into the decoder, state 0 at start
+  if (LDEC_Load(&decoderMachine, &decoder_badArc) != ldecOk) {
+    // The table does not fit the decoder, see decoder_badArc
+    __BKPT(0);
+  }
 
   // Configure channel 0 and channel 1
   LESENSE_ChannelConfig(&initLesenseCh, 0);
   LESENSE_ChannelConfig(&initLesenseCh, 1);
 
-  // 8 Hz scan
-  LESENSE_ScanFreqSet(0, SCAN_FREQ);
+  // Scan at the idle rate, SRATE_Update() raises it on decoder activity
+  SRATE_Config_t rateConfig = {
+    .idleRate = SCAN_FREQ_IDLE,
+    .activeRate = SCAN_FREQ_ACTIVE,
+    .holdTime = SCAN_HOLD_MS,
+    .activityFlags = LESENSE_IF_DEC,
+  };
+  SRATE_Init(&rateConfig);
 
   // Wait for SYNCBUSY clear
   while(LESENSE->SYNCBUSY);
@@ -0,0 +1,198 @@
+/***************************************************************************//**
+ * @file scanrate.c
+ * @brief Adaptive LESENSE scan rate, fast on activity and decaying to idle.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2021 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ *******************************************************************************
+ * # Evaluation Quality
+ * This code has been minimally tested to ensure that it builds and is suitable
+ * as a demonstration for evaluation purposes only. This code will be maintained
+ * at the sole discretion of Silicon Labs.
+ ******************************************************************************/
+
+#include "em_device.h"
+#include "em_lesense.h"
+
+#include "scanrate.h"
+
+static SRATE_Config_t rateConfig;
+
+// Scan rate asked for, and scans left before it is halved
+static uint32_t currentRate;
+static uint32_t scansLeft;
+
+// Rate changes, for tuning the hold time
+static volatile uint32_t changeCount;
+
+/**************************************************************************//**
+ * @brief
+ *   Scans in the hold time at a given rate, at least one
+ *****************************************************************************/
+static uint32_t holdScans(uint32_t rate)
+{
+  uint32_t scans = (rate * rateConfig.holdTime) / 1000;
+
+  return (scans > 0) ? scans : 1;
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Change the scan rate of the running LESENSE
+ *
+ * @details
+ *   The scan timer can only be changed with LESENSE disabled. The decoder
+ *   state is put back afterwards so the state machine carries on as if
+ *   the scan had never stopped; the gap is a few LESENSE clock cycles.
+ *   Going idle also stops the scan complete interrupt, so at the idle
+ *   rate the CPU only wakes up on activity.
+ *****************************************************************************/
+static void setRate(uint32_t rate)
+{
+  uint32_t state;
+
+  if (rate == currentRate) {
+    return;
+  }
+
+  state = LESENSE_DecoderStateGet();
+
+  LESENSE->EN_CLR = LESENSE_EN_EN;
+  while (LESENSE->EN & _LESENSE_EN_DISABLING_MASK);
+
+  LESENSE_ScanFreqSet(0, rate);
+
+  LESENSE->EN_SET = LESENSE_EN_EN;
+  while (LESENSE->SYNCBUSY);
+
+  LESENSE_DecoderStateSet(state);
+  LESENSE_ScanStart();
+
+  if (rate > rateConfig.idleRate) {
+    LESENSE_IntClear(LESENSE_IF_SCANCOMPLETE);
+    LESENSE_IntEnable(LESENSE_IEN_SCANCOMPLETE);
+  } else {
+    LESENSE_IntDisable(LESENSE_IEN_SCANCOMPLETE);
+  }
+
+  currentRate = rate;
+  changeCount++;
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Set up the adaptive scan rate
+ *
+ * @details
+ *   Call in place of LESENSE_ScanFreqSet() while LESENSE is configured,
+ *   before the scan is started. LESENSE starts scanning at the idle rate.
+ *
+ * @param[in] config
+ *   Rates and hold time. An idle rate above the active rate is rejected.
+ *
+ * @return
+ *   true if the configuration is usable.
+ *****************************************************************************/
+bool SRATE_Init(const SRATE_Config_t *config)
+{
+  if ((config->idleRate == 0) || (config->idleRate > config->activeRate)) {
+    return false;
+  }
+
+  rateConfig = *config;
+  currentRate = rateConfig.idleRate;
+  scansLeft = 0;
+  changeCount = 0;
+
+  LESENSE_ScanFreqSet(0, currentRate);
+
+  return true;
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Go to the active rate and start the hold time over
+ *
+ * @details
+ *   For activity that LESENSE does not flag itself. Call from an interrupt
+ *   handler at the same priority as the LESENSE interrupt.
+ *****************************************************************************/
+void SRATE_Activity(void)
+{
+  setRate(rateConfig.activeRate);
+  scansLeft = holdScans(currentRate);
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Adapt the scan rate, call from LESENSE_IRQHandler()
+ *
+ * @details
+ *   Any of the activity flags switches straight to the active rate. After
+ *   each hold time without activity the rate is halved, down to the idle
+ *   rate, so a burst of activity is followed at the active rate and the
+ *   rate falls off within a few hold times once it stops. The response
+ *   to the first activity is at most one idle scan period late.
+ *
+ * @param[in] flags
+ *   LESENSE interrupt flags, as read and cleared by the handler.
+ *****************************************************************************/
+void SRATE_Update(uint32_t flags)
+{
+  uint32_t rate;
+
+  if (flags & rateConfig.activityFlags) {
+    SRATE_Activity();
+  } else if ((flags & LESENSE_IF_SCANCOMPLETE) && (scansLeft > 0)) {
+    if (--scansLeft == 0) {
+      rate = currentRate / 2;
+      if (rate < rateConfig.idleRate) {
+        rate = rateConfig.idleRate;
+      }
+      setRate(rate);
+      if (currentRate > rateConfig.idleRate) {
+        scansLeft = holdScans(currentRate);
+      }
+    }
+  }
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Scan rate asked for at the moment, scans per second
+ *****************************************************************************/
+uint32_t SRATE_GetRate(void)
+{
+  return currentRate;
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Number of scan rate changes since SRATE_Init()
+ *****************************************************************************/
+uint32_t SRATE_GetChangeCount(void)
+{
+  return changeCount;
+}
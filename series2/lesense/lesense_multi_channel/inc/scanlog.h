@@ -0,0 +1,73 @@
+/***************************************************************************//**
+ * @file scanlog.h
+ * @brief LESENSE scan results logged to a RAM ring by the LDMA in EM2.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2021 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ******************************************************************************/
+
+#ifndef SCANLOG_H
+#define SCANLOG_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// LDMA channel that empties the LESENSE result FIFO
+#define SCANLOG_LDMA_CHANNEL  0
+
+// Most watermark blocks in the ring, one LDMA descriptor each
+#define SCANLOG_MAX_BLOCKS    8
+
+// Largest block, the most words one descriptor moves
+#define SCANLOG_MAX_BLOCK     2048
+
+/*
+ * Result FIFO word: the LESENSE channel that produced the result in bits
+ * 19:16 and the result, here the IADC conversion, in bits 15:0.
+ */
+#define SCANLOG_CHANNEL(word) (((word) >> 16) & 0xF)
+#define SCANLOG_DATA(word)    ((word) & 0xFFFF)
+
+// Called from the LDMA interrupt with each watermark block just filled.
+// The LDMA goes on filling the rest of the ring, so the data stays valid
+// until the ring wraps around to it.
+typedef void (*SCANLOG_Callback_t)(const uint32_t *block, uint32_t count);
+
+bool SCANLOG_Init(uint32_t *ring,
+                  uint32_t size,
+                  uint32_t watermark,
+                  SCANLOG_Callback_t callback);
+void SCANLOG_Stop(void);
+uint32_t SCANLOG_GetDroppedCount(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SCANLOG_H
@@ -3,7 +3,9 @@
  * @brief LESENSE multi channel demo for EFR32FG23. This example uses LESENSE
  *        to scan four IADC scan channels in low energy mode. The LESENSE is
  *        configured to detect when each input signal crosses over a threshold
- *        and will trigger an interrupt to toggle an the LED.
+ *        and can trigger an interrupt to toggle an the LED. Every result is
+ *        logged to a RAM ring by the LDMA in EM2, and the CPU only wakes up
+ *        when the ring reaches a watermark.
  *******************************************************************************
  * # License
  * <b>Copyright 2021 Silicon Laboratories Inc. www.silabs.com</b>
@@ -44,13 +46,16 @@
 #include "em_emu.h"
 #include "em_gpio.h"
 #include "em_core.h"
+#include "em_ldma.h"
 #include "em_lesense.h"
 #include "em_usart.h"
 #include "bspconfig.h"
 #include "bsp.h"
 #include "mx25flash_spi.h"
 
-#define PD01REGNORETAIN  1  // EM0/1 peripheral register retention
+#include "scanlog.h"
+
+#define PD01REGNORETAIN  0  // EM0/1 peripheral register retention
 #define EM2_DEBUG        0  // EM2 debug enable
 
 // Set HFRCOEM23 to lowest frequency (1 MHz)
@@ -71,6 +76,18 @@
 #define IADC_COMP_THRESH_UPPER    0xC00
 #define IADC_COMP_THRESH_LOWER    0x200
 
+// Set to 1 to also interrupt on threshold crossings and toggle the LEDs.
+// With 0 the CPU only wakes up when the log reaches the watermark.
+#define THRESHOLD_INTERRUPTS      0
+
+// Number of LESENSE channels scanned and logged
+#define NUM_CHANNELS              4
+
+// Log ring of 128 scans, the CPU wakes up every LOG_WATERMARK results:
+// 64 scans, every 2 seconds at 32 scans per second
+#define LOG_RING_SIZE             (128 * NUM_CHANNELS)
+#define LOG_WATERMARK             (64 * NUM_CHANNELS)
+
 /*
  * Specify the IADC input using the IADC_PosInput_t typedef.  This
  * must be paired with a corresponding macro definition that allocates
@@ -99,6 +116,71 @@
 #define IADC_INPUT_3_BUS          ABUSALLOC
 #define IADC_INPUT_3_BUSALLOC     GPIO_ABUSALLOC_AODD0_ADC0
 
+// Trend of one channel over the last watermark block
+typedef struct {
+  uint16_t min;
+  uint16_t max;
+  uint16_t mean;
+  uint16_t last;
+} ChannelTrend_t;
+
+// Scan results written by the LDMA; each block is summed up into trend[]
+static uint32_t logRing[LOG_RING_SIZE];
+
+static volatile ChannelTrend_t trend[NUM_CHANNELS];
+static volatile uint32_t blocksLogged;
+
+/***************************************************************************//**
+ * @brief
+ *   Sum up a watermark block of the log into the trend of each channel
+ *
+ * @details
+ *   Called from the LDMA interrupt. The channel of each result comes from
+ *   the FIFO word itself, so a block does not have to start with channel
+ *   0 even if results were lost.
+ ******************************************************************************/
+static void logBlock(const uint32_t *block, uint32_t count)
+{
+  uint32_t sum[NUM_CHANNELS] = { 0 };
+  uint32_t n[NUM_CHANNELS] = { 0 };
+  uint16_t min[NUM_CHANNELS];
+  uint16_t max[NUM_CHANNELS];
+  uint32_t ch;
+  uint16_t data;
+
+  for (ch = 0; ch < NUM_CHANNELS; ch++) {
+    min[ch] = 0xFFFF;
+    max[ch] = 0;
+  }
+
+  for (uint32_t i = 0; i < count; i++) {
+    ch = SCANLOG_CHANNEL(block[i]);
+    if (ch >= NUM_CHANNELS) {
+      continue;
+    }
+    data = (uint16_t)SCANLOG_DATA(block[i]);
+    sum[ch] += data;
+    n[ch]++;
+    if (data < min[ch]) {
+      min[ch] = data;
+    }
+    if (data > max[ch]) {
+      max[ch] = data;
+    }
+    trend[ch].last = data;
+  }
+
+  for (ch = 0; ch < NUM_CHANNELS; ch++) {
+    if (n[ch] > 0) {
+      trend[ch].min = min[ch];
+      trend[ch].max = max[ch];
+      trend[ch].mean = (uint16_t)(sum[ch] / n[ch]);
+    }
+  }
+
+  blocksLogged++;
+}
+
 /***************************************************************************//**
  * @brief LESENSE interrupt handler
  *        This function acknowledges the interrupt and toggles LED0.
@@ -276,6 +358,9 @@ void initLESENSE(void)
 
   // Do not store scan result
   initLesense.coreCtrl.storeScanRes = true;
+
+  // Let the LDMA empty the result FIFO in EM2
+  initLesense.coreCtrl.wakeupOnDMA = lesenseDMAWakeUpEnable;
   initLesense.coreCtrl.scanConfSel = lesenseScanConfToggle; // Allows for some
                                                             // hysteresis
 
@@ -284,7 +369,8 @@ void initLESENSE(void)
 
   // Channel Configuration
   initLesenseCh.enaScanCh = true;  // Enable scan channel
-  initLesenseCh.enaInt = true;     // Enable interrupt
+  initLesenseCh.enaInt = THRESHOLD_INTERRUPTS; // Interrupt on crossings
+  initLesenseCh.storeCntRes = true; // Store each result in the FIFO
   initLesenseCh.sampleDelay = 0x0; // 0+1 LF Clock cycle sample delay
   initLesenseCh.sampleMode = lesenseSampleModeADC;
   initLesenseCh.intMode = (LESENSE_ChIntMode_TypeDef)
@@ -301,6 +387,7 @@ void initLESENSE(void)
   LESENSE_ChannelConfig(&initLesenseCh, 3);
 
   // Configure alternate channels
+  initLesenseCh.storeCntRes = false;
   initLesenseCh.enaScanCh = false;  // not actually scanning these channels;
                                     // only configuring as complimentary
                                     // thresholds for channels 0-4
@@ -400,9 +487,10 @@ int main(void)
  * wake up. This can be done by setting bit 0 in the EMU_PD1PARETCTRL register.
  *
  * Note this will cause the the EM0 / EM1 peripheral register interface to reset
- * upon exit to EM0 and will need to be reconfigured. This example does not use
- * any peripherals that operates in EM0 / EM1 only, and therefore has this bit
- * configured for lower current consumption.
+ * upon exit to EM0 and will need to be reconfigured. This example logs the
+ * LESENSE results with the LDMA, an EM0 / EM1 peripheral that keeps working
+ * while the device is in EM2, so its registers must be retained and the bit
+ * is left clear. Set PD01REGNORETAIN to 1 only without the log.
 *****************************************************************************/
 #if PD01REGNORETAIN
   EMU->PD1PARETCTRL_SET = 0x1;  // provides around 0.2-0.5uA of current saving
@@ -428,6 +516,9 @@ int main(void)
   // Initialize ACMP
   initIADC();
   
+  // Start logging before the first scan
+  SCANLOG_Init(logRing, LOG_RING_SIZE, LOG_WATERMARK, logBlock);
+
   // Initialize LESENSE
   initLESENSE();
 
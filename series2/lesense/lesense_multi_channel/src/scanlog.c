@@ -0,0 +1,184 @@
+/***************************************************************************//**
+ * @file scanlog.c
+ * @brief LESENSE scan results logged to a RAM ring by the LDMA in EM2.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2021 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ *******************************************************************************
+ * # Evaluation Quality
+ * This code has been minimally tested to ensure that it builds and is suitable 
+ * as a demonstration for evaluation purposes only. This code will be maintained
+ * at the sole discretion of Silicon Labs.
+ ******************************************************************************/
+
+#include <stddef.h>
+
+#include "em_device.h"
+#include "em_ldma.h"
+
+#include "scanlog.h"
+
+#define BLOCK_DONE          (1 << SCANLOG_LDMA_CHANNEL)
+
+// One descriptor per block, the last one links back to the first
+static LDMA_Descriptor_t descriptors[SCANLOG_MAX_BLOCKS];
+
+static uint32_t *ringStart;
+static uint32_t blockSize;
+static uint32_t blockCount;
+static SCANLOG_Callback_t blockCallback;
+
+// Block due next, so a missed interrupt can be noticed
+static uint32_t nextBlock;
+static volatile uint32_t droppedCount;
+
+/**************************************************************************//**
+ * @brief  LDMA Handler
+ *****************************************************************************/
+void LDMA_IRQHandler(void)
+{
+  uint32_t pending = LDMA_IntGetEnabled();
+  uint32_t writing;
+  uint32_t done;
+
+  // Loop here to enable the debugger to see what has happened
+  if (pending & LDMA_IF_ERROR) {
+    __BKPT(0);
+  }
+
+  LDMA_IntClear(BLOCK_DONE);
+
+  /*
+   * The LDMA has already loaded the next descriptor, so the block it is
+   * writing now tells which one is complete. Blocks skipped since the
+   * last interrupt have been overwritten in part and are dropped.
+   */
+  writing = (LDMA->CH[SCANLOG_LDMA_CHANNEL].DST - (uint32_t)ringStart)
+            / (blockSize * sizeof(uint32_t));
+  if (writing >= blockCount) {
+    writing = 0;
+  }
+  done = (writing + blockCount - 1) % blockCount;
+
+  droppedCount += (done + blockCount - nextBlock) % blockCount;
+  nextBlock = (done + 1) % blockCount;
+
+  if (blockCallback != NULL) {
+    blockCallback(ringStart + (done * blockSize), blockSize);
+  }
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Set up the LDMA ring and start emptying the LESENSE result FIFO
+ *
+ * @details
+ *   LESENSE is configured by the caller, with the results of the logged
+ *   channels stored in the FIFO and DMA wakeup enabled, so the LDMA moves
+ *   each result while the device stays in EM2. The CPU only wakes up
+ *   when another watermark words have been written to the ring.
+ *
+ * @param[in] ring
+ *   Ring buffer, word aligned.
+ *
+ * @param[in] size
+ *   Ring size in words, a multiple of watermark.
+ *
+ * @param[in] watermark
+ *   Words per interrupt, at most SCANLOG_MAX_BLOCK, with size / watermark
+ *   at most SCANLOG_MAX_BLOCKS. A multiple of the channels per scan keeps
+ *   every block starting with the same channel.
+ *
+ * @param[in] callback
+ *   Called from the LDMA interrupt with each block filled, may be NULL.
+ *
+ * @return
+ *   false if size or watermark are out of range.
+ *****************************************************************************/
+bool SCANLOG_Init(uint32_t *ring,
+                  uint32_t size,
+                  uint32_t watermark,
+                  SCANLOG_Callback_t callback)
+{
+  LDMA_Init_t init = LDMA_INIT_DEFAULT;
+
+  // Trigger LDMA transfer on LESENSE result FIFO data valid
+  LDMA_TransferCfg_t transferCfg =
+    LDMA_TRANSFER_CFG_PERIPHERAL(ldmaPeripheralSignal_LESENSE_FIFO);
+
+  if ((watermark == 0) || (watermark > SCANLOG_MAX_BLOCK)
+      || (size % watermark) || (size / watermark == 0)
+      || (size / watermark > SCANLOG_MAX_BLOCKS)) {
+    return false;
+  }
+
+  ringStart = ring;
+  blockSize = watermark;
+  blockCount = size / watermark;
+  blockCallback = callback;
+  nextBlock = 0;
+  droppedCount = 0;
+
+  LDMA_Init(&init);
+
+  /*
+   * The relative link is counted in descriptors, each one links to the
+   * next and the last one back to the first, or to itself if there is
+   * only one block.
+   */
+  for (uint32_t i = 0; i < blockCount; i++) {
+    int32_t link = (i < blockCount - 1) ? 1 : -(int32_t)(blockCount - 1);
+
+    descriptors[i] = (LDMA_Descriptor_t)
+      LDMA_DESCRIPTOR_LINKREL_P2M_WORD(&(LESENSE->RESFIFO),
+                                       ring + (i * watermark),
+                                       watermark,
+                                       link);
+    descriptors[i].xfer.doneIfs = 1;
+  }
+
+  LDMA_StartTransfer(SCANLOG_LDMA_CHANNEL, &transferCfg, &descriptors[0]);
+
+  return true;
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Stop the LDMA ring. Results left in the FIFO stay there.
+ *****************************************************************************/
+void SCANLOG_Stop(void)
+{
+  LDMA_StopTransfer(SCANLOG_LDMA_CHANNEL);
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Number of blocks filled that were not handed to the callback because
+ *   the LDMA interrupt was served too late.
+ *****************************************************************************/
+uint32_t SCANLOG_GetDroppedCount(void)
+{
+  return droppedCount;
+}
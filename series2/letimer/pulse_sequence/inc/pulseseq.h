@@ -0,0 +1,63 @@
+/***************************************************************************//**
+ * @file pulseseq.h
+ *
+ * @brief LETIMER pulse sequence player, fed from a step table by the LDMA.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2022 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ ******************************************************************************/
+
+#ifndef PULSESEQ_H
+#define PULSESEQ_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "em_gpio.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// LDMA channel that loads the steps, and the PRS channel that carries the
+// LETIMER underflow pulse to it
+#define PSEQ_LDMA_CHANNEL     0
+#define PSEQ_PRS_CHANNEL      0
+
+// Longest sequence, one LDMA descriptor and three words of RAM per step
+#ifndef PSEQ_MAX_STEPS
+#define PSEQ_MAX_STEPS        64
+#endif
+
+// Shortest idle part of a step in LETIMER clocks. The compare value of a
+// step is written by the LDMA after the underflow that starts it and must
+// reach the LETIMER clock domain before the output goes active.
+#define PSEQ_MIN_IDLE         4
+
+// Longest step, the 24 bit counter less one value kept for "never active"
+#define PSEQ_MAX_TICKS        0xFFFFFF
+
+/*
+ * One step of a sequence, in LETIMER clocks: the output stays at its idle
+ * level for idle clocks, then goes active for active clocks up to the end
+ * of the step. A step with no active clocks is a gap.
+ */
+typedef struct {
+  uint32_t idle;
+  uint32_t active;
+} PSEQ_Step_t;
+
+void PSEQ_Init(GPIO_Port_TypeDef port, unsigned int pin);
+bool PSEQ_Play(const PSEQ_Step_t *steps, uint32_t count, bool loop);
+void PSEQ_Stop(void);
+bool PSEQ_Busy(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // PULSESEQ_H
@@ -0,0 +1,191 @@
+/***************************************************************************//**
+ * @file main.c
+ * @brief This project demonstrates playing an arbitrary pulse sequence with the
+ * LETIMER, with the LDMA loading the compare and top values of each step from
+ * a table on each underflow while the device stays in EM2.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2022 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ *******************************************************************************
+ * # Evaluation Quality
+ * This code has been minimally tested to ensure that it builds and is suitable 
+ * as a demonstration for evaluation purposes only. This code will be maintained
+ * at the sole discretion of Silicon Labs.
+ ******************************************************************************/
+
+#include "em_device.h"
+#include "em_chip.h"
+#include "em_cmu.h"
+#include "em_emu.h"
+#include "em_gpio.h"
+#include "bsp.h"
+#include "xseries.h"
+#include "pulseseq.h"
+
+// LET0_O0 port/pin defs (Only ports A and B are available for LET0_O0 output)
+#if (XSERIES_CONFIG == 1) || (XSERIES_CONFIG == 2)
+// PA6 = Expansion Header 14 (4181A, 4182A)
+#define LET0OUT0PORT	gpioPortA
+#define LET0OUT0PIN		6
+#else
+// PA0 = (Expansion Header 5 (4263B/C, 4186A), Expansion Header 11 (4263A))
+#define LET0OUT0PORT	gpioPortA
+#define LET0OUT0PIN		0
+#endif
+
+// NEC infrared code sent, address and command
+#define NEC_ADDRESS     0x04
+#define NEC_COMMAND     0x08
+
+// NEC timing in microseconds, the frame repeats every NEC_FRAME_US
+#define NEC_LEAD_MARK   9000
+#define NEC_LEAD_SPACE  4500
+#define NEC_BIT_MARK    562
+#define NEC_ZERO_SPACE  562
+#define NEC_ONE_SPACE   1687
+#define NEC_FRAME_US    108000
+
+// The padded lead mark, the lead space and first bit mark, then one step
+// per bit: its space and the mark after it
+#define NEC_STEPS       (1 + 32 + 1)
+
+static PSEQ_Step_t steps[NEC_STEPS];
+
+/**************************************************************************//**
+ * @brief
+ *    CMU initialization
+ *****************************************************************************/
+void initCmu(void)
+{
+  // Enable clock to GPIO and LETIMER0
+  CMU_ClockEnable(cmuClock_GPIO, true);
+  CMU_ClockEnable(cmuClock_LETIMER0, true);
+}
+
+/**************************************************************************//**
+ * @brief Clock initialization
+ *****************************************************************************/
+void initClock(void)
+{
+  CMU_LFXOInit_TypeDef lfxoInit = CMU_LFXOINIT_DEFAULT;
+
+  // Select LFXO for the LETIMER
+  CMU_LFXOInit(&lfxoInit);
+  CMU_ClockSelectSet(cmuClock_EM23GRPACLK, cmuSelect_LFXO);
+}
+
+/**************************************************************************//**
+ * @brief Microseconds to LETIMER clocks, rounded
+ *****************************************************************************/
+static uint32_t ticks(uint32_t us)
+{
+  return (uint32_t)((((uint64_t)us * CMU_ClockFreqGet(cmuClock_LETIMER0))
+                     + 500000) / 1000000);
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Build the steps of an NEC frame
+ *
+ * @details
+ *    The output is the envelope of the code, active during the marks; an
+ *    infrared LED driver adds the 38 kHz carrier. The frame is the lead
+ *    mark and space, then the address, the inverted address, the command
+ *    and the inverted command, LSB first, a bit being a 562 us mark
+ *    followed by a 562 us (0) or 1687 us (1) space, and a final mark.
+ *
+ *    Each step of the player is a space followed by a mark, so step n
+ *    holds the space after mark n - 1 and mark n. The space of the first
+ *    step pads the frame to NEC_FRAME_US, so the frame repeats at the NEC
+ *    rate when the sequence loops.
+ *****************************************************************************/
+void buildNecFrame(uint8_t address, uint8_t command)
+{
+  uint32_t code = address | ((uint32_t)(uint8_t)~address << 8)
+                  | ((uint32_t)command << 16)
+                  | ((uint32_t)(uint8_t)~command << 24);
+  uint32_t total, i;
+
+  steps[0].active = ticks(NEC_LEAD_MARK);
+
+  steps[1].idle = ticks(NEC_LEAD_SPACE);
+  steps[1].active = ticks(NEC_BIT_MARK);
+
+  for (i = 0; i < 32; i++) {
+    steps[2 + i].idle = ticks(((code >> i) & 1) ? NEC_ONE_SPACE
+                                                : NEC_ZERO_SPACE);
+    steps[2 + i].active = ticks(NEC_BIT_MARK);
+  }
+
+  total = steps[0].active;
+  for (i = 1; i < NEC_STEPS; i++) {
+    total += steps[i].idle + steps[i].active;
+  }
+  steps[0].idle = ticks(NEC_FRAME_US) - total;
+}
+
+/**************************************************************************//**
+ * @brief  Main function
+ *****************************************************************************/
+int main(void)
+{
+  // Chip errata
+  CHIP_Init();
+
+  // Recommended recovery procedure for code in development
+  XSERIES_EscapeHatch(BSP_GPIO_PB0_PORT, BSP_GPIO_PB0_PIN,
+                      BSP_GPIO_LED0_PORT, BSP_GPIO_LED0_PIN);
+
+  /* Note: On EFR32xG22 devices and later, the DEBUG block on the device is 
+     powered off by default in low power modes EM2 and below.  Setting the 
+     EM2DBGEN bit in EMU_CTRL will cause the device to keep DEBUG powered on in
+     EM2.  Because DEBUG and LETIMER are on different power sub-domains from
+     xG23 and this example goes into EM2 in a while(1) loop, this is necessary
+     in order to reconnect the debugger for subsequent device erase and
+     programming.  On xG22, the LETIMER keeps the shared sub-domain powered.
+     When the EM2DBGEN bit is set, the device will exhibit slightly higher EM2
+     current consumption than when EM2DBGEN is not set. */
+#if XSERIES_CONFIG >= 3
+  XSERIES_EM2DebugEnable();
+#endif
+
+  // Initializations
+  initCmu();
+  initClock();
+  PSEQ_Init(LET0OUT0PORT, LET0OUT0PIN);
+
+  // Play the frame over and over, the LDMA loads every step
+  buildNecFrame(NEC_ADDRESS, NEC_COMMAND);
+  if (!PSEQ_Play(steps, NEC_STEPS, true)) {
+    // Loop here to enable the debugger to see what has happened
+    while (1);
+  }
+
+  // Enter low energy state, the sequence will continue
+  while (1)
+  {
+    EMU_EnterEM2(true);
+  }
+}
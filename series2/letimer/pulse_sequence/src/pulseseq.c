@@ -0,0 +1,242 @@
+/***************************************************************************//**
+ * @file pulseseq.c
+ *
+ * @brief LETIMER pulse sequence player, fed from a step table by the LDMA.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2022 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ *******************************************************************************
+ * # Evaluation Quality
+ * This code has been minimally tested to ensure that it builds and is suitable 
+ * as a demonstration for evaluation purposes only. This code will be maintained
+ * at the sole discretion of Silicon Labs.
+ ******************************************************************************/
+
+
+#include "em_device.h"
+#include "em_cmu.h"
+#include "em_ldma.h"
+#include "em_letimer.h"
+#include "em_prs.h"
+#include "xseries.h"
+
+#include "pulseseq.h"
+
+// The LETIMER underflow pulse reaches the LDMA through the PRS request 0
+// input
+#define STEP_SIGNAL         (LDMAXBAR_CH_REQSEL_SIGSEL_LDMAXBARPRSREQ0 \
+                             | LDMAXBAR_CH_REQSEL_SOURCESEL_LDMAXBAR)
+
+#define SEQUENCE_DONE       (1 << PSEQ_LDMA_CHANNEL)
+
+// Compare value that the counter never reaches, for a step with no active
+// clocks
+#define NEVER_ACTIVE        PSEQ_MAX_TICKS
+
+/*
+ * Register values written on each step, in the order of the LETIMER
+ * registers COMP0, COMP1 and TOP, so one block of three words covers them.
+ * COMP1 is not used by the outputs and is written as 0.
+ */
+typedef struct {
+  uint32_t comp0;
+  uint32_t comp1;
+  uint32_t top;
+} StepRegs_t;
+
+// One descriptor per step, and one to stop the LETIMER at the end
+static LDMA_Descriptor_t descriptors[PSEQ_MAX_STEPS + 1];
+static StepRegs_t stepRegs[PSEQ_MAX_STEPS];
+static const uint32_t stopCommand = LETIMER_CMD_STOP | LETIMER_CMD_CTO0;
+
+static volatile bool playing;
+
+/**************************************************************************//**
+ * @brief  LDMA Handler
+ *****************************************************************************/
+void LDMA_IRQHandler(void)
+{
+  uint32_t pending = LDMA_IntGetEnabled();
+
+  // Loop here to enable the debugger to see what has happened
+  if (pending & LDMA_IF_ERROR) {
+    __BKPT(0);
+  }
+
+  // Only the stop descriptor of a sequence that does not loop gets here
+  LDMA_IntClear(SEQUENCE_DONE);
+  playing = false;
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Set up LETIMER0, the PRS and the LDMA for sequences on output 0
+ *
+ * @details
+ *   LETIMER0 runs PWM on output 0: the output is idle from each underflow
+ *   and goes active when the counter reaches COMP0. Output 1, which is not
+ *   routed to a pin, pulses on each underflow; through the PRS the pulse
+ *   requests the LDMA, which writes COMP0 of the step just started and TOP
+ *   of the step after it. The LETIMER clock is selected by the caller.
+ *
+ * @param[in] port
+ *   Port of the output pin, port A or B to keep working in EM2.
+ *
+ * @param[in] pin
+ *   Output pin.
+ *****************************************************************************/
+void PSEQ_Init(GPIO_Port_TypeDef port, unsigned int pin)
+{
+  LDMA_Init_t init = LDMA_INIT_DEFAULT;
+  LETIMER_Init_TypeDef letimerInit = LETIMER_INIT_DEFAULT;
+
+  LDMA_Init(&init);
+
+  CMU_ClockEnable(cmuClock_PRS, true);
+  PRS_SourceAsyncSignalSet(PSEQ_PRS_CHANNEL,
+                           PRS_ASYNC_CH_CTRL_SOURCESEL_LETIMER0,
+                           PRS_LETIMER0_CH1);
+  PRS_ConnectConsumer(PSEQ_PRS_CHANNEL, prsTypeAsync, prsConsumerLDMA_REQUEST0);
+
+  CMU_ClockEnable(cmuClock_LETIMER0, true);
+  letimerInit.enable = false;
+  letimerInit.comp0Top = true;
+  letimerInit.topValue = 0;
+  letimerInit.ufoa0 = letimerUFOAPwm;
+  letimerInit.ufoa1 = letimerUFOAPulse;
+  letimerInit.repMode = letimerRepeatFree;
+  LETIMER_Init(LETIMER0, &letimerInit);
+  LETIMER_CompareSet(LETIMER0, 0, NEVER_ACTIVE);
+
+  GPIO_PinModeSet(port, pin, gpioModePushPull, 0);
+  XSERIES_LetimerRouteOut(0, port, pin);
+
+  playing = false;
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Play a sequence of steps on the output
+ *
+ * @details
+ *   The steps are turned into register values and LDMA descriptors, so the
+ *   table passed in may be reused at once. The sequence then plays with no
+ *   CPU involvement: the device may stay in EM2 throughout, and a sequence
+ *   that loops goes on until PSEQ_Stop(). A sequence that does not loop
+ *   ends with the LETIMER stopped, the output idle and one LDMA interrupt.
+ *
+ *   The LETIMER starts from a counter of 0, so its first underflow comes
+ *   one clock after the start: it loads TOP with the first step and the
+ *   LDMA writes the compare value of the first step and TOP of the second.
+ *
+ * @param[in] steps
+ *   Steps, each with idle at least PSEQ_MIN_IDLE and idle + active at most
+ *   PSEQ_MAX_TICKS.
+ *
+ * @param[in] count
+ *   Steps, 1 to PSEQ_MAX_STEPS.
+ *
+ * @param[in] loop
+ *   true to start again from the first step after the last one.
+ *
+ * @return
+ *   false if a step or the count is out of range.
+ *****************************************************************************/
+bool PSEQ_Play(const PSEQ_Step_t *steps, uint32_t count, bool loop)
+{
+  LDMA_TransferCfg_t transferCfg = LDMA_TRANSFER_CFG_PERIPHERAL(STEP_SIGNAL);
+  uint32_t i, next;
+
+  if ((count < 1) || (count > PSEQ_MAX_STEPS)) {
+    return false;
+  }
+  for (i = 0; i < count; i++) {
+    if ((steps[i].idle < PSEQ_MIN_IDLE)
+        || (steps[i].active > (PSEQ_MAX_TICKS - steps[i].idle))) {
+      return false;
+    }
+  }
+
+  PSEQ_Stop();
+
+  // Step i writes its own compare value and the length of the next step
+  for (i = 0; i < count; i++) {
+    next = (i + 1 < count) ? (i + 1) : (loop ? 0 : i);
+    stepRegs[i].comp0 = (steps[i].active > 0) ? (steps[i].active - 1)
+                        : NEVER_ACTIVE;
+    stepRegs[i].comp1 = 0;
+    stepRegs[i].top = steps[next].idle + steps[next].active - 1;
+
+    descriptors[i] = (LDMA_Descriptor_t)
+      LDMA_DESCRIPTOR_LINKREL_M2P_BYTE(&stepRegs[i], &(LETIMER0->COMP0),
+                                       3, 1);
+    descriptors[i].xfer.size = ldmaCtrlSizeWord;
+    descriptors[i].xfer.dstInc = ldmaCtrlDstIncOne;
+    descriptors[i].xfer.blockSize = ldmaCtrlBlockSizeUnit3;
+  }
+
+  if (loop) {
+    descriptors[count - 1].xfer.linkAddr = -(int32_t)(count - 1)
+                                          * LDMA_DESCRIPTOR_NDWORDS;
+  } else {
+    // The underflow at the end of the last step stops the LETIMER
+    descriptors[count] = (LDMA_Descriptor_t)
+      LDMA_DESCRIPTOR_SINGLE_M2P_BYTE(&stopCommand, &(LETIMER0->CMD), 1);
+    descriptors[count].xfer.size = ldmaCtrlSizeWord;
+  }
+
+  LDMA_IntClear(SEQUENCE_DONE);
+  LDMA_StartTransfer(PSEQ_LDMA_CHANNEL, &transferCfg, &descriptors[0]);
+
+  LETIMER_CounterSet(LETIMER0, 0);
+  LETIMER_TopSet(LETIMER0, steps[0].idle + steps[0].active - 1);
+  LETIMER_CompareSet(LETIMER0, 0, NEVER_ACTIVE);
+
+  playing = true;
+  LETIMER_Enable(LETIMER0, true);
+
+  return true;
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Stop the sequence at once, the output goes idle
+ *****************************************************************************/
+void PSEQ_Stop(void)
+{
+  // CTO0 returns the PWM output to idle when stopped in an active part
+  LETIMER0->CMD = LETIMER_CMD_STOP | LETIMER_CMD_CTO0;
+  LDMA_StopTransfer(PSEQ_LDMA_CHANNEL);
+  playing = false;
+}
+
+/**************************************************************************//**
+ * @brief
+ *   true while a sequence plays
+ *****************************************************************************/
+bool PSEQ_Busy(void)
+{
+  return playing;
+}
@@ -1,5 +1,5 @@
 /***************************************************************************//**
- * @file main_xg23_xg24.c
+ * @file main.c
  * @brief This project demonstrates generating a pulse train using the LETIMER
  * module. Expansion Header Pin 5 is configured for output compare and toggles
  * EH Pin 5 on each overflow event at a set frequency.
@@ -42,41 +42,21 @@
 #include "em_gpio.h"
 #include "em_letimer.h"
 #include "bsp.h"
+#include "xseries.h"
 
 // Desired frequency in Hz
 #define OUT_FREQ 1000
 
 // LET0_O0 port/pin defs (Only ports A and B are available for LET0_O0 output)
+#if (XSERIES_CONFIG == 1) || (XSERIES_CONFIG == 2)
+// PA6 = Expansion Header 14 (4181A, 4182A)
+#define LET0OUT0PORT	gpioPortA
+#define LET0OUT0PIN		6
+#else
 // PA0 = (Expansion Header 5 (4263B/C, 4186A), Expansion Header 11 (4263A))
 #define LET0OUT0PORT	gpioPortA
 #define LET0OUT0PIN		0
-
-/**************************************************************************//**
- * @brief escapeHatch()
- * When developing or debugging code that enters EM2 or
- * lower, it's a good idea to have an "escape hatch" type
- * mechanism, e.g. a way to pause the device so that a debugger can
- * connect in order to erase flash, among other things.
- *
- * Before proceeding with this example, make sure PB0 is not pressed.
- * If the PB0 pin is low, turn on LED0 and execute the breakpoint
- * instruction to stop the processor in EM0 and allow a debug
- * connection to be made.
- *****************************************************************************/
-void escapeHatch(void)
-{
-  CMU_ClockEnable(cmuClock_GPIO, true);
-  GPIO_PinModeSet(BSP_GPIO_PB0_PORT, BSP_GPIO_PB0_PIN, gpioModeInputPullFilter, 1);
-  if (GPIO_PinInGet(BSP_GPIO_PB0_PORT, BSP_GPIO_PB0_PIN) == 0) {
-    GPIO_PinModeSet(BSP_GPIO_LED0_PORT, BSP_GPIO_LED0_PIN, gpioModePushPull, 1);
-    __BKPT(0);
-  }
-  // Pin not asserted, so disable input
-  else {
-    GPIO_PinModeSet(BSP_GPIO_PB0_PORT, BSP_GPIO_PB0_PIN, gpioModeDisabled, 0);
-    CMU_ClockEnable(cmuClock_GPIO, false);
-  }
-}
+#endif
 
 /**************************************************************************//**
  * @brief GPIO initialization
@@ -126,11 +106,8 @@ void initLetimer(void)
   letimerInit.ufoa0 = letimerUFOAPulse;
   letimerInit.repMode = letimerRepeatFree;
 
-  // Enable LETIMER0 output0 on PA6
-  GPIO->LETIMERROUTE.ROUTEEN = GPIO_LETIMER_ROUTEEN_OUT0PEN;
-  GPIO->LETIMERROUTE.OUT0ROUTE = \
-      (LET0OUT0PORT << _GPIO_LETIMER_OUT0ROUTE_PORT_SHIFT) \
-      | (LET0OUT0PIN << _GPIO_LETIMER_OUT0ROUTE_PIN_SHIFT);
+  // Enable LETIMER0 output0 on LET0OUT0PORT/PIN
+  XSERIES_LetimerRouteOut(0, LET0OUT0PORT, LET0OUT0PIN);
 
   // Initialize and enable LETIMER
   LETIMER_Init(LETIMER0, &letimerInit);
@@ -145,17 +122,21 @@ int main(void)
   CHIP_Init();
 
   // Recommended recovery procedure for code in development
-  escapeHatch();
+  XSERIES_EscapeHatch(BSP_GPIO_PB0_PORT, BSP_GPIO_PB0_PIN,
+                      BSP_GPIO_LED0_PORT, BSP_GPIO_LED0_PIN);
 
   /* Note: On EFR32xG22 devices and later, the DEBUG block on the device is 
      powered off by default in low power modes EM2 and below.  Setting the 
      EM2DBGEN bit in EMU_CTRL will cause the device to keep DEBUG powered on in
-     EM2.  Because DEBUG and LETIMER are on different power sub-domains on xG23
-     and this example goes into EM2 in a while(1) loop, this is necessary in
-     order to reconnect the debugger for subsequent device erase and
-     programming.  When the EM2DBGEN bit is set, the device will exhibit
-     slightly higher EM2 current consumption than when EM2DBGEN is not set. */
-  EMU->CTRL_SET = EMU_CTRL_EM2DBGEN;
+     EM2.  Because DEBUG and LETIMER are on different power sub-domains from
+     xG23 and this example goes into EM2 in a while(1) loop, this is necessary
+     in order to reconnect the debugger for subsequent device erase and
+     programming.  On xG22, the LETIMER keeps the shared sub-domain powered.
+     When the EM2DBGEN bit is set, the device will exhibit slightly higher EM2
+     current consumption than when EM2DBGEN is not set. */
+#if XSERIES_CONFIG >= 3
+  XSERIES_EM2DebugEnable();
+#endif
 
   // Initializations
   initCmu();
@@ -1,114 +0,0 @@
-/***************************************************************************//**
- * @file main_xg21.c
- * @brief This project demonstrates generating a pulse train using the LETIMER
- * module. Expansion Header Pin 14 is configured for output compare and toggles
- * EH Pin 14 on each overflow event at a set frequency.
- *******************************************************************************
- * # License
- * <b>Copyright 2021 Silicon Laboratories Inc. www.silabs.com</b>
- *******************************************************************************
- *
- * SPDX-License-Identifier: Zlib
- *
- * The licensor of this software is Silicon Laboratories Inc.
- *
- * This software is provided 'as-is', without any express or implied
- * warranty. In no event will the authors be held liable for any damages
- * arising from the use of this software.
- *
- * Permission is granted to anyone to use this software for any purpose,
- * including commercial applications, and to alter it and redistribute it
- * freely, subject to the following restrictions:
- *
- * 1. The origin of this software must not be misrepresented; you must not
- *    claim that you wrote the original software. If you use this software
- *    in a product, an acknowledgment in the product documentation would be
- *    appreciated but is not required.
- * 2. Altered source versions must be plainly marked as such, and must not be
- *    misrepresented as being the original software.
- * 3. This notice may not be removed or altered from any source distribution.
- *
- *******************************************************************************
- * # Evaluation Quality
- * This code has been minimally tested to ensure that it builds and is suitable 
- * as a demonstration for evaluation purposes only. This code will be maintained
- * at the sole discretion of Silicon Labs.
- ******************************************************************************/
-
-#include "em_device.h"
-#include "em_chip.h"
-#include "em_cmu.h"
-#include "em_emu.h"
-#include "em_gpio.h"
-#include "em_letimer.h"
-#include "bsp.h"
-
-// Desired frequency in Hz
-#define OUT_FREQ 1000
-
-/**************************************************************************//**
- * @brief GPIO initialization
- *****************************************************************************/
-void initGpio(void)
-{
-  // Configure PA6 (Expansion Header 14) as output
-  GPIO_PinModeSet(gpioPortA, 6, gpioModePushPull, 1);
-}
-
-/**************************************************************************//**
- * @brief Clock initialization
- *****************************************************************************/
-void initClock(void)
-{
-  CMU_LFXOInit_TypeDef lfxoInit = CMU_LFXOINIT_DEFAULT;
-
-  // Select LFXO for the LETIMER
-  CMU_LFXOInit(&lfxoInit);
-  CMU_ClockSelectSet(cmuClock_EM23GRPACLK, cmuSelect_LFXO);
-}
-
-/**************************************************************************//**
- * @brief LETIMER initialization
- *****************************************************************************/
-void initLetimer(void)
-{
-  LETIMER_Init_TypeDef letimerInit = LETIMER_INIT_DEFAULT;
-
-  // Calculate the top value (frequency) based on clock source
-  uint32_t topValue = CMU_ClockFreqGet(cmuClock_LETIMER0) / OUT_FREQ;
-
-  // Reload top on underflow, pulse output, and run in free mode
-  letimerInit.comp0Top = true;
-  letimerInit.topValue = topValue;
-  letimerInit.ufoa0 = letimerUFOAPulse;
-  letimerInit.repMode = letimerRepeatFree;
-
-  // Enable LETIMER0 output0 on PA6
-  GPIO->LETIMERROUTE[0].ROUTEEN = GPIO_LETIMER_ROUTEEN_OUT0PEN;
-  GPIO->LETIMERROUTE[0].OUT0ROUTE = \
-      (gpioPortA << _GPIO_LETIMER_OUT0ROUTE_PORT_SHIFT) \
-      | (6 << _GPIO_LETIMER_OUT0ROUTE_PIN_SHIFT);
-
-  // Initialize and enable LETIMER
-  LETIMER_Init(LETIMER0, &letimerInit);
-}
-
-/**************************************************************************//**
- * @brief  Main function
- *****************************************************************************/
-int main(void)
-{
-  // Chip errata
-  CHIP_Init();
-
-  // Initializations
-  initClock();
-  initGpio();
-  initLetimer();
-
-  // Enter low energy state, pulse train will continue
-  while (1)
-  {
-    EMU_EnterEM2(true);
-  }
-}
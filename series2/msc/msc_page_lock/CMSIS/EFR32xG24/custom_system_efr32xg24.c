@@ -38,6 +38,9 @@
 // Include the BSP header file here for board GPIO definitions
 #include "bsp.h"
 
+// Boot image pages, BOOT_IMAGE_LOCK
+#include "bootcheck.h"
+
 // Bit mask to lock the last page of main flash
 #define LASTLOCK  0x80000000
 /* End code added for 'msc_page_lock' example */
@@ -220,6 +223,9 @@ void SystemInit(void)
   CMU->CLKEN1_SET = CMU_CLKEN1_MSC;
   MSC->PAGELOCK5 = LASTLOCK;
 
+  // Lock the boot image pages checked by BOOT_Check()
+  MSC->PAGELOCK0 = BOOT_IMAGE_LOCK;
+
   /*
    * To see how soon this happens relative to writing to one of the
    * MSC registers in main(), drive the GPIO connected to LED0 on the
@@ -0,0 +1,93 @@
+/***************************************************************************//**
+ * @file bootcheck.h
+ *
+ * @brief Boot image check that skips the full CRC when the page locks and
+ * the cached digest are unchanged, confirming the image in the background.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2020 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ******************************************************************************/
+
+#ifndef BOOTCHECK_H
+#define BOOTCHECK_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "em_device.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// LDMA channel that feeds the image to the GPCRC
+#define BOOT_LDMA_CHANNEL     0
+
+// Pages at the start of main flash holding the boot image, at most 32;
+// SystemInit() locks them before anything else runs
+#ifndef BOOT_IMAGE_PAGES
+#define BOOT_IMAGE_PAGES      4
+#endif
+
+#define BOOT_IMAGE_BYTES      (BOOT_IMAGE_PAGES * FLASH_PAGE_SIZE)
+
+// PAGELOCK0 bits of the boot image pages
+#if BOOT_IMAGE_PAGES == 32
+#define BOOT_IMAGE_LOCK       0xFFFFFFFFUL
+#else
+#define BOOT_IMAGE_LOCK       ((1UL << BOOT_IMAGE_PAGES) - 1)
+#endif
+
+// Bytes checked per BOOT_Background() call
+#ifndef BOOT_SLICE_SIZE
+#define BOOT_SLICE_SIZE       1024
+#endif
+
+// Page holding the cached digest, the one below the locked last page
+#define BOOT_RECORD_ADDR      (FLASH_BASE + FLASH_SIZE - 2 * FLASH_PAGE_SIZE)
+
+// MSC_PAGELOCKn registers, one bit per page of main flash
+#define BOOT_LOCK_WORDS       ((FLASH_SIZE / FLASH_PAGE_SIZE + 31) / 32)
+
+#if (BOOT_IMAGE_PAGES < 1) || (BOOT_IMAGE_PAGES > 32)
+#error "BOOT_IMAGE_PAGES must be 1 to 32"
+#endif
+
+// How the image was checked at boot
+typedef enum {
+  bootPathFast,       // Record unchanged, image checked in the background
+  bootPathFull,       // Locks changed, image checked against the record
+  bootPathUpdate,     // New version or no record, digest recorded
+  bootPathFailed      // Image does not match the record
+} BOOT_Path_t;
+
+BOOT_Path_t BOOT_Check(uint32_t version);
+bool BOOT_Background(void);
+uint32_t BOOT_GetDigest(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // BOOTCHECK_H
@@ -0,0 +1,250 @@
+/***************************************************************************//**
+ * @file bootcheck.c
+ *
+ * @brief Boot image check that skips the full CRC when the page locks and
+ * the cached digest are unchanged, confirming the image in the background.
+ *
+ * A full CRC-32 of the boot image, run by the LDMA and the GPCRC, is only
+ * needed when something could have changed the image since it was last
+ * checked. A record in flash keeps the image version, the MSC_PAGELOCKn
+ * words of the boot that checked it and its digest. When the version and
+ * the page locks of this boot match the record, the image was locked from
+ * reset onwards on both boots, so the check is skipped and the application
+ * starts at once. BOOT_Background() then checks the image against the
+ * recorded digest one slice at a time from the idle loop.
+ *
+ * A new version, or no record, is an update: the image is checked in full
+ * before the application starts and its digest is recorded. If only the
+ * page locks differ, the image is checked in full against the recorded
+ * digest, and the record takes the new locks if it matches.
+ *
+ * The record is written with its magic word last, so a record torn by a
+ * reset during the write is not valid and the next boot checks in full.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2020 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ *******************************************************************************
+ * # Evaluation Quality
+ * This code has been minimally tested to ensure that it builds and is suitable
+ * as a demonstration for evaluation purposes only. This code will be maintained
+ * at the sole discretion of Silicon Labs.
+ ******************************************************************************/
+
+#include "em_device.h"
+#include "em_msc.h"
+
+#include "crcverify.h"
+#include "bootcheck.h"
+
+// Last word of a complete record
+#define RECORD_MAGIC    0xB0075EC5UL
+
+// Cached digest of the boot image, magic last
+typedef struct {
+  uint32_t version;
+  uint32_t length;
+  uint32_t lock[BOOT_LOCK_WORDS];
+  uint32_t digest;
+  uint32_t magic;
+} BootRecord_t;
+
+#define RECORD          ((const BootRecord_t *)BOOT_RECORD_ADDR)
+
+static uint32_t digest;
+static bool backgroundFailed;
+
+/**************************************************************************//**
+ * @brief
+ *   Copy the MSC_PAGELOCKn words
+ *****************************************************************************/
+static void readLocks(uint32_t *lock)
+{
+  const volatile uint32_t *reg = &MSC->PAGELOCK0;
+  uint32_t i;
+
+  for (i = 0; i < BOOT_LOCK_WORDS; i++) {
+    lock[i] = reg[i];
+  }
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Compare page locks with those of the record
+ *****************************************************************************/
+static bool locksMatch(const uint32_t *lock)
+{
+  uint32_t i;
+
+  for (i = 0; i < BOOT_LOCK_WORDS; i++) {
+    if (lock[i] != RECORD->lock[i]) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Set up the GPCRC check of the boot image
+ *****************************************************************************/
+static void initCheck(uint32_t expected)
+{
+  CRCVERIFY_Init_t init;
+
+  init.channel   = BOOT_LDMA_CHANNEL;
+  init.start     = (const void *)FLASH_BASE;
+  init.length    = BOOT_IMAGE_BYTES;
+  init.expected  = expected;
+  init.sliceSize = BOOT_SLICE_SIZE;
+  init.callback  = NULL;
+  CRCVERIFY_Init(&init);
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Check the whole image and wait for the result
+ *****************************************************************************/
+static uint32_t fullCheck(void)
+{
+  CRCVERIFY_Start();
+  while (CRCVERIFY_IsBusy());
+
+  return CRCVERIFY_GetCrc();
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Replace the record, the magic word written last
+ *****************************************************************************/
+static bool writeRecord(uint32_t version, const uint32_t *lock, uint32_t crc)
+{
+  BootRecord_t record;
+  uint32_t i;
+
+  record.version = version;
+  record.length  = BOOT_IMAGE_BYTES;
+  for (i = 0; i < BOOT_LOCK_WORDS; i++) {
+    record.lock[i] = lock[i];
+  }
+  record.digest  = crc;
+  record.magic   = RECORD_MAGIC;
+
+  if (MSC_ErasePage((uint32_t *)BOOT_RECORD_ADDR) != mscReturnOk) {
+    return false;
+  }
+  return MSC_WriteWord((uint32_t *)BOOT_RECORD_ADDR, &record,
+                       sizeof(record)) == mscReturnOk;
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Check the boot image, in full only if the record does not match
+ *
+ * @details
+ *   Call once at boot, after MSC_Init() and LDMA_Init(), with
+ *   CRCVERIFY_IRQHandler() called from LDMA_IRQHandler(). The boot image
+ *   pages must already be locked. Returns within microseconds on the fast
+ *   path; the other paths wait for the CRC of the whole image.
+ *
+ * @param[in] version
+ *   Version of the running image, a new value is taken as an update.
+ *
+ * @return
+ *   The path taken, bootPathFailed if the image does not match the
+ *   record or the record could not be written.
+ *****************************************************************************/
+BOOT_Path_t BOOT_Check(uint32_t version)
+{
+  uint32_t lock[BOOT_LOCK_WORDS];
+  BOOT_Path_t path;
+  bool valid;
+
+  readLocks(lock);
+  backgroundFailed = false;
+
+  valid = (RECORD->magic == RECORD_MAGIC)
+          && (RECORD->length == BOOT_IMAGE_BYTES)
+          && (RECORD->version == version);
+
+  // Same image, locked the same way on both boots; the background check
+  // confirms the digest later
+  if (valid && locksMatch(lock)) {
+    digest = RECORD->digest;
+    initCheck(digest);
+    return bootPathFast;
+  }
+
+  initCheck(valid ? RECORD->digest : 0);
+  digest = fullCheck();
+
+  if (valid) {
+    // The locks changed but the image must not have
+    if (CRCVERIFY_GetStatus() != crcVerifyPassed) {
+      return bootPathFailed;
+    }
+    path = bootPathFull;
+  } else {
+    path = bootPathUpdate;
+  }
+
+  if (!writeRecord(version, lock, digest)) {
+    return bootPathFailed;
+  }
+
+  // Keep checking against the new record
+  initCheck(digest);
+  return path;
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Check the next slice of the image against the digest
+ *
+ * @details
+ *   Call from the idle loop after BOOT_Check(). Each complete pass is
+ *   followed by the next, so the image is re-verified continuously.
+ *
+ * @return
+ *   false once a complete pass has not matched the digest.
+ *****************************************************************************/
+bool BOOT_Background(void)
+{
+  if (!backgroundFailed) {
+    CRCVERIFY_Slice();
+    if (CRCVERIFY_GetStatus() == crcVerifyFailed) {
+      backgroundFailed = true;
+    }
+  }
+  return !backgroundFailed;
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Digest the image is checked against
+ *****************************************************************************/
+uint32_t BOOT_GetDigest(void)
+{
+  return digest;
+}
@@ -37,17 +37,40 @@
 
 #include "em_device.h"
 #include "em_chip.h"
+#include "em_cmu.h"
+#include "em_ldma.h"
 #include "em_msc.h"
 
+#include "crcverify.h"
+#include "bootcheck.h"
+
 // Include the BSP header file here for board GPIO definitions
 #include "bsp.h"
 
+// Version of this image, change it with each release so that the first
+// boot of the new image checks it in full
+#define BOOT_IMAGE_VERSION  1
+
+// Boot check path and its duration in core clock cycles, for the debugger
+volatile BOOT_Path_t bootPath;
+volatile uint32_t bootCycles;
+
+/**************************************************************************//**
+ * @brief LDMA Handler
+ *****************************************************************************/
+void LDMA_IRQHandler(void)
+{
+  CRCVERIFY_IRQHandler();
+}
+
 /**************************************************************************//**
  * @brief Main function
  *****************************************************************************/
 int main(void)
 {
   MSC_Status_TypeDef flashStatus;
+  LDMA_Init_t ldmaInit = LDMA_INIT_DEFAULT;
+  uint32_t start;
 
   // Chip errata
   CHIP_Init();
@@ -103,6 +126,37 @@ int main(void)
          break;
   }
 
-  // If both pages are locked, code will loop here
-  while(1);
+  // The LDMA feeds the boot image to the GPCRC
+  CMU_ClockEnable(cmuClock_LDMA, true);
+  LDMA_Init(&ldmaInit);
+
+  // Count core clock cycles to time the boot check
+  CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+  DWT->CYCCNT = 0;
+  DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+  /*
+   * Check the boot image.  The full CRC only runs after an update or
+   * when the page locks differ from those of the boot that recorded the
+   * digest; otherwise this returns at once.
+   */
+  start = DWT->CYCCNT;
+  bootPath = BOOT_Check(BOOT_IMAGE_VERSION);
+  bootCycles = DWT->CYCCNT - start;
+
+  // Halt if the image does not match its recorded digest
+  if (bootPath == bootPathFailed) {
+    __BKPT(2);
+  }
+
+  /*
+   * If both pages are locked, code will loop here, checking the boot
+   * image against its digest in the background.  Halt if any pass does
+   * not match.
+   */
+  while (1) {
+    if (!BOOT_Background()) {
+      __BKPT(3);
+    }
+  }
 }
@@ -0,0 +1,358 @@
+/***************************************************************************//**
+ * @file main.c
+ * @brief This project measures how much faster hot DSP kernels run from RAM
+ * than from flash, with the instruction cache enabled and disabled. See
+ * readme.txt for details.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2021 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ *******************************************************************************
+ * # Evaluation Quality
+ * This code has been minimally tested to ensure that it builds and is suitable 
+ * as a demonstration for evaluation purposes only. This code will be maintained
+ * at the sole discretion of Silicon Labs.
+ ******************************************************************************/
+
+#include "em_device.h"
+#include "em_chip.h"
+#include "em_cmu.h"
+#include "em_ramfunc.h"
+
+/*******************************************************************************
+ *******************************   DEFINES   ***********************************
+ ******************************************************************************/
+
+// Core clock. Above 40 MHz flash reads take a wait state.
+#define CORE_FREQ                 cmuHFRCODPLLFreq_64M0Hz
+
+// Runs per configuration, the fastest one is kept
+#define RUNS                      16
+
+// Points of the FFT, a power of two
+#define FFT_POINTS                256
+
+// cos and sin of 2 * pi / FFT_POINTS, for the twiddle factor recurrence
+#define FFT_COS_STEP              0.99969881869620422f
+#define FFT_SIN_STEP              0.02454122852291229f
+
+// Stereo PDM FIFO words split per run
+#define PDM_WORDS                 512
+
+/*******************************************************************************
+ ***************************   GLOBAL VARIABLES   *******************************
+ ******************************************************************************/
+
+// Cycles of one kernel in each placement
+typedef struct {
+  const char *kernel;          // Kernel name
+  uint32_t cyclesFlashCold;    // Flash, first run after a cache flush
+  uint32_t cyclesFlash;        // Flash, instruction cache warm
+  uint32_t cyclesFlashNoCache; // Flash, instruction cache disabled
+  uint32_t cyclesRam;          // RAM
+  float speedupCold;           // cyclesFlashCold / cyclesRam
+  float speedup;               // cyclesFlash / cyclesRam
+  float speedupNoCache;        // cyclesFlashNoCache / cyclesRam
+} RamResult_t;
+
+#define NUM_KERNELS               2
+
+static volatile RamResult_t results[NUM_KERNELS] = {
+  { .kernel = "fft" },
+  { .kernel = "pdm deinterleave" },
+};
+
+// Passes completed over all kernels
+static volatile uint32_t passes;
+
+/*
+ * Kernel data, all in RAM, so the placements only differ in where the
+ * instructions are fetched from. The twiddle factors are not const for the
+ * same reason: const data would be read from flash.
+ */
+static int16_t twiddleRe[FFT_POINTS / 2];
+static int16_t twiddleIm[FFT_POINTS / 2];
+static int16_t fftRe[FFT_POINTS];
+static int16_t fftIm[FFT_POINTS];
+
+static uint32_t pdmFifo[PDM_WORDS];
+static int16_t pdmLeft[PDM_WORDS];
+static int16_t pdmRight[PDM_WORDS];
+
+/**************************************************************************//**
+ * @brief
+ *    Radix-2 decimation in time FFT of fftRe/fftIm in place, Q15
+ *
+ * @details
+ *    Each stage halves the data against overflow, so the result is the
+ *    transform / FFT_POINTS. Forced inline, so the flash and the RAM
+ *    placement below each get their own copy of the loops and call
+ *    nothing.
+ *****************************************************************************/
+__STATIC_FORCEINLINE void fftKernel(void)
+{
+  uint32_t i, j, k, m, bit, half, step;
+  int32_t wr, wi, tr, ti;
+  int16_t t;
+
+  // Bit reversed order
+  for (i = 1, j = 0; i < FFT_POINTS; i++) {
+    for (bit = FFT_POINTS >> 1; j & bit; bit >>= 1) {
+      j ^= bit;
+    }
+    j |= bit;
+    if (i < j) {
+      t = fftRe[i];
+      fftRe[i] = fftRe[j];
+      fftRe[j] = t;
+      t = fftIm[i];
+      fftIm[i] = fftIm[j];
+      fftIm[j] = t;
+    }
+  }
+
+  // Butterflies
+  for (half = 1, step = FFT_POINTS / 2; half < FFT_POINTS;
+       half <<= 1, step >>= 1) {
+    for (k = 0; k < half; k++) {
+      wr = twiddleRe[k * step];
+      wi = twiddleIm[k * step];
+      for (i = k; i < FFT_POINTS; i += 2 * half) {
+        m = i + half;
+        tr = (wr * fftRe[m] - wi * fftIm[m]) >> 15;
+        ti = (wr * fftIm[m] + wi * fftRe[m]) >> 15;
+        fftRe[m] = (int16_t)((fftRe[i] - tr) >> 1);
+        fftIm[m] = (int16_t)((fftIm[i] - ti) >> 1);
+        fftRe[i] = (int16_t)((fftRe[i] + tr) >> 1);
+        fftIm[i] = (int16_t)((fftIm[i] + ti) >> 1);
+      }
+    }
+  }
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Split stereo PDM FIFO words into left/right, as the PDM interrupt or
+ *    LDMA handler of the pdm examples does
+ *****************************************************************************/
+__STATIC_FORCEINLINE void deinterleaveKernel(void)
+{
+  uint32_t i;
+
+  for (i = 0; i < PDM_WORDS; i++) {
+    pdmLeft[i] = (int16_t)(pdmFifo[i] & 0x0000FFFF);
+    pdmRight[i] = (int16_t)(pdmFifo[i] >> 16);
+  }
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Kernels in flash
+ *****************************************************************************/
+static void fftFlash(void)
+{
+  fftKernel();
+}
+
+static void deinterleaveFlash(void)
+{
+  deinterleaveKernel();
+}
+
+/**************************************************************************//**
+ * @brief
+ *    The same kernels in RAM
+ *
+ * @details
+ *    SL_RAMFUNC_DEFINITION_BEGIN puts a function in the .ram section, which
+ *    the series 2 linker scripts place with the initialized data, so the
+ *    startup code copies it to RAM. The functions are called through
+ *    pointers, which reach RAM from flash without long call veneers.
+ *****************************************************************************/
+SL_RAMFUNC_DEFINITION_BEGIN
+static void fftRam(void)
+{
+  fftKernel();
+}
+SL_RAMFUNC_DEFINITION_END
+
+SL_RAMFUNC_DEFINITION_BEGIN
+static void deinterleaveRam(void)
+{
+  deinterleaveKernel();
+}
+SL_RAMFUNC_DEFINITION_END
+
+/**************************************************************************//**
+ * @brief
+ *    Load the FFT input, a square wave plus a ramp
+ *****************************************************************************/
+static void fftPrepare(void)
+{
+  uint32_t i;
+
+  for (i = 0; i < FFT_POINTS; i++) {
+    fftRe[i] = (int16_t)(((i & 16) ? 12000 : -12000) + (int32_t)i * 32);
+    fftIm[i] = 0;
+  }
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Load the PDM FIFO words, left in the low and right in the high half
+ *****************************************************************************/
+static void deinterleavePrepare(void)
+{
+  uint32_t i;
+
+  for (i = 0; i < PDM_WORDS; i++) {
+    pdmFifo[i] = ((i * 40503UL) << 16) | ((i * 7919UL) & 0xFFFF);
+  }
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Twiddle factors e^(-j * 2 * pi * k / FFT_POINTS), Q15
+ *
+ * @details
+ *    A rotation recurrence in float, so no math library is needed.
+ *****************************************************************************/
+static void initTwiddles(void)
+{
+  float c = 1.0f, s = 0.0f, t;
+  uint32_t k;
+
+  for (k = 0; k < FFT_POINTS / 2; k++) {
+    twiddleRe[k] = (int16_t)(c * 32767.0f);
+    twiddleIm[k] = (int16_t)(-s * 32767.0f);
+    t = c * FFT_COS_STEP - s * FFT_SIN_STEP;
+    s = s * FFT_COS_STEP + c * FFT_SIN_STEP;
+    c = t;
+  }
+}
+
+// Each kernel with its input and both placements
+typedef struct {
+  void (*prepare)(void);
+  void (*flash)(void);
+  void (*ram)(void);
+} Kernel_t;
+
+static const Kernel_t kernels[NUM_KERNELS] = {
+  { fftPrepare, fftFlash, fftRam },
+  { deinterleavePrepare, deinterleaveFlash, deinterleaveRam },
+};
+
+/**************************************************************************//**
+ * @brief
+ *    Cycles of one run of a kernel
+ *****************************************************************************/
+static uint32_t runOnce(const Kernel_t *k, void (*placement)(void))
+{
+  uint32_t start;
+
+  k->prepare();
+  start = DWT->CYCCNT;
+  placement();
+  return DWT->CYCCNT - start;
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Cycles of the fastest of RUNS runs of a kernel
+ *****************************************************************************/
+static uint32_t runBest(const Kernel_t *k, void (*placement)(void))
+{
+  uint32_t best = 0xFFFFFFFF, cycles, i;
+
+  for (i = 0; i < RUNS; i++) {
+    cycles = runOnce(k, placement);
+    if (cycles < best) {
+      best = cycles;
+    }
+  }
+
+  return best;
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Measure one kernel in all placements
+ *
+ * @param[in] k
+ *    Kernel
+ *
+ * @param[in] r
+ *    Its results, filled in
+ *****************************************************************************/
+static void measure(const Kernel_t *k, volatile RamResult_t *r)
+{
+  // Flash, as it runs when other code has evicted it from the cache
+  ICACHE0->CMD = ICACHE_CMD_FLUSH;
+  r->cyclesFlashCold = runOnce(k, k->flash);
+
+  // Flash, the cache holds the loops after the first run
+  r->cyclesFlash = runBest(k, k->flash);
+
+  // Flash, every fetch waits for the flash
+  ICACHE0->CTRL_SET = ICACHE_CTRL_CACHEDIS;
+  r->cyclesFlashNoCache = runBest(k, k->flash);
+  ICACHE0->CTRL_CLR = ICACHE_CTRL_CACHEDIS;
+
+  // RAM, the cache does not cache RAM and makes no difference
+  r->cyclesRam = runBest(k, k->ram);
+
+  r->speedupCold = (float)r->cyclesFlashCold / r->cyclesRam;
+  r->speedup = (float)r->cyclesFlash / r->cyclesRam;
+  r->speedupNoCache = (float)r->cyclesFlashNoCache / r->cyclesRam;
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Main function
+ *****************************************************************************/
+int main(void)
+{
+  int i;
+
+  CHIP_Init();
+
+  // Set the core clock, emlib sets the flash wait states with it
+  CMU_HFRCODPLLBandSet(CORE_FREQ);
+
+  // Start the cycle counter
+  CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+  DWT->CYCCNT = 0;
+  DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+  initTwiddles();
+
+  // Measure all kernels, over and over
+  while (1) {
+    for (i = 0; i < NUM_KERNELS; i++) {
+      measure(&kernels[i], &results[i]);
+    }
+    passes++;
+  }
+}
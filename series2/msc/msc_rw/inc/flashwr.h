@@ -0,0 +1,71 @@
+/***************************************************************************//**
+ * @file flashwr.h
+ * @brief Batched flash programming from RAM, by the CPU or the LDMA.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2021 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ******************************************************************************/
+
+#ifndef FLASHWR_H
+#define FLASHWR_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "em_msc.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// LDMA channel that feeds MSC->WDATA
+#define FLASHWR_LDMA_CHANNEL  0
+
+typedef enum {
+  flashwrCpu,                   // CPU writes WDATA, code running from RAM
+  flashwrDma,                   // LDMA writes WDATA
+} FLASHWR_Path_t;
+
+// Timing of the last FLASHWR_Program()
+typedef struct {
+  uint32_t bytes;               // Bytes programmed
+  uint32_t pages;               // Pages erased
+  uint32_t eraseCycles;         // Core clock cycles erasing
+  uint32_t writeCycles;         // Core clock cycles programming
+  uint32_t bytesPerMs;          // Programming rate, without the erases
+} FLASHWR_Stats_t;
+
+void FLASHWR_Init(void);
+MSC_Status_TypeDef FLASHWR_Program(uint32_t *address,
+                                   const void *data,
+                                   uint32_t numBytes,
+                                   bool erase,
+                                   FLASHWR_Path_t path);
+const FLASHWR_Stats_t *FLASHWR_GetStats(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // FLASHWR_H
@@ -0,0 +1,76 @@
+/***************************************************************************//**
+ * @file kvstore.h
+ * @brief Log structured key/value store in flash pages.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2021 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ******************************************************************************/
+
+#ifndef KVSTORE_H
+#define KVSTORE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Keys held in the RAM index, and the longest value in bytes
+#define KVS_MAX_KEYS          32
+#define KVS_MAX_VALUE         64
+
+// Most pages the store can span
+#define KVS_MAX_PAGES         8
+
+// Key of an erased word, not usable
+#define KVS_KEY_BLANK         0xFFFF
+
+typedef enum {
+  kvsOk,
+  kvsErrConfig,               // Pages not usable for the store
+  kvsErrNotFound,             // No value for the key
+  kvsErrKey,                  // Reserved key
+  kvsErrLength,               // Value longer than KVS_MAX_VALUE
+  kvsErrFull,                 // KVS_MAX_KEYS keys already in use
+  kvsErrFlash,                // Flash write or erase failed
+} KVS_Status_t;
+
+KVS_Status_t KVS_Init(uint32_t *base, uint32_t pageCount);
+KVS_Status_t KVS_Write(uint16_t key, const void *data, uint32_t length);
+KVS_Status_t KVS_Read(uint16_t key,
+                      void *data,
+                      uint32_t size,
+                      uint32_t *length);
+KVS_Status_t KVS_Delete(uint16_t key);
+uint32_t KVS_GetKeyCount(void);
+uint32_t KVS_GetFreeSpace(void);
+uint32_t KVS_GetEraseCount(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // KVSTORE_H
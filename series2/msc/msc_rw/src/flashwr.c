@@ -0,0 +1,171 @@
+/***************************************************************************//**
+ * @file flashwr.c
+ * @brief Batched flash programming from RAM, by the CPU or the LDMA.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2021 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ *******************************************************************************
+ * # Evaluation Quality
+ * This code has been minimally tested to ensure that it builds and is suitable
+ * as a demonstration for evaluation purposes only. This code will be maintained
+ * at the sole discretion of Silicon Labs.
+ ******************************************************************************/
+
+#include "em_device.h"
+#include "em_cmu.h"
+#include "em_ldma.h"
+#include "em_msc.h"
+#include "em_ramfunc.h"
+
+#include "flashwr.h"
+
+static FLASHWR_Stats_t stats;
+
+/**************************************************************************//**
+ * @brief
+ *   Erase the pages under a buffer, then program it in one go
+ *
+ * @details
+ *   Runs from RAM, like the emlib MSC write and erase functions it calls,
+ *   so no code is fetched from flash while it is busy. The buffer is
+ *   handed to MSC_WriteWord() or MSC_WriteWordDma() as a whole instead
+ *   of word by word; the MSC then keeps WDATA full and only waits for the
+ *   flash itself.
+ *****************************************************************************/
+SL_RAMFUNC_DEFINITION_BEGIN
+static MSC_Status_TypeDef program(uint32_t *address,
+                                  const void *data,
+                                  uint32_t numBytes,
+                                  bool erase,
+                                  FLASHWR_Path_t path)
+{
+  MSC_Status_TypeDef status = mscReturnOk;
+  uint32_t page;
+  uint32_t end;
+  uint32_t start;
+
+  start = DWT->CYCCNT;
+  if (erase) {
+    end = (uint32_t)address + numBytes;
+    for (page = (uint32_t)address & ~(FLASH_PAGE_SIZE - 1);
+         (page < end) && (status == mscReturnOk);
+         page += FLASH_PAGE_SIZE) {
+      status = MSC_ErasePage((uint32_t *)page);
+      stats.pages++;
+    }
+  }
+  stats.eraseCycles = DWT->CYCCNT - start;
+
+  if (status != mscReturnOk) {
+    return status;
+  }
+
+  start = DWT->CYCCNT;
+  if (path == flashwrDma) {
+    status = MSC_WriteWordDma(FLASHWR_LDMA_CHANNEL, address, data, numBytes);
+  } else {
+    status = MSC_WriteWord(address, data, numBytes);
+  }
+  stats.writeCycles = DWT->CYCCNT - start;
+
+  return status;
+}
+SL_RAMFUNC_DEFINITION_END
+
+/**************************************************************************//**
+ * @brief
+ *   Start the cycle counter and the LDMA used by the DMA path
+ *****************************************************************************/
+void FLASHWR_Init(void)
+{
+  LDMA_Init_t ldmaInit = LDMA_INIT_DEFAULT;
+
+  CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+  DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+  CMU_ClockEnable(cmuClock_MSC, true);
+  LDMA_Init(&ldmaInit);
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Program a buffer of any length into flash
+ *
+ * @details
+ *   The CPU is busy until the whole buffer is programmed; with the DMA
+ *   path it only waits for the LDMA to finish. The time taken is kept
+ *   for FLASHWR_GetStats().
+ *
+ * @param[in] address
+ *   Word aligned flash address.
+ *
+ * @param[in] data
+ *   Data to program, word aligned.
+ *
+ * @param[in] numBytes
+ *   Bytes to program, a multiple of 4.
+ *
+ * @param[in] erase
+ *   Erase every page the buffer touches first. Take care: the whole page
+ *   is erased, also the parts outside the buffer.
+ *
+ * @param[in] path
+ *   Feed WDATA from the CPU or from the LDMA.
+ *
+ * @return
+ *   Status of the first erase or write that failed, mscReturnOk if none.
+ *****************************************************************************/
+MSC_Status_TypeDef FLASHWR_Program(uint32_t *address,
+                                   const void *data,
+                                   uint32_t numBytes,
+                                   bool erase,
+                                   FLASHWR_Path_t path)
+{
+  MSC_Status_TypeDef status;
+
+  stats.bytes = numBytes;
+  stats.pages = 0;
+  stats.bytesPerMs = 0;
+
+  MSC_Init();
+  status = program(address, data, numBytes, erase, path);
+  MSC_Deinit();
+
+  if (stats.writeCycles > 0) {
+    stats.bytesPerMs = (uint32_t)(((uint64_t)numBytes * SystemCoreClockGet())
+                                  / ((uint64_t)stats.writeCycles * 1000));
+  }
+
+  return status;
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Timing of the last FLASHWR_Program()
+ *****************************************************************************/
+const FLASHWR_Stats_t *FLASHWR_GetStats(void)
+{
+  return &stats;
+}
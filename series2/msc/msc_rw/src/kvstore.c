@@ -0,0 +1,559 @@
+/***************************************************************************//**
+ * @file kvstore.c
+ * @brief Log structured key/value store in flash pages.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2021 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ *******************************************************************************
+ * # Evaluation Quality
+ * This code has been minimally tested to ensure that it builds and is suitable
+ * as a demonstration for evaluation purposes only. This code will be maintained
+ * at the sole discretion of Silicon Labs.
+ ******************************************************************************/
+
+#include <stddef.h>
+#include <string.h>
+
+#include "em_device.h"
+#include "em_msc.h"
+
+#include "kvstore.h"
+
+/*
+ * Each page starts with a header: PAGE_MAGIC and a sequence number that
+ * goes up by one for every page opened, so the pages can be put back in
+ * the order they were written. Records follow, back to back:
+ *
+ *   word 0   RECORD_MARK in bits 31:24, value length in bytes in 23:16,
+ *            key in 15:0. A length of 0 deletes the key.
+ *   word 1   CRC-32 of word 0 and the value, written last, so a record
+ *            cut short by a reset never passes the check
+ *   word 2.. value, padded with zeros to whole words
+ *
+ * The first erased word after the header ends the records of a page.
+ */
+#define PAGE_MAGIC          0x4B565331UL    // "KVS1"
+#define PAGE_HEADER_WORDS   2
+#define RECORD_MARK         0x5AUL
+#define RECORD_HEADER_WORDS 2
+#define ERASED              0xFFFFFFFFUL
+
+#define RECORD_WORDS(len)   (RECORD_HEADER_WORDS + (((len) + 3) / 4))
+#define MAX_RECORD_WORDS    RECORD_WORDS(KVS_MAX_VALUE)
+#define PAGE_WORDS          (FLASH_PAGE_SIZE / 4)
+
+// All the live records and one more must fit in a page after compaction
+#if (PAGE_HEADER_WORDS + ((KVS_MAX_KEYS + 1) * MAX_RECORD_WORDS)) > PAGE_WORDS
+#error "KVS_MAX_KEYS and KVS_MAX_VALUE do not fit in a flash page"
+#endif
+
+#define RECORD_KEY(word)    ((uint16_t)((word) & 0xFFFF))
+#define RECORD_LENGTH(word) (((word) >> 16) & 0xFF)
+#define RECORD_MARKED(word) (((word) >> 24) == RECORD_MARK)
+
+// RAM index, the newest record of every key that has a value
+typedef struct {
+  uint16_t key;
+  const uint32_t *record;
+} Entry_t;
+
+static Entry_t entries[KVS_MAX_KEYS];
+static uint32_t entryCount;
+
+static uint32_t *pages;
+static uint32_t pageTotal;
+
+// Page and next free word written to, and the sequence number of the page
+static uint32_t headPage;
+static uint32_t *writePtr;
+static uint32_t headSeq;
+
+static uint32_t eraseCount;
+
+/**************************************************************************//**
+ * @brief
+ *   CRC-32 (IEEE 802.3, reflected) over whole words, 4 bits at a time
+ *****************************************************************************/
+static uint32_t crcWords(uint32_t crc, const uint32_t *words, uint32_t count)
+{
+  static const uint32_t table[16] = {
+    0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC,
+    0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+    0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C,
+    0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C,
+  };
+  uint32_t word;
+
+  while (count--) {
+    word = *words++;
+    for (uint32_t i = 0; i < 8; i++) {
+      crc = (crc >> 4) ^ table[(crc ^ word) & 0xF];
+      word >>= 4;
+    }
+  }
+
+  return crc;
+}
+
+/**************************************************************************//**
+ * @brief
+ *   CRC of a record as stored in its word 1
+ *****************************************************************************/
+static uint32_t recordCrc(const uint32_t *record)
+{
+  uint32_t crc;
+
+  crc = crcWords(ERASED, record, 1);
+  crc = crcWords(crc,
+                 record + RECORD_HEADER_WORDS,
+                 RECORD_WORDS(RECORD_LENGTH(record[0])) - RECORD_HEADER_WORDS);
+
+  return ~crc;
+}
+
+static uint32_t *pageStart(uint32_t page)
+{
+  return pages + (page * PAGE_WORDS);
+}
+
+static bool pageValid(uint32_t page)
+{
+  return pageStart(page)[0] == PAGE_MAGIC;
+}
+
+static bool pageErased(uint32_t page)
+{
+  const uint32_t *p = pageStart(page);
+
+  for (uint32_t i = 0; i < PAGE_WORDS; i++) {
+    if (p[i] != ERASED) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Next record of a page, or NULL after the last one
+ *
+ * @details
+ *   A word that is not a record header, or a record that runs past the
+ *   end of the page, can only be a header cut short by a reset. Nothing
+ *   after it can be trusted, so the page is treated as full from there.
+ *****************************************************************************/
+static const uint32_t *nextRecord(uint32_t page,
+                                  const uint32_t *record,
+                                  const uint32_t **end)
+{
+  const uint32_t *limit = pageStart(page) + PAGE_WORDS;
+
+  if (record == NULL) {
+    record = pageStart(page) + PAGE_HEADER_WORDS;
+  } else {
+    record += RECORD_WORDS(RECORD_LENGTH(record[0]));
+  }
+
+  *end = record;
+  if ((record >= limit) || (record[0] == ERASED)) {
+    return NULL;
+  }
+  if (!RECORD_MARKED(record[0])
+      || ((record + RECORD_WORDS(RECORD_LENGTH(record[0]))) > limit)) {
+    *end = limit;
+    return NULL;
+  }
+
+  return record;
+}
+
+static Entry_t *findEntry(uint16_t key)
+{
+  for (uint32_t i = 0; i < entryCount; i++) {
+    if (entries[i].key == key) {
+      return &entries[i];
+    }
+  }
+
+  return NULL;
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Put a record into the index, the newest record of a key wins
+ *****************************************************************************/
+static void indexRecord(const uint32_t *record)
+{
+  uint16_t key = RECORD_KEY(record[0]);
+  Entry_t *entry = findEntry(key);
+
+  if (RECORD_LENGTH(record[0]) == 0) {
+    // Deleted, move the last entry into its place
+    if (entry != NULL) {
+      *entry = entries[--entryCount];
+    }
+  } else if (entry != NULL) {
+    entry->record = record;
+  } else if (entryCount < KVS_MAX_KEYS) {
+    entries[entryCount].key = key;
+    entries[entryCount].record = record;
+    entryCount++;
+  }
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Append a record to the head page, header, value, then CRC
+ *****************************************************************************/
+static bool appendRecord(uint32_t header, const uint32_t *value)
+{
+  uint32_t *record = writePtr;
+  uint32_t words = RECORD_WORDS(RECORD_LENGTH(header)) - RECORD_HEADER_WORDS;
+  uint32_t crc;
+  bool ok;
+
+  // Only after a reset in the middle of a compaction can this happen
+  if ((record + RECORD_HEADER_WORDS + words)
+      > (pageStart(headPage) + PAGE_WORDS)) {
+    return false;
+  }
+
+  MSC_Init();
+  ok = (MSC_WriteWord(record, &header, 4) == mscReturnOk);
+  if (ok && (words > 0)) {
+    ok = (MSC_WriteWord(record + RECORD_HEADER_WORDS, value, words * 4)
+          == mscReturnOk);
+  }
+  if (ok) {
+    crc = recordCrc(record);
+    ok = (MSC_WriteWord(record + 1, &crc, 4) == mscReturnOk);
+  }
+  MSC_Deinit();
+
+  // Skip a failed record too, the words may be partly written
+  writePtr += RECORD_HEADER_WORDS + words;
+
+  if (ok) {
+    indexRecord(record);
+  }
+
+  return ok;
+}
+
+static bool erasePage(uint32_t page)
+{
+  MSC_Status_TypeDef status;
+
+  MSC_Init();
+  status = MSC_ErasePage(pageStart(page));
+  MSC_Deinit();
+  eraseCount++;
+
+  return status == mscReturnOk;
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Copy the live records of a page to the head page and erase it
+ *
+ * @details
+ *   A record is live if the index points at it. A reset part way leaves
+ *   both copies, and the copy in the head page wins at the next
+ *   KVS_Init() because its page is newer.
+ *****************************************************************************/
+static bool compactPage(uint32_t page)
+{
+  const uint32_t *record = NULL;
+  const uint32_t *end;
+  Entry_t *entry;
+
+  while ((record = nextRecord(page, record, &end)) != NULL) {
+    entry = findEntry(RECORD_KEY(record[0]));
+    if ((entry != NULL) && (entry->record == record)) {
+      if (!appendRecord(record[0], record + RECORD_HEADER_WORDS)) {
+        return false;
+      }
+    }
+  }
+
+  return erasePage(page);
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Open the next page for writing and free the page after it
+ *
+ * @details
+ *   The page after the head page is kept erased. Opening it as the new
+ *   head moves the oldest page in front of it, where its live records
+ *   are copied to the new head before it is erased. With two pages, the
+ *   oldest page is the one just filled.
+ *****************************************************************************/
+static bool openNextPage(void)
+{
+  uint32_t header[PAGE_HEADER_WORDS];
+  uint32_t oldest;
+  bool ok;
+
+  headPage = (headPage + 1) % pageTotal;
+  headSeq++;
+  header[0] = PAGE_MAGIC;
+  header[1] = headSeq;
+
+  MSC_Init();
+  ok = (MSC_WriteWord(pageStart(headPage), header, sizeof(header))
+        == mscReturnOk);
+  MSC_Deinit();
+  writePtr = pageStart(headPage) + PAGE_HEADER_WORDS;
+
+  oldest = (headPage + 1) % pageTotal;
+  if (ok && !pageErased(oldest)) {
+    ok = compactPage(oldest);
+  }
+
+  return ok;
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Start the store and build the RAM index from the flash pages
+ *
+ * @details
+ *   The pages are read in the order they were written and every record
+ *   with a good CRC goes into the index, the newest one of each key
+ *   winning. Pages without a valid header are erased. If a reset stopped
+ *   a compaction, the page after the newest one is not erased yet and
+ *   the compaction is done again. Call with the MSC clock on.
+ *
+ * @param[in] base
+ *   First of the pages, on a page boundary, in main flash. They are
+ *   used by the store only.
+ *
+ * @param[in] pageCount
+ *   Pages in the store, 2 to KVS_MAX_PAGES. The values of all the keys
+ *   always fit in one page, the others spread the erases.
+ *
+ * @return
+ *   kvsOk, or why the store could not be started.
+ *****************************************************************************/
+KVS_Status_t KVS_Init(uint32_t *base, uint32_t pageCount)
+{
+  const uint32_t *record;
+  const uint32_t *end;
+  uint32_t order[KVS_MAX_PAGES];
+  uint32_t valid = 0;
+  uint32_t page;
+  uint32_t i;
+  uint32_t j;
+
+  if ((pageCount < 2) || (pageCount > KVS_MAX_PAGES)
+      || (((uint32_t)base % FLASH_PAGE_SIZE) != 0)) {
+    return kvsErrConfig;
+  }
+
+  pages = base;
+  pageTotal = pageCount;
+  entryCount = 0;
+  eraseCount = 0;
+
+  // Valid pages in sequence order, anything else is erased
+  for (page = 0; page < pageTotal; page++) {
+    if (pageValid(page)) {
+      for (i = valid; (i > 0) && (pageStart(order[i - 1])[1]
+                                  > pageStart(page)[1]); i--) {
+        order[i] = order[i - 1];
+      }
+      order[i] = page;
+      valid++;
+    } else if (!pageErased(page)) {
+      if (!erasePage(page)) {
+        return kvsErrFlash;
+      }
+    }
+  }
+
+  if (valid == 0) {
+    // New store, page 0 is opened first
+    headPage = pageTotal - 1;
+    headSeq = 0;
+    return openNextPage() ? kvsOk : kvsErrFlash;
+  }
+
+  for (j = 0; j < valid; j++) {
+    record = NULL;
+    while ((record = nextRecord(order[j], record, &end)) != NULL) {
+      if (record[1] == recordCrc(record)) {
+        indexRecord(record);
+      }
+    }
+  }
+
+  headPage = order[valid - 1];
+  headSeq = pageStart(headPage)[1];
+  writePtr = (uint32_t *)end;
+
+  page = (headPage + 1) % pageTotal;
+  if (!pageErased(page) && !compactPage(page)) {
+    return kvsErrFlash;
+  }
+
+  return kvsOk;
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Write a value, appended after the values already in flash
+ *
+ * @details
+ *   Only one record is programmed; a page is erased only when the head
+ *   page is full, after its live records have been moved on.
+ *
+ * @param[in] key
+ *   Any key but KVS_KEY_BLANK.
+ *
+ * @param[in] data
+ *   Value to store.
+ *
+ * @param[in] length
+ *   Bytes in the value, 1 to KVS_MAX_VALUE.
+ *
+ * @return
+ *   kvsOk, or why the value was not stored.
+ *****************************************************************************/
+KVS_Status_t KVS_Write(uint16_t key, const void *data, uint32_t length)
+{
+  uint32_t value[(KVS_MAX_VALUE + 3) / 4];
+  uint32_t header;
+
+  if (key == KVS_KEY_BLANK) {
+    return kvsErrKey;
+  }
+  if ((length == 0) || (length > KVS_MAX_VALUE)) {
+    return kvsErrLength;
+  }
+  if ((findEntry(key) == NULL) && (entryCount == KVS_MAX_KEYS)) {
+    return kvsErrFull;
+  }
+
+  value[(length - 1) / 4] = 0;
+  memcpy(value, data, length);
+  header = (RECORD_MARK << 24) | (length << 16) | key;
+
+  if ((writePtr + RECORD_WORDS(length)) > (pageStart(headPage) + PAGE_WORDS)) {
+    if (!openNextPage()) {
+      return kvsErrFlash;
+    }
+  }
+
+  return appendRecord(header, value) ? kvsOk : kvsErrFlash;
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Read a value straight from flash through the RAM index
+ *
+ * @param[in] key
+ *   Key to look up.
+ *
+ * @param[out] data
+ *   Buffer for the value.
+ *
+ * @param[in] size
+ *   Bytes in the buffer, a longer value is cut short.
+ *
+ * @param[out] length
+ *   Bytes in the stored value, may be NULL.
+ *
+ * @return
+ *   kvsOk or kvsErrNotFound.
+ *****************************************************************************/
+KVS_Status_t KVS_Read(uint16_t key,
+                      void *data,
+                      uint32_t size,
+                      uint32_t *length)
+{
+  Entry_t *entry = findEntry(key);
+  uint32_t stored;
+
+  if (entry == NULL) {
+    return kvsErrNotFound;
+  }
+
+  stored = RECORD_LENGTH(entry->record[0]);
+  memcpy(data, entry->record + RECORD_HEADER_WORDS,
+         (stored < size) ? stored : size);
+  if (length != NULL) {
+    *length = stored;
+  }
+
+  return kvsOk;
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Delete a key, by appending an empty record for it
+ *****************************************************************************/
+KVS_Status_t KVS_Delete(uint16_t key)
+{
+  if (findEntry(key) == NULL) {
+    return kvsErrNotFound;
+  }
+
+  if ((writePtr + RECORD_HEADER_WORDS) > (pageStart(headPage) + PAGE_WORDS)) {
+    if (!openNextPage()) {
+      return kvsErrFlash;
+    }
+  }
+
+  return appendRecord((RECORD_MARK << 24) | key, NULL) ? kvsOk : kvsErrFlash;
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Number of keys with a value
+ *****************************************************************************/
+uint32_t KVS_GetKeyCount(void)
+{
+  return entryCount;
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Bytes left in the head page before the next page erase
+ *****************************************************************************/
+uint32_t KVS_GetFreeSpace(void)
+{
+  return (uint32_t)((pageStart(headPage) + PAGE_WORDS) - writePtr) * 4;
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Number of page erases since KVS_Init()
+ *****************************************************************************/
+uint32_t KVS_GetEraseCount(void)
+{
+  return eraseCount;
+}
@@ -1,8 +1,10 @@
 /***************************************************************************//**
  * @file main_xG22.c
- * @brief This project demonstrates the use of the userdata page of the flash
- * memory. The value 32 is stored in the 4th byte of the page. A variable is
- * then set to the value stored at this location.
+ * @brief This project demonstrates a log structured key/value store in flash.
+ * The value 32 and a reset count are appended to the store as records, and
+ * variables are then set to the values read back from it. A 4 kB buffer is
+ * then programmed by the CPU and by the LDMA to compare the write rates, and
+ * a burst of events is appended to a circular event log in flash.
  *******************************************************************************
  * # License
  * <b>Copyright 2020 Silicon Laboratories Inc. www.silabs.com</b>
@@ -39,12 +41,119 @@
 #include "em_chip.h"
 #include "em_cmu.h"
 #include "em_msc.h"
-#include "em_cmu.h"
 
-#define USERDATA ((uint32_t*)USERDATA_BASE)
+#include "flashlog.h"
+#include "flashwr.h"
+#include "kvstore.h"
+
+// Store in the last pages of main flash, out of the way of the code
+#define KVS_PAGES         2
+#define KVS_BASE          ((uint32_t *)(FLASH_BASE + FLASH_SIZE \
+                                        - (KVS_PAGES * FLASH_PAGE_SIZE)))
+
+// Page below the store, erased and programmed by the write benchmark
+#define BENCH_BASE        (KVS_BASE - (FLASH_PAGE_SIZE / 4))
+#define BENCH_BYTES       4096
+
+// Event log in the pages below the benchmark page
+#define LOG_PAGES         3
+#define LOG_BASE          (BENCH_BASE - (LOG_PAGES * FLASH_PAGE_SIZE / 4))
 
-uint32_t Cleared_value;
+// Events appended after each reset, more than a page of records
+#define LOG_BURST         1000
+
+// Event numbers in the log
+#define EVENT_BOOT        1
+#define EVENT_BURST       2
+
+// Keys of the values kept in the store
+#define KEY_BOOT_COUNT    1
+#define KEY_VALUE         3
+
+KVS_Status_t Init_status;
+uint32_t Boot_count;
 uint32_t Set_value;
+uint32_t Erase_count;
+
+// Batched write timing, programmed by the CPU and by the LDMA
+FLASHWR_Stats_t Cpu_stats;
+FLASHWR_Stats_t Dma_stats;
+uint32_t Bench_errors;
+
+// Event log: longest append in core clock cycles, counters, and the
+// records read back with the newest of them
+uint32_t Log_appendMaxCycles;
+FLASHLOG_Counters_TypeDef Log_counters;
+uint32_t Log_records;
+FLASHLOG_Record_TypeDef Log_newest;
+
+static uint32_t benchData[BENCH_BYTES / 4];
+
+/**************************************************************************//**
+ * @brief
+ *   Program a 4 kB buffer by each path and keep the timing
+ *****************************************************************************/
+static void benchmarkWrites(void)
+{
+  uint32_t i;
+
+  for (i = 0; i < BENCH_BYTES / 4; i++) {
+    benchData[i] = i * 0x9E3779B9UL;
+  }
+
+  FLASHWR_Init();
+  Bench_errors = 0;
+
+  FLASHWR_Program(BENCH_BASE, benchData, BENCH_BYTES, true, flashwrCpu);
+  Cpu_stats = *FLASHWR_GetStats();
+  for (i = 0; i < BENCH_BYTES / 4; i++) {
+    Bench_errors += (BENCH_BASE[i] != benchData[i]);
+  }
+
+  FLASHWR_Program(BENCH_BASE, benchData, BENCH_BYTES, true, flashwrDma);
+  Dma_stats = *FLASHWR_GetStats();
+  for (i = 0; i < BENCH_BYTES / 4; i++) {
+    Bench_errors += (BENCH_BASE[i] != benchData[i]);
+  }
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Append a burst of events to the flash log and read it back
+ *****************************************************************************/
+static void logEvents(void)
+{
+  FLASHLOG_Init_TypeDef init = { LOG_BASE, LOG_PAGES };
+  FLASHLOG_Cursor_TypeDef cursor;
+  FLASHLOG_Record_TypeDef record;
+  uint32_t i, start, cycles;
+
+  // Goes on after the newest record written before the reset
+  FLASHLOG_Init(&init);
+  FLASHLOG_Append(EVENT_BOOT, DWT->CYCCNT, Boot_count);
+
+  // Appends only copy to RAM; the batches are written in between
+  Log_appendMaxCycles = 0;
+  for (i = 0; i < LOG_BURST; i++) {
+    start = DWT->CYCCNT;
+    FLASHLOG_Append(EVENT_BURST, start, i);
+    cycles = DWT->CYCCNT - start;
+    if (cycles > Log_appendMaxCycles) {
+      Log_appendMaxCycles = cycles;
+    }
+    FLASHLOG_Service();
+  }
+  FLASHLOG_Flush();
+  FLASHLOG_GetCounters(&Log_counters);
+
+  // Read the log back, oldest first
+  Log_records = 0;
+  FLASHLOG_Rewind(&cursor);
+  while (FLASHLOG_Next(&cursor, &record)) {
+    Log_records++;
+    Log_newest = record;
+  }
+}
 
 /**************************************************************************//**
  * @brief  Main function
@@ -60,19 +169,31 @@ int main(void)
   // Enable MSC Clock
   CMU_ClockEnable(cmuClock_MSC, true);
 
-  // Clear the Userdata page of any previous data stored
-  MSC_ErasePage(USERDATA);
+  // Build the RAM index from the records already in the store
+  Init_status = KVS_Init(KVS_BASE, KVS_PAGES);
+
+  // Count the resets, a single appended record each time
+  if (KVS_Read(KEY_BOOT_COUNT, &Boot_count, sizeof(Boot_count), NULL)
+      != kvsOk) {
+    Boot_count = 0;
+  }
+  Boot_count++;
+  KVS_Write(KEY_BOOT_COUNT, &Boot_count, sizeof(Boot_count));
+
+  // Store the value under its key, no page erase needed
+  KVS_Write(KEY_VALUE, &value, sizeof(value));
+
+  // Read the value back through the index
+  KVS_Read(KEY_VALUE, &Set_value, sizeof(Set_value), NULL);
 
-  // Read the initial value in the cleared page
-  Cleared_value = USERDATA[3];
+  // Page erases, only when a page fills up
+  Erase_count = KVS_GetEraseCount();
 
-  // Write the value into the 4th word of the Userdata portion of the flash
-  MSC_Init();
-  MSC_WriteWord((USERDATA + 3), &value, 4);
-  MSC_Deinit();
+  // Time large buffer writes through the CPU and LDMA paths
+  benchmarkWrites();
 
-  // Read the written data from the flash location it was stored in
-  Set_value = USERDATA[3];
+  // Log a burst of events without waiting for page erases
+  logEvents();
 
   // Infinite Loop
   while(1);
@@ -0,0 +1,69 @@
+/***************************************************************************//**
+ * @file pulseacc.h
+ *
+ * @brief PCNT pulse accumulator, extended to 64 bits at each report.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2021 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ******************************************************************************/
+
+
+#ifndef PULSEACC_H
+#define PULSEACC_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Most pulses between two reports. The PCNT wraps at 16 bits and the
+// accumulator takes the change of the counter modulo 65536.
+#define PULSEACC_MAX_PULSES   65535
+
+/*
+ * Accumulator state at the last report. The total counts every pulse
+ * since PULSEACC_Init(). The overruns are reports after which the counter
+ * had wrapped all the way around, more than PULSEACC_MAX_PULSES pulses
+ * since the report before, so the total is short by a multiple of 65536.
+ */
+typedef struct {
+  uint64_t total;
+  uint32_t pulses;
+  uint32_t peak;
+  uint32_t reports;
+  uint32_t overruns;
+} PULSEACC_Report_t;
+
+void PULSEACC_Init(void);
+uint32_t PULSEACC_Update(void);
+void PULSEACC_GetReport(PULSEACC_Report_t *report);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // PULSEACC_H
@@ -0,0 +1,301 @@
+/***************************************************************************//**
+ * @file main.c
+ * @brief This project counts pulses with PCNT0 in EM2 and extends the
+ * 16-bit counter to 64 bits, waking up only at each report.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2021 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ *******************************************************************************
+ * # Evaluation Quality
+ * This code has been minimally tested to ensure that it builds and is suitable 
+ * as a demonstration for evaluation purposes only. This code will be maintained
+ * at the sole discretion of Silicon Labs.
+ ******************************************************************************/
+
+
+#include "em_burtc.h"
+#include "em_chip.h"
+#include "em_cmu.h"
+#include "em_device.h"
+#include "em_emu.h"
+#include "em_gpio.h"
+#include "em_pcnt.h"
+#include "em_prs.h"
+#include "mx25flash_spi.h"
+#include "bsp.h"
+#include "pulseacc.h"
+
+// PRS channel to use for GPIO/PCNT
+#define PCNT_PRS_Ch0    0
+
+// LFRCO clocks between reports, one second
+#define REPORT_TICKS    32768
+
+/*
+ * This example enters EM2 in the infinite while loop; Setting this define to 1
+ * enables debug connectivity in the EMU_CTRL register, which will consume about
+ * 0.5uA additional supply current; comment this line of code to disable
+ */
+#define EM2DEBUG        1
+
+/*******************************************************************************
+ **************************   GLOBAL VARIABLES   *******************************
+ ******************************************************************************/
+
+// Set by the BURTC interrupt at each report
+static volatile bool reportDue = false;
+
+// Accumulator state at the last report: pulses since start, pulses in the
+// last report interval and the most in any, and the reports and overruns
+uint64_t totalPulses = 0;
+uint32_t lastPulses = 0;
+uint32_t peakPulses = 0;
+uint32_t reports = 0;
+uint32_t overruns = 0;
+
+/***************************************************************************//**
+ * @brief escapeHatch()
+ * When developing or debugging code that enters EM2 or
+ * lower, it's a good idea to have an "escape hatch" type
+ * mechanism, e.g. a way to pause the device so that a debugger can
+ * connect in order to erase flash, among other things.
+ *
+ * Before proceeding with this example, make sure PB0 is not pressed.
+ * If the PB0 pin is low, turn on LED0 and execute the breakpoint
+ * instruction to stop the processor in EM0 and allow a debug
+ * connection to be made.
+ ******************************************************************************/
+void escapeHatch(void)
+{
+  CMU_ClockEnable(cmuClock_GPIO, true);
+  GPIO_PinModeSet(BSP_GPIO_PB0_PORT, BSP_GPIO_PB0_PIN,
+                  gpioModeInputPullFilter, 1);
+  if (GPIO_PinInGet(BSP_GPIO_PB0_PORT, BSP_GPIO_PB0_PIN) == 0) {
+    GPIO_PinModeSet(BSP_GPIO_LED0_PORT, BSP_GPIO_LED0_PIN,
+                    gpioModePushPull, 1);
+    __BKPT(0);
+  }
+  // Pin not asserted, so disable input
+  else {
+    GPIO_PinModeSet(BSP_GPIO_PB0_PORT, BSP_GPIO_PB0_PIN,
+                    gpioModeDisabled, 0);
+    CMU_ClockEnable(cmuClock_GPIO, false);
+  }
+}
+
+/***************************************************************************//**
+ * @brief BURTC interrupt handler
+ *        This function folds the pulses since the last report into the
+ *        total; it is the only wakeup of the example
+ ******************************************************************************/
+void BURTC_IRQHandler(void)
+{
+  BURTC_IntClear(BURTC_IF_COMP);
+
+  PULSEACC_Update();
+  reportDue = true;
+}
+
+/***************************************************************************//**
+ * @brief Initialize PCNT0
+ *        This function initializes pulse counter 0 and sets up the
+ *        external single mode, wrapping at 16 bits with no interrupt
+ ******************************************************************************/
+static void initPcnt(void)
+{
+  PCNT_Init_TypeDef pcntInit = PCNT_INIT_DEFAULT;
+
+  CMU_ClockEnable(cmuClock_PCNT0, true);
+
+  pcntInit.mode     = pcntModeDisable;    // Initialize with PCNT disabled
+  pcntInit.top      = 0xFFFF;             // Wrap at 16 bits
+  pcntInit.s1CntDir = false;        // S1 does not affect counter direction,
+                                    // using default init setting; count up
+  pcntInit.s0PRS    = PCNT_PRS_Ch0;
+
+  // Enable PRS Channel 0
+  PCNT_PRSInputEnable(PCNT0, pcntPRSInputS0, true);
+
+  // Init PCNT0
+  PCNT_Init(PCNT0, &pcntInit);
+
+  // Set mode to externally clocked single input
+  PCNT_Enable(PCNT0, pcntModeExtSingle);
+
+  // Change to the external clock
+  CMU->PCNT0CLKCTRL = CMU_PCNT0CLKCTRL_CLKSEL_PCNTS0;
+
+  /*
+   * When the PCNT operates in externally clocked mode and switching external
+   * clock source, a few clock pulses are required on the external clock to
+   * synchronize accesses to the externally clocked domain. Generate them
+   * with the PRS software pulse triggering mechanism, see the
+   * pcnt_extclk_single_overflow example. The accumulator starts from the
+   * count left afterwards.
+   */
+  while (PCNT0->SYNCBUSY) {
+    PRS_PulseTrigger(1 << PCNT_PRS_Ch0);
+  }
+
+  /*
+   * The overflow interrupt stays disabled: the overflow flag is only read
+   * back at the next report, so a wrap of the counter does not wake the
+   * device up.
+   */
+}
+
+/***************************************************************************//**
+ * @brief Initialize PRS
+ *        This function sets up GPIO PRS which links BTN0 to PCNT0 PRS0
+ ******************************************************************************/
+static void initPrs(void)
+{
+  CMU_ClockEnable(cmuClock_PRS, true);
+
+  // Set up GPIO PRS
+  PRS_SourceAsyncSignalSet(PCNT_PRS_Ch0, PRS_ASYNC_CH_CTRL_SOURCESEL_GPIO,
+                           BSP_GPIO_PB0_PIN);
+}
+
+/***************************************************************************//**
+ * @brief Initialize GPIO
+ *        This function initializes push button PB0 and enables external
+ *        interrupt for PRS functionality
+ ******************************************************************************/
+static void initGpio(void)
+{
+  CMU_ClockEnable(cmuClock_GPIO, true);
+
+  // Initialize LED driver
+  GPIO_PinModeSet(BSP_GPIO_LED0_PORT, BSP_GPIO_LED0_PIN, gpioModePushPull, 0);
+
+  // Configure pin I/O - BTN0
+  GPIO_PinModeSet(BSP_GPIO_PB0_PORT, BSP_GPIO_PB0_PIN, gpioModeInput, 1);
+
+  // Configure BTN0 for external interrupt
+  GPIO_ExtIntConfig(BSP_GPIO_PB0_PORT, BSP_GPIO_PB0_PIN, BSP_GPIO_PB0_PIN,
+                    false, false, false);
+}
+
+/***************************************************************************//**
+ * @brief Initialize BURTC
+ *        This function sets up the BURTC to interrupt every REPORT_TICKS
+ *        LFRCO clocks
+ ******************************************************************************/
+static void initBurtc(void)
+{
+  BURTC_Init_TypeDef burtcInit = BURTC_INIT_DEFAULT;
+
+  CMU_ClockSelectSet(cmuClock_EM4GRPACLK, cmuSelect_LFRCO);
+  CMU_ClockEnable(cmuClock_BURTC, true);
+
+  burtcInit.compare0Top = true; // reset counter when counter reaches compare value
+  BURTC_Init(&burtcInit);
+
+  BURTC_CounterReset();
+  BURTC_CompareSet(0, REPORT_TICKS - 1);
+
+  BURTC_IntEnable(BURTC_IEN_COMP);
+  NVIC_ClearPendingIRQ(BURTC_IRQn);
+  NVIC_EnableIRQ(BURTC_IRQn);
+  BURTC_Enable(true);
+}
+
+/***************************************************************************//**
+ * @brief  Main function
+ ******************************************************************************/
+int main(void)
+{
+  FlashStatus status;
+  PULSEACC_Report_t report;
+
+  CHIP_Init();
+
+  // Recommended recovery procedure for code in development
+  escapeHatch();
+
+  // Select FSRCO for SYSCLK; FSRCO is default out of reset
+  CMU_ClockSelectSet(cmuClock_SYSCLK, cmuSelect_FSRCO);
+
+  // Turn on DCDC regulator
+  EMU_DCDCInit_TypeDef dcdcInit = EMU_DCDCINIT_WSTK_DEFAULT;
+  EMU_DCDCInit(&dcdcInit);
+
+  // Enable voltage downscaling in EM2/3 (VSCALE0)
+  EMU_EM23Init_TypeDef em23Init = EMU_EM23INIT_DEFAULT;
+  em23Init.vScaleEM23Voltage = emuVScaleEM23_LowPower;
+
+  // Initialize EM mode 2/3
+  EMU_EM23Init(&em23Init);
+
+  // Use LFRCO as clock for EM23GRPACLK and PCNT
+  CMU_ClockSelectSet(cmuClock_EM23GRPACLK, cmuSelect_LFRCO);
+
+#ifdef EM2DEBUG
+  // Enable debug connectivity in EM2
+  EMU->CTRL_SET = EMU_CTRL_EM2DBGEN;
+#endif
+
+  // Initialize GPIO
+  initGpio();
+
+  // Initialize and power-down MX25 SPI flash
+  MX25_init();
+  MX25_RSTEN();
+  MX25_RST(&status);
+  MX25_DP();
+  MX25_deinit();
+
+  // PRS Initialization
+  initPrs();
+
+  // PCNT Initialization
+  initPcnt();
+
+  // Accumulate from now, then report every REPORT_TICKS
+  PULSEACC_Init();
+  initBurtc();
+
+  // Enter EM2 forever, waking up only to report
+  while (true) {
+    EMU_EnterEM2(true);
+
+    if (reportDue) {
+      reportDue = false;
+
+      PULSEACC_GetReport(&report);
+      totalPulses = report.total;
+      lastPulses = report.pulses;
+      peakPulses = report.peak;
+      reports = report.reports;
+      overruns = report.overruns;
+
+      // Show a report with pulses in it
+      if (report.pulses) {
+        GPIO_PinOutToggle(BSP_GPIO_LED0_PORT, BSP_GPIO_LED0_PIN);
+      }
+    }
+  }
+}
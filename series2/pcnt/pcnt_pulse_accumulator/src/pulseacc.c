@@ -0,0 +1,147 @@
+/***************************************************************************//**
+ * @file pulseacc.c
+ *
+ * @brief PCNT pulse accumulator, extended to 64 bits at each report.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2021 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ *******************************************************************************
+ * # Evaluation Quality
+ * This code has been minimally tested to ensure that it builds and is suitable 
+ * as a demonstration for evaluation purposes only. This code will be maintained
+ * at the sole discretion of Silicon Labs.
+ ******************************************************************************/
+
+#include "em_device.h"
+#include "em_core.h"
+#include "em_pcnt.h"
+
+#include "pulseacc.h"
+
+// Counter value taken into the total at the last report
+static uint16_t lastCount;
+
+static PULSEACC_Report_t latest;
+
+/**************************************************************************//**
+ * @brief
+ *   Start accumulating the pulses counted by PCNT0
+ *
+ * @details
+ *   PCNT0 is set up by the caller, counting up with a top value of 0xFFFF
+ *   so the counter wraps at 16 bits, and with its overflow interrupt left
+ *   disabled. The counter is the first stage of the count and runs on its
+ *   own in EM2 and EM3. The overflow flag is the second: it is set by the
+ *   hardware at each wrap and only read back at the next report. The
+ *   64-bit total in RAM is the last, updated by PULSEACC_Update() at each
+ *   report, so the CPU never wakes up for the pulses themselves.
+ *****************************************************************************/
+void PULSEACC_Init(void)
+{
+  CORE_DECLARE_IRQ_STATE;
+
+  CORE_ENTER_CRITICAL();
+  lastCount = (uint16_t)PCNT_CounterGet(PCNT0);
+  PCNT_IntClear(PCNT0, PCNT_IF_OF);
+  latest.total = 0;
+  latest.pulses = 0;
+  latest.peak = 0;
+  latest.reports = 0;
+  latest.overruns = 0;
+  CORE_EXIT_CRITICAL();
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Fold the pulses since the last report into the total
+ *
+ * @details
+ *   Called at each report, from the report timer interrupt or from the
+ *   main loop. The change of the counter modulo 65536 is exact as long as
+ *   at most PULSEACC_MAX_PULSES pulses arrived since the last report.
+ *
+ *   The overflow flag tells a wrap from none: a wrap that left the counter
+ *   at or above its last value means it went all the way around, and more
+ *   pulses arrived than the change shows, an overrun. A wrap can come
+ *   while the counter is read: when the flag is only set after the read,
+ *   the counter is read again, so the count always follows the wrap. The
+ *   flag is cleared far less than 65536 pulses after it is read.
+ *
+ * @return
+ *   The pulses since the last report.
+ *****************************************************************************/
+uint32_t PULSEACC_Update(void)
+{
+  CORE_DECLARE_IRQ_STATE;
+  uint16_t count;
+  uint16_t pulses;
+  bool wrapped;
+
+  CORE_ENTER_CRITICAL();
+
+  wrapped = (PCNT_IntGet(PCNT0) & PCNT_IF_OF) != 0;
+  count = (uint16_t)PCNT_CounterGet(PCNT0);
+  if (!wrapped && (PCNT_IntGet(PCNT0) & PCNT_IF_OF)) {
+    wrapped = true;
+    count = (uint16_t)PCNT_CounterGet(PCNT0);
+  }
+  if (wrapped) {
+    PCNT_IntClear(PCNT0, PCNT_IF_OF);
+  }
+
+  pulses = (uint16_t)(count - lastCount);
+  if (wrapped && (count >= lastCount)) {
+    latest.overruns++;
+  }
+  lastCount = count;
+
+  latest.total += pulses;
+  latest.pulses = pulses;
+  if (pulses > latest.peak) {
+    latest.peak = pulses;
+  }
+  latest.reports++;
+
+  CORE_EXIT_CRITICAL();
+
+  return pulses;
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Get the state of the accumulator at the last report
+ *
+ * @param[out] report
+ *   Total, pulses and peak pulses between two reports, reports and
+ *   overruns.
+ *****************************************************************************/
+void PULSEACC_GetReport(PULSEACC_Report_t *report)
+{
+  CORE_DECLARE_IRQ_STATE;
+
+  CORE_ENTER_CRITICAL();
+  *report = latest;
+  CORE_EXIT_CRITICAL();
+}
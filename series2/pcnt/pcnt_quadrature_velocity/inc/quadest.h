@@ -0,0 +1,85 @@
+/***************************************************************************//**
+ * @file quadest.h
+ *
+ * @brief PCNT position and velocity estimator, sampled by LETIMER and LDMA.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2021 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ******************************************************************************/
+
+#ifndef QUADEST_H
+#define QUADEST_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// LDMA channel that samples the counter, and the PRS channel that carries
+// the LETIMER sample pulse to it. PRS channels 0 and 1 feed the PCNT.
+#define QEST_LDMA_CHANNEL     0
+#define QEST_PRS_CHANNEL      2
+
+// Counter samples per second, a divisor of the 32768 Hz LETIMER clock
+#ifndef QEST_SAMPLE_RATE
+#define QEST_SAMPLE_RATE      1024
+#endif
+
+// Largest ring, two descriptors of at most 2048 samples each
+#define QEST_MAX_RING         4096
+
+// Batches in the median of the velocity, odd
+#ifndef QEST_MEDIAN_LENGTH
+#define QEST_MEDIAN_LENGTH    5
+#endif
+
+/*
+ * Counter state at the end of a batch of samples. The position is in
+ * counts since QEST_Init(), extended past the 16 bit counter. The velocity
+ * is the least squares slope of the positions in the batch, in counts per
+ * second; it is the speed in the middle of the batch. The smoothed velocity
+ * is the median of the last QEST_MEDIAN_LENGTH velocities, which drops a
+ * batch off on its own, such as one slope across a bounce of the inputs,
+ * and lags by QEST_MEDIAN_LENGTH / 2 batches.
+ */
+typedef struct {
+  int32_t position;
+  int32_t velocity;
+  int32_t smoothed;
+  uint32_t batches;
+} QEST_Estimate_t;
+
+bool QEST_Init(uint32_t *ring, uint32_t size);
+void QEST_Stop(void);
+bool QEST_GetEstimate(QEST_Estimate_t *estimate);
+uint32_t QEST_GetOverrunCount(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // QUADEST_H
@@ -0,0 +1,267 @@
+/***************************************************************************//**
+ * @file quadest.c
+ *
+ * @brief PCNT position and velocity estimator, sampled by LETIMER and LDMA.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2021 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ *******************************************************************************
+ * # Evaluation Quality
+ * This code has been minimally tested to ensure that it builds and is suitable 
+ * as a demonstration for evaluation purposes only. This code will be maintained
+ * at the sole discretion of Silicon Labs.
+ ******************************************************************************/
+
+#include "em_device.h"
+#include "em_cmu.h"
+#include "em_core.h"
+#include "em_ldma.h"
+#include "em_letimer.h"
+#include "em_prs.h"
+
+#include "fixmath.h"
+#include "quadest.h"
+
+// The LETIMER pulse reaches the LDMA through the PRS request 0 input
+#define SAMPLE_SIGNAL       (LDMAXBAR_CH_REQSEL_SIGSEL_LDMAXBARPRSREQ0 \
+                             | LDMAXBAR_CH_REQSEL_SOURCESEL_LDMAXBAR)
+
+#define HALF_DONE           (1 << QEST_LDMA_CHANNEL)
+
+// Ring halves, descriptor 0 fills the first and links to descriptor 1
+static LDMA_Descriptor_t descriptors[2];
+
+static uint32_t *ringStart;
+static uint32_t halfSize;
+
+// Half delivered last, so a missed interrupt can be noticed
+static uint32_t lastHalf;
+static volatile uint32_t overrunCount;
+
+// Counter value of the last sample taken into the position
+static uint16_t lastCount;
+static int32_t position;
+
+// The velocities of the last batches, for the median
+static FIXMATH_Median_t velocityMedian;
+static int32_t medianRing[QEST_MEDIAN_LENGTH];
+static int32_t medianSorted[QEST_MEDIAN_LENGTH];
+
+static QEST_Estimate_t latest;
+static volatile bool haveEstimate;
+
+/**************************************************************************//**
+ * @brief
+ *   Fold a half of the ring into the position and estimate the velocity
+ *
+ * @details
+ *   The counter wraps at 16 bits, so the change between samples is its
+ *   difference as a signed 16 bit number. That holds up to 32767 counts
+ *   between samples, also across a half that was overwritten.
+ *
+ *   With t = 0..n-1 and p the position at each sample, the least squares
+ *   slope is (n * sum(t * p) - sum(t) * sum(p)) / (n * sum(t^2) - sum(t)^2)
+ *   counts per sample. Only the positions relative to the first sample of
+ *   the half are summed, which keeps the sums small.
+ *****************************************************************************/
+static void processHalf(const uint32_t *samples, uint32_t n)
+{
+  int64_t sumTP = 0;
+  int64_t sumP = 0;
+  int64_t sumT = ((int64_t)n * (n - 1)) / 2;
+  int64_t sumTT = ((int64_t)n * (n - 1) * (2 * n - 1)) / 6;
+  int64_t num, den;
+  int32_t start = 0;
+  int32_t rel;
+  uint16_t count;
+
+  for (uint32_t t = 0; t < n; t++) {
+    count = (uint16_t)samples[t];
+    position += (int16_t)(count - lastCount);
+    lastCount = count;
+
+    if (t == 0) {
+      start = position;
+    }
+    rel = position - start;
+    sumP += rel;
+    sumTP += (int64_t)t * rel;
+  }
+
+  num = ((int64_t)n * sumTP) - (sumT * sumP);
+  den = ((int64_t)n * sumTT) - (sumT * sumT);
+
+  // Scaled in two steps, num * QEST_SAMPLE_RATE can overflow for big rings
+  latest.position = position;
+  latest.velocity = (int32_t)(((num / den) * QEST_SAMPLE_RATE)
+                              + (((num % den) * QEST_SAMPLE_RATE) / den));
+  latest.smoothed = FIXMATH_MedianAdd(&velocityMedian, latest.velocity);
+  latest.batches++;
+  haveEstimate = true;
+}
+
+/**************************************************************************//**
+ * @brief  LDMA Handler
+ *****************************************************************************/
+void LDMA_IRQHandler(void)
+{
+  uint32_t pending = LDMA_IntGetEnabled();
+  uint32_t half;
+
+  // Loop here to enable the debugger to see what has happened
+  if (pending & LDMA_IF_ERROR) {
+    __BKPT(0);
+  }
+
+  LDMA_IntClear(HALF_DONE);
+
+  /*
+   * The LDMA has already loaded the next descriptor, so the half it is
+   * writing now tells which one is complete. If it is the same as last
+   * time, a whole half was overwritten before it could be processed.
+   */
+  if (LDMA->CH[QEST_LDMA_CHANNEL].DST < (uint32_t)(ringStart + halfSize)) {
+    half = 1;
+  } else {
+    half = 0;
+  }
+
+  if (half == lastHalf) {
+    overrunCount++;
+  }
+  lastHalf = half;
+
+  processHalf(ringStart + (half * halfSize), halfSize);
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Start sampling PCNT0->CNT into the ring
+ *
+ * @details
+ *   PCNT0 is set up by the caller, with a top value of 0xFFFF so the
+ *   counter wraps at 16 bits. LETIMER0 pulses QEST_SAMPLE_RATE times per
+ *   second on QEST_PRS_CHANNEL and the LDMA copies the counter on each
+ *   pulse, all without waking the CPU. It wakes once per half of the ring
+ *   to update the estimate.
+ *
+ * @param[in] ring
+ *   Ring buffer, word aligned.
+ *
+ * @param[in] size
+ *   Ring size in samples, even, at least 4 and at most QEST_MAX_RING.
+ *
+ * @return
+ *   false if size is out of range.
+ *****************************************************************************/
+bool QEST_Init(uint32_t *ring, uint32_t size)
+{
+  LDMA_Init_t init = LDMA_INIT_DEFAULT;
+  LDMA_TransferCfg_t transferCfg = LDMA_TRANSFER_CFG_PERIPHERAL(SAMPLE_SIGNAL);
+  LETIMER_Init_TypeDef letimerInit = LETIMER_INIT_DEFAULT;
+
+  if ((size < 4) || (size % 2) || (size > QEST_MAX_RING)) {
+    return false;
+  }
+
+  ringStart = ring;
+  halfSize = size / 2;
+  lastHalf = 1;
+  overrunCount = 0;
+  lastCount = (uint16_t)PCNT0->CNT;
+  position = 0;
+  latest.batches = 0;
+  haveEstimate = false;
+  FIXMATH_MedianInit(&velocityMedian, medianRing, medianSorted,
+                     QEST_MEDIAN_LENGTH);
+
+  LDMA_Init(&init);
+
+  descriptors[0] = (LDMA_Descriptor_t)
+    LDMA_DESCRIPTOR_LINKREL_P2M_WORD(&(PCNT0->CNT), ring, halfSize, 1);
+  descriptors[1] = (LDMA_Descriptor_t)
+    LDMA_DESCRIPTOR_LINKREL_P2M_WORD(&(PCNT0->CNT), ring + halfSize, halfSize, -1);
+  descriptors[0].xfer.doneIfs = 1;
+  descriptors[1].xfer.doneIfs = 1;
+
+  LDMA_StartTransfer(QEST_LDMA_CHANNEL, &transferCfg, &descriptors[0]);
+
+  // The LETIMER output pulse is the sample request; no pin is needed
+  CMU_ClockEnable(cmuClock_PRS, true);
+  PRS_SourceAsyncSignalSet(QEST_PRS_CHANNEL,
+                           PRS_ASYNC_CH_CTRL_SOURCESEL_LETIMER0,
+                           PRS_LETIMER0_CH0);
+  PRS_ConnectConsumer(QEST_PRS_CHANNEL, prsTypeAsync, prsConsumerLDMA_REQUEST0);
+
+  CMU_ClockEnable(cmuClock_LETIMER0, true);
+  letimerInit.comp0Top = true;
+  letimerInit.topValue = (CMU_ClockFreqGet(cmuClock_LETIMER0) / QEST_SAMPLE_RATE) - 1;
+  letimerInit.ufoa0 = letimerUFOAPulse;
+  letimerInit.repMode = letimerRepeatFree;
+  LETIMER_Init(LETIMER0, &letimerInit);
+
+  return true;
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Stop sampling
+ *****************************************************************************/
+void QEST_Stop(void)
+{
+  LETIMER_Enable(LETIMER0, false);
+  LDMA_StopTransfer(QEST_LDMA_CHANNEL);
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Copy the estimate of the last batch
+ *
+ * @return
+ *   true if there is an estimate that has not been read yet.
+ *****************************************************************************/
+bool QEST_GetEstimate(QEST_Estimate_t *estimate)
+{
+  bool fresh;
+
+  CORE_DECLARE_IRQ_STATE;
+  CORE_ENTER_CRITICAL();
+  *estimate = latest;
+  fresh = haveEstimate;
+  haveEstimate = false;
+  CORE_EXIT_CRITICAL();
+
+  return fresh;
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Number of halves overwritten before the LDMA interrupt was served. The
+ *   position stays right; only their velocity estimates are lost.
+ *****************************************************************************/
+uint32_t QEST_GetOverrunCount(void)
+{
+  return overrunCount;
+}
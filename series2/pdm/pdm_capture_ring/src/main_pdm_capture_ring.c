@@ -0,0 +1,234 @@
+/***************************************************************************//**
+ * @file main_pdm_capture_ring.c
+ * @brief This project demonstrates stereo PDM capture into a ring of LDMA
+ * buffers that are processed in place.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2022 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ *******************************************************************************
+ * # Evaluation Quality
+ * This code has been minimally tested to ensure that it builds and is suitable 
+ * as a demonstration for evaluation purposes only. This code will be maintained
+ * at the sole discretion of Silicon Labs.
+ ******************************************************************************/
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "em_chip.h"
+#include "em_cmu.h"
+#include "em_emu.h"
+#include "em_gpio.h"
+#include "em_ldma.h"
+#include "em_pdm.h"
+#include "arena.h"
+#include "pdmcapture.h"
+
+// DMA channel used for the example
+#define LDMA_CHANNEL        0
+
+// Deepest ring and memory reserved for all buffers together
+#define MAX_BUFFERS         PDMCAPTURE_MAX_BUFFERS
+#define RING_WORDS          1024
+
+// Ring depth and stereo frames per buffer, read once at start-up
+volatile unsigned int bufferCount  = 4;
+volatile unsigned int bufferFrames = 64;
+
+// Buffer memory, the LDMA writes here directly. The ring is carved from
+// it as a pool at start-up, so any depth and length that fit together are
+// allowed, and the memory is free for other uses once the capture stops.
+static uint32_t ringMemory[RING_WORDS];
+static ARENA_Arena_t ringArena;
+static ARENA_Pool_t bufferPool;
+
+// Results of the processing loop
+volatile int16_t peakLeft;
+volatile int16_t peakRight;
+volatile uint32_t buffersProcessed;
+volatile uint32_t buffersDropped;
+
+/***************************************************************************//**
+ * @brief
+ *   Sets up PDM pins and clocks
+ ******************************************************************************/
+void initPdmPins(void)
+{
+  // Set up clocks
+  CMU_ClockEnable(cmuClock_GPIO, true);
+  CMU_ClockEnable(cmuClock_PDM, true);
+  CMU_ClockSelectSet(cmuClock_PDMREF, cmuSelect_HFRCODPLL); // 19 MHz
+
+  // Config GPIO and pin routing
+  GPIO_PinModeSet(gpioPortA, 0, gpioModePushPull, 1);    // MIC_EN
+  GPIO_PinModeSet(gpioPortC, 6, gpioModePushPull, 0);    // PDM_CLK
+  GPIO_PinModeSet(gpioPortC, 7, gpioModeInput, 0);       // PDM_DATA
+
+  GPIO_SlewrateSet(gpioPortC, 7, 7);
+
+  GPIO->PDMROUTE.ROUTEEN = GPIO_PDM_ROUTEEN_CLKPEN;
+  GPIO->PDMROUTE.CLKROUTE = (gpioPortC << _GPIO_PDM_CLKROUTE_PORT_SHIFT)
+                            | (6 << _GPIO_PDM_CLKROUTE_PIN_SHIFT);
+  GPIO->PDMROUTE.DAT0ROUTE = (gpioPortC << _GPIO_PDM_DAT0ROUTE_PORT_SHIFT)
+                            | (7 << _GPIO_PDM_DAT0ROUTE_PIN_SHIFT);
+  GPIO->PDMROUTE.DAT1ROUTE = (gpioPortC << _GPIO_PDM_DAT1ROUTE_PORT_SHIFT)
+                            | (7 << _GPIO_PDM_DAT1ROUTE_PIN_SHIFT);
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Sets up the PDM and the capture ring
+ ******************************************************************************/
+void initCapture(void)
+{
+  static uint32_t * buffers[MAX_BUFFERS];
+  LDMA_Init_t ldmaInit = LDMA_INIT_DEFAULT;
+  PDMCAPTURE_Init_t captureInit;
+  PDM_Init_TypeDef pdmInit;
+  unsigned int i;
+
+  // Clamp the run time settings to the driver limits
+  if(bufferCount < 2) {
+    bufferCount = 2;
+  } else if(bufferCount > MAX_BUFFERS) {
+    bufferCount = MAX_BUFFERS;
+  }
+  if(bufferFrames == 0) {
+    bufferFrames = 1;
+  } else if(bufferFrames > LDMA_DESCRIPTOR_MAX_XFER_SIZE) {
+    bufferFrames = LDMA_DESCRIPTOR_MAX_XFER_SIZE;
+  }
+
+  // Halve the buffers until the ring fits in the memory reserved above
+  ARENA_Init(&ringArena, ringMemory, sizeof(ringMemory));
+  while(!ARENA_PoolInit(&bufferPool, &ringArena,
+                        bufferFrames * sizeof(uint32_t), bufferCount,
+                        ARENA_ALIGN_DMA)) {
+    bufferFrames /= 2;
+  }
+  for(i=0; i<bufferCount; i++) {
+    buffers[i] = ARENA_PoolAlloc(&bufferPool);
+  }
+
+  // Configure PDM
+  pdmInit.start = false;
+  pdmInit.dsr = 32;
+  pdmInit.gain = 5;
+  pdmInit.ch0ClkPolarity = pdmCh0ClkPolarityRisingEdge;  // Normal
+  pdmInit.ch1ClkPolarity = pdmCh1ClkPolarityFallingEdge; // Invert
+  pdmInit.enableCh0Ch1Stereo = true;
+  pdmInit.fifoValidWatermark = pdmFifoValidWatermarkFour;
+  pdmInit.dataFormat = pdmDataFormatDouble16;
+  pdmInit.numChannels = pdmNumberOfChannelsTwo;
+  pdmInit.filterOrder = pdmFilterOrderFifth;
+  pdmInit.prescaler = 5;
+
+  captureInit.channel = LDMA_CHANNEL;
+  captureInit.buffers = buffers;
+  captureInit.count = bufferCount;
+  captureInit.length = bufferFrames;
+  captureInit.callback = NULL;
+
+  LDMA_Init(&ldmaInit);
+
+  if(!PDMCAPTURE_Init(&captureInit, &pdmInit)) {
+    // Loop here to enable the debugger to see what has happened
+    while(1);
+  }
+}
+
+/***************************************************************************//**
+ * @brief
+ *   LDMA IRQ handler.
+ ******************************************************************************/
+void LDMA_IRQHandler(void)
+{
+  // Check for LDMA error
+  if(LDMA_IntGet() & LDMA_IF_ERROR) {
+    // Loop here to enable the debugger to see what has happened
+    while(1);
+  }
+
+  PDMCAPTURE_IRQHandler();
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Track the left/right peak level of one buffer, reading it in place
+ ******************************************************************************/
+void processBuffer(const uint32_t *buffer, unsigned int frames)
+{
+  int16_t l, r;
+  int16_t maxL = 0;
+  int16_t maxR = 0;
+  unsigned int i;
+
+  for(i=0; i<frames; i++) {
+    l = PDMCAPTURE_LEFT(buffer[i]);
+    r = PDMCAPTURE_RIGHT(buffer[i]);
+    if(l < 0) {
+      l = (l == INT16_MIN) ? INT16_MAX : -l;
+    }
+    if(r < 0) {
+      r = (r == INT16_MIN) ? INT16_MAX : -r;
+    }
+    if(l > maxL) {
+      maxL = l;
+    }
+    if(r > maxR) {
+      maxR = r;
+    }
+  }
+
+  peakLeft = maxL;
+  peakRight = maxR;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Main function
+ ******************************************************************************/
+int main(void)
+{
+  const uint32_t *buffer;
+
+  // Chip errata
+  CHIP_Init();
+
+  initPdmPins();
+  initCapture();
+  PDMCAPTURE_Start();
+
+  while(1) {
+    // Process every filled buffer, then sleep until the next one
+    while((buffer = PDMCAPTURE_GetBuffer()) != NULL) {
+      processBuffer(buffer, bufferFrames);
+      PDMCAPTURE_ReleaseBuffer(buffer);
+      buffersProcessed++;
+    }
+    buffersDropped = PDMCAPTURE_Overruns();
+
+    EMU_EnterEM1();
+  }
+}
@@ -0,0 +1,332 @@
+/***************************************************************************//**
+ * @file main_pdm_i2s_passthrough.c
+ * @brief This project passes stereo PDM microphone audio straight to an I2S
+ * DAC through a short ring of LDMA slots, and measures the latency.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2022 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ *******************************************************************************
+ * # Evaluation Quality
+ * This code has been minimally tested to ensure that it builds and is suitable 
+ * as a demonstration for evaluation purposes only. This code will be maintained
+ * at the sole discretion of Silicon Labs.
+ ******************************************************************************/
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "em_chip.h"
+#include "em_cmu.h"
+#include "em_core.h"
+#include "em_emu.h"
+#include "em_gpio.h"
+#include "em_ldma.h"
+#include "em_pdm.h"
+#include "em_usart.h"
+#include "ldmapipe.h"
+
+// LDMA channels of the capture and output stages, and the first SYNC bit
+#define PDM_LDMA_CHANNEL    0
+#define I2S_LDMA_CHANNEL    1
+#define PIPE_SYNC_SHIFT     0
+
+// Ring of slots between the stages, each SLOT_FRAMES stereo frames. The
+// output takes a slot as soon as the capture has filled it, so the ring
+// delay is about one slot; more slots only add slack, not delay.
+#define PIPE_SLOTS          LDMAPIPE_MAX_SLOTS
+#define SLOT_FRAMES         4
+#define RING_FRAMES         (PIPE_SLOTS * SLOT_FRAMES)
+
+// PCM sample rate: 19 MHz PDMREF, PDM clock prescaler 5, DSR 32
+#define PDM_PRESCALER       5
+#define PDM_DSR             32
+#define SAMPLEFREQ          (19000000 / (PDM_PRESCALER + 1) / PDM_DSR)
+
+// I2S bit clock, two 16 bit slots per frame. The USART runs from the same
+// 19 MHz as the PDM and divides it by 6 too, so the output rate is exactly
+// the capture rate and the ring never slips.
+#define I2S_BITRATE         (19000000 / (PDM_PRESCALER + 1))
+
+// Fixed parts of the delay, in ns: the fifth order decimation filter,
+// 5 * (DSR - 1) / 2 PDM clocks, and the USART transmit buffer and shift
+// register, one and a half frames
+#define FILTER_DELAY_NS     (5ULL * (PDM_DSR - 1) * 1000000000ULL \
+                             / (2 * I2S_BITRATE))
+#define OUTPUT_DELAY_NS     (3ULL * 1000000000ULL / (2 * SAMPLEFREQ))
+
+// Ring measurements per second, from the SysTick interrupt
+#define MEASURE_HZ          100
+
+// I2S pins: bit clock, word select and data to the DAC
+#define I2S_CLK_PORT        gpioPortB
+#define I2S_CLK_PIN         2
+#define I2S_WS_PORT         gpioPortB
+#define I2S_WS_PIN          3
+#define I2S_DATA_PORT       gpioPortB
+#define I2S_DATA_PIN        4
+
+// Ring memory, one stereo frame per word, left in the low half
+static uint32_t ring[RING_FRAMES];
+
+static LDMAPIPE_Pipe_t pipe;
+
+// Frames between the capture and the output in the ring, and the whole
+// delay from the microphone to the I2S data pin, in us
+volatile uint32_t ringFramesMin = UINT32_MAX;
+volatile uint32_t ringFramesMax;
+volatile uint32_t latencyUs;
+volatile uint32_t latencyUsMax;
+volatile uint32_t measurements;
+
+/***************************************************************************//**
+ * @brief
+ *   Sets up PDM pins and clocks
+ ******************************************************************************/
+void initPdmPins(void)
+{
+  // Set up clocks
+  CMU_ClockEnable(cmuClock_GPIO, true);
+  CMU_ClockEnable(cmuClock_PDM, true);
+  CMU_ClockSelectSet(cmuClock_PDMREF, cmuSelect_HFRCODPLL); // 19 MHz
+
+  // Config GPIO and pin routing
+  GPIO_PinModeSet(gpioPortA, 0, gpioModePushPull, 1);    // MIC_EN
+  GPIO_PinModeSet(gpioPortC, 6, gpioModePushPull, 0);    // PDM_CLK
+  GPIO_PinModeSet(gpioPortC, 7, gpioModeInput, 0);       // PDM_DATA
+
+  GPIO_SlewrateSet(gpioPortC, 7, 7);
+
+  GPIO->PDMROUTE.ROUTEEN = GPIO_PDM_ROUTEEN_CLKPEN;
+  GPIO->PDMROUTE.CLKROUTE = (gpioPortC << _GPIO_PDM_CLKROUTE_PORT_SHIFT)
+                            | (6 << _GPIO_PDM_CLKROUTE_PIN_SHIFT);
+  GPIO->PDMROUTE.DAT0ROUTE = (gpioPortC << _GPIO_PDM_DAT0ROUTE_PORT_SHIFT)
+                            | (7 << _GPIO_PDM_DAT0ROUTE_PIN_SHIFT);
+  GPIO->PDMROUTE.DAT1ROUTE = (gpioPortC << _GPIO_PDM_DAT1ROUTE_PORT_SHIFT)
+                            | (7 << _GPIO_PDM_DAT1ROUTE_PIN_SHIFT);
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Sets up the PDM, not started yet
+ *
+ * @details
+ *   The FIFO raises its data valid request at every frame, so no frame
+ *   waits in the FIFO for others.
+ ******************************************************************************/
+void initPdm(void)
+{
+  PDM_Init_TypeDef pdmInit;
+
+  pdmInit.start = false;
+  pdmInit.dsr = PDM_DSR;
+  pdmInit.gain = 5;
+  pdmInit.ch0ClkPolarity = pdmCh0ClkPolarityRisingEdge;  // Normal
+  pdmInit.ch1ClkPolarity = pdmCh1ClkPolarityFallingEdge; // Invert
+  pdmInit.enableCh0Ch1Stereo = true;
+  pdmInit.fifoValidWatermark = pdmFifoValidWatermarkOne;
+  pdmInit.dataFormat = pdmDataFormatDouble16;
+  pdmInit.numChannels = pdmNumberOfChannelsTwo;
+  pdmInit.filterOrder = pdmFilterOrderFifth;
+  pdmInit.prescaler = PDM_PRESCALER;
+
+  PDM_Init(PDM, &pdmInit);
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Sets up USART0 as I2S master transmitter, 16 bit stereo
+ *
+ * @details
+ *   Each frame is written to TXDOUBLE as two 16 bit words, left first;
+ *   the word select comes out on the CS pin.
+ ******************************************************************************/
+void initI2s(void)
+{
+  USART_InitI2s_TypeDef i2sInit = USART_INITI2S_DEFAULT;
+
+  CMU_ClockEnable(cmuClock_USART0, true);
+
+  i2sInit.sync.enable = usartEnableTx;
+  i2sInit.sync.baudrate = I2S_BITRATE;
+  i2sInit.sync.databits = usartDatabits16;
+  i2sInit.format = usartI2sFormatW16D16;
+  i2sInit.justify = usartI2sJustifyLeft;
+  i2sInit.delay = true;
+  i2sInit.mono = false;
+  USART_InitI2s(USART0, &i2sInit);
+
+  GPIO_PinModeSet(I2S_CLK_PORT, I2S_CLK_PIN, gpioModePushPull, 0);
+  GPIO_PinModeSet(I2S_WS_PORT, I2S_WS_PIN, gpioModePushPull, 0);
+  GPIO_PinModeSet(I2S_DATA_PORT, I2S_DATA_PIN, gpioModePushPull, 0);
+
+  GPIO->USARTROUTE[0].CLKROUTE = (I2S_CLK_PORT << _GPIO_USART_CLKROUTE_PORT_SHIFT)
+                                 | (I2S_CLK_PIN << _GPIO_USART_CLKROUTE_PIN_SHIFT);
+  GPIO->USARTROUTE[0].CSROUTE = (I2S_WS_PORT << _GPIO_USART_CSROUTE_PORT_SHIFT)
+                                | (I2S_WS_PIN << _GPIO_USART_CSROUTE_PIN_SHIFT);
+  GPIO->USARTROUTE[0].TXROUTE = (I2S_DATA_PORT << _GPIO_USART_TXROUTE_PORT_SHIFT)
+                                | (I2S_DATA_PIN << _GPIO_USART_TXROUTE_PIN_SHIFT);
+  GPIO->USARTROUTE[0].ROUTEEN = GPIO_USART_ROUTEEN_CLKPEN
+                                | GPIO_USART_ROUTEEN_CSPEN
+                                | GPIO_USART_ROUTEEN_TXPEN;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Sets up the two stage pipeline, PDM FIFO to slot and slot to I2S
+ *
+ * @details
+ *   The LDMA hands each slot from the capture to the output and back
+ *   with the SYNC bits, so the loop runs without the CPU. The done
+ *   interrupt of the output stage is turned off, the CPU only wakes for
+ *   the measurements.
+ ******************************************************************************/
+void initPipe(void)
+{
+  static void * slots[PIPE_SLOTS];
+  LDMA_Init_t ldmaInit = LDMA_INIT_DEFAULT;
+  LDMAPIPE_Stage_t stage;
+  unsigned int i;
+
+  for(i=0; i<PIPE_SLOTS; i++) {
+    slots[i] = &ring[i * SLOT_FRAMES];
+  }
+
+  LDMA_Init(&ldmaInit);
+
+  if(!LDMAPIPE_Init(&pipe, slots, PIPE_SLOTS, SLOT_FRAMES * sizeof(ring[0]),
+                    PIPE_SYNC_SHIFT)) {
+    while(1);
+  }
+
+  // One frame per PDM data valid request
+  stage.channel = PDM_LDMA_CHANNEL;
+  stage.dir = ldmaPipeFromPeri;
+  stage.signal = ldmaPeripheralSignal_PDM_RXDATAV;
+  stage.addr = &PDM->RXDATA;
+  stage.size = ldmaCtrlSizeWord;
+  if(!LDMAPIPE_AddStage(&pipe, &stage)) {
+    while(1);
+  }
+
+  // One 16 bit channel word per transmit buffer request
+  stage.channel = I2S_LDMA_CHANNEL;
+  stage.dir = ldmaPipeToPeri;
+  stage.signal = ldmaPeripheralSignal_USART0_TXBL;
+  stage.addr = &USART0->TXDOUBLE;
+  stage.size = ldmaCtrlSizeHalf;
+  if(!LDMAPIPE_AddStage(&pipe, &stage)) {
+    while(1);
+  }
+
+  if(!LDMAPIPE_Start(&pipe, NULL, NULL)) {
+    while(1);
+  }
+  LDMA_IntDisable(1UL << I2S_LDMA_CHANNEL);
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Frame of the ring an LDMA address is in
+ *
+ * @return
+ *   RING_FRAMES if the channel is between descriptors and the address is
+ *   not in the ring.
+ ******************************************************************************/
+static uint32_t ringFrame(uint32_t addr)
+{
+  uint32_t offset = addr - (uint32_t)ring;
+
+  if(offset >= sizeof(ring)) {
+    return RING_FRAMES;
+  }
+  return offset / sizeof(ring[0]);
+}
+
+/***************************************************************************//**
+ * @brief
+ *   SysTick interrupt handler, measures the delay through the ring
+ *
+ * @details
+ *   The frame the capture writes next and the frame the output reads next
+ *   are read back to back from the channel registers; the frames between
+ *   them are the ring delay. The decimation filter and the USART buffer
+ *   add a fixed delay on top.
+ ******************************************************************************/
+void SysTick_Handler(void)
+{
+  uint32_t in, out, frames, us;
+  CORE_DECLARE_IRQ_STATE;
+
+  CORE_ENTER_ATOMIC();
+  in = ringFrame(LDMA->CH[PDM_LDMA_CHANNEL].DST);
+  out = ringFrame(LDMA->CH[I2S_LDMA_CHANNEL].SRC);
+  CORE_EXIT_ATOMIC();
+
+  if((in == RING_FRAMES) || (out == RING_FRAMES)) {
+    return;
+  }
+
+  frames = (in + RING_FRAMES - out) % RING_FRAMES;
+  us = (uint32_t)((FILTER_DELAY_NS + OUTPUT_DELAY_NS
+                   + (frames * 1000000000ULL) / SAMPLEFREQ) / 1000);
+
+  if(frames < ringFramesMin) {
+    ringFramesMin = frames;
+  }
+  if(frames > ringFramesMax) {
+    ringFramesMax = frames;
+  }
+  if(us > latencyUsMax) {
+    latencyUsMax = us;
+  }
+  latencyUs = us;
+  measurements++;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Main function
+ ******************************************************************************/
+int main(void)
+{
+  // Chip errata
+  CHIP_Init();
+
+  initPdmPins();
+  initPdm();
+  initI2s();
+  initPipe();
+
+  // The capture stage waits for its first request
+  PDM_Start(PDM);
+
+  if(SysTick_Config(CMU_ClockFreqGet(cmuClock_SYSCLK) / MEASURE_HZ)) {
+    while(1);
+  }
+
+  // Nothing to do but sleep, the audio goes through without the CPU
+  while(1) {
+    EMU_EnterEM1();
+  }
+}
@@ -0,0 +1,426 @@
+/***************************************************************************//**
+ * @file main_pdm_profile_sweep.c
+ * @brief This project sweeps the PDM prescaler, decimation ratio and filter
+ * order, measures the sample rate and the SNR of a test tone for each, and
+ * switches between a low power and a high fidelity profile at run time.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2022 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ *******************************************************************************
+ * # Evaluation Quality
+ * This code has been minimally tested to ensure that it builds and is suitable 
+ * as a demonstration for evaluation purposes only. This code will be maintained
+ * at the sole discretion of Silicon Labs.
+ ******************************************************************************/
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <math.h>
+#include "em_chip.h"
+#include "em_cmu.h"
+#include "em_emu.h"
+#include "em_gpio.h"
+#include "em_ldma.h"
+#include "em_pdm.h"
+#include "energymark.h"
+#include "pdmcapture.h"
+
+// DMA channel used for the example
+#define LDMA_CHANNEL        0
+
+// Capture ring
+#define BUFFER_COUNT        4
+#define BUFFER_FRAMES       256
+
+// Test tone played to the microphones, and the samples analyzed for it
+#define TONE_HZ             1000
+#define ANALYSIS_SAMPLES    2048
+
+// Bins on each side of the tone bin that count as tone, the Hann window
+// spreads a tone between bins over about this many
+#define TONE_BINS           3
+
+// Samples dropped after a switch while the microphone changes mode and the
+// filter settles, and the time each profile is held for the current
+// measurement
+#define SETTLE_MS           100
+#define DWELL_MS            1000
+
+// Swept settings: PDM clock 3.17 MHz, 1.58 MHz and 792 kHz from the 19 MHz
+// PDMREF, the last in the low power mode of the microphones
+static const uint32_t prescalers[] = { 5, 11, 23 };
+static const uint32_t ratios[] = { 32, 64 };
+static const PDM_FilterOrder_TypeDef orders[] = {
+  pdmFilterOrderSecond, pdmFilterOrderThird,
+  pdmFilterOrderFourth, pdmFilterOrderFifth
+};
+
+#define COUNT_OF(a)         (sizeof(a) / sizeof((a)[0]))
+#define PROFILE_COUNT       (COUNT_OF(prescalers) * COUNT_OF(ratios) \
+                             * COUNT_OF(orders))
+
+// Profiles switched between at run time once the sweep is done
+static const PDMCAPTURE_Profile_t lowPowerProfile = {
+  23, 32, pdmFilterOrderThird, 0
+};
+static const PDMCAPTURE_Profile_t highFidelityProfile = {
+  5, 64, pdmFilterOrderFifth, 10
+};
+
+// Result of one profile of the sweep
+typedef struct {
+  PDMCAPTURE_Profile_t profile;
+  uint32_t pdmClock;                // Hz
+  uint32_t sampleRate;              // Hz, measured
+  float snrDb;                      // tone to everything else
+  uint8_t marker;                   // ENERGYMARK ID of the dwell
+} Result_t;
+
+volatile Result_t results[PROFILE_COUNT];
+volatile uint32_t profilesDone;
+
+// Set from the debugger after the sweep to switch profiles, and the SNR
+// of the profile in use, measured again and again
+volatile bool lowPower = false;
+volatile float liveSnrDb;
+
+static uint32_t ringBuffers[BUFFER_COUNT][BUFFER_FRAMES];
+static float analysis[ANALYSIS_SAMPLES];
+
+// Frames captured since the last profile switch, counted by the callback
+static volatile uint32_t framesCaptured;
+
+/***************************************************************************//**
+ * @brief
+ *   Sets up PDM pins and clocks
+ ******************************************************************************/
+void initPdmPins(void)
+{
+  // Set up clocks
+  CMU_ClockEnable(cmuClock_GPIO, true);
+  CMU_ClockEnable(cmuClock_PDM, true);
+  CMU_ClockSelectSet(cmuClock_PDMREF, cmuSelect_HFRCODPLL); // 19 MHz
+
+  // Config GPIO and pin routing
+  GPIO_PinModeSet(gpioPortA, 0, gpioModePushPull, 1);    // MIC_EN
+  GPIO_PinModeSet(gpioPortC, 6, gpioModePushPull, 0);    // PDM_CLK
+  GPIO_PinModeSet(gpioPortC, 7, gpioModeInput, 0);       // PDM_DATA
+
+  GPIO_SlewrateSet(gpioPortC, 7, 7);
+
+  GPIO->PDMROUTE.ROUTEEN = GPIO_PDM_ROUTEEN_CLKPEN;
+  GPIO->PDMROUTE.CLKROUTE = (gpioPortC << _GPIO_PDM_CLKROUTE_PORT_SHIFT)
+                            | (6 << _GPIO_PDM_CLKROUTE_PIN_SHIFT);
+  GPIO->PDMROUTE.DAT0ROUTE = (gpioPortC << _GPIO_PDM_DAT0ROUTE_PORT_SHIFT)
+                            | (7 << _GPIO_PDM_DAT0ROUTE_PIN_SHIFT);
+  GPIO->PDMROUTE.DAT1ROUTE = (gpioPortC << _GPIO_PDM_DAT1ROUTE_PORT_SHIFT)
+                            | (7 << _GPIO_PDM_DAT1ROUTE_PIN_SHIFT);
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Called from the LDMA interrupt for each filled buffer
+ ******************************************************************************/
+static void bufferFilled(const uint32_t *buffer)
+{
+  (void)buffer;
+  framesCaptured += BUFFER_FRAMES;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Sets up the PDM and the capture ring, with the high fidelity profile
+ ******************************************************************************/
+void initCapture(void)
+{
+  static uint32_t * buffers[BUFFER_COUNT];
+  LDMA_Init_t ldmaInit = LDMA_INIT_DEFAULT;
+  PDMCAPTURE_Init_t captureInit;
+  PDM_Init_TypeDef pdmInit;
+  unsigned int i;
+
+  for(i=0; i<BUFFER_COUNT; i++) {
+    buffers[i] = ringBuffers[i];
+  }
+
+  pdmInit.start = false;
+  pdmInit.dsr = highFidelityProfile.dsr;
+  pdmInit.gain = highFidelityProfile.gain;
+  pdmInit.ch0ClkPolarity = pdmCh0ClkPolarityRisingEdge;  // Normal
+  pdmInit.ch1ClkPolarity = pdmCh1ClkPolarityFallingEdge; // Invert
+  pdmInit.enableCh0Ch1Stereo = true;
+  pdmInit.fifoValidWatermark = pdmFifoValidWatermarkFour;
+  pdmInit.dataFormat = pdmDataFormatDouble16;
+  pdmInit.numChannels = pdmNumberOfChannelsTwo;
+  pdmInit.filterOrder = highFidelityProfile.filterOrder;
+  pdmInit.prescaler = highFidelityProfile.prescaler;
+
+  captureInit.channel = LDMA_CHANNEL;
+  captureInit.buffers = buffers;
+  captureInit.count = BUFFER_COUNT;
+  captureInit.length = BUFFER_FRAMES;
+  captureInit.callback = bufferFilled;
+
+  LDMA_Init(&ldmaInit);
+
+  if(!PDMCAPTURE_Init(&captureInit, &pdmInit)) {
+    // Loop here to enable the debugger to see what has happened
+    while(1);
+  }
+}
+
+/***************************************************************************//**
+ * @brief
+ *   LDMA IRQ handler.
+ ******************************************************************************/
+void LDMA_IRQHandler(void)
+{
+  // Check for LDMA error
+  if(LDMA_IntGet() & LDMA_IF_ERROR) {
+    // Loop here to enable the debugger to see what has happened
+    while(1);
+  }
+
+  PDMCAPTURE_IRQHandler();
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Filter gain for an order and decimation ratio
+ *
+ * @details
+ *   The decimation filter output grows by order * log2(dsr) bits. The gain
+ *   follows the growth from the fifth order, DSR 32, gain 5 setting of the
+ *   other PDM examples, so every profile gives about the same level.
+ ******************************************************************************/
+static uint32_t gainFor(PDM_FilterOrder_TypeDef order, uint32_t dsr)
+{
+  int32_t bits = 0;
+  int32_t n = (order == pdmFilterOrderSecond) ? 2
+              : (order == pdmFilterOrderThird) ? 3
+              : (order == pdmFilterOrderFourth) ? 4 : 5;
+  int32_t gain;
+
+  while((dsr >>= 1) != 0) {
+    bits++;
+  }
+  gain = 5 + (n * bits) - (5 * 5);
+
+  return (gain < 0) ? 0 : (uint32_t)gain;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Sleep until count more frames have been captured, dropping them
+ *
+ * @return
+ *   Frames counted, a whole number of buffers.
+ ******************************************************************************/
+static uint32_t skipFrames(uint32_t count)
+{
+  const uint32_t *buffer;
+  uint32_t start = framesCaptured;
+
+  while((framesCaptured - start) < count) {
+    while((buffer = PDMCAPTURE_GetBuffer()) != NULL) {
+      PDMCAPTURE_ReleaseBuffer(buffer);
+    }
+    EMU_EnterEM1();
+  }
+  return framesCaptured - start;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Copy the next ANALYSIS_SAMPLES left channel samples out of the ring
+ ******************************************************************************/
+static void collect(void)
+{
+  const uint32_t *buffer;
+  uint32_t n = 0;
+  uint32_t i;
+
+  // Start with a buffer filled after the call
+  while((buffer = PDMCAPTURE_GetBuffer()) != NULL) {
+    PDMCAPTURE_ReleaseBuffer(buffer);
+  }
+
+  while(n < ANALYSIS_SAMPLES) {
+    buffer = PDMCAPTURE_GetBuffer();
+    if(buffer == NULL) {
+      EMU_EnterEM1();
+      continue;
+    }
+    for(i=0; (i<BUFFER_FRAMES) && (n<ANALYSIS_SAMPLES); i++) {
+      analysis[n++] = (float)PDMCAPTURE_LEFT(buffer[i]);
+    }
+    PDMCAPTURE_ReleaseBuffer(buffer);
+  }
+}
+
+/***************************************************************************//**
+ * @brief
+ *   SNR of the test tone in the collected samples
+ *
+ * @details
+ *   The samples less their mean go through a Hann window. The tone energy
+ *   is that of the bins around the tone, from one Goertzel filter per bin;
+ *   everything else, noise, hum and distortion, is the total energy less
+ *   the tone, by Parseval.
+ ******************************************************************************/
+static float snrOf(uint32_t sampleRate)
+{
+  const float pi = 3.14159265f;
+  float mean = 0.0f;
+  float total = 0.0f;
+  float tone = 0.0f;
+  float coeff, s0, s1, s2;
+  int32_t k0, k;
+  uint32_t i;
+
+  for(i=0; i<ANALYSIS_SAMPLES; i++) {
+    mean += analysis[i];
+  }
+  mean /= ANALYSIS_SAMPLES;
+
+  for(i=0; i<ANALYSIS_SAMPLES; i++) {
+    analysis[i] = (analysis[i] - mean)
+                  * (0.5f - 0.5f * cosf(2 * pi * i / ANALYSIS_SAMPLES));
+    total += analysis[i] * analysis[i];
+  }
+
+  k0 = (int32_t)(((uint64_t)TONE_HZ * ANALYSIS_SAMPLES + sampleRate / 2)
+                 / sampleRate);
+  for(k=k0-TONE_BINS; k<=k0+TONE_BINS; k++) {
+    if(k <= 0) {
+      continue;
+    }
+    coeff = 2 * cosf(2 * pi * k / ANALYSIS_SAMPLES);
+    s1 = 0.0f;
+    s2 = 0.0f;
+    for(i=0; i<ANALYSIS_SAMPLES; i++) {
+      s0 = analysis[i] + coeff * s1 - s2;
+      s2 = s1;
+      s1 = s0;
+    }
+    tone += s1 * s1 + s2 * s2 - coeff * s1 * s2;
+  }
+
+  // Both the positive and the negative frequency bins of the tone
+  tone = 2 * tone / ANALYSIS_SAMPLES;
+  if((tone <= 0.0f) || (tone >= total)) {
+    return 0.0f;
+  }
+  return 10 * log10f(tone / (total - tone));
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Switch to a profile and measure it
+ *
+ * @details
+ *   The sample rate is the frames counted over the DWELL_MS dwell, timed
+ *   by the DWT cycle counter. The dwell is marked with the ENERGYMARK ID
+ *   of the profile, so the current over the marked region is the current
+ *   of the profile with the CPU asleep in EM1 between buffers.
+ ******************************************************************************/
+static void measure(const PDMCAPTURE_Profile_t *profile, volatile Result_t *result,
+                    uint8_t marker)
+{
+  uint32_t cyclesPerMs = CMU_ClockFreqGet(cmuClock_SYSCLK) / 1000;
+  PDMCAPTURE_Profile_t current;
+  uint32_t rate, start, frames;
+
+  // Only restart the capture for a new profile
+  PDMCAPTURE_GetProfile(&current);
+  if((current.prescaler != profile->prescaler) || (current.dsr != profile->dsr)
+     || (current.filterOrder != profile->filterOrder)
+     || (current.gain != profile->gain)) {
+    if(!PDMCAPTURE_SetProfile(profile)) {
+      // Loop here to enable the debugger to see what has happened
+      while(1);
+    }
+  }
+
+  rate = PDMCAPTURE_SampleRate();
+  skipFrames((rate * SETTLE_MS) / 1000);
+  collect();
+
+  result->profile = *profile;
+  result->pdmClock = rate * profile->dsr;
+  result->snrDb = snrOf(rate);
+  result->marker = marker;
+
+  ENERGYMARK_BEGIN(marker);
+  start = DWT->CYCCNT;
+  frames = skipFrames((rate * DWELL_MS) / 1000);
+  result->sampleRate = (uint32_t)(((uint64_t)frames * 1000 * cyclesPerMs)
+                                  / (DWT->CYCCNT - start));
+  ENERGYMARK_END(marker);
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Main function
+ ******************************************************************************/
+int main(void)
+{
+  PDMCAPTURE_Profile_t profile;
+  volatile Result_t live;
+  unsigned int p, d, o;
+
+  // Chip errata
+  CHIP_Init();
+
+  ENERGYMARK_Init();
+  CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+  DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+  initPdmPins();
+  initCapture();
+  PDMCAPTURE_Start();
+
+  // Every combination, one after the other
+  for(p=0; p<COUNT_OF(prescalers); p++) {
+    for(d=0; d<COUNT_OF(ratios); d++) {
+      for(o=0; o<COUNT_OF(orders); o++) {
+        profile.prescaler = prescalers[p];
+        profile.dsr = ratios[d];
+        profile.filterOrder = orders[o];
+        profile.gain = gainFor(orders[o], ratios[d]);
+        measure(&profile, &results[profilesDone],
+                (uint8_t)(ENERGYMARK_ID_USER + profilesDone));
+        profilesDone++;
+      }
+    }
+  }
+
+  // Then the profile picked with lowPower, measured again and again
+  while(1) {
+    measure(lowPower ? &lowPowerProfile : &highFidelityProfile, &live,
+            ENERGYMARK_ID_APP);
+    liveSnrDb = live.snrDb;
+  }
+}
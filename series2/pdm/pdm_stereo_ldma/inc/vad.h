@@ -0,0 +1,91 @@
+/***************************************************************************//**
+ * @file vad.h
+ *
+ * @brief Voice activity detection on PDM stereo buffers from the energy and
+ * the zero crossings of each buffer, at a few cycles per sample.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2020 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ******************************************************************************/
+
+#ifndef VAD_H
+#define VAD_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Sound when the buffer energy is this many times the noise floor
+#ifndef VAD_RATIO
+#define VAD_RATIO             4
+#endif
+
+// Energy never taken as sound, mean square in codes, ignores digital silence
+#ifndef VAD_ENERGY_MIN
+#define VAD_ENERGY_MIN        64
+#endif
+
+// Most zero crossings of a sound buffer, per 256 samples; hiss crosses more
+#ifndef VAD_CROSSINGS_MAX
+#define VAD_CROSSINGS_MAX     128
+#endif
+
+// Buffers the gate stays open after the last buffer with sound
+#ifndef VAD_HANGOVER
+#define VAD_HANGOVER          200
+#endif
+
+// Rise of the noise floor per buffer, 2^-VAD_NOISE_SHIFT of its value
+#ifndef VAD_NOISE_SHIFT
+#define VAD_NOISE_SHIFT       10
+#endif
+
+// Weight of each buffer mean in the DC estimate, 2^-VAD_DC_SHIFT
+#ifndef VAD_DC_SHIFT
+#define VAD_DC_SHIFT          4
+#endif
+
+typedef struct {
+  int32_t  dcLeft;            // DC estimate of each channel, in codes
+  int32_t  dcRight;
+  uint32_t energy;            // Mean square of the last buffer, both channels
+  uint32_t noise;             // Noise floor, follows the quietest buffers
+  uint32_t crossings;         // Zero crossings of the left channel, last buffer
+  uint32_t hangover;          // Buffers left before the gate closes
+  bool     started;           // The DC estimate holds a buffer mean
+  bool     active;            // Gate open
+} VAD_State_t;
+
+void VAD_Init(VAD_State_t *vad);
+bool VAD_Process(VAD_State_t *vad, const uint32_t *src, int n);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // VAD_H
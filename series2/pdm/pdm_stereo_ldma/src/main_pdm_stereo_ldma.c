@@ -36,12 +36,16 @@
 
 #include <stdint.h>
 #include <stdbool.h>
+#include <string.h>
 #include "em_chip.h"
 #include "em_cmu.h"
 #include "em_emu.h"
 #include "em_gpio.h"
 #include "em_ldma.h"
-#include "em_pdm.h"
+#include "dspfilter.h"
+#include "evsched.h"
+#include "regimage.h"
+#include "vad.h"
 
 // DMA channel used for the example
 #define LDMA_CHANNEL        0
@@ -53,9 +57,35 @@
 // Ping-pong buffer size
 #define PP_BUFFER_SIZE      64
 
-// Buffers for left/right PCM data
-int16_t left[BUFFER_SIZE];
-int16_t right[BUFFER_SIZE];
+// PCM sample rate: 19 MHz PDMREF, PDM clock prescaler 5, DSR 32
+#define SAMPLEFREQ          (19000000 / (5 + 1) / 32)
+
+// Highpass that removes the DC and rumble of the microphones, Butterworth
+// of order 2 * HIGHPASS_STAGES
+#define HIGHPASS_CORNER     100
+#define HIGHPASS_STAGES     2
+
+// Scheduler event posted by the LDMA interrupt for each filled buffer,
+// its data is 1 for pingBuffer and 0 for pongBuffer
+#define EVENT_BUFFER        0
+
+// LED0, on while the voice activity gate is open
+#define LED_PORT            gpioPortB
+#define LED_PIN             0
+
+// Buffers for left/right PCM data, word aligned for the packed stores
+__ALIGNED(4) int16_t left[BUFFER_SIZE];
+__ALIGNED(4) int16_t right[BUFFER_SIZE];
+
+// Highpass of each channel, in float; the state carries from one
+// ping-pong buffer to the next
+static DSPFILTER_BiquadF32_TypeDef leftFilter;
+static DSPFILTER_BiquadF32_TypeDef rightFilter;
+static float32_t pcm[PP_BUFFER_SIZE];
+
+// Cycles taken to deinterleave one ping-pong buffer, measured at start-up
+volatile uint32_t cyclesScalar;
+volatile uint32_t cyclesPacked;
 
 // Descriptor linked list for LDMA transfer
 LDMA_Descriptor_t descLink[2];
@@ -67,52 +97,90 @@ uint32_t pongBuffer[PP_BUFFER_SIZE];
 // Keeps track of previously written buffer
 bool prevBufferPing;
 
+// Voice activity detector, run on every buffer before anything else
+VAD_State_t vad;
+
+// Cycles of the last detector run, and buffers with the gate open/closed
+volatile uint32_t cyclesVad;
+volatile uint32_t buffersActive;
+volatile uint32_t buffersSilent;
+
+// Cycles of the last highpass run, both channels
+volatile uint32_t cyclesFilter;
+
+/***************************************************************************//**
+ * PDM and pin setup as a constant register image, computed by the compiler.
+ * The entries are the register writes GPIO_PinModeSet(), PDM_Reset() and
+ * PDM_Init() would make for this configuration, in the same order, so the
+ * setup after a reset or an EM4 wakeup is a short loop of stores.
+ *
+ * Stereo, 16 bit samples two per FIFO word, fifth order filter, DSR 32,
+ * gain 5 and PDM clock prescaler 5.
+ ******************************************************************************/
+static const REGIMAGE_Entry_t pdmImage[] = {
+  // MIC_EN, PDM_CLK and PDM_DATA
+  REGIMAGE_GPIO_MODE(gpioPortA, 0, gpioModePushPull, 1),
+  REGIMAGE_GPIO_MODE(gpioPortC, 6, gpioModePushPull, 0),
+  REGIMAGE_GPIO_MODE(gpioPortC, 7, gpioModeInput, 0),
+
+  // GPIO_SlewrateSet(gpioPortC, 7, 7)
+  REGIMAGE_FIELD(GPIO->P[gpioPortC].CTRL,
+                 _GPIO_P_CTRL_SLEWRATE_MASK | _GPIO_P_CTRL_SLEWRATEALT_MASK,
+                 (7UL << _GPIO_P_CTRL_SLEWRATE_SHIFT)
+                 | (7UL << _GPIO_P_CTRL_SLEWRATEALT_SHIFT)),
+
+  // Both channels take their data from PC7, on opposite clock edges
+  REGIMAGE_WRITE(GPIO->PDMROUTE.ROUTEEN, GPIO_PDM_ROUTEEN_CLKPEN),
+  REGIMAGE_WRITE(GPIO->PDMROUTE.CLKROUTE,
+                 (gpioPortC << _GPIO_PDM_CLKROUTE_PORT_SHIFT)
+                 | (6 << _GPIO_PDM_CLKROUTE_PIN_SHIFT)),
+  REGIMAGE_WRITE(GPIO->PDMROUTE.DAT0ROUTE,
+                 (gpioPortC << _GPIO_PDM_DAT0ROUTE_PORT_SHIFT)
+                 | (7 << _GPIO_PDM_DAT0ROUTE_PIN_SHIFT)),
+  REGIMAGE_WRITE(GPIO->PDMROUTE.DAT1ROUTE,
+                 (gpioPortC << _GPIO_PDM_DAT1ROUTE_PORT_SHIFT)
+                 | (7 << _GPIO_PDM_DAT1ROUTE_PIN_SHIFT)),
+
+  // Stop and disable, the configuration registers are locked while enabled
+  REGIMAGE_WAIT(PDM->SYNCBUSY, _PDM_SYNCBUSY_MASK, 0),
+  REGIMAGE_WRITE(PDM->CMD, PDM_CMD_STOP),
+  REGIMAGE_WAIT(PDM->SYNCBUSY, _PDM_SYNCBUSY_MASK, 0),
+  REGIMAGE_WRITE(PDM->EN, 0),
+
+  REGIMAGE_WRITE(PDM->CFG0, PDM_CFG0_CH0CLKPOL_NORMAL
+                            | PDM_CFG0_CH1CLKPOL_INVERT
+                            | PDM_CFG0_STEREOMODECH01_CH01ENABLE
+                            | PDM_CFG0_FIFODVL_FOUR
+                            | PDM_CFG0_DATAFORMAT_DOUBLE16
+                            | PDM_CFG0_NUMCH_TWO
+                            | PDM_CFG0_FORDER_FIFTH),
+  REGIMAGE_WRITE(PDM->CFG1, 5 << _PDM_CFG1_PRESC_SHIFT),
+  REGIMAGE_WRITE(PDM->EN, PDM_EN_EN),
+  REGIMAGE_WRITE(PDM->CTRL, (32 << _PDM_CTRL_DSR_SHIFT)
+                            | (5 << _PDM_CTRL_GAIN_SHIFT)),
+
+  // Clear the filter, flush the FIFO and start
+  REGIMAGE_WAIT(PDM->SYNCBUSY, _PDM_SYNCBUSY_MASK, 0),
+  REGIMAGE_WRITE(PDM->CMD, PDM_CMD_CLEAR),
+  REGIMAGE_WAIT(PDM->SYNCBUSY, _PDM_SYNCBUSY_MASK, 0),
+  REGIMAGE_WRITE(PDM->CMD, PDM_CMD_FIFOFL),
+  REGIMAGE_WAIT(PDM->SYNCBUSY, _PDM_SYNCBUSY_MASK, 0),
+  REGIMAGE_WRITE(PDM->CMD, PDM_CMD_START),
+};
+
 /***************************************************************************//**
  * @brief
  *   Sets up PDM microphones
  ******************************************************************************/
 void initPdm(void)
 {
-  PDM_Init_TypeDef pdmInit;
-
   // Set up clocks
   CMU_ClockEnable(cmuClock_GPIO, true);
   CMU_ClockEnable(cmuClock_PDM, true);
   CMU_ClockSelectSet(cmuClock_PDMREF, cmuSelect_HFRCODPLL); // 19 MHz
 
-  // Config GPIO and pin routing
-  GPIO_PinModeSet(gpioPortA, 0, gpioModePushPull, 1);    // MIC_EN
-  GPIO_PinModeSet(gpioPortC, 6, gpioModePushPull, 0);    // PDM_CLK
-  GPIO_PinModeSet(gpioPortC, 7, gpioModeInput, 0);       // PDM_DATA
-
-  GPIO_SlewrateSet(gpioPortC, 7, 7);
-
-  GPIO->PDMROUTE.ROUTEEN = GPIO_PDM_ROUTEEN_CLKPEN;
-  GPIO->PDMROUTE.CLKROUTE = (gpioPortC << _GPIO_PDM_CLKROUTE_PORT_SHIFT)
-                            | (6 << _GPIO_PDM_CLKROUTE_PIN_SHIFT);
-  GPIO->PDMROUTE.DAT0ROUTE = (gpioPortC << _GPIO_PDM_DAT0ROUTE_PORT_SHIFT)
-                            | (7 << _GPIO_PDM_DAT0ROUTE_PIN_SHIFT);
-  GPIO->PDMROUTE.DAT1ROUTE = (gpioPortC << _GPIO_PDM_DAT1ROUTE_PORT_SHIFT)
-                            | (7 << _GPIO_PDM_DAT1ROUTE_PIN_SHIFT);
-
-  // Initialize PDM registers with reset values
-  PDM_Reset(PDM);
-
-  // Configure PDM
-  pdmInit.start = true;
-  pdmInit.dsr = 32;
-  pdmInit.gain = 5;
-  pdmInit.ch0ClkPolarity = pdmCh0ClkPolarityRisingEdge;  // Normal
-  pdmInit.ch1ClkPolarity = pdmCh1ClkPolarityFallingEdge; // Invert
-  pdmInit.enableCh0Ch1Stereo = true;
-  pdmInit.fifoValidWatermark = pdmFifoValidWatermarkFour;
-  pdmInit.dataFormat = pdmDataFormatDouble16;
-  pdmInit.numChannels = pdmNumberOfChannelsTwo;
-  pdmInit.filterOrder = pdmFilterOrderFifth;
-  pdmInit.prescaler = 5;
-
-  // Initialize PDM peripheral
-  PDM_Init(PDM, &pdmInit);
+  // Config GPIO, pin routing and PDM
+  REGIMAGE_Apply(pdmImage, REGIMAGE_COUNT(pdmImage));
 }
 
 /***************************************************************************//**
@@ -165,38 +233,179 @@ void LDMA_IRQHandler(void)
 
   // Keep track of previously written buffer
   prevBufferPing = !prevBufferPing;
+
+  // Processing runs in thread mode; a buffer the scheduler has not got to
+  // by the time its queue is full is dropped and counted
+  EVSCHED_Post(EVENT_BUFFER, prevBufferPing);
 }
 
 /***************************************************************************//**
  * @brief
- *   Main function
+ *   Split stereo samples into left/right, one sample per iteration
  ******************************************************************************/
-int main(void)
+void deinterleaveScalar(const uint32_t *src, int16_t *l, int16_t *r, int n)
 {
   int i;
 
+  for(i=0; i<n; i++) {
+    l[i] = src[i] & 0x0000FFFF;
+    r[i] = (src[i] >> 16) & 0x0000FFFF;
+  }
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Split stereo samples into left/right, two samples per iteration
+ *
+ * @details
+ *   Each source word holds left in the low and right in the high half.
+ *   PKHBT combines the low halves of two words into one left pair and
+ *   PKHTB the high halves into one right pair, so a word pair costs two
+ *   loads, two pack instructions and two stores. n must be even and l/r
+ *   word aligned. Falls back to the scalar loop without the DSP extension.
+ ******************************************************************************/
+void deinterleavePacked(const uint32_t *src, int16_t *l, int16_t *r, int n)
+{
+#if defined(__ARM_FEATURE_DSP) && (__ARM_FEATURE_DSP == 1)
+  uint32_t w0, w1, pair;
+  int i;
+
+  for(i=0; i<n; i+=2) {
+    w0 = src[i];
+    w1 = src[i+1];
+    pair = __PKHBT(w0, w1, 16);   // w1.lo:w0.lo
+    memcpy(&l[i], &pair, sizeof(pair));
+    pair = __PKHTB(w1, w0, 16);   // w1.hi:w0.hi
+    memcpy(&r[i], &pair, sizeof(pair));
+  }
+#else
+  deinterleaveScalar(src, l, r, n);
+#endif
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Set up the highpass of both channels
+ ******************************************************************************/
+void initFilters(void)
+{
+  DSPFILTER_Init_TypeDef init;
+
+  init.type       = dspFilterHighpass;
+  init.sampleRate = SAMPLEFREQ;
+  init.frequency  = HIGHPASS_CORNER;
+  init.q          = 0;
+  init.length     = HIGHPASS_STAGES;
+
+  DSPFILTER_BiquadInitF32(&leftFilter, &init);
+  DSPFILTER_BiquadInitF32(&rightFilter, &init);
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Highpass one channel of a ping-pong buffer in place
+ *
+ * @details
+ *   The corner is a thousandth of the sample rate, too low for q15
+ *   coefficients, so the samples go through the filter in float.
+ ******************************************************************************/
+void highpass(DSPFILTER_BiquadF32_TypeDef *filter, int16_t *samples, int n)
+{
+  arm_q15_to_float(samples, pcm, (uint32_t)n);
+  DSPFILTER_BiquadF32(filter, pcm, pcm, (uint32_t)n);
+  arm_float_to_q15(pcm, samples, (uint32_t)n);
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Measure both deinterleave loops with the DWT cycle counter
+ ******************************************************************************/
+void benchmarkDeinterleave(void)
+{
+  uint32_t start;
+
+  CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+  DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+  start = DWT->CYCCNT;
+  deinterleaveScalar(pingBuffer, left, right, PP_BUFFER_SIZE);
+  cyclesScalar = DWT->CYCCNT - start;
+
+  start = DWT->CYCCNT;
+  deinterleavePacked(pingBuffer, left, right, PP_BUFFER_SIZE);
+  cyclesPacked = DWT->CYCCNT - start;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Process one filled ping-pong buffer, run by the scheduler
+ *
+ * @param[in] ping
+ *   1 if pingBuffer was filled, 0 for pongBuffer.
+ ******************************************************************************/
+void bufferReady(uint32_t ping)
+{
+  const uint32_t *buffer;
+  int16_t *l, *r;
+  uint32_t start;
+  bool active;
+
+  // Only the detector runs during silence, straight on the raw buffer
+  buffer = ping ? pingBuffer : pongBuffer;
+  start = DWT->CYCCNT;
+  active = VAD_Process(&vad, buffer, PP_BUFFER_SIZE);
+  cyclesVad = DWT->CYCCNT - start;
+
+  if(!active) {
+    GPIO_PinOutClear(LED_PORT, LED_PIN);
+    buffersSilent++;
+    return;
+  }
+  GPIO_PinOutSet(LED_PORT, LED_PIN);
+  buffersActive++;
+
+  // Convert data from the ping-pong buffer to left/right PCM data; the
+  // heavier processing (FFT, storage, radio) would start here too, or be
+  // posted as a lower priority event of its own
+  if(ping) {
+    l = left;
+    r = right;
+  } else {
+    l = &left[PP_BUFFER_SIZE];
+    r = &right[PP_BUFFER_SIZE];
+  }
+  deinterleavePacked(buffer, l, r, PP_BUFFER_SIZE);
+
+  start = DWT->CYCCNT;
+  highpass(&leftFilter, l, PP_BUFFER_SIZE);
+  highpass(&rightFilter, r, PP_BUFFER_SIZE);
+  cyclesFilter = DWT->CYCCNT - start;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Main function
+ ******************************************************************************/
+int main(void)
+{
   // Chip errata
   CHIP_Init();
 
+  benchmarkDeinterleave();
+
+  GPIO_PinModeSet(LED_PORT, LED_PIN, gpioModePushPull, 0);
+  VAD_Init(&vad);
+  initFilters();
+
+  // The PDM only runs in EM0 and EM1, so the scheduler sleeps in EM1
+  EVSCHED_Init();
+  EVSCHED_Register(EVENT_BUFFER, 0, bufferReady);
+  EVSCHED_EnergyModeLock(evschedEM2);
+
   // Initialize LDMA and PDM
   initLdma();
   initPdm();
 
-  while(1) {
-    EMU_EnterEM1();
-
-    // After LDMA transfer completes and wakes up device from EM1,
-    // convert data from ping-pong buffers to left/right PCM data
-    if(prevBufferPing) {
-      for(i=0; i<PP_BUFFER_SIZE; i++) {
-        left[i] = pingBuffer[i] & 0x0000FFFF;
-        right[i] = (pingBuffer[i] >> 16) & 0x0000FFFF;
-      }
-    } else {
-      for(i=0; i<PP_BUFFER_SIZE; i++) {
-        left[PP_BUFFER_SIZE + i] = pongBuffer[i] & 0x0000FFFF;
-        right[PP_BUFFER_SIZE + i] = (pongBuffer[i] >> 16) & 0x0000FFFF;
-      }
-    }
-  }
+  // Run bufferReady() for each filled buffer, in EM1 in between
+  EVSCHED_Run();
 }
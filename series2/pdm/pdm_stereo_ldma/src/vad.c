@@ -0,0 +1,166 @@
+/***************************************************************************//**
+ * @file vad.c
+ *
+ * @brief Voice activity detection on PDM stereo buffers from the energy and
+ * the zero crossings of each buffer, at a few cycles per sample.
+ *
+ * Each buffer word holds a left sample in the low and a right sample in the
+ * high half, as the PDM FIFO delivers them. One pass over the raw buffer,
+ * before any deinterleaving, subtracts the DC estimate of both channels
+ * with one QSUB16, sums the squares of both with one SMLALD and counts the
+ * sign changes of the left channel.
+ *
+ * The noise floor drops at once to a quieter buffer and rises slowly
+ * otherwise, so it follows the background level. A buffer is sound when its
+ * energy is VAD_RATIO times the floor and it has fewer zero crossings than
+ * broadband hiss; the gate then stays open for VAD_HANGOVER buffers, so the
+ * gaps between words do not close it.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2020 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ *******************************************************************************
+ * # Evaluation Quality
+ * This code has been minimally tested to ensure that it builds and is suitable
+ * as a demonstration for evaluation purposes only. This code will be maintained
+ * at the sole discretion of Silicon Labs.
+ ******************************************************************************/
+
+#include "em_device.h"
+
+#include "vad.h"
+
+/***************************************************************************//**
+ * @brief
+ *   Reset the detector, the gate closed
+ ******************************************************************************/
+void VAD_Init(VAD_State_t *vad)
+{
+  vad->dcLeft = 0;
+  vad->dcRight = 0;
+  vad->energy = 0;
+  vad->noise = UINT32_MAX;
+  vad->crossings = 0;
+  vad->hangover = 0;
+  vad->started = false;
+  vad->active = false;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Saturate to a signed 16 bit half
+ ******************************************************************************/
+static uint32_t half(int32_t x)
+{
+  if (x > INT16_MAX) {
+    x = INT16_MAX;
+  } else if (x < INT16_MIN) {
+    x = INT16_MIN;
+  }
+  return (uint16_t)x;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Run the detector on one buffer of stereo samples
+ *
+ * @param[in] src
+ *   n words, left in the low and right in the high half.
+ *
+ * @return
+ *   true while the gate is open: this buffer had sound, or one of the last
+ *   VAD_HANGOVER buffers did.
+ ******************************************************************************/
+bool VAD_Process(VAD_State_t *vad, const uint32_t *src, int n)
+{
+  uint32_t dc = (half(vad->dcRight) << 16) | half(vad->dcLeft);
+  uint32_t crossings = 0;
+  uint32_t prev, x;
+  int32_t sumLeft = 0, sumRight = 0;
+  uint64_t squares = 0;
+  bool sound;
+  int i;
+
+  if (n <= 0) {
+    return vad->active;
+  }
+
+  prev = src[0];
+  for (i = 0; i < n; i++) {
+    sumLeft += (int16_t)src[i];
+    sumRight += (int16_t)(src[i] >> 16);
+
+#if defined(__ARM_FEATURE_DSP) && (__ARM_FEATURE_DSP == 1)
+    x = __QSUB16(src[i], dc);
+    squares = __SMLALD(x, x, squares);
+#else
+    {
+      int32_t l = (int16_t)src[i] - (int16_t)dc;
+      int32_t r = (int16_t)(src[i] >> 16) - (int16_t)(dc >> 16);
+
+      x = (half(r) << 16) | half(l);
+      l = (int16_t)x;
+      r = (int16_t)(x >> 16);
+      squares += (uint64_t)(l * l) + (uint64_t)(r * r);
+    }
+#endif
+
+    // Sign change of the left half
+    crossings += ((x ^ prev) >> 15) & 1;
+    prev = x;
+  }
+
+  // The first buffer sets the DC estimate, later ones move it
+  if (!vad->started) {
+    vad->dcLeft = sumLeft / n;
+    vad->dcRight = sumRight / n;
+    vad->started = true;
+  } else {
+    vad->dcLeft += (sumLeft / n - vad->dcLeft) >> VAD_DC_SHIFT;
+    vad->dcRight += (sumRight / n - vad->dcRight) >> VAD_DC_SHIFT;
+  }
+
+  vad->energy = (uint32_t)(squares / (2 * (uint32_t)n));
+  vad->crossings = crossings;
+
+  sound = (vad->energy >= VAD_ENERGY_MIN)
+          && ((uint64_t)vad->energy >= (uint64_t)vad->noise * VAD_RATIO)
+          && (crossings * 256 <= (uint32_t)n * VAD_CROSSINGS_MAX);
+
+  // Down at once, up slowly, never below the energy that can be sound
+  if (vad->energy < vad->noise) {
+    vad->noise = (vad->energy > VAD_ENERGY_MIN) ? vad->energy : VAD_ENERGY_MIN;
+  } else if (vad->noise < (UINT32_MAX / VAD_RATIO)) {
+    vad->noise += (vad->noise >> VAD_NOISE_SHIFT) + 1;
+  }
+
+  if (sound) {
+    vad->hangover = VAD_HANGOVER;
+  } else if (vad->hangover > 0) {
+    vad->hangover--;
+  }
+  vad->active = sound || (vad->hangover > 0);
+
+  return vad->active;
+}
@@ -42,9 +42,7 @@
 #include "em_emu.h"
 
 #include "bsp.h"
-
-#define PRS_CH_A   6
-#define PRS_CH_B   1
+#include "prsgraph.h"
 
 /**************************************************************************//**
  * @brief GPIO initialization
@@ -75,31 +73,34 @@ void initGpio(void)
  *****************************************************************************/
 void initPrs(void)
 {
-  // Enable PRS clock
-  CMU_ClockEnable(cmuClock_PRS, true);
+  int pb0, out;
 
-  // Use Push Buttons as PRS source
-  // Push Button 0
-  PRS_SourceAsyncSignalSet(
-        PRS_CH_B,
-        PRS_ASYNC_CH_CTRL_SOURCESEL_GPIO,
-        BSP_GPIO_PB0_PIN);
+  /*
+   * Declare the links and let prsgraph pick the channels. Push Button 1
+   * is input A of the logic function and Push Button 0 input B, and the
+   * output drives LED1. The channels chosen meet the restrictions of
+   * the device: on EFR32xG21/xG24 input B must come from the channel
+   * just below input A, and only some channels can be routed to the LED
+   * pin.
+   */
+  PRSGRAPH_Init();
 
-  // Push Button 1
-  PRS_SourceAsyncSignalSet(
-        PRS_CH_A,
-        PRS_ASYNC_CH_CTRL_SOURCESEL_GPIO,
-        BSP_GPIO_PB1_PIN);
+  // Push Button 0
+  pb0 = PRSGRAPH_Source(PRS_ASYNC_CH_CTRL_SOURCESEL_GPIO, BSP_GPIO_PB0_PIN);
 
-  // Configure PRS logic
-  PRS_Combine(PRS_CH_A, PRS_CH_B, prsLogic_A_OR_B);
+  // Push Button 1, combined with Push Button 0 by the PRS logic
+  out = PRSGRAPH_Logic(PRS_ASYNC_CH_CTRL_SOURCESEL_GPIO, BSP_GPIO_PB1_PIN,
+                       pb0, prsLogic_A_OR_B);
 
   // Route output to LED1
-  PRS_PinOutput(PRS_CH_A, prsTypeAsync, BSP_GPIO_LED1_PORT, BSP_GPIO_LED1_PIN);
-  /* Note that there are certain restrictions to where a PRS channel can be
-   *   routed. Consult the datasheet of the device to see if a channel can be
-   *   routed to the requested GPIO pin.
-   */
+  PRSGRAPH_Pin(out, BSP_GPIO_LED1_PORT, BSP_GPIO_LED1_PIN);
+
+  // Allocate the channels and configure the PRS
+  if (!PRSGRAPH_Build())
+  {
+    // The graph does not fit the channels of this device
+    while (1);
+  }
 }
 
 /**************************************************************************//**
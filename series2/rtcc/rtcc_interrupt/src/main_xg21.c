@@ -40,21 +40,39 @@
 #include "em_emu.h"
 #include "em_prs.h"
 #include "em_rtcc.h"
+#include "swtimer.h"
 #include "bsp.h"
 
 // Defines
 #define RTCC_CLOCK              cmuSelect_LFXO  // RTCC clock source
 #define RTCC_PRS_CH             0               // RTCC PRS output channel
-#define WAKEUP_INTERVAL_MS      500             // Wake up interval in ms
+
+// Virtual timers. Slack lets a timer run late to share a wakeup.
+#define HEARTBEAT_PERIOD_MS     500             // No slack, always on time
+#define SENSOR_PERIOD_MS        1000            // Simulated sensor read
+#define SENSOR_SLACK_MS         100
+#define REPORT_PERIOD_MS        1100            // Simulated radio report
+#define REPORT_SLACK_MS         100
+#define STATS_INTERVAL_MS       10000           // Statistics update
+
+// Timers and their expiry counts
+static SWTIMER_Timer_t heartbeatTimer, sensorTimer, reportTimer;
+volatile uint32_t heartbeats, sensorReads, reports;
+
+// RTCC wakeups and timer expiries, updated every STATS_INTERVAL_MS
+uint32_t wakeups, expiries;
 
 /**************************************************************************//**
  * @brief  
- *   RTCC Interrupt Handler, clears the flag.
+ *   Timer callback, counts the expiries of one timer.
+ * @param[in] data
+ *   The expiry count of the timer.
  *****************************************************************************/
-void RTCC_IRQHandler(void)
+void countExpiry(SWTIMER_Timer_t *timer, void *data)
 {
-  // Clear interrupt source CC1
-  RTCC_IntClear(RTCC_IF_CC1);
+  (void)timer;
+
+  (*(volatile uint32_t *)data)++;
 }
 
 /**************************************************************************//**
@@ -66,9 +84,6 @@ void RTCC_IRQHandler(void)
  *****************************************************************************/
 void setupRtcc(CMU_Select_TypeDef rtccClock)
 {
-  RTCC_Init_TypeDef rtccInit = RTCC_INIT_DEFAULT;
-  RTCC_CCChConf_TypeDef rtccInitCompareChannel = RTCC_CH_INIT_COMPARE_DEFAULT;
-
   if (rtccClock == cmuSelect_LFXO) {
     // Initialize LFXO with specific parameters
     CMU_LFXOInit_TypeDef lfxoInit = CMU_LFXOINIT_DEFAULT;
@@ -78,26 +93,11 @@ void setupRtcc(CMU_Select_TypeDef rtccClock)
   // Setting RTCC clock source
   CMU_ClockSelectSet(cmuClock_RTCCCLK, rtccClock);
 
-  // Initialize CC1 to toggle PRS output on compare match
-  rtccInitCompareChannel.compMatchOutAction = rtccCompMatchOutActionToggle;
-  RTCC_ChannelInit(1, &rtccInitCompareChannel);
-
-  // Setting the CC1 compare value of the RTCC
-  if (rtccClock == cmuSelect_ULFRCO) {
-    RTCC_ChannelCCVSet(1, (1000 * WAKEUP_INTERVAL_MS) / 1000 - 1);
-  } else {
-    RTCC_ChannelCCVSet(1, (32768 * WAKEUP_INTERVAL_MS) / 1000 - 1);
-  }
-
-  // Initialize the RTCC
-  rtccInit.cntWrapOnCCV1 = true;        // Clear counter on CC1 compare match
-  rtccInit.presc = rtccCntPresc_1;      // Prescaler 1
-  RTCC_Init(&rtccInit);
-
-  // Enabling Interrupt from RTCC CC1
-  RTCC_IntEnable(RTCC_IEN_CC1);
-  NVIC_ClearPendingIRQ(RTCC_IRQn);
-  NVIC_EnableIRQ(RTCC_IRQn);
+  /*
+   * Start the RTCC counting freely for the software timers.  Each compare
+   * match on CC1, one per wakeup, toggles the CC1 PRS output.
+   */
+  SWTIMER_Init();
 }
 
 /**************************************************************************//**
@@ -119,12 +119,24 @@ int main(void)
   PRS_PinOutput(RTCC_PRS_CH, prsTypeAsync, BSP_GPIO_LED1_PORT,
                 BSP_GPIO_LED1_PIN);
 
+  // Start the timers, all in the same tick
+  SWTIMER_Start(&heartbeatTimer, SWTIMER_MsToTicks(HEARTBEAT_PERIOD_MS),
+                SWTIMER_MsToTicks(HEARTBEAT_PERIOD_MS), 0,
+                countExpiry, (void *)&heartbeats);
+  SWTIMER_Start(&sensorTimer, SWTIMER_MsToTicks(SENSOR_PERIOD_MS),
+                SWTIMER_MsToTicks(SENSOR_PERIOD_MS),
+                SWTIMER_MsToTicks(SENSOR_SLACK_MS),
+                countExpiry, (void *)&sensorReads);
+  SWTIMER_Start(&reportTimer, SWTIMER_MsToTicks(REPORT_PERIOD_MS),
+                SWTIMER_MsToTicks(REPORT_PERIOD_MS),
+                SWTIMER_MsToTicks(REPORT_SLACK_MS),
+                countExpiry, (void *)&reports);
+
   while (1) {
-    // Forever enter EM2 or EM3
-    if (CMU_ClockSelectGet(cmuClock_RTCCCLK) == cmuSelect_ULFRCO) {
-      EMU_EnterEM3(false);
-    } else {
-      EMU_EnterEM2(false);
-    }
+    // Sleep in EM2 or EM3, depending on the RTCC clock source
+    SWTIMER_DelayMs(STATS_INTERVAL_MS);
+
+    wakeups = SWTIMER_GetWakeupCount();
+    expiries = SWTIMER_GetExpiryCount();
   }
 }
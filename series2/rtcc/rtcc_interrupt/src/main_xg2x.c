@@ -40,6 +40,7 @@
 #include "em_emu.h"
 #include "em_prs.h"
 #include "em_rtcc.h"
+#include "swtimer.h"
 #include "mx25flash_spi.h"
 #include "bsp.h"
 
@@ -56,7 +57,20 @@
 
 #define RTCC_CLOCK              cmuSelect_LFXO    // RTCC clock source
 #define RTCC_PRS_CH             0                 // RTCC PRS output channel
-#define WAKEUP_INTERVAL_MS      500               // Wake up interval in ms
+
+/**************************************************************************//**
+ * Virtual timers on the RTCC. Each one expires from the RTCC interrupt with
+ * no periodic tick in between. A timer with slack may run that much late so
+ * that it shares a wakeup with a later one: the report timer drifts against
+ * the others and joins the wakeup of the next heartbeat or sensor timer when
+ * it is close enough.
+ *****************************************************************************/
+#define HEARTBEAT_PERIOD_MS     500               // No slack, always on time
+#define SENSOR_PERIOD_MS        1000              // Simulated sensor read
+#define SENSOR_SLACK_MS         100
+#define REPORT_PERIOD_MS        1100              // Simulated radio report
+#define REPORT_SLACK_MS         100
+#define STATS_INTERVAL_MS       10000             // Statistics update
 
 /**************************************************************************//**
  * A JEDEC standard SPI flash boots up in standby mode in order to
@@ -80,14 +94,24 @@ void powerDownSpiFlash(void)
   MX25_deinit();
 }
 
+// Timers and their expiry counts
+static SWTIMER_Timer_t heartbeatTimer, sensorTimer, reportTimer;
+volatile uint32_t heartbeats, sensorReads, reports;
+
+// RTCC wakeups and timer expiries, updated every STATS_INTERVAL_MS
+uint32_t wakeups, expiries;
+
 /**************************************************************************//**
  * @brief  
- *   RTCC Interrupt Handler, clears the flag.
+ *   Timer callback, counts the expiries of one timer.
+ * @param[in] data
+ *   The expiry count of the timer.
  *****************************************************************************/
-void RTCC_IRQHandler(void)
+void countExpiry(SWTIMER_Timer_t *timer, void *data)
 {
-  // Clear interrupt source CC1
-  RTCC_IntClear(RTCC_IF_CC1);
+  (void)timer;
+
+  (*(volatile uint32_t *)data)++;
 }
 
 /**************************************************************************//**
@@ -100,10 +124,6 @@ void RTCC_IRQHandler(void)
  *****************************************************************************/
 void setupRtcc(CMU_Select_TypeDef rtccClock)
 {
-  // Configure the RTCC with default parameters
-  RTCC_Init_TypeDef rtccInit = RTCC_INIT_DEFAULT;
-  RTCC_CCChConf_TypeDef rtccInitCompareChannel = RTCC_CH_INIT_COMPARE_DEFAULT;
-
   // Check RTCC clock source
   if (rtccClock == cmuSelect_LFXO) {
     // Initialize LFXO with specific parameters
@@ -114,39 +134,11 @@ void setupRtcc(CMU_Select_TypeDef rtccClock)
   // Setting RTCC clock source
   CMU_ClockSelectSet(cmuClock_RTCCCLK, rtccClock);
 
-  // Enable RTCC bus clock
-  CMU_ClockEnable(cmuClock_RTCC, true);
-
-  // Initialize Capture Compare Channel 1 to toggle PRS output on compare match
-  rtccInitCompareChannel.compMatchOutAction = rtccCompMatchOutActionToggle;
-  RTCC_ChannelInit(1, &rtccInitCompareChannel);
-
-  /**********************************************************************//**
-   * Set RTCC Capture Compare Value to the frequency of the
-   * LFXO/ULFRCO(minus 1).
-   *
-   * When the pre-counter (RTCC_PRECNT) matches this value, the counter
-   * (RTCC_CNT) increments by one.
-   *************************************************************************/
-  if (rtccClock == cmuSelect_ULFRCO) {
-    //Setting the CC1 compare value of the RTCC
-    RTCC_ChannelCCVSet(1, (1000 * WAKEUP_INTERVAL_MS) / 1000 - 1);
-  } else {
-    //Setting the CC1 compare value of the RTCC
-    RTCC_ChannelCCVSet(1, (32768 * WAKEUP_INTERVAL_MS) / 1000 - 1);
-  }
-
-  // Initialize the RTCC
-  rtccInit.cntWrapOnCCV1 = true;        // Clear counter on CC1 compare match
-  rtccInit.presc = rtccCntPresc_1;      // Prescaler 1
-
-  // Initialize and start counting
-  RTCC_Init(&rtccInit);
-
-  // Enabling Interrupt from RTCC CC1
-  RTCC_IntEnable(RTCC_IEN_CC1);
-  NVIC_ClearPendingIRQ(RTCC_IRQn);
-  NVIC_EnableIRQ(RTCC_IRQn);
+  /*
+   * Start the RTCC counting freely for the software timers.  Each compare
+   * match on CC1, one per wakeup, toggles the CC1 PRS output.
+   */
+  SWTIMER_Init();
 }
 
 /**************************************************************************//**
@@ -216,23 +208,28 @@ int main(void)
                            PRS_ASYNC_CH_CTRL_SIGSEL_RTCCCCV1);
   PRS_PinOutput(RTCC_PRS_CH, prsTypeAsync, PRS_Output_Port, PRS_Output_Pin);
 
-  /**********************************************************************//**
-   * Power down first 24 KB to reduce current in EM2/3.
-   *
-   * NOTE: The top 8 KB of RAM (BLK1) **MUST** remain powered in EM2/3
-   * (SYSCFG_DMEM0RETNCTRL_RAMRETNCTRL != 2) or the device is liable to
-   * hard fault on wake-up depending on what data may have been saved
-   * on the stack, e.g. the return address from the EMU_EnterEM3() call
-   * below.
-   *************************************************************************/
-  EMU_RamPowerDown(SRAM_BASE, SRAM_BASE + SRAM_SIZE - 0x2000);
+  /*
+   * Start the timers, all in the same tick.  The timers and their list
+   * live in RAM and must survive each sleep, so no RAM is powered down
+   * in EM2/3.
+   */
+  SWTIMER_Start(&heartbeatTimer, SWTIMER_MsToTicks(HEARTBEAT_PERIOD_MS),
+                SWTIMER_MsToTicks(HEARTBEAT_PERIOD_MS), 0,
+                countExpiry, (void *)&heartbeats);
+  SWTIMER_Start(&sensorTimer, SWTIMER_MsToTicks(SENSOR_PERIOD_MS),
+                SWTIMER_MsToTicks(SENSOR_PERIOD_MS),
+                SWTIMER_MsToTicks(SENSOR_SLACK_MS),
+                countExpiry, (void *)&sensorReads);
+  SWTIMER_Start(&reportTimer, SWTIMER_MsToTicks(REPORT_PERIOD_MS),
+                SWTIMER_MsToTicks(REPORT_PERIOD_MS),
+                SWTIMER_MsToTicks(REPORT_SLACK_MS),
+                countExpiry, (void *)&reports);
 
   while (1) {
-    // Forever enter EM2 or EM3 depending on RTCC clock source
-    if (CMU_ClockSelectGet(cmuClock_RTCCCLK) == cmuSelect_ULFRCO) {
-      EMU_EnterEM3(false);
-    } else {
-      EMU_EnterEM2(false);
-    }
+    // Sleep in EM2 or EM3, depending on the RTCC clock source
+    SWTIMER_DelayMs(STATS_INTERVAL_MS);
+
+    wakeups = SWTIMER_GetWakeupCount();
+    expiries = SWTIMER_GetExpiryCount();
   }
 }
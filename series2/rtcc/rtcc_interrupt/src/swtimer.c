@@ -0,0 +1,402 @@
+/***************************************************************************//**
+ * @file swtimer.c
+ * @brief Tickless software timers on one RTCC compare channel.
+ *
+ * @details
+ *   The RTCC counts freely and any number of caller owned timers wait on
+ *   it in a list sorted by deadline. Only the next wakeup is programmed
+ *   into the compare channel, so the device sleeps from one deadline to
+ *   the next with no periodic tick.
+ *
+ *   A timer may run up to its slack late. The next wakeup is moved from
+ *   the first deadline to the latest later deadline that every timer
+ *   before it can still wait for, and all timers due by then expire in
+ *   the same interrupt.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2021 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ******************************************************************************/
+
+#include <stddef.h>
+#include "em_device.h"
+#include "em_cmu.h"
+#include "em_core.h"
+#include "em_emu.h"
+#include "em_rtcc.h"
+#include "swtimer.h"
+
+// Soonest the compare can be set ahead of the counter and still match
+#define MIN_LEAD_TICKS    3
+
+#define CC_IF             (RTCC_IF_CC0 << SWTIMER_CC_CHANNEL)
+#define CC_IEN            (RTCC_IEN_CC0 << SWTIMER_CC_CHANNEL)
+
+static SWTIMER_Timer_t *head;
+static uint32_t ticksPerSecond;
+
+static volatile uint32_t wakeupCount;
+static volatile uint32_t expiryCount;
+
+/***************************************************************************//**
+ * @brief
+ *   Compare two counter values across the 32-bit wrap.
+ *
+ * @return
+ *   true if a is before b.
+ ******************************************************************************/
+static bool before(uint32_t a, uint32_t b)
+{
+  return (int32_t)(a - b) < 0;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Insert a timer into the list, after any timers with the same deadline.
+ ******************************************************************************/
+static void insert(SWTIMER_Timer_t *timer)
+{
+  SWTIMER_Timer_t **link = &head;
+
+  while ((*link != NULL) && !before(timer->deadline, (*link)->deadline)) {
+    link = &(*link)->next;
+  }
+
+  timer->next = *link;
+  *link = timer;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Remove a timer from the list if it is in it.
+ ******************************************************************************/
+static void unlink(SWTIMER_Timer_t *timer)
+{
+  SWTIMER_Timer_t **link;
+
+  for (link = &head; *link != NULL; link = &(*link)->next) {
+    if (*link == timer) {
+      *link = timer->next;
+      break;
+    }
+  }
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Program the compare channel for the next wakeup.
+ *
+ * @details
+ *   The wakeup starts at the first deadline and moves on to each later
+ *   deadline that is no later than the earliest deadline + slack of the
+ *   timers taken in so far. Called with interrupts disabled.
+ ******************************************************************************/
+static void program(void)
+{
+  SWTIMER_Timer_t *timer;
+  uint32_t wake, limit, now;
+
+  if (head == NULL) {
+    RTCC_IntDisable(CC_IEN);
+    return;
+  }
+
+  wake = head->deadline;
+  limit = head->deadline + head->slack;
+
+  for (timer = head->next;
+       (timer != NULL) && !before(limit, timer->deadline);
+       timer = timer->next) {
+    wake = timer->deadline;
+    if (before(timer->deadline + timer->slack, limit)) {
+      limit = timer->deadline + timer->slack;
+    }
+  }
+
+  now = RTCC_CounterGet();
+  if (before(wake, now + MIN_LEAD_TICKS)) {
+    wake = now + MIN_LEAD_TICKS;
+  }
+
+  RTCC_ChannelCCVSet(SWTIMER_CC_CHANNEL, wake);
+  RTCC_IntClear(CC_IF);
+  RTCC_IntEnable(CC_IEN);
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Sleep until the next interrupt, in EM3 if the RTCC runs from the
+ *   ULFRCO and in EM2 otherwise.
+ ******************************************************************************/
+static void enterSleep(void)
+{
+  if (CMU_ClockSelectGet(cmuClock_RTCCCLK) == cmuSelect_ULFRCO) {
+    EMU_EnterEM3(true);
+  } else {
+    EMU_EnterEM2(true);
+  }
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Timer callback of SWTIMER_DelayMs().
+ ******************************************************************************/
+static void delayExpired(SWTIMER_Timer_t *timer, void *data)
+{
+  (void)timer;
+
+  *(volatile bool *)data = true;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   RTCC interrupt, expires every timer that is due.
+ *
+ * @details
+ *   Periodic timers are put back before their callback runs, so a
+ *   callback can stop or restart its own timer. A periodic timer that has
+ *   fallen a whole period behind restarts from now rather than expiring
+ *   several times in a row.
+ ******************************************************************************/
+void RTCC_IRQHandler(void)
+{
+  SWTIMER_Timer_t *timer;
+  uint32_t now;
+
+  RTCC_IntClear(CC_IF);
+  wakeupCount++;
+
+  now = RTCC_CounterGet();
+
+  while ((head != NULL) && !before(now, head->deadline)) {
+    timer = head;
+    head = timer->next;
+
+    if (timer->period != 0) {
+      timer->deadline += timer->period;
+      if (!before(now, timer->deadline)) {
+        timer->deadline = now + timer->period;
+      }
+      insert(timer);
+    } else {
+      timer->running = false;
+    }
+
+    expiryCount++;
+
+    if (timer->callback != NULL) {
+      timer->callback(timer, timer->data);
+    }
+  }
+
+  program();
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Start the RTCC counting freely and take over its compare channel.
+ *
+ * @details
+ *   The RTCC clock must already be selected. Each wakeup also toggles the
+ *   PRS output of the compare channel.
+ ******************************************************************************/
+void SWTIMER_Init(void)
+{
+  RTCC_Init_TypeDef rtccInit = RTCC_INIT_DEFAULT;
+  RTCC_CCChConf_TypeDef compare = RTCC_CH_INIT_COMPARE_DEFAULT;
+
+  CMU_ClockEnable(cmuClock_RTCC, true);
+  ticksPerSecond = CMU_ClockFreqGet(cmuClock_RTCCCLK);
+
+  compare.compMatchOutAction = rtccCompMatchOutActionToggle;
+  RTCC_ChannelInit(SWTIMER_CC_CHANNEL, &compare);
+
+  rtccInit.presc = rtccCntPresc_1;
+  RTCC_Init(&rtccInit);
+
+  head = NULL;
+  wakeupCount = 0;
+  expiryCount = 0;
+
+  RTCC_IntDisable(CC_IEN);
+  RTCC_IntClear(CC_IF);
+  NVIC_ClearPendingIRQ(RTCC_IRQn);
+  NVIC_EnableIRQ(RTCC_IRQn);
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Start or restart a timer.
+ *
+ * @param[in] timer
+ *   Timer to start, owned by the caller until it expires or is stopped.
+ *
+ * @param[in] timeout
+ *   RTCC ticks to the first expiry.
+ *
+ * @param[in] period
+ *   RTCC ticks between later expiries, 0 for a one shot timer.
+ *
+ * @param[in] slack
+ *   RTCC ticks the timer may run late by to share a wakeup.
+ *
+ * @param[in] callback
+ *   Called from the RTCC interrupt on each expiry, may be NULL.
+ *
+ * @param[in] data
+ *   Passed to the callback.
+ *
+ * @return
+ *   false if a time is longer than SWTIMER_MAX_TICKS.
+ ******************************************************************************/
+bool SWTIMER_Start(SWTIMER_Timer_t *timer,
+                   uint32_t timeout,
+                   uint32_t period,
+                   uint32_t slack,
+                   SWTIMER_Callback_t callback,
+                   void *data)
+{
+  CORE_DECLARE_IRQ_STATE;
+
+  if ((timer == NULL)
+      || (timeout > SWTIMER_MAX_TICKS)
+      || (period > SWTIMER_MAX_TICKS)
+      || (slack > SWTIMER_MAX_TICKS)) {
+    return false;
+  }
+
+  CORE_ENTER_CRITICAL();
+
+  unlink(timer);
+
+  timer->deadline = RTCC_CounterGet() + timeout;
+  timer->period = period;
+  timer->slack = slack;
+  timer->callback = callback;
+  timer->data = data;
+  timer->running = true;
+
+  insert(timer);
+  program();
+
+  CORE_EXIT_CRITICAL();
+
+  return true;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Stop a timer, nothing happens if it is not running.
+ ******************************************************************************/
+void SWTIMER_Stop(SWTIMER_Timer_t *timer)
+{
+  CORE_DECLARE_IRQ_STATE;
+
+  CORE_ENTER_CRITICAL();
+
+  unlink(timer);
+  timer->running = false;
+  program();
+
+  CORE_EXIT_CRITICAL();
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Check whether a timer is waiting to expire.
+ ******************************************************************************/
+bool SWTIMER_IsRunning(const SWTIMER_Timer_t *timer)
+{
+  return timer->running;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Sleep for a number of milliseconds, other timers keep running.
+ *
+ * @details
+ *   Replaces a SysTick based delay; the device sleeps in EM2 or EM3 until
+ *   the delay is over and wakes up only for other timers. Must not be
+ *   called from a timer callback.
+ ******************************************************************************/
+void SWTIMER_DelayMs(uint32_t ms)
+{
+  SWTIMER_Timer_t timer;
+  volatile bool done = false;
+  CORE_DECLARE_IRQ_STATE;
+
+  timer.running = false;
+  if (!SWTIMER_Start(&timer, SWTIMER_MsToTicks(ms), 0, 0,
+                     delayExpired, (void *)&done)) {
+    return;
+  }
+
+  while (!done) {
+    // Check and sleep with interrupts off so the wakeup cannot be missed
+    CORE_ENTER_CRITICAL();
+    if (!done) {
+      enterSleep();
+    }
+    CORE_EXIT_CRITICAL();
+  }
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Convert milliseconds to RTCC ticks, rounded up.
+ ******************************************************************************/
+uint32_t SWTIMER_MsToTicks(uint32_t ms)
+{
+  uint64_t ticks = (((uint64_t)ms * ticksPerSecond) + 999) / 1000;
+
+  return (ticks > SWTIMER_MAX_TICKS) ? SWTIMER_MAX_TICKS : (uint32_t)ticks;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Get the RTCC count the timers run on.
+ ******************************************************************************/
+uint32_t SWTIMER_GetTicks(void)
+{
+  return RTCC_CounterGet();
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Get the number of RTCC wakeups since SWTIMER_Init().
+ ******************************************************************************/
+uint32_t SWTIMER_GetWakeupCount(void)
+{
+  return wakeupCount;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Get the number of timer expiries since SWTIMER_Init(). More expiries
+ *   than wakeups means deadlines were coalesced.
+ ******************************************************************************/
+uint32_t SWTIMER_GetExpiryCount(void)
+{
+  return expiryCount;
+}
@@ -0,0 +1,68 @@
+/***************************************************************************//**
+ * @file burstseq.h
+ *
+ * @brief TIMER0 burst sequencer on two compare channels, started by the PRS
+ * and reloaded by the LDMA.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2022 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ ******************************************************************************/
+
+#ifndef BURSTSEQ_H
+#define BURSTSEQ_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "em_gpio.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Output channels, TIMER0 CC1 and CC2; CC0 takes the trigger
+#define BSEQ_OUTPUTS          2
+
+// First of the LDMA channels, one per output
+#define BSEQ_LDMA_CHANNEL     0
+
+// Longest burst of an output, two words of RAM per pulse
+#ifndef BSEQ_MAX_PULSES
+#define BSEQ_MAX_PULSES       32
+#endif
+
+// Fewest timer clocks between two edges of an output, for the LDMA to load
+// the compare value of the next edge
+#define BSEQ_MIN_GAP          32
+
+/*
+ * Burst of one output, in timer clocks: pulses pulses of high clocks, one
+ * every period clocks, the first rising edge delay clocks after the
+ * trigger. An output with no pulses stays low.
+ */
+typedef struct {
+  uint32_t delay;
+  uint32_t high;
+  uint32_t period;
+  uint32_t pulses;
+} BSEQ_Burst_t;
+
+typedef struct {
+  unsigned int prsChannel;                  // Trigger, rising edge
+  GPIO_Port_TypeDef port[BSEQ_OUTPUTS];     // Output pins
+  unsigned int pin[BSEQ_OUTPUTS];
+  BSEQ_Burst_t burst[BSEQ_OUTPUTS];
+} BSEQ_Init_t;
+
+bool BSEQ_Init(const BSEQ_Init_t *init);
+uint32_t BSEQ_Length(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // BURSTSEQ_H
@@ -0,0 +1,234 @@
+/***************************************************************************//**
+ * @file burstseq.c
+ *
+ * @brief TIMER0 burst sequencer on two compare channels, started by the PRS
+ * and reloaded by the LDMA.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2022 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ *******************************************************************************
+ * # Evaluation Quality
+ * This code has been minimally tested to ensure that it builds and is suitable 
+ * as a demonstration for evaluation purposes only. This code will be maintained
+ * at the sole discretion of Silicon Labs.
+ ******************************************************************************/
+
+
+#include "em_device.h"
+#include "em_cmu.h"
+#include "em_ldma.h"
+#include "em_prs.h"
+#include "em_timer.h"
+
+#include "burstseq.h"
+
+// Edges of the burst of each output
+static uint32_t edges[BSEQ_OUTPUTS][2 * BSEQ_MAX_PULSES];
+static LDMA_Descriptor_t descriptors[BSEQ_OUTPUTS];
+
+// Top value, the timer stops at the overflow after the last edge
+static uint32_t burstLength;
+
+static const LDMA_PeripheralSignal_t compareSignal[BSEQ_OUTPUTS] = {
+  ldmaPeripheralSignal_TIMER0_CC1, ldmaPeripheralSignal_TIMER0_CC2
+};
+
+/**************************************************************************//**
+ * @brief
+ *   Check a burst and get its last edge
+ *
+ * @return
+ *   false if the burst does not fit the timer or the LDMA reload.
+ *****************************************************************************/
+static bool checkBurst(const BSEQ_Burst_t *burst, uint32_t *last)
+{
+  uint64_t end;
+
+  if (burst->pulses == 0) {
+    *last = 0;
+    return true;
+  }
+
+  if ((burst->pulses > BSEQ_MAX_PULSES)
+      || (burst->delay < 1)
+      || (burst->high < BSEQ_MIN_GAP)
+      || ((burst->pulses > 1)
+          && ((burst->period < burst->high)
+              || ((burst->period - burst->high) < BSEQ_MIN_GAP)))) {
+    return false;
+  }
+
+  end = (uint64_t)burst->delay
+        + ((uint64_t)(burst->pulses - 1) * burst->period) + burst->high;
+  if (end + BSEQ_MIN_GAP > TIMER_MaxCount(TIMER0)) {
+    return false;
+  }
+
+  *last = (uint32_t)end;
+  return true;
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Set up one output: compare mode toggling on each match, and the LDMA
+ *   channel that loads the compare value of the next edge
+ *
+ * @details
+ *   The first edge is loaded here. On each match the LDMA writes the next
+ *   edge to CC[n].OC, and after the last edge the first one again, which
+ *   the counter does not reach until the next trigger restarts it from 0.
+ *   The descriptor links to itself, so every burst plays the same table.
+ *****************************************************************************/
+static void initOutput(unsigned int output, const BSEQ_Init_t *init)
+{
+  const BSEQ_Burst_t *burst = &init->burst[output];
+  TIMER_InitCC_TypeDef ccInit = TIMER_INITCC_DEFAULT;
+  LDMA_TransferCfg_t compareCfg =
+    LDMA_TRANSFER_CFG_PERIPHERAL(compareSignal[output]);
+  unsigned int cc = output + 1;
+  uint32_t count = 2 * burst->pulses;
+  uint32_t i, rise;
+
+  GPIO_PinModeSet(init->port[output], init->pin[output], gpioModePushPull, 0);
+
+  if (burst->pulses == 0) {
+    return;
+  }
+
+  // Table order: edge 1 to the last edge, then edge 0
+  for (i = 0; i < burst->pulses; i++) {
+    rise = burst->delay + (i * burst->period);
+    edges[output][(2 * i + count - 1) % count] = rise;
+    edges[output][2 * i] = rise + burst->high;
+  }
+
+  ccInit.mode = timerCCModeCompare;
+  ccInit.cmoa = timerOutputActionToggle;
+  TIMER_InitCC(TIMER0, cc, &ccInit);
+  TIMER_CompareSet(TIMER0, cc, edges[output][count - 1]);
+
+  descriptors[output] = (LDMA_Descriptor_t)
+    LDMA_DESCRIPTOR_LINKREL_M2P_BYTE(edges[output], &TIMER0->CC[cc].OC,
+                                     count, 0);
+  descriptors[output].xfer.size = ldmaCtrlSizeWord;
+  LDMA_StartTransfer(BSEQ_LDMA_CHANNEL + output, &compareCfg,
+                     &descriptors[output]);
+
+  if (cc == 1) {
+    GPIO->TIMERROUTE[0].ROUTEEN |= GPIO_TIMER_ROUTEEN_CC1PEN;
+    GPIO->TIMERROUTE[0].CC1ROUTE =
+      (init->port[output] << _GPIO_TIMER_CC1ROUTE_PORT_SHIFT)
+      | (init->pin[output] << _GPIO_TIMER_CC1ROUTE_PIN_SHIFT);
+  } else {
+    GPIO->TIMERROUTE[0].ROUTEEN |= GPIO_TIMER_ROUTEEN_CC2PEN;
+    GPIO->TIMERROUTE[0].CC2ROUTE =
+      (init->port[output] << _GPIO_TIMER_CC2ROUTE_PORT_SHIFT)
+      | (init->pin[output] << _GPIO_TIMER_CC2ROUTE_PIN_SHIFT);
+  }
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Set up TIMER0 and the LDMA to play a burst on each rising edge of the
+ *   trigger
+ *
+ * @details
+ *   TIMER0 runs one shot: a rising edge of the PRS channel on CC0 reloads
+ *   and starts the counter from 0, and the counter stops again at the
+ *   overflow after the last edge. Every edge is a compare match of the
+ *   counter, so the edges of both outputs keep their times from the start
+ *   to the clock, whatever the CPU and the rest of the system are doing.
+ *   The start itself is one timer clock uncertain, the trigger being
+ *   synchronized to the timer clock.
+ *
+ *   A trigger during a burst restarts the counter but not the tables, so
+ *   the triggers must be at least BSEQ_Length() timer clocks apart. The
+ *   CPU is never involved after this call.
+ *
+ * @param[in] init
+ *   Trigger, pins and bursts. The delay of an output sets its offset from
+ *   the other output.
+ *
+ * @return
+ *   false if a burst is out of range.
+ *****************************************************************************/
+bool BSEQ_Init(const BSEQ_Init_t *init)
+{
+  LDMA_Init_t ldmaInit = LDMA_INIT_DEFAULT;
+  TIMER_Init_TypeDef timerInit = TIMER_INIT_DEFAULT;
+  TIMER_InitCC_TypeDef triggerInit = TIMER_INITCC_DEFAULT;
+  uint32_t last, end = 0;
+  unsigned int i;
+
+  CMU_ClockEnable(cmuClock_GPIO, true);
+  CMU_ClockEnable(cmuClock_PRS, true);
+  CMU_ClockEnable(cmuClock_TIMER0, true);
+
+  for (i = 0; i < BSEQ_OUTPUTS; i++) {
+    if (!checkBurst(&init->burst[i], &last)) {
+      return false;
+    }
+    if (last > end) {
+      end = last;
+    }
+  }
+  burstLength = end + BSEQ_MIN_GAP;
+
+  // Enabled but stopped at 0 until the first trigger
+  timerInit.enable = false;
+  timerInit.prescale = timerPrescale1;
+  timerInit.oneShot = true;
+  timerInit.riseAction = timerInputActionReloadStart;
+  // Let the LDMA clear the compare requests
+  timerInit.dmaClrAct = true;
+  TIMER_Init(TIMER0, &timerInit);
+
+  triggerInit.mode = timerCCModeCapture;
+  triggerInit.edge = timerEdgeRising;
+  triggerInit.prsInput = true;
+  triggerInit.prsSel = init->prsChannel;
+  triggerInit.prsInputType = timerPrsInputAsyncLevel;
+  TIMER_InitCC(TIMER0, 0, &triggerInit);
+  PRS_ConnectConsumer(init->prsChannel, prsTypeAsync, prsConsumerTIMER0_CC0);
+
+  TIMER_TopSet(TIMER0, burstLength);
+
+  LDMA_Init(&ldmaInit);
+  for (i = 0; i < BSEQ_OUTPUTS; i++) {
+    initOutput(i, init);
+  }
+
+  return true;
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Timer clocks from a trigger to the end of a burst, the shortest time
+ *   between triggers
+ *****************************************************************************/
+uint32_t BSEQ_Length(void)
+{
+  return burstLength + 1;
+}
@@ -0,0 +1,306 @@
+/***************************************************************************//**
+ * @file main.c
+ * @brief This project demonstrates a burst sequencer on two TIMER compare
+ * channels, triggered through the PRS and reloaded by the LDMA, with a jitter
+ * measurement by input capture on a second TIMER. Refer to the readme file for
+ * testing instructions.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2022 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ *******************************************************************************
+ * # Evaluation Quality
+ * This code has been minimally tested to ensure that it builds and is suitable 
+ * as a demonstration for evaluation purposes only. This code will be maintained
+ * at the sole discretion of Silicon Labs.
+ ******************************************************************************/
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "em_device.h"
+#include "em_chip.h"
+#include "em_cmu.h"
+#include "em_emu.h"
+#include "em_gpio.h"
+#include "em_letimer.h"
+#include "em_prs.h"
+#include "em_timer.h"
+#include "burstseq.h"
+
+// PRS channels: the trigger, and the two outputs for the measurement
+#define TRIGGER_PRS_CH    0
+#define OUTPUT_A_PRS_CH   1
+#define OUTPUT_B_PRS_CH   2
+
+// Bursts per second, from LETIMER0
+#define TRIGGER_RATE      100
+
+// Burst of 8 pulses at 40 kHz, 50 % duty, 100 us after the trigger on
+// output A, and the same burst half a period later on output B, for a
+// push-pull transducer drive. Times in us, converted to timer clocks.
+#define BURST_PULSES      8
+#define BURST_DELAY_US    100
+#define BURST_FREQ        40000
+#define OUTPUT_B_OFFSET_NS 12500
+
+// Jitter measurement, in TIMER1 clocks. The latency is from the trigger to
+// the first rising edge of output A, the offset from that edge to the first
+// rising edge of output B, both taken on every burst.
+typedef struct {
+  uint32_t bursts;
+  uint32_t latencyMin;
+  uint32_t latencyMax;
+  uint32_t offsetMin;
+  uint32_t offsetMax;
+  uint32_t jitterNs;        // latencyMax - latencyMin
+  uint32_t offsetJitterNs;  // offsetMax - offsetMin
+} Measurement_t;
+
+volatile Measurement_t measurement = { 0, UINT32_MAX, 0, UINT32_MAX, 0, 0, 0 };
+
+// Capture of the trigger and of the first edge of output A, for the burst
+// in progress
+static uint32_t triggerTime;
+static uint32_t firstEdgeA;
+static bool haveA;
+
+static uint32_t timerFreq;
+
+/**************************************************************************//**
+ * @brief
+ *    CMU initialization
+ *****************************************************************************/
+void initCmu(void)
+{
+  CMU_LFXOInit_TypeDef lfxoInit = CMU_LFXOINIT_DEFAULT;
+
+  // Enable clock to GPIO, PRS, TIMER1 and LETIMER0
+  CMU_ClockEnable(cmuClock_GPIO, true);
+  CMU_ClockEnable(cmuClock_PRS, true);
+  CMU_ClockEnable(cmuClock_TIMER1, true);
+  CMU_ClockEnable(cmuClock_LETIMER0, true);
+
+  // The LETIMER runs from the LFXO, not related to the timer clock
+  CMU_LFXOInit(&lfxoInit);
+  CMU_ClockSelectSet(cmuClock_EM23GRPACLK, cmuSelect_LFXO);
+
+  timerFreq = CMU_ClockFreqGet(cmuClock_TIMER0);
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Trigger initialization
+ *
+ * @details
+ *    LETIMER0 pulses output 0 TRIGGER_RATE times a second; the pulse is not
+ *    routed to a pin, only to the PRS. Its clock is independent of the
+ *    timer clock, as an external trigger would be.
+ *****************************************************************************/
+void initTrigger(void)
+{
+  LETIMER_Init_TypeDef letimerInit = LETIMER_INIT_DEFAULT;
+
+  PRS_SourceAsyncSignalSet(TRIGGER_PRS_CH,
+                           PRS_ASYNC_CH_CTRL_SOURCESEL_LETIMER0,
+                           PRS_ASYNC_CH_CTRL_SIGSEL_LETIMER0CH0);
+
+  letimerInit.comp0Top = true;
+  letimerInit.topValue = (CMU_ClockFreqGet(cmuClock_LETIMER0) / TRIGGER_RATE) - 1;
+  letimerInit.ufoa0 = letimerUFOAPulse;
+  letimerInit.repMode = letimerRepeatFree;
+  LETIMER_Init(LETIMER0, &letimerInit);
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Sequencer initialization
+ *****************************************************************************/
+void initSequencer(void)
+{
+  BSEQ_Init_t init;
+  uint32_t clocksPerUs = timerFreq / 1000000;
+  uint32_t period = timerFreq / BURST_FREQ;
+  uint32_t offset = (uint32_t)(((uint64_t)timerFreq * OUTPUT_B_OFFSET_NS)
+                               / 1000000000);
+
+  init.prsChannel = TRIGGER_PRS_CH;
+
+  // Output A on PA6, output B on PA5
+  init.port[0] = gpioPortA;
+  init.pin[0] = 6;
+  init.port[1] = gpioPortA;
+  init.pin[1] = 5;
+
+  init.burst[0].delay = BURST_DELAY_US * clocksPerUs;
+  init.burst[0].high = period / 2;
+  init.burst[0].period = period;
+  init.burst[0].pulses = BURST_PULSES;
+
+  init.burst[1] = init.burst[0];
+  init.burst[1].delay += offset;
+
+  if (!BSEQ_Init(&init)) {
+    // Loop here to enable the debugger to see what has happened
+    while (1);
+  }
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Measurement initialization
+ *
+ * @details
+ *    TIMER1 counts freely on the same clock as TIMER0. CC0 captures the
+ *    trigger, CC1 and CC2 the rising edges of outputs A and B, all
+ *    through the PRS, so no wiring is needed.
+ *****************************************************************************/
+void initMeasurement(void)
+{
+  TIMER_Init_TypeDef timerInit = TIMER_INIT_DEFAULT;
+  TIMER_InitCC_TypeDef ccInit = TIMER_INITCC_DEFAULT;
+
+  PRS_SourceAsyncSignalSet(OUTPUT_A_PRS_CH, PRS_ASYNC_CH_CTRL_SOURCESEL_TIMER0,
+                           PRS_ASYNC_CH_CTRL_SIGSEL_TIMER0CC1);
+  PRS_SourceAsyncSignalSet(OUTPUT_B_PRS_CH, PRS_ASYNC_CH_CTRL_SOURCESEL_TIMER0,
+                           PRS_ASYNC_CH_CTRL_SIGSEL_TIMER0CC2);
+  PRS_ConnectConsumer(TRIGGER_PRS_CH, prsTypeAsync, prsConsumerTIMER1_CC0);
+  PRS_ConnectConsumer(OUTPUT_A_PRS_CH, prsTypeAsync, prsConsumerTIMER1_CC1);
+  PRS_ConnectConsumer(OUTPUT_B_PRS_CH, prsTypeAsync, prsConsumerTIMER1_CC2);
+
+  timerInit.enable = false;
+  timerInit.prescale = timerPrescale1;
+  TIMER_Init(TIMER1, &timerInit);
+
+  ccInit.mode = timerCCModeCapture;
+  ccInit.edge = timerEdgeRising;
+  ccInit.prsInput = true;
+  ccInit.prsInputType = timerPrsInputAsyncLevel;
+
+  ccInit.prsSel = TRIGGER_PRS_CH;
+  TIMER_InitCC(TIMER1, 0, &ccInit);
+  ccInit.prsSel = OUTPUT_A_PRS_CH;
+  TIMER_InitCC(TIMER1, 1, &ccInit);
+  ccInit.prsSel = OUTPUT_B_PRS_CH;
+  TIMER_InitCC(TIMER1, 2, &ccInit);
+
+  // Only the trigger interrupts until a burst starts
+  TIMER_IntClear(TIMER1, _TIMER_IF_MASK);
+  TIMER_IntEnable(TIMER1, TIMER_IEN_CC0);
+  NVIC_ClearPendingIRQ(TIMER1_IRQn);
+  NVIC_EnableIRQ(TIMER1_IRQn);
+
+  TIMER_Enable(TIMER1, true);
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Drop the captures of the last burst still in a capture buffer
+ *****************************************************************************/
+static void flushCaptures(unsigned int cc)
+{
+  while (!(TIMER1->STATUS & (TIMER_STATUS_ICFEMPTY0 << cc))) {
+    (void)TIMER_CaptureGet(TIMER1, cc);
+  }
+}
+
+/**************************************************************************//**
+ * @brief
+ *    TIMER1 interrupt handler
+ *
+ * @details
+ *    On the trigger, the captures left from the last burst are dropped and
+ *    the output captures enabled. The first capture of each output is then
+ *    the first rising edge of the burst, even if this handler runs after
+ *    later edges, since the capture buffer keeps the oldest. The burst
+ *    delay is far longer than the time to get here from the trigger.
+ *****************************************************************************/
+void TIMER1_IRQHandler(void)
+{
+  uint32_t flags = TIMER_IntGetEnabled(TIMER1);
+  uint32_t latency, offset;
+
+  TIMER_IntClear(TIMER1, flags);
+
+  if (flags & TIMER_IF_CC0) {
+    triggerTime = TIMER_CaptureGet(TIMER1, 0);
+    flushCaptures(1);
+    flushCaptures(2);
+    TIMER_IntClear(TIMER1, TIMER_IF_CC1 | TIMER_IF_CC2);
+    TIMER_IntEnable(TIMER1, TIMER_IEN_CC1 | TIMER_IEN_CC2);
+    haveA = false;
+    return;
+  }
+
+  if (flags & TIMER_IF_CC1) {
+    TIMER_IntDisable(TIMER1, TIMER_IEN_CC1);
+    firstEdgeA = TIMER_CaptureGet(TIMER1, 1);
+    haveA = true;
+
+    latency = firstEdgeA - triggerTime;
+    if (latency < measurement.latencyMin) {
+      measurement.latencyMin = latency;
+    }
+    if (latency > measurement.latencyMax) {
+      measurement.latencyMax = latency;
+    }
+    measurement.jitterNs = (uint32_t)(((uint64_t)(measurement.latencyMax
+                                                  - measurement.latencyMin)
+                                       * 1000000000) / timerFreq);
+  }
+
+  if ((flags & TIMER_IF_CC2) && haveA) {
+    TIMER_IntDisable(TIMER1, TIMER_IEN_CC2);
+    offset = TIMER_CaptureGet(TIMER1, 2) - firstEdgeA;
+    if (offset < measurement.offsetMin) {
+      measurement.offsetMin = offset;
+    }
+    if (offset > measurement.offsetMax) {
+      measurement.offsetMax = offset;
+    }
+    measurement.offsetJitterNs =
+      (uint32_t)(((uint64_t)(measurement.offsetMax - measurement.offsetMin)
+                  * 1000000000) / timerFreq);
+    measurement.bursts++;
+  }
+}
+
+/**************************************************************************//**
+ * @brief  Main function
+ *****************************************************************************/
+int main(void)
+{
+  // Chip errata
+  CHIP_Init();
+
+  // Initializations
+  initCmu();
+  initSequencer();
+  initMeasurement();
+  initTrigger();
+
+  while (1)
+  {
+    EMU_EnterEM1();
+  }
+}
@@ -0,0 +1,67 @@
+/***************************************************************************//**
+ * @file edgestream.h
+ * @brief Continuous TIMER edge capture into a looped LDMA ring, with the
+ * capture values extended to 64 bit timestamps.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2020 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ******************************************************************************/
+
+#ifndef EDGESTREAM_H
+#define EDGESTREAM_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// LDMA channels that store the captures and the overflow marks
+#define EDGES_CAPTURE_LDMA_CHANNEL  0
+#define EDGES_MARK_LDMA_CHANNEL     1
+
+// Ring limits, two descriptors of at most 2048 words each
+#define EDGES_MIN_RING              4
+#define EDGES_MAX_RING              4096
+
+// Overflows remembered until the captures around them are read, a power
+// of 2. With more overflows pending the older ones are taken to precede
+// all unread captures.
+#define EDGES_MARK_QUEUE            16
+
+bool EDGES_Init(uint32_t *ring, uint32_t size);
+void EDGES_Stop(void);
+uint32_t EDGES_Available(void);
+uint32_t EDGES_ReadTimestamps(uint64_t *out, uint32_t max);
+uint32_t EDGES_ReadDeltas(uint32_t *out, uint32_t max);
+uint32_t EDGES_GetOverrunCount(void);
+uint32_t EDGES_GetOverflowCount(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // EDGESTREAM_H
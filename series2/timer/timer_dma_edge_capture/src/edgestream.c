@@ -0,0 +1,411 @@
+/***************************************************************************//**
+ * @file edgestream.c
+ * @brief Continuous TIMER edge capture into a looped LDMA ring, with the
+ * capture values extended to 64 bit timestamps.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2020 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ *******************************************************************************
+ * # Evaluation Quality
+ * This code has been minimally tested to ensure that it builds and is suitable 
+ * as a demonstration for evaluation purposes only. This code will be maintained
+ * at the sole discretion of Silicon Labs.
+ ******************************************************************************/
+
+#include "em_device.h"
+#include "em_core.h"
+#include "em_ldma.h"
+#include "em_timer.h"
+
+#include "edgestream.h"
+
+// Capture channel and the LDMA requests it and the overflow raise
+#define CAPTURE_TIMER       TIMER0
+#define CAPTURE_SOURCE      (&CAPTURE_TIMER->CC[0].ICF)
+#define CAPTURE_SIGNAL      ldmaPeripheralSignal_TIMER0_CC0
+#define OVERFLOW_SIGNAL     ldmaPeripheralSignal_TIMER0_UFOF
+
+/*
+ * A capture and an overflow only a few cycles apart can reach the LDMA in
+ * either order. Captures next to an overflow mark and within this many
+ * counts of the wrap are put on the side of the mark their value says.
+ */
+#define GUARD_COUNTS        32
+
+#define CAPTURE_DONE        (1 << EDGES_CAPTURE_LDMA_CHANNEL)
+#define MARK_DONE           (1 << EDGES_MARK_LDMA_CHANNEL)
+
+#if (EDGES_MARK_QUEUE & (EDGES_MARK_QUEUE - 1))
+#error "EDGES_MARK_QUEUE must be a power of 2"
+#endif
+
+static LDMA_Descriptor_t captureDesc[2];
+static LDMA_Descriptor_t markDesc;
+
+static uint32_t *ringStart;
+static uint32_t ringSize;
+static uint32_t halfSize;
+
+// Ring halves completed, counted in the LDMA interrupt
+static volatile uint32_t halvesDone;
+
+// Capture channel destination at the last overflow, written by the LDMA
+static volatile uint32_t markWord;
+
+// Number of the first capture after each overflow, and the overflows
+// seen. Written in the LDMA interrupt only.
+static volatile uint32_t markQueue[EDGES_MARK_QUEUE];
+static volatile uint32_t marksWritten;
+
+// Reader state: captures and marks consumed, the ring slot of the next
+// capture and the number of overflows before it
+static uint32_t readCount;
+static uint32_t readIndex;
+static uint32_t marksApplied;
+static uint32_t epoch;
+static uint64_t period;
+static uint32_t maxCount;
+
+static uint64_t lastTimestamp;
+static bool haveLast;
+static uint32_t overruns;
+
+/**************************************************************************//**
+ * @brief
+ *   Ring slot the LDMA writes next
+ *****************************************************************************/
+static uint32_t writeIndex(uint32_t dst)
+{
+  return ((dst - (uint32_t)ringStart) / sizeof(uint32_t)) % ringSize;
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Captures written since EDGES_Init(), wrapping at 2^32
+ *
+ * @param[in] index
+ *   Ring slot the LDMA writes next, from writeIndex().
+ *
+ * @note
+ *   Call with interrupts disabled or from the LDMA interrupt.
+ *****************************************************************************/
+static uint32_t writeCount(uint32_t index)
+{
+  uint32_t halves = halvesDone;
+
+  // The LDMA has moved on to the other half, its interrupt is pending
+  if ((index >= halfSize) != (halves & 1)) {
+    halves++;
+  }
+
+  return (halves * halfSize) + (index - ((halves & 1) * halfSize));
+}
+
+/**************************************************************************//**
+ * @brief LDMA Handler
+ *****************************************************************************/
+void LDMA_IRQHandler(void)
+{
+  uint32_t pending = LDMA_IntGetEnabled();
+  uint32_t index, back;
+
+  if (pending & LDMA_IF_ERROR) {
+    __BKPT(0);
+  }
+
+  // Count the halves first, the mark is converted with the count
+  if (pending & CAPTURE_DONE) {
+    LDMA_IntClear(CAPTURE_DONE);
+    halvesDone++;
+  }
+
+  if (pending & MARK_DONE) {
+    LDMA_IntClear(MARK_DONE);
+
+    // The mark holds the slot the LDMA was about to fill when the timer
+    // overflowed. This runs well within one ring length of that, so the
+    // slot is at most one ring behind the current one.
+    index = writeIndex(LDMA->CH[EDGES_CAPTURE_LDMA_CHANNEL].DST);
+    back = (index + ringSize - writeIndex(markWord)) % ringSize;
+
+    markQueue[marksWritten & (EDGES_MARK_QUEUE - 1)] = writeCount(index) - back;
+    marksWritten++;
+  }
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Captures waiting and the marks seen, skipping what was overwritten
+ *****************************************************************************/
+static uint32_t snapshot(uint32_t *marks)
+{
+  CORE_DECLARE_IRQ_STATE;
+  uint32_t written, lost;
+
+  CORE_ENTER_CRITICAL();
+  written = writeCount(writeIndex(LDMA->CH[EDGES_CAPTURE_LDMA_CHANNEL].DST));
+  *marks = marksWritten;
+  CORE_EXIT_CRITICAL();
+
+  // The LDMA has lapped the reader, the oldest captures are gone
+  if (written - readCount > ringSize) {
+    lost = written - readCount - ringSize;
+    overruns += lost;
+    readCount += lost;
+    readIndex = (readIndex + (lost % ringSize)) % ringSize;
+    haveLast = false;
+  }
+
+  // Overflows whose marks were overwritten count before all unread captures
+  if (*marks - marksApplied > EDGES_MARK_QUEUE) {
+    lost = *marks - marksApplied - EDGES_MARK_QUEUE;
+    epoch += lost;
+    marksApplied += lost;
+  }
+
+  return written - readCount;
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Take the next capture out of the ring and extend it to a timestamp
+ *****************************************************************************/
+static uint64_t next(uint32_t marks)
+{
+  uint32_t value = ringStart[readIndex];
+  uint32_t count = readCount;
+  uint32_t e;
+  bool markHere = false;
+
+  // Apply the overflows that happened before this capture was written
+  while ((marks != marksApplied)
+         && ((int32_t)(markQueue[marksApplied & (EDGES_MARK_QUEUE - 1)]
+                       - count) <= 0)) {
+    markHere = (markQueue[marksApplied & (EDGES_MARK_QUEUE - 1)] == count);
+    epoch++;
+    marksApplied++;
+  }
+
+  e = epoch;
+  if (markHere && (value > maxCount - GUARD_COUNTS) && (e > 0)) {
+    // Written after the overflow mark, but captured just before the wrap
+    e--;
+  } else if ((value < GUARD_COUNTS) && (marks != marksApplied)
+             && (markQueue[marksApplied & (EDGES_MARK_QUEUE - 1)]
+                 == count + 1)) {
+    // Written before the overflow mark, but captured just after the wrap
+    e++;
+  }
+
+  readCount++;
+  readIndex = (readIndex + 1) % ringSize;
+
+  return ((uint64_t)e * period) + value;
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Start storing every capture of TIMER0 CC0 and every TIMER0 overflow
+ *
+ * @details
+ *   TIMER0 must be initialized before calling this, with dmaClrAct set
+ *   so the LDMA clears the overflow request, and with CC0 in capture mode.
+ *   Its top value is taken as the wrap of the capture values and must not
+ *   change afterwards. The timer may be enabled before or after the call.
+ *
+ * @param[in] ring
+ *   Ring buffer, written by the LDMA.
+ *
+ * @param[in] size
+ *   Ring size in words, even and EDGES_MIN_RING to EDGES_MAX_RING.
+ *
+ * @return
+ *   false if size is out of range.
+ *****************************************************************************/
+bool EDGES_Init(uint32_t *ring, uint32_t size)
+{
+  LDMA_Init_t init = LDMA_INIT_DEFAULT;
+  LDMA_TransferCfg_t captureCfg = LDMA_TRANSFER_CFG_PERIPHERAL(CAPTURE_SIGNAL);
+  LDMA_TransferCfg_t markCfg = LDMA_TRANSFER_CFG_PERIPHERAL(OVERFLOW_SIGNAL);
+
+  if ((size < EDGES_MIN_RING) || (size > EDGES_MAX_RING) || (size % 2)) {
+    return false;
+  }
+
+  ringStart = ring;
+  ringSize = size;
+  halfSize = size / 2;
+  halvesDone = 0;
+  marksWritten = 0;
+  readCount = 0;
+  readIndex = 0;
+  marksApplied = 0;
+  epoch = 0;
+  haveLast = false;
+  overruns = 0;
+
+  maxCount = TIMER_TopGet(CAPTURE_TIMER);
+  period = (uint64_t)maxCount + 1;
+
+  LDMA_Init(&init);
+
+  // One word per capture; each half links to the other and signals done
+  captureDesc[0] = (LDMA_Descriptor_t)
+    LDMA_DESCRIPTOR_LINKREL_P2M_WORD(CAPTURE_SOURCE, ring, halfSize, 1);
+  captureDesc[1] = (LDMA_Descriptor_t)
+    LDMA_DESCRIPTOR_LINKREL_P2M_WORD(CAPTURE_SOURCE, ring + halfSize,
+                                     halfSize, -1);
+  captureDesc[0].xfer.doneIfs = 1;
+  captureDesc[1].xfer.doneIfs = 1;
+
+  // On each overflow, copy where the next capture goes. The descriptor
+  // links to itself, so this repeats for as long as the timer runs.
+  markDesc = (LDMA_Descriptor_t)
+    LDMA_DESCRIPTOR_LINKREL_P2M_WORD(&LDMA->CH[EDGES_CAPTURE_LDMA_CHANNEL].DST,
+                                     &markWord, 1, 0);
+  markDesc.xfer.doneIfs = 1;
+
+  LDMA_StartTransfer(EDGES_CAPTURE_LDMA_CHANNEL, &captureCfg, &captureDesc[0]);
+  LDMA_StartTransfer(EDGES_MARK_LDMA_CHANNEL, &markCfg, &markDesc);
+
+  return true;
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Stop both LDMA channels; captures already stored can still be read
+ *****************************************************************************/
+void EDGES_Stop(void)
+{
+  LDMA_StopTransfer(EDGES_MARK_LDMA_CHANNEL);
+  LDMA_StopTransfer(EDGES_CAPTURE_LDMA_CHANNEL);
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Number of captures waiting to be read
+ *****************************************************************************/
+uint32_t EDGES_Available(void)
+{
+  uint32_t marks;
+
+  return snapshot(&marks);
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Read captures as timestamps, oldest first
+ *
+ * @details
+ *   Timestamps count timer clocks from the start of the timer and are
+ *   extended with the overflows, so they do not wrap. Read at least once
+ *   per ring length of edges, or the oldest captures are lost and counted
+ *   by EDGES_GetOverrunCount().
+ *
+ * @param[out] out
+ *   Timestamps.
+ *
+ * @param[in] max
+ *   Timestamps that fit in out.
+ *
+ * @return
+ *   Number of timestamps read.
+ *****************************************************************************/
+uint32_t EDGES_ReadTimestamps(uint64_t *out, uint32_t max)
+{
+  uint32_t marks, count, i;
+
+  count = snapshot(&marks);
+  if (count > max) {
+    count = max;
+  }
+
+  for (i = 0; i < count; i++) {
+    lastTimestamp = next(marks);
+    out[i] = lastTimestamp;
+  }
+  if (count) {
+    haveLast = true;
+  }
+
+  return count;
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Read the time from each capture to the next, oldest first
+ *
+ * @details
+ *   The first capture after EDGES_Init() or after an overrun only starts
+ *   the next delta. Deltas longer than 2^32 - 1 timer clocks are clipped.
+ *
+ * @param[out] out
+ *   Deltas in timer clocks.
+ *
+ * @param[in] max
+ *   Deltas that fit in out.
+ *
+ * @return
+ *   Number of deltas read.
+ *****************************************************************************/
+uint32_t EDGES_ReadDeltas(uint32_t *out, uint32_t max)
+{
+  uint32_t marks, count, n = 0;
+  uint64_t timestamp, delta;
+
+  count = snapshot(&marks);
+
+  while (count && (n < max)) {
+    timestamp = next(marks);
+    count--;
+
+    if (haveLast) {
+      delta = timestamp - lastTimestamp;
+      out[n++] = (delta > UINT32_MAX) ? UINT32_MAX : (uint32_t)delta;
+    }
+    lastTimestamp = timestamp;
+    haveLast = true;
+  }
+
+  return n;
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Number of captures lost because the ring was full
+ *****************************************************************************/
+uint32_t EDGES_GetOverrunCount(void)
+{
+  return overruns;
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Number of timer overflows since EDGES_Init()
+ *****************************************************************************/
+uint32_t EDGES_GetOverflowCount(void)
+{
+  return marksWritten;
+}
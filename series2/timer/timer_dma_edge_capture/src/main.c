@@ -1,8 +1,9 @@
 /***************************************************************************//**
  * @file main.c
- * @brief This project demonstrates edge capture with LDMA. The first 512 events
- * captured by TIMER0 CC0 are transferred to a fixed length buffer by the LDMA.
- * For this example both rising and falling edges are captured.
+ * @brief This project demonstrates edge capture with LDMA. Every event
+ * captured by TIMER0 CC0 is transferred to a looped ring by the LDMA and read
+ * back as the time between edges. For this example both rising and falling
+ * edges are captured.
  *******************************************************************************
  * # License
  * <b>Copyright 2020 Silicon Laboratories Inc. www.silabs.com</b>
@@ -46,65 +47,27 @@
 #include "em_ldma.h"
 #include "bsp.h"
 
-#define BUFFERSIZE 512
+#include "edgestream.h"
+#include "timestamp.h"
 
-// Globally declared link descriptor
-LDMA_Descriptor_t descLink;
+// Captures held until they are read, and deltas read at a time
+#define RING_SIZE       512
+#define DELTA_SIZE      64
 
-// Edge capture buffer
-volatile uint32_t buffer[BUFFERSIZE];
+// Edge capture ring, written by the LDMA
+static uint32_t captureRing[RING_SIZE];
 
-/***************************************************************************//**
- * @brief
- *   LDMA IRQ handler.
- ******************************************************************************/
-void LDMA_IRQHandler (void)
-{
-  uint32_t pending;
+// Time between successive edges in TIMER0 clocks, the last batch read
+uint32_t deltas[DELTA_SIZE];
+volatile uint32_t deltaCount;
 
-  // Read interrupt source
-  pending = LDMA_IntGet();
+// Edges read, edges lost to a full ring and TIMER0 overflows
+volatile uint32_t edgeCount;
+volatile uint32_t overrunCount;
+volatile uint32_t overflowCount;
 
-  // Clear interrupts
-  LDMA_IntClear(pending);
-
-  // Check for LDMA error
-  if ( pending & LDMA_IF_ERROR ){
-    // Loop here to enable the debugger to see what has happened
-    while (1);
-  }
-}
-
-/**************************************************************************//**
- * @brief Configure and start DMA
- *****************************************************************************/
-void initLDMA(void)
-{
-  // Default LDMA init
-  LDMA_Init_t init = LDMA_INIT_DEFAULT;
-  LDMA_Init(&init);
-
-  // Configure LDMA for transfer from TIMER0 CC0 to memory
-  // LDMA will perform a single unit transfer for each CC0 event
-  LDMA_TransferCfg_t periTransferTx =
-          LDMA_TRANSFER_CFG_PERIPHERAL(ldmaPeripheralSignal_TIMER0_CC0);
-
-  // Get default descriptor for transfer from TIM0_CC0 to the buffer
-  LDMA_Descriptor_t xfer = LDMA_DESCRIPTOR_SINGLE_P2M_BYTE(&TIMER0->CC[0].ICF,
-                            &buffer, BUFFERSIZE);
-
-  // Store descriptor globally
-  descLink = xfer;
-  // Transfer one word per unit
-  descLink.xfer.size = ldmaCtrlSizeWord;
-  // Do not ignore single requests
-  // IE: When Timer CC0 event occurs, transfer 1 unit then wait for next
-  // capture
-  descLink.xfer.ignoreSrec = 0;
-
-  // Start transfer, LDMA will transfer each edge
-  LDMA_StartTransfer(0, (void*)&periTransferTx, (void*)&descLink);
-}
+// Monotonic time of the last batch read, in ns since TIMESTAMP_Init()
+volatile uint64_t batchTime;
 
 /**************************************************************************//**
  * @brief GPIO initialization
@@ -143,6 +106,8 @@ void initTIMER(void)
 
   timerInit.enable = false;
   timerInit.prescale = timerPrescale1;
+  // Let the LDMA clear the overflow request, it does not read TOPB
+  timerInit.dmaClrAct = true;
   // Set event on every edge
   timerCCInit.eventCtrl = timerEventEveryEdge;
   timerCCInit.edge = timerEdgeBoth;
@@ -169,14 +134,40 @@ int main(void)
   // Chip errata
   CHIP_Init();
 
+  CORE_DECLARE_IRQ_STATE;
+  uint32_t count;
+
   // Initializations
-  initLDMA();
   initCmu();
   initGPIO();
   initTIMER();
 
+  if (!EDGES_Init(captureRing, RING_SIZE)) {
+    __BKPT(0);
+  }
+
+  // Timestamp the batches on the RTC, split by TIMER1
+  if (!TIMESTAMP_Init()) {
+    __BKPT(0);
+  }
+
   while (1)
   {
-    EMU_EnterEM1();
+    // Sleep in EM1 until the LDMA has filled half the ring or the timer has
+    // overflowed; edges arriving in between are stored without waking up
+    CORE_ENTER_CRITICAL();
+    if (EDGES_Available() == 0) {
+      EMU_EnterEM1();
+    }
+    CORE_EXIT_CRITICAL();
+
+    // Take everything stored since the last wake-up
+    batchTime = TIMESTAMP_GetNs();
+    while ((count = EDGES_ReadDeltas(deltas, DELTA_SIZE)) > 0) {
+      deltaCount = count;
+      edgeCount += count;
+    }
+    overrunCount = EDGES_GetOverrunCount();
+    overflowCount = EDGES_GetOverflowCount();
   }
 }
@@ -40,12 +40,34 @@
 #include "em_cmu.h"
 #include "em_emu.h"
 #include "em_gpio.h"
+#include "em_ldma.h"
 #include "em_timer.h"
 
 // Desired frequency in Hz
 // Min: 145 Hz, Max: 9.5 MHz with default settings
 #define OUT_FREQ 1000
 
+// 1 to let the LDMA dither the top value for a fractional frequency
+#define FRACTIONAL_MODE 1
+
+// Desired frequency in mHz in fractional mode, 1000.25 Hz
+#define OUT_FREQ_MILLIHZ 1000250
+
+// Half periods in the dither sequence; more gives a finer frequency step
+#define SEQUENCE_LENGTH 256
+
+// LDMA channel that writes the sequence to TOPB
+#define LDMA_CHANNEL 0
+
+#if (FRACTIONAL_MODE == 1)
+// Top values of the half periods, played over and over by the LDMA
+static uint32_t topSequence[SEQUENCE_LENGTH];
+static LDMA_Descriptor_t topDesc;
+
+// Average output frequency of the sequence in mHz, for the debugger
+volatile uint32_t outFreqMilliHz;
+#endif
+
 /**************************************************************************//**
  * @brief GPIO initialization
  *****************************************************************************/
@@ -84,6 +106,10 @@ void initTIMER(void)
 
   timerInit.prescale = timerPrescale1;
   timerInit.enable = false;
+#if (FRACTIONAL_MODE == 1)
+  // Let the LDMA clear the overflow request as it writes TOPB
+  timerInit.dmaClrAct = true;
+#endif
   timerCCInit.mode = timerCCModeCompare;
   timerCCInit.cofoa = timerOutputActionToggle;
 
@@ -107,6 +133,63 @@ void initTIMER(void)
   TIMER_Enable(TIMER0, true);
 }
 
+#if (FRACTIONAL_MODE == 1)
+/**************************************************************************//**
+ * @brief Fractional frequency initialization
+ *
+ * @details
+ *    The half period of OUT_FREQ_MILLIHZ is rarely a whole number of timer
+ *    clocks. The SEQUENCE_LENGTH half periods of the sequence add up to the
+ *    nearest whole number of clocks, total, and half period i is
+ *    floor((i + 1) * total / SEQUENCE_LENGTH) - floor(i * total /
+ *    SEQUENCE_LENGTH) clocks: a first order sigma-delta, the long and short
+ *    half periods spread out so the phase never drifts by more than one
+ *    clock from that of the exact frequency.
+ *
+ *    On each overflow the LDMA writes the next top value to TOPB, and the
+ *    timer loads it into TOP at the overflow after. The descriptor links to
+ *    itself, so the sequence plays over and over with no CPU involvement.
+ *    The average frequency steps by 2 * f^2 / (timer clock *
+ *    SEQUENCE_LENGTH), 0.4 mHz at 1 kHz, against 0.1 Hz for a fixed top.
+ *****************************************************************************/
+void initFractional(void)
+{
+  LDMA_Init_t ldmaInit = LDMA_INIT_DEFAULT;
+  LDMA_TransferCfg_t overflowCfg =
+    LDMA_TRANSFER_CFG_PERIPHERAL(ldmaPeripheralSignal_TIMER0_UFOF);
+  uint32_t timerFreq = CMU_ClockFreqGet(cmuClock_TIMER0);
+  uint64_t total;
+  uint32_t i, start, end;
+
+  // Timer clocks in the whole sequence, rounded
+  total = (((uint64_t)timerFreq * SEQUENCE_LENGTH * 1000)
+           + OUT_FREQ_MILLIHZ) / (2 * (uint64_t)OUT_FREQ_MILLIHZ);
+
+  start = 0;
+  for (i = 0; i < SEQUENCE_LENGTH; i++) {
+    end = (uint32_t)((total * (i + 1)) / SEQUENCE_LENGTH);
+    topSequence[i] = end - start - 1;
+    start = end;
+  }
+
+  outFreqMilliHz = (uint32_t)((((uint64_t)timerFreq * SEQUENCE_LENGTH * 1000)
+                               + total) / (2 * total));
+
+  TIMER_Enable(TIMER0, false);
+  TIMER_CounterSet(TIMER0, 0);
+  TIMER_TopSet(TIMER0, topSequence[0]);
+
+  LDMA_Init(&ldmaInit);
+  topDesc = (LDMA_Descriptor_t)
+    LDMA_DESCRIPTOR_LINKREL_M2P_BYTE(topSequence, &TIMER0->TOPB,
+                                     SEQUENCE_LENGTH, 0);
+  topDesc.xfer.size = ldmaCtrlSizeWord;
+  LDMA_StartTransfer(LDMA_CHANNEL, &overflowCfg, &topDesc);
+
+  TIMER_Enable(TIMER0, true);
+}
+#endif
+
 /**************************************************************************//**
  * @brief  Main function
  *****************************************************************************/
@@ -119,6 +202,9 @@ int main(void)
   initCmu();
   initGPIO();
   initTIMER();
+#if (FRACTIONAL_MODE == 1)
+  initFractional();
+#endif
 
   while (1)
   {
@@ -0,0 +1,84 @@
+/***************************************************************************//**
+ * @file bitstream.h
+ *
+ * @brief One-wire LED bitstream encoder streamed through TIMER0 CC0 by LDMA.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2021 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ******************************************************************************/
+
+#ifndef BITSTREAM_H
+#define BITSTREAM_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// LDMA channel that writes the compare buffer
+#define BITS_LDMA_CHANNEL     0
+
+// Bits expanded into each half of the compare value buffer. The buffer
+// takes 2 * BITS_CHUNK_BITS half words however long the stream is, and
+// each half must be refilled in the time it takes to send the other.
+#ifndef BITS_CHUNK_BITS
+#define BITS_CHUNK_BITS       96
+#endif
+
+#if (BITS_CHUNK_BITS % 8) || (BITS_CHUNK_BITS > 2048)
+#error "BITS_CHUNK_BITS must be a multiple of 8 and at most 2048"
+#endif
+
+// Timing of the line in ns. Every bit starts high and falls after the
+// high time of its value; the line then stays low for the reset time to
+// latch the data.
+typedef struct {
+  uint32_t bitNs;
+  uint32_t zeroNs;
+  uint32_t oneNs;
+  uint32_t resetNs;
+} BITS_Timing_t;
+
+// WS2812B and compatible LEDs, 800 kbit/s. Newer parts need a reset
+// time of 280 us instead of the original 50 us.
+#define BITS_TIMING_WS2812      \
+  {                             \
+    1250,   /* bit period */    \
+    400,    /* 0 high time */   \
+    800,    /* 1 high time */   \
+    300000  /* reset */         \
+  }
+
+bool BITS_Init(const BITS_Timing_t *timing);
+bool BITS_Send(const uint8_t *data, uint32_t length);
+bool BITS_IsBusy(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // BITSTREAM_H
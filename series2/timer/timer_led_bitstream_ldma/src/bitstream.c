@@ -0,0 +1,257 @@
+/***************************************************************************//**
+ * @file bitstream.c
+ *
+ * @brief One-wire LED bitstream encoder streamed through TIMER0 CC0 by LDMA.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2021 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ *******************************************************************************
+ * # Evaluation Quality
+ * This code has been minimally tested to ensure that it builds and is suitable 
+ * as a demonstration for evaluation purposes only. This code will be maintained
+ * at the sole discretion of Silicon Labs.
+ ******************************************************************************/
+
+#include "em_device.h"
+#include "em_cmu.h"
+#include "em_core.h"
+#include "em_ldma.h"
+#include "em_timer.h"
+
+#include "bitstream.h"
+
+// The line is the PWM output of this channel. A compare value written to
+// the buffer on the compare event of one period takes effect at the next
+// overflow, so the LDMA stays a period ahead of the line.
+#define LINE_TIMER          TIMER0
+#define LINE_CC             0
+#define LINE_SIGNAL         ldmaPeripheralSignal_TIMER0_CC0
+
+#define CHANNEL_DONE        (1 << BITS_LDMA_CHANNEL)
+
+// Compare values for the two halves sent in turn by the LDMA
+static uint16_t chunk[2][BITS_CHUNK_BITS];
+static LDMA_Descriptor_t desc[2];
+
+// Low periods in each half, and in the halves sent so far
+static uint32_t lowInHalf[2];
+static uint32_t lowSent;
+
+// Compare values of the two bit values, and the periods of reset
+static uint16_t zeroCompare;
+static uint16_t oneCompare;
+static uint32_t resetPeriods;
+
+static const uint8_t *streamData;
+static uint32_t streamLength;
+static uint32_t streamIndex;
+static uint32_t nextHalf;
+static volatile bool busy;
+
+/**************************************************************************//**
+ * @brief
+ *   Timer clock cycles closest to a time in ns
+ *****************************************************************************/
+static uint32_t nsToCycles(uint32_t ns)
+{
+  uint64_t cycles = (uint64_t)ns * CMU_ClockFreqGet(cmuClock_TIMER0);
+
+  return (uint32_t)((cycles + 500000000) / 1000000000);
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Expand the next bytes of the stream into a half of the buffer
+ *
+ * @details
+ *   The bytes are sent most significant bit first. Once the stream is
+ *   used up the rest of the half is set to compare value 0, which keeps
+ *   the line low for whole periods.
+ *
+ * @return
+ *   The number of low periods written.
+ *****************************************************************************/
+static uint32_t fillHalf(uint16_t *dst)
+{
+  uint32_t n = 0;
+  uint32_t low;
+  uint8_t byte, mask;
+
+  while ((n < BITS_CHUNK_BITS) && (streamIndex < streamLength)) {
+    byte = streamData[streamIndex++];
+    for (mask = 0x80; mask != 0; mask >>= 1) {
+      dst[n++] = (byte & mask) ? oneCompare : zeroCompare;
+    }
+  }
+
+  low = BITS_CHUNK_BITS - n;
+  while (n < BITS_CHUNK_BITS) {
+    dst[n++] = 0;
+  }
+
+  return low;
+}
+
+/**************************************************************************//**
+ * @brief LDMA Handler
+ *****************************************************************************/
+void LDMA_IRQHandler(void)
+{
+  uint32_t pending = LDMA_IntGetEnabled();
+  uint32_t half;
+
+  if (pending & LDMA_IF_ERROR) {
+    __BKPT(0);
+  }
+
+  if (!(pending & CHANNEL_DONE)) {
+    return;
+  }
+  LDMA_IntClear(CHANNEL_DONE);
+
+  // The LDMA has moved on to the other half, this one is free
+  half = nextHalf;
+  nextHalf ^= 1;
+
+  // Low periods only ever follow the end of the data
+  lowSent += lowInHalf[half];
+
+  // Stop once the reset time has been sent and the half playing now only
+  // holds the line low, so the LDMA never reaches stale data
+  if ((lowSent >= resetPeriods) && (lowInHalf[half ^ 1] == BITS_CHUNK_BITS)) {
+    LDMA_StopTransfer(BITS_LDMA_CHANNEL);
+    busy = false;
+    return;
+  }
+
+  lowInHalf[half] = fillHalf(chunk[half]);
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Set up TIMER0 and the LDMA for a line timing
+ *
+ * @details
+ *   TIMER0 runs in PWM mode with one period per bit and starts with the
+ *   line low. The CC0 output must be routed to the pin the LEDs are
+ *   connected to.
+ *
+ * @return
+ *   False if the timer clock is too slow or too fast for the timing.
+ *****************************************************************************/
+bool BITS_Init(const BITS_Timing_t *timing)
+{
+  TIMER_Init_TypeDef timerInit = TIMER_INIT_DEFAULT;
+  TIMER_InitCC_TypeDef timerCCInit = TIMER_INITCC_DEFAULT;
+  LDMA_Init_t ldmaInit = LDMA_INIT_DEFAULT;
+  uint32_t bitCycles = nsToCycles(timing->bitNs);
+
+  zeroCompare = (uint16_t)nsToCycles(timing->zeroNs);
+  oneCompare = (uint16_t)nsToCycles(timing->oneNs);
+  resetPeriods = (timing->resetNs + timing->bitNs - 1) / timing->bitNs;
+
+  // The high times have to be distinct and shorter than a bit
+  if ((bitCycles > 0x10000) || (zeroCompare == 0)
+      || (zeroCompare >= oneCompare) || (oneCompare >= bitCycles)) {
+    return false;
+  }
+
+  timerInit.enable = false;
+  timerCCInit.mode = timerCCModePWM;
+  TIMER_Init(LINE_TIMER, &timerInit);
+  TIMER_InitCC(LINE_TIMER, LINE_CC, &timerCCInit);
+  TIMER_TopSet(LINE_TIMER, bitCycles - 1);
+  TIMER_CompareSet(LINE_TIMER, LINE_CC, 0);
+  TIMER_CompareBufSet(LINE_TIMER, LINE_CC, 0);
+  TIMER_Enable(LINE_TIMER, true);
+
+  // DMA request on the compare event of every period
+  TIMER_IntEnable(LINE_TIMER, TIMER_IEN_CC0);
+
+  LDMA_Init(&ldmaInit);
+
+  desc[0] = (LDMA_Descriptor_t)
+    LDMA_DESCRIPTOR_LINKREL_M2P_BYTE(chunk[0], &LINE_TIMER->CC[LINE_CC].OCB,
+                                     BITS_CHUNK_BITS, 1);
+  desc[1] = (LDMA_Descriptor_t)
+    LDMA_DESCRIPTOR_LINKREL_M2P_BYTE(chunk[1], &LINE_TIMER->CC[LINE_CC].OCB,
+                                     BITS_CHUNK_BITS, -1);
+  desc[0].xfer.size = ldmaCtrlSizeHalf;
+  desc[1].xfer.size = ldmaCtrlSizeHalf;
+
+  busy = false;
+
+  return true;
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Start sending a stream of bytes
+ *
+ * @details
+ *   The bytes are expanded a chunk at a time from the LDMA interrupt while
+ *   the other chunk is being sent, followed by the reset time.
+ *
+ * @param[in] data
+ *   Bytes to send, most significant bit first. They must not change until
+ *   BITS_IsBusy() returns false.
+ *
+ * @param[in] length
+ *   Number of bytes.
+ *
+ * @return
+ *   False if the last stream is still being sent.
+ *****************************************************************************/
+bool BITS_Send(const uint8_t *data, uint32_t length)
+{
+  LDMA_TransferCfg_t cfg = LDMA_TRANSFER_CFG_PERIPHERAL(LINE_SIGNAL);
+
+  if (busy) {
+    return false;
+  }
+
+  streamData = data;
+  streamLength = length;
+  streamIndex = 0;
+  lowSent = 0;
+  nextHalf = 0;
+
+  lowInHalf[0] = fillHalf(chunk[0]);
+  lowInHalf[1] = fillHalf(chunk[1]);
+
+  busy = true;
+  LDMA_StartTransfer(BITS_LDMA_CHANNEL, &cfg, &desc[0]);
+
+  return true;
+}
+
+/**************************************************************************//**
+ * @brief
+ *   True from BITS_Send() until the reset time after the stream is sent
+ *****************************************************************************/
+bool BITS_IsBusy(void)
+{
+  return busy;
+}
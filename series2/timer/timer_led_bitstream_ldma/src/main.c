@@ -1,8 +1,9 @@
 /***************************************************************************//**
- * @file main_xg22.c
- * @brief This project demonstrates generating a pulse train using the LETIMER
- * module. Expansion Header Pin 14 is configured for output compare and toggles
- * EH Pin 14 on each overflow event at a set frequency.
+ * @file main.c
+ * @brief This project demonstrates driving a chain of WS2812 style LEDs with
+ * the TIMER and LDMA. The pixel data is expanded a few LEDs at a time into a
+ * small buffer of PWM compare values, one per bit, which the LDMA writes to
+ * the CCVB register period by period.
  *******************************************************************************
  * # License
  * <b>Copyright 2021 Silicon Laboratories Inc. www.silabs.com</b>
@@ -36,23 +37,36 @@
  ******************************************************************************/
 
 #include "em_device.h"
-#include "em_chip.h"
 #include "em_cmu.h"
 #include "em_emu.h"
+#include "em_chip.h"
 #include "em_gpio.h"
-#include "em_letimer.h"
-#include "bsp.h"
+#include "em_timer.h"
+#include "bitstream.h"
+
+// Note: change this to the number of LEDs in the chain
+#define LED_COUNT 16
 
-// Desired frequency in Hz
-#define OUT_FREQ 1000
+// Frames sent before the pattern moves on by one LED. A frame takes
+// LED_COUNT * 30 us plus the reset time.
+#define FRAMES_PER_STEP 100
+
+// Pixel data in the order the LEDs expect it: green, red, blue
+static uint8_t pixels[LED_COUNT * 3];
 
 /**************************************************************************//**
- * @brief GPIO initialization
+ * @brief
+ *    GPIO initialization
  *****************************************************************************/
 void initGpio(void)
 {
-  // Configure PA6 (Expansion Header 14) as output
-  GPIO_PinModeSet(gpioPortA, 6, gpioModePushPull, 1);
+  // Configure PA6 as output
+  GPIO_PinModeSet(gpioPortA, 6, gpioModePushPull, 0);
+
+  // Route Timer0 CC0 output to PA6
+  GPIO->TIMERROUTE[0].ROUTEEN  = GPIO_TIMER_ROUTEEN_CC0PEN;
+  GPIO->TIMERROUTE[0].CC0ROUTE = (gpioPortA << _GPIO_TIMER_CC0ROUTE_PORT_SHIFT)
+                    | (6 << _GPIO_TIMER_CC0ROUTE_PIN_SHIFT);
 }
 
 /**************************************************************************//**
@@ -61,47 +75,41 @@ void initGpio(void)
  *****************************************************************************/
 void initCmu(void)
 {
-  // Enable clock to GPIO and LETIMER0
+  // Enable clock to GPIO, TIMER0 and LDMA
   CMU_ClockEnable(cmuClock_GPIO, true);
-  CMU_ClockEnable(cmuClock_LETIMER0, true);
+  CMU_ClockEnable(cmuClock_TIMER0, true);
+  CMU_ClockEnable(cmuClock_LDMA, true);
+  /* Note: For EFR32xG21 radio devices, library function calls to
+   * CMU_ClockEnable() have no effect as oscillators are automatically turned
+   * on/off based on demand from the peripherals; CMU_ClockEnable() is a dummy
+   * function for EFR32xG21 for library consistency/compatibility.
+   */
 }
 
 /**************************************************************************//**
- * @brief Clock initialization
+ * @brief
+ *    Set the colour of one LED
  *****************************************************************************/
-void initClock(void)
+void setPixel(uint32_t led, uint8_t red, uint8_t green, uint8_t blue)
 {
-  CMU_LFXOInit_TypeDef lfxoInit = CMU_LFXOINIT_DEFAULT;
-
-  // Select LFXO for the LETIMER
-  CMU_LFXOInit(&lfxoInit);
-  CMU_ClockSelectSet(cmuClock_EM23GRPACLK, cmuSelect_LFXO);
+  pixels[led * 3]     = green;
+  pixels[led * 3 + 1] = red;
+  pixels[led * 3 + 2] = blue;
 }
 
 /**************************************************************************//**
- * @brief LETIMER initialization
+ * @brief
+ *    Draw a red, a green and a blue dot chasing each other along the chain
  *****************************************************************************/
-void initLetimer(void)
+void drawPattern(uint32_t step)
 {
-  LETIMER_Init_TypeDef letimerInit = LETIMER_INIT_DEFAULT;
-
-  // Calculate the top value (frequency) based on clock source
-  uint32_t topValue = CMU_ClockFreqGet(cmuClock_LETIMER0) / OUT_FREQ;
-
-  // Reload top on underflow, pulse output, and run in free mode
-  letimerInit.comp0Top = true;
-  letimerInit.topValue = topValue;
-  letimerInit.ufoa0 = letimerUFOAPulse;
-  letimerInit.repMode = letimerRepeatFree;
-
-  // Enable LETIMER0 output0 on PA6
-  GPIO->LETIMERROUTE[0].ROUTEEN = GPIO_LETIMER_ROUTEEN_OUT0PEN;
-  GPIO->LETIMERROUTE[0].OUT0ROUTE = \
-      (gpioPortA << _GPIO_LETIMER_OUT0ROUTE_PORT_SHIFT) \
-      | (6 << _GPIO_LETIMER_OUT0ROUTE_PIN_SHIFT);
+  for (uint32_t i = 0; i < LED_COUNT; i++) {
+    setPixel(i, 0, 0, 0);
+  }
 
-  // Initialize and enable LETIMER
-  LETIMER_Init(LETIMER0, &letimerInit);
+  setPixel(step % LED_COUNT, 32, 0, 0);
+  setPixel((step + LED_COUNT / 3) % LED_COUNT, 0, 32, 0);
+  setPixel((step + 2 * LED_COUNT / 3) % LED_COUNT, 0, 0, 32);
 }
 
 /**************************************************************************//**
@@ -109,18 +117,32 @@ void initLetimer(void)
  *****************************************************************************/
 int main(void)
 {
+  const BITS_Timing_t timing = BITS_TIMING_WS2812;
+  uint32_t frames = 0;
+  uint32_t step = 0;
+
   // Chip errata
   CHIP_Init();
 
   // Initializations
   initCmu();
-  initClock();
   initGpio();
-  initLetimer();
 
-  // Enter low energy state, pulse train will continue
-  while (1)
-  {
-    EMU_EnterEM2(true);
+  // Stop here if the timer clock cannot resolve the bit timing
+  if (!BITS_Init(&timing)) {
+    __BKPT(0);
+  }
+
+  while (1) {
+    if (frames++ % FRAMES_PER_STEP == 0) {
+      drawPattern(step++);
+    }
+
+    BITS_Send(pixels, sizeof(pixels));
+
+    // The LDMA interrupts once per chunk, sleep in between
+    while (BITS_IsBusy()) {
+      EMU_EnterEM1();
+    }
   }
 }
@@ -0,0 +1,339 @@
+/***************************************************************************//**
+ * @file main.c
+ * @brief This project demonstrates period and duty cycle measurement without
+ * an interrupt per edge. TIMER0 restarts on every rising edge, so CC0 captures
+ * the period and CC1 the high time of each cycle, and the LDMA moves both into
+ * buffers that are evaluated a batch at a time.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2021 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ *******************************************************************************
+ * # Evaluation Quality
+ * This code has been minimally tested to ensure that it builds and is suitable 
+ * as a demonstration for evaluation purposes only. This code will be maintained
+ * at the sole discretion of Silicon Labs.
+ ******************************************************************************/
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "em_device.h"
+#include "em_chip.h"
+#include "em_cmu.h"
+#include "em_core.h"
+#include "em_emu.h"
+#include "em_gpio.h"
+#include "em_ldma.h"
+#include "em_timer.h"
+
+// LDMA channels for the period (CC0) and high time (CC1) captures
+#define PERIOD_LDMA_CH    0
+#define HIGH_LDMA_CH      1
+
+// Cycles evaluated per batch; the LDMA interrupts once per batch
+#define BATCH_SIZE        256
+#define RING_SIZE         (2 * BATCH_SIZE)
+
+// Measurement results of the last batch, times in TIMER0 clocks
+typedef struct {
+  uint32_t cycles;        // Cycles in the batch
+  uint32_t periodMin;
+  uint32_t periodMax;
+  uint32_t periodMean;
+  uint32_t highMin;
+  uint32_t highMax;
+  uint32_t dutyCycle;     // Mean duty cycle in units of 0.01 %
+  uint32_t frequency;     // Mean frequency in Hz
+} Measurement_t;
+
+volatile Measurement_t measurement;
+
+// Batches evaluated, and batches overwritten before they were evaluated
+volatile uint32_t batchesProcessed;
+volatile uint32_t batchesDropped;
+
+// Capture rings of two batches each, written by the LDMA
+static uint32_t periodRing[RING_SIZE];
+static uint32_t highRing[RING_SIZE];
+
+static LDMA_Descriptor_t periodDesc[2];
+static LDMA_Descriptor_t highDesc[2];
+
+// Half of the rings filled last, and set until the main loop has
+// evaluated it
+static volatile uint32_t readyHalf;
+static volatile bool halfReady;
+static uint32_t lastHalf = 1;
+
+// Offset from a period capture to the high time of the same cycle, found
+// from the first batch
+static bool aligned;
+static uint32_t highShift;
+
+static uint32_t timerFreq;
+
+/**************************************************************************//**
+ * @brief
+ *    LDMA interrupt handler, runs once per batch of period captures
+ *
+ * @details
+ *    The falling edge of a cycle comes before the rising edge that ends it,
+ *    so once the periods of a batch are in, its high times are in as well.
+ *****************************************************************************/
+void LDMA_IRQHandler(void)
+{
+  uint32_t pending = LDMA_IntGetEnabled();
+  uint32_t half;
+
+  if (pending & LDMA_IF_ERROR) {
+    __BKPT(0);
+  }
+
+  if (pending & (1 << PERIOD_LDMA_CH)) {
+    LDMA_IntClear(1 << PERIOD_LDMA_CH);
+
+    // The half the LDMA is not writing is the one just completed
+    if (LDMA->CH[PERIOD_LDMA_CH].DST < (uint32_t)&periodRing[BATCH_SIZE]) {
+      half = 1;
+    } else {
+      half = 0;
+    }
+
+    // An interrupt was missed, or the main loop is still on the last batch
+    if ((half == lastHalf) || halfReady) {
+      batchesDropped++;
+    }
+    lastHalf = half;
+
+    readyHalf = half;
+    halfReady = true;
+  }
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Evaluate one batch of captures
+ *****************************************************************************/
+void processBatch(uint32_t half)
+{
+  uint32_t first = half * BATCH_SIZE;
+  uint32_t periodMin = UINT32_MAX, periodMax = 0;
+  uint32_t highMin = UINT32_MAX, highMax = 0;
+  uint64_t periodSum = 0, highSum = 0;
+  uint32_t cycles = 0;
+  uint32_t i, period, high;
+
+  /*
+   * TIMER0 is held at 0 until the first rising edge starts it. A capture
+   * taken before that holds 0: the first period capture, and the first high
+   * time capture if the input was high at start-up. Such a leading entry
+   * has no cycle to go with and shifts the pairing by one.
+   */
+  if (!aligned) {
+    highShift = RING_SIZE
+                + ((highRing[0] == 0) ? 1 : 0)
+                - ((periodRing[0] == 0) ? 1 : 0);
+    aligned = true;
+  }
+
+  for (i = first; i < first + BATCH_SIZE; i++) {
+    period = periodRing[i];
+    high = highRing[(i + highShift) % RING_SIZE];
+
+    if (period == 0) {
+      continue;
+    }
+
+    if (period < periodMin) {
+      periodMin = period;
+    }
+    if (period > periodMax) {
+      periodMax = period;
+    }
+    if (high < highMin) {
+      highMin = high;
+    }
+    if (high > highMax) {
+      highMax = high;
+    }
+    periodSum += period;
+    highSum += high;
+    cycles++;
+  }
+
+  if (cycles == 0) {
+    return;
+  }
+
+  measurement.cycles = cycles;
+  measurement.periodMin = periodMin;
+  measurement.periodMax = periodMax;
+  measurement.periodMean = (uint32_t)(periodSum / cycles);
+  measurement.highMin = highMin;
+  measurement.highMax = highMax;
+  measurement.dutyCycle = (uint32_t)((highSum * 10000) / periodSum);
+  measurement.frequency = (uint32_t)(((uint64_t)timerFreq * cycles) / periodSum);
+}
+
+/**************************************************************************//**
+ * @brief
+ *    GPIO initialization
+ *****************************************************************************/
+void initGpio(void)
+{
+  // Configure PA6 as input
+  GPIO_PinModeSet(gpioPortA, 6, gpioModeInput, 0);
+}
+
+/**************************************************************************//**
+ * @brief
+ *    CMU initialization
+ *****************************************************************************/
+void initCmu(void)
+{
+  // Enable clock to GPIO, TIMER0 and LDMA
+  CMU_ClockEnable(cmuClock_GPIO, true);
+  CMU_ClockEnable(cmuClock_TIMER0, true);
+  CMU_ClockEnable(cmuClock_LDMA, true);
+  /* Note: For EFR32xG21 radio devices, library function calls to
+   * CMU_ClockEnable() have no effect as oscillators are automatically turned
+   * on/off based on demand from the peripherals; CMU_ClockEnable() is a dummy
+   * function for EFR32xG21 for library consistency/compatibility.
+   */
+}
+
+/**************************************************************************//**
+ * @brief
+ *    TIMER initialization
+ *
+ * @details
+ *    CC0 and CC1 both take their input from PA6. Each rising edge captures
+ *    the count in CC0 and then restarts TIMER0 from 0, so CC0 captures the
+ *    period and CC1, on the falling edge, the high time of each cycle.
+ *    TIMER0 is not started here; the first rising edge starts it.
+ *****************************************************************************/
+void initTimer(void)
+{
+  // Initialize the timer
+  TIMER_Init_TypeDef timerInit = TIMER_INIT_DEFAULT;
+  // Configure TIMER0 Compare/Capture for input capture
+  TIMER_InitCC_TypeDef periodInit = TIMER_INITCC_DEFAULT;
+  TIMER_InitCC_TypeDef highInit = TIMER_INITCC_DEFAULT;
+
+  timerInit.prescale = timerPrescale1;
+  timerInit.enable = false;
+  timerInit.riseAction = timerInputActionReloadStart;
+  periodInit.edge = timerEdgeRising;
+  periodInit.mode = timerCCModeCapture;
+  highInit.edge = timerEdgeFalling;
+  highInit.mode = timerCCModeCapture;
+
+  TIMER_Init(TIMER0, &timerInit);
+
+  // Route Timer0 CC0 and CC1 inputs to PA6
+  GPIO->TIMERROUTE[0].ROUTEEN  = GPIO_TIMER_ROUTEEN_CC0PEN
+                                 | GPIO_TIMER_ROUTEEN_CC1PEN;
+  GPIO->TIMERROUTE[0].CC0ROUTE = (gpioPortA << _GPIO_TIMER_CC0ROUTE_PORT_SHIFT)
+                    | (6 << _GPIO_TIMER_CC0ROUTE_PIN_SHIFT);
+  GPIO->TIMERROUTE[0].CC1ROUTE = (gpioPortA << _GPIO_TIMER_CC1ROUTE_PORT_SHIFT)
+                    | (6 << _GPIO_TIMER_CC1ROUTE_PIN_SHIFT);
+
+  TIMER_InitCC(TIMER0, 0, &periodInit);
+  TIMER_InitCC(TIMER0, 1, &highInit);
+
+  timerFreq = CMU_ClockFreqGet(cmuClock_TIMER0);
+}
+
+/**************************************************************************//**
+ * @brief
+ *    LDMA initialization
+ *
+ * @details
+ *    Each channel loops over the two halves of its ring, one word per
+ *    capture. Only the period channel interrupts, at the end of each half.
+ *****************************************************************************/
+void initLdma(void)
+{
+  LDMA_Init_t init = LDMA_INIT_DEFAULT;
+  LDMA_TransferCfg_t periodCfg =
+    LDMA_TRANSFER_CFG_PERIPHERAL(ldmaPeripheralSignal_TIMER0_CC0);
+  LDMA_TransferCfg_t highCfg =
+    LDMA_TRANSFER_CFG_PERIPHERAL(ldmaPeripheralSignal_TIMER0_CC1);
+
+  LDMA_Init(&init);
+
+  periodDesc[0] = (LDMA_Descriptor_t)
+    LDMA_DESCRIPTOR_LINKREL_P2M_WORD(&TIMER0->CC[0].ICF, &periodRing[0],
+                                     BATCH_SIZE, 1);
+  periodDesc[1] = (LDMA_Descriptor_t)
+    LDMA_DESCRIPTOR_LINKREL_P2M_WORD(&TIMER0->CC[0].ICF, &periodRing[BATCH_SIZE],
+                                     BATCH_SIZE, -1);
+  periodDesc[0].xfer.doneIfs = 1;
+  periodDesc[1].xfer.doneIfs = 1;
+
+  highDesc[0] = (LDMA_Descriptor_t)
+    LDMA_DESCRIPTOR_LINKREL_P2M_WORD(&TIMER0->CC[1].ICF, &highRing[0],
+                                     BATCH_SIZE, 1);
+  highDesc[1] = (LDMA_Descriptor_t)
+    LDMA_DESCRIPTOR_LINKREL_P2M_WORD(&TIMER0->CC[1].ICF, &highRing[BATCH_SIZE],
+                                     BATCH_SIZE, -1);
+
+  LDMA_StartTransfer(PERIOD_LDMA_CH, &periodCfg, &periodDesc[0]);
+  LDMA_StartTransfer(HIGH_LDMA_CH, &highCfg, &highDesc[0]);
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Main function
+ *****************************************************************************/
+int main(void)
+{
+  CORE_DECLARE_IRQ_STATE;
+
+  // Chip errata
+  CHIP_Init();
+
+  // Initializations
+  initCmu();
+  initGpio();
+  initTimer();
+  initLdma();
+
+  while (1) {
+    // Enter EM1 until the next batch is complete
+    CORE_ENTER_CRITICAL();
+    if (!halfReady) {
+      EMU_EnterEM1();
+    }
+    CORE_EXIT_CRITICAL();
+
+    if (halfReady) {
+      processBatch(readyHalf);
+      batchesProcessed++;
+
+      // Done with it, the LDMA may overwrite it from now on
+      halfReady = false;
+    }
+  }
+}
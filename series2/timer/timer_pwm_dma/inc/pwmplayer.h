@@ -0,0 +1,75 @@
+/***************************************************************************//**
+ * @file pwmplayer.h
+ *
+ * @brief LDMA driven PWM waveform player for TIMER0 CC0.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2021 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ******************************************************************************/
+
+#ifndef PWMPLAYER_H
+#define PWMPLAYER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// LDMA channel that writes the compare buffer
+#define PWMP_LDMA_CHANNEL     0
+
+// Descriptors per program: one to mark the start, one per repeated
+// segment to load the loop counter, one per 2048 table entries and one
+// at the end to link to what plays next
+#define PWMP_MAX_DESCRIPTORS  32
+
+// The LDMA loop counter is 8 bits wide
+#define PWMP_MAX_REPEAT       256
+
+/*
+ * A run of PWM periods: each table entry is the compare value for one
+ * period, and the whole table is played repeat times before the next
+ * segment starts. The table must stay valid for as long as it plays.
+ */
+typedef struct {
+  const uint16_t *table;
+  uint32_t length;
+  uint32_t repeat;
+} PWMP_Segment_t;
+
+void PWMP_Init(void);
+bool PWMP_Play(const PWMP_Segment_t *segments, uint32_t count, bool loop);
+void PWMP_Stop(void);
+bool PWMP_IsPlaying(void);
+bool PWMP_IsPending(void);
+uint32_t PWMP_GetPassCount(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // PWMPLAYER_H
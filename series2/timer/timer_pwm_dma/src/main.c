@@ -3,7 +3,8 @@
  * @brief This project demonstrates DMA driven pulse width modulation using the
  * TIMER module. The GPIO pin specified in the readme.txt is configured to
  * output a 1kHz signal. The DMA continuously updates the CCVB register to vary
- * the duty cycle.
+ * the duty cycle, playing two waveform programs in turn without any CPU
+ * involvement per period.
  *******************************************************************************
  * # License
  * <b>Copyright 2020 Silicon Laboratories Inc. www.silabs.com</b>
@@ -43,6 +44,7 @@
 #include "em_gpio.h"
 #include "em_timer.h"
 #include "em_ldma.h"
+#include "pwmplayer.h"
 
 // Note: change this to set the desired Output frequency in Hz
 #define PWM_FREQ 1000
@@ -50,13 +52,32 @@
 // Buffer size
 #define BUFFER_SIZE 11
 
+// Periods of the rise and fall of the breathing pattern
+#define BREATHE_SIZE 200
+
+// Program passes played before switching to the other program
+#define SWITCH_PASSES 5
+
 // Note: change this to change the duty cycles used in this example
 static const uint16_t dutyCyclePercentages[BUFFER_SIZE] =
     {0, 10, 20, 30, 40, 50, 60, 70, 80, 90, 100};
 
-// Buffer of duty cycle values for DMA transfer to CCVB
-// Buffer is populated after TIMER is initialized and Top value is set
+// Buffers of compare values played by the LDMA, populated after TIMER is
+// initialized and Top value is set
 static uint16_t buffer[BUFFER_SIZE];
+static uint16_t breathe[BREATHE_SIZE];
+static uint16_t half;
+
+// Staircase of 50 periods per step, then a quarter second at 50 %
+static const PWMP_Segment_t stairs[] = {
+  { buffer, BUFFER_SIZE, 50 },
+  { &half,  1,           250 },
+};
+
+// Linear rise and fall, one compare value per period
+static const PWMP_Segment_t breathing[] = {
+  { breathe, BREATHE_SIZE, 1 },
+};
 
 /**************************************************************************//**
  * @brief
@@ -121,54 +142,22 @@ void initTimer(void)
 
 /**************************************************************************//**
  * @brief
- *    Populate buffer with timer duty cycle values
+ *    Populate buffers with timer duty cycle values
  *****************************************************************************/
 void populateBuffer(void)
 {
+  uint32_t top = TIMER_TopGet(TIMER0);
+
   for (uint32_t i = 0; i < BUFFER_SIZE; i++) {
-    buffer[i] = (uint16_t) (TIMER_TopGet(TIMER0) * dutyCyclePercentages[i] / 100);
+    buffer[i] = (uint16_t) (top * dutyCyclePercentages[i] / 100);
   }
-}
 
-/**************************************************************************//**
-* @brief
-*    Initialize the LDMA module
-*
-* @details
-*    Configure the channel descriptor to use the default peripheral to
-*    memory transfer descriptor. Modify it to not generate an interrupt
-*    upon transfer completion (we don't need it). Additionally, the transfer
-*    configuration selects the TIMER0_CC0 signal as the trigger for the LDMA
-*    transaction to occur.
-*
-* @note
-*    The descriptor object needs to at least have static scope persistence so
-*    that the reference to the object is valid beyond its first use in
-*    initialization
-*****************************************************************************/
-void initLdma(void)
-{
-  // Start the transfer
-  uint32_t channelNum = 0;
-
-  // LDMA initialization
-  LDMA_Init_t init = LDMA_INIT_DEFAULT;
-  LDMA_Init(&init);
-
-  // Transfer configuration and trigger selection
-  LDMA_TransferCfg_t transferConfig =
-    LDMA_TRANSFER_CFG_PERIPHERAL(ldmaPeripheralSignal_TIMER0_CC0);
-
-  // Channel descriptor configuration
-  static LDMA_Descriptor_t descriptor =
-    LDMA_DESCRIPTOR_LINKREL_M2P_BYTE(&buffer,            // Memory source address
-                                    &TIMER0->CC[0].OCB, // Peripheral destination address
-                                    BUFFER_SIZE,         // Number of bytes per transfer
-                                    0);                  // Link to same descriptor
-  descriptor.xfer.size     = ldmaCtrlSizeHalf; // Unit transfer size
-  descriptor.xfer.doneIfs  = 0;                // Don't trigger interrupt when done
-
-  LDMA_StartTransfer(channelNum, &transferConfig, &descriptor);
+  for (uint32_t i = 0; i < BREATHE_SIZE / 2; i++) {
+    breathe[i] = (uint16_t) (top * i / (BREATHE_SIZE / 2));
+    breathe[BREATHE_SIZE - 1 - i] = breathe[i];
+  }
+
+  half = (uint16_t) (top / 2);
 }
 
 /**************************************************************************//**
@@ -184,12 +173,28 @@ int main(void)
   initGpio();
   initTimer();
 
-  // Initialize DMA only after buffer is populated
+  // Start the player only after the buffers are populated
   populateBuffer();
-  initLdma();
+  PWMP_Init();
+  PWMP_Play(stairs, sizeof(stairs) / sizeof(stairs[0]), true);
+
+  uint32_t lastSwitch = 0;
+  bool playingStairs = true;
 
   while (1) {
-    EMU_EnterEM1(); // Enter EM1 (won't exit)
+    // The LDMA interrupts once per program pass only
+    EMU_EnterEM1();
+
+    // Queue the other program, it takes over at the end of this pass
+    if (!PWMP_IsPending()
+        && (PWMP_GetPassCount() - lastSwitch >= SWITCH_PASSES)) {
+      playingStairs = !playingStairs;
+      if (playingStairs) {
+        PWMP_Play(stairs, sizeof(stairs) / sizeof(stairs[0]), true);
+      } else {
+        PWMP_Play(breathing, sizeof(breathing) / sizeof(breathing[0]), true);
+      }
+      lastSwitch = PWMP_GetPassCount();
+    }
   }
 }
-
@@ -0,0 +1,342 @@
+/***************************************************************************//**
+ * @file pwmplayer.c
+ *
+ * @brief LDMA driven PWM waveform player for TIMER0 CC0.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2021 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ *******************************************************************************
+ * # Evaluation Quality
+ * This code has been minimally tested to ensure that it builds and is suitable 
+ * as a demonstration for evaluation purposes only. This code will be maintained
+ * at the sole discretion of Silicon Labs.
+ ******************************************************************************/
+
+#include "em_device.h"
+#include "em_core.h"
+#include "em_ldma.h"
+
+#include "pwmplayer.h"
+
+// Compare buffer the tables are written to and the LDMA request that
+// paces them. The compare request is raised once per period and cleared
+// by the write, and the buffer is copied to the compare value at the next
+// overflow, so every entry lasts exactly one whole period.
+#define COMPARE_BUFFER      (&TIMER0->CC[0].OCB)
+#define COMPARE_SIGNAL      ldmaPeripheralSignal_TIMER0_CC0
+
+#define CHANNEL_DONE        (1 << PWMP_LDMA_CHANNEL)
+
+// Largest transfer of a single descriptor
+#define MAX_XFER            2048
+
+/*
+ * Each program is a descriptor list:
+ *
+ *   start     writes the program number to startedProgram, interrupts
+ *   loop      loads the loop counter, only for segments repeated
+ *   table     one descriptor per MAX_XFER entries, the last one links
+ *             back to the first while the loop counter is not zero
+ *   ...       loop and table descriptors of the other segments
+ *   end       links to the start of the program that plays next, or
+ *             ends the transfer
+ *
+ * Two programs are kept so the next one can be written while the other
+ * plays. Changing the link of the end descriptor switches over exactly
+ * between two periods, after the last entry of the playing program.
+ */
+static LDMA_Descriptor_t program[2][PWMP_MAX_DESCRIPTORS];
+static LDMA_Descriptor_t *endDesc[2];
+
+// Written by the start descriptor of each program
+static volatile uint32_t startedProgram;
+
+static volatile uint32_t activeProgram;
+static volatile bool playing;
+static volatile bool queued;
+static volatile uint32_t passes;
+
+/**************************************************************************//**
+ * @brief
+ *   Make a descriptor link to the start of a program
+ *****************************************************************************/
+static void linkTo(LDMA_Descriptor_t *desc, uint32_t next)
+{
+  desc->xfer.linkMode = ldmaLinkModeAbs;
+  desc->xfer.linkAddr = (uint32_t)&program[next][0] >> 2;
+  desc->xfer.link     = 1;
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Write the descriptor list of a program
+ *
+ * @return
+ *   False if a segment is empty, repeated too often, or the segments need
+ *   more than PWMP_MAX_DESCRIPTORS descriptors.
+ *****************************************************************************/
+static bool buildProgram(uint32_t index,
+                         const PWMP_Segment_t *segments,
+                         uint32_t count,
+                         bool loop)
+{
+  LDMA_Descriptor_t *desc = program[index];
+  uint32_t needed = 2;
+  uint32_t n, s, offset, chunk, first;
+
+  if ((segments == NULL) || (count == 0)) {
+    return false;
+  }
+
+  for (s = 0; s < count; s++) {
+    if ((segments[s].table == NULL) || (segments[s].length == 0)
+        || (segments[s].repeat == 0) || (segments[s].repeat > PWMP_MAX_REPEAT)) {
+      return false;
+    }
+    needed += (segments[s].length + MAX_XFER - 1) / MAX_XFER;
+    needed += (segments[s].repeat > 1) ? 1 : 0;
+  }
+  if (needed > PWMP_MAX_DESCRIPTORS) {
+    return false;
+  }
+
+  desc[0] = (LDMA_Descriptor_t)LDMA_DESCRIPTOR_LINKREL_WRITE(index, &startedProgram, 1);
+  desc[0].wri.doneIfs = 1;
+  n = 1;
+
+  for (s = 0; s < count; s++) {
+    if (segments[s].repeat > 1) {
+      desc[n++] = (LDMA_Descriptor_t)
+        LDMA_DESCRIPTOR_LINKREL_WRITE(segments[s].repeat - 1,
+                                      &LDMA->CH[PWMP_LDMA_CHANNEL].LOOP,
+                                      1);
+    }
+
+    first = n;
+    for (offset = 0; offset < segments[s].length; offset += chunk) {
+      chunk = segments[s].length - offset;
+      if (chunk > MAX_XFER) {
+        chunk = MAX_XFER;
+      }
+      desc[n] = (LDMA_Descriptor_t)
+        LDMA_DESCRIPTOR_LINKREL_M2P_BYTE(&segments[s].table[offset],
+                                         COMPARE_BUFFER,
+                                         chunk,
+                                         1);
+      desc[n].xfer.size    = ldmaCtrlSizeHalf;
+      desc[n].xfer.doneIfs = 0;
+      n++;
+    }
+
+    // Play the table again until the loop counter runs out
+    if (segments[s].repeat > 1) {
+      desc[n - 1].xfer.decLoopCnt = 1;
+      desc[n - 1].xfer.linkAddr   =
+        -(int32_t)((n - 1 - first) * LDMA_DESCRIPTOR_NDWORDS);
+    }
+  }
+
+  // A write with no effect, only there to carry the link
+  desc[n] = (LDMA_Descriptor_t)
+    LDMA_DESCRIPTOR_LINKREL_WRITE(0, &LDMA->CH[PWMP_LDMA_CHANNEL].LOOP, 0);
+  if (loop) {
+    linkTo(&desc[n], index);
+  } else {
+    desc[n].wri.link    = 0;
+    desc[n].wri.doneIfs = 1;
+  }
+  endDesc[index] = &desc[n];
+
+  return true;
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Start a program on an idle channel
+ *****************************************************************************/
+static void startProgram(uint32_t index)
+{
+  LDMA_TransferCfg_t cfg = LDMA_TRANSFER_CFG_PERIPHERAL(COMPARE_SIGNAL);
+
+  activeProgram = index;
+  queued = false;
+  playing = true;
+  LDMA_StartTransfer(PWMP_LDMA_CHANNEL, &cfg, &program[index][0]);
+}
+
+/**************************************************************************//**
+ * @brief LDMA Handler
+ *****************************************************************************/
+void LDMA_IRQHandler(void)
+{
+  uint32_t pending = LDMA_IntGetEnabled();
+
+  if (pending & LDMA_IF_ERROR) {
+    __BKPT(0);
+  }
+
+  if (!(pending & CHANNEL_DONE)) {
+    return;
+  }
+  LDMA_IntClear(CHANNEL_DONE);
+
+  if (LDMA_TransferDone(PWMP_LDMA_CHANNEL)) {
+    // The end descriptor of a program that does not loop
+    playing = false;
+    if (queued) {
+      startProgram(activeProgram ^ 1);
+    }
+    return;
+  }
+
+  // A pass is starting, of the queued program once the switch is made
+  passes++;
+  if (queued && (startedProgram != activeProgram)) {
+    activeProgram = startedProgram;
+    queued = false;
+  }
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Set up the LDMA for the player
+ *
+ * @note
+ *   TIMER0 must be set up for PWM on CC0 and running. The player only
+ *   writes the compare buffer.
+ *****************************************************************************/
+void PWMP_Init(void)
+{
+  LDMA_Init_t init = LDMA_INIT_DEFAULT;
+
+  LDMA_Init(&init);
+
+  playing = false;
+  queued = false;
+  passes = 0;
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Play a sequence of segments
+ *
+ * @details
+ *   If nothing is playing the program starts with the next period.
+ *   Otherwise it is queued and takes over after the last entry of the
+ *   program playing now, which for a looping program is the end of its
+ *   current pass. Only one program can be queued at a time.
+ *
+ * @param[in] segments
+ *   Segments played in order. The array itself is not needed after the
+ *   call, the tables are.
+ *
+ * @param[in] count
+ *   Number of segments.
+ *
+ * @param[in] loop
+ *   Play again from the first segment after the last, until another
+ *   program is queued or PWMP_Stop() is called. Without loop the compare
+ *   value of the last entry stays in place when the program ends.
+ *
+ * @return
+ *   False if a program is already queued or the segments are invalid.
+ *****************************************************************************/
+bool PWMP_Play(const PWMP_Segment_t *segments, uint32_t count, bool loop)
+{
+  uint32_t next;
+
+  CORE_DECLARE_IRQ_STATE;
+  CORE_ENTER_CRITICAL();
+
+  if (queued) {
+    CORE_EXIT_CRITICAL();
+    return false;
+  }
+
+  next = playing ? (activeProgram ^ 1) : activeProgram;
+  if (!buildProgram(next, segments, count, loop)) {
+    CORE_EXIT_CRITICAL();
+    return false;
+  }
+
+  if (!playing) {
+    startProgram(next);
+  } else {
+    // The end descriptor may already be loaded; then the link is taken
+    // at the end of the next pass, or the interrupt starts the program
+    // if the playing one does not loop. The link is written before the
+    // interrupt is dropped, which the LDMA reads the other way round.
+    queued = true;
+    linkTo(endDesc[activeProgram], next);
+    endDesc[activeProgram]->wri.doneIfs = 0;
+  }
+
+  CORE_EXIT_CRITICAL();
+  return true;
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Stop playing, the compare value last written stays in place
+ *****************************************************************************/
+void PWMP_Stop(void)
+{
+  CORE_DECLARE_IRQ_STATE;
+  CORE_ENTER_CRITICAL();
+
+  LDMA_StopTransfer(PWMP_LDMA_CHANNEL);
+  LDMA_IntClear(CHANNEL_DONE);
+  playing = false;
+  queued = false;
+
+  CORE_EXIT_CRITICAL();
+}
+
+/**************************************************************************//**
+ * @brief
+ *   True until PWMP_Stop() or the end of a program that does not loop
+ *****************************************************************************/
+bool PWMP_IsPlaying(void)
+{
+  return playing;
+}
+
+/**************************************************************************//**
+ * @brief
+ *   True while a program waits for the playing one to reach its end
+ *****************************************************************************/
+bool PWMP_IsPending(void)
+{
+  return queued;
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Program passes started since PWMP_Init(), counting each loop
+ *****************************************************************************/
+uint32_t PWMP_GetPassCount(void)
+{
+  return passes;
+}
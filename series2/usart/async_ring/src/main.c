@@ -0,0 +1,232 @@
+/***************************************************************************//**
+ * @file main.c
+ *
+ * @brief This project demonstrates full-duplex asynchronous operation of the
+ * USART through the UartRing driver. The LDMA fills an RX ring and sends a
+ * TX ring, and the main loop echoes every byte received, so a stream sent
+ * at up to 1 Mbaud comes back unchanged while the MCU sleeps in EM1.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2021 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ *******************************************************************************
+ * # Evaluation Quality
+ * This code has been minimally tested to ensure that it builds and is suitable
+ * as a demonstration for evaluation purposes only. This code will be maintained
+ * at the sole discretion of Silicon Labs.
+ ******************************************************************************/
+
+#include "em_device.h"
+#include "em_chip.h"
+#include "em_cmu.h"
+#include "em_core.h"
+#include "em_emu.h"
+#include "em_gpio.h"
+#include "em_ldma.h"
+#include "em_usart.h"
+
+// BSP for board controller pin macros
+#include "bsp.h"
+
+#include "uartring.h"
+
+// Baud rate, the driver holds up at 1000000 in both directions at once
+#define BAUDRATE          115200
+
+// LDMA channels of the driver
+#define RX_LDMA_CHANNEL   0
+#define TX_LDMA_CHANNEL   1
+
+// Ring sizes, powers of two. The RX ring takes a burst the main loop is
+// too busy for, the TX ring what is queued while the USART catches up.
+#define RX_RING_SIZE      256
+#define TX_RING_SIZE      256
+
+// Bytes moved from the RX ring to the TX ring at a time
+#define ECHO_CHUNK        64
+
+static uint8_t rxRing[RX_RING_SIZE];
+static uint8_t txRing[TX_RING_SIZE];
+
+static UARTRING_Handle_t uart;
+
+// Statistics
+volatile uint32_t echoedBytes;
+volatile uint32_t rxOverruns;
+volatile uint32_t txFullWaits;
+
+/**************************************************************************//**
+ * @brief
+ *    GPIO initialization
+ *****************************************************************************/
+void initGPIO(void)
+{
+  CMU_ClockEnable(cmuClock_GPIO, true);
+
+  // Configure the USART TX pin to the board controller as an output
+  GPIO_PinModeSet(BSP_BCC_TXPORT, BSP_BCC_TXPIN, gpioModePushPull, 1);
+
+  // Configure the USART RX pin to the board controller as an input
+  GPIO_PinModeSet(BSP_BCC_RXPORT, BSP_BCC_RXPIN, gpioModeInput, 0);
+
+  /*
+   * Configure the BCC_ENABLE pin as output and set high.  This enables
+   * the virtual COM port (VCOM) connection to the board controller and
+   * permits serial port traffic over the debug connection to the host
+   * PC.
+   *
+   * To disable the VCOM connection and use the pins on the kit
+   * expansion (EXP) header, comment out the following line.
+   */
+  GPIO_PinModeSet(BSP_BCC_ENABLE_PORT, BSP_BCC_ENABLE_PIN, gpioModePushPull, 1);
+}
+
+/**************************************************************************//**
+ * @brief
+ *    USART0 initialization
+ *****************************************************************************/
+void initUSART0(void)
+{
+  CMU_ClockEnable(cmuClock_USART0, true);
+
+  // Default asynchronous initializer (8N1, no flow control)
+  USART_InitAsync_TypeDef init = USART_INITASYNC_DEFAULT;
+
+  init.baudrate = BAUDRATE;
+
+  // Route USART0 TX and RX to the board controller TX and RX pins
+  GPIO->USARTROUTE[0].TXROUTE = (BSP_BCC_TXPORT << _GPIO_USART_TXROUTE_PORT_SHIFT)
+      | (BSP_BCC_TXPIN << _GPIO_USART_TXROUTE_PIN_SHIFT);
+  GPIO->USARTROUTE[0].RXROUTE = (BSP_BCC_RXPORT << _GPIO_USART_RXROUTE_PORT_SHIFT)
+      | (BSP_BCC_RXPIN << _GPIO_USART_RXROUTE_PIN_SHIFT);
+
+  // Enable RX and TX signals now that they have been routed
+  GPIO->USARTROUTE[0].ROUTEEN = GPIO_USART_ROUTEEN_RXPEN | GPIO_USART_ROUTEEN_TXPEN;
+
+  // Configure and enable USART0
+  USART_InitAsync(USART0, &init);
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Ring driver initialization, the RX channel starts right away
+ *****************************************************************************/
+void initUartRing(void)
+{
+  UARTRING_Init_t init = {
+    .usart     = USART0,
+    .rxChannel = RX_LDMA_CHANNEL,
+    .txChannel = TX_LDMA_CHANNEL,
+    .rxSignal  = ldmaPeripheralSignal_USART0_RXDATAV,
+    .txSignal  = ldmaPeripheralSignal_USART0_TXBL,
+    .rxBuffer  = rxRing,
+    .rxSize    = RX_RING_SIZE,
+    .txBuffer  = txRing,
+    .txSize    = TX_RING_SIZE,
+  };
+
+  LDMA_Init_t ldmaInit = LDMA_INIT_DEFAULT;
+  LDMA_Init(&ldmaInit);
+
+  UARTRING_Init(&uart, &init);
+
+  // The driver's RX idle timer interrupts through the USART
+  NVIC_ClearPendingIRQ(USART0_RX_IRQn);
+  NVIC_EnableIRQ(USART0_RX_IRQn);
+  NVIC_ClearPendingIRQ(USART0_TX_IRQn);
+  NVIC_EnableIRQ(USART0_TX_IRQn);
+}
+
+/**************************************************************************//**
+ * @brief LDMA IRQHandler
+ *****************************************************************************/
+void LDMA_IRQHandler(void)
+{
+  UARTRING_IRQHandler(&uart);
+}
+
+/**************************************************************************//**
+ * @brief USART0 RX IRQHandler
+ *****************************************************************************/
+void USART0_RX_IRQHandler(void)
+{
+  UARTRING_IRQHandler(&uart);
+}
+
+/**************************************************************************//**
+ * @brief USART0 TX IRQHandler
+ *****************************************************************************/
+void USART0_TX_IRQHandler(void)
+{
+  UARTRING_IRQHandler(&uart);
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Main function
+ *****************************************************************************/
+int main(void)
+{
+  uint8_t chunk[ECHO_CHUNK];
+  size_t count;
+  CORE_DECLARE_IRQ_STATE;
+
+  // Chip errata
+  CHIP_Init();
+
+  // Initialize GPIO, USART0 and the rings
+  initGPIO();
+  initUSART0();
+  initUartRing();
+
+  while (1)
+  {
+    // Echo as much as the TX ring has room for
+    count = UARTRING_TxFree(&uart);
+    if (count > ECHO_CHUNK)
+      count = ECHO_CHUNK;
+    count = UARTRING_Read(&uart, chunk, count);
+
+    if (count > 0) {
+      UARTRING_Write(&uart, chunk, count);
+      echoedBytes += count;
+      rxOverruns = UARTRING_RxOverruns(&uart);
+      continue;
+    }
+
+    if ((UARTRING_TxFree(&uart) == 0) && (UARTRING_RxAvailable(&uart) > 0))
+      txFullWaits++;
+
+    /*
+     * Nothing to echo, or no room for it: wait in EM1 for the next RX
+     * half, RX idle or TX done interrupt.  The check is made with
+     * interrupts masked, an interrupt that comes in after it still ends
+     * the sleep.
+     */
+    CORE_ENTER_CRITICAL();
+    if ((UARTRING_RxAvailable(&uart) == 0) || (UARTRING_TxFree(&uart) == 0))
+      EMU_EnterEM1();
+    CORE_EXIT_CRITICAL();
+  }
+}
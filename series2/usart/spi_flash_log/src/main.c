@@ -0,0 +1,202 @@
+/***************************************************************************//**
+ * @file main.c
+ * @brief This project logs a sample every millisecond from the SysTick
+ * interrupt to a log structured file store on the on-board MX25 SPI flash,
+ * reads the newest data back and prints the store counters over VCOM.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2022 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ *******************************************************************************
+ * # Evaluation Quality
+ * This code has been minimally tested to ensure that it builds and is suitable
+ * as a demonstration for evaluation purposes only. This code will be maintained
+ * at the sole discretion of Silicon Labs.
+ ******************************************************************************/
+
+#include <stdio.h>
+#include "em_device.h"
+#include "em_chip.h"
+#include "em_cmu.h"
+#include "em_emu.h"
+#include "em_gpio.h"
+#include "em_ldma.h"
+#include "bsp.h"
+#include "retargetserial.h"
+#include "mx25flash_spi.h"
+#include "mx25log.h"
+
+// Log area, 256 kB from 256 kB up; wraps when full of samples
+#define LOG_BASE        0x40000
+#define LOG_SECTORS     64
+
+// Samples from the SysTick interrupt, and a record per report
+#define FILE_SAMPLES    0
+#define FILE_REPORTS    1
+
+// Report period and samples read back for each report
+#define REPORT_MS       1000
+#define CHECK_SAMPLES   16
+
+// Oldest data read back, data this close to the end may still be in RAM
+#define CHECK_BACK      (MX25LOG_BUFFERS * MX25LOG_PAGE_DATA + Page_Offset)
+
+typedef struct {
+  uint32_t time;
+  uint32_t samples;
+  uint32_t pagesWritten;
+  uint32_t sectorsErased;
+} Report_t;
+
+static volatile uint32_t msTicks;
+
+/**************************************************************************//**
+ * @brief  SysTick interrupt handler, appends one sample per millisecond
+ *
+ * @details
+ *    The sample is its own index in the file, so the data read back can be
+ *    checked against its offset.
+ *****************************************************************************/
+void SysTick_Handler(void)
+{
+  uint32_t sample = MX25LOG_Size(FILE_SAMPLES) / sizeof(sample);
+
+  msTicks++;
+  MX25LOG_Append(FILE_SAMPLES, &sample, sizeof(sample));
+}
+
+/**************************************************************************//**
+ * @brief  LDMA interrupt handler, used by the MX25 driver for bulk reads
+ *****************************************************************************/
+void LDMA_IRQHandler(void)
+{
+  MX25_LDMA_IRQHandler();
+}
+
+/**************************************************************************//**
+ * @brief  Read back samples a little behind the newest, check and report
+ *
+ * @return
+ *    false if the store was busy, try again later.
+ *****************************************************************************/
+static bool report(void)
+{
+  uint32_t samples[CHECK_SAMPLES];
+  MX25LOG_Counters_TypeDef counters;
+  MX25LOG_Status_TypeDef status;
+  Report_t record;
+  uint32_t size, offset, count, i;
+  bool match;
+
+  size = MX25LOG_Size(FILE_SAMPLES);
+  if (size < CHECK_BACK) {
+    return true;
+  }
+  offset = size - CHECK_BACK;
+
+  status = MX25LOG_Read(FILE_SAMPLES, offset, samples, sizeof(samples),
+                        &count);
+  if (status == mx25logBusy) {
+    return false;
+  }
+
+  match = (status == mx25logOk) && (count == sizeof(samples));
+  for (i = 0; match && (i < CHECK_SAMPLES); i++) {
+    match = samples[i] == (offset / sizeof(samples[0])) + i;
+  }
+
+  MX25LOG_GetCounters(&counters);
+  printf("%7lu ms %8lu bytes %6lu pages %5lu copied %4lu erases"
+         " %6lu dropped %s\n",
+         msTicks, size, counters.pagesWritten, counters.pagesCopied,
+         counters.sectorsErased, counters.bytesDropped,
+         match ? "OK" : "DATA MISMATCH");
+
+  // One record per report in the second file, written at once
+  record.time = msTicks;
+  record.samples = size / sizeof(samples[0]);
+  record.pagesWritten = counters.pagesWritten;
+  record.sectorsErased = counters.sectorsErased;
+  MX25LOG_Append(FILE_REPORTS, &record, sizeof(record));
+  MX25LOG_Flush(FILE_REPORTS);
+
+  return true;
+}
+
+/**************************************************************************//**
+ * @brief  Main function
+ *****************************************************************************/
+int main(void)
+{
+  LDMA_Init_t ldmaInit = LDMA_INIT_DEFAULT;
+  MX25LOG_Init_TypeDef logInit;
+  MX25LOG_Counters_TypeDef counters;
+  uint32_t lastReport = 0;
+  uint32_t powerTicks = 0;
+
+  CHIP_Init();
+
+  // Retarget to USART1 so that USART0 stays with the flash
+  RETARGET_SerialInit();
+  RETARGET_SerialCrLf(1);
+
+  GPIO_PinModeSet(BSP_GPIO_LED0_PORT, BSP_GPIO_LED0_PIN, gpioModePushPull, 0);
+
+  MX25_init();
+  LDMA_Init(&ldmaInit);
+
+  // Rebuild the index from the flash, the files go on where they stopped
+  logInit.base = LOG_BASE;
+  logInit.sectors = LOG_SECTORS;
+  logInit.wrap = true;
+  if (!MX25LOG_Init(&logInit)) {
+    while (1) ;
+  }
+
+  MX25LOG_GetCounters(&counters);
+  printf("\nMX25 log, %lu sample bytes, %lu report bytes, %lu torn pages\n",
+         MX25LOG_Size(FILE_SAMPLES), MX25LOG_Size(FILE_REPORTS),
+         counters.tornPages);
+  GPIO_PinOutSet(BSP_GPIO_LED0_PORT, BSP_GPIO_LED0_PIN);
+
+  // 1 ms tick, the sample rate and the flash poll period
+  if (SysTick_Config(CMU_ClockFreqGet(cmuClock_SYSCLK) / 1000)) while (1) ;
+
+  while (1) {
+    MX25LOG_Process();
+
+    // Deep power down between page programs, one power tick per SysTick
+    while (powerTicks != msTicks) {
+      powerTicks++;
+      MX25_PowerTick();
+    }
+
+    if (((msTicks - lastReport) >= REPORT_MS) && report()) {
+      lastReport += REPORT_MS;
+    }
+
+    // Woken up by the next SysTick
+    EMU_EnterEM1();
+  }
+}
@@ -0,0 +1,127 @@
+/***************************************************************************//**
+ * @file main.c
+ * @brief This project compares the read throughput of the single I/O (READ,
+ * FAST_READ) and dual I/O (DREAD, 2READ) commands of the on-board MX25 SPI
+ * flash and prints the results over the VCOM port.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2022 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ *******************************************************************************
+ * # Evaluation Quality
+ * This code has been minimally tested to ensure that it builds and is suitable
+ * as a demonstration for evaluation purposes only. This code will be maintained
+ * at the sole discretion of Silicon Labs.
+ ******************************************************************************/
+
+#include <stdio.h>
+#include <string.h>
+#include "em_device.h"
+#include "em_chip.h"
+#include "em_cmu.h"
+#include "em_emu.h"
+#include "em_gpio.h"
+#include "bsp.h"
+#include "retargetserial.h"
+#include "mx25flash_spi.h"
+
+// Flash area read by each test and size of each read call
+#define READ_ADDRESS    0x00000
+#define READ_TOTAL      (16 * 1024)
+#define READ_CHUNK      4096
+
+typedef ReturnMsg (*ReadFunction)(uint32_t, uint8_t *, uint32_t);
+
+// Reference data read with the plain READ command
+static uint8_t refBuffer[READ_CHUNK];
+static uint8_t readBuffer[READ_CHUNK];
+
+/**************************************************************************//**
+ * @brief  Enable the DWT cycle counter used for the measurements
+ *****************************************************************************/
+void initCycleCounter(void)
+{
+  CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+  DWT->CYCCNT = 0;
+  DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+}
+
+/**************************************************************************//**
+ * @brief  Read READ_TOTAL bytes with one read command, check the data
+ *         against the READ command and print the throughput
+ *****************************************************************************/
+void measure(const char *name, ReadFunction read)
+{
+  uint32_t addr;
+  uint32_t cycles = 0;
+  uint32_t start;
+  bool match = true;
+
+  for (addr = READ_ADDRESS; addr < READ_ADDRESS + READ_TOTAL; addr += READ_CHUNK) {
+    MX25_READ(addr, refBuffer, READ_CHUNK);
+
+    start = DWT->CYCCNT;
+    read(addr, readBuffer, READ_CHUNK);
+    cycles += DWT->CYCCNT - start;
+
+    if (memcmp(refBuffer, readBuffer, READ_CHUNK) != 0) {
+      match = false;
+    }
+  }
+
+  // bytes/s = bytes * f / cycles, printed in kB/s
+  printf("%-10s %8lu cycles %6lu kB/s %s\n", name, cycles,
+         (uint32_t)(((uint64_t)READ_TOTAL * CMU_ClockFreqGet(cmuClock_SYSCLK))
+                    / cycles / 1000),
+         match ? "OK" : "DATA MISMATCH");
+}
+
+/**************************************************************************//**
+ * @brief  Main function
+ *****************************************************************************/
+int main(void)
+{
+  CHIP_Init();
+
+  // Retarget to USART1 so that USART0 stays with the flash
+  RETARGET_SerialInit();
+  RETARGET_SerialCrLf(1);
+
+  initCycleCounter();
+  GPIO_PinModeSet(BSP_GPIO_LED0_PORT, BSP_GPIO_LED0_PIN, gpioModePushPull, 0);
+
+  MX25_init();
+
+  printf("\nMX25 read throughput, %d bytes per command\n", READ_CHUNK);
+  measure("READ",      MX25_READ);
+  measure("FASTREAD",  MX25_FASTREAD);
+  measure("DREAD",     MX25_DREAD);
+  measure("2READ",     MX25_2READ);
+
+  // Done
+  GPIO_PinOutSet(BSP_GPIO_LED0_PORT, BSP_GPIO_LED0_PIN);
+  while (1) {
+    EMU_EnterEM1();
+  }
+}
@@ -2,9 +2,9 @@
  * @file main_s2.c
  *
  * @brief This project demonstrates DMA-driven use of the USART in synchronous
- * (SPI) secondary mode.  The main loop starts the LDMA channels, which transmit
- * the specified number of bytes and receive the byte that is shifted in with
- * each outgoing one.
+ * (SPI) secondary mode.  A looped LDMA descriptor keeps receiving into a ring
+ * buffer, and the chip select rising edge marks where each variable-length
+ * frame ends.
  *
  * The pins used in this example are defined below and are described in the
  * accompanying readme.txt file.
@@ -43,6 +43,7 @@
 #include "em_device.h"
 #include "em_chip.h"
 #include "em_cmu.h"
+#include "em_core.h"
 #include "em_emu.h"
 #include "em_gpio.h"
 #include "em_ldma.h"
@@ -58,29 +59,57 @@
 #define US0CS_PORT    gpioPortC
 #define US0CS_PIN     3
 
-// LDMA channel for receive and transmit servicing
+// LDMA channel for receive servicing
 #define RX_LDMA_CHANNEL 0
-#define TX_LDMA_CHANNEL 1
 
-// LDMA descriptor and transfer configuration structures for USART TX channel
-LDMA_Descriptor_t ldmaTXDescriptor;
-LDMA_TransferCfg_t ldmaTXConfig;
+// Size of the receive ring, at most 2048 bytes (one LDMA descriptor).
+// Frames longer than this cannot be told apart from lost data.
+#define RING_SIZE       1024
+
+// Number of frame boundaries that can wait for the main loop
+#define FRAME_QUEUE_LEN 16
+
+#if (RING_SIZE > 2048)
+#error "RING_SIZE must fit in a single LDMA descriptor"
+#endif
 
 // LDMA descriptor and transfer configuration structures for USART RX channel
 LDMA_Descriptor_t ldmaRXDescriptor;
 LDMA_TransferCfg_t ldmaRXConfig;
 
-// Size of the data buffers
-#define BUFLEN  10
-
-// Outgoing data
-uint8_t outbuf[BUFLEN];
-
-// Incoming data
-uint8_t inbuf[BUFLEN];
-
-// Data reception complete
-bool rx_done;
+// Receive ring, written by the LDMA without ever stopping
+uint8_t ring[RING_SIZE];
+
+// Number of times the LDMA has wrapped around the ring
+static volatile uint32_t ringWraps;
+
+/*
+ * Frame boundaries are byte counts since reset: the ring position of the
+ * frame end plus the wraps so far.  Each frame starts where the previous one
+ * ended.
+ */
+typedef struct {
+  uint32_t start;
+  uint32_t end;
+} Frame_t;
+
+static Frame_t frameQueue[FRAME_QUEUE_LEN];
+static volatile uint32_t frameHead;
+static volatile uint32_t frameTail;
+static uint32_t lastBoundary;
+
+// Most recent frame, copied out of the ring by the main loop
+#define FRAME_MAX       256
+uint8_t inbuf[FRAME_MAX];
+volatile uint32_t inbufLength;
+
+// Frame statistics
+// Note: These are only volatile to ensure that they don't get optimized out
+// by the compiler before the user checks their value.
+volatile uint32_t frameCount;
+volatile uint32_t byteCount;
+volatile uint32_t overrunCount;       // Ring lapped before a frame was read
+volatile uint32_t boundaryDropCount;  // Frame queue full, frames merged
 
 /**************************************************************************//**
  * @brief
@@ -102,8 +131,8 @@ void initGPIO(void)
   // Configure CS pin as an input
   GPIO_PinModeSet(US0CS_PORT, US0CS_PIN, gpioModeInput, 0);
 
-  // Request an interrupt on a CS pin high-to-low transition.
-  GPIO_ExtIntConfig(US0CS_PORT, US0CS_PIN, US0CS_PIN, false, true, false);
+  // Request an interrupt on a CS pin low-to-high transition (frame end)
+  GPIO_ExtIntConfig(US0CS_PORT, US0CS_PIN, US0CS_PIN, true, false, true);
 
   // Enable NVIC GPIO interrupt
 #if (US0CS_PIN & 1)
@@ -128,7 +157,7 @@ void initUSART0(void)
 
   init.master = false;  // Operate as a secondary
   init.msbf = true;     // MSB first transmission for SPI compatibility
-  init.enable = usartDisable;  // Do not enable yet
+  init.enable = usartEnableRx; // Receive only
 
   // Route USART0 RX, TX, CLK, and CS to the specified pins.
   GPIO->USARTROUTE[0].TXROUTE = (US0MOSI_PORT << _GPIO_USART_TXROUTE_PORT_SHIFT)
@@ -146,7 +175,11 @@ void initUSART0(void)
                                 GPIO_USART_ROUTEEN_CLKPEN |
                                 GPIO_USART_ROUTEEN_CSPEN;
 
-  // Configure but do not enable USART0
+  /*
+   * The chip select input is routed to the USART, so it ignores the clock
+   * while CS is high and can stay enabled all the time.  Nothing is
+   * transmitted.
+   */
   USART_InitSync(USART0, &init);
 }
 
@@ -160,21 +193,53 @@ void initLDMA(void)
   LDMA_Init_t ldmaInit = LDMA_INIT_DEFAULT;
   LDMA_Init(&ldmaInit);
 
-  // Source is outbuf, destination is USART0_TXDATA, and length is BUFLEN
-  ldmaTXDescriptor = (LDMA_Descriptor_t)LDMA_DESCRIPTOR_SINGLE_M2P_BYTE(outbuf, &(USART0->TXDATA), BUFLEN);
-  ldmaTXDescriptor.xfer.blockSize = ldmaCtrlBlockSizeUnit2;    // Transfers 2 units per arbitration
-  ldmaTXDescriptor.xfer.ignoreSrec = 1;    // Ignores single requests
+  /*
+   * Source is USART0_RXDATA, destination is the ring.  The descriptor
+   * links to itself, so the channel reloads the ring start after the last
+   * byte and never stops.  Each wrap raises the done interrupt.  Bytes are
+   * moved one at a time so the last byte of an odd-length frame does not
+   * wait in the USART for a partner.
+   */
+  ldmaRXDescriptor = (LDMA_Descriptor_t)LDMA_DESCRIPTOR_LINKREL_P2M_BYTE(&(USART0->RXDATA), ring, RING_SIZE, 0);
+  ldmaRXDescriptor.xfer.doneIfs = 1;
 
-  // Transfer 2 bytes on free space in the USART buffer
-  ldmaTXConfig = (LDMA_TransferCfg_t)LDMA_TRANSFER_CFG_PERIPHERAL(ldmaPeripheralSignal_USART0_TXBL);
+  // Transfer a byte on receive data valid
+  ldmaRXConfig = (LDMA_TransferCfg_t)LDMA_TRANSFER_CFG_PERIPHERAL(ldmaPeripheralSignal_USART0_RXDATAV);
 
-  // Source is USART0_RXDATA, destination is inbuf, and length is BUFLEN
-  ldmaRXDescriptor = (LDMA_Descriptor_t)LDMA_DESCRIPTOR_SINGLE_P2M_BYTE(&(USART0->RXDATA), inbuf, BUFLEN);
-  ldmaRXDescriptor.xfer.blockSize = ldmaCtrlBlockSizeUnit2;    // Transfers 2 units per arbitration
-  ldmaRXDescriptor.xfer.ignoreSrec = 1;    // Ignores single requests
+  LDMA_StartTransfer(RX_LDMA_CHANNEL, &ldmaRXConfig, &ldmaRXDescriptor);
+}
 
-  // Transfer 2 bytes on receive data valid
-  ldmaRXConfig = (LDMA_TransferCfg_t)LDMA_TRANSFER_CFG_PERIPHERAL(ldmaPeripheralSignal_USART0_RXDATAV);
+/**************************************************************************//**
+ * @brief
+ *    Count a ring wrap if the LDMA has flagged one
+ *****************************************************************************/
+static void countWrap(void)
+{
+  if (LDMA_IntGet() & (1 << RX_LDMA_CHANNEL)){
+    LDMA_IntClear(1 << RX_LDMA_CHANNEL);
+    ringWraps++;
+  }
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Number of bytes written to the ring since reset. Called from
+ *    interrupt handlers of the same priority as the LDMA interrupt.
+ *****************************************************************************/
+static uint32_t ringPosition(void)
+{
+  uint32_t offset;
+
+  countWrap();
+  offset = LDMA->CH[RX_LDMA_CHANNEL].DST - (uint32_t)ring;
+
+  // A wrap between the two reads leaves DST at the ring end
+  countWrap();
+  if (offset >= RING_SIZE){
+    offset = LDMA->CH[RX_LDMA_CHANNEL].DST - (uint32_t)ring;
+  }
+
+  return (ringWraps * RING_SIZE) + (offset % RING_SIZE);
 }
 
 /**************************************************************************//**
@@ -184,19 +249,8 @@ void LDMA_IRQHandler()
 {
   uint32_t flags = LDMA_IntGet();
 
-  // Clear the transmit channel's done flag if set
-  if (flags & (1 << TX_LDMA_CHANNEL)){
-    LDMA_IntClear(1 << TX_LDMA_CHANNEL);
-  }
-
-  /*
-   * Clear the receive channel's done flag if set and change receive
-   * state to done.
-   */
-  if (flags & (1 << RX_LDMA_CHANNEL)){
-    LDMA_IntClear(1 << RX_LDMA_CHANNEL);
-    rx_done = true;
-  }
+  // Receive channel done means the ring wrapped
+  countWrap();
 
   // Stop in case there was an error
   if (flags & LDMA_IF_ERROR){
@@ -213,8 +267,63 @@ void GPIO_ODD_IRQHandler(void)
 void GPIO_EVEN_IRQHandler(void)
 #endif
 {
-  // Clear the falling edge interrupt flag
+  uint32_t end;
+  uint32_t next;
+
+  // Clear the rising edge interrupt flag
   GPIO_IntClear(1 << US0CS_PIN);
+
+  // The last byte of the frame may still be in the receive buffer
+  while (USART0->STATUS & USART_STATUS_RXDATAV);
+
+  end = ringPosition();
+
+  // CS glitch or a frame without clocks
+  if (end == lastBoundary){
+    return;
+  }
+
+  next = (frameHead + 1) % FRAME_QUEUE_LEN;
+  if (next == frameTail){
+    // No room, the next boundary covers this frame as well
+    boundaryDropCount++;
+    return;
+  }
+
+  frameQueue[frameHead].start = lastBoundary;
+  frameQueue[frameHead].end = end;
+  frameHead = next;
+  lastBoundary = end;
+}
+
+/**************************************************************************//**
+ * @brief
+ *    Copy a frame out of the ring
+ *
+ * @return
+ *    False if the LDMA has already overwritten part of the frame
+ *****************************************************************************/
+static bool readFrame(const Frame_t *frame)
+{
+  uint32_t length = frame->end - frame->start;
+  uint32_t i;
+  CORE_DECLARE_IRQ_STATE;
+
+  if (length > FRAME_MAX){
+    length = FRAME_MAX;
+  }
+
+  for (i = 0; i < length; i++){
+    inbuf[i] = ring[(frame->start + i) % RING_SIZE];
+  }
+  inbufLength = length;
+
+  // Anything written past a full ring from the frame start overlapped it
+  CORE_ENTER_CRITICAL();
+  i = ringPosition();
+  CORE_EXIT_CRITICAL();
+
+  return (i - frame->start) <= RING_SIZE;
 }
 
 /**************************************************************************//**
@@ -223,7 +332,7 @@ void GPIO_EVEN_IRQHandler(void)
  *****************************************************************************/
 int main(void)
 {
-  uint32_t i;
+  CORE_DECLARE_IRQ_STATE;
 
   // Chip errata
   CHIP_Init();
@@ -251,42 +360,31 @@ int main(void)
    */
   CMU_UpdateWaitStates(SystemCoreClockGet(), 0);
 
-  // Initialize GPIO, USART0, and LDMA
-  initGPIO();
+  // Initialize USART0, LDMA, and GPIO.  The ring is running before the
+  // chip select interrupt can record the first boundary.
   initUSART0();
   initLDMA();
+  initGPIO();
 
   while (1){
-    // Zero incoming buffer and populate outgoing data array
-    for (i = 0; i < BUFLEN; i++){
-      inbuf[i] = 0;
-      outbuf[i] = (uint8_t)i;
+    // Wait in EM1 until a frame has ended
+    CORE_ENTER_CRITICAL();
+    if (frameTail == frameHead){
+      EMU_EnterEM1();
     }
+    CORE_EXIT_CRITICAL();
 
-    // Set the receive state to not done
-    rx_done = false;
-
-    // Now enable the falling edge interrupt on the US0CS_PIN
-    GPIO_IntEnable(1 << US0CS_PIN);
+    while (frameTail != frameHead){
+      Frame_t *frame = &frameQueue[frameTail];
 
-    // Wait for falling edge on US0CS_PIN
-    EMU_EnterEM1();
+      if (readFrame(frame)){
+        frameCount++;
+        byteCount += frame->end - frame->start;
+      } else {
+        overrunCount++;
+      }
 
-    // Now enable the USART receiver and transmitter
-    USART_Enable(USART0, usartEnable);
-
-    // Start both channels
-    LDMA_StartTransfer(RX_LDMA_CHANNEL, &ldmaRXConfig, &ldmaRXDescriptor);
-    LDMA_StartTransfer(TX_LDMA_CHANNEL, &ldmaTXConfig, &ldmaTXDescriptor);
-
-    // Wait in EM1 until all data is received
-    while (!rx_done){
-      EMU_EnterEM1();
+      frameTail = (frameTail + 1) % FRAME_QUEUE_LEN;
     }
-    // Disable the falling edge interrupt on the US0CS_PIN
-    GPIO_IntDisable(1 << US0CS_PIN);
-
-    // Disable USART receiver and transmitter until next chip select
-    USART_Enable(USART0, usartDisable);
   }
 }
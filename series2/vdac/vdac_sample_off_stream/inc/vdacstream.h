@@ -0,0 +1,92 @@
+/***************************************************************************//**
+ * @file vdacstream.h
+ *
+ * @brief VDAC output streamed from an LDMA ring, paced by LETIMER0.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2021 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ******************************************************************************/
+
+#ifndef VDACSTREAM_H
+#define VDACSTREAM_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "em_vdac.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// LDMA channel that writes the samples to the VDAC channel FIFO
+#define VSTREAM_LDMA_CHANNEL  0
+
+// PRS channel from the LETIMER0 underflow pulse to the LDMA request
+#define VSTREAM_PRS_CHANNEL   0
+
+// VDAC channel streamed to, 0 or 1
+#define VSTREAM_VDAC_CHANNEL  0
+
+// The VDAC, like LETIMER0, runs off the 32.768 kHz EM23GRPACLK so that
+// the stream keeps going in EM2 and EM3
+#define VSTREAM_VDAC_CLOCK    32768
+
+// Largest ring, two descriptors of at most 2048 words each
+#define VSTREAM_MAX_RING      4096
+
+typedef enum {
+  vstreamContinuous,           // The VDAC drives the output all the time
+  vstreamSampleOff             // The VDAC drives the output after each
+                               // sample and refresh, and is off in between
+} VSTREAM_Mode_t;
+
+typedef struct {
+  VSTREAM_Mode_t mode;
+  uint32_t rate;               // Samples per second, at most 16384
+  uint32_t holdTime;           // Sample-off: VDAC clocks the output is
+                               // driven after each conversion, 0 to 1023
+  bool refresh;                // Sample-off: convert the last sample again
+                               // each refreshPeriod between samples
+  VDAC_Refresh_TypeDef refreshPeriod;
+} VSTREAM_Config_t;
+
+// Called from the LDMA interrupt with each half of the ring that has just
+// been played, to be refilled while the other half plays.
+typedef void (*VSTREAM_Callback_t)(uint32_t *block, uint32_t count);
+
+bool VSTREAM_Start(const VSTREAM_Config_t *config,
+                   uint32_t *ring,
+                   uint32_t size,
+                   VSTREAM_Callback_t callback);
+void VSTREAM_Stop(void);
+uint32_t VSTREAM_GetSampleRate(void);
+uint32_t VSTREAM_GetPosition(void);
+uint32_t VSTREAM_GetUnderrunCount(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // VDACSTREAM_H
@@ -0,0 +1,476 @@
+/***************************************************************************//**
+ * @file main_vdac_sample_off_stream.c
+ * @brief This project streams a waveform to the VDAC with the LDMA in
+ * continuous and in sample/off mode and compares their current draw and
+ * output fidelity at several update rates. See readme.txt for details.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2021 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ *******************************************************************************
+ * # Evaluation Quality
+ * This code has been minimally tested to ensure that it builds and is suitable 
+ * as a demonstration for evaluation purposes only. This code will be maintained
+ * at the sole discretion of Silicon Labs.
+ ******************************************************************************/
+
+#include <math.h>
+#include "em_device.h"
+#include "em_burtc.h"
+#include "em_chip.h"
+#include "em_cmu.h"
+#include "em_core.h"
+#include "em_emu.h"
+#include "em_gpio.h"
+#include "em_iadc.h"
+#include "mx25flash_spi.h"
+
+#include "vdacstream.h"
+
+/*******************************************************************************
+ *******************************   DEFINES   ***********************************
+ ******************************************************************************/
+
+// One period of the waveform, the output frequency is the update rate / 256
+#define RING_SIZE                 256
+
+// Sine wave of 0.5 V +/- 0.25 V, VDAC internal 1.25 V reference
+#define OUTPUT_MID                0.5f
+#define OUTPUT_AMPLITUDE          0.25f
+#define VDAC_VREF                 1.25f
+
+// Sample/off mode: drive the output for 10 VDAC clocks (305 us) after each
+// sample and convert the last sample again every 32 clocks (977 us), as in
+// the vdac_sample_off example
+#define HOLD_TIME                 10
+#define REFRESH_PERIOD            vdacRefresh32
+
+// Set CLK_ADC to 10 MHz, CLK_SRC_ADC from the FSRCO so the IADC runs in EM2
+#define CLK_SRC_ADC_FREQ          20000000  // CLK_SRC_ADC
+#define CLK_ADC_FREQ              10000000  // CLK_ADC - 10 MHz max in normal mode
+
+// The IADC measures the VDAC output on PB00, the VDAC0 CH0 main output
+#define IADC_INPUT_PORT_PIN       iadcPosInputPortBPin0
+#define IADC_INPUT_BUS            BBUSALLOC
+#define IADC_INPUT_BUSALLOC       GPIO_BBUSALLOC_BEVEN0_ADC0
+
+// IADC full scale, internal 1.21 V reference with a gain of 0.5
+#define IADC_FULL_SCALE           2.42f
+
+/*
+ * Output measurements per second in the fidelity phase. The rate is not
+ * related to the update rates, so the measurements fall at every point
+ * between two samples in turn, right after a sample as well as after the
+ * output has been left floating the longest.
+ */
+#define FIDELITY_RATE             997
+
+// Length of the fidelity and the energy phase in seconds
+#define FIDELITY_SECONDS          4
+#define ENERGY_SECONDS            10
+
+// The first measurements include the IADC warmup and the output settling
+// from 0 V and are left out of the statistics
+#define FIDELITY_SKIP             16
+
+// BURTC ticks of the energy phase, LFRCO via EM4GRPACLK
+#define ENERGY_TICKS              (ENERGY_SECONDS * 32768)
+
+// GPIO output, high while a configuration runs its energy phase
+#define GPIO_OUTPUT_0_PORT        gpioPortC
+#define GPIO_OUTPUT_0_PIN         5
+
+/* This example enters EM2 in both phases; Setting this define to 1
+ * enables debug connectivity in the EMU_CTRL register, which will consume about
+ * 0.5uA additional supply current */
+#define EM2DEBUG                  1
+
+/*******************************************************************************
+ ***************************   GLOBAL VARIABLES   *******************************
+ ******************************************************************************/
+
+// Measurements of one output mode at one update rate
+typedef struct {
+  VSTREAM_Mode_t mode;
+  uint32_t rate;            // Requested updates per second
+  uint32_t sampleRate;      // Updates per second actually played
+  uint32_t measurements;    // Output measurements in the statistics
+  double errorMean;         // Mean of output - ideal, mV
+  double errorRms;          // RMS of output - ideal, mV
+  double errorPeak;         // Largest |output - ideal|, mV
+  double current;           // Average uA over the energy phase, entered
+                            // from the Energy Profiler
+  double currentSaving;     // Sample/off only: % less than continuous at
+                            // the same rate
+} StreamResult_t;
+
+#define NUM_RUNS                  8
+
+static volatile StreamResult_t results[NUM_RUNS] = {
+  { .mode = vstreamContinuous, .rate = 64 },
+  { .mode = vstreamSampleOff,  .rate = 64 },
+  { .mode = vstreamContinuous, .rate = 256 },
+  { .mode = vstreamSampleOff,  .rate = 256 },
+  { .mode = vstreamContinuous, .rate = 1024 },
+  { .mode = vstreamSampleOff,  .rate = 1024 },
+  { .mode = vstreamContinuous, .rate = 4096 },
+  { .mode = vstreamSampleOff,  .rate = 4096 },
+};
+
+// Completed passes over all configurations
+static volatile uint32_t passes;
+
+// VDAC codes of one waveform period
+static uint32_t ring[RING_SIZE];
+
+// Fidelity phase sums, updated in the IADC interrupt
+static volatile uint32_t conversions;
+static volatile double errorSum;
+static volatile double errorSquares;
+static volatile double errorPeak;
+
+static volatile bool energyDone;
+
+/**************************************************************************//**
+ * @brief
+ *   Compare each output measurement with the sample being played
+ *****************************************************************************/
+void IADC_IRQHandler(void)
+{
+  IADC_Result_t sample = IADC_pullSingleFifoResult(IADC0);
+  uint32_t position = VSTREAM_GetPosition();
+  double error;
+
+  IADC_clearInt(IADC0, IADC_IF_SINGLEDONE);
+
+  conversions++;
+  if (conversions <= FIDELITY_SKIP) {
+    return;
+  }
+
+  error = 1000.0 * (((sample.data * IADC_FULL_SCALE) / 4095)
+                    - ((ring[position] * VDAC_VREF) / 4095));
+
+  errorSum += error;
+  errorSquares += error * error;
+  if (fabs(error) > errorPeak) {
+    errorPeak = fabs(error);
+  }
+}
+
+/**************************************************************************//**
+ * @brief  End of the energy phase
+ *****************************************************************************/
+void BURTC_IRQHandler(void)
+{
+  BURTC_IntClear(BURTC_IF_COMP);
+  BURTC_Enable(false);
+  energyDone = true;
+}
+
+/***************************************************************************//**
+ * @brief
+ *    Powers down the SPI flash on the radio board
+ *
+ * @details
+ *    A JEDEC standard SPI flash boots up in standby mode in order to
+ *    provide immediate access, such as when used it as a boot memory.
+ *
+ *    Typical current draw in standby mode for the MX25R8035F device used
+ *    on EFR32 radio boards is 5 µA.
+ *
+ *    JEDEC standard SPI flash memories have a lower current deep power-down
+ *    mode, which can be entered after sending the relevant commands. This is on
+ *    the order of 0.007 µA for the MX25R8035F.
+ ******************************************************************************/
+void powerDownSpiFlash(void)
+{
+  FlashStatus status;
+
+  MX25_init();
+  MX25_RSTEN();
+  MX25_RST(&status);
+  MX25_DP();
+  MX25_deinit();
+}
+
+/**************************************************************************//**
+ * @brief  GPIO initialization
+ *****************************************************************************/
+void initGPIO(void)
+{
+  CMU_ClockEnable(cmuClock_GPIO, true);
+
+  // Output set during each energy phase, to find them in the Energy Profiler
+  GPIO_PinModeSet(GPIO_OUTPUT_0_PORT, GPIO_OUTPUT_0_PIN, gpioModePushPull, 0);
+}
+
+/**************************************************************************//**
+ * @brief  BURTC initialization, times the energy phases
+ *****************************************************************************/
+void initBURTC(void)
+{
+  BURTC_Init_TypeDef burtcInit = BURTC_INIT_DEFAULT;
+
+  CMU_ClockSelectSet(cmuClock_EM4GRPACLK, cmuSelect_LFRCO);
+  CMU_ClockEnable(cmuClock_BURTC, true);
+
+  burtcInit.start = false;
+  burtcInit.compare0Top = true;
+  BURTC_Init(&burtcInit);
+  BURTC_CompareSet(0, ENERGY_TICKS - 1);
+
+  BURTC_IntEnable(BURTC_IEN_COMP);
+  NVIC_ClearPendingIRQ(BURTC_IRQn);
+  NVIC_EnableIRQ(BURTC_IRQn);
+}
+
+/**************************************************************************//**
+ * @brief  IADC initialization, single conversions of the VDAC output
+ *         started by the IADC local timer
+ *****************************************************************************/
+void initIADC(void)
+{
+  IADC_Init_t init = IADC_INIT_DEFAULT;
+  IADC_AllConfigs_t initAllConfigs = IADC_ALLCONFIGS_DEFAULT;
+  IADC_InitSingle_t initSingle = IADC_INITSINGLE_DEFAULT;
+  IADC_SingleInput_t initSingleInput = IADC_SINGLEINPUT_DEFAULT;
+
+  CMU_ClockEnable(cmuClock_IADC0, true);
+
+  // Start from the reset configuration, the IADC is off between phases
+  IADC_reset(IADC0);
+
+  // Configure IADC clock source for use while in EM2
+  CMU_ClockSelectSet(cmuClock_IADCCLK, cmuSelect_FSRCO);  // FSRCO - 20MHz
+
+  // Shutdown between conversions to reduce current
+  init.warmup = iadcWarmupNormal;
+
+  // Set the HFSCLK prescale value here
+  init.srcClkPrescale = IADC_calcSrcClkPrescale(IADC0, CLK_SRC_ADC_FREQ, 0);
+
+  // The IADC local timer counts CLK_SRC_ADC cycles
+  init.timerCycles = CMU_ClockFreqGet(cmuClock_IADCCLK) / FIDELITY_RATE;
+
+  // Internal 1.21 V bandgap reference and a gain of 0.5, 12 bit results
+  initAllConfigs.configs[0].reference = iadcCfgReferenceInt1V2;
+  initAllConfigs.configs[0].vRef = 1210;
+  initAllConfigs.configs[0].osrHighSpeed = iadcCfgOsrHighSpeed2x;
+  initAllConfigs.configs[0].analogGain = iadcCfgAnalogGain0P5x;
+
+  // Divides CLK_SRC_ADC to set the CLK_ADC frequency
+  initAllConfigs.configs[0].adcClkPrescale = IADC_calcAdcClkPrescale(IADC0,
+                                                                     CLK_ADC_FREQ,
+                                                                     0,
+                                                                     iadcCfgModeNormal,
+                                                                     init.srcClkPrescale);
+
+  // One conversion per local timer period
+  initSingle.triggerSelect = iadcTriggerSelTimer;
+  initSingle.dataValidLevel = iadcFifoCfgDvl1;
+
+  initSingleInput.posInput = IADC_INPUT_PORT_PIN;
+  initSingleInput.negInput = iadcNegInputGnd;
+
+  IADC_init(IADC0, &init, &initAllConfigs);
+  IADC_initSingle(IADC0, &initSingle, &initSingleInput);
+
+  // Allocate the analog bus for ADC0 inputs
+  GPIO->IADC_INPUT_BUS |= IADC_INPUT_BUSALLOC;
+
+  IADC_clearInt(IADC0, _IADC_IF_MASK);
+  IADC_enableInt(IADC0, IADC_IEN_SINGLEDONE);
+  NVIC_ClearPendingIRQ(IADC_IRQn);
+  NVIC_EnableIRQ(IADC_IRQn);
+}
+
+/**************************************************************************//**
+ * @brief  Fill the ring with one period of the sine wave
+ *****************************************************************************/
+void initRing(void)
+{
+  const float pi = 3.14159265f;
+  float v;
+
+  for (uint32_t i = 0; i < RING_SIZE; i++) {
+    v = OUTPUT_MID + (OUTPUT_AMPLITUDE * sinf((2 * pi * i) / RING_SIZE));
+    ring[i] = (uint32_t)(((v * 4095) / VDAC_VREF) + 0.5f);
+  }
+}
+
+/**************************************************************************//**
+ * @brief  Start streaming the ring in the mode and at the rate of a run
+ *****************************************************************************/
+void startStream(uint32_t run)
+{
+  VSTREAM_Config_t config;
+
+  config.mode = results[run].mode;
+  config.rate = results[run].rate;
+  config.holdTime = HOLD_TIME;
+  config.refresh = true;
+  config.refreshPeriod = REFRESH_PERIOD;
+
+  // The ring plays in a loop, no callback
+  VSTREAM_Start(&config, ring, RING_SIZE, NULL);
+  results[run].sampleRate = VSTREAM_GetSampleRate();
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Measure the output FIDELITY_RATE times per second for
+ *   FIDELITY_SECONDS and compare it with the ideal waveform
+ *
+ * @details
+ *   The error includes the VDAC and IADC offset and gain errors, which are
+ *   the same in both modes. What sample/off mode adds is the droop of the
+ *   floating output between refreshes and the settling after each one.
+ *****************************************************************************/
+void measureFidelity(uint32_t run)
+{
+  const uint32_t total = FIDELITY_SKIP + (FIDELITY_SECONDS * FIDELITY_RATE);
+  uint32_t n;
+
+  conversions = 0;
+  errorSum = 0;
+  errorSquares = 0;
+  errorPeak = 0;
+
+  startStream(run);
+  initIADC();
+  IADC_command(IADC0, iadcCmdStartSingle);
+  IADC_command(IADC0, iadcCmdEnableTimer);
+
+  while (conversions < total) {
+    CORE_DECLARE_IRQ_STATE;
+
+    CORE_ENTER_CRITICAL();
+    if (conversions < total) {
+      EMU_EnterEM2(true);
+    }
+    CORE_EXIT_CRITICAL();
+  }
+
+  IADC_command(IADC0, iadcCmdDisableTimer);
+  IADC_command(IADC0, iadcCmdStopSingle);
+  NVIC_DisableIRQ(IADC_IRQn);
+  IADC_reset(IADC0);
+  VSTREAM_Stop();
+
+  n = conversions - FIDELITY_SKIP;
+  results[run].measurements = n;
+  results[run].errorMean = errorSum / n;
+  results[run].errorRms = sqrt(errorSquares / n);
+  results[run].errorPeak = errorPeak;
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Stream for ENERGY_SECONDS with nothing else running, for the Energy
+ *   Profiler to measure the average current
+ *
+ * @details
+ *   The IADC is off and the CPU sleeps in EM2 without waking up until the
+ *   BURTC ends the phase, so the current is that of the stream alone:
+ *   VDAC, LETIMER0, PRS and the LDMA waking up for each sample.
+ *****************************************************************************/
+void measureEnergy(uint32_t run)
+{
+  energyDone = false;
+
+  startStream(run);
+
+  GPIO_PinOutSet(GPIO_OUTPUT_0_PORT, GPIO_OUTPUT_0_PIN);
+  BURTC_CounterReset();
+  BURTC_Enable(true);
+
+  while (!energyDone) {
+    CORE_DECLARE_IRQ_STATE;
+
+    CORE_ENTER_CRITICAL();
+    if (!energyDone) {
+      EMU_EnterEM2(true);
+    }
+    CORE_EXIT_CRITICAL();
+  }
+
+  GPIO_PinOutClear(GPIO_OUTPUT_0_PORT, GPIO_OUTPUT_0_PIN);
+  VSTREAM_Stop();
+}
+
+/**************************************************************************//**
+ * @brief  Main function
+ *****************************************************************************/
+int main(void)
+{
+  EMU_DCDCInit_TypeDef dcdcInit = EMU_DCDCINIT_DEFAULT;
+  EMU_EM23Init_TypeDef em23Init = EMU_EM23INIT_DEFAULT;
+  uint32_t run;
+
+  // Chip errata
+  CHIP_Init();
+
+  // Enable DC-DC converter
+  EMU_DCDCInit(&dcdcInit);
+
+  // Enable voltage downscaling in energy modes EM2 and EM3
+  em23Init.vScaleEM23Voltage = emuVScaleEM23_LowPower;
+  EMU_EM23Init(&em23Init);
+
+  // Power down the SPI flash
+  powerDownSpiFlash();
+
+  initGPIO();
+
+  initBURTC();
+
+  initRing();
+
+#ifdef EM2DEBUG
+#if (EM2DEBUG == 1)
+  // Enable debug connectivity in EM2
+  EMU->CTRL_SET = EMU_CTRL_EM2DBGEN;
+#endif
+#endif
+
+  // Infinite loop
+  while (1)
+  {
+    for (run = 0; run < NUM_RUNS; run++) {
+      measureFidelity(run);
+      measureEnergy(run);
+    }
+
+    // Sample/off entries directly follow continuous at the same rate
+    for (run = 1; run < NUM_RUNS; run += 2) {
+      if ((results[run].current > 0) && (results[run - 1].current > 0)) {
+        results[run].currentSaving = 100 * (1 - (results[run].current
+                                                 / results[run - 1].current));
+      }
+    }
+
+    passes++;
+  }
+}
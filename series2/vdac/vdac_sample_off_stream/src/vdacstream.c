@@ -0,0 +1,280 @@
+/***************************************************************************//**
+ * @file vdacstream.c
+ * @brief VDAC output streamed from an LDMA ring, paced by LETIMER0.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2021 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ *******************************************************************************
+ * # Evaluation Quality
+ * This code has been minimally tested to ensure that it builds and is suitable 
+ * as a demonstration for evaluation purposes only. This code will be maintained
+ * at the sole discretion of Silicon Labs.
+ ******************************************************************************/
+
+#include <stddef.h>
+
+#include "em_device.h"
+#include "em_cmu.h"
+#include "em_ldma.h"
+#include "em_letimer.h"
+#include "em_prs.h"
+#include "em_vdac.h"
+
+#include "vdacstream.h"
+
+// The LETIMER pulse reaches the LDMA through the PRS request 0 input
+#define SAMPLE_SIGNAL       (LDMAXBAR_CH_REQSEL_SIGSEL_LDMAXBARPRSREQ0 \
+                             | LDMAXBAR_CH_REQSEL_SOURCESEL_LDMAXBAR)
+
+#if (VSTREAM_VDAC_CHANNEL == 0)
+#define CHANNEL_FIFO        (&(VDAC0->CH0F))
+#else
+#define CHANNEL_FIFO        (&(VDAC0->CH1F))
+#endif
+
+#define HALF_DONE           (1 << VSTREAM_LDMA_CHANNEL)
+
+// Ring halves, descriptor 0 plays the first and links to descriptor 1
+static LDMA_Descriptor_t descriptors[2];
+
+static uint32_t *ringStart;
+static uint32_t ringSize;
+static VSTREAM_Callback_t refillCallback;
+static uint32_t sampleRate;
+
+// Half handed to the callback last, so a missed interrupt can be noticed
+static uint32_t lastHalf;
+static volatile uint32_t underrunCount;
+
+/**************************************************************************//**
+ * @brief  LDMA Handler
+ *****************************************************************************/
+void LDMA_IRQHandler(void)
+{
+  uint32_t pending = LDMA_IntGetEnabled();
+  uint32_t half;
+
+  // Loop here to enable the debugger to see what has happened
+  if (pending & LDMA_IF_ERROR) {
+    __BKPT(0);
+  }
+
+  LDMA_IntClear(HALF_DONE);
+
+  /*
+   * The LDMA has already loaded the next descriptor, so the half it is
+   * reading now tells which one has been played. If it is the same as
+   * last time, the half now playing was never refilled and repeats.
+   */
+  if (LDMA->CH[VSTREAM_LDMA_CHANNEL].SRC < (uint32_t)(ringStart + (ringSize / 2))) {
+    half = 1;
+  } else {
+    half = 0;
+  }
+
+  if (half == lastHalf) {
+    underrunCount++;
+  }
+  lastHalf = half;
+
+  refillCallback(ringStart + (half * (ringSize / 2)), ringSize / 2);
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Set up the VDAC channel for streaming
+ *
+ * @details
+ *   The software trigger mode starts a conversion on each write to the
+ *   channel FIFO, so the LDMA write is the conversion trigger and no
+ *   other trigger is needed. In sample-off mode the VDAC drives the
+ *   output for holdTime clocks after each conversion and then lets it
+ *   float, held only by the load capacitance. The refresh timer can
+ *   convert the last sample again in between to top the output up.
+ *****************************************************************************/
+static void initVdac(const VSTREAM_Config_t *config)
+{
+  VDAC_Init_TypeDef init = VDAC_INIT_DEFAULT;
+  VDAC_InitChannel_TypeDef initChannel = VDAC_INITCHANNEL_DEFAULT;
+  bool sampleOff = (config->mode == vstreamSampleOff);
+
+  CMU_ClockSelectSet(cmuClock_VDAC0, cmuSelect_EM23GRPACLK);
+  CMU_ClockEnable(cmuClock_VDAC0, true);
+
+  init.prescaler = VDAC_PrescaleCalc(VDAC0, VSTREAM_VDAC_CLOCK);
+  init.reference = vdacRef1V25;
+
+  // EM23GRPACLK can not be on demand, setting this turns on demand off
+  init.onDemandClk = true;
+  init.refresh = config->refreshPeriod;
+
+  initChannel.powerMode = vdacPowerModeLowPower;
+  initChannel.sampleOffMode = sampleOff;
+  initChannel.holdOutTime = sampleOff ? config->holdTime : 0;
+  initChannel.trigMode = vdacTrigModeSw;
+  if (sampleOff && config->refresh) {
+    initChannel.chRefreshSource = vdacRefreshSrcRefreshTimer;
+  } else {
+    initChannel.chRefreshSource = vdacRefreshSrcNone;
+  }
+  initChannel.highCapLoadEnable = false;
+
+  VDAC_Init(VDAC0, &init);
+  VDAC_InitChannel(VDAC0, &initChannel, VSTREAM_VDAC_CHANNEL);
+  VDAC_Enable(VDAC0, VSTREAM_VDAC_CHANNEL, true);
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Start streaming the ring to the VDAC
+ *
+ * @details
+ *   LETIMER0 pulses config->rate times per second on VSTREAM_PRS_CHANNEL
+ *   and the LDMA writes the next sample to the VDAC channel FIFO on each
+ *   pulse, also in EM2. Without a callback the ring plays in a loop and
+ *   the CPU is never woken up. With one, the CPU wakes once per half of
+ *   the ring to refill the half just played.
+ *
+ *   The ring holds right aligned 12 bit VDAC codes, one per word.
+ *
+ * @param[in] config
+ *   Output mode and sample rate.
+ *
+ * @param[in] ring
+ *   Ring buffer, word aligned.
+ *
+ * @param[in] size
+ *   Ring size in samples, even, at least 2 and at most VSTREAM_MAX_RING.
+ *
+ * @param[in] callback
+ *   Called from the LDMA interrupt with each half played, may be NULL.
+ *
+ * @return
+ *   false if size or the sample rate are out of range.
+ *****************************************************************************/
+bool VSTREAM_Start(const VSTREAM_Config_t *config,
+                   uint32_t *ring,
+                   uint32_t size,
+                   VSTREAM_Callback_t callback)
+{
+  LDMA_Init_t init = LDMA_INIT_DEFAULT;
+  LDMA_TransferCfg_t transferCfg = LDMA_TRANSFER_CFG_PERIPHERAL(SAMPLE_SIGNAL);
+  LETIMER_Init_TypeDef letimerInit = LETIMER_INIT_DEFAULT;
+  uint32_t ticks;
+
+  if ((size < 2) || (size % 2) || (size > VSTREAM_MAX_RING)
+      || (config->rate == 0)) {
+    return false;
+  }
+
+  CMU_ClockEnable(cmuClock_LETIMER0, true);
+  ticks = CMU_ClockFreqGet(cmuClock_LETIMER0) / config->rate;
+  if (ticks < 2) {
+    return false;
+  }
+
+  ringStart = ring;
+  ringSize = size;
+  refillCallback = callback;
+  sampleRate = CMU_ClockFreqGet(cmuClock_LETIMER0) / ticks;
+  lastHalf = 1;
+  underrunCount = 0;
+
+  initVdac(config);
+
+  LDMA_Init(&init);
+
+  descriptors[0] = (LDMA_Descriptor_t)
+    LDMA_DESCRIPTOR_LINKREL_M2P_BYTE(ring, CHANNEL_FIFO, size / 2, 1);
+  descriptors[1] = (LDMA_Descriptor_t)
+    LDMA_DESCRIPTOR_LINKREL_M2P_BYTE(ring + (size / 2), CHANNEL_FIFO, size / 2, -1);
+  descriptors[0].xfer.size = ldmaCtrlSizeWord;
+  descriptors[1].xfer.size = ldmaCtrlSizeWord;
+  descriptors[0].xfer.doneIfs = (callback != NULL);
+  descriptors[1].xfer.doneIfs = (callback != NULL);
+
+  LDMA_StartTransfer(VSTREAM_LDMA_CHANNEL, &transferCfg, &descriptors[0]);
+
+  // The LETIMER output pulse is the sample request; no pin is needed
+  CMU_ClockEnable(cmuClock_PRS, true);
+  PRS_SourceAsyncSignalSet(VSTREAM_PRS_CHANNEL,
+                           PRS_ASYNC_CH_CTRL_SOURCESEL_LETIMER0,
+                           PRS_LETIMER0_CH0);
+  PRS_ConnectConsumer(VSTREAM_PRS_CHANNEL, prsTypeAsync, prsConsumerLDMA_REQUEST0);
+
+  letimerInit.comp0Top = true;
+  letimerInit.topValue = ticks - 1;
+  letimerInit.ufoa0 = letimerUFOAPulse;
+  letimerInit.repMode = letimerRepeatFree;
+  LETIMER_Init(LETIMER0, &letimerInit);
+
+  return true;
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Stop streaming and disable the VDAC channel
+ *****************************************************************************/
+void VSTREAM_Stop(void)
+{
+  LETIMER_Enable(LETIMER0, false);
+  LDMA_StopTransfer(VSTREAM_LDMA_CHANNEL);
+  VDAC_Enable(VDAC0, VSTREAM_VDAC_CHANNEL, false);
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Samples per second actually played, the LETIMER clock divided by a
+ *   whole number of ticks
+ *****************************************************************************/
+uint32_t VSTREAM_GetSampleRate(void)
+{
+  return sampleRate;
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Ring index of the sample written to the VDAC last
+ *
+ * @details
+ *   Read from the LDMA source address, which points at the next sample.
+ *   A sample written at the same time may or may not be counted yet.
+ *****************************************************************************/
+uint32_t VSTREAM_GetPosition(void)
+{
+  uint32_t next = (LDMA->CH[VSTREAM_LDMA_CHANNEL].SRC - (uint32_t)ringStart)
+                  / sizeof(uint32_t);
+
+  return (next + ringSize - 1) % ringSize;
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Number of halves played again because the callback came too late
+ *****************************************************************************/
+uint32_t VSTREAM_GetUnderrunCount(void)
+{
+  return underrunCount;
+}
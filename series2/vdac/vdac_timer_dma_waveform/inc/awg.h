@@ -0,0 +1,64 @@
+/***************************************************************************//**
+ * @file awg.h
+ *
+ * @brief Arbitrary waveform generator streaming VDAC tables with the LDMA.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2021 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ******************************************************************************/
+
+#ifndef AWG_H
+#define AWG_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// LDMA channels writing VDAC0 CH0 and CH1
+#define AWG_LDMA_CHANNEL0     0
+#define AWG_LDMA_CHANNEL1     1
+
+// Tables held at the same time and the samples each can take
+#define AWG_TABLES            4
+#define AWG_MAX_SAMPLES       1024
+
+// Highest sample rate, each sample is one TIMER0 period
+#define AWG_MAX_SAMPLE_RATE   500000
+
+bool AWG_Init(uint32_t channels);
+bool AWG_Upload(uint32_t table, const uint16_t *samples, uint32_t count);
+bool AWG_Play(uint32_t table0, uint32_t table1, uint32_t frequency);
+void AWG_Stop(void);
+bool AWG_IsPending(void);
+uint32_t AWG_GetFrequency(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // AWG_H
@@ -0,0 +1,398 @@
+/***************************************************************************//**
+ * @file awg.c
+ *
+ * @brief Arbitrary waveform generator streaming VDAC tables with the LDMA.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2021 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ *******************************************************************************
+ * # Evaluation Quality
+ * This code has been minimally tested to ensure that it builds and is suitable 
+ * as a demonstration for evaluation purposes only. This code will be maintained
+ * at the sole discretion of Silicon Labs.
+ ******************************************************************************/
+
+#include "em_device.h"
+#include "em_cmu.h"
+#include "em_core.h"
+#include "em_ldma.h"
+#include "em_timer.h"
+
+#include "awg.h"
+
+#define MAX_CHANNELS        2
+
+/*
+ * Both channels are paced by TIMER0. Channel 0 is written on the
+ * overflow and channel 1 on the CC0 match at zero, the same instant. Each
+ * request is cleared by its write, and the VDAC converts on the write, so
+ * both outputs step together once per period.
+ */
+static const uint32_t ldmaChannel[MAX_CHANNELS] = {
+  AWG_LDMA_CHANNEL0, AWG_LDMA_CHANNEL1
+};
+static const LDMA_PeripheralSignal_t sampleSignal[MAX_CHANNELS] = {
+  ldmaPeripheralSignal_TIMER0_UFOF, ldmaPeripheralSignal_TIMER0_CC0
+};
+
+#define ALL_DONE            ((1 << AWG_LDMA_CHANNEL0) | (1 << AWG_LDMA_CHANNEL1))
+
+/*
+ * Each program is a short descriptor list per channel:
+ *
+ *   start     writes the program number to started[], interrupts
+ *   top       channel 0 only, writes the new top value to TIMER0->TOPB
+ *   loop      the table, links back to itself
+ *
+ * Two programs are kept so the next one can be written while the other
+ * plays. Changing the link of the loop descriptors switches over at a
+ * table boundary. The top buffer is loaded at the next overflow, so the
+ * last sample of the old table still lasts an old period and the first of
+ * the new table a new one.
+ */
+#define START               0
+#define TOP                 1
+#define LOOP                2
+
+static LDMA_Descriptor_t program[2][MAX_CHANNELS][3];
+static uint32_t programTop[2];
+static uint32_t programFrequency[2];
+static uint32_t programTable[2][MAX_CHANNELS];
+
+// Written by the start descriptors
+static volatile uint32_t started[MAX_CHANNELS];
+
+static uint16_t tables[AWG_TABLES][AWG_MAX_SAMPLES];
+static uint32_t tableLength[AWG_TABLES];
+
+static uint32_t channels;
+static uint32_t timerFreq;
+static volatile uint32_t activeProgram;
+static volatile bool playing;
+static volatile bool queued;
+
+/**************************************************************************//**
+ * @brief
+ *   Write the descriptor lists of a program
+ *****************************************************************************/
+static void buildProgram(uint32_t index)
+{
+  volatile uint32_t *data[MAX_CHANNELS] = { &VDAC0->CH0F, &VDAC0->CH1F };
+  LDMA_Descriptor_t *desc;
+  uint32_t table;
+
+  for (uint32_t c = 0; c < channels; c++) {
+    desc = program[index][c];
+    table = programTable[index][c];
+
+    // Channel 1 has no top descriptor and goes straight to its loop
+    desc[START] = (LDMA_Descriptor_t)
+      LDMA_DESCRIPTOR_LINKREL_WRITE(index, &started[c], (c == 0) ? 1 : 2);
+    desc[START].wri.doneIfs = 1;
+
+    if (c == 0) {
+      desc[TOP] = (LDMA_Descriptor_t)
+        LDMA_DESCRIPTOR_LINKREL_WRITE(programTop[index] - 1, &TIMER0->TOPB, 1);
+    }
+
+    desc[LOOP] = (LDMA_Descriptor_t)
+      LDMA_DESCRIPTOR_LINKREL_M2P_BYTE(tables[table],
+                                       data[c],
+                                       tableLength[table],
+                                       0);
+    desc[LOOP].xfer.size    = ldmaCtrlSizeHalf;
+    desc[LOOP].xfer.doneIfs = 0;
+  }
+}
+
+/**************************************************************************//**
+ * @brief
+ *   True if the active or the queued program plays a table
+ *****************************************************************************/
+static bool tableInUse(uint32_t table)
+{
+  for (uint32_t c = 0; c < channels; c++) {
+    if (programTable[activeProgram][c] == table) {
+      return true;
+    }
+    if (queued && (programTable[activeProgram ^ 1][c] == table)) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+/**************************************************************************//**
+ * @brief LDMA Handler
+ *****************************************************************************/
+void LDMA_IRQHandler(void)
+{
+  uint32_t pending = LDMA_IntGetEnabled();
+  uint32_t c;
+
+  if (pending & LDMA_IF_ERROR) {
+    __BKPT(0);
+  }
+
+  LDMA_IntClear(pending & ALL_DONE);
+
+  // The switch is done once every channel has started the new program
+  if (queued) {
+    for (c = 0; c < channels; c++) {
+      if (started[c] == activeProgram) {
+        return;
+      }
+    }
+    activeProgram ^= 1;
+    queued = false;
+  }
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Set up TIMER0 and the LDMA for the generator
+ *
+ * @note
+ *   VDAC0 must be set up by the caller, with the channels used enabled in
+ *   software trigger mode so each write is converted right away.
+ *
+ * @param[in] count
+ *   Channels to drive, 1 for CH0 only or 2 for CH0 and CH1.
+ *
+ * @return
+ *   false if count is out of range.
+ *****************************************************************************/
+bool AWG_Init(uint32_t count)
+{
+  LDMA_Init_t init = LDMA_INIT_DEFAULT;
+  TIMER_Init_TypeDef timerInit = TIMER_INIT_DEFAULT;
+  TIMER_InitCC_TypeDef timerCCInit = TIMER_INITCC_DEFAULT;
+
+  if ((count < 1) || (count > MAX_CHANNELS)) {
+    return false;
+  }
+
+  channels = count;
+  activeProgram = 0;
+  playing = false;
+  queued = false;
+  for (uint32_t t = 0; t < AWG_TABLES; t++) {
+    tableLength[t] = 0;
+  }
+
+  CMU_ClockEnable(cmuClock_TIMER0, true);
+
+  // Started by the first AWG_Play()
+  timerInit.dmaClrAct = true;
+  timerInit.enable = false;
+  TIMER_Init(TIMER0, &timerInit);
+
+  // CC0 requests channel 1 as the counter passes zero
+  timerCCInit.mode = timerCCModeCompare;
+  TIMER_InitCC(TIMER0, 0, &timerCCInit);
+  TIMER_CompareSet(TIMER0, 0, 0);
+
+  timerFreq = CMU_ClockFreqGet(cmuClock_TIMER0);
+
+  LDMA_Init(&init);
+
+  return true;
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Copy a waveform into a table
+ *
+ * @param[in] table
+ *   Table to write, below AWG_TABLES. It must not be playing or queued.
+ *
+ * @param[in] samples
+ *   12 bit VDAC samples, one period of the waveform.
+ *
+ * @param[in] count
+ *   Number of samples, 1 to AWG_MAX_SAMPLES.
+ *
+ * @return
+ *   false if the table is out of range or in use, or count is.
+ *****************************************************************************/
+bool AWG_Upload(uint32_t table, const uint16_t *samples, uint32_t count)
+{
+  if ((table >= AWG_TABLES) || (samples == NULL)
+      || (count == 0) || (count > AWG_MAX_SAMPLES)) {
+    return false;
+  }
+
+  CORE_DECLARE_IRQ_STATE;
+  CORE_ENTER_CRITICAL();
+  if (playing && tableInUse(table)) {
+    CORE_EXIT_CRITICAL();
+    return false;
+  }
+  // Keep an upload from being started on until it is complete
+  tableLength[table] = 0;
+  CORE_EXIT_CRITICAL();
+
+  for (uint32_t i = 0; i < count; i++) {
+    tables[table][i] = samples[i] & 0x0FFF;
+  }
+  tableLength[table] = count;
+
+  return true;
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Play tables at a waveform frequency
+ *
+ * @details
+ *   The sample rate is frequency times the table length, rounded to a
+ *   whole number of TIMER0 clocks per sample; AWG_GetFrequency() gives
+ *   the frequency it comes to. If nothing is playing the tables start
+ *   right away. Otherwise they are queued and take over at a table
+ *   boundary, within two passes of the tables playing now, together with
+ *   the new sample rate. Only one program can be queued at a time.
+ *
+ * @param[in] table0
+ *   Table for VDAC0 CH0.
+ *
+ * @param[in] table1
+ *   Table for VDAC0 CH1, the same length as table0 so both stay in step.
+ *   Ignored when only one channel is driven.
+ *
+ * @param[in] frequency
+ *   Waveform frequency in Hz.
+ *
+ * @return
+ *   false if a program is already queued, a table is empty, the lengths
+ *   differ, or the sample rate is above AWG_MAX_SAMPLE_RATE.
+ *****************************************************************************/
+bool AWG_Play(uint32_t table0, uint32_t table1, uint32_t frequency)
+{
+  LDMA_TransferCfg_t cfg;
+  uint32_t length, rate, top, next, c;
+
+  if ((table0 >= AWG_TABLES) || (tableLength[table0] == 0)
+      || (frequency == 0) || (frequency > AWG_MAX_SAMPLE_RATE)) {
+    return false;
+  }
+  length = tableLength[table0];
+  if ((channels > 1)
+      && ((table1 >= AWG_TABLES) || (tableLength[table1] != length))) {
+    return false;
+  }
+
+  rate = frequency * length;
+  if (rate > AWG_MAX_SAMPLE_RATE) {
+    return false;
+  }
+  top = (timerFreq + (rate / 2)) / rate;
+
+  CORE_DECLARE_IRQ_STATE;
+  CORE_ENTER_CRITICAL();
+
+  if (queued) {
+    CORE_EXIT_CRITICAL();
+    return false;
+  }
+
+  next = playing ? (activeProgram ^ 1) : activeProgram;
+  programTable[next][0] = table0;
+  programTable[next][1] = table1;
+  programTop[next] = top;
+  programFrequency[next] = timerFreq / (top * length);
+  buildProgram(next);
+
+  if (!playing) {
+    // The top descriptor only fills the buffer, set the first top here
+    TIMER_TopSet(TIMER0, top - 1);
+    for (c = 0; c < channels; c++) {
+      cfg = (LDMA_TransferCfg_t)LDMA_TRANSFER_CFG_PERIPHERAL(sampleSignal[c]);
+      LDMA_StartTransfer(ldmaChannel[c], &cfg, &program[next][c][START]);
+    }
+    playing = true;
+    TIMER_Enable(TIMER0, true);
+  } else {
+    /*
+     * The LDMA reads a loop descriptor again at the end of each pass, so
+     * the new link is taken at the end of the pass after that. Requests
+     * are held off while the links change so that both channels take
+     * them after the same pass.
+     */
+    for (c = 0; c < channels; c++) {
+      LDMA_EnableChannelRequest(ldmaChannel[c], false);
+    }
+    for (c = 0; c < channels; c++) {
+      program[activeProgram][c][LOOP].xfer.linkMode = ldmaLinkModeAbs;
+      program[activeProgram][c][LOOP].xfer.linkAddr =
+        (uint32_t)&program[next][c][START] >> 2;
+    }
+    for (c = 0; c < channels; c++) {
+      LDMA_EnableChannelRequest(ldmaChannel[c], true);
+    }
+    queued = true;
+  }
+
+  CORE_EXIT_CRITICAL();
+  return true;
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Stop the generator, the outputs keep the last sample written
+ *****************************************************************************/
+void AWG_Stop(void)
+{
+  CORE_DECLARE_IRQ_STATE;
+  CORE_ENTER_CRITICAL();
+
+  TIMER_Enable(TIMER0, false);
+  for (uint32_t c = 0; c < channels; c++) {
+    LDMA_StopTransfer(ldmaChannel[c]);
+  }
+  LDMA_IntClear(ALL_DONE);
+  playing = false;
+  queued = false;
+
+  CORE_EXIT_CRITICAL();
+}
+
+/**************************************************************************//**
+ * @brief
+ *   True while a program waits for a table boundary to take over
+ *****************************************************************************/
+bool AWG_IsPending(void)
+{
+  return queued;
+}
+
+/**************************************************************************//**
+ * @brief
+ *   Waveform frequency in Hz of the program playing, after rounding
+ *****************************************************************************/
+uint32_t AWG_GetFrequency(void)
+{
+  return playing ? programFrequency[activeProgram] : 0;
+}
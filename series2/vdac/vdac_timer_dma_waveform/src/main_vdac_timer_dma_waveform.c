@@ -1,7 +1,9 @@
 /***************************************************************************//**
  * @file main.c
- * @brief This project uses the VDAC and TIMER0 to output a 32 point sine wave
- * at a particular frequency (10 kHz by default). This project operates in EM1.
+ * @brief This project uses the VDAC, TIMER0 and the LDMA as an arbitrary
+ * waveform generator. Waveform tables are uploaded at run time and played on
+ * both VDAC channels in step, switching table and frequency at a table
+ * boundary without a glitch. This project operates in EM1.
  *******************************************************************************
  * # License
  * <b>Copyright 2021 Silicon Laboratories Inc. www.silabs.com</b>
@@ -34,37 +36,33 @@
  * at the sole discretion of Silicon Labs.
  ******************************************************************************/
 
+#include <math.h>
+
 #include "em_device.h"
 #include "em_chip.h"
 #include "em_cmu.h"
 #include "em_emu.h"
 #include "em_vdac.h"
-#include "em_timer.h"
-#include "em_ldma.h"
-
-// 32 point sine table
-#define SINE_TABLE_SIZE 32
-static const uint16_t sineTable[SINE_TABLE_SIZE] = {
-  2048 , 2447 , 2831 , 3185 , 3495 , 3750 , 3939 , 4056 ,
-  4095 , 4056 , 3939 , 3750 , 3495 , 3185 , 2831 , 2447 ,
-  2048 , 1648 , 1264 , 910  , 600  , 345  , 156  , 39   ,
-  0    , 39   , 156  , 345  , 600  , 910  , 1264 , 1648 ,
-};
 
-// Note: change this to change which channel the VDAC outputs to. This value can
-// be either a zero or one
-#define CHANNEL_NUM 0
+#include "awg.h"
 
-// Set the VDAC to max frequency of 1 MHz
-#define CLK_VDAC_FREQ              1000000
+// Samples per waveform period
+#define WAVE_SAMPLES    64
 
-// Note: change this to determine the frequency of the sine wave
-#define WAVEFORM_FREQ              10000
+// Full scale of the 12 bit VDAC
+#define VDAC_MAX        4095
+
+// Tables uploaded to the generator
+#define TABLE_SINE      0
+#define TABLE_COSINE    1
+#define TABLE_TRIANGLE  2
+#define TABLE_SAWTOOTH  3
+
+// Set the VDAC to max frequency of 1 MHz
+#define CLK_VDAC_FREQ   1000000
 
-// The timer needs to run at SINE_TABLE_SIZE times faster than the desired
-// waveform frequency because it needs to output SINE_TABLE_SIZE points in that
-// same amount of time
-#define TIMER0_FREQ                (WAVEFORM_FREQ * SINE_TABLE_SIZE)
+// Time each step of the demo plays for
+#define STEP_MS         2000
 
 /*
  * The port and pin for the VDAC output is set in VDAC_OUTCTRL register. The
@@ -77,9 +75,54 @@ static const uint16_t sineTable[SINE_TABLE_SIZE] = {
  *
  * The VDAC port pin settings do not need to be set when the main output is
  * used. Refer to the device Reference Manual and Datasheet for more details. We
- * will be selecting the CH0 main output PB00 for this example.
+ * will be selecting the CH0 main output PB00 and the CH1 main output PB01 for
+ * this example.
  */
 
+// Tables and waveform frequency of each step, CH0 and CH1 play in step
+typedef struct {
+  uint32_t table0;
+  uint32_t table1;
+  uint32_t frequency;
+} Step_t;
+
+static const Step_t steps[] = {
+  { TABLE_SINE,     TABLE_COSINE,   1000 },
+  { TABLE_SINE,     TABLE_COSINE,   5000 },
+  { TABLE_TRIANGLE, TABLE_SAWTOOTH, 2000 },
+  { TABLE_SAWTOOTH, TABLE_SINE,     500 },
+};
+
+#define STEPS           (sizeof(steps) / sizeof(steps[0]))
+
+// Waveform being built before it is uploaded
+static uint16_t wave[WAVE_SAMPLES];
+
+static volatile uint32_t msTicks;
+
+/**************************************************************************//**
+ * @brief SysTick_Handler
+ * Interrupt Service Routine for system tick counter
+ *****************************************************************************/
+void SysTick_Handler(void)
+{
+  msTicks++;       // increment counter necessary in Delay()
+}
+
+/**************************************************************************//**
+ * @brief Delays number of msTick Systicks (typically 1 ms)
+ * @param dlyTicks Number of ticks to delay
+ *****************************************************************************/
+void Delay(uint32_t dlyTicks)
+{
+  uint32_t curTicks;
+
+  curTicks = msTicks;
+  while ((msTicks - curTicks) < dlyTicks) {
+    EMU_EnterEM1();
+  }
+}
+
 /**************************************************************************//**
  * @brief
  *    VDAC initialization
@@ -115,98 +158,74 @@ void initVdac(void)
   // this mode off
   initChannel.highCapLoadEnable = false;
 
-  // Initialize the VDAC and VDAC channel
+  // Convert each value as soon as the LDMA writes it
+  initChannel.trigMode = vdacTrigModeSw;
+
+  // Initialize the VDAC and both VDAC channels
   VDAC_Init(VDAC0, &init);
-  VDAC_InitChannel(VDAC0, &initChannel, CHANNEL_NUM);
+  VDAC_InitChannel(VDAC0, &initChannel, 0);
+  VDAC_InitChannel(VDAC0, &initChannel, 1);
 
   // Enable the VDAC
-  VDAC_Enable(VDAC0, CHANNEL_NUM, true);
+  VDAC_Enable(VDAC0, 0, true);
+  VDAC_Enable(VDAC0, 1, true);
 }
 
 /**************************************************************************//**
  * @brief
- *    Timer initialization
+ *    Build the fixed waveforms and upload them to the generator
  *****************************************************************************/
-void initTimer(void)
+void uploadWaves(void)
 {
-  uint32_t timerFreq, topValue;
-
-  // Enable clock for TIMER0 module
-  CMU_ClockEnable(cmuClock_TIMER0, true);
+  const float pi = 3.14159265f;
+  uint32_t i;
 
-  // Initialize TIMER0
-  TIMER_Init_TypeDef init = TIMER_INIT_DEFAULT;
-  init.dmaClrAct = true;
-  init.enable = false;
-  TIMER_Init(TIMER0, &init);
-
-  // Set top (reload) value for the timer
-  // Note: the timer runs off of the EM01GRPACLK clock
-  timerFreq = CMU_ClockFreqGet(cmuClock_TIMER0) / (init.prescale + 1);
-  topValue = (timerFreq / TIMER0_FREQ);
+  for (i = 0; i < WAVE_SAMPLES; i++) {
+    wave[i] = (uint16_t)((VDAC_MAX / 2)
+                         + ((VDAC_MAX / 2) * sinf((2 * pi * i) / WAVE_SAMPLES)));
+  }
+  AWG_Upload(TABLE_SINE, wave, WAVE_SAMPLES);
 
-  // Set top value to overflow at the desired TIMER0_FREQ frequency
-  TIMER_TopSet(TIMER0, topValue);
+  for (i = 0; i < WAVE_SAMPLES; i++) {
+    wave[i] = (uint16_t)((VDAC_MAX / 2)
+                         + ((VDAC_MAX / 2) * cosf((2 * pi * i) / WAVE_SAMPLES)));
+  }
+  AWG_Upload(TABLE_COSINE, wave, WAVE_SAMPLES);
 
-  // Enable TIMER0
-  TIMER_Enable(TIMER0, true);
+  for (i = 0; i < WAVE_SAMPLES; i++) {
+    wave[i] = (uint16_t)((VDAC_MAX * i) / (WAVE_SAMPLES - 1));
+  }
+  AWG_Upload(TABLE_SAWTOOTH, wave, WAVE_SAMPLES);
 }
 
 /**************************************************************************//**
  * @brief
- *    Initialize the LDMA module
- *
- * @details
- *    Configure the channel descriptor to use the default memory to
- *    peripheral transfer descriptor. Modify it to not generate an interrupt
- *    upon transfer completion (we don't need it for this example).
- *    Also make the descriptor link to itself so that the descriptor runs
- *    continuously. Additionally, the transfer configuration selects the
- *    TIMER0 overflow signal as the trigger for the DMA transaction to occur.
+ *    Build a triangle of the given peak and upload it
  *
- * @note
- *    The descriptor object needs to at least have static scope persistence so
- *    that the reference to the object is valid beyond its first use in
- *    initialization. This is because this code loops back to the same
- *    descriptor after every dma transfer. If the reference isn't valid anymore,
- *    then all dma transfers after the first one will fail.
- ******************************************************************************/
-void initLdma(void)
+ * @return
+ *    false if the triangle is playing or queued and was left as it is.
+ *****************************************************************************/
+bool uploadTriangle(uint32_t peak)
 {
-  // Descriptor loops through the sine table and outputs its values to the VDAC
-  static LDMA_Descriptor_t loopDescriptor =
-    LDMA_DESCRIPTOR_LINKREL_M2P_BYTE(&sineTable[0],   // Memory source address
-                                     &VDAC0->CH0F,    // Peripheral destination address
-                                     SINE_TABLE_SIZE, // Number of halfwords per transfer
-                                     0);              // Link to same descriptor
-
-  // Don't trigger interrupt when transfer is done
-  loopDescriptor.xfer.doneIfs = 0;
-
-  // Transfer halfwords (VDAC data register is 12 bits)
-  loopDescriptor.xfer.size = ldmaCtrlSizeHalf;
-
-  // Transfer configuration and trigger selection
-  // Trigger on TIMER0 overflow and set loop count to size of the sine table
-  // minus one
-  LDMA_TransferCfg_t transferConfig =
-    LDMA_TRANSFER_CFG_PERIPHERAL(ldmaPeripheralSignal_TIMER0_UFOF);
-
-  // LDMA initialization
-  LDMA_Init_t init = LDMA_INIT_DEFAULT;
-  LDMA_Init(&init);
-
-  // Start the transfer
-  uint32_t channelNum = 0;
-  LDMA_StartTransfer(channelNum, &transferConfig, &loopDescriptor);
+  uint32_t half = WAVE_SAMPLES / 2;
+
+  for (uint32_t i = 0; i < half; i++) {
+    wave[i] = (uint16_t)((peak * i) / half);
+    wave[WAVE_SAMPLES - 1 - i] = (uint16_t)((peak * (i + 1)) / half);
+  }
+
+  return AWG_Upload(TABLE_TRIANGLE, wave, WAVE_SAMPLES);
 }
 
 /**************************************************************************//**
  * @brief
- *    Output a sine wave to DAC channel 0
+ *    Play the steps in turn on both VDAC channels
  *****************************************************************************/
 int main(void)
 {
+  uint32_t step = 0;
+  uint32_t peak = VDAC_MAX;
+
   // Chip errata
   CHIP_Init();
 
@@ -215,14 +234,30 @@ int main(void)
   // Enable DC-DC converter
   EMU_DCDCInit(&dcdcInit);
 
-  // Initialize the VDAC, LDMA and Timer
+  // Setup SysTick Timer for 1 msec interrupts
+  if (SysTick_Config(CMU_ClockFreqGet(cmuClock_CORE) / 1000)) while (1) ;
+
+  // Initialize the VDAC and the generator for both channels
   initVdac();
-  initLdma();
-  initTimer();
+  AWG_Init(2);
+
+  uploadWaves();
+  uploadTriangle(peak);
 
   while (1) {
-    // Enter EM1 (won't exit)
-    EMU_EnterEM1();
+    // Queued while the previous step plays, taken at a table boundary
+    while (!AWG_Play(steps[step].table0,
+                     steps[step].table1,
+                     steps[step].frequency)) {
+      EMU_EnterEM1();
+    }
+    Delay(STEP_MS);
+
+    // Lower the triangle a little each time round, while it does not play
+    step = (step + 1) % STEPS;
+    if (step == 0) {
+      peak = (peak > (VDAC_MAX / 4)) ? (peak - (VDAC_MAX / 8)) : VDAC_MAX;
+      uploadTriangle(peak);
+    }
   }
 }
-
@@ -46,41 +46,34 @@
 #include "em_system.h"
 #include "em_wdog.h"
 #include "bspconfig.h"
+#include "lpdelay.h"
+#include "wdogsup.h"
+
+// Supervisor tick, the WDOG is fed at most this often
+#define SUP_TICK_MS       50
+
+// Task windows: the LED blinks every 100 ms, the button is polled with it
+#define BLINK_MIN_MS      50
+#define BLINK_MAX_MS      500
+#define BUTTON_MAX_MS     1000
 
 // GLOBAL VARIABLES 
 unsigned long resetCause;
-volatile uint32_t msTicks; // counts 1ms timeTicks 
+
+// Tasks that had failed before the last WDOG reset, bit n for task n
+uint32_t failedTasks;
 
 // Function Declarations 
 void initGPIO(void);
 void initWDOG(void);
 
-/**************************************************************************//**
- * @brief SysTick_Handler
- * Interrupt Service Routine for system tick counter
- *****************************************************************************/
-void SysTick_Handler(void)
-{
-  msTicks++;       // increment counter necessary in Delay()
-}
-
-/**************************************************************************//**
- * @brief Delays number of msTick Systicks (typically 1 ms)
- * @param dlyTicks Number of ticks to delay
- *****************************************************************************/
-void Delay(uint32_t dlyTicks)
-{
-  uint32_t curTicks;
-
-  curTicks = msTicks;
-  while ((msTicks - curTicks) < dlyTicks) ;
-}
-
 /**************************************************************************//**
  * @brief  Main function
  *****************************************************************************/
 int main(void)
 {
+  int blinkTask, buttonTask;
+
   // Chip errata 
   CHIP_Init();
 
@@ -98,32 +91,41 @@ int main(void)
   // Configure the Push Buttons and the LEDs 
   initGPIO();
 
-  // Setup SysTick Timer for 1 msec interrupts  
-  if (SysTick_Config(CMU_ClockFreqGet(cmuClock_CORE) / 1000)) while (1) ;
+  // Sleep in EM2 during delays, the WDOG keeps running from the ULFRCO
+  LPDELAY_Init(true);
 
-  // Configure and Initialize the Watchdog timer 
+  // Configure and Initialize the Watchdog timer and its supervisor
   initWDOG();
 
   // Check if Watch Dog (WDOG0) triggered the last reset
   if (resetCause & EMU_RSTCAUSE_WDOG0)
   {
+    // Keep the tasks that stalled; no task is registered, so the
+    // supervisor keeps feeding the WDOG
+    WDOGSUP_GetLastFailed(&failedTasks);
+
     // Turn LED0 on
     GPIO_PinOutSet(BSP_GPIO_LED0_PORT, BSP_GPIO_LED0_PIN);
     while(1); //Stay here
   }
 
-  // Enter loop, and feed the WDOG 
+  // The WDOG is fed only while both tasks check in within their windows
+  blinkTask = WDOGSUP_Register(BLINK_MIN_MS, BLINK_MAX_MS);
+  buttonTask = WDOGSUP_Register(0, BUTTON_MAX_MS);
+
+  // Enter loop, the tasks check in
   while (1)
   {
-    // Do not feed the WDOG if PB0 is pressed 
-    while(!(GPIO_PinInGet(BSP_GPIO_PB0_PORT,BSP_GPIO_PB0_PIN)));
-
-    // Feed the watchdog
-    WDOGn_Feed(DEFAULT_WDOG);
+    // The button task stalls while PB0 is pressed
+    if (GPIO_PinInGet(BSP_GPIO_PB0_PORT, BSP_GPIO_PB0_PIN))
+    {
+      WDOGSUP_CheckIn(buttonTask);
+    }
 
-    // Toggle LED0 at 10 kHz
+    // Toggle LED0 every 100 ms
     GPIO_PinOutToggle(BSP_GPIO_LED0_PORT, BSP_GPIO_LED0_PIN);
-    Delay(100);
+    WDOGSUP_CheckIn(blinkTask);
+    LPDELAY_Ms(100);
   }
 }
 
@@ -147,16 +149,12 @@ void initGPIO(void)
  *****************************************************************************/
 void initWDOG(void)
 {
-  // Enable clock for the WDOG module; has no effect on xG21
-  CMU_ClockEnable(cmuClock_WDOG0, true);
-
-  // Watchdog Initialize settings 
-  WDOG_Init_TypeDef wdogInit = WDOG_INIT_DEFAULT;
-  CMU_ClockSelectSet(cmuClock_WDOG0, cmuSelect_ULFRCO); /* ULFRCO as clock source */
-  wdogInit.debugRun = true;
-  wdogInit.em3Run = true;
-  wdogInit.perSel = wdogPeriod_2k; // 2049 clock cycles of a 1kHz clock  ~2 seconds period
-
-  // Initializing watchdog with chosen settings 
-  WDOGn_Init(DEFAULT_WDOG, &wdogInit);
+  WDOGSUP_Init_TypeDef supInit;
+
+  // The supervisor runs the WDOG from the ULFRCO, also in EM2 while the
+  // delays sleep, and feeds it from a LETIMER interrupt
+  supInit.tickMs = SUP_TICK_MS;
+  supInit.period = wdogPeriod_2k; // 2049 clock cycles of a 1kHz clock  ~2 seconds period
+  supInit.debugRun = true;
+  WDOGSUP_Init(&supInit);
 }